@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include "caffe2/binaries/sharded_db_writer.h"
 #include "caffe2/core/db.h"
 #include "caffe2/core/init.h"
 #include "caffe2/proto/caffe2.pb.h"
@@ -23,29 +24,42 @@ CAFFE2_DEFINE_string(input_db, "", "The input db.");
 CAFFE2_DEFINE_string(input_db_type, "", "The input db type.");
 CAFFE2_DEFINE_string(output_db, "", "The output db.");
 CAFFE2_DEFINE_string(output_db_type, "", "The output db type.");
-CAFFE2_DEFINE_int(batch_size, 1000, "The write batch size.");
+CAFFE2_DEFINE_int(batch_size, 1000, "The write batch size of every shard.");
+CAFFE2_DEFINE_int(
+    num_shards,
+    1,
+    "The number of output dbs, named <output_db>_shard_<i> when more than "
+    "one, the records being dealt to them in turn.");
 
 using caffe2::db::Cursor;
 using caffe2::db::DB;
-using caffe2::db::Transaction;
 
 int main(int argc, char** argv) {
   caffe2::GlobalInit(&argc, &argv);
+  CAFFE_ENFORCE_GT(caffe2::FLAGS_num_shards, 0);
 
   std::unique_ptr<DB> in_db(caffe2::db::CreateDB(
       caffe2::FLAGS_input_db_type, caffe2::FLAGS_input_db, caffe2::db::READ));
-  std::unique_ptr<DB> out_db(caffe2::db::CreateDB(
-      caffe2::FLAGS_output_db_type, caffe2::FLAGS_output_db, caffe2::db::NEW));
   std::unique_ptr<Cursor> cursor(in_db->NewCursor());
-  std::unique_ptr<Transaction> transaction(out_db->NewTransaction());
+  std::vector<std::string> sources;
+  for (int i = 0; i < caffe2::FLAGS_num_shards; ++i) {
+    sources.push_back(
+        caffe2::FLAGS_num_shards == 1
+            ? caffe2::FLAGS_output_db
+            : caffe2::FLAGS_output_db + "_shard_" + caffe2::to_string(i));
+  }
+  // The shards are written by threads of their own while this one reads.
+  caffe2::ShardedDBWriter writer(
+      caffe2::FLAGS_output_db_type, sources, caffe2::FLAGS_batch_size);
   int count = 0;
   for (; cursor->Valid(); cursor->Next()) {
-    transaction->Put(cursor->key(), cursor->value());
+    writer.Put(
+        count % caffe2::FLAGS_num_shards, cursor->key(), cursor->value());
     if (++count % caffe2::FLAGS_batch_size == 0) {
-      transaction->Commit();
       LOG(INFO) << "Converted " << count << " items so far.";
     }
   }
+  writer.Finish();
   LOG(INFO) << "A total of " << count << " items processed.";
   return 0;
 }
@@ -160,6 +160,27 @@ class DummyEmptyOp : public Operator<Context> {
 REGISTER_CPU_OPERATOR(DummyEmpty, DummyEmptyOp<CPUContext>);
 REGISTER_CUDA_OPERATOR(DummyEmpty, DummyEmptyOp<CUDAContext>);
 OPERATOR_SCHEMA(DummyEmpty);
+
+// Only does what every operator does with its output, without a kernel.
+template <class Context>
+class DummyResizeLikeOp : public Operator<Context> {
+ public:
+  DummyResizeLikeOp(const OperatorDef& def, Workspace* ws)
+      : Operator<Context>(def, ws) {}
+
+  bool RunOnDevice() final {
+    this->Output(0)->ResizeLike(this->Input(0));
+    this->Output(0)->template mutable_data<float>();
+    return true;
+  }
+};
+
+REGISTER_CPU_OPERATOR(DummyResizeLike, DummyResizeLikeOp<CPUContext>);
+REGISTER_CUDA_OPERATOR(DummyResizeLike, DummyResizeLikeOp<CUDAContext>);
+OPERATOR_SCHEMA(DummyResizeLike)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .IdenticalTypeAndShape();
 }  // namespace
 
 static void BM_OperatorCreationCPU(benchmark::State& state) {
@@ -220,4 +241,40 @@ static void BM_TensorAllocDeallocCUDA(benchmark::State& state) {
 }
 BENCHMARK(BM_TensorAllocDeallocCUDA);
 
+// A chain of 64 tiny operators on CPU. With state.range(0) set, the batch
+// size of the input alternates between 1 and 2, so that the outputs change
+// shape on every run.
+static void BM_TinyOpNetCPU(benchmark::State& state, const char* net_type) {
+  Workspace ws;
+  NetDef net_def;
+  net_def.set_name("tiny_op_net");
+  net_def.set_type(net_type);
+  net_def.add_external_input("X0");
+  const int num_ops = 64;
+  for (int i = 0; i < num_ops; ++i) {
+    auto* op = net_def.add_op();
+    op->set_type("DummyResizeLike");
+    op->add_input("X" + caffe2::to_string(i));
+    op->add_output("X" + caffe2::to_string(i + 1));
+  }
+  auto* input = ws.CreateBlob("X0")->GetMutable<TensorCPU>();
+  input->Resize(1, 16);
+  input->mutable_data<float>();
+  auto* net = ws.CreateNet(net_def);
+  CHECK(net);
+  int iter = 0;
+  while (state.KeepRunning()) {
+    if (state.range(0)) {
+      input->Resize(1 + (iter++ % 2), 16);
+      input->mutable_data<float>();
+    }
+    CHECK(net->Run());
+  }
+  state.SetItemsProcessed(state.iterations() * num_ops);
+}
+BENCHMARK_CAPTURE(BM_TinyOpNetCPU, simple, "simple")->Arg(0)->Arg(1);
+BENCHMARK_CAPTURE(BM_TinyOpNetCPU, static_shape, "static_shape")
+    ->Arg(0)
+    ->Arg(1);
+
 BENCHMARK_MAIN()
@@ -30,16 +30,27 @@ CAFFE2_DEFINE_int(repeat, 10, "The number to repeat the throughput test.");
 CAFFE2_DEFINE_bool(use_reader, false, "If true, use the reader interface.");
 CAFFE2_DEFINE_int(num_read_threads, 1,
                    "The number of concurrent reading threads.");
+CAFFE2_DEFINE_int(prefetch_depth, 0,
+                   "If positive, read the db through a PrefetchingCursor "
+                   "that reads this many records ahead.");
+CAFFE2_DEFINE_int(num_cursors, 1,
+                   "The number of cursors the reader reads the db with in "
+                   "parallel.");
 
 using caffe2::db::Cursor;
 using caffe2::db::DB;
 using caffe2::db::DBReader;
+using caffe2::db::PrefetchingCursor;
 using caffe2::string;
 
 void TestThroughputWithDB() {
   std::unique_ptr<DB> in_db(caffe2::db::CreateDB(
       caffe2::FLAGS_input_db_type, caffe2::FLAGS_input_db, caffe2::db::READ));
   std::unique_ptr<Cursor> cursor(in_db->NewCursor());
+  if (caffe2::FLAGS_prefetch_depth > 0) {
+    cursor.reset(new PrefetchingCursor(
+        std::move(cursor), caffe2::FLAGS_prefetch_depth));
+  }
   for (int iter_id = 0; iter_id < caffe2::FLAGS_repeat; ++iter_id) {
     caffe2::Timer timer;
     for (int i = 0; i < caffe2::FLAGS_report_interval; ++i) {
@@ -75,7 +86,8 @@ void TestThroughputWithReaderWorker(const DBReader* reader, int thread_id) {
 
 void TestThroughputWithReader() {
   caffe2::db::DBReader reader(
-      caffe2::FLAGS_input_db_type, caffe2::FLAGS_input_db);
+      caffe2::FLAGS_input_db_type, caffe2::FLAGS_input_db, 1, 0,
+      caffe2::FLAGS_num_cursors);
   std::vector<std::unique_ptr<std::thread>> reading_threads(
       caffe2::FLAGS_num_read_threads);
   for (int i = 0; i < reading_threads.size(); ++i) {
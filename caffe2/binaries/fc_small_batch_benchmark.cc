@@ -0,0 +1,136 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Latency of FC at the batch sizes of online inference, on CPU. BM_FC runs
+// the operator, which takes the small batch kernels of
+// perfkernels/fc_small_batch.h for M <= 8. BM_FCGemm runs what it did before,
+// math::Gemm followed by the rank one bias update, on the same shapes.
+
+#include <random>
+
+#include "benchmark/benchmark.h"
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
+#include "caffe2/utils/proto_utils.h"
+
+using namespace caffe2;
+
+namespace {
+
+void FillRandom(TensorCPU* tensor, std::mt19937* gen) {
+  std::uniform_real_distribution<float> dist(-1, 1);
+  float* data = tensor->mutable_data<float>();
+  for (TIndex i = 0; i < tensor->size(); ++i) {
+    data[i] = dist(*gen);
+  }
+}
+
+void SetFlops(benchmark::State& state, int M, int K, int N) {
+  state.counters["GFLOP/s"] = benchmark::Counter(
+      2.0 * M * K * N * state.iterations() / 1e9, benchmark::Counter::kIsRate);
+}
+
+} // namespace
+
+// Args: M, K, N.
+static void BM_FC(benchmark::State& state) {
+  const int M = state.range(0), K = state.range(1), N = state.range(2);
+  Workspace ws;
+  std::mt19937 gen(1701);
+  auto* X = ws.CreateBlob("X")->GetMutable<TensorCPU>();
+  X->Resize(M, K);
+  FillRandom(X, &gen);
+  auto* W = ws.CreateBlob("W")->GetMutable<TensorCPU>();
+  W->Resize(N, K);
+  FillRandom(W, &gen);
+  auto* b = ws.CreateBlob("b")->GetMutable<TensorCPU>();
+  b->Resize(N);
+  FillRandom(b, &gen);
+  auto op = CreateOperator(
+      CreateOperatorDef("FC", "", {"X", "W", "b"}, {"Y"}), &ws);
+  CAFFE_ENFORCE(op->Run());
+  while (state.KeepRunning()) {
+    op->Run();
+  }
+  SetFlops(state, M, K, N);
+}
+
+// Args: M, K, N.
+static void BM_FCGemm(benchmark::State& state) {
+  const int M = state.range(0), K = state.range(1), N = state.range(2);
+  std::mt19937 gen(1701);
+  CPUContext context;
+  TensorCPU X(vector<TIndex>{M, K});
+  FillRandom(&X, &gen);
+  TensorCPU W(vector<TIndex>{N, K});
+  FillRandom(&W, &gen);
+  TensorCPU b(vector<TIndex>{N});
+  FillRandom(&b, &gen);
+  TensorCPU bias_multiplier(vector<TIndex>{M});
+  math::Set<float, CPUContext>(
+      M, 1.f, bias_multiplier.mutable_data<float>(), &context);
+  TensorCPU Y(vector<TIndex>{M, N});
+  float* Y_data = Y.mutable_data<float>();
+  while (state.KeepRunning()) {
+    math::Gemm<float, CPUContext>(
+        CblasNoTrans,
+        CblasTrans,
+        M,
+        N,
+        K,
+        1,
+        X.data<float>(),
+        W.data<float>(),
+        0,
+        Y_data,
+        &context);
+    math::Gemm<float, CPUContext>(
+        CblasNoTrans,
+        CblasNoTrans,
+        M,
+        N,
+        1,
+        1,
+        bias_multiplier.data<float>(),
+        b.data<float>(),
+        1,
+        Y_data,
+        &context);
+  }
+  SetFlops(state, M, K, N);
+}
+
+// Ranking MLP towers at one to eight requests per batch.
+#define CAFFE2_FC_SMALL_BATCH_SHAPES(bm) \
+  BENCHMARK(bm)                          \
+      ->Args({1, 256, 256})              \
+      ->Args({1, 512, 128})              \
+      ->Args({1, 1024, 1024})            \
+      ->Args({1, 4096, 1024})            \
+      ->Args({2, 1024, 1024})            \
+      ->Args({4, 256, 256})              \
+      ->Args({4, 1024, 1024})            \
+      ->Args({4, 2048, 512})             \
+      ->Args({8, 512, 512})              \
+      ->Args({8, 1024, 1024})            \
+      ->Args({8, 4096, 1000})
+
+CAFFE2_FC_SMALL_BATCH_SHAPES(BM_FC);
+CAFFE2_FC_SMALL_BATCH_SHAPES(BM_FCGemm);
+
+BENCHMARK_MAIN();
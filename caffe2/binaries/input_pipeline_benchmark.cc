@@ -0,0 +1,231 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the throughput of a whole input pipeline: the db reads, the
+// decoding and augmentation, the copies to the device and the prefetch
+// queue, by running a PrefetchOperator-based input op (ImageInput,
+// VideoInput, TensorProtosDBInput) standalone, e.g.
+//
+//   input_pipeline_benchmark --op ImageInput --db /data/train_lmdb
+//       --db_type lmdb --batch_size 256 --decode_threads 16 --device hip
+//       --args "crop=224,scale=256,use_gpu_transform=1" --consumer_us 20000
+//
+// --consumer_us simulates the time the training step takes per batch, to
+// check that the pipeline keeps up with it: a starved fraction close to zero
+// means the readers are fast enough.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "caffe2/core/init.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/stats.h"
+#include "caffe2/core/timer.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/proto/caffe2.pb.h"
+#include "caffe2/utils/proto_utils.h"
+#include "caffe2/utils/string_utils.h"
+
+CAFFE2_DEFINE_string(op, "ImageInput", "The type of the input op.");
+CAFFE2_DEFINE_string(db, "", "The input db.");
+CAFFE2_DEFINE_string(db_type, "lmdb", "The input db type.");
+CAFFE2_DEFINE_int(batch_size, 32, "The batch size.");
+CAFFE2_DEFINE_int(
+    num_outputs,
+    2,
+    "The number of outputs of the op, e.g. one per tensor of the records "
+    "for TensorProtosDBInput.");
+CAFFE2_DEFINE_int(decode_threads, 4, "The number of decode threads.");
+CAFFE2_DEFINE_int(
+    prefetch_buffers,
+    1,
+    "The number of batches prefetched ahead on devices.");
+CAFFE2_DEFINE_string(device, "cpu", "The device of the op: cpu, cuda or hip.");
+CAFFE2_DEFINE_int(gpu_id, 0, "The gpu of the op, if any.");
+CAFFE2_DEFINE_string(
+    args,
+    "",
+    "Additional arguments of the op, as comma separated name=value pairs. "
+    "Integer and float values are detected, lists of integers are "
+    "separated by semicolons (random_scale=256;480).");
+CAFFE2_DEFINE_int(warmup, 10, "The number of batches to warm up with.");
+CAFFE2_DEFINE_int(iter, 100, "The number of batches to measure.");
+CAFFE2_DEFINE_int(
+    consumer_us,
+    0,
+    "Time in microseconds the simulated consumer spends on every batch.");
+CAFFE2_DEFINE_int(
+    report_interval,
+    0,
+    "If positive, print the throughput every this many batches.");
+
+namespace caffe2 {
+namespace {
+
+// The name of the benchmarked op, which names its stats groups.
+const char kOpName[] = "benchmark";
+
+void AddParsedArgument(const string& name, const string& value,
+                       OperatorDef* def) {
+  if (value.find(';') != string::npos) {
+    vector<int> values;
+    for (const auto& v : split(';', value)) {
+      values.push_back(std::stoi(v));
+    }
+    AddArgument(name, values, def);
+    return;
+  }
+  char* end = nullptr;
+  long int_value = std::strtol(value.c_str(), &end, 10);
+  if (!value.empty() && *end == '\0') {
+    AddArgument(name, static_cast<int>(int_value), def);
+    return;
+  }
+  float float_value = std::strtof(value.c_str(), &end);
+  if (!value.empty() && *end == '\0') {
+    AddArgument(name, float_value, def);
+    return;
+  }
+  AddArgument(name, value, def);
+}
+
+OperatorDef MakeInputOpDef() {
+  OperatorDef def;
+  def.set_type(FLAGS_op);
+  def.set_name(kOpName);
+  def.add_input("reader");
+  def.add_output("data");
+  if (FLAGS_num_outputs > 1) {
+    def.add_output("label");
+  }
+  for (int i = 2; i < FLAGS_num_outputs; ++i) {
+    def.add_output("output_" + caffe2::to_string(i));
+  }
+  AddArgument("batch_size", FLAGS_batch_size, &def);
+  AddArgument("decode_threads", FLAGS_decode_threads, &def);
+  AddArgument("prefetch_buffers", FLAGS_prefetch_buffers, &def);
+  if (!FLAGS_args.empty()) {
+    for (const auto& arg : split(',', FLAGS_args)) {
+      auto pos = arg.find('=');
+      CAFFE_ENFORCE(pos != string::npos, "Arguments are name=value: ", arg);
+      AddParsedArgument(arg.substr(0, pos), arg.substr(pos + 1), &def);
+    }
+  }
+  auto* option = def.mutable_device_option();
+  if (FLAGS_device == "cuda") {
+    option->set_device_type(CUDA);
+    option->set_cuda_gpu_id(FLAGS_gpu_id);
+  } else if (FLAGS_device == "hip") {
+    option->set_device_type(HIP);
+    option->set_hip_gpu_id(FLAGS_gpu_id);
+  } else {
+    CAFFE_ENFORCE_EQ(FLAGS_device, "cpu", "Unknown device ", FLAGS_device);
+  }
+  return def;
+}
+
+// Returns the average of stat "<group>/<name>" per event, where the stat is
+// an AvgExportedStat.
+double Average(const ExportedStatMap& stats, const string& group,
+               const string& name) {
+  auto sum = stats.find(group + "/" + name + "/sum");
+  auto count = stats.find(group + "/" + name + "/count");
+  if (sum == stats.end() || count == stats.end() || count->second == 0) {
+    return 0;
+  }
+  return static_cast<double>(sum->second) / count->second;
+}
+
+void PrintStageStats(const ExportedStatMap& stats, int batches) {
+  const string prefetch = string("prefetch/") + kOpName;
+  printf("Per batch, in milliseconds:\n");
+  printf("  prefetch (producer):  %10.3f\n",
+         Average(stats, prefetch, "prefetch_us") / 1000);
+  const string image = string("image_input/") + kOpName;
+  if (stats.count(image + "/read_us/count")) {
+    printf("    read:               %10.3f\n",
+           Average(stats, image, "read_us") / 1000);
+    printf("    decode + augment:   %10.3f\n",
+           Average(stats, image, "decode_us") / 1000);
+    printf("    issue device copy:  %10.3f\n",
+           Average(stats, image, "copy_us") / 1000);
+  }
+  printf("  copy to outputs:      %10.3f\n",
+         Average(stats, prefetch, "copy_us") / 1000);
+  auto starved = stats.find(prefetch + "/starved_runs");
+  const int64_t starved_runs = starved == stats.end() ? 0 : starved->second;
+  printf("Consumer starved on %lld of %d batches (%.1f%%), waiting %.3f ms "
+         "on average when starved.\n",
+         static_cast<long long>(starved_runs), batches,
+         100.0 * starved_runs / batches,
+         Average(stats, prefetch, "wait_us") / 1000);
+}
+
+void RunBenchmark() {
+  CAFFE_ENFORCE(!FLAGS_db.empty(), "--db must be given.");
+  CAFFE_ENFORCE_GT(FLAGS_iter, 0);
+  Workspace ws;
+  OperatorDef create_db;
+  create_db.set_type("CreateDB");
+  create_db.add_output("reader");
+  AddArgument("db", FLAGS_db, &create_db);
+  AddArgument("db_type", FLAGS_db_type, &create_db);
+  CAFFE_ENFORCE(CreateOperator(create_db, &ws)->Run());
+
+  auto op = CreateOperator(MakeInputOpDef(), &ws);
+  for (int i = 0; i < FLAGS_warmup; ++i) {
+    CAFFE_ENFORCE(op->Run());
+  }
+  // Only count the measured batches.
+  StatRegistry::get().publish(true);
+
+  const int samples_per_batch = std::max(FLAGS_batch_size, 1);
+  Timer timer;
+  Timer interval_timer;
+  for (int i = 0; i < FLAGS_iter; ++i) {
+    CAFFE_ENFORCE(op->Run());
+    if (FLAGS_consumer_us > 0) {
+      std::this_thread::sleep_for(
+          std::chrono::microseconds(FLAGS_consumer_us));
+    }
+    if (FLAGS_report_interval > 0 && (i + 1) % FLAGS_report_interval == 0) {
+      printf("Batch %05d, %f samples/sec.\n", i + 1,
+             FLAGS_report_interval * samples_per_batch /
+                 interval_timer.Seconds());
+      interval_timer.Start();
+    }
+  }
+  const double seconds = timer.Seconds();
+  const auto stats = toMap(StatRegistry::get().publish());
+
+  printf("%s: %d batches of %d in %.3f s, %f samples/sec sustained.\n",
+         FLAGS_op.c_str(), FLAGS_iter, samples_per_batch, seconds,
+         FLAGS_iter * samples_per_batch / seconds);
+  PrintStageStats(stats, FLAGS_iter);
+}
+
+} // namespace
+} // namespace caffe2
+
+int main(int argc, char** argv) {
+  caffe2::GlobalInit(&argc, &argv);
+  caffe2::RunBenchmark();
+  return 0;
+}
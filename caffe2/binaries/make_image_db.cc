@@ -36,6 +36,7 @@
 #include <string>
 #include <thread>
 
+#include "caffe2/binaries/sharded_db_writer.h"
 #include "caffe2/core/common.h"
 #include "caffe2/core/db.h"
 #include "caffe2/core/init.h"
@@ -63,6 +64,15 @@ CAFFE2_DEFINE_int(
     num_threads,
     -1,
     "Number of image parsing and conversion threads.");
+CAFFE2_DEFINE_int(batch_size, 1000, "The write batch size of every shard.");
+CAFFE2_DEFINE_int(
+    num_shards,
+    1,
+    "The number of output dbs, named <output_db_name>_shard_<i> when more "
+    "than one, the images being dealt to them in turn.");
+
+// Number of serialized images a converter gets ahead of the writers by.
+constexpr int kMaxConverted = 64;
 
 namespace caffe2 {
 
@@ -108,7 +118,7 @@ class Converter {
       cv_.wait(lock);
     }
 
-    auto value = out_.front();
+    auto value = std::move(out_.front());
     out_.pop();
     cv_.notify_one();
     return value;
@@ -176,12 +186,12 @@ class Converter {
 
       protos_.SerializeToString(&value);
 
-      // Add serialized proto to out queue or wait if it is not empty
+      // Add serialized proto to out queue or wait if it is full
       lock.lock();
-      while (!out_.empty()) {
+      while (out_.size() >= kMaxConverted) {
         cv_.wait(lock);
       }
-      out_.push(value);
+      out_.push(std::move(value));
       cv_.notify_one();
     }
   }
@@ -224,8 +234,17 @@ void ConvertImageDataset(
   LOG(INFO) << "Processing " << lines.size() << " images...";
   LOG(INFO) << "Opening DB " << output_db_name;
 
-  auto db = db::CreateDB(caffe2::FLAGS_db, output_db_name, db::NEW);
-  auto transaction = db->NewTransaction();
+  CAFFE_ENFORCE_GT(caffe2::FLAGS_num_shards, 0);
+  std::vector<std::string> sources;
+  for (int i = 0; i < caffe2::FLAGS_num_shards; ++i) {
+    sources.push_back(
+        caffe2::FLAGS_num_shards == 1
+            ? output_db_name
+            : output_db_name + "_shard_" + to_string(i));
+  }
+  // The shards are written by threads of their own while the converters
+  // encode the next images.
+  ShardedDBWriter writer(caffe2::FLAGS_db, sources, caffe2::FLAGS_batch_size);
 
   LOG(INFO) << "Using " << num_threads << " processing threads...";
   std::vector<Converter> converters(num_threads);
@@ -254,17 +273,15 @@ void ConvertImageDataset(
     DCHECK_LE(key_len, sizeof(key_cstr));
 
     // Put in db
-    transaction->Put(string(key_cstr), value);
+    writer.Put(i % writer.num_shards(), string(key_cstr), std::move(value));
 
     if (++count % 1000 == 0) {
-      // Commit the current writes.
-      transaction->Commit();
       LOG(INFO) << "Processed " << count << " files.";
     }
   }
 
-  // Commit final transaction
-  transaction->Commit();
+  // Commit the final writes
+  writer.Finish();
   LOG(INFO) << "Processed " << count << " files.";
 }
 
@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Lowers an inference net to C++ for static input shapes, see
+// caffe2/core/net_compiler.h. Build the output into a shared library linked
+// against caffe2, e.g.
+//
+//   c++ -std=c++11 -O3 -shared -fPIC net.cc -lcaffe2 -o libnet.so
+//
+// and run it with a CompiledPredictor(init_net, "<net name>", "libnet.so").
+
+#include <fstream>
+
+#include "caffe2/core/flags.h"
+#include "caffe2/core/init.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/net_compiler.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/utils/proto_utils.h"
+#include "caffe2/utils/string_utils.h"
+
+CAFFE2_DEFINE_string(net, "", "The given net to compile.");
+CAFFE2_DEFINE_string(
+    init_net,
+    "",
+    "The given net to initialize the parameters, which are bound to the "
+    "compiled net in the same shapes.");
+CAFFE2_DEFINE_string(
+    input,
+    "",
+    "Inputs of the net, comma separated, in the order of Predictor::run.");
+CAFFE2_DEFINE_string(
+    input_dims,
+    "",
+    "The static dims of the inputs, which are float TensorCPUs, as comma "
+    "separated numbers. Use semicolons to separate the inputs.");
+CAFFE2_DEFINE_string(output, "", "The C++ file to write.");
+
+namespace caffe2 {
+
+void run() {
+  CAFFE_ENFORCE(!FLAGS_net.empty(), "Use --net=/path/to/net.");
+  CAFFE_ENFORCE(!FLAGS_output.empty(), "Use --output=/path/to/net.cc.");
+  Workspace ws;
+  if (!FLAGS_init_net.empty()) {
+    NetDef init_net;
+    CAFFE_ENFORCE(ReadProtoFromFile(FLAGS_init_net, &init_net));
+    CAFFE_ENFORCE(ws.RunNetOnce(init_net));
+  }
+  NetDef net;
+  CAFFE_ENFORCE(ReadProtoFromFile(FLAGS_net, &net));
+
+  CaffeMap<string, std::vector<TIndex>> input_dims;
+  const auto inputs = split(',', FLAGS_input);
+  const auto dims = split(';', FLAGS_input_dims);
+  CAFFE_ENFORCE_EQ(
+      inputs.size(), dims.size(), "Give the dims of every input and only them");
+  for (int i = 0; i < inputs.size(); ++i) {
+    for (const auto& d : split(',', dims[i])) {
+      input_dims[inputs[i]].push_back(caffe2::stoi(d));
+    }
+  }
+
+  const auto plan = net_compiler::PlanNet(net, &ws, input_dims);
+  int lowered = 0;
+  for (bool op_lowered : plan.lowered) {
+    lowered += op_lowered;
+  }
+  LOG(INFO) << "Lowered " << lowered << " of " << net.op_size()
+            << " operators, with an arena of " << plan.arena.arena_bytes
+            << " bytes";
+  std::ofstream out(FLAGS_output);
+  out << net_compiler::GenerateCpp(net, &ws, input_dims);
+  CAFFE_ENFORCE(out.good(), "Could not write ", FLAGS_output);
+}
+
+} // namespace caffe2
+
+int main(int argc, char** argv) {
+  caffe2::GlobalInit(&argc, &argv);
+  caffe2::run();
+  // This is to allow us to use memory leak checks.
+  google::protobuf::ShutdownProtobufLibrary();
+  return 0;
+}
@@ -0,0 +1,373 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks of the HIP operators that dominate our models, over the shapes
+// they are run at. Every benchmark reports the achieved bandwidth (GB/s) and
+// compute (TFLOP/s) next to the fraction of the device peak (peak_bw and
+// peak_flops), so that a kernel regression shows up as a drop against the
+// roofline rather than only as a time that depends on the machine.
+//
+// The bytes are the minimal traffic of the operator: every input and output
+// read or written once (only the gathered rows for SparseLengthsSum). The
+// operator time is measured on the device with events.
+
+#include <random>
+
+#include "benchmark/benchmark.h"
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/proto_utils.h"
+
+#define CAFFE2_SKIP_IF_NO_GPU                                         \
+    if(!caffe2::NumHipDevices())                                      \
+    {                                                                 \
+        state.SkipWithError("No HIP available, skipping benchmark."); \
+        return;                                                       \
+    }
+
+using namespace caffe2;
+
+namespace {
+
+struct DevicePeak
+{
+    double bytes_per_second;
+    double flops_per_second;
+};
+
+// Peak bandwidth and FP32 FMA throughput of device 0: 64 lanes per compute
+// unit, two flops per FMA.
+const DevicePeak& GetDevicePeak()
+{
+    static DevicePeak peak = []() {
+        hipDeviceProp_t prop;
+        HIP_ENFORCE(hipGetDeviceProperties(&prop, 0));
+        DevicePeak p;
+        // Clock rates are in kHz, the memory is double data rate.
+        p.bytes_per_second = 2.0 * prop.memoryClockRate * 1e3 * prop.memoryBusWidth / 8;
+        p.flops_per_second = 2.0 * 64 * prop.multiProcessorCount * prop.clockRate * 1e3;
+        return p;
+    }();
+    return peak;
+}
+
+struct InputSpec
+{
+    string name;
+    vector<TIndex> dims;
+    // Int32 tensors are filled with values in [0, max_index), float tensors
+    // with values in [-1, 1], unless the input is constant.
+    bool is_int;
+    int max_index;
+    bool constant;
+    float value;
+};
+
+InputSpec FloatInput(const string& name, vector<TIndex> dims)
+{
+    return InputSpec{name, std::move(dims), false, 0, false, 0};
+}
+
+InputSpec IndexInput(const string& name, vector<TIndex> dims, int max_index)
+{
+    return InputSpec{name, std::move(dims), true, max_index, false, 0};
+}
+
+InputSpec ConstantInput(const string& name, vector<TIndex> dims, bool is_int, float value)
+{
+    return InputSpec{name, std::move(dims), is_int, 0, true, value};
+}
+
+void FeedInputs(const vector<InputSpec>& inputs, Workspace* ws)
+{
+    std::mt19937 gen(1701);
+    for(const auto& spec : inputs)
+    {
+        TensorCPU cpu(spec.dims);
+        if(spec.is_int)
+        {
+            std::uniform_int_distribution<int> dist(0, std::max(spec.max_index - 1, 0));
+            int* data = cpu.mutable_data<int>();
+            for(TIndex i = 0; i < cpu.size(); ++i)
+            {
+                data[i] = spec.constant ? static_cast<int>(spec.value) : dist(gen);
+            }
+        }
+        else
+        {
+            std::uniform_real_distribution<float> dist(-1, 1);
+            float* data = cpu.mutable_data<float>();
+            for(TIndex i = 0; i < cpu.size(); ++i)
+            {
+                data[i] = spec.constant ? spec.value : dist(gen);
+            }
+        }
+        ws->CreateBlob(spec.name)->GetMutable<TensorHIP>()->CopyFrom(cpu);
+    }
+}
+
+// Runs the operator once to allocate its outputs, then times it on the
+// device. If bytes is not positive, it is computed from the input and output
+// sizes.
+void RunOperatorBenchmark(benchmark::State& state,
+                          const string& type,
+                          const string& engine,
+                          const vector<InputSpec>& inputs,
+                          const vector<string>& outputs,
+                          const vector<Argument>& args,
+                          double flops,
+                          double bytes = 0)
+{
+    Workspace ws;
+    FeedInputs(inputs, &ws);
+    vector<string> input_names;
+    for(const auto& spec : inputs)
+    {
+        input_names.push_back(spec.name);
+    }
+    DeviceOption option;
+    option.set_device_type(HIP);
+    auto def = CreateOperatorDef(type, "", input_names, outputs, args, option, engine);
+    auto op  = CreateOperator(def, &ws);
+    CAFFE_ENFORCE(op->Run());
+
+    if(bytes <= 0)
+    {
+        for(const auto& name : input_names)
+        {
+            bytes += ws.GetBlob(name)->Get<TensorHIP>().nbytes();
+        }
+        for(const auto& name : outputs)
+        {
+            bytes += ws.GetBlob(name)->Get<TensorHIP>().nbytes();
+        }
+    }
+
+    hipStream_t stream = HIPContext::hip_stream(0, 0);
+    hipEvent_t start, stop;
+    HIP_ENFORCE(hipEventCreate(&start));
+    HIP_ENFORCE(hipEventCreate(&stop));
+    double seconds = 0;
+    while(state.KeepRunning())
+    {
+        HIP_ENFORCE(hipEventRecord(start, stream));
+        CAFFE_ENFORCE(op->Run());
+        HIP_ENFORCE(hipEventRecord(stop, stream));
+        HIP_ENFORCE(hipEventSynchronize(stop));
+        float millis = 0;
+        HIP_ENFORCE(hipEventElapsedTime(&millis, start, stop));
+        state.SetIterationTime(millis / 1e3);
+        seconds += millis / 1e3;
+    }
+    HIP_ENFORCE(hipEventDestroy(start));
+    HIP_ENFORCE(hipEventDestroy(stop));
+
+    const auto& peak               = GetDevicePeak();
+    const double bytes_per_second  = bytes * state.iterations() / seconds;
+    state.counters["GB/s"]         = bytes_per_second / 1e9;
+    state.counters["peak_bw"]      = bytes_per_second / peak.bytes_per_second;
+    if(flops > 0)
+    {
+        const double flops_per_second = flops * state.iterations() / seconds;
+        state.counters["TFLOP/s"]     = flops_per_second / 1e12;
+        state.counters["peak_flops"]  = flops_per_second / peak.flops_per_second;
+    }
+}
+
+} // namespace
+
+// NCHW convolutions of ResNet-50 at batch 32.
+// Args: N, C, H, W, M, kernel, stride.
+static void BM_ConvMIOpen(benchmark::State& state)
+{
+    CAFFE2_SKIP_IF_NO_GPU;
+    const int N = state.range(0), C = state.range(1), H = state.range(2), W = state.range(3);
+    const int M = state.range(4), kernel = state.range(5), stride = state.range(6);
+    const int pad = kernel / 2;
+    const int OH  = (H + 2 * pad - kernel) / stride + 1;
+    const int OW  = (W + 2 * pad - kernel) / stride + 1;
+    RunOperatorBenchmark(state,
+                         "Conv",
+                         "MIOPEN",
+                         {FloatInput("X", {N, C, H, W}),
+                          FloatInput("W", {M, C, kernel, kernel}),
+                          FloatInput("b", {M})},
+                         {"Y"},
+                         {MakeArgument<int>("kernel", kernel),
+                          MakeArgument<int>("stride", stride),
+                          MakeArgument<int>("pad", pad)},
+                         2.0 * N * M * OH * OW * C * kernel * kernel);
+}
+BENCHMARK(BM_ConvMIOpen)
+    ->Args({32, 3, 224, 224, 64, 7, 2})
+    ->Args({32, 64, 56, 56, 64, 3, 1})
+    ->Args({32, 256, 56, 56, 64, 1, 1})
+    ->Args({32, 128, 28, 28, 128, 3, 1})
+    ->Args({32, 256, 14, 14, 256, 3, 1})
+    ->Args({32, 1024, 14, 14, 256, 1, 1})
+    ->Args({32, 512, 7, 7, 512, 3, 1})
+    ->UseManualTime();
+
+// Classifier and recommendation MLP layers.
+// Args: M, K, N.
+static void BM_FC(benchmark::State& state)
+{
+    CAFFE2_SKIP_IF_NO_GPU;
+    const int M = state.range(0), K = state.range(1), N = state.range(2);
+    RunOperatorBenchmark(state,
+                         "FC",
+                         "",
+                         {FloatInput("X", {M, K}), FloatInput("W", {N, K}), FloatInput("b", {N})},
+                         {"Y"},
+                         {},
+                         2.0 * M * K * N);
+}
+BENCHMARK(BM_FC)
+    ->Args({64, 2048, 1000})
+    ->Args({256, 4096, 4096})
+    ->Args({512, 1024, 1024})
+    ->Args({2048, 512, 256})
+    ->Args({2048, 256, 1})
+    ->UseManualTime();
+
+// Attention score and context products.
+// Args: batch, M, K, N.
+static void BM_BatchMatMul(benchmark::State& state)
+{
+    CAFFE2_SKIP_IF_NO_GPU;
+    const int B = state.range(0), M = state.range(1), K = state.range(2), N = state.range(3);
+    RunOperatorBenchmark(state,
+                         "BatchMatMul",
+                         "",
+                         {FloatInput("A", {B, M, K}), FloatInput("B", {B, K, N})},
+                         {"Y"},
+                         {},
+                         2.0 * B * M * K * N);
+}
+BENCHMARK(BM_BatchMatMul)
+    ->Args({128, 128, 64, 128})
+    ->Args({128, 128, 128, 64})
+    ->Args({16, 512, 64, 512})
+    ->Args({64, 64, 512, 64})
+    ->UseManualTime();
+
+// Args: number of elements.
+static void BM_Add(benchmark::State& state)
+{
+    CAFFE2_SKIP_IF_NO_GPU;
+    const int N = state.range(0);
+    RunOperatorBenchmark(
+        state, "Add", "", {FloatInput("A", {N}), FloatInput("B", {N})}, {"Y"}, {}, N);
+}
+BENCHMARK(BM_Add)->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 24)->UseManualTime();
+
+// Args: number of elements.
+static void BM_ReluMIOpen(benchmark::State& state)
+{
+    CAFFE2_SKIP_IF_NO_GPU;
+    const int N = state.range(0);
+    RunOperatorBenchmark(state, "Relu", "MIOPEN", {FloatInput("X", {N})}, {"Y"}, {}, N);
+}
+BENCHMARK(BM_ReluMIOpen)->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 24)->UseManualTime();
+
+// Classifier and attention softmaxes.
+// Args: N, D.
+static void BM_Softmax(benchmark::State& state)
+{
+    CAFFE2_SKIP_IF_NO_GPU;
+    const int N = state.range(0), D = state.range(1);
+    RunOperatorBenchmark(state, "Softmax", "", {FloatInput("X", {N, D})}, {"Y"}, {}, 0);
+}
+BENCHMARK(BM_Softmax)
+    ->Args({64, 1000})
+    ->Args({256, 32768})
+    ->Args({16384, 128})
+    ->UseManualTime();
+
+// Inference batch norm of ResNet-50 at batch 32.
+// Args: N, C, H, W.
+static void BM_SpatialBNMIOpen(benchmark::State& state)
+{
+    CAFFE2_SKIP_IF_NO_GPU;
+    const int N = state.range(0), C = state.range(1), H = state.range(2), W = state.range(3);
+    RunOperatorBenchmark(state,
+                         "SpatialBN",
+                         "MIOPEN",
+                         {FloatInput("X", {N, C, H, W}),
+                          FloatInput("scale", {C}),
+                          FloatInput("bias", {C}),
+                          FloatInput("mean", {C}),
+                          ConstantInput("var", {C}, false, 1)},
+                         {"Y"},
+                         {MakeArgument<int>("is_test", 1)},
+                         2.0 * N * C * H * W);
+}
+BENCHMARK(BM_SpatialBNMIOpen)
+    ->Args({32, 64, 112, 112})
+    ->Args({32, 256, 56, 56})
+    ->Args({32, 1024, 14, 14})
+    ->Args({32, 2048, 7, 7})
+    ->UseManualTime();
+
+// NCHW to NHWC.
+// Args: N, C, H, W.
+static void BM_Transpose(benchmark::State& state)
+{
+    CAFFE2_SKIP_IF_NO_GPU;
+    const int N = state.range(0), C = state.range(1), H = state.range(2), W = state.range(3);
+    RunOperatorBenchmark(state,
+                         "Transpose",
+                         "",
+                         {FloatInput("X", {N, C, H, W})},
+                         {"Y"},
+                         {MakeArgument<vector<int>>("axes", {0, 2, 3, 1})},
+                         0);
+}
+BENCHMARK(BM_Transpose)
+    ->Args({32, 64, 56, 56})
+    ->Args({32, 256, 14, 14})
+    ->Args({32, 3, 224, 224})
+    ->UseManualTime();
+
+// Embedding table lookups of recommendation models.
+// Args: rows, dim, batch, pooling (indices per bag).
+static void BM_SparseLengthsSum(benchmark::State& state)
+{
+    CAFFE2_SKIP_IF_NO_GPU;
+    const int rows = state.range(0), dim = state.range(1);
+    const int batch = state.range(2), pooling = state.range(3);
+    const double lookups = static_cast<double>(batch) * pooling;
+    RunOperatorBenchmark(state,
+                         "SparseLengthsSum",
+                         "",
+                         {FloatInput("data", {rows, dim}),
+                          IndexInput("indices", {batch * pooling}, rows),
+                          ConstantInput("lengths", {batch}, true, pooling)},
+                         {"Y"},
+                         {},
+                         lookups * dim,
+                         lookups * (dim + 1) * sizeof(float) + batch * (dim + 1) * sizeof(float));
+}
+BENCHMARK(BM_SparseLengthsSum)
+    ->Args({1000000, 64, 2048, 20})
+    ->Args({1000000, 32, 4096, 80})
+    ->Args({100000, 128, 1024, 50})
+    ->Args({5000000, 16, 8192, 1})
+    ->UseManualTime();
+
+BENCHMARK_MAIN()
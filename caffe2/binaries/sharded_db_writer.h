@@ -0,0 +1,170 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CAFFE2_BINARIES_SHARDED_DB_WRITER_H_
+#define CAFFE2_BINARIES_SHARDED_DB_WRITER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "caffe2/core/db.h"
+#include "caffe2/core/logging.h"
+
+namespace caffe2 {
+
+/**
+ * Writes key/value records into a number of output dbs, each one from a
+ * thread of its own, so that the shards are written in parallel and while
+ * the caller reads or encodes the next records.
+ *
+ * Records are handed over to the writers in chunks through bounded queues,
+ * which make Put() wait when the writers fall behind, and every writer
+ * commits its transaction each batch_size records. Finish() commits what is
+ * left and waits for the writers.
+ */
+class ShardedDBWriter {
+ public:
+  ShardedDBWriter(
+      const string& db_type,
+      const vector<string>& sources,
+      const int batch_size,
+      const int chunk_size = 256,
+      const int queue_chunks = 16)
+      : batch_size_(batch_size),
+        chunk_size_(chunk_size),
+        queue_chunks_(queue_chunks) {
+    CAFFE_ENFORCE(!sources.empty(), "Need at least one output db");
+    CAFFE_ENFORCE_GT(batch_size_, 0);
+    CAFFE_ENFORCE_GT(chunk_size, 0);
+    CAFFE_ENFORCE_GT(queue_chunks, 0);
+    for (const auto& source : sources) {
+      shards_.emplace_back(new Shard());
+      shards_.back()->db = db::CreateDB(db_type, source, db::NEW);
+      CAFFE_ENFORCE(shards_.back()->db, "Cannot create output db ", source);
+    }
+    for (auto& shard : shards_) {
+      shard->thread = std::thread(&ShardedDBWriter::Write, this, shard.get());
+    }
+  }
+
+  ~ShardedDBWriter() {
+    Finish();
+  }
+
+  int num_shards() const {
+    return shards_.size();
+  }
+
+  void Put(const int shard, string key, string value) {
+    auto& s = *shards_[shard];
+    s.pending.emplace_back(std::move(key), std::move(value));
+    if (s.pending.size() == chunk_size_) {
+      Flush(&s);
+    }
+  }
+
+  // Returns the number of records written to all the shards.
+  int64_t Finish() {
+    int64_t count = 0;
+    for (auto& shard : shards_) {
+      if (shard->thread.joinable()) {
+        Flush(shard.get());
+        {
+          std::lock_guard<std::mutex> lock(shard->mutex);
+          shard->done = true;
+        }
+        shard->not_empty.notify_one();
+        shard->thread.join();
+      }
+      count += shard->count;
+    }
+    return count;
+  }
+
+ private:
+  using Chunk = vector<std::pair<string, string>>;
+
+  struct Shard {
+    std::unique_ptr<db::DB> db;
+    std::thread thread;
+    // The chunk being filled by Put().
+    Chunk pending;
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<Chunk> queue;
+    bool done = false;
+    int64_t count = 0;
+  };
+
+  void Flush(Shard* shard) {
+    if (shard->pending.empty()) {
+      return;
+    }
+    {
+      std::unique_lock<std::mutex> lock(shard->mutex);
+      shard->not_full.wait(
+          lock, [&] { return shard->queue.size() < queue_chunks_; });
+      shard->queue.push_back(std::move(shard->pending));
+    }
+    shard->not_empty.notify_one();
+    shard->pending = Chunk();
+    shard->pending.reserve(chunk_size_);
+  }
+
+  void Write(Shard* shard) {
+    std::unique_ptr<db::Transaction> transaction(shard->db->NewTransaction());
+    int uncommitted = 0;
+    while (true) {
+      Chunk chunk;
+      {
+        std::unique_lock<std::mutex> lock(shard->mutex);
+        shard->not_empty.wait(
+            lock, [&] { return !shard->queue.empty() || shard->done; });
+        if (shard->queue.empty()) {
+          break;
+        }
+        chunk = std::move(shard->queue.front());
+        shard->queue.pop_front();
+      }
+      shard->not_full.notify_one();
+      for (const auto& record : chunk) {
+        transaction->Put(record.first, record.second);
+        if (++uncommitted == batch_size_) {
+          transaction->Commit();
+          uncommitted = 0;
+        }
+      }
+      shard->count += chunk.size();
+    }
+    transaction->Commit();
+  }
+
+  const int batch_size_;
+  const size_t chunk_size_;
+  const size_t queue_chunks_;
+  vector<std::unique_ptr<Shard>> shards_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_BINARIES_SHARDED_DB_WRITER_H_
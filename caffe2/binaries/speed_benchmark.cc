@@ -14,11 +14,25 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
 #include <string>
+#include <thread>
 
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "caffe2/binaries/speed_benchmark_backend.h"
 #include "caffe2/core/init.h"
 #include "caffe2/core/logging.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/net_cost_model.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/core/timer.h"
 #include "caffe2/proto/caffe2.pb.h"
 #include "caffe2/utils/proto_utils.h"
 #include "caffe2/utils/string_utils.h"
@@ -66,23 +80,498 @@ CAFFE2_DEFINE_bool(
     run_individual,
     false,
     "Whether to benchmark individual operators.");
+CAFFE2_DEFINE_int(
+    concurrency,
+    0,
+    "If positive, also measure the throughput of this many threads running "
+    "their own copy of the net on the same parameters, each for --iter "
+    "iterations.");
+CAFFE2_DEFINE_bool(
+    hip,
+    false,
+    "Run the nets on the HIP device given by --gpu, with the inputs copied "
+    "to it. Per operator times then include the device time. Only available "
+    "in speed_benchmark_hip.");
+CAFFE2_DEFINE_int(gpu, 0, "The device to run on with --hip.");
+CAFFE2_DEFINE_double(
+    peak_gflops,
+    0,
+    "If set with peak_gbps, the peak GFLOPS of the device, to report how close "
+    "the net gets to the least time its estimated cost can take.");
+CAFFE2_DEFINE_double(
+    peak_gbps,
+    0,
+    "The peak memory bandwidth of the device in GB/s, see peak_gflops.");
+CAFFE2_DEFINE_string(
+    json_output,
+    "",
+    "If set, the results are also written to this file as JSON.");
+CAFFE2_DEFINE_string(
+    net_types,
+    "",
+    "If set, the main net is also benchmarked as each of these comma "
+    "separated net types, '*' meaning every registered one, to compare "
+    "the executors. The types that can't run the net are skipped.");
+CAFFE2_DEFINE_string(
+    num_workers,
+    "",
+    "Comma separated worker counts the net types are compared with, used as "
+    "the num_workers of the net and the CPU pool size of the async nets. "
+    "Defaults to the num_workers of the net.");
+CAFFE2_DEFINE_string(
+    streams_per_gpu,
+    "",
+    "Comma separated values of --caffe2_streams_per_gpu the net types are "
+    "compared with. Defaults to the current value.");
 
 CAFFE2_DEFINE_bool(force_engine, false, "Force engine field for all operators");
 CAFFE2_DEFINE_string(engine, "", "Forced engine field value");
 CAFFE2_DEFINE_bool(force_algo, false, "Force algo arg for all operators");
 CAFFE2_DEFINE_string(algo, "", "Forced algo arg value");
 
+CAFFE2_DECLARE_int(caffe2_net_async_cpu_pool_size);
+CAFFE2_DECLARE_int(caffe2_streams_per_gpu);
+
 using std::string;
 using std::unique_ptr;
 using std::vector;
 
+namespace caffe2 {
+
+CAFFE_DEFINE_REGISTRY(SpeedBenchmarkBackendRegistry, SpeedBenchmarkBackend);
+
+namespace {
+
+struct LatencyStats {
+  float mean = 0;
+  float min = 0;
+  float max = 0;
+  float p50 = 0;
+  float p90 = 0;
+  float p99 = 0;
+};
+
+struct OperatorTime {
+  string name;
+  string type;
+  float host_ms = 0;
+  // Negative when the backend has no device timer.
+  float device_ms = -1;
+  // From the cost inference function of the operator, if it has one.
+  bool has_cost = false;
+  OpSchema::Cost cost;
+};
+
+// One configuration of --net_types, --num_workers and --streams_per_gpu.
+struct ExecutorResult {
+  string type;
+  int num_workers = 0;
+  int streams_per_gpu = 0;
+  LatencyStats latency;
+  float iters_per_second = 0;
+  // Mean number of cores busy in the process during the runs, negative if
+  // the platform doesn't report it.
+  float cpu_utilization = -1;
+};
+
+// Nearest rank percentile of the sorted millis.
+float Percentile(const vector<float>& sorted, float p) {
+  const int rank = static_cast<int>(std::ceil(p / 100 * sorted.size()));
+  return sorted[std::min(std::max(rank, 1), (int)sorted.size()) - 1];
+}
+
+LatencyStats ComputeLatencyStats(vector<float> millis) {
+  LatencyStats stats;
+  if (millis.empty()) {
+    return stats;
+  }
+  std::sort(millis.begin(), millis.end());
+  for (float ms : millis) {
+    stats.mean += ms;
+  }
+  stats.mean /= millis.size();
+  stats.min = millis.front();
+  stats.max = millis.back();
+  stats.p50 = Percentile(millis, 50);
+  stats.p90 = Percentile(millis, 90);
+  stats.p99 = Percentile(millis, 99);
+  return stats;
+}
+
+// Returns the wall clock milliseconds of each of the main runs. Operators
+// wait for their device work, so this includes the device time.
+vector<float> TimeRuns(NetBase* net, int warmup, int iter) {
+  for (int i = 0; i < warmup; ++i) {
+    CAFFE_ENFORCE(net->Run(), "Warmup run ", i, " has failed.");
+  }
+  vector<float> millis(iter);
+  Timer timer;
+  for (int i = 0; i < iter; ++i) {
+    timer.Start();
+    CAFFE_ENFORCE(net->Run(), "Main run ", i, " has failed.");
+    millis[i] = timer.MilliSeconds();
+  }
+  return millis;
+}
+
+// User and system CPU seconds used by the process so far, negative if unknown.
+double CpuSeconds() {
+#ifndef _WIN32
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+        1e-6 * (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+  }
+#endif
+  return -1;
+}
+
+vector<int> ParseIntList(const string& list, int default_value) {
+  vector<int> values;
+  for (const auto& s : split(',', list)) {
+    if (s.size()) {
+      values.push_back(caffe2::stoi(s));
+    }
+  }
+  if (values.empty()) {
+    values.push_back(default_value);
+  }
+  return values;
+}
+
+// Runs net_def as each of the net types of --net_types, for every worker
+// count of --num_workers and every stream count of --streams_per_gpu, each in
+// its own child workspace of ws.
+vector<ExecutorResult>
+CompareNetTypes(const NetDef& net_def, Workspace* ws, int warmup, int iter) {
+  vector<string> types = FLAGS_net_types == "*" ? NetRegistry()->Keys()
+                                                : split(',', FLAGS_net_types);
+  const auto worker_counts = ParseIntList(
+      FLAGS_num_workers, net_def.has_num_workers() ? net_def.num_workers() : 1);
+  const int default_pool_size = FLAGS_caffe2_net_async_cpu_pool_size;
+  const int default_streams = FLAGS_caffe2_streams_per_gpu;
+  const auto stream_counts =
+      ParseIntList(FLAGS_streams_per_gpu, default_streams);
+  vector<ExecutorResult> results;
+  for (const auto& type : types) {
+    for (int num_workers : worker_counts) {
+      for (int streams : stream_counts) {
+        NetDef def(net_def);
+        def.set_type(type);
+        def.set_num_workers(num_workers);
+        // The async nets read the flags when they are created. Their CPU pool
+        // is shared and only created again once no net holds it, so the pool
+        // size doesn't change while the main net is an async one.
+        FLAGS_caffe2_net_async_cpu_pool_size = num_workers;
+        FLAGS_caffe2_streams_per_gpu = streams;
+        Workspace child(ws);
+        unique_ptr<NetBase> net;
+        try {
+          net = CreateNet(def, &child);
+        } catch (const std::exception& e) {
+          LOG(WARNING) << "Skipping net type " << type << ": " << e.what();
+        }
+        if (!net) {
+          continue;
+        }
+        TimeRuns(net.get(), warmup, 0);
+        ExecutorResult result;
+        result.type = type;
+        result.num_workers = num_workers;
+        result.streams_per_gpu = streams;
+        const double cpu_start = CpuSeconds();
+        Timer timer;
+        result.latency = ComputeLatencyStats(TimeRuns(net.get(), 0, iter));
+        const float total_ms = timer.MilliSeconds();
+        const double cpu_end = CpuSeconds();
+        result.iters_per_second = 1000.0f * iter / total_ms;
+        if (cpu_start >= 0 && cpu_end >= 0) {
+          result.cpu_utilization = 1e3 * (cpu_end - cpu_start) / total_ms;
+        }
+        results.push_back(result);
+      }
+    }
+  }
+  FLAGS_caffe2_net_async_cpu_pool_size = default_pool_size;
+  FLAGS_caffe2_streams_per_gpu = default_streams;
+  return results;
+}
+
+void LogExecutorResults(const vector<ExecutorResult>& results) {
+  LOG(INFO) << "Net types:";
+  for (const auto& r : results) {
+    LOG(INFO) << std::setw(20) << std::setfill(' ') << r.type
+              << " workers " << r.num_workers << " streams "
+              << r.streams_per_gpu << ": " << r.iters_per_second
+              << " iters/s, p50 " << r.latency.p50 << " ms, p90 "
+              << r.latency.p90 << " ms, p99 " << r.latency.p99
+              << " ms, CPU " << r.cpu_utilization << " cores";
+  }
+}
+
+// Runs the operators of the net one by one, in order, and returns their mean
+// time per run. With a backend, the device time of each operator is measured
+// on the device too.
+vector<OperatorTime>
+TimeOperators(NetBase* net, int iter, SpeedBenchmarkBackend* backend) {
+  const auto ops = net->GetOperators();
+  vector<OperatorTime> times(ops.size());
+  for (int idx = 0; idx < ops.size(); ++idx) {
+    const auto& def = ops[idx]->debug_def();
+    times[idx].name = def.name().size()
+        ? def.name()
+        : (def.output_size() ? def.output(0) : "NO_OUTPUT");
+    times[idx].type = def.type();
+    if (backend) {
+      times[idx].device_ms = 0;
+    }
+  }
+  Timer timer;
+  for (int i = 0; i < iter; ++i) {
+    for (auto* op : ops) {
+      op->ResetEvent();
+    }
+    for (int idx = 0; idx < ops.size(); ++idx) {
+      auto* op = ops[idx];
+      if (backend) {
+        backend->StartTimer(op->device_option());
+      }
+      timer.Start();
+      CAFFE_ENFORCE(
+          op->Run(),
+          "operator ",
+          times[idx].name,
+          "(",
+          times[idx].type,
+          ") has failed.");
+      times[idx].host_ms += timer.MilliSeconds();
+      if (backend) {
+        const float device_ms = backend->StopTimer();
+        if (device_ms < 0 || times[idx].device_ms < 0) {
+          times[idx].device_ms = -1;
+        } else {
+          times[idx].device_ms += device_ms;
+        }
+      }
+    }
+  }
+  for (auto& t : times) {
+    t.host_ms /= iter;
+    if (t.device_ms > 0) {
+      t.device_ms /= iter;
+    }
+  }
+  return times;
+}
+
+// Runs the net on `concurrency` threads at once, each in its own child
+// workspace of ws so that they share the parameters and inputs but not the
+// intermediate blobs, and returns the total iterations per second.
+float MeasureThroughput(
+    const NetDef& net_def,
+    Workspace* ws,
+    int concurrency,
+    int warmup,
+    int iter) {
+  vector<unique_ptr<Workspace>> workspaces;
+  vector<unique_ptr<NetBase>> nets;
+  for (int i = 0; i < concurrency; ++i) {
+    workspaces.emplace_back(new Workspace(ws));
+    nets.push_back(CreateNet(net_def, workspaces.back().get()));
+    CAFFE_ENFORCE(nets.back(), "Failed to create net ", i);
+  }
+  std::atomic<int> ready(0);
+  std::atomic<bool> start(false);
+  vector<std::thread> threads;
+  for (int i = 0; i < concurrency; ++i) {
+    threads.emplace_back([&, i]() {
+      for (int j = 0; j < warmup; ++j) {
+        CAFFE_ENFORCE(nets[i]->Run(), "Warmup run ", j, " has failed.");
+      }
+      ++ready;
+      while (!start) {
+        std::this_thread::yield();
+      }
+      for (int j = 0; j < iter; ++j) {
+        CAFFE_ENFORCE(nets[i]->Run(), "Main run ", j, " has failed.");
+      }
+    });
+  }
+  while (ready < concurrency) {
+    std::this_thread::yield();
+  }
+  Timer timer;
+  start = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return 1000.0f * concurrency * iter / timer.MilliSeconds();
+}
+
+string JsonString(const string& s) {
+  std::stringstream ss;
+  ss << '"';
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      ss << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      ss << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+         << static_cast<int>(c) << std::dec;
+    } else {
+      ss << c;
+    }
+  }
+  ss << '"';
+  return ss.str();
+}
+
+string ToJson(
+    const string& net_name,
+    const string& backend,
+    const LatencyStats& latency,
+    int concurrency,
+    float throughput,
+    const NetCostModel& cost_model,
+    const vector<OperatorTime>& op_times,
+    const vector<ExecutorResult>& executors) {
+  std::stringstream ss;
+  ss << "{\n";
+  ss << "  \"net\": " << JsonString(net_name) << ",\n";
+  ss << "  \"backend\": " << JsonString(backend) << ",\n";
+  ss << "  \"warmup\": " << FLAGS_warmup << ",\n";
+  ss << "  \"iter\": " << FLAGS_iter << ",\n";
+  ss << "  \"latency_ms\": {\"mean\": " << latency.mean
+     << ", \"min\": " << latency.min << ", \"max\": " << latency.max
+     << ", \"p50\": " << latency.p50 << ", \"p90\": " << latency.p90
+     << ", \"p99\": " << latency.p99 << "}";
+  if (concurrency > 0) {
+    ss << ",\n  \"throughput\": {\"concurrency\": " << concurrency
+       << ", \"iters_per_second\": " << throughput << "}";
+  }
+  ss << ",\n  \"cost\": {\"known_operators\": " << cost_model.num_known_ops()
+     << ", \"flops\": " << cost_model.total_cost().flops
+     << ", \"bytes_moved\": " << cost_model.total_cost().bytes_moved;
+  if (FLAGS_peak_gflops > 0 && FLAGS_peak_gbps > 0) {
+    ss << ", \"min_ms\": "
+       << 1e3 *
+            cost_model.MinSeconds(
+                1e9 * FLAGS_peak_gflops, 1e9 * FLAGS_peak_gbps);
+  }
+  ss << "}";
+  if (!op_times.empty()) {
+    ss << ",\n  \"operators\": [";
+    for (int idx = 0; idx < op_times.size(); ++idx) {
+      const auto& t = op_times[idx];
+      ss << (idx ? "," : "") << "\n    {\"index\": " << idx
+         << ", \"name\": " << JsonString(t.name)
+         << ", \"type\": " << JsonString(t.type)
+         << ", \"host_ms\": " << t.host_ms;
+      if (t.device_ms >= 0) {
+        ss << ", \"device_ms\": " << t.device_ms;
+      }
+      if (t.has_cost) {
+        ss << ", \"flops\": " << t.cost.flops
+           << ", \"bytes_moved\": " << t.cost.bytes_moved;
+      }
+      ss << "}";
+    }
+    ss << "\n  ]";
+  }
+  if (!executors.empty()) {
+    ss << ",\n  \"net_types\": [";
+    for (int idx = 0; idx < executors.size(); ++idx) {
+      const auto& r = executors[idx];
+      ss << (idx ? "," : "") << "\n    {\"type\": " << JsonString(r.type)
+         << ", \"num_workers\": " << r.num_workers
+         << ", \"streams_per_gpu\": " << r.streams_per_gpu
+         << ", \"iters_per_second\": " << r.iters_per_second
+         << ", \"latency_ms\": {\"mean\": " << r.latency.mean
+         << ", \"p50\": " << r.latency.p50 << ", \"p90\": " << r.latency.p90
+         << ", \"p99\": " << r.latency.p99 << "}";
+      if (r.cpu_utilization >= 0) {
+        ss << ", \"cpu_utilization\": " << r.cpu_utilization;
+      }
+      ss << "}";
+    }
+    ss << "\n  ]";
+  }
+  ss << "\n}\n";
+  return ss.str();
+}
+
+void LogOperatorTimes(const vector<OperatorTime>& op_times) {
+  CaffeMap<string, float> time_per_op_type;
+  for (int idx = 0; idx < op_times.size(); ++idx) {
+    const auto& t = op_times[idx];
+    std::stringstream device_str;
+    if (t.device_ms >= 0) {
+      device_str << " (" << t.device_ms << " ms/iter on device)";
+    }
+    std::stringstream flops_str;
+    const float ms = t.device_ms > 0 ? t.device_ms : t.host_ms;
+    if (t.has_cost && t.cost.flops && ms > 0) {
+      flops_str << " (" << 1e-6 * t.cost.flops / ms << " GFLOPS)";
+    }
+    LOG(INFO) << "Operator #" << idx << " (" << t.name << ", " << t.type
+              << ") " << t.host_ms << " ms/iter" << device_str.str()
+              << flops_str.str();
+    time_per_op_type[t.type] += t.host_ms;
+  }
+  LOG(INFO) << "Time per operator type:";
+  // sort by decreasing time spending.
+  std::vector<std::pair<string, float>> time_per_op_type_vec(
+      time_per_op_type.begin(), time_per_op_type.end());
+  std::sort(
+      time_per_op_type_vec.begin(),
+      time_per_op_type_vec.end(),
+      [](const std::pair<string, float>& a,
+         const std::pair<string, float>& b) { return a.second > b.second; });
+  for (const auto& item : time_per_op_type_vec) {
+    LOG(INFO) << std::setw(15) << std::setfill(' ') << item.second << " "
+              << item.first;
+  }
+}
+
+// Compares the cost of the net estimated by its cost model to the time it
+// took, and to the least time the cost can take with the peak_gflops and
+// peak_gbps of the device.
+void LogNetCost(const NetCostModel& cost_model, float ms) {
+  const auto& total = cost_model.total_cost();
+  LOG(INFO) << "Estimated cost per iter of " << cost_model.num_known_ops()
+            << " of the " << cost_model.num_ops() << " operators: "
+            << 1e-9 * total.flops << " GFLOP, " << 1e-9 * total.bytes_moved
+            << " GB moved. Achieved " << 1e-6 * total.flops / ms
+            << " GFLOPS, " << 1e-6 * total.bytes_moved / ms << " GB/s.";
+  if (FLAGS_peak_gflops > 0 && FLAGS_peak_gbps > 0) {
+    const double min_ms = 1e3 *
+        cost_model.MinSeconds(1e9 * FLAGS_peak_gflops, 1e9 * FLAGS_peak_gbps);
+    LOG(INFO) << "Theoretical minimum of the known operators: " << min_ms
+              << " ms per iter, " << 100 * min_ms / ms
+              << "% of the time taken.";
+  }
+}
+
+} // namespace
+} // namespace caffe2
+
 int main(int argc, char** argv) {
   caffe2::GlobalInit(&argc, &argv);
   unique_ptr<caffe2::Workspace> workspace(new caffe2::Workspace());
 
+  unique_ptr<caffe2::SpeedBenchmarkBackend> backend;
+  if (caffe2::FLAGS_hip) {
+    backend = caffe2::SpeedBenchmarkBackendRegistry()->Create("HIP");
+    CAFFE_ENFORCE(
+        backend,
+        "This binary was built without HIP support, use speed_benchmark_hip.");
+  }
+
   // Run initialization network.
   caffe2::NetDef net_def;
   CAFFE_ENFORCE(ReadProtoFromFile(caffe2::FLAGS_init_net, &net_def));
+  if (backend) {
+    net_def.mutable_device_option()->CopyFrom(backend->GetDeviceOption());
+  }
   CAFFE_ENFORCE(workspace->RunNetOnce(net_def));
 
   // Load input.
@@ -122,10 +611,22 @@ int main(int argc, char** argv) {
           "You requested input tensors, but neither input_file nor "
           "input_dims is set.");
     }
+    if (backend) {
+      for (const string& name : input_names) {
+        auto* blob = workspace->GetBlob(name);
+        if (blob->IsType<caffe2::TensorCPU>()) {
+          caffe2::TensorCPU cpu_tensor(blob->Get<caffe2::TensorCPU>());
+          backend->CopyToDevice(cpu_tensor, blob);
+        }
+      }
+    }
   }
 
   // Run main network.
   CAFFE_ENFORCE(ReadProtoFromFile(caffe2::FLAGS_net, &net_def));
+  if (backend) {
+    net_def.mutable_device_option()->CopyFrom(backend->GetDeviceOption());
+  }
   // force changing engine and algo
   if (caffe2::FLAGS_force_engine) {
     LOG(INFO) << "force engine be: " << caffe2::FLAGS_engine;
@@ -141,10 +642,67 @@ int main(int argc, char** argv) {
           ->set_s(caffe2::FLAGS_algo);
     }
   }
+  CAFFE_ENFORCE_GE(caffe2::FLAGS_warmup, 0);
+  CAFFE_ENFORCE_GT(caffe2::FLAGS_iter, 0);
+
+  // The throughput runs go first, while the intermediate blobs of the net
+  // only exist in the child workspaces and not in the shared one.
+  float throughput = 0;
+  if (caffe2::FLAGS_concurrency > 0) {
+    throughput = caffe2::MeasureThroughput(
+        net_def,
+        workspace.get(),
+        caffe2::FLAGS_concurrency,
+        caffe2::FLAGS_warmup,
+        caffe2::FLAGS_iter);
+    LOG(INFO) << "Throughput at concurrency " << caffe2::FLAGS_concurrency
+              << ": " << throughput << " iters per second.";
+  }
+
   caffe2::NetBase* net = workspace->CreateNet(net_def);
   CHECK_NOTNULL(net);
-  net->TEST_Benchmark(
-      caffe2::FLAGS_warmup, caffe2::FLAGS_iter, caffe2::FLAGS_run_individual);
+  LOG(INFO) << "Starting benchmark.";
+  const auto latency = caffe2::ComputeLatencyStats(
+      caffe2::TimeRuns(net, caffe2::FLAGS_warmup, caffe2::FLAGS_iter));
+  LOG(INFO) << "Main run finished. Milliseconds per iter: " << latency.mean
+            << ". Iters per second: " << 1000.0 / latency.mean;
+  LOG(INFO) << "Latency percentiles (ms): p50 " << latency.p50 << ", p90 "
+            << latency.p90 << ", p99 " << latency.p99 << ", min "
+            << latency.min << ", max " << latency.max;
+  // The runs have given every blob of the net its shape.
+  const auto cost_model =
+      caffe2::NetCostModel::FromWorkspace(net_def, workspace.get());
+  caffe2::LogNetCost(cost_model, latency.mean);
+  vector<caffe2::OperatorTime> op_times;
+  if (caffe2::FLAGS_run_individual) {
+    op_times = caffe2::TimeOperators(net, caffe2::FLAGS_iter, backend.get());
+    if (op_times.size() == cost_model.num_ops()) {
+      for (int idx = 0; idx < op_times.size(); ++idx) {
+        op_times[idx].has_cost = cost_model.known(idx);
+        op_times[idx].cost = cost_model.op_cost(idx);
+      }
+    }
+    caffe2::LogOperatorTimes(op_times);
+  }
+  vector<caffe2::ExecutorResult> executors;
+  if (caffe2::FLAGS_net_types.size()) {
+    executors = caffe2::CompareNetTypes(
+        net_def, workspace.get(), caffe2::FLAGS_warmup, caffe2::FLAGS_iter);
+    caffe2::LogExecutorResults(executors);
+  }
+  if (caffe2::FLAGS_json_output.size()) {
+    CAFFE_ENFORCE(caffe2::WriteStringToFile(
+        caffe2::ToJson(
+            net_def.name(),
+            backend ? "hip" : "cpu",
+            latency,
+            caffe2::FLAGS_concurrency,
+            throughput,
+            cost_model,
+            op_times,
+            executors),
+        caffe2::FLAGS_json_output.c_str()));
+  }
 
   string output_prefix = caffe2::FLAGS_output_folder.size()
       ? caffe2::FLAGS_output_folder + "/"
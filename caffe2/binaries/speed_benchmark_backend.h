@@ -0,0 +1,58 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_BINARIES_SPEED_BENCHMARK_BACKEND_H_
+#define CAFFE2_BINARIES_SPEED_BENCHMARK_BACKEND_H_
+
+#include "caffe2/core/blob.h"
+#include "caffe2/core/registry.h"
+#include "caffe2/core/tensor.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+
+/**
+ * A device that speed_benchmark can run a net on, other than the CPU.
+ *
+ * Backends live in their own translation unit, which is linked into a
+ * speed_benchmark variant built for that device (e.g. speed_benchmark_hip),
+ * and are looked up by name in SpeedBenchmarkBackendRegistry.
+ */
+class SpeedBenchmarkBackend {
+ public:
+  virtual ~SpeedBenchmarkBackend() {}
+
+  // The device option set on the init and main nets.
+  virtual DeviceOption GetDeviceOption() const = 0;
+
+  // Replaces the tensor in blob with a copy on the device.
+  virtual void CopyToDevice(const TensorCPU& src, Blob* blob) = 0;
+
+  // Brackets the device work of one operator run, on the calling thread's
+  // stream of the given device. StopTimer returns the milliseconds between
+  // the two calls measured on the device, or a negative value if the device
+  // does not keep time.
+  virtual void StartTimer(const DeviceOption& option) = 0;
+  virtual float StopTimer() = 0;
+};
+
+CAFFE_DECLARE_REGISTRY(SpeedBenchmarkBackendRegistry, SpeedBenchmarkBackend);
+#define REGISTER_SPEED_BENCHMARK_BACKEND(name, ...) \
+  CAFFE_REGISTER_CLASS(SpeedBenchmarkBackendRegistry, name, __VA_ARGS__)
+
+} // namespace caffe2
+
+#endif // CAFFE2_BINARIES_SPEED_BENCHMARK_BACKEND_H_
@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/binaries/speed_benchmark_backend.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/init.h"
+
+CAFFE2_DECLARE_int(gpu);
+
+namespace caffe2 {
+namespace {
+
+// Runs speed_benchmark on a HIP device. The per operator device time is the
+// time between two events recorded on the stream that the operator runs on:
+// operators of the benchmarked net run on stream 0 of their device, and the
+// streams are per thread, so that is the stream of the calling thread.
+class HIPSpeedBenchmarkBackend final : public SpeedBenchmarkBackend
+{
+    public:
+    HIPSpeedBenchmarkBackend()
+    {
+        CAFFE_ENFORCE(HasHipGPU(), "No HIP device is available.");
+        CAFFE_ENFORCE_LT(FLAGS_gpu, NumHipDevices(), "Invalid --gpu.");
+        DeviceGuard guard(FLAGS_gpu);
+        HIP_ENFORCE(hipEventCreate(&start_));
+        HIP_ENFORCE(hipEventCreate(&stop_));
+    }
+
+    ~HIPSpeedBenchmarkBackend()
+    {
+        DeviceGuard guard(FLAGS_gpu);
+        HIP_CHECK(hipEventDestroy(start_));
+        HIP_CHECK(hipEventDestroy(stop_));
+    }
+
+    DeviceOption GetDeviceOption() const override
+    {
+        DeviceOption option;
+        option.set_device_type(HIP);
+        option.set_hip_gpu_id(FLAGS_gpu);
+        return option;
+    }
+
+    void CopyToDevice(const TensorCPU& src, Blob* blob) override
+    {
+        HIPContext context(GetDeviceOption());
+        auto* dst = blob->GetMutable<TensorHIP>();
+        dst->CopyFrom(src, &context);
+        context.FinishDeviceComputation();
+    }
+
+    void StartTimer(const DeviceOption& option) override
+    {
+        timing_ = option.device_type() == HIP;
+        if(!timing_)
+        {
+            return;
+        }
+        stream_ = HIPContext::hip_stream(option.hip_gpu_id(), 0);
+        HIP_ENFORCE(hipEventRecord(start_, stream_));
+    }
+
+    float StopTimer() override
+    {
+        if(!timing_)
+        {
+            return 0;
+        }
+        float millis = 0;
+        HIP_ENFORCE(hipEventRecord(stop_, stream_));
+        HIP_ENFORCE(hipEventSynchronize(stop_));
+        HIP_ENFORCE(hipEventElapsedTime(&millis, start_, stop_));
+        return millis;
+    }
+
+    private:
+    hipEvent_t start_;
+    hipEvent_t stop_;
+    hipStream_t stream_ = nullptr;
+    bool timing_        = false;
+};
+
+} // namespace
+
+REGISTER_SPEED_BENCHMARK_BACKEND(HIP, HIPSpeedBenchmarkBackend);
+
+} // namespace caffe2
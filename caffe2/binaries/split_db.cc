@@ -17,6 +17,7 @@
 #include <string>
 #include <sstream>
 
+#include "caffe2/binaries/sharded_db_writer.h"
 #include "caffe2/core/db.h"
 #include "caffe2/core/init.h"
 #include "caffe2/proto/caffe2.pb.h"
@@ -25,7 +26,7 @@
 CAFFE2_DEFINE_string(input_db, "", "The input db.");
 CAFFE2_DEFINE_int(splits, 0, "The number of splits.");
 CAFFE2_DEFINE_string(db_type, "", "The db type.");
-CAFFE2_DEFINE_int(batch_size, 1000, "The write batch size.");
+CAFFE2_DEFINE_int(batch_size, 1000, "The write batch size of every split.");
 
 namespace caffe2 {
 
@@ -44,28 +45,21 @@ static int Split(int argc, char** argv) {
   CAFFE_ENFORCE(
       cursor != nullptr, "Cannot obtain cursor for input db: ", FLAGS_input_db);
 
-  vector<unique_ptr<db::DB>> out_dbs;
-  vector<unique_ptr<db::Transaction>> transactions;
+  // Every split is written by a thread of its own while this one reads.
+  vector<string> sources;
   for (int i = 0; i < FLAGS_splits; ++i) {
-    out_dbs.push_back(unique_ptr<db::DB>(db::CreateDB(
-        FLAGS_db_type, FLAGS_input_db + "_split_" + to_string(i), db::NEW)));
-    CAFFE_ENFORCE(out_dbs.back().get(), "Cannot create output db #", i);
-    transactions.push_back(
-        unique_ptr<db::Transaction>(out_dbs[i]->NewTransaction()));
-    CAFFE_ENFORCE(
-        transactions.back().get(), "Cannot get transaction for output db #", i);
+    sources.push_back(FLAGS_input_db + "_split_" + to_string(i));
   }
+  ShardedDBWriter writer(FLAGS_db_type, sources, FLAGS_batch_size);
 
   int count = 0;
   for (; cursor->Valid(); cursor->Next()) {
-    transactions[count % FLAGS_splits]->Put(cursor->key(), cursor->value());
+    writer.Put(count % FLAGS_splits, cursor->key(), cursor->value());
     if (++count % FLAGS_batch_size == 0) {
-      for (int i = 0; i < FLAGS_splits; ++i) {
-        transactions[i]->Commit();
-      }
       LOG(INFO) << "Split " << count << " items so far.";
     }
   }
+  writer.Finish();
   LOG(INFO) << "A total of " << count << " items processed.";
   return 0;
 }
@@ -21,11 +21,28 @@
 #include "caffe2/core/db.h"
 #include "caffe2/core/init.h"
 #include "caffe2/core/logging.h"
+#include "caffe2/db/zmq_record_batch.h"
+#include "caffe2/utils/string_utils.h"
 #include "caffe2/utils/zmq_helper.h"
 
-CAFFE2_DEFINE_string(server, "tcp://*:5555", "The server address.");
+CAFFE2_DEFINE_string(
+    server,
+    "tcp://*:5555",
+    "The server address. Several comma separated addresses can be given, "
+    "the records are then spread over them, so that a ZmqDB connected to "
+    "all of them receives on as many connections.");
 CAFFE2_DEFINE_string(input_db, "", "The input db.");
 CAFFE2_DEFINE_string(input_db_type, "", "The input db type.");
+CAFFE2_DEFINE_int(
+    batch_size,
+    1,
+    "Number of records sent per message. With 1, every record is sent as a "
+    "key and a value message, which any ZmqDB can read; larger batches use "
+    "the record batch format of zmq_record_batch.h.");
+CAFFE2_DEFINE_bool(
+    compress,
+    false,
+    "If true, compress the record batches with Snappy.");
 
 using caffe2::db::DB;
 using caffe2::db::Cursor;
@@ -33,6 +50,13 @@ using caffe2::string;
 
 int main(int argc, char** argv) {
   caffe2::GlobalInit(&argc, &argv);
+  CAFFE_ENFORCE_GT(caffe2::FLAGS_batch_size, 0);
+  const bool batched =
+      caffe2::FLAGS_batch_size > 1 || caffe2::FLAGS_compress;
+  CAFFE_ENFORCE(
+      !caffe2::FLAGS_compress ||
+          caffe2::db::ZmqRecordBatchCompressionAvailable(),
+      "Caffe2 was built without Snappy, --compress is not available.");
 
   LOG(INFO) << "Opening DB...";
   auto in_db = caffe2::db::CreateDB(
@@ -48,13 +72,28 @@ int main(int argc, char** argv) {
 
   //  Socket to talk to clients
   caffe2::ZmqSocket sender(ZMQ_PUSH);
-  sender.Bind(caffe2::FLAGS_server);
-  LOG(INFO) << "Server created at " << caffe2::FLAGS_server;
+  for (const auto& address : caffe2::split(',', caffe2::FLAGS_server)) {
+    sender.Bind(address);
+    LOG(INFO) << "Server created at " << address;
+  }
 
+  caffe2::db::ZmqRecordBatchWriter writer;
+  string header, payload;
   while (1) {
     VLOG(1) << "Sending " << cursor->key();
-    sender.SendTillSuccess(cursor->key(), ZMQ_SNDMORE);
-    sender.SendTillSuccess(cursor->value(), 0);
+    if (!batched) {
+      sender.SendTillSuccess(cursor->key(), ZMQ_SNDMORE);
+      sender.SendTillSuccess(cursor->value(), 0);
+    } else {
+      // value_view() lets the dbs that support it skip a copy.
+      const string key = cursor->key();
+      writer.Add(key.data(), key.size(), cursor->value_view());
+      if (writer.size() == caffe2::FLAGS_batch_size) {
+        writer.Finish(caffe2::FLAGS_compress, &header, &payload);
+        sender.SendTillSuccess(header, ZMQ_SNDMORE);
+        sender.SendTillSuccess(payload, 0);
+      }
+    }
     cursor->Next();
     if (!cursor->Valid()) {
       cursor->SeekToFirst();
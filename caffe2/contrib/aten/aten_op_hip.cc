@@ -0,0 +1,70 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "aten_op.h"
+#include "caffe2/core/context_hip.h"
+
+namespace caffe2 {
+
+REGISTER_HIP_OPERATOR(ATen, ATenOp<HIPContext>);
+
+// On ROCm the GPU backend of ATen is its hipified CUDA backend, so the
+// tensors it hands out are HIP device memory that Tensor<HIPContext> can
+// wrap and share without copies.
+template <>
+at::Backend ATenOp<HIPContext>::backend() const
+{
+    return at::kCUDA;
+}
+
+// ATen queues its kernels on its own current stream, which is not the stream
+// of the Caffe2 context. The two streams are ordered with events on the
+// device so the inputs are ready before ATen reads them and the outputs are
+// ready before the next Caffe2 op on this stream, without waiting on the host.
+template <>
+bool ATenOp<HIPContext>::RunOnDevice()
+{
+    hipStream_t aten_stream = at::globalContext().getCurrentCUDAStream();
+    hipStream_t caffe2_stream = context_.hip_stream();
+    if(aten_stream == caffe2_stream)
+    {
+        return run_op();
+    }
+
+    hipEvent_t inputs_ready, outputs_ready;
+    HIP_ENFORCE(hipEventCreateWithFlags(&inputs_ready, hipEventDisableTiming));
+    HIP_ENFORCE(hipEventCreateWithFlags(&outputs_ready, hipEventDisableTiming));
+    HIP_ENFORCE(hipEventRecord(inputs_ready, caffe2_stream));
+    HIP_ENFORCE(hipStreamWaitEvent(aten_stream, inputs_ready, 0));
+    const bool result = run_op();
+    HIP_ENFORCE(hipEventRecord(outputs_ready, aten_stream));
+    HIP_ENFORCE(hipStreamWaitEvent(caffe2_stream, outputs_ready, 0));
+    // Destroying a recorded event is deferred by the runtime until it
+    // completes.
+    HIP_ENFORCE(hipEventDestroy(inputs_ready));
+    HIP_ENFORCE(hipEventDestroy(outputs_ready));
+    return result;
+}
+
+namespace math {
+template <>
+void Set<at::Half, HIPContext>(const size_t N, const at::Half h, at::Half* v, HIPContext* c)
+{
+    Set(0, h.x, (uint16_t*)v, c);
+}
+} // namespace math
+
+} // namespace caffe2
@@ -16,6 +16,9 @@
 
 #include "allreduce_ops.h"
 
+#include "caffe2/utils/conversions.h"
+
+#include <gloo/allgather_ring.h>
 #include <gloo/allreduce_halving_doubling.h>
 #include <gloo/allreduce_ring.h>
 #include <gloo/allreduce_ring_chunked.h>
@@ -69,9 +72,49 @@ void AllreduceOp<Context>::initializeRingChunked() {
   }
 }
 
+template <>
+void FloatToWireFp16<CPUContext>(
+    size_t n,
+    const float* x,
+    float16* y,
+    CPUContext* /*context*/) {
+  for (size_t i = 0; i < n; ++i) {
+    y[i] = convert::To<float, float16>(x[i]);
+  }
+}
+
+template <>
+void WireFp16ToFloat<CPUContext>(
+    size_t n,
+    const float16* x,
+    float* y,
+    CPUContext* /*context*/) {
+  for (size_t i = 0; i < n; ++i) {
+    y[i] = convert::To<float16, float>(x[i]);
+  }
+}
+
+template <class Context>
+void TopKAllreduceOp<Context>::initializeAlgorithm() {
+  gather_indices_.reset(new ::gloo::AllgatherRing<int>(
+      common_world_,
+      std::vector<const int*>{send_indices_.data()},
+      recv_indices_.data(),
+      k_));
+  gather_values_.reset(new ::gloo::AllgatherRing<float>(
+      common_world_,
+      std::vector<const float*>{send_values_.data()},
+      recv_values_.data(),
+      k_));
+}
+
 namespace {
 
 REGISTER_CPU_OPERATOR_WITH_ENGINE(Allreduce, GLOO, AllreduceOp<CPUContext>);
+REGISTER_CPU_OPERATOR_WITH_ENGINE(
+    TopKAllreduce,
+    GLOO,
+    TopKAllreduceOp<CPUContext>);
 
 } // namespace
 } // namespace gloo
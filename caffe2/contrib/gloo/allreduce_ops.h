@@ -17,6 +17,9 @@
 #pragma once
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
 
 #include "caffe2/contrib/gloo/common.h"
 #include "caffe2/core/operator.h"
@@ -29,6 +32,13 @@
 namespace caffe2 {
 namespace gloo {
 
+// Converts between the fp32 tensors and the fp16 buffers of an Allreduce
+// with wire_fp16, on the device of the context.
+template <class Context>
+void FloatToWireFp16(size_t n, const float* x, float16* y, Context* context);
+template <class Context>
+void WireFp16ToFloat(size_t n, const float16* x, float* y, Context* context);
+
 template <class Context>
 class AllreduceOp final : public Operator<Context> {
   enum Mode { RING_FULL, RING_CHUNKED, HALVING_DOUBLING };
@@ -42,7 +52,12 @@ class AllreduceOp final : public Operator<Context> {
         status_blob_(
             OperatorBase::GetSingleArgument<std::string>("status_blob", "")),
         gpu_direct_(
-            OperatorBase::GetSingleArgument<bool>("gpu_direct", false)) {
+            OperatorBase::GetSingleArgument<bool>("gpu_direct", false)),
+        wire_fp16_(
+            OperatorBase::GetSingleArgument<bool>("wire_fp16", false)) {
+    CAFFE_ENFORCE(
+        !wire_fp16_ || operator_def.device_option().device_type() != CUDA,
+        "wire_fp16 is only supported by the CPU and HIP Allreduce, not CUDA");
     if (status_blob_ != "") {
       ws_->CreateBlob(status_blob_);
     }
@@ -58,6 +73,18 @@ class AllreduceOp final : public Operator<Context> {
     update(current_);
     CAFFE_ENFORCE(current_ == init_, "Inputs/outputs have changed");
 
+    if (!wire_.empty()) {
+      for (auto i = 0; i < wire_.size(); i++) {
+        FloatToWireFp16<Context>(
+            wire_[i].size(),
+            Input(i + 1).template data<float>(),
+            wire_[i].template mutable_data<float16>(),
+            &context_);
+      }
+      // The algorithm reads the buffers outside of the stream of the op.
+      context_.FinishDeviceComputation();
+    }
+
     try {
       algorithm_->run();
     } catch (::gloo::IoException& ioe) {
@@ -69,6 +96,14 @@ class AllreduceOp final : public Operator<Context> {
         throw ioe;
       }
     }
+
+    for (auto i = 0; i < wire_.size(); i++) {
+      WireFp16ToFloat<Context>(
+          wire_[i].size(),
+          wire_[i].template data<float16>(),
+          Output(i)->template mutable_data<float>(),
+          &context_);
+    }
     return true;
   }
 
@@ -77,15 +112,25 @@ class AllreduceOp final : public Operator<Context> {
     Mode mode = HALVING_DOUBLING;
     auto bytes = Input(1).nbytes();
 
-    // Store which inputs/outputs this instance initialized with
-    update(init_);
-
     // Verify inputs == ouputs
-    CAFFE_ENFORCE_EQ(init_.inputs.size(), init_.outputs.size());
-    for (auto i = 0; i < init_.inputs.size(); i++) {
-      CAFFE_ENFORCE_EQ(init_.inputs[i], init_.outputs[i]);
+    CAFFE_ENFORCE_EQ(InputSize() - 1, OutputSize());
+    for (auto i = 0; i < OutputSize(); i++) {
+      CAFFE_ENFORCE_EQ(Input(i + 1).raw_data(), Output(i)->raw_data());
+    }
+
+    // With wire_fp16, fp32 tensors are reduced through fp16 copies, which
+    // halves the bytes sent. Tensors that are fp16 already are unaffected.
+    if (wire_fp16_ && Input(1).template IsType<float>()) {
+      wire_.resize(OutputSize());
+      for (auto i = 0; i < wire_.size(); i++) {
+        wire_[i].ResizeLike(Input(i + 1));
+        wire_[i].template mutable_data<float16>();
+      }
     }
 
+    // Store which inputs/outputs this instance initialized with
+    update(init_);
+
     // Verify tensors all have same size
     size_t size = Input(1).size();
     for (auto i = 2; i < InputSize(); i++) {
@@ -130,10 +175,13 @@ class AllreduceOp final : public Operator<Context> {
     params.outputs.resize(OutputSize());
     for (auto i = 0; i < params.inputs.size(); i++) {
       params.inputs[i] = Input(i + 1).template raw_data();
-      params.outputs[i] = Output(i)->template raw_mutable_data();
+      // The algorithm reduces the wire buffers in place of the tensors.
+      params.outputs[i] = wire_.empty()
+          ? Output(i)->template raw_mutable_data()
+          : wire_[i].raw_mutable_data();
     }
     params.size = Output(0)->size();
-    params.meta = Output(0)->meta();
+    params.meta = wire_.empty() ? Output(0)->meta() : wire_[0].meta();
   }
 
   GlooParameters init_;
@@ -141,6 +189,133 @@ class AllreduceOp final : public Operator<Context> {
   Workspace* ws_;
   std::string status_blob_;
   const bool gpu_direct_;
+  const bool wire_fp16_;
+  std::vector<Tensor<Context>> wire_;
+};
+
+// TopKAllreduceOp sums a sparsified version of a gradient across the common
+// world, with error feedback. Every node adds its gradient to its residual,
+// sends only the k entries of largest magnitude, and keeps the rest in the
+// residual for the next run, so no update is lost, only delayed. The k
+// (index, value) pairs of all nodes are exchanged with two allgathers and
+// summed into the output, in the same order on every node.
+template <class Context>
+class TopKAllreduceOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+
+  TopKAllreduceOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        ws_(ws),
+        status_blob_(
+            OperatorBase::GetSingleArgument<std::string>("status_blob", "")),
+        k_(OperatorBase::GetSingleArgument<int>("k", 0)),
+        ratio_(OperatorBase::GetSingleArgument<float>("ratio", 0)) {
+    CAFFE_ENFORCE(
+        (k_ > 0) != (ratio_ > 0),
+        "Exactly one of k and ratio has to be given");
+    CAFFE_ENFORCE_LE(ratio_, 1);
+    if (status_blob_ != "") {
+      ws_->CreateBlob(status_blob_);
+    }
+  }
+
+  virtual ~TopKAllreduceOp() {}
+
+  bool RunOnDevice() override {
+    const auto& X = Input(DATA);
+    auto& residual = *Output(OUTPUT_RESIDUAL);
+    CAFFE_ENFORCE_EQ(
+        X.size(), residual.size(), "The residual has to be shaped like X");
+    std::call_once(once_, [&] { initialize(); });
+    CAFFE_ENFORCE(
+        common_world_ == OperatorBase::Input<std::shared_ptr<::gloo::Context>>(0),
+        "The common world has changed");
+    CAFFE_ENFORCE_EQ(X.size(), size_, "Inputs/outputs have changed");
+
+    // Error feedback: what was not sent before is added to the gradient.
+    const float* x = X.template data<float>();
+    float* r = residual.template mutable_data<float>();
+    for (TIndex i = 0; i < size_; ++i) {
+      r[i] += x[i];
+    }
+
+    // Send the k largest magnitudes and keep the others for the next run.
+    std::iota(order_.begin(), order_.end(), 0);
+    std::nth_element(
+        order_.begin(),
+        order_.begin() + (k_ - 1),
+        order_.end(),
+        [r](int a, int b) { return std::abs(r[a]) > std::abs(r[b]); });
+    for (int j = 0; j < k_; ++j) {
+      send_indices_[j] = order_[j];
+      send_values_[j] = r[order_[j]];
+      r[order_[j]] = 0;
+    }
+
+    try {
+      gather_indices_->run();
+      gather_values_->run();
+    } catch (::gloo::IoException& ioe) {
+      LOG(ERROR) << "Caught gloo IO exception: " << ioe.what();
+      if (status_blob_ != "") {
+        signalFailure(ws_->GetBlob(status_blob_), ioe);
+        return false;
+      } else {
+        throw ioe;
+      }
+    }
+
+    auto* Y = Output(OUTPUT);
+    Y->ResizeLike(residual);
+    float* y = Y->template mutable_data<float>();
+    std::fill(y, y + size_, 0.f);
+    for (size_t j = 0; j < recv_indices_.size(); ++j) {
+      y[recv_indices_[j]] += recv_values_[j];
+    }
+    return true;
+  }
+
+ protected:
+  void initialize() {
+    common_world_ = OperatorBase::Input<std::shared_ptr<::gloo::Context>>(0);
+    size_ = Input(DATA).size();
+    CAFFE_ENFORCE_GT(size_, 0);
+    CAFFE_ENFORCE_LE(size_, std::numeric_limits<int>::max());
+    if (ratio_ > 0) {
+      k_ = std::max<int>(1, std::ceil(ratio_ * size_));
+    }
+    k_ = std::min<int>(k_, size_);
+
+    order_.resize(size_);
+    send_indices_.resize(k_);
+    send_values_.resize(k_);
+    recv_indices_.resize(k_ * common_world_->size);
+    recv_values_.resize(k_ * common_world_->size);
+    initializeAlgorithm();
+  }
+
+  void initializeAlgorithm();
+
+  std::once_flag once_;
+  std::shared_ptr<::gloo::Context> common_world_;
+  std::unique_ptr<::gloo::Algorithm> gather_indices_;
+  std::unique_ptr<::gloo::Algorithm> gather_values_;
+
+  Workspace* ws_;
+  std::string status_blob_;
+  int k_;
+  float ratio_;
+  TIndex size_{0};
+
+  std::vector<int> order_;
+  std::vector<int> send_indices_;
+  std::vector<float> send_values_;
+  std::vector<int> recv_indices_;
+  std::vector<float> recv_values_;
+
+  INPUT_TAGS(COMM, DATA, RESIDUAL);
+  OUTPUT_TAGS(OUTPUT, OUTPUT_RESIDUAL);
 };
 
 } // namespace gloo
@@ -18,6 +18,7 @@
 
 #include "caffe2/core/context_gpu.h"
 #include "caffe2/core/logging.h"
+#include "caffe2/operators/operator_fallback_gpu.h"
 
 #include <gloo/cuda_allreduce_halving_doubling.h>
 #include <gloo/cuda_allreduce_ring.h>
@@ -116,9 +117,32 @@ void AllreduceOp<Context>::initializeRingChunked() {
   }
 }
 
+// Never called: the constructor rejects wire_fp16 on CUDA.
+template <>
+void FloatToWireFp16<CUDAContext>(
+    size_t /*n*/,
+    const float* /*x*/,
+    float16* /*y*/,
+    CUDAContext* /*context*/) {
+  CAFFE_THROW("wire_fp16 is not supported for CUDA tensors");
+}
+
+template <>
+void WireFp16ToFloat<CUDAContext>(
+    size_t /*n*/,
+    const float16* /*x*/,
+    float* /*y*/,
+    CUDAContext* /*context*/) {
+  CAFFE_THROW("wire_fp16 is not supported for CUDA tensors");
+}
+
 namespace {
 
 REGISTER_CUDA_OPERATOR_WITH_ENGINE(Allreduce, GLOO, AllreduceOp<CUDAContext>);
+REGISTER_CUDA_OPERATOR_WITH_ENGINE(
+    TopKAllreduce,
+    GLOO,
+    GPUFallbackOp<TopKAllreduceOp<CPUContext>>);
 
 } // namespace
 } // namespace gloo
@@ -0,0 +1,167 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "allreduce_ops.h"
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/operators/operator_fallback_hip.h"
+#include "caffe2/utils/conversions.h"
+
+#include <gloo/hip_allreduce_halving_doubling.h>
+#include <gloo/hip_allreduce_ring.h>
+#include <gloo/hip_allreduce_ring_chunked.h>
+#include <gloo/types.h>
+
+namespace caffe2 {
+namespace gloo {
+
+namespace {
+
+// Decides on using GPUDirect based on device support. With a device
+// workspace the transport reads and writes the HIP buffers directly (ROCm
+// peer memory), otherwise every chunk is staged through pinned host memory.
+template <template <typename T, typename W> class A, typename T>
+std::unique_ptr<::gloo::Algorithm> initializeAlgorithm(bool gpu_direct_,
+                                                       std::shared_ptr<::gloo::Context> context,
+                                                       std::vector<T*> ptrs,
+                                                       size_t size)
+{
+    if(gpu_direct_)
+    {
+        if(context->getDevice()->hasGPUDirect())
+        {
+            return std::unique_ptr<::gloo::Algorithm>(
+                new A<T, ::gloo::HipDeviceWorkspace<T>>(context, ptrs, size));
+        }
+        else
+        {
+            LOG(WARNING) << "GPUDirect not available; "
+                         << "Gloo communication will go through system memory instead.";
+        }
+    }
+
+    return std::unique_ptr<::gloo::Algorithm>(
+        new A<T, ::gloo::HipHostWorkspace<T>>(context, ptrs, size));
+}
+
+__global__ void FloatToWireFp16Kernel(const size_t n, const float* x, float16* y)
+{
+    HIP_1D_KERNEL_LOOP(i, n) { y[i] = convert::To<float, float16>(x[i]); }
+}
+
+__global__ void WireFp16ToFloatKernel(const size_t n, const float16* x, float* y)
+{
+    HIP_1D_KERNEL_LOOP(i, n) { y[i] = convert::To<float16, float>(x[i]); }
+}
+
+} // namespace
+
+template <>
+void FloatToWireFp16<HIPContext>(size_t n, const float* x, float16* y, HIPContext* context)
+{
+    hipLaunchKernelGGL((FloatToWireFp16Kernel),
+                       dim3(CAFFE_GET_BLOCKS(n)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context->hip_stream(),
+                       n,
+                       x,
+                       y);
+}
+
+template <>
+void WireFp16ToFloat<HIPContext>(size_t n, const float16* x, float* y, HIPContext* context)
+{
+    hipLaunchKernelGGL((WireFp16ToFloatKernel),
+                       dim3(CAFFE_GET_BLOCKS(n)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context->hip_stream(),
+                       n,
+                       x,
+                       y);
+}
+
+template <class Context>
+void AllreduceOp<Context>::initializeHalvingDoubling()
+{
+    if(init_.template IsType<float>())
+    {
+        algorithm_ = initializeAlgorithm<::gloo::HipAllreduceHalvingDoubling, float>(
+            gpu_direct_, init_.context, init_.template getOutputs<float>(), init_.size);
+    }
+    else if(init_.template IsType<float16>())
+    {
+        algorithm_ = initializeAlgorithm<::gloo::HipAllreduceHalvingDoubling, ::gloo::float16>(
+            gpu_direct_, init_.context, init_.template getOutputs<::gloo::float16>(), init_.size);
+    }
+    else
+    {
+        CAFFE_ENFORCE(false, "Unhandled type: ", init_.meta.name());
+    }
+}
+
+template <class Context>
+void AllreduceOp<Context>::initializeRingFull()
+{
+    if(init_.template IsType<float>())
+    {
+        algorithm_ = initializeAlgorithm<::gloo::HipAllreduceRing, float>(
+            gpu_direct_, init_.context, init_.template getOutputs<float>(), init_.size);
+    }
+    else if(init_.template IsType<float16>())
+    {
+        algorithm_ = initializeAlgorithm<::gloo::HipAllreduceRing, ::gloo::float16>(
+            gpu_direct_, init_.context, init_.template getOutputs<::gloo::float16>(), init_.size);
+    }
+    else
+    {
+        CAFFE_ENFORCE(false, "Unhandled type: ", init_.meta.name());
+    }
+}
+
+template <class Context>
+void AllreduceOp<Context>::initializeRingChunked()
+{
+    if(init_.template IsType<float>())
+    {
+        algorithm_ = initializeAlgorithm<::gloo::HipAllreduceRingChunked, float>(
+            gpu_direct_, init_.context, init_.template getOutputs<float>(), init_.size);
+    }
+    else if(init_.template IsType<float16>())
+    {
+        algorithm_ = initializeAlgorithm<::gloo::HipAllreduceRingChunked, ::gloo::float16>(
+            gpu_direct_, init_.context, init_.template getOutputs<::gloo::float16>(), init_.size);
+    }
+    else
+    {
+        CAFFE_ENFORCE(false, "Unhandled type: ", init_.meta.name());
+    }
+}
+
+namespace {
+
+REGISTER_HIP_OPERATOR_WITH_ENGINE(Allreduce, GLOO, AllreduceOp<HIPContext>);
+// The top-k selection and the scatter of the gathered pairs run on the host,
+// only the k pairs of each node are sent over the network.
+REGISTER_HIP_OPERATOR_WITH_ENGINE(TopKAllreduce,
+                                  GLOO,
+                                  GPUFallbackOp<TopKAllreduceOp<CPUContext>>);
+
+} // namespace
+} // namespace gloo
+} // namespace caffe2
@@ -0,0 +1,46 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/contrib/gloo/common_world_ops.h"
+
+#include "caffe2/core/context_hip.h"
+
+#include <gloo/hip.h>
+#include <gloo/transport/tcp/device.h>
+
+namespace caffe2 {
+namespace gloo {
+
+template <>
+void CreateCommonWorld<HIPContext>::initializeForContext()
+{
+    static std::once_flag once;
+    std::call_once(once, [&]() {
+        // This is the first time we call Gloo code for a HIPContext.
+        // Share Caffe2 HIP mutex with Gloo.
+        ::gloo::HipShared::setMutex(&HIPContext::mutex());
+    });
+}
+
+namespace {
+
+REGISTER_HIP_OPERATOR_WITH_ENGINE(CreateCommonWorld, GLOO, CreateCommonWorld<HIPContext>);
+
+REGISTER_HIP_OPERATOR_WITH_ENGINE(CloneCommonWorld, GLOO, CloneCommonWorld<HIPContext>);
+
+} // namespace
+} // namespace gloo
+} // namespace caffe2
@@ -252,7 +252,8 @@ class TestCase(hu.HypothesisTestCase):
                         blob_size=None,
                         num_blobs=None,
                         tmpdir=None,
-                        use_float16=False
+                        use_float16=False,
+                        wire_fp16=False
                         ):
         store_handler, common_world = self.create_common_world(
             comm_rank=comm_rank,
@@ -281,7 +282,8 @@ class TestCase(hu.HypothesisTestCase):
         net.Allreduce(
             [common_world] + blobs,
             blobs,
-            engine=op_engine)
+            engine=op_engine,
+            wire_fp16=wire_fp16)
 
         workspace.CreateNet(net)
         workspace.RunNet(net.Name())
@@ -339,9 +341,10 @@ class TestCase(hu.HypothesisTestCase):
            blob_size=st.integers(min_value=1e3, max_value=1e6),
            num_blobs=st.integers(min_value=1, max_value=4),
            device_option=st.sampled_from([hu.cpu_do]),
-           use_float16=st.booleans())
+           use_float16=st.booleans(),
+           wire_fp16=st.booleans())
     def test_allreduce(self, comm_size, blob_size, num_blobs, device_option,
-                       use_float16):
+                       use_float16, wire_fp16):
         TestCase.test_counter += 1
         if os.getenv('COMM_RANK') is not None:
             self.run_test_distributed(
@@ -349,6 +352,7 @@ class TestCase(hu.HypothesisTestCase):
                 blob_size=blob_size,
                 num_blobs=num_blobs,
                 use_float16=use_float16,
+                wire_fp16=wire_fp16,
                 device_option=device_option)
         else:
             with TemporaryDirectory() as tmpdir:
@@ -359,7 +363,65 @@ class TestCase(hu.HypothesisTestCase):
                     num_blobs=num_blobs,
                     device_option=device_option,
                     tmpdir=tmpdir,
-                    use_float16=use_float16)
+                    use_float16=use_float16,
+                    wire_fp16=wire_fp16)
+
+    def _test_topk_allreduce(self,
+                             comm_rank=None,
+                             comm_size=None,
+                             blob_size=None,
+                             tmpdir=None
+                             ):
+        store_handler, common_world = self.create_common_world(
+            comm_rank=comm_rank,
+            comm_size=comm_size,
+            tmpdir=tmpdir)
+
+        blob_size = self.synchronize(
+            store_handler,
+            blob_size,
+            comm_rank=comm_rank)
+
+        # The last entry is the largest on every node, so it is the only one
+        # sent with k=1.
+        value = np.arange(1, blob_size + 1, dtype=np.float32) * (comm_rank + 1)
+        workspace.FeedBlob("X", value)
+        workspace.FeedBlob("residual", np.zeros(blob_size, np.float32))
+
+        net = core.Net("topk_allreduce")
+        net.TopKAllreduce(
+            [common_world, "X", "residual"],
+            ["X", "residual"],
+            engine=op_engine,
+            k=1)
+        workspace.RunNetOnce(net)
+
+        expected = np.zeros(blob_size, np.float32)
+        expected[-1] = blob_size * comm_size * (comm_size + 1) / 2
+        np.testing.assert_array_equal(workspace.FetchBlob("X"), expected)
+        residual = value.copy()
+        residual[-1] = 0
+        np.testing.assert_array_equal(
+            workspace.FetchBlob("residual"), residual)
+
+    @given(comm_size=st.integers(min_value=2, max_value=8),
+           blob_size=st.integers(min_value=2, max_value=1e4),
+           device_option=st.sampled_from([hu.cpu_do]))
+    def test_topk_allreduce(self, comm_size, blob_size, device_option):
+        TestCase.test_counter += 1
+        if os.getenv('COMM_RANK') is not None:
+            self.run_test_distributed(
+                self._test_topk_allreduce,
+                blob_size=blob_size,
+                device_option=device_option)
+        else:
+            with TemporaryDirectory() as tmpdir:
+                self.run_test_locally(
+                    self._test_topk_allreduce,
+                    comm_size=comm_size,
+                    blob_size=blob_size,
+                    device_option=device_option,
+                    tmpdir=tmpdir)
 
     def _test_allgather(self,
                         comm_rank=None,
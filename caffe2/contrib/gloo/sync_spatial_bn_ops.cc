@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/operator.h"
+#include "caffe2/core/operator_gradient.h"
+
+namespace caffe2 {
+namespace gloo {
+
+OPERATOR_SCHEMA(SyncSpatialBN)
+    .NumInputs(6)
+    .NumOutputs(5)
+    .EnforceInplace({{4, 1}, {5, 2}})
+    .InputsCanCrossDevices()
+    .IdenticalTypeAndShapeOfInput(1)
+    .SetDoc(R"DOC(
+Training-mode spatial batch normalization with statistics synchronized across
+the nodes of a common world, for data-parallel training at small per-device
+batch sizes. Every node computes the per-channel sum and sum of squares of
+its X, the partial sums and element counts are allreduced, and all nodes
+normalize with the mean and variance of the global batch. The nodes may have
+different batch sizes. The gradient allreduces the per-channel sums it needs
+in the same way, and outputs the local scale and bias gradients, which are
+summed across nodes like any other parameter gradient.
+
+Only implemented for HIPContext with the GLOO engine, with float data in the
+NCHW order.
+)DOC")
+    .Arg("epsilon", "The epsilon value to use to avoid division by zero.")
+    .Arg(
+        "momentum",
+        "Factor used in computing the running mean and variance."
+        "e.g., running_mean = running_mean * momentum + mean * (1 - momentum)")
+    .Arg(
+        "gpu_direct",
+        "(bool, default false) Let the transport read and write the "
+        "device buffers directly when it supports it.")
+    .Input(0, "comm_world", "The common world.")
+    .Input(1, "X", "The input 4-dimensional tensor of shape NCHW.")
+    .Input(2, "scale", "The scale as a 1-dimensional tensor of size C.")
+    .Input(3, "bias", "The bias as a 1-dimensional tensor of size C.")
+    .Input(4, "mean", "The running mean as a 1-dimensional tensor of size C.")
+    .Input(
+        5, "var", "The running variance as a 1-dimensional tensor of size C.")
+    .Output(0, "Y", "The output 4-dimensional tensor of the same shape as X.")
+    .Output(1, "mean", "The running mean, in-place with the input mean.")
+    .Output(2, "var", "The running variance, in-place with the input var.")
+    .Output(3, "saved_mean", "The mean of the global batch.")
+    .Output(
+        4,
+        "saved_inv_var",
+        "The inverse standard deviation of the global batch.");
+
+// Input: comm_world, X, scale, dY, saved_mean, saved_inv_var
+// Output: dX, dscale, dbias
+OPERATOR_SCHEMA(SyncSpatialBNGradient)
+    .NumInputs(6)
+    .NumOutputs(3)
+    .InputsCanCrossDevices();
+
+class GetSyncSpatialBNGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    return SingleGradientDef(
+        "SyncSpatialBNGradient",
+        "",
+        vector<string>{I(0), I(1), I(2), GO(0), O(3), O(4)},
+        vector<string>{GI(1), GI(2), GI(3)});
+  }
+};
+REGISTER_GRADIENT(SyncSpatialBN, GetSyncSpatialBNGradient);
+
+} // namespace gloo
+} // namespace caffe2
@@ -0,0 +1,418 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <hipcub/hipcub.hpp>
+
+#include "caffe2/contrib/gloo/common.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
+
+#include <gloo/algorithm.h>
+#include <gloo/common/error.h>
+#include <gloo/context.h>
+#include <gloo/hip_allreduce_halving_doubling.h>
+
+namespace caffe2 {
+namespace gloo {
+
+namespace {
+
+// Allreduces a small float buffer of per-channel partial sums on the stream
+// of the op. The algorithm is built again only when the common world or the
+// buffer size changes, which happens on every node at the same time, so the
+// nodes stay in step.
+class ChannelSumsAllreduce
+{
+    public:
+    void Run(const std::shared_ptr<::gloo::Context>& context,
+             float* data,
+             int size,
+             hipStream_t stream,
+             bool gpu_direct)
+    {
+        if(algorithm_ == nullptr || context != context_ || size != size_)
+        {
+            context_ = context;
+            data_    = data;
+            size_    = size;
+            std::vector<hipStream_t> streams{stream};
+            if(gpu_direct && context->getDevice()->hasGPUDirect())
+            {
+                algorithm_.reset(new ::gloo::HipAllreduceHalvingDoubling<
+                                 float,
+                                 ::gloo::HipDeviceWorkspace<float>>(
+                    context, std::vector<float*>{data}, size, streams));
+            }
+            else
+            {
+                if(gpu_direct)
+                {
+                    LOG(WARNING) << "GPUDirect not available; "
+                                 << "Gloo communication will go through system memory "
+                                    "instead.";
+                }
+                algorithm_.reset(new ::gloo::HipAllreduceHalvingDoubling<
+                                 float,
+                                 ::gloo::HipHostWorkspace<float>>(
+                    context, std::vector<float*>{data}, size, streams));
+            }
+        }
+        CAFFE_ENFORCE(data == data_, "The allreduced buffer has moved");
+        algorithm_->run();
+    }
+
+    private:
+    std::shared_ptr<::gloo::Context> context_;
+    float* data_ = nullptr;
+    int size_    = 0;
+    std::unique_ptr<::gloo::Algorithm> algorithm_;
+};
+
+// One block per channel. Writes the sum and the sum of squares of channel c
+// of X to sums[c] and sums[C + c], and the element count to sums[2 * C].
+__global__ void ChannelStatsKernel(
+    const int N, const int C, const int HxW, const float* X, float* sums)
+{
+    const int c = hipBlockIdx_x;
+    float sum   = 0;
+    float sumsq = 0;
+    for(int i = hipThreadIdx_x; i < N * HxW; i += hipBlockDim_x)
+    {
+        const float x = X[(i / HxW * C + c) * HxW + i % HxW];
+        sum += x;
+        sumsq += x * x;
+    }
+    using BlockReduce = hipcub::BlockReduce<float, CAFFE_HIP_NUM_THREADS>;
+    __shared__ typename BlockReduce::TempStorage temp_storage;
+    const float sum_tot = BlockReduce(temp_storage).Sum(sum);
+    __syncthreads();
+    const float sumsq_tot = BlockReduce(temp_storage).Sum(sumsq);
+    if(hipThreadIdx_x == 0)
+    {
+        sums[c]     = sum_tot;
+        sums[C + c] = sumsq_tot;
+        if(c == 0)
+        {
+            sums[2 * C] = N * HxW;
+        }
+    }
+}
+
+__global__ void ComputeMomentsKernel(const int C,
+                                     const float* sums,
+                                     const float epsilon,
+                                     const float momentum,
+                                     float* running_mean,
+                                     float* running_var,
+                                     float* saved_mean,
+                                     float* saved_inv_var)
+{
+    HIP_1D_KERNEL_LOOP(c, C)
+    {
+        const float count = sums[2 * C];
+        const float mean  = sums[c] / count;
+        const float var   = fmaxf(sums[C + c] / count - mean * mean, 0);
+        saved_mean[c]     = mean;
+        saved_inv_var[c]  = rsqrtf(var + epsilon);
+        running_mean[c]   = running_mean[c] * momentum + mean * (1 - momentum);
+        running_var[c]    = running_var[c] * momentum + var * (1 - momentum);
+    }
+}
+
+__global__ void NormalizeKernel(const int size,
+                                const int C,
+                                const int HxW,
+                                const float* X,
+                                const float* scale,
+                                const float* bias,
+                                const float* mean,
+                                const float* inv_var,
+                                float* Y)
+{
+    HIP_1D_KERNEL_LOOP(i, size)
+    {
+        const int c = i / HxW % C;
+        Y[i]        = (X[i] - mean[c]) * inv_var[c] * scale[c] + bias[c];
+    }
+}
+
+// One block per channel. Writes the gradients of the scale and the bias of
+// channel c to sums[c] and sums[C + c], and the element count to sums[2 * C].
+__global__ void ChannelBackpropStatsKernel(const int N,
+                                           const int C,
+                                           const int HxW,
+                                           const float* X,
+                                           const float* dY,
+                                           const float* mean,
+                                           const float* inv_var,
+                                           float* sums)
+{
+    const int c       = hipBlockIdx_x;
+    const float mu    = mean[c];
+    const float rsig  = inv_var[c];
+    float dscale      = 0;
+    float dbias       = 0;
+    for(int i = hipThreadIdx_x; i < N * HxW; i += hipBlockDim_x)
+    {
+        const int idx = (i / HxW * C + c) * HxW + i % HxW;
+        dscale += dY[idx] * (X[idx] - mu) * rsig;
+        dbias += dY[idx];
+    }
+    using BlockReduce = hipcub::BlockReduce<float, CAFFE_HIP_NUM_THREADS>;
+    __shared__ typename BlockReduce::TempStorage temp_storage;
+    const float dscale_tot = BlockReduce(temp_storage).Sum(dscale);
+    __syncthreads();
+    const float dbias_tot = BlockReduce(temp_storage).Sum(dbias);
+    if(hipThreadIdx_x == 0)
+    {
+        sums[c]     = dscale_tot;
+        sums[C + c] = dbias_tot;
+        if(c == 0)
+        {
+            sums[2 * C] = N * HxW;
+        }
+    }
+}
+
+// dX = scale * inv_var * (dY - (dbias + x_hat * dscale) / count), with the
+// global dscale, dbias and count.
+__global__ void SyncSpatialBNGradientKernel(const int size,
+                                            const int C,
+                                            const int HxW,
+                                            const float* X,
+                                            const float* dY,
+                                            const float* scale,
+                                            const float* mean,
+                                            const float* inv_var,
+                                            const float* sums,
+                                            float* dX)
+{
+    HIP_1D_KERNEL_LOOP(i, size)
+    {
+        const int c       = i / HxW % C;
+        const float x_hat = (X[i] - mean[c]) * inv_var[c];
+        dX[i]             = scale[c] * inv_var[c] *
+                (dY[i] - (sums[C + c] + x_hat * sums[c]) / sums[2 * C]);
+    }
+}
+
+} // namespace
+
+class SyncSpatialBNOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    SyncSpatialBNOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws),
+          epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)),
+          momentum_(OperatorBase::GetSingleArgument<float>("momentum", 0.9f)),
+          gpu_direct_(OperatorBase::GetSingleArgument<bool>("gpu_direct", false))
+    {
+        CAFFE_ENFORCE_EQ(OperatorBase::GetSingleArgument<string>("order", "NCHW"),
+                         "NCHW",
+                         "SyncSpatialBN only supports NCHW");
+        CAFFE_ENFORCE_GT(epsilon_, 0);
+        CAFFE_ENFORCE_GE(momentum_, 0);
+        CAFFE_ENFORCE_LE(momentum_, 1);
+    }
+
+    bool RunOnDevice() override
+    {
+        const auto& X     = Input(INPUT);
+        const auto& scale = Input(SCALE);
+        const auto& bias  = Input(BIAS);
+        CAFFE_ENFORCE(X.IsType<float>(), "SyncSpatialBN only supports float");
+        CAFFE_ENFORCE_GE(X.ndim(), 3);
+        const int N   = X.dim32(0);
+        const int C   = X.dim32(1);
+        const int HxW = X.size() / (N * C);
+        CAFFE_ENFORCE_EQ(scale.size(), C);
+        CAFFE_ENFORCE_EQ(bias.size(), C);
+
+        // Global sums: sum, sum of squares and count.
+        sums_.Resize(2 * C + 1);
+        float* sums = sums_.mutable_data<float>();
+        hipLaunchKernelGGL((ChannelStatsKernel),
+                           dim3(C),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           N,
+                           C,
+                           HxW,
+                           X.data<float>(),
+                           sums);
+        allreduce_.Run(OperatorBase::Input<std::shared_ptr<::gloo::Context>>(COMM),
+                       sums,
+                       2 * C + 1,
+                       context_.hip_stream(),
+                       gpu_direct_);
+
+        auto* running_mean = Output(RUNNING_MEAN);
+        auto* running_var  = Output(RUNNING_VAR);
+        if(!running_mean->size())
+        {
+            running_mean->Resize(C);
+            running_var->Resize(C);
+            math::Set<float, HIPContext>(
+                C, 0, running_mean->mutable_data<float>(), &context_);
+            math::Set<float, HIPContext>(
+                C, 0, running_var->mutable_data<float>(), &context_);
+        }
+        CAFFE_ENFORCE_EQ(running_mean->size(), C);
+        CAFFE_ENFORCE_EQ(running_var->size(), C);
+        auto* saved_mean    = Output(SAVED_MEAN);
+        auto* saved_inv_var = Output(SAVED_INV_VAR);
+        saved_mean->Resize(C);
+        saved_inv_var->Resize(C);
+        hipLaunchKernelGGL((ComputeMomentsKernel),
+                           dim3(CAFFE_GET_BLOCKS(C)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           C,
+                           sums,
+                           static_cast<float>(epsilon_),
+                           static_cast<float>(momentum_),
+                           running_mean->mutable_data<float>(),
+                           running_var->mutable_data<float>(),
+                           saved_mean->mutable_data<float>(),
+                           saved_inv_var->mutable_data<float>());
+
+        auto* Y = Output(OUTPUT);
+        Y->ResizeLike(X);
+        hipLaunchKernelGGL((NormalizeKernel),
+                           dim3(CAFFE_GET_BLOCKS(X.size())),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           static_cast<const int>(X.size()),
+                           C,
+                           HxW,
+                           X.data<float>(),
+                           scale.data<float>(),
+                           bias.data<float>(),
+                           saved_mean->data<float>(),
+                           saved_inv_var->data<float>(),
+                           Y->mutable_data<float>());
+        return true;
+    }
+
+    protected:
+    double epsilon_;
+    double momentum_;
+    const bool gpu_direct_;
+    Tensor<HIPContext> sums_;
+    ChannelSumsAllreduce allreduce_;
+
+    INPUT_TAGS(COMM, INPUT, SCALE, BIAS, EST_MEAN, EST_VAR);
+    OUTPUT_TAGS(OUTPUT, RUNNING_MEAN, RUNNING_VAR, SAVED_MEAN, SAVED_INV_VAR);
+};
+
+class SyncSpatialBNGradientOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    SyncSpatialBNGradientOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws),
+          gpu_direct_(OperatorBase::GetSingleArgument<bool>("gpu_direct", false))
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        const auto& X             = Input(INPUT);
+        const auto& scale         = Input(SCALE);
+        const auto& dY            = Input(OUTPUT_GRAD);
+        const auto& saved_mean    = Input(SAVED_MEAN);
+        const auto& saved_inv_var = Input(SAVED_INV_VAR);
+        CAFFE_ENFORCE(X.IsType<float>(), "SyncSpatialBNGradient only supports float");
+        CAFFE_ENFORCE_GE(X.ndim(), 3);
+        CAFFE_ENFORCE_EQ(dY.dims(), X.dims());
+        const int N   = X.dim32(0);
+        const int C   = X.dim32(1);
+        const int HxW = X.size() / (N * C);
+        CAFFE_ENFORCE_EQ(scale.size(), C);
+
+        // The local gradients of the scale and the bias are also the outputs;
+        // the global ones, with the global count, are only used for dX.
+        sums_.Resize(2 * C + 1);
+        float* sums = sums_.mutable_data<float>();
+        hipLaunchKernelGGL((ChannelBackpropStatsKernel),
+                           dim3(C),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           N,
+                           C,
+                           HxW,
+                           X.data<float>(),
+                           dY.data<float>(),
+                           saved_mean.data<float>(),
+                           saved_inv_var.data<float>(),
+                           sums);
+        auto* dScale = Output(SCALE_GRAD);
+        auto* dBias  = Output(BIAS_GRAD);
+        dScale->ResizeLike(scale);
+        dBias->ResizeLike(scale);
+        context_.Copy<float, HIPContext, HIPContext>(
+            C, sums, dScale->mutable_data<float>());
+        context_.Copy<float, HIPContext, HIPContext>(
+            C, sums + C, dBias->mutable_data<float>());
+        allreduce_.Run(OperatorBase::Input<std::shared_ptr<::gloo::Context>>(COMM),
+                       sums,
+                       2 * C + 1,
+                       context_.hip_stream(),
+                       gpu_direct_);
+
+        auto* dX = Output(INPUT_GRAD);
+        dX->ResizeLike(X);
+        hipLaunchKernelGGL((SyncSpatialBNGradientKernel),
+                           dim3(CAFFE_GET_BLOCKS(X.size())),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           static_cast<const int>(X.size()),
+                           C,
+                           HxW,
+                           X.data<float>(),
+                           dY.data<float>(),
+                           scale.data<float>(),
+                           saved_mean.data<float>(),
+                           saved_inv_var.data<float>(),
+                           sums,
+                           dX->mutable_data<float>());
+        return true;
+    }
+
+    protected:
+    const bool gpu_direct_;
+    Tensor<HIPContext> sums_;
+    ChannelSumsAllreduce allreduce_;
+
+    INPUT_TAGS(COMM, INPUT, SCALE, OUTPUT_GRAD, SAVED_MEAN, SAVED_INV_VAR);
+    OUTPUT_TAGS(INPUT_GRAD, SCALE_GRAD, BIAS_GRAD);
+};
+
+namespace {
+
+REGISTER_HIP_OPERATOR_WITH_ENGINE(SyncSpatialBN, GLOO, SyncSpatialBNOp);
+REGISTER_HIP_OPERATOR_WITH_ENGINE(SyncSpatialBNGradient, GLOO, SyncSpatialBNGradientOp);
+
+} // namespace
+} // namespace gloo
+} // namespace caffe2
@@ -191,6 +191,7 @@ OPERATOR_SCHEMA(NCCLAllreduce)
     .NumOutputs(1, CAFFE2_COMPILE_TIME_MAX_GPUS)
     .IdenticalTypeAndShape()
     .InputsCanCrossDevices()
+    .CommunicationOp()
     .AllowOneToOneInplace()
     .DeviceInferenceFunction(ncclOpDevInfer);
 SHOULD_NOT_DO_GRADIENT(NCCLAllreduce);
@@ -201,6 +202,7 @@ OPERATOR_SCHEMA(NCCLBroadcast)
     .NumOutputs(1, CAFFE2_COMPILE_TIME_MAX_GPUS)
     .IdenticalTypeAndShape()
     .InputsCanCrossDevices()
+    .CommunicationOp()
     .EnforceOneToOneInplace()
     .DeviceInferenceFunction(ncclOpDevInfer);
 
@@ -212,6 +214,7 @@ OPERATOR_SCHEMA(NCCLReduce)
     .NumOutputs(1)
     .IdenticalTypeAndShapeOfInput(0)
     .InputsCanCrossDevices()
+    .CommunicationOp()
     .AllowInplace([](int in, int out) -> bool { return (out == 0); })
     .DeviceInferenceFunction(ncclOpDevInfer);
 SHOULD_NOT_DO_GRADIENT(NCCLReduce);
@@ -221,6 +224,7 @@ OPERATOR_SCHEMA(NCCLAllGather)
     .NumInputs(1, CAFFE2_COMPILE_TIME_MAX_GPUS)
     .NumOutputs(1, CAFFE2_COMPILE_TIME_MAX_GPUS)
     .InputsCanCrossDevices()
+    .CommunicationOp()
     .DeviceInferenceFunction(ncclOpDevInfer);
 SHOULD_NOT_DO_GRADIENT(NCCLAllGather);
 
@@ -229,6 +233,7 @@ OPERATOR_SCHEMA(NCCLReduceScatter)
     .NumInputs(1, CAFFE2_COMPILE_TIME_MAX_GPUS)
     .NumOutputs(1, CAFFE2_COMPILE_TIME_MAX_GPUS)
     .InputsCanCrossDevices()
+    .CommunicationOp()
     .DeviceInferenceFunction(ncclOpDevInfer);
 SHOULD_NOT_DO_GRADIENT(NCCLReduceScatter);
 } // namespace
@@ -0,0 +1,329 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rccl_hip.h"
+
+namespace caffe2 {
+
+namespace rccl {
+
+namespace {
+
+std::vector<int> getDevices(const RCCLExecution& ex)
+{
+    std::vector<int> result;
+    result.reserve(ex.elements.size());
+    for(const auto& el : ex.elements)
+    {
+        result.push_back(el.device);
+    }
+    return result;
+}
+
+class RCCLContext
+{
+    public:
+    explicit RCCLContext(const RCCLExecution& ex)
+        : devices_(getDevices(ex)), master_gpu_id_(ex.stream_gpu_id)
+    {
+        comms_.resize(devices_.size());
+        CAFFE_RCCL_CHECK(ncclCommInitAll(comms_.data(), devices_.size(), devices_.data()));
+
+        streams_.resize(devices_.size());
+        events_.resize(devices_.size());
+        for(auto i = 0; i < devices_.size(); ++i)
+        {
+            DeviceGuard g(devices_[i]);
+            // The collectives get ahead of the compute kernels queued on the
+            // device, as the communication stream of the async nets does.
+            int least_priority, greatest_priority;
+            HIP_ENFORCE(hipDeviceGetStreamPriorityRange(&least_priority, &greatest_priority));
+            HIP_ENFORCE(hipStreamCreateWithPriority(
+                &streams_[i], hipStreamNonBlocking, greatest_priority));
+            HIP_ENFORCE(hipEventCreateWithFlags(&events_[i], hipEventDisableTiming));
+        }
+        DeviceGuard g(master_gpu_id_);
+        HIP_ENFORCE(hipEventCreateWithFlags(&master_event_, hipEventDisableTiming));
+    }
+
+    ~RCCLContext()
+    {
+        for(auto i = 0; i < devices_.size(); ++i)
+        {
+            DeviceGuard g(devices_[i]);
+            HIP_ENFORCE(hipStreamDestroy(streams_[i]));
+            HIP_ENFORCE(hipEventDestroy(events_[i]));
+        }
+        DeviceGuard g(master_gpu_id_);
+        HIP_ENFORCE(hipEventDestroy(master_event_));
+        for(auto& comm : comms_)
+        {
+            ncclCommDestroy(comm);
+        }
+    }
+
+    std::vector<int> devices_;
+    std::vector<ncclComm_t> comms_;
+    std::vector<hipStream_t> streams_;
+    int master_gpu_id_;
+    hipEvent_t master_event_;
+    std::vector<hipEvent_t> events_;
+
+    DISABLE_COPY_AND_ASSIGN(RCCLContext);
+};
+
+// We share the contexts across multiple operators, hence the
+// process-wide cache
+static std::mutex& gContextsMutex()
+{
+    static std::mutex m;
+    return m;
+}
+
+std::unordered_map<std::string, std::unique_ptr<RCCLContext>>& gContexts()
+{
+    // Initiazed after HIP, so guaranteed to be destructed before HIP.
+    static std::unordered_map<std::string, std::unique_ptr<RCCLContext>> m;
+    return m;
+}
+
+std::string rcclKey(const RCCLExecution& ex)
+{
+    std::string result;
+    result += to_string(CaffeHipGetDevice()) + ":";
+    for(const auto& el : ex.elements)
+    {
+        result += to_string(el.device) + ",";
+    }
+    return result;
+}
+
+RCCLContext* getRCCLContext(const RCCLExecution& ex)
+{
+    auto& contexts = gContexts();
+    const auto key = rcclKey(ex);
+    if(!contexts[key])
+    {
+        LOG(INFO) << "Creating RCCLContext for key: " << key;
+        contexts[key].reset(new RCCLContext(ex));
+    }
+    return CHECK_NOTNULL(contexts[key].get());
+}
+
+template <typename T>
+class rcclTypeWrapper;
+
+template <>
+class rcclTypeWrapper<float>
+{
+    public:
+    static const ncclDataType_t type = ncclFloat;
+};
+
+template <>
+class rcclTypeWrapper<int>
+{
+    public:
+    static const ncclDataType_t type = ncclInt;
+};
+
+template <>
+class rcclTypeWrapper<float16>
+{
+    public:
+    static const ncclDataType_t type = ncclHalf;
+};
+
+template <typename T, typename InitF, typename F>
+void runRCCL(const RCCLExecution& ex, InitF&& init_f, F&& f)
+{
+    // do initialization
+    for(auto i = 0; i < ex.elements.size(); ++i)
+    {
+        auto& ctx = ex.elements[i];
+        DeviceGuard g(ctx.device);
+        init_f(ex.elements[i]);
+    }
+
+    std::lock_guard<std::mutex> g(gContextsMutex());
+    auto* context = getRCCLContext(ex);
+    auto& comms   = context->comms_;
+    auto& streams = context->streams_;
+    auto& events  = context->events_;
+    // Record an event on the master context, wait on it in each of the
+    // children streams, so the children streams are synchronized WRT
+    // the original stream.
+    {
+        DeviceGuard g(ex.stream_gpu_id);
+        HIP_ENFORCE(hipEventRecord(context->master_event_, ex.stream));
+    }
+
+    {
+        // lock out alloc / free while RCCL launches
+        std::lock_guard<std::mutex> lock(HIPContext::mutex());
+
+        CAFFE_RCCL_CHECK(ncclGroupStart());
+
+        for(auto i = 0; i < ex.elements.size(); ++i)
+        {
+            auto& ctx    = ex.elements[i];
+            DeviceGuard g(ctx.device);
+            auto& comm   = comms[i];
+            auto& stream = streams[i];
+
+            DCHECK_EQ(ctx.device, GetGPUIDForPointer(ctx.src->raw_data()));
+            HIP_ENFORCE(hipStreamWaitEvent(stream, context->master_event_, 0));
+            f(ctx, comm, stream);
+        }
+
+        CAFFE_RCCL_CHECK(ncclGroupEnd());
+
+        for(auto i = 0; i < ex.elements.size(); ++i)
+        {
+            auto& ctx = ex.elements[i];
+            DeviceGuard g(ctx.device);
+            // Record an event on each children stream that we have finished
+            // our computation
+            HIP_ENFORCE(hipEventRecord(events[i], streams[i]));
+        }
+    }
+
+    // Now, wait on all the events in the original stream.
+    DeviceGuard dg(ex.stream_gpu_id);
+    for(auto& event : events)
+    {
+        HIP_ENFORCE(hipStreamWaitEvent(CHECK_NOTNULL(ex.stream), event, 0));
+    }
+}
+
+} // namespace
+
+template <typename T>
+void RCCL<T>::AllReduce(const RCCLExecution& ex)
+{
+    return runRCCL<T>(ex,
+                      [](const RCCLElement& ctx) {
+                          ctx.dst->Resize(ctx.src->dims());
+                          ctx.dst->template mutable_data<T>();
+                      },
+                      [](const RCCLElement& ctx, ncclComm_t comm, hipStream_t stream) {
+                          CAFFE_RCCL_CHECK(ncclAllReduce(ctx.src->raw_data(),
+                                                         ctx.dst->raw_mutable_data(),
+                                                         ctx.dst->size(),
+                                                         rcclTypeWrapper<T>::type,
+                                                         ncclSum,
+                                                         comm,
+                                                         stream));
+                      });
+}
+
+template <typename T>
+void RCCL<T>::Broadcast(const RCCLExecution& ex)
+{
+    return runRCCL<T>(ex,
+                      [](const RCCLElement& ctx) {
+                          ctx.dst->Resize(ctx.src->dims());
+                          ctx.dst->template mutable_data<T>();
+                      },
+                      [&ex](const RCCLElement& ctx, ncclComm_t comm, hipStream_t stream) {
+                          CAFFE_RCCL_CHECK(ncclBcast(ctx.dst->raw_mutable_data(),
+                                                     ctx.dst->size(),
+                                                     rcclTypeWrapper<T>::type,
+                                                     ex.root,
+                                                     comm,
+                                                     stream));
+                      });
+}
+
+template <typename T>
+void RCCL<T>::Reduce(const RCCLExecution& ex)
+{
+    return runRCCL<T>(ex,
+                      [](const RCCLElement& ctx) {
+                          if(ctx.dst)
+                          {
+                              ctx.dst->Resize(ctx.src->dims());
+                              ctx.dst->template mutable_data<T>();
+                          }
+                      },
+                      [&ex](const RCCLElement& ctx, ncclComm_t comm, hipStream_t stream) {
+                          CAFFE_RCCL_CHECK(
+                              ncclReduce(ctx.src->raw_data(),
+                                         ctx.dst ? ctx.dst->raw_mutable_data() : nullptr,
+                                         ctx.src->size(),
+                                         rcclTypeWrapper<T>::type,
+                                         ncclSum,
+                                         ex.root,
+                                         comm,
+                                         stream));
+                      });
+}
+
+template <typename T>
+void RCCL<T>::AllGather(const RCCLExecution& ex)
+{
+    const auto n = ex.elements.size();
+    return runRCCL<T>(ex,
+                      [n](const RCCLElement& ctx) {
+                          CAFFE_ENFORCE_NE(ctx.src, ctx.dst);
+                          std::vector<TIndex> dims;
+                          dims.reserve(ctx.src->ndim() + 1);
+                          dims.push_back(n);
+                          for(auto d : ctx.src->dims())
+                          {
+                              dims.push_back(d);
+                          }
+                          ctx.dst->Resize(dims);
+                          ctx.dst->template mutable_data<T>();
+                      },
+                      [](const RCCLElement& ctx, ncclComm_t comm, hipStream_t stream) {
+                          CAFFE_RCCL_CHECK(ncclAllGather(ctx.src->raw_data(),
+                                                         ctx.dst->raw_mutable_data(),
+                                                         ctx.src->size(),
+                                                         rcclTypeWrapper<T>::type,
+                                                         comm,
+                                                         stream));
+                      });
+}
+
+template <typename T>
+void RCCL<T>::ReduceScatter(const RCCLExecution& ex)
+{
+    return runRCCL<T>(ex,
+                      [](const RCCLElement& ctx) {
+                          CAFFE_ENFORCE_NE(ctx.src, ctx.dst);
+                          const auto& srcDims = ctx.src->dims();
+                          std::vector<TIndex> dstDims(srcDims.begin() + 1, srcDims.end());
+                          ctx.dst->Resize(dstDims);
+                          ctx.dst->template mutable_data<T>();
+                      },
+                      [](const RCCLElement& ctx, ncclComm_t comm, hipStream_t stream) {
+                          CAFFE_RCCL_CHECK(ncclReduceScatter(ctx.src->raw_data(),
+                                                             ctx.dst->raw_mutable_data(),
+                                                             ctx.dst->size(),
+                                                             rcclTypeWrapper<T>::type,
+                                                             ncclSum,
+                                                             comm,
+                                                             stream));
+                      });
+}
+
+// Explicit instantiation
+template class RCCL<float>;
+template class RCCL<int>;
+template class RCCL<float16>;
+} // namespace rccl
+} // namespace caffe2
@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "caffe2/core/common_hip.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/logging.h"
+
+#include <rccl.h>
+#include <unordered_map>
+
+namespace caffe2 {
+
+namespace rccl {
+
+#define CAFFE_RCCL_CHECK(condition)                     \
+    do                                                  \
+    {                                                   \
+        ncclResult_t status = (condition);              \
+        CAFFE_ENFORCE_EQ(status,                        \
+                         ncclSuccess,                   \
+                         " ",                           \
+                         "Error at: ",                  \
+                         __FILE__,                      \
+                         __LINE__,                      \
+                         ": ",                          \
+                         ncclGetErrorString(status));   \
+    } while(0)
+
+struct RCCLElement
+{
+    const TensorHIP* src{nullptr};
+    TensorHIP* dst{nullptr};
+    int device{0};
+};
+
+struct RCCLExecution
+{
+    int stream_gpu_id{0};
+    hipStream_t stream{nullptr};
+    std::vector<RCCLElement> elements;
+    size_t root{0};
+};
+
+/**
+ * RCCL counterpart of nccl::NCCL (cuda_nccl_gpu.h). Communicators are created
+ * once per set of devices and shared by all operators running collectives on
+ * that set, so intra-node collectives go straight over the peer-to-peer links.
+ */
+template <typename T>
+class RCCL
+{
+    public:
+    static void AllReduce(const RCCLExecution& ex);
+    static void Broadcast(const RCCLExecution& ex);
+    static void Reduce(const RCCLExecution& ex);
+    static void AllGather(const RCCLExecution& ex);
+    static void ReduceScatter(const RCCLExecution& ex);
+};
+} // namespace rccl
+} // namespace caffe2
@@ -0,0 +1,277 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/operator.h"
+
+#include "rccl_hip.h"
+
+namespace caffe2 {
+
+rccl::RCCLExecution getRCCLElements(OperatorBase* op, const HIPContext& context)
+{
+    // We either do an N-N op, or an N-1 op.
+    CAFFE_ENFORCE(op->InputSize() == op->OutputSize() || op->OutputSize() == 1);
+    rccl::RCCLExecution ex;
+    ex.stream_gpu_id = context.hip_gpu_id();
+    ex.stream        = context.hip_stream();
+    ex.root          = op->template GetSingleArgument<int>("root", 0);
+    ex.elements.resize(op->InputSize());
+    for(auto i = 0; i < op->InputSize(); ++i)
+    {
+        auto& el = ex.elements[i];
+        el.src   = &(op->Input<TensorHIP>(i));
+        if(op->OutputSize() == 1)
+        {
+            // Reduce op
+            if(i == ex.root)
+            {
+                el.dst = op->Output<TensorHIP>(0);
+            }
+        }
+        else if(i < op->OutputSize())
+        {
+            el.dst = op->Output<TensorHIP>(i);
+        }
+        el.device = GetGPUIDForPointer(op->Input<TensorHIP>(i).raw_data());
+    }
+
+    return ex;
+}
+
+namespace {
+// Check if all inputs are float
+template <typename T>
+bool AllInputsAre(OperatorBase* op)
+{
+    for(auto i = 0; i < op->InputSize(); ++i)
+    {
+        if(op->Input<TensorHIP>(i).IsType<T>())
+        {
+            continue;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+}; // namespace
+
+class RCCLAllreduceOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    using Operator::Operator;
+    bool RunOnDevice() override
+    {
+        if(InputSize() == 1)
+            return true;
+
+        if(AllInputsAre<float>(this))
+        {
+            rccl::RCCL<float>::AllReduce(getRCCLElements(this, context_));
+            return true;
+        }
+        else if(AllInputsAre<float16>(this))
+        {
+            rccl::RCCL<float16>::AllReduce(getRCCLElements(this, context_));
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+};
+
+class RCCLBroadcastOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    using Operator::Operator;
+    bool RunOnDevice() override
+    {
+        if(InputSize() == 1)
+            return true;
+        if(AllInputsAre<float>(this))
+        {
+            rccl::RCCL<float>::Broadcast(getRCCLElements(this, context_));
+            return true;
+        }
+        else if(AllInputsAre<float16>(this))
+        {
+            rccl::RCCL<float16>::Broadcast(getRCCLElements(this, context_));
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+};
+
+class RCCLReduceOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    using Operator::Operator;
+    bool RunOnDevice() override
+    {
+        if(InputSize() == 1)
+            return true;
+        const auto& ex = getRCCLElements(this, context_);
+
+        if(AllInputsAre<float>(this))
+        {
+            rccl::RCCL<float>::Reduce(ex);
+            return true;
+        }
+        else if(AllInputsAre<float16>(this))
+        {
+            rccl::RCCL<float16>::Reduce(ex);
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+};
+
+class RCCLAllGatherOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    using Operator::Operator;
+    bool RunOnDevice() override
+    {
+        if(InputSize() == 1)
+            return true;
+        if(AllInputsAre<float>(this))
+        {
+            rccl::RCCL<float>::AllGather(getRCCLElements(this, context_));
+            return true;
+        }
+        else if(AllInputsAre<float16>(this))
+        {
+            rccl::RCCL<float16>::AllGather(getRCCLElements(this, context_));
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+};
+
+class RCCLReduceScatterOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    using Operator::Operator;
+    bool RunOnDevice() override
+    {
+        if(AllInputsAre<float>(this))
+        {
+            rccl::RCCL<float>::ReduceScatter(getRCCLElements(this, context_));
+            return true;
+        }
+        else if(AllInputsAre<float16>(this))
+        {
+            rccl::RCCL<float16>::ReduceScatter(getRCCLElements(this, context_));
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+};
+
+namespace {
+
+std::pair<std::vector<DeviceOption>, std::vector<DeviceOption>>
+rcclOpDevInfer(const OperatorDef& def)
+{
+    std::vector<DeviceOption> opt;
+    for(int i = 0; i < def.input().size(); ++i)
+    {
+        DeviceOption dev;
+        dev.set_device_type(HIP);
+        dev.set_hip_gpu_id(i);
+        opt.push_back(dev);
+    }
+    return std::make_pair(opt, opt);
+}
+
+// The operators keep the NCCL* names so that nets built for CUDA (e.g. by
+// data_parallel_model) run unchanged on ROCm. The schemas are only defined
+// here because the CUDA NCCL operators are never built together with HIP.
+REGISTER_HIP_OPERATOR(NCCLAllreduce, RCCLAllreduceOp);
+OPERATOR_SCHEMA(NCCLAllreduce)
+    .NumInputs(1, CAFFE2_COMPILE_TIME_MAX_GPUS)
+    .NumOutputs(1, CAFFE2_COMPILE_TIME_MAX_GPUS)
+    .IdenticalTypeAndShape()
+    .InputsCanCrossDevices()
+    .CommunicationOp()
+    .AllowOneToOneInplace()
+    .DeviceInferenceFunction(rcclOpDevInfer);
+SHOULD_NOT_DO_GRADIENT(NCCLAllreduce);
+
+REGISTER_HIP_OPERATOR(NCCLBroadcast, RCCLBroadcastOp);
+OPERATOR_SCHEMA(NCCLBroadcast)
+    .NumInputs(1, CAFFE2_COMPILE_TIME_MAX_GPUS)
+    .NumOutputs(1, CAFFE2_COMPILE_TIME_MAX_GPUS)
+    .IdenticalTypeAndShape()
+    .InputsCanCrossDevices()
+    .CommunicationOp()
+    .EnforceOneToOneInplace()
+    .DeviceInferenceFunction(rcclOpDevInfer);
+SHOULD_NOT_DO_GRADIENT(NCCLBroadcast);
+
+REGISTER_HIP_OPERATOR(NCCLReduce, RCCLReduceOp);
+OPERATOR_SCHEMA(NCCLReduce)
+    .NumInputs(1, CAFFE2_COMPILE_TIME_MAX_GPUS)
+    .NumOutputs(1)
+    .IdenticalTypeAndShapeOfInput(0)
+    .InputsCanCrossDevices()
+    .CommunicationOp()
+    .AllowInplace([](int in, int out) -> bool { return (out == 0); })
+    .DeviceInferenceFunction(rcclOpDevInfer);
+SHOULD_NOT_DO_GRADIENT(NCCLReduce);
+
+REGISTER_HIP_OPERATOR(NCCLAllGather, RCCLAllGatherOp);
+OPERATOR_SCHEMA(NCCLAllGather)
+    .NumInputs(1, CAFFE2_COMPILE_TIME_MAX_GPUS)
+    .NumOutputs(1, CAFFE2_COMPILE_TIME_MAX_GPUS)
+    .InputsCanCrossDevices()
+    .CommunicationOp()
+    .DeviceInferenceFunction(rcclOpDevInfer);
+SHOULD_NOT_DO_GRADIENT(NCCLAllGather);
+
+REGISTER_HIP_OPERATOR(NCCLReduceScatter, RCCLReduceScatterOp);
+OPERATOR_SCHEMA(NCCLReduceScatter)
+    .NumInputs(1, CAFFE2_COMPILE_TIME_MAX_GPUS)
+    .NumOutputs(1, CAFFE2_COMPILE_TIME_MAX_GPUS)
+    .InputsCanCrossDevices()
+    .CommunicationOp()
+    .DeviceInferenceFunction(rcclOpDevInfer);
+SHOULD_NOT_DO_GRADIENT(NCCLReduceScatter);
+} // namespace
+
+} // namespace caffe2
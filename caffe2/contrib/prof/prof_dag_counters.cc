@@ -0,0 +1,199 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/contrib/prof/prof_dag_counters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#include "caffe2/core/init.h"
+
+CAFFE2_DEFINE_int(
+    caffe2_prof_dag_sample_period,
+    0,
+    "If positive, profile the operators of every net in one out of this many "
+    "runs, see GetProfDagStats.");
+
+namespace caffe2 {
+
+namespace {
+
+std::mutex& CountersMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::unordered_map<const NetBase*, ProfDAGCounters*>& CountersMap() {
+  static std::unordered_map<const NetBase*, ProfDAGCounters*> counters;
+  return counters;
+}
+
+} // namespace
+
+ProfDAGCounters::ProfDAGCounters(NetBase* subject, int sample_period)
+    : ObserverBase<NetBase>(subject),
+      sample_period_(sample_period),
+      operators_(subject->GetOperators()),
+      op_time_run_(operators_.size()),
+      time_per_op_(operators_.size()) {
+  CAFFE_ENFORCE_GT(sample_period_, 0);
+  for (int idx = 0; idx < operators_.size(); ++idx) {
+    auto* op = operators_[idx];
+    op_types_.push_back(
+        op->has_debug_def() ? op->debug_def().type() : std::string("unknown"));
+    op->AttachObserver(
+        caffe2::make_unique<ProfDAGCountersOperatorObserver>(op, this, idx));
+  }
+  std::lock_guard<std::mutex> lock(CountersMutex());
+  CountersMap()[subject] = this;
+}
+
+ProfDAGCounters::~ProfDAGCounters() {
+  std::lock_guard<std::mutex> lock(CountersMutex());
+  auto it = CountersMap().find(subject_);
+  if (it != CountersMap().end() && it->second == this) {
+    CountersMap().erase(it);
+  }
+}
+
+ProfDAGCounters* ProfDAGCounters::Find(const NetBase* net) {
+  std::lock_guard<std::mutex> lock(CountersMutex());
+  auto it = CountersMap().find(net);
+  return it == CountersMap().end() ? nullptr : it->second;
+}
+
+void ProfDAGCounters::Start() {
+  ++runs_;
+  // don't collect statistics from first run
+  const bool sample = runs_ > 1 && (runs_ - 2) % sample_period_ == 0;
+  if (sample) {
+    std::fill(op_time_run_.begin(), op_time_run_.end(), 0.0f);
+  }
+  sampling_.store(sample, std::memory_order_relaxed);
+}
+
+void ProfDAGCounters::Stop() {
+  if (!sampling()) {
+    return;
+  }
+  sampling_.store(false, std::memory_order_relaxed);
+
+  // aggregate this run's stats per operator type
+  CaffeMap<std::string, float> time_per_op_type_run;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (int idx = 0; idx < operators_.size(); ++idx) {
+    const float spent = op_time_run_[idx];
+    time_per_op_[idx].sum += spent;
+    time_per_op_[idx].sqrsum += spent * spent;
+    time_per_op_type_run[op_types_[idx]] += spent;
+    time_per_op_type_[op_types_[idx]].cnt += 1;
+  }
+  for (const auto& item : time_per_op_type_run) {
+    time_per_op_type_[item.first].sum += item.second;
+    time_per_op_type_[item.first].sqrsum += item.second * item.second;
+  }
+  ++sampled_runs_;
+}
+
+int ProfDAGCounters::sampled_runs() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return sampled_runs_;
+}
+
+ProfDAGProto ProfDAGCounters::ProtoMsg(
+    const std::string& name,
+    const Stats& stats) const {
+  ProfDAGProto message;
+  float mean = 0;
+  float stddev = 0;
+  if (sampled_runs_ > 0) {
+    mean = stats.sum / sampled_runs_;
+    stddev = std::sqrt(
+        std::max(stats.sqrsum / sampled_runs_ - mean * mean, 0.0f));
+  }
+  message.set_mean(mean);
+  message.set_stddev(stddev);
+  message.set_name(name);
+  return message;
+}
+
+ProfDAGProtos ProfDAGCounters::GetOperatorStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ProfDAGProtos prof_dag_protos;
+  for (const auto& item : time_per_op_type_) {
+    prof_dag_protos.add_stats()->CopyFrom(ProtoMsg(item.first, item.second));
+  }
+  return prof_dag_protos;
+}
+
+ProfDAGProtos ProfDAGCounters::GetPerOperatorCost() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ProfDAGProtos prof_dag_protos;
+  for (int idx = 0; idx < operators_.size(); ++idx) {
+    const std::string op_output_name =
+        subject_->Name() + "___" + to_string(idx) + "___" + op_types_[idx];
+    prof_dag_protos.add_stats()->CopyFrom(
+        ProtoMsg(op_output_name, time_per_op_[idx]));
+  }
+  return prof_dag_protos;
+}
+
+ProfDAGCountersOperatorObserver::ProfDAGCountersOperatorObserver(
+    OperatorBase* subject,
+    ProfDAGCounters* counters,
+    int idx)
+    : ObserverBase<OperatorBase>(subject), counters_(counters), idx_(idx) {}
+
+void ProfDAGCountersOperatorObserver::Start() {
+  if (counters_->sampling()) {
+    timer_.Start();
+  }
+}
+
+void ProfDAGCountersOperatorObserver::Stop() {
+  if (counters_->sampling()) {
+    counters_->op_time_run_[idx_] = timer_.MilliSeconds();
+  }
+}
+
+void EnableProfDAGSampling(int sample_period) {
+  CAFFE_ENFORCE_GT(sample_period, 0);
+  AddGlobalNetObserverCreator([sample_period](NetBase* net) {
+    return caffe2::make_unique<ProfDAGCounters>(net, sample_period);
+  });
+}
+
+namespace {
+
+bool Caffe2InitProfDAGSampling(int*, char***) {
+  if (FLAGS_caffe2_prof_dag_sample_period > 0) {
+    EnableProfDAGSampling(FLAGS_caffe2_prof_dag_sample_period);
+    VLOG(1) << "Profiling one in " << FLAGS_caffe2_prof_dag_sample_period
+            << " net runs";
+  }
+  return true;
+}
+
+} // namespace
+
+REGISTER_CAFFE2_INIT_FUNCTION(
+    Caffe2InitProfDAGSampling,
+    &Caffe2InitProfDAGSampling,
+    "Sample net runs with ProfDAGCounters if --caffe2_prof_dag_sample_period "
+    "is set.");
+
+} // namespace caffe2
@@ -0,0 +1,115 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "caffe2/contrib/prof/prof_dag_net.h"
+#include "caffe2/core/flags.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/observer.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/timer.h"
+#include "caffe2/proto/prof_dag.pb.h"
+
+CAFFE2_DECLARE_int(caffe2_prof_dag_sample_period);
+
+namespace caffe2 {
+
+class ProfDAGCountersOperatorObserver;
+
+/**
+ * A sampling counterpart of ProfDAGNet that works with any net type: it
+ * observes a net and times its operators in one run out of sample_period,
+ * collecting the same statistics as ProfDAGNet. The runs in between only pay
+ * for a check of a flag in each operator observer, so this can be left on in
+ * production.
+ *
+ * Like ProfDAGNet, the first run is not measured. Operator times are host
+ * times: in async nets they only cover the launch of the operators that have
+ * an asynchronous device part.
+ *
+ * The statistics can be read at any time, including while the net runs, with
+ * the GetProfDagStats operator.
+ */
+class ProfDAGCounters final : public ObserverBase<NetBase> {
+ public:
+  ProfDAGCounters(NetBase* subject, int sample_period);
+  ~ProfDAGCounters();
+
+  // Returns the counters observing net, or nullptr if there are none.
+  static ProfDAGCounters* Find(const NetBase* net);
+
+  bool sampling() const {
+    return sampling_.load(std::memory_order_relaxed);
+  }
+
+  // Same formats as ProfDAGNet::GetOperatorStats and GetPerOperatorCost.
+  ProfDAGProtos GetOperatorStats() const;
+  ProfDAGProtos GetPerOperatorCost() const;
+
+  int sampled_runs() const;
+
+ private:
+  friend class ProfDAGCountersOperatorObserver;
+
+  void Start() override;
+  void Stop() override;
+
+  ProfDAGProto ProtoMsg(const std::string& name, const Stats& stats) const;
+
+  const int sample_period_;
+  std::vector<OperatorBase*> operators_;
+  std::vector<std::string> op_types_;
+  int64_t runs_ = 0;
+  std::atomic<bool> sampling_{false};
+  // Written by the operator observers during a sampled run.
+  std::vector<float> op_time_run_;
+
+  mutable std::mutex mutex_;
+  int sampled_runs_ = 0;
+  std::vector<Stats> time_per_op_;
+  CaffeMap<std::string, Stats> time_per_op_type_;
+};
+
+class ProfDAGCountersOperatorObserver final
+    : public ObserverBase<OperatorBase> {
+ public:
+  ProfDAGCountersOperatorObserver(
+      OperatorBase* subject,
+      ProfDAGCounters* counters,
+      int idx);
+
+ private:
+  void Start() override;
+  void Stop() override;
+
+  ProfDAGCounters* counters_;
+  const int idx_;
+  Timer timer_;
+};
+
+/**
+ * Attaches a ProfDAGCounters observer sampling one in sample_period runs to
+ * every net created from now on. This is done at init time if
+ * --caffe2_prof_dag_sample_period is set.
+ */
+void EnableProfDAGSampling(int sample_period);
+
+} // namespace caffe2
@@ -0,0 +1,111 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/contrib/prof/prof_dag_counters.h"
+#include "caffe2/core/graph.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/workspace.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+
+namespace caffe2 {
+
+namespace {
+
+// Sleeps for a few milliseconds, then fails if the "fail" argument is set.
+class ProfDAGCountersTestOp final : public Operator<CPUContext> {
+ public:
+  ProfDAGCountersTestOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        fail_(OperatorBase::GetSingleArgument<bool>("fail", false)) {}
+
+  bool RunOnDevice() override {
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    CAFFE_ENFORCE(!fail_, "Failing as requested");
+    return true;
+  }
+
+ private:
+  const bool fail_;
+};
+
+REGISTER_CPU_OPERATOR(ProfDAGCountersTest, ProfDAGCountersTestOp);
+OPERATOR_SCHEMA(ProfDAGCountersTest).NumInputs(0).NumOutputs(0);
+
+unique_ptr<NetBase> CreateTestNet(Workspace* ws, bool fail) {
+  NetDef net_def;
+  net_def.set_name("prof_test");
+  AddOp(&net_def, "ProfDAGCountersTest", {}, {});
+  auto* op = AddOp(&net_def, "ProfDAGCountersTest", {}, {});
+  AddArgument("fail", static_cast<int>(fail), op);
+  return CreateNet(net_def, ws);
+}
+
+} // namespace
+
+TEST(ProfDAGCountersTest, SamplesOneRunInPeriod) {
+  Workspace ws;
+  auto net = CreateTestNet(&ws, false);
+  auto* counters = dynamic_cast_if_rtti<const ProfDAGCounters*>(
+      net->AttachObserver(
+          caffe2::make_unique<ProfDAGCounters>(net.get(), 2)));
+  EXPECT_EQ(ProfDAGCounters::Find(net.get()), counters);
+
+  // The first run is skipped, then one run out of two is sampled.
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(net->Run());
+  }
+  EXPECT_EQ(counters->sampled_runs(), 2);
+
+  const auto per_op = counters->GetPerOperatorCost();
+  EXPECT_EQ(per_op.stats_size(), 2);
+  EXPECT_EQ(per_op.stats(0).name(), "prof_test___0___ProfDAGCountersTest");
+  EXPECT_EQ(per_op.stats(1).name(), "prof_test___1___ProfDAGCountersTest");
+  for (const auto& stats : per_op.stats()) {
+    EXPECT_GE(stats.mean(), 2.0f);
+  }
+
+  // Both operators have the same type, so their times add up.
+  const auto per_type = counters->GetOperatorStats();
+  EXPECT_EQ(per_type.stats_size(), 1);
+  EXPECT_EQ(per_type.stats(0).name(), "ProfDAGCountersTest");
+  EXPECT_GE(per_type.stats(0).mean(), 4.0f);
+}
+
+TEST(ProfDAGCountersTest, TimesFailingOperators) {
+  Workspace ws;
+  auto net = CreateTestNet(&ws, true);
+  auto* counters = dynamic_cast_if_rtti<const ProfDAGCounters*>(
+      net->AttachObserver(
+          caffe2::make_unique<ProfDAGCounters>(net.get(), 1)));
+
+  auto* failing_op = net->GetOperators()[1];
+  for (int i = 0; i < 2; ++i) {
+    net->StartAllObservers();
+    EXPECT_THROW(failing_op->RunAsync(), EnforceNotMet);
+    net->StopAllObservers();
+  }
+  // The observer of the operator is stopped even though it threw, so the
+  // sampled second run has its time.
+  EXPECT_EQ(counters->sampled_runs(), 1);
+  EXPECT_GE(counters->GetPerOperatorCost().stats(1).mean(), 2.0f);
+  EXPECT_EQ(counters->GetPerOperatorCost().stats(0).mean(), 0.0f);
+}
+
+} // namespace caffe2
@@ -25,7 +25,9 @@ OPERATOR_SCHEMA(GetProfDagStats)
     .NumInputs(0)
     .NumOutputs(1)
     .SetDoc(R"DOC(
-Gets the profiling statistics.
+Gets the profiling statistics of a net, which is either a ProfDAGNet or a net
+of any type sampled by ProfDAGCounters (see --caffe2_prof_dag_sample_period).
+The output is a serialized ProfDAGProtos.
 )DOC")
     .Arg(
         "per_op",
@@ -34,9 +36,9 @@ Gets the profiling statistics.
         "op will be calculated separately")
     .Arg(
         "partial_net_name",
-        "(string) default to empty; describes the partial name of the ProfDAGNet")
+        "(string) default to empty; describes the partial name of the net")
     .Arg(
         "net_name",
-        "(string) default to empty; describes the name of the ProfDAGNet");
+        "(string) default to empty; describes the name of the net");
 } // namespace
 } // namespace caffe2
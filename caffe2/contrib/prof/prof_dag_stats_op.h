@@ -17,6 +17,7 @@
 #ifndef CAFFE2_OPERATORS_FULLY_CONNECTED_OP_H_
 #define CAFFE2_OPERATORS_FULLY_CONNECTED_OP_H_
 
+#include "caffe2/contrib/prof/prof_dag_counters.h"
 #include "caffe2/contrib/prof/prof_dag_net.h"
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
@@ -24,7 +25,8 @@
 
 namespace caffe2 {
 
-// This operator outputs the ProfDAGNet stats
+// This operator outputs the stats of a ProfDAGNet, or of the ProfDAGCounters
+// observing a net of another type
 template <typename T, class Context, class Engine = DefaultEngine>
 class GetProfDagStatsOp final : public Operator<Context> {
  public:
@@ -69,14 +71,28 @@ class GetProfDagStatsOp final : public Operator<Context> {
           " as part of its name");
     }
 
-    auto prof_dag_net = dynamic_cast_if_rtti<ProfDAGNet*>(net);
-    CAFFE_ENFORCE(prof_dag_net);
+    CAFFE_ENFORCE(net, "Can not find net ", net_name_);
 
     ProfDAGProtos stats;
-    if (per_op_) {
-      stats = prof_dag_net->GetPerOperatorCost();
+    if (auto* counters = ProfDAGCounters::Find(net)) {
+      if (per_op_) {
+        stats = counters->GetPerOperatorCost();
+      } else {
+        stats = counters->GetOperatorStats();
+      }
     } else {
-      stats = prof_dag_net->GetOperatorStats();
+      auto prof_dag_net = dynamic_cast_if_rtti<ProfDAGNet*>(net);
+      CAFFE_ENFORCE(
+          prof_dag_net,
+          "Net ",
+          net->Name(),
+          " is neither a ProfDAGNet nor sampled by ProfDAGCounters, see "
+          "--caffe2_prof_dag_sample_period");
+      if (per_op_) {
+        stats = prof_dag_net->GetPerOperatorCost();
+      } else {
+        stats = prof_dag_net->GetOperatorStats();
+      }
     }
 
     // Write protobuf message to the output blob
@@ -0,0 +1,345 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/contrib/shm_mutex/shm_blobs.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#include "caffe2/contrib/shm_mutex/shm_mutex.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor.h"
+#include "caffe2/core/types.h"
+
+namespace caffe2 {
+
+namespace {
+
+// A segment is a header, one entry per blob, and the data of the blobs:
+//   SegmentHeader
+//   for each blob: EntryHeader, int64 dims[ndim], name, padding up to 8
+//   for each blob: padding up to kDataAlignment, raw data
+// `complete` is set last, so a segment left behind by a process that died
+// while creating it is recognized and created again.
+constexpr char kMagic[4] = {'C', '2', 'S', 'B'};
+constexpr size_t kDataAlignment = 64;
+
+struct SegmentHeader {
+  char magic[4];
+  uint32_t num_blobs;
+  uint64_t size;
+  std::atomic<uint32_t> complete;
+  uint32_t unused;
+};
+
+struct EntryHeader {
+  uint64_t data_offset;
+  uint64_t nbytes;
+  int32_t data_type;
+  int32_t ndim;
+  uint32_t name_size;
+  uint32_t unused;
+};
+
+size_t AlignUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+size_t EntrySize(const TensorCPU& tensor, const std::string& name) {
+  return AlignUp(
+      sizeof(EntryHeader) + tensor.ndim() * sizeof(int64_t) + name.size(), 8);
+}
+
+void CreateSegment(
+    const std::string& segment,
+    const std::vector<std::string>& names,
+    const Workspace& loaded) {
+  std::vector<const TensorCPU*> tensors;
+  size_t size = sizeof(SegmentHeader);
+  for (const auto& name : names) {
+    const Blob* blob = loaded.GetBlob(name);
+    CAFFE_ENFORCE(
+        blob && blob->IsType<TensorCPU>(),
+        "The loader did not create the TensorCPU ",
+        name);
+    const auto& tensor = blob->Get<TensorCPU>();
+    const TensorProto::DataType data_type = TypeMetaToDataType(tensor.meta());
+    CAFFE_ENFORCE(
+        data_type != TensorProto::STRING &&
+            data_type != TensorProto::UNDEFINED,
+        "Only tensors of a fixed-size type can be shared, not ",
+        tensor.meta().name(),
+        " of ",
+        name);
+    tensors.push_back(&tensor);
+    size += EntrySize(tensor, name);
+  }
+  std::vector<size_t> data_offsets;
+  for (const auto* tensor : tensors) {
+    size = AlignUp(size, kDataAlignment);
+    data_offsets.push_back(size);
+    size += tensor->nbytes();
+  }
+
+  int fd = shm_open(segment.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+  CAFFE_ENFORCE_GE(
+      fd, 0, "Cannot create segment ", segment, ": ", strerror(errno));
+  const bool truncated = ftruncate(fd, size) == 0;
+  void* base = truncated
+      ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+      : MAP_FAILED;
+  close(fd);
+  if (base == MAP_FAILED) {
+    shm_unlink(segment.c_str());
+    CAFFE_THROW("Cannot allocate ", size, " bytes for segment ", segment);
+  }
+  char* data = static_cast<char*>(base);
+
+  auto* header = reinterpret_cast<SegmentHeader*>(data);
+  memcpy(header->magic, kMagic, sizeof(kMagic));
+  header->num_blobs = tensors.size();
+  header->size = size;
+  size_t offset = sizeof(SegmentHeader);
+  for (int i = 0; i < tensors.size(); ++i) {
+    const auto& tensor = *tensors[i];
+    EntryHeader entry;
+    entry.data_offset = data_offsets[i];
+    entry.nbytes = tensor.nbytes();
+    entry.data_type = TypeMetaToDataType(tensor.meta());
+    entry.ndim = tensor.ndim();
+    entry.name_size = names[i].size();
+    entry.unused = 0;
+    memcpy(data + offset, &entry, sizeof(entry));
+    for (int d = 0; d < tensor.ndim(); ++d) {
+      const int64_t dim = tensor.dim(d);
+      memcpy(
+          data + offset + sizeof(entry) + d * sizeof(int64_t),
+          &dim,
+          sizeof(dim));
+    }
+    memcpy(
+        data + offset + sizeof(entry) + tensor.ndim() * sizeof(int64_t),
+        names[i].data(),
+        names[i].size());
+    offset += EntrySize(tensor, names[i]);
+    if (tensor.nbytes()) {
+      memcpy(data + data_offsets[i], tensor.raw_data(), tensor.nbytes());
+    }
+  }
+  header->complete.store(1, std::memory_order_release);
+  munmap(base, size);
+  VLOG(1) << "Created segment " << segment << " of " << size << " bytes for "
+          << names.size() << " blobs";
+}
+
+enum class MapResult { kMapped, kMissing, kIncomplete };
+
+MapResult TryMapSegment(
+    const std::string& segment,
+    const std::vector<std::string>& names,
+    Workspace* ws) {
+  int fd = shm_open(segment.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    CAFFE_ENFORCE_EQ(
+        errno, ENOENT, "Cannot open segment ", segment, ": ", strerror(errno));
+    return MapResult::kMissing;
+  }
+  struct stat st;
+  const bool stat_ok = fstat(fd, &st) == 0;
+  const size_t size = stat_ok ? st.st_size : 0;
+  if (size < sizeof(SegmentHeader)) {
+    // Still being created, or its creator died before truncating it.
+    close(fd);
+    return MapResult::kIncomplete;
+  }
+  void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  CAFFE_ENFORCE(base != MAP_FAILED, "Cannot map segment ", segment);
+  std::shared_ptr<void> mapping(base, [size](void* ptr) { munmap(ptr, size); });
+  const char* data = static_cast<const char*>(base);
+
+  const auto* header = reinterpret_cast<const SegmentHeader*>(data);
+  CAFFE_ENFORCE(
+      memcmp(header->magic, kMagic, sizeof(kMagic)) == 0,
+      segment,
+      " is not a segment of shared blobs.");
+  if (!header->complete.load(std::memory_order_acquire)) {
+    return MapResult::kIncomplete;
+  }
+  CAFFE_ENFORCE_EQ(header->size, size, segment, " is truncated.");
+
+  std::unordered_map<std::string, std::pair<EntryHeader, const int64_t*>>
+      entries;
+  size_t offset = sizeof(SegmentHeader);
+  for (int i = 0; i < header->num_blobs; ++i) {
+    EntryHeader entry;
+    CAFFE_ENFORCE_LE(offset + sizeof(entry), size);
+    memcpy(&entry, data + offset, sizeof(entry));
+    const size_t dims_offset = offset + sizeof(entry);
+    const size_t name_offset = dims_offset + entry.ndim * sizeof(int64_t);
+    CAFFE_ENFORCE_LE(name_offset + entry.name_size, size);
+    CAFFE_ENFORCE_LE(entry.data_offset + entry.nbytes, size);
+    entries[std::string(data + name_offset, entry.name_size)] = std::make_pair(
+        entry, reinterpret_cast<const int64_t*>(data + dims_offset));
+    offset = AlignUp(name_offset + entry.name_size, 8);
+  }
+
+  for (const auto& name : names) {
+    auto it = entries.find(name);
+    CAFFE_ENFORCE(it != entries.end(), "Segment ", segment, " has no ", name);
+    const EntryHeader& entry = it->second.first;
+    const TypeMeta& meta =
+        DataTypeToTypeMeta(static_cast<TensorProto::DataType>(entry.data_type));
+    auto* tensor = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+    tensor->Resize(
+        vector<TIndex>(it->second.second, it->second.second + entry.ndim));
+    CAFFE_ENFORCE_EQ(tensor->size() * meta.itemsize(), entry.nbytes);
+    // The tensors keep the segment mapped for as long as they share it.
+    tensor->ShareExternalPointer(
+        const_cast<char*>(data) + entry.data_offset,
+        meta,
+        0,
+        [mapping](void*) {});
+  }
+  return MapResult::kMapped;
+}
+
+} // namespace
+
+void CheckSegmentName(const std::string& segment) {
+  CAFFE_ENFORCE(
+      segment.size() > 1 && segment[0] == '/' &&
+          segment.find('/', 1) == std::string::npos,
+      "A shared memory segment name is a '/' followed by a name without "
+      "other '/', not ",
+      segment);
+}
+
+void MapSharedBlobs(
+    const std::string& segment,
+    const std::vector<std::string>& names,
+    Workspace* ws,
+    const std::function<void(Workspace*)>& loader) {
+  CheckSegmentName(segment);
+  if (TryMapSegment(segment, names, ws) == MapResult::kMapped) {
+    return;
+  }
+
+  // A process may only hold one ShmTTSetMutex_t of a given name.
+  static std::mutex local_mutex;
+  std::lock_guard<std::mutex> local_guard(local_mutex);
+  ShmTTSetMutex_t mutex((segment + ".lock").c_str());
+  // Sleep rather than spin, the creation may take as long as loading the
+  // model.
+  while (!mutex.try_lock()) {
+    usleep(10000);
+  }
+  std::lock_guard<ShmTTSetMutex_t> guard(mutex, std::adopt_lock);
+
+  const MapResult result = TryMapSegment(segment, names, ws);
+  if (result == MapResult::kMapped) {
+    return;
+  }
+  if (result == MapResult::kIncomplete) {
+    LOG(WARNING) << "Recreating segment " << segment
+                 << ", left incomplete by a process that died creating it";
+    shm_unlink(segment.c_str());
+  }
+  {
+    Workspace loaded(ws);
+    loader(&loaded);
+    CreateSegment(segment, names, loaded);
+  }
+  CAFFE_ENFORCE(
+      TryMapSegment(segment, names, ws) == MapResult::kMapped,
+      "Cannot map segment ",
+      segment,
+      " after creating it");
+}
+
+bool UnlinkSharedBlobs(const std::string& segment) {
+  CheckSegmentName(segment);
+  if (shm_unlink(segment.c_str()) == 0) {
+    return true;
+  }
+  CAFFE_ENFORCE_EQ(
+      errno, ENOENT, "Cannot unlink segment ", segment, ": ", strerror(errno));
+  return false;
+}
+
+class MapSharedBlobsOp final : public Operator<CPUContext> {
+ public:
+  MapSharedBlobsOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        ws_(ws),
+        segment_(GetSingleArgument<string>("segment", "")),
+        init_net_(GetSingleArgument<NetDef>("init_net", NetDef())),
+        names_(operator_def.output().begin(), operator_def.output().end()) {
+    CheckSegmentName(segment_);
+  }
+
+  bool RunOnDevice() override {
+    MapSharedBlobs(segment_, names_, ws_, [this](Workspace* loaded) {
+      CAFFE_ENFORCE(
+          init_net_.op_size() > 0,
+          "Segment ",
+          segment_,
+          " does not exist and there is no init_net to load it from.");
+      CAFFE_ENFORCE(loaded->RunNetOnce(init_net_));
+    });
+    return true;
+  }
+
+ private:
+  Workspace* ws_;
+  string segment_;
+  NetDef init_net_;
+  vector<string> names_;
+};
+
+REGISTER_CPU_OPERATOR(MapSharedBlobs, MapSharedBlobsOp);
+
+OPERATOR_SCHEMA(MapSharedBlobs)
+    .NumInputs(0)
+    .NumOutputs(1, INT_MAX)
+    .SetDoc(R"DOC(
+Maps the output tensors, read-only, from the named POSIX shared-memory
+segment `segment`, so that the processes of a host that serve the same model
+share one copy of its weights. The first process to run the op for a
+segment that does not exist runs `init_net` in a child workspace to load the
+tensors, and creates the segment from them; the processes that come after it
+do not run `init_net`. The tensors must not be written to. The segment stays
+until it is unlinked, so its name should identify the version of the model.
+)DOC")
+    .Arg(
+        "segment",
+        "(string) name of the segment, a '/' followed by a name without "
+        "other '/'.")
+    .Arg(
+        "init_net",
+        "(NetDef) net creating the output tensors, run when the segment does "
+        "not exist.");
+
+NO_GRADIENT(MapSharedBlobs);
+
+} // namespace caffe2
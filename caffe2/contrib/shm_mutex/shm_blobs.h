@@ -0,0 +1,59 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Shares read-only CPU tensors, typically the weights of a model, between the
+ * processes of a host through a named POSIX shared-memory segment.
+ *
+ * The first process to ask for a segment that does not exist yet loads the
+ * tensors (e.g. by running the init_net of the model) and copies them into a
+ * new segment. Every process, including the first one, then maps the segment
+ * read-only and shares the tensors from it as external data, so the host only
+ * holds one copy of the weights whatever the number of processes. The
+ * creation is serialized by a ShmTTSetMutex_t named after the segment.
+ *
+ * The tensors must not be written to: they are mapped read-only, so writing
+ * to one crashes the process. The segment outlives the processes until
+ * UnlinkSharedBlobs is called, so its name should identify the version of
+ * the model. Only tensors of a fixed-size type can be shared.
+ */
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "caffe2/core/workspace.h"
+
+namespace caffe2 {
+
+// Maps the blobs `names` of segment into ws, as read-only TensorCPU. If the
+// segment does not exist, loader is called on a child workspace of ws, which
+// it has to fill with the blobs, and the segment is created from them.
+void MapSharedBlobs(
+    const std::string& segment,
+    const std::vector<std::string>& names,
+    Workspace* ws,
+    const std::function<void(Workspace*)>& loader);
+
+// Removes the segment, which is freed once no process maps it anymore.
+// Returns false if it did not exist.
+bool UnlinkSharedBlobs(const std::string& segment);
+
+// Throws unless segment is a valid name of a POSIX shared-memory segment.
+void CheckSegmentName(const std::string& segment);
+
+} // namespace caffe2
@@ -0,0 +1,613 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/contrib/shm_mutex/shm_queue.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "caffe2/contrib/shm_mutex/shm_blobs.h"
+#include "caffe2/contrib/shm_mutex/shm_mutex.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/types.h"
+
+namespace caffe2 {
+
+namespace {
+
+// The segment is the SharedMemoryQueueLayout header, padded up to
+// kDataAlignment, followed by the slots. A slot is
+//   SlotHeader, BlobHeader[num_blobs], padding up to kDataAlignment
+//   for each blob: raw data, padding up to kDataAlignment
+// `complete` is set last, so a segment left behind by a process that died
+// while creating it is recognized and created again.
+constexpr char kMagic[4] = {'C', '2', 'S', 'Q'};
+constexpr size_t kDataAlignment = 64;
+constexpr int kMaxDims = 8;
+// Waiting polls the slots, first yielding and then sleeping, since there is
+// no condition variable to share between processes.
+constexpr int kSpinCount = 1000;
+constexpr int kSleepMicros = 100;
+
+struct SlotHeader {
+  std::atomic<uint64_t> sequence;
+  uint64_t unused;
+};
+
+struct BlobHeader {
+  uint64_t data_offset; // from the start of the slot
+  uint64_t nbytes;
+  int32_t data_type;
+  int32_t ndim;
+  int64_t dims[kMaxDims];
+};
+
+size_t AlignUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+size_t SlotDataOffset(int num_blobs) {
+  return AlignUp(
+      sizeof(SlotHeader) + num_blobs * sizeof(BlobHeader), kDataAlignment);
+}
+
+} // namespace
+
+struct SharedMemoryQueueLayout {
+  char magic[4];
+  uint32_t num_slots;
+  uint32_t num_blobs;
+  uint32_t unused;
+  uint64_t slot_bytes;
+  uint64_t slot_stride;
+  uint64_t size;
+  std::atomic<uint32_t> complete;
+  std::atomic<uint32_t> closed;
+  // On cache lines of their own, they are bumped by different processes.
+  alignas(64) std::atomic<uint64_t> writer;
+  alignas(64) std::atomic<uint64_t> reader;
+
+  char* slot(uint64_t pos) {
+    return reinterpret_cast<char*>(this) +
+        AlignUp(sizeof(SharedMemoryQueueLayout), kDataAlignment) +
+        (pos % num_slots) * slot_stride;
+  }
+  std::atomic<uint64_t>& sequence(uint64_t pos) {
+    return reinterpret_cast<SlotHeader*>(slot(pos))->sequence;
+  }
+};
+
+namespace {
+
+template <typename Claim>
+bool WaitFor(
+    Claim claim,
+    const SharedMemoryQueueLayout* layout,
+    float timeout_secs) {
+  const auto deadline = std::chrono::steady_clock::now() +
+      std::chrono::milliseconds(int(timeout_secs * 1000));
+  for (int i = 0;; ++i) {
+    if (claim()) {
+      return true;
+    }
+    if (layout->closed.load(std::memory_order_acquire) ||
+        (timeout_secs > 0 && std::chrono::steady_clock::now() >= deadline)) {
+      return false;
+    }
+    if (i < kSpinCount) {
+      std::this_thread::yield();
+    } else {
+      usleep(kSleepMicros);
+    }
+  }
+}
+
+// Returns the mapped segment, or nullptr if it is incomplete.
+void* MapSegment(const std::string& segment, int fd, size_t* size) {
+  struct stat st;
+  CAFFE_ENFORCE_EQ(fstat(fd, &st), 0, "Cannot stat segment ", segment);
+  *size = st.st_size;
+  if (*size < sizeof(SharedMemoryQueueLayout)) {
+    return nullptr;
+  }
+  void* base =
+      mmap(nullptr, *size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  CAFFE_ENFORCE(base != MAP_FAILED, "Cannot map segment ", segment);
+  auto* layout = static_cast<SharedMemoryQueueLayout*>(base);
+  if (!layout->complete.load(std::memory_order_acquire)) {
+    munmap(base, *size);
+    return nullptr;
+  }
+  CAFFE_ENFORCE(
+      memcmp(layout->magic, kMagic, sizeof(kMagic)) == 0,
+      segment,
+      " is not a shared memory queue.");
+  CAFFE_ENFORCE_EQ(layout->size, *size, segment, " is truncated.");
+  return base;
+}
+
+void* CreateSegment(
+    const std::string& segment,
+    int num_slots,
+    int num_blobs,
+    size_t slot_bytes,
+    size_t* size) {
+  CAFFE_ENFORCE_GE(num_slots, 2, "A shared memory queue needs 2 slots");
+  CAFFE_ENFORCE_GT(num_blobs, 0);
+  slot_bytes = AlignUp(slot_bytes, kDataAlignment);
+  const size_t slot_stride = SlotDataOffset(num_blobs) + slot_bytes;
+  *size = AlignUp(sizeof(SharedMemoryQueueLayout), kDataAlignment) +
+      num_slots * slot_stride;
+
+  int fd = shm_open(segment.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  CAFFE_ENFORCE_GE(
+      fd, 0, "Cannot create segment ", segment, ": ", strerror(errno));
+  const bool truncated = ftruncate(fd, *size) == 0;
+  void* base = truncated
+      ? mmap(nullptr, *size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+      : MAP_FAILED;
+  close(fd);
+  if (base == MAP_FAILED) {
+    shm_unlink(segment.c_str());
+    CAFFE_THROW("Cannot allocate ", *size, " bytes for segment ", segment);
+  }
+
+  // The segment is all zeroes after ftruncate.
+  auto* layout = static_cast<SharedMemoryQueueLayout*>(base);
+  memcpy(layout->magic, kMagic, sizeof(kMagic));
+  layout->num_slots = num_slots;
+  layout->num_blobs = num_blobs;
+  layout->slot_bytes = slot_bytes;
+  layout->slot_stride = slot_stride;
+  layout->size = *size;
+  // Slot i is free for the writer at position i
+  for (uint64_t i = 0; i < num_slots; ++i) {
+    layout->sequence(i).store(i, std::memory_order_relaxed);
+  }
+  layout->complete.store(1, std::memory_order_release);
+  VLOG(1) << "Created queue " << segment << " of " << num_slots
+          << " slots of " << slot_bytes << " bytes";
+  return base;
+}
+
+} // namespace
+
+std::shared_ptr<SharedMemoryQueue> SharedMemoryQueue::Open(
+    const std::string& segment,
+    int num_slots,
+    int num_blobs,
+    size_t slot_bytes,
+    bool recreate) {
+  CheckSegmentName(segment);
+  // A process may only hold one ShmTTSetMutex_t of a given name.
+  static std::mutex local_mutex;
+  std::lock_guard<std::mutex> local_guard(local_mutex);
+  ShmTTSetMutex_t mutex((segment + ".lock").c_str());
+  while (!mutex.try_lock()) {
+    usleep(1000);
+  }
+  std::lock_guard<ShmTTSetMutex_t> guard(mutex, std::adopt_lock);
+
+  if (recreate) {
+    shm_unlink(segment.c_str());
+  }
+  void* base = nullptr;
+  size_t size = 0;
+  int fd = shm_open(segment.c_str(), O_RDWR, 0);
+  if (fd >= 0) {
+    base = MapSegment(segment, fd, &size);
+    close(fd);
+    if (!base) {
+      LOG(WARNING) << "Recreating queue " << segment
+                   << ", left incomplete by a process that died creating it";
+      shm_unlink(segment.c_str());
+    }
+  } else {
+    CAFFE_ENFORCE_EQ(
+        errno, ENOENT, "Cannot open segment ", segment, ": ", strerror(errno));
+  }
+
+  if (base) {
+    const auto* layout = static_cast<SharedMemoryQueueLayout*>(base);
+    if (num_slots > 0 &&
+        (layout->num_slots != num_slots || layout->num_blobs != num_blobs ||
+         layout->slot_bytes != AlignUp(slot_bytes, kDataAlignment))) {
+      munmap(base, size);
+      CAFFE_THROW(
+          "Queue ",
+          segment,
+          " exists with ",
+          layout->num_slots,
+          " slots of ",
+          layout->num_blobs,
+          " blobs and ",
+          layout->slot_bytes,
+          " bytes");
+    }
+  } else {
+    CAFFE_ENFORCE_GT(num_slots, 0, "Queue ", segment, " does not exist");
+    base = CreateSegment(segment, num_slots, num_blobs, slot_bytes, &size);
+  }
+  return std::shared_ptr<SharedMemoryQueue>(
+      new SharedMemoryQueue(segment, base, size));
+}
+
+bool SharedMemoryQueue::Unlink(const std::string& segment) {
+  CheckSegmentName(segment);
+  if (shm_unlink(segment.c_str()) == 0) {
+    return true;
+  }
+  CAFFE_ENFORCE_EQ(
+      errno, ENOENT, "Cannot unlink segment ", segment, ": ", strerror(errno));
+  return false;
+}
+
+SharedMemoryQueue::SharedMemoryQueue(
+    const std::string& segment,
+    void* base,
+    size_t size)
+    : segment_(segment),
+      mapping_(base, [size](void* ptr) { munmap(ptr, size); }),
+      layout_(static_cast<SharedMemoryQueueLayout*>(base)) {}
+
+SharedMemoryQueue::~SharedMemoryQueue() = default;
+
+bool SharedMemoryQueue::tryClaimWrite(uint64_t* pos) {
+  uint64_t writer = layout_->writer.load(std::memory_order_relaxed);
+  while (true) {
+    const uint64_t seq =
+        layout_->sequence(writer).load(std::memory_order_acquire);
+    if (seq == writer) {
+      if (layout_->writer.compare_exchange_weak(
+              writer, writer + 1, std::memory_order_relaxed)) {
+        *pos = writer;
+        return true;
+      }
+    } else if (seq < writer) {
+      // The slot still holds, or is still shared by the reader of, the
+      // record written a lap ago
+      return false;
+    } else {
+      writer = layout_->writer.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool SharedMemoryQueue::tryClaimRead(uint64_t* pos) {
+  uint64_t reader = layout_->reader.load(std::memory_order_relaxed);
+  while (true) {
+    const uint64_t seq =
+        layout_->sequence(reader).load(std::memory_order_acquire);
+    if (seq == reader + 1) {
+      if (layout_->reader.compare_exchange_weak(
+              reader, reader + 1, std::memory_order_relaxed)) {
+        *pos = reader;
+        return true;
+      }
+    } else if (seq < reader + 1) {
+      // The record at this position is not written yet
+      return false;
+    } else {
+      reader = layout_->reader.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool SharedMemoryQueue::Enqueue(const std::vector<const TensorCPU*>& tensors) {
+  CAFFE_ENFORCE_EQ(tensors.size(), layout_->num_blobs);
+  size_t bytes = 0;
+  for (const auto* tensor : tensors) {
+    const TensorProto::DataType data_type = TypeMetaToDataType(tensor->meta());
+    CAFFE_ENFORCE(
+        data_type != TensorProto::STRING &&
+            data_type != TensorProto::UNDEFINED,
+        "Only tensors of a fixed-size type can be queued, not ",
+        tensor->meta().name());
+    CAFFE_ENFORCE_LE(tensor->ndim(), kMaxDims);
+    bytes += AlignUp(tensor->nbytes(), kDataAlignment);
+  }
+  CAFFE_ENFORCE_LE(
+      bytes,
+      layout_->slot_bytes,
+      "The record does not fit in the slots of ",
+      segment_);
+  if (IsClosed()) {
+    return false;
+  }
+  uint64_t pos;
+  if (!WaitFor([this, &pos]() { return tryClaimWrite(&pos); }, layout_, 0)) {
+    return false;
+  }
+
+  char* slot = layout_->slot(pos);
+  auto* blobs = reinterpret_cast<BlobHeader*>(slot + sizeof(SlotHeader));
+  size_t offset = SlotDataOffset(layout_->num_blobs);
+  for (int i = 0; i < tensors.size(); ++i) {
+    const auto& tensor = *tensors[i];
+    BlobHeader& blob = blobs[i];
+    blob.data_offset = offset;
+    blob.nbytes = tensor.nbytes();
+    blob.data_type = TypeMetaToDataType(tensor.meta());
+    blob.ndim = tensor.ndim();
+    for (int d = 0; d < tensor.ndim(); ++d) {
+      blob.dims[d] = tensor.dim(d);
+    }
+    if (tensor.nbytes()) {
+      memcpy(slot + offset, tensor.raw_data(), tensor.nbytes());
+    }
+    offset += AlignUp(tensor.nbytes(), kDataAlignment);
+  }
+  layout_->sequence(pos).store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+bool SharedMemoryQueue::Dequeue(
+    const std::vector<TensorCPU*>& outputs,
+    float timeout_secs) {
+  CAFFE_ENFORCE_EQ(outputs.size(), layout_->num_blobs);
+  uint64_t pos;
+  if (!WaitFor(
+          [this, &pos]() { return tryClaimRead(&pos); },
+          layout_,
+          timeout_secs)) {
+    if (timeout_secs > 0 && !IsClosed()) {
+      LOG(ERROR) << "SharedMemoryQueueDequeue timed out in " << timeout_secs
+                 << " secs";
+    }
+    return false;
+  }
+
+  char* slot = layout_->slot(pos);
+  // The slot is freed for the writer of the next lap once the last tensor
+  // sharing it is destroyed, and the segment stays mapped until then.
+  auto* sequence = &layout_->sequence(pos);
+  const uint64_t next_lap = pos + layout_->num_slots;
+  auto mapping = mapping_;
+  std::shared_ptr<void> lease(slot, [mapping, sequence, next_lap](void*) {
+    sequence->store(next_lap, std::memory_order_release);
+  });
+  const auto* blobs =
+      reinterpret_cast<const BlobHeader*>(slot + sizeof(SlotHeader));
+  for (int i = 0; i < outputs.size(); ++i) {
+    const BlobHeader& blob = blobs[i];
+    const TypeMeta& meta =
+        DataTypeToTypeMeta(static_cast<TensorProto::DataType>(blob.data_type));
+    auto* tensor = outputs[i];
+    tensor->Resize(vector<TIndex>(blob.dims, blob.dims + blob.ndim));
+    CAFFE_ENFORCE_EQ(tensor->size() * meta.itemsize(), blob.nbytes);
+    tensor->ShareExternalPointer(
+        slot + blob.data_offset, meta, 0, [lease](void*) {});
+  }
+  return true;
+}
+
+void SharedMemoryQueue::Close() {
+  layout_->closed.store(1, std::memory_order_release);
+}
+
+bool SharedMemoryQueue::IsClosed() const {
+  return layout_->closed.load(std::memory_order_acquire);
+}
+
+int SharedMemoryQueue::num_blobs() const {
+  return layout_->num_blobs;
+}
+
+CAFFE_KNOWN_TYPE(std::shared_ptr<SharedMemoryQueue>);
+
+namespace {
+
+std::shared_ptr<SharedMemoryQueue> GetQueue(const OperatorBase& op) {
+  const auto& queue =
+      op.Inputs()[0]->Get<std::shared_ptr<SharedMemoryQueue>>();
+  CAFFE_ENFORCE(queue);
+  return queue;
+}
+
+class CreateSharedMemoryQueueOp final : public Operator<CPUContext> {
+ public:
+  CreateSharedMemoryQueueOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        segment_(GetSingleArgument<string>("segment", "")),
+        num_slots_(GetSingleArgument<int>("num_slots", 0)),
+        num_blobs_(GetSingleArgument<int>("num_blobs", 1)),
+        slot_bytes_(GetSingleArgument<int64_t>("slot_bytes", 0)),
+        recreate_(GetSingleArgument<bool>("recreate", false)) {
+    CheckSegmentName(segment_);
+  }
+
+  bool RunOnDevice() override {
+    *OperatorBase::Output<std::shared_ptr<SharedMemoryQueue>>(0) =
+        SharedMemoryQueue::Open(
+            segment_, num_slots_, num_blobs_, slot_bytes_, recreate_);
+    return true;
+  }
+
+ private:
+  string segment_;
+  int num_slots_;
+  int num_blobs_;
+  int64_t slot_bytes_;
+  bool recreate_;
+};
+
+class SharedMemoryQueueEnqueueOp final : public Operator<CPUContext> {
+ public:
+  using Operator<CPUContext>::Operator;
+
+  bool RunOnDevice() override {
+    auto queue = GetQueue(*this);
+    std::vector<const TensorCPU*> tensors;
+    for (int i = 1; i < InputSize(); ++i) {
+      tensors.push_back(&Input(i));
+    }
+    const bool enqueued = queue->Enqueue(tensors);
+    if (OutputSize() == 0) {
+      return enqueued;
+    }
+    auto* status = Output(0);
+    status->Resize();
+    *status->mutable_data<bool>() = !enqueued;
+    return true;
+  }
+};
+
+class SharedMemoryQueueDequeueOp final : public Operator<CPUContext> {
+ public:
+  SharedMemoryQueueDequeueOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        timeout_secs_(GetSingleArgument<float>("timeout_secs", 0)) {}
+
+  bool RunOnDevice() override {
+    auto queue = GetQueue(*this);
+    const int num_blobs = queue->num_blobs();
+    CAFFE_ENFORCE(
+        OutputSize() == num_blobs || OutputSize() == num_blobs + 1,
+        "Queue ",
+        queue->segment(),
+        " has records of ",
+        num_blobs,
+        " blobs");
+    std::vector<TensorCPU*> outputs;
+    for (int i = 0; i < num_blobs; ++i) {
+      outputs.push_back(Output(i));
+    }
+    const bool dequeued = queue->Dequeue(outputs, timeout_secs_);
+    if (OutputSize() == num_blobs) {
+      return dequeued;
+    }
+    auto* status = Output(num_blobs);
+    status->Resize();
+    *status->mutable_data<bool>() = !dequeued;
+    return true;
+  }
+
+ private:
+  float timeout_secs_;
+};
+
+class CloseSharedMemoryQueueOp final : public Operator<CPUContext> {
+ public:
+  CloseSharedMemoryQueueOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        unlink_(GetSingleArgument<bool>("unlink", false)) {}
+
+  bool RunOnDevice() override {
+    auto queue = GetQueue(*this);
+    queue->Close();
+    if (unlink_) {
+      SharedMemoryQueue::Unlink(queue->segment());
+    }
+    return true;
+  }
+
+ private:
+  bool unlink_;
+};
+
+} // namespace
+
+REGISTER_CPU_OPERATOR(CreateSharedMemoryQueue, CreateSharedMemoryQueueOp);
+REGISTER_CPU_OPERATOR(SharedMemoryQueueEnqueue, SharedMemoryQueueEnqueueOp);
+REGISTER_CPU_OPERATOR(SharedMemoryQueueDequeue, SharedMemoryQueueDequeueOp);
+REGISTER_CPU_OPERATOR(CloseSharedMemoryQueue, CloseSharedMemoryQueueOp);
+
+OPERATOR_SCHEMA(CreateSharedMemoryQueue)
+    .NumInputs(0)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Maps the queue of records of CPU tensors held in the POSIX shared-memory
+segment `segment`, creating it with `num_slots` slots of `slot_bytes` bytes
+for records of `num_blobs` tensors if it does not exist. The processes of a
+host that map the same segment share the queue: typically worker processes
+prepare the data and enqueue it, and a trainer dequeues it without a copy.
+With num_slots 0, the queue has to exist already.
+)DOC")
+    .Arg(
+        "segment",
+        "(string) name of the segment, a '/' followed by a name without "
+        "other '/'.")
+    .Arg("num_slots", "(int) number of records the queue holds, at least 2")
+    .Arg("num_blobs", "(int) number of tensors of a record")
+    .Arg(
+        "slot_bytes",
+        "(int) size of a slot; the tensors of a record take their size "
+        "rounded up to 64 bytes.")
+    .Arg(
+        "recreate",
+        "(bool, default false) unlink the queue first if it exists, e.g. "
+        "one left behind by a previous run.")
+    .Output(0, "queue", "The shared pointer to the SharedMemoryQueue");
+
+OPERATOR_SCHEMA(SharedMemoryQueueEnqueue)
+    .NumInputs(2, INT_MAX)
+    .NumOutputs(0, 1)
+    .SetDoc(R"DOC(
+Copies the input tensors, a record, into the next free slot of the shared
+memory queue, waiting for one. Once the queue is closed the op fails, or sets
+the status output to true if there is one.
+)DOC")
+    .Input(0, "queue", "The shared pointer to the SharedMemoryQueue")
+    .Output(0, "status", "(optional) true if the queue is closed");
+
+OPERATOR_SCHEMA(SharedMemoryQueueDequeue)
+    .NumInputs(1)
+    .NumOutputs(1, INT_MAX)
+    .SetDoc(R"DOC(
+Dequeues the next record of the shared memory queue into the output tensors,
+which share the memory of its slot instead of copying it. The slot is given
+back to the writers once the outputs are destroyed or changed, e.g. when the
+next record is dequeued into them, so they should be consumed before that.
+Once the queue is closed and empty, or on timeout, the op fails, or sets the
+status output to true if there is one.
+)DOC")
+    .Arg(
+        "timeout_secs",
+        "(float, default 0) seconds to wait for a record, 0 waits forever")
+    .Input(0, "queue", "The shared pointer to the SharedMemoryQueue")
+    .Output(0, "blob", "The tensors of the record")
+    .Output(
+        1,
+        "status",
+        "(optional) after the tensors, true if no record was dequeued");
+
+OPERATOR_SCHEMA(CloseSharedMemoryQueue)
+    .NumInputs(1)
+    .NumOutputs(0)
+    .SetDoc(R"DOC(
+Closes the shared memory queue for all the processes mapping it: the pending
+and later enqueues fail, and so do the dequeues once the queue is empty.
+)DOC")
+    .Arg(
+        "unlink",
+        "(bool, default false) also remove the segment, which is freed once "
+        "no process maps it anymore.")
+    .Input(0, "queue", "The shared pointer to the SharedMemoryQueue");
+
+SHOULD_NOT_DO_GRADIENT(CreateSharedMemoryQueue);
+SHOULD_NOT_DO_GRADIENT(SharedMemoryQueueEnqueue);
+SHOULD_NOT_DO_GRADIENT(SharedMemoryQueueDequeue);
+SHOULD_NOT_DO_GRADIENT(CloseSharedMemoryQueue);
+
+} // namespace caffe2
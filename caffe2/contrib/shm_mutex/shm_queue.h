@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A queue of records of CPU tensors between the processes of a host, held in
+ * a named POSIX shared-memory segment, so that data can be prepared by worker
+ * processes and read by a trainer without going through the GIL or a
+ * serialization.
+ *
+ * The segment is a ring of num_slots slots of slot_bytes bytes each. A
+ * writer copies the tensors of a record into a free slot; a reader shares
+ * the tensors of the next ready slot, without copying them, and the slot is
+ * only given back to the writers once all of them are destroyed (typically
+ * when the next record is dequeued into the same blobs). The slots are
+ * claimed with per slot sequence numbers as in LockFreeBlobsQueue, and the
+ * creation of the segment is serialized by a ShmTTSetMutex_t named after it.
+ *
+ * A process that dies while writing or reading a slot leaves it claimed,
+ * which stalls the queue at that slot; the queue has to be closed and
+ * recreated then.
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "caffe2/core/tensor.h"
+
+namespace caffe2 {
+
+struct SharedMemoryQueueLayout;
+
+class SharedMemoryQueue {
+ public:
+  // Maps the queue segment, creating it if it does not exist. An existing
+  // queue has to have the same shape, unless num_slots is 0, in which case
+  // it is only opened. With recreate, an existing queue is unlinked first.
+  static std::shared_ptr<SharedMemoryQueue> Open(
+      const std::string& segment,
+      int num_slots,
+      int num_blobs,
+      size_t slot_bytes,
+      bool recreate = false);
+
+  // Removes the segment, which is freed once no process maps it anymore.
+  // Returns false if it did not exist.
+  static bool Unlink(const std::string& segment);
+
+  ~SharedMemoryQueue();
+
+  // Copies the tensors of a record into the next free slot, waiting for one.
+  // Returns false if the queue is closed.
+  bool Enqueue(const std::vector<const TensorCPU*>& tensors);
+
+  // Shares the tensors of the next record into outputs, waiting for one for
+  // at most timeout_secs (0 waits forever). Returns false if the queue is
+  // closed and empty, or on timeout.
+  bool Dequeue(const std::vector<TensorCPU*>& outputs, float timeout_secs = 0);
+
+  // Wakes up and fails the pending and later Enqueue calls of all processes,
+  // and the Dequeue calls once the ready records are read.
+  void Close();
+  bool IsClosed() const;
+
+  int num_blobs() const;
+  const std::string& segment() const {
+    return segment_;
+  }
+
+ private:
+  SharedMemoryQueue(const std::string& segment, void* base, size_t size);
+
+  bool tryClaimWrite(uint64_t* pos);
+  bool tryClaimRead(uint64_t* pos);
+
+  std::string segment_;
+  // Unmaps the segment once the queue and the tensors sharing its slots are
+  // destroyed.
+  std::shared_ptr<void> mapping_;
+  SharedMemoryQueueLayout* layout_;
+};
+
+} // namespace caffe2
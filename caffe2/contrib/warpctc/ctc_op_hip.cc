@@ -0,0 +1,422 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/operator.h"
+#include "hip/hip_runtime.h"
+#include <hipcub/hipcub.hpp>
+
+namespace caffe2 {
+
+namespace {
+
+// A native HIP implementation of the CTC loss of warp-ctc, computing the
+// forward (alpha) and backward (beta) variables in log space. Label 0 is the
+// blank, and the extended label sequence of a label sequence l of length L
+// interleaves S = 2L + 1 blanks and labels.
+constexpr int kBlank = 0;
+
+__device__ float LogAdd(float a, float b)
+{
+    if(a == -INFINITY)
+    {
+        return b;
+    }
+    if(b == -INFINITY)
+    {
+        return a;
+    }
+    return fmaxf(a, b) + log1pf(expf(-fabsf(a - b)));
+}
+
+__device__ int ExtendedLabel(const int* labels, int s)
+{
+    return s % 2 ? labels[s / 2] : kBlank;
+}
+
+// One block per (t, n): log-softmax of the activations of a step, and the
+// softmax the gradient starts from. Steps past the input length get no
+// gradient.
+__global__ void CTCLogSoftmaxKernel(const int N,
+                                    const int A,
+                                    const int* input_lengths,
+                                    const float* acts,
+                                    float* log_probs,
+                                    float* grads)
+{
+    typedef hipcub::BlockReduce<float, CAFFE_HIP_NUM_THREADS> BlockReduce;
+    __shared__ typename BlockReduce::TempStorage temp_storage;
+    __shared__ float max_val;
+    __shared__ float log_sum;
+
+    const int t    = blockIdx.x / N;
+    const int n    = blockIdx.x % N;
+    const int base = blockIdx.x * A;
+    if(t >= input_lengths[n])
+    {
+        for(int k = threadIdx.x; k < A; k += blockDim.x)
+        {
+            grads[base + k] = 0;
+        }
+        return;
+    }
+
+    float thread_max = -INFINITY;
+    for(int k = threadIdx.x; k < A; k += blockDim.x)
+    {
+        thread_max = fmaxf(thread_max, acts[base + k]);
+    }
+    const float block_max = BlockReduce(temp_storage).Reduce(thread_max, hipcub::Max());
+    if(threadIdx.x == 0)
+    {
+        max_val = block_max;
+    }
+    __syncthreads();
+
+    float thread_sum = 0;
+    for(int k = threadIdx.x; k < A; k += blockDim.x)
+    {
+        thread_sum += expf(acts[base + k] - max_val);
+    }
+    const float block_sum = BlockReduce(temp_storage).Sum(thread_sum);
+    if(threadIdx.x == 0)
+    {
+        log_sum = logf(block_sum);
+    }
+    __syncthreads();
+
+    for(int k = threadIdx.x; k < A; k += blockDim.x)
+    {
+        const float lp     = acts[base + k] - max_val - log_sum;
+        log_probs[base + k] = lp;
+        grads[base + k]     = expf(lp);
+    }
+}
+
+// One block per sequence, the threads of the block sharing the S positions
+// of the extended labels for every step in turn.
+__global__ void CTCAlphaKernel(const int N,
+                               const int A,
+                               const int max_t,
+                               const int max_s,
+                               const int* input_lengths,
+                               const int* label_lengths,
+                               const int* label_offsets,
+                               const int* all_labels,
+                               const float* log_probs,
+                               float* alphas,
+                               float* log_likelihoods)
+{
+    const int n      = blockIdx.x;
+    const int T      = input_lengths[n];
+    const int S      = 2 * label_lengths[n] + 1;
+    const int* label = all_labels + label_offsets[n];
+    float* alpha     = alphas + n * max_t * max_s;
+    if(T == 0)
+    {
+        if(threadIdx.x == 0)
+        {
+            log_likelihoods[n] = S == 1 ? 0 : -INFINITY;
+        }
+        return;
+    }
+
+    for(int s = threadIdx.x; s < S; s += blockDim.x)
+    {
+        alpha[s] = s < 2 ? log_probs[n * A + ExtendedLabel(label, s)] : -INFINITY;
+    }
+    __syncthreads();
+    for(int t = 1; t < T; ++t)
+    {
+        const float* prev = alpha + (t - 1) * max_s;
+        float* cur        = alpha + t * max_s;
+        const float* lp   = log_probs + (t * N + n) * A;
+        for(int s = threadIdx.x; s < S; s += blockDim.x)
+        {
+            float a = prev[s];
+            if(s > 0)
+            {
+                a = LogAdd(a, prev[s - 1]);
+            }
+            if(s > 1 && s % 2 && label[s / 2] != label[s / 2 - 1])
+            {
+                a = LogAdd(a, prev[s - 2]);
+            }
+            cur[s] = a + lp[ExtendedLabel(label, s)];
+        }
+        __syncthreads();
+    }
+
+    if(threadIdx.x == 0)
+    {
+        const float* last  = alpha + (T - 1) * max_s;
+        log_likelihoods[n] = S > 1 ? LogAdd(last[S - 1], last[S - 2]) : last[0];
+    }
+}
+
+__global__ void CTCBetaKernel(const int N,
+                              const int A,
+                              const int max_t,
+                              const int max_s,
+                              const int* input_lengths,
+                              const int* label_lengths,
+                              const int* label_offsets,
+                              const int* all_labels,
+                              const float* log_probs,
+                              float* betas)
+{
+    const int n      = blockIdx.x;
+    const int T      = input_lengths[n];
+    const int S      = 2 * label_lengths[n] + 1;
+    const int* label = all_labels + label_offsets[n];
+    float* beta      = betas + n * max_t * max_s;
+    if(T == 0)
+    {
+        return;
+    }
+
+    float* last           = beta + (T - 1) * max_s;
+    const float* last_lp = log_probs + ((T - 1) * N + n) * A;
+    for(int s = threadIdx.x; s < S; s += blockDim.x)
+    {
+        last[s] = s >= S - 2 ? last_lp[ExtendedLabel(label, s)] : -INFINITY;
+    }
+    __syncthreads();
+    for(int t = T - 2; t >= 0; --t)
+    {
+        const float* next = beta + (t + 1) * max_s;
+        float* cur        = beta + t * max_s;
+        const float* lp   = log_probs + (t * N + n) * A;
+        for(int s = threadIdx.x; s < S; s += blockDim.x)
+        {
+            float b = next[s];
+            if(s < S - 1)
+            {
+                b = LogAdd(b, next[s + 1]);
+            }
+            if(s < S - 2 && s % 2 && label[s / 2] != label[s / 2 + 1])
+            {
+                b = LogAdd(b, next[s + 2]);
+            }
+            cur[s] = b + lp[ExtendedLabel(label, s)];
+        }
+        __syncthreads();
+    }
+}
+
+// One block per (t, n): subtracts the posterior of every label, summed over
+// the positions of the extended labels it appears at, from the softmax.
+__global__ void CTCGradientKernel(const int N,
+                                  const int A,
+                                  const int max_t,
+                                  const int max_s,
+                                  const int* input_lengths,
+                                  const int* label_lengths,
+                                  const int* label_offsets,
+                                  const int* all_labels,
+                                  const float* log_probs,
+                                  const float* alphas,
+                                  const float* betas,
+                                  const float* log_likelihoods,
+                                  float* grads)
+{
+    const int t        = blockIdx.x / N;
+    const int n        = blockIdx.x % N;
+    const float log_ll = log_likelihoods[n];
+    if(t >= input_lengths[n] || log_ll == -INFINITY)
+    {
+        return;
+    }
+    const int S        = 2 * label_lengths[n] + 1;
+    const int* label   = all_labels + label_offsets[n];
+    const float* alpha = alphas + (n * max_t + t) * max_s;
+    const float* beta  = betas + (n * max_t + t) * max_s;
+    const float* lp    = log_probs + blockIdx.x * A;
+    float* grad        = grads + blockIdx.x * A;
+    for(int s = threadIdx.x; s < S; s += blockDim.x)
+    {
+        const int k = ExtendedLabel(label, s);
+        atomicAdd(grad + k, -expf(alpha[s] + beta[s] - lp[k] - log_ll));
+    }
+}
+
+class HIPCTCOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPCTCOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        const auto& inputs = Input(INPUTS);
+        CAFFE_ENFORCE_EQ(inputs.ndim(), 3, "INPUTS should be [T, N, A]");
+        const int max_t     = inputs.dim32(0);
+        const int minibatch = inputs.dim32(1);
+        const int alphabet  = inputs.dim32(2);
+        const auto& labels  = OperatorBase::Input<TensorCPU>(LABELS);
+        const auto& label_lengths =
+            OperatorBase::Input<TensorCPU>(LABEL_LENGTHS);
+        const auto& input_lengths =
+            OperatorBase::Input<TensorCPU>(INPUT_LENGTHS);
+        CAFFE_ENFORCE_EQ(label_lengths.size(), minibatch);
+        CAFFE_ENFORCE_EQ(input_lengths.size(), minibatch);
+
+        // The lengths, the offsets of the labels of every sequence and the
+        // labels are sent to the device in one copy.
+        host_ints_.Resize(3 * minibatch + labels.size());
+        int* ints          = host_ints_.mutable_data<int>();
+        int total_labels   = 0;
+        int max_label_size = 0;
+        for(int n = 0; n < minibatch; ++n)
+        {
+            const int input_length = input_lengths.data<int>()[n];
+            const int label_length = label_lengths.data<int>()[n];
+            CAFFE_ENFORCE(input_length >= 0 && input_length <= max_t,
+                          "Invalid input length ",
+                          input_length);
+            CAFFE_ENFORCE_GE(label_length, 0);
+            ints[n]                 = input_length;
+            ints[minibatch + n]     = label_length;
+            ints[2 * minibatch + n] = total_labels;
+            total_labels += label_length;
+            max_label_size = std::max(max_label_size, label_length);
+        }
+        CAFFE_ENFORCE_EQ(total_labels, labels.size());
+        std::copy(labels.data<int>(),
+                  labels.data<int>() + labels.size(),
+                  ints + 3 * minibatch);
+        const int max_s = 2 * max_label_size + 1;
+
+        auto* costs = OperatorBase::Output<TensorCPU>(COSTS);
+        costs->ResizeLike(label_lengths);
+        auto* gradients = Output(GRADIENTS);
+        gradients->ResizeLike(inputs);
+        if(inputs.size() == 0)
+        {
+            std::fill(costs->mutable_data<float>(),
+                      costs->mutable_data<float>() + costs->size(),
+                      0.0f);
+            return true;
+        }
+
+        const size_t log_probs_size = inputs.size();
+        const size_t variables_size = size_t(minibatch) * max_t * max_s;
+        auto* workspace             = Output(WORKSPACE);
+        workspace->Resize((log_probs_size + 2 * variables_size + minibatch) * sizeof(float) +
+                          host_ints_.nbytes());
+        float* log_probs       = reinterpret_cast<float*>(workspace->mutable_data<uint8_t>());
+        float* alphas          = log_probs + log_probs_size;
+        float* betas           = alphas + variables_size;
+        float* log_likelihoods = betas + variables_size;
+        int* device_ints       = reinterpret_cast<int*>(log_likelihoods + minibatch);
+        context_.CopyBytes<CPUContext, HIPContext>(
+            host_ints_.nbytes(), host_ints_.raw_data(), device_ints);
+        const int* device_input_lengths = device_ints;
+        const int* device_label_lengths = device_ints + minibatch;
+        const int* device_label_offsets = device_ints + 2 * minibatch;
+        const int* device_labels        = device_ints + 3 * minibatch;
+
+        hipLaunchKernelGGL((CTCLogSoftmaxKernel),
+                           dim3(max_t * minibatch),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           minibatch,
+                           alphabet,
+                           device_input_lengths,
+                           inputs.data<float>(),
+                           log_probs,
+                           gradients->mutable_data<float>());
+        hipLaunchKernelGGL((CTCAlphaKernel),
+                           dim3(minibatch),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           minibatch,
+                           alphabet,
+                           max_t,
+                           max_s,
+                           device_input_lengths,
+                           device_label_lengths,
+                           device_label_offsets,
+                           device_labels,
+                           log_probs,
+                           alphas,
+                           log_likelihoods);
+        hipLaunchKernelGGL((CTCBetaKernel),
+                           dim3(minibatch),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           minibatch,
+                           alphabet,
+                           max_t,
+                           max_s,
+                           device_input_lengths,
+                           device_label_lengths,
+                           device_label_offsets,
+                           device_labels,
+                           log_probs,
+                           betas);
+        hipLaunchKernelGGL((CTCGradientKernel),
+                           dim3(max_t * minibatch),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           minibatch,
+                           alphabet,
+                           max_t,
+                           max_s,
+                           device_input_lengths,
+                           device_label_lengths,
+                           device_label_offsets,
+                           device_labels,
+                           log_probs,
+                           alphas,
+                           betas,
+                           log_likelihoods,
+                           gradients->mutable_data<float>());
+
+        // The costs are on the CPU, as with warp-ctc.
+        float* cost_data = costs->mutable_data<float>();
+        context_.CopyBytes<HIPContext, CPUContext>(
+            minibatch * sizeof(float), log_likelihoods, cost_data);
+        context_.FinishDeviceComputation();
+        for(int n = 0; n < minibatch; ++n)
+        {
+            cost_data[n] = -cost_data[n];
+        }
+        return true;
+    }
+
+    private:
+    TensorCPU host_ints_;
+
+    INPUT_TAGS(INPUTS, LABELS, LABEL_LENGTHS, INPUT_LENGTHS);
+    OUTPUT_TAGS(GRADIENTS, COSTS, WORKSPACE);
+};
+
+} // namespace
+
+REGISTER_HIP_OPERATOR(CTC, HIPCTCOp);
+} // namespace caffe2
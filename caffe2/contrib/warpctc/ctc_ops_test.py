@@ -18,6 +18,7 @@ from __future__ import division
 from __future__ import print_function
 
 import numpy as np
+import unittest
 from caffe2.proto import caffe2_pb2
 
 from caffe2.python import core, workspace, dyndep, test_util
@@ -82,3 +83,9 @@ class CTCOpsTest(test_util.TestCase):
         self.verify_cost(
             caffe2_pb2.DeviceOption(device_type=caffe2_pb2.CUDA,
                                     cuda_gpu_id=0))
+
+    @unittest.skipIf(not workspace.has_hip, "No HIP support")
+    def test_ctc_cost_hip(self):
+        self.verify_cost(
+            caffe2_pb2.DeviceOption(device_type=caffe2_pb2.HIP,
+                                    hip_gpu_id=0))
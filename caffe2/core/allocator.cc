@@ -14,7 +14,17 @@
  * limitations under the License.
  */
 
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #include "caffe2/core/context.h"
+#include "caffe2/core/init.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/core/tensor.h"
 #include "caffe2/core/typeid.h"
@@ -26,9 +36,26 @@ CAFFE2_DEFINE_bool(
 
 CAFFE2_DEFINE_bool(
     caffe2_cpu_allocator_do_zero_fill,
-    true,
+    false,
     "If set, do memory zerofilling when allocating on CPU");
 
+CAFFE2_DEFINE_string(
+    caffe2_cpu_allocator,
+    "",
+    "Name of the registered CPU allocator to use, e.g. Caching. Empty keeps "
+    "the default one.");
+
+CAFFE2_DEFINE_int64(
+    caffe2_cpu_allocator_thread_cache_bytes,
+    64 << 20,
+    "Max number of bytes each thread keeps cached in CachingCPUAllocator");
+
+CAFFE2_DEFINE_int64(
+    caffe2_cpu_allocator_huge_page_bytes,
+    2 << 20,
+    "CachingCPUAllocator blocks of at least this size are mmapped and backed "
+    "by transparent huge pages (Linux only, 0 disables)");
+
 namespace caffe2 {
 
 void NoDelete(void*) {}
@@ -42,6 +69,228 @@ void SetCPUAllocator(CPUAllocator* alloc) {
   g_cpu_allocator.reset(alloc);
 }
 
+static std::atomic<MemoryAllocationObserver*> g_memory_allocation_observer(
+    nullptr);
+MemoryAllocationObserver* GetMemoryAllocationObserver() {
+  return g_memory_allocation_observer.load(std::memory_order_acquire);
+}
+
+void SetMemoryAllocationObserver(MemoryAllocationObserver* observer) {
+  g_memory_allocation_observer.store(observer, std::memory_order_release);
+}
+
+CAFFE_DEFINE_REGISTRY(CPUAllocatorRegistry, CPUAllocator);
+REGISTER_CPU_ALLOCATOR(Default, DefaultCPUAllocator);
+REGISTER_CPU_ALLOCATOR(Caching, CachingCPUAllocator);
+
+namespace {
+
+bool Caffe2SetCPUAllocator(int*, char***) {
+  if (FLAGS_caffe2_cpu_allocator.empty()) {
+    return true;
+  }
+  auto alloc = CPUAllocatorRegistry()->Create(FLAGS_caffe2_cpu_allocator);
+  if (!alloc) {
+    LOG(ERROR) << "Unknown CPU allocator: " << FLAGS_caffe2_cpu_allocator;
+    return false;
+  }
+  VLOG(1) << "Setting CPUAllocator to " << FLAGS_caffe2_cpu_allocator;
+  SetCPUAllocator(alloc.release());
+  return true;
+}
+
+// Every block of CachingCPUAllocator starts with this header, and the data
+// follows it at gCaffe2Alignment.
+struct BlockHeader {
+  // -1 for blocks that are too large to be cached.
+  int size_class;
+  bool mmapped;
+  // Bytes obtained from the system, header included.
+  size_t block_bytes;
+};
+static_assert(
+    sizeof(BlockHeader) <= gCaffe2Alignment,
+    "BlockHeader must fit in the alignment padding");
+
+// Classes go 64, 80, 96, 112, 128, 160, ... bytes; 4 * 56 of them cover any
+// size_t that can actually be allocated.
+constexpr int kNumSizeClasses = 4 * 56;
+
+inline BlockHeader* HeaderOf(void* data) {
+  return reinterpret_cast<BlockHeader*>(
+      static_cast<char*>(data) - gCaffe2Alignment);
+}
+
+void* SystemAlloc(size_t nbytes, bool* mmapped) {
+  void* block = nullptr;
+#if defined(__linux__)
+  if (FLAGS_caffe2_cpu_allocator_huge_page_bytes > 0 &&
+      nbytes >=
+          static_cast<size_t>(FLAGS_caffe2_cpu_allocator_huge_page_bytes)) {
+    block = mmap(
+        nullptr,
+        nbytes,
+        PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS,
+        -1,
+        0);
+    CAFFE_ENFORCE(block != MAP_FAILED, "mmap failed, errno: ", errno);
+#ifdef MADV_HUGEPAGE
+    // Only a hint: fails if transparent huge pages are disabled.
+    madvise(block, nbytes, MADV_HUGEPAGE);
+#endif
+    *mmapped = true;
+    return block;
+  }
+#endif
+#ifdef __ANDROID__
+  block = memalign(gCaffe2Alignment, nbytes);
+#elif defined(_MSC_VER)
+  block = _aligned_malloc(nbytes, gCaffe2Alignment);
+#else
+  CAFFE_ENFORCE_EQ(posix_memalign(&block, gCaffe2Alignment, nbytes), 0);
+#endif
+  CAFFE_ENFORCE(block);
+  *mmapped = false;
+  return block;
+}
+
+void SystemFree(BlockHeader* header) {
+#if defined(__linux__)
+  if (header->mmapped) {
+    munmap(header, header->block_bytes);
+    return;
+  }
+#endif
+#ifdef _MSC_VER
+  _aligned_free(header);
+#else
+  free(header);
+#endif
+}
+
+// Set once the cache of the thread is destroyed, so that blocks freed later
+// during thread or static teardown go back to the system.
+thread_local bool tls_cache_destroyed = false;
+
+class ThreadCache {
+ public:
+  ThreadCache() : free_lists_(kNumSizeClasses), cached_bytes_(0) {}
+
+  ~ThreadCache() {
+    for (auto& free_list : free_lists_) {
+      for (auto* header : free_list) {
+        SystemFree(header);
+      }
+    }
+    tls_cache_destroyed = true;
+  }
+
+  BlockHeader* Pop(int size_class) {
+    auto& free_list = free_lists_[size_class];
+    if (free_list.empty()) {
+      return nullptr;
+    }
+    auto* header = free_list.back();
+    free_list.pop_back();
+    cached_bytes_ -= header->block_bytes;
+    return header;
+  }
+
+  bool Push(BlockHeader* header) {
+    if (cached_bytes_ + header->block_bytes >
+        static_cast<size_t>(FLAGS_caffe2_cpu_allocator_thread_cache_bytes)) {
+      return false;
+    }
+    free_lists_[header->size_class].push_back(header);
+    cached_bytes_ += header->block_bytes;
+    return true;
+  }
+
+ private:
+  std::vector<std::vector<BlockHeader*>> free_lists_;
+  size_t cached_bytes_;
+};
+
+ThreadCache* GetThreadCache() {
+  if (tls_cache_destroyed) {
+    return nullptr;
+  }
+  static thread_local ThreadCache cache;
+  return &cache;
+}
+
+} // namespace
+
+REGISTER_CAFFE2_INIT_FUNCTION(
+    Caffe2SetCPUAllocator,
+    &Caffe2SetCPUAllocator,
+    "Set the CPU allocator from --caffe2_cpu_allocator.");
+
+size_t CachingCPUAllocator::SizeClassBytes(int size_class) {
+  return static_cast<size_t>(4 + size_class % 4) << (size_class / 4 + 4);
+}
+
+int CachingCPUAllocator::SizeClass(size_t nbytes) {
+  if (nbytes <= 64) {
+    return 0;
+  }
+  // nbytes is in (2^b, 2^(b+1)], split in four classes of 2^(b-2) bytes.
+  int b = 0;
+  for (size_t m = nbytes - 1; m > 1; m >>= 1) {
+    ++b;
+  }
+  const int shift = b - 2;
+  const size_t quarters = (nbytes + (size_t(1) << shift) - 1) >> shift;
+  return 4 * (b - 6) + static_cast<int>(quarters - 4);
+}
+
+std::pair<void*, MemoryDeleter> CachingCPUAllocator::New(size_t nbytes) {
+  const size_t total = nbytes + gCaffe2Alignment;
+  int size_class = SizeClass(total);
+  if (size_class >= kNumSizeClasses ||
+      SizeClassBytes(size_class) >
+          static_cast<size_t>(FLAGS_caffe2_cpu_allocator_thread_cache_bytes)) {
+    size_class = -1;
+  }
+  BlockHeader* header = nullptr;
+  if (size_class >= 0) {
+    auto* cache = GetThreadCache();
+    if (cache) {
+      header = cache->Pop(size_class);
+    }
+  }
+  if (!header) {
+    const size_t block_bytes =
+        size_class >= 0 ? SizeClassBytes(size_class) : total;
+    bool mmapped = false;
+    header = static_cast<BlockHeader*>(SystemAlloc(block_bytes, &mmapped));
+    header->size_class = size_class;
+    header->mmapped = mmapped;
+    header->block_bytes = block_bytes;
+    NUMAMove(header, block_bytes, GetCurrentNUMANode());
+  }
+  void* data = reinterpret_cast<char*>(header) + gCaffe2Alignment;
+  if (FLAGS_caffe2_cpu_allocator_do_zero_fill) {
+    memset(data, 0, nbytes);
+  }
+  return {data, Delete};
+}
+
+void CachingCPUAllocator::Delete(void* data) {
+  if (!data) {
+    return;
+  }
+  auto* header = HeaderOf(data);
+  if (header->size_class >= 0) {
+    auto* cache = GetThreadCache();
+    if (cache && cache->Push(header)) {
+      return;
+    }
+  }
+  SystemFree(header);
+}
+
 MemoryAllocationReporter CPUContext::reporter_;
 
 void MemoryAllocationReporter::New(void* ptr, size_t nbytes) {
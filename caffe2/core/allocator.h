@@ -20,9 +20,14 @@
 #include <unordered_map>
 
 #include "caffe2/core/logging.h"
+#include "caffe2/core/numa.h"
+#include "caffe2/core/registry.h"
 
 CAFFE2_DECLARE_bool(caffe2_report_cpu_memory_usage);
 CAFFE2_DECLARE_bool(caffe2_cpu_allocator_do_zero_fill);
+CAFFE2_DECLARE_string(caffe2_cpu_allocator);
+CAFFE2_DECLARE_int64(caffe2_cpu_allocator_thread_cache_bytes);
+CAFFE2_DECLARE_int64(caffe2_cpu_allocator_huge_page_bytes);
 
 namespace caffe2 {
 
@@ -69,6 +74,9 @@ struct DefaultCPUAllocator final : CPUAllocator {
     CAFFE_ENFORCE_EQ(posix_memalign(&data, gCaffe2Alignment, nbytes), 0);
 #endif
     CAFFE_ENFORCE(data);
+    // Move the pages to the node of the allocating thread before they are
+    // touched; does nothing unless NUMA is enabled.
+    NUMAMove(data, nbytes, GetCurrentNUMANode());
     if (FLAGS_caffe2_cpu_allocator_do_zero_fill) {
       memset(data, 0, nbytes);
     }
@@ -90,6 +98,54 @@ struct DefaultCPUAllocator final : CPUAllocator {
   }
 };
 
+// An allocator that keeps freed blocks in thread-local caches, one free list
+// per size class (four classes per power of two), so that steady-state
+// allocations do not go to the system. Each thread caches up to
+// caffe2_cpu_allocator_thread_cache_bytes; blocks of at least
+// caffe2_cpu_allocator_huge_page_bytes are mmapped and backed by transparent
+// huge pages where available. A freed block goes to the cache of the thread
+// freeing it.
+struct CachingCPUAllocator final : CPUAllocator {
+  CachingCPUAllocator() {}
+  ~CachingCPUAllocator() override {}
+  std::pair<void*, MemoryDeleter> New(size_t nbytes) override;
+
+  static void Delete(void* data);
+
+  MemoryDeleter GetDeleter() override {
+    return Delete;
+  }
+
+  // Size of the largest block of the given size class, and the class that
+  // holds nbytes.
+  static size_t SizeClassBytes(int size_class);
+  static int SizeClass(size_t nbytes);
+};
+
+// Hook that CPUContext::New and HIPContext::New report every allocation and
+// every free to, when one is installed. device is -1 for CPU memory and the
+// gpu id otherwise. Frees of memory allocated before the hook was installed
+// are reported as well. See observers/memory_observer.h.
+class MemoryAllocationObserver {
+ public:
+  virtual ~MemoryAllocationObserver() noexcept {}
+  virtual void OnNew(void* ptr, size_t nbytes, int device) = 0;
+  virtual void OnDelete(void* ptr) = 0;
+};
+
+// Returns the installed hook, or nullptr.
+MemoryAllocationObserver* GetMemoryAllocationObserver();
+// Installs the hook, or removes it with nullptr. The caller keeps the
+// ownership and must not destroy it while allocations are still reported to
+// it from other threads.
+void SetMemoryAllocationObserver(MemoryAllocationObserver* observer);
+
+// CPU allocators that can be selected by name with --caffe2_cpu_allocator.
+// "Default" and "Caching" are registered by default.
+CAFFE_DECLARE_REGISTRY(CPUAllocatorRegistry, CPUAllocator);
+#define REGISTER_CPU_ALLOCATOR(name, ...) \
+  CAFFE_REGISTER_CLASS(CPUAllocatorRegistry, name, __VA_ARGS__)
+
 // Get the CPU Alloctor.
 CPUAllocator* GetCPUAllocator();
 // Sets the CPU allocator to the given allocator: the caller gives away the
@@ -37,6 +37,13 @@ CAFFE2_DEFINE_bool(
     false,
     "Serialize FLOAT16 tensors using byte_data field");
 
+CAFFE2_DEFINE_bool(
+    caffe2_serialize_as_raw_bytes,
+    false,
+    "Serialize tensors of all fixed-size types as raw bytes in the byte_data "
+    "field, which is much faster to load than the typed repeated fields. "
+    "Older versions can only load FLOAT16 tensors written this way.");
+
 namespace caffe2 {
 /**
  * @brief StringSerializer is the serializer for String.
@@ -32,6 +32,7 @@
 CAFFE2_DECLARE_int(caffe2_tensor_chunk_size);
 CAFFE2_DECLARE_int(caffe2_max_tensor_serializer_threads);
 CAFFE2_DECLARE_bool(caffe2_serialize_fp16_as_bytes);
+CAFFE2_DECLARE_bool(caffe2_serialize_as_raw_bytes);
 
 namespace caffe2 {
 
@@ -164,6 +165,51 @@ inline void CopyToProtoWithCast(
   }
 }
 
+// Tensors of a fixed-size type can be stored as their raw little endian bytes
+// in byte_data, which (de)serializes with one copy instead of an encoding of
+// every element in a repeated field.
+inline bool HasRawBytesEncoding(TensorProto::DataType data_type) {
+  return data_type != TensorProto_DataType_STRING &&
+      data_type != TensorProto_DataType_UNDEFINED &&
+      data_type != TensorProto_DataType_BYTE;
+}
+
+inline void EnforceLittleEndian() {
+  const int kValue = 1;
+  CAFFE_ENFORCE_EQ(
+      reinterpret_cast<const char*>(&kValue)[0],
+      1,
+      "Serialization of raw bytes on big endian platform is not written yet.");
+}
+
+template <class Context>
+inline void CopyToProtoAsBytes(
+    const size_t nbytes,
+    const void* src,
+    TensorProto* proto,
+    Context* context) {
+  EnforceLittleEndian();
+  string* bytes = proto->mutable_byte_data();
+  bytes->resize(nbytes);
+  if (nbytes) {
+    context->template Copy<char, Context, CPUContext>(
+        nbytes, static_cast<const char*>(src), &(*bytes)[0]);
+  }
+  context->FinishDeviceComputation();
+}
+
+template <class Context>
+inline void CopyFromProtoAsBytes(
+    const size_t nbytes,
+    const string& bytes,
+    void* dst,
+    Context* context) {
+  EnforceLittleEndian();
+  CAFFE_ENFORCE_EQ(nbytes, bytes.size(), "Incorrect proto field size.");
+  context->template Copy<char, CPUContext, Context>(
+      nbytes, bytes.data(), static_cast<char*>(dst));
+}
+
 template <typename SrcType, typename DstType, class Context>
 inline void CopyFromProtoAsIs(
     const size_t size,
@@ -313,6 +359,17 @@ void TensorSerializer<Context>::Serialize(
   proto.set_data_type(data_type);
   StoreDeviceDetail(input, &proto);
 
+  if (FLAGS_caffe2_serialize_as_raw_bytes &&
+      detail::HasRawBytesEncoding(data_type)) {
+    detail::CopyToProtoAsBytes(
+        chunkSize * input.itemsize(),
+        static_cast<const char*>(input.raw_data()) +
+            chunkBegin * input.itemsize(),
+        &proto,
+        &this->context_);
+    return;
+  }
+
   // A lot of copypaste is error prone. Should we create a macro for this?
   switch (data_type) {
   case TensorProto_DataType_FLOAT:
@@ -386,20 +443,11 @@ void TensorSerializer<Context>::Serialize(
     break;
   case TensorProto_DataType_FLOAT16: {
     if (FLAGS_caffe2_serialize_fp16_as_bytes) {
-      const int kValue = 1;
-      CAFFE_ENFORCE_EQ(
-          reinterpret_cast<const char*>(&kValue)[0],
-          1,
-          "Serialization of FLOAT16 on big endian platform "
-          "is not written yet.");
-      unique_ptr<char[]> buffer(new char[2 * chunkSize]);
-      this->context_.template Copy<char, Context, CPUContext>(
+      detail::CopyToProtoAsBytes(
           2 * chunkSize,
-          reinterpret_cast<const char*>(
-              input.template data<float16>() + chunkBegin),
-          buffer.get());
-      this->context_.FinishDeviceComputation();
-      proto.set_byte_data(buffer.release(), 2 * chunkSize);
+          input.template data<float16>() + chunkBegin,
+          &proto,
+          &this->context_);
     } else {
       detail::CopyToProtoWithCast(
           chunkSize,
@@ -468,6 +516,19 @@ void TensorDeserializer<Context>::Deserialize(
       tensor->size());
   auto chunkSize = chunkEnd - chunkBegin;
 
+  // Any fixed-size type may have been stored as raw bytes.
+  if (proto.has_byte_data() && detail::HasRawBytesEncoding(proto.data_type())) {
+    const TypeMeta& meta = DataTypeToTypeMeta(proto.data_type());
+    detail::CopyFromProtoAsBytes(
+        chunkSize * meta.itemsize(),
+        proto.byte_data(),
+        static_cast<char*>(tensor->raw_mutable_data(meta)) +
+            chunkBegin * meta.itemsize(),
+        &context);
+    context.FinishDeviceComputation();
+    return;
+  }
+
   switch (proto.data_type()) {
     case TensorProto_DataType_FLOAT:
       detail::CopyFromProtoAsIs(
@@ -545,31 +606,15 @@ void TensorDeserializer<Context>::Deserialize(
           &context);
       break;
     case TensorProto_DataType_FLOAT16:
-      if (proto.has_byte_data()) {
-        const int kValue = 1;
-        CAFFE_ENFORCE_EQ(
-            reinterpret_cast<const char*>(&kValue)[0],
-            1,
-            "Serialization of FLOAT16 on big endian platform "
-            "is not written yet.");
-        CAFFE_ENFORCE_EQ(
-            2 * chunkSize,
-            proto.byte_data().size(),
-            "Incorrect proto field size.");
-        context.template Copy<float16, Context, CPUContext>(
-            chunkSize,
-            reinterpret_cast<const float16*>(proto.byte_data().data()),
-            tensor->template mutable_data<float16>() + chunkBegin);
-      } else {
-        // Backward compatibility with models which used int32_data field
-        detail::CopyFromProtoWithCast(
-            chunkSize,
-            proto.int32_data(),
-            reinterpret_cast<uint16_t*>(
-                tensor->template mutable_data<float16>()) +
-                chunkBegin,
-            &context);
-      }
+      // Without byte_data, for backward compatibility with models which used
+      // the int32_data field.
+      detail::CopyFromProtoWithCast(
+          chunkSize,
+          proto.int32_data(),
+          reinterpret_cast<uint16_t*>(
+              tensor->template mutable_data<float16>()) +
+              chunkBegin,
+          &context);
       break;
     case TensorProto_DataType_DOUBLE:
       detail::CopyFromProtoAsIs(
@@ -0,0 +1,193 @@
+#include "caffe2/core/blob_serialization_async_hip.h"
+
+#include <algorithm>
+
+#include "caffe2/core/blob_serialization.h"
+
+namespace caffe2 {
+
+struct HipAsyncTensorSerializer::Job
+{
+    std::string name;
+    int device;
+    TensorCPU host;
+    hipEvent_t copied = nullptr;
+    int chunk_size;
+    BlobSerializerBase::SerializationAcceptor acceptor;
+    std::promise<void> done;
+};
+
+HipAsyncTensorSerializer::HipAsyncTensorSerializer(int num_threads)
+    : copy_streams_(NumHipDevices(), nullptr)
+{
+    CAFFE_ENFORCE_GT(num_threads, 0);
+    for(int i = 0; i < num_threads; ++i)
+    {
+        threads_.emplace_back([this] { Worker(); });
+    }
+}
+
+HipAsyncTensorSerializer::~HipAsyncTensorSerializer()
+{
+    jobs_.NoMoreJobs();
+    for(auto& thread : threads_)
+    {
+        thread.join();
+    }
+    for(int device = 0; device < copy_streams_.size(); ++device)
+    {
+        if(copy_streams_[device])
+        {
+            DeviceGuard guard(device);
+            HIP_CHECK(hipStreamDestroy(copy_streams_[device]));
+        }
+    }
+}
+
+hipStream_t HipAsyncTensorSerializer::CopyStream(int device)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    CAFFE_ENFORCE_LT(device, copy_streams_.size());
+    if(!copy_streams_[device])
+    {
+        DeviceGuard guard(device);
+        // The numerically greatest priority is the lowest one, the copies
+        // yield to the compute kernels.
+        int least_priority, greatest_priority;
+        HIP_ENFORCE(hipDeviceGetStreamPriorityRange(&least_priority, &greatest_priority));
+        HIP_ENFORCE(hipStreamCreateWithPriority(
+            &copy_streams_[device], hipStreamNonBlocking, least_priority));
+    }
+    return copy_streams_[device];
+}
+
+std::future<void>
+HipAsyncTensorSerializer::SerializeAsync(const TensorHIP& tensor,
+                                         const std::string& name,
+                                         BlobSerializerBase::SerializationAcceptor acceptor,
+                                         int chunk_size,
+                                         hipStream_t producer)
+{
+    auto job        = std::make_shared<Job>();
+    job->name       = name;
+    job->chunk_size = chunk_size;
+    job->acceptor   = std::move(acceptor);
+    job->host.Resize(tensor.dims());
+    auto future = job->done.get_future();
+
+    if(tensor.size() == 0)
+    {
+        job->device = CaffeHipGetDevice();
+        job->host.raw_mutable_data(tensor.meta());
+        jobs_.Push(job);
+        return future;
+    }
+
+    job->device = GetGPUIDForPointer(tensor.raw_data());
+    DeviceGuard guard(job->device);
+    if(!producer)
+    {
+        producer = HIPContext::hip_stream(job->device, 0);
+    }
+    hipStream_t copy = CopyStream(job->device);
+
+    // The pinned allocator keeps freed buffers, repeated snapshots of the
+    // same parameters do not go through hipHostMalloc again.
+    static PinnedCPUAllocator allocator;
+    auto buffer = allocator.New(tensor.nbytes());
+    job->host.ShareExternalPointer(buffer.first, tensor.meta(), tensor.nbytes(), buffer.second);
+
+    hipEvent_t written;
+    HIP_ENFORCE(hipEventCreateWithFlags(&written, hipEventDisableTiming));
+    HIP_ENFORCE(hipEventCreateWithFlags(&job->copied, hipEventDisableTiming));
+    HIP_ENFORCE(hipEventRecord(written, producer));
+    HIP_ENFORCE(hipStreamWaitEvent(copy, written, 0));
+    HIP_ENFORCE(hipMemcpyAsync(job->host.raw_mutable_data(tensor.meta()),
+                               tensor.raw_data(),
+                               tensor.nbytes(),
+                               hipMemcpyDeviceToHost,
+                               copy));
+    HIP_ENFORCE(hipEventRecord(job->copied, copy));
+    // Later writers of the tensor on the producer stream come after the copy.
+    HIP_ENFORCE(hipStreamWaitEvent(producer, job->copied, 0));
+    HIP_ENFORCE(hipEventDestroy(written));
+
+    jobs_.Push(job);
+    return future;
+}
+
+std::future<std::string> HipAsyncTensorSerializer::SerializeToStringAsync(
+    const TensorHIP& tensor, const std::string& name, hipStream_t producer)
+{
+    auto result = std::make_shared<std::string>();
+    auto done   = SerializeAsync(tensor,
+                               name,
+                               [result](const std::string&, const std::string& blob) {
+                                   *result = blob;
+                               },
+                               kNoChunking,
+                               producer);
+    // Deferred: get() waits for the serialization, without another thread.
+    return std::async(std::launch::deferred, [result](std::future<void> f) {
+        f.get();
+        return std::move(*result);
+    }, std::move(done));
+}
+
+void HipAsyncTensorSerializer::Worker()
+{
+    std::shared_ptr<Job> job;
+    while(jobs_.Pop(&job))
+    {
+        try
+        {
+            Serialize(job.get());
+            job->done.set_value();
+        }
+        catch(...)
+        {
+            job->done.set_exception(std::current_exception());
+        }
+        job.reset();
+    }
+}
+
+void HipAsyncTensorSerializer::Serialize(Job* job)
+{
+    if(job->copied)
+    {
+        HIP_ENFORCE(hipEventSynchronize(job->copied));
+        HIP_ENFORCE(hipEventDestroy(job->copied));
+        job->copied = nullptr;
+    }
+    const auto& tensor = job->host;
+    int chunk_size     = job->chunk_size;
+    if(chunk_size == kNoChunking)
+    {
+        chunk_size = tensor.size() + 1; // to account for empty tensors
+    }
+    else if(chunk_size == kDefaultChunkSize)
+    {
+        chunk_size = FLAGS_caffe2_tensor_chunk_size;
+    }
+
+    TensorSerializer<CPUContext> serializer;
+    for(size_t chunk_begin = 0; chunk_begin < std::max(tensor.size(), static_cast<TIndex>(1));
+        chunk_begin += chunk_size)
+    {
+        BlobProto blob_proto;
+        blob_proto.set_name(job->name);
+        blob_proto.set_type(kTensorBlobType);
+        TensorProto& proto = *blob_proto.mutable_tensor();
+        proto.set_name(job->name);
+        serializer.Serialize(tensor, job->name, &proto, chunk_begin, chunk_size);
+        // Deserialize to the device the tensor came from.
+        auto* device_detail = proto.mutable_device_detail();
+        device_detail->set_device_type(HIP);
+        device_detail->set_hip_gpu_id(job->device);
+        job->acceptor(MakeString(job->name, kChunkIdSeparator, chunk_begin / chunk_size),
+                      blob_proto.SerializeAsString());
+    }
+}
+
+} // namespace caffe2
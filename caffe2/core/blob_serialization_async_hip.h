@@ -0,0 +1,71 @@
+#ifndef CAFFE2_CORE_BLOB_SERIALIZATION_ASYNC_HIP_H_
+#define CAFFE2_CORE_BLOB_SERIALIZATION_ASYNC_HIP_H_
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "caffe2/core/blob_serializer_base.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/utils/simple_queue.h"
+
+namespace caffe2 {
+
+/**
+ * Serializes HIP tensors without blocking the host thread or the compute
+ * stream, e.g. to checkpoint parameters or push them to a parameter server
+ * in the middle of training.
+ *
+ * SerializeAsync() only enqueues work: an event is recorded on the producer
+ * stream (the stream that wrote the tensor last, by default the stream 0 of
+ * the calling thread on the device of the tensor), and a copy into a pinned
+ * host buffer is issued behind it on a low priority copy stream of the
+ * device. The producer stream then waits on the copy with an event, so that
+ * work enqueued after the call never overwrites the tensor before it was
+ * copied, yet the host never waits. A serializer thread waits for the copy
+ * and builds the protos, which are handed to the acceptor as
+ * TensorSerializer<HIPContext> would, with a HIP device detail.
+ */
+class HipAsyncTensorSerializer
+{
+    public:
+    explicit HipAsyncTensorSerializer(int num_threads = 1);
+    // Serializes the pending tensors before returning.
+    ~HipAsyncTensorSerializer();
+
+    // Snapshots tensor and calls acceptor from a serializer thread with every
+    // chunk, see BlobSerializerBase::SerializeWithChunkSize. The future is
+    // ready once all chunks have been accepted, and holds any error.
+    std::future<void> SerializeAsync(const TensorHIP& tensor,
+                                     const std::string& name,
+                                     BlobSerializerBase::SerializationAcceptor acceptor,
+                                     int chunk_size         = kDefaultChunkSize,
+                                     hipStream_t producer   = nullptr);
+
+    // Snapshots tensor into a single serialized BlobProto, as
+    // Blob::Serialize(name) would return it.
+    std::future<std::string> SerializeToStringAsync(const TensorHIP& tensor,
+                                                    const std::string& name,
+                                                    hipStream_t producer = nullptr);
+
+    private:
+    struct Job;
+
+    // The copy stream of device, created on first use.
+    hipStream_t CopyStream(int device);
+    void Worker();
+    void Serialize(Job* job);
+
+    std::mutex mutex_;
+    std::vector<hipStream_t> copy_streams_;
+    SimpleQueue<std::shared_ptr<Job>> jobs_;
+    std::vector<std::thread> threads_;
+    DISABLE_COPY_AND_ASSIGN(HipAsyncTensorSerializer);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_BLOB_SERIALIZATION_ASYNC_HIP_H_
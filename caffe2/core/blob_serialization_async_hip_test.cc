@@ -0,0 +1,80 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "caffe2/core/blob.h"
+#include "caffe2/core/blob_serialization.h"
+#include "caffe2/core/blob_serialization_async_hip.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/proto/caffe2.pb.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+TEST(HipAsyncTensorSerializerTest, SnapshotsBeforeLaterWrites)
+{
+    if(!HasHipGPU())
+        return;
+    DeviceOption option;
+    option.set_device_type(HIP);
+    HIPContext context(option);
+    TensorHIP tensor(vector<TIndex>{1000});
+    math::Set<float, HIPContext>(1000, 1.5f, tensor.mutable_data<float>(), &context);
+
+    HipAsyncTensorSerializer serializer;
+    auto future = serializer.SerializeToStringAsync(tensor, "x", context.hip_stream());
+    // Enqueued after the snapshot, this must not show in the serialized blob.
+    math::Set<float, HIPContext>(1000, -2.0f, tensor.mutable_data<float>(), &context);
+
+    Blob blob;
+    blob.Deserialize(future.get());
+    const auto& restored = blob.Get<TensorHIP>();
+    EXPECT_EQ(restored.size(), 1000);
+    TensorCPU host(restored, &context);
+    context.FinishDeviceComputation();
+    for(int i = 0; i < host.size(); ++i)
+    {
+        EXPECT_EQ(host.data<float>()[i], 1.5f);
+    }
+}
+
+TEST(HipAsyncTensorSerializerTest, Chunks)
+{
+    if(!HasHipGPU())
+        return;
+    DeviceOption option;
+    option.set_device_type(HIP);
+    HIPContext context(option);
+    TensorCPU source(vector<TIndex>{10, 7});
+    for(int i = 0; i < source.size(); ++i)
+    {
+        source.mutable_data<int>()[i] = i;
+    }
+    TensorHIP tensor(source, &context);
+    context.FinishDeviceComputation();
+
+    HipAsyncTensorSerializer serializer(2);
+    std::mutex mutex;
+    std::vector<std::string> chunks;
+    serializer
+        .SerializeAsync(tensor,
+                        "y",
+                        [&](const std::string&, const std::string& blob) {
+                            std::lock_guard<std::mutex> lock(mutex);
+                            chunks.push_back(blob);
+                        },
+                        16)
+        .get();
+    EXPECT_EQ(chunks.size(), 5u);
+    int total = 0;
+    for(const auto& chunk : chunks)
+    {
+        BlobProto proto;
+        ASSERT_TRUE(proto.ParseFromString(chunk));
+        EXPECT_EQ(proto.tensor().device_detail().device_type(), HIP);
+        total += proto.tensor().int32_data_size();
+    }
+    EXPECT_EQ(total, 70);
+}
+
+} // namespace caffe2
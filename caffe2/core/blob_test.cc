@@ -37,6 +37,7 @@
 CAFFE2_DEFINE_int64(caffe2_test_big_tensor_size, 100000000, "");
 CAFFE2_DECLARE_int(caffe2_tensor_chunk_size);
 CAFFE2_DECLARE_bool(caffe2_serialize_fp16_as_bytes);
+CAFFE2_DECLARE_bool(caffe2_serialize_as_raw_bytes);
 
 namespace caffe2 {
 using namespace ::caffe2::db;
@@ -629,6 +630,48 @@ TEST_SERIALIZATION_WITH_TYPE(uint8_t, int32_data)
 TEST_SERIALIZATION_WITH_TYPE(uint16_t, int32_data)
 TEST_SERIALIZATION_WITH_TYPE(int64_t, int64_data)
 
+template <typename T>
+class TensorRawBytesSerializationTest : public ::testing::Test {};
+typedef ::testing::
+    Types<bool, double, float, int, int8_t, int16_t, uint8_t, uint16_t, int64_t>
+        RawBytesTypes;
+TYPED_TEST_CASE(TensorRawBytesSerializationTest, RawBytesTypes);
+
+TYPED_TEST(TensorRawBytesSerializationTest, RoundTrip) {
+  FLAGS_caffe2_serialize_as_raw_bytes = true;
+  Blob blob;
+  TensorCPU* tensor = blob.GetMutable<TensorCPU>();
+  tensor->Resize(5, 7);
+  for (int i = 0; i < tensor->size(); ++i) {
+    tensor->mutable_data<TypeParam>()[i] = static_cast<TypeParam>(i % 3);
+  }
+  // Chunks of 10 elements, the last one shorter.
+  vector<string> chunks;
+  blob.Serialize(
+      "test",
+      [&chunks](const string&, const string& data) { chunks.push_back(data); },
+      10);
+  FLAGS_caffe2_serialize_as_raw_bytes = false;
+  EXPECT_EQ(chunks.size(), 4);
+  Blob new_blob;
+  for (const auto& chunk : chunks) {
+    BlobProto proto;
+    CHECK(proto.ParseFromString(chunk));
+    const TensorProto& tensor_proto = proto.tensor();
+    const auto& segment = tensor_proto.segment();
+    EXPECT_EQ(
+        tensor_proto.byte_data().size(),
+        (segment.end() - segment.begin()) * sizeof(TypeParam));
+    EXPECT_EQ(tensor_proto.int32_data_size(), 0);
+    new_blob.Deserialize(proto);
+  }
+  const TensorCPU& new_tensor = new_blob.Get<TensorCPU>();
+  EXPECT_EQ(new_tensor.dims(), tensor->dims());
+  for (int i = 0; i < tensor->size(); ++i) {
+    EXPECT_EQ(tensor->data<TypeParam>()[i], new_tensor.data<TypeParam>()[i]);
+  }
+}
+
 TEST(TensorTest, TensorSerialization_CustomType) {
   Blob blob;
   TensorCPU* tensor = blob.GetMutable<TensorCPU>();
@@ -27,6 +27,15 @@
 
 #define MIOPEN_VERSION 1399
 
+// miopenSetConvolutionGroupCount is available starting with MIOpen 1.5, whose
+// miopen.h also provides the MIOPEN_VERSION_* macros.
+#if defined(MIOPEN_VERSION_MAJOR) && \
+    (MIOPEN_VERSION_MAJOR > 1 || (MIOPEN_VERSION_MAJOR == 1 && MIOPEN_VERSION_MINOR >= 5))
+#define CAFFE2_MIOPEN_HAS_GROUP_CONV 1
+#else
+#define CAFFE2_MIOPEN_HAS_GROUP_CONV 0
+#endif
+
 namespace caffe2 {
 
 namespace internal {
@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/compiled_net.h"
+
+#include "caffe2/core/module.h"
+
+namespace caffe2 {
+
+CAFFE_DEFINE_REGISTRY(CompiledNetRegistry, CompiledNet, Workspace*);
+
+CompiledNet::CompiledNet(
+    Workspace* ws,
+    std::vector<std::string> inputs,
+    std::vector<std::vector<TIndex>> input_dims,
+    std::vector<std::string> outputs)
+    : ws_(ws),
+      inputs_(std::move(inputs)),
+      input_dims_(std::move(input_dims)),
+      outputs_(std::move(outputs)) {
+  CAFFE_ENFORCE_EQ(inputs_.size(), input_dims_.size());
+  for (const auto& name : inputs_) {
+    GetTensor(name);
+  }
+}
+
+const float* CompiledNet::Weight(
+    const std::string& name,
+    const std::vector<TIndex>& dims) {
+  auto* blob = ws_->GetBlob(name);
+  CAFFE_ENFORCE(blob, "Weight does not exist: ", name);
+  CAFFE_ENFORCE(
+      blob->IsType<TensorCPU>(), "Weight is not a CPU Tensor: ", name);
+  const auto& tensor = blob->Get<TensorCPU>();
+  CAFFE_ENFORCE(
+      tensor.dims() == dims,
+      "The net was compiled for another shape of ",
+      name,
+      ": ",
+      tensor.dims(),
+      " instead of ",
+      dims);
+  return tensor.data<float>();
+}
+
+TensorCPU* CompiledNet::GetTensor(const std::string& name) {
+  return ws_->CreateBlob(name)->GetMutable<TensorCPU>();
+}
+
+OperatorBase* CompiledNet::AddOperator(const std::string& serialized_def) {
+  OperatorDef def;
+  CAFFE_ENFORCE(def.ParseFromString(serialized_def));
+  operators_.push_back(CreateOperator(def, ws_));
+  return operators_.back().get();
+}
+
+float* CompiledNet::Arena(size_t nbytes) {
+  if (nbytes == 0) {
+    return nullptr;
+  }
+  auto data_and_deleter = CPUContext::New(nbytes);
+  arena_.reset(data_and_deleter.first, data_and_deleter.second);
+  return static_cast<float*>(arena_.get());
+}
+
+CompiledPredictor::CompiledPredictor(
+    const NetDef& init_net,
+    const std::string& name,
+    const std::string& library,
+    Workspace* parent)
+    : ws_(parent) {
+  CAFFE_ENFORCE(ws_.RunNetOnce(init_net));
+  if (!CompiledNetRegistry()->Has(name)) {
+    CAFFE_ENFORCE(
+        !library.empty(), "No compiled net ", name, " and no library to load");
+    LoadModule("", library);
+  }
+  net_ = CompiledNetRegistry()->Create(name, &ws_);
+  CAFFE_ENFORCE(net_, "The library does not define the compiled net ", name);
+}
+
+bool CompiledPredictor::run(
+    const TensorVector& inputs,
+    TensorVector* outputs) {
+  CAFFE_ENFORCE_EQ(inputs.size(), net_->inputs().size());
+  for (int i = 0; i < inputs.size(); ++i) {
+    CAFFE_ENFORCE(
+        inputs[i]->dims() == net_->input_dims()[i],
+        "The net was compiled for another shape of input ",
+        net_->inputs()[i]);
+    auto* tensor = ws_.GetBlob(net_->inputs()[i])->GetMutable<TensorCPU>();
+    tensor->ResizeLike(*inputs[i]);
+    tensor->ShareData(*inputs[i]);
+  }
+  if (!net_->Run()) {
+    return false;
+  }
+  outputs->resize(net_->outputs().size());
+  for (int i = 0; i < outputs->size(); ++i) {
+    (*outputs)[i] = ws_.GetBlob(net_->outputs()[i])->GetMutable<TensorCPU>();
+  }
+  return true;
+}
+
+} // namespace caffe2
@@ -0,0 +1,119 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/predictor.h"
+#include "caffe2/core/registry.h"
+#include "caffe2/core/tensor.h"
+#include "caffe2/core/workspace.h"
+
+namespace caffe2 {
+
+/**
+ * Base class of the nets that net_compiler lowers to C++ (see
+ * net_compiler.h). The generated subclass calls the kernels of the supported
+ * operators directly on buffers laid out at compile time for the static shapes
+ * of the inputs, and keeps the other operators as regular operators. Its
+ * constructor binds the weights from the workspace, which must have the shapes
+ * the net was compiled with.
+ */
+class CompiledNet {
+ public:
+  CompiledNet(
+      Workspace* ws,
+      std::vector<std::string> inputs,
+      std::vector<std::vector<TIndex>> input_dims,
+      std::vector<std::string> outputs);
+  virtual ~CompiledNet() {}
+
+  // Runs the net on the tensors in the input blobs of the workspace, which
+  // must have the dims of input_dims().
+  virtual bool Run() = 0;
+
+  const std::vector<std::string>& inputs() const {
+    return inputs_;
+  }
+  const std::vector<std::vector<TIndex>>& input_dims() const {
+    return input_dims_;
+  }
+  const std::vector<std::string>& outputs() const {
+    return outputs_;
+  }
+
+ protected:
+  // Helpers for the generated constructors.
+  const float* Weight(const std::string& name, const std::vector<TIndex>& dims);
+  // A tensor of the workspace, created if needed.
+  TensorCPU* GetTensor(const std::string& name);
+  // Creates an operator for the serialized OperatorDef.
+  OperatorBase* AddOperator(const std::string& serialized_def);
+  // Buffer for the activations, aligned like the tensors.
+  float* Arena(size_t nbytes);
+
+  Workspace* ws_;
+  CPUContext context_;
+
+ private:
+  std::vector<std::string> inputs_;
+  std::vector<std::vector<TIndex>> input_dims_;
+  std::vector<std::string> outputs_;
+  std::vector<std::unique_ptr<OperatorBase>> operators_;
+  std::shared_ptr<void> arena_;
+};
+
+// The generated translation units register their net under the name of the
+// NetDef, given as a string.
+CAFFE_DECLARE_REGISTRY(CompiledNetRegistry, CompiledNet, Workspace*);
+#define REGISTER_COMPILED_NET(name, ...) \
+  CAFFE_REGISTER_TYPED_CLASS(CompiledNetRegistry, name, __VA_ARGS__)
+
+/**
+ * Runs a compiled net behind the interface of Predictor. The `init_net` is
+ * run once, then the shared library made from the output of net_compiler is
+ * loaded with LoadModule, unless it is linked in already, and the net
+ * registered under `name` is bound to the weights.
+ */
+class CompiledPredictor {
+ public:
+  using TensorVector = Predictor::TensorVector;
+
+  CompiledPredictor(
+      const NetDef& init_net,
+      const std::string& name,
+      const std::string& library = "",
+      Workspace* parent = nullptr);
+
+  // Like Predictor::run. The inputs must have the shapes the net was
+  // compiled for.
+  bool run(const TensorVector& inputs, TensorVector* outputs);
+
+  Workspace* ws() {
+    return &ws_;
+  }
+
+ private:
+  Workspace ws_;
+  std::unique_ptr<CompiledNet> net_;
+};
+
+} // namespace caffe2
@@ -16,13 +16,58 @@
 
 #include "caffe2/core/context.h"
 
+#include <algorithm>
 #include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
 #if defined(_MSC_VER)
 #include <process.h>
 #endif
 
+#include "caffe2/core/scratch_arena.h"
+#include "caffe2/utils/threadpool/ThreadPool.h"
+
+CAFFE2_DEFINE_int(
+    caffe2_intra_op_num_threads,
+    0,
+    "Number of threads, including the calling one, that "
+    "CPUContext::ParallelFor shards operators over (0 - number of cores, "
+    "1 - no intra-op parallelism)");
+
 namespace caffe2 {
 
+namespace {
+
+std::atomic<int> running_inter_op_tasks{0};
+
+// Set while the thread runs a chunk of a ParallelFor, nested ones run inline.
+thread_local bool in_parallel_for = false;
+
+struct IntraOpThreadPool {
+  IntraOpThreadPool()
+      : num_threads(
+            FLAGS_caffe2_intra_op_num_threads > 0
+                ? FLAGS_caffe2_intra_op_num_threads
+                : std::max<int>(std::thread::hardware_concurrency(), 1)),
+        pool(num_threads) {
+    pool.setMinWorkSize(0);
+  }
+
+  const int num_threads;
+  ThreadPool pool;
+  // Held by the ParallelFor using the pool, which runs one chunk per thread;
+  // concurrent ones run inline instead of waiting for it.
+  std::mutex mutex;
+};
+
+IntraOpThreadPool& GetIntraOpThreadPool() {
+  static IntraOpThreadPool pool;
+  return pool;
+}
+
+} // namespace
+
 uint32_t RandomNumberSeed() {
   // Originally copied from folly::randomNumberSeed (at 418ad4)
   // modified to use chrono instead of sys/time.h
@@ -40,4 +85,72 @@ uint32_t RandomNumberSeed() {
       kPrime2 * tv_sec + kPrime3 * tv_usec;
 }
 
+void CPUContext::ParallelFor(
+    size_t range,
+    size_t grain_size,
+    const std::function<void(size_t, size_t)>& fn) {
+  if (range == 0) {
+    return;
+  }
+  size_t chunks = (range + std::max<size_t>(grain_size, 1) - 1) /
+      std::max<size_t>(grain_size, 1);
+  if (chunks < 2 || in_parallel_for || FLAGS_caffe2_intra_op_num_threads == 1) {
+    fn(0, range);
+    return;
+  }
+  auto& intra_op = GetIntraOpThreadPool();
+  const int others = std::max(InterOpTaskScope::Running() - 1, 0);
+  chunks = std::min<size_t>(
+      chunks, std::max(intra_op.num_threads - others, 1));
+  std::unique_lock<std::mutex> lock(intra_op.mutex, std::try_to_lock);
+  if (chunks < 2 || !lock.owns_lock()) {
+    fn(0, range);
+    return;
+  }
+
+  const size_t chunk_size = (range + chunks - 1) / chunks;
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  intra_op.pool.run(
+      [&](int /* thread */, size_t chunk) {
+        const size_t begin = chunk * chunk_size;
+        const size_t end = std::min(begin + chunk_size, range);
+        if (begin >= end) {
+          return;
+        }
+        in_parallel_for = true;
+        try {
+          fn(begin, end);
+        } catch (...) {
+          std::lock_guard<std::mutex> guard(error_mutex);
+          if (!error) {
+            error = std::current_exception();
+          }
+        }
+        in_parallel_for = false;
+      },
+      chunks);
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+InterOpTaskScope::InterOpTaskScope() {
+  running_inter_op_tasks.fetch_add(1, std::memory_order_relaxed);
+}
+
+InterOpTaskScope::~InterOpTaskScope() {
+  running_inter_op_tasks.fetch_sub(1, std::memory_order_relaxed);
+}
+
+int InterOpTaskScope::Running() {
+  return running_inter_op_tasks.load(std::memory_order_relaxed);
+}
+
+ScratchArena<CPUContext>* CPUContext::scratch_arena() {
+  // Never destroyed, tensors can still be returned while statics go away.
+  static auto* arena = new ScratchArena<CPUContext>();
+  return arena;
+}
+
 } // namespace caffe2
@@ -19,6 +19,7 @@
 
 #include <cstdlib>
 #include <ctime>
+#include <functional>
 #include <random>
 #include <unordered_map>
 
@@ -32,6 +33,9 @@ CAFFE2_DECLARE_bool(caffe2_report_cpu_memory_usage);
 
 namespace caffe2 {
 
+template <class Context>
+class ScratchArena;
+
 /**
  * A function to generate a random number seed that is unique in a best-effort
  * basis, using an ever-incrementing seed and the current time.
@@ -121,6 +125,10 @@ class CPUContext final {
       reporter_.New(data_and_deleter.first, nbytes);
       data_and_deleter.second = ReportAndDelete;
     }
+    if (auto* observer = GetMemoryAllocationObserver()) {
+      observer->OnNew(data_and_deleter.first, nbytes, -1);
+      data_and_deleter.second = ObserveAndDelete;
+    }
     return data_and_deleter;
   }
 
@@ -152,6 +160,23 @@ class CPUContext final {
     }
   }
 
+  // Runs fn(begin, end) on disjoint chunks covering [0, range) of at least
+  // grain_size items each, spread over the process wide intra-op thread pool
+  // (caffe2_intra_op_num_threads). The chunks run inline on the calling
+  // thread when range is below two grains, when the pool is in use by another
+  // operator or when called from within a chunk. One thread is left to each
+  // other operator that an inter-op executor runs at the same time (see
+  // InterOpTaskScope). Exceptions thrown by fn are rethrown once all the
+  // chunks are done.
+  static void ParallelFor(
+      size_t range,
+      size_t grain_size,
+      const std::function<void(size_t, size_t)>& fn);
+
+  // Scratch tensors shared by the CPU operators of the process, see
+  // scratch_arena.h.
+  static ScratchArena<CPUContext>* scratch_arena();
+
   // By default CPU operators don't have async device parts
   static bool HasAsyncPartDefault() {
     return false;
@@ -178,6 +203,33 @@ class CPUContext final {
     reporter_.Delete(ptr);
     GetCPUAllocator()->GetDeleter()(ptr);
   }
+  static void ObserveAndDelete(void* ptr) {
+    if (auto* observer = GetMemoryAllocationObserver()) {
+      observer->OnDelete(ptr);
+    }
+    if (FLAGS_caffe2_report_cpu_memory_usage) {
+      ReportAndDelete(ptr);
+    } else {
+      GetCPUAllocator()->GetDeleter()(ptr);
+    }
+  }
+};
+
+/**
+ * Counts the operators that inter-op executor threads are running, for the
+ * thread budget of CPUContext::ParallelFor. Executors keep one alive on their
+ * worker threads while they run a task.
+ */
+class InterOpTaskScope {
+ public:
+  InterOpTaskScope();
+  ~InterOpTaskScope();
+
+  // Number of scopes alive in the process.
+  static int Running();
+
+ private:
+  DISABLE_COPY_AND_ASSIGN(InterOpTaskScope);
 };
 
 template<>
@@ -27,6 +27,7 @@
 #include "caffe2/core/context_gpu.h"
 #include "caffe2/core/init.h"
 #include "caffe2/core/logging.h"
+#include "caffe2/core/scratch_arena.h"
 #include "caffe2/core/tensor.h"
 #include "caffe2/utils/string_utils.h"
 
@@ -270,6 +271,23 @@ CUDAContext::CUDAContext(const DeviceOption& option)
   DCHECK_EQ(option.device_type(), CUDA);
 }
 
+namespace {
+// Streams are per thread, so are the arenas.
+thread_local std::vector<std::unique_ptr<ScratchArena<CUDAContext>>>
+    cuda_scratch_arenas[CAFFE2_COMPILE_TIME_MAX_GPUS];
+} // namespace
+
+ScratchArena<CUDAContext>* CUDAContext::scratch_arena() {
+  auto& arenas = cuda_scratch_arenas[gpu_id_];
+  if (arenas.size() <= static_cast<size_t>(stream_id_)) {
+    arenas.resize(stream_id_ + 1);
+  }
+  if (!arenas[stream_id_]) {
+    arenas[stream_id_].reset(new ScratchArena<CUDAContext>());
+  }
+  return arenas[stream_id_].get();
+}
+
 // shared mutex to lock out alloc / free during NCCL launches
 std::mutex& CUDAContext::mutex() {
   static std::mutex m;
@@ -195,6 +195,9 @@ class CUDAContext final {
     return cuda_objects_.GetCudnnHandle(gpu_id_, stream_id_);
   }
 
+  // Scratch tensors of the current stream of this thread, see scratch_arena.h.
+  ScratchArena<CUDAContext>* scratch_arena();
+
   curandGenerator_t& curand_generator() {
     if (!curand_generator_) {
       DeviceGuard guard(gpu_id_);
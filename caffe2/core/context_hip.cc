@@ -1,8 +1,13 @@
 #include <algorithm>
 #include <atomic>
 #include <cstdlib>
+#include <deque>
+#include <exception>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "cub/util_allocator.cuh"
 #include "caffe2/core/asan.h"
@@ -10,13 +15,15 @@
 #include "caffe2/core/context_hip.h"
 #include "caffe2/core/init.h"
 #include "caffe2/core/logging.h"
+#include "caffe2/core/scratch_arena.h"
+#include "caffe2/core/stream_pool_hip.h"
 #include "caffe2/core/tensor.h"
 #include "caffe2/utils/string_utils.h"
 
 CAFFE2_DEFINE_string(caffe2_hip_memory_pool,
                      "",
                      "Sets the memory pool used by caffe2. Possible values are "
-                     "none, cnmen and cub.");
+                     "none, cnmen, cub and stream_pool.");
 
 // For description of CUB caching allocator configuration, see
 // https://nvlabs.github.io/cub/structcub_1_1_caching_device_allocator.html
@@ -47,6 +54,10 @@ CAFFE2_DEFINE_bool(caffe2_gpu_memory_tracking,
 CAFFE2_DEFINE_int(caffe2_gpu_memory_report_interval_mb,
                   128,
                   "The threshold in MB on how frequently to report memory changes");
+CAFFE2_DEFINE_int(caffe2_hip_pinned_memory_pool_mb,
+                  1024,
+                  "Max MB of freed pinned host memory kept for reuse by "
+                  "PinnedCPUAllocator (0 disables the pool)");
 
 namespace caffe2 {
 
@@ -86,6 +97,10 @@ static std::vector<long> g_max_by_gpu_map(CAFFE2_COMPILE_TIME_MAX_GPUS, 0);
 static long g_total_mem = 0;
 static long g_last_rep  = 0;
 
+// Allocation counters of the cub pool, guarded by HIPContext::mutex.
+static std::vector<long> g_cub_num_allocs(CAFFE2_COMPILE_TIME_MAX_GPUS, 0);
+static std::vector<long> g_cub_num_cache_hits(CAFFE2_COMPILE_TIME_MAX_GPUS, 0);
+
 HipMemoryPoolType GetHipMemoryPoolType() { return g_hip_memory_pool_type; }
 
 vector<TIndex>
@@ -124,31 +139,14 @@ static void Caffe2InitializeHip()
                      CAFFE2_COMPILE_TIME_MAX_GPUS,
                      "). Increase that and recompile the caffe binary.");
 
-    for(int i = 0; i < NumHipDevices(); ++i)
+    if(FLAGS_caffe2_hip_eager_device_init)
     {
-        DeviceGuard g(i);
-        // Enable peer access.
-        const int peer_group = i / CAFFE2_HIP_MAX_PEER_SIZE;
-        const int peer_start = peer_group * CAFFE2_HIP_MAX_PEER_SIZE;
-        const int peer_end = std::min(NumHipDevices(), (peer_group + 1) * CAFFE2_HIP_MAX_PEER_SIZE);
-        VLOG(1) << "Enabling peer access within group #" << peer_group << ", from gpuid "
-                << peer_start << " to " << peer_end - 1 << ", for gpuid " << i << ".";
-
-        for(int j = peer_start; j < peer_end; ++j)
+        std::vector<int> gpu_ids(NumHipDevices());
+        for(int i = 0; i < gpu_ids.size(); ++i)
         {
-            if(i == j)
-                continue;
-            int can_access;
-            HIP_ENFORCE(hipDeviceCanAccessPeer(&can_access, i, j));
-            if(can_access)
-            {
-                VLOG(1) << "Enabling peer access from " << i << " to " << j;
-                // Note: just for future reference, the 0 here is not a gpu id, it is
-                // a reserved flag for hipDeviceEnablePeerAccess that should always be
-                // zero currently.
-                HIP_ENFORCE(hipDeviceEnablePeerAccess(j, 0));
-            }
+            gpu_ids[i] = i;
         }
+        InitializeHipDevices(gpu_ids);
     }
 
     RegisterTypeCallFunction(TypeMeta::Id<Tensor<HIPContext>>(), GetTensorType<HIPContext>);
@@ -158,6 +156,116 @@ static void Caffe2InitializeHip()
     // CheckMiOpenVersions();
 }
 
+namespace {
+// Devices are set up and peered lazily: touching every device and enabling
+// peer access for every pair up front takes seconds on large nodes, even for
+// processes that only use one GPU.
+std::once_flag g_device_init_once[CAFFE2_COMPILE_TIME_MAX_GPUS];
+std::atomic<bool> g_device_initialized[CAFFE2_COMPILE_TIME_MAX_GPUS];
+std::once_flag g_peer_access_once[CAFFE2_COMPILE_TIME_MAX_GPUS][CAFFE2_COMPILE_TIME_MAX_GPUS];
+std::atomic<bool> g_peer_access_enabled[CAFFE2_COMPILE_TIME_MAX_GPUS]
+                                       [CAFFE2_COMPILE_TIME_MAX_GPUS];
+
+bool InSamePeerGroup(const int i, const int j)
+{
+    return i / CAFFE2_HIP_MAX_PEER_SIZE == j / CAFFE2_HIP_MAX_PEER_SIZE;
+}
+} // namespace
+
+bool EnableHipPeerAccess(const int from, const int to)
+{
+    if(from == to)
+    {
+        return true;
+    }
+    CAFFE_ENFORCE(from >= 0 && from < NumHipDevices(), "Invalid gpu id ", from);
+    CAFFE_ENFORCE(to >= 0 && to < NumHipDevices(), "Invalid gpu id ", to);
+    std::call_once(g_peer_access_once[from][to], [from, to]() {
+        if(!InSamePeerGroup(from, to))
+        {
+            return;
+        }
+        int can_access;
+        HIP_ENFORCE(hipDeviceCanAccessPeer(&can_access, from, to));
+        if(!can_access)
+        {
+            return;
+        }
+        VLOG(1) << "Enabling peer access from " << from << " to " << to;
+        DeviceGuard g(from);
+        // Note: just for future reference, the 0 here is not a gpu id, it is
+        // a reserved flag for hipDeviceEnablePeerAccess that should always be
+        // zero currently.
+        const hipError_t err = hipDeviceEnablePeerAccess(to, 0);
+        if(err == hipErrorPeerAccessAlreadyEnabled)
+        {
+            // Someone outside of Caffe2 enabled it already, clear the error.
+            hipGetLastError();
+        }
+        else
+        {
+            HIP_ENFORCE(err);
+        }
+        g_peer_access_enabled[from][to] = true;
+    });
+    return g_peer_access_enabled[from][to];
+}
+
+void InitializeHipDevice(const int gpu_id)
+{
+    CAFFE_ENFORCE(gpu_id >= 0 && gpu_id < CAFFE2_COMPILE_TIME_MAX_GPUS, "Invalid gpu id ", gpu_id);
+    std::call_once(g_device_init_once[gpu_id], [gpu_id]() {
+        VLOG(1) << "Initializing HIP device " << gpu_id;
+        {
+            DeviceGuard g(gpu_id);
+            // Creates the device context.
+            HIP_ENFORCE(hipFree(nullptr));
+        }
+        // Publish the device before looking at the others: of two devices
+        // initialized at the same time, at least one sees the other and peers
+        // them.
+        g_device_initialized[gpu_id] = true;
+        for(int j = 0; j < NumHipDevices(); ++j)
+        {
+            if(j != gpu_id && InSamePeerGroup(gpu_id, j) && g_device_initialized[j])
+            {
+                EnableHipPeerAccess(gpu_id, j);
+                EnableHipPeerAccess(j, gpu_id);
+            }
+        }
+    });
+}
+
+void InitializeHipDevices(const std::vector<int>& gpu_ids)
+{
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors(gpu_ids.size());
+    for(int i = 0; i < gpu_ids.size(); ++i)
+    {
+        threads.emplace_back([&gpu_ids, &errors, i]() {
+            try
+            {
+                InitializeHipDevice(gpu_ids[i]);
+            }
+            catch(...)
+            {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+    for(auto& thread : threads)
+    {
+        thread.join();
+    }
+    for(auto& error : errors)
+    {
+        if(error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
 static void SetUpCub()
 {
     VLOG(1) << "Setting up cub memory pool.";
@@ -196,12 +304,179 @@ static void Caffe2SetHIPMemoryPool()
         g_hip_memory_pool_type = HipMemoryPoolType::CUB;
         SetUpCub();
     }
+    else if(FLAGS_caffe2_hip_memory_pool == "stream_pool")
+    {
+        g_hip_memory_pool_type = HipMemoryPoolType::STREAM_POOL;
+    }
     else
     {
         CAFFE_THROW("Unrecognized HIP memory pool type: ", FLAGS_caffe2_hip_memory_pool);
     }
 }
 
+namespace {
+// Pinned blocks handed out by PinnedCPUAllocator, and the freed ones kept for
+// reuse. Leaked so that blocks can still be freed during static destruction.
+struct PinnedMemoryPool
+{
+    // A freed block, with the events recorded on the streams that may still
+    // have async copies reading or writing it, as (gpu, event) pairs.
+    struct FreedBlock
+    {
+        void* data;
+        std::vector<std::pair<int, hipEvent_t>> events;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<void*, size_t> block_bytes;
+    std::unordered_map<size_t, std::deque<FreedBlock>> free_blocks;
+    std::vector<hipEvent_t> free_events[CAFFE2_COMPILE_TIME_MAX_GPUS];
+    size_t cached_bytes = 0;
+};
+
+PinnedMemoryPool& GetPinnedMemoryPool()
+{
+    static PinnedMemoryPool* pool = new PinnedMemoryPool();
+    return *pool;
+}
+
+size_t PinnedBinBytes(size_t nbytes)
+{
+    size_t bin = 4096;
+    while(bin < nbytes)
+    {
+        bin <<= 1;
+    }
+    return bin;
+}
+
+// Records an event on every stream the calling thread is using. Expects
+// pool.mutex to be held.
+std::vector<std::pair<int, hipEvent_t>> RecordPinnedFreeEvents(PinnedMemoryPool& pool)
+{
+    std::vector<std::pair<int, hipEvent_t>> events;
+    const int num_gpus = NumHipDevices();
+    for(int gpu = 0; gpu < num_gpus; ++gpu)
+    {
+        hipStream_t stream = HIPContext::current_hip_stream(gpu);
+        if(!stream)
+        {
+            continue;
+        }
+        hipEvent_t event;
+        auto& free_events = pool.free_events[gpu];
+        if(free_events.empty())
+        {
+            DeviceGuard guard(gpu);
+            HIP_ENFORCE(hipEventCreateWithFlags(&event, hipEventDisableTiming));
+        }
+        else
+        {
+            event = free_events.back();
+            free_events.pop_back();
+        }
+        HIP_ENFORCE(hipEventRecord(event, stream));
+        events.emplace_back(gpu, event);
+    }
+    return events;
+}
+
+// Returns whether all the events of block are done, and if so hands them
+// back to the pool. Expects pool.mutex to be held.
+bool PinnedBlockReady(PinnedMemoryPool& pool, PinnedMemoryPool::FreedBlock& block)
+{
+    for(const auto& event : block.events)
+    {
+        const hipError_t status = hipEventQuery(event.second);
+        if(status == hipErrorNotReady)
+        {
+            return false;
+        }
+        HIP_ENFORCE(status);
+    }
+    for(const auto& event : block.events)
+    {
+        pool.free_events[event.first].push_back(event.second);
+    }
+    block.events.clear();
+    return true;
+}
+} // namespace
+
+std::pair<void*, MemoryDeleter> PinnedCPUAllocator::New(size_t nbytes)
+{
+    auto& pool       = GetPinnedMemoryPool();
+    const size_t bin = PinnedBinBytes(nbytes);
+    void* data       = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        auto it = pool.free_blocks.find(bin);
+        if(it != pool.free_blocks.end())
+        {
+            // The oldest blocks are the most likely to be done.
+            auto& blocks = it->second;
+            for(auto block = blocks.begin(); block != blocks.end(); ++block)
+            {
+                if(PinnedBlockReady(pool, *block))
+                {
+                    data = block->data;
+                    blocks.erase(block);
+                    pool.cached_bytes -= bin;
+                    break;
+                }
+            }
+        }
+    }
+    if(!data)
+    {
+        {
+            std::lock_guard<std::mutex> lock(HIPContext::mutex());
+            HIP_ENFORCE(hipHostMalloc(&data, bin));
+        }
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.block_bytes[data] = bin;
+    }
+    if(FLAGS_caffe2_cpu_allocator_do_zero_fill)
+    {
+        memset(data, 0, nbytes);
+    }
+    return {data, Delete};
+}
+
+void PinnedCPUAllocator::Delete(void* data)
+{
+    auto& pool = GetPinnedMemoryPool();
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        auto it = pool.block_bytes.find(data);
+        if(it == pool.block_bytes.end())
+        {
+            // Caffe2 uses a lazy way to figure out if one is actually going
+            // to use GPUs or not. If a HIPContext::New() call is made, inside
+            // the HIPContext function we will switch the cpu side allocator
+            // to a PinnedCPUAllocator. But, if one calls CPUContext::New()
+            // before any HIP allocations, PinnedCPUAllocator can still delete
+            // the corresponding memory.
+            free(data);
+            return;
+        }
+        const size_t bin = it->second;
+        if(pool.cached_bytes + bin <=
+           size_t(FLAGS_caffe2_hip_pinned_memory_pool_mb) * 1024L * 1024L)
+        {
+            pool.free_blocks[bin].push_back(
+                PinnedMemoryPool::FreedBlock{data, RecordPinnedFreeEvents(pool)});
+            pool.cached_bytes += bin;
+            return;
+        }
+        pool.block_bytes.erase(it);
+    }
+    // hipHostFree synchronizes the device, so no outstanding copy can still
+    // be using the block.
+    std::lock_guard<std::mutex> lock(HIPContext::mutex());
+    HIP_ENFORCE(hipHostFree(data));
+}
+
 // An initialization function that sets the CPU side to use pinned cpu
 // allocator.
 void Caffe2UsePinnedCPUAllocator()
@@ -251,6 +526,7 @@ HIPContext::HIPContext(const int gpu_id)
     : gpu_id_(gpu_id == -1 ? GetDefaultGPUID() : gpu_id), random_seed_(RandomNumberSeed())
 {
     static Caffe2HipInitializerHelper g_hip_initializer_;
+    InitializeHipDevice(gpu_id_);
 }
 
 HIPContext::HIPContext(const DeviceOption& option)
@@ -259,6 +535,27 @@ HIPContext::HIPContext(const DeviceOption& option)
 {
     static Caffe2HipInitializerHelper g_hip_initializer_;
     DCHECK_EQ(option.device_type(), HIP);
+    InitializeHipDevice(gpu_id_);
+}
+
+namespace {
+// Streams are per thread, so are the arenas.
+thread_local std::vector<std::unique_ptr<ScratchArena<HIPContext>>>
+    hip_scratch_arenas[CAFFE2_COMPILE_TIME_MAX_GPUS];
+} // namespace
+
+ScratchArena<HIPContext>* HIPContext::scratch_arena()
+{
+    auto& arenas = hip_scratch_arenas[gpu_id_];
+    if(arenas.size() <= static_cast<size_t>(stream_id_))
+    {
+        arenas.resize(stream_id_ + 1);
+    }
+    if(!arenas[stream_id_])
+    {
+        arenas[stream_id_].reset(new ScratchArena<HIPContext>());
+    }
+    return arenas[stream_id_].get();
 }
 
 // shared mutex to lock out alloc / free during NCCL launches
@@ -284,6 +581,55 @@ std::vector<long> HIPContext::MaxMemoryByGpu()
     return g_max_by_gpu_map;
 }
 
+std::vector<HipMemoryPoolStats> HIPContext::MemoryPoolStats()
+{
+    std::vector<HipMemoryPoolStats> stats(NumHipDevices());
+    switch(g_hip_memory_pool_type)
+    {
+    case HipMemoryPoolType::NONE:
+    {
+        std::lock_guard<std::mutex> lock(HIPContext::mutex());
+        for(int gpu = 0; gpu < stats.size(); ++gpu)
+        {
+            stats[gpu].allocated_bytes = g_total_by_gpu_map[gpu];
+            stats[gpu].cached_bytes    = g_total_by_gpu_map[gpu];
+        }
+        break;
+    }
+    case HipMemoryPoolType::CUB:
+    {
+        std::lock_guard<std::mutex> lock(HIPContext::mutex());
+        for(const auto& block : g_cub_allocator->live_blocks)
+        {
+            auto& s = stats[block.device];
+            s.allocated_bytes += block.bytes;
+            s.cached_bytes += block.bytes;
+            ++s.num_segments;
+        }
+        for(const auto& block : g_cub_allocator->cached_blocks)
+        {
+            auto& s = stats[block.device];
+            s.cached_bytes += block.bytes;
+            s.largest_free_block = std::max(s.largest_free_block, block.bytes);
+            ++s.num_segments;
+        }
+        for(int gpu = 0; gpu < stats.size(); ++gpu)
+        {
+            stats[gpu].num_allocs     = g_cub_num_allocs[gpu];
+            stats[gpu].num_cache_hits = g_cub_num_cache_hits[gpu];
+        }
+        break;
+    }
+    case HipMemoryPoolType::STREAM_POOL:
+        for(int gpu = 0; gpu < stats.size(); ++gpu)
+        {
+            stats[gpu] = HipStreamPoolAllocator::Get().GetStats(gpu);
+        }
+        break;
+    }
+    return stats;
+}
+
 namespace {
 void TrackMemoryAlloc(size_t nbytes)
 {
@@ -314,14 +660,52 @@ void TrackMemoryAlloc(size_t nbytes)
         g_last_rep = g_total_mem;
     }
 }
+
+void ObserveNew(void* ptr, size_t nbytes, int gpu)
+{
+    auto* observer = GetMemoryAllocationObserver();
+    if(observer && ptr)
+    {
+        observer->OnNew(ptr, nbytes, gpu);
+    }
+}
+
+void UntrackMemoryFree(void* ptr)
+{
+    auto sz_it = g_size_map.find(ptr);
+    DCHECK(sz_it != g_size_map.end());
+    auto aff_it = g_hip_device_affiliation.find(ptr);
+    DCHECK(aff_it != g_hip_device_affiliation.end());
+    g_total_mem -= sz_it->second;
+    g_total_by_gpu_map[aff_it->second] -= sz_it->second;
+    g_size_map.erase(sz_it);
+}
 }
 
 std::pair<void*, MemoryDeleter> HIPContext::New(size_t nbytes)
 {
-    // Lock the mutex
-    std::lock_guard<std::mutex> lock(HIPContext::mutex());
     // A one-time caffe2 cuda initializer.
     static Caffe2HipInitializerHelper g_hip_initializer_;
+
+    // The stream pool does its own, per stream, locking.
+    if(g_hip_memory_pool_type == HipMemoryPoolType::STREAM_POOL)
+    {
+        const int gpu = CaffeHipGetDevice();
+        auto stream   = hip_objects_.GetStream(gpu, hip_objects_.current_stream_ids_[gpu]);
+        void* ptr     = HipStreamPoolAllocator::Get().Allocate(nbytes, gpu, stream);
+        if(FLAGS_caffe2_gpu_memory_tracking && ptr)
+        {
+            std::lock_guard<std::mutex> lock(HIPContext::mutex());
+            TrackMemoryAlloc(nbytes);
+            g_size_map[ptr]               = nbytes;
+            g_hip_device_affiliation[ptr] = gpu;
+        }
+        ObserveNew(ptr, nbytes, gpu);
+        return {ptr, Delete};
+    }
+
+    // Lock the mutex
+    std::lock_guard<std::mutex> lock(HIPContext::mutex());
     void* ptr = nullptr;
 
     if(FLAGS_caffe2_gpu_memory_tracking)
@@ -337,34 +721,88 @@ std::pair<void*, MemoryDeleter> HIPContext::New(size_t nbytes)
             g_size_map[ptr]               = nbytes;
             g_hip_device_affiliation[ptr] = CaffeHipGetDevice();
         }
+        ObserveNew(ptr, nbytes, CaffeHipGetDevice());
         return {ptr, Delete};
     case HipMemoryPoolType::CUB:
+    {
+        // cub takes a block from its cache when it has one for the size.
+        const auto num_cached = g_cub_allocator->cached_blocks.size();
         HIP_ENFORCE(g_cub_allocator->DeviceAllocate(&ptr, nbytes));
-        g_hip_device_affiliation[ptr] = CaffeHipGetDevice();
-        VLOG(2) << "CUB allocating pointer " << ptr << " on device " << CaffeHipGetDevice();
+        const int gpu = CaffeHipGetDevice();
+        ++g_cub_num_allocs[gpu];
+        if(g_cub_allocator->cached_blocks.size() < num_cached)
+        {
+            ++g_cub_num_cache_hits[gpu];
+        }
+        g_hip_device_affiliation[ptr] = gpu;
+        VLOG(2) << "CUB allocating pointer " << ptr << " on device " << gpu;
         if(FLAGS_caffe2_gpu_memory_tracking)
         {
             g_size_map[ptr] = nbytes;
         }
+        ObserveNew(ptr, nbytes, gpu);
         return {ptr, Delete};
     }
+    case HipMemoryPoolType::STREAM_POOL:
+        // Handled above, without the global lock.
+        break;
+    }
     return {nullptr, Delete};
 }
 
+std::pair<void*, MemoryDeleter> HIPContext::NewManaged(size_t nbytes)
+{
+    static Caffe2HipInitializerHelper g_hip_initializer_;
+
+    std::lock_guard<std::mutex> lock(HIPContext::mutex());
+    void* ptr = nullptr;
+    HIP_ENFORCE(hipMallocManaged(&ptr, nbytes, hipMemAttachGlobal));
+    return {ptr, DeleteManaged};
+}
+
+void HIPContext::DeleteManaged(void* ptr)
+{
+    std::lock_guard<std::mutex> lock(HIPContext::mutex());
+    // Same as hipFree in Delete, this may run after the runtime has exited.
+    hipError_t error = hipFree(ptr);
+    if(error != hipSuccess)
+    {
+        LOG(FATAL) << "Error at: " << __FILE__ << ":" << __LINE__ << ": "
+                   << hipGetErrorString(error);
+    }
+}
+
 void HIPContext::Delete(void* ptr)
 {
+    if(auto* observer = GetMemoryAllocationObserver())
+    {
+        observer->OnDelete(ptr);
+    }
+    if(g_hip_memory_pool_type == HipMemoryPoolType::STREAM_POOL)
+    {
+        if(FLAGS_caffe2_gpu_memory_tracking && ptr)
+        {
+            std::lock_guard<std::mutex> lock(HIPContext::mutex());
+            UntrackMemoryFree(ptr);
+            g_hip_device_affiliation.erase(ptr);
+        }
+        if(!ptr)
+        {
+            return;
+        }
+        // The block may be freed while another device is current: order the
+        // free after the caller's stream on the device that owns the block.
+        auto& allocator = HipStreamPoolAllocator::Get();
+        allocator.Free(ptr, hip_objects_.CurrentStream(allocator.GetDevice(ptr)));
+        return;
+    }
+
     // lock the mutex
     std::lock_guard<std::mutex> lock(HIPContext::mutex());
 
     if(FLAGS_caffe2_gpu_memory_tracking)
     {
-        auto sz_it = g_size_map.find(ptr);
-        DCHECK(sz_it != g_size_map.end());
-        auto aff_it = g_hip_device_affiliation.find(ptr);
-        DCHECK(aff_it != g_hip_device_affiliation.end());
-        g_total_mem -= sz_it->second;
-        g_total_by_gpu_map[aff_it->second] -= sz_it->second;
-        g_size_map.erase(sz_it);
+        UntrackMemoryFree(ptr);
     }
 
     switch(g_hip_memory_pool_type)
@@ -401,6 +839,9 @@ void HIPContext::Delete(void* ptr)
         g_hip_device_affiliation.erase(it);
         break;
     }
+    case HipMemoryPoolType::STREAM_POOL:
+        // Handled above, without the global lock.
+        break;
     }
 }
 
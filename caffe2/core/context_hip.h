@@ -13,12 +13,18 @@
 #include "caffe2/core/types.h"
 #include "caffe2/proto/caffe2.pb.h"
 
+// The streams of each GPU have the ids 0 to caffe2_streams_per_gpu - 1 and
+// the stream with id caffe2_streams_per_gpu is the high priority one the
+// async nets run the communication ops on (see dag_utils::runsOnCommStream).
+CAFFE2_DECLARE_int(caffe2_streams_per_gpu);
+
 namespace caffe2 {
 
 enum class HipMemoryPoolType
 {
-    NONE = 0,
-    CUB  = 1,
+    NONE        = 0,
+    CUB         = 1,
+    STREAM_POOL = 2,
 };
 
 /**
@@ -28,6 +34,47 @@ enum class HipMemoryPoolType
  */
 HipMemoryPoolType GetHipMemoryPoolType();
 
+/**
+ * Initializes a HIP device the first time it is used by this process.
+ *
+ * HIPContext calls it for its device, so a run only pays for the devices it
+ * touches. Peer access is enabled, in both directions, between the device and
+ * every device of its peer group that was initialized before it. Calling it
+ * again for an initialized device is cheap.
+ */
+void InitializeHipDevice(const int gpu_id);
+
+/**
+ * Initializes the given HIP devices in parallel, one thread per device, e.g.
+ * before a data parallel model creates its nets.
+ */
+void InitializeHipDevices(const std::vector<int>& gpu_ids);
+
+/**
+ * Enables access from device `from` to the memory of device `to` the first
+ * time it is asked for. Returns false if the devices are not in the same peer
+ * group or the hardware does not allow it. Thread safe.
+ */
+bool EnableHipPeerAccess(const int from, const int to);
+
+/**
+ * Memory pool counters of one device, see HIPContext::MemoryPoolStats.
+ */
+struct HipMemoryPoolStats
+{
+    // Bytes currently handed out to callers.
+    size_t allocated_bytes = 0;
+    // Bytes obtained from the device and owned by the pool, used or not.
+    size_t cached_bytes = 0;
+    // Size of the largest free block held by the pool.
+    size_t largest_free_block = 0;
+    // Number of allocations, and of those served from the cache.
+    long num_allocs     = 0;
+    long num_cache_hits = 0;
+    // Number of device allocations currently owned by the pool.
+    long num_segments = 0;
+};
+
 /**
  * A struct to host thread-local cuda objects.
  *
@@ -46,9 +93,10 @@ class ThreadLocalHIPObjects
     {
         for(int i = 0; i < CAFFE2_COMPILE_TIME_MAX_GPUS; ++i)
         {
-            hip_streams_[i]     = vector<hipStream_t>();
-            rocblas_handles_[i] = vector<rocblas_handle>();
-            miopen_handles_[i]  = vector<miopenHandle_t>();
+            hip_streams_[i]        = vector<hipStream_t>();
+            rocblas_handles_[i]    = vector<rocblas_handle>();
+            miopen_handles_[i]     = vector<miopenHandle_t>();
+            current_stream_ids_[i] = 0;
         }
     }
 
@@ -62,11 +110,31 @@ class ThreadLocalHIPObjects
         if(!gpu_streams[stream_id])
         {
             DeviceGuard guard(gpu);
-            HIP_ENFORCE(hipStreamCreateWithFlags(&gpu_streams[stream_id], hipStreamNonBlocking));
+            if(stream_id == FLAGS_caffe2_streams_per_gpu)
+            {
+                int least_priority, greatest_priority;
+                HIP_ENFORCE(hipDeviceGetStreamPriorityRange(&least_priority, &greatest_priority));
+                HIP_ENFORCE(hipStreamCreateWithPriority(
+                    &gpu_streams[stream_id], hipStreamNonBlocking, greatest_priority));
+            }
+            else
+            {
+                HIP_ENFORCE(hipStreamCreateWithFlags(&gpu_streams[stream_id], hipStreamNonBlocking));
+            }
         }
         return gpu_streams[stream_id];
     }
 
+    // Returns the stream the calling thread last switched to on gpu, or
+    // nullptr if that stream has not been created (the thread has not queued
+    // any work on it).
+    hipStream_t CurrentStream(int gpu) const
+    {
+        const int stream_id = current_stream_ids_[gpu];
+        const vector<hipStream_t>& gpu_streams = hip_streams_[gpu];
+        return stream_id < gpu_streams.size() ? gpu_streams[stream_id] : nullptr;
+    }
+
     rocblas_handle GetHandle(int gpu, int stream_id)
     {
         DeviceGuard guard(gpu);
@@ -134,6 +202,9 @@ class ThreadLocalHIPObjects
     vector<hipStream_t> hip_streams_[CAFFE2_COMPILE_TIME_MAX_GPUS];
     vector<rocblas_handle> rocblas_handles_[CAFFE2_COMPILE_TIME_MAX_GPUS];
     vector<miopenHandle_t> miopen_handles_[CAFFE2_COMPILE_TIME_MAX_GPUS];
+    // Stream id of the last SwitchToDevice call per gpu, used by the stream
+    // pool allocator to find the stream an allocation is made for.
+    int current_stream_ids_[CAFFE2_COMPILE_TIME_MAX_GPUS];
 };
 
 class HIPContext final
@@ -156,6 +227,7 @@ class HIPContext final
     {
         set_stream_id(stream_id);
         CaffeHipSetDevice(gpu_id_);
+        hip_objects_.current_stream_ids_[gpu_id_] = stream_id;
     }
     inline void SwitchToDevice() { SwitchToDevice(0); }
 
@@ -188,10 +260,17 @@ class HIPContext final
         return hip_objects_.GetStream(gpu_id, stream_id);
     }
 
+    // Stream the calling thread currently queues work on for gpu_id, or
+    // nullptr if the thread has not used that GPU.
+    static hipStream_t current_hip_stream(int gpu_id) { return hip_objects_.CurrentStream(gpu_id); }
+
     rocblas_handle get_rocblas_handle() { return hip_objects_.GetHandle(gpu_id_, stream_id_); }
 
     miopenHandle_t miopen_handle() { return hip_objects_.GetMiopenHandle(gpu_id_, stream_id_); }
 
+    // Scratch tensors of the current stream of this thread, see scratch_arena.h.
+    ScratchArena<HIPContext>* scratch_arena();
+
     hiprandGenerator_t& hiprand_generator()
     {
         if(!hiprand_generator_)
@@ -208,6 +287,12 @@ class HIPContext final
 
     static std::pair<void*, MemoryDeleter> New(size_t nbytes);
 
+    // Allocates nbytes of managed memory with hipMallocManaged, which the
+    // device pages in on demand and can thus exceed the device memory. This
+    // bypasses the memory pool and the memory tracking; it is meant for a few
+    // large blobs, see CopyToManaged.
+    static std::pair<void*, MemoryDeleter> NewManaged(size_t nbytes);
+
     // Get a mutex to lock out hipMalloc / hipFree calls when
     // NCCL kernels are being launched. Should remove threat of
     // deadlocks
@@ -218,6 +303,12 @@ class HIPContext final
     static std::vector<long> TotalMemoryByGpu();
     static std::vector<long> MaxMemoryByGpu();
 
+    // Returns the memory pool counters of every device. Unlike the functions
+    // above, this does not need --caffe2_gpu_memory_tracking and is cheap
+    // enough to be polled periodically. With no memory pool, allocated_bytes
+    // and cached_bytes are only filled in when memory tracking is on.
+    static std::vector<HipMemoryPoolStats> MemoryPoolStats();
+
     template <class SrcContext, class DstContext>
     inline void CopyBytes(size_t nbytes, const void* src, void* dst)
     {
@@ -254,6 +345,7 @@ class HIPContext final
 
     protected:
     static void Delete(void* data);
+    static void DeleteManaged(void* data);
     void set_stream_id(int stream_id) { stream_id_ = stream_id; }
 
     int gpu_id_;
@@ -289,44 +381,24 @@ inline void CPUContext::CopyBytes<CPUContext, HIPContext>(size_t nbytes, const v
  * space. As a result, whenever Caffe2 is built with GPU and there is
  * GPU present during runtime, at global initialization time we will set
  * the CPU memory allocator to allocate pinned memory.
+ *
+ * hipHostMalloc and hipHostFree are slow and the latter synchronizes the
+ * device, so freed blocks are kept in power-of-two bins and reused, up to
+ * caffe2_hip_pinned_memory_pool_mb of cached memory. An async copy may still
+ * be reading a block when it is freed, so an event is recorded on the current
+ * streams of the freeing thread and the block is only reused once they are
+ * done.
  */
 struct PinnedCPUAllocator final : CPUAllocator
 {
     PinnedCPUAllocator() {}
     ~PinnedCPUAllocator() override {}
-    std::pair<void*, MemoryDeleter> New(size_t nbytes) override
-    {
-        void* data;
-        std::lock_guard<std::mutex> lock(HIPContext::mutex());
-        HIP_ENFORCE(hipHostMalloc(&data, nbytes));
-        memset(data, 0, nbytes);
-        return {data, Delete};
-    }
+    std::pair<void*, MemoryDeleter> New(size_t nbytes) override;
 
     MemoryDeleter GetDeleter() override { return Delete; }
 
     private:
-    static void Delete(void* data)
-    {
-        // Caffe2 uses a lazy way to figure out if one is actually going to use GPUs
-        // or not. If a HIPContext::New() call is made, inside the CUDAContext
-        // function we will switch the cpu side allocator to a PinnedCPUAllocator.
-        // But, if one calls CPUContext::New() before any HIP allocations,
-        // PinnedCPUAllocator can still delete the corresponding memory.
-        std::lock_guard<std::mutex> lock(HIPContext::mutex());
-        hipError_t err = hipHostFree(data);
-        if(err == hipErrorInvalidValue)
-        {
-            free(data);
-            // Calling hipGetLastError will reset the HIP error.
-            hipGetLastError();
-        }
-        else
-        {
-            // For all other errors, still do a HIP check.
-            HIP_ENFORCE(err);
-        }
-    }
+    static void Delete(void* data);
 };
 
 // For simplicity, we will typedef Tensor<CPUContext> to TensorCPU.
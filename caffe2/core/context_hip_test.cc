@@ -95,6 +95,25 @@ TEST(HIPContextTest, MemoryPoolAllocateDealloc)
     }
 }
 
+TEST(HIPContextTest, MemoryPoolStats)
+{
+    if(!HasHipGPU())
+        return;
+    if(GetHipMemoryPoolType() == HipMemoryPoolType::NONE)
+    {
+        LOG(ERROR) << "Choose a memory type that is not none to test memory pool.";
+        return;
+    }
+    DeviceGuard guard(0);
+    const auto before = HIPContext::MemoryPoolStats();
+    EXPECT_EQ(before.size(), NumHipDevices());
+    auto allocated = shared_from_new(HIPContext::New(1048576));
+    const auto after = HIPContext::MemoryPoolStats();
+    EXPECT_GE(after[0].allocated_bytes, before[0].allocated_bytes + 1048576);
+    EXPECT_GE(after[0].cached_bytes, after[0].allocated_bytes);
+    EXPECT_EQ(after[0].num_allocs, before[0].num_allocs + 1);
+}
+
 hipStream_t getStreamForHandle(rocblas_handle handle)
 {
     hipStream_t stream = nullptr;
@@ -163,4 +182,21 @@ TEST(HIPContextTest, TestDifferntThreadDifferentobject)
     EXPECT_NE(temp[0], temp[1]);
 }
 
+TEST(PinnedCPUAllocatorTest, ReusesFreedBlocks)
+{
+    if(!HasHipGPU())
+        return;
+    PinnedCPUAllocator allocator;
+    auto data = allocator.New(1000);
+    EXPECT_NE(data.first, nullptr);
+    data.second(data.first);
+    // Any size of the same bin gets the freed block back.
+    auto again = allocator.New(2000);
+    EXPECT_EQ(again.first, data.first);
+    again.second(again.first);
+    // Memory that is not pinned is still released.
+    auto cpu = DefaultCPUAllocator().New(10);
+    allocator.GetDeleter()(cpu.first);
+}
+
 } // namespace caffe2
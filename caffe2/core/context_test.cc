@@ -14,7 +14,10 @@
  * limitations under the License.
  */
 
+#include <atomic>
 #include <random>
+#include <stdexcept>
+#include <vector>
 
 #include "caffe2/proto/caffe2.pb.h"
 #include "caffe2/core/context.h"
@@ -50,4 +53,94 @@ TEST(CPUContextTest, TestAllocDealloc) {
   dst_data_and_deleter.second(dst_data);
 }
 
+TEST(CachingCPUAllocatorTest, SizeClasses) {
+  EXPECT_EQ(CachingCPUAllocator::SizeClass(1), 0);
+  EXPECT_EQ(CachingCPUAllocator::SizeClass(64), 0);
+  EXPECT_EQ(CachingCPUAllocator::SizeClass(65), 1);
+  EXPECT_EQ(CachingCPUAllocator::SizeClass(128), 4);
+  EXPECT_EQ(CachingCPUAllocator::SizeClass(129), 5);
+  for (size_t n = 1; n < (1 << 20); n = n * 3 / 2 + 1) {
+    auto size_class = CachingCPUAllocator::SizeClass(n);
+    EXPECT_GE(CachingCPUAllocator::SizeClassBytes(size_class), n);
+    if (size_class > 0) {
+      EXPECT_LT(CachingCPUAllocator::SizeClassBytes(size_class - 1), n);
+    }
+  }
+}
+
+TEST(CachingCPUAllocatorTest, ReusesFreedBlocks) {
+  CachingCPUAllocator alloc;
+  for (size_t nbytes : {size_t(1), size_t(1000), size_t(4 << 20)}) {
+    auto data = alloc.New(nbytes);
+    EXPECT_EQ((reinterpret_cast<size_t>(data.first) % gCaffe2Alignment), 0);
+    memset(data.first, 1, nbytes);
+    data.second(data.first);
+    // The block is in the cache of this thread and comes back.
+    auto again = alloc.New(nbytes);
+    EXPECT_EQ(again.first, data.first);
+    again.second(again.first);
+  }
+}
+
+TEST(CachingCPUAllocatorTest, UncachedLargeBlocks) {
+  CachingCPUAllocator alloc;
+  const size_t nbytes = FLAGS_caffe2_cpu_allocator_thread_cache_bytes + 1;
+  auto data = alloc.New(nbytes);
+  EXPECT_NE(data.first, nullptr);
+  static_cast<char*>(data.first)[nbytes - 1] = 1;
+  data.second(data.first);
+}
+
+TEST(CPUContextTest, ParallelForCoversRange) {
+  for (size_t range : {size_t(0), size_t(1), size_t(7), size_t(1000)}) {
+    for (size_t grain : {size_t(0), size_t(1), size_t(3), size_t(2000)}) {
+      std::vector<std::atomic<int>> visits(range);
+      for (auto& v : visits) {
+        v = 0;
+      }
+      CPUContext::ParallelFor(range, grain, [&](size_t begin, size_t end) {
+        EXPECT_LT(begin, end);
+        EXPECT_LE(end, range);
+        for (size_t i = begin; i < end; ++i) {
+          visits[i]++;
+        }
+      });
+      for (size_t i = 0; i < range; ++i) {
+        EXPECT_EQ(visits[i], 1) << "range " << range << ", grain " << grain;
+      }
+    }
+  }
+}
+
+TEST(CPUContextTest, ParallelForNested) {
+  std::atomic<int> total(0);
+  CPUContext::ParallelFor(8, 1, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      // Runs inline on the thread of the outer chunk.
+      CPUContext::ParallelFor(100, 1, [&](size_t b, size_t e) {
+        total += e - b;
+      });
+    }
+  });
+  EXPECT_EQ(total, 800);
+}
+
+TEST(CPUContextTest, ParallelForRethrows) {
+  EXPECT_THROW(
+      CPUContext::ParallelFor(
+          100,
+          1,
+          [](size_t /* begin */, size_t end) {
+            if (end == 100) {
+              throw std::runtime_error("chunk failed");
+            }
+          }),
+      std::runtime_error);
+  // The pool is still usable afterwards.
+  std::atomic<int> total(0);
+  CPUContext::ParallelFor(
+      100, 1, [&](size_t begin, size_t end) { total += end - begin; });
+  EXPECT_EQ(total, 100);
+}
+
 }  // namespace caffe2
@@ -16,7 +16,11 @@
 
 #include "caffe2/core/db.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
+#include <thread>
 
 #include "caffe2/core/blob_serialization.h"
 #include "caffe2/core/logging.h"
@@ -93,6 +97,11 @@ class MiniDBCursor : public Cursor {
     return string(value_.data(), value_len_);
   }
 
+  ValueView value_view() override {
+    CAFFE_ENFORCE(valid_, "Cursor is at invalid location!");
+    return ValueView{value_.data(), static_cast<size_t>(value_len_)};
+  }
+
   bool Valid() override { return valid_; }
 
  private:
@@ -185,6 +194,298 @@ class MiniDB : public DB {
 REGISTER_CAFFE2_DB(MiniDB, MiniDB);
 REGISTER_CAFFE2_DB(minidb, MiniDB);
 
+PrefetchingCursor::PrefetchingCursor(unique_ptr<Cursor> cursor, int depth)
+    : cursor_(std::move(cursor)), depth_(depth) {
+  CAFFE_ENFORCE_GT(depth_, 0);
+  Start();
+}
+
+PrefetchingCursor::~PrefetchingCursor() {
+  Stop();
+}
+
+void PrefetchingCursor::Seek(const string& key) {
+  Stop();
+  cursor_->Seek(key);
+  Start();
+}
+
+void PrefetchingCursor::SeekToFirst() {
+  Stop();
+  cursor_->SeekToFirst();
+  Start();
+}
+
+void PrefetchingCursor::Next() {
+  CAFFE_ENFORCE(FetchCurrent(), "Next() called past the end of the db.");
+  has_current_ = false;
+}
+
+string PrefetchingCursor::key() {
+  CAFFE_ENFORCE(FetchCurrent(), "key() called past the end of the db.");
+  return current_.first;
+}
+
+string PrefetchingCursor::value() {
+  CAFFE_ENFORCE(FetchCurrent(), "value() called past the end of the db.");
+  return current_.second;
+}
+
+ValueView PrefetchingCursor::value_view() {
+  CAFFE_ENFORCE(FetchCurrent(), "value_view() called past the end of the db.");
+  return ValueView{current_.second.data(), current_.second.size()};
+}
+
+bool PrefetchingCursor::Valid() {
+  return FetchCurrent();
+}
+
+bool PrefetchingCursor::FetchCurrent() {
+  if (has_current_) {
+    return true;
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return !queue_.empty() || done_; });
+  if (queue_.empty()) {
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    return false;
+  }
+  current_ = std::move(queue_.front());
+  queue_.pop_front();
+  has_current_ = true;
+  lock.unlock();
+  cv_.notify_all();
+  return true;
+}
+
+void PrefetchingCursor::Start() {
+  queue_.clear();
+  has_current_ = false;
+  done_ = false;
+  stop_ = false;
+  error_ = nullptr;
+  thread_ = std::thread([this] { ReadAhead(); });
+}
+
+void PrefetchingCursor::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void PrefetchingCursor::ReadAhead() {
+  try {
+    for (; cursor_->Valid(); cursor_->Next()) {
+      auto record = std::make_pair(cursor_->key(), cursor_->value());
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stop_ || queue_.size() < depth_; });
+      if (stop_) {
+        return;
+      }
+      queue_.push_back(std::move(record));
+      lock.unlock();
+      cv_.notify_all();
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_ = std::current_exception();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+  }
+  cv_.notify_all();
+}
+
+// Reads a db through one cursor and thread per segment, keeping up to
+// read_ahead records of every segment queued. Within an epoch a segment is
+// skipped once all its records were returned, so every epoch returns every
+// record of the db exactly once, in the same order.
+class ParallelDBReadAhead {
+ public:
+  ParallelDBReadAhead(
+      DB* db,
+      const vector<string>& first_keys,
+      const vector<int64_t>& sizes,
+      const int read_ahead)
+      : read_ahead_(read_ahead), segments_(first_keys.size()) {
+    for (int i = 0; i < segments_.size(); ++i) {
+      auto& segment = segments_[i];
+      segment.cursor = db->NewCursor();
+      segment.first_key = first_keys[i];
+      segment.size = sizes[i];
+      num_records_ += sizes[i];
+    }
+  }
+
+  ~ParallelDBReadAhead() {
+    Stop();
+  }
+
+  // Returns the next record in the interleaved order.
+  void Read(string* key, string* value) {
+    if (epoch_reads_ == num_records_) {
+      StartEpoch();
+    }
+    while (segments_[next_segment_].epoch_reads ==
+           segments_[next_segment_].size) {
+      next_segment_ = (next_segment_ + 1) % segments_.size();
+    }
+    auto& segment = segments_[next_segment_];
+    ++segment.epoch_reads;
+    ++epoch_reads_;
+    next_segment_ = (next_segment_ + 1) % segments_.size();
+    std::unique_lock<std::mutex> lock(segment.mutex);
+    segment.cv.wait(lock, [&segment] { return !segment.queue.empty(); });
+    *key = std::move(segment.queue.front().first);
+    *value = std::move(segment.queue.front().second);
+    segment.queue.pop_front();
+    lock.unlock();
+    segment.cv.notify_all();
+  }
+
+  // Starts reading, or goes back to the first record of every segment.
+  void Restart() {
+    Stop();
+    Start();
+  }
+
+ private:
+  struct Segment {
+    unique_ptr<Cursor> cursor;
+    string first_key;
+    int64_t size;
+    // Records returned by Read() in the current epoch.
+    int64_t epoch_reads = 0;
+    std::deque<std::pair<string, string>> queue;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread thread;
+  };
+
+  void StartEpoch() {
+    for (auto& segment : segments_) {
+      segment.epoch_reads = 0;
+    }
+    epoch_reads_ = 0;
+    next_segment_ = 0;
+  }
+
+  void Start() {
+    stop_ = false;
+    StartEpoch();
+    for (auto& segment : segments_) {
+      segment.queue.clear();
+      segment.thread = std::thread([this, &segment] { ReadSegment(&segment); });
+    }
+  }
+
+  void Stop() {
+    stop_ = true;
+    for (auto& segment : segments_) {
+      // Taking the lock makes sure the thread is either waiting, and gets
+      // the notification, or has not checked stop_ yet.
+      std::lock_guard<std::mutex> lock(segment.mutex);
+      segment.cv.notify_all();
+    }
+    for (auto& segment : segments_) {
+      if (segment.thread.joinable()) {
+        segment.thread.join();
+      }
+    }
+  }
+
+  void ReadSegment(Segment* segment) {
+    Cursor* cursor = segment->cursor.get();
+    cursor->Seek(segment->first_key);
+    int64_t position = 0;
+    while (true) {
+      CHECK(cursor->Valid()) << "Db changed while being read.";
+      auto record = std::make_pair(cursor->key(), cursor->value());
+      {
+        std::unique_lock<std::mutex> lock(segment->mutex);
+        segment->cv.wait(lock, [this, segment] {
+          return stop_ || segment->queue.size() < read_ahead_;
+        });
+        if (stop_) {
+          return;
+        }
+        segment->queue.push_back(std::move(record));
+      }
+      segment->cv.notify_all();
+      if (++position == segment->size) {
+        position = 0;
+        cursor->Seek(segment->first_key);
+      } else {
+        cursor->Next();
+      }
+    }
+  }
+
+  const int read_ahead_;
+  vector<Segment> segments_;
+  int64_t num_records_ = 0;
+  int64_t epoch_reads_ = 0;
+  int next_segment_ = 0;
+  std::atomic<bool> stop_{false};
+};
+
+void DBReader::InitializeParallel(const int32_t num_cursors) {
+  CAFFE_ENFORCE(
+      cursor_->SupportsSeek(),
+      "Reading a db with several cursors needs a db type that supports "
+      "seeking, which ",
+      db_type_,
+      " does not.");
+  // Split the records in segments of even size, starting at first_keys.
+  int64_t num_records = 0;
+  for (cursor_->SeekToFirst(); cursor_->Valid(); cursor_->Next()) {
+    ++num_records;
+  }
+  CAFFE_ENFORCE_GT(num_records, 0, "Cannot read an empty db: ", source_);
+  const int64_t num_segments = std::min<int64_t>(num_cursors, num_records);
+  vector<string> first_keys;
+  vector<int64_t> sizes;
+  int64_t position = 0;
+  cursor_->SeekToFirst();
+  for (int64_t i = 0; i < num_segments; ++i) {
+    const int64_t begin = i * num_records / num_segments;
+    const int64_t end = (i + 1) * num_records / num_segments;
+    for (; position < begin; ++position) {
+      cursor_->Next();
+    }
+    first_keys.push_back(cursor_->key());
+    sizes.push_back(end - begin);
+  }
+  constexpr int kReadAhead = 16;
+  parallel_ = std::make_shared<ParallelDBReadAhead>(
+      db_.get(), first_keys, sizes, kReadAhead);
+  RestartParallel();
+}
+
+void DBReader::ReadParallel(string* key, string* value) const {
+  parallel_->Read(key, value);
+  string skipped_key, skipped_value;
+  for (int s = 1; s < num_shards_; ++s) {
+    parallel_->Read(&skipped_key, &skipped_value);
+  }
+}
+
+void DBReader::RestartParallel() const {
+  parallel_->Restart();
+  string skipped_key, skipped_value;
+  for (int s = 0; s < shard_id_; ++s) {
+    parallel_->Read(&skipped_key, &skipped_value);
+  }
+}
+
 void DBReaderSerializer::Serialize(
     const Blob& blob,
     const string& name,
@@ -195,7 +496,9 @@ void DBReaderSerializer::Serialize(
   proto.set_name(name);
   proto.set_source(reader.source_);
   proto.set_db_type(reader.db_type_);
-  if (reader.cursor() && reader.cursor()->SupportsSeek()) {
+  // The position of a parallel reader is not a single key, it restarts from
+  // the beginning.
+  if (!reader.parallel_ && reader.cursor() && reader.cursor()->SupportsSeek()) {
     proto.set_key(reader.cursor()->key());
   }
   BlobProto blob_proto;
@@ -17,7 +17,11 @@
 #ifndef CAFFE2_CORE_DB_H_
 #define CAFFE2_CORE_DB_H_
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <mutex>
+#include <thread>
 
 #include "caffe2/core/blob_serialization.h"
 #include "caffe2/core/registry.h"
@@ -32,6 +36,14 @@ namespace db {
  */
 enum Mode { READ, WRITE, NEW };
 
+/**
+ * A non-owning view of a record value, see Cursor::value_view().
+ */
+struct ValueView {
+  const char* data;
+  size_t size;
+};
+
 /**
  * An abstract class for the cursor of the database while reading.
  */
@@ -62,12 +74,26 @@ class Cursor {
    * Returns the current value.
    */
   virtual string value() = 0;
+  /**
+   * Returns a view of the current value, which stays valid until the cursor
+   * moves or value_view() is called again. Databases that can expose their
+   * own storage (mmapped pages, iterator slices) override this to avoid the
+   * copy made by value(); the default implementation keeps that copy in the
+   * cursor.
+   */
+  virtual ValueView value_view() {
+    value_view_buffer_ = value();
+    return ValueView{value_view_buffer_.data(), value_view_buffer_.size()};
+  }
   /**
    * Returns whether the current location is valid - for example, if we have
    * reached the end of the database, return false.
    */
   virtual bool Valid() = 0;
 
+ private:
+  string value_view_buffer_;
+
   DISABLE_COPY_AND_ASSIGN(Cursor);
 };
 
@@ -154,8 +180,65 @@ inline bool DBExists(const string& db_type, const string& full_db_name) {
   }
 }
 
+/**
+ * A cursor that reads up to `depth` records ahead of another cursor on a
+ * background thread, so that the latency of fetching a record (for example
+ * page faults of a memory-mapped db on network storage) overlaps with the
+ * work of the caller instead of stalling every Next().
+ *
+ * Seek() and SeekToFirst() drop the records read ahead and restart the read
+ * ahead from the new position. Errors of the wrapped cursor are rethrown
+ * when the record that caused them is reached.
+ */
+class PrefetchingCursor : public Cursor {
+ public:
+  PrefetchingCursor(unique_ptr<Cursor> cursor, int depth);
+  ~PrefetchingCursor() override;
+
+  void Seek(const string& key) override;
+  bool SupportsSeek() override { return cursor_->SupportsSeek(); }
+  void SeekToFirst() override;
+  void Next() override;
+  string key() override;
+  string value() override;
+  ValueView value_view() override;
+  bool Valid() override;
+
+ private:
+  void Start();
+  void Stop();
+  void ReadAhead();
+  // Moves the next record read ahead to current_, waiting for it if needed.
+  // Returns false at the end of the wrapped cursor.
+  bool FetchCurrent();
+
+  unique_ptr<Cursor> cursor_;
+  const int depth_;
+  std::pair<string, string> current_;
+  bool has_current_ = false;
+  std::deque<std::pair<string, string>> queue_;
+  bool done_ = false;
+  bool stop_ = false;
+  std::exception_ptr error_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::thread thread_;
+
+  DISABLE_COPY_AND_ASSIGN(PrefetchingCursor);
+};
+
+class ParallelDBReadAhead;
+
 /**
  * A reader wrapper for DB that also allows us to serialize it.
+ *
+ * With num_cursors > 1, the records are split into num_cursors contiguous
+ * segments of even size, each read ahead by its own cursor and thread, and
+ * Read() returns them interleaved round robin over the segments: the first
+ * record of every segment, then the second one of every segment, and so on,
+ * skipping the segments that are done. Every epoch thus returns every record
+ * once, in an order that only depends on the db and num_cursors. This needs a
+ * db that supports seeking.
  */
 class DBReader {
  public:
@@ -167,8 +250,9 @@ class DBReader {
       const string& db_type,
       const string& source,
       const int32_t num_shards = 1,
-      const int32_t shard_id = 0) {
-    Open(db_type, source, num_shards, shard_id);
+      const int32_t shard_id = 0,
+      const int32_t num_cursors = 1) {
+    Open(db_type, source, num_shards, shard_id, num_cursors);
   }
 
   explicit DBReader(const DBReaderProto& proto) {
@@ -195,27 +279,31 @@ class DBReader {
       const string& db_type,
       const string& source,
       const int32_t num_shards = 1,
-      const int32_t shard_id = 0) {
+      const int32_t shard_id = 0,
+      const int32_t num_cursors = 1) {
     // Note(jiayq): resetting is needed when we re-open e.g. leveldb where no
     // concurrent access is allowed.
+    parallel_.reset();
     cursor_.reset();
     db_.reset();
     db_type_ = db_type;
     source_ = source;
     db_ = CreateDB(db_type_, source_, READ);
     CAFFE_ENFORCE(db_, "Cannot open db: ", source_, " of type ", db_type_);
-    InitializeCursor(num_shards, shard_id);
+    InitializeCursor(num_shards, shard_id, num_cursors);
   }
 
   void Open(
       unique_ptr<DB>&& db,
       const int32_t num_shards = 1,
-      const int32_t shard_id = 0) {
+      const int32_t shard_id = 0,
+      const int32_t num_cursors = 1) {
+    parallel_.reset();
     cursor_.reset();
     db_.reset();
     db_ = std::move(db);
     CAFFE_ENFORCE(db_.get(), "Passed null db");
-    InitializeCursor(num_shards, shard_id);
+    InitializeCursor(num_shards, shard_id, num_cursors);
   }
 
  public:
@@ -238,17 +326,36 @@ class DBReader {
   void Read(string* key, string* value) const {
     CAFFE_ENFORCE(cursor_ != nullptr, "Reader not initialized.");
     std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
+    if (parallel_) {
+      ReadParallel(key, value);
+      return;
+    }
     *key = cursor_->key();
-    *value = cursor_->value();
+    // Assigning from the view reuses the capacity of value.
+    const auto view = cursor_->value_view();
+    value->assign(view.data, view.size);
+    MoveToNext();
+  }
 
-    // In sharded mode, each read skips num_shards_ records
-    for (int s = 0; s < num_shards_; s++) {
-      cursor_->Next();
-      if (!cursor_->Valid()) {
-        MoveToBeginning();
-        break;
-      }
+  /**
+   * Like Read(), but instead of copying the value, calls consume(data, size)
+   * with a view of it before the cursor moves. Thread safe; consume runs
+   * under the reader lock, so it should only parse the value, e.g. with
+   * ParseFromArray().
+   */
+  template <typename Consumer>
+  void ReadView(string* key, Consumer&& consume) const {
+    CAFFE_ENFORCE(cursor_ != nullptr, "Reader not initialized.");
+    std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
+    if (parallel_) {
+      ReadParallel(key, &parallel_value_);
+      consume(parallel_value_.data(), parallel_value_.size());
+      return;
     }
+    *key = cursor_->key();
+    const auto view = cursor_->value_view();
+    consume(view.data, view.size);
+    MoveToNext();
   }
 
   /**
@@ -257,6 +364,10 @@ class DBReader {
   void SeekToFirst() const {
     CAFFE_ENFORCE(cursor_ != nullptr, "Reader not initialized.");
     std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
+    if (parallel_) {
+      RestartParallel();
+      return;
+    }
     MoveToBeginning();
   }
 
@@ -274,16 +385,41 @@ class DBReader {
   }
 
  private:
-  void InitializeCursor(const int32_t num_shards, const int32_t shard_id) {
+  void InitializeCursor(
+      const int32_t num_shards,
+      const int32_t shard_id,
+      const int32_t num_cursors = 1) {
     CAFFE_ENFORCE(num_shards >= 1);
     CAFFE_ENFORCE(shard_id >= 0);
     CAFFE_ENFORCE(shard_id < num_shards);
+    CAFFE_ENFORCE(num_cursors >= 1);
     num_shards_ = num_shards;
     shard_id_ = shard_id;
     cursor_ = db_->NewCursor();
+    if (num_cursors > 1) {
+      InitializeParallel(num_cursors);
+      return;
+    }
     SeekToFirst();
   }
 
+  // Parallel mode, implemented in db.cc. Reads skip num_shards_ records of
+  // the interleaved sequence, like MoveToNext() does on the cursor.
+  void InitializeParallel(const int32_t num_cursors);
+  void ReadParallel(string* key, string* value) const;
+  void RestartParallel() const;
+
+  // In sharded mode, each read skips num_shards_ records.
+  void MoveToNext() const {
+    for (int s = 0; s < num_shards_; s++) {
+      cursor_->Next();
+      if (!cursor_->Valid()) {
+        MoveToBeginning();
+        break;
+      }
+    }
+  }
+
   void MoveToBeginning() const {
     cursor_->SeekToFirst();
     for (auto s = 0; s < shard_id_; s++) {
@@ -297,6 +433,9 @@ class DBReader {
   string source_;
   unique_ptr<DB> db_;
   unique_ptr<Cursor> cursor_;
+  // A shared_ptr, as the type is only complete in db.cc.
+  std::shared_ptr<ParallelDBReadAhead> parallel_;
+  mutable string parallel_value_;
   mutable std::mutex reader_mutex_;
   uint32_t num_shards_;
   uint32_t shard_id_;
@@ -27,6 +27,7 @@ EventQueryFunction Event::event_querier_[MaxDeviceTypes];
 EventErrorMessageFunction Event::event_err_msg_getter_[MaxDeviceTypes];
 EventSetFinishedFunction Event::event_finished_setter_[MaxDeviceTypes];
 EventResetFunction Event::event_resetter_[MaxDeviceTypes];
+EventSetCallbackFunction Event::event_callback_setter_[MaxDeviceTypes];
 
 namespace {
 const std::string kNoError = "No error";
@@ -17,6 +17,8 @@
 #ifndef CAFFE2_CORE_EVENT_H_
 #define CAFFE2_CORE_EVENT_H_
 
+#include <functional>
+
 #include "caffe2/core/common.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/proto/caffe2.pb.h"
@@ -63,6 +65,13 @@ typedef const std::string& (*EventErrorMessageFunction)(const Event*);
 typedef void (*EventSetFinishedFunction)(const Event*, const char*);
 typedef void (*EventResetFunction)(Event*);
 
+// Runs the callback once the operation is fully finished without blocking the
+// caller, e.g. from a stream callback of the device runtime, or right away if
+// the operation is already done. The callback must not call into the device
+// runtime. Optional, see Event::SupportsCallback().
+// Can be called concurrently from multiple threads
+typedef void (*EventSetCallbackFunction)(const Event*, std::function<void()>);
+
 class Event {
  public:
   explicit Event(const DeviceOption& option)
@@ -132,6 +141,15 @@ class Event {
     return event_finished_setter_[type_](this, err_msg);
   }
 
+  bool SupportsCallback() const {
+    return event_callback_setter_[type_] != nullptr;
+  }
+
+  void SetCallback(std::function<void()> callback) const {
+    CAFFE_ENFORCE(event_callback_setter_[type_]);
+    event_callback_setter_[type_](this, std::move(callback));
+  }
+
   // If parent op has succeeded, then we can run any child op;
   // If parent op is in scheduled state, we need to check that:
   //  - child op supports async scheduling
@@ -181,6 +199,7 @@ class Event {
   static EventErrorMessageFunction event_err_msg_getter_[MaxDeviceTypes];
   static EventSetFinishedFunction event_finished_setter_[MaxDeviceTypes];
   static EventResetFunction event_resetter_[MaxDeviceTypes];
+  static EventSetCallbackFunction event_callback_setter_[MaxDeviceTypes];
 
   template <int d>
   friend struct EventCreateFunctionRegisterer;
@@ -199,6 +218,8 @@ class Event {
   friend struct EventSetFinishedFunctionRegisterer;
   template <int d>
   friend struct EventResetFunctionRegisterer;
+  template <int d>
+  friend struct EventSetCallbackFunctionRegisterer;
 };
 
 template <int d>
@@ -298,6 +319,18 @@ struct EventResetFunctionRegisterer {
   static EventResetFunctionRegisterer<d> g_event_reset_##d(f); \
   }
 
+template <int d>
+struct EventSetCallbackFunctionRegisterer {
+  explicit EventSetCallbackFunctionRegisterer(EventSetCallbackFunction f) {
+    static_assert(d < MaxDeviceTypes, "");
+    Event::event_callback_setter_[d] = f;
+  }
+};
+#define REGISTER_EVENT_SET_CALLBACK_FUNCTION(d, f)                          \
+  namespace {                                                               \
+  static EventSetCallbackFunctionRegisterer<d> g_event_set_callback_##d(f); \
+  }
+
 } // namespace caffe2
 
 #endif // CAFFE2_CORE_EVENT_H_
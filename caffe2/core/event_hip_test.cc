@@ -1,4 +1,7 @@
 #include <gtest/gtest.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include "caffe2/core/context.h"
 #include "caffe2/core/context_hip.h"
 #include "caffe2/core/event.h"
@@ -48,4 +51,62 @@ TEST(EventHIPTest, EventBasics)
     context_hip.WaitEvent(event_cpu);
 }
 
+TEST(EventHIPTest, EventCallback)
+{
+    if(!HasHipGPU())
+        return;
+    DeviceOption device_hip;
+    device_hip.set_device_type(HIP);
+    HIPContext context_hip(device_hip);
+    Event event_hip(device_hip);
+    EXPECT_TRUE(event_hip.SupportsCallback());
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    int calls = 0;
+    auto callback = [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++calls;
+        cv.notify_all();
+    };
+
+    context_hip.SwitchToDevice();
+    context_hip.Record(&event_hip);
+    event_hip.SetCallback(callback);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return calls == 1; });
+    }
+    event_hip.Finish();
+
+    // Finished events call back right away
+    event_hip.SetCallback(callback);
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(calls, 2);
+}
+
+TEST(EventHIPTest, EventQueryPolling)
+{
+    if(!HasHipGPU())
+        return;
+    DeviceOption device_hip;
+    device_hip.set_device_type(HIP);
+    HIPContext context_hip(device_hip);
+    Event event_hip(device_hip);
+
+    // Not recorded yet, the query returns right away
+    EXPECT_EQ(event_hip.Query(), EventStatus::EVENT_INITIALIZED);
+
+    context_hip.SwitchToDevice();
+    context_hip.Record(&event_hip);
+    EventStatus status = event_hip.Query();
+    while(status == EventStatus::EVENT_SCHEDULED)
+    {
+        std::this_thread::yield();
+        status = event_hip.Query();
+    }
+    EXPECT_EQ(status, EventStatus::EVENT_SUCCESS);
+    EXPECT_EQ(event_hip.ErrorMessage(), "No error");
+}
+
 } // namespace caffe2
@@ -92,19 +92,21 @@ const std::vector<std::pair<string, int>> Graph::GetSubgraphPerimeterHelper(
     const std::vector<int>& match) {
   std::vector<std::pair<string, int>> edge_list;
   std::unordered_set<int> match_set(match.begin(), match.end());
-  for (int x = 0; x < nodes_.size(); x++) {
-    if (!is_node_active(x)) {
-      continue;
-    }
-    if (!match_set.count(x)) { // x is not in subgraph
+  // Only the neighbors of the subgraph can be on its perimeter, so look at
+  // those rather than at every node of the graph.
+  for (int m : match) {
+    const auto& neighbors = from_children ? node(m).parents : node(m).children;
+    for (const auto& edge : neighbors) {
+      int x = edge.first;
+      if (match_set.count(x) || !is_node_active(x)) {
+        continue;
+      }
+      // x is not in subgraph, but is connected to m, which is.
       const auto& list = from_children ? node(x).children : node(x).parents;
-      for (const auto& edge : list) {
-        int parent = edge.first;
-        const auto& blobs = edge.second;
-        if (match_set.count(parent)) { // but has a parent that is in subgraph
-          for (const string& blob : blobs) {
-            edge_list.push_back({blob, x});
-          }
+      auto it = list.find(m);
+      if (it != list.end()) {
+        for (const string& blob : it->second) {
+          edge_list.push_back({blob, x});
         }
       }
     }
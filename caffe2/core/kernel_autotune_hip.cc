@@ -0,0 +1,240 @@
+#include "caffe2/core/kernel_autotune_hip.h"
+
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+CAFFE2_DEFINE_bool(caffe2_hip_kernel_autotune,
+                   false,
+                   "If set, HIP kernels launched through HipTunedLaunch benchmark their "
+                   "candidate launch configurations on first use for each size bucket "
+                   "and keep the fastest one.");
+CAFFE2_DEFINE_string(caffe2_hip_kernel_autotune_cache_file,
+                     "",
+                     "If set, the HIP kernel launch configurations picked by the "
+                     "autotuner are loaded from and appended to this file, so that "
+                     "later runs can skip the benchmark.");
+
+namespace caffe2 {
+
+namespace {
+
+// Number of timed launches per candidate, after one warm-up launch.
+constexpr int kBenchmarkRuns = 3;
+
+} // namespace
+
+std::vector<HipLaunchConfig> DefaultHipLaunchCandidates(const int device)
+{
+    const auto& prop = GetDeviceProperty(device);
+    std::vector<HipLaunchConfig> candidates{HipLaunchConfig()};
+    for(int threads : {128, 256, 512, 1024})
+    {
+        if(threads > prop.maxThreadsPerBlock)
+        {
+            continue;
+        }
+        for(int waves : {0, 4, 16})
+        {
+            HipLaunchConfig config(
+                threads, waves == 0 ? CAFFE_MAXIMUM_NUM_BLOCKS : waves * prop.multiProcessorCount);
+            if(std::find(candidates.begin(), candidates.end(), config) == candidates.end())
+            {
+                candidates.push_back(config);
+            }
+        }
+    }
+    return candidates;
+}
+
+HipKernelTuner& HipKernelTuner::Get()
+{
+    // New it (never delete) so that kernels launched during static
+    // destruction can still reach the cache.
+    static auto* tuner = new HipKernelTuner();
+    return *tuner;
+}
+
+HipKernelTuner::HipKernelTuner() : cache_file_(FLAGS_caffe2_hip_kernel_autotune_cache_file)
+{
+    if(!cache_file_.empty())
+    {
+        auto n = Load(cache_file_);
+        VLOG(1) << "Loaded " << n << " HIP kernel launch configurations from " << cache_file_;
+    }
+}
+
+HipLaunchConfig HipKernelTuner::Choose(const std::string& kernel,
+                                       const int n,
+                                       hipStream_t stream,
+                                       const Launch& launch,
+                                       const std::vector<HipLaunchConfig>& candidates)
+{
+    HipLaunchConfig config;
+    if(!FLAGS_caffe2_hip_kernel_autotune || n <= 0)
+    {
+        return config;
+    }
+    const int device = CaffeHipGetDevice();
+    const std::string key = HipKernelTuneKey(kernel, device, n);
+    if(lookup(key, &config))
+    {
+        return config;
+    }
+    std::lock_guard<std::mutex> lock(benchmark_mutex_);
+    // Another thread may have tuned the bucket while we were waiting.
+    if(lookup(key, &config))
+    {
+        return config;
+    }
+    config = Benchmark(key,
+                       n,
+                       stream,
+                       launch,
+                       candidates.empty() ? DefaultHipLaunchCandidates(device) : candidates);
+    insert(key, config);
+    return config;
+}
+
+HipLaunchConfig HipKernelTuner::Benchmark(const std::string& key,
+                                          const int n,
+                                          hipStream_t stream,
+                                          const Launch& launch,
+                                          const std::vector<HipLaunchConfig>& candidates)
+{
+    hipEvent_t start, stop;
+    HIP_ENFORCE(hipEventCreate(&start));
+    HIP_ENFORCE(hipEventCreate(&stop));
+    HipLaunchConfig best;
+    float best_ms = std::numeric_limits<float>::max();
+    for(const auto& config : candidates)
+    {
+        if(config.blocks(n) <= 0)
+        {
+            continue;
+        }
+        launch(config);
+        HIP_ENFORCE(hipEventRecord(start, stream));
+        for(int i = 0; i < kBenchmarkRuns; ++i)
+        {
+            launch(config);
+        }
+        HIP_ENFORCE(hipEventRecord(stop, stream));
+        HIP_ENFORCE(hipEventSynchronize(stop));
+        // A configuration the kernel cannot be launched with (too many
+        // registers for the block size, say) is skipped.
+        if(hipGetLastError() != hipSuccess)
+        {
+            VLOG(1) << key << ": cannot launch with " << config.threads << " threads";
+            continue;
+        }
+        float ms = 0;
+        HIP_ENFORCE(hipEventElapsedTime(&ms, start, stop));
+        if(ms < best_ms)
+        {
+            best_ms = ms;
+            best    = config;
+        }
+    }
+    HIP_ENFORCE(hipEventDestroy(start));
+    HIP_ENFORCE(hipEventDestroy(stop));
+    VLOG(1) << key << ": picked " << best.threads << " threads, at most " << best.max_blocks
+            << " blocks (" << best_ms / kBenchmarkRuns << " ms)";
+    return best;
+}
+
+bool HipKernelTuner::lookup(const std::string& key, HipLaunchConfig* config)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = configs_.find(key);
+    if(it == configs_.end())
+    {
+        return false;
+    }
+    *config = it->second;
+    return true;
+}
+
+void HipKernelTuner::insert(const std::string& key, const HipLaunchConfig& config)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = configs_.find(key);
+    if(it != configs_.end() && it->second == config)
+    {
+        return;
+    }
+    configs_[key] = config;
+    if(!cache_file_.empty())
+    {
+        Append(key, config);
+    }
+}
+
+size_t HipKernelTuner::size()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return configs_.size();
+}
+
+void HipKernelTuner::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    configs_.clear();
+}
+
+size_t HipKernelTuner::Load(const std::string& path)
+{
+    std::ifstream in(path);
+    if(!in.is_open())
+    {
+        VLOG(1) << "HIP kernel autotune cache file " << path << " does not exist yet.";
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    std::string key;
+    HipLaunchConfig config;
+    // Each line is "<key> <threads> <max_blocks>". Later lines win.
+    while(in >> key >> config.threads >> config.max_blocks)
+    {
+        configs_[key] = config;
+        ++count;
+    }
+    return count;
+}
+
+void HipKernelTuner::Save(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ofstream out(path, std::ios::trunc);
+    CAFFE_ENFORCE(out.is_open(), "Cannot open HIP kernel autotune cache file ", path);
+    for(const auto& kv : configs_)
+    {
+        out << kv.first << " " << kv.second.threads << " " << kv.second.max_blocks << "\n";
+    }
+}
+
+void HipKernelTuner::Append(const std::string& key, const HipLaunchConfig& config)
+{
+    std::ofstream out(cache_file_, std::ios::app);
+    if(!out.is_open())
+    {
+        LOG(WARNING) << "Cannot write HIP kernel autotune cache file " << cache_file_;
+        return;
+    }
+    out << key << " " << config.threads << " " << config.max_blocks << "\n";
+}
+
+std::string HipKernelTuneKey(const std::string& kernel, const int device, const int n)
+{
+    int bucket = 1;
+    while(bucket < n && bucket < (1 << 30))
+    {
+        bucket <<= 1;
+    }
+    std::stringstream ss;
+    ss << kernel << ";gfx" << GetDeviceProperty(device).gcnArch << ";" << bucket;
+    return ss.str();
+}
+
+} // namespace caffe2
@@ -0,0 +1,148 @@
+#ifndef CAFFE2_CORE_KERNEL_AUTOTUNE_HIP_H_
+#define CAFFE2_CORE_KERNEL_AUTOTUNE_HIP_H_
+
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "caffe2/core/common_hip.h"
+#include "caffe2/core/flags.h"
+
+CAFFE2_DECLARE_bool(caffe2_hip_kernel_autotune);
+CAFFE2_DECLARE_string(caffe2_hip_kernel_autotune_cache_file);
+
+namespace caffe2 {
+
+/**
+ * The launch configuration of a 1D grid-stride kernel (one written with
+ * HIP_1D_KERNEL_LOOP): the block size, and the maximum number of blocks the
+ * grid is capped at. The default is the one of CAFFE_GET_BLOCKS.
+ */
+struct HipLaunchConfig
+{
+    int threads    = CAFFE_HIP_NUM_THREADS;
+    int max_blocks = CAFFE_MAXIMUM_NUM_BLOCKS;
+
+    HipLaunchConfig() {}
+    HipLaunchConfig(int t, int b) : threads(t), max_blocks(b) {}
+
+    int blocks(const int n) const { return std::min((n + threads - 1) / threads, max_blocks); }
+    bool operator==(const HipLaunchConfig& other) const
+    {
+        return threads == other.threads && max_blocks == other.max_blocks;
+    }
+};
+
+/**
+ * The candidates tried for a kernel that does not provide its own: block
+ * sizes from 128 to 1024 threads, with the default grid cap and with one of
+ * a few waves of blocks per compute unit of the given device. The default
+ * configuration comes first.
+ */
+std::vector<HipLaunchConfig> DefaultHipLaunchCandidates(const int device);
+
+/**
+ * A process-wide cache of the launch configurations picked for HIP kernels.
+ *
+ * When --caffe2_hip_kernel_autotune is set, the first launch of a kernel for
+ * a given size bucket (the next power of two of its number of items) on a
+ * given GPU architecture benchmarks every candidate configuration on the
+ * launching stream, and the fastest one is used for all later launches of
+ * that bucket. The best block size and grid differ between MI25, MI50 and
+ * MI100 class GPUs, so the key includes the gcnArch of the device (see
+ * HipKernelTuneKey).
+ *
+ * If --caffe2_hip_kernel_autotune_cache_file is set, the cache is loaded
+ * from that file on first use and every new choice is appended to it, in
+ * the same way as MIOPENConvAlgoCache, so a warm restart does not benchmark
+ * again. Entries of other architectures are kept, one file can be shared by
+ * machines with different GPUs.
+ *
+ * The benchmark runs the kernel several times, so only kernels whose outputs
+ * do not alias their inputs can be tuned; HipTunedLaunch takes a flag for
+ * that.
+ */
+class HipKernelTuner
+{
+    public:
+    using Launch = std::function<void(const HipLaunchConfig&)>;
+
+    static HipKernelTuner& Get();
+
+    // Returns the configuration to launch kernel with on n items, running the
+    // benchmark through launch on stream if the bucket has not been tuned
+    // yet. Returns the default configuration when tuning is disabled.
+    HipLaunchConfig Choose(const std::string& kernel,
+                           const int n,
+                           hipStream_t stream,
+                           const Launch& launch,
+                           const std::vector<HipLaunchConfig>& candidates = {});
+
+    bool lookup(const std::string& key, HipLaunchConfig* config);
+    void insert(const std::string& key, const HipLaunchConfig& config);
+    size_t size();
+    void clear();
+
+    // Loads the entries stored in path, overriding existing ones. Returns
+    // the number of entries read.
+    size_t Load(const std::string& path);
+    // Writes all entries to path, replacing its content.
+    void Save(const std::string& path);
+
+    private:
+    HipKernelTuner();
+    HipLaunchConfig Benchmark(const std::string& key,
+                              const int n,
+                              hipStream_t stream,
+                              const Launch& launch,
+                              const std::vector<HipLaunchConfig>& candidates);
+    void Append(const std::string& key, const HipLaunchConfig& config);
+
+    std::mutex mutex_;
+    // Serializes the benchmarks, so two threads launching the same kernel
+    // do not time it concurrently.
+    std::mutex benchmark_mutex_;
+    std::unordered_map<std::string, HipLaunchConfig> configs_;
+    std::string cache_file_;
+    DISABLE_COPY_AND_ASSIGN(HipKernelTuner);
+};
+
+/**
+ * Builds the cache key of kernel on n items on the given device, e.g.
+ * "Exp_float;gfx906;65536".
+ */
+std::string HipKernelTuneKey(const std::string& kernel, const int device, const int n);
+
+/**
+ * Launches a kernel through launch with the configuration tuned for n items.
+ * Pass tunable = false when the kernel runs in place or otherwise reads what
+ * it writes; it is then launched with the default configuration, or with the
+ * one already tuned for the bucket.
+ */
+template <typename F>
+void HipTunedLaunch(
+    const char* kernel, const int n, hipStream_t stream, const bool tunable, F launch)
+{
+    if(!FLAGS_caffe2_hip_kernel_autotune)
+    {
+        launch(HipLaunchConfig());
+        return;
+    }
+    HipLaunchConfig config;
+    if(tunable)
+    {
+        config = HipKernelTuner::Get().Choose(kernel, n, stream, launch);
+    }
+    else
+    {
+        HipKernelTuner::Get().lookup(HipKernelTuneKey(kernel, CaffeHipGetDevice(), n), &config);
+    }
+    launch(config);
+}
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_KERNEL_AUTOTUNE_HIP_H_
@@ -0,0 +1,107 @@
+#include <cstdio>
+
+#include <gtest/gtest.h>
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/kernel_autotune_hip.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+class HipKernelTunerTest : public ::testing::Test
+{
+    protected:
+    void SetUp() override
+    {
+        FLAGS_caffe2_hip_kernel_autotune = true;
+        HipKernelTuner::Get().clear();
+    }
+
+    void TearDown() override
+    {
+        FLAGS_caffe2_hip_kernel_autotune = false;
+        HipKernelTuner::Get().clear();
+    }
+};
+} // namespace
+
+TEST_F(HipKernelTunerTest, KeyBuckets)
+{
+    if(!HasHipGPU())
+        return;
+    EXPECT_EQ(HipKernelTuneKey("k", 0, 1000), HipKernelTuneKey("k", 0, 1024));
+    EXPECT_NE(HipKernelTuneKey("k", 0, 1024), HipKernelTuneKey("k", 0, 1025));
+    EXPECT_NE(HipKernelTuneKey("k", 0, 1024), HipKernelTuneKey("other", 0, 1024));
+}
+
+TEST_F(HipKernelTunerTest, BenchmarksOncePerBucket)
+{
+    if(!HasHipGPU())
+        return;
+    DeviceGuard guard(0);
+    std::vector<HipLaunchConfig> candidates{HipLaunchConfig(), HipLaunchConfig(256, 1024)};
+    int launches = 0;
+    auto launch  = [&](const HipLaunchConfig&) { ++launches; };
+    auto& tuner  = HipKernelTuner::Get();
+    auto config  = tuner.Choose("counting", 1000, 0, launch, candidates);
+    EXPECT_TRUE(config == candidates[0] || config == candidates[1]);
+    EXPECT_GT(launches, 2);
+    EXPECT_EQ(tuner.size(), 1u);
+
+    launches = 0;
+    EXPECT_TRUE(tuner.Choose("counting", 900, 0, launch, candidates) == config);
+    EXPECT_EQ(launches, 0);
+
+    FLAGS_caffe2_hip_kernel_autotune = false;
+    EXPECT_TRUE(tuner.Choose("counting", 5000, 0, launch, candidates) == HipLaunchConfig());
+    EXPECT_EQ(launches, 0);
+}
+
+TEST_F(HipKernelTunerTest, SaveAndLoad)
+{
+    if(!HasHipGPU())
+        return;
+    auto& tuner = HipKernelTuner::Get();
+    tuner.insert("a;gfx900;64", HipLaunchConfig(128, 64));
+    tuner.insert("b;gfx906;1024", HipLaunchConfig(1024, 4096));
+    const std::string path = std::tmpnam(nullptr);
+    tuner.Save(path);
+    tuner.clear();
+    EXPECT_EQ(tuner.Load(path), 2u);
+    HipLaunchConfig config;
+    EXPECT_TRUE(tuner.lookup("a;gfx900;64", &config));
+    EXPECT_EQ(config.threads, 128);
+    EXPECT_EQ(config.max_blocks, 64);
+    std::remove(path.c_str());
+}
+
+TEST_F(HipKernelTunerTest, TunedMathKernels)
+{
+    if(!HasHipGPU())
+        return;
+    DeviceOption option;
+    option.set_device_type(HIP);
+    HIPContext context(option);
+    const int N = 3000;
+    TensorCPU host(vector<TIndex>{N});
+    for(int i = 0; i < N; ++i)
+    {
+        host.mutable_data<float>()[i] = 0.001f * i;
+    }
+    TensorHIP x(host, &context);
+    TensorHIP y(vector<TIndex>{N});
+    math::Add<float, HIPContext>(
+        N, x.data<float>(), x.data<float>(), y.mutable_data<float>(), &context);
+    // In place, the kernel runs once with the configuration tuned above.
+    math::Add<float, HIPContext>(
+        N, y.data<float>(), x.data<float>(), y.mutable_data<float>(), &context);
+    TensorCPU result(y, &context);
+    context.FinishDeviceComputation();
+    for(int i = 0; i < N; ++i)
+    {
+        EXPECT_FLOAT_EQ(result.data<float>()[i], 3 * host.data<float>()[i]);
+    }
+}
+
+} // namespace caffe2
@@ -16,6 +16,9 @@
 
 #include "caffe2/core/memonger.h"
 
+#include <algorithm>
+#include <cmath>
+#include <map>
 #include <set>
 #include <unordered_set>
 
@@ -606,5 +609,482 @@ NetDef compute_blob_recycling_for_dag(
       blob_shapes);
 }
 
+StaticMemoryPlan plan_static_memory(
+    const NetDef& net,
+    const std::unordered_map<string, size_t>& blob_bytes,
+    size_t alignment) {
+  CAFFE_ENFORCE(
+      net.type() == "" || net.type() == "simple",
+      "Static memory planning needs ops to run in order, got a net of type ",
+      net.type());
+
+  // Step 1: lifetime of each blob, as [first op, last op]
+  std::unordered_map<string, std::pair<int, int>> ranges;
+  for (int i = 0; i < net.op_size(); i++) {
+    for (const auto& inp : net.op(i).input()) {
+      auto it = ranges.find(inp);
+      if (it != ranges.end()) {
+        it->second.second = i;
+      }
+    }
+    for (const auto& outp : net.op(i).output()) {
+      if (blob_bytes.count(outp) && !ranges.count(outp)) {
+        ranges[outp] = std::make_pair(i, i);
+      } else if (ranges.count(outp)) {
+        ranges[outp].second = i;
+      }
+    }
+  }
+  for (const auto& outp : net.external_output()) {
+    auto it = ranges.find(outp);
+    if (it != ranges.end()) {
+      it->second.second = net.op_size();
+    }
+  }
+
+  // Step 2: place the blobs largest first, each at the lowest offset not
+  // used by an already placed blob that is alive at the same time
+  std::vector<string> blobs;
+  for (const auto& range : ranges) {
+    blobs.push_back(range.first);
+  }
+  std::sort(blobs.begin(), blobs.end(), [&](const string& a, const string& b) {
+    const auto size_a = blob_bytes.at(a);
+    const auto size_b = blob_bytes.at(b);
+    return size_a != size_b ? size_a > size_b : a < b;
+  });
+
+  StaticMemoryPlan plan;
+  std::vector<string> placed;
+  for (const auto& blob : blobs) {
+    const auto& range = ranges[blob];
+    const size_t size =
+        (blob_bytes.at(blob) + alignment - 1) / alignment * alignment;
+    std::vector<std::pair<size_t, size_t>> used;
+    for (const auto& other : placed) {
+      const auto& other_range = ranges[other];
+      if (other_range.first <= range.second &&
+          range.first <= other_range.second) {
+        const auto offset = plan.offsets[other];
+        used.emplace_back(
+            offset,
+            offset +
+                (blob_bytes.at(other) + alignment - 1) / alignment * alignment);
+      }
+    }
+    std::sort(used.begin(), used.end());
+    size_t offset = 0;
+    for (const auto& interval : used) {
+      if (offset + size <= interval.first) {
+        break;
+      }
+      offset = std::max(offset, interval.second);
+    }
+    plan.offsets[blob] = offset;
+    plan.arena_bytes = std::max(plan.arena_bytes, offset + size);
+    placed.push_back(blob);
+  }
+  return plan;
+}
+
+namespace {
+
+// Ops whose outputs differ from one run to the next, rerunning them would not
+// give back the activations the loss was computed from.
+const std::unordered_set<string>& nondeterministicOps() {
+  static const std::unordered_set<string> ops{"Dropout",
+                                              "UniformFill",
+                                              "UniformIntFill",
+                                              "GaussianFill",
+                                              "XavierFill",
+                                              "MSRAFill"};
+  return ops;
+}
+
+// Frees blobs on the device of `neighbour`, the op it is placed next to.
+OperatorDef makeFreeOp(
+    const std::vector<string>& blobs,
+    const OperatorDef& neighbour) {
+  OperatorDef op;
+  op.set_type("Free");
+  for (const auto& blob : blobs) {
+    op.add_input(blob);
+    op.add_output(blob);
+  }
+  if (neighbour.has_device_option()) {
+    op.mutable_device_option()->CopyFrom(neighbour.device_option());
+  }
+  return op;
+}
+
+bool writes(const OperatorDef& op, const string& blob) {
+  return std::find(op.output().begin(), op.output().end(), blob) !=
+      op.output().end();
+}
+
+} // namespace
+
+NetDef apply_recomputation(
+    const NetDef& net,
+    int num_forward_ops,
+    const std::vector<int>& segment_starts,
+    const std::unordered_set<string>& dont_drop_blob_names) {
+  CAFFE_ENFORCE(
+      num_forward_ops >= 0 && num_forward_ops <= net.op_size(),
+      "num_forward_ops out of range: ",
+      num_forward_ops);
+  for (const auto& op : net.op()) {
+    if (op.type() == "RecurrentNetwork") {
+      LOG(INFO) << "Recomputation does not support RecurrentNetwork yet";
+      return net;
+    }
+  }
+  const int F = num_forward_ops;
+
+  // Step 1: segment of every forward op
+  std::vector<int> starts;
+  if (segment_starts.empty()) {
+    const int step = std::max(
+        1, static_cast<int>(std::ceil(std::sqrt(static_cast<double>(F)))));
+    for (int i = 0; i < F; i += step) {
+      starts.push_back(i);
+    }
+  } else {
+    starts.push_back(0);
+    for (int start : segment_starts) {
+      if (start > 0 && start < F) {
+        starts.push_back(start);
+      }
+    }
+    std::sort(starts.begin(), starts.end());
+    starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+  }
+  const int num_segments = starts.size();
+  std::vector<int> segment(F);
+  for (int s = 0; s < num_segments; s++) {
+    const int end = s + 1 < num_segments ? starts[s + 1] : F;
+    for (int i = starts[s]; i < end; i++) {
+      segment[i] = s;
+    }
+  }
+
+  // Step 2: the blobs a segment can drop are first written in it, used by no
+  // forward op of another segment, not written by gradient ops, and not
+  // written by a random op
+  std::unordered_set<string> kept(
+      dont_drop_blob_names.begin(), dont_drop_blob_names.end());
+  kept.insert(net.external_input().begin(), net.external_input().end());
+  kept.insert(net.external_output().begin(), net.external_output().end());
+  std::unordered_map<string, int> blob_segment;
+  for (int i = 0; i < F; i++) {
+    const auto& op = net.op(i);
+    for (const auto& inp : op.input()) {
+      auto it = blob_segment.find(inp);
+      if (it == blob_segment.end()) {
+        // Read before being written, so it comes from outside the net
+        kept.insert(inp);
+      } else if (it->second != segment[i]) {
+        kept.insert(inp);
+      }
+    }
+    for (const auto& outp : op.output()) {
+      auto it = blob_segment.find(outp);
+      if (it != blob_segment.end() && it->second != segment[i]) {
+        kept.insert(outp);
+      }
+      blob_segment.emplace(outp, segment[i]);
+      if (nondeterministicOps().count(op.type())) {
+        kept.insert(outp);
+      }
+    }
+  }
+  // First and last gradient op reading every blob
+  std::unordered_map<string, std::pair<int, int>> backward_reads;
+  for (int i = F; i < net.op_size(); i++) {
+    for (const auto& inp : net.op(i).input()) {
+      auto it = backward_reads.find(inp);
+      if (it == backward_reads.end()) {
+        backward_reads[inp] = std::make_pair(i, i);
+      } else {
+        it->second.second = i;
+      }
+    }
+    for (const auto& outp : net.op(i).output()) {
+      kept.insert(outp);
+    }
+  }
+
+  // Ops to add before / after every op of net
+  std::vector<std::vector<OperatorDef>> before(net.op_size() + 1);
+  std::vector<std::vector<OperatorDef>> after(net.op_size());
+  int num_dropped = 0;
+  for (int s = 0; s + 1 < num_segments; s++) {
+    const int begin = starts[s];
+    const int end = starts[s + 1];
+    std::unordered_set<string> local;
+    std::vector<string> local_order;
+    std::vector<string> dropped;
+    int insert_at = net.op_size();
+    for (int i = begin; i < end; i++) {
+      for (const auto& outp : net.op(i).output()) {
+        if (!kept.count(outp) && local.insert(outp).second) {
+          local_order.push_back(outp);
+          auto it = backward_reads.find(outp);
+          if (it != backward_reads.end()) {
+            dropped.push_back(outp);
+            insert_at = std::min(insert_at, it->second.first);
+          }
+        }
+      }
+    }
+    if (dropped.empty()) {
+      continue;
+    }
+
+    // Step 3: the ops to rerun are the ones writing the dropped blobs, and
+    // the ones writing the local blobs that those read
+    std::unordered_set<string> wanted(dropped.begin(), dropped.end());
+    std::vector<int> rerun;
+    for (int i = end - 1; i >= begin; i--) {
+      const auto& op = net.op(i);
+      bool needed = false;
+      for (const auto& outp : op.output()) {
+        needed = needed || wanted.count(outp);
+      }
+      if (!needed) {
+        continue;
+      }
+      rerun.push_back(i);
+      for (const auto& inp : op.input()) {
+        if (local.count(inp)) {
+          wanted.insert(inp);
+        }
+      }
+    }
+    std::reverse(rerun.begin(), rerun.end());
+
+    // The other inputs of the rerun ops must still hold the values they had
+    bool valid = true;
+    for (int i : rerun) {
+      for (const auto& inp : net.op(i).input()) {
+        if (local.count(inp)) {
+          continue;
+        }
+        for (int j = i + 1; j < insert_at && valid; j++) {
+          valid = !writes(net.op(j), inp);
+        }
+      }
+    }
+    if (!valid) {
+      VLOG(1) << "Cannot recompute segment " << s << " of " << net.name();
+      continue;
+    }
+
+    // Step 4: free the local blobs at the end of the segment, rerun the ops
+    // before the first gradient op reading a dropped blob, and free every
+    // dropped blob after its last gradient op. The outputs of the rerun ops
+    // that are not local (e.g. running statistics updated in place) go to
+    // scratch blobs, so that they are not updated twice.
+    after[end - 1].push_back(makeFreeOp(local_order, net.op(end - 1)));
+    std::vector<string> scratch;
+    for (int i : rerun) {
+      OperatorDef op = net.op(i);
+      for (int k = 0; k < op.output_size(); k++) {
+        const string name = op.output(k);
+        if (local.count(name)) {
+          continue;
+        }
+        const string copy = name + "_recompute";
+        for (int j = 0; j < op.input_size(); j++) {
+          if (op.input(j) == name) {
+            OperatorDef copy_op;
+            copy_op.set_type("Copy");
+            copy_op.add_input(name);
+            copy_op.add_output(copy);
+            if (op.has_device_option()) {
+              copy_op.mutable_device_option()->CopyFrom(op.device_option());
+            }
+            before[insert_at].push_back(copy_op);
+            op.set_input(j, copy);
+          }
+        }
+        op.set_output(k, copy);
+        if (std::find(scratch.begin(), scratch.end(), copy) == scratch.end()) {
+          scratch.push_back(copy);
+        }
+      }
+      before[insert_at].push_back(op);
+    }
+    std::vector<string> not_read;
+    for (const auto& blob : local_order) {
+      if (wanted.count(blob) && !backward_reads.count(blob)) {
+        not_read.push_back(blob);
+      }
+    }
+    not_read.insert(not_read.end(), scratch.begin(), scratch.end());
+    if (!not_read.empty()) {
+      before[insert_at].push_back(makeFreeOp(not_read, net.op(rerun.back())));
+    }
+    std::map<int, std::vector<string>> last_reads;
+    for (const auto& blob : dropped) {
+      last_reads[backward_reads[blob].second].push_back(blob);
+    }
+    for (const auto& reads : last_reads) {
+      after[reads.first].push_back(
+          makeFreeOp(reads.second, net.op(reads.first)));
+    }
+    num_dropped += dropped.size();
+  }
+
+  NetDef optimized = net;
+  optimized.clear_op();
+  for (int i = 0; i < net.op_size(); i++) {
+    for (const auto& op : before[i]) {
+      optimized.add_op()->CopyFrom(op);
+    }
+    optimized.add_op()->CopyFrom(net.op(i));
+    for (const auto& op : after[i]) {
+      optimized.add_op()->CopyFrom(op);
+    }
+  }
+  VLOG(1) << "Recomputing " << num_dropped << " activations of "
+          << net.name();
+  return optimized;
+}
+
+NetDef apply_offload(
+    const NetDef& net,
+    int num_forward_ops,
+    const NetCostModel& cost_model,
+    const std::unordered_map<string, size_t>& blob_bytes,
+    const OffloadOptions& options) {
+  CAFFE_ENFORCE(
+      num_forward_ops >= 0 && num_forward_ops <= net.op_size(),
+      "num_forward_ops out of range: ",
+      num_forward_ops);
+  CAFFE_ENFORCE_EQ(cost_model.num_ops(), net.op_size());
+  const int F = num_forward_ops;
+  std::vector<double> seconds(net.op_size(), 0);
+  if (options.peak_flops > 0 && options.peak_bandwidth > 0) {
+    for (int i = 0; i < net.op_size(); i++) {
+      seconds[i] = cost_model.MinSeconds(
+          i, options.peak_flops, options.peak_bandwidth);
+    }
+  }
+
+  // Step 1: last forward write and read, first gradient read of every blob
+  struct Uses {
+    int last_write = -1;
+    int last_read = -1;
+    int first_backward_read = -1;
+    bool backward_write = false;
+  };
+  std::unordered_map<string, Uses> uses;
+  for (int i = 0; i < net.op_size(); i++) {
+    for (const auto& inp : net.op(i).input()) {
+      auto& use = uses[inp];
+      if (i < F) {
+        use.last_read = i;
+      } else if (use.first_backward_read < 0) {
+        use.first_backward_read = i;
+      }
+    }
+    for (const auto& outp : net.op(i).output()) {
+      auto& use = uses[outp];
+      if (i < F) {
+        use.last_write = i;
+      } else {
+        use.backward_write = true;
+      }
+    }
+  }
+  std::unordered_set<string> external(
+      net.external_input().begin(), net.external_input().end());
+  external.insert(net.external_output().begin(), net.external_output().end());
+
+  std::vector<std::vector<OperatorDef>> before(net.op_size());
+  std::vector<std::vector<OperatorDef>> after(net.op_size());
+  auto makeOp = [](const string& type,
+                   const string& input,
+                   const string& output,
+                   const OperatorDef& neighbour) {
+    OperatorDef op;
+    op.set_type(type);
+    op.add_input(input);
+    op.add_output(output);
+    if (neighbour.has_device_option()) {
+      op.mutable_device_option()->CopyFrom(neighbour.device_option());
+    }
+    return op;
+  };
+  // Sorted for the ops to be added in the same order on every call
+  std::vector<string> blobs;
+  for (const auto& blob : blob_bytes) {
+    blobs.push_back(blob.first);
+  }
+  std::sort(blobs.begin(), blobs.end());
+
+  int num_offloaded = 0;
+  for (const auto& blob : blobs) {
+    const size_t bytes = blob_bytes.at(blob);
+    auto it = uses.find(blob);
+    if (bytes < options.min_bytes || it == uses.end() || external.count(blob)) {
+      continue;
+    }
+    const auto& use = it->second;
+    if (use.last_write < 0 || use.first_backward_read < 0 ||
+        use.backward_write) {
+      continue;
+    }
+    const double copy_seconds =
+        options.host_bandwidth > 0 ? bytes / options.host_bandwidth : 0;
+
+    // Step 2: free it after its last forward use, once the copy to the host
+    // is done, and prefetch it as late as the copy back allows
+    int free_after = use.last_write;
+    double elapsed = 0;
+    while (elapsed < copy_seconds && free_after < F - 1) {
+      elapsed += seconds[++free_after];
+    }
+    free_after = std::max(free_after, use.last_read);
+    const int read = use.first_backward_read;
+    int prefetch_before = read;
+    double lead = 0;
+    while (lead < copy_seconds && prefetch_before - 1 > free_after) {
+      lead += seconds[--prefetch_before];
+    }
+    if (elapsed < copy_seconds || lead < copy_seconds) {
+      VLOG(1) << "No time to offload " << blob;
+      continue;
+    }
+
+    const string state = blob + "_offload";
+    after[use.last_write].push_back(
+        makeOp("OffloadToHost", blob, state, net.op(use.last_write)));
+    after[free_after].push_back(
+        makeOp("WaitOffload", state, blob, net.op(free_after)));
+    auto prefetch = makeOp("PrefetchToDevice", state, blob, net.op(read));
+    prefetch.add_output(state);
+    before[prefetch_before].push_back(prefetch);
+    before[read].push_back(makeOp("WaitOffload", state, blob, net.op(read)));
+    num_offloaded++;
+  }
+
+  NetDef optimized = net;
+  optimized.clear_op();
+  for (int i = 0; i < net.op_size(); i++) {
+    for (const auto& op : before[i]) {
+      optimized.add_op()->CopyFrom(op);
+    }
+    optimized.add_op()->CopyFrom(net.op(i));
+    for (const auto& op : after[i]) {
+      optimized.add_op()->CopyFrom(op);
+    }
+  }
+  VLOG(1) << "Offloading " << num_offloaded << " activations of "
+          << net.name();
+  return optimized;
+}
+
 } // memonger
 } // caffe2
@@ -20,6 +20,7 @@
 #include <unordered_set>
 
 #include "caffe2/core/common.h"
+#include "caffe2/core/net_cost_model.h"
 #include "caffe2/core/workspace.h"
 #include "caffe2/proto/caffe2.pb.h"
 
@@ -39,6 +40,71 @@ NetDef compute_blob_recycling_for_dag(
     const std::unordered_set<string>& dont_share_blob_names,
     const std::unordered_map<string, vector<int>>& blob_shapes);
 
+// Offsets of the blobs of a net in one preallocated arena, see
+// plan_static_memory().
+struct StaticMemoryPlan {
+  size_t arena_bytes = 0;
+  std::unordered_map<string, size_t> offsets;
+};
+
+// Computes a static memory plan for an inference net whose ops run in order
+// (a simple net). Every blob of blob_bytes lives from the first op writing it
+// to the last op reading it, or to the end of the net for its external
+// outputs, and blobs whose lifetimes overlap get disjoint byte ranges of the
+// arena, aligned to `alignment`. Blobs are placed largest first at the lowest
+// offset that fits.
+StaticMemoryPlan plan_static_memory(
+    const NetDef& net,
+    const std::unordered_map<string, size_t>& blob_bytes,
+    size_t alignment = 64);
+
+// Gradient checkpointing for a training net whose first `num_forward_ops` ops
+// are the forward pass, followed by the gradient ops. The forward ops are cut
+// into segments starting at `segment_starts`, or every
+// ceil(sqrt(num_forward_ops)) ops if it is empty. The activations that only
+// the ops of one segment use in the forward pass are freed at the end of the
+// segment, and the ops producing the ones read by gradient ops are run again
+// right before the first of them, after which they are freed again. Blobs
+// crossing segments, external inputs and outputs, outputs of random ops such
+// as Dropout and `dont_drop_blob_names` are kept, and so is the last segment,
+// whose gradients run first. A segment whose ops cannot be rerun (their
+// inputs are overwritten in the meantime) is left as it is.
+NetDef apply_recomputation(
+    const NetDef& net,
+    int num_forward_ops,
+    const std::vector<int>& segment_starts,
+    const std::unordered_set<string>& dont_drop_blob_names);
+
+// Device the offload copies are timed on by apply_offload().
+struct OffloadOptions {
+  // Of the device, for the time of the ops from the cost model
+  double peak_flops = 0;
+  double peak_bandwidth = 0;
+  // Of the copies between the device and the pinned host memory. The copies
+  // count as instant if it is not set.
+  double host_bandwidth = 0;
+  // Smaller activations are not worth the ops of their copies
+  size_t min_bytes = 1 << 20;
+};
+
+// Activation offload for a training net whose first `num_forward_ops` ops
+// are the forward pass, followed by the gradient ops. Every activation of
+// blob_bytes of at least min_bytes that gradient ops read is copied to pinned
+// host memory (into a "<blob>_offload" blob) by an OffloadToHost op after its
+// last forward write, and freed by a WaitOffload op after its last forward
+// read, once the copy should be done. A PrefetchToDevice op copies it back
+// early enough for the copy to be done before its first gradient op, which a
+// WaitOffload op right in front of it waits for. The times come from the ops
+// of `cost_model` on the device of `options`; an activation is left on the
+// device when there is no time to do both copies between its forward and
+// gradient uses, or when a gradient op writes it.
+NetDef apply_offload(
+    const NetDef& net,
+    int num_forward_ops,
+    const NetCostModel& cost_model,
+    const std::unordered_map<string, size_t>& blob_bytes,
+    const OffloadOptions& options);
+
 } // memonger
 } // caffe2
 
@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/micro_ops.h"
+
+#include <mutex>
+#include <set>
+#include <utility>
+
+#include "caffe2/core/flags.h"
+
+CAFFE2_DEFINE_bool(
+    caffe2_net_async_coalesce_micro_ops,
+    false,
+    "Let consecutive ops of a chain that are registered as coalescable (e.g. "
+    "Scale, Clip or Cast of small tensors on HIP) run with one kernel launch");
+
+namespace caffe2 {
+
+namespace {
+thread_local bool micro_ops_active = false;
+thread_local MicroOpQueue* pending_queue = nullptr;
+
+std::mutex& CoalescableMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::set<std::pair<int, std::string>>& CoalescableTypes() {
+  static std::set<std::pair<int, std::string>> types;
+  return types;
+}
+} // namespace
+
+bool MicroOps::Active() {
+  return micro_ops_active;
+}
+
+void MicroOps::SetPending(MicroOpQueue* queue) {
+  if (pending_queue != queue) {
+    Flush();
+    pending_queue = queue;
+  }
+}
+
+void MicroOps::Flush() {
+  if (pending_queue) {
+    auto* queue = pending_queue;
+    pending_queue = nullptr;
+    queue->Flush();
+  }
+}
+
+void MicroOps::Begin(bool active) {
+  if (!active) {
+    Flush();
+  }
+  micro_ops_active = active;
+}
+
+void MicroOps::End(bool failed) {
+  micro_ops_active = false;
+  if (failed && pending_queue) {
+    pending_queue->Clear();
+    pending_queue = nullptr;
+  }
+  Flush();
+}
+
+bool IsCoalescable(const OperatorDef& def) {
+  // The other engines of the type don't queue their work
+  if (!def.engine().empty()) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(CoalescableMutex());
+  return CoalescableTypes().count(
+      std::make_pair(def.device_option().device_type(), def.type()));
+}
+
+CoalescableOperatorRegisterer::CoalescableOperatorRegisterer(
+    int device_type,
+    const std::string& type) {
+  std::lock_guard<std::mutex> lock(CoalescableMutex());
+  CoalescableTypes().emplace(device_type, type);
+}
+
+} // namespace caffe2
@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_CORE_MICRO_OPS_H_
+#define CAFFE2_CORE_MICRO_OPS_H_
+
+#include <string>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+/**
+ * Coalescing of tiny device ops (--caffe2_net_async_coalesce_micro_ops).
+ *
+ * The async nets run the ops of a chain one after the other on one stream.
+ * An op of a type registered as coalescable can then queue its work in the
+ * MicroOpQueue of its device instead of launching a kernel, and the queue
+ * runs all the queued ops with one kernel launch when it is flushed: before
+ * the next op that doesn't queue its work, and at the end of the chain. The
+ * last op of a chain always runs on its own, so that the chain event is
+ * recorded after all its work; the events of the other coalesced ops are
+ * recorded before their work is launched and should not be waited on.
+ */
+class MicroOpQueue {
+ public:
+  virtual ~MicroOpQueue() {}
+  // Launches the queued ops
+  virtual void Flush() = 0;
+  // Drops the queued ops, when the chain failed
+  virtual void Clear() = 0;
+};
+
+class MicroOps {
+ public:
+  // Whether the op being run may queue its work.
+  static bool Active();
+  // Called by the queue of a device when it holds work to be flushed.
+  static void SetPending(MicroOpQueue* queue);
+  // Flushes the pending queue.
+  static void Flush();
+
+  // Used by the nets around each op of a chain: flushes the queued work
+  // unless the op is allowed to queue its own.
+  static void Begin(bool active);
+  // Flushes the queued work at the end of a chain, or drops it if the chain
+  // failed.
+  static void End(bool failed);
+};
+
+// Whether the ops of this type and device can queue their work. The ops
+// registered as coalescable have to either queue their work or call
+// MicroOps::Flush() before launching it when MicroOps::Active().
+bool IsCoalescable(const OperatorDef& def);
+
+// Holder of registration of the coalescable op types of a device.
+class CoalescableOperatorRegisterer {
+ public:
+  CoalescableOperatorRegisterer(int device_type, const std::string& type);
+};
+
+#define REGISTER_COALESCABLE_OPERATOR(device_type, name)            \
+  static CoalescableOperatorRegisterer CAFFE_ANONYMOUS_VARIABLE( \
+      g_coalescable_##name)(device_type, #name)
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_MICRO_OPS_H_
@@ -0,0 +1,174 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/micro_ops_hip.h"
+#include "caffe2/utils/conversions.h"
+
+namespace caffe2 {
+
+namespace {
+// Ops per kernel launch, passed by value as the kernel argument
+constexpr int kMaxMicroOps = 32;
+// Ops larger than this are not worth coalescing
+constexpr TIndex kMaxMicroOpSize = 8192;
+// Elements per kernel launch, the whole list runs on one block
+constexpr TIndex kMaxMicroOpsSize = 1 << 16;
+
+struct HIPMicroOpList
+{
+    int size;
+    HIPMicroOp ops[kMaxMicroOps];
+};
+
+// One block runs the ops in order, the barrier after each op making its
+// output visible to the next ones.
+__global__ void MicroOpsKernel(const HIPMicroOpList list)
+{
+    for(int k = 0; k < list.size; ++k)
+    {
+        const HIPMicroOp op = list.ops[k];
+        const float* x      = static_cast<const float*>(op.x);
+        float* y            = static_cast<float*>(op.y);
+        switch(op.type)
+        {
+        case HIPMicroOp::kScale:
+            for(int i = threadIdx.x; i < op.n; i += blockDim.x)
+            {
+                y[i] = op.alpha * x[i];
+            }
+            break;
+        case HIPMicroOp::kClip:
+            for(int i = threadIdx.x; i < op.n; i += blockDim.x)
+            {
+                y[i] = fminf(fmaxf(x[i], op.alpha), op.beta);
+            }
+            break;
+        case HIPMicroOp::kNegative:
+            for(int i = threadIdx.x; i < op.n; i += blockDim.x)
+            {
+                y[i] = -x[i];
+            }
+            break;
+        case HIPMicroOp::kReplaceNaN:
+            for(int i = threadIdx.x; i < op.n; i += blockDim.x)
+            {
+                y[i] = isnan(x[i]) ? op.alpha : x[i];
+            }
+            break;
+        case HIPMicroOp::kCopy:
+            for(int i = threadIdx.x; i < op.n; i += blockDim.x)
+            {
+                static_cast<uint8_t*>(op.y)[i] = static_cast<const uint8_t*>(op.x)[i];
+            }
+            break;
+        case HIPMicroOp::kFloatToHalf:
+            for(int i = threadIdx.x; i < op.n; i += blockDim.x)
+            {
+                static_cast<float16*>(op.y)[i] = convert::To<float, float16>(x[i]);
+            }
+            break;
+        case HIPMicroOp::kHalfToFloat:
+            for(int i = threadIdx.x; i < op.n; i += blockDim.x)
+            {
+                y[i] = convert::To<float16, float>(static_cast<const float16*>(op.x)[i]);
+            }
+            break;
+        }
+        __syncthreads();
+    }
+}
+
+// Ops queued by the chain run on the calling thread, all on one stream.
+class HIPMicroOpQueue final : public MicroOpQueue
+{
+    public:
+    static HIPMicroOpQueue& ThreadLocal()
+    {
+        static thread_local HIPMicroOpQueue queue;
+        return queue;
+    }
+
+    void Add(const HIPMicroOp& op, HIPContext* context)
+    {
+        MicroOps::SetPending(this);
+        if(list_.size > 0 &&
+           (gpu_id_ != context->hip_gpu_id() || stream_ != context->hip_stream() ||
+            list_.size == kMaxMicroOps || size_ + op.n > kMaxMicroOpsSize))
+        {
+            Flush();
+        }
+        gpu_id_                  = context->hip_gpu_id();
+        stream_                  = context->hip_stream();
+        list_.ops[list_.size++] = op;
+        size_ += op.n;
+    }
+
+    void Flush() override
+    {
+        if(list_.size == 0)
+        {
+            return;
+        }
+        DeviceGuard guard(gpu_id_);
+        hipLaunchKernelGGL(
+            (MicroOpsKernel), dim3(1), dim3(CAFFE_HIP_NUM_THREADS), 0, stream_, list_);
+        Clear();
+    }
+
+    void Clear() override
+    {
+        list_.size = 0;
+        size_      = 0;
+    }
+
+    private:
+    HIPMicroOpQueue() { Clear(); }
+
+    HIPMicroOpList list_;
+    TIndex size_;
+    int gpu_id_           = -1;
+    hipStream_t stream_   = nullptr;
+};
+} // namespace
+
+bool QueueHIPMicroOp(HIPContext* context,
+                     HIPMicroOp::Type type,
+                     TIndex n,
+                     const void* x,
+                     void* y,
+                     float alpha,
+                     float beta)
+{
+    if(!MicroOps::Active() || n > kMaxMicroOpSize)
+    {
+        MicroOps::Flush();
+        return false;
+    }
+    if(n > 0)
+    {
+        HIPMicroOp op;
+        op.type  = type;
+        op.n     = static_cast<int>(n);
+        op.x     = x;
+        op.y     = y;
+        op.alpha = alpha;
+        op.beta  = beta;
+        HIPMicroOpQueue::ThreadLocal().Add(op, context);
+    }
+    return true;
+}
+
+} // namespace caffe2
@@ -0,0 +1,60 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_CORE_MICRO_OPS_HIP_H_
+#define CAFFE2_CORE_MICRO_OPS_HIP_H_
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/micro_ops.h"
+
+namespace caffe2 {
+
+// Work of a coalescable HIP op, run by the micro-op kernel (see MicroOps).
+// n counts floats, or bytes for kCopy.
+struct HIPMicroOp
+{
+    enum Type
+    {
+        kScale,       // y = alpha * x
+        kClip,        // y = min(max(x, alpha), beta)
+        kNegative,    // y = -x
+        kReplaceNaN,  // y = isnan(x) ? alpha : x
+        kCopy,        // bytes
+        kFloatToHalf, // float16 y
+        kHalfToFloat, // float16 x
+    };
+    int type;
+    int n;
+    const void* x;
+    void* y;
+    float alpha;
+    float beta;
+};
+
+// Queues the op in the micro-op queue of the calling thread when
+// MicroOps::Active() and the op is small enough. Otherwise flushes the queued
+// ops and returns false, the caller then launches its own kernel.
+bool QueueHIPMicroOp(HIPContext* context,
+                     HIPMicroOp::Type type,
+                     TIndex n,
+                     const void* x,
+                     void* y,
+                     float alpha = 0.f,
+                     float beta  = 0.f);
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_MICRO_OPS_HIP_H_
@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/flags.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/utils/proto_utils.h"
+
+CAFFE2_DECLARE_bool(caffe2_net_async_coalesce_micro_ops);
+
+namespace caffe2 {
+
+namespace {
+
+void AddOp(NetDef* net_def,
+           const string& type,
+           const string& input,
+           const string& output,
+           const vector<Argument>& args = {})
+{
+    net_def->add_op()->CopyFrom(
+        CreateOperatorDef(type, "", vector<string>{input}, vector<string>{output}, args));
+}
+
+// Chain of coalescable ops, the in-place Scale reads the output of the op
+// before it within the same kernel.
+void CheckMicroOps(TIndex size)
+{
+    NetDef net_def;
+    net_def.set_type("async_scheduling");
+    net_def.mutable_device_option()->set_device_type(HIP);
+    net_def.add_external_input("X");
+    AddOp(&net_def, "Scale", "X", "A", {MakeArgument<float>("scale", 2)});
+    AddOp(&net_def,
+          "Clip",
+          "A",
+          "B",
+          {MakeArgument<float>("min", -3), MakeArgument<float>("max", 5)});
+    AddOp(&net_def, "Negative", "B", "C");
+    AddOp(&net_def, "Scale", "C", "C", {MakeArgument<float>("scale", 0.5)});
+    AddOp(&net_def, "Cast", "C", "D", {MakeArgument<int>("to", TensorProto::FLOAT16)});
+    AddOp(&net_def, "Cast", "D", "E", {MakeArgument<int>("to", TensorProto::FLOAT)});
+    AddOp(&net_def, "StopGradient", "E", "F");
+    AddOp(&net_def, "Scale", "F", "Z", {MakeArgument<float>("scale", 3)});
+
+    Workspace ws;
+    TensorCPU input(vector<TIndex>{size});
+    for(int i = 0; i < input.size(); ++i)
+    {
+        input.mutable_data<float>()[i] = (i % 16) - 8;
+    }
+    ws.CreateBlob("X")->GetMutable<TensorHIP>()->CopyFrom(input);
+    NetBase* net = ws.CreateNet(net_def);
+    ASSERT_TRUE(net != nullptr);
+    for(int run = 0; run < 2; ++run)
+    {
+        EXPECT_TRUE(net->Run());
+        TensorCPU output(ws.GetBlob("Z")->Get<TensorHIP>());
+        ASSERT_EQ(output.size(), size);
+        for(int i = 0; i < output.size(); ++i)
+        {
+            const float x = input.data<float>()[i];
+            const float expected = 3 * 0.5f * -std::min(std::max(2 * x, -3.f), 5.f);
+            EXPECT_FLOAT_EQ(output.data<float>()[i], expected);
+        }
+    }
+}
+
+} // namespace
+
+TEST(MicroOpsHIPTest, CoalescesChain)
+{
+    if(!HasHipGPU())
+        return;
+    FLAGS_caffe2_net_async_coalesce_micro_ops = true;
+    CheckMicroOps(100);
+    // Ops too large to be coalesced flush the queued ones first
+    CheckMicroOps(100000);
+    FLAGS_caffe2_net_async_coalesce_micro_ops = false;
+    CheckMicroOps(100);
+}
+
+} // namespace caffe2
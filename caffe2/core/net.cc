@@ -104,9 +104,11 @@ bool NetBase::RunAsync() {
   return DoRunAsync();
 }
 
-static NetObserverCreator GlobalNetObserverCreator = [](NetBase* net) {
-  // A no-op ObserverBase<NetBase> observer
-  return std::unique_ptr<NetObserver>(new NetObserver(net));
+// Creators may return a null observer, in which case nothing is attached. The
+// default one does so, so that nets don't pay for a no-op observer on every
+// run.
+static NetObserverCreator GlobalNetObserverCreator = [](NetBase* /* net */) {
+  return std::unique_ptr<NetObserver>();
 };
 
 void SetGlobalNetObserverCreator(NetObserverCreator creator) {
@@ -114,6 +116,20 @@ void SetGlobalNetObserverCreator(NetObserverCreator creator) {
   VLOG(1) << "Have set custom GlobalNetObserverCreator";
 }
 
+static std::vector<std::pair<NetObserverCreator, int>>&
+AdditionalNetObserverCreators() {
+  static std::vector<std::pair<NetObserverCreator, int>> creators;
+  return creators;
+}
+
+void AddGlobalNetObserverCreator(
+    NetObserverCreator creator,
+    int sampling_rate) {
+  CAFFE_ENFORCE_GE(sampling_rate, 1, "Sampling rate must be positive.");
+  AdditionalNetObserverCreators().emplace_back(creator, sampling_rate);
+  VLOG(1) << "Have added a GlobalNetObserverCreator";
+}
+
 unique_ptr<NetBase> CreateNet(const NetDef& net_def, Workspace* ws) {
   std::shared_ptr<NetDef> tmp_net_def(new NetDef(net_def));
   return CreateNet(tmp_net_def, ws);
@@ -132,7 +148,16 @@ unique_ptr<NetBase> CreateNet(
   }
   VLOG(1) << "Adding a global observer to a net";
   if (net) {
-    net->AttachObserver(GlobalNetObserverCreator(net.get()));
+    auto observer = GlobalNetObserverCreator(net.get());
+    if (observer) {
+      net->AttachObserver(std::move(observer));
+    }
+    for (auto& creator : AdditionalNetObserverCreators()) {
+      observer = creator.first(net.get());
+      if (observer) {
+        net->AttachObserver(std::move(observer), creator.second);
+      }
+    }
   }
   return net;
 }
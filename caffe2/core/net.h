@@ -163,6 +163,14 @@ unique_ptr<NetBase> CreateNet(
 
 void SetGlobalNetObserverCreator(NetObserverCreator creator);
 
+// Unlike the global creator, which is replaced by each
+// SetGlobalNetObserverCreator call, every creator added here attaches its
+// observer to the nets created afterwards. The observers are started on one
+// net run out of sampling_rate.
+void AddGlobalNetObserverCreator(
+    NetObserverCreator creator,
+    int sampling_rate = 1);
+
 } // namespace caffe2
 
 #endif // CAFFE2_CORE_NET_H_
@@ -16,6 +16,7 @@
 
 #include "caffe2/core/net_async_polling.h"
 
+#include "caffe2/core/micro_ops.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/core/timer.h"
 
@@ -25,6 +26,7 @@ CAFFE2_DEFINE_int(
     "Number of streams per GPU to use in GPU thread pool");
 
 CAFFE2_DECLARE_bool(caffe2_dag_net_collect_stats);
+CAFFE2_DECLARE_bool(caffe2_net_async_coalesce_micro_ops);
 
 CAFFE2_DEFINE_bool(
     caffe2_net_async_use_single_pool,
@@ -51,11 +53,24 @@ CAFFE2_DEFINE_int(
     0,
     "Number of threads in CPU pool (default - number of cores)");
 
+CAFFE2_DEFINE_bool(
+    caffe2_net_async_cpu_work_stealing,
+    false,
+    "Use a work-stealing CPU pool, in which a task scheduled from a worker "
+    "runs on that worker unless an idle one steals it (ignores priorities)");
+
 CAFFE2_DEFINE_bool(
     caffe2_net_async_check_stream_status,
     true,
     "Select next non-busy stream");
 
+CAFFE2_DEFINE_bool(
+    caffe2_net_async_plan_streams,
+    true,
+    "Assign GPU streams to chains when the net is created, so that chains "
+    "that can run concurrently use different streams and a chain continues "
+    "the stream of a parent, instead of picking the next non-busy stream");
+
 namespace caffe2 {
 
 thread_local std::vector<int> AsyncNetBase::stream_counters_;
@@ -69,6 +84,12 @@ AsyncNetBase::AsyncNetBase(
   for (const auto& node : operator_nodes_) {
     operators_.push_back(node.operator_.get());
   }
+  if (FLAGS_caffe2_net_async_coalesce_micro_ops) {
+    for (const auto& op : operators_) {
+      coalescable_.push_back(
+          op->has_debug_def() && IsCoalescable(op->debug_def()));
+    }
+  }
 
   const auto& execution_chains = dag_utils::computeChains(operator_nodes_);
   chains_.reserve(execution_chains.size());
@@ -76,17 +97,40 @@ AsyncNetBase::AsyncNetBase(
     chains_.push_back(kv.second);
   }
   chain_nodes_ = dag_utils::prepareChainGraphNodes(operator_nodes_, chains_);
+  chain_priorities_ =
+      dag_utils::computeChainPriorities(net_def, chains_, chain_nodes_);
 
   events_.reserve(chains_.size());
+  comm_chains_.reserve(chains_.size());
   for (const auto& chain : chains_) {
     const auto& op = operators_[chain.back()];
     events_.push_back(&op->event());
+    // computeChains doesn't mix comm stream ops with others
+    comm_chains_.push_back(dag_utils::runsOnCommStream(*op));
+  }
+
+  if (FLAGS_caffe2_net_async_plan_streams) {
+    std::vector<int> chain_devices(chains_.size(), -1);
+    for (int task_id = 0; task_id < tasksNum(); ++task_id) {
+      const auto& device_option = event(task_id).GetDeviceOption();
+      if (comm_chains_[task_id]) {
+        // Not planned, see stream()
+        continue;
+      } else if (device_option.device_type() == CUDA) {
+        chain_devices[task_id] = device_option.cuda_gpu_id();
+      } else if (device_option.device_type() == HIP) {
+        chain_devices[task_id] = device_option.hip_gpu_id();
+      }
+    }
+    chain_streams_ = dag_utils::computeChainStreams(
+        chain_nodes_, chain_devices, FLAGS_caffe2_streams_per_gpu);
   }
 
   DeviceOption cpu_option;
   cpu_option.set_device_type(CPU);
   cpu_pool_ = ThreadPoolRegistry()->Create(
       DeviceTypeName(cpu_option.device_type()), cpu_option);
+  cpu_pools_.resize(GetNumNUMANodes());
   gpu_pools_.resize(FLAGS_caffe2_net_async_max_gpus);
   if (FLAGS_caffe2_net_async_use_single_gpu_pool) {
     DeviceOption gpu_option;
@@ -95,18 +139,45 @@ AsyncNetBase::AsyncNetBase(
     gpu_pool_ = ThreadPoolRegistry()->Create(
         DeviceTypeName(gpu_option.device_type()), gpu_option);
   }
+
+  if (FLAGS_caffe2_net_async_tracing) {
+    tracer_.reset(
+        new tracing::Tracer(this, FLAGS_caffe2_net_async_tracing_capacity));
+  }
 }
 
 std::shared_ptr<TaskThreadPool> AsyncNetBase::pool(
     const DeviceOption& device_option) {
-  if (FLAGS_caffe2_net_async_use_single_pool ||
-      device_option.device_type() == CPU) {
+  if (FLAGS_caffe2_net_async_use_single_pool) {
     return cpu_pool_;
-  } else if (device_option.device_type() == CUDA) {
+  } else if (device_option.device_type() == CPU) {
+    auto numa_node_id = device_option.numa_node_id();
+    if (numa_node_id < 0 || !IsNUMAEnabled()) {
+      return cpu_pool_;
+    }
+    CAFFE_ENFORCE(
+        numa_node_id < static_cast<int>(cpu_pools_.size()),
+        "Invalid NUMA node id: " + caffe2::to_string(numa_node_id));
+    auto pool = cpu_pools_[numa_node_id];
+    if (!pool) {
+      std::unique_lock<std::mutex> pools_lock(pools_mutex_);
+      pool = cpu_pools_[numa_node_id];
+      if (!pool) {
+        pool = ThreadPoolRegistry()->Create(
+            DeviceTypeName(device_option.device_type()), device_option);
+        cpu_pools_[numa_node_id] = pool;
+      }
+    }
+    return pool;
+  } else if (
+      device_option.device_type() == CUDA ||
+      device_option.device_type() == HIP) {
     if (FLAGS_caffe2_net_async_use_single_gpu_pool) {
       return gpu_pool_;
     } else {
-      auto gpu_id = device_option.cuda_gpu_id();
+      auto gpu_id = device_option.device_type() == CUDA
+          ? device_option.cuda_gpu_id()
+          : device_option.hip_gpu_id();
       CAFFE_ENFORCE(
           gpu_id >= 0 && gpu_id < FLAGS_caffe2_net_async_max_gpus,
           "Invalid GPU id: " + caffe2::to_string(gpu_id));
@@ -132,17 +203,34 @@ std::shared_ptr<TaskThreadPool> AsyncNetBase::pool(
 int AsyncNetBase::stream(int task_id) {
   const auto& device_option = event(task_id).GetDeviceOption();
   int stream_id = 0;
-  if (device_option.device_type() == CUDA) {
-    int gpu_id = device_option.cuda_gpu_id();
+  if (device_option.device_type() == CUDA ||
+      device_option.device_type() == HIP) {
+    int gpu_id = device_option.device_type() == CUDA
+        ? device_option.cuda_gpu_id()
+        : device_option.hip_gpu_id();
     CAFFE_ENFORCE_GE(gpu_id, 0, "Invalid gpu id: " + caffe2::to_string(gpu_id));
+    if (comm_chains_[task_id]) {
+      // The high priority stream of the GPU that HIPContext creates after
+      // the compute ones; the chains it waits for or that wait for it are
+      // on other streams, so they are synchronized by their events.
+      return FLAGS_caffe2_streams_per_gpu;
+    }
+    if (!chain_streams_.empty()) {
+      return chain_streams_[task_id];
+    }
     if (gpu_id >= stream_counters_.size()) {
       stream_counters_.resize(gpu_id + 1, 0);
     }
-    do {
+    // Prefers an idle stream; with all of them busy the chain is queued on the
+    // next one instead of spinning until the GPU drains.
+    for (int probe = 0; probe < FLAGS_caffe2_streams_per_gpu; ++probe) {
       stream_id = stream_counters_[gpu_id]++;
       stream_counters_[gpu_id] %= FLAGS_caffe2_streams_per_gpu;
-    } while (!isStreamFree(task_id, stream_id) &&
-             FLAGS_caffe2_net_async_check_stream_status);
+      if (!FLAGS_caffe2_net_async_check_stream_status ||
+          isStreamFree(task_id, stream_id)) {
+        break;
+      }
+    }
   }
   return stream_id;
 }
@@ -202,6 +290,10 @@ const std::vector<int>& AsyncNetBase::parents(int task_id) const {
   return task_node.parents_;
 }
 
+int AsyncNetBase::priority(int task_id) const {
+  return chain_priorities_[task_id];
+}
+
 void AsyncNetBase::asyncWait(
     int task_id,
     int stream_id,
@@ -217,12 +309,28 @@ void AsyncNetBase::asyncWait(
 }
 
 bool AsyncNetBase::run(int task_id, int stream_id) {
+  // Counted against the threads that the chain's ops can shard their work on
+  InterOpTaskScope inter_op_task;
   bool failed = false;
   std::string err_msg;
-  for (auto& op_id : chains_[task_id]) {
+  const auto& chain = chains_[task_id];
+  for (size_t i = 0; i < chain.size(); ++i) {
+    const auto op_id = chain[i];
     auto& op = operators_[op_id];
     try {
-      if (!op->RunAsync(stream_id)) {
+      tracing::OpSpan span;
+      if (tracer_) {
+        span = tracer_->StartOp(op_id, stream_id);
+      }
+      if (!coalescable_.empty()) {
+        // The last op of the chain runs on its own, see MicroOps
+        MicroOps::Begin(coalescable_[op_id] && i + 1 < chain.size());
+      }
+      const bool success = op->RunAsync(stream_id);
+      if (tracer_) {
+        tracer_->StopOp(op_id, stream_id, span);
+      }
+      if (!success) {
         failed = true;
         err_msg = "Failed to execute task: op " +
             (op->has_debug_def() ? op->type() : " unknown");
@@ -239,6 +347,15 @@ bool AsyncNetBase::run(int task_id, int stream_id) {
     }
   }
 
+  if (!coalescable_.empty()) {
+    try {
+      MicroOps::End(failed);
+    } catch (const std::exception& e) {
+      failed = true;
+      err_msg = e.what();
+    }
+  }
+
   if (!failed && FLAGS_caffe2_net_async_finish_chain) {
     operators_[chains_[task_id].back()]->event().Finish();
   }
@@ -263,7 +380,12 @@ void AsyncNetBase::finalizeEvents() {
   }
 }
 
-AsyncNetBase::~AsyncNetBase() {}
+AsyncNetBase::~AsyncNetBase() {
+  if (tracer_ && !FLAGS_caffe2_net_async_tracing_file_prefix.empty()) {
+    tracer_->DumpChromeTrace(
+        FLAGS_caffe2_net_async_tracing_file_prefix + Name() + ".json");
+  }
+}
 
 CAFFE_DEFINE_SHARED_REGISTRY(
     ThreadPoolRegistry,
@@ -277,18 +399,23 @@ std::shared_ptr<TaskThreadPool> AsyncNetCPUThreadPoolCreator(
       device_option.device_type(),
       CPU,
       "Unexpected device type for CPU thread pool");
-  return GetAsyncNetCPUThreadPool();
+  return GetAsyncNetCPUThreadPool(device_option.numa_node_id());
 }
 } // namespace
 
 CAFFE_REGISTER_CREATOR(ThreadPoolRegistry, CPU, AsyncNetCPUThreadPoolCreator);
 
 /* static */
-std::shared_ptr<TaskThreadPool> GetAsyncNetCPUThreadPool() {
-  static std::weak_ptr<TaskThreadPool> pool;
+std::shared_ptr<TaskThreadPool> GetAsyncNetCPUThreadPool(int numa_node_id) {
+  // One pool per NUMA node, -1 being the unbound pool
+  static std::unordered_map<int, std::weak_ptr<TaskThreadPool>> pools;
   static std::mutex pool_mutex;
   std::lock_guard<std::mutex> lock(pool_mutex);
 
+  if (!IsNUMAEnabled()) {
+    numa_node_id = -1;
+  }
+  auto& pool = pools[numa_node_id];
   auto shared_pool = pool.lock();
   if (!shared_pool) {
     auto pool_size = FLAGS_caffe2_net_async_cpu_pool_size;
@@ -297,8 +424,15 @@ std::shared_ptr<TaskThreadPool> GetAsyncNetCPUThreadPool() {
       CAFFE_ENFORCE(num_cores > 0, "Failed to get number of CPU cores");
       pool_size = num_cores;
     }
-    LOG(INFO) << "Using cpu pool size: " << pool_size;
-    shared_pool = std::make_shared<TaskThreadPool>(pool_size);
+    LOG(INFO) << "Using cpu pool size: " << pool_size
+              << (FLAGS_caffe2_net_async_cpu_work_stealing
+                      ? ", work stealing"
+                      : "")
+              << (numa_node_id >= 0
+                      ? ", NUMA node " + caffe2::to_string(numa_node_id)
+                      : "");
+    shared_pool = std::make_shared<TaskThreadPool>(
+        pool_size, FLAGS_caffe2_net_async_cpu_work_stealing, numa_node_id);
     pool = shared_pool;
   }
   return shared_pool;
@@ -19,6 +19,7 @@
 
 #include "caffe2/core/common.h"
 #include "caffe2/core/net.h"
+#include "caffe2/core/net_async_tracing.h"
 #include "caffe2/core/net_dag_utils.h"
 #include "caffe2/core/registry.h"
 #include "caffe2/core/stats.h"
@@ -43,6 +44,11 @@ class AsyncNetBase : public NetBase {
     return operators_;
   }
 
+  // The tracer of the net, if --caffe2_net_async_tracing is set.
+  tracing::Tracer* tracer() const {
+    return tracer_.get();
+  }
+
  protected:
   bool canSchedule(
       int chain_id,
@@ -53,6 +59,7 @@ class AsyncNetBase : public NetBase {
   EventStatus query(int task_id) const;
   const std::vector<int>& children(int task_id) const;
   const std::vector<int>& parents(int task_id) const;
+  int priority(int task_id) const;
   void asyncWait(
       int task_id,
       int stream_id,
@@ -71,13 +78,26 @@ class AsyncNetBase : public NetBase {
   std::vector<dag_utils::OperatorNode> operator_nodes_;
   std::vector<std::vector<int>> chains_;
   std::vector<dag_utils::OpGraphNode> chain_nodes_; // chains' parents/children
+  std::vector<int> chain_priorities_; // see dag_utils::computeChainPriorities
+  // Whether each op can queue its work, see MicroOps; empty unless
+  // --caffe2_net_async_coalesce_micro_ops
+  std::vector<bool> coalescable_;
+  // Whether each chain runs on the communication stream of its GPU, see
+  // dag_utils::runsOnCommStream
+  std::vector<bool> comm_chains_;
 
   // Pools and streams
   std::mutex pools_mutex_;
   std::vector<std::shared_ptr<TaskThreadPool>> gpu_pools_;
   std::shared_ptr<TaskThreadPool> cpu_pool_;
+  std::vector<std::shared_ptr<TaskThreadPool>> cpu_pools_; // per NUMA node
   std::shared_ptr<TaskThreadPool> gpu_pool_;
   static thread_local std::vector<int> stream_counters_;
+  // Planned stream of each chain, see dag_utils::computeChainStreams; empty
+  // unless --caffe2_net_async_plan_streams
+  std::vector<int> chain_streams_;
+
+  std::unique_ptr<tracing::Tracer> tracer_;
 
   DISABLE_COPY_AND_ASSIGN(AsyncNetBase);
 };
@@ -87,7 +107,10 @@ CAFFE_DECLARE_SHARED_REGISTRY(
     TaskThreadPool,
     const DeviceOption&);
 
-std::shared_ptr<TaskThreadPool> GetAsyncNetCPUThreadPool();
+// Returns the CPU pool shared by the async nets, bound to the given NUMA node
+// when NUMA is enabled.
+std::shared_ptr<TaskThreadPool> GetAsyncNetCPUThreadPool(
+    int numa_node_id = -1);
 
 } // namespace caffe2
 
@@ -47,6 +47,9 @@ class AsyncDAGNet : public DAGNetBase {
 
   int stream(const DeviceOption& device_option);
   static thread_local std::vector<int> stream_counters_;
+  // Planned stream of each chain by the index of its first op, see
+  // dag_utils::computeChainStreams
+  std::unordered_map<int, int> chain_streams_;
 
   DISABLE_COPY_AND_ASSIGN(AsyncDAGNet);
 };
@@ -16,6 +16,7 @@
 
 #include "caffe2/core/net_async_dag_gpu.h"
 
+#include <algorithm>
 #include <set>
 #include <stack>
 #include <unordered_map>
@@ -41,6 +42,8 @@ CAFFE2_DECLARE_int(caffe2_streams_per_gpu);
 
 CAFFE2_DECLARE_bool(caffe2_net_async_check_stream_status);
 
+CAFFE2_DECLARE_bool(caffe2_net_async_plan_streams);
+
 namespace caffe2 {
 
 thread_local std::vector<int> AsyncDAGNet::stream_counters_;
@@ -83,6 +86,38 @@ AsyncDAGNet::AsyncDAGNet(const std::shared_ptr<const NetDef>& net_def, Workspace
     }
     VLOG(1) << "Total " << execution_chains_.size() << " chains, final waiting on "
             << events_.size() << " events";
+
+    if(FLAGS_caffe2_async_dag_use_multiple_streams && FLAGS_caffe2_net_async_plan_streams)
+    {
+        // Chains in the order of the net, which breaks ties in the planning
+        std::vector<int> chain_starts;
+        chain_starts.reserve(execution_chains_.size());
+        for(const auto& chain : execution_chains_)
+        {
+            chain_starts.push_back(chain.first);
+        }
+        std::sort(chain_starts.begin(), chain_starts.end());
+        std::vector<std::vector<int>> chains;
+        std::vector<int> chain_devices;
+        chains.reserve(chain_starts.size());
+        chain_devices.reserve(chain_starts.size());
+        for(auto chain_start : chain_starts)
+        {
+            const auto& device_option =
+                operator_nodes_[chain_start].operator_->event().GetDeviceOption();
+            chains.push_back(execution_chains_[chain_start]);
+            chain_devices.push_back(device_option.device_type() == HIP ? device_option.hip_gpu_id()
+                                                                       : -1);
+        }
+        const auto streams = dag_utils::computeChainStreams(
+            dag_utils::prepareChainGraphNodes(operator_nodes_, chains),
+            chain_devices,
+            FLAGS_caffe2_streams_per_gpu);
+        for(int chain_idx = 0; chain_idx < chains.size(); ++chain_idx)
+        {
+            chain_streams_[chain_starts[chain_idx]] = streams[chain_idx];
+        }
+    }
 }
 
 int AsyncDAGNet::stream(const DeviceOption& device_option)
@@ -96,12 +131,18 @@ int AsyncDAGNet::stream(const DeviceOption& device_option)
         {
             stream_counters_.resize(gpu_id + 1, 0);
         }
-        do
+        // Prefers an idle stream; with all of them busy the chain is queued on
+        // the next one instead of spinning until the GPU drains.
+        for(int probe = 0; probe < FLAGS_caffe2_streams_per_gpu; ++probe)
         {
             stream_id = stream_counters_[gpu_id]++;
             stream_counters_[gpu_id] %= FLAGS_caffe2_streams_per_gpu;
-        } while(FLAGS_caffe2_net_async_check_stream_status &&
-                !HIPContext::IsStreamFree(device_option, stream_id));
+            if(!FLAGS_caffe2_net_async_check_stream_status ||
+               HIPContext::IsStreamFree(device_option, stream_id))
+            {
+                break;
+            }
+        }
     }
     return stream_id;
 }
@@ -121,7 +162,10 @@ bool AsyncDAGNet::RunAt(int chain_id, const std::vector<int>& chain)
     int stream_id = 0;
     if(FLAGS_caffe2_async_dag_use_multiple_streams)
     {
-        stream_id = stream(operator_nodes_[source_idx].operator_->event().GetDeviceOption());
+        auto planned = chain_streams_.find(source_idx);
+        stream_id    = planned != chain_streams_.end()
+                        ? planned->second
+                        : stream(operator_nodes_[source_idx].operator_->event().GetDeviceOption());
     }
 
     std::vector<const Event*> parent_events;
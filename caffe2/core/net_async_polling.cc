@@ -19,8 +19,18 @@
 #include "caffe2/core/operator.h"
 #include "caffe2/core/timer.h"
 
+#include <thread>
+
 CAFFE2_DECLARE_bool(caffe2_dag_net_collect_stats);
 
+CAFFE2_DEFINE_bool(
+    caffe2_net_async_polling_inline_gpu,
+    false,
+    "Run the GPU chains of async_polling nets on the polling thread instead "
+    "of the GPU thread pools. GPU chains only queue work on their stream and "
+    "their events are polled without blocking, so a single thread can drive "
+    "all the GPUs");
+
 namespace caffe2 {
 
 AsyncPollingNet::AsyncPollingNet(
@@ -50,6 +60,9 @@ bool AsyncPollingNet::DoRunAsync() {
   reset();
 
   StartAllObservers();
+  if (tracer_) {
+    tracer_->StartNetRun();
+  }
 
   Timer timer;
   bool success = pollAndSchedule();
@@ -60,6 +73,9 @@ bool AsyncPollingNet::DoRunAsync() {
     finalizeEvents();
   }
 
+  if (tracer_) {
+    tracer_->StopNetRun();
+  }
   StopAllObservers();
   running_ = false;
   return success;
@@ -70,7 +86,7 @@ void AsyncPollingNet::schedule(int task_id) {
     task_timers_[task_id]->Start();
   }
   const auto& device_option = event(task_id).GetDeviceOption();
-  pool(device_option)->run([this, task_id, device_option]() {
+  auto task = [this, task_id, device_option]() {
     int stream_id = stream(task_id);
 
     if (FLAGS_caffe2_dag_net_collect_stats) {
@@ -99,7 +115,14 @@ void AsyncPollingNet::schedule(int task_id) {
     if (!result) {
       has_chain_failed_ = true;
     }
-  });
+  };
+  if (FLAGS_caffe2_net_async_polling_inline_gpu &&
+      (device_option.device_type() == CUDA ||
+       device_option.device_type() == HIP)) {
+    task();
+  } else {
+    pool(device_option)->run(task);
+  }
 }
 
 void AsyncPollingNet::reset() {
@@ -180,6 +203,10 @@ bool AsyncPollingNet::pollAndSchedule() {
       }
     }
 
+    // Nothing has changed, let the chains make progress before polling again
+    if (updated_tasks.empty()) {
+      std::this_thread::yield();
+    }
     current_tasks.swap(next_tasks);
   }
   return true;
@@ -26,12 +26,36 @@ CAFFE2_DEFINE_int(
     1,
     "Number of polling threads in async_scheduling executor");
 
+CAFFE2_DEFINE_bool(
+    caffe2_net_async_use_priorities,
+    true,
+    "Start ready chains by priority (OperatorDef.priority, communication ops, "
+    "critical path) instead of in the order they become ready");
+
+CAFFE2_DEFINE_bool(
+    caffe2_net_async_event_callbacks,
+    true,
+    "Schedule chains that wait for device work of their parents from "
+    "callbacks of the parents' events, where the device supports them, "
+    "instead of polling the events");
+
 namespace caffe2 {
 
 AsyncSchedulingNet::AsyncSchedulingNet(
     const std::shared_ptr<const NetDef>& net_def,
     Workspace* ws)
     : AsyncNetBase(net_def, ws), running_(false) {
+  if (FLAGS_caffe2_net_async_use_priorities) {
+    // Children that become ready together are scheduled highest priority
+    // first, e.g. a gradient allreduce before the rest of the backward pass.
+    for (auto& chain_node : chain_nodes_) {
+      std::sort(
+          chain_node.children_.begin(),
+          chain_node.children_.end(),
+          [this](int a, int b) { return priority(a) > priority(b); });
+    }
+  }
+
   pending_tasks_.reserve(FLAGS_caffe2_net_async_polling_threads_num);
   for (auto thread_num = 0;
        thread_num < FLAGS_caffe2_net_async_polling_threads_num;
@@ -72,7 +96,9 @@ void AsyncSchedulingNet::Wait() {
 
 void AsyncSchedulingNet::schedule(int task_id) {
   const auto& device_option = event(task_id).GetDeviceOption();
-  pool(device_option)->run([this, task_id]() {
+  const int task_priority =
+      FLAGS_caffe2_net_async_use_priorities ? priority(task_id) : 0;
+  pool(device_option)->runWithPriority([this, task_id]() {
     if (success_) {
       int stream_id = stream(task_id);
       asyncWait(task_id, stream_id, parents(task_id));
@@ -89,7 +115,7 @@ void AsyncSchedulingNet::schedule(int task_id) {
         if (cleanup_ || FLAGS_caffe2_net_async_always_schedule_child ||
             canSchedule(child_id)) {
           schedule(child_id);
-        } else {
+        } else if (!scheduleWhenParentsFinish(child_id)) {
           auto polling_thread_id = next_polling_thread_counter_++;
           polling_thread_id %= FLAGS_caffe2_net_async_polling_threads_num;
           pending_tasks_[polling_thread_id]->Push(child_id);
@@ -130,7 +156,43 @@ void AsyncSchedulingNet::schedule(int task_id) {
       // Notify observers and waiters
       finishRun();
     }
-  });
+  }, task_priority);
+}
+
+bool AsyncSchedulingNet::scheduleWhenParentsFinish(int task_id) {
+  if (!FLAGS_caffe2_net_async_event_callbacks) {
+    return false;
+  }
+  std::vector<const Event*> pending_events;
+  for (auto parent_id : parents(task_id)) {
+    const auto& parent_event = event(parent_id);
+    auto status = parent_event.Query();
+    if (status == EventStatus::EVENT_SUCCESS) {
+      continue;
+    }
+    if (status != EventStatus::EVENT_SCHEDULED ||
+        !parent_event.SupportsCallback()) {
+      return false;
+    }
+    pending_events.push_back(&parent_event);
+  }
+  if (pending_events.empty()) {
+    schedule(task_id);
+    return true;
+  }
+
+  // Callbacks run on the device runtime's threads, make sure that scheduling
+  // from them doesn't have to create the pool.
+  pool(event(task_id).GetDeviceOption());
+  auto remaining = std::make_shared<std::atomic<int>>(pending_events.size());
+  for (const auto* parent_event : pending_events) {
+    parent_event->SetCallback([this, task_id, remaining]() {
+      if (--*remaining == 0) {
+        schedule(task_id);
+      }
+    });
+  }
+  return true;
 }
 
 void AsyncSchedulingNet::pollAndSchedule(int thread_id) {
@@ -155,6 +217,9 @@ int AsyncSchedulingNet::updateParentCount(int child_id) {
 
 void AsyncSchedulingNet::finishRun() {
   // notify observers and waiters
+  if (tracer_) {
+    tracer_->StopNetRun();
+  }
   StopAllObservers();
   running_ = false;
   running_cv_.notify_all();
@@ -167,6 +232,9 @@ bool AsyncSchedulingNet::DoRunAsync() {
   reset();
 
   StartAllObservers();
+  if (tracer_) {
+    tracer_->StartNetRun();
+  }
 
   for (auto task_id = 0; task_id < tasksNum(); ++task_id) {
     if (parents(task_id).empty()) {
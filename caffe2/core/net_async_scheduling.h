@@ -35,6 +35,9 @@ class AsyncSchedulingNet : public AsyncNetBase {
 
   void pollAndSchedule(int thread_id);
   void schedule(int task_id);
+  // Schedules the task from the callbacks of the events of its unfinished
+  // parents, returns false if some of them can't call back.
+  bool scheduleWhenParentsFinish(int task_id);
   void reset();
   void finishRun();
   int updateParentCount(int child_id);
@@ -0,0 +1,307 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/net_async_tracing.h"
+
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <unordered_set>
+
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/proto_utils.h"
+
+CAFFE2_DEFINE_bool(
+    caffe2_net_async_tracing,
+    false,
+    "Record the operator runs of async nets for Chrome traces");
+CAFFE2_DEFINE_int(
+    caffe2_net_async_tracing_capacity,
+    1 << 16,
+    "Number of operator runs kept per traced async net");
+CAFFE2_DEFINE_string(
+    caffe2_net_async_tracing_file_prefix,
+    "",
+    "If set, traced async nets dump their Chrome trace to "
+    "<prefix><net name>.json when destroyed");
+
+namespace caffe2 {
+namespace tracing {
+
+CAFFE_DEFINE_REGISTRY(DeviceTracerRegistry, DeviceTracer, size_t);
+
+int64_t NowMicros() {
+  static const auto epoch = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - epoch)
+      .count();
+}
+
+namespace {
+
+// Small sequential ids of the threads, used as lanes in the trace.
+int ThreadLane() {
+  static std::atomic<int> next_lane{0};
+  static thread_local int lane = next_lane++;
+  return lane;
+}
+
+int GpuId(const DeviceOption& option) {
+  return option.device_type() == HIP ? option.hip_gpu_id()
+                                     : option.cuda_gpu_id();
+}
+
+std::mutex& TracersMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::unordered_set<Tracer*>& Tracers() {
+  static std::unordered_set<Tracer*> tracers;
+  return tracers;
+}
+
+std::string JsonString(const std::string& s) {
+  std::stringstream ss;
+  ss << '"';
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      ss << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      ss << ' ';
+    } else {
+      ss << c;
+    }
+  }
+  ss << '"';
+  return ss.str();
+}
+
+// Process ids of the trace: the host, then one per device.
+constexpr int kHostPid = 0;
+int DevicePid(const DeviceOption& option) {
+  return 1 + option.device_type() * 1000 + GpuId(option);
+}
+
+} // namespace
+
+Tracer::Tracer(const NetBase* net, size_t capacity)
+    : net_name_(net->Name()),
+      operators_(net->GetOperators()),
+      ring_(std::max(capacity, size_t(1))) {
+  for (const auto type : {CUDA, HIP}) {
+    auto tracer =
+        DeviceTracerRegistry()->Create(DeviceTypeName(type), capacity);
+    if (tracer) {
+      device_tracers_[type] = std::move(tracer);
+    }
+  }
+  std::lock_guard<std::mutex> guard(TracersMutex());
+  Tracers().insert(this);
+}
+
+Tracer::~Tracer() {
+  std::lock_guard<std::mutex> guard(TracersMutex());
+  Tracers().erase(this);
+}
+
+Tracer::Record& Tracer::Claim(uint64_t* index) {
+  *index = next_++;
+  auto& record = ring_[*index % ring_.size()];
+  record.seq.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  return record;
+}
+
+void Tracer::Publish(Record& record, uint64_t index) {
+  record.seq.store(index + 1, std::memory_order_release);
+}
+
+OpSpan Tracer::StartOp(int op_id, int stream_id) {
+  OpSpan span;
+  const auto& option = operators_[op_id]->device_option();
+  auto it = device_tracers_.find(option.device_type());
+  if (it != device_tracers_.end()) {
+    span.has_device = true;
+    span.device_handle = it->second->Start(option, stream_id);
+  }
+  span.start_us = NowMicros();
+  return span;
+}
+
+void Tracer::StopOp(int op_id, int stream_id, const OpSpan& span) {
+  const int64_t end_us = NowMicros();
+  if (span.has_device) {
+    const auto& option = operators_[op_id]->device_option();
+    device_tracers_.at(option.device_type())->Stop(span.device_handle);
+  }
+  uint64_t index;
+  auto& record = Claim(&index);
+  record.kind = kOp;
+  record.op_id = op_id;
+  record.lane = ThreadLane();
+  record.stream_id = stream_id;
+  record.start_us = span.start_us;
+  record.end_us = end_us;
+  record.has_device = span.has_device;
+  record.device_handle = span.device_handle;
+  Publish(record, index);
+}
+
+void Tracer::StartNetRun() {
+  net_run_start_us_ = NowMicros();
+}
+
+void Tracer::StopNetRun() {
+  uint64_t index;
+  auto& record = Claim(&index);
+  record.kind = kNetRun;
+  record.lane = -1;
+  record.start_us = net_run_start_us_;
+  record.end_us = NowMicros();
+  record.has_device = false;
+  Publish(record, index);
+}
+
+std::string Tracer::ToChromeTrace() {
+  std::stringstream ss;
+  ss << "{\"traceEvents\": [\n";
+  bool first = true;
+  auto emit = [&](const std::string& event) {
+    ss << (first ? "  " : ",\n  ") << event;
+    first = false;
+  };
+  auto span = [](const std::string& name,
+                 const std::string& category,
+                 int pid,
+                 int tid,
+                 int64_t start_us,
+                 int64_t end_us,
+                 const std::string& args) {
+    std::stringstream ev;
+    ev << "{\"name\": " << JsonString(name)
+       << ", \"cat\": " << JsonString(category) << ", \"ph\": \"X\", \"ts\": "
+       << start_us << ", \"dur\": " << std::max(end_us - start_us, int64_t(0))
+       << ", \"pid\": " << pid << ", \"tid\": " << tid
+       << ", \"args\": {" << args << "}}";
+    return ev.str();
+  };
+
+  std::set<int> host_lanes;
+  std::set<std::pair<int, int>> device_lanes;
+  std::unordered_map<int, std::string> device_names;
+  const uint64_t end = next_.load();
+  const uint64_t begin = end > ring_.size() ? end - ring_.size() : 0;
+  for (uint64_t index = begin; index < end; ++index) {
+    const auto& record = ring_[index % ring_.size()];
+    if (record.seq.load(std::memory_order_acquire) != index + 1) {
+      continue;
+    }
+    const int kind = record.kind;
+    const int op_id = record.op_id;
+    const int lane = record.lane;
+    const int stream_id = record.stream_id;
+    const int64_t start_us = record.start_us;
+    const int64_t end_us = record.end_us;
+    const bool has_device = record.has_device;
+    const uint64_t device_handle = record.device_handle;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (record.seq.load(std::memory_order_relaxed) != index + 1) {
+      continue;
+    }
+
+    if (kind == kNetRun) {
+      emit(span(net_name_, "net", kHostPid, 0, start_us, end_us, ""));
+      continue;
+    }
+    const auto& def = operators_[op_id]->debug_def();
+    const std::string name = def.name().empty() ? def.type() : def.name();
+    std::stringstream args;
+    args << "\"op\": " << op_id << ", \"type\": " << JsonString(def.type())
+         << ", \"stream\": " << stream_id;
+    emit(span(name, "op", kHostPid, lane + 1, start_us, end_us, args.str()));
+    host_lanes.insert(lane);
+
+    int64_t device_start_us, device_end_us;
+    if (has_device) {
+      const auto& option = operators_[op_id]->device_option();
+      if (device_tracers_.at(option.device_type())
+              ->Resolve(device_handle, &device_start_us, &device_end_us)) {
+        const int pid = DevicePid(option);
+        emit(span(
+            name,
+            "device",
+            pid,
+            stream_id,
+            device_start_us,
+            device_end_us,
+            args.str()));
+        device_lanes.insert(std::make_pair(pid, stream_id));
+        device_names[pid] = DeviceTypeName(option.device_type()) + " gpu " +
+            caffe2::to_string(GpuId(option));
+      }
+    }
+  }
+
+  auto metadata = [](const char* what, int pid, int tid, const std::string& n) {
+    std::stringstream ev;
+    ev << "{\"name\": \"" << what << "\", \"ph\": \"M\", \"pid\": " << pid
+       << ", \"tid\": " << tid << ", \"args\": {\"name\": " << JsonString(n)
+       << "}}";
+    return ev.str();
+  };
+  emit(metadata("process_name", kHostPid, 0, "host: " + net_name_));
+  emit(metadata("thread_name", kHostPid, 0, "net runs"));
+  for (int lane : host_lanes) {
+    emit(metadata(
+        "thread_name",
+        kHostPid,
+        lane + 1,
+        "worker " + caffe2::to_string(lane)));
+  }
+  for (const auto& kv : device_names) {
+    emit(metadata("process_name", kv.first, 0, kv.second));
+  }
+  for (const auto& pid_stream : device_lanes) {
+    emit(metadata(
+        "thread_name",
+        pid_stream.first,
+        pid_stream.second,
+        "stream " + caffe2::to_string(pid_stream.second)));
+  }
+  ss << "\n], \"displayTimeUnit\": \"ms\"}\n";
+  return ss.str();
+}
+
+void Tracer::DumpChromeTrace(const std::string& filename) {
+  std::ofstream out(filename, std::ios::trunc);
+  CAFFE_ENFORCE(out.good(), "Cannot open ", filename);
+  out << ToChromeTrace();
+  LOG(INFO) << "Wrote the trace of net " << net_name_ << " to " << filename;
+}
+
+void DumpAllTraces(const std::string& prefix) {
+  std::lock_guard<std::mutex> guard(TracersMutex());
+  for (auto* tracer : Tracers()) {
+    tracer->DumpChromeTrace(prefix + tracer->net_name() + ".json");
+  }
+}
+
+} // namespace tracing
+} // namespace caffe2
@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_CORE_NET_ASYNC_TRACING_H_
+#define CAFFE2_CORE_NET_ASYNC_TRACING_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/flags.h"
+#include "caffe2/core/registry.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+CAFFE2_DECLARE_bool(caffe2_net_async_tracing);
+CAFFE2_DECLARE_int(caffe2_net_async_tracing_capacity);
+CAFFE2_DECLARE_string(caffe2_net_async_tracing_file_prefix);
+
+namespace caffe2 {
+
+class NetBase;
+class OperatorBase;
+
+namespace tracing {
+
+// Microseconds on the clock shared by all tracers.
+int64_t NowMicros();
+
+/**
+ * Timestamps the device work of operators on their streams, for devices that
+ * run operators asynchronously. Implementations are registered in
+ * DeviceTracerRegistry under the name of their device type and are called
+ * from the worker threads concurrently.
+ */
+class DeviceTracer {
+ public:
+  virtual ~DeviceTracer() {}
+
+  // Marks the start of an operator on the stream, and returns a handle for
+  // the calls below.
+  virtual uint64_t Start(const DeviceOption& option, int stream_id) = 0;
+  virtual void Stop(uint64_t handle) = 0;
+
+  // Returns the device span in NowMicros() time, or false if the device has
+  // not finished it yet or its slot has since been reused.
+  virtual bool Resolve(uint64_t handle, int64_t* start_us, int64_t* end_us) = 0;
+};
+
+CAFFE_DECLARE_REGISTRY(DeviceTracerRegistry, DeviceTracer, size_t);
+
+struct OpSpan {
+  int64_t start_us = 0;
+  bool has_device = false;
+  uint64_t device_handle = 0;
+};
+
+/**
+ * Records the operator runs of an async net into a fixed size ring buffer,
+ * and dumps the last ones as a Chrome trace (the trace_event JSON format of
+ * chrome://tracing).
+ *
+ * The trace has a lane for the runs of the net, one per worker thread with
+ * the operators it ran, and, for devices with a DeviceTracer, one per device
+ * stream with the device time of every operator. Writers are lock free:
+ * every record claims a slot with one atomic increment and publishes it with
+ * a sequence number, so that a dump only skips the slots being rewritten.
+ */
+class Tracer {
+ public:
+  Tracer(const NetBase* net, size_t capacity);
+  ~Tracer();
+
+  OpSpan StartOp(int op_id, int stream_id);
+  void StopOp(int op_id, int stream_id, const OpSpan& span);
+  void StartNetRun();
+  void StopNetRun();
+
+  const std::string& net_name() const {
+    return net_name_;
+  }
+
+  std::string ToChromeTrace();
+  void DumpChromeTrace(const std::string& filename);
+
+ private:
+  enum Kind { kOp = 1, kNetRun = 2 };
+
+  struct Record {
+    std::atomic<uint64_t> seq{0};
+    int kind = 0;
+    int op_id = -1;
+    int lane = -1;
+    int stream_id = 0;
+    int64_t start_us = 0;
+    int64_t end_us = 0;
+    bool has_device = false;
+    uint64_t device_handle = 0;
+  };
+
+  Record& Claim(uint64_t* index);
+  void Publish(Record& record, uint64_t index);
+
+  const std::string net_name_;
+  const std::vector<OperatorBase*> operators_;
+  std::vector<Record> ring_;
+  std::atomic<uint64_t> next_{0};
+  std::atomic<int64_t> net_run_start_us_{0};
+  std::unordered_map<int, std::unique_ptr<DeviceTracer>> device_tracers_;
+
+  DISABLE_COPY_AND_ASSIGN(Tracer);
+};
+
+// Dumps the traces of every live traced net, to <prefix><net name>.json.
+void DumpAllTraces(const std::string& prefix);
+
+} // namespace tracing
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_NET_ASYNC_TRACING_H_
@@ -0,0 +1,160 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/net_async_tracing.h"
+
+#include <mutex>
+
+#include "caffe2/core/context_hip.h"
+
+namespace caffe2 {
+namespace tracing {
+
+namespace {
+
+// Records a pair of hipEvents around every operator. Device timestamps are
+// converted to host time through a reference event per device, recorded and
+// synchronized when the device is first traced.
+class HIPDeviceTracer final : public DeviceTracer
+{
+    public:
+    explicit HIPDeviceTracer(size_t capacity) : slots_(std::max(capacity, size_t(1))) {}
+
+    ~HIPDeviceTracer()
+    {
+        for(auto& slot : slots_)
+        {
+            if(slot.gpu_id >= 0)
+            {
+                DeviceGuard guard(slot.gpu_id);
+                HIP_CHECK(hipEventDestroy(slot.start));
+                HIP_CHECK(hipEventDestroy(slot.stop));
+            }
+        }
+        for(auto& kv : references_)
+        {
+            DeviceGuard guard(kv.first);
+            HIP_CHECK(hipEventDestroy(kv.second.event));
+        }
+    }
+
+    uint64_t Start(const DeviceOption& option, int stream_id) override
+    {
+        const int gpu_id      = option.hip_gpu_id();
+        const uint64_t handle = next_++;
+        auto& slot            = slots_[handle % slots_.size()];
+        std::lock_guard<std::mutex> guard(slot.mutex);
+        DeviceGuard device_guard(gpu_id);
+        if(slot.gpu_id != gpu_id)
+        {
+            if(slot.gpu_id >= 0)
+            {
+                DeviceGuard old_device_guard(slot.gpu_id);
+                HIP_ENFORCE(hipEventDestroy(slot.start));
+                HIP_ENFORCE(hipEventDestroy(slot.stop));
+            }
+            HIP_ENFORCE(hipEventCreate(&slot.start));
+            HIP_ENFORCE(hipEventCreate(&slot.stop));
+            slot.gpu_id = gpu_id;
+        }
+        EnsureReference(gpu_id);
+        slot.handle  = handle;
+        slot.stream  = HIPContext::hip_stream(gpu_id, stream_id);
+        slot.stopped = false;
+        HIP_ENFORCE(hipEventRecord(slot.start, slot.stream));
+        return handle;
+    }
+
+    void Stop(uint64_t handle) override
+    {
+        auto& slot = slots_[handle % slots_.size()];
+        std::lock_guard<std::mutex> guard(slot.mutex);
+        if(slot.handle == handle)
+        {
+            DeviceGuard device_guard(slot.gpu_id);
+            HIP_ENFORCE(hipEventRecord(slot.stop, slot.stream));
+            slot.stopped = true;
+        }
+    }
+
+    bool Resolve(uint64_t handle, int64_t* start_us, int64_t* end_us) override
+    {
+        auto& slot = slots_[handle % slots_.size()];
+        std::lock_guard<std::mutex> guard(slot.mutex);
+        if(slot.handle != handle || !slot.stopped || hipEventQuery(slot.stop) != hipSuccess)
+        {
+            return false;
+        }
+        Reference reference;
+        {
+            std::lock_guard<std::mutex> references_guard(references_mutex_);
+            reference = references_.at(slot.gpu_id);
+        }
+        float start_ms = 0;
+        float end_ms   = 0;
+        HIP_ENFORCE(hipEventElapsedTime(&start_ms, reference.event, slot.start));
+        HIP_ENFORCE(hipEventElapsedTime(&end_ms, reference.event, slot.stop));
+        *start_us = reference.host_us + static_cast<int64_t>(start_ms * 1000);
+        *end_us   = reference.host_us + static_cast<int64_t>(end_ms * 1000);
+        return true;
+    }
+
+    private:
+    struct Slot
+    {
+        std::mutex mutex;
+        int gpu_id      = -1;
+        uint64_t handle = ~uint64_t(0);
+        bool stopped    = false;
+        hipStream_t stream;
+        hipEvent_t start;
+        hipEvent_t stop;
+    };
+
+    struct Reference
+    {
+        hipEvent_t event;
+        int64_t host_us;
+    };
+
+    // Called with the device of gpu_id set.
+    void EnsureReference(int gpu_id)
+    {
+        std::lock_guard<std::mutex> guard(references_mutex_);
+        if(references_.count(gpu_id))
+        {
+            return;
+        }
+        Reference reference;
+        HIP_ENFORCE(hipEventCreate(&reference.event));
+        HIP_ENFORCE(hipEventRecord(reference.event, 0));
+        HIP_ENFORCE(hipEventSynchronize(reference.event));
+        reference.host_us   = NowMicros();
+        references_[gpu_id] = reference;
+    }
+
+    std::vector<Slot> slots_;
+    std::atomic<uint64_t> next_{0};
+    std::mutex references_mutex_;
+    std::unordered_map<int, Reference> references_;
+};
+
+} // namespace
+
+CAFFE_REGISTER_CLASS(DeviceTracerRegistry, HIP, HIPDeviceTracer);
+
+} // namespace tracing
+} // namespace caffe2
@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include "caffe2/core/net.h"
+#include "caffe2/core/net_async_base.h"
+#include "caffe2/core/net_async_tracing.h"
+#include "caffe2/core/operator.h"
+
+#include <google/protobuf/text_format.h>
+
+namespace caffe2 {
+
+namespace {
+
+class TracingTestDummyOp final : public OperatorBase {
+ public:
+  using OperatorBase::OperatorBase;
+
+  bool Run(int /* unused */ /*stream_id*/) override {
+    return true;
+  }
+};
+
+REGISTER_CPU_OPERATOR(TracingTestDummy, TracingTestDummyOp);
+
+OPERATOR_SCHEMA(TracingTestDummy)
+    .NumInputs(0, INT_MAX)
+    .NumOutputs(0, INT_MAX)
+    .AllowInplace({{0, 0}});
+
+int CountOccurrences(const std::string& s, const std::string& what) {
+  int count = 0;
+  for (auto pos = s.find(what); pos != std::string::npos;
+       pos = s.find(what, pos + what.size())) {
+    ++count;
+  }
+  return count;
+}
+
+std::unique_ptr<NetBase> CreateTracedNet(Workspace* ws) {
+  const auto spec = R"DOC(
+        name: "traced"
+        type: "async_scheduling"
+        external_input: "in"
+        op {
+          input: "in"
+          output: "hidden"
+          name: "first"
+          type: "TracingTestDummy"
+        }
+        op {
+          input: "hidden"
+          output: "out1"
+          type: "TracingTestDummy"
+        }
+        op {
+          input: "hidden"
+          output: "out2"
+          type: "TracingTestDummy"
+        }
+)DOC";
+  NetDef net_def;
+  CAFFE_ENFORCE(google::protobuf::TextFormat::ParseFromString(spec, &net_def));
+  ws->CreateBlob("in");
+  FLAGS_caffe2_net_async_tracing = true;
+  auto net = CreateNet(net_def, ws);
+  FLAGS_caffe2_net_async_tracing = false;
+  return net;
+}
+
+} // namespace
+
+TEST(NetAsyncTracingTest, ChromeTrace) {
+  Workspace ws;
+  auto net = CreateTracedNet(&ws);
+  ASSERT_TRUE(net);
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_TRUE(net->Run());
+  }
+  auto* tracer = dynamic_cast<AsyncNetBase*>(net.get())->tracer();
+  ASSERT_TRUE(tracer);
+  const auto trace = tracer->ToChromeTrace();
+  // 3 operators and the net, per run.
+  EXPECT_EQ(CountOccurrences(trace, "\"ph\": \"X\""), 8);
+  EXPECT_EQ(CountOccurrences(trace, "\"cat\": \"net\""), 2);
+  EXPECT_EQ(CountOccurrences(trace, "\"name\": \"first\""), 2);
+  EXPECT_EQ(CountOccurrences(trace, "\"name\": \"TracingTestDummy\""), 4);
+  EXPECT_GE(CountOccurrences(trace, "\"name\": \"worker "), 1);
+}
+
+TEST(NetAsyncTracingTest, KeepsTheLastRecords) {
+  Workspace ws;
+  const int capacity = FLAGS_caffe2_net_async_tracing_capacity;
+  FLAGS_caffe2_net_async_tracing_capacity = 5;
+  auto net = CreateTracedNet(&ws);
+  FLAGS_caffe2_net_async_tracing_capacity = capacity;
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(net->Run());
+  }
+  const auto trace =
+      dynamic_cast<AsyncNetBase*>(net.get())->tracer()->ToChromeTrace();
+  EXPECT_EQ(CountOccurrences(trace, "\"ph\": \"X\""), 5);
+}
+
+TEST(NetAsyncTracingTest, NoTracerByDefault) {
+  Workspace ws;
+  NetDef net_def;
+  net_def.set_type("async_scheduling");
+  net_def.add_op()->set_type("TracingTestDummy");
+  auto net = CreateNet(net_def, &ws);
+  ASSERT_TRUE(net);
+  EXPECT_FALSE(dynamic_cast<AsyncNetBase*>(net.get())->tracer());
+}
+
+} // namespace caffe2
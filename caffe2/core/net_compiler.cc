@@ -0,0 +1,480 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/net_compiler.h"
+
+#include <algorithm>
+#include <set>
+#include <sstream>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/perfkernels/fc_small_batch.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+namespace net_compiler {
+
+namespace {
+
+TIndex SizeOf(const std::vector<TIndex>& dims, int begin, int end) {
+  TIndex size = 1;
+  for (int i = begin; i < end; ++i) {
+    size *= dims[i];
+  }
+  return size;
+}
+
+TIndex SizeOf(const std::vector<TIndex>& dims) {
+  return SizeOf(dims, 0, dims.size());
+}
+
+bool IsCPU(const OperatorDef& op) {
+  return !op.has_device_option() || op.device_option().device_type() == CPU;
+}
+
+// Whether the operator can be lowered, given the float blobs of known shape.
+bool CanLower(
+    const OperatorDef& op,
+    const std::unordered_map<string, std::vector<TIndex>>& dims,
+    const std::set<string>& external_inputs) {
+  if (!IsCPU(op) || !op.engine().empty()) {
+    return false;
+  }
+  for (const auto& name : op.input()) {
+    if (!dims.count(name)) {
+      return false;
+    }
+  }
+  for (const auto& name : op.output()) {
+    // The inputs are shared with the tensors of the caller, and the weights
+    // are bound once.
+    if (!dims.count(name) || external_inputs.count(name)) {
+      return false;
+    }
+  }
+  ArgumentHelper args(op);
+  const auto& type = op.type();
+  if (type == "FC") {
+    return op.input_size() == 3 && op.output_size() == 1 &&
+        args.GetSingleArgument<int>("axis", 1) == 1 &&
+        args.GetSingleArgument<int>("axis_w", 1) == 1 &&
+        op.output(0) != op.input(0) && dims.at(op.input(0)).size() >= 2 &&
+        dims.at(op.input(1)).size() >= 2;
+  }
+  if (type == "Relu" || type == "Sigmoid" || type == "Tanh") {
+    return op.input_size() == 1 && op.output_size() == 1;
+  }
+  if (type == "Softmax") {
+    const int axis = args.GetSingleArgument<int>("axis", 1);
+    return op.input_size() == 1 && op.output_size() == 1 &&
+        op.output(0) != op.input(0) && axis >= 0 &&
+        axis < dims.at(op.input(0)).size();
+  }
+  if (type == "Add" || type == "Sub" || type == "Mul" || type == "Div") {
+    return op.input_size() == 2 && op.output_size() == 1 &&
+        !args.GetSingleArgument<int>("broadcast", 0) &&
+        dims.at(op.input(0)) == dims.at(op.input(1));
+  }
+  if (type == "Sum") {
+    if (op.output_size() != 1) {
+      return false;
+    }
+    for (int i = 0; i < op.input_size(); ++i) {
+      if (dims.at(op.input(i)) != dims.at(op.input(0)) ||
+          (i > 0 && op.input(i) == op.output(0))) {
+        return false;
+      }
+    }
+    return op.input_size() > 0;
+  }
+  return false;
+}
+
+std::string Identifier(const std::string& name) {
+  std::string id;
+  for (char c : name) {
+    id += isalnum(static_cast<unsigned char>(c)) ? c : '_';
+  }
+  return id;
+}
+
+// A C++ string literal, octal escaped where needed, to be wrapped in
+// std::string(literal, size) for the embedded NULs.
+std::string Literal(const std::string& bytes) {
+  std::stringstream ss;
+  ss << '"';
+  for (unsigned char c : bytes) {
+    if (isprint(c) && c != '"' && c != '\\' && c != '?') {
+      ss << c;
+    } else {
+      ss << '\\' << static_cast<char>('0' + (c >> 6))
+         << static_cast<char>('0' + ((c >> 3) & 7))
+         << static_cast<char>('0' + (c & 7));
+    }
+  }
+  ss << '"';
+  return ss.str();
+}
+
+std::string Dims(const std::vector<TIndex>& dims) {
+  std::stringstream ss;
+  ss << "{";
+  for (int i = 0; i < dims.size(); ++i) {
+    ss << (i ? ", " : "") << dims[i];
+  }
+  ss << "}";
+  return ss.str();
+}
+
+// Names the variables of the generated code and emits their declarations and
+// initializations.
+class Emitter {
+ public:
+  Emitter(
+      const NetDef& net,
+      const NetPlan& plan,
+      const std::vector<string>& inputs)
+      : net_(net), plan_(plan), inputs_(inputs.begin(), inputs.end()) {
+    for (const auto& name : net.external_input()) {
+      external_inputs_.insert(name);
+    }
+    for (const auto& op : net.op()) {
+      written_.insert(op.output().begin(), op.output().end());
+    }
+  }
+
+  std::string Generate(const std::vector<string>& inputs);
+
+ private:
+  // The expression of the data of a blob read by a lowered operator.
+  std::string Read(const string& name);
+  // The expression of the data of a blob written by a lowered operator,
+  // after the statements resizing its tensor if it has one.
+  std::string Write(const string& name);
+  std::string TensorVar(const string& name);
+  void Lower(const OperatorDef& op);
+
+  const NetDef& net_;
+  const NetPlan& plan_;
+  std::set<string> inputs_;
+  std::set<string> external_inputs_;
+  std::set<string> written_;
+  std::map<string, string> weights_;
+  std::map<string, string> tensors_;
+  std::stringstream members_;
+  std::stringstream ctor_;
+  std::stringstream run_;
+  size_t ones_size_ = 0;
+  size_t softmax_rows_ = 0;
+  int num_operators_ = 0;
+};
+
+std::string Emitter::TensorVar(const string& name) {
+  auto it = tensors_.find(name);
+  if (it != tensors_.end()) {
+    return it->second;
+  }
+  const string var = "t" + caffe2::to_string(tensors_.size()) + "_";
+  members_ << "  TensorCPU* " << var << "; // " << name << "\n";
+  ctor_ << "    " << var << " = GetTensor(" << Literal(name) << ");\n";
+  tensors_[name] = var;
+  return var;
+}
+
+std::string Emitter::Read(const string& name) {
+  auto offset = plan_.arena.offsets.find(name);
+  if (offset != plan_.arena.offsets.end()) {
+    return "(arena_ + " + caffe2::to_string(offset->second / sizeof(float)) +
+        ")";
+  }
+  // The weights do not change between runs, unlike the inputs and the
+  // tensors the net writes to.
+  if (external_inputs_.count(name) && !inputs_.count(name) &&
+      !written_.count(name)) {
+    auto it = weights_.find(name);
+    if (it == weights_.end()) {
+      const string var = "w" + caffe2::to_string(weights_.size()) + "_";
+      members_ << "  const float* " << var << "; // " << name << "\n";
+      ctor_ << "    " << var << " = Weight(" << Literal(name) << ", "
+            << Dims(plan_.dims.at(name)) << ");\n";
+      it = weights_.emplace(name, var).first;
+    }
+    return it->second;
+  }
+  return TensorVar(name) + "->data<float>()";
+}
+
+std::string Emitter::Write(const string& name) {
+  auto offset = plan_.arena.offsets.find(name);
+  if (offset != plan_.arena.offsets.end()) {
+    return "(arena_ + " + caffe2::to_string(offset->second / sizeof(float)) +
+        ")";
+  }
+  const string var = TensorVar(name);
+  run_ << "    " << var << "->Resize(std::vector<TIndex>"
+       << Dims(plan_.dims.at(name)) << ");\n";
+  return var + "->mutable_data<float>()";
+}
+
+void Emitter::Lower(const OperatorDef& op) {
+  const auto& type = op.type();
+  const auto& x_dims = plan_.dims.at(op.input(0));
+  if (type == "FC") {
+    const auto& w_dims = plan_.dims.at(op.input(1));
+    const TIndex M = x_dims[0];
+    const TIndex K = SizeOf(x_dims, 1, x_dims.size());
+    const TIndex N = w_dims[0];
+    CAFFE_ENFORCE_EQ(K, SizeOf(w_dims, 1, w_dims.size()), ProtoDebugString(op));
+    const string X = Read(op.input(0));
+    const string W = Read(op.input(1));
+    const string b = Read(op.input(2));
+    const string Y = Write(op.output(0));
+    if (M <= kFullyConnectedSmallBatchM) {
+      run_ << "    FullyConnectedSmallBatch(" << M << ", " << N << ", " << K
+           << ", " << X << ", " << W << ", " << b << ", " << Y << ");\n";
+    } else {
+      ones_size_ = std::max<size_t>(ones_size_, M);
+      run_ << "    math::Gemm<float, CPUContext>(CblasNoTrans, CblasTrans, "
+           << M << ", " << N << ", " << K << ", 1, " << X << ", " << W
+           << ", 0, " << Y << ", &context_);\n";
+      run_ << "    math::Gemm<float, CPUContext>(CblasNoTrans, CblasNoTrans, "
+           << M << ", " << N << ", 1, 1, ones_.data(), " << b << ", 1, " << Y
+           << ", &context_);\n";
+    }
+    return;
+  }
+  const TIndex n = SizeOf(x_dims);
+  if (type == "Relu" || type == "Sigmoid" || type == "Tanh") {
+    const string X = Read(op.input(0));
+    const string Y = Write(op.output(0));
+    const string value = type == "Relu"
+        ? "std::max(x[i], 0.f)"
+        : type == "Sigmoid" ? "1.f / (1.f + std::exp(-x[i]))"
+                            : "std::tanh(x[i])";
+    run_ << "    {\n"
+         << "      const float* x = " << X << ";\n"
+         << "      float* y = " << Y << ";\n"
+         << "      for (int i = 0; i < " << n << "; ++i) {\n"
+         << "        y[i] = " << value << ";\n"
+         << "      }\n"
+         << "    }\n";
+    return;
+  }
+  if (type == "Softmax") {
+    const int axis = ArgumentHelper(op).GetSingleArgument<int>("axis", 1);
+    const TIndex N = SizeOf(x_dims, 0, axis);
+    const TIndex D = SizeOf(x_dims, axis, x_dims.size());
+    ones_size_ = std::max<size_t>(ones_size_, D);
+    softmax_rows_ = std::max<size_t>(softmax_rows_, N);
+    const string X = Read(op.input(0));
+    const string Y = Write(op.output(0));
+    run_ << "    SoftmaxCPU(context_, " << N << ", " << D << ", " << X << ", "
+         << Y << ", softmax_scale_.data(), ones_.data(), false, "
+         << "softmax_rowmax_.data());\n";
+    return;
+  }
+  if (type == "Add" || type == "Sub" || type == "Mul" || type == "Div") {
+    const string A = Read(op.input(0));
+    const string B = Read(op.input(1));
+    const string Y = Write(op.output(0));
+    run_ << "    math::" << type << "<float, CPUContext>(" << n << ", " << A
+         << ", " << B << ", " << Y << ", &context_);\n";
+    return;
+  }
+  CAFFE_ENFORCE_EQ(type, "Sum");
+  std::vector<string> X;
+  for (const auto& name : op.input()) {
+    X.push_back(Read(name));
+  }
+  const string Y = Write(op.output(0));
+  run_ << "    {\n"
+       << "      float* y = " << Y << ";\n";
+  if (op.input(0) != op.output(0)) {
+    run_ << "      std::copy(" << X[0] << ", " << X[0] << " + " << n
+         << ", y);\n";
+  }
+  for (int i = 1; i < X.size(); ++i) {
+    run_ << "      math::Add<float, CPUContext>(" << n << ", y, " << X[i]
+         << ", y, &context_);\n";
+  }
+  run_ << "    }\n";
+}
+
+std::string Emitter::Generate(const std::vector<string>& inputs) {
+  for (int i = 0; i < net_.op_size(); ++i) {
+    const auto& op = net_.op(i);
+    run_ << "    // #" << i << " " << op.type() << " (";
+    for (int j = 0; j < op.output_size(); ++j) {
+      run_ << (j ? ", " : "") << op.output(j);
+    }
+    run_ << ")\n";
+    if (plan_.lowered[i]) {
+      Lower(op);
+      continue;
+    }
+    const string var = "op" + caffe2::to_string(num_operators_++) + "_";
+    members_ << "  OperatorBase* " << var << ";\n";
+    std::string def;
+    op.SerializeToString(&def);
+    ctor_ << "    " << var << " = AddOperator(std::string(" << Literal(def)
+          << ", " << def.size() << "));\n";
+    run_ << "    if (!" << var << "->Run()) {\n"
+         << "      return false;\n"
+         << "    }\n";
+  }
+
+  const string name = net_.name();
+  const string cls = "CompiledNet_" + Identifier(name);
+  std::stringstream ss;
+  ss << "// Generated by net_compiler from the net " << name
+     << ". Do not edit.\n\n"
+     << "#include <algorithm>\n"
+     << "#include <cmath>\n\n"
+     << "#include \"caffe2/core/compiled_net.h\"\n"
+     << "#include \"caffe2/operators/softmax_shared.h\"\n"
+     << "#include \"caffe2/perfkernels/fc_small_batch.h\"\n"
+     << "#include \"caffe2/utils/math.h\"\n\n"
+     << "namespace caffe2 {\n\n"
+     << "namespace {\n\n"
+     << "class " << cls << " final : public CompiledNet {\n"
+     << " public:\n"
+     << "  explicit " << cls << "(Workspace* ws)\n"
+     << "      : CompiledNet(\n"
+     << "            ws,\n"
+     << "            {";
+  for (int i = 0; i < inputs.size(); ++i) {
+    ss << (i ? ", " : "") << Literal(inputs[i]);
+  }
+  ss << "},\n            {";
+  for (int i = 0; i < inputs.size(); ++i) {
+    ss << (i ? ", " : "") << Dims(plan_.dims.at(inputs[i]));
+  }
+  ss << "},\n            {";
+  for (int i = 0; i < net_.external_output_size(); ++i) {
+    ss << (i ? ", " : "") << Literal(net_.external_output(i));
+  }
+  ss << "}),\n"
+     << "        ones_(" << ones_size_ << ", 1.f),\n"
+     << "        softmax_scale_(" << softmax_rows_ << "),\n"
+     << "        softmax_rowmax_(" << softmax_rows_ << ") {\n"
+     << "    arena_ = Arena(" << plan_.arena.arena_bytes << ");\n"
+     << ctor_.str() << "  }\n\n"
+     << "  bool Run() override {\n"
+     << run_.str() << "    return true;\n"
+     << "  }\n\n"
+     << " private:\n"
+     << "  std::vector<float> ones_;\n"
+     << "  std::vector<float> softmax_scale_;\n"
+     << "  std::vector<float> softmax_rowmax_;\n"
+     << "  float* arena_;\n"
+     << members_.str() << "};\n\n"
+     << "} // namespace\n\n"
+     << "REGISTER_COMPILED_NET(" << Literal(name) << ", " << cls << ");\n\n"
+     << "} // namespace caffe2\n";
+  return ss.str();
+}
+
+} // namespace
+
+NetPlan PlanNet(
+    const NetDef& net,
+    Workspace* ws,
+    const CaffeMap<string, std::vector<TIndex>>& input_dims) {
+  CaffeMap<string, std::vector<TIndex>> blob_dims = input_dims;
+  std::set<string> external_inputs;
+  // The inputs are float tensors, like the --input_dims of speed_benchmark.
+  std::set<string> float_inputs;
+  for (const auto& name : net.external_input()) {
+    external_inputs.insert(name);
+    if (input_dims.count(name)) {
+      float_inputs.insert(name);
+      continue;
+    }
+    auto* blob = ws->GetBlob(name);
+    CAFFE_ENFORCE(
+        blob && blob->IsType<TensorCPU>(),
+        "The weight ",
+        name,
+        " is not a CPU tensor of the workspace");
+    const auto& tensor = blob->Get<TensorCPU>();
+    blob_dims[name] = tensor.dims();
+    if (tensor.IsType<float>()) {
+      float_inputs.insert(name);
+    }
+  }
+
+  NetPlan plan;
+  std::vector<std::unique_ptr<NetDef>> nets;
+  nets.emplace_back(new NetDef(net));
+  // Shape inference takes every given blob for a float one.
+  const auto shapes = InferBlobShapesAndTypesFromMap(blob_dims, nets);
+  for (const auto& shape : shapes.shapes()) {
+    if (!shape.unknown_shape() && shape.data_type() == TensorProto::FLOAT &&
+        (!external_inputs.count(shape.name()) ||
+         float_inputs.count(shape.name()))) {
+      plan.dims[shape.name()] =
+          std::vector<TIndex>(shape.dims().begin(), shape.dims().end());
+    }
+  }
+
+  std::set<string> external_outputs(
+      net.external_output().begin(), net.external_output().end());
+  std::set<string> in_tensors;
+  for (const auto& op : net.op()) {
+    plan.lowered.push_back(CanLower(op, plan.dims, external_inputs));
+    if (!plan.lowered.back()) {
+      in_tensors.insert(op.input().begin(), op.input().end());
+      in_tensors.insert(op.output().begin(), op.output().end());
+    }
+  }
+
+  std::unordered_map<string, size_t> arena_bytes;
+  for (int i = 0; i < net.op_size(); ++i) {
+    if (!plan.lowered[i]) {
+      continue;
+    }
+    for (const auto& name : net.op(i).output()) {
+      if (!in_tensors.count(name) && !external_outputs.count(name)) {
+        arena_bytes[name] = SizeOf(plan.dims.at(name)) * sizeof(float);
+      }
+    }
+  }
+  plan.arena = memonger::plan_static_memory(net, arena_bytes);
+  return plan;
+}
+
+std::string GenerateCpp(
+    const NetDef& net,
+    Workspace* ws,
+    const CaffeMap<string, std::vector<TIndex>>& input_dims) {
+  CAFFE_ENFORCE(!net.name().empty(), "The net to compile needs a name");
+  const auto plan = PlanNet(net, ws, input_dims);
+  // In the order of Predictor::run.
+  std::vector<string> inputs;
+  for (const auto& name : net.external_input()) {
+    if (input_dims.count(name)) {
+      inputs.push_back(name);
+    }
+  }
+  CAFFE_ENFORCE_EQ(
+      inputs.size(),
+      input_dims.size(),
+      "Every input needs to be an external input of the net");
+  return Emitter(net, plan, inputs).Generate(inputs);
+}
+
+} // namespace net_compiler
+} // namespace caffe2
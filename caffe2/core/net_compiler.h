@@ -0,0 +1,64 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_CORE_NET_COMPILER_H_
+#define CAFFE2_CORE_NET_COMPILER_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/memonger.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+namespace net_compiler {
+
+// How the compiled net computes an inference net for static input shapes.
+struct NetPlan {
+  // Per operator, whether it is lowered to direct kernel calls. The other
+  // ones run as regular operators.
+  std::vector<bool> lowered;
+  // Shapes of the float blobs, from shape inference.
+  std::unordered_map<string, std::vector<TIndex>> dims;
+  // Activations that only lowered operators touch live in one arena; the
+  // others are tensors of the workspace.
+  memonger::StaticMemoryPlan arena;
+};
+
+// Plans the lowering of a CPU inference net run by a simple net. `ws` holds
+// the weights, i.e. the external inputs of the net missing from `input_dims`.
+// FC, Relu, Sigmoid, Tanh, Softmax, Add, Sub, Mul, Div and Sum on float
+// tensors are lowered, unless they use broadcasting, engines or arguments
+// that change the layout.
+NetPlan PlanNet(
+    const NetDef& net,
+    Workspace* ws,
+    const CaffeMap<string, std::vector<TIndex>>& input_dims);
+
+// Generates the C++ translation unit of the compiled net, a CompiledNet (see
+// compiled_net.h) registered under the name of `net`.
+std::string GenerateCpp(
+    const NetDef& net,
+    Workspace* ws,
+    const CaffeMap<string, std::vector<TIndex>>& input_dims);
+
+} // namespace net_compiler
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_NET_COMPILER_H_
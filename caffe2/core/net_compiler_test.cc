@@ -0,0 +1,167 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <google/protobuf/text_format.h>
+#include "caffe2/core/compiled_net.h"
+#include "caffe2/core/net_compiler.h"
+#include "caffe2/core/operator.h"
+
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+namespace {
+
+const char* kNetSpec = R"DOC(
+        name: "compiled_net_test"
+        external_input: "data"
+        external_input: "W1"
+        external_input: "b1"
+        external_input: "W2"
+        external_input: "b2"
+        external_output: "prob"
+        op {
+          type: "FC"
+          input: "data"
+          input: "W1"
+          input: "b1"
+          output: "h1"
+        }
+        op {
+          type: "Relu"
+          input: "h1"
+          output: "h1"
+        }
+        op {
+          type: "FC"
+          input: "h1"
+          input: "W2"
+          input: "b2"
+          output: "h2"
+        }
+        op {
+          type: "Copy"
+          input: "h2"
+          output: "h2_copy"
+        }
+        op {
+          type: "Softmax"
+          input: "h2_copy"
+          output: "prob"
+        }
+)DOC";
+
+void AddWeight(Workspace* ws, const string& name, std::vector<TIndex> dims) {
+  auto* tensor = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  tensor->Resize(dims);
+  tensor->mutable_data<float>();
+}
+
+NetDef CreateTestNet(Workspace* ws) {
+  NetDef net;
+  CAFFE_ENFORCE(google::protobuf::TextFormat::ParseFromString(kNetSpec, &net));
+  AddWeight(ws, "W1", {16, 4});
+  AddWeight(ws, "b1", {16});
+  AddWeight(ws, "W2", {3, 16});
+  AddWeight(ws, "b2", {3});
+  return net;
+}
+
+// What net_compiler generates, by hand: y = max(x, 0).
+class CompiledReluTestNet final : public CompiledNet {
+ public:
+  explicit CompiledReluTestNet(Workspace* ws)
+      : CompiledNet(ws, {"x"}, {{2, 3}}, {"y"}) {
+    x_ = GetTensor("x");
+    y_ = GetTensor("y");
+  }
+
+  bool Run() override {
+    const float* x = x_->data<float>();
+    y_->Resize(std::vector<TIndex>{2, 3});
+    float* y = y_->mutable_data<float>();
+    for (int i = 0; i < 6; ++i) {
+      y[i] = std::max(x[i], 0.f);
+    }
+    return true;
+  }
+
+ private:
+  TensorCPU* x_;
+  TensorCPU* y_;
+};
+
+REGISTER_COMPILED_NET("compiled_relu_test", CompiledReluTestNet);
+
+} // namespace
+
+TEST(NetCompilerTest, PlanNet) {
+  Workspace ws;
+  const auto net = CreateTestNet(&ws);
+  const auto plan = net_compiler::PlanNet(net, &ws, {{"data", {2, 4}}});
+  // Copy is not lowered, so its input and output stay in the workspace, as
+  // does the output of the net; only h1 is left for the arena.
+  EXPECT_EQ(plan.lowered, std::vector<bool>({true, true, true, false, true}));
+  EXPECT_EQ(plan.dims.at("h1"), std::vector<TIndex>({2, 16}));
+  EXPECT_EQ(plan.dims.at("prob"), std::vector<TIndex>({2, 3}));
+  EXPECT_EQ(plan.arena.offsets.size(), 1);
+  EXPECT_EQ(plan.arena.offsets.count("h1"), 1);
+  EXPECT_EQ(plan.arena.arena_bytes, 2 * 16 * sizeof(float));
+}
+
+TEST(NetCompilerTest, GenerateCpp) {
+  Workspace ws;
+  const auto net = CreateTestNet(&ws);
+  const auto code = net_compiler::GenerateCpp(net, &ws, {{"data", {2, 4}}});
+  // The batch of 2 takes the small batch FC kernel.
+  EXPECT_NE(
+      code.find("FullyConnectedSmallBatch(2, 16, 4, t0_->data<float>(), w0_"),
+      std::string::npos);
+  EXPECT_NE(code.find("std::max(x[i], 0.f)"), std::string::npos);
+  EXPECT_NE(code.find("SoftmaxCPU(context_, 2, 3, "), std::string::npos);
+  EXPECT_NE(code.find("AddOperator(std::string("), std::string::npos);
+  EXPECT_NE(
+      code.find("REGISTER_COMPILED_NET(\"compiled_net_test\", "
+                "CompiledNet_compiled_net_test);"),
+      std::string::npos);
+
+  // Batches beyond the small batch kernel go through Gemm.
+  const auto large = net_compiler::GenerateCpp(net, &ws, {{"data", {64, 4}}});
+  EXPECT_NE(
+      large.find("math::Gemm<float, CPUContext>(CblasNoTrans, CblasTrans, "
+                 "64, 16, 4"),
+      std::string::npos);
+}
+
+TEST(NetCompilerTest, CompiledPredictor) {
+  CompiledPredictor predictor(NetDef(), "compiled_relu_test");
+  TensorCPU x(std::vector<TIndex>{2, 3});
+  float* data = x.mutable_data<float>();
+  for (int i = 0; i < 6; ++i) {
+    data[i] = i - 3;
+  }
+  CompiledPredictor::TensorVector outputs;
+  EXPECT_TRUE(predictor.run({&x}, &outputs));
+  ASSERT_EQ(outputs.size(), 1);
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(outputs[0]->data<float>()[i], std::max(i - 3, 0));
+  }
+  TensorCPU wrong(std::vector<TIndex>{3, 2});
+  wrong.mutable_data<float>();
+  EXPECT_THROW(predictor.run({&wrong}, &outputs), EnforceNotMet);
+}
+
+} // namespace caffe2
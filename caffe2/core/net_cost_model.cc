@@ -0,0 +1,105 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/net_cost_model.h"
+
+#include <algorithm>
+
+#include "caffe2/core/logging.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+NetCostModel::NetCostModel(const NetDef& net_def, const TensorShapes& shapes)
+    : costs_(net_def.op_size()), known_(net_def.op_size(), false) {
+  CaffeMap<string, const TensorShape*> blob_shapes;
+  for (const auto& shape : shapes.shapes()) {
+    blob_shapes[shape.name()] = &shape;
+  }
+  for (int idx = 0; idx < net_def.op_size(); ++idx) {
+    const auto& op = net_def.op(idx);
+    types_.push_back(op.type());
+    const OpSchema* schema = OpSchemaRegistry::Schema(op.type());
+    if (schema == nullptr || !schema->HasCostInferenceFunction()) {
+      continue;
+    }
+    vector<TensorShape> input_shapes;
+    for (const auto& input : op.input()) {
+      const auto it = blob_shapes.find(input);
+      if (it == blob_shapes.end() || it->second->unknown_shape()) {
+        break;
+      }
+      input_shapes.push_back(*it->second);
+    }
+    if (input_shapes.size() != op.input_size()) {
+      continue;
+    }
+    try {
+      costs_[idx] = schema->InferCost(op, input_shapes);
+      known_[idx] = true;
+    } catch (::caffe2::EnforceNotMet& enf) {
+      VLOG(1) << "Cost inference of " << op.type() << " failed: " << enf.msg();
+      continue;
+    }
+    total_.flops += costs_[idx].flops;
+    total_.bytes_moved += costs_[idx].bytes_moved;
+  }
+}
+
+NetCostModel NetCostModel::FromWorkspace(const NetDef& net_def, Workspace* ws) {
+  vector<std::unique_ptr<NetDef>> nets;
+  nets.emplace_back(new NetDef(net_def));
+  return NetCostModel(
+      net_def, InferBlobShapesAndTypesFromWorkspace(ws, nets));
+}
+
+int NetCostModel::num_known_ops() const {
+  return std::count(known_.begin(), known_.end(), true);
+}
+
+CaffeMap<string, OpSchema::Cost> NetCostModel::CostPerOpType() const {
+  CaffeMap<string, OpSchema::Cost> cost_per_type;
+  for (int idx = 0; idx < num_ops(); ++idx) {
+    if (known_[idx]) {
+      auto& cost = cost_per_type[types_[idx]];
+      cost.flops += costs_[idx].flops;
+      cost.bytes_moved += costs_[idx].bytes_moved;
+    }
+  }
+  return cost_per_type;
+}
+
+double NetCostModel::MinSeconds(
+    int idx,
+    double peak_flops,
+    double peak_bandwidth) const {
+  CAFFE_ENFORCE_GT(peak_flops, 0);
+  CAFFE_ENFORCE_GT(peak_bandwidth, 0);
+  return std::max(
+      costs_[idx].flops / peak_flops,
+      costs_[idx].bytes_moved / peak_bandwidth);
+}
+
+double NetCostModel::MinSeconds(double peak_flops, double peak_bandwidth)
+    const {
+  double seconds = 0;
+  for (int idx = 0; idx < num_ops(); ++idx) {
+    seconds += MinSeconds(idx, peak_flops, peak_bandwidth);
+  }
+  return seconds;
+}
+
+} // namespace caffe2
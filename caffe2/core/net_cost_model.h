@@ -0,0 +1,79 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_CORE_NET_COST_MODEL_H_
+#define CAFFE2_CORE_NET_COST_MODEL_H_
+
+#include <string>
+#include <vector>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/operator_schema.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+
+/**
+ * Estimates the work of a net from the cost inference functions of the
+ * schemas of its ops, given the shapes of its blobs (e.g. as inferred by
+ * InferBlobShapesAndTypesFromMap).
+ *
+ * An op is unknown, and counts as free, when its schema has no cost
+ * inference function, when the shape of one of its inputs is not known, or
+ * when its cost function fails on them.
+ */
+class NetCostModel {
+ public:
+  NetCostModel(const NetDef& net_def, const TensorShapes& shapes);
+
+  // Takes the shapes of the blobs of ws, e.g. after a run of the net, and
+  // infers the others.
+  static NetCostModel FromWorkspace(const NetDef& net_def, Workspace* ws);
+
+  int num_ops() const {
+    return costs_.size();
+  }
+  int num_known_ops() const;
+  bool known(int idx) const {
+    return known_[idx];
+  }
+  const OpSchema::Cost& op_cost(int idx) const {
+    return costs_[idx];
+  }
+  const OpSchema::Cost& total_cost() const {
+    return total_;
+  }
+
+  // The summed cost of the known ops of each type.
+  CaffeMap<string, OpSchema::Cost> CostPerOpType() const;
+
+  // The least seconds the op, or the net, can take on a device with the
+  // given peak flops per second and memory bandwidth in bytes per second,
+  // each op being bound by the slower of the two.
+  double MinSeconds(int idx, double peak_flops, double peak_bandwidth) const;
+  double MinSeconds(double peak_flops, double peak_bandwidth) const;
+
+ private:
+  std::vector<string> types_;
+  std::vector<OpSchema::Cost> costs_;
+  std::vector<bool> known_;
+  OpSchema::Cost total_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_NET_COST_MODEL_H_
@@ -0,0 +1,78 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include "caffe2/core/graph.h"
+#include "caffe2/core/net_cost_model.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+namespace {
+
+NetDef CostModelNet() {
+  NetDef net_def;
+  AddOp(&net_def, "FC", {"X", "W", "b"}, {"Y"});
+  AddOp(&net_def, "Relu", {"Y"}, {"Z"});
+  // Transpose has no cost inference function.
+  AddOp(&net_def, "Transpose", {"Z"}, {"Z_t"});
+  return net_def;
+}
+
+TEST(NetCostModelTest, TestCosts) {
+  const NetDef net_def = CostModelNet();
+  vector<std::unique_ptr<NetDef>> nets;
+  nets.emplace_back(new NetDef(net_def));
+  NetCostModel model(
+      net_def,
+      InferBlobShapesAndTypesFromMap(
+          {{"X", {4, 8}}, {"W", {16, 8}}, {"b", {16}}}, nets));
+
+  ASSERT_EQ(model.num_ops(), 3);
+  EXPECT_EQ(model.num_known_ops(), 2);
+  ASSERT_TRUE(model.known(0));
+  // 2 * M * N * K multiply-adds and M * N bias adds, and X, W, b and Y.
+  EXPECT_EQ(model.op_cost(0).flops, 2 * 4 * 16 * 8 + 4 * 16);
+  EXPECT_EQ(model.op_cost(0).bytes_moved, (32 + 128 + 16 + 64) * 4);
+  ASSERT_TRUE(model.known(1));
+  EXPECT_EQ(model.op_cost(1).flops, 2 * 64);
+  EXPECT_EQ(model.op_cost(1).bytes_moved, 2 * 64 * 4);
+  EXPECT_FALSE(model.known(2));
+  EXPECT_EQ(model.total_cost().flops, 1088 + 128);
+  EXPECT_EQ(model.total_cost().bytes_moved, 960 + 512);
+
+  const auto per_type = model.CostPerOpType();
+  EXPECT_EQ(per_type.size(), 2);
+  EXPECT_EQ(per_type.at("FC").flops, 1088);
+  EXPECT_EQ(per_type.count("Transpose"), 0);
+
+  // The FC is bound by its flops, the Relu by its bytes.
+  EXPECT_NEAR(model.MinSeconds(0, 1e3, 1e3), 1.088, 1e-9);
+  EXPECT_NEAR(model.MinSeconds(1, 1e3, 1e3), 0.512, 1e-9);
+  EXPECT_NEAR(model.MinSeconds(1e3, 1e3), 1.6, 1e-9);
+}
+
+TEST(NetCostModelTest, TestUnknownShapes) {
+  const NetDef net_def = CostModelNet();
+  NetCostModel model(net_def, TensorShapes());
+  EXPECT_EQ(model.num_known_ops(), 0);
+  EXPECT_EQ(model.total_cost().flops, 0);
+  EXPECT_EQ(model.MinSeconds(1e3, 1e3), 0);
+}
+
+} // namespace
+
+} // namespace caffe2
@@ -207,7 +207,11 @@ void DAGNetBase::WorkerFunction() {
         idx,
         ".");
     const auto& chain = execution_chains_[idx];
-    bool this_success = RunAt(idx, execution_chains_[idx]);
+    bool this_success;
+    {
+      InterOpTaskScope inter_op_task;
+      this_success = RunAt(idx, execution_chains_[idx]);
+    }
     if (!this_success) {
       LOG(ERROR) << "Operator chain failed: "
                  << ProtoDebugString(
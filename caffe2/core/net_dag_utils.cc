@@ -16,8 +16,12 @@
 
 #include "caffe2/core/net_dag_utils.h"
 
+#include <functional>
+#include <numeric>
+#include <queue>
 #include <set>
 #include <stack>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -27,6 +31,13 @@
 #include "caffe2/proto/caffe2.pb.h"
 #include "caffe2/utils/proto_utils.h"
 
+CAFFE2_DEFINE_bool(
+    caffe2_net_async_hip_comm_stream,
+    true,
+    "Run the communication ops of HIP nets in chains of their own, on a high "
+    "priority stream of their GPU, so that collectives are not queued behind "
+    "compute kernels");
+
 namespace caffe2 {
 namespace dag_utils {
 
@@ -198,12 +209,15 @@ ExecutionChains computeChains(std::vector<OperatorNode>& orig_nodes) {
              //  2. Parent op has async part _and_
              //     both ops are on the same device _and_
              //     dependent op can be executed as an async dependency
-
-             !orig_nodes[chain.back()].operator_->HasAsyncPart() ||
-             (IsSameDevice(
-                  orig_nodes[cur.first].operator_->device_option(),
-                  orig_nodes[chain.back()].operator_->device_option()) &&
-              orig_nodes[cur.first].operator_->SupportsAsyncScheduling()))));
+             // and both ops have to run on the communication stream of
+             // their GPU or neither does (see runsOnCommStream).
+             (!orig_nodes[chain.back()].operator_->HasAsyncPart() ||
+              (IsSameDevice(
+                   orig_nodes[cur.first].operator_->device_option(),
+                   orig_nodes[chain.back()].operator_->device_option()) &&
+               orig_nodes[cur.first].operator_->SupportsAsyncScheduling())) &&
+             runsOnCommStream(*orig_nodes[cur.first].operator_) ==
+                 runsOnCommStream(*orig_nodes[chain.back()].operator_))));
   };
   auto commit_chain = [&]() {
     if (chain.size() > 0) {
@@ -442,5 +456,210 @@ std::vector<OpGraphNode> prepareChainGraphNodes(
   return chain_nodes;
 }
 
+bool isCommunicationOp(const std::string& op_type) {
+  const auto* schema = OpSchemaRegistry::Schema(op_type);
+  if (schema && schema->communication_op()) {
+    return true;
+  }
+  static const std::unordered_set<std::string> kCommOps{
+      "Allreduce",
+      "Allgather",
+      "Broadcast",
+      "Barrier",
+      "ReduceScatter",
+  };
+  return kCommOps.count(op_type) || op_type.compare(0, 4, "NCCL") == 0 ||
+      op_type.compare(0, 3, "MPI") == 0;
+}
+
+bool runsOnCommStream(const OperatorBase& op) {
+  return FLAGS_caffe2_net_async_hip_comm_stream &&
+      op.device_option().device_type() == HIP && op.has_debug_def() &&
+      isCommunicationOp(op.debug_def().type());
+}
+
+std::vector<int> computeChainPriorities(
+    const std::shared_ptr<const NetDef>& net_def,
+    const std::vector<std::vector<int>>& execution_chains,
+    const std::vector<OpGraphNode>& chain_nodes) {
+  const int num_chains = execution_chains.size();
+  std::vector<int> explicit_priority(num_chains, INT_MIN);
+  std::vector<int> has_comm(num_chains, 0);
+  for (int chain_idx = 0; chain_idx < num_chains; ++chain_idx) {
+    for (auto op_idx : execution_chains[chain_idx]) {
+      const auto& op_def = net_def->op(op_idx);
+      explicit_priority[chain_idx] =
+          std::max(explicit_priority[chain_idx], op_def.priority());
+      if (isCommunicationOp(op_def.type())) {
+        has_comm[chain_idx] = 1;
+      }
+    }
+  }
+
+  // Longest path to a sink, computed in reverse topological order.
+  std::vector<int> order;
+  order.reserve(num_chains);
+  std::vector<int> pending_children(num_chains);
+  for (int chain_idx = 0; chain_idx < num_chains; ++chain_idx) {
+    pending_children[chain_idx] = chain_nodes[chain_idx].children_.size();
+    if (pending_children[chain_idx] == 0) {
+      order.push_back(chain_idx);
+    }
+  }
+  std::vector<int> path_length(num_chains, 0);
+  for (int i = 0; i < order.size(); ++i) {
+    const auto chain_idx = order[i];
+    int longest_child = 0;
+    for (auto child_idx : chain_nodes[chain_idx].children_) {
+      longest_child = std::max(longest_child, path_length[child_idx]);
+    }
+    path_length[chain_idx] =
+        longest_child + execution_chains[chain_idx].size();
+    for (auto parent_idx : chain_nodes[chain_idx].parents_) {
+      if (--pending_children[parent_idx] == 0) {
+        order.push_back(parent_idx);
+      }
+    }
+  }
+  CAFFE_ENFORCE_EQ(order.size(), num_chains, "Chain graph has a cycle");
+
+  std::vector<int> sorted(num_chains);
+  std::iota(sorted.begin(), sorted.end(), 0);
+  // Ties are broken by the position in the net, earlier ops first.
+  auto key = [&](int chain_idx) {
+    return std::make_tuple(
+        explicit_priority[chain_idx],
+        has_comm[chain_idx],
+        path_length[chain_idx],
+        -execution_chains[chain_idx].front());
+  };
+  std::sort(sorted.begin(), sorted.end(), [&](int a, int b) {
+    return key(a) < key(b);
+  });
+  std::vector<int> priorities(num_chains);
+  for (int rank = 0; rank < num_chains; ++rank) {
+    priorities[sorted[rank]] = rank;
+  }
+  return priorities;
+}
+
+std::vector<int> computeChainStreams(
+    const std::vector<OpGraphNode>& chain_nodes,
+    const std::vector<int>& chain_devices,
+    int streams_per_device) {
+  const int num_chains = chain_nodes.size();
+  CAFFE_ENFORCE_EQ(chain_devices.size(), num_chains);
+  CAFFE_ENFORCE_GT(streams_per_device, 0);
+
+  // Chains are planned in topological order, the ones that come first in the
+  // net first among those that are ready.
+  std::vector<int> order;
+  order.reserve(num_chains);
+  std::vector<int> pending_parents(num_chains);
+  std::priority_queue<int, std::vector<int>, std::greater<int>> ready;
+  for (int chain_idx = 0; chain_idx < num_chains; ++chain_idx) {
+    pending_parents[chain_idx] = chain_nodes[chain_idx].parents_.size();
+    if (pending_parents[chain_idx] == 0) {
+      ready.push(chain_idx);
+    }
+  }
+  while (!ready.empty()) {
+    const auto chain_idx = ready.top();
+    ready.pop();
+    order.push_back(chain_idx);
+    for (auto child_idx : chain_nodes[chain_idx].children_) {
+      if (--pending_parents[child_idx] == 0) {
+        ready.push(child_idx);
+      }
+    }
+  }
+  CAFFE_ENFORCE_EQ(order.size(), num_chains, "Chain graph has a cycle");
+  std::vector<int> position(num_chains);
+  for (int i = 0; i < num_chains; ++i) {
+    position[order[i]] = i;
+  }
+
+  // Last chain planned on each stream of a device, -1 for unused streams.
+  std::unordered_map<int, std::vector<int>> tails;
+  std::vector<int> streams(num_chains, 0);
+  std::vector<char> is_ancestor(num_chains, 0);
+  std::vector<int> ancestors;
+  for (auto chain_idx : order) {
+    const auto device = chain_devices[chain_idx];
+    if (device < 0) {
+      continue;
+    }
+    auto& device_tails = tails[device];
+    if (device_tails.empty()) {
+      device_tails.assign(streams_per_device, -1);
+    }
+
+    // Continuing the stream of a parent saves the event between them; only
+    // one child of a parent can, its siblings may run concurrently with it.
+    int stream_id = -1;
+    for (auto parent_idx : chain_nodes[chain_idx].parents_) {
+      if (chain_devices[parent_idx] == device &&
+          device_tails[streams[parent_idx]] == parent_idx) {
+        stream_id = streams[parent_idx];
+        break;
+      }
+    }
+    if (stream_id < 0) {
+      stream_id = std::find(device_tails.begin(), device_tails.end(), -1) -
+          device_tails.begin();
+    }
+    if (stream_id == streams_per_device) {
+      // All streams are used: a stream whose last chain is an ancestor is
+      // idle by the time the chain runs, else share the one that has been
+      // waiting the longest. Ancestors that come before all of the tails
+      // don't matter.
+      int oldest_tail_position = num_chains;
+      for (auto tail_idx : device_tails) {
+        oldest_tail_position =
+            std::min(oldest_tail_position, position[tail_idx]);
+      }
+      std::vector<int> stack(
+          chain_nodes[chain_idx].parents_.begin(),
+          chain_nodes[chain_idx].parents_.end());
+      while (!stack.empty()) {
+        const auto node_idx = stack.back();
+        stack.pop_back();
+        if (is_ancestor[node_idx] ||
+            position[node_idx] < oldest_tail_position) {
+          continue;
+        }
+        is_ancestor[node_idx] = 1;
+        ancestors.push_back(node_idx);
+        stack.insert(
+            stack.end(),
+            chain_nodes[node_idx].parents_.begin(),
+            chain_nodes[node_idx].parents_.end());
+      }
+
+      int oldest_stream_id = 0;
+      stream_id = -1;
+      for (int candidate = 0; candidate < streams_per_device; ++candidate) {
+        const auto tail_idx = device_tails[candidate];
+        if (is_ancestor[tail_idx] && stream_id < 0) {
+          stream_id = candidate;
+        }
+        if (position[tail_idx] < position[device_tails[oldest_stream_id]]) {
+          oldest_stream_id = candidate;
+        }
+      }
+      if (stream_id < 0) {
+        stream_id = oldest_stream_id;
+      }
+      for (auto node_idx : ancestors) {
+        is_ancestor[node_idx] = 0;
+      }
+      ancestors.clear();
+    }
+    streams[chain_idx] = stream_id;
+    device_tails[stream_id] = chain_idx;
+  }
+  return streams;
+}
+
 } // namespace dag_utils
 } // namespace caffe2
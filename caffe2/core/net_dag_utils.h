@@ -70,6 +70,38 @@ std::vector<OpGraphNode> prepareChainGraphNodes(
     const std::vector<dag_utils::OperatorNode>& operator_nodes,
     const std::vector<std::vector<int>>& execution_chains);
 
+// Returns true for the operators that talk to other devices or hosts
+// (Gloo, NCCL/RCCL and MPI collectives, point-to-point sends/receives), as
+// marked by OpSchema::CommunicationOp or known by name.
+bool isCommunicationOp(const std::string& op_type);
+
+// Returns true for the HIP communication ops, which computeChains puts in
+// chains of their own and async nets run on the high priority communication
+// stream of their GPU (stream id caffe2_streams_per_gpu), unless
+// --caffe2_net_async_hip_comm_stream is off.
+bool runsOnCommStream(const OperatorBase& op);
+
+// Ranks the chains for scheduling; a chain with a higher value should be
+// started first when several are ready. Chains are ordered by the highest
+// OperatorDef.priority of their ops, then by whether they contain a
+// communication op, then by the length (in ops) of the longest path from the
+// chain to the end of the net, so that the critical path is not delayed.
+std::vector<int> computeChainPriorities(
+    const std::shared_ptr<const NetDef>& net_def,
+    const std::vector<std::vector<int>>& execution_chains,
+    const std::vector<OpGraphNode>& chain_nodes);
+
+// Plans the streams of the chains that run on GPUs, chain_devices holds the
+// GPU id of each chain or -1 for chains that don't use streams (their stream
+// is 0). A chain continues the stream of one of its parents on the same GPU
+// when no other child took it, so serial chains don't need events between
+// them, and chains that may run concurrently get distinct streams as long as
+// there are enough of them.
+std::vector<int> computeChainStreams(
+    const std::vector<OpGraphNode>& chain_nodes,
+    const std::vector<int>& chain_devices,
+    int streams_per_device);
+
 } // namespace dag_utils
 } // namespace caffe2
 
@@ -0,0 +1,226 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/net_simple.h"
+
+#include <tuple>
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/workspace.h"
+
+namespace caffe2 {
+
+namespace {
+
+// A net that captures one iteration of a static-shape net into a hipGraph
+// and replays it, so that an iteration costs a single graph launch instead
+// of one launch per kernel.
+//
+// Every run first builds a signature of the external inputs (shape and data
+// pointer, since the captured kernels use raw pointers). When it changes, the
+// graph is dropped, one eager run lets the operators allocate their buffers
+// for the new shapes, and the next run is captured. Nets that cannot be
+// captured (operators that are not all HIP on a single GPU, or operators
+// that sync or allocate while running) fall back to running like SimpleNet.
+//
+// Without hipGraph support in the HIP runtime (CAFFE2_USE_HIP_GRAPH), the net
+// always runs like SimpleNet.
+class HIPGraphNet final : public SimpleNet
+{
+    public:
+    HIPGraphNet(const std::shared_ptr<const NetDef>& net_def, Workspace* ws)
+        : SimpleNet(net_def, ws), ws_(ws)
+    {
+#ifdef CAFFE2_USE_HIP_GRAPH
+        capturable_ = !operators_.empty();
+        for(const auto& op : operators_)
+        {
+            const auto& option = op->device_option();
+            if(option.device_type() != HIP ||
+               option.hip_gpu_id() != operators_[0]->device_option().hip_gpu_id())
+            {
+                capturable_ = false;
+                break;
+            }
+        }
+        if(capturable_)
+        {
+            gpu_id_ = operators_[0]->device_option().hip_gpu_id();
+        }
+        else
+        {
+            LOG(WARNING) << "Net " << name_ << " has operators that are not HIP operators on a "
+                         << "single GPU, it will not be captured into a hipGraph.";
+        }
+#endif // CAFFE2_USE_HIP_GRAPH
+    }
+
+    ~HIPGraphNet() override
+    {
+#ifdef CAFFE2_USE_HIP_GRAPH
+        ResetGraph();
+#endif // CAFFE2_USE_HIP_GRAPH
+    }
+
+    protected:
+    bool Run() override
+    {
+#ifdef CAFFE2_USE_HIP_GRAPH
+        if(!capturable_)
+        {
+            return SimpleNet::Run();
+        }
+        auto signature = InputSignature();
+        if(signature != signature_)
+        {
+            ResetGraph();
+            signature_ = std::move(signature);
+            warmed_up_ = false;
+        }
+        if(!warmed_up_)
+        {
+            warmed_up_ = true;
+            return SimpleNet::Run();
+        }
+        if(graph_exec_ == nullptr && !Capture())
+        {
+            return SimpleNet::Run();
+        }
+        StartAllObservers();
+        DeviceGuard guard(gpu_id_);
+        const auto stream = HIPContext::hip_stream(gpu_id_, 0);
+        HIP_ENFORCE(hipGraphLaunch(graph_exec_, stream));
+        HIP_ENFORCE(hipStreamSynchronize(stream));
+        StopAllObservers();
+        return true;
+#else
+        return SimpleNet::Run();
+#endif // CAFFE2_USE_HIP_GRAPH
+    }
+
+    bool RunAsync() override { return Run(); }
+
+    private:
+#ifdef CAFFE2_USE_HIP_GRAPH
+    using InputKey = std::tuple<const void*, vector<TIndex>>;
+
+    vector<InputKey> InputSignature() const
+    {
+        vector<InputKey> signature;
+        for(const auto& name : external_input_)
+        {
+            const Blob* blob = ws_->GetBlob(name);
+            if(blob == nullptr)
+            {
+                signature.emplace_back(nullptr, vector<TIndex>());
+            }
+            else if(blob->IsType<TensorHIP>())
+            {
+                const auto& tensor = blob->Get<TensorHIP>();
+                signature.emplace_back(tensor.raw_data(), tensor.dims());
+            }
+            else if(blob->IsType<TensorCPU>())
+            {
+                const auto& tensor = blob->Get<TensorCPU>();
+                signature.emplace_back(tensor.raw_data(), tensor.dims());
+            }
+            else
+            {
+                signature.emplace_back(blob->GetRaw(), vector<TIndex>());
+            }
+        }
+        return signature;
+    }
+
+    // Records the asynchronous part of every operator on the stream of the
+    // net. The capture is global, so that operators that sync the stream or
+    // allocate device memory make it fail rather than record a graph that is
+    // not safe to replay. In that case the net stops trying to capture.
+    bool Capture()
+    {
+        DeviceGuard guard(gpu_id_);
+        const auto stream = HIPContext::hip_stream(gpu_id_, 0);
+        HIP_ENFORCE(hipStreamBeginCapture(stream, hipStreamCaptureModeGlobal));
+        bool success = true;
+        try
+        {
+            for(auto& op : operators_)
+            {
+                if(!op->RunAsync(0))
+                {
+                    success = false;
+                    break;
+                }
+            }
+        }
+        catch(const std::exception& e)
+        {
+            VLOG(1) << "Capture of net " << name_ << " failed: " << e.what();
+            success = false;
+        }
+        hipGraph_t graph  = nullptr;
+        hipError_t status = hipStreamEndCapture(stream, &graph);
+        if(success && status == hipSuccess && graph != nullptr)
+        {
+            status  = hipGraphInstantiate(&graph_exec_, graph, nullptr, nullptr, 0);
+            success = status == hipSuccess;
+        }
+        else
+        {
+            success = false;
+        }
+        if(graph != nullptr)
+        {
+            HIP_ENFORCE(hipGraphDestroy(graph));
+        }
+        if(!success)
+        {
+            // Clear the sticky capture error, if any.
+            hipGetLastError();
+            graph_exec_ = nullptr;
+            capturable_ = false;
+            LOG(WARNING) << "Net " << name_ << " could not be captured into a hipGraph, "
+                         << "running it as a simple net.";
+        }
+        return success;
+    }
+
+    void ResetGraph()
+    {
+        if(graph_exec_ != nullptr)
+        {
+            HIP_CHECK(hipGraphExecDestroy(graph_exec_));
+            graph_exec_ = nullptr;
+        }
+    }
+
+    bool capturable_           = false;
+    bool warmed_up_            = false;
+    int gpu_id_                = 0;
+    hipGraphExec_t graph_exec_ = nullptr;
+    vector<InputKey> signature_;
+#endif // CAFFE2_USE_HIP_GRAPH
+    Workspace* ws_;
+
+    DISABLE_COPY_AND_ASSIGN(HIPGraphNet);
+};
+
+} // namespace
+
+REGISTER_NET(hip_graph, HIPGraphNet);
+
+} // namespace caffe2
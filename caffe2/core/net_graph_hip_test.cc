@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+namespace {
+
+void FeedInput(Workspace* ws, const vector<TIndex>& dims, float offset)
+{
+    TensorCPU input(dims);
+    for(int i = 0; i < input.size(); ++i)
+    {
+        input.mutable_data<float>()[i] = i + offset;
+    }
+    ws->CreateBlob("X")->GetMutable<TensorHIP>()->CopyFrom(input);
+}
+
+void CheckOutput(Workspace* ws, const vector<TIndex>& dims, float offset)
+{
+    TensorCPU output(ws->GetBlob("Z")->Get<TensorHIP>());
+    EXPECT_EQ(output.dims(), dims);
+    for(int i = 0; i < output.size(); ++i)
+    {
+        EXPECT_FLOAT_EQ(output.data<float>()[i], 6 * (i + offset));
+    }
+}
+
+} // namespace
+
+TEST(HIPGraphNetTest, ReplaysAndRecaptures)
+{
+    if(!HasHipGPU())
+        return;
+    NetDef net_def;
+    net_def.set_type("hip_graph");
+    net_def.mutable_device_option()->set_device_type(HIP);
+    net_def.add_external_input("X");
+    auto* scale = net_def.add_op();
+    scale->CopyFrom(CreateOperatorDef(
+        "Scale", "", vector<string>{"X"}, vector<string>{"Y"}, {MakeArgument<float>("scale", 2)}));
+    scale = net_def.add_op();
+    scale->CopyFrom(CreateOperatorDef(
+        "Scale", "", vector<string>{"Y"}, vector<string>{"Z"}, {MakeArgument<float>("scale", 3)}));
+
+    Workspace ws;
+    FeedInput(&ws, {2, 3}, 0);
+    NetBase* net = ws.CreateNet(net_def);
+    ASSERT_TRUE(net != nullptr);
+    // Eager warm up run, captured run, then replays that see new input values.
+    for(int run = 0; run < 4; ++run)
+    {
+        FeedInput(&ws, {2, 3}, run);
+        EXPECT_TRUE(net->Run());
+        CheckOutput(&ws, {2, 3}, run);
+    }
+    // A new shape drops the graph.
+    for(int run = 0; run < 3; ++run)
+    {
+        FeedInput(&ws, {4, 5}, run);
+        EXPECT_TRUE(net->Run());
+        CheckOutput(&ws, {4, 5}, run);
+    }
+}
+
+} // namespace caffe2
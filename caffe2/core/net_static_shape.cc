@@ -0,0 +1,189 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/net_simple.h"
+
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/core/workspace.h"
+
+namespace caffe2 {
+
+namespace {
+
+// A SimpleNet for nets whose shapes only depend on the shapes of their
+// external inputs. Every run builds a signature of the types and shapes of
+// the external inputs; when it changes, the outputs of the operators are
+// resized and allocated up front from the OpSchema shape inference of the
+// net, so that the Resize and mutable_data calls of the operators find their
+// outputs ready. Shape inference runs once per signature: the resulting
+// allocation plans are cached, and a run with an unchanged signature costs a
+// lookup of the external inputs.
+//
+// Only the blobs that are written by a single operator, and are neither
+// external inputs nor read before they are written, are preallocated, so
+// that the preallocation can not change what any operator reads. Outputs
+// whose shape or type can not be inferred are left to their operator.
+class StaticShapeNet final : public SimpleNet {
+ public:
+  StaticShapeNet(const std::shared_ptr<const NetDef>& net_def, Workspace* ws)
+      : SimpleNet(net_def, ws), ws_(ws) {
+    std::unordered_map<string, int> writes;
+    for (const auto& op : net_def->op()) {
+      for (const auto& output : op.output()) {
+        ++writes[output];
+      }
+    }
+    std::unordered_set<string> seen(
+        external_input_.begin(), external_input_.end());
+    for (int idx = 0; idx < net_def->op_size(); ++idx) {
+      const auto& op = net_def->op(idx);
+      seen.insert(op.input().begin(), op.input().end());
+      for (int i = 0; i < op.output_size(); ++i) {
+        const auto& output = op.output(i);
+        if (!seen.count(output) && writes[output] == 1) {
+          outputs_.push_back({operators_[idx].get(), i, output});
+        }
+        seen.insert(output);
+      }
+    }
+    VLOG(1) << "Net " << name_ << " preallocates " << outputs_.size()
+            << " outputs";
+  }
+
+ protected:
+  bool Run() override {
+    auto signature = InputSignature();
+    if (!planned_ || signature != signature_) {
+      auto it = plans_.find(signature);
+      if (it == plans_.end()) {
+        if (plans_.size() >= kMaxCachedSignatures) {
+          plans_.clear();
+        }
+        it = plans_.emplace(signature, MakePlan()).first;
+      }
+      for (const auto& entry : it->second) {
+        entry.op->PreallocateOutput(entry.idx, entry.shape);
+      }
+      signature_ = std::move(signature);
+      planned_ = true;
+    }
+    return SimpleNet::Run();
+  }
+
+  bool RunAsync() override {
+    return Run();
+  }
+
+ private:
+  static constexpr size_t kMaxCachedSignatures = 64;
+
+  struct Output {
+    OperatorBase* op;
+    int idx;
+    string name;
+  };
+
+  struct PlanEntry {
+    OperatorBase* op;
+    int idx;
+    TensorShape shape;
+  };
+
+  // Type id, number of dimensions and dimensions of each external input, or
+  // -1 for the inputs that are not tensors.
+  vector<TIndex> InputSignature() const {
+    vector<TIndex> signature;
+    for (const auto& name : external_input_) {
+      const Blob* blob = ws_->GetBlob(name);
+      TensorInfoCall tensor_info_fun =
+          blob ? GetTensorInfoFunction(blob->meta().id()) : nullptr;
+      if (!tensor_info_fun) {
+        signature.push_back(-1);
+        continue;
+      }
+      bool shares_data;
+      size_t capacity;
+      DeviceOption device;
+      const auto dims = tensor_info_fun(
+          const_cast<Blob*>(blob)->GetRaw(), &shares_data, &capacity, &device);
+      signature.push_back(static_cast<TIndex>(blob->meta().id()));
+      signature.push_back(dims.size());
+      signature.insert(signature.end(), dims.begin(), dims.end());
+    }
+    return signature;
+  }
+
+  vector<PlanEntry> MakePlan() const {
+    vector<std::unique_ptr<NetDef>> nets;
+    nets.emplace_back(new NetDef(debug_def()));
+    const auto shapes =
+        InferBlobShapesAndTypesFromWorkspace(ws_, external_input_, nets);
+    CaffeMap<string, const TensorShape*> shape_of;
+    for (const auto& shape : shapes.shapes()) {
+      shape_of[shape.name()] = &shape;
+    }
+
+    vector<PlanEntry> plan;
+    for (const auto& output : outputs_) {
+      auto it = shape_of.find(output.name);
+      if (it == shape_of.end() || !IsPlannable(*it->second)) {
+        continue;
+      }
+      plan.push_back({output.op, output.idx, *it->second});
+    }
+    VLOG(1) << "Net " << name_ << " planned " << plan.size() << " of "
+            << outputs_.size() << " outputs for a new input signature";
+    return plan;
+  }
+
+  static bool IsPlannable(const TensorShape& shape) {
+    if (shape.unknown_shape() ||
+        shape.data_type() == TensorProto_DataType_UNDEFINED) {
+      return false;
+    }
+    for (auto d : shape.dims()) {
+      if (d < 0) {
+        return false;
+      }
+    }
+    try {
+      DataTypeToTypeMeta(shape.data_type());
+    } catch (const std::runtime_error&) {
+      return false;
+    }
+    return true;
+  }
+
+  Workspace* ws_;
+  vector<Output> outputs_;
+  bool planned_ = false;
+  vector<TIndex> signature_;
+  std::map<vector<TIndex>, vector<PlanEntry>> plans_;
+
+  DISABLE_COPY_AND_ASSIGN(StaticShapeNet);
+};
+
+constexpr size_t StaticShapeNet::kMaxCachedSignatures;
+
+} // namespace
+
+REGISTER_NET(static_shape, StaticShapeNet);
+
+} // namespace caffe2
@@ -0,0 +1,95 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Records the size of its output before resizing it like its input.
+class StaticShapeTestOp final : public Operator<CPUContext> {
+ public:
+  StaticShapeTestOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    size_before_run_ = Output(0)->size();
+    data_before_run_ = Output(0)->size() > 0 ? Output(0)->raw_data() : nullptr;
+    Output(0)->ResizeLike(Input(0));
+    Output(0)->mutable_data<float>();
+    return true;
+  }
+
+  static TIndex size_before_run_;
+  static const void* data_before_run_;
+};
+
+TIndex StaticShapeTestOp::size_before_run_ = -1;
+const void* StaticShapeTestOp::data_before_run_ = nullptr;
+
+REGISTER_CPU_OPERATOR(StaticShapeTest, StaticShapeTestOp);
+
+OPERATOR_SCHEMA(StaticShapeTest)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .IdenticalTypeAndShape();
+
+std::unique_ptr<NetBase> CreateStaticShapeTestNet(Workspace* ws) {
+  NetDef net_def;
+  net_def.set_type("static_shape");
+  auto& op = *(net_def.add_op());
+  op.set_type("StaticShapeTest");
+  op.add_input("in");
+  op.add_output("out");
+  net_def.add_external_input("in");
+  return CreateNet(net_def, ws);
+}
+
+void FeedInput(Workspace* ws, const vector<TIndex>& dims) {
+  auto* tensor = ws->CreateBlob("in")->GetMutable<TensorCPU>();
+  tensor->Resize(dims);
+  tensor->mutable_data<float>();
+}
+
+} // namespace
+
+TEST(StaticShapeNetTest, PreallocatesOutputs) {
+  Workspace ws;
+  FeedInput(&ws, {4, 5});
+  auto net = CreateStaticShapeTestNet(&ws);
+  ASSERT_TRUE(net.get() != nullptr);
+
+  EXPECT_TRUE(net->Run());
+  EXPECT_EQ(StaticShapeTestOp::size_before_run_, 20);
+  EXPECT_TRUE(StaticShapeTestOp::data_before_run_ != nullptr);
+  const auto& out = ws.GetBlob("out")->Get<TensorCPU>();
+  EXPECT_EQ(out.dims(), (vector<TIndex>{4, 5}));
+
+  FeedInput(&ws, {8, 5});
+  EXPECT_TRUE(net->Run());
+  EXPECT_EQ(StaticShapeTestOp::size_before_run_, 40);
+  EXPECT_EQ(out.dims(), (vector<TIndex>{8, 5}));
+
+  // Back to a cached signature
+  FeedInput(&ws, {4, 5});
+  EXPECT_TRUE(net->Run());
+  EXPECT_EQ(StaticShapeTestOp::size_before_run_, 20);
+}
+
+} // namespace caffe2
@@ -596,6 +596,97 @@ TEST(NetTest, ChainingForHogwildModel) {
   checkNumChainsAndRun(spec, 2);
 }
 
+TEST(NetTest, ChainPriorities) {
+  const auto spec = R"DOC(
+        name: "example"
+        type: "async_scheduling"
+        external_input: "in"
+        op {
+          input: "in"
+          output: "hidden"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "hidden"
+          output: "out1"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "out1"
+          output: "out2"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "hidden"
+          output: "hidden"
+          type: "Allreduce"
+        }
+)DOC";
+  auto net_def = std::make_shared<NetDef>();
+  CAFFE_ENFORCE(
+      google::protobuf::TextFormat::ParseFromString(spec, net_def.get()));
+
+  std::vector<std::vector<int>> chains{{0}, {1}, {2}, {3}};
+  std::vector<dag_utils::OpGraphNode> chain_nodes(4);
+  chain_nodes[0].children_ = {1, 3};
+  chain_nodes[1].parents_ = {0};
+  chain_nodes[1].children_ = {2};
+  chain_nodes[2].parents_ = {1};
+  chain_nodes[3].parents_ = {0};
+
+  // The communication op is started before the compute ops.
+  auto priorities =
+      dag_utils::computeChainPriorities(net_def, chains, chain_nodes);
+  EXPECT_GT(priorities[3], priorities[1]);
+  // Compute ops are ordered by the critical path.
+  EXPECT_GT(priorities[0], priorities[1]);
+  EXPECT_GT(priorities[1], priorities[2]);
+
+  // An explicit priority beats the inferred ones.
+  net_def->mutable_op(1)->set_priority(1);
+  priorities = dag_utils::computeChainPriorities(net_def, chains, chain_nodes);
+  EXPECT_GT(priorities[1], priorities[3]);
+}
+
+TEST(NetTest, ChainStreams) {
+  // 0 -> {1, 2, 3} -> 4, with 3 on the CPU
+  std::vector<dag_utils::OpGraphNode> chain_nodes(5);
+  chain_nodes[0].children_ = {1, 2, 3};
+  chain_nodes[1].parents_ = {0};
+  chain_nodes[1].children_ = {4};
+  chain_nodes[2].parents_ = {0};
+  chain_nodes[2].children_ = {4};
+  chain_nodes[3].parents_ = {0};
+  chain_nodes[3].children_ = {4};
+  chain_nodes[4].parents_ = {1, 2, 3};
+  std::vector<int> devices{0, 0, 0, -1, 0};
+
+  // Branches run on distinct streams, the first one and the join continue
+  // the stream of their parent.
+  auto streams = dag_utils::computeChainStreams(chain_nodes, devices, 4);
+  EXPECT_EQ(streams, (std::vector<int>{0, 0, 1, 0, 0}));
+
+  // 0 -> {1, 2} -> 3 -> {4, 5} with two streams: 5 takes the stream of 2,
+  // which is done by then, rather than the one of its sibling.
+  chain_nodes = std::vector<dag_utils::OpGraphNode>(6);
+  chain_nodes[0].children_ = {1, 2};
+  chain_nodes[1].parents_ = {0};
+  chain_nodes[1].children_ = {3};
+  chain_nodes[2].parents_ = {0};
+  chain_nodes[2].children_ = {3};
+  chain_nodes[3].parents_ = {1, 2};
+  chain_nodes[3].children_ = {4, 5};
+  chain_nodes[4].parents_ = {3};
+  chain_nodes[5].parents_ = {3};
+  devices = std::vector<int>(6, 0);
+  streams = dag_utils::computeChainStreams(chain_nodes, devices, 2);
+  EXPECT_EQ(streams, (std::vector<int>{0, 0, 1, 0, 0, 1}));
+
+  // With a single stream everything is serialized on it.
+  streams = dag_utils::computeChainStreams(chain_nodes, devices, 1);
+  EXPECT_EQ(streams, std::vector<int>(6, 0));
+}
+
 TEST(NetTest, FailingOperator) {
   const auto spec = R"DOC(
         name: "example"
@@ -0,0 +1,154 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/numa.h"
+
+#include "caffe2/core/logging.h"
+
+#ifdef CAFFE2_USE_NUMA
+#include <numa.h>
+#include <numaif.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+CAFFE2_DEFINE_bool(
+    caffe2_cpu_numa_enabled,
+    false,
+    "Use NUMA whenever possible: CPU async net pools are pinned to the "
+    "numa_node_id of their device option, and CPU allocations are moved to "
+    "the node of the allocating thread.");
+
+namespace caffe2 {
+
+#ifdef CAFFE2_USE_NUMA
+
+bool IsNUMAEnabled() {
+  return FLAGS_caffe2_cpu_numa_enabled && numa_available() >= 0;
+}
+
+void NUMABind(int numa_node_id) {
+  if (numa_node_id < 0 || !IsNUMAEnabled()) {
+    return;
+  }
+  CAFFE_ENFORCE(
+      numa_node_id <= numa_max_node(),
+      "NUMA node id ",
+      numa_node_id,
+      " is out of range, the host has ",
+      numa_max_node() + 1,
+      " nodes.");
+  struct bitmask* mask = numa_allocate_nodemask();
+  numa_bitmask_setbit(mask, numa_node_id);
+  numa_bind(mask);
+  numa_bitmask_free(mask);
+}
+
+int GetNUMANode(const void* ptr) {
+  if (!IsNUMAEnabled()) {
+    return -1;
+  }
+  CAFFE_ENFORCE(ptr);
+  int numa_node = -1;
+  CAFFE_ENFORCE_EQ(
+      get_mempolicy(
+          &numa_node,
+          nullptr,
+          0,
+          const_cast<void*>(ptr),
+          MPOL_F_NODE | MPOL_F_ADDR),
+      0,
+      "Unable to get the memory policy, errno: ",
+      errno);
+  return numa_node;
+}
+
+int GetNumNUMANodes() {
+  if (!IsNUMAEnabled()) {
+    return 1;
+  }
+  return numa_num_configured_nodes();
+}
+
+void NUMAMove(void* ptr, size_t size, int numa_node_id) {
+  if (numa_node_id < 0 || !IsNUMAEnabled()) {
+    return;
+  }
+  CAFFE_ENFORCE(ptr);
+  // mbind works on whole pages: skip the partial pages at both ends, which
+  // may be shared with other allocations.
+  const size_t page_size = getpagesize();
+  const size_t begin = reinterpret_cast<size_t>(ptr);
+  const size_t first_page = (begin + page_size - 1) / page_size * page_size;
+  const size_t end_page = (begin + size) / page_size * page_size;
+  if (first_page >= end_page) {
+    return;
+  }
+  unsigned long mask = 1UL << numa_node_id;
+  CAFFE_ENFORCE_EQ(
+      mbind(
+          reinterpret_cast<void*>(first_page),
+          end_page - first_page,
+          MPOL_BIND,
+          &mask,
+          sizeof(mask) * 8,
+          MPOL_MF_MOVE | MPOL_MF_STRICT),
+      0,
+      "Could not move memory to a NUMA node, errno: ",
+      errno);
+}
+
+int GetCurrentNUMANode() {
+  if (!IsNUMAEnabled()) {
+    return -1;
+  }
+  const int cpu = sched_getcpu();
+  return cpu < 0 ? -1 : numa_node_of_cpu(cpu);
+}
+
+#else // CAFFE2_USE_NUMA
+
+bool IsNUMAEnabled() {
+  return false;
+}
+
+void NUMABind(int numa_node_id) {
+  if (numa_node_id >= 0) {
+    VLOG(1) << "NUMA is not enabled";
+  }
+}
+
+int GetNUMANode(const void* /* unused */) {
+  return -1;
+}
+
+int GetNumNUMANodes() {
+  return 1;
+}
+
+void NUMAMove(void* /* unused */, size_t /* unused */, int numa_node_id) {
+  if (numa_node_id >= 0) {
+    VLOG(1) << "NUMA is not enabled";
+  }
+}
+
+int GetCurrentNUMANode() {
+  return -1;
+}
+
+#endif // CAFFE2_USE_NUMA
+
+} // namespace caffe2
@@ -0,0 +1,53 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_CORE_NUMA_H_
+#define CAFFE2_CORE_NUMA_H_
+
+#include <cstddef>
+
+#include "caffe2/core/flags.h"
+#include "caffe2/core/macros.h"
+
+CAFFE2_DECLARE_bool(caffe2_cpu_numa_enabled);
+
+namespace caffe2 {
+
+// Whether NUMA is supported in this build and on this host, and
+// caffe2_cpu_numa_enabled is set. All the functions below are no-ops
+// otherwise.
+bool IsNUMAEnabled();
+
+// Binds the calling thread, and the memory it allocates from then on, to the
+// given node. -1 does nothing.
+void NUMABind(int numa_node_id);
+
+// Returns the node the page holding ptr lives on, -1 if unknown.
+int GetNUMANode(const void* ptr);
+
+// Returns the number of nodes, 1 without NUMA.
+int GetNumNUMANodes();
+
+// Moves the pages of [ptr, ptr + size) to the given node. The pages are only
+// moved if they are entirely inside the range. -1 does nothing.
+void NUMAMove(void* ptr, size_t size, int numa_node_id);
+
+// Returns the node of the CPU the calling thread runs on, -1 if unknown.
+int GetCurrentNUMANode();
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_NUMA_H_
@@ -16,8 +16,12 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <unordered_set>
+#include <vector>
 #include "caffe2/core/logging.h"
 
 namespace caffe2 {
@@ -55,6 +59,12 @@ class ObserverBase {
 
 /**
  *  Inherit to make your class observable.
+ *
+ *  Each observer is attached with a sampling rate: an observer attached with
+ *  rate N is started and stopped on one run out of N, the first one being the
+ *  run following the attach. The subject counts its runs and only walks its
+ *  observers on runs where at least one of them is sampled, so runs without
+ *  any sampled observer make no virtual calls.
  */
 template <class T>
 class Observable {
@@ -63,8 +73,11 @@ class Observable {
   using Observer = ObserverBase<T>;
 
   /* Returns a reference to the observer after addition. */
-  const Observer* AttachObserver(std::unique_ptr<Observer> observer) {
+  const Observer* AttachObserver(
+      std::unique_ptr<Observer> observer,
+      int sampling_rate = 1) {
     CAFFE_ENFORCE(observer, "Couldn't attach a null observer.");
+    CAFFE_ENFORCE_GE(sampling_rate, 1, "Sampling rate must be positive.");
     std::unordered_set<const Observer*> observers;
     for (auto& ob : observers_list_) {
       observers.insert(ob.get());
@@ -75,6 +88,8 @@ class Observable {
       return observer_ptr;
     }
     observers_list_.push_back(std::move(observer));
+    observers_sampling_.push_back(Sampling{sampling_rate, num_runs_, false});
+    next_sampled_run_ = std::min(next_sampled_run_, num_runs_);
 
     return observer_ptr;
   }
@@ -84,10 +99,12 @@ class Observable {
    * nullptr
    */
   std::unique_ptr<Observer> DetachObserver(const Observer* observer_ptr) {
-    for (auto it = observers_list_.begin(); it != observers_list_.end(); ++it) {
-      if (it->get() == observer_ptr) {
-        auto res = std::move(*it);
-        observers_list_.erase(it);
+    for (size_t i = 0; i < observers_list_.size(); ++i) {
+      if (observers_list_[i].get() == observer_ptr) {
+        auto res = std::move(observers_list_[i]);
+        observers_list_.erase(observers_list_.begin() + i);
+        observers_sampling_.erase(observers_sampling_.begin() + i);
+        UpdateNextSampledRun();
         return res;
       }
     }
@@ -99,19 +116,64 @@ class Observable {
   }
 
   void StartAllObservers() {
-    for (auto& observer : observers_list_) {
-      observer->Start();
+    const uint64_t run = num_runs_++;
+    sampled_run_ = run >= next_sampled_run_;
+    if (sampled_run_) {
+      StartSampledObservers(run);
     }
   }
 
   void StopAllObservers() {
-    for (auto& observer : observers_list_) {
-      observer->Stop();
+    if (!sampled_run_) {
+      return;
+    }
+    sampled_run_ = false;
+    // Observers attached while running are not stopped before being started.
+    for (size_t i = 0; i < observers_list_.size(); ++i) {
+      if (observers_sampling_[i].started) {
+        observers_sampling_[i].started = false;
+        observers_list_[i]->Stop();
+      }
     }
   }
 
  protected:
   std::vector<std::unique_ptr<Observer>> observers_list_;
+
+ private:
+  struct Sampling {
+    int rate;
+    uint64_t next_run;
+    bool started;
+  };
+
+  void StartSampledObservers(uint64_t run) {
+    // Observers may attach new observers to the subject when started, those
+    // are first sampled on the next run.
+    const size_t num_observers = observers_list_.size();
+    for (size_t i = 0; i < num_observers; ++i) {
+      auto& sampling = observers_sampling_[i];
+      sampling.started = sampling.next_run <= run;
+      if (sampling.started) {
+        sampling.next_run = run + sampling.rate;
+        observers_list_[i]->Start();
+      }
+    }
+    UpdateNextSampledRun();
+  }
+
+  void UpdateNextSampledRun() {
+    next_sampled_run_ = std::numeric_limits<uint64_t>::max();
+    for (const auto& sampling : observers_sampling_) {
+      next_sampled_run_ = std::min(next_sampled_run_, sampling.next_run);
+    }
+  }
+
+  // Parallel to observers_list_.
+  std::vector<Sampling> observers_sampling_;
+  uint64_t num_runs_ = 0;
+  uint64_t next_sampled_run_ = std::numeric_limits<uint64_t>::max();
+  bool sampled_run_ = false;
 };
 
 } // namespace caffe2
@@ -65,6 +65,21 @@ void DummyObserver<OperatorBase>::Stop() {
   counter.fetch_add(1);
 }
 
+class CountingNetObserver final : public ObserverBase<NetBase> {
+ public:
+  explicit CountingNetObserver(NetBase* subject_)
+      : ObserverBase<NetBase>(subject_) {}
+  void Start() override {
+    ++starts;
+  }
+  void Stop() override {
+    ++stops;
+  }
+
+  int starts = 0;
+  int stops = 0;
+};
+
 class ObsTestDummyOp final : public OperatorBase {
  public:
   using OperatorBase::OperatorBase;
@@ -194,4 +209,33 @@ TEST(ObserverTest, TestMultipleNetBase) {
 
   EXPECT_EQ(net.get()->NumObservers(), prev_num);
 }
+
+TEST(ObserverTest, TestSampledObservers) {
+  Workspace ws;
+  ws.CreateBlob("in");
+  unique_ptr<NetBase> net(CreateNetTestHelper(&ws));
+  auto* every_run = static_cast<const CountingNetObserver*>(
+      net->AttachObserver(make_unique<CountingNetObserver>(net.get())));
+  auto* one_in_three = static_cast<const CountingNetObserver*>(
+      net->AttachObserver(make_unique<CountingNetObserver>(net.get()), 3));
+  for (int i = 0; i < 10; ++i) {
+    net->Run();
+  }
+  EXPECT_EQ(every_run->starts, 10);
+  EXPECT_EQ(every_run->stops, 10);
+  // Sampled on runs 0, 3, 6 and 9.
+  EXPECT_EQ(one_in_three->starts, 4);
+  EXPECT_EQ(one_in_three->stops, 4);
+
+  // Without a sampled observer left, runs don't reach the observers.
+  auto detached = net->DetachObserver(every_run);
+  EXPECT_EQ(detached.get(), every_run);
+  for (int i = 0; i < 2; ++i) {
+    net->Run();
+  }
+  EXPECT_EQ(one_in_three->starts, 4);
+  net->Run();
+  EXPECT_EQ(one_in_three->starts, 5);
+  EXPECT_EQ(one_in_three->stops, 5);
+}
 } // namespace caffe2
@@ -87,16 +87,21 @@ GlobalEnginePrefType& g_global_engine_pref() {
   return *g_global_engine_pref_;
 }
 
-unique_ptr<OperatorBase> TryCreateOperator(
-    const string& key, const OperatorDef& operator_def, Workspace* ws) {
-  auto type = operator_def.device_option().device_type();
+OperatorRegistry* DeviceOperatorRegistry(int type) {
+  auto* registries = gDeviceTypeRegistry();
+  auto it = registries->find(type);
   CAFFE_ENFORCE(
-      gDeviceTypeRegistry()->count(type),
-      "Device type ",
-      type,
-      " not registered.");
-  OperatorRegistry* registry = gDeviceTypeRegistry()->at(type);
-  VLOG(1) << "Creating operator with device type " << type;
+      it != registries->end(), "Device type ", type, " not registered.");
+  return it->second;
+}
+
+unique_ptr<OperatorBase> TryCreateOperator(
+    OperatorRegistry* registry,
+    const string& key,
+    const OperatorDef& operator_def,
+    Workspace* ws) {
+  VLOG(1) << "Creating operator with device type "
+          << operator_def.device_option().device_type();
   try {
     return registry->Create(key, operator_def, ws);
   } catch (const UnsupportedOperatorFeature& err) {
@@ -112,8 +117,9 @@ unique_ptr<OperatorBase> _CreateOperator(
     const OperatorDef& operator_def,
     Workspace* ws) {
   static StaticLinkingProtector g_protector;
-  const auto op_type = operator_def.type();
+  const auto& op_type = operator_def.type();
   const auto device_type = operator_def.device_option().device_type();
+  OperatorRegistry* registry = DeviceOperatorRegistry(device_type);
 
 #ifndef CAFFE2_NO_OPERATOR_SCHEMA
   // first, check with OpSchema if the operator is legal.
@@ -138,27 +144,31 @@ unique_ptr<OperatorBase> _CreateOperator(
     const auto op_def_engines = split(',', operator_def.engine());
     engines.insert(engines.end(), op_def_engines.begin(), op_def_engines.end());
   }
-  if (!FLAGS_caffe2_disable_implicit_engine_preference &&
-      g_per_op_engine_pref().count(device_type) &&
-      g_per_op_engine_pref()[device_type].count(op_type)) {
-    const auto& preferred_engines =
-        g_per_op_engine_pref()[device_type][op_type];
-    VLOG(2) << "Inserting per-op engine preference: " << preferred_engines;
-    engines.insert(
-        engines.end(), preferred_engines.begin(), preferred_engines.end());
-  }
-  if (!FLAGS_caffe2_disable_implicit_engine_preference &&
-      g_global_engine_pref().count(device_type)) {
-    const auto& preferred_engines = g_global_engine_pref()[device_type];
-    VLOG(2) << "Inserting global engine preference: " << preferred_engines;
-    engines.insert(
-        engines.end(), preferred_engines.begin(), preferred_engines.end());
+  if (!FLAGS_caffe2_disable_implicit_engine_preference) {
+    const auto& per_op_pref = g_per_op_engine_pref();
+    auto device_pref = per_op_pref.find(device_type);
+    if (device_pref != per_op_pref.end()) {
+      auto op_pref = device_pref->second.find(op_type);
+      if (op_pref != device_pref->second.end()) {
+        VLOG(2) << "Inserting per-op engine preference: " << op_pref->second;
+        engines.insert(
+            engines.end(), op_pref->second.begin(), op_pref->second.end());
+      }
+    }
+    const auto& global_pref = g_global_engine_pref();
+    auto global_device_pref = global_pref.find(device_type);
+    if (global_device_pref != global_pref.end()) {
+      const auto& preferred_engines = global_device_pref->second;
+      VLOG(2) << "Inserting global engine preference: " << preferred_engines;
+      engines.insert(
+          engines.end(), preferred_engines.begin(), preferred_engines.end());
+    }
   }
   for (const auto& engine : engines) {
     const std::string key = OpRegistryKey(op_type, engine);
     VLOG(1) << "Trying to create operator " << op_type << " with engine "
             << engine;
-    auto op = TryCreateOperator(key, operator_def, ws);
+    auto op = TryCreateOperator(registry, key, operator_def, ws);
     if (op) {
       if (engine.size() <= FLAGS_caffe2_operator_max_engine_name_length) {
         op->annotate_engine(engine);
@@ -176,7 +186,7 @@ unique_ptr<OperatorBase> _CreateOperator(
   VLOG(1) << "Using default implementation.";
 
   // Lastly, if the engine does not work here, try using the default engine.
-  auto op = TryCreateOperator(op_type, operator_def, ws);
+  auto op = TryCreateOperator(registry, op_type, operator_def, ws);
   CAFFE_ENFORCE(
       op,
       "Cannot create operator of type '",
@@ -558,6 +568,21 @@ TensorShapes InferBlobShapesAndTypesFromWorkspace(
   return InferBlobShapesAndTypes(blob_desc, nets);
 }
 
+TensorShapes InferBlobShapesAndTypesFromWorkspace(
+    Workspace* ws,
+    const vector<string>& blobs,
+    const vector<std::unique_ptr<NetDef>>& nets) {
+  CaffeMap<string, TensorShape> blob_desc;
+  // Populate shapes from the given blobs only
+  for (const auto& s : blobs) {
+    const Blob* b = ws->GetBlob(s);
+    if (b != nullptr) {
+      blob_desc[s] = GetTensorShapeOfBlob(b);
+    }
+  }
+  return InferBlobShapesAndTypes(blob_desc, nets);
+}
+
 TensorShapes InferBlobShapesAndTypesFromMap(
     const CaffeMap<std::string, std::vector<TIndex>>& blob_dimensions,
     const vector<std::unique_ptr<NetDef>>& nets) {
@@ -259,6 +259,15 @@ class OperatorBase : public Observable<OperatorBase> {
     return true;
   }
 
+  // Resizes output idx to shape and allocates it with the data type of shape
+  // ahead of the run, so the operator finds it ready. Returns false if the
+  // output blob holds something other than a tensor of the operator's device.
+  virtual bool PreallocateOutput(
+      int /* unused */,
+      const TensorShape& /* unused */) {
+    return false;
+  }
+
   const std::string& type() {
     CAFFE_ENFORCE(operator_def_.get() != nullptr);
     return operator_def_->type();
@@ -395,9 +404,20 @@ class Operator : public OperatorBase {
   }
 
   bool RunAsync(int stream_id = 0) final {
+    // Observers that were started are stopped on errors too, so that they
+    // are never started twice in a row.
+    bool observers_started = false;
     try {
+      StartAllObservers();
+      observers_started = true;
+
       context_.SwitchToDevice(stream_id);
       auto result = RunOnDevice();
+      // Observers see the host side of the operator only, the device part
+      // may still be running. They are stopped before the event is set so
+      // that they are done by the time the net sees the operator finish.
+      observers_started = false;
+      StopAllObservers();
       if (result) {
         if (HasAsyncPart()) {
           RecordEvent();
@@ -417,10 +437,16 @@ class Operator : public OperatorBase {
             "Error from operator: \n" + ProtoDebugString(debug_def()));
         AddRelatedBlobInfo(&err);
       }
+      if (observers_started) {
+        StopAllObservers();
+      }
       RecordEvent(err.what());
       this->RecordLastFailedOpNetPosition();
       throw;
     } catch (...) {
+      if (observers_started) {
+        StopAllObservers();
+      }
       RecordEvent(getErrorMsg().c_str());
       this->RecordLastFailedOpNetPosition();
       throw;
@@ -431,6 +457,17 @@ class Operator : public OperatorBase {
     return context_.IsStreamFree(device_option(), stream_id);
   }
 
+  bool PreallocateOutput(int idx, const TensorShape& shape) override {
+    Blob* blob = OutputBlob(idx);
+    if (blob->meta().id() != 0 && !blob->IsType<Tensor<Context>>()) {
+      return false;
+    }
+    auto* tensor = blob->GetMutable<Tensor<Context>>();
+    tensor->Resize(vector<TIndex>(shape.dims().begin(), shape.dims().end()));
+    tensor->raw_mutable_data(DataTypeToTypeMeta(shape.data_type()));
+    return true;
+  }
+
   virtual bool RunOnDevice() = 0;
 
   // Returns whether operator has async on device part.
@@ -839,6 +876,13 @@ TensorShapes InferBlobShapesAndTypesFromWorkspace(
     Workspace* ws,
     const vector<std::unique_ptr<NetDef>>& nets);
 
+// Like above, but starts from the shapes of the given workspace blobs only,
+// so that stale shapes of other blobs are not taken for inferred ones.
+TensorShapes InferBlobShapesAndTypesFromWorkspace(
+    Workspace* ws,
+    const vector<string>& blobs,
+    const vector<std::unique_ptr<NetDef>>& nets);
+
 TensorShapes InferBlobShapesAndTypesFromMap(
     const CaffeMap<std::string, std::vector<TIndex>>& blob_dimensions,
     const vector<std::unique_ptr<NetDef>>& nets);
@@ -17,6 +17,7 @@
 #include "caffe2/core/operator_schema.h"
 
 #include "caffe2/core/logging.h"
+#include "caffe2/core/types.h"
 
 namespace caffe2 {
 
@@ -206,6 +207,11 @@ OpSchema& OpSchema::InputsCanCrossDevices() {
   return *this;
 }
 
+OpSchema& OpSchema::CommunicationOp() {
+  communication_op_ = true;
+  return *this;
+}
+
 OpSchema& OpSchema::TensorInferenceFunction(
     TensorInferenceFunctionType function) {
   tensor_inference_function_ = function;
@@ -358,6 +364,18 @@ std::ostream& operator<<(std::ostream& out, const OpSchema& schema) {
   return out;
 }
 
+uint64_t nBytesFromShape(const TensorShape& shape) {
+  switch (shape.data_type()) {
+    case TensorProto::UNDEFINED:
+      return 0;
+    case TensorProto::BYTE:
+      return nElemFromShape(shape);
+    default:
+      return nElemFromShape(shape) *
+          DataTypeToTypeMeta(shape.data_type()).itemsize();
+  }
+}
+
 CaffeMap<string, OpSchema>& OpSchemaRegistry::map() {
   static CaffeMap<string, OpSchema> map;
   return map;
@@ -184,8 +184,8 @@ class OpSchema {
    * an operator such as FLOPs and total memory use.
    */
   struct Cost {
-    uint64_t flops; // Floating point operations.
-    uint64_t bytes_moved; // Total memory used.
+    uint64_t flops{0}; // Floating point operations.
+    uint64_t bytes_moved{0}; // Total memory used.
   };
   /**
    * @brief Registers a function that takes in an OperatorDef
@@ -273,6 +273,10 @@ class OpSchema {
   // This op can pass data across devices
   OpSchema& InputsCanCrossDevices();
 
+  // This op is a collective or point-to-point communication op, the async
+  // nets run it on the communication stream of HIP devices
+  OpSchema& CommunicationOp();
+
   /**
    * @brief A function to allow one to get the number of outputs based on the
    * number of inputs, if this schema supports it.
@@ -307,6 +311,14 @@ class OpSchema {
     return num_inputs_outputs_allowed_(x, y);
   }
 
+  bool inplace_allowed(int in, int out) const {
+    return inplace_allowed_(in, out);
+  }
+
+  bool inplace_enforced(int in, int out) const {
+    return inplace_enforced_(in, out);
+  }
+
   int inf() const {
     return std::numeric_limits<int>::max();
   }
@@ -329,6 +341,9 @@ class OpSchema {
   bool inputs_can_cross_devices() const {
     return inputs_can_cross_devices_;
   }
+  bool communication_op() const {
+    return communication_op_;
+  }
 
   /**
    * @brief Returns the required device location of inputs and outputs.
@@ -360,6 +375,7 @@ class OpSchema {
   int max_output_ = std::numeric_limits<int>::max();
   bool private_ = false;
   bool inputs_can_cross_devices_ = false;
+  bool communication_op_ = false;
   std::function<bool(int)> num_inputs_allowed_ = [](int) { return true; };
   std::function<bool(int)> num_outputs_allowed_ = [](int) { return true; };
   std::function<bool(int, int)> num_inputs_outputs_allowed_ = [](int, int) {
@@ -463,6 +479,18 @@ inline vector<TIndex> GetDimsVector(const TensorShape& shape) {
   return dims;
 }
 
+// Helper functions for cost inference: the number of elements, and of bytes,
+// of a tensor of the given shape. The bytes are 0 for an undefined data type.
+inline uint64_t nElemFromShape(const TensorShape& shape) {
+  uint64_t size = 1;
+  for (const auto d : shape.dims()) {
+    size *= d;
+  }
+  return size;
+}
+
+uint64_t nBytesFromShape(const TensorShape& shape);
+
 // Helper function for infer op inputs and outputs device information.
 inline std::pair<std::vector<DeviceOption>, std::vector<DeviceOption>>
 InferOpInputOutputDevice(const OperatorDef& op) {
@@ -479,13 +507,12 @@ OpSchema::Cost PointwiseCostInference(
     const vector<TensorShape>& inputs) {
   struct OpSchema::Cost c;
   const TensorShape X = inputs[0];
-  uint64_t size = 1;
-
-  for (auto i = 0; i < X.dims().size(); ++i) {
-    size *= X.dims(i);
+  c.flops = nElemFromShape(X) * OpsPerPoint;
+  // The output is the size of the first input.
+  c.bytes_moved = nBytesFromShape(X);
+  for (const auto& input : inputs) {
+    c.bytes_moved += nBytesFromShape(input);
   }
-
-  c.flops = size * OpsPerPoint;
   return c;
 }
 
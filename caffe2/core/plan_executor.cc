@@ -17,6 +17,7 @@
 #include "caffe2/core/plan_executor.h"
 
 #include <condition_variable>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -32,6 +33,11 @@ CAFFE2_DEFINE_bool(
     false,
     "If used we will handle exceptions in executor threads. "
     "This avoids SIGABRT but may cause process to deadlock");
+CAFFE2_DEFINE_int(
+    caffe2_plan_executor_idle_threads,
+    32,
+    "Number of idle threads kept around to run the concurrent substeps of "
+    "later steps. Threads are only created when no idle one is available.");
 
 namespace caffe2 {
 
@@ -85,6 +91,77 @@ struct Reporter {
   bool done{false};
 };
 
+// Runs the workers of concurrent substeps. Concurrent substeps may depend on
+// each other to make progress (e.g. a producer and a consumer of a blocking
+// queue), so every task gets a thread right away: an idle one if there is
+// one, a new one otherwise. Up to caffe2_plan_executor_idle_threads threads
+// are kept once their task is done, so that steps run repeatedly don't pay
+// for thread creation every time.
+class PlanThreadCache {
+ public:
+  static PlanThreadCache& get() {
+    static PlanThreadCache cache;
+    return cache;
+  }
+
+  void run(std::function<void()> task) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+    if (idle_ >= tasks_.size()) {
+      cv_.notify_one();
+      return;
+    }
+    ++live_;
+    lock.unlock();
+    std::thread(&PlanThreadCache::workerLoop, this).detach();
+  }
+
+  ~PlanThreadCache() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    stop_ = true;
+    cv_.notify_all();
+    exited_.wait(lock, [this]() { return live_ == 0; });
+  }
+
+ private:
+  PlanThreadCache() {}
+
+  void workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      while (!tasks_.empty()) {
+        auto task = std::move(tasks_.front());
+        tasks_.pop_front();
+        lock.unlock();
+        // Exceptions are handled by the task: when one escapes, it is meant
+        // to terminate the process, as it would from a plain std::thread.
+        task();
+        lock.lock();
+      }
+      const size_t max_idle = FLAGS_caffe2_plan_executor_idle_threads;
+      if (stop_ || idle_ >= max_idle) {
+        break;
+      }
+      ++idle_;
+      cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+      --idle_;
+    }
+    if (--live_ == 0) {
+      exited_.notify_all();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::condition_variable exited_;
+  std::deque<std::function<void()>> tasks_;
+  size_t idle_{0};
+  size_t live_{0};
+  bool stop_{false};
+
+  DISABLE_COPY_AND_ASSIGN(PlanThreadCache);
+};
+
 // Returns a function that returns `true` if we should continue
 // iterating, given the current iteration count.
 std::function<bool(int64_t)> getContinuationTest(
@@ -448,16 +525,25 @@ bool ExecuteStepRecursive(ExecutionStepWrapper& stepWrapper) {
           }
         };
 
-        std::vector<std::thread> threads;
         auto numThreads = compiledStep->recurringSubsteps.size();
         if (step.has_num_concurrent_instances()) {
           numThreads *= step.num_concurrent_instances();
         }
+        std::mutex done_mutex;
+        std::condition_variable done_cv;
+        size_t num_running = numThreads;
         for (int64_t i = 0; i < numThreads; ++i) {
-          threads.emplace_back(worker);
+          PlanThreadCache::get().run([&]() {
+            worker();
+            std::lock_guard<std::mutex> guard(done_mutex);
+            if (--num_running == 0) {
+              done_cv.notify_all();
+            }
+          });
         }
-        for (auto& thread : threads) {
-          thread.join();
+        {
+          std::unique_lock<std::mutex> lock(done_mutex);
+          done_cv.wait(lock, [&]() { return num_running == 0; });
         }
         if (compiledStep->gotFailure) {
           LOG(ERROR) << "One of the workers failed.";
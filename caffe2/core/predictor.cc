@@ -18,6 +18,8 @@
 
 #include <unordered_set>
 
+#include "caffe2/core/memonger.h"
+
 namespace caffe2 {
 
 namespace {
@@ -31,10 +33,16 @@ void enforceIsTensor(Workspace* ws, const std::string& name) {
 
 void shareInputTensor(
     Workspace* ws,
+    const Workspace* weights,
     const std::string& name,
     TensorCPU* input) {
   enforceIsTensor(ws, name);
   auto* blob = ws->GetBlob(name);
+  CAFFE_ENFORCE(
+      !weights || !weights->HasBlob(name) || blob != weights->GetBlob(name),
+      "Input ",
+      name,
+      " is a shared weight, it has to be listed in the inputs of the model");
   CAFFE_ENFORCE(blob, "Blob: ", name, " does not exist");
   auto* tensor = blob->template GetMutable<TensorCPU>();
   tensor->ResizeLike(*input);
@@ -67,6 +75,15 @@ const ::google::protobuf::RepeatedPtrField<::std::string>& getBlobs(
   }
   CAFFE_THROW("Blob not found: ", name);
 }
+
+void copyOutputs(
+    const Predictor::TensorVector& outputs,
+    std::vector<TensorCPU>* copies) {
+  copies->resize(outputs.size());
+  for (auto i = 0; i < outputs.size(); ++i) {
+    (*copies)[i].CopyFrom(*outputs[i]);
+  }
+}
 } // namespace
 
 Predictor::Predictor(const MetaNetDef& def, Workspace* parent)
@@ -103,12 +120,37 @@ Predictor::Predictor(
   CAFFE_ENFORCE(ws_.CreateNet(run_net));
 }
 
+Predictor::Predictor(
+    const NetDef& run_net,
+    const Workspace* weights,
+    const std::unordered_set<std::string>& inputNames)
+    : run_net_(run_net),
+      ws_(weights),
+      inputNames_(inputNames),
+      weights_(weights) {
+  CAFFE_ENFORCE(weights_);
+  for (const auto& name : run_net.external_input()) {
+    if (inputNames_.count(name) || !weights_->HasBlob(name)) {
+      auto* blob = ws_.CreateLocalBlob(name);
+      blob->template GetMutable<TensorCPU>();
+    }
+  }
+  // Hide the shared blobs that run_net writes, operators keep pointers to
+  // their outputs so this has to be done before creating the net.
+  for (const auto& op : run_net.op()) {
+    for (const auto& name : op.output()) {
+      ws_.CreateLocalBlob(name);
+    }
+  }
+  CAFFE_ENFORCE(ws_.CreateNet(run_net));
+}
+
 Predictor::~Predictor() {}
 
 bool Predictor::run(const TensorVector& inputs, TensorVector* outputs) {
   CAFFE_ENFORCE(inputs.size() <= run_net_.external_input_size());
   for (auto i = 0; i < inputs.size(); ++i) {
-    shareInputTensor(&ws_, run_net_.external_input(i), inputs[i]);
+    shareInputTensor(&ws_, weights_, run_net_.external_input(i), inputs[i]);
   }
 
   if (!ws_.RunNet(run_net_.name())) {
@@ -130,7 +172,7 @@ bool Predictor::run_map(const TensorMap& inputs, TensorVector* outputs) {
     if (!inputNames_.empty()) {
       CAFFE_ENFORCE_GT(inputNames_.count(input.first), 0);
     }
-    shareInputTensor(&ws_, input.first, input.second);
+    shareInputTensor(&ws_, weights_, input.first, input.second);
   }
 
   if (!ws_.RunNet(run_net_.name())) {
@@ -143,4 +185,147 @@ bool Predictor::run_map(const TensorMap& inputs, TensorVector* outputs) {
   }
   return true;
 }
+
+bool Predictor::plan_memory(const TensorVector& inputs) {
+  if (run_net_.type() != "" && run_net_.type() != "simple") {
+    LOG(INFO) << "Cannot plan memory for nets of type: " << run_net_.type();
+    return false;
+  }
+  TensorVector outputs;
+  if (!run(inputs, &outputs)) {
+    return false;
+  }
+
+  // Candidates are the tensors written by run_net that own their data, or
+  // that we laid out ourselves last time. Inputs and weights are not, and
+  // neither are tensors whose data is also used by another blob.
+  std::unordered_set<std::string> externalInputs(
+      run_net_.external_input().begin(), run_net_.external_input().end());
+  std::unordered_map<const void*, int> users;
+  for (const auto& name : ws_.Blobs()) {
+    const auto* blob = ws_.GetBlob(name);
+    // Our own layout shares data between blobs on purpose
+    if (!plannedBlobs_.count(name) && blob->template IsType<TensorCPU>() &&
+        blob->template Get<TensorCPU>().size() > 0) {
+      ++users[blob->template Get<TensorCPU>().raw_data()];
+    }
+  }
+  std::unordered_map<std::string, size_t> blobBytes;
+  for (const auto& op : run_net_.op()) {
+    for (const auto& name : op.output()) {
+      if (externalInputs.count(name) || blobBytes.count(name) ||
+          (weights_ && weights_->HasBlob(name) &&
+           ws_.GetBlob(name) == weights_->GetBlob(name))) {
+        continue;
+      }
+      const auto* blob = ws_.GetBlob(name);
+      if (!blob->template IsType<TensorCPU>()) {
+        continue;
+      }
+      const auto& tensor = blob->template Get<TensorCPU>();
+      if (tensor.size() <= 0 || tensor.meta().ctor() ||
+          tensor.meta().dtor() || users[tensor.raw_data()] > 1 ||
+          (tensor.shares_data() && !plannedBlobs_.count(name))) {
+        continue;
+      }
+      blobBytes[name] = tensor.nbytes();
+    }
+  }
+
+  const auto plan = memonger::plan_static_memory(run_net_, blobBytes);
+  auto arena = CPUContext::New(plan.arena_bytes);
+  std::shared_ptr<void> newArena(arena.first, arena.second);
+  plannedBlobs_.clear();
+  for (const auto& offset : plan.offsets) {
+    auto* tensor = ws_.GetBlob(offset.first)->template GetMutable<TensorCPU>();
+    tensor->ShareExternalPointer(
+        static_cast<char*>(newArena.get()) + offset.second,
+        tensor->meta(),
+        blobBytes[offset.first]);
+    plannedBlobs_.insert(offset.first);
+  }
+  arena_ = std::move(newArena);
+  arenaBytes_ = plan.arena_bytes;
+  VLOG(1) << "Planned " << plannedBlobs_.size() << " activations of "
+          << run_net_.name() << " in " << arenaBytes_ << " bytes";
+  return true;
+}
+
+PredictorPool::PredictorPool(
+    const MetaNetDef& def,
+    size_t size,
+    Workspace* parent)
+    : weights_(parent) {
+  const auto& inputs =
+      getBlobs(def, PredictorConsts::default_instance().inputs_blob_type());
+  initialize(
+      getNet(def, PredictorConsts::default_instance().global_init_net_type()),
+      getNet(def, PredictorConsts::default_instance().predict_net_type()),
+      size,
+      std::unordered_set<std::string>(inputs.begin(), inputs.end()));
+}
+
+PredictorPool::PredictorPool(
+    const NetDef& init_net,
+    const NetDef& run_net,
+    size_t size,
+    Workspace* parent)
+    : weights_(parent) {
+  initialize(init_net, run_net, size, {});
+}
+
+void PredictorPool::initialize(
+    const NetDef& init_net,
+    const NetDef& run_net,
+    size_t size,
+    const std::unordered_set<std::string>& inputNames) {
+  CAFFE_ENFORCE_GT(size, 0);
+  CAFFE_ENFORCE(weights_.RunNetOnce(init_net));
+  predictors_.reserve(size);
+  free_.reserve(size);
+  for (auto i = 0; i < size; ++i) {
+    predictors_.emplace_back(new Predictor(run_net, &weights_, inputNames));
+    free_.push_back(predictors_.back().get());
+  }
+}
+
+PredictorPool::Handle PredictorPool::acquire() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return !free_.empty(); });
+  auto* predictor = free_.back();
+  free_.pop_back();
+  return Handle(this, predictor);
+}
+
+void PredictorPool::release(Predictor* predictor) {
+  {
+    std::lock_guard<std::mutex> g(mutex_);
+    free_.push_back(predictor);
+  }
+  cv_.notify_one();
+}
+
+bool PredictorPool::run(
+    const TensorVector& inputs,
+    std::vector<TensorCPU>* outputs) {
+  auto predictor = acquire();
+  TensorVector results;
+  if (!predictor->run(inputs, &results)) {
+    return false;
+  }
+  copyOutputs(results, outputs);
+  return true;
+}
+
+bool PredictorPool::run_map(
+    const TensorMap& inputs,
+    std::vector<TensorCPU>* outputs) {
+  auto predictor = acquire();
+  TensorVector results;
+  if (!predictor->run_map(inputs, &results)) {
+    return false;
+  }
+  copyOutputs(results, outputs);
+  return true;
+}
 } // namespace caffe2
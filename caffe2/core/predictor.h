@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <mutex>
 #include <unordered_set>
 #include "caffe2/core/net.h"
 #include "caffe2/core/tensor.h"
@@ -34,11 +36,23 @@ class Predictor {
   Predictor(const MetaNetDef& net, Workspace* parent = nullptr);
 
   // Runs the `init_net` once, then saves the `run_net` to be executed
-  // in `::run`
+  // in `::run`. For huge embedding tables, the `init_net` can map the
+  // weights written by SaveMapped with LoadMapped: the constructor then does
+  // not read them, and only the rows in use are paged in.
   Predictor(
       const NetDef& init_net,
       const NetDef& run_net,
       Workspace* parent = nullptr);
+
+  // Saves the `run_net` to be executed in `::run`, in a workspace that shares
+  // the blobs of `weights` (typically initialized by an `init_net`) without
+  // writing to them: the inputs in `inputNames`, the inputs missing from
+  // `weights` and all the blobs written by `run_net` are local. Several such
+  // Predictors can thus run concurrently on one copy of the weights.
+  Predictor(
+      const NetDef& run_net,
+      const Workspace* weights,
+      const std::unordered_set<std::string>& inputNames = {});
   ~Predictor();
 
   // Executes `run_net` on the inputs.
@@ -57,6 +71,18 @@ class Predictor {
   // Similar to run, but consumes a map of name to tensor as input
   bool run_map(const TensorMap& inputs, TensorVector* outputs);
 
+  // Runs `run_net` once on `inputs` and lays the activations it produced out
+  // in one preallocated arena (see memonger::plan_static_memory), so that
+  // later runs on inputs of the same shape do not allocate them. Activations
+  // that outgrow their range fall back to their own allocation. Only for
+  // simple nets; blobs sharing their data with others are left alone.
+  bool plan_memory(const TensorVector& inputs);
+
+  // Size of the arena of plan_memory(), 0 if memory is not planned
+  size_t arena_bytes() const {
+    return arenaBytes_;
+  }
+
   const NetDef& def() const {
     return run_net_;
   };
@@ -69,5 +95,96 @@ class Predictor {
   NetDef run_net_;
   Workspace ws_;
   std::unordered_set<std::string> inputNames_;
+  // The workspace shared read-only, if any
+  const Workspace* weights_{nullptr};
+  // Activations laid out by plan_memory()
+  std::shared_ptr<void> arena_;
+  size_t arenaBytes_{0};
+  std::unordered_set<std::string> plannedBlobs_;
+};
+
+// A pool of Predictors sharing one copy of the weights, for serving from
+// several threads. The `init_net` is run once in a weights workspace, and
+// every Predictor of the pool runs `run_net` in its own child workspace with
+// private activations (see the Predictor constructor taking a `weights`
+// workspace). A Predictor is used by one thread at a time.
+class PredictorPool {
+ public:
+  using TensorVector = Predictor::TensorVector;
+  using TensorMap = Predictor::TensorMap;
+
+  PredictorPool(
+      const MetaNetDef& net,
+      size_t size,
+      Workspace* parent = nullptr);
+
+  PredictorPool(
+      const NetDef& init_net,
+      const NetDef& run_net,
+      size_t size,
+      Workspace* parent = nullptr);
+
+  // Exclusive use of one Predictor of the pool, which goes back to the pool
+  // when the Handle is destroyed. The outputs of the Predictor stay valid
+  // until then.
+  class Handle {
+   public:
+    Handle(Handle&& other) noexcept
+        : pool_(other.pool_), predictor_(other.predictor_) {
+      other.predictor_ = nullptr;
+    }
+    Handle(const Handle&) = delete;
+    Handle& operator=(const Handle&) = delete;
+    ~Handle() {
+      if (predictor_) {
+        pool_->release(predictor_);
+      }
+    }
+
+    Predictor* operator->() const {
+      return predictor_;
+    }
+    Predictor& operator*() const {
+      return *predictor_;
+    }
+
+   private:
+    friend class PredictorPool;
+    Handle(PredictorPool* pool, Predictor* predictor)
+        : pool_(pool), predictor_(predictor) {}
+
+    PredictorPool* pool_;
+    Predictor* predictor_;
+  };
+
+  // Blocks until a Predictor is free
+  Handle acquire();
+
+  // Runs on a free Predictor like Predictor::run and Predictor::run_map, and
+  // copies the outputs out before giving the Predictor back.
+  bool run(const TensorVector& inputs, std::vector<TensorCPU>* outputs);
+  bool run_map(const TensorMap& inputs, std::vector<TensorCPU>* outputs);
+
+  size_t size() const {
+    return predictors_.size();
+  }
+
+  Workspace* weights() {
+    return &weights_;
+  }
+
+ private:
+  void initialize(
+      const NetDef& init_net,
+      const NetDef& run_net,
+      size_t size,
+      const std::unordered_set<std::string>& inputNames);
+  void release(Predictor* predictor);
+
+  Workspace weights_;
+  std::vector<std::unique_ptr<Predictor>> predictors_;
+  std::mutex mutex_; // protects free_
+  std::condition_variable cv_;
+  std::vector<Predictor*> free_;
 };
 }
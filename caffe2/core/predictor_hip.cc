@@ -0,0 +1,281 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/predictor_hip.h"
+
+#include "caffe2/core/common_hip.h"
+
+namespace caffe2 {
+
+AsyncPredictor::AsyncPredictor(const NetDef& init_net,
+                               const NetDef& run_net,
+                               int depth,
+                               Workspace* parent)
+    : run_net_(run_net), gpu_id_(run_net.device_option().hip_gpu_id()), weights_(parent)
+{
+    CAFFE_ENFORCE_GT(depth, 0);
+    CAFFE_ENFORCE_EQ(run_net.device_option().device_type(),
+                     HIP,
+                     "AsyncPredictor needs a run_net placed on a HIP GPU");
+    CAFFE_ENFORCE(weights_.RunNetOnce(init_net));
+
+    DeviceGuard guard(gpu_id_);
+    for(int i = 0; i < depth; ++i)
+    {
+        std::unique_ptr<Slot> slot(new Slot());
+        slot->ws.reset(new Workspace(static_cast<const Workspace*>(&weights_)));
+        for(const auto& name : run_net_.external_input())
+        {
+            if(!weights_.HasBlob(name))
+            {
+                slot->ws->CreateLocalBlob(name)->GetMutable<Tensor<HIPContext>>();
+            }
+        }
+        // Hide the weights that run_net writes, as Predictor does.
+        for(const auto& op : run_net_.op())
+        {
+            for(const auto& name : op.output())
+            {
+                slot->ws->CreateLocalBlob(name);
+            }
+        }
+        slot->net = slot->ws->CreateNet(run_net_);
+        CAFFE_ENFORCE(slot->net);
+        HIP_ENFORCE(hipEventCreateWithFlags(&slot->uploaded, hipEventDisableTiming));
+        HIP_ENFORCE(hipEventCreateWithFlags(&slot->computed, hipEventDisableTiming));
+        HIP_ENFORCE(hipEventCreateWithFlags(&slot->downloaded, hipEventDisableTiming));
+        free_.push_back(slot.get());
+        slots_.push_back(std::move(slot));
+    }
+    dispatcher_ = std::thread([this] { Dispatch(); });
+}
+
+AsyncPredictor::~AsyncPredictor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_one();
+    dispatcher_.join();
+    DeviceGuard guard(gpu_id_);
+    for(auto& slot : slots_)
+    {
+        hipEventDestroy(slot->uploaded);
+        hipEventDestroy(slot->computed);
+        hipEventDestroy(slot->downloaded);
+    }
+}
+
+std::future<bool> AsyncPredictor::run(const TensorVector& inputs,
+                                      std::vector<TensorCPU>* outputs)
+{
+    CAFFE_ENFORCE_LE(inputs.size(), run_net_.external_input_size());
+    CAFFE_ENFORCE(outputs);
+    Request request;
+    request.inputs  = inputs;
+    request.outputs = outputs;
+    auto future     = request.promise.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        CAFFE_ENFORCE(!stop_);
+        requests_.push_back(std::move(request));
+    }
+    cv_.notify_one();
+    return future;
+}
+
+bool AsyncPredictor::HasRequests()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !requests_.empty();
+}
+
+// Every iteration uploads a new request, computes the oldest uploaded one and
+// hands out the finished downloads, so that the copies queued on the upload
+// and download streams run while the host waits for the compute.
+void AsyncPredictor::Dispatch()
+{
+    DeviceGuard guard(gpu_id_);
+    // The streams of HIPContext are thread local: the ops of the nets run on
+    // stream 0 of this thread, and the copies on two others.
+    upload_stream_   = HIPContext::hip_stream(gpu_id_, 1);
+    download_stream_ = HIPContext::hip_stream(gpu_id_, 2);
+    while(true)
+    {
+        if(!free_.empty())
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if(uploaded_.empty() && downloading_.empty())
+            {
+                cv_.wait(lock, [this] { return stop_ || !requests_.empty(); });
+            }
+            if(!requests_.empty())
+            {
+                Slot* slot = free_.back();
+                free_.pop_back();
+                slot->request = std::move(requests_.front());
+                requests_.pop_front();
+                lock.unlock();
+                Upload(slot);
+            }
+            else if(stop_ && uploaded_.empty() && downloading_.empty())
+            {
+                return;
+            }
+        }
+
+        if(!uploaded_.empty())
+        {
+            Slot* slot = uploaded_.front();
+            uploaded_.pop_front();
+            Compute(slot);
+        }
+
+        while(!downloading_.empty())
+        {
+            Slot* slot = downloading_.front();
+            try
+            {
+                const hipError_t status = hipEventQuery(slot->downloaded);
+                if(status == hipErrorNotReady)
+                {
+                    // Only wait for the download when there is nothing else
+                    // to queue.
+                    if(!uploaded_.empty() || (!free_.empty() && HasRequests()))
+                    {
+                        break;
+                    }
+                    HIP_ENFORCE(hipEventSynchronize(slot->downloaded));
+                }
+                else
+                {
+                    HIP_ENFORCE(status);
+                }
+            }
+            catch(...)
+            {
+                downloading_.pop_front();
+                Fail(slot, std::current_exception());
+                continue;
+            }
+            downloading_.pop_front();
+            Finish(slot, true);
+        }
+    }
+}
+
+void AsyncPredictor::Upload(Slot* slot)
+{
+    try
+    {
+        const auto& inputs = slot->request.inputs;
+        for(int i = 0; i < inputs.size(); ++i)
+        {
+            const auto& name = run_net_.external_input(i);
+            auto* blob       = slot->ws->GetBlob(name);
+            CAFFE_ENFORCE(blob, "Blob: ", name, " does not exist");
+            CAFFE_ENFORCE(!weights_.HasBlob(name) || blob != weights_.GetBlob(name),
+                          "Input ",
+                          name,
+                          " is a shared weight, it cannot be fed");
+            auto* tensor = blob->GetMutable<Tensor<HIPContext>>();
+            tensor->ResizeLike(*inputs[i]);
+            void* data = tensor->raw_mutable_data(inputs[i]->meta());
+            if(inputs[i]->size() > 0)
+            {
+                HIP_ENFORCE(hipMemcpyAsync(data,
+                                           inputs[i]->raw_data(),
+                                           inputs[i]->nbytes(),
+                                           hipMemcpyHostToDevice,
+                                           upload_stream_));
+            }
+        }
+        HIP_ENFORCE(hipEventRecord(slot->uploaded, upload_stream_));
+        uploaded_.push_back(slot);
+    }
+    catch(...)
+    {
+        Fail(slot, std::current_exception());
+    }
+}
+
+void AsyncPredictor::Compute(Slot* slot)
+{
+    try
+    {
+        const hipStream_t compute_stream = HIPContext::hip_stream(gpu_id_, 0);
+        HIP_ENFORCE(hipStreamWaitEvent(compute_stream, slot->uploaded, 0));
+        if(!slot->net->Run())
+        {
+            HIP_ENFORCE(hipStreamSynchronize(upload_stream_));
+            Finish(slot, false);
+            return;
+        }
+        HIP_ENFORCE(hipEventRecord(slot->computed, compute_stream));
+        HIP_ENFORCE(hipStreamWaitEvent(download_stream_, slot->computed, 0));
+
+        auto& outputs = *slot->request.outputs;
+        outputs.resize(run_net_.external_output_size());
+        for(int i = 0; i < outputs.size(); ++i)
+        {
+            const auto& name = run_net_.external_output(i);
+            const auto* blob = slot->ws->GetBlob(name);
+            CAFFE_ENFORCE(blob, "Blob: ", name, " does not exist");
+            if(blob->IsType<TensorCPU>())
+            {
+                outputs[i].CopyFrom(blob->Get<TensorCPU>());
+                continue;
+            }
+            const auto& tensor = blob->Get<Tensor<HIPContext>>();
+            outputs[i].ResizeLike(tensor);
+            void* data = outputs[i].raw_mutable_data(tensor.meta());
+            if(tensor.size() > 0)
+            {
+                HIP_ENFORCE(hipMemcpyAsync(data,
+                                           tensor.raw_data(),
+                                           tensor.nbytes(),
+                                           hipMemcpyDeviceToHost,
+                                           download_stream_));
+            }
+        }
+        HIP_ENFORCE(hipEventRecord(slot->downloaded, download_stream_));
+        downloading_.push_back(slot);
+    }
+    catch(...)
+    {
+        Fail(slot, std::current_exception());
+    }
+}
+
+void AsyncPredictor::Finish(Slot* slot, bool success)
+{
+    slot->request.promise.set_value(success);
+    slot->request = Request();
+    free_.push_back(slot);
+}
+
+// The slot can be reused once nothing is copied from or into it anymore.
+void AsyncPredictor::Fail(Slot* slot, std::exception_ptr error)
+{
+    hipStreamSynchronize(upload_stream_);
+    hipStreamSynchronize(download_stream_);
+    slot->request.promise.set_exception(error);
+    slot->request = Request();
+    free_.push_back(slot);
+}
+
+} // namespace caffe2
@@ -0,0 +1,105 @@
+#ifndef CAFFE2_CORE_PREDICTOR_HIP_H_
+#define CAFFE2_CORE_PREDICTOR_HIP_H_
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/predictor.h"
+
+namespace caffe2 {
+
+/**
+ * Serves a `run_net` placed on one HIP GPU from a single host thread, with
+ * the stages of consecutive requests overlapping: while request k-1 computes
+ * on the compute stream, the inputs of request k are uploaded on an upload
+ * stream and the outputs of request k-2 downloaded on a download stream.
+ *
+ * Every request in flight has a slot with its own workspace, which shares the
+ * weights set up by the `init_net` as the Predictors of a PredictorPool do.
+ * `depth` is the number of slots, three are enough for the three stages to
+ * overlap.
+ *
+ * The inputs are CPU tensors which should be pinned (as TensorCPU is by
+ * default when a GPU is present) for the copies to be asynchronous. They are
+ * fed to the first external inputs of `run_net` as device tensors, and the
+ * external outputs, device or CPU tensors, are copied to `outputs`.
+ */
+class AsyncPredictor
+{
+    public:
+    using TensorVector = Predictor::TensorVector;
+
+    AsyncPredictor(const NetDef& init_net,
+                   const NetDef& run_net,
+                   int depth         = 3,
+                   Workspace* parent = nullptr);
+    // Waits for the requests in flight.
+    ~AsyncPredictor();
+
+    // Queues a request and returns right away. The future is true once the
+    // outputs are in `outputs`, or false if run_net failed; it holds the
+    // exception if the request could not be run. `inputs` and `outputs` have
+    // to stay alive and untouched until then. Reusing the same `outputs` for
+    // later requests saves allocating their pinned memory again.
+    std::future<bool> run(const TensorVector& inputs, std::vector<TensorCPU>* outputs);
+
+    Workspace* weights() { return &weights_; }
+
+    private:
+    struct Request
+    {
+        TensorVector inputs;
+        std::vector<TensorCPU>* outputs;
+        std::promise<bool> promise;
+    };
+
+    struct Slot
+    {
+        std::unique_ptr<Workspace> ws;
+        NetBase* net;
+        Request request;
+        hipEvent_t uploaded;
+        hipEvent_t computed;
+        hipEvent_t downloaded;
+    };
+
+    void Dispatch();
+    void Upload(Slot* slot);
+    void Compute(Slot* slot);
+    // Hands the result of the request of slot out and frees slot.
+    void Finish(Slot* slot, bool success);
+    void Fail(Slot* slot, std::exception_ptr error);
+    bool HasRequests();
+
+    NetDef run_net_;
+    int gpu_id_;
+    Workspace weights_;
+    std::vector<std::unique_ptr<Slot>> slots_;
+
+    std::mutex mutex_; // protects requests_ and stop_
+    std::condition_variable cv_;
+    std::deque<Request> requests_;
+    bool stop_ = false;
+
+    // Only used by the dispatcher thread.
+    std::vector<Slot*> free_;
+    std::deque<Slot*> uploaded_;
+    std::deque<Slot*> downloading_;
+    hipStream_t upload_stream_;
+    hipStream_t download_stream_;
+
+    std::thread dispatcher_;
+
+    DISABLE_COPY_AND_ASSIGN(AsyncPredictor);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_PREDICTOR_HIP_H_
@@ -0,0 +1,101 @@
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/predictor_hip.h"
+
+namespace caffe2 {
+
+namespace {
+
+const char* initSpec = R"DOC(
+    name: "init"
+    op {
+        output: "bias"
+        type: "ConstantFill"
+        arg { name: "shape" ints: 4 }
+        arg { name: "value" f: 1.0 }
+    }
+    device_option { device_type: 4 hip_gpu_id: 0 }
+)DOC";
+
+const char* runSpec = R"DOC(
+    name: "run"
+    external_input: "data"
+    external_input: "bias"
+    external_output: "out"
+    op {
+        input: "data"
+        output: "scaled"
+        type: "Scale"
+        arg { name: "scale" f: 2.0 }
+    }
+    op {
+        input: "scaled"
+        input: "bias"
+        output: "out"
+        type: "Add"
+        arg { name: "broadcast" i: 1 }
+    }
+    device_option { device_type: 4 hip_gpu_id: 0 }
+)DOC";
+
+NetDef parseNetDef(const char* spec)
+{
+    NetDef net;
+    CAFFE_ENFORCE(google::protobuf::TextFormat::ParseFromString(spec, &net));
+    return net;
+}
+
+} // namespace
+
+TEST(AsyncPredictorTest, PipelinesRequests)
+{
+    if(!HasHipGPU())
+        return;
+    AsyncPredictor predictor(parseNetDef(initSpec), parseNetDef(runSpec));
+
+    // More requests than slots, so that the slots get reused.
+    const int kRequests = 8;
+    std::vector<TensorCPU> inputs(kRequests);
+    std::vector<std::vector<TensorCPU>> outputs(kRequests);
+    std::vector<std::future<bool>> results;
+    for(int i = 0; i < kRequests; ++i)
+    {
+        inputs[i].Resize(i + 1, 4);
+        float* data = inputs[i].mutable_data<float>();
+        for(int j = 0; j < inputs[i].size(); ++j)
+        {
+            data[j] = i + j;
+        }
+        results.push_back(predictor.run({&inputs[i]}, &outputs[i]));
+    }
+    for(int i = 0; i < kRequests; ++i)
+    {
+        EXPECT_TRUE(results[i].get());
+        ASSERT_EQ(outputs[i].size(), 1);
+        const auto& out = outputs[i][0];
+        EXPECT_EQ(out.dims(), inputs[i].dims());
+        for(int j = 0; j < out.size(); ++j)
+        {
+            EXPECT_FLOAT_EQ(out.data<float>()[j], 2 * (i + j) + 1);
+        }
+    }
+}
+
+TEST(AsyncPredictorTest, RejectsSharedWeightsAsInputs)
+{
+    if(!HasHipGPU())
+        return;
+    auto runNet = parseNetDef(runSpec);
+    // bias is initialized by the init net, it cannot be fed.
+    runNet.mutable_external_input()->SwapElements(0, 1);
+    AsyncPredictor predictor(parseNetDef(initSpec), runNet);
+    TensorCPU bias(std::vector<TIndex>{4});
+    bias.mutable_data<float>();
+    std::vector<TensorCPU> outputs;
+    auto result = predictor.run({&bias}, &outputs);
+    EXPECT_THROW(result.get(), EnforceNotMet);
+}
+
+} // namespace caffe2
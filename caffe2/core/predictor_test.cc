@@ -22,6 +22,12 @@
 #include "caffe2/utils/math.h"
 
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
 
 namespace caffe2 {
 
@@ -43,6 +49,31 @@ const char* predictSpec = R"DOC(
         }
 )DOC";
 
+const char* simplePredictSpec = R"DOC(
+        name: "predict_simple"
+        external_input: "data"
+        external_input: "W"
+        external_input: "b"
+        external_output: "y"
+        op {
+          input: "data"
+          input: "W"
+          input: "b"
+          output: "fc"
+          type: "FC"
+        }
+        op {
+          input: "fc"
+          output: "relu"
+          type: "Relu"
+        }
+        op {
+          input: "relu"
+          output: "y"
+          type: "Relu"
+        }
+)DOC";
+
 const char* initSpec = R"DOC(
         name: "init"
         type: "dag"
@@ -239,4 +270,124 @@ TEST_F(PredictorMetaNetDefTest, SimpleMetaNetDefInitializer) {
   EXPECT_TRUE(output.front()->dim(1) == 10);
   EXPECT_NEAR(output.front()->data<float>()[4], 0.1209, 1E-4);
 }
+
+TEST(PredictorPoolTest, SharesWeights) {
+  PredictorPool pool(parseMetaNetDef(metaSpec), 2);
+  auto first = pool.acquire();
+  auto second = pool.acquire();
+  EXPECT_EQ(first->ws()->GetBlob("W"), pool.weights()->GetBlob("W"));
+  EXPECT_EQ(second->ws()->GetBlob("W"), pool.weights()->GetBlob("W"));
+  // Inputs and activations are private
+  EXPECT_NE(first->ws()->GetBlob("data"), second->ws()->GetBlob("data"));
+  EXPECT_NE(first->ws()->GetBlob("y"), second->ws()->GetBlob("y"));
+}
+
+TEST(PredictorPoolTest, ConcurrentRuns) {
+  DeviceOption op;
+  op.set_random_seed(1701);
+  CPUContext ctx(op);
+  PredictorPool pool(parseNetDef(initSpec), parseNetDef(predictSpec), 2);
+  auto inputData = randomTensor({1, 4}, &ctx);
+  Predictor::TensorVector input{inputData->template GetMutable<TensorCPU>()};
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&pool, &input]() {
+      for (int j = 0; j < 10; ++j) {
+        std::vector<TensorCPU> output;
+        EXPECT_TRUE(pool.run(input, &output));
+        EXPECT_EQ(output.size(), 1);
+        EXPECT_EQ(output.front().dim(0), 1);
+        EXPECT_EQ(output.front().dim(1), 10);
+        EXPECT_NEAR(output.front().data<float>()[4], 0.1209, 1E-4);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+#ifndef _WIN32
+TEST(PredictorMappedWeightsTest, MatchesLoadedWeights) {
+  const std::string folder = std::tmpnam(nullptr);
+  ASSERT_EQ(mkdir(folder.c_str(), 0744), 0);
+  Workspace ws;
+  ASSERT_TRUE(ws.RunNetOnce(parseNetDef(initSpec)));
+  const std::string folderArgs = R"DOC(
+          arg {
+            name: "absolute_path"
+            i: 1
+          }
+          arg {
+            name: "folder"
+            s: ")DOC" + folder + R"DOC("
+          })DOC";
+  ASSERT_TRUE(ws.RunNetOnce(parseNetDef(
+      "op { type: \"SaveMapped\" input: \"W\" input: \"b\" " + folderArgs +
+      " }")));
+
+  // The init_net maps the weights instead of filling them.
+  Predictor mapped(
+      parseNetDef(
+          "op { type: \"LoadMapped\" output: \"W\" output: \"b\" " +
+          folderArgs + " }"),
+      parseNetDef(predictSpec));
+  Predictor reference(parseNetDef(initSpec), parseNetDef(predictSpec));
+  EXPECT_TRUE(mapped.ws()->GetBlob("W")->Get<TensorCPU>().shares_data());
+
+  DeviceOption op;
+  CPUContext ctx(op);
+  auto inputData = randomTensor({1, 4}, &ctx);
+  Predictor::TensorVector input{inputData->template GetMutable<TensorCPU>()};
+  Predictor::TensorVector output, expected;
+  EXPECT_TRUE(mapped.run(input, &output));
+  EXPECT_TRUE(reference.run(input, &expected));
+  for (int j = 0; j < 10; ++j) {
+    EXPECT_EQ(
+        output.front()->data<float>()[j], expected.front()->data<float>()[j]);
+  }
+}
+#endif
+
+TEST(PredictorPlanMemoryTest, ReusesActivationMemory) {
+  DeviceOption op;
+  op.set_random_seed(1701);
+  CPUContext ctx(op);
+  Predictor planned(parseNetDef(initSpec), parseNetDef(simplePredictSpec));
+  Predictor reference(parseNetDef(initSpec), parseNetDef(simplePredictSpec));
+  auto inputData = randomTensor({1, 4}, &ctx);
+  Predictor::TensorVector input{inputData->template GetMutable<TensorCPU>()};
+
+  EXPECT_TRUE(planned.plan_memory(input));
+  // fc and y are never alive at the same time and share their 64 bytes
+  EXPECT_EQ(planned.arena_bytes(), 128);
+  const auto* fcData = planned.ws()->GetBlob("fc")->Get<TensorCPU>().raw_data();
+
+  for (int i = 0; i < 2; ++i) {
+    inputData = randomTensor({1, 4}, &ctx);
+    Predictor::TensorVector input{inputData->template GetMutable<TensorCPU>()};
+    Predictor::TensorVector output, expected;
+    EXPECT_TRUE(planned.run(input, &output));
+    EXPECT_TRUE(reference.run(input, &expected));
+    EXPECT_EQ(
+        planned.ws()->GetBlob("fc")->Get<TensorCPU>().raw_data(), fcData);
+    EXPECT_EQ(output.front()->raw_data(), fcData);
+    for (int j = 0; j < 10; ++j) {
+      EXPECT_EQ(
+          output.front()->data<float>()[j],
+          expected.front()->data<float>()[j]);
+    }
+  }
+}
+
+TEST(PredictorPlanMemoryTest, RejectsDagNets) {
+  Predictor p(parseNetDef(initSpec), parseNetDef(predictSpec));
+  DeviceOption op;
+  CPUContext ctx(op);
+  auto inputData = randomTensor({1, 4}, &ctx);
+  Predictor::TensorVector input{inputData->template GetMutable<TensorCPU>()};
+  EXPECT_FALSE(p.plan_memory(input));
+  EXPECT_EQ(p.arena_bytes(), 0);
+}
 } // namespace caffe2
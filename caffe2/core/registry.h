@@ -84,11 +84,12 @@ class Registry {
   inline bool Has(const SrcType& key) { return (registry_.count(key) != 0); }
 
   ObjectPtrType Create(const SrcType& key, Args... args) {
-    if (registry_.count(key) == 0) {
+    auto it = registry_.find(key);
+    if (it == registry_.end()) {
       // Returns nullptr if the key is not registered.
       return nullptr;
     }
-    return registry_[key](args...);
+    return it->second(args...);
   }
 
   /**
@@ -0,0 +1,148 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CAFFE2_CORE_SCRATCH_ARENA_H_
+#define CAFFE2_CORE_SCRATCH_ARENA_H_
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "caffe2/core/tensor.h"
+
+namespace caffe2 {
+
+/**
+ * A pool of scratch tensors that operators borrow for the duration of a run
+ * instead of keeping their own members alive between iterations, e.g.
+ *
+ *   auto col_buffer = context_.scratch_arena()->Borrow();
+ *   col_buffer->Resize(...);
+ *
+ * The tensor goes back to the arena when the Buffer is destroyed. Tensors keep
+ * their capacity when they are resized down (see caffe2_keep_on_shrink), and
+ * the most recently returned one is handed out first, so an arena settles at
+ * the peak scratch requirement of the operators that run concurrently on it
+ * rather than the sum over the net.
+ *
+ * Each context hands out its own arena through scratch_arena(): CPUContext
+ * shares one arena across the process, GPU contexts have one per stream, so a
+ * tensor is only reused by work that is queued after the one that returned it.
+ */
+template <class Context>
+class ScratchArena {
+ public:
+  class Buffer {
+   public:
+    Buffer() {}
+    Buffer(Buffer&& other) noexcept
+        : arena_(other.arena_), tensor_(std::move(other.tensor_)) {
+      other.arena_ = nullptr;
+    }
+    Buffer& operator=(Buffer&& other) noexcept {
+      if (this != &other) {
+        reset();
+        arena_ = other.arena_;
+        tensor_ = std::move(other.tensor_);
+        other.arena_ = nullptr;
+      }
+      return *this;
+    }
+    ~Buffer() {
+      reset();
+    }
+
+    Tensor<Context>* get() const {
+      return tensor_.get();
+    }
+    Tensor<Context>* operator->() const {
+      return tensor_.get();
+    }
+    Tensor<Context>& operator*() const {
+      return *tensor_;
+    }
+
+    // Hands the tensor back to the arena before the Buffer goes away.
+    void reset() {
+      if (tensor_) {
+        arena_->Return(std::move(tensor_));
+      }
+      arena_ = nullptr;
+    }
+
+   private:
+    friend class ScratchArena;
+    Buffer(ScratchArena* arena, std::unique_ptr<Tensor<Context>> tensor)
+        : arena_(arena), tensor_(std::move(tensor)) {}
+
+    ScratchArena* arena_ = nullptr;
+    std::unique_ptr<Tensor<Context>> tensor_;
+
+    DISABLE_COPY_AND_ASSIGN(Buffer);
+  };
+
+  ScratchArena() {}
+
+  Buffer Borrow() {
+    std::unique_ptr<Tensor<Context>> tensor;
+    {
+      std::lock_guard<std::mutex> g(mutex_);
+      if (!idle_.empty()) {
+        tensor = std::move(idle_.back());
+        idle_.pop_back();
+      }
+    }
+    if (!tensor) {
+      tensor.reset(new Tensor<Context>());
+    }
+    return Buffer(this, std::move(tensor));
+  }
+
+  // Frees the memory of the tensors that are not borrowed.
+  void Release() {
+    std::vector<std::unique_ptr<Tensor<Context>>> idle;
+    {
+      std::lock_guard<std::mutex> g(mutex_);
+      idle.swap(idle_);
+    }
+  }
+
+  // Bytes held by the tensors that are not borrowed.
+  size_t idle_nbytes() {
+    std::lock_guard<std::mutex> g(mutex_);
+    size_t nbytes = 0;
+    for (const auto& tensor : idle_) {
+      nbytes += tensor->capacity_nbytes();
+    }
+    return nbytes;
+  }
+
+ private:
+  void Return(std::unique_ptr<Tensor<Context>> tensor) {
+    std::lock_guard<std::mutex> g(mutex_);
+    idle_.push_back(std::move(tensor));
+  }
+
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<Tensor<Context>>> idle_;
+
+  DISABLE_COPY_AND_ASSIGN(ScratchArena);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_SCRATCH_ARENA_H_
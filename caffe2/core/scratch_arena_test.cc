@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/scratch_arena.h"
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+TEST(ScratchArenaTest, ReusesReturnedTensor) {
+  ScratchArena<CPUContext> arena;
+  const void* data = nullptr;
+  {
+    auto buffer = arena.Borrow();
+    buffer->Resize(1000);
+    data = buffer->mutable_data<float>();
+  }
+  EXPECT_EQ(arena.idle_nbytes(), 1000 * sizeof(float));
+  // A smaller request is served from the memory of the first one.
+  auto buffer = arena.Borrow();
+  EXPECT_EQ(arena.idle_nbytes(), 0);
+  buffer->Resize(10);
+  EXPECT_EQ(buffer->mutable_data<float>(), data);
+}
+
+TEST(ScratchArenaTest, ConcurrentBorrowsAreDistinct) {
+  ScratchArena<CPUContext> arena;
+  auto first = arena.Borrow();
+  auto second = arena.Borrow();
+  EXPECT_NE(first.get(), second.get());
+  first->Resize(10);
+  second->Resize(20);
+  EXPECT_NE(first->mutable_data<float>(), second->mutable_data<float>());
+  first.reset();
+  second.reset();
+  EXPECT_EQ(first.get(), nullptr);
+  EXPECT_EQ(arena.idle_nbytes(), 30 * sizeof(float));
+}
+
+TEST(ScratchArenaTest, MovedBufferReturnsOnce) {
+  ScratchArena<CPUContext> arena;
+  {
+    auto buffer = arena.Borrow();
+    buffer->Resize(4);
+    buffer->mutable_data<float>();
+    ScratchArena<CPUContext>::Buffer moved;
+    moved = std::move(buffer);
+    EXPECT_EQ(buffer.get(), nullptr);
+    EXPECT_NE(moved.get(), nullptr);
+  }
+  EXPECT_EQ(arena.idle_nbytes(), 4 * sizeof(float));
+  arena.Release();
+  EXPECT_EQ(arena.idle_nbytes(), 0);
+}
+
+TEST(ScratchArenaTest, ContextArena) {
+  EXPECT_EQ(CPUContext::scratch_arena(), CPUContext::scratch_arena());
+  CPUContext context;
+  auto buffer = context.scratch_arena()->Borrow();
+  EXPECT_NE(buffer.get(), nullptr);
+}
+
+} // namespace caffe2
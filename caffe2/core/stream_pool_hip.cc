@@ -0,0 +1,392 @@
+#include "caffe2/core/stream_pool_hip.h"
+
+#include <algorithm>
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/logging.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Allocations are rounded up to this many bytes.
+constexpr size_t kRoundSize = 512;
+// Allocations up to this size share small segments.
+constexpr size_t kSmallSize = 1 << 20;
+constexpr size_t kSmallSegment = 2 << 20;
+// Allocations up to this size share large segments, bigger ones get a
+// segment of their own.
+constexpr size_t kMediumSize   = 10 << 20;
+constexpr size_t kLargeSegment = 20 << 20;
+
+size_t RoundSize(size_t nbytes)
+{
+    if(nbytes < kRoundSize)
+    {
+        return kRoundSize;
+    }
+    return (nbytes + kRoundSize - 1) / kRoundSize * kRoundSize;
+}
+
+size_t SegmentSize(size_t size)
+{
+    if(size <= kSmallSize)
+    {
+        return kSmallSegment;
+    }
+    if(size < kMediumSize)
+    {
+        return kLargeSegment;
+    }
+    return (size + kSmallSegment - 1) / kSmallSegment * kSmallSegment;
+}
+
+// Only split when the remainder is worth keeping: small blocks can be split
+// at any granularity, large ones only when at least kSmallSize is left, so
+// that large segments do not fill up with tiny fragments.
+bool ShouldSplit(size_t block_size, size_t size)
+{
+    const size_t remaining = block_size - size;
+    return size <= kSmallSize ? remaining >= kRoundSize : remaining > kSmallSize;
+}
+
+std::atomic<int> g_next_allocator_id(0);
+
+} // namespace
+
+HipStreamPoolAllocator::HipStreamPoolAllocator() : id_(g_next_allocator_id++) {}
+
+HipStreamPoolAllocator::~HipStreamPoolAllocator()
+{
+    for(auto& pool : pools_)
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        for(auto& pending : pool->pending)
+        {
+            HIP_CHECK(hipEventSynchronize(pending.first));
+            HIP_CHECK(hipEventDestroy(pending.first));
+            FreeBlock(pool.get(), pending.second);
+        }
+        pool->pending.clear();
+        ReleaseFreeSegments(pool.get());
+        if(pool->stats.num_segments > 0)
+        {
+            LOG(WARNING) << "Destroying the HIP stream pool of device " << pool->device
+                         << " with " << pool->stats.allocated_bytes
+                         << " bytes still allocated.";
+        }
+    }
+}
+
+HipStreamPoolAllocator& HipStreamPoolAllocator::Get()
+{
+    static auto* allocator = new HipStreamPoolAllocator();
+    return *allocator;
+}
+
+HipStreamPoolAllocator::StreamPool* HipStreamPoolAllocator::GetPool(int device,
+                                                                    hipStream_t stream)
+{
+    // A thread allocates on a handful of streams only, so a small thread
+    // local list saves taking pools_mutex_ on every allocation.
+    struct CachedPool
+    {
+        int allocator_id;
+        int device;
+        hipStream_t stream;
+        StreamPool* pool;
+    };
+    static thread_local std::vector<CachedPool> cache;
+    for(const auto& entry : cache)
+    {
+        if(entry.allocator_id == id_ && entry.device == device && entry.stream == stream)
+        {
+            return entry.pool;
+        }
+    }
+
+    StreamPool* pool = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(pools_mutex_);
+        for(auto& p : pools_)
+        {
+            if(p->device == device && p->stream == stream)
+            {
+                pool = p.get();
+                break;
+            }
+        }
+        if(!pool)
+        {
+            pools_.emplace_back(new StreamPool());
+            pool         = pools_.back().get();
+            pool->device = device;
+            pool->stream = stream;
+        }
+    }
+    cache.push_back({id_, device, stream, pool});
+    return pool;
+}
+
+HipStreamPoolAllocator::Block* HipStreamPoolAllocator::TryAllocate(StreamPool* pool,
+                                                                   size_t size)
+{
+    ProcessPendingFrees(pool);
+
+    Block* block = nullptr;
+    Block key{nullptr, nullptr, size, false, nullptr, nullptr};
+    auto it = pool->free_blocks.lower_bound(&key);
+    if(it != pool->free_blocks.end())
+    {
+        block = *it;
+        pool->free_blocks.erase(it);
+        ++pool->stats.num_cache_hits;
+    }
+    else
+    {
+        const size_t segment_size = SegmentSize(size);
+        void* ptr                 = nullptr;
+        hipError_t error;
+        {
+            std::lock_guard<std::mutex> lock(HIPContext::mutex());
+            DeviceGuard guard(pool->device);
+            error = hipMalloc(&ptr, segment_size);
+        }
+        if(error != hipSuccess)
+        {
+            // Clear the error state, the caller may retry after freeing
+            // the caches.
+            hipGetLastError();
+            return nullptr;
+        }
+        block = new Block{pool, static_cast<char*>(ptr), segment_size, false, nullptr, nullptr};
+        pool->stats.cached_bytes += segment_size;
+        ++pool->stats.num_segments;
+    }
+
+    if(ShouldSplit(block->size, size))
+    {
+        auto* remainder = new Block{
+            pool, block->ptr + size, block->size - size, false, block, block->next};
+        if(block->next)
+        {
+            block->next->prev = remainder;
+        }
+        block->next = remainder;
+        block->size = size;
+        pool->free_blocks.insert(remainder);
+    }
+    block->allocated = true;
+    pool->stats.allocated_bytes += block->size;
+    ++pool->stats.num_allocs;
+    return block;
+}
+
+void HipStreamPoolAllocator::FreeBlock(StreamPool* pool, Block* block)
+{
+    block->allocated = false;
+    pool->stats.allocated_bytes -= block->size;
+
+    // Coalesce with the free neighbours. Blocks waiting for an event are
+    // still marked as allocated, so they are left alone.
+    Block* prev = block->prev;
+    if(prev && !prev->allocated)
+    {
+        pool->free_blocks.erase(prev);
+        prev->size += block->size;
+        prev->next = block->next;
+        if(block->next)
+        {
+            block->next->prev = prev;
+        }
+        delete block;
+        block = prev;
+    }
+    Block* next = block->next;
+    if(next && !next->allocated)
+    {
+        pool->free_blocks.erase(next);
+        block->size += next->size;
+        block->next = next->next;
+        if(next->next)
+        {
+            next->next->prev = block;
+        }
+        delete next;
+    }
+    pool->free_blocks.insert(block);
+}
+
+void HipStreamPoolAllocator::ProcessPendingFrees(StreamPool* pool)
+{
+    auto it = pool->pending.begin();
+    while(it != pool->pending.end())
+    {
+        hipError_t status = hipEventQuery(it->first);
+        if(status == hipErrorNotReady)
+        {
+            ++it;
+            continue;
+        }
+        HIP_ENFORCE(status);
+        HIP_ENFORCE(hipEventDestroy(it->first));
+        FreeBlock(pool, it->second);
+        it = pool->pending.erase(it);
+    }
+}
+
+void HipStreamPoolAllocator::ReleaseFreeSegments(StreamPool* pool)
+{
+    auto it = pool->free_blocks.begin();
+    while(it != pool->free_blocks.end())
+    {
+        Block* block = *it;
+        // Only whole segments can be given back.
+        if(block->prev || block->next)
+        {
+            ++it;
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(HIPContext::mutex());
+            DeviceGuard guard(pool->device);
+            HIP_CHECK(hipFree(block->ptr));
+        }
+        pool->stats.cached_bytes -= block->size;
+        --pool->stats.num_segments;
+        delete block;
+        it = pool->free_blocks.erase(it);
+    }
+}
+
+void* HipStreamPoolAllocator::Allocate(size_t nbytes, int device, hipStream_t stream)
+{
+    if(nbytes == 0)
+    {
+        return nullptr;
+    }
+    const size_t size = RoundSize(nbytes);
+    StreamPool* pool  = GetPool(device, stream);
+
+    Block* block = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        block = TryAllocate(pool, size);
+    }
+    if(!block)
+    {
+        // Memory may be cached by the pools of other streams; give it back
+        // to the device and try once more.
+        EmptyCache(device);
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        block = TryAllocate(pool, size);
+    }
+    CAFFE_ENFORCE(block,
+                  "HIP stream pool: out of memory allocating ",
+                  nbytes,
+                  " bytes on device ",
+                  device);
+
+    auto& shard = GetShard(block->ptr);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.blocks[block->ptr] = block;
+    return block->ptr;
+}
+
+void HipStreamPoolAllocator::Free(void* ptr, hipStream_t current_stream)
+{
+    if(!ptr)
+    {
+        return;
+    }
+    Block* block = nullptr;
+    {
+        auto& shard = GetShard(ptr);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.blocks.find(ptr);
+        CAFFE_ENFORCE(it != shard.blocks.end(), "Pointer ", ptr, " not allocated by this pool");
+        block = it->second;
+        shard.blocks.erase(it);
+    }
+
+    StreamPool* pool = block->pool;
+    if(current_stream && current_stream != pool->stream)
+    {
+        // The caller's stream may still have work using the block queued up.
+        // It is a stream of the block's device, so the event is created there.
+        DeviceGuard guard(pool->device);
+        hipEvent_t event;
+        HIP_ENFORCE(hipEventCreateWithFlags(&event, hipEventDisableTiming));
+        HIP_ENFORCE(hipEventRecord(event, current_stream));
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->pending.emplace_back(event, block);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    FreeBlock(pool, block);
+}
+
+int HipStreamPoolAllocator::GetDevice(void* ptr)
+{
+    auto& shard = GetShard(ptr);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.blocks.find(ptr);
+    CAFFE_ENFORCE(it != shard.blocks.end(), "Pointer ", ptr, " not allocated by this pool");
+    return it->second->pool->device;
+}
+
+void HipStreamPoolAllocator::EmptyCache(int device)
+{
+    std::vector<StreamPool*> pools;
+    {
+        std::lock_guard<std::mutex> lock(pools_mutex_);
+        for(auto& pool : pools_)
+        {
+            if(device < 0 || pool->device == device)
+            {
+                pools.push_back(pool.get());
+            }
+        }
+    }
+    for(auto* pool : pools)
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        ProcessPendingFrees(pool);
+        ReleaseFreeSegments(pool);
+    }
+}
+
+HipMemoryPoolStats HipStreamPoolAllocator::GetStats(int device)
+{
+    std::vector<StreamPool*> pools;
+    {
+        std::lock_guard<std::mutex> lock(pools_mutex_);
+        for(auto& pool : pools_)
+        {
+            if(pool->device == device)
+            {
+                pools.push_back(pool.get());
+            }
+        }
+    }
+    HipMemoryPoolStats total;
+    for(auto* pool : pools)
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        const auto& stats = pool->stats;
+        total.allocated_bytes += stats.allocated_bytes;
+        total.cached_bytes += stats.cached_bytes;
+        total.num_allocs += stats.num_allocs;
+        total.num_cache_hits += stats.num_cache_hits;
+        total.num_segments += stats.num_segments;
+        if(!pool->free_blocks.empty())
+        {
+            total.largest_free_block =
+                std::max(total.largest_free_block, (*pool->free_blocks.rbegin())->size);
+        }
+    }
+    return total;
+}
+
+} // namespace caffe2
@@ -0,0 +1,132 @@
+#ifndef CAFFE2_CORE_STREAM_POOL_HIP_H_
+#define CAFFE2_CORE_STREAM_POOL_HIP_H_
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "caffe2/core/common_hip.h"
+#include "caffe2/core/context_hip.h"
+
+namespace caffe2 {
+
+/**
+ * A caching device allocator that keeps a separate pool for every
+ * (device, stream) pair, used when --caffe2_hip_memory_pool=stream_pool.
+ *
+ * Memory is requested from hipMalloc in segments, which are split to serve
+ * allocations and coalesced again when neighbouring blocks are freed. A block
+ * is only ever reused on the stream it was allocated on, so stream ordering
+ * makes the reuse safe without any synchronization. When a block is freed
+ * from a different stream, an event is recorded on that stream and the block
+ * returns to its pool only once the event has completed.
+ *
+ * Each pool has its own lock. Since caffe2 streams are thread local, that
+ * lock is only contended by frees coming from other threads, so allocations
+ * on different streams never wait on each other, unlike with the global
+ * HIPContext::mutex() used by the cub allocator. hipMalloc / hipFree calls
+ * still take HIPContext::mutex() so that they do not interleave with RCCL
+ * launches.
+ */
+class HipStreamPoolAllocator
+{
+    public:
+    HipStreamPoolAllocator();
+    ~HipStreamPoolAllocator();
+
+    // Process-wide instance used by HIPContext. It is never destroyed, so
+    // that tensors freed during static destruction can still return
+    // their memory.
+    static HipStreamPoolAllocator& Get();
+
+    // Allocates nbytes on device, to be used on stream.
+    void* Allocate(size_t nbytes, int device, hipStream_t stream);
+    // Frees ptr, which must come from Allocate. current_stream is the
+    // stream of the caller on the device of ptr; if it is neither null nor
+    // the allocation stream, the block is only reused after the work queued
+    // on current_stream so far has completed.
+    void Free(void* ptr, hipStream_t current_stream);
+    // Device that ptr, which must come from Allocate, was allocated on.
+    int GetDevice(void* ptr);
+
+    // Returns the unused segments of device (all devices if device < 0)
+    // to hipFree.
+    void EmptyCache(int device = -1);
+
+    HipMemoryPoolStats GetStats(int device);
+
+    private:
+    struct StreamPool;
+
+    struct Block
+    {
+        StreamPool* pool;
+        char* ptr;
+        size_t size;
+        bool allocated;
+        // Neighbouring blocks carved out of the same segment.
+        Block* prev;
+        Block* next;
+    };
+
+    struct BlockComparator
+    {
+        bool operator()(const Block* a, const Block* b) const
+        {
+            if(a->size != b->size)
+            {
+                return a->size < b->size;
+            }
+            return a->ptr < b->ptr;
+        }
+    };
+
+    struct StreamPool
+    {
+        int device;
+        hipStream_t stream;
+        std::mutex mutex;
+        std::set<Block*, BlockComparator> free_blocks;
+        // Blocks freed from another stream, waiting for their event.
+        std::deque<std::pair<hipEvent_t, Block*>> pending;
+        HipMemoryPoolStats stats;
+    };
+
+    // The pointer to block map is sharded so that frees do not serialize
+    // on a single lock.
+    static constexpr int kNumShards = 64;
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<void*, Block*> blocks;
+    };
+
+    StreamPool* GetPool(int device, hipStream_t stream);
+    Shard& GetShard(void* ptr)
+    {
+        return shards_[(reinterpret_cast<uintptr_t>(ptr) >> 9) % kNumShards];
+    }
+
+    // All the helpers below expect pool->mutex to be held.
+    Block* TryAllocate(StreamPool* pool, size_t size);
+    void FreeBlock(StreamPool* pool, Block* block);
+    void ProcessPendingFrees(StreamPool* pool);
+    void ReleaseFreeSegments(StreamPool* pool);
+
+    const int id_;
+    std::mutex pools_mutex_;
+    std::vector<std::unique_ptr<StreamPool>> pools_;
+    Shard shards_[kNumShards];
+
+    DISABLE_COPY_AND_ASSIGN(HipStreamPoolAllocator);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_STREAM_POOL_HIP_H_
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/stream_pool_hip.h"
+
+namespace caffe2 {
+
+namespace {
+class HipStreamPoolTest : public ::testing::Test
+{
+    protected:
+    void SetUp() override
+    {
+        if(!HasHipGPU())
+            return;
+        DeviceGuard guard(0);
+        HIP_ENFORCE(hipStreamCreateWithFlags(&stream_a_, hipStreamNonBlocking));
+        HIP_ENFORCE(hipStreamCreateWithFlags(&stream_b_, hipStreamNonBlocking));
+    }
+
+    void TearDown() override
+    {
+        if(!HasHipGPU())
+            return;
+        HIP_ENFORCE(hipStreamDestroy(stream_a_));
+        HIP_ENFORCE(hipStreamDestroy(stream_b_));
+    }
+
+    hipStream_t stream_a_ = nullptr;
+    hipStream_t stream_b_ = nullptr;
+};
+} // namespace
+
+TEST_F(HipStreamPoolTest, ReuseOnSameStream)
+{
+    if(!HasHipGPU())
+        return;
+    HipStreamPoolAllocator allocator;
+    void* ptr = allocator.Allocate(1000, 0, stream_a_);
+    EXPECT_NE(ptr, nullptr);
+    allocator.Free(ptr, stream_a_);
+    EXPECT_EQ(allocator.Allocate(1000, 0, stream_a_), ptr);
+    // The free block belongs to stream_a_, so stream_b_ gets its own memory.
+    void* other = allocator.Allocate(1000, 0, stream_b_);
+    EXPECT_NE(other, ptr);
+    allocator.Free(ptr, stream_a_);
+    allocator.Free(other, stream_b_);
+
+    auto stats = allocator.GetStats(0);
+    EXPECT_EQ(stats.allocated_bytes, 0u);
+    EXPECT_EQ(stats.num_allocs, 3);
+    EXPECT_EQ(stats.num_cache_hits, 1);
+    EXPECT_EQ(stats.num_segments, 2);
+}
+
+TEST_F(HipStreamPoolTest, SplitAndCoalesce)
+{
+    if(!HasHipGPU())
+        return;
+    HipStreamPoolAllocator allocator;
+    void* a = allocator.Allocate(4096, 0, stream_a_);
+    void* b = allocator.Allocate(4096, 0, stream_a_);
+    // Both blocks are carved out of the same segment.
+    EXPECT_EQ(static_cast<char*>(b), static_cast<char*>(a) + 4096);
+    allocator.Free(a, stream_a_);
+    allocator.Free(b, stream_a_);
+    // Once coalesced, the whole segment is one free block again.
+    auto stats = allocator.GetStats(0);
+    EXPECT_EQ(stats.num_segments, 1);
+    EXPECT_EQ(stats.largest_free_block, stats.cached_bytes);
+    EXPECT_EQ(allocator.Allocate(8192, 0, stream_a_), a);
+    allocator.Free(a, stream_a_);
+    allocator.EmptyCache();
+    EXPECT_EQ(allocator.GetStats(0).cached_bytes, 0u);
+}
+
+TEST_F(HipStreamPoolTest, CrossStreamFree)
+{
+    if(!HasHipGPU())
+        return;
+    HipStreamPoolAllocator allocator;
+    void* ptr = allocator.Allocate(1 << 20, 0, stream_a_);
+    HIP_ENFORCE(hipMemsetAsync(ptr, 0, 1 << 20, stream_b_));
+    // Freed from stream_b_: the block is only reused once the memset is
+    // done.
+    allocator.Free(ptr, stream_b_);
+    HIP_ENFORCE(hipStreamSynchronize(stream_b_));
+    EXPECT_EQ(allocator.Allocate(1 << 20, 0, stream_a_), ptr);
+    allocator.Free(ptr, stream_a_);
+}
+
+} // namespace caffe2
@@ -16,6 +16,9 @@
 
 #include "caffe2/core/transform.h"
 
+#include <algorithm>
+#include <numeric>
+
 #include "caffe2/core/common.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/core/net.h"
@@ -28,6 +31,38 @@ using transform::Graph;
 
 CAFFE_DEFINE_REGISTRY(TransformRegistry, Transform);
 
+const std::vector<int>* Transform::CandidateNodes(
+    const Graph& graph,
+    size_t pos) {
+  if (pos >= candidates_built_.size()) {
+    candidates_built_.resize(pos + 1, false);
+    candidate_nodes_.resize(pos + 1);
+    candidate_mask_.resize(pos + 1);
+  }
+  if (!candidates_built_[pos]) {
+    candidates_built_[pos] = true;
+    const string type = PatternOpType(pos);
+    if (type != "*") {
+      auto& nodes = candidate_nodes_[pos];
+      for (const auto& entry : nodes_by_type_) {
+        if (MatchStrings(type, entry.first)) {
+          nodes.insert(nodes.end(), entry.second.begin(), entry.second.end());
+        }
+      }
+      std::sort(nodes.begin(), nodes.end());
+      candidate_mask_[pos].assign(graph.size(), false);
+      for (int idx : nodes) {
+        candidate_mask_[pos][idx] = true;
+      }
+    }
+  }
+  return candidate_mask_[pos].empty() ? nullptr : &candidate_nodes_[pos];
+}
+
+bool Transform::IsCandidate(const Graph& graph, size_t pos, int idx) {
+  return CandidateNodes(graph, pos) == nullptr || candidate_mask_[pos][idx];
+}
+
 std::vector<std::vector<int>> Transform::PatternMatch(const Graph& graph) {
   // checks if the node at index i is matched already or not
   std::vector<bool> matched(graph.size(), false);
@@ -35,8 +70,25 @@ std::vector<std::vector<int>> Transform::PatternMatch(const Graph& graph) {
   // stores matches, which are ordered subgraphs of G
   std::vector<std::vector<int>> matches;
 
-  // Consider every possible node as the starting point.
+  // Index the nodes by op type, so that only the nodes of the types the
+  // pattern asks for are tried at each position.
+  nodes_by_type_.clear();
+  candidates_built_.clear();
+  candidate_nodes_.clear();
+  candidate_mask_.clear();
   for (int idx = 0; idx < graph.size(); ++idx) {
+    nodes_by_type_[graph.node(idx).op.type()].push_back(idx);
+  }
+  std::vector<int> all_nodes;
+  const std::vector<int>* start_nodes = CandidateNodes(graph, 0);
+  if (!start_nodes) {
+    all_nodes.resize(graph.size());
+    std::iota(all_nodes.begin(), all_nodes.end(), 0);
+    start_nodes = &all_nodes;
+  }
+
+  // Consider every possible node as the starting point.
+  for (int idx : *start_nodes) {
     // The current working subgraph. We will try to add new nodes to this,
     // when invoking the PatternRule.
     std::vector<int> subgraph;
@@ -70,6 +122,9 @@ void Transform::TryNeighbors(
   auto& subgraph = *subgraph_ptr;
   for (const auto& edge : neighbors) {
     int j = edge.first;
+    if (!IsCandidate(graph, subgraph.size(), j)) {
+      continue;
+    }
     if (std::find(subgraph.begin(), subgraph.end(), j) == subgraph.end()) {
       if (!matched.at(j) && PatternRule(graph, subgraph, j)) {
         subgraph.push_back(j);
@@ -139,11 +194,26 @@ void Transform::PatternMatchHelper(
     if (subgraph.size() > 0) {
       start_idx = subgraph.back() + 1;
     }
-    for (int i = start_idx; i < graph.size(); i++) {
-      if (!matched.at(i) && PatternRule(graph, subgraph, i)) {
-        subgraph.push_back(i);
-        PatternMatchHelper(graph, matched, subgraph_ptr, best_subgraph_ptr);
-        subgraph.pop_back();
+    const auto* candidates = CandidateNodes(graph, subgraph.size());
+    if (candidates) {
+      for (auto it = std::lower_bound(
+               candidates->begin(), candidates->end(), start_idx);
+           it != candidates->end();
+           ++it) {
+        int i = *it;
+        if (!matched.at(i) && PatternRule(graph, subgraph, i)) {
+          subgraph.push_back(i);
+          PatternMatchHelper(graph, matched, subgraph_ptr, best_subgraph_ptr);
+          subgraph.pop_back();
+        }
+      }
+    } else {
+      for (int i = start_idx; i < graph.size(); i++) {
+        if (!matched.at(i) && PatternRule(graph, subgraph, i)) {
+          subgraph.push_back(i);
+          PatternMatchHelper(graph, matched, subgraph_ptr, best_subgraph_ptr);
+          subgraph.pop_back();
+        }
       }
     }
   } else if (pattern_match_type_ == GENERAL) {
@@ -153,6 +223,9 @@ void Transform::PatternMatchHelper(
     // For every current subgraph, we consider all nodes to be
     // the next candidate node, as long as it isn't already matched.
     for (int i = 0; i < graph.size(); i++) {
+      if (!IsCandidate(graph, subgraph.size(), i)) {
+        continue;
+      }
       if (std::find(subgraph.begin(), subgraph.end(), i) == subgraph.end()) {
         // Then we try appending it to the subgraph.
         if (!matched.at(i) && PatternRule(graph, subgraph, i)) {
@@ -16,6 +16,10 @@
 
 #pragma once
 
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
 #include "caffe2/core/common.h"
 #include "caffe2/core/graph.h"
 #include "caffe2/core/workspace.h"
@@ -54,8 +58,11 @@ class Transform {
   /**
    * Apply a Transform onto a NetDef.
    * Returns the transformed NetDef.
+   *
+   * Transforms that work on the whole graph at once rather than on matched
+   * subgraphs (e.g. dead op elimination) override this instead of the rules.
    */
-  NetDef ApplyTo(const NetDef& orig_net_def);
+  virtual NetDef ApplyTo(const NetDef& orig_net_def);
 
   virtual ~Transform() {}
 
@@ -136,11 +143,34 @@ class Transform {
     CAFFE_NOT_IMPLEMENTED;
   }
 
+  /**
+   * Returns the op type, as a pattern accepted by MatchStrings, that a node
+   * must have for PatternRule to accept it at position pos of a subgraph, or
+   * "*" if any op can be there. PatternMatch then only tries the ops of the
+   * matching types, which it finds through an index of the graph by op type.
+   */
+  virtual string PatternOpType(size_t /*pos*/) {
+    return "*";
+  }
+
   void SetPatternMatchType(PatternMatchType type) {
     pattern_match_type_ = type;
   }
 
  private:
+  /**
+   * Returns the nodes of the graph, in execution order, whose type matches
+   * PatternOpType(pos), or nullptr if any node may be at position pos.
+   */
+  const std::vector<int>* CandidateNodes(
+      const transform::Graph& graph,
+      size_t pos);
+
+  /**
+   * Whether node idx may be at position pos, according to PatternOpType.
+   */
+  bool IsCandidate(const transform::Graph& graph, size_t pos, int idx);
+
   /**
    * A helper function for PatternMatch, which keeps track of the best subgraph
    * so far.
@@ -161,6 +191,16 @@ class Transform {
       std::vector<int>* best_subgraph_ptr);
 
   PatternMatchType pattern_match_type_ = CONNECTED_SUBGRAPH;
+
+  // The index used by PatternMatch: the nodes of each op type, and for each
+  // position of a subgraph, the nodes PatternOpType accepts there (as a list
+  // and as a mask). Positions without restriction have an empty mask.
+  std::unordered_map<string, std::vector<int>> nodes_by_type_;
+  std::vector<bool> candidates_built_;
+  // These are deques so that the recursion can add positions while the
+  // lists of the earlier positions are being iterated.
+  std::deque<std::vector<int>> candidate_nodes_;
+  std::deque<std::vector<bool>> candidate_mask_;
 };
 
 // Creates a Transform based on a key, which should be defined in registry.
@@ -94,15 +94,12 @@ vector<string> Workspace::LocalBlobs() const {
   for (auto& entry : blob_map_) {
     names.push_back(entry.first);
   }
+  std::sort(names.begin(), names.end());
   return names;
 }
 
 vector<string> Workspace::Blobs() const {
-  vector<string> names;
-  names.reserve(blob_map_.size());
-  for (auto& entry : blob_map_) {
-    names.push_back(entry.first);
-  }
+  vector<string> names = LocalBlobs();
   for (const auto& forwarded : forwarded_blobs_) {
     const auto parent_ws = forwarded.second.first;
     const auto& parent_name = forwarded.second.second;
@@ -118,27 +115,35 @@ vector<string> Workspace::Blobs() const {
 }
 
 Blob* Workspace::CreateBlob(const string& name) {
-  if (HasBlob(name)) {
+  auto it = blob_map_.find(name);
+  if (it != blob_map_.end()) {
     VLOG(1) << "Blob " << name << " already exists. Skipping.";
-  } else if (forwarded_blobs_.count(name)) {
-    // possible if parent workspace deletes forwarded blob
-    VLOG(1) << "Blob " << name << " is already forwarded from parent workspace "
-            << "(blob " << forwarded_blobs_[name].second << "). Skipping.";
-  } else {
-    VLOG(1) << "Creating blob " << name;
-    blob_map_[name] = unique_ptr<Blob>(new Blob());
+    return it->second.get();
+  }
+  auto forwarded = forwarded_blobs_.find(name);
+  if (forwarded != forwarded_blobs_.end()) {
+    // the parent workspace may have deleted the forwarded blob, in which case
+    // this returns nullptr
+    VLOG(1) << "Blob " << name << " is forwarded from parent workspace "
+            << "(blob " << forwarded->second.second << "). Skipping.";
+    return GetBlob(name);
+  }
+  if (shared_ && shared_->HasBlob(name)) {
+    VLOG(1) << "Blob " << name << " already exists. Skipping.";
+    return GetBlob(name);
   }
-  return GetBlob(name);
+  return CreateLocalBlob(name);
 }
 
 Blob* Workspace::CreateLocalBlob(const string& name) {
-  if (blob_map_.count(name)) {
+  auto& blob = blob_map_[name];
+  if (blob) {
     VLOG(1) << "Blob " << name << " already exists. Skipping.";
   } else {
     VLOG(1) << "Creating blob " << name;
-    blob_map_[name] = unique_ptr<Blob>(new Blob());
+    blob.reset(new Blob());
   }
-  return GetBlob(name);
+  return blob.get();
 }
 
 Blob* Workspace::RenameBlob(const string& old_name, const string& new_name) {
@@ -160,7 +165,7 @@ Blob* Workspace::RenameBlob(const string& old_name, const string& new_name) {
   blob_map_.erase(it);
 
   auto* raw_ptr = value.get();
-  blob_map_[new_name] = std::move(value);
+  blob_map_.emplace(new_name, std::move(value));
   return raw_ptr;
 }
 
@@ -178,12 +183,13 @@ bool Workspace::RemoveBlob(const string& name) {
 }
 
 const Blob* Workspace::GetBlob(const string& name) const {
-  if (blob_map_.count(name)) {
-    return blob_map_.at(name).get();
-  } else if (forwarded_blobs_.count(name)) {
-    const auto parent_ws = forwarded_blobs_.at(name).first;
-    const auto& parent_name = forwarded_blobs_.at(name).second;
-    return parent_ws->GetBlob(parent_name);
+  auto it = blob_map_.find(name);
+  if (it != blob_map_.end()) {
+    return it->second.get();
+  }
+  auto forwarded = forwarded_blobs_.find(name);
+  if (forwarded != forwarded_blobs_.end()) {
+    return forwarded->second.first->GetBlob(forwarded->second.second);
   } else if (shared_ && shared_->HasBlob(name)) {
     return shared_->GetBlob(name);
   }
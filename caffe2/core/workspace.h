@@ -28,6 +28,7 @@
 #include <cstddef>
 #include <mutex>
 #include <typeinfo>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -69,7 +70,10 @@ struct StopOnSignal {
 class Workspace {
  public:
   typedef std::function<bool(int)> ShouldContinue;
-  typedef CaffeMap<string, unique_ptr<Blob> > BlobMap;
+  // Blobs are looked up by name on every GetBlob/CreateBlob, so they are kept
+  // in a hash map; the Blob objects themselves never move. LocalBlobs() and
+  // Blobs() sort the names they return.
+  typedef std::unordered_map<string, unique_ptr<Blob>> BlobMap;
   typedef CaffeMap<string, unique_ptr<NetBase> > NetMap;
   /**
    * Initializes an empty workspace.
@@ -195,16 +199,24 @@ class Workspace {
     // Then, check the forwarding map, then the parent workspace
     if (blob_map_.count(name)) {
       return true;
-    } else if (forwarded_blobs_.count(name)) {
-      const auto parent_ws = forwarded_blobs_.at(name).first;
-      const auto& parent_name = forwarded_blobs_.at(name).second;
-      return parent_ws->HasBlob(parent_name);
+    }
+    auto forwarded = forwarded_blobs_.find(name);
+    if (forwarded != forwarded_blobs_.end()) {
+      return forwarded->second.first->HasBlob(forwarded->second.second);
     } else if (shared_) {
       return shared_->HasBlob(name);
     }
     return false;
   }
 
+  /**
+   * Checks if a blob with the given name is owned by the current workspace,
+   * without looking at forwarded blobs or the shared workspace.
+   */
+  inline bool HasLocalBlob(const string& name) const {
+    return blob_map_.count(name);
+  }
+
   void PrintBlobSizes();
 
   /**
@@ -230,6 +242,11 @@ class Workspace {
   /**
    * Gets the blob with the given name as a const pointer. If the blob does not
    * exist, a nullptr is returned.
+   *
+   * The returned pointer stays valid, also across RenameBlob(), until the blob
+   * is removed or the workspace owning it is destroyed, so callers running the
+   * same blobs repeatedly (operators, plan executors, Python handles) should
+   * look a blob up once and keep the pointer.
    */
   const Blob* GetBlob(const string& name) const;
   /**
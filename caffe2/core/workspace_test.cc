@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <iostream>
 
 #include "caffe2/core/operator.h"
@@ -70,6 +71,24 @@ TEST(WorkspaceTest, BlobAccess) {
   EXPECT_FALSE(ws.HasBlob("newblob"));
 }
 
+TEST(WorkspaceTest, BlobPointersAreStable) {
+  Workspace ws;
+  Blob* first = ws.CreateBlob("blob_0");
+  // Growing the workspace must not move the blobs already handed out.
+  for (int i = 1; i < 1000; ++i) {
+    ws.CreateBlob("blob_" + caffe2::to_string(i));
+  }
+  EXPECT_EQ(first, ws.GetBlob("blob_0"));
+  EXPECT_EQ(first, ws.CreateBlob("blob_0"));
+  EXPECT_EQ(first, ws.RenameBlob("blob_0", "renamed"));
+  EXPECT_EQ(first, ws.GetBlob("renamed"));
+  EXPECT_FALSE(ws.HasBlob("blob_0"));
+
+  const auto names = ws.LocalBlobs();
+  EXPECT_EQ(names.size(), 1000);
+  EXPECT_TRUE(std::is_sorted(names.begin(), names.end()));
+}
+
 TEST(WorkspaceTest, RunEmptyPlan) {
   PlanDef plan_def;
   Workspace ws;
@@ -131,4 +150,21 @@ TEST(WorkspaceTest, BlobMapping) {
   }
 }
 
+TEST(WorkspaceTest, ReadForwardedBlob) {
+  Workspace parent;
+  *parent.CreateBlob("a")->GetMutable<int>() = 17;
+  std::unordered_map<string, string> forwarded_blobs;
+  forwarded_blobs["inner_a"] = "a";
+  Workspace child(&parent, forwarded_blobs);
+  // Reads through the const and the mutable accessors reach the parent blob.
+  const Workspace& const_child = child;
+  EXPECT_EQ(const_child.GetBlob("inner_a"), parent.GetBlob("a"));
+  EXPECT_EQ(child.GetBlob("inner_a"), parent.GetBlob("a"));
+  EXPECT_EQ(child.CreateBlob("inner_a"), parent.GetBlob("a"));
+  EXPECT_EQ(const_child.GetBlob("inner_a")->Get<int>(), 17);
+  // Writes through the mapping are seen by the parent.
+  *child.GetBlob("inner_a")->GetMutable<int>() = 42;
+  EXPECT_EQ(parent.GetBlob("a")->Get<int>(), 42);
+}
+
 }  // namespace caffe2
@@ -0,0 +1,409 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/db/columnar_db.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "caffe2/core/blob_serialization.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/types.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+namespace db {
+
+namespace {
+
+constexpr char kSchemaFile[] = "schema";
+constexpr char kKeysFile[] = "keys";
+constexpr char kIndexFile[] = "index";
+
+string ColumnFile(const string& source, int column) {
+  return source + "/column_" + caffe2::to_string(column);
+}
+
+size_t FileSize(const string& path) {
+  struct stat st;
+  CAFFE_ENFORCE_EQ(stat(path.c_str(), &st), 0, "Cannot stat ", path);
+  return st.st_size;
+}
+
+void* MapFile(const string& path, size_t* size) {
+  *size = FileSize(path);
+  if (*size == 0) {
+    return nullptr;
+  }
+  int fd = open(path.c_str(), O_RDONLY);
+  CAFFE_ENFORCE_GE(fd, 0, "Cannot open ", path);
+  void* data = mmap(nullptr, *size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  CAFFE_ENFORCE(data != MAP_FAILED, "Cannot mmap ", path);
+  return data;
+}
+
+FILE* OpenOrDie(const string& path, const char* mode) {
+  FILE* file = fopen(path.c_str(), mode);
+  CAFFE_ENFORCE(file, "Cannot open ", path);
+  return file;
+}
+
+void WriteOrDie(FILE* file, const void* data, size_t size) {
+  if (size) {
+    CAFFE_ENFORCE_EQ(fwrite(data, 1, size, file), size, "Write failed.");
+  }
+}
+
+// Writes the file under a temporary name and renames it into place, so that
+// a reader opening path sees either the old or the new content, never a
+// partially written file.
+void ReplaceFileOrDie(const string& path, const void* data, size_t size) {
+  const string tmp_path = path + ".tmp";
+  FILE* file = OpenOrDie(tmp_path, "wb");
+  WriteOrDie(file, data, size);
+  CAFFE_ENFORCE_EQ(fclose(file), 0, "Cannot write ", tmp_path);
+  CAFFE_ENFORCE_EQ(
+      rename(tmp_path.c_str(), path.c_str()),
+      0,
+      "Cannot rename ",
+      tmp_path,
+      " to ",
+      path);
+}
+
+} // namespace
+
+class ColumnarDBCursor : public Cursor {
+ public:
+  explicit ColumnarDBCursor(const ColumnarDB* db) : db_(db), record_(0) {}
+  ~ColumnarDBCursor() {}
+
+  void Seek(const string& key) override {
+    CAFFE_ENFORCE(
+        db_->keys_sorted(),
+        "ColumnarDB only supports seeking when the keys were written in "
+        "sorted order.");
+    int64_t lo = 0;
+    int64_t hi = db_->num_records();
+    while (lo < hi) {
+      const int64_t mid = lo + (hi - lo) / 2;
+      if (db_->key(mid) < key) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    record_ = lo;
+  }
+  bool SupportsSeek() override {
+    return db_->keys_sorted();
+  }
+  void SeekToFirst() override {
+    record_ = 0;
+  }
+  void Next() override {
+    ++record_;
+  }
+  string key() override {
+    return db_->key(record_);
+  }
+  string value() override {
+    // Rebuilds the TensorProtos the record was written from. The tensors
+    // share the mapped data, so the only copy is the one into the proto.
+    const auto& schema = db_->schema();
+    TensorProtos protos;
+    TensorSerializer<CPUContext> serializer;
+    for (int i = 0; i < schema.protos_size(); ++i) {
+      const auto& column = schema.protos(i);
+      TensorCPU tensor(
+          vector<TIndex>(column.dims().begin(), column.dims().end()));
+      tensor.ShareExternalPointer(
+          const_cast<char*>(db_->column_data(i, record_)),
+          DataTypeToTypeMeta(column.data_type()),
+          db_->record_bytes(i));
+      serializer.Serialize(
+          tensor, column.name(), protos.add_protos(), 0, tensor.size());
+    }
+    return protos.SerializeAsString();
+  }
+  bool Valid() override {
+    return record_ < db_->num_records();
+  }
+
+ private:
+  const ColumnarDB* db_;
+  int64_t record_;
+};
+
+class ColumnarTransaction : public Transaction {
+ public:
+  explicit ColumnarTransaction(ColumnarDB* db) : db_(db) {}
+  ~ColumnarTransaction() {
+    Commit();
+    db_->transaction_open_ = false;
+  }
+  void Put(const string& key, const string& value) override {
+    TensorProtos protos;
+    CAFFE_ENFORCE(
+        protos.ParseFromString(value),
+        "ColumnarDB values must be serialized TensorProtos.");
+    db_->CheckOrSetSchema(protos);
+    vector<TensorCPU> tensors(protos.protos_size());
+    TensorDeserializer<CPUContext> deserializer;
+    for (int i = 0; i < protos.protos_size(); ++i) {
+      deserializer.Deserialize(protos.protos(i), &tensors[i]);
+    }
+    db_->Append(key, tensors);
+  }
+  void Commit() override {
+    db_->Flush();
+  }
+
+ private:
+  ColumnarDB* db_;
+
+  DISABLE_COPY_AND_ASSIGN(ColumnarTransaction);
+};
+
+ColumnarDB::ColumnarDB(const string& source, Mode mode)
+    : DB(source, mode), source_(source) {
+  if (mode == READ) {
+    OpenForRead();
+  } else {
+    OpenForWrite();
+  }
+  LOG(INFO) << "Opened columnar db " << source << " with " << num_records_
+            << " records";
+}
+
+void ColumnarDB::OpenForRead() {
+  CAFFE_ENFORCE(
+      ReadProtoFromFile(source_ + "/" + kSchemaFile, &schema_),
+      "Cannot read the schema of columnar db ",
+      source_);
+  SetRecordBytes();
+  keys_map_.data = MapFile(source_ + "/" + kKeysFile, &keys_map_.size);
+  index_map_.data = MapFile(source_ + "/" + kIndexFile, &index_map_.size);
+  CAFFE_ENFORCE_GE(index_map_.size, sizeof(int64_t));
+  num_records_ = index_map_.size / sizeof(int64_t) - 1;
+  for (int i = 0; i < schema_.protos_size(); ++i) {
+    Mapping column;
+    column.data = MapFile(ColumnFile(source_, i), &column.size);
+    CAFFE_ENFORCE_EQ(
+        column.size,
+        record_bytes_[i] * num_records_,
+        "Column ",
+        i,
+        " of columnar db ",
+        source_,
+        " is truncated.");
+    column_maps_.push_back(column);
+  }
+  for (int64_t i = 1; i < num_records_ && keys_sorted_; ++i) {
+    keys_sorted_ = key(i - 1) <= key(i);
+  }
+}
+
+void ColumnarDB::OpenForWrite() {
+  if (mode_ == NEW) {
+    CAFFE_ENFORCE_EQ(
+        mkdir(source_.c_str(), 0744), 0, "mkdir ", source_, " failed");
+    index_.push_back(0);
+    keys_file_ = OpenOrDie(source_ + "/" + kKeysFile, "wb");
+    return;
+  }
+  // WRITE appends to an existing db.
+  CAFFE_ENFORCE(
+      ReadProtoFromFile(source_ + "/" + kSchemaFile, &schema_),
+      "Cannot read the schema of columnar db ",
+      source_);
+  SetRecordBytes();
+  const string index_path = source_ + "/" + kIndexFile;
+  index_.resize(FileSize(index_path) / sizeof(int64_t));
+  CAFFE_ENFORCE(!index_.empty());
+  FILE* index_file = OpenOrDie(index_path, "rb");
+  CAFFE_ENFORCE_EQ(
+      fread(index_.data(), sizeof(int64_t), index_.size(), index_file),
+      index_.size());
+  fclose(index_file);
+  num_records_ = index_.size() - 1;
+  keys_file_ = OpenOrDie(source_ + "/" + kKeysFile, "ab");
+  for (int i = 0; i < schema_.protos_size(); ++i) {
+    column_files_.push_back(OpenOrDie(ColumnFile(source_, i), "ab"));
+  }
+}
+
+void ColumnarDB::Unmap(Mapping* mapping) {
+  if (mapping->data) {
+    munmap(mapping->data, mapping->size);
+    mapping->data = nullptr;
+  }
+}
+
+void ColumnarDB::Close() {
+  if (closed_) {
+    return;
+  }
+  closed_ = true;
+  if (mode_ == READ) {
+    Unmap(&keys_map_);
+    Unmap(&index_map_);
+    for (auto& column : column_maps_) {
+      Unmap(&column);
+    }
+    return;
+  }
+  Flush();
+  fclose(keys_file_);
+  for (auto* file : column_files_) {
+    fclose(file);
+  }
+}
+
+unique_ptr<Cursor> ColumnarDB::NewCursor() {
+  CAFFE_ENFORCE_EQ(mode_, READ, "ColumnarDB can only be read in READ mode.");
+  return make_unique<ColumnarDBCursor>(this);
+}
+
+unique_ptr<Transaction> ColumnarDB::NewTransaction() {
+  CAFFE_ENFORCE_NE(mode_, READ, "ColumnarDB cannot be written in READ mode.");
+  CAFFE_ENFORCE(
+      !transaction_open_, "ColumnarDB supports one transaction at a time.");
+  transaction_open_ = true;
+  return make_unique<ColumnarTransaction>(this);
+}
+
+string ColumnarDB::key(int64_t record) const {
+  const int64_t* index = static_cast<const int64_t*>(index_map_.data);
+  return string(
+      static_cast<const char*>(keys_map_.data) + index[record],
+      index[record + 1] - index[record]);
+}
+
+const char* ColumnarDB::column_data(int column, int64_t record) const {
+  return static_cast<const char*>(column_maps_[column].data) +
+      record * record_bytes_[column];
+}
+
+void ColumnarDB::ReadBatch(
+    int64_t record,
+    int64_t count,
+    const vector<TensorCPU*>& tensors) const {
+  CAFFE_ENFORCE_EQ(tensors.size(), schema_.protos_size());
+  CAFFE_ENFORCE_LE(record + count, num_records_);
+  for (int i = 0; i < schema_.protos_size(); ++i) {
+    const auto& column = schema_.protos(i);
+    vector<TIndex> dims{count};
+    dims.insert(dims.end(), column.dims().begin(), column.dims().end());
+    tensors[i]->Resize(dims);
+    void* dst =
+        tensors[i]->raw_mutable_data(DataTypeToTypeMeta(column.data_type()));
+    if (count) {
+      memcpy(dst, column_data(i, record), count * record_bytes_[i]);
+    }
+  }
+}
+
+void ColumnarDB::CheckOrSetSchema(const TensorProtos& protos) {
+  if (schema_.protos_size() == 0 && num_records_ == 0) {
+    for (const auto& proto : protos.protos()) {
+      CAFFE_ENFORCE(
+          proto.data_type() != TensorProto::STRING &&
+              proto.data_type() != TensorProto::UNDEFINED,
+          "ColumnarDB only stores tensors with a fixed item size, ",
+          proto.name(),
+          " is not one.");
+      auto* column = schema_.add_protos();
+      column->set_name(proto.name());
+      column->set_data_type(proto.data_type());
+      *column->mutable_dims() = proto.dims();
+      column_files_.push_back(
+          OpenOrDie(ColumnFile(source_, schema_.protos_size() - 1), "wb"));
+    }
+    SetRecordBytes();
+  }
+  CAFFE_ENFORCE_EQ(
+      protos.protos_size(),
+      schema_.protos_size(),
+      "All records of a ColumnarDB must have the same number of tensors.");
+  for (int i = 0; i < protos.protos_size(); ++i) {
+    const auto& proto = protos.protos(i);
+    const auto& column = schema_.protos(i);
+    CAFFE_ENFORCE_EQ(
+        proto.data_type(),
+        column.data_type(),
+        "Tensor ",
+        i,
+        " does not match the type of the first record.");
+    CAFFE_ENFORCE(
+        proto.dims_size() == column.dims_size() &&
+            std::equal(
+                proto.dims().begin(),
+                proto.dims().end(),
+                column.dims().begin()),
+        "Tensor ",
+        i,
+        " does not match the shape of the first record.");
+  }
+}
+
+void ColumnarDB::SetRecordBytes() {
+  record_bytes_.clear();
+  for (const auto& column : schema_.protos()) {
+    size_t bytes = DataTypeToTypeMeta(column.data_type()).itemsize();
+    for (const auto d : column.dims()) {
+      bytes *= d;
+    }
+    record_bytes_.push_back(bytes);
+  }
+}
+
+void ColumnarDB::Append(const string& key, const vector<TensorCPU>& tensors) {
+  WriteOrDie(keys_file_, key.data(), key.size());
+  index_.push_back(index_.back() + key.size());
+  for (int i = 0; i < tensors.size(); ++i) {
+    CAFFE_ENFORCE_EQ(tensors[i].nbytes(), record_bytes_[i]);
+    WriteOrDie(column_files_[i], tensors[i].raw_data(), record_bytes_[i]);
+  }
+  ++num_records_;
+}
+
+void ColumnarDB::Flush() {
+  fflush(keys_file_);
+  for (auto* file : column_files_) {
+    fflush(file);
+  }
+  // The schema and index are small next to the data and are replaced as a
+  // whole, so a reader never sees records whose data has not been flushed.
+  const string schema = schema_.SerializeAsString();
+  ReplaceFileOrDie(source_ + "/" + kSchemaFile, schema.data(), schema.size());
+  ReplaceFileOrDie(
+      source_ + "/" + kIndexFile,
+      index_.data(),
+      index_.size() * sizeof(int64_t));
+}
+
+REGISTER_CAFFE2_DB(ColumnarDB, ColumnarDB);
+REGISTER_CAFFE2_DB(columnar, ColumnarDB);
+
+} // namespace db
+} // namespace caffe2
@@ -0,0 +1,120 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_DB_COLUMNAR_DB_H_
+#define CAFFE2_DB_COLUMNAR_DB_H_
+
+#include <cstdio>
+
+#include "caffe2/core/db.h"
+#include "caffe2/core/tensor.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+namespace db {
+
+/**
+ * A db of fixed-schema TensorProtos records, stored column by column in
+ * memory-mapped files: every record has the same number of tensors, and
+ * tensor i of every record has the same data type and dims. The db is a
+ * directory with
+ *   schema    a TensorProtos with the name, data type and dims of each column
+ *   keys      the keys of all records, back to back
+ *   index     num_records + 1 int64 offsets of the keys into keys
+ *   column_i  the data of tensor i of all records, back to back
+ *
+ * Through the Cursor interface values are read back as serialized
+ * TensorProtos, so that the existing readers work unchanged. Readers that
+ * know the db is columnar can skip the parse altogether: column_data()
+ * points into the mapped column, and ReadBatch() fills a batch of every
+ * column with a single memcpy.
+ *
+ * Only types with a fixed item size can be stored, so no strings.
+ */
+class ColumnarDB : public DB {
+ public:
+  ColumnarDB(const string& source, Mode mode);
+  ~ColumnarDB() override {
+    Close();
+  }
+
+  void Close() override;
+  unique_ptr<Cursor> NewCursor() override;
+  unique_ptr<Transaction> NewTransaction() override;
+
+  // The functions below are only available in READ mode.
+  int64_t num_records() const {
+    return num_records_;
+  }
+  const TensorProtos& schema() const {
+    return schema_;
+  }
+  string key(int64_t record) const;
+  // Returns the data of column `column` of record `record`, which is
+  // record_bytes(column) long and directly followed by the next record.
+  const char* column_data(int column, int64_t record) const;
+  size_t record_bytes(int column) const {
+    return record_bytes_[column];
+  }
+  bool keys_sorted() const {
+    return keys_sorted_;
+  }
+  // Resizes tensors[i] to [count, dims of column i] and copies records
+  // [record, record + count) of column i into it.
+  void ReadBatch(
+      int64_t record,
+      int64_t count,
+      const vector<TensorCPU*>& tensors) const;
+
+ private:
+  friend class ColumnarTransaction;
+
+  struct Mapping {
+    void* data = nullptr;
+    size_t size = 0;
+  };
+
+  void OpenForRead();
+  void OpenForWrite();
+  // Sets the schema from the first record written, or checks that record
+  // matches it.
+  void CheckOrSetSchema(const TensorProtos& protos);
+  void SetRecordBytes();
+  void Append(const string& key, const vector<TensorCPU>& tensors);
+  void Flush();
+  static void Unmap(Mapping* mapping);
+
+  string source_;
+  TensorProtos schema_;
+  vector<size_t> record_bytes_;
+  int64_t num_records_ = 0;
+  // Read mode.
+  bool keys_sorted_ = true;
+  Mapping keys_map_;
+  Mapping index_map_;
+  vector<Mapping> column_maps_;
+  // Write mode.
+  vector<int64_t> index_;
+  FILE* keys_file_ = nullptr;
+  vector<FILE*> column_files_;
+  bool transaction_open_ = false;
+  bool closed_ = false;
+};
+
+} // namespace db
+} // namespace caffe2
+
+#endif // CAFFE2_DB_COLUMNAR_DB_H_
@@ -25,6 +25,10 @@
 #include "caffe2/proto/caffe2.pb.h"
 #include <gtest/gtest.h>
 
+#ifndef _WIN32
+#include "caffe2/db/columnar_db.h"
+#endif
+
 namespace caffe2 {
 namespace db {
 
@@ -54,6 +58,8 @@ static void TestCursor(Cursor* cursor) {
   cursor->SeekToFirst();
   EXPECT_EQ(cursor->key(), "00");
   EXPECT_EQ(cursor->value(), "00");
+  const auto view = cursor->value_view();
+  EXPECT_EQ(string(view.data, view.size), "00");
   // Test if Next() works.
   cursor->Next();
   EXPECT_EQ(cursor->key(), "01");
@@ -102,6 +108,24 @@ TEST(DBSeekTest, LMDB) {
   DBSeekTestWrapper("lmdb");
 }
 
+TEST(PrefetchingCursorTest, LevelDB) {
+  std::string name = std::tmpnam(nullptr);
+  CreateAndFill("leveldb", name);
+  std::unique_ptr<DB> db(CreateDB("leveldb", name, READ));
+  // A depth smaller than the db so the read ahead has to block.
+  PrefetchingCursor cursor(db->NewCursor(), 3);
+  TestCursor(&cursor);
+  cursor.SeekToFirst();
+  int count = 0;
+  for (; cursor.Valid(); cursor.Next()) {
+    std::stringstream ss;
+    ss << std::setw(2) << std::setfill('0') << count++;
+    EXPECT_EQ(cursor.key(), ss.str());
+    EXPECT_EQ(cursor.value(), ss.str());
+  }
+  EXPECT_EQ(count, kMaxItems);
+}
+
 TEST(DBReaderTest, Reader) {
   std::string name = std::tmpnam(nullptr);
   CreateAndFill("leveldb", name);
@@ -120,6 +144,11 @@ TEST(DBReaderTest, Reader) {
   reader->Read(&key, &value);
   EXPECT_EQ(key, "06");
   EXPECT_EQ(value, "06");
+  reader->ReadView(&key, [&value](const char* data, size_t size) {
+    value.assign(data, size);
+  });
+  EXPECT_EQ(key, "07");
+  EXPECT_EQ(value, "07");
 
   // Test if we are able to serialize it using the blob serialization
   // interface.
@@ -167,6 +196,41 @@ TEST(DBReaderTest, Reader) {
   EXPECT_EQ(keys_set.size(), kMaxItems);
 }
 
+TEST(DBReaderTest, ParallelReader) {
+  std::string name = std::tmpnam(nullptr);
+  CreateAndFill("leveldb", name);
+  // Three segments, [00, 03), [03, 06) and [06, 10), interleaved; the last
+  // record of the longer segment comes alone at the end of the epoch.
+  const vector<string> expected = {
+      "00", "03", "06", "01", "04", "07", "02", "05", "08", "09"};
+  DBReader reader("leveldb", name, 1, 0, 3);
+  string key;
+  string value;
+  for (int restart = 0; restart < 2; ++restart) {
+    // Consecutive epochs repeat the same permutation of the records.
+    for (int epoch = 0; epoch < 2; ++epoch) {
+      std::set<string> keys_set;
+      for (const auto& expected_key : expected) {
+        reader.Read(&key, &value);
+        EXPECT_EQ(key, expected_key);
+        EXPECT_EQ(value, expected_key);
+        keys_set.insert(key);
+      }
+      EXPECT_EQ(keys_set.size(), kMaxItems);
+    }
+    reader.SeekToFirst();
+  }
+  // Shards take every num_shards-th record of the interleaved order.
+  DBReader shard_reader("leveldb", name, 2, 1, 3);
+  for (int i = 1; i < 2 * expected.size(); i += 2) {
+    shard_reader.ReadView(&key, [&value](const char* data, size_t size) {
+      value.assign(data, size);
+    });
+    EXPECT_EQ(key, expected[i % expected.size()]);
+    EXPECT_EQ(value, expected[i % expected.size()]);
+  }
+}
+
 TEST(DBReaderShardedTest, Reader) {
   std::string name = std::tmpnam(nullptr);
   CreateAndFill("leveldb", name);
@@ -212,5 +276,68 @@ TEST(DBReaderShardedTest, Reader) {
   EXPECT_EQ(value, "05");
 }
 
+#ifndef _WIN32
+TEST(ColumnarDBTest, RoundTrip) {
+  std::string name = std::tmpnam(nullptr);
+  {
+    std::unique_ptr<DB> db(CreateDB("columnar", name, NEW));
+    ASSERT_TRUE(db.get() != nullptr);
+    std::unique_ptr<Transaction> trans(db->NewTransaction());
+    TensorSerializer<CPUContext> serializer;
+    for (int i = 0; i < kMaxItems; ++i) {
+      TensorCPU data(vector<TIndex>{2, 3});
+      TensorCPU label(vector<TIndex>{1});
+      for (int j = 0; j < data.size(); ++j) {
+        data.mutable_data<float>()[j] = i * 10 + j;
+      }
+      label.mutable_data<int>()[0] = i;
+      TensorProtos protos;
+      serializer.Serialize(data, "data", protos.add_protos(), 0, data.size());
+      serializer.Serialize(label, "label", protos.add_protos(), 0, 1);
+      std::stringstream ss;
+      ss << std::setw(2) << std::setfill('0') << i;
+      trans->Put(ss.str(), protos.SerializeAsString());
+    }
+    trans->Commit();
+  }
+  std::unique_ptr<DB> db(CreateDB("columnar", name, READ));
+  auto* columnar = dynamic_cast<ColumnarDB*>(db.get());
+  ASSERT_TRUE(columnar != nullptr);
+  EXPECT_EQ(columnar->num_records(), kMaxItems);
+  EXPECT_EQ(columnar->record_bytes(0), 6 * sizeof(float));
+  EXPECT_EQ(columnar->key(3), "03");
+
+  // The cursor returns the TensorProtos that were written.
+  std::unique_ptr<Cursor> cursor(db->NewCursor());
+  EXPECT_TRUE(cursor->SupportsSeek());
+  cursor->Seek("05");
+  EXPECT_EQ(cursor->key(), "05");
+  TensorProtos protos;
+  EXPECT_TRUE(protos.ParseFromString(cursor->value()));
+  EXPECT_EQ(protos.protos_size(), 2);
+  EXPECT_EQ(protos.protos(0).name(), "data");
+  EXPECT_EQ(protos.protos(0).float_data(4), 54);
+  EXPECT_EQ(protos.protos(1).int32_data(0), 5);
+
+  // ReadBatch copies whole rows of every column.
+  TensorCPU data;
+  TensorCPU label;
+  columnar->ReadBatch(2, 4, {&data, &label});
+  EXPECT_EQ(data.dims(), (vector<TIndex>{4, 2, 3}));
+  EXPECT_EQ(data.data<float>()[6], 30);
+  EXPECT_EQ(label.data<int>()[3], 5);
+
+  // Records must keep the schema of the first one.
+  db.reset(CreateDB("columnar", name, WRITE).release());
+  std::unique_ptr<Transaction> trans(db->NewTransaction());
+  TensorCPU other(vector<TIndex>{3});
+  other.mutable_data<float>();
+  TensorSerializer<CPUContext> serializer;
+  protos.Clear();
+  serializer.Serialize(other, "data", protos.add_protos(), 0, 3);
+  EXPECT_THROW(trans->Put("10", protos.SerializeAsString()), EnforceNotMet);
+}
+#endif // _WIN32
+
 }  // namespace db
 }  // namespace caffe2
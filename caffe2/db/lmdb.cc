@@ -30,6 +30,7 @@
 namespace caffe2 {
 namespace db {
 
+// Initial size of the map, transactions double it when they need more.
 constexpr size_t LMDB_MAP_SIZE = 1099511627776;  // 1 TB
 
 inline void MDB_CHECK(int mdb_status) {
@@ -84,6 +85,12 @@ class LMDBCursor : public Cursor {
         mdb_value_.mv_size);
   }
 
+  // Points into the memory map, which stays valid for the read transaction.
+  ValueView value_view() override {
+    return ValueView{static_cast<const char*>(mdb_value_.mv_data),
+                     mdb_value_.mv_size};
+  }
+
   bool Valid() override { return valid_; }
 
  private:
@@ -105,30 +112,26 @@ class LMDBCursor : public Cursor {
   bool valid_;
 };
 
+// The writes are kept until Commit(), which makes them in one transaction.
+// When they don't fit in the map of the environment, the map is doubled and
+// the transaction made again, so dbs can grow past LMDB_MAP_SIZE.
 class LMDBTransaction final : public Transaction {
  public:
   explicit LMDBTransaction(MDB_env* mdb_env)
-      : mdb_env_(mdb_env) {
-    MDB_CHECK(mdb_txn_begin(mdb_env_, NULL, 0, &mdb_txn_));
-    MDB_CHECK(mdb_dbi_open(mdb_txn_, NULL, 0, &mdb_dbi_));
-  }
+      : mdb_env_(mdb_env) {}
   ~LMDBTransaction() {
-    MDB_CHECK(mdb_txn_commit(mdb_txn_));
-    mdb_dbi_close(mdb_env_, mdb_dbi_);
+    Commit();
   }
-  void Put(const string& key, const string& value) override;
-  void Commit() override {
-    MDB_CHECK(mdb_txn_commit(mdb_txn_));
-    mdb_dbi_close(mdb_env_, mdb_dbi_);
-    // Begin a new transaction.
-    MDB_CHECK(mdb_txn_begin(mdb_env_, NULL, 0, &mdb_txn_));
-    MDB_CHECK(mdb_dbi_open(mdb_txn_, NULL, 0, &mdb_dbi_));
+  void Put(const string& key, const string& value) override {
+    keys_.push_back(key);
+    values_.push_back(value);
   }
+  void Commit() override;
 
  private:
   MDB_env* mdb_env_;
-  MDB_dbi mdb_dbi_;
-  MDB_txn* mdb_txn_;
+  vector<string> keys_;
+  vector<string> values_;
 
   DISABLE_COPY_AND_ASSIGN(LMDBTransaction);
 };
@@ -173,13 +176,45 @@ LMDB::LMDB(const string& source, Mode mode) : DB(source, mode) {
   VLOG(1) << "Opened lmdb " << source;
 }
 
-void LMDBTransaction::Put(const string& key, const string& value) {
-  MDB_val mdb_key, mdb_value;
-  mdb_key.mv_data = const_cast<char*>(key.data());
-  mdb_key.mv_size = key.size();
-  mdb_value.mv_data = const_cast<char*>(value.data());
-  mdb_value.mv_size = value.size();
-  MDB_CHECK(mdb_put(mdb_txn_, mdb_dbi_, &mdb_key, &mdb_value, 0));
+void LMDBTransaction::Commit() {
+  if (keys_.empty()) {
+    return;
+  }
+  while (true) {
+    MDB_txn* mdb_txn;
+    MDB_dbi mdb_dbi;
+    MDB_CHECK(mdb_txn_begin(mdb_env_, NULL, 0, &mdb_txn));
+    MDB_CHECK(mdb_dbi_open(mdb_txn, NULL, 0, &mdb_dbi));
+    int mdb_status = MDB_SUCCESS;
+    for (size_t i = 0; i < keys_.size() && mdb_status == MDB_SUCCESS; ++i) {
+      MDB_val mdb_key, mdb_value;
+      mdb_key.mv_data = const_cast<char*>(keys_[i].data());
+      mdb_key.mv_size = keys_[i].size();
+      mdb_value.mv_data = const_cast<char*>(values_[i].data());
+      mdb_value.mv_size = values_[i].size();
+      mdb_status = mdb_put(mdb_txn, mdb_dbi, &mdb_key, &mdb_value, 0);
+    }
+    if (mdb_status == MDB_SUCCESS) {
+      // The transaction is freed whether or not the commit succeeds.
+      mdb_status = mdb_txn_commit(mdb_txn);
+    } else {
+      mdb_txn_abort(mdb_txn);
+    }
+    mdb_dbi_close(mdb_env_, mdb_dbi);
+    if (mdb_status != MDB_MAP_FULL) {
+      MDB_CHECK(mdb_status);
+      break;
+    }
+    // No transaction of the environment is open here, as the map can only
+    // be resized then.
+    MDB_envinfo mdb_info;
+    MDB_CHECK(mdb_env_info(mdb_env_, &mdb_info));
+    const size_t map_size = mdb_info.me_mapsize * 2;
+    LOG(INFO) << "Growing the lmdb map to " << map_size << " bytes";
+    MDB_CHECK(mdb_env_set_mapsize(mdb_env_, map_size));
+  }
+  keys_.clear();
+  values_.clear();
 }
 
 REGISTER_CAFFE2_DB(LMDB, LMDB);
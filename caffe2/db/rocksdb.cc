@@ -39,6 +39,10 @@ class RocksDBCursor : public Cursor {
   void Next() override { iter_->Next(); }
   string key() override { return iter_->key().ToString(); }
   string value() override { return iter_->value().ToString(); }
+  ValueView value_view() override {
+    const auto value = iter_->value();
+    return ValueView{value.data(), value.size()};
+  }
   bool Valid() override { return iter_->Valid(); }
 
  private:
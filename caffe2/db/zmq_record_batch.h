@@ -0,0 +1,176 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_DB_ZMQ_RECORD_BATCH_H_
+#define CAFFE2_DB_ZMQ_RECORD_BATCH_H_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "caffe2/core/db.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/macros.h"
+
+#ifdef CAFFE2_USE_SNAPPY
+#include <snappy.h>
+#endif
+
+namespace caffe2 {
+namespace db {
+
+/**
+ * The wire format of the record batches zmq_feeder sends to ZmqDB.
+ *
+ * A batch is a two part ZeroMQ message: a ZmqRecordBatchHeader, then the
+ * payload, made of the key and value sizes of every record as uint32 pairs,
+ * followed by the keys and values themselves, key0 value0 key1 value1 ...
+ * The payload may be compressed with Snappy as a whole.
+ *
+ * The header starts with a NUL byte, so that ZmqDB can tell it from the key
+ * of the one record per message format older feeders send.
+ */
+struct ZmqRecordBatchHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t num_records;
+  uint32_t flags;
+  // Size of the payload before compression.
+  uint64_t payload_bytes;
+};
+
+constexpr char kZmqRecordBatchMagic[4] = {'\0', 'C', '2', 'B'};
+constexpr uint32_t kZmqRecordBatchVersion = 1;
+constexpr uint32_t kZmqRecordBatchSnappy = 1;
+
+inline bool IsZmqRecordBatchHeader(const void* data, size_t size) {
+  return size == sizeof(ZmqRecordBatchHeader) &&
+      std::memcmp(data, kZmqRecordBatchMagic, sizeof(kZmqRecordBatchMagic)) ==
+      0;
+}
+
+inline bool ZmqRecordBatchCompressionAvailable() {
+#ifdef CAFFE2_USE_SNAPPY
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Accumulates records and builds the two parts of a batch message.
+ */
+class ZmqRecordBatchWriter {
+ public:
+  void Add(const char* key, size_t key_size, const ValueView& value) {
+    sizes_.push_back(key_size);
+    sizes_.push_back(value.size);
+    data_.append(key, key_size);
+    data_.append(value.data, value.size);
+  }
+
+  size_t size() const {
+    return sizes_.size() / 2;
+  }
+
+  // Writes the header and the payload of the batch, and clears the writer.
+  void Finish(bool compress, std::string* header, std::string* payload) {
+    ZmqRecordBatchHeader h;
+    std::memcpy(h.magic, kZmqRecordBatchMagic, sizeof(h.magic));
+    h.version = kZmqRecordBatchVersion;
+    h.num_records = size();
+    h.flags = 0;
+    std::string raw;
+    raw.reserve(sizes_.size() * sizeof(uint32_t) + data_.size());
+    raw.append(
+        reinterpret_cast<const char*>(sizes_.data()),
+        sizes_.size() * sizeof(uint32_t));
+    raw.append(data_);
+    h.payload_bytes = raw.size();
+    if (compress) {
+#ifdef CAFFE2_USE_SNAPPY
+      h.flags |= kZmqRecordBatchSnappy;
+      snappy::Compress(raw.data(), raw.size(), payload);
+#else
+      CAFFE_THROW("Caffe2 was built without Snappy, cannot compress batches.");
+#endif
+    } else {
+      payload->swap(raw);
+    }
+    header->assign(reinterpret_cast<const char*>(&h), sizeof(h));
+    sizes_.clear();
+    data_.clear();
+  }
+
+ private:
+  std::vector<uint32_t> sizes_;
+  std::string data_;
+};
+
+/**
+ * Parses the payload of a batch. If it is compressed, it is decompressed into
+ * buffer. The keys and values then point into the payload or buffer, without
+ * copies.
+ */
+inline void ParseZmqRecordBatch(
+    const void* header_data,
+    const char* payload,
+    size_t payload_size,
+    std::string* buffer,
+    std::vector<ValueView>* keys,
+    std::vector<ValueView>* values) {
+  ZmqRecordBatchHeader header;
+  std::memcpy(&header, header_data, sizeof(header));
+  CAFFE_ENFORCE_EQ(
+      header.version,
+      kZmqRecordBatchVersion,
+      "Unsupported ZmqDB record batch version");
+  if (header.flags & kZmqRecordBatchSnappy) {
+#ifdef CAFFE2_USE_SNAPPY
+    CAFFE_ENFORCE(
+        snappy::Uncompress(payload, payload_size, buffer),
+        "Corrupted ZmqDB record batch");
+    payload = buffer->data();
+    payload_size = buffer->size();
+#else
+    CAFFE_THROW("Caffe2 was built without Snappy, cannot read the batch.");
+#endif
+  }
+  CAFFE_ENFORCE_EQ(payload_size, header.payload_bytes);
+  const size_t index_bytes = 2 * sizeof(uint32_t) * header.num_records;
+  CAFFE_ENFORCE_LE(index_bytes, payload_size);
+  std::vector<uint32_t> sizes(2 * header.num_records);
+  std::memcpy(sizes.data(), payload, index_bytes);
+  size_t offset = index_bytes;
+  keys->clear();
+  values->clear();
+  for (uint32_t i = 0; i < header.num_records; ++i) {
+    CAFFE_ENFORCE_LE(
+        offset + sizes[2 * i] + sizes[2 * i + 1],
+        payload_size,
+        "Truncated ZmqDB record batch");
+    keys->push_back(ValueView{payload + offset, sizes[2 * i]});
+    offset += sizes[2 * i];
+    values->push_back(ValueView{payload + offset, sizes[2 * i + 1]});
+    offset += sizes[2 * i + 1];
+  }
+}
+
+} // namespace db
+} // namespace caffe2
+
+#endif // CAFFE2_DB_ZMQ_RECORD_BATCH_H_
@@ -16,36 +16,72 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <thread>  // NOLINT
+#include <vector>
 
 #include "caffe2/core/db.h"
-#include "caffe2/utils/zmq_helper.h"
+#include "caffe2/core/flags.h"
 #include "caffe2/core/logging.h"
+#include "caffe2/db/zmq_record_batch.h"
+#include "caffe2/utils/string_utils.h"
+#include "caffe2/utils/zmq_helper.h"
+
+CAFFE2_DEFINE_int(
+    caffe2_zmqdb_prefetch_messages,
+    4,
+    "Number of messages every ZmqDB connection receives ahead of the "
+    "cursor.");
 
 namespace caffe2 {
 namespace db {
 
+// The source of a ZmqDB is a comma separated list of feeder addresses. The
+// cursor receives from every one of them on its own thread, so that several
+// feeders (or a feeder bound to several addresses) can fill it in parallel,
+// and the records are consumed in the order their messages arrive.
+//
+// Messages are either record batches (see zmq_record_batch.h), or a key and
+// a value as sent by one record per message feeders. The received message
+// buffers are kept while their records are read, and value_view() points
+// into them (or into the decompressed payload) without a copy.
 class ZmqDBCursor : public Cursor {
  public:
   explicit ZmqDBCursor(const string& source)
-      : source_(source), socket_(ZMQ_PULL),
-        prefetched_(false), finalize_(false) {
-    socket_.Connect(source_);
-    // Start prefetching thread.
-    prefetch_thread_.reset(
-        new std::thread([this] { this->Prefetch(); }));
+      : sources_(split(',', source)),
+        capacity_(
+            std::max(1, FLAGS_caffe2_zmqdb_prefetch_messages) *
+            std::max<size_t>(sources_.size(), 1)),
+        finalize_(false) {
+    CAFFE_ENFORCE(!sources_.empty(), "ZmqDB needs at least one address.");
+    for (const auto& address : sources_) {
+      sockets_.emplace_back(new ZmqSocket(ZMQ_PULL));
+      // Wake up regularly to check for finalize_.
+      sockets_.back()->SetOption(ZMQ_RCVTIMEO, 100);
+      sockets_.back()->Connect(address);
+    }
+    for (int i = 0; i < sockets_.size(); ++i) {
+      receive_threads_.emplace_back([this, i] { this->Receive(i); });
+    }
     // obtain the first value.
     Next();
   }
 
   ~ZmqDBCursor() {
-    finalize_ = true;
-    prefetched_ = false;
-    producer_.notify_one();
-    // Wait for the prefetch thread to finish elegantly.
-    prefetch_thread_->join();
-    socket_.Disconnect(source_);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      finalize_ = true;
+    }
+    producer_.notify_all();
+    // Wait for the receiving threads to finish elegantly.
+    for (auto& thread : receive_threads_) {
+      thread.join();
+    }
+    for (int i = 0; i < sockets_.size(); ++i) {
+      sockets_[i]->Disconnect(sources_[i]);
+    }
   }
 
   void Seek(const string& /*key*/) override { /* do nothing */
@@ -54,49 +90,99 @@ class ZmqDBCursor : public Cursor {
   void SeekToFirst() override { /* do nothing */ }
 
   void Next() override {
-    std::unique_lock<std::mutex> lock(prefetch_access_mutex_);
-    while (!prefetched_) consumer_.wait(lock);
-    key_ = prefetch_key_;
-    value_ = prefetch_value_;
-    prefetched_ = false;
+    if (current_ && ++index_ < current_->keys.size()) {
+      return;
+    }
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      consumer_.wait(lock, [this] { return !messages_.empty(); });
+      current_ = std::move(messages_.front());
+      messages_.pop_front();
+    }
     producer_.notify_one();
+    index_ = 0;
   }
 
-  string key() override { return key_; }
-  string value() override { return value_; }
+  string key() override {
+    const auto& key = current_->keys[index_];
+    return string(key.data, key.size);
+  }
+  string value() override {
+    const auto& value = current_->values[index_];
+    return string(value.data, value.size);
+  }
+  ValueView value_view() override {
+    return current_->values[index_];
+  }
   bool Valid() override { return true; }
 
  private:
-
-  void Prefetch() {
+  struct Message {
+    std::unique_ptr<ZmqMessage> parts[2];
+    // The decompressed payload of a compressed batch.
+    string buffer;
+    std::vector<ValueView> keys;
+    std::vector<ValueView> values;
+  };
+
+  void Receive(int connection) {
+    auto& socket = *sockets_[connection];
     while (!finalize_) {
-      std::unique_lock<std::mutex> lock(prefetch_access_mutex_);
-      while (prefetched_) producer_.wait(lock);
-      if (finalize_) {
-        return;
+      std::unique_ptr<Message> message(new Message());
+      message->parts[0].reset(new ZmqMessage());
+      if (!socket.Recv(message->parts[0].get())) {
+        // Timed out.
+        continue;
+      }
+      // The parts of a ZeroMQ message arrive together.
+      message->parts[1].reset(new ZmqMessage());
+      socket.RecvTillSuccess(message->parts[1].get());
+      auto& header = *message->parts[0];
+      auto& payload = *message->parts[1];
+      if (IsZmqRecordBatchHeader(header.data(), header.size())) {
+        ParseZmqRecordBatch(
+            header.data(),
+            static_cast<const char*>(payload.data()),
+            payload.size(),
+            &message->buffer,
+            &message->keys,
+            &message->values);
+        if (message->keys.empty()) {
+          continue;
+        }
+      } else {
+        message->keys.push_back(
+            ValueView{static_cast<const char*>(header.data()), header.size()});
+        message->values.push_back(ValueView{
+            static_cast<const char*>(payload.data()), payload.size()});
+      }
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        producer_.wait(lock, [this] {
+          return messages_.size() < capacity_ || finalize_;
+        });
+        if (finalize_) {
+          return;
+        }
+        messages_.push_back(std::move(message));
       }
-      ZmqMessage msg;
-      socket_.RecvTillSuccess(&msg);
-      prefetch_key_.assign(static_cast<char*>(msg.data()), msg.size());
-      socket_.RecvTillSuccess(&msg);
-      prefetch_value_.assign(static_cast<char*>(msg.data()), msg.size());
-      prefetched_ = true;
       consumer_.notify_one();
     }
   }
 
-  string source_;
-  ZmqSocket socket_;
-  string key_;
-  string value_;
-  string prefetch_key_;
-  string prefetch_value_;
-
-  unique_ptr<std::thread> prefetch_thread_;
-  std::mutex prefetch_access_mutex_;
+  const std::vector<string> sources_;
+  const size_t capacity_;
+  std::vector<std::unique_ptr<ZmqSocket>> sockets_;
+  std::vector<std::thread> receive_threads_;
+
+  // The message whose records are being read, and the current record.
+  std::unique_ptr<Message> current_;
+  size_t index_ = 0;
+
+  std::mutex mutex_;
   std::condition_variable producer_, consumer_;
-  std::atomic<bool> prefetched_;
-  // finalize_ is used to tell the prefetcher to quit.
+  std::deque<std::unique_ptr<Message>> messages_;
+  // finalize_ is used to tell the receiving threads to quit.
   std::atomic<bool> finalize_;
 };
 
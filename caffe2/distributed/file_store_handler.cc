@@ -23,6 +23,13 @@
 #include <stdlib.h>
 #include <sys/stat.h>
 
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif // defined(__linux__)
+
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <iostream>
@@ -89,6 +96,18 @@ std::string FileStoreHandler::objectPath(const std::string& name) {
   return basePath_ + "/" + encodeName(name);
 }
 
+bool FileStoreHandler::exists(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    // Only deal with files that don't exist.
+    // Anything else is a problem.
+    CHECK_EQ(errno, ENOENT);
+    return false;
+  }
+  close(fd);
+  return true;
+}
+
 void FileStoreHandler::set(const std::string& name, const std::string& data) {
   auto tmp = tmpPath(name);
   auto path = objectPath(name);
@@ -105,9 +124,20 @@ void FileStoreHandler::set(const std::string& name, const std::string& data) {
   // Atomically movve result to final location
   auto rv = rename(tmp.c_str(), path.c_str());
   CAFFE_ENFORCE_EQ(rv, 0, "rename: ", strerror(errno));
+
+  std::lock_guard<std::mutex> guard(cacheMutex_);
+  cache_[name] = data;
 }
 
 std::string FileStoreHandler::get(const std::string& name) {
+  {
+    std::lock_guard<std::mutex> guard(cacheMutex_);
+    auto it = cache_.find(name);
+    if (it != cache_.end()) {
+      return it->second;
+    }
+  }
+
   auto path = objectPath(name);
   std::string result;
 
@@ -124,6 +154,9 @@ std::string FileStoreHandler::get(const std::string& name) {
   result.resize(n);
   ifs.seekg(0);
   ifs.read(&result[0], n);
+
+  std::lock_guard<std::mutex> guard(cacheMutex_);
+  cache_[name] = result;
   return result;
 }
 
@@ -141,17 +174,10 @@ bool FileStoreHandler::check(const std::vector<std::string>& names) {
   }
 
   for (const auto& path : paths) {
-    int fd = open(path.c_str(), O_RDONLY);
-    if (fd == -1) {
-      // Only deal with files that don't exist.
-      // Anything else is a problem.
-      CHECK_EQ(errno, ENOENT);
-
+    if (!exists(path)) {
       // One of the paths doesn't exist; return early
       return false;
     }
-
-    close(fd);
   }
 
   return true;
@@ -160,17 +186,67 @@ bool FileStoreHandler::check(const std::vector<std::string>& names) {
 void FileStoreHandler::wait(
     const std::vector<std::string>& names,
     const std::chrono::milliseconds& timeout) {
-  // Not using inotify because it doesn't work on many
-  // shared filesystems (such as NFS).
+  std::vector<std::string> paths;
+  {
+    std::lock_guard<std::mutex> guard(cacheMutex_);
+    for (const auto& name : names) {
+      if (cache_.find(name) == cache_.end()) {
+        paths.push_back(objectPath(name));
+      }
+    }
+  }
+
+  // inotify is only used to wake up early: it doesn't work on many shared
+  // filesystems (such as NFS), so the files are still polled. Only the ones
+  // that are still missing are checked again.
+  int notifyFd = -1;
+#if defined(__linux__)
+  notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (notifyFd != -1 &&
+      inotify_add_watch(
+          notifyFd, basePath_.c_str(), IN_MOVED_TO | IN_CREATE) == -1) {
+    close(notifyFd);
+    notifyFd = -1;
+  }
+#endif // defined(__linux__)
+
   const auto start = std::chrono::steady_clock::now();
-  while (!check(names)) {
+  while (true) {
+    paths.erase(
+        std::remove_if(
+            paths.begin(),
+            paths.end(),
+            [this](const std::string& path) { return exists(path); }),
+        paths.end());
+    if (paths.empty()) {
+      break;
+    }
     const auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
         std::chrono::steady_clock::now() - start);
     if (timeout != kNoTimeout && elapsed > timeout) {
+      if (notifyFd != -1) {
+        close(notifyFd);
+      }
       STORE_HANDLER_TIMEOUT("Wait timeout for name(s): ", Join(" ", names));
     }
+#if defined(__linux__)
+    if (notifyFd != -1) {
+      struct pollfd pfd = {notifyFd, POLLIN, 0};
+      if (poll(&pfd, 1, 10) > 0) {
+        // Drain the events, all that matters is that something changed.
+        std::array<char, 4096> events;
+        while (read(notifyFd, events.data(), events.size()) > 0) {
+        }
+      }
+      continue;
+    }
+#endif // defined(__linux__)
     /* sleep override */
     std::this_thread::sleep_for(std::chrono::milliseconds(10));
   }
+
+  if (notifyFd != -1) {
+    close(notifyFd);
+  }
 }
 }
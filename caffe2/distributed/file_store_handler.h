@@ -18,6 +18,9 @@
 
 #include <caffe2/distributed/store_handler.h>
 
+#include <mutex>
+#include <unordered_map>
+
 namespace caffe2 {
 
 class FileStoreHandler : public StoreHandler {
@@ -40,11 +43,17 @@ class FileStoreHandler : public StoreHandler {
  protected:
   std::string basePath_;
 
+  // Values are set only once, so the ones read are kept.
+  std::mutex cacheMutex_;
+  std::unordered_map<std::string, std::string> cache_;
+
   std::string realPath(const std::string& path);
 
   std::string tmpPath(const std::string& name);
 
   std::string objectPath(const std::string& name);
+
+  bool exists(const std::string& path);
 };
 
 } // namespace caffe2
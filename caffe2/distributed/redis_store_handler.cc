@@ -19,7 +19,7 @@
 #include <caffe2/core/logging.h>
 
 #include <chrono>
-#include <thread>
+#include <memory>
 #include <vector>
 
 namespace caffe2 {
@@ -46,37 +46,130 @@ std::string RedisStoreHandler::compoundKey(const std::string& name) {
   return prefix_ + name;
 }
 
+std::string RedisStoreHandler::notifyKey(const std::string& name) {
+  return prefix_ + name + "/notify";
+}
+
+std::vector<redisReply*> RedisStoreHandler::pipeline(
+    const std::vector<std::vector<std::string>>& commands) {
+  for (const auto& args : commands) {
+    std::vector<const char*> argv;
+    std::vector<size_t> argvlen;
+    for (const auto& arg : args) {
+      argv.push_back(arg.c_str());
+      argvlen.push_back(arg.length());
+    }
+    auto ret =
+        redisAppendCommandArgv(redis_, argv.size(), argv.data(), argvlen.data());
+    CAFFE_ENFORCE_EQ(ret, REDIS_OK, redis_->errstr);
+  }
+
+  std::vector<redisReply*> replies;
+  for (size_t i = 0; i < commands.size(); ++i) {
+    void* ptr = nullptr;
+    auto ret = redisGetReply(redis_, &ptr);
+    CAFFE_ENFORCE_EQ(ret, REDIS_OK, redis_->errstr);
+    CAFFE_ENFORCE_NE(ptr, (void*)nullptr, redis_->errstr);
+    replies.push_back(static_cast<redisReply*>(ptr));
+  }
+  return replies;
+}
+
 void RedisStoreHandler::set(const std::string& name, const std::string& data) {
-  auto key = compoundKey(name);
-  void* ptr = redisCommand(
-      redis_,
-      "SETNX %b %b",
-      key.c_str(),
-      (size_t)key.size(),
-      data.c_str(),
-      (size_t)data.size());
-  CAFFE_ENFORCE_NE(ptr, (void*)nullptr, redis_->errstr);
-  redisReply* reply = static_cast<redisReply*>(ptr);
-  CAFFE_ENFORCE_EQ(reply->type, REDIS_REPLY_INTEGER);
-  CAFFE_ENFORCE_EQ(
-      reply->integer,
-      1,
-      "Value at ",
-      name,
-      " was already set",
-      " (perhaps you reused a run ID you have used before?)");
+  multiSet({name}, {data});
+}
+
+void RedisStoreHandler::multiSet(
+    const std::vector<std::string>& names,
+    const std::vector<std::string>& data) {
+  CAFFE_ENFORCE_EQ(names.size(), data.size());
+  // Every value is followed by a push to its notify list, which wakes up the
+  // waiters blocked on that list.
+  std::vector<std::vector<std::string>> commands;
+  for (size_t i = 0; i < names.size(); ++i) {
+    commands.push_back({"SETNX", compoundKey(names[i]), data[i]});
+    commands.push_back({"RPUSH", notifyKey(names[i]), "1"});
+  }
+  auto replies = pipeline(commands);
+  for (size_t i = 0; i < names.size(); ++i) {
+    std::unique_ptr<redisReply, void (*)(void*)> reply(
+        replies[2 * i], freeReplyObject);
+    freeReplyObject(replies[2 * i + 1]);
+    CAFFE_ENFORCE_EQ(reply->type, REDIS_REPLY_INTEGER);
+    CAFFE_ENFORCE_EQ(
+        reply->integer,
+        1,
+        "Value at ",
+        names[i],
+        " was already set",
+        " (perhaps you reused a run ID you have used before?)");
+  }
+  std::lock_guard<std::mutex> guard(cacheMutex_);
+  for (size_t i = 0; i < names.size(); ++i) {
+    cache_[names[i]] = data[i];
+  }
 }
 
 std::string RedisStoreHandler::get(const std::string& name) {
-  // Block until key is set
-  wait({name});
+  return multiGet({name})[0];
+}
 
-  auto key = compoundKey(name);
-  void* ptr = redisCommand(redis_, "GET %b", key.c_str(), (size_t)key.size());
-  CAFFE_ENFORCE_NE(ptr, (void*)nullptr, redis_->errstr);
-  redisReply* reply = static_cast<redisReply*>(ptr);
-  CAFFE_ENFORCE_EQ(reply->type, REDIS_REPLY_STRING);
-  return std::string(reply->str, reply->len);
+std::vector<std::string> RedisStoreHandler::multiGet(
+    const std::vector<std::string>& names) {
+  std::vector<std::string> result(names.size());
+  std::vector<size_t> uncached;
+  {
+    std::lock_guard<std::mutex> guard(cacheMutex_);
+    for (size_t i = 0; i < names.size(); ++i) {
+      auto it = cache_.find(names[i]);
+      if (it != cache_.end()) {
+        result[i] = it->second;
+      } else {
+        uncached.push_back(i);
+      }
+    }
+  }
+
+  // Read optimistically, and only wait for the keys that were not set yet.
+  bool waited = false;
+  while (!uncached.empty()) {
+    std::vector<std::string> args{"MGET"};
+    for (auto i : uncached) {
+      args.push_back(compoundKey(names[i]));
+    }
+    auto replies = pipeline({args});
+    std::unique_ptr<redisReply, void (*)(void*)> reply(
+        replies[0], freeReplyObject);
+    CAFFE_ENFORCE_EQ(reply->type, REDIS_REPLY_ARRAY);
+    CAFFE_ENFORCE_EQ(reply->elements, uncached.size());
+
+    std::vector<size_t> unset;
+    std::vector<std::string> unsetNames;
+    {
+      std::lock_guard<std::mutex> guard(cacheMutex_);
+      for (size_t j = 0; j < uncached.size(); ++j) {
+        const auto* element = reply->element[j];
+        const auto i = uncached[j];
+        if (element->type == REDIS_REPLY_NIL) {
+          unset.push_back(i);
+          unsetNames.push_back(names[i]);
+          continue;
+        }
+        CAFFE_ENFORCE_EQ(element->type, REDIS_REPLY_STRING);
+        result[i] = std::string(element->str, element->len);
+        cache_[names[i]] = result[i];
+      }
+    }
+    // Keys that are stored are never deleted, so after one wait all of them
+    // have to be found.
+    CAFFE_ENFORCE(unset.empty() || !waited, "Keys disappeared from the store");
+    if (!unset.empty()) {
+      wait(unsetNames);
+      waited = true;
+    }
+    uncached = std::move(unset);
+  }
+  return result;
 }
 
 int64_t RedisStoreHandler::add(const std::string& name, int64_t value) {
@@ -111,22 +204,56 @@ bool RedisStoreHandler::check(const std::vector<std::string>& names) {
   return reply->integer == names.size();
 }
 
+std::vector<std::string> RedisStoreHandler::missing(
+    const std::vector<std::string>& names) {
+  std::vector<std::vector<std::string>> commands;
+  for (const auto& name : names) {
+    commands.push_back({"EXISTS", compoundKey(name)});
+  }
+  auto replies = pipeline(commands);
+  std::vector<std::string> result;
+  for (size_t i = 0; i < names.size(); ++i) {
+    std::unique_ptr<redisReply, void (*)(void*)> reply(
+        replies[i], freeReplyObject);
+    CAFFE_ENFORCE_EQ(reply->type, REDIS_REPLY_INTEGER);
+    if (reply->integer == 0) {
+      result.push_back(names[i]);
+    }
+  }
+  return result;
+}
+
+bool RedisStoreHandler::waitOne(
+    const std::string& name,
+    const std::chrono::steady_clock::time_point& deadline,
+    bool hasDeadline) {
+  // BRPOPLPUSH moves the element back onto the same list, so that it stays
+  // there for all the other waiters. It blocks for a second at a time (the
+  // timeout of BRPOPLPUSH is in seconds), so that keys set by writers that
+  // do not notify are still found.
+  const auto key = notifyKey(name);
+  while (true) {
+    if (hasDeadline && std::chrono::steady_clock::now() > deadline) {
+      return missing({name}).empty();
+    }
+    auto replies = pipeline({{"BRPOPLPUSH", key, key, "1"}});
+    std::unique_ptr<redisReply, void (*)(void*)> reply(
+        replies[0], freeReplyObject);
+    if (reply->type != REDIS_REPLY_NIL || missing({name}).empty()) {
+      return true;
+    }
+  }
+}
+
 void RedisStoreHandler::wait(
     const std::vector<std::string>& names,
     const std::chrono::milliseconds& timeout) {
-  // Simple approach: poll...
-  // Complex approach: use pub/sub.
-  // Polling is fine for the typical rendezvous use case, as it is
-  // only done at initialization time and  not at run time.
-  const auto start = std::chrono::steady_clock::now();
-  while (!check(names)) {
-    const auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-        std::chrono::steady_clock::now() - start);
-    if (timeout != kNoTimeout && elapsed > timeout) {
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  const bool hasDeadline = timeout != kNoTimeout;
+  for (const auto& name : missing(names)) {
+    if (!waitOne(name, deadline, hasDeadline)) {
       STORE_HANDLER_TIMEOUT("Wait timeout for name(s): ", Join(" ", names));
     }
-    /* sleep override */
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
   }
 }
 }
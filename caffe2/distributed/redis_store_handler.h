@@ -22,7 +22,9 @@ extern "C" {
 #include <hiredis/hiredis.h>
 }
 
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 namespace caffe2 {
 
@@ -43,6 +45,13 @@ class RedisStoreHandler : public StoreHandler {
       const std::vector<std::string>& names,
       const std::chrono::milliseconds& timeout = kDefaultTimeout) override;
 
+  virtual void multiSet(
+      const std::vector<std::string>& names,
+      const std::vector<std::string>& data) override;
+
+  virtual std::vector<std::string> multiGet(
+      const std::vector<std::string>& names) override;
+
  private:
   std::string host_;
   int port_;
@@ -50,7 +59,28 @@ class RedisStoreHandler : public StoreHandler {
 
   redisContext* redis_;
 
+  // Values are set only once, so the ones read are kept.
+  std::mutex cacheMutex_;
+  std::unordered_map<std::string, std::string> cache_;
+
   std::string compoundKey(const std::string& name);
+
+  // Key of the list a value is announced on once it is set.
+  std::string notifyKey(const std::string& name);
+
+  // Sends all commands before reading any reply, so that they take a single
+  // round trip. The caller owns the replies.
+  std::vector<redisReply*> pipeline(
+      const std::vector<std::vector<std::string>>& commands);
+
+  // Returns the names of the keys that are not stored yet.
+  std::vector<std::string> missing(const std::vector<std::string>& names);
+
+  // Blocks until the key is stored; returns false on timeout.
+  bool waitOne(
+      const std::string& name,
+      const std::chrono::steady_clock::time_point& deadline,
+      bool hasDeadline);
 };
 
 } // namespace caffe2
@@ -51,3 +51,6 @@ class TestRedisStoreHandlerOp(TestCase):
 
     def test_set_get(self):
         StoreOpsTests.test_set_get(self.create_store_handler)
+
+    def test_multi_set_get(self):
+        StoreOpsTests.test_multi_set_get(self.create_store_handler)
@@ -64,6 +64,23 @@ class StoreHandler {
   virtual void wait(
       const std::vector<std::string>& names,
       const std::chrono::milliseconds& timeout = kDefaultTimeout) = 0;
+
+  /*
+   * Set the data for many keys, with the semantics of set() for each.
+   * Stores that can should do this in a single round trip; the default
+   * calls set() for every key.
+   */
+  virtual void multiSet(
+      const std::vector<std::string>& names,
+      const std::vector<std::string>& data);
+
+  /*
+   * Get the data for many keys, waiting until all of them are stored with
+   * default timeout. The default waits for all keys and calls get() for
+   * every key.
+   */
+  virtual std::vector<std::string> multiGet(
+      const std::vector<std::string>& names);
 };
 
 struct StoreHandlerTimeoutException : public std::runtime_error {
@@ -22,57 +22,80 @@ constexpr auto kBlobName = "blob_name";
 constexpr auto kAddValue = "add_value";
 
 StoreSetOp::StoreSetOp(const OperatorDef& operator_def, Workspace* ws)
-    : Operator<CPUContext>(operator_def, ws),
-      blobName_(
-          GetSingleArgument<std::string>(kBlobName, operator_def.input(DATA))) {
+    : Operator<CPUContext>(operator_def, ws) {
+  for (int i = DATA; i < operator_def.input_size(); ++i) {
+    blobNames_.push_back(operator_def.input(i));
+  }
+  if (HasArgument(kBlobName)) {
+    CAFFE_ENFORCE_EQ(
+        blobNames_.size(), 1, "blob_name can only be used with a single blob");
+    blobNames_[0] = GetSingleArgument<std::string>(kBlobName, "");
+  }
 }
 
 bool StoreSetOp::RunOnDevice() {
   // Serialize and pass to store
   auto* handler =
       OperatorBase::Input<std::unique_ptr<StoreHandler>>(HANDLER).get();
-  handler->set(blobName_, InputBlob(DATA).Serialize(blobName_));
+  std::vector<std::string> data;
+  for (int i = 0; i < blobNames_.size(); ++i) {
+    data.push_back(InputBlob(DATA + i).Serialize(blobNames_[i]));
+  }
+  handler->multiSet(blobNames_, data);
   return true;
 }
 
 REGISTER_CPU_OPERATOR(StoreSet, StoreSetOp);
 OPERATOR_SCHEMA(StoreSet)
-    .NumInputs(2)
+    .NumInputs(2, INT_MAX)
     .NumOutputs(0)
     .SetDoc(R"DOC(
-Set a blob in a store. The key is the input blob's name and the value
-is the data in that blob. The key can be overridden by specifying the
-'blob_name' argument.
+Set one or more blobs in a store. The keys are the input blobs' names and the
+values are the data in those blobs. All the blobs are set in a single batched
+call to the store. With a single blob, the key can be overridden by specifying
+the 'blob_name' argument.
 )DOC")
     .Arg("blob_name", "alternative key for the blob (optional)")
     .Input(0, "handler", "unique_ptr<StoreHandler>")
-    .Input(1, "data", "data blob");
+    .Input(1, "data", "data blob(s)");
 
 StoreGetOp::StoreGetOp(const OperatorDef& operator_def, Workspace* ws)
-    : Operator<CPUContext>(operator_def, ws),
-      blobName_(GetSingleArgument<std::string>(
-          kBlobName,
-          operator_def.output(DATA))) {}
+    : Operator<CPUContext>(operator_def, ws) {
+  for (int i = DATA; i < operator_def.output_size(); ++i) {
+    blobNames_.push_back(operator_def.output(i));
+  }
+  if (HasArgument(kBlobName)) {
+    CAFFE_ENFORCE_EQ(
+        blobNames_.size(), 1, "blob_name can only be used with a single blob");
+    blobNames_[0] = GetSingleArgument<std::string>(kBlobName, "");
+  }
+}
 
 bool StoreGetOp::RunOnDevice() {
   // Get from store and deserialize
   auto* handler =
       OperatorBase::Input<std::unique_ptr<StoreHandler>>(HANDLER).get();
-  OperatorBase::Outputs()[DATA]->Deserialize(handler->get(blobName_));
+  auto data = handler->multiGet(blobNames_);
+  CAFFE_ENFORCE_EQ(data.size(), blobNames_.size());
+  for (int i = 0; i < data.size(); ++i) {
+    OperatorBase::Outputs()[DATA + i]->Deserialize(data[i]);
+  }
   return true;
 }
 
 REGISTER_CPU_OPERATOR(StoreGet, StoreGetOp);
 OPERATOR_SCHEMA(StoreGet)
     .NumInputs(1)
-    .NumOutputs(1)
+    .NumOutputs(1, INT_MAX)
     .SetDoc(R"DOC(
-Get a blob from a store. The key is the output blob's name. The key
-can be overridden by specifying the 'blob_name' argument.
+Get one or more blobs from a store. The keys are the output blobs' names and
+all of them are fetched in a single batched call, waiting until they are all
+set. With a single blob, the key can be overridden by specifying the
+'blob_name' argument.
 )DOC")
     .Arg("blob_name", "alternative key for the blob (optional)")
     .Input(0, "handler", "unique_ptr<StoreHandler>")
-    .Output(0, "data", "data blob");
+    .Output(0, "data", "data blob(s)");
 
 StoreAddOp::StoreAddOp(const OperatorDef& operator_def, Workspace* ws)
     : Operator<CPUContext>(operator_def, ws),
@@ -61,7 +61,42 @@ class StoreOpsTests(object):
         workspace.ResetWorkspace()
 
     @classmethod
-    def test_set_get(cls, create_store_handler_fn):
+    def _test_multi_set_get(
+            cls, queue, create_store_handler_fn, index, num_procs):
+        store_handler = create_store_handler_fn()
+        blobs = ["multi_blob_{}".format(i) for i in range(3)]
+
+        # Every process sets its own blobs, then gets all of them.
+        own_blobs = ["{}_{}".format(blob, index) for blob in blobs]
+        for i, blob in enumerate(own_blobs):
+            workspace.FeedBlob(blob, np.full(1, index * 10 + i, np.float32))
+        workspace.RunOperatorOnce(
+            core.CreateOperator(
+                "StoreSet",
+                [store_handler] + own_blobs,
+                []))
+
+        all_blobs = [
+            "{}_{}".format(blob, i) for i in range(num_procs) for blob in blobs]
+        workspace.RunOperatorOnce(
+            core.CreateOperator(
+                "StoreGet",
+                [store_handler],
+                all_blobs))
+
+        try:
+            for i in range(num_procs):
+                for j, blob in enumerate(blobs):
+                    np.testing.assert_array_equal(
+                        workspace.FetchBlob("{}_{}".format(blob, i)),
+                        i * 10 + j)
+        except AssertionError as err:
+            queue.put(err)
+
+        workspace.ResetWorkspace()
+
+    @classmethod
+    def _run_procs(cls, target, create_store_handler_fn):
         # Queue for assertion errors on subprocesses
         queue = Queue()
 
@@ -70,7 +105,7 @@ class StoreOpsTests(object):
         procs = []
         for index in range(num_procs):
             proc = Process(
-                target=cls._test_set_get,
+                target=target,
                 args=(queue, create_store_handler_fn, index, num_procs, ))
             proc.start()
             procs.append(proc)
@@ -82,3 +117,11 @@ class StoreOpsTests(object):
         # Raise first error we find, if any
         if not queue.empty():
             raise queue.get()
+
+    @classmethod
+    def test_set_get(cls, create_store_handler_fn):
+        cls._run_procs(cls._test_set_get, create_store_handler_fn)
+
+    @classmethod
+    def test_multi_set_get(cls, create_store_handler_fn):
+        cls._run_procs(cls._test_multi_set_get, create_store_handler_fn)
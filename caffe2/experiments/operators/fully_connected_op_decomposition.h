@@ -61,8 +61,9 @@ class FullyConnectedOpDecomp final : public Operator<Context> {
     int K = X.size() / M;
     // number of outputs.
     int N = U.dim32(0);
-    int middle = U.dim32(0);
+    int middle = U.dim32(1);
     CAFFE_ENFORCE_EQ(K, V.dim32(0));
+    CAFFE_ENFORCE_EQ(middle, V.dim32(1));
     CAFFE_ENFORCE_EQ(N, b.dim32(0));
     if (X.ndim() > 1) {
       Y->Resize(M, N);
@@ -75,16 +76,8 @@ class FullyConnectedOpDecomp final : public Operator<Context> {
   // and width.
     //  multi_buffer_.Resize(M, middle);
     T* multi_buffer_data = multi_buffer_.template mutable_data<T>();
-    //  X * V * tans(U)
-    math::Gemm<T, Context, Engine>(
-        CblasNoTrans, CblasNoTrans, M, middle, K, 1, X.template data<T>(),
-        V.template data<T>(), 0, multi_buffer_data,
-        &context_);
-    math::Gemm<T, Context, Engine>(
-        CblasNoTrans, CblasTrans, M, N, middle, 1, multi_buffer_data,
-        U.template data<T>(), 0, Y->template mutable_data<T>(),
-        &context_);
-    // Add bias term
+    // The bias is broadcast into Y first, so that the second GEMM adds
+    // X * V * trans(U) to it (beta = 1) instead of Y being read once more.
     if (bias_multiplier_.size() != M) {
       // If the helper bias multiplier is not M, reshape and fill it with one.
       bias_multiplier_.Resize(M);
@@ -94,8 +87,17 @@ class FullyConnectedOpDecomp final : public Operator<Context> {
     }
     math::Gemm<T, Context, Engine>(
         CblasNoTrans, CblasNoTrans, M, N, 1, 1,
-        bias_multiplier_.template data<T>(), b.template data<T>(), 1,
+        bias_multiplier_.template data<T>(), b.template data<T>(), 0,
         Y->template mutable_data<T>(), &context_);
+    //  X * V * tans(U), the M-by-middle product first as middle is small.
+    math::Gemm<T, Context, Engine>(
+        CblasNoTrans, CblasNoTrans, M, middle, K, 1, X.template data<T>(),
+        V.template data<T>(), 0, multi_buffer_data,
+        &context_);
+    math::Gemm<T, Context, Engine>(
+        CblasNoTrans, CblasTrans, M, N, middle, 1, multi_buffer_data,
+        U.template data<T>(), 1, Y->template mutable_data<T>(),
+        &context_);
     return true;
   }
 
@@ -145,7 +147,7 @@ class FullyConnectedDecompGradientOp : public Operator<Context> {
 
     // Compute dU
     // first compute X * V
-    du_buffer_.Resize(N, middle);
+    du_buffer_.Resize(M, middle);
     T* du_buffer_data = du_buffer_.template mutable_data<T>();
     math::Gemm<T, Context, Engine>(
         CblasNoTrans, CblasNoTrans, M, middle, K, 1,
@@ -168,7 +170,7 @@ class FullyConnectedDecompGradientOp : public Operator<Context> {
         &context_);
     math::Gemm<T, Context, Engine>(
         CblasTrans, CblasNoTrans, K, middle, M, 1,
-        dY.template data<T>(), du_buffer_data,
+        X.template data<T>(), dv_buffer_data,
         0, dV->template mutable_data<T>(),
         &context_);
     if (bias_multiplier_.size() != M) {
@@ -187,18 +189,12 @@ class FullyConnectedDecompGradientOp : public Operator<Context> {
         &context_);
     // Compute dX if necessary.
     if (OutputSize() == 4) {
+      // dY * U is already in dv_buffer_.
       auto* dX = Output(3);
       dX->ResizeLike(X);
-      dx_buffer_.Resize(M, middle);
-      T* dx_buffer_data = dx_buffer_.template mutable_data<T>();
-      math::Gemm<T, Context, Engine>(
-          CblasNoTrans, CblasNoTrans, M, middle, N, 1,
-          dY.template data<T>(), U.template data<T>(),
-          0, dx_buffer_data,
-          &context_);
       math::Gemm<T, Context, Engine>(
           CblasNoTrans, CblasTrans, M, K, middle, 1,
-          dx_buffer_data, V.template data<T>(),
+          dv_buffer_data, V.template data<T>(),
           0, dX->template mutable_data<T>(),
           &context_);
     }
@@ -210,7 +206,6 @@ class FullyConnectedDecompGradientOp : public Operator<Context> {
   Tensor<Context> bias_multiplier_;
   Tensor<Context> du_buffer_;
   Tensor<Context> dv_buffer_;
-  Tensor<Context> dx_buffer_;
 };
 
 }  // namespace caffe2
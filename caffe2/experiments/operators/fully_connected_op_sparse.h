@@ -17,6 +17,8 @@
 #ifndef CAFFE2_OPERATORS_FULLY_CONNECTED_OP_SPARSE_H_
 #define CAFFE2_OPERATORS_FULLY_CONNECTED_OP_SPARSE_H_
 
+#include <algorithm>
+
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/utils/math.h"
@@ -49,9 +51,12 @@ inline const std::vector<TIndex>& shape(int i, int j) {
   return shape<2>(Shape<2>({i, j}));
 }
 
+// C = A(sparse) * B + bias, bias being added to every column of C
+// (i.e. bias[i] to row i). A is m-by-k in zero based CSR format.
 template <typename T, class Context>
 void Sparse_mm(const T* acsr, const int* ia, const int* ja,
-              int m, int k, int n, const T* b, T* c, Context* context);
+              int m, int k, int n, const T* b, const T* bias, T* c,
+              Context* context);
 
 template<typename T, class Context>
 void trans_mat(const T* o, T* t, int m, int n, Context* context);
@@ -70,7 +75,6 @@ void trans_mat<float, CPUContext>(
   }
 }
 
-// C = A(sparse) * B
 // No transpose;
 template <>
 void Sparse_mm<float, CPUContext>(
@@ -81,11 +85,31 @@ void Sparse_mm<float, CPUContext>(
     int k,
     int n,
     const float* b,
+    const float* bias,
     float* c,
     CPUContext* /*context*/) {
-  float alpha = 1.0, beta = 0.;
+#ifdef CAFFE2_USE_MKL
+  for (int i = 0; i < m; ++i) {
+    std::fill(c + i * n, c + (i + 1) * n, bias[i]);
+  }
+  float alpha = 1.0, beta = 1.;
   mkl_scsrmm("N", &m, &n, &k, &alpha, "GLNC",
              acsr, ja, ia, ia+1, b, &n, &beta, c, &n);
+#else
+  // Every nonzero of a row of A scales a row of B into the same row of C,
+  // vectorized over the n columns. Rows of C are independent.
+  const size_t grain = std::max<size_t>(1, 16384 / std::max(1, n));
+  CPUContext::ParallelFor(m, grain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      EigenVectorArrayMap<float> c_row(c + i * n, n);
+      c_row.setConstant(bias[i]);
+      for (int p = ia[i]; p < ia[i + 1]; ++p) {
+        c_row += acsr[p] *
+            ConstEigenVectorArrayMap<float>(b + TIndex(ja[p]) * n, n);
+      }
+    }
+  });
+#endif  // CAFFE2_USE_MKL
 }
 
 }
@@ -117,30 +141,16 @@ class FullyConnectedOp_SPARSE final : public Operator<Context> {
     // number of outputs.
     int N = iw.dim32(0)-1;
     CAFFE_ENFORCE_EQ(N, b.dim32(0));
+    CAFFE_ENFORCE_EQ(Wcsr.size(), jw.size());
     Yt->Resize(shape(N, M));
 
-    // Y' = W * X';
+    // Y' = W * X' + b;
     Sparse_mm<T, Context>(
       Wcsr.template data<T>(), iw.template data<int>(),
       jw.template data<int>(), N, K, M, Xt.template data<T>(),
-      Yt->template mutable_data<T>(), &context_);
-    // Add bias term
-    if (bias_multiplier_.size() != M) {
-      // If the helper bias multiplier is not M, reshape and fill it with one.
-      bias_multiplier_.Resize(shape(M));
-      math::Set<T, Context>(
-          M, static_cast<T>(1), bias_multiplier_.template mutable_data<T>(),
-          &context_);
-    }
-    math::Gemm<T, Context, Engine>(
-        CblasNoTrans, CblasNoTrans, N, M, 1, 1,
-        b.template data<T>(), bias_multiplier_.template data<T>(), 1,
-        Yt->template mutable_data<T>(), &context_);
+      b.template data<T>(), Yt->template mutable_data<T>(), &context_);
     return true;
   }
-
- protected:
-  Tensor<Context> bias_multiplier_;
 };
 
 
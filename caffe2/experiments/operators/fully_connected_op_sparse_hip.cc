@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "hip/hip_runtime.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/experiments/operators/fully_connected_op_sparse.h"
+
+namespace caffe2 {
+
+namespace {
+
+// One block per row of C (grid-strided), its threads stride over the n
+// columns, so that the rows of B picked by the nonzeros of the row of A are
+// read with coalesced loads.
+__global__ void csr_mm_kernel(const int m,
+                              const int n,
+                              const float* acsr,
+                              const int* ia,
+                              const int* ja,
+                              const float* b,
+                              const float* bias,
+                              float* c)
+{
+    for(int i = hipBlockIdx_x; i < m; i += hipGridDim_x)
+    {
+        const int begin = ia[i];
+        const int end   = ia[i + 1];
+        for(int col = hipThreadIdx_x; col < n; col += hipBlockDim_x)
+        {
+            float sum = bias[i];
+            for(int p = begin; p < end; ++p)
+            {
+                sum += acsr[p] * b[static_cast<int64_t>(ja[p]) * n + col];
+            }
+            c[static_cast<int64_t>(i) * n + col] = sum;
+        }
+    }
+}
+
+// Specializes the template of the anonymous namespace of the header.
+template <>
+void Sparse_mm<float, HIPContext>(const float* acsr,
+                                  const int* ia,
+                                  const int* ja,
+                                  int m,
+                                  int /*k*/,
+                                  int n,
+                                  const float* b,
+                                  const float* bias,
+                                  float* c,
+                                  HIPContext* context)
+{
+    if(m == 0 || n == 0)
+    {
+        return;
+    }
+    // Narrow outputs get a single wavefront per row.
+    const int threads = std::min(CAFFE_HIP_NUM_THREADS, (n + 63) / 64 * 64);
+    hipLaunchKernelGGL(csr_mm_kernel,
+                       dim3(std::min(m, CAFFE_MAXIMUM_NUM_BLOCKS)),
+                       dim3(threads),
+                       0,
+                       context->hip_stream(),
+                       m,
+                       n,
+                       acsr,
+                       ia,
+                       ja,
+                       b,
+                       bias,
+                       c);
+}
+
+} // namespace
+
+REGISTER_HIP_OPERATOR(FC_Sparse, FullyConnectedOp_SPARSE<float, HIPContext>);
+
+} // namespace caffe2
@@ -63,22 +63,20 @@ class TTContractionOp final : public Operator<Context> {
     TIndex B_stride = K_ * N_;
     TIndex C_stride = M_ * N_;
 
-    const T* A_data = A.template data<T>();
-    const T* B_data = B.template data<T>();
-    T* C_data = C->template mutable_data<T>();
-
-    for (TIndex B_index = 0; B_index < B_size; B_index += B_stride) {
-      math::Gemm<T, Context, Engine>(
-          CblasTrans,
-          CblasNoTrans,
-          M_, N_, K_, 1,
-          A_data,
-          B_data + B_index,
-          0,
-          C_data,
-          &context_);
-      C_data += C_stride;
-    }
+    // All the D products share A, they are computed by one batched GEMM.
+    math::GemmStridedBatched<T, Context, Engine>(
+        CblasTrans,
+        CblasNoTrans,
+        D_,
+        M_, N_, K_, 1,
+        A.template data<T>(),
+        0,
+        B.template data<T>(),
+        B_stride,
+        0,
+        C->template mutable_data<T>(),
+        C_stride,
+        &context_);
 
     return true;
   }
@@ -124,6 +122,8 @@ class TTContractionGradientOp final : public Operator<Context> {
     T* dA_data = dA->template mutable_data<T>();
     T* dB_data = dB->template mutable_data<T>();
 
+    // dA sums the products of the D slices, they accumulate one after the
+    // other.
     const T* G_ptr = G_data;
     for (TIndex B_index = 0; B_index < dB_size; B_index += B_stride) {
       math::Gemm<T, Context, Engine>(
@@ -138,19 +138,19 @@ class TTContractionGradientOp final : public Operator<Context> {
       G_ptr += G_stride;
     }
 
-    G_ptr = G_data;
-    for (TIndex B_index = 0; B_index < dB_size; B_index += B_stride) {
-      math::Gemm<T, Context, Engine>(
-          CblasNoTrans,
-          CblasNoTrans,
-          K_, N_, M_, 1,
-          A_data,
-          G_ptr,
-          0,
-          dB_data + B_index,
-          &context_);
-      G_ptr += G_stride;
-    }
+    math::GemmStridedBatched<T, Context, Engine>(
+        CblasNoTrans,
+        CblasNoTrans,
+        D_,
+        K_, N_, M_, 1,
+        A_data,
+        0,
+        G_data,
+        G_stride,
+        0,
+        dB_data,
+        B_stride,
+        &context_);
 
     return true;
   }
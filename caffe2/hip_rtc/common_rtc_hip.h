@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_HIP_RTC_COMMON_RTC_HIP_H_
+#define CAFFE2_HIP_RTC_COMMON_RTC_HIP_H_
+
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+#include <hip/hip_runtime.h>
+#include <hip/hiprtc.h>
+
+#include "caffe2/core/common_hip.h"
+#include "caffe2/core/logging.h"
+
+#define HIPRTC_CHECK(condition)                                                   \
+    do                                                                            \
+    {                                                                             \
+        hiprtcResult result = condition;                                          \
+        if(result != HIPRTC_SUCCESS)                                              \
+        {                                                                         \
+            LOG(FATAL) << "Error at: " << __FILE__ << ":" << __LINE__ << ": "     \
+                       << hiprtcGetErrorString(result);                           \
+        }                                                                         \
+    } while(0)
+
+namespace caffe2 {
+
+// A kernel compiled at runtime with hiprtc and loaded as a module on the
+// current device. The source must declare the kernel extern "C".
+class HipRTCFunction
+{
+    public:
+    HipRTCFunction(const std::string& name, const std::string& src) : name_(name)
+    {
+        VLOG(1) << "function name: " << name;
+        VLOG(1) << "function src:\n" << src;
+        hiprtcProgram prog;
+        HIPRTC_CHECK(hiprtcCreateProgram(&prog, src.c_str(), nullptr, 0, nullptr, nullptr));
+        hiprtcResult compile_result = hiprtcCompileProgram(prog, 0, nullptr);
+        if(compile_result != HIPRTC_SUCCESS)
+        {
+            size_t log_size;
+            HIPRTC_CHECK(hiprtcGetProgramLogSize(prog, &log_size));
+            vector<char> hiprtc_log(log_size + 1, '\0');
+            HIPRTC_CHECK(hiprtcGetProgramLog(prog, hiprtc_log.data()));
+            LOG(FATAL) << "Compilation failure for hiprtc("
+                       << hiprtcGetErrorString(compile_result) << "): \n"
+                       << hiprtc_log.data();
+        }
+        size_t code_size;
+        HIPRTC_CHECK(hiprtcGetCodeSize(prog, &code_size));
+        vector<char> code(code_size);
+        HIPRTC_CHECK(hiprtcGetCode(prog, code.data()));
+        HIPRTC_CHECK(hiprtcDestroyProgram(&prog));
+        HIP_ENFORCE(hipModuleLoadData(&module_, code.data()));
+        HIP_ENFORCE(hipModuleGetFunction(&kernel_, module_, name.c_str()));
+    }
+
+    ~HipRTCFunction() { HIP_CHECK(hipModuleUnload(module_)); }
+
+    const std::string& name() const { return name_; }
+
+    // hipModuleLaunchKernel only takes the kernel arguments packed in a
+    // buffer, so there is no variant taking an array of argument pointers.
+    void LaunchEx(unsigned int gx,
+                  unsigned int gy,
+                  unsigned int gz,
+                  unsigned int bx,
+                  unsigned int by,
+                  unsigned int bz,
+                  unsigned int shared_mem,
+                  hipStream_t stream,
+                  void** extra)
+    {
+        HIP_ENFORCE(hipModuleLaunchKernel(
+            kernel_, gx, gy, gz, bx, by, bz, shared_mem, stream, nullptr, extra));
+    }
+
+    private:
+    std::string name_;
+    hipModule_t module_;
+    hipFunction_t kernel_;
+};
+
+// Returns the function generated by get_source(name) for the given key,
+// compiling it the first time the key is seen on the current device. The
+// kernel name is derived from a hash of the key, so ops generating the same
+// source share a single module.
+template <typename SourceFn>
+std::shared_ptr<HipRTCFunction> GetOrCompileHipRTCFunction(const std::string& key,
+                                                           SourceFn get_source)
+{
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::shared_ptr<HipRTCFunction>> cache;
+
+    int device;
+    HIP_ENFORCE(hipGetDevice(&device));
+    const std::string device_key = std::to_string(device) + ":" + key;
+
+    std::lock_guard<std::mutex> guard(mutex);
+    auto it = cache.find(device_key);
+    if(it != cache.end())
+    {
+        return it->second;
+    }
+    std::stringstream name;
+    name << "_hip_kernel_" << std::hex << std::setw(16) << std::setfill('0')
+         << std::hash<std::string>()(key);
+    auto func = std::make_shared<HipRTCFunction>(name.str(), get_source(name.str()));
+    cache[device_key] = func;
+    return func;
+}
+
+} // namespace caffe2
+
+#endif // CAFFE2_HIP_RTC_COMMON_RTC_HIP_H_
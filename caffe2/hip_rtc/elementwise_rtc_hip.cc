@@ -0,0 +1,141 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/hip_rtc/common_rtc_hip.h"
+
+namespace caffe2 {
+namespace {
+
+std::string GetElementwiseSource(const std::string& name,
+                                 int input_size,
+                                 int output_size,
+                                 const std::string& type,
+                                 const std::string& command_string)
+{
+    std::stringstream ss;
+    ss << "#include <hip/hip_runtime.h>\n"
+          "extern \"C\" __global__ void "
+       << name << "(const size_t nthreads";
+    for(int i = 0; i < input_size; ++i)
+    {
+        ss << ",\nconst " << type << "* in" << i;
+    }
+    for(int i = 0; i < output_size; ++i)
+    {
+        ss << ",\n" << type << "* out" << i;
+    }
+    ss << ") {\n"
+          "for (int index = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;\n"
+          "index < nthreads; index += hipBlockDim_x * hipGridDim_x) {\n"
+       << command_string << "\n"
+       << "}\n}";
+    return ss.str();
+}
+
+} // namespace
+
+/**
+ * The HIP counterpart of the NVRTC ElementwiseRTC op: rtc_src is pasted into
+ * the body of a grid-stride loop over index, and refers to the inputs and
+ * outputs as in0, in1, ..., out0, out1, ... All inputs must be float tensors
+ * of the same size, and the outputs are shaped like the first input.
+ *
+ * The kernel is compiled with hiprtc the first time the op runs and cached
+ * process-wide by a hash of the source and the data type, so the many ops
+ * that a FuseElementwise transform generates from the same expression share
+ * one module.
+ */
+class ElementwiseRTCOp final : public Operator<HIPContext>
+{
+    public:
+    ElementwiseRTCOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws),
+          src_(OperatorBase::GetSingleArgument<string>("rtc_src", ""))
+    {
+        CAFFE_ENFORCE(src_.size(), "Op should have a non-zero source code size.");
+    }
+    ~ElementwiseRTCOp() {}
+
+    bool RunOnDevice() override
+    {
+        static_assert(sizeof(void*) == sizeof(size_t),
+                      "The argbuffer relies on the assumption that void* and "
+                      "size_t have the same size.");
+        const auto& X = Input(0);
+        CAFFE_ENFORCE(X.size() < std::numeric_limits<int>::max(),
+                      "The kernel function currently only supports int index.");
+        for(int i = 0; i < InputSize(); ++i)
+        {
+            CAFFE_ENFORCE(Input(i).IsType<float>(), "ElementwiseRTC only supports float.");
+            CAFFE_ENFORCE_EQ(Input(i).size(), X.size(), "Inputs must have the same size.");
+        }
+        if(!func_)
+        {
+            const int input_size  = InputSize();
+            const int output_size = OutputSize();
+            const string key      = "float:" + std::to_string(input_size) + ":" +
+                               std::to_string(output_size) + ":" + src_;
+            func_ = GetOrCompileHipRTCFunction(key, [&](const std::string& name) {
+                return GetElementwiseSource(name, input_size, output_size, "float", src_);
+            });
+        }
+
+        vector<size_t> argBuffer(InputSize() + OutputSize() + 1);
+        argBuffer[0]       = X.size();
+        void** ptr_buffer = reinterpret_cast<void**>(argBuffer.data() + 1);
+        for(int i = 0; i < InputSize(); ++i)
+        {
+            ptr_buffer[i] = const_cast<float*>(Input(i).data<float>());
+        }
+        for(int i = 0; i < OutputSize(); ++i)
+        {
+            Output(i)->ResizeLike(X);
+            ptr_buffer[i + InputSize()] = Output(i)->mutable_data<float>();
+        }
+        if(X.size() == 0)
+        {
+            return true;
+        }
+        size_t argBufferSize = argBuffer.size() * sizeof(size_t);
+        void* config[]       = {HIP_LAUNCH_PARAM_BUFFER_POINTER,
+                          argBuffer.data(),
+                          HIP_LAUNCH_PARAM_BUFFER_SIZE,
+                          &argBufferSize,
+                          HIP_LAUNCH_PARAM_END};
+        func_->LaunchEx(CAFFE_GET_BLOCKS(X.size()),
+                        1,
+                        1,
+                        CAFFE_HIP_NUM_THREADS,
+                        1,
+                        1,
+                        0,
+                        context_.hip_stream(),
+                        config);
+        return true;
+    }
+
+    private:
+    const string src_;
+    std::shared_ptr<HipRTCFunction> func_;
+};
+
+namespace {
+REGISTER_HIP_OPERATOR_WITH_ENGINE(ElementwiseRTC, HIPRTC, ElementwiseRTCOp);
+}
+
+} // namespace caffe2
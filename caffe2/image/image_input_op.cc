@@ -102,8 +102,29 @@ The dimension of the output image will always be cropxcrop
     .Arg("use_caffe_datum", "1 if the input is in Caffe format. Defaults to 0")
     .Arg("use_gpu_transform", "1 if GPU acceleration should be used."
          " Defaults to 0. Can only be 1 in a CUDAContext")
+    .Arg("use_gpu_augmentation", "1 if cropping, scaling, mirroring and color "
+         "jitter/lighting should also run on the GPU, leaving only the "
+         "decoding to the CPU threads. Requires use_gpu_transform. Images are "
+         "resampled with a bilinear or box filter instead of OpenCV's "
+         "INTER_AREA. Defaults to 0")
+    .Arg("gpu_augmentation_chunk", "Number of images decoded before they are "
+         "copied to the GPU and augmented while the next ones are decoded. "
+         "Defaults to a quarter of batch_size")
+    .Arg("raw_images", "1 if every record is a raw uint8 image (a BYTE "
+         "TensorProto of dims [height, width, channels]) of the size of the "
+         "first one, e.g. made by convert_encoded_to_raw_leveldb --warp. "
+         "The records are copied straight into the staging buffer "
+         "of the batch, without decoding or cv::Mat conversion, and the batch "
+         "is sent to the GPU in one copy. Requires use_gpu_augmentation. "
+         "Bounding boxes are not applied. Defaults to 0")
+    .Arg("prefetch_buffers", "Number of batches that are prefetched and "
+         "copied to the GPU ahead of the one being consumed. Defaults to 1")
     .Arg("decode_threads", "Number of CPU decode/transform threads."
          " Defaults to 4")
+    .Arg("reduced_decode", "1 to decode JPEGs at 1/2, 1/4 or 1/8 of their "
+         "size when their shortest side is at least that many times scale. "
+         "Only used with scale, without random_scale, bounding boxes or "
+         "inception-style scale jittering. Requires OpenCV 3.1. Defaults to 0")
     .Arg("output_type", "If gpu_transform, can set to FLOAT or FLOAT16.")
     .Arg("db", "Name of the database (if not passed as input)")
     .Arg("db_type", "Type of database (if not passed as input)."
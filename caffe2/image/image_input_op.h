@@ -31,6 +31,13 @@
 #include "caffe2/operators/prefetch_op.h"
 #include "caffe2/image/transform_gpu.h"
 
+// cv::IMREAD_REDUCED_* are available from OpenCV 3.1. OpenCV 2.4 defines
+// CV_VERSION_EPOCH and reuses CV_VERSION_MAJOR for its minor version.
+#if !defined(CV_VERSION_EPOCH) && \
+    (CV_VERSION_MAJOR > 3 || (CV_VERSION_MAJOR == 3 && CV_VERSION_MINOR >= 1))
+#define CAFFE2_IMAGE_REDUCED_DECODE 1
+#endif
+
 namespace caffe2 {
 
 class CUDAContext;
@@ -89,13 +96,31 @@ class ImageInputOp final
 
   bool GetImageAndLabelAndInfoFromDBValue(
       const string& value, cv::Mat* img, PerImageArg& info, int item_id,
-      std::mt19937* randgen);
+      std::mt19937* randgen, uint8_t* raw_image = nullptr);
+  cv::Mat DecodeImage(const char* data, int size, const PerImageArg& info);
   void DecodeAndTransform(
       const std::string& value, float *image_data, int item_id,
       const int channels, std::size_t thread_index);
   void DecodeAndTransposeOnly(
       const std::string& value, uint8_t *image_data, int item_id,
       const int channels, std::size_t thread_index);
+  void DecodeForGPUAugmentation(
+      const std::string& value, int item_id, const int channels,
+      std::size_t thread_index);
+  void DecodeRawForGPUAugmentation(
+      const std::string& value, uint8_t* staging_data, int item_id,
+      const int channels, std::size_t thread_index);
+  bool GetScaledSize(
+      const cv::Mat& img, std::mt19937* randgen, int* scaled_height,
+      int* scaled_width);
+  void GetAugmentationParams(
+      const cv::Mat& img, const int channels, std::mt19937* randgen,
+      cv::Mat* window_img, ImageAugmentationParams* params);
+  void AugmentChunkOnGPU(int begin, int end, const int channels);
+  uint8_t* GetRawStagingBuffer(const TensorProto& image_proto,
+                               const int channels);
+  void AugmentRawBatchOnGPU(const int channels);
+  void CopyMeanStdToDevice();
 
   unique_ptr<db::DBReader> owned_reader_;
   const db::DBReader* reader_;
@@ -103,9 +128,10 @@ class ImageInputOp final
   TensorCPU prefetched_image_;
   TensorCPU prefetched_label_;
   vector<TensorCPU> prefetched_additional_outputs_;
-  Tensor<Context> prefetched_image_on_device_;
-  Tensor<Context> prefetched_label_on_device_;
-  vector<Tensor<Context>> prefetched_additional_outputs_on_device_;
+  // One of each per prefetch slot.
+  vector<Tensor<Context>> prefetched_image_on_device_;
+  vector<Tensor<Context>> prefetched_label_on_device_;
+  vector<vector<Tensor<Context>>> prefetched_additional_outputs_on_device_;
   // Default parameters for images
   PerImageArg default_arg_;
   int batch_size_;
@@ -137,6 +163,18 @@ class ImageInputOp final
   bool is_test_;
   bool use_caffe_datum_;
   bool gpu_transform_;
+  // Crop, resize and color augmentation are done on the device as well, the
+  // decode threads only decode the images and draw the random parameters.
+  bool gpu_augmentation_;
+  // Decode JPEGs at 1/2, 1/4 or 1/8 of their size when they are scaled down
+  // by at least as much afterwards.
+  bool reduced_decode_;
+  // The records are raw uint8 HWC images that all have the size of the
+  // first one. The decode threads copy them straight into the staging
+  // buffer of the batch, which is augmented on the device at once.
+  bool raw_images_;
+  int raw_height_ = 0;
+  int raw_width_ = 0;
   bool mean_std_copied_ = false;
 
   // thread pool for parse + decode
@@ -155,6 +193,28 @@ class ImageInputOp final
 
   // Working variables
   std::vector<std::mt19937> randgen_per_thread_;
+
+  // GPU augmentation: the batch is decoded in chunks of
+  // gpu_augmentation_chunk_ images, and every chunk is staged in one of two
+  // host buffers (pinned when the HIP/CUDA pinned allocator is on) and copied
+  // to the device asynchronously while the next chunk is decoded.
+  int gpu_augmentation_chunk_;
+  std::vector<cv::Mat> decoded_images_;
+  std::vector<ImageAugmentationParams> augmentation_params_;
+  TensorCPU staging_[2];
+  Tensor<Context> staging_on_device_[2];
+  // Recorded after the augmentation of the chunk staged in each buffer.
+  std::vector<std::unique_ptr<Event>> staging_events_;
+
+  // Time every stage of Prefetch() takes per batch: reading the records,
+  // decoding and augmenting them (including the GPU augmentation of the
+  // chunks), and issuing the copies to the device.
+  struct ImageInputStats {
+    CAFFE_STAT_CTOR(ImageInputStats);
+    CAFFE_AVG_EXPORTED_STAT(read_us);
+    CAFFE_AVG_EXPORTED_STAT(decode_us);
+    CAFFE_AVG_EXPORTED_STAT(copy_us);
+  } stage_stats_;
 };
 
 template <class Context>
@@ -164,7 +224,11 @@ ImageInputOp<Context>::ImageInputOp(
     : PrefetchOperator<Context>(operator_def, ws),
       reader_(nullptr),
       prefetched_additional_outputs_(OutputSize() - 2),
-      prefetched_additional_outputs_on_device_(OutputSize() - 2),
+      prefetched_image_on_device_(this->prefetch_slots()),
+      prefetched_label_on_device_(this->prefetch_slots()),
+      prefetched_additional_outputs_on_device_(
+          this->prefetch_slots(),
+          vector<Tensor<Context>>(OutputSize() - 2)),
       batch_size_(
           OperatorBase::template GetSingleArgument<int>("batch_size", 0)),
       label_type_(static_cast<LABEL_TYPE>(
@@ -204,6 +268,15 @@ ImageInputOp<Context>::ImageInputOp(
       gpu_transform_(OperatorBase::template GetSingleArgument<int>(
           "use_gpu_transform",
           0)),
+      gpu_augmentation_(OperatorBase::template GetSingleArgument<int>(
+          "use_gpu_augmentation",
+          0)),
+      reduced_decode_(OperatorBase::template GetSingleArgument<int>(
+          "reduced_decode",
+          0)),
+      raw_images_(OperatorBase::template GetSingleArgument<int>(
+          "raw_images",
+          0)),
       num_decode_threads_(
           OperatorBase::template GetSingleArgument<int>("decode_threads", 4)),
       thread_pool_(std::make_shared<TaskThreadPool>(num_decode_threads_)),
@@ -211,7 +284,11 @@ ImageInputOp<Context>::ImageInputOp(
       output_type_(
           cast::GetCastDataType(ArgumentHelper(operator_def), "output_type")),
       random_scale_(
-          OperatorBase::template GetRepeatedArgument<int>("random_scale", {-1,-1})) {
+          OperatorBase::template GetRepeatedArgument<int>("random_scale", {-1,-1})),
+      stage_stats_(
+          "image_input/" +
+          (operator_def.name().empty() ? operator_def.type()
+                                       : operator_def.name())) {
   if ((random_scale_[0] == -1) || (random_scale_[1] == -1)) {
     random_scaling_ = false;
   } else {
@@ -304,6 +381,33 @@ ImageInputOp<Context>::ImageInputOp(
   CAFFE_ENFORCE_GE(random_scale_[1], random_scale_[0],
       "random scale must provide a range [min, max]");
 
+  if (gpu_augmentation_) {
+    CAFFE_ENFORCE(
+        (!std::is_same<Context, CPUContext>::value),
+        "GPU augmentation needs a GPU device option");
+    CAFFE_ENFORCE(
+        gpu_transform_, "use_gpu_augmentation requires use_gpu_transform");
+    CAFFE_ENFORCE(
+        output_type_ == TensorProto_DataType_FLOAT ||
+            output_type_ == TensorProto_DataType_FLOAT16,
+        "GPU augmentation only outputs float or float16");
+    gpu_augmentation_chunk_ = OperatorBase::template GetSingleArgument<int>(
+        "gpu_augmentation_chunk", (batch_size_ + 3) / 4);
+    CAFFE_ENFORCE_GT(gpu_augmentation_chunk_, 0);
+    decoded_images_.resize(batch_size_);
+    augmentation_params_.resize(batch_size_);
+    for (int i = 0; i < 2; ++i) {
+      staging_events_.emplace_back(new Event(operator_def.device_option()));
+    }
+  }
+
+  if (raw_images_) {
+    CAFFE_ENFORCE(
+        gpu_augmentation_, "raw_images requires use_gpu_augmentation");
+    CAFFE_ENFORCE(
+        !use_caffe_datum_, "raw_images does not support Caffe datums");
+  }
+
   if (default_arg_.bounding_params.ymin < 0
       || default_arg_.bounding_params.xmin < 0
       || default_arg_.bounding_params.height < 0
@@ -324,6 +428,21 @@ ImageInputOp<Context>::ImageInputOp(
   if (gpu_transform_) {
     LOG(INFO) << "    Performing transformation on GPU";
   }
+  if (gpu_augmentation_) {
+    LOG(INFO) << "    Performing cropping, scaling and color augmentation on "
+              << "GPU in chunks of " << gpu_augmentation_chunk_ << " images";
+  }
+  if (raw_images_) {
+    LOG(INFO) << "    Copying raw images straight to the staging buffer;";
+  }
+  if (reduced_decode_) {
+#ifdef CAFFE2_IMAGE_REDUCED_DECODE
+    LOG(INFO) << "    Decoding JPEGs at reduced size when possible;";
+#else
+    LOG(WARNING) << "reduced_decode requires OpenCV 3.1 or newer, ignoring it";
+    reduced_decode_ = false;
+#endif
+  }
   LOG(INFO) << "    Outputting in batches of " << batch_size_ << " images;";
   LOG(INFO) << "    Treating input image as "
             << (color_ ? "color " : "grayscale ") << "image;";
@@ -394,21 +513,18 @@ ImageInputOp<Context>::ImageInputOp(
   }
 }
 
-// Inception-stype scale jittering
+// Picks the window of Inception-stype scale jittering
 template <class Context>
-bool RandomSizedCropping(
-  cv::Mat* img,
-  const int crop,
-  std::mt19937* randgen
+bool RandomSizedCroppingWindow(
+  const int im_height,
+  const int im_width,
+  std::mt19937* randgen,
+  cv::Rect* roi
 ) {
-  cv::Mat scaled_img;
-  bool inception_scale_jitter = false;
-  int im_height = img->rows, im_width = img->cols;
   int area = im_height * im_width;
   std::uniform_real_distribution<> area_dis(0.08, 1.0);
   std::uniform_real_distribution<> aspect_ratio_dis(3.0 / 4.0, 4.0 / 3.0);
 
-  cv::Mat cropping;
   for (int i = 0; i < 10; ++i) {
     int target_area = int(ceil(area_dis(*randgen) * area));
     float aspect_ratio = aspect_ratio_dis(*randgen);
@@ -419,21 +535,35 @@ bool RandomSizedCropping(
         0, im_height - nh)(*randgen);
       int width_offset = std::uniform_int_distribution<>(
         0,im_width - nw)(*randgen);
-      cv::Rect ROI(width_offset, height_offset, nw, nh);
-      cropping = (*img)(ROI);
-      cv::resize(
-          cropping,
-          scaled_img,
-          cv::Size(crop, crop),
-          0,
-          0,
-          cv::INTER_AREA);
-      *img = scaled_img;
-      inception_scale_jitter = true;
-      break;
+      *roi = cv::Rect(width_offset, height_offset, nw, nh);
+      return true;
     }
   }
-  return inception_scale_jitter;
+  return false;
+}
+
+// Inception-stype scale jittering
+template <class Context>
+bool RandomSizedCropping(
+  cv::Mat* img,
+  const int crop,
+  std::mt19937* randgen
+) {
+  cv::Rect ROI;
+  if (!RandomSizedCroppingWindow<Context>(img->rows, img->cols, randgen, &ROI)) {
+    return false;
+  }
+  cv::Mat scaled_img;
+  cv::Mat cropping = (*img)(ROI);
+  cv::resize(
+      cropping,
+      scaled_img,
+      cv::Size(crop, crop),
+      0,
+      0,
+      cv::INTER_AREA);
+  *img = scaled_img;
+  return true;
 }
 
 template <class Context>
@@ -442,7 +572,8 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
     cv::Mat* img,
     PerImageArg& info,
     int item_id,
-    std::mt19937* randgen) {
+    std::mt19937* randgen,
+    uint8_t* raw_image) {
   //
   // recommend using --caffe2_use_fatal_for_enforce=1 when using ImageInputOp
   // as this function runs on a worker thread and the exceptions from
@@ -460,13 +591,7 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
     prefetched_label_.mutable_data<int>()[item_id] = datum.label();
     if (datum.encoded()) {
       // encoded image in datum.
-      src = cv::imdecode(
-          cv::Mat(
-              1,
-              datum.data().size(),
-              CV_8UC1,
-              const_cast<char*>(datum.data().data())),
-          color_ ? CV_LOAD_IMAGE_COLOR : CV_LOAD_IMAGE_GRAYSCALE);
+      src = DecodeImage(datum.data().data(), datum.data().size(), info);
     } else {
       // Raw image in datum.
       CAFFE_ENFORCE(datum.channels() == 3 || datum.channels() == 1);
@@ -518,19 +643,23 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
       info.bounding_params.width = bounding_proto.int32_data(3);
     }
 
-    if (image_proto.data_type() == TensorProto::STRING) {
+    if (raw_image != nullptr) {
+      // raw_images: the pixels go straight to the staging buffer
+      CAFFE_ENFORCE_EQ(image_proto.data_type(), TensorProto::BYTE);
+      CAFFE_ENFORCE_EQ(
+          static_cast<int>(image_proto.byte_data().size()),
+          raw_height_ * raw_width_ * (color_ ? 3 : 1),
+          "All the raw images must have the size and channels of the first");
+      memcpy(
+          raw_image,
+          image_proto.byte_data().data(),
+          image_proto.byte_data().size());
+    } else if (image_proto.data_type() == TensorProto::STRING) {
       // encoded image string.
       DCHECK_EQ(image_proto.string_data_size(), 1);
       const string& encoded_image_str = image_proto.string_data(0);
-      int encoded_size = encoded_image_str.size();
-      // We use a cv::Mat to wrap the encoded str so we do not need a copy.
-      src = cv::imdecode(
-          cv::Mat(
-              1,
-              &encoded_size,
-              CV_8UC1,
-              const_cast<char*>(encoded_image_str.data())),
-          color_ ? CV_LOAD_IMAGE_COLOR : CV_LOAD_IMAGE_GRAYSCALE);
+      src = DecodeImage(
+          encoded_image_str.data(), encoded_image_str.size(), info);
     } else if (image_proto.data_type() == TensorProto::BYTE) {
       // raw image content.
       int src_c = (image_proto.dims_size() == 3) ? image_proto.dims(2) : 1;
@@ -647,6 +776,11 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
     }
   }
 
+  if (raw_image != nullptr) {
+    // Nothing to convert, bounding boxes are not applied to raw images
+    return true;
+  }
+
   //
   // convert source to the color format requested from Op
   //
@@ -688,6 +822,11 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
     // LOG(INFO) << "No bounding\n";
   }
 
+  if (gpu_augmentation_) {
+    // Scaling and cropping are done on the device, see GetAugmentationParams
+    return true;
+  }
+
   cv::Mat scaled_img;
   bool inception_scale_jitter = false;
   if (scale_jitter_type_ == INCEPTION_STYLE) {
@@ -701,31 +840,7 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
   if ((scale_jitter_type_ == NO_SCALE_JITTER) ||
     (scale_jitter_type_ == INCEPTION_STYLE && !inception_scale_jitter)) {
       int scaled_width, scaled_height;
-      int scale_to_use = scale_ > 0 ? scale_ : minsize_;
-
-      // set the random minsize
-      if (random_scaling_) {
-        scale_to_use = std::uniform_int_distribution<>(random_scale_[0],
-                                                       random_scale_[1])(*randgen);
-      }
-
-      if (warp_) {
-        scaled_width = scale_to_use;
-        scaled_height = scale_to_use;
-      } else if (img->rows > img->cols) {
-        scaled_width = scale_to_use;
-        scaled_height =
-            static_cast<float>(img->rows) * scale_to_use / img->cols;
-      } else {
-        scaled_height = scale_to_use;
-        scaled_width =
-            static_cast<float>(img->cols) * scale_to_use / img->rows;
-      }
-      if ((scale_ > 0 &&
-           (scaled_height != img->rows || scaled_width != img->cols))
-          || (scaled_height > img->rows || scaled_width > img->cols)) {
-        // We rescale in all cases if we are using scale_
-        // but only to make the image bigger if using minsize_
+      if (GetScaledSize(*img, randgen, &scaled_height, &scaled_width)) {
         /*
         LOG(INFO) << "Scaling to " << scaled_width << " x " << scaled_height
                   << " From " << img->cols << " x " << img->rows;
@@ -744,6 +859,229 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
   return true;
 }
 
+// Reads the size of a baseline or progressive JPEG from its frame header.
+// Returns false if data is not a JPEG or the header cannot be found.
+inline bool GetJpegSize(
+    const uint8_t* data,
+    const int size,
+    int* height,
+    int* width) {
+  if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+    return false;
+  }
+  int pos = 2;
+  while (pos + 4 <= size) {
+    if (data[pos] != 0xFF) {
+      return false;
+    }
+    const uint8_t marker = data[pos + 1];
+    if (marker == 0xFF) {
+      // fill byte
+      ++pos;
+      continue;
+    }
+    const int length = (data[pos + 2] << 8) | data[pos + 3];
+    // SOF0 - SOF15, except DHT (C4), JPG (C8) and DAC (CC)
+    if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 &&
+        marker != 0xC8 && marker != 0xCC) {
+      if (pos + 9 > size) {
+        return false;
+      }
+      *height = (data[pos + 5] << 8) | data[pos + 6];
+      *width = (data[pos + 7] << 8) | data[pos + 8];
+      return *height > 0 && *width > 0;
+    }
+    if (marker == 0xD9 || marker == 0xDA) {
+      // end of image or start of scan before any frame header
+      return false;
+    }
+    pos += 2 + length;
+  }
+  return false;
+}
+
+// Decodes an encoded image. With reduced_decode, a JPEG whose shortest side
+// is at least twice the scale it is resized to is decoded at 1/2, 1/4 or 1/8
+// of its size, which libjpeg does in the DCT domain: most of the inverse DCT,
+// upsampling and color conversion work is skipped, and so is part of the
+// resizing. This is only done when the image is always resized to scale_,
+// without a bounding box or inception-style cropping that would crop the
+// full resolution image first.
+template <class Context>
+cv::Mat ImageInputOp<Context>::DecodeImage(
+    const char* data,
+    int size,
+    const PerImageArg& info) {
+  // We use a cv::Mat to wrap the encoded str so we do not need a copy.
+  const cv::Mat encoded(1, size, CV_8UC1, const_cast<char*>(data));
+  int flags = color_ ? CV_LOAD_IMAGE_COLOR : CV_LOAD_IMAGE_GRAYSCALE;
+#ifdef CAFFE2_IMAGE_REDUCED_DECODE
+  int height, width;
+  if (reduced_decode_ && scale_ > 0 && !random_scaling_ &&
+      scale_jitter_type_ == NO_SCALE_JITTER && !info.bounding_params.valid &&
+      GetJpegSize(
+          reinterpret_cast<const uint8_t*>(data), size, &height, &width)) {
+    const int shortest = std::min(height, width);
+    // libjpeg rounds the reduced size up
+    if ((shortest + 7) / 8 >= scale_) {
+      flags = color_ ? cv::IMREAD_REDUCED_COLOR_8
+                     : cv::IMREAD_REDUCED_GRAYSCALE_8;
+    } else if ((shortest + 3) / 4 >= scale_) {
+      flags = color_ ? cv::IMREAD_REDUCED_COLOR_4
+                     : cv::IMREAD_REDUCED_GRAYSCALE_4;
+    } else if ((shortest + 1) / 2 >= scale_) {
+      flags = color_ ? cv::IMREAD_REDUCED_COLOR_2
+                     : cv::IMREAD_REDUCED_GRAYSCALE_2;
+    }
+  }
+#endif
+  return cv::imdecode(encoded, flags);
+}
+
+// Computes the size img is scaled to before cropping, and returns whether it
+// needs to be rescaled at all
+template <class Context>
+bool ImageInputOp<Context>::GetScaledSize(
+    const cv::Mat& img,
+    std::mt19937* randgen,
+    int* scaled_height,
+    int* scaled_width) {
+  int scale_to_use = scale_ > 0 ? scale_ : minsize_;
+
+  // set the random minsize
+  if (random_scaling_) {
+    scale_to_use = std::uniform_int_distribution<>(random_scale_[0],
+                                                   random_scale_[1])(*randgen);
+  }
+
+  if (warp_) {
+    *scaled_width = scale_to_use;
+    *scaled_height = scale_to_use;
+  } else if (img.rows > img.cols) {
+    *scaled_width = scale_to_use;
+    *scaled_height = static_cast<float>(img.rows) * scale_to_use / img.cols;
+  } else {
+    *scaled_height = scale_to_use;
+    *scaled_width = static_cast<float>(img.cols) * scale_to_use / img.rows;
+  }
+  // We rescale in all cases if we are using scale_
+  // but only to make the image bigger if using minsize_
+  return (scale_ > 0 &&
+          (*scaled_height != img.rows || *scaled_width != img.cols)) ||
+      (*scaled_height > img.rows || *scaled_width > img.cols);
+}
+
+// Draws the same random crop, mirroring and color augmentation as
+// TransformImage, but leaves the pixel work to AugmentOnGPU. window_img is
+// set to the part of img the crop is resampled from; if it is null, the
+// window is relative to the whole image, which is staged as is.
+template <class Context>
+void ImageInputOp<Context>::GetAugmentationParams(
+    const cv::Mat& img,
+    const int channels,
+    std::mt19937* randgen,
+    cv::Mat* window_img,
+    ImageAugmentationParams* params) {
+  float window_y, window_x, window_height, window_width;
+  cv::Rect roi;
+  if (scale_jitter_type_ == INCEPTION_STYLE && !is_test_ &&
+      RandomSizedCroppingWindow<Context>(img.rows, img.cols, randgen, &roi)) {
+    window_y = roi.y;
+    window_x = roi.x;
+    window_height = roi.height;
+    window_width = roi.width;
+  } else {
+    int scaled_height, scaled_width;
+    if (!GetScaledSize(img, randgen, &scaled_height, &scaled_width)) {
+      scaled_height = img.rows;
+      scaled_width = img.cols;
+    }
+    CAFFE_ENFORCE_GE(
+        scaled_height, crop_, "Image height must be bigger than crop.");
+    CAFFE_ENFORCE_GE(
+        scaled_width, crop_, "Image width must be bigger than crop.");
+    int width_offset, height_offset;
+    if (is_test_) {
+      width_offset = (scaled_width - crop_) / 2;
+      height_offset = (scaled_height - crop_) / 2;
+    } else {
+      width_offset =
+        std::uniform_int_distribution<>(0, scaled_width - crop_)(*randgen);
+      height_offset =
+        std::uniform_int_distribution<>(0, scaled_height - crop_)(*randgen);
+    }
+    const float scale_y = static_cast<float>(img.rows) / scaled_height;
+    const float scale_x = static_cast<float>(img.cols) / scaled_width;
+    window_y = height_offset * scale_y;
+    window_x = width_offset * scale_x;
+    window_height = crop_ * scale_y;
+    window_width = crop_ * scale_x;
+  }
+
+  std::bernoulli_distribution mirror_this_image(0.5f);
+  params->mirror = !is_test_ && mirror_ && mirror_this_image(*randgen);
+
+  for (int i = 0; i < 3; ++i) {
+    params->jitter_order[i] = -1;
+    params->jitter_alpha[i] = 1.0f;
+    params->lighting[i] = 0.0f;
+  }
+  if (color_jitter_ && channels == 3 && !is_test_) {
+    std::vector<int> jitter_order{0, 1, 2};
+    std::shuffle(jitter_order.begin(), jitter_order.end(), *randgen);
+    const float alpha_rand[3] = {
+        img_saturation_, img_brightness_, img_contrast_};
+    for (int i = 0; i < 3; ++i) {
+      const float r = alpha_rand[jitter_order[i]];
+      params->jitter_order[i] = jitter_order[i];
+      params->jitter_alpha[i] =
+          1.0f + std::uniform_real_distribution<float>(-r, r)(*randgen);
+    }
+  }
+  if (color_lighting_ && channels == 3 && !is_test_) {
+    std::normal_distribution<float> d(0, color_lighting_std_);
+    std::vector<float> alphas(3);
+    for (int i = 0; i < 3; ++i) {
+      alphas[i] = d(*randgen);
+    }
+    for (int i = 0; i < 3; ++i) {
+      float delta = 0;
+      for (int j = 0; j < 3; ++j) {
+        delta += color_lighting_eigvecs_[i][j] * color_lighting_eigvals_[j] *
+            alphas[j];
+      }
+      // the eigenvectors are in RGB order, the image in BGR
+      params->lighting[2 - i] = delta;
+    }
+  }
+
+  if (window_img == nullptr) {
+    params->height = img.rows;
+    params->width = img.cols;
+    params->window_y = window_y;
+    params->window_x = window_x;
+    params->window_height = window_height;
+    params->window_width = window_width;
+    return;
+  }
+
+  // Only the window, plus a pixel of margin for the bilinear filter, is
+  // copied to the device
+  const int y0 = std::max(0, static_cast<int>(std::floor(window_y)) - 1);
+  const int x0 = std::max(0, static_cast<int>(std::floor(window_x)) - 1);
+  const int y1 = std::min(
+      img.rows, static_cast<int>(std::ceil(window_y + window_height)) + 1);
+  const int x1 = std::min(
+      img.cols, static_cast<int>(std::ceil(window_x + window_width)) + 1);
+  *window_img = img(cv::Rect(x0, y0, x1 - x0, y1 - y0));
+  params->height = y1 - y0;
+  params->width = x1 - x0;
+  params->window_y = window_y - y0;
+  params->window_x = window_x - x0;
+  params->window_height = window_height;
+  params->window_width = window_width;
+}
+
 // assume HWC order and color channels BGR
 template <class Context>
 void Saturation(
@@ -904,6 +1242,43 @@ void ColorNormalization(
   }
 }
 
+// Copies the crop x crop window of img at (height_offset, width_offset) to
+// image_data as floats, mirrored if requested. With kNormalize, the mean is
+// subtracted and the result scaled by std on the fly.
+template <bool kNormalize>
+void CopyImageCrop(
+    const cv::Mat& img,
+    const int channels,
+    const int height_offset,
+    const int width_offset,
+    const int crop,
+    const bool mirror,
+    const float* mean,
+    const float* std,
+    float* image_data) {
+  float m[3] = {0, 0, 0};
+  float s[3] = {1, 1, 1};
+  if (kNormalize) {
+    for (int c = 0; c < channels; ++c) {
+      m[c] = mean[c];
+      s[c] = std[c];
+    }
+  }
+  // Walking the row backwards mirrors it
+  const int step = mirror ? -channels : channels;
+  for (int h = height_offset; h < height_offset + crop; ++h) {
+    const uint8_t* cv_data = img.ptr(h) +
+        (mirror ? width_offset + crop - 1 : width_offset) * channels;
+    for (int w = 0; w < crop; ++w, cv_data += step) {
+      for (int c = 0; c < channels; ++c) {
+        *(image_data++) = kNormalize
+            ? (static_cast<float>(cv_data[c]) - m[c]) * s[c]
+            : static_cast<float>(cv_data[c]);
+      }
+    }
+  }
+}
+
 // Factored out image transformation
 template <class Context>
 void TransformImage(
@@ -942,34 +1317,25 @@ void TransformImage(
       std::uniform_int_distribution<>(0, scaled_img.rows - crop)(*randgen);
   }
 
-  float* image_data_ptr = image_data;
-  if (!is_test && mirror && (*mirror_this_image)(*randgen)) {
-    // Copy mirrored image.
-    for (int h = height_offset; h < height_offset + crop; ++h) {
-      for (int w = width_offset + crop - 1; w >= width_offset; --w) {
-        const uint8_t* cv_data = scaled_img.ptr(h) + w * channels;
-        for (int c = 0; c < channels; ++c) {
-          *(image_data_ptr++) = static_cast<float>(cv_data[c]);
-        }
-      }
-    }
-  } else {
-    // Copy normally.
-    for (int h = height_offset; h < height_offset + crop; ++h) {
-      for (int w = width_offset; w < width_offset + crop; ++w) {
-        const uint8_t* cv_data = scaled_img.ptr(h) + w * channels;
-        for (int c = 0; c < channels; ++c) {
-          *(image_data_ptr++) = static_cast<float>(cv_data[c]);
-        }
-      }
-    }
+  const bool mirror_image =
+      !is_test && mirror && (*mirror_this_image)(*randgen);
+  const bool jitter = color_jitter && channels == 3 && !is_test;
+  const bool lighting = color_lighting && channels == 3 && !is_test;
+  if (!jitter && !lighting) {
+    // Nothing to do between the copy and the normalization, so they are done
+    // in a single pass over the crop.
+    CopyImageCrop<true>(scaled_img, channels, height_offset, width_offset,
+      crop, mirror_image, mean.data(), std.data(), image_data);
+    return;
   }
+  CopyImageCrop<false>(scaled_img, channels, height_offset, width_offset,
+    crop, mirror_image, nullptr, nullptr, image_data);
 
-  if (color_jitter && channels == 3 && !is_test) {
+  if (jitter) {
     ColorJitter<Context>(image_data, crop, saturation, brightness, contrast,
       randgen);
   }
-  if (color_lighting && channels == 3 && !is_test) {
+  if (lighting) {
     ColorLighting<Context>(image_data, crop, color_lighting_std,
       color_lighting_eigvecs, color_lighting_eigvals, randgen);
   }
@@ -1074,6 +1440,204 @@ void ImageInputOp<Context>::DecodeAndTransposeOnly(
                               randgen, &mirror_this_image, is_test_);
 }
 
+template <class Context>
+void ImageInputOp<Context>::DecodeForGPUAugmentation(
+    const std::string& value, int item_id, const int channels,
+    std::size_t thread_index) {
+
+  CAFFE_ENFORCE((int)thread_index < num_decode_threads_);
+
+  std::mt19937* randgen = &(randgen_per_thread_[thread_index]);
+
+  cv::Mat img;
+  // Decode the image
+  PerImageArg info;
+  CHECK(GetImageAndLabelAndInfoFromDBValue(value, &img, info, item_id,
+    randgen));
+
+  GetAugmentationParams(img, channels, randgen, &decoded_images_[item_id],
+                        &augmentation_params_[item_id]);
+}
+
+// Parses a raw image record straight into its place in staging_data, and
+// draws its augmentation parameters.
+template <class Context>
+void ImageInputOp<Context>::DecodeRawForGPUAugmentation(
+    const std::string& value, uint8_t* staging_data, int item_id,
+    const int channels, std::size_t thread_index) {
+
+  CAFFE_ENFORCE((int)thread_index < num_decode_threads_);
+
+  std::mt19937* randgen = &(randgen_per_thread_[thread_index]);
+
+  const size_t offset = batch_size_ * sizeof(ImageAugmentationParams) +
+      item_id * raw_height_ * raw_width_ * channels;
+  cv::Mat img;
+  PerImageArg info;
+  CHECK(GetImageAndLabelAndInfoFromDBValue(value, &img, info, item_id,
+    randgen, staging_data + offset));
+
+  // Only the size of the image is read
+  const cv::Mat image(
+      raw_height_, raw_width_, CV_8UC(channels), staging_data + offset);
+  GetAugmentationParams(image, channels, randgen, nullptr,
+                        &augmentation_params_[item_id]);
+  augmentation_params_[item_id].offset = offset;
+}
+
+template <class Context>
+void ImageInputOp<Context>::CopyMeanStdToDevice() {
+  if (!mean_std_copied_) {
+    mean_gpu_.Resize(mean_.size());
+    std_gpu_.Resize(std_.size());
+
+    context_.template Copy<float, CPUContext, Context>(
+      mean_.size(), mean_.data(), mean_gpu_.template mutable_data<float>());
+    context_.template Copy<float, CPUContext, Context>(
+      std_.size(), std_.data(), std_gpu_.template mutable_data<float>());
+    mean_std_copied_ = true;
+  }
+}
+
+// Stages the decoded images [begin, end) of the batch and augments them into
+// the prefetch slot's prefetched_image_on_device_. The copy and the kernel
+// are asynchronous, so the caller can decode the next chunk meanwhile.
+template <class Context>
+void ImageInputOp<Context>::AugmentChunkOnGPU(
+    int begin, int end, const int channels) {
+  const int n = end - begin;
+  const int buffer = (begin / gpu_augmentation_chunk_) % 2;
+  auto* event = staging_events_[buffer].get();
+  // Wait for the chunk previously staged in this buffer to be done with it
+  if (event->Query() != EventStatus::EVENT_INITIALIZED) {
+    event->Finish();
+    event->Reset();
+  }
+
+  // Layout: the parameters of the n images, then the pixels of each window
+  size_t bytes = n * sizeof(ImageAugmentationParams);
+  for (int i = begin; i < end; ++i) {
+    augmentation_params_[i].offset = bytes;
+    bytes += decoded_images_[i].rows * decoded_images_[i].cols * channels;
+  }
+  auto& staging = staging_[buffer];
+  if (staging.size() < bytes) {
+    staging.Resize(TIndex(bytes));
+  }
+  uint8_t* staging_data = staging.template mutable_data<uint8_t>();
+  memcpy(
+      staging_data,
+      &augmentation_params_[begin],
+      n * sizeof(ImageAugmentationParams));
+  for (int i = begin; i < end; ++i) {
+    thread_pool_->runTask([this, staging_data, i, channels]() {
+      cv::Mat& img = decoded_images_[i];
+      uint8_t* dst = staging_data + augmentation_params_[i].offset;
+      const int row_bytes = img.cols * channels;
+      for (int h = 0; h < img.rows; ++h) {
+        memcpy(dst + h * row_bytes, img.ptr(h), row_bytes);
+      }
+      img.release();
+    });
+  }
+  thread_pool_->waitWorkComplete();
+
+  auto& staging_on_device = staging_on_device_[buffer];
+  if (staging_on_device.size() < bytes) {
+    staging_on_device.Resize(TIndex(bytes));
+  }
+  uint8_t* staging_on_device_data =
+      staging_on_device.template mutable_data<uint8_t>();
+  context_.template CopyBytes<CPUContext, Context>(
+      bytes, staging_data, staging_on_device_data);
+
+  const int offset = begin * channels * crop_ * crop_;
+  auto& image_on_device = prefetched_image_on_device_[this->prefetch_slot()];
+  if (output_type_ == TensorProto_DataType_FLOAT) {
+    AugmentOnGPU<float, Context>(
+        staging_on_device_data, n, channels, crop_,
+        mean_gpu_.template data<float>(), std_gpu_.template data<float>(),
+        image_on_device.template mutable_data<float>() + offset,
+        &context_);
+  } else {
+    AugmentOnGPU<float16, Context>(
+        staging_on_device_data, n, channels, crop_,
+        mean_gpu_.template data<float>(), std_gpu_.template data<float>(),
+        image_on_device.template mutable_data<float16>() + offset,
+        &context_);
+  }
+  context_.Record(event);
+}
+
+// Takes the size of the raw images from the first record, and returns the
+// host staging buffer of the batch: the augmentation parameters of the
+// batch_size_ images, followed by their pixels.
+template <class Context>
+uint8_t* ImageInputOp<Context>::GetRawStagingBuffer(
+    const TensorProto& image_proto, const int channels) {
+  if (raw_height_ == 0) {
+    CAFFE_ENFORCE_EQ(image_proto.data_type(), TensorProto::BYTE,
+                     "raw_images requires raw image records");
+    CAFFE_ENFORCE_GE(image_proto.dims_size(), 2);
+    const int src_c =
+        (image_proto.dims_size() == 3) ? image_proto.dims(2) : 1;
+    CAFFE_ENFORCE_EQ(src_c, channels,
+                     "raw images must have the channels of the output");
+    raw_height_ = image_proto.dims(0);
+    raw_width_ = image_proto.dims(1);
+    LOG(INFO) << "Raw images are " << raw_height_ << "x" << raw_width_;
+  }
+
+  // Wait for the previous batch to be done with the buffer
+  auto* event = staging_events_[0].get();
+  if (event->Query() != EventStatus::EVENT_INITIALIZED) {
+    event->Finish();
+    event->Reset();
+  }
+  const size_t bytes = batch_size_ * (sizeof(ImageAugmentationParams) +
+                                      raw_height_ * raw_width_ * channels);
+  auto& staging = staging_[0];
+  if (staging.size() < bytes) {
+    staging.Resize(TIndex(bytes));
+  }
+  return staging.template mutable_data<uint8_t>();
+}
+
+// Copies the staging buffer filled by DecodeRawForGPUAugmentation to the
+// device in one transfer, and augments the whole batch.
+template <class Context>
+void ImageInputOp<Context>::AugmentRawBatchOnGPU(const int channels) {
+  uint8_t* staging_data = staging_[0].template mutable_data<uint8_t>();
+  memcpy(
+      staging_data,
+      augmentation_params_.data(),
+      batch_size_ * sizeof(ImageAugmentationParams));
+  const size_t bytes = batch_size_ * (sizeof(ImageAugmentationParams) +
+                                      raw_height_ * raw_width_ * channels);
+
+  auto& staging_on_device = staging_on_device_[0];
+  if (staging_on_device.size() < bytes) {
+    staging_on_device.Resize(TIndex(bytes));
+  }
+  uint8_t* staging_on_device_data =
+      staging_on_device.template mutable_data<uint8_t>();
+  context_.template CopyBytes<CPUContext, Context>(
+      bytes, staging_data, staging_on_device_data);
+
+  auto& image_on_device = prefetched_image_on_device_[this->prefetch_slot()];
+  if (output_type_ == TensorProto_DataType_FLOAT) {
+    AugmentOnGPU<float, Context>(
+        staging_on_device_data, batch_size_, channels, crop_,
+        mean_gpu_.template data<float>(), std_gpu_.template data<float>(),
+        image_on_device.template mutable_data<float>(), &context_);
+  } else {
+    AugmentOnGPU<float16, Context>(
+        staging_on_device_data, batch_size_, channels, crop_,
+        mean_gpu_.template data<float>(), std_gpu_.template data<float>(),
+        image_on_device.template mutable_data<float16>(), &context_);
+  }
+  context_.Record(staging_events_[0].get());
+}
 
 template <class Context>
 bool ImageInputOp<Context>::Prefetch() {
@@ -1085,7 +1649,13 @@ bool ImageInputOp<Context>::Prefetch() {
   }
   const int channels = color_ ? 3 : 1;
   // Call mutable_data() once to allocate the underlying memory.
-  if (gpu_transform_) {
+  if (gpu_augmentation_) {
+    // the images are augmented straight into the device tensor, chunk by
+    // chunk
+    prefetched_image_on_device_[this->prefetch_slot()].Resize(
+        TIndex(batch_size_), TIndex(channels), TIndex(crop_), TIndex(crop_));
+    CopyMeanStdToDevice();
+  } else if (gpu_transform_) {
     // we'll transfer up in int8, then convert later
     prefetched_image_.mutable_data<uint8_t>();
   } else {
@@ -1093,14 +1663,19 @@ bool ImageInputOp<Context>::Prefetch() {
   }
 
   prefetched_label_.mutable_data<int>();
+  uint8_t* raw_staging_data = nullptr;
   // Prefetching handled with a thread pool of "decode_threads" threads.
 
+  Timer batch_timer;
+  float read_time_us = 0;
   for (int item_id = 0; item_id < batch_size_; ++item_id) {
     std::string key, value;
     cv::Mat img;
 
     // read data
+    Timer read_timer;
     reader_->Read(&key, &value);
+    read_time_us += read_timer.MicroSeconds();
 
     // determine label type based on first item
     if( item_id == 0 ) {
@@ -1134,19 +1709,51 @@ bool ImageInputOp<Context>::Prefetch() {
             LOG(FATAL) << "Unsupported output type.";
           }
         }
+
+        if (raw_images_) {
+          raw_staging_data = GetRawStagingBuffer(protos.protos(0), channels);
+        }
       }
     }
 
-    // launch into thread pool for processing
+    // launch into thread pool for processing; value is not used afterwards,
+    // so it is moved into the task instead of copied
     // TODO: support color jitter and color lighting in gpu_transform
-    if (gpu_transform_) {
+    if (raw_images_) {
+      thread_pool_->runTaskWithID(std::bind(
+          &ImageInputOp<Context>::DecodeRawForGPUAugmentation,
+          this,
+          std::move(value),
+          raw_staging_data,
+          item_id,
+          channels,
+          std::placeholders::_1));
+    } else if (gpu_augmentation_) {
+      thread_pool_->runTaskWithID(std::bind(
+          &ImageInputOp<Context>::DecodeForGPUAugmentation,
+          this,
+          std::move(value),
+          item_id,
+          channels,
+          std::placeholders::_1));
+      // Hand every chunk to the device as soon as it is decoded, so that its
+      // copy and augmentation overlap with the decoding of the next one.
+      if ((item_id + 1) % gpu_augmentation_chunk_ == 0 ||
+          item_id + 1 == batch_size_) {
+        thread_pool_->waitWorkComplete();
+        AugmentChunkOnGPU(
+            item_id / gpu_augmentation_chunk_ * gpu_augmentation_chunk_,
+            item_id + 1,
+            channels);
+      }
+    } else if (gpu_transform_) {
       // output of decode will still be int8
       uint8_t* image_data = prefetched_image_.mutable_data<uint8_t>() +
           crop_ * crop_ * channels * item_id;
       thread_pool_->runTaskWithID(std::bind(
           &ImageInputOp<Context>::DecodeAndTransposeOnly,
           this,
-          std::string(value),
+          std::move(value),
           image_data,
           item_id,
           channels,
@@ -1157,7 +1764,7 @@ bool ImageInputOp<Context>::Prefetch() {
       thread_pool_->runTaskWithID(std::bind(
           &ImageInputOp<Context>::DecodeAndTransform,
           this,
-          std::string(value),
+          std::move(value),
           image_data,
           item_id,
           channels,
@@ -1165,18 +1772,35 @@ bool ImageInputOp<Context>::Prefetch() {
     }
   }
   thread_pool_->waitWorkComplete();
+  if (raw_images_) {
+    AugmentRawBatchOnGPU(channels);
+  }
+  CAFFE_EVENT(stage_stats_, read_us, static_cast<int64_t>(read_time_us));
+  CAFFE_EVENT(
+      stage_stats_,
+      decode_us,
+      static_cast<int64_t>(batch_timer.MicroSeconds() - read_time_us));
+  Timer copy_timer;
 
   // If the context is not CPUContext, we will need to do a copy in the
-  // prefetch function as well.
+  // prefetch function as well. It runs asynchronously, into the current slot.
   if (!std::is_same<Context, CPUContext>::value) {
-    prefetched_image_on_device_.CopyFrom(prefetched_image_, &context_);
-    prefetched_label_on_device_.CopyFrom(prefetched_label_, &context_);
+    const int slot = this->prefetch_slot();
+    if (!gpu_augmentation_) {
+      this->CopyToDeviceAsync(
+          &prefetched_image_, &prefetched_image_on_device_[slot], 0);
+    }
+    this->CopyToDeviceAsync(
+        &prefetched_label_, &prefetched_label_on_device_[slot], 1);
 
-    for (int i = 0; i < prefetched_additional_outputs_on_device_.size(); ++i) {
-      prefetched_additional_outputs_on_device_[i].CopyFrom(
-          prefetched_additional_outputs_[i], &context_);
+    auto& additional_outputs = prefetched_additional_outputs_on_device_[slot];
+    for (int i = 0; i < additional_outputs.size(); ++i) {
+      this->CopyToDeviceAsync(
+          &prefetched_additional_outputs_[i], &additional_outputs[i], 2 + i);
     }
   }
+  CAFFE_EVENT(
+      stage_stats_, copy_us, static_cast<int64_t>(copy_timer.MicroSeconds()));
   return true;
 }
 
@@ -1202,38 +1826,33 @@ bool ImageInputOp<Context>::CopyPrefetched() {
           prefetched_additional_outputs_[i], &context_);
     }
   } else {
+    const int slot = this->consume_slot();
+    auto& image_on_device = prefetched_image_on_device_[slot];
     // TODO: support color jitter and color lighting in gpu_transform
-    if (gpu_transform_) {
-      if (!mean_std_copied_) {
-        mean_gpu_.Resize(mean_.size());
-        std_gpu_.Resize(std_.size());
-
-        context_.template Copy<float, CPUContext, Context>(
-          mean_.size(), mean_.data(), mean_gpu_.template mutable_data<float>());
-        context_.template Copy<float, CPUContext, Context>(
-          std_.size(), std_.data(), std_gpu_.template mutable_data<float>());
-        mean_std_copied_ = true;
-      }
+    if (gpu_augmentation_) {
+      image_output->CopyFrom(image_on_device, &context_);
+    } else if (gpu_transform_) {
+      CopyMeanStdToDevice();
       // GPU transform kernel allows explicitly setting output type
       if (output_type_ == TensorProto_DataType_FLOAT) {
-        TransformOnGPU<uint8_t,float,Context>(prefetched_image_on_device_,
+        TransformOnGPU<uint8_t,float,Context>(image_on_device,
                                               image_output, mean_gpu_,
                                               std_gpu_, &context_);
       } else if (output_type_ == TensorProto_DataType_FLOAT16) {
-        TransformOnGPU<uint8_t,float16,Context>(prefetched_image_on_device_,
+        TransformOnGPU<uint8_t,float16,Context>(image_on_device,
                                                 image_output, mean_gpu_,
                                                 std_gpu_, &context_);
       }  else {
         return false;
       }
     } else {
-      image_output->CopyFrom(prefetched_image_on_device_, &context_);
+      image_output->CopyFrom(image_on_device, &context_);
     }
-    label_output->CopyFrom(prefetched_label_on_device_, &context_);
+    label_output->CopyFrom(prefetched_label_on_device_[slot], &context_);
 
     for (int i = 0; i < additional_outputs_output.size(); ++i) {
       additional_outputs_output[i]->CopyFrom(
-          prefetched_additional_outputs_on_device_[i], &context_);
+          prefetched_additional_outputs_on_device_[slot][i], &context_);
     }
   }
   return true;
@@ -62,6 +62,139 @@ __global__ void transform_kernel(
   }
 }
 
+// Threads per block of augment_kernel, one block per image.
+constexpr int kAugmentThreads = 256;
+
+// Samples the C channels of output pixel (y, x) of the window of p, with a
+// bilinear filter when upsampling and a box filter over the footprint of the
+// pixel when downsampling, so that large reductions do not alias.
+__device__ void sample_pixel(
+    const uint8_t* img,
+    const ImageAugmentationParams& p,
+    const int C,
+    const int crop,
+    const int y,
+    const int x,
+    float* v) {
+  const float sy = p.window_height / crop;
+  const float sx = p.window_width / crop;
+  const float fy = p.window_y + y * sy;
+  const float fx = p.window_x + x * sx;
+  if (sy > 1.0f || sx > 1.0f) {
+    const int y0 = min(static_cast<int>(fy), p.height - 1);
+    const int x0 = min(static_cast<int>(fx), p.width - 1);
+    const int y1 =
+        max(y0 + 1, min(p.height, static_cast<int>(ceilf(fy + sy))));
+    const int x1 =
+        max(x0 + 1, min(p.width, static_cast<int>(ceilf(fx + sx))));
+    const float scale = 1.0f / ((y1 - y0) * (x1 - x0));
+    for (int c = 0; c < C; ++c) {
+      float sum = 0.0f;
+      for (int h = y0; h < y1; ++h) {
+        for (int w = x0; w < x1; ++w) {
+          sum += img[(h * p.width + w) * C + c];
+        }
+      }
+      v[c] = sum * scale;
+    }
+    return;
+  }
+  const float cy = min(max(fy + 0.5f * sy - 0.5f, 0.0f), p.height - 1.0f);
+  const float cx = min(max(fx + 0.5f * sx - 0.5f, 0.0f), p.width - 1.0f);
+  const int y0 = static_cast<int>(cy);
+  const int x0 = static_cast<int>(cx);
+  const int y1 = min(y0 + 1, p.height - 1);
+  const int x1 = min(x0 + 1, p.width - 1);
+  const float dy = cy - y0;
+  const float dx = cx - x0;
+  for (int c = 0; c < C; ++c) {
+    const float top = img[(y0 * p.width + x0) * C + c] * (1 - dx) +
+        img[(y0 * p.width + x1) * C + c] * dx;
+    const float bottom = img[(y1 * p.width + x0) * C + c] * (1 - dx) +
+        img[(y1 * p.width + x1) * C + c] * dx;
+    v[c] = top * (1 - dy) + bottom * dy;
+  }
+}
+
+// input in (uint8, HWC, any size), output in (Out, NCHW, crop x crop)
+template <typename Out>
+__global__ void augment_kernel(
+    const uint8_t* staging,
+    const int C,
+    const int crop,
+    const float* mean,
+    const float* std,
+    Out* out) {
+  __shared__ float partial[kAugmentThreads];
+
+  const int n = blockIdx.x;
+  const auto& p = reinterpret_cast<const ImageAugmentationParams*>(staging)[n];
+  const uint8_t* img = staging + p.offset;
+  const int tid = threadIdx.y * blockDim.x + threadIdx.x;
+  const int plane = crop * crop;
+  Out* output_ptr = &out[n * C * plane];
+
+  // Contrast blends with the mean gray level of the image. Saturation keeps
+  // the gray level of every pixel and brightness scales it, so the mean at
+  // the time contrast is applied follows from the one of the crop.
+  bool contrast = false;
+  for (int k = 0; k < 3 && p.jitter_order[k] >= 0; ++k) {
+    contrast |= p.jitter_order[k] == 2;
+  }
+  float gray_mean = 0.0f;
+  if (C == 3 && contrast) {
+    float sum = 0.0f;
+    for (int i = tid; i < plane; i += kAugmentThreads) {
+      float v[3];
+      sample_pixel(img, p, C, crop, i / crop, i % crop, v);
+      sum += v[0] * 0.114f + v[1] * 0.587f + v[2] * 0.299f;
+    }
+    partial[tid] = sum;
+    __syncthreads();
+    for (int s = kAugmentThreads / 2; s > 0; s >>= 1) {
+      if (tid < s) {
+        partial[tid] += partial[tid + s];
+      }
+      __syncthreads();
+    }
+    gray_mean = partial[0] / plane;
+  }
+
+  for (int i = tid; i < plane; i += kAugmentThreads) {
+    const int x = i % crop;
+    float v[3];
+    sample_pixel(img, p, C, crop, i / crop, p.mirror ? crop - 1 - x : x, v);
+    if (C == 3) {
+      float m = gray_mean;
+      for (int k = 0; k < 3 && p.jitter_order[k] >= 0; ++k) {
+        const float alpha = p.jitter_alpha[k];
+        if (p.jitter_order[k] == 0) {
+          const float gray = v[0] * 0.114f + v[1] * 0.587f + v[2] * 0.299f;
+          for (int c = 0; c < 3; ++c) {
+            v[c] = v[c] * alpha + gray * (1.0f - alpha);
+          }
+        } else if (p.jitter_order[k] == 1) {
+          for (int c = 0; c < 3; ++c) {
+            v[c] *= alpha;
+          }
+          m *= alpha;
+        } else {
+          for (int c = 0; c < 3; ++c) {
+            v[c] = v[c] * alpha + m * (1.0f - alpha);
+          }
+        }
+      }
+      for (int c = 0; c < 3; ++c) {
+        v[c] += p.lighting[c];
+      }
+    }
+    for (int c = 0; c < C; ++c) {
+      output_ptr[c * plane + i] =
+          convert::To<float, Out>((v[c] - mean[c]) * std[c]);
+    }
+  }
+}
+
 }
 
 template <typename T_IN, typename T_OUT, class Context>
@@ -96,4 +229,29 @@ template bool TransformOnGPU<uint8_t, float16, CUDAContext>(Tensor<CUDAContext>&
                                                             Tensor<CUDAContext>& std,
                                                             CUDAContext *context);
 
+template <typename T_OUT, class Context>
+bool AugmentOnGPU(const uint8_t* staging, const int N, const int C,
+                  const int crop, const float* mean, const float* std,
+                  T_OUT* out, Context* context) {
+  augment_kernel<T_OUT>
+      <<<N, dim3(16, kAugmentThreads / 16), 0, context->cuda_stream()>>>(
+          staging, C, crop, mean, std, out);
+  return true;
+}
+
+template bool AugmentOnGPU<float, CUDAContext>(const uint8_t* staging,
+                                               const int N, const int C,
+                                               const int crop,
+                                               const float* mean,
+                                               const float* std, float* out,
+                                               CUDAContext* context);
+
+template bool AugmentOnGPU<float16, CUDAContext>(const uint8_t* staging,
+                                                 const int N, const int C,
+                                                 const int crop,
+                                                 const float* mean,
+                                                 const float* std,
+                                                 float16* out,
+                                                 CUDAContext* context);
+
 }  // namespace caffe2
@@ -51,6 +51,35 @@ bool TransformOnGPU(Tensor<Context>& X, Tensor<Context>* Y,
                     Tensor<Context>& mean, Tensor<Context>& std,
                     Context* context);
 
+// Per-image parameters of AugmentOnGPU. They are drawn on the CPU by the
+// decode threads, so that the device only runs the pixel work.
+struct ImageAugmentationParams {
+  // Offset of the decoded HWC uint8 image in the staging buffer, and its size.
+  int64_t offset;
+  int height;
+  int width;
+  // Window of the decoded image that is resampled to the crop x crop output.
+  float window_y;
+  float window_x;
+  float window_height;
+  float window_width;
+  int mirror;
+  // Order in which saturation (0), brightness (1) and contrast (2) are
+  // applied, with their alphas; -1 marks the end of the list.
+  int jitter_order[3];
+  float jitter_alpha[3];
+  // Color lighting offset of every channel, in BGR order.
+  float lighting[3];
+};
+
+// Crops, resizes, mirrors, color jitters and normalizes a chunk of N decoded
+// images on the device. staging holds N ImageAugmentationParams, followed by
+// the image data they point to; out is NCHW with crop x crop images.
+template <typename T_OUT, class Context>
+bool AugmentOnGPU(const uint8_t* staging, const int N, const int C,
+                  const int crop, const float* mean, const float* std,
+                  T_OUT* out, Context* context);
+
 }  // namespace caffe2
 
 #endif
@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/mkl/mkl_utils.h"
+
+#ifdef CAFFE2_HAS_MKL_DNN
+
+namespace caffe2 {
+namespace mkl {
+
+template <typename T>
+class MKLConcatOp final : public MKLOperator<T> {
+ public:
+  USE_MKLOPERATOR_FUNCTIONS(T);
+
+  MKLConcatOp(const OperatorDef& operator_def, Workspace* ws)
+      : MKLOperator<T>(operator_def, ws) {
+    int axis = 1;
+    if (OperatorBase::HasArgument("axis")) {
+      axis = OperatorBase::GetSingleArgument<int>("axis", -1);
+    } else if (OperatorBase::HasArgument("order")) {
+      OPERATOR_NEEDS_FEATURE(
+          OperatorBase::GetSingleArgument<string>("order", "NCHW") == "NCHW",
+          "Only NCHW order supported.");
+    }
+    OPERATOR_NEEDS_FEATURE(axis == 1, "Only concatenation on axis 1 supported.");
+    OPERATOR_NEEDS_FEATURE(
+        OperatorBase::GetSingleArgument<int>("add_axis", 0) == 0,
+        "add_axis not supported.");
+  }
+
+  bool RunOnDevice() override {
+    const MKLMemory<T>& X0 = Input(0);
+    MKLMemory<T>* Y = Output(0);
+    TensorCPU* split = OperatorBase::Output<TensorCPU>(1);
+    CAFFE_ENFORCE_EQ(X0.ndim(), 4);
+    CAFFE_ENFORCE_LE(
+        InputSize(),
+        dnnResourceNumber - dnnResourceMultipleSrc,
+        "Too many inputs for the MKL concat primitive.");
+
+    bool dims_changed = input_size_cache_.size() != size_t(InputSize());
+    input_size_cache_.resize(InputSize());
+    for (int i = 0; i < InputSize(); ++i) {
+      if (input_size_cache_[i] != Input(i).dims()) {
+        input_size_cache_[i] = Input(i).dims();
+        dims_changed = true;
+      }
+    }
+    if (dims_changed) {
+      vector<TIndex> Y_dims = X0.dims();
+      Y_dims[1] = 0;
+      vector<dnnLayout_t> layouts(InputSize());
+      for (int i = 0; i < InputSize(); ++i) {
+        const MKLMemory<T>& Xi = Input(i);
+        CAFFE_ENFORCE_EQ(Xi.ndim(), 4);
+        for (int d = 0; d < 4; ++d) {
+          CAFFE_ENFORCE(
+              d == 1 || Xi.dim(d) == X0.dim(d),
+              "Cannot concat inputs of different shapes, input ",
+              i,
+              " differs from input 0 on dimension ",
+              d);
+        }
+        Y_dims[1] += Xi.dim(1);
+        layouts[i] = Xi.layout();
+      }
+      primitive_.Reset(
+          dnnConcatCreate<T>, nullptr, InputSize(), layouts.data());
+      Y->Reset(Y_dims, primitive_, dnnResourceDst);
+      buffer_.Reset(Y_dims, primitive_, dnnResourceDst, true);
+    }
+
+    split->Resize(vector<TIndex>(1, InputSize()));
+    int* split_data = split->template mutable_data<int>();
+    for (int i = 0; i < InputSize(); ++i) {
+      split_data[i] = Input(i).dim32(1);
+      resources_[dnnResourceMultipleSrc + i] = Input(i).buffer();
+    }
+    // Try to share from the output: this allows us to avoid unnecessary copy
+    // operations, if the output is already allocated and is having the same
+    // layout as the buffer has.
+    buffer_.ShareFrom(*Y);
+    resources_[dnnResourceDst] = buffer_.buffer();
+    ExecutePrimitive();
+    buffer_.CopyTo(Y, primitive_, dnnResourceDst);
+    return true;
+  }
+};
+
+} // namespace mkl
+
+REGISTER_MKL_OPERATOR(Concat, mkl::MKLConcatOp<float>);
+
+} // namespace caffe2
+
+#endif // CAFFE2_HAS_MKL_DNN
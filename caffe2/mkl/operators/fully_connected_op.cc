@@ -28,7 +28,8 @@ class MKLFullyConnectedOp final : public MKLOperator<T> {
  public:
   MKLFullyConnectedOp(const OperatorDef& operator_def, Workspace* ws)
       : MKLOperator<T>(operator_def, ws),
-        axis_(OperatorBase::GetSingleArgument<int32_t>("axis", 1)) {}
+        axis_(OperatorBase::GetSingleArgument<int32_t>("axis", 1)),
+        relu_(OperatorBase::GetSingleArgument<bool>("relu", false)) {}
   ~MKLFullyConnectedOp() {}
 
   bool RunOnDevice() override {
@@ -76,6 +77,12 @@ class MKLFullyConnectedOp final : public MKLOperator<T> {
 
       input_layout_.Reset(primitive_, dnnResourceSrc);
       filter_layout_.Reset(primitive_, dnnResourceFilter);
+      if (relu_) {
+        // The ReLU runs in place on the internal output buffer, before it is
+        // converted to the layout of Y.
+        relu_primitive_.Reset(
+            dnnReLUCreateForward<T>, nullptr, buffer_.layout(), 0.f);
+      }
     }
 
     // Try to share from the output: this allows us to avoid unnecessary copy
@@ -95,6 +102,11 @@ class MKLFullyConnectedOp final : public MKLOperator<T> {
     resources_[dnnResourceDst] = buffer_.buffer();
 
     MKLDNN_SAFE_CALL(mkl::dnnExecute<T>(primitive_, resources_));
+    if (relu_) {
+      relu_resources_[dnnResourceSrc] = buffer_.buffer();
+      relu_resources_[dnnResourceDst] = buffer_.buffer();
+      MKLDNN_SAFE_CALL(mkl::dnnExecute<T>(relu_primitive_, relu_resources_));
+    }
     buffer_.CopyTo(Y, primitive_, dnnResourceDst);
     return true;
   }
@@ -103,6 +115,8 @@ class MKLFullyConnectedOp final : public MKLOperator<T> {
   // Input: X, W, b
   // Output: Y
   size_t axis_{1};
+  // If true, a ReLU is applied to the output.
+  bool relu_;
   vector<TIndex> cached_input_dims_;
   vector<TIndex> cached_filter_dims_;
   PrimitiveWrapper<T> primitive_;
@@ -111,6 +125,8 @@ class MKLFullyConnectedOp final : public MKLOperator<T> {
   LayoutWrapper<T> bias_layout_;
   MKLMemory<T> buffer_;
   void* resources_[dnnResourceNumber] = {0};
+  PrimitiveWrapper<T> relu_primitive_;
+  void* relu_resources_[dnnResourceNumber] = {0};
   INPUT_TAGS(INPUT, FILTER, BIAS);
 };
 
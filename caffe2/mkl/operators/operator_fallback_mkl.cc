@@ -25,7 +25,6 @@
 #include "caffe2/operators/load_save_op.h"
 #include "caffe2/operators/loss_op.h"
 #include "caffe2/operators/reshape_op.h"
-#include "caffe2/operators/softmax_op.h"
 #include "caffe2/operators/utility_ops.h"
 
 namespace caffe2 {
@@ -43,9 +42,6 @@ struct SigmoidCPUFunctor {
 
 // can add more non-MKL operators if needed
 namespace caffe2 {
-REGISTER_MKL_OPERATOR(
-    Softmax,
-    mkl::MKLFallbackOp<SoftmaxOp<float, CPUContext>>);
 REGISTER_MKL_OPERATOR(
     Reshape,
     mkl::MKLFallbackOp<ReshapeOp<float, CPUContext>, SkipIndices<1>>);
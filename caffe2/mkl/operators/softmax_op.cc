@@ -0,0 +1,106 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/mkl/mkl_utils.h"
+#include "caffe2/operators/softmax_shared.h"
+#include "caffe2/utils/math.h"
+
+#ifdef CAFFE2_HAS_MKL_DNN
+
+namespace caffe2 {
+namespace mkl {
+
+// There is no MKL primitive for softmax. The op reads the input in its user
+// layout, which is what the inner product produces, so that an FC followed by
+// a Softmax does not need any conversion, and writes Y in the user layout.
+template <typename T>
+class MKLSoftmaxOp final : public MKLOperator<T> {
+ public:
+  USE_MKLOPERATOR_FUNCTIONS(T);
+
+  MKLSoftmaxOp(const OperatorDef& operator_def, Workspace* ws)
+      : MKLOperator<T>(operator_def, ws),
+        axis_(OperatorBase::GetSingleArgument<int>("axis", 1)) {}
+
+  bool RunOnDevice() override {
+    const MKLMemory<T>& X = Input(0);
+    MKLMemory<T>* Y = Output(0);
+    CAFFE_ENFORCE(&X != Y, "Softmax cannot be run in place.");
+    const int canonical_axis = axis_ < 0 ? axis_ + X.ndim() : axis_;
+    CAFFE_ENFORCE_GE(canonical_axis, 0);
+    CAFFE_ENFORCE_LT(canonical_axis, X.ndim());
+    int N = 1;
+    for (int i = 0; i < canonical_axis; ++i) {
+      N *= X.dim32(i);
+    }
+    const int D = X.size() / N;
+
+    bool dims_changed;
+    CHECK_INPUT_DIMS(X, dims_changed);
+    if (dims_changed) {
+      const size_t dimension = X.ndim();
+      vector<size_t> size(dimension);
+      vector<size_t> strides(dimension);
+      for (int i = 0; i < dimension; ++i) {
+        size[i] = X.dim(dimension - i - 1);
+        strides[i] = (i == 0) ? 1 : strides[i - 1] * size[i - 1];
+      }
+      user_layout_.Reset(dimension, size.data(), strides.data());
+      Y->Reset(X.dims());
+      scale_.Resize(N);
+      rowmax_.Resize(N);
+      sum_multiplier_.Resize(D);
+      math::Set<float, CPUContext>(
+          D, 1.f, sum_multiplier_.mutable_data<float>(), &cpu_context_);
+    }
+    if (X.size() == 0) {
+      return true;
+    }
+
+    std::shared_ptr<void> X_view =
+        X.View(user_layout_, nullptr, dnnResourceSrc);
+    SoftmaxCPU(
+        cpu_context_,
+        N,
+        D,
+        static_cast<const float*>(X_view.get()),
+        static_cast<float*>(Y->buffer()),
+        scale_.mutable_data<float>(),
+        sum_multiplier_.data<float>(),
+        false,
+        rowmax_.mutable_data<float>());
+    return true;
+  }
+
+ private:
+  int axis_;
+  vector<TIndex> cached_input_dims_;
+  LayoutWrapper<T> user_layout_;
+  CPUContext cpu_context_;
+  TensorCPU scale_;
+  TensorCPU rowmax_;
+  TensorCPU sum_multiplier_;
+};
+
+} // namespace mkl
+
+REGISTER_MKL_OPERATOR(Softmax, mkl::MKLSoftmaxOp<float>);
+
+} // namespace caffe2
+
+#endif // CAFFE2_HAS_MKL_DNN
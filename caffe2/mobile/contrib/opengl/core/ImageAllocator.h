@@ -18,6 +18,7 @@
 #pragma once
 
 #include "GLImageAllocator.h"
+#include "caffe2/core/blob.h"
 
 namespace caffe2 {
 
@@ -59,5 +60,28 @@ class ImageAllocator {
     return glImageAllocator->newImage(
         num_images, width, height, channels, tile_x, tile_y, textureAllocator);
   }
+
+  // Returns the image already held by the output blob when it has the same
+  // geometry, so the textures of an operator output are allocated on the
+  // first run and reused by the following ones. Otherwise a new image is
+  // allocated and handed over to the blob.
+  GLImageVector<T>* reuseOrNewImage(Blob* blob,
+                                    int num_images,
+                                    int width,
+                                    int height,
+                                    int channels,
+                                    int tile_x,
+                                    int tile_y,
+                                    bool is_output = false) {
+    if (blob->IsType<GLImageVector<T>>()) {
+      GLImageVector<T>* image = blob->GetMutable<GLImageVector<T>>();
+      if (image->size() == num_images && image->width() == width &&
+          image->height() == height && image->channels() == channels &&
+          image->tile_x() == tile_x && image->tile_y() == tile_y) {
+        return image;
+      }
+    }
+    return blob->Reset(newImage(num_images, width, height, channels, tile_x, tile_y, is_output));
+  }
 };
 } // namespace caffe2
@@ -187,8 +187,14 @@ class OpenGLConcatOp final : public Operator<CPUContext>, ImageAllocator<T> {
 
     int is_last = OperatorBase::GetSingleArgument<int>("is_last", 0);
 
-    GLImageVector<T>* output = ImageAllocator<T>::newImage(
-        num_images, output_width, output_height, output_channels, output_tile_x, output_tile_y, is_last);
+    GLImageVector<T>* output = ImageAllocator<T>::reuseOrNewImage(Outputs()[0],
+                                                                  num_images,
+                                                                  output_width,
+                                                                  output_height,
+                                                                  output_channels,
+                                                                  output_tile_x,
+                                                                  output_tile_y,
+                                                                  is_last);
     if (!_concat) {
       tile_descriptor output_tile_geometries{
           {output_tile_x, output_tile_y}, {output_width, output_height}, output_tile_x * output_tile_y};
@@ -197,7 +203,6 @@ class OpenGLConcatOp final : public Operator<CPUContext>, ImageAllocator<T> {
 
     _concat->concat(input_images, *output, Inputs().size());
     delete[] input_images;
-    Outputs()[0]->Reset(output);
 
     return true;
   }
@@ -463,78 +463,82 @@ template <typename T>
 void GLConvolution::run_batched_conv(
     const GLImageVector<T>& input_images,
     const GLImageVector<T>& output_images) {
-  for (int i = 0; i < input_images.size(); i++) {
-    GLImage<T>* input_image = input_images[i];
-    GLImage<T>* output_image = output_images[i];
-    int input_slices = input_image->slices;
-    int output_slices = output_image->slices;
+  // All the images of a vector have the same geometry. The frames are the
+  // innermost loop so the bias, kernel and PRelu blocks of a slice batch are
+  // packed and uploaded once for the whole batch of images.
+  const int input_slices = input_images.slices();
+  const int output_slices = output_images.slices();
+
+  for (int is = 0; is < input_slices; is += input_batch_size) {
+    for (int os = 0; os < output_slices; os += output_batch_size) {
+      const int output_channels_per_batch =
+          std::min(4 * output_batch_size, geometry.output_channels - 4 * os);
+
+      gl_log(
+          GL_VERBOSE,
+          "GLConvolution::convolution - is: %d, os: %d\n",
+          is,
+          os);
 
-    for (int is = 0; is < input_slices; is += input_batch_size) {
-      for (int os = 0; os < output_slices; os += output_batch_size) {
-        const int output_channels_per_batch =
-            std::min(4 * output_batch_size, geometry.output_channels - 4 * os);
+      // Note the order of the binding point needs to be the same as in the
+      // constructor
+      int binding_point = 0;
 
-        gl_log(
-            GL_VERBOSE,
-            "GLConvolution::convolution - is: %d, os: %d\n",
-            is,
-            os);
+      // bias
+      attach_uniform_buffer<float16_t>(
+          bias_block, binding_point++, [&](float16_t* data, size_t size) {
+            CAFFE_ENFORCE_GE(
+                size,
+                output_channels_per_batch * sizeof(float16_t),
+                "Bias buffer size too small");
+            for (int ob = 0; ob < output_channels_per_batch; ob++) {
+              data[ob] = bias[4 * os + ob];
+            }
+          });
 
-        // Note the order of the binding point needs to be the same as in the
-        // constructor
-        int binding_point = 0;
+      // kernel weights
+      for (int ib = 0; ib < input_batch_size; ib++) {
+        attach_uniform_buffer<float16_t>(
+            kernel_block[ib],
+            binding_point++,
+            [&](float16_t* data, size_t size) {
+              CAFFE_ENFORCE_EQ(
+                  size,
+                  4 * (4 * output_batch_size) * geometry.kernel_size.y *
+                      geometry.kernel_size.x * sizeof(float16_t),
+                  "Kernel size mismatch");
+              pack_kernel_data_for_bached_conv(
+                  data,
+                  size,
+                  input_images.channels(),
+                  output_images.channels(),
+                  is,
+                  os,
+                  ib);
+            });
+      }
 
-        // bias
+      // PRelu scale
+      if (prelu_scale != nullptr && is == input_slices - input_batch_size) {
         attach_uniform_buffer<float16_t>(
-            bias_block, binding_point++, [&](float16_t* data, size_t size) {
+            prelu_scale_block,
+            binding_point++,
+            [&](float16_t* data, size_t size) {
               CAFFE_ENFORCE_GE(
                   size,
                   output_channels_per_batch * sizeof(float16_t),
-                  "Bias buffer size too small");
+                  "PRelu buffer size too small");
               for (int ob = 0; ob < output_channels_per_batch; ob++) {
-                data[ob] = bias[4 * os + ob];
+                data[ob] = prelu_scale_size == geometry.output_channels
+                    ? prelu_scale[4 * os + ob]
+                    : prelu_scale[0];
               }
             });
+      }
 
-        // kernel weights
-        for (int ib = 0; ib < input_batch_size; ib++) {
-          attach_uniform_buffer<float16_t>(
-              kernel_block[ib],
-              binding_point++,
-              [&](float16_t* data, size_t size) {
-                CAFFE_ENFORCE_EQ(
-                    size,
-                    4 * (4 * output_batch_size) * geometry.kernel_size.y *
-                        geometry.kernel_size.x * sizeof(float16_t),
-                    "Kernel size mismatch");
-                pack_kernel_data_for_bached_conv(
-                    data,
-                    size,
-                    input_image->channels,
-                    output_image->channels,
-                    is,
-                    os,
-                    ib);
-              });
-        }
-
-        // PRelu scale
-        if (prelu_scale != nullptr && is == input_slices - input_batch_size) {
-          attach_uniform_buffer<float16_t>(
-              prelu_scale_block,
-              binding_point++,
-              [&](float16_t* data, size_t size) {
-                CAFFE_ENFORCE_GE(
-                    size,
-                    output_channels_per_batch * sizeof(float16_t),
-                    "PRelu buffer size too small");
-                for (int ob = 0; ob < output_channels_per_batch; ob++) {
-                  data[ob] = prelu_scale_size == geometry.output_channels
-                      ? prelu_scale[4 * os + ob]
-                      : prelu_scale[0];
-                }
-              });
-        }
+      for (int i = 0; i < input_images.size(); i++) {
+        GLImage<T>* input_image = input_images[i];
+        GLImage<T>* output_image = output_images[i];
 
         std::vector<texture_attachment> input_attachments;
         for (int ib = 0; ib < input_batch_size; ib++) {
@@ -822,7 +826,8 @@ class OpenGLConvOp final : public ConvPoolOpBase<CPUContext>, ImageAllocator<T>
 
     int is_last = GetSingleArgument<int>("is_last", 0);
 
-    GLImageVector<T>* output = ImageAllocator<T>::newImage(
+    GLImageVector<T>* output = ImageAllocator<T>::reuseOrNewImage(
+        Outputs()[0],
         num_images,
         output_width,
         output_height,
@@ -887,8 +892,6 @@ class OpenGLConvOp final : public ConvPoolOpBase<CPUContext>, ImageAllocator<T>
 
     conv->convolution(input, *output);
 
-    Outputs()[0]->Reset(output);
-
     return true;
   }
 
@@ -996,7 +999,8 @@ class OpenGLConvTransposeOp final : public ConvTransposeUnpoolBase<CPUContext>,
 
     int is_last = GetSingleArgument<int>("is_last", 0);
 
-    GLImageVector<T>* output = ImageAllocator<T>::newImage(
+    GLImageVector<T>* output = ImageAllocator<T>::reuseOrNewImage(
+        Outputs()[0],
         num_images,
         output_width,
         output_height,
@@ -1062,8 +1066,6 @@ class OpenGLConvTransposeOp final : public ConvTransposeUnpoolBase<CPUContext>,
 
     conv->convolution(input, *output);
 
-    Outputs()[0]->Reset(output);
-
     return true;
   }
 
@@ -51,16 +51,17 @@ class CopyToOpenGLOp final : public Operator<CPUContext>, ImageAllocator<T> {
     int tile_x = GetSingleArgument<int>("tile_x", 1);
     int tile_y = GetSingleArgument<int>("tile_y", 1);
 
-    GLImageVector<T>* output_image = ImageAllocator<T>::newImage(num_images,
-                                                                 input_width,
-                                                                 input_height,
-                                                                 input_channels,
-                                                                 tile_x,
-                                                                 tile_y,
+    GLImageVector<T>* output_image = ImageAllocator<T>::reuseOrNewImage(Outputs()[0],
+                                                                        num_images,
+                                                                        input_width,
+                                                                        input_height,
+                                                                        input_channels,
+                                                                        tile_x,
+                                                                        tile_y,
 #if CAFFE2_IOS
-                                                                 true
+                                                                        true
 #else
-                                                                 false
+                                                                        false
 #endif
     );
 
@@ -69,8 +70,6 @@ class CopyToOpenGLOp final : public Operator<CPUContext>, ImageAllocator<T> {
                 << output_image->tile_y();
     }
 
-    Outputs()[0]->Reset(output_image);
-
     for (int i = 0; i < num_images; i++) {
       const auto textures = (*output_image)[i]->textures;
       for (int slice = 0; slice < textures.size(); slice++) {
@@ -535,6 +535,8 @@ void testOpenGLConv(int N,
     }
   }
 
+  // The second run writes into the output textures allocated by the first.
+  ws.RunNetOnce(netdef);
   ws.RunNetOnce(netdef);
   const auto& t1 = ws.GetBlob("Y_cpu")->Get<TensorCPU>(); // OpenGL
   const auto& t2 = ws.GetBlob("Y_ref")->Get<TensorCPU>(); // CPU
@@ -2549,6 +2551,15 @@ void testOpenGL() {
                        1);
       }
     }
+
+    // Test batches of several frames, with several slices per batch
+    for (int num_images = 2; num_images <= 4; num_images++) {
+      // clang-format off
+      testOpenGLConv(num_images, 16, 10, 10, 16, 3, 3, 0, 1, Conv, 0.5, true, 2, 2);
+      testOpenGLConv(num_images, 16, 10, 10, 16, 3, 3, 1, 1, ConvPRelu, 0.5, true, 2, 2);
+      testOpenGLConv(num_images, 16, 10, 10, 16, 3, 3, 0, 2, ConvTranspose, 0.5, true, 2, 2);
+      // clang-format on
+    }
     for (const auto& channel : channels) {
       int tile_x = 1, tile_y = 1;
       squareFactors((channel + 3) / 4, tile_x, tile_y);
@@ -16,6 +16,7 @@
 
 #include "ulp.h"
 #include "caffe2/operators/conv_pool_op_base.h"
+#include "ulp_avx2.h"
 #include "ulp_neon.h"
 
 namespace caffe2 {
@@ -312,6 +313,11 @@ void run2b1bConvGeneric(QConvState* state, const ConvArgs& args, const TensorCPU
   if (run2b1bConvNeon(state, args, X, Y)) {
     return;
   }
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+  if (run2b1bConvAVX2(state, args, X, Y)) {
+    return;
+  }
 #endif
   uniformQuantize2b1b(X, state->XQs, 0.5, 1.0);
   for (auto i = 0; i < k2b1bXBits; ++i) {
@@ -0,0 +1,317 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ulp_avx2.h"
+#include "caffe2/utils/cpuid.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define CAFFE2_ULP_X86 1
+// VPOPCNTDQ intrinsics need GCC 7 or clang 5.
+#if (defined(__clang__) && __clang_major__ >= 5) || (!defined(__clang__) && __GNUC__ >= 7)
+#define CAFFE2_ULP_AVX512 1
+#endif
+#endif
+
+namespace caffe2 {
+
+#ifdef CAFFE2_ULP_X86
+
+namespace {
+
+// Number of filters that are popcounted against each loaded input row.
+constexpr size_t kFilterBlock = 4;
+constexpr size_t kL1CacheSizeBytes = 32 * 1024;
+
+// Signature of the kernels computing, for FB consecutive filter rows of W (of
+// QK bytes each), acc0[f] = popcount(X0 ^ W[f]) and acc1[f] = popcount(X1 ^ W[f]).
+using QGEMVKernel =
+    void (*)(const uint8_t*, const uint8_t*, const uint8_t*, size_t, int32_t*, int32_t*);
+
+// Scalar tail shared by the kernels, for the bytes in [qk0, QK).
+inline void qgemvTail(const uint8_t* __restrict__ X0,
+                      const uint8_t* __restrict__ X1,
+                      const uint8_t* __restrict__ Wrow,
+                      size_t qk0,
+                      size_t QK,
+                      int32_t* acc0,
+                      int32_t* acc1) {
+  for (size_t qk = qk0; qk < QK; ++qk) {
+    *acc0 += __builtin_popcount(X0[qk] ^ Wrow[qk]);
+    *acc1 += __builtin_popcount(X1[qk] ^ Wrow[qk]);
+  }
+}
+
+// Per-byte popcount through a nibble lookup table (AVX2 has no vector popcnt).
+__attribute__((target("avx2"))) inline __m256i popcnt8AVX2(__m256i v, __m256i lut, __m256i low) {
+  const __m256i lo = _mm256_and_si256(v, low);
+  const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low);
+  return _mm256_add_epi8(_mm256_shuffle_epi8(lut, lo), _mm256_shuffle_epi8(lut, hi));
+}
+
+template <size_t FB>
+__attribute__((target("avx2,popcnt"))) void qgemv2b1bAVX2(const uint8_t* __restrict__ X0,
+                                                           const uint8_t* __restrict__ X1,
+                                                           const uint8_t* __restrict__ W,
+                                                           size_t QK,
+                                                           int32_t* acc0,
+                                                           int32_t* acc1) {
+  const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                       0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low = _mm256_set1_epi8(0x0f);
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i s0[FB];
+  __m256i s1[FB];
+  for (size_t f = 0; f < FB; ++f) {
+    s0[f] = zero;
+    s1[f] = zero;
+  }
+  size_t qk = 0;
+  for (; qk + 32 <= QK; qk += 32) {
+    const __m256i x0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(X0 + qk));
+    const __m256i x1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(X1 + qk));
+    for (size_t f = 0; f < FB; ++f) {
+      const __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(W + f * QK + qk));
+      // Each byte count is at most 8, so summing them with sad into the four
+      // 64 bit lanes cannot overflow.
+      s0[f] = _mm256_add_epi64(
+          s0[f], _mm256_sad_epu8(popcnt8AVX2(_mm256_xor_si256(x0, w), lut, low), zero));
+      s1[f] = _mm256_add_epi64(
+          s1[f], _mm256_sad_epu8(popcnt8AVX2(_mm256_xor_si256(x1, w), lut, low), zero));
+    }
+  }
+  for (size_t f = 0; f < FB; ++f) {
+    alignas(32) uint64_t t0[4];
+    alignas(32) uint64_t t1[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(t0), s0[f]);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(t1), s1[f]);
+    acc0[f] = t0[0] + t0[1] + t0[2] + t0[3];
+    acc1[f] = t1[0] + t1[1] + t1[2] + t1[3];
+    qgemvTail(X0, X1, W + f * QK, qk, QK, &acc0[f], &acc1[f]);
+  }
+}
+
+#ifdef CAFFE2_ULP_AVX512
+template <size_t FB>
+__attribute__((target("avx512f,avx512vpopcntdq,popcnt"))) void qgemv2b1bAVX512(
+    const uint8_t* __restrict__ X0,
+    const uint8_t* __restrict__ X1,
+    const uint8_t* __restrict__ W,
+    size_t QK,
+    int32_t* acc0,
+    int32_t* acc1) {
+  __m512i s0[FB];
+  __m512i s1[FB];
+  for (size_t f = 0; f < FB; ++f) {
+    s0[f] = _mm512_setzero_si512();
+    s1[f] = _mm512_setzero_si512();
+  }
+  size_t qk = 0;
+  for (; qk + 64 <= QK; qk += 64) {
+    const __m512i x0 = _mm512_loadu_si512(X0 + qk);
+    const __m512i x1 = _mm512_loadu_si512(X1 + qk);
+    for (size_t f = 0; f < FB; ++f) {
+      const __m512i w = _mm512_loadu_si512(W + f * QK + qk);
+      s0[f] = _mm512_add_epi64(s0[f], _mm512_popcnt_epi64(_mm512_xor_si512(x0, w)));
+      s1[f] = _mm512_add_epi64(s1[f], _mm512_popcnt_epi64(_mm512_xor_si512(x1, w)));
+    }
+  }
+  for (size_t f = 0; f < FB; ++f) {
+    acc0[f] = _mm512_reduce_add_epi64(s0[f]);
+    acc1[f] = _mm512_reduce_add_epi64(s1[f]);
+    qgemvTail(X0, X1, W + f * QK, qk, QK, &acc0[f], &acc1[f]);
+  }
+}
+#endif
+
+// Same as uniformQuantize2b1b for a single row of C floats; whole bytes come
+// straight out of movemask. The comparisons are chosen to match the scalar
+// code, including for NaNs.
+__attribute__((target("avx2"))) void quantize2b1bAVX2(size_t C,
+                                                       const float* __restrict__ Xdata,
+                                                       float offset,
+                                                       float inter_center_distance,
+                                                       uint8_t* __restrict__ XQ0,
+                                                       uint8_t* __restrict__ XQ1) {
+  const __m256 offset_ = _mm256_set1_ps(offset);
+  const __m256 offset_plus_inter_center_distance = _mm256_set1_ps(offset + inter_center_distance);
+  const __m256 offset_plus_2_inter_center_distance =
+      _mm256_set1_ps(offset + 2 * inter_center_distance);
+  size_t qc = 0;
+  for (; qc * 8 + 8 <= C; ++qc) {
+    const __m256 x = _mm256_loadu_ps(Xdata + qc * 8);
+    const __m256 x_ge_offset = _mm256_cmp_ps(x, offset_, _CMP_NLT_UQ);
+    const __m256 x_lt_offset_plus_inter_center_distance =
+        _mm256_cmp_ps(x, offset_plus_inter_center_distance, _CMP_LT_OQ);
+    const __m256 x_ge_offset_plus_2_inter_center_distance =
+        _mm256_cmp_ps(x, offset_plus_2_inter_center_distance, _CMP_NLT_UQ);
+    const __m256 p0_mask = _mm256_or_ps(
+        _mm256_and_ps(x_ge_offset, x_lt_offset_plus_inter_center_distance),
+        x_ge_offset_plus_2_inter_center_distance);
+    XQ0[qc] = _mm256_movemask_ps(p0_mask);
+    XQ1[qc] = _mm256_movemask_ps(
+        _mm256_cmp_ps(x, offset_plus_inter_center_distance, _CMP_NLT_UQ));
+  }
+  if (qc * 8 < C) {
+    std::array<uint8_t, k2b1bXBits> p = {{0, 0}};
+    for (size_t c = qc * 8; c < C; ++c) {
+      const size_t b = c - qc * 8;
+      float v = Xdata[c];
+      if (v < offset) {
+        // zero'd already.
+      } else if (v < offset + inter_center_distance) {
+        p[0] |= 1 << b;
+      } else if (v < offset + 2 * inter_center_distance) {
+        p[1] |= 1 << b;
+      } else {
+        p[0] |= 1 << b;
+        p[1] |= 1 << b;
+      }
+    }
+    XQ0[qc] = p[0];
+    XQ1[qc] = p[1];
+  }
+}
+
+void uniformQuantize2b1bAVX2(QConvState* state,
+                             const TensorCPU& X,
+                             const std::vector<std::unique_ptr<TensorCPU>>& XQ,
+                             float offset,
+                             float inter_center_distance) {
+  CAFFE_ENFORCE_GT(X.ndim(), 1);
+  const size_t C = X.dim32(X.ndim() - 1);
+  const size_t N = X.size() / C;
+  const size_t QC = divRoundUp(C, 8);
+  auto XQs = X.dims();
+  XQs[X.ndim() - 1] = QC;
+  CAFFE_ENFORCE_EQ(XQ.size(), k2b1bXBits);
+  for (auto i = 0; i < k2b1bXBits; ++i) {
+    XQ[i]->Resize(XQs);
+  }
+  const float* Xdata = X.data<float>();
+  uint8_t* XQ0data = XQ[0]->mutable_data<uint8_t>();
+  uint8_t* XQ1data = XQ[1]->mutable_data<uint8_t>();
+  // Each worker reads and writes about an L1 cache worth of rows.
+  const size_t rowsPerBlock = std::max<size_t>(kL1CacheSizeBytes / (4 * C + 2 * QC), 1);
+  state->parallelFor(divRoundUp(N, rowsPerBlock), [&](size_t nb) {
+    for (size_t n = nb * rowsPerBlock; n < std::min<size_t>(nb * rowsPerBlock + rowsPerBlock, N);
+         ++n) {
+      quantize2b1bAVX2(
+          C, Xdata + C * n, offset, inter_center_distance, XQ0data + QC * n, XQ1data + QC * n);
+    }
+  });
+}
+
+// Computes both bit planes of the binary GEMM Y = XQcol * WQ^T and applies the
+// 2b1b unification (see run2b1bUnification) on the fly, so YQs never need to be
+// materialized. Rows of XQcol are processed in blocks that stay in L1 while
+// kFilterBlock filters at a time are streamed against them.
+void qgemm2b1b(QConvState* state,
+               const TensorCPU& XQcol0,
+               const TensorCPU& XQcol1,
+               QGEMVKernel blockKernel,
+               QGEMVKernel rowKernel,
+               float* Ydata) {
+  const auto& WQ = *(state->WQ);
+  const size_t F = WQ.dim32(0);
+  const size_t QK = WQ.size() / F;
+  const size_t M = XQcol0.size() / QK;
+  CAFFE_ENFORCE_EQ(XQcol0.size(), M * QK);
+  CAFFE_ENFORCE_EQ(XQcol1.size(), M * QK);
+  const uint8_t* X0data = XQcol0.data<uint8_t>();
+  const uint8_t* X1data = XQcol1.data<uint8_t>();
+  const uint8_t* WQdata = WQ.data<uint8_t>();
+  const float* WQNdata = state->WQN->data<float>();
+  const float* bias = state->bias ? state->bias->data<float>() : nullptr;
+  const float K = QK * 8;
+  const size_t FBlocked = (F / kFilterBlock) * kFilterBlock;
+  const size_t rowsPerBlock = std::max<size_t>(kL1CacheSizeBytes / (4 * QK), 1);
+
+  state->parallelFor(divRoundUp(M, rowsPerBlock), [&](size_t mb) {
+    const size_t mStart = mb * rowsPerBlock;
+    const size_t mEnd = std::min<size_t>(mStart + rowsPerBlock, M);
+    for (size_t f = 0; f < F;) {
+      const size_t FB = f < FBlocked ? kFilterBlock : 1;
+      const QGEMVKernel kernel = f < FBlocked ? blockKernel : rowKernel;
+      for (size_t m = mStart; m < mEnd; ++m) {
+        std::array<int32_t, kFilterBlock> acc0;
+        std::array<int32_t, kFilterBlock> acc1;
+        kernel(X0data + m * QK,
+               X1data + m * QK,
+               WQdata + f * QK,
+               QK,
+               acc0.data(),
+               acc1.data());
+        for (size_t ff = 0; ff < FB; ++ff) {
+          const float YQ0 = K - 2 * acc0[ff];
+          const float YQ1 = K - 2 * acc1[ff];
+          float y = (std::pow<float>(2, k2b1bXBits) - 1) / 2 * WQNdata[f + ff] +
+                    std::pow<float>(2, -1) * YQ0 + std::pow<float>(2, 0) * YQ1;
+          if (bias) {
+            y += bias[f + ff];
+          }
+          Ydata[m * F + f + ff] = y;
+        }
+      }
+      f += FB;
+    }
+  });
+}
+
+} // namespace
+
+bool run2b1bConvAVX2(QConvState* state, const ConvArgs& args, const TensorCPU& X, TensorCPU* Y) {
+  static const bool kHasAVX2 = GetCpuId().avx2() && GetCpuId().popcnt();
+  if (!kHasAVX2) {
+    return false;
+  }
+  CAFFE_ENFORCE_EQ(X.ndim(), 4);
+  uniformQuantize2b1bAVX2(state, X, state->XQs, 0.5, 1.0);
+  // qim2col just aliases its input for 1x1 convolutions.
+  qim2col(args, *(state->XQs[0]), *(state->WQ), state->scratchColBuffer.get());
+  qim2col(args, *(state->XQs[1]), *(state->WQ), state->scratch.get());
+  const auto& XQcol = *(state->scratchColBuffer);
+  Y->Resize(XQcol.dim32(0), XQcol.dim32(1), XQcol.dim32(2), state->WQ->dim32(0));
+#ifdef CAFFE2_ULP_AVX512
+  static const bool kHasAVX512 = GetCpuId().avx512f() && GetCpuId().avx512vpopcntdq();
+  if (kHasAVX512) {
+    qgemm2b1b(state,
+              XQcol,
+              *(state->scratch),
+              &qgemv2b1bAVX512<kFilterBlock>,
+              &qgemv2b1bAVX512<1>,
+              Y->mutable_data<float>());
+    return true;
+  }
+#endif
+  qgemm2b1b(state,
+            XQcol,
+            *(state->scratch),
+            &qgemv2b1bAVX2<kFilterBlock>,
+            &qgemv2b1bAVX2<1>,
+            Y->mutable_data<float>());
+  return true;
+}
+
+#else
+
+bool run2b1bConvAVX2(QConvState* state, const ConvArgs& args, const TensorCPU& X, TensorCPU* Y) {
+  return false;
+}
+
+#endif
+
+} // namespace caffe2
@@ -0,0 +1,27 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ulp.h"
+
+namespace caffe2 {
+
+// Runs the 2b1b convolution with x86 popcount kernels (AVX-512 VPOPCNTDQ if
+// available, AVX2 otherwise), selected at runtime from cpuid. Returns false if
+// the CPU supports neither, in which case the generic path should be used.
+bool run2b1bConvAVX2(QConvState* state, const ConvArgs& args, const TensorCPU& X, TensorCPU* Y);
+}
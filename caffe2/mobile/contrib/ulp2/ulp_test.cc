@@ -15,6 +15,7 @@
  */
 
 #include "ulp.h"
+#include "ulp_avx2.h"
 #include "ulp_neon.h"
 #include "gtest/gtest.h"
 
@@ -384,6 +385,37 @@ TEST(QConv, 2b1bInputPackingTest) {
   ConvTest2b1b(2, 2, 2, 3, 3, 1, 1, ca());
 }
 
+void ConvTest2b1bAVX2(int IC, int KH, int KW, int H, int W, int OC, int N, ConvArgs args) {
+  auto X = genTensor0123({N, H, W, IC});
+  auto W_ = genTensor11({OC, KH, KW, IC});
+  auto bias = genTensorUniform11({OC});
+  TensorCPU Y, Y2b1b;
+  {
+    Workspace ws;
+    auto state = create2b1bConvState(&ws, W_, &bias);
+    if (!run2b1bConvAVX2(state.get(), args, X, &Y2b1b)) {
+      LOG(INFO) << "AVX2 unavailable, skipping";
+      return;
+    }
+  }
+  { conv(args, X, W_, &bias, &Y); }
+  EXPECT_TRUE(Y.dims() == Y2b1b.dims());
+  for (auto i = 0; i < Y.size(); ++i) {
+    EXPECT_NEAR(Y.data<float>()[i], Y2b1b.data<float>()[i], 1e-3);
+  }
+}
+
+TEST(QConv, 2b1bConvTestAVX2) {
+  // Depths around the 32 and 64 byte vector widths and filter counts that are
+  // not a multiple of the filter block exercise the scalar tails.
+  ConvTest2b1bAVX2(2, 1, 1, 3, 3, 1, 1, ca());
+  ConvTest2b1bAVX2(59, 1, 1, 4, 4, 7, 1, ca());
+  ConvTest2b1bAVX2(256, 1, 1, 5, 5, 64, 2, ca());
+  ConvTest2b1bAVX2(264, 1, 1, 5, 5, 65, 1, ca());
+  ConvTest2b1bAVX2(64, 3, 3, 10, 10, 30, 1, ca(1));
+  ConvTest2b1bAVX2(512, 3, 3, 7, 7, 33, 1, ca(1, 2));
+}
+
 TEST(QConv, 2b1bConvTestRandomized) {
   auto rca = []() {
     ConvArgs r;
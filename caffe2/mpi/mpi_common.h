@@ -19,6 +19,7 @@
 
 #include <mpi.h>
 #include <mutex>
+#include <thread>
 
 #include "caffe2/core/logging.h"
 
@@ -39,6 +40,8 @@ template <typename T> class MPIDataTypeWrapper;
   };
 
 MPI_DATATYPE_WRAPPER(char, MPI_CHAR)
+MPI_DATATYPE_WRAPPER(int, MPI_INT)
+MPI_DATATYPE_WRAPPER(int64_t, MPI_INT64_T)
 MPI_DATATYPE_WRAPPER(float, MPI_FLOAT)
 MPI_DATATYPE_WRAPPER(double, MPI_DOUBLE)
 // Note(Yangqing): as necessary, add more specializations.
@@ -146,6 +149,58 @@ class MPICommonWorldWrapper {
   int rank_;
 };
 
+/**
+ * @brief A wrapper over the request of a non-blocking MPI call, such as the
+ * one started by MPIAllreduceAsync.
+ *
+ * The buffers of the call must stay alive and untouched until Wait() returns,
+ * so the destructor also waits for a request that is still pending.
+ */
+class MPIRequestWrapper {
+ public:
+  MPIRequestWrapper() : request_(MPI_REQUEST_NULL) {}
+
+  ~MPIRequestWrapper() {
+    int ret;
+    MPI_CHECK(MPI_Finalized(&ret));
+    if (!ret) {
+      Wait();
+    }
+  }
+
+  /**
+   * @brief Returns the request for the non-blocking call to fill in. The
+   * previous request has to be completed already.
+   */
+  inline MPI_Request* request() {
+    CAFFE_ENFORCE(
+        request_ == MPI_REQUEST_NULL,
+        "The previous MPI request has not been waited on.");
+    return &request_;
+  }
+
+  /**
+   * @brief Blocks until the request completes; a no-op if there is none.
+   *
+   * The request is polled with MPI_Test rather than waited on with MPI_Wait
+   * so that the MPI mutex is not held while the collective is in flight, and
+   * other operators can issue their MPI calls in the meantime.
+   */
+  void Wait() {
+    int done = 0;
+    while (true) {
+      MPI_CHECK(MPI_Test(&request_, &done, MPI_STATUS_IGNORE));
+      if (done) {
+        return;
+      }
+      std::this_thread::yield();
+    }
+  }
+
+ private:
+  MPI_Request request_;
+};
+
 /**
  * A function used to perform peer setup so one does not need to use
  * mpirun / mpiexec to run the binary. Note that if you use mpirun or mpiexec
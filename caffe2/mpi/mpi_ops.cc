@@ -35,6 +35,32 @@ OPERATOR_SCHEMA(MPIAllreduce)
   .NumInputs(2)
   .NumOutputs(1)
   .AllowInplace({{1, 0}});
+OPERATOR_SCHEMA(MPIAllreduceAsync)
+  .NumInputs(2)
+  .NumOutputs(2)
+  .AllowInplace({{1, 0}})
+  .SetDoc(R"DOC(
+Starts a sum allreduce of X over the common world and returns without waiting
+for it. Y is only reduced after MPIWait has run on the returned request, and
+neither X nor Y may be read or written before that.
+)DOC")
+  .Input(0, "comm", "The common world")
+  .Input(1, "X", "The tensor to reduce")
+  .Output(0, "Y", "The reduced tensor, valid after MPIWait")
+  .Output(1, "request", "The request of the reduction");
+OPERATOR_SCHEMA(MPIWait)
+  .NumInputs(2)
+  .NumOutputs(2)
+  .EnforceInplace({{0, 0}, {1, 1}})
+  .SetDoc(R"DOC(
+Waits for the request of a non-blocking MPI operator such as MPIAllreduceAsync
+to complete, and passes the result tensor through so that its readers are
+ordered after the wait.
+)DOC")
+  .Input(0, "request", "The request to wait on")
+  .Input(1, "Y", "The output of the non-blocking operator")
+  .Output(0, "request", "The completed request")
+  .Output(1, "Y", "The same tensor, now safe to use");
 OPERATOR_SCHEMA(MPISendTensor);
 OPERATOR_SCHEMA(MPIReceiveTensor);
 
@@ -43,6 +69,10 @@ REGISTER_CPU_OPERATOR(MPIBroadcast, MPIBroadcastOp<CPUContext>);
 REGISTER_CPU_OPERATOR(MPIReduce, MPIReduceOp<float, CPUContext>);
 REGISTER_CPU_OPERATOR(MPIAllgather, MPIAllgatherOp<float, CPUContext>);
 REGISTER_CPU_OPERATOR(MPIAllreduce, MPIAllreduceOp<float, CPUContext>);
+REGISTER_CPU_OPERATOR(
+    MPIAllreduceAsync,
+    MPIAllreduceAsyncOp<float, CPUContext>);
+REGISTER_CPU_OPERATOR(MPIWait, MPIWaitOp<CPUContext>);
 REGISTER_CPU_OPERATOR(MPISendTensor, MPISendTensorOp<CPUContext>);
 REGISTER_CPU_OPERATOR(MPIReceiveTensor, MPIReceiveTensorOp<CPUContext>);
 
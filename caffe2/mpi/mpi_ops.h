@@ -60,6 +60,9 @@ class MPIBroadcastOp final : public Operator<Context> {
         output->size() > 0,
         "Broadcast op uses in-place operation so the output "
         "should be already allocated.");
+    // A device-aware MPI reads and writes the buffers outside of the
+    // stream of the context, so the kernels producing them have to be done.
+    context_.FinishDeviceComputation();
     MPI_CHECK(MPI_Bcast(
         output->raw_mutable_data(),
         output->nbytes(),
@@ -88,6 +91,7 @@ class MPIReduceOp final : public Operator<Context> {
     auto& input = Input(1);
     auto* output = Output(0);
     output->ResizeLike(input);
+    context_.FinishDeviceComputation();
     MPI_CHECK(MPI_Reduce(
         const_cast<T*>(input.template data<T>()),
         output->template mutable_data<T>(),
@@ -117,6 +121,7 @@ class MPIAllgatherOp final : public Operator<Context> {
     vector<TIndex> output_dims = input.dims();
     output_dims[0] *= OperatorBase::Input<MPICommonWorldWrapper>(0).size();
     output->Resize(output_dims);
+    context_.FinishDeviceComputation();
     MPI_CHECK(MPI_Allgather(
         const_cast<T*>(input.template data<T>()),
         input.size(),
@@ -149,6 +154,7 @@ class MPIAllreduceOp final : public Operator<Context> {
       // Normal allreduce takes the source from the input.
       source = const_cast<T*>(input.template data<T>());
     }
+    context_.FinishDeviceComputation();
     MPI_CHECK(MPI_Allreduce(
         source,
         output->template mutable_data<T>(),
@@ -160,6 +166,62 @@ class MPIAllreduceOp final : public Operator<Context> {
   }
 };
 
+// MPIAllreduceAsyncOp starts an MPI_Iallreduce and returns without waiting
+// for it. The reduced output is only valid once MPIWait has run on the
+// request output, and nothing may touch the input or output in between. Other
+// operators of an async net can run while the reduction is in flight.
+template <typename T, class Context>
+class MPIAllreduceAsyncOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  USE_SIMPLE_CTOR_DTOR(MPIAllreduceAsyncOp);
+
+  bool RunOnDevice() override {
+    MPI_Comm comm = OperatorBase::Input<MPICommonWorldWrapper>(0).comm();
+    auto& input = Input(1);
+    auto* output = Output(0);
+    output->ResizeLike(input);
+    auto* request = OperatorBase::Output<MPIRequestWrapper>(1);
+    // A request of the previous run that was never waited on still owns the
+    // buffers.
+    request->Wait();
+    void* source;
+    if (output->template mutable_data<T>() == input.template data<T>()) {
+      source = MPI_IN_PLACE;
+    } else {
+      source = const_cast<T*>(input.template data<T>());
+    }
+    context_.FinishDeviceComputation();
+    MPI_CHECK(MPI_Iallreduce(
+        source,
+        output->template mutable_data<T>(),
+        input.size(),
+        MPIDataTypeWrapper<T>::type(),
+        MPI_SUM,
+        comm,
+        request->request()));
+    return true;
+  }
+};
+
+// MPIWaitOp blocks until the request of a non-blocking MPI operator is done,
+// after which the blob it passes through is safe to use. A request blob that
+// holds no MPIRequestWrapper, e.g. one left unset by a staged fallback that
+// already completed synchronously, is treated as done.
+template <class Context>
+class MPIWaitOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  USE_SIMPLE_CTOR_DTOR(MPIWaitOp);
+
+  bool RunOnDevice() override {
+    if (OperatorBase::OutputIsType<MPIRequestWrapper>(0)) {
+      OperatorBase::Output<MPIRequestWrapper>(0)->Wait();
+    }
+    return true;
+  }
+};
+
 template <class Context>
 class MPISendTensorOp final : public Operator<Context> {
  public:
@@ -191,6 +253,7 @@ class MPISendTensorOp final : public Operator<Context> {
       // We need to do a const cast to cope with the fact that, before OpenMPI
       // 1.7, MPI_Send expects a non-const pointer although it uses it in a
       // const way.
+      context_.FinishDeviceComputation();
       MPI_CHECK(MPI_Send(
           const_cast<void*>(input.raw_data()),
           input.nbytes(),
@@ -233,6 +296,7 @@ class MPIReceiveTensorOp final : public Operator<Context> {
     MPI_Status status;
     if (raw_buffer_) {
       auto* output = Output(OUTPUT);
+      context_.FinishDeviceComputation();
       MPI_CHECK(MPI_Recv(
           output->raw_mutable_data(),
           output->nbytes(),
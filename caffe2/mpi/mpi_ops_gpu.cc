@@ -93,10 +93,18 @@ REGISTER_CUDA_OPERATOR(
 
 #if CAFFE2_HAS_CUDA_MPI_ALLREDUCE
 REGISTER_CUDA_OPERATOR(MPIAllreduce, MPIAllreduceOp<float, CUDAContext>);
+REGISTER_CUDA_OPERATOR(
+    MPIAllreduceAsync,
+    MPIAllreduceAsyncOp<float, CUDAContext>);
 #else
 REGISTER_CUDA_OPERATOR(
     MPIAllreduce,
     GPUFallbackOp<MPIAllreduceOp<float, CPUContext>>);
+// The staged reduction completes synchronously and leaves the request unset.
+REGISTER_CUDA_OPERATOR(
+    MPIAllreduceAsync,
+    GPUFallbackOp<MPIAllreduceOp<float, CPUContext>, SkipIndices<1>>);
 #endif
+REGISTER_CUDA_OPERATOR(MPIWait, MPIWaitOp<CUDAContext>);
 
 }  // namespace caffe2
@@ -0,0 +1,109 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/mpi/mpi_ops.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/operator_fallback_hip.h"
+
+namespace caffe2 {
+
+// OpenMPI reports at compile time whether it was built with ROCm support, and
+// MPIX_Query_rocm_support() tells whether the library that is loaded at run
+// time has it. Other MPI environments are assumed to need host buffers.
+#if OPEN_MPI
+#include "mpi-ext.h" /* Needed for ROCm-aware check */
+#if defined(MPIX_ROCM_AWARE_SUPPORT) && MPIX_ROCM_AWARE_SUPPORT
+#define CAFFE2_HAS_ROCM_MPI 1
+#else // MPIX_ROCM_AWARE_SUPPORT
+#define CAFFE2_HAS_ROCM_MPI 0
+#endif // MPIX_ROCM_AWARE_SUPPORT
+#else // !OPEN_MPI
+#define CAFFE2_HAS_ROCM_MPI 0
+#endif // OPEN_MPI
+
+// We allow a macro to force using fallback functions.
+#ifdef CAFFE2_FORCE_FALLBACK_HIP_MPI
+#undef CAFFE2_HAS_ROCM_MPI
+#define CAFFE2_HAS_ROCM_MPI 0
+#endif // CAFFE2_FORCE_FALLBACK_HIP_MPI
+
+namespace {
+
+bool MPISupportsHIPBuffers()
+{
+#if CAFFE2_HAS_ROCM_MPI
+    static const bool supported = [] {
+        CheckInitializedMPI();
+        const bool rocm_aware = MPIX_Query_rocm_support();
+        if(!rocm_aware)
+        {
+            LOG(WARNING) << "The MPI library is not ROCm-aware at run time; "
+                         << "MPI operators will stage HIP tensors through host memory.";
+        }
+        return rocm_aware;
+    }();
+    return supported;
+#else
+    return false;
+#endif
+}
+
+// Creates the operator that hands HIP buffers to MPI directly when the MPI
+// library can read device memory, and the one that stages them through
+// pinned host tensors otherwise.
+template <class DeviceOp, class StagedOp>
+std::unique_ptr<OperatorBase> CreateMPIHIPOp(const OperatorDef& def, Workspace* ws)
+{
+    if(MPISupportsHIPBuffers())
+    {
+        return std::unique_ptr<OperatorBase>(new DeviceOp(def, ws));
+    }
+    return std::unique_ptr<OperatorBase>(new StagedOp(def, ws));
+}
+
+} // namespace
+
+REGISTER_HIP_OPERATOR(MPICreateCommonWorld, MPICreateCommonWorldOp<HIPContext>);
+REGISTER_HIP_OPERATOR_CREATOR(
+    MPIBroadcast,
+    CreateMPIHIPOp<MPIBroadcastOp<HIPContext>, GPUFallbackOp<MPIBroadcastOp<CPUContext>>>);
+REGISTER_HIP_OPERATOR_CREATOR(MPIReduce,
+                              CreateMPIHIPOp<MPIReduceOp<float, HIPContext>,
+                                             GPUFallbackOp<MPIReduceOp<float, CPUContext>>>);
+REGISTER_HIP_OPERATOR_CREATOR(MPIAllgather,
+                              CreateMPIHIPOp<MPIAllgatherOp<float, HIPContext>,
+                                             GPUFallbackOp<MPIAllgatherOp<float, CPUContext>>>);
+REGISTER_HIP_OPERATOR_CREATOR(MPIAllreduce,
+                              CreateMPIHIPOp<MPIAllreduceOp<float, HIPContext>,
+                                             GPUFallbackOp<MPIAllreduceOp<float, CPUContext>>>);
+REGISTER_HIP_OPERATOR_CREATOR(MPISendTensor,
+                              CreateMPIHIPOp<MPISendTensorOp<HIPContext>,
+                                             GPUFallbackOp<MPISendTensorOp<CPUContext>>>);
+REGISTER_HIP_OPERATOR_CREATOR(
+    MPIReceiveTensor,
+    CreateMPIHIPOp<MPIReceiveTensorOp<HIPContext>,
+                   GPUFallbackOp<MPIReceiveTensorOp<CPUContext>, SkipIndices<1, 2>>>);
+
+// The staged allreduce cannot be left in flight, since its host result is
+// copied back to the device right after the op runs. It reduces synchronously
+// instead and leaves the request blob unset, which MPIWait treats as done.
+REGISTER_HIP_OPERATOR_CREATOR(
+    MPIAllreduceAsync,
+    CreateMPIHIPOp<MPIAllreduceAsyncOp<float, HIPContext>,
+                   GPUFallbackOp<MPIAllreduceOp<float, CPUContext>, SkipIndices<1>>>);
+REGISTER_HIP_OPERATOR(MPIWait, MPIWaitOp<HIPContext>);
+
+} // namespace caffe2
@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "caffe2/mpi/mpi_sparse_ops.h"
+
+namespace caffe2 {
+
+OPERATOR_SCHEMA(MPIShardedSparseLengthsSum)
+  .NumInputs(4)
+  .NumOutputs(1)
+  .SetDoc(R"DOC(
+SparseLengthsSum over an embedding table whose rows are sharded over the ranks
+of the common world: row i lives on rank i % size, as row i / size of its
+DATA shard. Every rank looks up the unique INDICES once, sends each of them
+to its owner in one exchange, serves the rows the other ranks asked for out of
+its shard and sums the rows it got back into the segments given by LENGTHS.
+
+All the ranks have to run the operator together. It does not depend on the
+dense part of the model, so with an asynchronous net executor it runs while
+the dense layers compute.
+)DOC")
+  .Input(0, "comm", "The common world")
+  .Input(1, "DATA", "The local shard of the embedding table")
+  .Input(2, "INDICES", "Global row ids to look up")
+  .Input(3, "LENGTHS", "Number of INDICES in every segment")
+  .Output(0, "OUTPUT", "The summed rows of every segment");
+OPERATOR_SCHEMA(MPIShardedSparseAdagrad)
+  .NumInputs(6)
+  .NumOutputs(2)
+  .EnforceInplace({{1, 0}, {2, 1}})
+  .SetDoc(R"DOC(
+SparseAdagrad on an embedding table sharded as for MPIShardedSparseLengthsSum.
+The gradients of the rows every rank touched are summed, sent to the owners of
+the rows and applied to their shards of the parameters and moments.
+)DOC")
+  .Input(0, "comm", "The common world")
+  .Input(1, "param", "The local shard of the parameters")
+  .Input(2, "moment", "The local shard of the moments")
+  .Input(3, "indices", "Global row ids of the gradient")
+  .Input(4, "grad", "Gradient of every row in indices")
+  .Input(5, "lr", "Learning rate")
+  .Output(0, "output_param", "Updated shard of the parameters")
+  .Output(1, "output_moment", "Updated shard of the moments")
+  .Arg("epsilon", "Default 1e-5");
+
+REGISTER_CPU_OPERATOR(
+    MPIShardedSparseLengthsSum,
+    MPIShardedSparseLengthsSumOp);
+REGISTER_CPU_OPERATOR(MPIShardedSparseAdagrad, MPIShardedSparseAdagradOp);
+
+namespace {
+// The gradient of the rows is computed locally, as for SparseLengthsSum; it
+// is only sent to the owners of the rows by MPIShardedSparseAdagrad.
+class GetMPIShardedSparseLengthsSumGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    SetSparse(1, I(2), GI_V(1));
+    return SingleGradientDef(
+        "SparseLengthsIndicesInGradientSumGradient",
+        "",
+        vector<string>{GO(0), I(3), I(2)},
+        vector<string>{GI_V(1)});
+  }
+};
+} // namespace
+
+REGISTER_GRADIENT(
+    MPIShardedSparseLengthsSum,
+    GetMPIShardedSparseLengthsSumGradient);
+NO_GRADIENT(MPIShardedSparseAdagrad);
+
+}  // namespace caffe2
@@ -0,0 +1,321 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CAFFE2_MPI_MPI_SPARSE_OPS_H_
+#define CAFFE2_MPI_MPI_SPARSE_OPS_H_
+
+#include <mpi.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/mpi/mpi_common.h"
+#include "caffe2/perfkernels/embedding_lookup.h"
+#include "caffe2/sgd/adagrad_op.h"
+
+namespace caffe2 {
+
+namespace detail {
+
+// Sends sendCounts[r] elements of send to every rank r, in rank order, and
+// receives recvCounts[r] elements of every rank into recv.
+template <typename T>
+void MPIAlltoallv(
+    MPI_Comm comm,
+    const std::vector<T>& send,
+    const std::vector<int>& sendCounts,
+    const std::vector<int>& recvCounts,
+    std::vector<T>* recv) {
+  std::vector<int> sendDispls(sendCounts.size(), 0);
+  std::vector<int> recvDispls(recvCounts.size(), 0);
+  for (int r = 1; r < sendCounts.size(); ++r) {
+    sendDispls[r] = sendDispls[r - 1] + sendCounts[r - 1];
+    recvDispls[r] = recvDispls[r - 1] + recvCounts[r - 1];
+  }
+  recv->resize(recvDispls.back() + recvCounts.back());
+  MPI_CHECK(MPI_Alltoallv(
+      const_cast<T*>(send.data()),
+      const_cast<int*>(sendCounts.data()),
+      sendDispls.data(),
+      MPIDataTypeWrapper<T>::type(),
+      recv->data(),
+      const_cast<int*>(recvCounts.data()),
+      recvDispls.data(),
+      MPIDataTypeWrapper<T>::type(),
+      comm));
+}
+
+// The rows of a table sharded over the common world: row id is owned by rank
+// id % size, where it is row id / size of the local shard.
+struct ShardedIds {
+  // The unique ids of the indices, grouped by owner.
+  std::vector<int64_t> sendIds;
+  std::vector<int> sendCounts;
+  // For every index, its position in sendIds.
+  std::vector<int> positions;
+  // The ids of the local shard the other ranks asked for, grouped by sender.
+  std::vector<int64_t> recvIds;
+  std::vector<int> recvCounts;
+};
+
+// Deduplicates the indices, so that every row is only sent once per rank,
+// and exchanges them with their owners.
+template <typename SIndex>
+void RouteShardedIds(
+    const MPICommonWorldWrapper& comm,
+    const SIndex* indices,
+    TIndex n,
+    ShardedIds* ids) {
+  const int size = comm.size();
+  std::unordered_map<int64_t, int> unique;
+  std::vector<int64_t> uniqueIds;
+  std::vector<int> uniqueOf(n);
+  ids->sendCounts.assign(size, 0);
+  for (TIndex i = 0; i < n; ++i) {
+    const int64_t id = indices[i];
+    CAFFE_ENFORCE_GE(id, 0, "Negative index ", id);
+    auto it = unique.find(id);
+    if (it == unique.end()) {
+      it = unique.emplace(id, uniqueIds.size()).first;
+      uniqueIds.push_back(id);
+      ++ids->sendCounts[id % size];
+    }
+    uniqueOf[i] = it->second;
+  }
+
+  std::vector<int> offsets(size, 0);
+  for (int r = 1; r < size; ++r) {
+    offsets[r] = offsets[r - 1] + ids->sendCounts[r - 1];
+  }
+  std::vector<int> slots(uniqueIds.size());
+  ids->sendIds.resize(uniqueIds.size());
+  for (int u = 0; u < uniqueIds.size(); ++u) {
+    slots[u] = offsets[uniqueIds[u] % size]++;
+    ids->sendIds[slots[u]] = uniqueIds[u];
+  }
+  ids->positions.resize(n);
+  for (TIndex i = 0; i < n; ++i) {
+    ids->positions[i] = slots[uniqueOf[i]];
+  }
+
+  ids->recvCounts.resize(size);
+  MPI_CHECK(MPI_Alltoall(
+      ids->sendCounts.data(),
+      1,
+      MPIDataTypeWrapper<int>::type(),
+      ids->recvCounts.data(),
+      1,
+      MPIDataTypeWrapper<int>::type(),
+      comm.comm()));
+  MPIAlltoallv(
+      comm.comm(),
+      ids->sendIds,
+      ids->sendCounts,
+      ids->recvCounts,
+      &ids->recvIds);
+}
+
+inline std::vector<int> ScaleCounts(const std::vector<int>& counts, int n) {
+  std::vector<int> scaled(counts.size());
+  for (int r = 0; r < counts.size(); ++r) {
+    scaled[r] = counts[r] * n;
+  }
+  return scaled;
+}
+
+} // namespace detail
+
+// MPIShardedSparseLengthsSumOp is SparseLengthsSum over an embedding table
+// whose rows are sharded over the ranks of the common world.
+class MPIShardedSparseLengthsSumOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  MPIShardedSparseLengthsSumOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(
+        this, Input(INDICES));
+  }
+
+  template <typename SIndex>
+  bool DoRunWithType() {
+    const auto& comm = OperatorBase::Input<MPICommonWorldWrapper>(COMM);
+    auto& data = Input(DATA);
+    auto& indices = Input(INDICES);
+    auto& lengths = Input(LENGTHS);
+    CAFFE_ENFORCE_GE(data.ndim(), 1, "DATA should be at least 1-D");
+    CAFFE_ENFORCE_EQ(indices.ndim(), 1, "INDICES should be 1-D");
+    CAFFE_ENFORCE_EQ(lengths.ndim(), 1, "LENGTHS should be 1-D");
+    const TIndex blockSize = data.size_from_dim(1);
+    const int size = comm.size();
+
+    detail::ShardedIds ids;
+    detail::RouteShardedIds(
+        comm, indices.template data<SIndex>(), indices.size(), &ids);
+
+    // Serve the rows the other ranks asked for out of the local shard.
+    std::vector<int64_t> rows(ids.recvIds.size());
+    for (int i = 0; i < rows.size(); ++i) {
+      rows[i] = ids.recvIds[i] / size;
+    }
+    std::vector<int> ones(rows.size(), 1);
+    std::vector<float> served(rows.size() * blockSize);
+    EmbeddingLookup(
+        blockSize,
+        rows.size(),
+        rows.size(),
+        data.dim(0),
+        data.template data<float>(),
+        rows.data(),
+        ones.data(),
+        nullptr,
+        nullptr,
+        false,
+        served.data());
+
+    std::vector<float> fetched;
+    detail::MPIAlltoallv(
+        comm.comm(),
+        served,
+        detail::ScaleCounts(ids.recvCounts, blockSize),
+        detail::ScaleCounts(ids.sendCounts, blockSize),
+        &fetched);
+
+    auto outputDims = data.dims();
+    outputDims[0] = lengths.size();
+    auto* output = Output(0);
+    output->Resize(outputDims);
+    EmbeddingLookup(
+        blockSize,
+        lengths.size(),
+        indices.size(),
+        ids.sendIds.size(),
+        fetched.data(),
+        ids.positions.data(),
+        lengths.template data<int>(),
+        nullptr,
+        nullptr,
+        false,
+        output->template mutable_data<float>());
+    return true;
+  }
+
+  INPUT_TAGS(COMM, DATA, INDICES, LENGTHS);
+};
+
+// MPIShardedSparseAdagradOp is SparseAdagrad on an embedding table whose
+// rows are sharded over the ranks of the common world.
+class MPIShardedSparseAdagradOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  MPIShardedSparseAdagradOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)) {}
+
+  bool RunOnDevice() override {
+    CAFFE_ENFORCE_EQ(Input(PARAM).size(), Input(MOMENT_1).size());
+    CAFFE_ENFORCE_EQ(Input(LR).size(), 1);
+    CAFFE_ENFORCE_EQ(Input(INDICES).ndim(), 1, "INDICES should be 1-D");
+    CAFFE_ENFORCE_EQ(
+        Input(PARAM).size_from_dim(1),
+        Input(GRAD).size_from_dim(Input(INDICES).ndim()));
+    return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(
+        this, Input(INDICES));
+  }
+
+  template <typename SIndex>
+  bool DoRunWithType() {
+    const auto& comm = OperatorBase::Input<MPICommonWorldWrapper>(COMM);
+    auto& indices = Input(INDICES);
+    const TIndex blockSize = Input(PARAM).size_from_dim(1);
+    const TIndex numRows = Input(PARAM).dim(0);
+    const int size = comm.size();
+
+    detail::ShardedIds ids;
+    detail::RouteShardedIds(
+        comm, indices.template data<SIndex>(), indices.size(), &ids);
+
+    // The gradients of repeated indices are summed before they are sent.
+    std::vector<float> grads(ids.sendIds.size() * blockSize, 0.0f);
+    const auto* gradIn = Input(GRAD).template data<float>();
+    for (TIndex i = 0; i < indices.size(); ++i) {
+      auto* g = grads.data() + ids.positions[i] * blockSize;
+      for (TIndex j = 0; j < blockSize; ++j) {
+        g[j] += gradIn[i * blockSize + j];
+      }
+    }
+
+    std::vector<float> received;
+    detail::MPIAlltoallv(
+        comm.comm(),
+        grads,
+        detail::ScaleCounts(ids.sendCounts, blockSize),
+        detail::ScaleCounts(ids.recvCounts, blockSize),
+        &received);
+
+    // And so are the ones of the rows asked for by more than one rank.
+    std::unordered_map<int64_t, int> unique;
+    std::vector<int64_t> rows;
+    std::vector<float> summed;
+    for (int i = 0; i < ids.recvIds.size(); ++i) {
+      const int64_t row = ids.recvIds[i] / size;
+      CAFFE_ENFORCE_LT(row, numRows, "Index ", ids.recvIds[i], " out of range");
+      auto it = unique.find(row);
+      if (it == unique.end()) {
+        it = unique.emplace(row, rows.size()).first;
+        rows.push_back(row);
+        summed.resize(summed.size() + blockSize, 0.0f);
+      }
+      auto* g = summed.data() + it->second * blockSize;
+      for (TIndex j = 0; j < blockSize; ++j) {
+        g[j] += received[i * blockSize + j];
+      }
+    }
+
+    const auto* lr = Input(LR).template data<float>();
+    const auto* paramIn = Input(PARAM).template data<float>();
+    const auto* momentIn = Input(MOMENT_1).template data<float>();
+    auto* paramOut = Output(OUTPUT_PARAM)->template mutable_data<float>();
+    auto* momentOut = Output(OUTPUT_MOMENT_1)->template mutable_data<float>();
+    for (int i = 0; i < rows.size(); ++i) {
+      const auto offset = rows[i] * blockSize;
+      adagrad_update(
+          blockSize,
+          paramIn + offset,
+          summed.data() + i * blockSize,
+          momentIn + offset,
+          paramOut + offset,
+          momentOut + offset,
+          epsilon_,
+          1.0f,
+          lr,
+          &context_);
+    }
+    return true;
+  }
+
+ protected:
+  float epsilon_;
+  INPUT_TAGS(COMM, PARAM, MOMENT_1, INDICES, GRAD, LR);
+  OUTPUT_TAGS(OUTPUT_PARAM, OUTPUT_MOMENT_1);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_MPI_MPI_SPARSE_OPS_H_
@@ -316,6 +316,163 @@ TEST(MPITest, TestInPlaceMPIAllreduce) {
   }
 }
 
+const char kMPIAllreduceAsyncNet[] = R"NET(
+  name: "allreduce_async"
+  op {
+    output: "comm"
+    type: "MPICreateCommonWorld"
+  }
+  op {
+    output: "X"
+    type: "ConstantFill"
+    arg {
+      name: "shape"
+      ints: 10
+    }
+    arg {
+      name: "value"
+      f: 0.0
+    }
+  }
+  op {
+    input: "comm"
+    input: "X"
+    output: "X_reduced"
+    output: "request"
+    type: "MPIAllreduceAsync"
+  }
+  op {
+    input: "request"
+    input: "X_reduced"
+    output: "request"
+    output: "X_reduced"
+    type: "MPIWait"
+  }
+)NET";
+
+TEST(MPITest, TestMPIAllreduceAsync) {
+  NetDef net_def;
+  CHECK(google::protobuf::TextFormat::ParseFromString(
+      string(kMPIAllreduceAsyncNet), &net_def));
+  // Let's set the network's constant fill value to be the mpi rank.
+  auto* arg = net_def.mutable_op(1)->mutable_arg(1);
+  CAFFE_ENFORCE_EQ(arg->name(), "value");
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  arg->set_f(rank);
+  int size;
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  Workspace ws;
+  unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  EXPECT_NE(nullptr, net.get());
+  // The request is completed by MPIWait, so the net can be run again.
+  for (int run = 0; run < 2; ++run) {
+    EXPECT_TRUE(net->Run());
+    auto& X_reduced = ws.GetBlob("X_reduced")->Get<TensorCPU>();
+    EXPECT_EQ(X_reduced.size(), 10);
+    int expected_result = size * (size - 1) / 2;
+    for (int i = 0; i < X_reduced.size(); ++i) {
+      EXPECT_EQ(X_reduced.data<float>()[i], expected_result);
+    }
+  }
+}
+
+const char kMPIShardedSparseNet[] = R"NET(
+  name: "sharded_sparse"
+  op {
+    output: "comm"
+    type: "MPICreateCommonWorld"
+  }
+  op {
+    input: "comm"
+    input: "DATA"
+    input: "INDICES"
+    input: "LENGTHS"
+    output: "OUTPUT"
+    type: "MPIShardedSparseLengthsSum"
+  }
+  op {
+    input: "comm"
+    input: "DATA"
+    input: "MOMENT"
+    input: "INDICES"
+    input: "GRAD"
+    input: "LR"
+    output: "DATA"
+    output: "MOMENT"
+    type: "MPIShardedSparseAdagrad"
+  }
+)NET";
+
+TEST(MPITest, TestMPIShardedSparse) {
+  NetDef net_def;
+  CHECK(google::protobuf::TextFormat::ParseFromString(
+      string(kMPIShardedSparseNet), &net_def));
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  int size;
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  // Every rank holds 3 rows of 2 values, global row g being {g, -g}.
+  const int kRows = 3;
+  Workspace ws;
+  auto* data = ws.CreateBlob("DATA")->GetMutable<TensorCPU>();
+  data->Resize(kRows, 2);
+  for (int i = 0; i < kRows; ++i) {
+    const float g = i * size + rank;
+    data->mutable_data<float>()[2 * i] = g;
+    data->mutable_data<float>()[2 * i + 1] = -g;
+  }
+  auto* moment = ws.CreateBlob("MOMENT")->GetMutable<TensorCPU>();
+  moment->ResizeLike(*data);
+  std::fill(
+      moment->mutable_data<float>(),
+      moment->mutable_data<float>() + moment->size(),
+      0.0f);
+  const int last = kRows * size - 1;
+  const std::vector<int64_t> indices{0, 1, 0, last};
+  auto* indicesTensor = ws.CreateBlob("INDICES")->GetMutable<TensorCPU>();
+  indicesTensor->Resize(indices.size());
+  std::copy(
+      indices.begin(),
+      indices.end(),
+      indicesTensor->mutable_data<int64_t>());
+  auto* lengths = ws.CreateBlob("LENGTHS")->GetMutable<TensorCPU>();
+  lengths->Resize(2);
+  lengths->mutable_data<int>()[0] = 3;
+  lengths->mutable_data<int>()[1] = 1;
+  auto* grad = ws.CreateBlob("GRAD")->GetMutable<TensorCPU>();
+  grad->Resize(indices.size(), 2);
+  std::fill(
+      grad->mutable_data<float>(),
+      grad->mutable_data<float>() + grad->size(),
+      1.0f);
+  auto* lr = ws.CreateBlob("LR")->GetMutable<TensorCPU>();
+  lr->Resize(1);
+  lr->mutable_data<float>()[0] = 1.0f;
+
+  unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  EXPECT_NE(nullptr, net.get());
+  EXPECT_TRUE(net->Run());
+
+  auto& output = ws.GetBlob("OUTPUT")->Get<TensorCPU>();
+  EXPECT_EQ(output.size(), 4);
+  EXPECT_EQ(output.data<float>()[0], 1);
+  EXPECT_EQ(output.data<float>()[1], -1);
+  EXPECT_EQ(output.data<float>()[2], last);
+  EXPECT_EQ(output.data<float>()[3], -last);
+
+  // The rows every rank looked up all moved by lr, whatever their gradient.
+  auto& updated = ws.GetBlob("DATA")->Get<TensorCPU>();
+  for (int i = 0; i < kRows; ++i) {
+    const int g = i * size + rank;
+    const float step = (g == 0 || g == 1 || g == last) ? 1.0f : 0.0f;
+    EXPECT_NEAR(updated.data<float>()[2 * i], g + step, 1e-4);
+    EXPECT_NEAR(updated.data<float>()[2 * i + 1], -g + step, 1e-4);
+  }
+}
+
 }  // namespace caffe2
 
 
@@ -0,0 +1,123 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_CONTRIB_OBSERVERS_HIP_TIME_OBSERVER_H_
+#define CAFFE2_CONTRIB_OBSERVERS_HIP_TIME_OBSERVER_H_
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/common_hip.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/observer.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+template <class T>
+class HIPTimeObserver;
+
+/**
+ * Measures the device time of the HIP operators of a net, aggregated per
+ * operator type.
+ *
+ * Every HIP operator gets a pair of hipEvents recorded around it on stream 0
+ * of its GPU, which is the stream used by operators run from the simple and
+ * DAG nets. The pairs are resolved lazily with hipEventQuery at the start and
+ * end of every net run, so the observer never syncs the pipeline; only
+ * device_time_per_op_type() waits for the pairs still in flight. Each pair is
+ * queried on its own, since operators on different GPUs or DAG chains finish
+ * out of order. Events are pooled, so steady state runs do not create any.
+ *
+ *     auto* ob = net->AttachObserver(
+ *         caffe2::make_unique<HIPTimeObserver<NetBase>>(net.get()));
+ *     net->Run();
+ *     for(const auto& it : dynamic_cast_if_rtti<HIPTimeObserver<NetBase>*>(ob)
+ *                              ->device_time_per_op_type())
+ *     {
+ *         LOG(INFO) << it.first << ": " << it.second << " ms";
+ *     }
+ */
+template <>
+class HIPTimeObserver<NetBase> final : public ObserverBase<NetBase>
+{
+    public:
+    explicit HIPTimeObserver(NetBase* subject);
+    ~HIPTimeObserver();
+
+    void Start() override;
+    void Stop() override;
+
+    // Waits for the recorded events and returns the total device time in
+    // milliseconds of every operator type.
+    std::unordered_map<string, float> device_time_per_op_type();
+    // Number of timed runs of every operator type.
+    std::unordered_map<string, int> runs_per_op_type();
+
+    // Used by the operator observers, possibly from several threads at once.
+    hipEvent_t RecordEvent(int gpu_id);
+    void AddTiming(const string& op_type, int gpu_id, hipEvent_t start, hipEvent_t stop);
+
+    private:
+    struct Timing
+    {
+        string op_type;
+        int gpu_id;
+        hipEvent_t start;
+        hipEvent_t stop;
+    };
+
+    // Accumulates the timings whose events are done. With wait, blocks until
+    // all of them are.
+    void Resolve(bool wait);
+
+    vector<const ObserverBase<OperatorBase>*> operator_observers_;
+    // Guards the pending timings, the event pools and the totals.
+    std::mutex mutex_;
+    std::list<Timing> pending_;
+    vector<hipEvent_t> free_events_[CAFFE2_COMPILE_TIME_MAX_GPUS];
+    std::unordered_map<string, float> time_per_op_type_;
+    std::unordered_map<string, int> runs_per_op_type_;
+};
+
+template <>
+class HIPTimeObserver<OperatorBase> final : public ObserverBase<OperatorBase>
+{
+    public:
+    HIPTimeObserver(OperatorBase* subject, HIPTimeObserver<NetBase>* net_observer);
+
+    void Start() override;
+    void Stop() override;
+
+    std::unique_ptr<ObserverBase<OperatorBase>> copy(OperatorBase* subject) override
+    {
+        return std::unique_ptr<ObserverBase<OperatorBase>>(
+            new HIPTimeObserver<OperatorBase>(subject, net_observer_));
+    }
+
+    private:
+    HIPTimeObserver<NetBase>* net_observer_;
+    const string op_type_;
+    const bool is_hip_;
+    const int gpu_id_;
+    hipEvent_t start_ = nullptr;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CONTRIB_OBSERVERS_HIP_TIME_OBSERVER_H_
@@ -0,0 +1,163 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hip_time_observer.h"
+
+#include "caffe2/core/context_hip.h"
+
+namespace caffe2 {
+
+HIPTimeObserver<NetBase>::HIPTimeObserver(NetBase* subject) : ObserverBase<NetBase>(subject)
+{
+    for(auto* op : subject_->GetOperators())
+    {
+        const auto* observer =
+            op->AttachObserver(caffe2::make_unique<HIPTimeObserver<OperatorBase>>(op, this));
+        CAFFE_ENFORCE(observer != nullptr);
+        operator_observers_.push_back(observer);
+    }
+}
+
+HIPTimeObserver<NetBase>::~HIPTimeObserver()
+{
+    auto ops = subject_->GetOperators();
+    for(int i = 0; i < ops.size(); ++i)
+    {
+        ops[i]->DetachObserver(operator_observers_[i]);
+    }
+    Resolve(true);
+    for(int gpu_id = 0; gpu_id < CAFFE2_COMPILE_TIME_MAX_GPUS; ++gpu_id)
+    {
+        if(free_events_[gpu_id].empty())
+        {
+            continue;
+        }
+        DeviceGuard guard(gpu_id);
+        for(auto event : free_events_[gpu_id])
+        {
+            HIP_CHECK(hipEventDestroy(event));
+        }
+    }
+}
+
+void HIPTimeObserver<NetBase>::Start() { Resolve(false); }
+
+void HIPTimeObserver<NetBase>::Stop() { Resolve(false); }
+
+std::unordered_map<string, float> HIPTimeObserver<NetBase>::device_time_per_op_type()
+{
+    Resolve(true);
+    std::lock_guard<std::mutex> lock(mutex_);
+    return time_per_op_type_;
+}
+
+std::unordered_map<string, int> HIPTimeObserver<NetBase>::runs_per_op_type()
+{
+    Resolve(true);
+    std::lock_guard<std::mutex> lock(mutex_);
+    return runs_per_op_type_;
+}
+
+hipEvent_t HIPTimeObserver<NetBase>::RecordEvent(int gpu_id)
+{
+    hipEvent_t event = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& free_events = free_events_[gpu_id];
+        if(!free_events.empty())
+        {
+            event = free_events.back();
+            free_events.pop_back();
+        }
+    }
+    if(event == nullptr)
+    {
+        DeviceGuard guard(gpu_id);
+        HIP_ENFORCE(hipEventCreate(&event));
+    }
+    HIP_ENFORCE(hipEventRecord(event, HIPContext::hip_stream(gpu_id, 0)));
+    return event;
+}
+
+void HIPTimeObserver<NetBase>::AddTiming(const string& op_type,
+                                         int gpu_id,
+                                         hipEvent_t start,
+                                         hipEvent_t stop)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.push_back(Timing{op_type, gpu_id, start, stop});
+}
+
+void HIPTimeObserver<NetBase>::Resolve(bool wait)
+{
+    // Timings are recorded on several GPUs and from several DAG chains, so they
+    // do not finish in the order they were added: check every one of them.
+    std::lock_guard<std::mutex> lock(mutex_);
+    for(auto it = pending_.begin(); it != pending_.end();)
+    {
+        const auto& timing = *it;
+        if(wait)
+        {
+            HIP_ENFORCE(hipEventSynchronize(timing.stop));
+        }
+        else
+        {
+            const hipError_t status = hipEventQuery(timing.stop);
+            if(status == hipErrorNotReady)
+            {
+                ++it;
+                continue;
+            }
+            HIP_ENFORCE(status);
+        }
+        float milliseconds = 0;
+        HIP_ENFORCE(hipEventElapsedTime(&milliseconds, timing.start, timing.stop));
+        time_per_op_type_[timing.op_type] += milliseconds;
+        ++runs_per_op_type_[timing.op_type];
+        free_events_[timing.gpu_id].push_back(timing.start);
+        free_events_[timing.gpu_id].push_back(timing.stop);
+        it = pending_.erase(it);
+    }
+}
+
+HIPTimeObserver<OperatorBase>::HIPTimeObserver(OperatorBase* subject,
+                                               HIPTimeObserver<NetBase>* net_observer)
+    : ObserverBase<OperatorBase>(subject),
+      net_observer_(net_observer),
+      op_type_(subject->has_debug_def() ? subject->debug_def().type() : "unknown"),
+      is_hip_(subject->device_option().device_type() == HIP),
+      gpu_id_(subject->device_option().hip_gpu_id())
+{
+}
+
+void HIPTimeObserver<OperatorBase>::Start()
+{
+    if(is_hip_)
+    {
+        start_ = net_observer_->RecordEvent(gpu_id_);
+    }
+}
+
+void HIPTimeObserver<OperatorBase>::Stop()
+{
+    if(is_hip_ && start_ != nullptr)
+    {
+        net_observer_->AddTiming(op_type_, gpu_id_, start_, net_observer_->RecordEvent(gpu_id_));
+        start_ = nullptr;
+    }
+}
+
+} // namespace caffe2
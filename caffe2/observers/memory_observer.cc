@@ -0,0 +1,204 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/observers/memory_observer.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace caffe2 {
+
+namespace {
+
+// The operator that the thread is running, for the observer of its net.
+thread_local const MemoryNetObserver* tls_net = nullptr;
+thread_local int tls_op = -1;
+
+std::string DeviceName(int device) {
+  return device < 0 ? std::string("CPU") : "GPU " + caffe2::to_string(device);
+}
+
+std::string FormatBytes(int64_t bytes) {
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(1) << bytes / 1048576.0 << " MB";
+  return ss.str();
+}
+
+} // namespace
+
+MemoryNetObserver::MemoryNetObserver(NetBase* subject, int keep_runs)
+    : ObserverBase<NetBase>(subject),
+      keep_runs_(keep_runs),
+      handle_(std::make_shared<MemoryNetObserver*>(this)) {
+  CAFFE_ENFORCE(
+      GetMemoryAllocationObserver() == nullptr,
+      "Only one MemoryNetObserver can be attached at a time.");
+  const auto& ops = subject->GetOperators();
+  for (int i = 0; i < ops.size(); ++i) {
+    std::string name = "#" + caffe2::to_string(i);
+    if (ops[i]->has_debug_def()) {
+      const auto& def = ops[i]->debug_def();
+      name += " " + def.type() + " (";
+      for (int j = 0; j < def.output_size(); ++j) {
+        name += (j ? ", " : "") + def.output(j);
+      }
+      name += ")";
+    }
+    op_names_.push_back(name);
+    ops[i]->AttachObserver(
+        caffe2::make_unique<MemoryOperatorObserver>(ops[i], handle_, i));
+  }
+  SetMemoryAllocationObserver(this);
+}
+
+MemoryNetObserver::~MemoryNetObserver() {
+  SetMemoryAllocationObserver(nullptr);
+  *handle_ = nullptr;
+}
+
+MemoryNetObserver::DeviceState& MemoryNetObserver::State(int device) {
+  auto& state = devices_[device];
+  if (state.live_bytes_by_op.empty()) {
+    state.live_bytes_by_op.resize(op_names_.size() + 1, 0);
+  }
+  if (running_ && !current_.count(device)) {
+    auto& run = current_[device];
+    run.run = run_index_;
+    run.start_bytes = run.peak_bytes = state.live_bytes;
+    run.peak_op = outside_ops();
+    run.peak_bytes_by_op = state.live_bytes_by_op;
+  }
+  return state;
+}
+
+void MemoryNetObserver::OnNew(void* ptr, size_t nbytes, int device) {
+  const int op = tls_net == this ? tls_op : outside_ops();
+  std::lock_guard<std::mutex> lock(mutex_);
+  allocations_[ptr] = Allocation{nbytes, device, op};
+  auto& state = State(device);
+  state.live_bytes += nbytes;
+  state.live_bytes_by_op[op] += nbytes;
+  if (running_) {
+    auto& run = current_[device];
+    if (state.live_bytes > run.peak_bytes) {
+      run.peak_bytes = state.live_bytes;
+      run.peak_op = op;
+      run.peak_bytes_by_op = state.live_bytes_by_op;
+    }
+  }
+}
+
+void MemoryNetObserver::OnDelete(void* ptr) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = allocations_.find(ptr);
+  if (it == allocations_.end()) {
+    return;
+  }
+  auto& state = State(it->second.device);
+  state.live_bytes -= it->second.nbytes;
+  state.live_bytes_by_op[it->second.op] -= it->second.nbytes;
+  allocations_.erase(it);
+}
+
+void MemoryNetObserver::Start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  running_ = true;
+  current_.clear();
+  for (auto& it : devices_) {
+    State(it.first);
+  }
+}
+
+void MemoryNetObserver::Stop() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  running_ = false;
+  for (auto& it : current_) {
+    auto peak = peaks_.find(it.first);
+    if (peak == peaks_.end() ||
+        it.second.peak_bytes > peak->second.peak_bytes) {
+      peaks_[it.first] = it.second;
+    }
+  }
+  runs_.push_back(std::move(current_));
+  current_.clear();
+  while (runs_.size() > keep_runs_) {
+    runs_.pop_front();
+  }
+  ++run_index_;
+}
+
+void MemoryNetObserver::StartOp(int op) {
+  tls_net = this;
+  tls_op = op;
+}
+
+void MemoryNetObserver::StopOp(int op) {
+  tls_net = nullptr;
+  tls_op = -1;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!running_) {
+    return;
+  }
+  for (auto& it : devices_) {
+    State(it.first);
+    current_[it.first].timeline.emplace_back(op, it.second.live_bytes);
+  }
+}
+
+std::deque<MemoryNetObserver::Run> MemoryNetObserver::runs() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return runs_;
+}
+
+std::map<int, MemoryNetObserver::DeviceRun> MemoryNetObserver::peaks() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return peaks_;
+}
+
+std::string MemoryNetObserver::PeakBreakdown(int top) const {
+  std::stringstream ss;
+  for (const auto& it : peaks()) {
+    const auto& peak = it.second;
+    ss << DeviceName(it.first) << ": peak of " << FormatBytes(peak.peak_bytes)
+       << " in run " << peak.run << ", while running "
+       << (peak.peak_op < outside_ops() ? op_names_[peak.peak_op]
+                                        : std::string("no operator"))
+       << "\n";
+    std::vector<int> order;
+    for (int op = 0; op < peak.peak_bytes_by_op.size(); ++op) {
+      if (peak.peak_bytes_by_op[op] != 0) {
+        order.push_back(op);
+      }
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+      return peak.peak_bytes_by_op[a] > peak.peak_bytes_by_op[b];
+    });
+    if (order.size() > top) {
+      order.resize(top);
+    }
+    for (int op : order) {
+      ss << "  " << std::setw(10) << FormatBytes(peak.peak_bytes_by_op[op])
+         << "  "
+         << (op < outside_ops() ? op_names_[op]
+                                : std::string("outside of the operators"))
+         << "\n";
+    }
+  }
+  return ss.str();
+}
+
+} // namespace caffe2
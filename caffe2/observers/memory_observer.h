@@ -0,0 +1,159 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_CONTRIB_OBSERVERS_MEMORY_OBSERVER_H_
+#define CAFFE2_CONTRIB_OBSERVERS_MEMORY_OBSERVER_H_
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "caffe2/core/allocator.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/observer.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+/**
+ * Attributes the memory allocated by CPUContext::New and HIPContext::New to
+ * the operators of a net, and records the bytes live on every device over the
+ * runs of the net, for finding out which operators make the peak memory. The
+ * allocations are tagged with the operator that the allocating thread is
+ * running, so this works with the async executors too. Memory allocated
+ * outside of the operators of the net, e.g. by FeedBlob, is put under
+ * outside_ops(), and memory allocated before the observer was attached is not
+ * counted at all.
+ *
+ * Only one MemoryNetObserver can be attached at a time, as it installs itself
+ * as the process wide MemoryAllocationObserver.
+ */
+class MemoryNetObserver final : public ObserverBase<NetBase>,
+                                public MemoryAllocationObserver {
+ public:
+  // Memory of one device over one run. Devices are -1 for the CPU and the
+  // gpu id otherwise.
+  struct DeviceRun {
+    int run = 0;
+    int64_t start_bytes = 0;
+    // (operator, live bytes) after every operator, in the order in which the
+    // operators finished.
+    std::vector<std::pair<int, int64_t>> timeline;
+    int64_t peak_bytes = 0;
+    // The operator running when the peak was reached, and the bytes live at
+    // that point by operator that allocated them (outside_ops() last).
+    int peak_op = -1;
+    std::vector<int64_t> peak_bytes_by_op;
+  };
+  using Run = std::map<int, DeviceRun>;
+
+  // keep_runs is the number of recent runs that runs() keeps.
+  explicit MemoryNetObserver(NetBase* subject, int keep_runs = 10);
+  ~MemoryNetObserver();
+
+  // Index of the memory allocated outside of the operators of the net.
+  int outside_ops() const {
+    return op_names_.size();
+  }
+
+  std::deque<Run> runs() const;
+  // The run with the highest peak of every device.
+  std::map<int, DeviceRun> peaks() const;
+
+  // Formats the peaks(): for every device, the top operators by bytes live
+  // at the peak.
+  std::string PeakBreakdown(int top = 10) const;
+  std::string debugInfo() override {
+    return PeakBreakdown();
+  }
+
+  void OnNew(void* ptr, size_t nbytes, int device) override;
+  void OnDelete(void* ptr) override;
+
+  // Called by the operator observers.
+  void StartOp(int op);
+  void StopOp(int op);
+
+ private:
+  void Start() override;
+  void Stop() override;
+
+  struct Allocation {
+    size_t nbytes;
+    int device;
+    int op;
+  };
+
+  struct DeviceState {
+    int64_t live_bytes = 0;
+    std::vector<int64_t> live_bytes_by_op;
+  };
+
+  DeviceState& State(int device);
+
+  std::vector<std::string> op_names_;
+  int keep_runs_;
+
+  mutable std::mutex mutex_;
+  std::unordered_map<void*, Allocation> allocations_;
+  std::map<int, DeviceState> devices_;
+  int run_index_ = 0;
+  bool running_ = false;
+  Run current_;
+  std::deque<Run> runs_;
+  std::map<int, DeviceRun> peaks_;
+  // Shared with the operator observers, which outlive this one when it is
+  // detached from the net, or when the net is destroyed.
+  std::shared_ptr<MemoryNetObserver*> handle_;
+};
+
+class MemoryOperatorObserver final : public ObserverBase<OperatorBase> {
+ public:
+  MemoryOperatorObserver(
+      OperatorBase* subject,
+      std::shared_ptr<MemoryNetObserver*> net,
+      int op)
+      : ObserverBase<OperatorBase>(subject), net_(std::move(net)), op_(op) {}
+
+  std::unique_ptr<ObserverBase<OperatorBase>> copy(
+      OperatorBase* subject) override {
+    return caffe2::make_unique<MemoryOperatorObserver>(subject, net_, op_);
+  }
+
+ private:
+  void Start() override {
+    if (*net_) {
+      (*net_)->StartOp(op_);
+    }
+  }
+  void Stop() override {
+    if (*net_) {
+      (*net_)->StopOp(op_);
+    }
+  }
+
+  std::shared_ptr<MemoryNetObserver*> net_;
+  int op_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CONTRIB_OBSERVERS_MEMORY_OBSERVER_H_
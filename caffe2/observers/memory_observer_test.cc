@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "memory_observer.h"
+
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+namespace {
+
+constexpr int64_t kMB = 1 << 20;
+
+// Allocates an output of "mb" MB, or frees it when mb is 0.
+class MemoryObserverAllocOp final : public Operator<CPUContext> {
+ public:
+  MemoryObserverAllocOp(const OperatorDef& def, Workspace* ws)
+      : Operator<CPUContext>(def, ws),
+        mb_(OperatorBase::GetSingleArgument<int>("mb", 0)) {}
+
+  bool RunOnDevice() override {
+    if (mb_ == 0) {
+      OperatorBase::OutputBlob(0)->Reset();
+    } else {
+      Output(0)->Resize(mb_ * kMB);
+      Output(0)->mutable_data<char>();
+    }
+    return true;
+  }
+
+ private:
+  int mb_;
+};
+
+REGISTER_CPU_OPERATOR(MemoryObserverAllocOp, MemoryObserverAllocOp);
+
+OPERATOR_SCHEMA(MemoryObserverAllocOp).NumInputs(0).NumOutputs(1);
+
+unique_ptr<NetBase> CreateNetTestHelper(Workspace* ws) {
+  NetDef net_def;
+  net_def.set_name("memory_observer_test");
+  const std::vector<std::pair<std::string, int>> ops = {
+      {"A", 1}, {"B", 2}, {"A", 0}, {"C", 1}};
+  for (const auto& it : ops) {
+    auto& op = *(net_def.add_op());
+    op.set_type("MemoryObserverAllocOp");
+    op.add_output(it.first);
+    auto& arg = *(op.add_arg());
+    arg.set_name("mb");
+    arg.set_i(it.second);
+  }
+  return CreateNet(net_def, ws);
+}
+
+} // namespace
+
+TEST(MemoryObserverTest, AttributesPeakToOperators) {
+  Workspace ws;
+  unique_ptr<NetBase> net(CreateNetTestHelper(&ws));
+  const auto* observer = dynamic_cast_if_rtti<const MemoryNetObserver*>(
+      net->AttachObserver(make_unique<MemoryNetObserver>(net.get())));
+  EXPECT_EQ(GetMemoryAllocationObserver(), observer);
+  // The first run peaks at A and B, the second one at B, C and the A
+  // allocated again by the first operator.
+  EXPECT_TRUE(net->Run());
+  EXPECT_TRUE(net->Run());
+
+  auto runs = observer->runs();
+  ASSERT_EQ(runs.size(), 2);
+  const auto& first = runs[0].at(-1);
+  EXPECT_EQ(first.start_bytes, 0);
+  EXPECT_EQ(first.peak_bytes, 3 * kMB);
+  EXPECT_EQ(first.peak_op, 1);
+  const auto& second = runs[1].at(-1);
+  EXPECT_EQ(second.start_bytes, 3 * kMB);
+  EXPECT_EQ(second.peak_bytes, 4 * kMB);
+  EXPECT_EQ(second.peak_op, 0);
+  const std::vector<std::pair<int, int64_t>> timeline = {
+      {0, 4 * kMB}, {1, 4 * kMB}, {2, 3 * kMB}, {3, 3 * kMB}};
+  EXPECT_EQ(second.timeline, timeline);
+
+  auto peak = observer->peaks().at(-1);
+  EXPECT_EQ(peak.run, 1);
+  const std::vector<int64_t> by_op = {kMB, 2 * kMB, 0, kMB, 0};
+  EXPECT_EQ(peak.peak_bytes_by_op, by_op);
+  const auto breakdown = observer->PeakBreakdown();
+  EXPECT_NE(breakdown.find("CPU: peak of 4.0 MB in run 1"), std::string::npos);
+  EXPECT_LT(
+      breakdown.find("#1 MemoryObserverAllocOp (B)"),
+      breakdown.find("#0 MemoryObserverAllocOp (A)"));
+
+  net.reset();
+  EXPECT_EQ(GetMemoryAllocationObserver(), nullptr);
+}
+
+} // namespace caffe2
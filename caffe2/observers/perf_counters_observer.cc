@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/observers/perf_counters_observer.h"
+
+namespace caffe2 {
+
+namespace {
+
+std::string NetStatsName(const NetBase* net) {
+  return "net/" + (net->Name().empty() ? std::string("unnamed") : net->Name());
+}
+
+std::string OperatorStatsName(const OperatorBase* op) {
+  return "op/" +
+      (op->has_debug_def() ? op->debug_def().type() : std::string("unknown"));
+}
+
+} // namespace
+
+const std::vector<int64_t>& PerfCountersNetObserver::LatencyBucketBounds() {
+  static const std::vector<int64_t> bounds = []() {
+    std::vector<int64_t> b;
+    for (int64_t bound = 64; bound <= (int64_t(1) << 26); bound *= 2) {
+      b.push_back(bound);
+    }
+    return b;
+  }();
+  return bounds;
+}
+
+PerfCountersNetObserver::PerfCountersNetObserver(NetBase* subject)
+    : ObserverBase<NetBase>(subject), stats_(NetStatsName(subject)) {
+  for (auto bound : LatencyBucketBounds()) {
+    buckets_.emplace_back(
+        stats_.groupName, "latency_us_bucket/" + caffe2::to_string(bound));
+  }
+  buckets_.emplace_back(stats_.groupName, "latency_us_bucket/inf");
+  for (auto* op : subject->GetOperators()) {
+    op->AttachObserver(caffe2::make_unique<PerfCountersOperatorObserver>(op));
+  }
+}
+
+void PerfCountersNetObserver::Start() {
+  timer_.Start();
+}
+
+void PerfCountersNetObserver::Stop() {
+  const int64_t us = static_cast<int64_t>(timer_.MicroSeconds());
+  CAFFE_EVENT(stats_, latency_us_count);
+  CAFFE_EVENT(stats_, latency_us_sum, us);
+  // Buckets are cumulative, so a run counts in every bucket it fits in.
+  const auto& bounds = LatencyBucketBounds();
+  for (int i = bounds.size() - 1; i >= 0 && us <= bounds[i]; --i) {
+    buckets_[i].increment();
+  }
+  buckets_.back().increment();
+}
+
+PerfCountersOperatorObserver::PerfCountersOperatorObserver(
+    OperatorBase* subject)
+    : ObserverBase<OperatorBase>(subject),
+      stats_(OperatorStatsName(subject)) {}
+
+std::unique_ptr<ObserverBase<OperatorBase>> PerfCountersOperatorObserver::copy(
+    OperatorBase* subject) {
+  return std::unique_ptr<ObserverBase<OperatorBase>>(
+      new PerfCountersOperatorObserver(subject));
+}
+
+void PerfCountersOperatorObserver::Start() {
+  timer_.Start();
+}
+
+void PerfCountersOperatorObserver::Stop() {
+  CAFFE_EVENT(stats_, runs);
+  CAFFE_EVENT(stats_, time_us, static_cast<int64_t>(timer_.MicroSeconds()));
+}
+
+void EnablePerfCounters() {
+  SetGlobalNetObserverCreator([](NetBase* net) {
+    return caffe2::make_unique<PerfCountersNetObserver>(net);
+  });
+}
+
+} // namespace caffe2
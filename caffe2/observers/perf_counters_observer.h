@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_CONTRIB_OBSERVERS_PERF_COUNTERS_OBSERVER_H_
+#define CAFFE2_CONTRIB_OBSERVERS_PERF_COUNTERS_OBSERVER_H_
+
+#include <vector>
+
+#include "caffe2/core/net.h"
+#include "caffe2/core/observer.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/stats.h"
+#include "caffe2/core/timer.h"
+
+namespace caffe2 {
+
+/**
+ * Publishes continuous performance counters of a net and its operators into
+ * the StatRegistry singleton, where a StatExporter (see stat_exporter.h) can
+ * pick them up. All counters are cumulative:
+ *
+ *   net/<net name>/latency_us_count           runs
+ *   net/<net name>/latency_us_sum
+ *   net/<net name>/latency_us_bucket/<bound>  runs that took <= bound us
+ *   op/<operator type>/runs
+ *   op/<operator type>/time_us
+ *
+ * The latency buckets are powers of two from 64us to about 67s, plus "inf",
+ * i.e. a Prometheus histogram. Operator times are host times, so for
+ * operators with an asynchronous device part they include their launch only.
+ */
+class PerfCountersNetObserver final : public ObserverBase<NetBase> {
+ public:
+  explicit PerfCountersNetObserver(NetBase* subject);
+
+  static const std::vector<int64_t>& LatencyBucketBounds();
+
+ private:
+  void Start() override;
+  void Stop() override;
+
+  struct NetStats {
+    CAFFE_STAT_CTOR(NetStats);
+    CAFFE_EXPORTED_STAT(latency_us_count);
+    CAFFE_EXPORTED_STAT(latency_us_sum);
+  } stats_;
+  // One counter per bound of LatencyBucketBounds(), and one for "inf".
+  std::vector<ExportedStat> buckets_;
+  Timer timer_;
+};
+
+class PerfCountersOperatorObserver final : public ObserverBase<OperatorBase> {
+ public:
+  explicit PerfCountersOperatorObserver(OperatorBase* subject);
+
+  std::unique_ptr<ObserverBase<OperatorBase>> copy(
+      OperatorBase* subject) override;
+
+ private:
+  void Start() override;
+  void Stop() override;
+
+  struct OperatorStats {
+    CAFFE_STAT_CTOR(OperatorStats);
+    CAFFE_EXPORTED_STAT(runs);
+    CAFFE_EXPORTED_STAT(time_us);
+  } stats_;
+  Timer timer_;
+};
+
+/**
+ * Attaches a PerfCountersNetObserver to every net created from now on, in
+ * place of the default global observer.
+ */
+void EnablePerfCounters();
+
+} // namespace caffe2
+
+#endif // CAFFE2_CONTRIB_OBSERVERS_PERF_COUNTERS_OBSERVER_H_
@@ -0,0 +1,111 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/stats.h"
+#include "perf_counters_observer.h"
+#include "stat_exporter.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace caffe2 {
+
+namespace {
+
+class PerfCountersSleepOp final : public OperatorBase {
+ public:
+  using OperatorBase::OperatorBase;
+  bool Run(int /* unused */) override {
+    StartAllObservers();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    StopAllObservers();
+    return true;
+  }
+};
+
+REGISTER_CPU_OPERATOR(PerfCountersSleepOp, PerfCountersSleepOp);
+
+OPERATOR_SCHEMA(PerfCountersSleepOp)
+    .NumInputs(0, INT_MAX)
+    .NumOutputs(0, INT_MAX);
+
+unique_ptr<NetBase> CreateNetTestHelper(Workspace* ws, const string& name) {
+  NetDef net_def;
+  net_def.set_name(name);
+  for (int i = 0; i < 2; ++i) {
+    auto& op = *(net_def.add_op());
+    op.set_type("PerfCountersSleepOp");
+  }
+  return CreateNet(net_def, ws);
+}
+
+} // namespace
+
+TEST(PerfCountersObserverTest, PublishesToStatRegistry) {
+  Workspace ws;
+  unique_ptr<NetBase> net(CreateNetTestHelper(&ws, "perf_counters_test"));
+  net->AttachObserver(make_unique<PerfCountersNetObserver>(net.get()));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(net->Run());
+  }
+  auto stats = toMap(StatRegistry::get().publish());
+  const string net_prefix = "net/perf_counters_test/";
+  EXPECT_EQ(stats[net_prefix + "latency_us_count"], 3);
+  EXPECT_GE(stats[net_prefix + "latency_us_sum"], 3 * 20000);
+  // Every run took more than 20ms, none more than a minute.
+  EXPECT_EQ(stats[net_prefix + "latency_us_bucket/64"], 0);
+  EXPECT_EQ(stats[net_prefix + "latency_us_bucket/67108864"], 3);
+  EXPECT_EQ(stats[net_prefix + "latency_us_bucket/inf"], 3);
+  EXPECT_GE(stats["op/PerfCountersSleepOp/runs"], 6);
+  EXPECT_GE(stats["op/PerfCountersSleepOp/time_us"], 6 * 10000);
+}
+
+TEST(PerfCountersObserverTest, PrometheusExporter) {
+  const string path = "perf_counters_observer_test.prom";
+  auto exporter = CreateStatExporter("prometheus:" + path);
+  ExportedStatList stats = {
+      {"net/a/latency_us_bucket/128", 2, {}},
+      {"net/a/latency_us_bucket/inf", 3, {}},
+      {"op/FC/time_us", 7, {}},
+  };
+  exporter->Export(stats);
+  std::ifstream in(path);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  EXPECT_EQ(
+      ss.str(),
+      "caffe2_net_a_latency_us_bucket{le=\"128\"} 2\n"
+      "caffe2_net_a_latency_us_bucket{le=\"+Inf\"} 3\n"
+      "caffe2_op_FC_time_us 7\n");
+  std::remove(path.c_str());
+}
+
+TEST(PerfCountersObserverTest, Gauges) {
+  RegisterStatGaugeUpdater(
+      []() { SetStatGauge("perf_counters_test/gauge", 42); });
+  UpdateStatGauges();
+  UpdateStatGauges();
+  auto stats = toMap(StatRegistry::get().publish());
+  EXPECT_EQ(stats["perf_counters_test/gauge"], 42);
+}
+
+} // namespace caffe2
@@ -0,0 +1,283 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/observers/stat_exporter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#ifndef _WIN32
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#include "caffe2/core/init.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/observers/perf_counters_observer.h"
+
+CAFFE2_DEFINE_string(
+    caffe2_stat_export,
+    "",
+    "If set, attach performance counter observers to every net and export "
+    "the StatRegistry to this target, e.g. prometheus:/path/caffe2.prom or "
+    "statsd:localhost:8125.");
+CAFFE2_DEFINE_int(
+    caffe2_stat_export_interval_ms,
+    10000,
+    "Interval between two exports of --caffe2_stat_export.");
+
+namespace caffe2 {
+
+CAFFE_DEFINE_REGISTRY(StatExporterRegistry, StatExporter, const std::string&);
+
+std::unique_ptr<StatExporter> CreateStatExporter(const std::string& target) {
+  const auto pos = target.find(':');
+  CAFFE_ENFORCE(
+      pos != std::string::npos,
+      "Stat export target must be <exporter>:<argument>, got ",
+      target);
+  auto exporter = StatExporterRegistry()->Create(
+      target.substr(0, pos), target.substr(pos + 1));
+  CAFFE_ENFORCE(exporter, "Unknown stat exporter in ", target);
+  return exporter;
+}
+
+namespace {
+
+std::mutex& GaugeUpdatersMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::vector<std::function<void()>>& GaugeUpdaters() {
+  static std::vector<std::function<void()>> updaters;
+  return updaters;
+}
+
+} // namespace
+
+void SetStatGauge(const std::string& name, int64_t value) {
+  StatRegistry::get().add(name)->reset(value);
+}
+
+void RegisterStatGaugeUpdater(std::function<void()> updater) {
+  std::lock_guard<std::mutex> guard(GaugeUpdatersMutex());
+  GaugeUpdaters().push_back(std::move(updater));
+}
+
+void UpdateStatGauges() {
+  std::lock_guard<std::mutex> guard(GaugeUpdatersMutex());
+  for (const auto& updater : GaugeUpdaters()) {
+    updater();
+  }
+}
+
+StatExportThread::StatExportThread(
+    std::unique_ptr<StatExporter> exporter,
+    std::chrono::milliseconds interval)
+    : exporter_(std::move(exporter)), interval_(interval) {
+  CAFFE_ENFORCE(exporter_);
+  CAFFE_ENFORCE_GT(interval_.count(), 0);
+  thread_ = std::thread([this]() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!cv_.wait_for(lock, interval_, [this]() { return stop_; })) {
+      lock.unlock();
+      ExportNow();
+      lock.lock();
+    }
+  });
+}
+
+StatExportThread::~StatExportThread() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+  ExportNow();
+}
+
+void StatExportThread::ExportNow() {
+  UpdateStatGauges();
+  auto stats = StatRegistry::get().publish();
+  try {
+    exporter_->Export(stats);
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Stat export failed: " << e.what();
+  }
+}
+
+namespace {
+
+// Maps a StatRegistry key such as "net/train/latency_us_sum" to a metric name
+// such as "caffe2_net_train_latency_us_sum".
+std::string MetricName(const std::string& key, char separator) {
+  std::string name = "caffe2";
+  name += separator;
+  for (char c : key) {
+    const bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+        (c >= '0' && c <= '9') || c == '_';
+    name += valid ? c : (c == '/' ? separator : '_');
+  }
+  return name;
+}
+
+class PrometheusFileExporter final : public StatExporter {
+ public:
+  explicit PrometheusFileExporter(const std::string& path) : path_(path) {
+    CAFFE_ENFORCE(!path_.empty(), "prometheus exporter needs a file name");
+  }
+
+  void Export(const ExportedStatList& stats) override {
+    ExportedStatList sorted(stats);
+    std::sort(
+        sorted.begin(),
+        sorted.end(),
+        [](const ExportedStatValue& a, const ExportedStatValue& b) {
+          return a.key < b.key;
+        });
+    std::stringstream ss;
+    for (const auto& stat : sorted) {
+      const auto pos = stat.key.rfind("_bucket/");
+      if (pos == std::string::npos) {
+        ss << MetricName(stat.key, '_') << " " << stat.value << "\n";
+        continue;
+      }
+      const std::string bound = stat.key.substr(pos + 8);
+      ss << MetricName(stat.key.substr(0, pos), '_') << "_bucket{le=\""
+         << (bound == "inf" ? "+Inf" : bound) << "\"} " << stat.value << "\n";
+    }
+    // Write and rename, so that the collector never reads a partial file.
+    const std::string tmp_path = path_ + ".tmp";
+    {
+      std::ofstream out(tmp_path, std::ios::trunc);
+      CAFFE_ENFORCE(out.good(), "Cannot open ", tmp_path);
+      out << ss.str();
+      CAFFE_ENFORCE(out.good(), "Cannot write ", tmp_path);
+    }
+    CAFFE_ENFORCE_EQ(
+        std::rename(tmp_path.c_str(), path_.c_str()),
+        0,
+        "Cannot write ",
+        path_);
+  }
+
+ private:
+  const std::string path_;
+};
+
+REGISTER_STAT_EXPORTER(prometheus, PrometheusFileExporter);
+
+#ifndef _WIN32
+class StatsdExporter final : public StatExporter {
+ public:
+  explicit StatsdExporter(const std::string& address) {
+    const auto pos = address.rfind(':');
+    CAFFE_ENFORCE(
+        pos != std::string::npos,
+        "statsd exporter needs host:port, got ",
+        address);
+    struct addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    struct addrinfo* info = nullptr;
+    const int err = getaddrinfo(
+        address.substr(0, pos).c_str(),
+        address.substr(pos + 1).c_str(),
+        &hints,
+        &info);
+    CAFFE_ENFORCE_EQ(
+        err, 0, "Cannot resolve ", address, ": ", gai_strerror(err));
+    fd_ = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+    if (fd_ >= 0 && connect(fd_, info->ai_addr, info->ai_addrlen) != 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+    freeaddrinfo(info);
+    CAFFE_ENFORCE_GE(fd_, 0, "Cannot open a UDP socket to ", address);
+  }
+
+  ~StatsdExporter() {
+    close(fd_);
+  }
+
+  void Export(const ExportedStatList& stats) override {
+    // Counters are cumulative, so they are sent as gauges. Lines are batched
+    // into datagrams that fit an ethernet MTU.
+    std::string packet;
+    for (const auto& stat : stats) {
+      const std::string line = MetricName(stat.key, '.') + ":" +
+          caffe2::to_string(stat.value) + "|g\n";
+      if (!packet.empty() && packet.size() + line.size() > kMaxPacketBytes) {
+        Send(packet);
+        packet.clear();
+      }
+      packet += line;
+    }
+    if (!packet.empty()) {
+      Send(packet);
+    }
+  }
+
+ private:
+  static constexpr size_t kMaxPacketBytes = 1400;
+
+  void Send(const std::string& packet) {
+    // Like statsd clients, drop the datagram if the daemon is not there.
+    if (send(fd_, packet.data(), packet.size(), 0) < 0) {
+      VLOG(1) << "Dropped a statsd packet of " << packet.size() << " bytes.";
+    }
+  }
+
+  int fd_ = -1;
+};
+
+REGISTER_STAT_EXPORTER(statsd, StatsdExporter);
+#endif // _WIN32
+
+bool Caffe2InitStatExport(int*, char***) {
+  if (FLAGS_caffe2_stat_export.empty()) {
+    return true;
+  }
+  EnablePerfCounters();
+  // Destroyed at exit, which exports the counters one last time. Statics are
+  // destroyed in reverse order of construction, so the ones that export uses
+  // are constructed first, to outlive the thread.
+  StatRegistry::get();
+  GaugeUpdatersMutex();
+  GaugeUpdaters();
+  static std::unique_ptr<StatExportThread> thread;
+  thread.reset(new StatExportThread(
+      CreateStatExporter(FLAGS_caffe2_stat_export),
+      std::chrono::milliseconds(FLAGS_caffe2_stat_export_interval_ms)));
+  VLOG(1) << "Exporting stats to " << FLAGS_caffe2_stat_export;
+  return true;
+}
+
+} // namespace
+
+REGISTER_CAFFE2_INIT_FUNCTION(
+    Caffe2InitStatExport,
+    &Caffe2InitStatExport,
+    "Start exporting the StatRegistry if --caffe2_stat_export is set.");
+
+} // namespace caffe2
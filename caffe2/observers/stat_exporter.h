@@ -0,0 +1,91 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_CONTRIB_OBSERVERS_STAT_EXPORTER_H_
+#define CAFFE2_CONTRIB_OBSERVERS_STAT_EXPORTER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "caffe2/core/registry.h"
+#include "caffe2/core/stats.h"
+
+namespace caffe2 {
+
+/**
+ * Sends the counters of a StatRegistry to a monitoring system.
+ *
+ * Exporters are created by name from a target of the form
+ * "<name>:<argument>", see CreateStatExporter. Two are built in:
+ *
+ *   prometheus:<file>    rewrites <file> in the Prometheus text format on
+ *                        every export, for the node_exporter textfile
+ *                        collector. Counters ending in "_bucket/<bound>" are
+ *                        written as the "le" buckets of a histogram.
+ *   statsd:<host>:<port> sends every counter as a statsd gauge over UDP.
+ */
+class StatExporter {
+ public:
+  virtual ~StatExporter() {}
+  virtual void Export(const ExportedStatList& stats) = 0;
+};
+
+CAFFE_DECLARE_REGISTRY(StatExporterRegistry, StatExporter, const std::string&);
+#define REGISTER_STAT_EXPORTER(name, ...) \
+  CAFFE_REGISTER_CLASS(StatExporterRegistry, name, __VA_ARGS__)
+
+std::unique_ptr<StatExporter> CreateStatExporter(const std::string& target);
+
+/**
+ * Gauges are counters of the StatRegistry singleton that hold a current
+ * value, such as the bytes held by an allocator, instead of a cumulative one.
+ * Updaters registered here are called to refresh them right before every
+ * export.
+ */
+void SetStatGauge(const std::string& name, int64_t value);
+void RegisterStatGaugeUpdater(std::function<void()> updater);
+void UpdateStatGauges();
+
+/**
+ * Exports the StatRegistry singleton every interval on a background thread,
+ * and once more when destroyed.
+ */
+class StatExportThread {
+ public:
+  StatExportThread(
+      std::unique_ptr<StatExporter> exporter,
+      std::chrono::milliseconds interval);
+  ~StatExportThread();
+
+  void ExportNow();
+
+ private:
+  std::unique_ptr<StatExporter> exporter_;
+  std::chrono::milliseconds interval_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+  std::thread thread_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CONTRIB_OBSERVERS_STAT_EXPORTER_H_
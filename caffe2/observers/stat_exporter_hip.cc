@@ -0,0 +1,48 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/observers/stat_exporter.h"
+
+#include "caffe2/core/context_hip.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Publishes the memory pool of every HIP device as hip/<gpu>/<counter> gauges.
+void UpdateHipMemoryPoolGauges()
+{
+    const auto stats = HIPContext::MemoryPoolStats();
+    for(int gpu = 0; gpu < stats.size(); ++gpu)
+    {
+        const std::string prefix = "hip/" + caffe2::to_string(gpu) + "/";
+        SetStatGauge(prefix + "allocated_bytes", stats[gpu].allocated_bytes);
+        SetStatGauge(prefix + "cached_bytes", stats[gpu].cached_bytes);
+        SetStatGauge(prefix + "largest_free_block", stats[gpu].largest_free_block);
+        SetStatGauge(prefix + "num_allocs", stats[gpu].num_allocs);
+        SetStatGauge(prefix + "num_cache_hits", stats[gpu].num_cache_hits);
+        SetStatGauge(prefix + "num_segments", stats[gpu].num_segments);
+    }
+}
+
+struct HipMemoryPoolGaugesRegisterer
+{
+    HipMemoryPoolGaugesRegisterer() { RegisterStatGaugeUpdater(&UpdateHipMemoryPoolGauges); }
+} g_hip_memory_pool_gauges_registerer;
+
+} // namespace
+
+} // namespace caffe2
@@ -18,22 +18,16 @@
 
 namespace caffe2 {
 
-template <>
-bool AccuracyOp<float, CPUContext>::RunOnDevice() {
-  auto& X = Input(PREDICTION);
-  auto& label = Input(LABEL);
-  auto* Y = Output(0);
-  CAFFE_ENFORCE_EQ(X.ndim(), 2);
-  int N = X.dim32(0);
-  int D = X.dim32(1);
-  CAFFE_ENFORCE_EQ(label.ndim(), 1);
-  CAFFE_ENFORCE_EQ(label.dim32(0), N);
-  Y->Resize(vector<TIndex>());
-  const auto* Xdata = X.data<float>();
-  const auto* labelData = label.data<int>();
-  const int top_k = top_k_;
-  int correct = 0;
+namespace {
 
+// Counts the samples whose label is among the top_k scoring classes.
+int CountTopK(
+    const int N,
+    const int D,
+    const int top_k,
+    const float* Xdata,
+    const int* labelData) {
+  int correct = 0;
   // it's equivalent to using a stable sorting algorithm to sort the
   // classes (with their predictions as key) and then check whether
   // the label is within the first top_k slots.
@@ -53,6 +47,25 @@ bool AccuracyOp<float, CPUContext>::RunOnDevice() {
       ++correct;
     }
   }
+  return correct;
+}
+
+} // namespace
+
+template <>
+bool AccuracyOp<float, CPUContext>::RunOnDevice() {
+  auto& X = Input(PREDICTION);
+  auto& label = Input(LABEL);
+  auto* Y = Output(0);
+  CAFFE_ENFORCE_EQ(X.ndim(), 2);
+  int N = X.dim32(0);
+  int D = X.dim32(1);
+  CAFFE_ENFORCE_EQ(label.ndim(), 1);
+  CAFFE_ENFORCE_EQ(label.dim32(0), N);
+  Y->Resize(vector<TIndex>());
+  const auto* Xdata = X.data<float>();
+  const auto* labelData = label.data<int>();
+  const int correct = CountTopK(N, D, top_k_, Xdata, labelData);
   CAFFE_ENFORCE_LE(correct, N);
   *(Y->mutable_data<float>()) = static_cast<float>(correct) / N;
 
@@ -61,6 +74,29 @@ bool AccuracyOp<float, CPUContext>::RunOnDevice() {
 
 REGISTER_CPU_OPERATOR(Accuracy, AccuracyOp<float, CPUContext>);
 
+template <>
+bool AccumulateAccuracyOp<float, CPUContext>::RunOnDevice() {
+  auto& X = Input(PREDICTION);
+  auto& label = Input(LABEL);
+  CAFFE_ENFORCE_EQ(X.ndim(), 2);
+  const int N = X.dim32(0);
+  const int D = X.dim32(1);
+  CAFFE_ENFORCE_EQ(label.ndim(), 1);
+  CAFFE_ENFORCE_EQ(label.dim32(0), N);
+  int64_t* counts = InitCounts();
+  counts[0] += CountTopK(N, D, top_k_, X.data<float>(), label.data<int>());
+  counts[1] += N;
+  auto* Y = Output(ACCURACY);
+  Y->Resize(vector<TIndex>());
+  *(Y->mutable_data<float>()) =
+      counts[1] ? static_cast<float>(counts[0]) / counts[1] : 0.0f;
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(
+    AccumulateAccuracy,
+    AccumulateAccuracyOp<float, CPUContext>);
+
 OPERATOR_SCHEMA(Accuracy)
   .NumInputs(2)
   .NumOutputs(1)
@@ -85,4 +121,30 @@ classes, it is considered a correct prediction.
           "accuracy");
 
 SHOULD_NOT_DO_GRADIENT(Accuracy);
+
+OPERATOR_SCHEMA(AccumulateAccuracy)
+    .NumInputs(2)
+    .NumOutputs(2)
+    .SetDoc(R"DOC(
+Accuracy over all the batches seen so far. The numbers of correct predictions
+and of samples are added to counts at every run, and accuracy is their ratio.
+counts is kept in the context of the op, so on a GPU the running accuracy is
+updated without synchronizing with the host. counts is created at the first
+run; feeding an empty tensor to it starts over. Together with AsyncCopyToHost,
+the accuracy can be monitored without stalling the device.
+)DOC")
+    .Arg(
+        "top_k",
+        "Count as correct by comparing the true label to the top k scoring "
+        "classes (default 1: only compare to the top scoring class i.e. argmax)")
+    .Input(0, "predictions", "2-D tensor (Tensor<float>) of size "
+           "(num_batches x num_classes) containing scores")
+    .Input(1, "labels", "1-D tensor (Tensor<int>) of size (num_batches) having "
+           "the indices of true labels")
+    .Output(0, "accuracy", "Scalar tensor (Tensor<float>) with the accuracy "
+            "over all the batches so far")
+    .Output(1, "counts", "1-D tensor (Tensor<int64_t>) of size 2 with the "
+            "numbers of correct predictions and of samples");
+
+SHOULD_NOT_DO_GRADIENT(AccumulateAccuracy);
 }  // namespace caffe2
@@ -19,6 +19,7 @@
 
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
 
 namespace caffe2 {
 
@@ -37,6 +38,37 @@ class AccuracyOp final : public Operator<Context> {
   INPUT_TAGS(PREDICTION, LABEL);
 };
 
+// Like Accuracy, but the numbers of correct predictions and of samples are
+// summed in counts over all the runs, and accuracy is the ratio so far. The
+// counts stay on the device, so nothing has to be fetched every iteration.
+template <typename T, class Context>
+class AccumulateAccuracyOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  AccumulateAccuracyOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        top_k_(OperatorBase::GetSingleArgument<int>("top_k", 1)) {}
+
+  bool RunOnDevice() override;
+
+ protected:
+  // Starts counting from zero when counts is new or was reset, i.e. is not
+  // a pair of int64.
+  int64_t* InitCounts() {
+    auto* counts = Output(COUNTS);
+    if (counts->size() != 2 || !counts->template IsType<int64_t>()) {
+      counts->Resize(2);
+      math::Set<int64_t, Context>(
+          2, 0, counts->template mutable_data<int64_t>(), &context_);
+    }
+    return counts->template mutable_data<int64_t>();
+  }
+
+  int top_k_;
+  INPUT_TAGS(PREDICTION, LABEL);
+  OUTPUT_TAGS(ACCURACY, COUNTS);
+};
+
 } // namespace caffe2
 
 #endif // CAFFE2_OPERATORS_ACCURACY_OP_H_
@@ -23,12 +23,14 @@
 namespace caffe2 {
 
 namespace {
+// Adds the number of correct predictions to *accuracy.
+template <typename Count>
 __global__ void AccuracyKernel(const int N,
                                const int D,
                                const int top_k,
                                const float* Xdata,
                                const int* labelData,
-                               float* accuracy)
+                               Count* accuracy)
 {
     using BlockReduce = hipcub::BlockReduce<int, CAFFE_HIP_NUM_THREADS>;
     __shared__ typename BlockReduce::TempStorage temp_storage;
@@ -55,11 +57,17 @@ __global__ void AccuracyKernel(const int N,
     }
     if(threadIdx.x == 0)
     {
-        atomicAdd(accuracy, static_cast<float>(correct));
+        atomicAdd(accuracy, static_cast<Count>(correct));
     }
 }
 
 __global__ void AccuracyDivideKernel(const int N, float* accuracy) { *accuracy /= N; }
+
+__global__ void AccumulateAccuracyKernel(const int N, int64_t* counts, float* accuracy)
+{
+    counts[1] += N;
+    *accuracy = counts[1] ? static_cast<float>(counts[0]) / counts[1] : 0.0f;
+}
 } // namespace
 
 template <>
@@ -76,7 +84,7 @@ bool AccuracyOp<float, HIPContext>::RunOnDevice()
     Y->Resize(vector<TIndex>());
     float* Ydata = Y->mutable_data<float>();
     math::Set<float, HIPContext>(1, 0, Ydata, &context_);
-    hipLaunchKernelGGL((AccuracyKernel),
+    hipLaunchKernelGGL((AccuracyKernel<float>),
                        dim3(std::min(CAFFE_MAXIMUM_NUM_BLOCKS, N)),
                        dim3(CAFFE_HIP_NUM_THREADS),
                        0,
@@ -95,4 +103,44 @@ bool AccuracyOp<float, HIPContext>::RunOnDevice()
 }
 
 REGISTER_HIP_OPERATOR(Accuracy, AccuracyOp<float, HIPContext>);
+
+template <>
+bool AccumulateAccuracyOp<float, HIPContext>::RunOnDevice()
+{
+    auto& X     = Input(PREDICTION);
+    auto& label = Input(LABEL);
+    CAFFE_ENFORCE_EQ(X.ndim(), 2);
+    const int N = X.dim32(0);
+    const int D = X.dim32(1);
+    CAFFE_ENFORCE_EQ(label.ndim(), 1);
+    CAFFE_ENFORCE_EQ(label.dim32(0), N);
+    int64_t* counts = InitCounts();
+    auto* Y         = Output(ACCURACY);
+    Y->Resize(vector<TIndex>());
+    if(N > 0)
+    {
+        hipLaunchKernelGGL((AccuracyKernel<unsigned long long>),
+                           dim3(std::min(CAFFE_MAXIMUM_NUM_BLOCKS, N)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           N,
+                           D,
+                           top_k_,
+                           X.data<float>(),
+                           label.data<int>(),
+                           reinterpret_cast<unsigned long long*>(counts));
+    }
+    hipLaunchKernelGGL((AccumulateAccuracyKernel),
+                       dim3(1),
+                       dim3(1),
+                       0,
+                       context_.hip_stream(),
+                       N,
+                       counts,
+                       Y->mutable_data<float>());
+    return true;
+}
+
+REGISTER_HIP_OPERATOR(AccumulateAccuracy, AccumulateAccuracyOp<float, HIPContext>);
 } // namespace caffe2
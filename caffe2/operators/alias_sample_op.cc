@@ -0,0 +1,226 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/alias_sample_op.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace caffe2 {
+
+namespace {
+
+// The CPU draws come from SplitMix64: number i of the generator is a hash of
+// seed + i * kGolden. Each number only depends on its position, so a block
+// of them is computed by a loop without dependencies between iterations,
+// which the compiler vectorizes, before the table lookups.
+constexpr uint64_t kGolden = 0x9E3779B97F4A7C15ULL;
+constexpr int kDrawBlock = 1024;
+
+inline uint64_t SplitMix64(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+} // namespace
+
+void BuildAliasTables(
+    const int rows,
+    const int k,
+    const float* weights,
+    float* prob,
+    int* alias) {
+  std::vector<double> scaled(k);
+  std::vector<int> small;
+  std::vector<int> large;
+  small.reserve(k);
+  large.reserve(k);
+  for (int r = 0; r < rows; ++r) {
+    const float* w = weights + r * k;
+    float* p = prob + r * k;
+    int* a = alias + r * k;
+    double sum = 0;
+    for (int j = 0; j < k; ++j) {
+      CAFFE_ENFORCE_GE(w[j], 0, "The weights must be non-negative");
+      sum += w[j];
+    }
+    CAFFE_ENFORCE_GT(sum, 0, "The weights of row ", r, " sum to 0");
+
+    // Columns with less than the average mass take the rest of theirs from
+    // one with more, until all of them hold exactly the average.
+    small.clear();
+    large.clear();
+    for (int j = 0; j < k; ++j) {
+      scaled[j] = w[j] * k / sum;
+      (scaled[j] < 1 ? small : large).push_back(j);
+    }
+    while (!small.empty() && !large.empty()) {
+      const int s = small.back();
+      const int l = large.back();
+      small.pop_back();
+      p[s] = scaled[s];
+      a[s] = l;
+      scaled[l] -= 1 - scaled[s];
+      if (scaled[l] < 1) {
+        large.pop_back();
+        small.push_back(l);
+      }
+    }
+    // What is left is 1 up to rounding errors.
+    for (int j : large) {
+      p[j] = 1;
+      a[j] = j;
+    }
+    for (int j : small) {
+      p[j] = 1;
+      a[j] = j;
+    }
+  }
+}
+
+template <>
+bool AliasTableCreateOp<CPUContext>::RunOnDevice() {
+  const auto& weights = Input(0);
+  CAFFE_ENFORCE(
+      weights.ndim() == 1 || weights.ndim() == 2,
+      "The weights are a vector or a matrix of rows");
+  auto* prob = Output(0);
+  auto* alias = Output(1);
+  prob->ResizeLike(weights);
+  alias->ResizeLike(weights);
+  const int k = weights.dim32(weights.ndim() - 1);
+  const int rows = k ? weights.size() / k : 0;
+  BuildAliasTables(
+      rows,
+      k,
+      weights.data<float>(),
+      prob->mutable_data<float>(),
+      alias->mutable_data<int>());
+  return true;
+}
+
+template <>
+bool AliasSampleOp<CPUContext>::RunOnDevice() {
+  const auto& prob = Input(0);
+  const auto& alias = Input(1);
+  CAFFE_ENFORCE(prob.ndim() == 1 || prob.ndim() == 2);
+  CAFFE_ENFORCE_EQ(prob.dims(), alias.dims());
+  const int k = prob.dim32(prob.ndim() - 1);
+  const int rows = prob.ndim() == 2 ? prob.dim32(0) : 1;
+  auto* output = Output(0);
+  if (prob.ndim() == 2) {
+    output->Resize(rows, num_samples_);
+  } else {
+    output->Resize(num_samples_);
+  }
+  int* output_data = output->mutable_data<int>();
+  const int n = rows * num_samples_;
+  if (n == 0) {
+    return true;
+  }
+  CAFFE_ENFORCE_GT(k, 0, "Cannot sample from an empty table");
+
+  const float* prob_data = prob.data<float>();
+  const int* alias_data = alias.data<int>();
+  uint64_t bits[kDrawBlock];
+  for (int begin = 0; begin < n; begin += kDrawBlock) {
+    const int size = std::min(kDrawBlock, n - begin);
+    const uint64_t key = random_seed_ + (random_offset_ + begin) * kGolden;
+    for (int i = 0; i < size; ++i) {
+      bits[i] = SplitMix64(key + i * kGolden);
+    }
+    for (int i = 0; i < size; ++i) {
+      const int row = (begin + i) / num_samples_;
+      output_data[begin + i] = AliasDraw(
+          prob_data + row * k,
+          alias_data + row * k,
+          k,
+          static_cast<uint32_t>(bits[i] >> 32),
+          static_cast<uint32_t>(bits[i]));
+    }
+  }
+  random_offset_ += n;
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(AliasTableCreate, AliasTableCreateOp<CPUContext>);
+REGISTER_CPU_OPERATOR(AliasSample, AliasSampleOp<CPUContext>);
+
+OPERATOR_SCHEMA(AliasTableCreate)
+    .NumInputs(1)
+    .NumOutputs(2)
+    .TensorInferenceFunction([](const OperatorDef& /* unused */,
+                                const vector<TensorShape>& in) {
+      vector<TensorShape> out(2, in[0]);
+      out[0].set_data_type(TensorProto::FLOAT);
+      out[1].set_data_type(TensorProto::INT32);
+      return out;
+    })
+    .SetDoc(R"DOC(
+Builds the Walker alias tables of sampling weights, so that AliasSample then
+draws from them in constant time per sample instead of the linear scan of
+WeightedSample. The weights are a vector of k non-negative numbers, or a
+matrix of such rows, each one with its own table, and the tables have their
+shape. Building them costs O(k) per row, do it once for weights that don't
+change, e.g. in the init net. On GPUs the tables are built on the host.
+)DOC")
+    .Input(
+        0,
+        "sampling_weights",
+        "A 1-D or 2-D Tensor<float> of non-negative weights, the last "
+        "dimension indexes the items and every row has a positive sum.")
+    .Output(0, "prob", "Tensor<float> of the probability to keep a column")
+    .Output(1, "alias", "Tensor<int> of the column taken otherwise");
+
+OPERATOR_SCHEMA(AliasSample)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .TensorInferenceFunction([](const OperatorDef& def,
+                                const vector<TensorShape>& in) {
+      ArgumentHelper helper(def);
+      const int num_samples = helper.GetSingleArgument<int>("num_samples", 1);
+      vector<TensorShape> out(1);
+      if (in[0].dims_size() == 2) {
+        out[0] = CreateTensorShape(
+            vector<TIndex>{in[0].dims(0), num_samples}, TensorProto::INT32);
+      } else {
+        out[0] =
+            CreateTensorShape(vector<int>{num_samples}, TensorProto::INT32);
+      }
+      return out;
+    })
+    .SetDoc(R"DOC(
+Draws num_samples indexes, with replacement, from the distribution of the
+alias tables made by AliasTableCreate, at a constant cost per sample, e.g. the
+negative items of a batch from the popularity of a catalog. A 1-D table gives
+a vector of num_samples indexes, a 2-D one a (rows x num_samples) matrix with
+the samples of each row. The values of the sampled items can be read with
+Gather.
+
+The random numbers come from a counter-based generator keyed by the random
+seed of the device option and by the number of samples the op drew before
+(SplitMix64 on CPU, Philox on HIP), so the CPU and HIP samples differ.
+)DOC")
+    .Arg("num_samples", "Number of samples per table, 1 by default")
+    .Input(0, "prob", "The prob output of AliasTableCreate")
+    .Input(1, "alias", "The alias output of AliasTableCreate")
+    .Output(0, "sampled_indexes", "Tensor<int> of the sampled indexes");
+
+SHOULD_NOT_DO_GRADIENT(AliasTableCreate);
+SHOULD_NOT_DO_GRADIENT(AliasSample);
+
+} // namespace caffe2
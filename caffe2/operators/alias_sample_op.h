@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_OPERATORS_ALIAS_SAMPLE_OP_H_
+#define CAFFE2_OPERATORS_ALIAS_SAMPLE_OP_H_
+
+#include <cstdint>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor.h"
+
+// The draws are also made by the HIP kernels.
+#if defined(__CUDACC__) || defined(__HIPCC__)
+#define ALIAS_SAMPLE_DECL inline __host__ __device__
+#else
+#define ALIAS_SAMPLE_DECL inline
+#endif
+
+namespace caffe2 {
+
+// Builds the Walker alias tables of the rows of weights, a rows x k matrix,
+// with Vose's method: drawing column j uniformly and keeping it with
+// probability prob[j], or taking alias[j] otherwise, samples the row in
+// proportion to its weights.
+void BuildAliasTables(
+    const int rows,
+    const int k,
+    const float* weights,
+    float* prob,
+    int* alias);
+
+// A draw from the alias table of k columns, made of two uniform 32-bit
+// numbers: the high one picks the column and the low one the coin flip.
+ALIAS_SAMPLE_DECL int AliasDraw(
+    const float* prob,
+    const int* alias,
+    const int k,
+    const uint32_t column_bits,
+    const uint32_t coin_bits) {
+  const int j = static_cast<int>((static_cast<uint64_t>(column_bits) * k) >> 32);
+  const float coin = (coin_bits >> 8) * (1.0f / 16777216.0f);
+  return coin < prob[j] ? j : alias[j];
+}
+
+template <class Context>
+class AliasTableCreateOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  USE_SIMPLE_CTOR_DTOR(AliasTableCreateOp);
+
+  bool RunOnDevice() override;
+
+ private:
+  // Host copies of the weights and the tables on GPUs.
+  TensorCPU weights_host_;
+  TensorCPU prob_host_;
+  TensorCPU alias_host_;
+};
+
+template <class Context>
+class AliasSampleOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  AliasSampleOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        num_samples_(
+            OperatorBase::GetSingleArgument<int>("num_samples", 1)),
+        random_seed_(
+            operator_def.device_option().has_random_seed()
+                ? operator_def.device_option().random_seed()
+                : RandomNumberSeed()),
+        random_offset_(0) {
+    CAFFE_ENFORCE_GE(num_samples_, 0);
+  }
+
+  bool RunOnDevice() override;
+
+ private:
+  int num_samples_;
+  // Seed and counter of the counter-based generator of the draws, the
+  // counter moves past the numbers of every run so the next one draws fresh
+  // ones.
+  const unsigned long long random_seed_;
+  unsigned long long random_offset_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_ALIAS_SAMPLE_OP_H_
@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <hiprand_kernel.h>
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/alias_sample_op.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Samples are drawn in pairs: pair g takes the four numbers of Philox
+// subsequence g at the offset of the run, two per sample, so a run draws
+// four numbers per subsequence whatever its size.
+constexpr int kSamplesPerGroup = 2;
+
+__global__ void AliasSampleKernel(const int n,
+                                  const int num_samples,
+                                  const int k,
+                                  const float* prob,
+                                  const int* alias,
+                                  const unsigned long long seed,
+                                  const unsigned long long offset,
+                                  int* out)
+{
+    HIP_1D_KERNEL_LOOP(g, (n + kSamplesPerGroup - 1) / kSamplesPerGroup)
+    {
+        hiprandStatePhilox4_32_10_t state;
+        hiprand_init(seed, g, offset, &state);
+        const uint4 r = hiprand4(&state);
+        const int i   = g * kSamplesPerGroup;
+        int row       = i / num_samples;
+        out[i]        = AliasDraw(prob + row * k, alias + row * k, k, r.x, r.y);
+        if(i + 1 < n)
+        {
+            row        = (i + 1) / num_samples;
+            out[i + 1] = AliasDraw(prob + row * k, alias + row * k, k, r.z, r.w);
+        }
+    }
+}
+
+} // namespace
+
+template <>
+bool AliasTableCreateOp<HIPContext>::RunOnDevice()
+{
+    const auto& weights = Input(0);
+    CAFFE_ENFORCE(weights.ndim() == 1 || weights.ndim() == 2,
+                  "The weights are a vector or a matrix of rows");
+    // The tables are built once, their sequential construction stays on the
+    // host.
+    weights_host_.CopyFrom(weights, &context_);
+    context_.FinishDeviceComputation();
+    prob_host_.ResizeLike(weights_host_);
+    alias_host_.ResizeLike(weights_host_);
+    const int k    = weights.dim32(weights.ndim() - 1);
+    const int rows = k ? weights.size() / k : 0;
+    BuildAliasTables(rows,
+                     k,
+                     weights_host_.data<float>(),
+                     prob_host_.mutable_data<float>(),
+                     alias_host_.mutable_data<int>());
+    Output(0)->CopyFrom(prob_host_, &context_);
+    Output(1)->CopyFrom(alias_host_, &context_);
+    return true;
+}
+
+template <>
+bool AliasSampleOp<HIPContext>::RunOnDevice()
+{
+    const auto& prob  = Input(0);
+    const auto& alias = Input(1);
+    CAFFE_ENFORCE(prob.ndim() == 1 || prob.ndim() == 2);
+    CAFFE_ENFORCE_EQ(prob.dims(), alias.dims());
+    const int k    = prob.dim32(prob.ndim() - 1);
+    const int rows = prob.ndim() == 2 ? prob.dim32(0) : 1;
+    auto* output   = Output(0);
+    if(prob.ndim() == 2)
+    {
+        output->Resize(rows, num_samples_);
+    }
+    else
+    {
+        output->Resize(num_samples_);
+    }
+    int* output_data = output->mutable_data<int>();
+    const int n      = rows * num_samples_;
+    if(n == 0)
+    {
+        return true;
+    }
+    CAFFE_ENFORCE_GT(k, 0, "Cannot sample from an empty table");
+
+    const int groups = (n + kSamplesPerGroup - 1) / kSamplesPerGroup;
+    hipLaunchKernelGGL((AliasSampleKernel),
+                       dim3(CAFFE_GET_BLOCKS(groups)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       n,
+                       num_samples_,
+                       k,
+                       prob.data<float>(),
+                       alias.data<int>(),
+                       random_seed_,
+                       random_offset_,
+                       output_data);
+    random_offset_ += 2 * kSamplesPerGroup;
+    return true;
+}
+
+REGISTER_HIP_OPERATOR(AliasTableCreate, AliasTableCreateOp<HIPContext>);
+REGISTER_HIP_OPERATOR(AliasSample, AliasSampleOp<HIPContext>);
+
+} // namespace caffe2
@@ -0,0 +1,257 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <hipcub/hipcub.hpp>
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/apmeter_op.h"
+#include "caffe2/operators/top_k_hip.h"
+#include "caffe2/utils/math.h"
+#include "hip/hip_runtime.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Writes the N samples into the ring buffers of the D classes, the first one
+// at position head.
+__global__ void APMeterBufferKernel(const int N,
+                                    const int D,
+                                    const int buffer_size,
+                                    const int head,
+                                    const float* Xdata,
+                                    const int* labelData,
+                                    float* scores,
+                                    int* labels)
+{
+    HIP_1D_KERNEL_LOOP(i, N * D)
+    {
+        const int pos                    = (head + i / D) % buffer_size;
+        scores[(i % D) * buffer_size + pos] = Xdata[i];
+        labels[(i % D) * buffer_size + pos] = labelData[i];
+    }
+}
+
+// Copies the used part of the ring buffers in the order the samples came in,
+// which is the order the CPU op keeps them in, so that ties sort the same.
+__global__ void APMeterLinearizeKernel(const int D,
+                                       const int buffer_size,
+                                       const int used,
+                                       const int start,
+                                       const float* scores,
+                                       const int* labels,
+                                       float* linear_scores,
+                                       int* linear_labels)
+{
+    HIP_1D_KERNEL_LOOP(i, D * used)
+    {
+        const int src    = (i / used) * buffer_size + (start + i % used) % buffer_size;
+        linear_scores[i] = scores[src];
+        linear_labels[i] = labels[src];
+    }
+}
+
+// One block per class: with the samples sorted by decreasing score,
+// AP = sum(tp(k) / (k + 1) for the positives) / max(1, positives).
+__global__ void AveragePrecisionKernel(
+    const int D, const int used, const int* sorted_indices, const int* labels, float* ap)
+{
+    using BlockScan   = hipcub::BlockScan<int, CAFFE_HIP_NUM_THREADS>;
+    using BlockReduce = hipcub::BlockReduce<float, CAFFE_HIP_NUM_THREADS>;
+    __shared__ typename BlockScan::TempStorage scan_storage;
+    __shared__ typename BlockReduce::TempStorage reduce_storage;
+    __shared__ int tp_carry;
+    for(int d = hipBlockIdx_x; d < D; d += hipGridDim_x)
+    {
+        if(hipThreadIdx_x == 0)
+        {
+            tp_carry = 0;
+        }
+        __syncthreads();
+        float precision_sum = 0;
+        float positives     = 0;
+        for(int base = 0; base < used; base += hipBlockDim_x)
+        {
+            const int k     = base + hipThreadIdx_x;
+            const int label = k < used ? labels[sorted_indices[d * used + k]] : 0;
+            int tp          = 0;
+            int chunk_tp    = 0;
+            BlockScan(scan_storage).InclusiveSum(label, tp, chunk_tp);
+            if(label == 1)
+            {
+                precision_sum += static_cast<float>(tp_carry + tp) / (k + 1);
+                positives += 1;
+            }
+            __syncthreads();
+            if(hipThreadIdx_x == 0)
+            {
+                tp_carry += chunk_tp;
+            }
+            __syncthreads();
+        }
+        precision_sum = BlockReduce(reduce_storage).Sum(precision_sum);
+        __syncthreads();
+        positives = BlockReduce(reduce_storage).Sum(positives);
+        if(hipThreadIdx_x == 0)
+        {
+            ap[d] = precision_sum / fmaxf(1.0f, positives);
+        }
+        __syncthreads();
+    }
+}
+
+} // namespace
+
+// APMeter keeping its buffer of predictions on the device: every run appends
+// the batch to per class ring buffers and computes the AP of all of them
+// there, so that the running AP never round trips through the host.
+class HIPAPMeterOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPAPMeterOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws),
+          buffer_size_(OperatorBase::GetSingleArgument<int32_t>("buffer_size", 1000))
+    {
+        CAFFE_ENFORCE_GT(buffer_size_, 0);
+    }
+
+    bool RunOnDevice() override
+    {
+        auto& X     = Input(PREDICTION);
+        auto& label = Input(LABEL);
+        CAFFE_ENFORCE_EQ(X.ndim(), 2);
+        int N = X.dim32(0);
+        const int D = X.dim32(1);
+        CAFFE_ENFORCE_EQ(label.ndim(), 2);
+        CAFFE_ENFORCE_EQ(label.dim32(0), N);
+        CAFFE_ENFORCE_EQ(label.dim32(1), D);
+        if(scores_.size() == 0)
+        {
+            scores_.Resize(D, buffer_size_);
+            labels_.Resize(D, buffer_size_);
+        }
+        CAFFE_ENFORCE_EQ(scores_.dim32(0), D, "The number of classes changed.");
+
+        const float* Xdata   = X.data<float>();
+        const int* labelData = label.data<int>();
+        // Only the last buffer_size samples can stay in the buffer.
+        if(N > buffer_size_)
+        {
+            Xdata += (N - buffer_size_) * D;
+            labelData += (N - buffer_size_) * D;
+            N = buffer_size_;
+        }
+        if(N > 0 && D > 0)
+        {
+            hipLaunchKernelGGL((APMeterBufferKernel),
+                               dim3(CAFFE_GET_BLOCKS(N * D)),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context_.hip_stream(),
+                               N,
+                               D,
+                               buffer_size_,
+                               head_,
+                               Xdata,
+                               labelData,
+                               scores_.mutable_data<float>(),
+                               labels_.mutable_data<int>());
+        }
+        head_        = (head_ + N) % buffer_size_;
+        buffer_used_ = std::min(buffer_used_ + N, buffer_size_);
+
+        auto* Y = Output(0);
+        Y->Resize(D);
+        if(D == 0)
+        {
+            return true;
+        }
+        float* ap = Y->mutable_data<float>();
+        if(buffer_used_ == 0)
+        {
+            math::Set<float, HIPContext>(D, 0.0f, ap, &context_);
+            return true;
+        }
+
+        const int items = D * buffer_used_;
+        linear_scores_.Resize(items);
+        linear_labels_.Resize(items);
+        sorted_scores_.Resize(items);
+        sorted_indices_.Resize(items);
+        offsets_.Resize(D + 1);
+        hipLaunchKernelGGL((APMeterLinearizeKernel),
+                           dim3(CAFFE_GET_BLOCKS(items)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           D,
+                           buffer_size_,
+                           buffer_used_,
+                           (head_ - buffer_used_ + buffer_size_) % buffer_size_,
+                           scores_.data<float>(),
+                           labels_.data<int>(),
+                           linear_scores_.mutable_data<float>(),
+                           linear_labels_.mutable_data<int>());
+        hipLaunchKernelGGL((TopKUniformOffsetsKernel<int>),
+                           dim3(CAFFE_GET_BLOCKS(D + 1)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           D + 1,
+                           buffer_used_,
+                           offsets_.mutable_data<int>());
+        SegmentedSortDescending(items,
+                                D,
+                                linear_scores_.data<float>(),
+                                offsets_.data<int>(),
+                                sorted_scores_.mutable_data<float>(),
+                                sorted_indices_.mutable_data<int>(),
+                                &scratch_,
+                                &context_);
+        hipLaunchKernelGGL((AveragePrecisionKernel),
+                           dim3(std::min(D, CAFFE_MAXIMUM_NUM_BLOCKS)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           D,
+                           buffer_used_,
+                           sorted_indices_.data<int>(),
+                           linear_labels_.data<int>(),
+                           ap);
+        return true;
+    }
+
+    protected:
+    int buffer_size_;
+    // Samples in the buffer, and ring position of the next one.
+    int buffer_used_ = 0;
+    int head_        = 0;
+    // D x buffer_size_ ring buffers.
+    Tensor<HIPContext> scores_;
+    Tensor<HIPContext> labels_;
+    Tensor<HIPContext> linear_scores_;
+    Tensor<HIPContext> linear_labels_;
+    Tensor<HIPContext> sorted_scores_;
+    Tensor<HIPContext> sorted_indices_;
+    Tensor<HIPContext> offsets_;
+    Tensor<HIPContext> scratch_;
+
+    INPUT_TAGS(PREDICTION, LABEL);
+};
+
+REGISTER_HIP_OPERATOR(APMeter, HIPAPMeterOp);
+
+} // namespace caffe2
@@ -0,0 +1,208 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <mutex>
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Append for HIP tensors. The dataset grows its capacity by growthPct (doubling
+// by default) through Tensor::Extend, so appending is amortized O(1): the
+// occasional reallocation goes through the HIP allocator and its copy, like
+// the copy of the new rows, is queued on the stream of the op without waiting
+// for it.
+class HipAppendOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HipAppendOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws),
+          growthPct_(OperatorBase::GetSingleArgument<int>("growthPct", 100))
+    {
+        CAFFE_ENFORCE_GT(growthPct_, 0);
+    }
+
+    bool RunOnDevice() override
+    {
+        auto& a = Input(0);
+        auto& b = Input(1);
+        auto* c = Output(0);
+        CAFFE_ENFORCE(b.ndim() >= 1);
+        if(a.size() == 0 && a.dim(0) == 0)
+        {
+            c->CopyFrom(b, &context_);
+            return true;
+        }
+        CAFFE_ENFORCE(&a == c, "First argument must be in-place.");
+        CAFFE_ENFORCE(c->ndim() == b.ndim());
+        CAFFE_ENFORCE(a.meta() == b.meta());
+        for(int i = 1; i < a.ndim(); ++i)
+        {
+            CAFFE_ENFORCE(a.dims()[i] == b.dims()[i]);
+        }
+        auto oldSize = c->size();
+        c->Extend(b.dims()[0], growthPct_, &context_);
+        auto* dst = (char*)c->raw_mutable_data() + oldSize * b.meta().itemsize();
+        context_.CopyItems<HIPContext, HIPContext>(b.meta(), b.size(), b.raw_data(), dst);
+        return true;
+    }
+
+    private:
+    int growthPct_;
+};
+
+// LastNWindowCollector for HIP tensors. The window lives on the device and
+// is allocated to num_to_collect rows on the first run, the rows are copied
+// into it with async device copies. The cursor (NEXT) and NUM_VISITED are
+// small bookkeeping tensors that stay on the host, so that no device to host
+// copy or synchronization is needed to find where to write.
+class HipLastNWindowCollectorOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HipLastNWindowCollectorOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws),
+          numToCollect_(OperatorBase::GetSingleArgument<int>("num_to_collect", -1))
+    {
+        CAFFE_ENFORCE_GT(numToCollect_, 0);
+    }
+
+    bool RunOnDevice() override
+    {
+        if(InputSize() > MUTEX)
+        {
+            CAFFE_ENFORCE(OperatorBase::InputIsType<std::unique_ptr<std::mutex>>(MUTEX),
+                          "The HIP LastNWindowCollector only supports a mutex as "
+                          "its MUTEX input");
+            auto& mutex = OperatorBase::Input<std::unique_ptr<std::mutex>>(MUTEX);
+            std::lock_guard<std::mutex> guard(*mutex);
+            return collect();
+        }
+        return collect();
+    }
+
+    private:
+    bool collect()
+    {
+        auto* output     = Output(LAST_N);
+        const auto& input = Input(DATA);
+        auto* next       = OperatorBase::Output<TensorCPU>(NEXT);
+
+        CAFFE_ENFORCE_GE(input.ndim(), 1);
+        bool output_initialized = output->size() > 0 && next->size() > 0;
+        if(output_initialized)
+        {
+            CAFFE_ENFORCE(output->meta() == input.meta());
+            CAFFE_ENFORCE_EQ(output->ndim(), input.ndim());
+            for(size_t i = 1; i < input.ndim(); ++i)
+            {
+                CAFFE_ENFORCE_EQ(output->dim(i), input.dim(i));
+            }
+        }
+
+        auto dims        = input.dims();
+        auto num_entries = dims[0];
+
+        if(OutputSize() > NUM_VISITED)
+        {
+            auto* num_visited_tensor = OperatorBase::Output<TensorCPU>(NUM_VISITED);
+            CAFFE_ENFORCE_EQ(1, num_visited_tensor->size(), "NUM_VISITED must be a CPU scalar");
+            auto* num_visited = num_visited_tensor->template mutable_data<int64_t>();
+            if(!output_initialized)
+            {
+                *num_visited = 0;
+            }
+            CAFFE_ENFORCE_GE(*num_visited, 0);
+            *num_visited += num_entries;
+        }
+
+        dims[0] = numToCollect_;
+        output->Reserve(dims, &context_);
+
+        if(num_entries == 0)
+        {
+            if(!output_initialized)
+            {
+                // Get both shape and meta
+                output->CopyFrom(input, &context_);
+            }
+            return true;
+        }
+
+        auto num_to_copy       = std::min<int32_t>(num_entries, numToCollect_);
+        auto output_batch_size = output_initialized ? output->dim(0) : 0;
+        dims[0] = std::min<size_t>(numToCollect_, output_batch_size + num_to_copy);
+        if(output_batch_size < numToCollect_)
+        {
+            output->Resize(dims);
+        }
+        auto* output_data = static_cast<char*>(output->raw_mutable_data(input.meta()));
+
+        next->Resize();
+        auto* next_data = next->template mutable_data<int32_t>();
+        if(!output_initialized)
+        {
+            *next_data = 0;
+        }
+        CAFFE_ENFORCE_LT(*next_data, output->dim(0));
+
+        auto block_size        = input.size_from_dim(1);
+        auto block_bytesize    = block_size * input.itemsize();
+        const auto* input_data = static_cast<const char*>(input.raw_data());
+
+        if(num_entries > numToCollect_)
+        {
+            // just copy the last N rows
+            context_.CopyItems<HIPContext, HIPContext>(
+                input.meta(),
+                num_to_copy * block_size,
+                input_data + (num_entries - numToCollect_) * block_bytesize,
+                output_data);
+            *next_data = 0;
+            return true;
+        }
+        auto start            = *next_data;
+        auto first_chunk_size = std::min<size_t>(num_to_copy + start, numToCollect_) - start;
+        context_.CopyItems<HIPContext, HIPContext>(input.meta(),
+                                                   first_chunk_size * block_size,
+                                                   input_data,
+                                                   output_data + start * block_bytesize);
+        context_.CopyItems<HIPContext, HIPContext>(
+            input.meta(),
+            (num_to_copy - first_chunk_size) * block_size,
+            input_data + first_chunk_size * block_bytesize,
+            output_data);
+
+        *next_data = (start + num_to_copy) % numToCollect_;
+        return true;
+    }
+
+    const int32_t numToCollect_;
+
+    INPUT_TAGS(LAST_N_IN, NEXT_IN, DATA, MUTEX, NUM_VISITED_IN);
+    OUTPUT_TAGS(LAST_N, NEXT, NUM_VISITED);
+};
+
+} // namespace
+
+REGISTER_HIP_OPERATOR(Append, HipAppendOp);
+REGISTER_HIP_OPERATOR(LastNWindowCollector, HipLastNWindowCollectorOp);
+
+} // namespace caffe2
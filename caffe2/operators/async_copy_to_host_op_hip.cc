@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/operator.h"
+#include "hip/hip_runtime.h"
+
+namespace caffe2 {
+
+// Copies the input to the host without ever waiting for the device: every run
+// picks up the copy started by an earlier run if it has landed, and starts the
+// next one on the stream of the op. The output thus lags the input by one or
+// more runs, and stays empty until the first copy lands.
+class AsyncCopyToHostOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    AsyncCopyToHostOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws)
+    {
+        DeviceGuard guard(context_.hip_gpu_id());
+        HIP_ENFORCE(hipEventCreateWithFlags(&event_, hipEventDisableTiming));
+    }
+
+    ~AsyncCopyToHostOp()
+    {
+        DeviceGuard guard(context_.hip_gpu_id());
+        if(pending_)
+        {
+            // The staging buffer is freed with the op.
+            hipEventSynchronize(event_);
+        }
+        hipEventDestroy(event_);
+    }
+
+    bool RunOnDevice() override
+    {
+        auto& input  = Input(0);
+        auto* output = OperatorBase::Output<TensorCPU>(0);
+        if(pending_)
+        {
+            const hipError_t status = hipEventQuery(event_);
+            if(status == hipErrorNotReady)
+            {
+                return true;
+            }
+            HIP_ENFORCE(status);
+            output->CopyFrom(staging_);
+            pending_ = false;
+        }
+        // The staging tensor is pinned when a GPU is present, so that the copy
+        // is really asynchronous.
+        staging_.ResizeLike(input);
+        void* staging_data = staging_.raw_mutable_data(input.meta());
+        if(input.size() > 0)
+        {
+            HIP_ENFORCE(hipMemcpyAsync(staging_data,
+                                       input.raw_data(),
+                                       input.nbytes(),
+                                       hipMemcpyDeviceToHost,
+                                       context_.hip_stream()));
+        }
+        HIP_ENFORCE(hipEventRecord(event_, context_.hip_stream()));
+        pending_ = true;
+        return true;
+    }
+
+    private:
+    TensorCPU staging_;
+    hipEvent_t event_;
+    bool pending_ = false;
+};
+
+REGISTER_HIP_OPERATOR(AsyncCopyToHost, AsyncCopyToHostOp);
+
+} // namespace caffe2
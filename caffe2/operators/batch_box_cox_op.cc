@@ -18,6 +18,7 @@
 
 #include "caffe2/core/operator.h"
 #include "caffe2/core/tensor.h"
+#include "caffe2/perfkernels/box_cox.h"
 
 #ifdef CAFFE2_USE_MKL
 #include <mkl.h>
@@ -232,9 +233,10 @@ bool BatchBoxCoxOp<CPUContext>::DoRunWithType() {
   return true;
 }
 
-template <>
+namespace {
+
 template <typename T>
-void BatchBoxCoxOp<CPUContext>::BoxCoxNaive(
+void BoxCoxRows(
     TIndex N,
     TIndex D,
     const T* data_ptr,
@@ -256,6 +258,48 @@ void BatchBoxCoxOp<CPUContext>::BoxCoxNaive(
   }
 }
 
+template <>
+void BoxCoxRows<float>(
+    TIndex N,
+    TIndex D,
+    const float* data_ptr,
+    const float* lambda1_ptr,
+    const float* lambda2_ptr,
+    float k_eps,
+    float* output_ptr) {
+  BoxCox(N, D, data_ptr, lambda1_ptr, lambda2_ptr, k_eps, output_ptr);
+}
+
+// Number of elements below which the transform is not split across threads.
+constexpr TIndex kBoxCoxGrainSize = 16384;
+
+} // namespace
+
+template <>
+template <typename T>
+void BatchBoxCoxOp<CPUContext>::BoxCoxNaive(
+    TIndex N,
+    TIndex D,
+    const T* data_ptr,
+    const T* lambda1_ptr,
+    const T* lambda2_ptr,
+    T k_eps,
+    T* output_ptr) {
+  CPUContext::ParallelFor(
+      N,
+      std::max<TIndex>(1, kBoxCoxGrainSize / D),
+      [&](size_t begin, size_t end) {
+        BoxCoxRows<T>(
+            end - begin,
+            D,
+            data_ptr + begin * D,
+            lambda1_ptr,
+            lambda2_ptr,
+            k_eps,
+            output_ptr + begin * D);
+      });
+}
+
 #ifdef CAFFE2_USE_MKL
 
 template <>
@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/batch_box_cox_op.h"
+#include "caffe2/core/context_hip.h"
+#include "hip/hip_runtime.h"
+
+namespace caffe2 {
+
+namespace {
+
+template <typename T>
+__global__ void BatchBoxCoxKernel(const int N,
+                                  const int D,
+                                  const T* data,
+                                  const T* lambda1,
+                                  const T* lambda2,
+                                  const T k_eps,
+                                  T* output)
+{
+    HIP_1D_KERNEL_LOOP(i, N * D)
+    {
+        const int j       = i % D;
+        const T lambda1_v = lambda1[j];
+        const T tmp       = data[i] + lambda2[j];
+        const T x         = tmp > k_eps ? tmp : k_eps;
+        output[i]         = lambda1_v == 0 ? log(x) : (pow(x, lambda1_v) - 1) / lambda1_v;
+    }
+}
+
+} // namespace
+
+template <>
+template <typename T>
+bool BatchBoxCoxOp<HIPContext>::DoRunWithType()
+{
+    auto& data    = Input(DATA);
+    auto& lambda1 = Input(LAMBDA1);
+    auto& lambda2 = Input(LAMBDA2);
+    CAFFE_ENFORCE_GE(data.ndim(), 1);
+    const auto N = data.dim(0);
+    const auto D = data.size_from_dim(1);
+
+    auto* output = Output(0);
+    output->ResizeLike(Input(DATA));
+    auto* output_ptr = output->template mutable_data<T>();
+
+    if(data.size() <= 0)
+    {
+        return true;
+    }
+
+    CAFFE_ENFORCE_EQ(lambda1.size(), D);
+    CAFFE_ENFORCE_EQ(lambda2.size(), D);
+
+    hipLaunchKernelGGL((BatchBoxCoxKernel<T>),
+                       dim3(CAFFE_GET_BLOCKS(N * D)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       static_cast<int>(N),
+                       static_cast<int>(D),
+                       data.template data<T>(),
+                       lambda1.template data<T>(),
+                       lambda2.template data<T>(),
+                       static_cast<T>(1e-6),
+                       output_ptr);
+    return true;
+}
+
+REGISTER_HIP_OPERATOR(BatchBoxCox, BatchBoxCoxOp<HIPContext>);
+
+} // namespace caffe2
@@ -3,30 +3,31 @@
 #include "caffe2/core/common_hip.h"
 #include "caffe2/core/context_hip.h"
 #include "caffe2/operators/batch_gather_ops.h"
+#include "caffe2/operators/row_copy_hip.h"
 
 namespace caffe2 {
 
-template <typename T_INDEX, typename TData>
-__global__ void BatchGatherKernel(const TData* src_base,
-                                  TData* out,
+// Row r of the output is row indices[r % N] of batch r / N of the data.
+template <typename T_INDEX, typename W>
+__global__ void BatchGatherKernel(const W* src_base,
+                                  W* out,
                                   const T_INDEX* indices,
-                                  const int M,
-                                  const int N,
-                                  const int data_batch_size,
-                                  const int gathered_batch_size,
-                                  const int block_size)
+                                  const TIndex M,
+                                  const TIndex N,
+                                  const TIndex data_rows,
+                                  const TIndex row_words)
 {
-    const int begin_idx = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
-    const int num_items = M * N * block_size;
-    for(int s = begin_idx; s < num_items; s += hipBlockDim_x * hipGridDim_x)
+    HIP_ROW_LOOP(r, M * N)
     {
-        const int k             = s % block_size;
-        const int j             = s / block_size % N;
-        const int i             = s / block_size / N;
-        const T_INDEX idx       = indices[j];
-        const float* src_offset = src_base + i * data_batch_size + idx * block_size;
-        float* dst_offset       = out + i * gathered_batch_size + j * block_size;
-        dst_offset[k]           = src_offset[k];
+        const TIndex i    = r / N;
+        const T_INDEX idx = indices[r % N];
+        HIP_KERNEL_ASSERT(0 <= idx && idx < data_rows);
+        const W* src_offset = src_base + (i * data_rows + idx) * row_words;
+        W* dst_offset       = out + r * row_words;
+        HIP_ROW_WORD_LOOP(j, row_words)
+        {
+            dst_offset[j] = src_offset[j];
+        }
     }
 }
 
@@ -45,34 +46,44 @@ bool BatchGatherOp<HIPContext>::DoRunWithType()
     auto& indices = Input(INDICES);
     auto* output  = Output(0);
 
+    CAFFE_ENFORCE_GE(data.ndim(), 2, "DATA should be at least 2-D");
+
     vector<TIndex> shape;
     shape.push_back(data.dim(0));
     shape.insert(shape.end(), indices.dims().begin(), indices.dims().end());
     shape.insert(shape.end(), data.dims().begin() + 2, data.dims().end());
     output->Resize(shape);
 
-    const int block_size           = data.size_from_dim(2);
-    const int N                    = indices.size();
-    const auto data_batch_size     = data.size_from_dim(1);
-    const auto gathered_batch_size = N * data.size_from_dim(2);
-    const TInd* idxs               = indices.template data<TInd>();
-    auto src_base                  = static_cast<const float*>(data.raw_data());
-    auto out                       = static_cast<float*>(output->raw_mutable_data(data.meta()));
-    const int M                    = data.dim32(0);
-
-    hipLaunchKernelGGL((BatchGatherKernel),
-                       dim3(std::min(M, CAFFE_MAXIMUM_NUM_BLOCKS)),
-                       dim3(std::min(N * block_size, CAFFE_HIP_NUM_THREADS)),
-                       0,
-                       context_.hip_stream(),
-                       src_base,
-                       out,
-                       idxs,
-                       M,
-                       N,
-                       static_cast<const int>(data_batch_size),
-                       static_cast<const int>(gathered_batch_size),
-                       block_size);
+    const TIndex block_bytesize = data.size_from_dim(2) * data.itemsize();
+    const TIndex N              = indices.size();
+    const TIndex M              = data.dim(0);
+    const TInd* idxs            = indices.template data<TInd>();
+    auto src_base               = data.raw_data();
+    auto out                    = output->raw_mutable_data(data.meta());
+    if(M * N == 0 || block_bytesize == 0)
+    {
+        return true;
+    }
+
+    // Rows are moved as raw words, so any type of data can be gathered.
+    const int word_size = RowCopyWordSize(block_bytesize, {src_base, out});
+    const TIndex words  = block_bytesize / word_size;
+    const dim3 block    = RowCopyBlock(words);
+#define BATCH_GATHER_LAUNCH(W)                              \
+    hipLaunchKernelGGL((BatchGatherKernel<TInd, W>),        \
+                       RowCopyGrid(M * N, block),           \
+                       block,                               \
+                       0,                                   \
+                       context_.hip_stream(),               \
+                       static_cast<const W*>(src_base),     \
+                       static_cast<W*>(out),                \
+                       idxs,                                \
+                       M,                                   \
+                       N,                                   \
+                       data.dim(1),                         \
+                       words)
+    DISPATCH_ROW_COPY_WORD(word_size, BATCH_GATHER_LAUNCH);
+#undef BATCH_GATHER_LAUNCH
     return true;
 }
 
@@ -80,23 +91,21 @@ template <typename T_INDEX, typename TData>
 __global__ void BatchGatherGradientKernel(const TData* grad_data,
                                           TData* out,
                                           const T_INDEX* indices,
-                                          const int M,
-                                          const int N,
-                                          const int data_batch_size,
-                                          const int gathered_batch_size,
-                                          const int block_size)
+                                          const TIndex M,
+                                          const TIndex N,
+                                          const TIndex data_rows,
+                                          const TIndex block_size)
 {
-    int begin_idx = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
-    int num_items = M * N * block_size;
-    for(int s = begin_idx; s < num_items; s += hipBlockDim_x * hipGridDim_x)
+    HIP_ROW_LOOP(r, M * N)
     {
-        const int k             = s % block_size;
-        const int j             = s / block_size % N;
-        const int i             = s / block_size / N;
-        const T_INDEX idx       = indices[j];
-        const float* src_offset = grad_data + i * gathered_batch_size + j * block_size;
-        float* dst_offset       = out + i * data_batch_size + idx * block_size;
-        atomicAdd(dst_offset + k, src_offset[k]);
+        const TIndex i          = r / N;
+        const T_INDEX idx       = indices[r % N];
+        const TData* src_offset = grad_data + r * block_size;
+        TData* dst_offset       = out + (i * data_rows + idx) * block_size;
+        HIP_ROW_WORD_LOOP(k, block_size)
+        {
+            atomicAdd(dst_offset + k, src_offset[k]);
+        }
     }
 }
 
@@ -132,16 +141,19 @@ bool BatchGatherGradientOp<HIPContext>::DoRunWithType2()
 
     const auto* grad_data = grad.template data<float>();
 
-    const int M                    = grad.dim32(0);
-    const int block_size           = data.size_from_dim(2);
-    const int N                    = indices.size();
-    const auto data_batch_size     = data.size_from_dim(1);
-    const auto gathered_batch_size = N * data.size_from_dim(2);
-    const TInd* idxs               = indices.template data<TInd>();
+    const TIndex M          = grad.dim(0);
+    const TIndex block_size = data.size_from_dim(2);
+    const TIndex N          = indices.size();
+    const TInd* idxs        = indices.template data<TInd>();
+    if(M * N == 0 || block_size == 0)
+    {
+        return true;
+    }
 
-    hipLaunchKernelGGL((BatchGatherGradientKernel),
-                       dim3(std::min(M, CAFFE_MAXIMUM_NUM_BLOCKS)),
-                       dim3(std::min(N * block_size, CAFFE_HIP_NUM_THREADS)),
+    const dim3 block = RowCopyBlock(block_size);
+    hipLaunchKernelGGL((BatchGatherGradientKernel<TInd, float>),
+                       RowCopyGrid(M * N, block),
+                       block,
                        0,
                        context_.hip_stream(),
                        grad_data,
@@ -149,8 +161,7 @@ bool BatchGatherGradientOp<HIPContext>::DoRunWithType2()
                        idxs,
                        M,
                        N,
-                       static_cast<const int>(data_batch_size),
-                       static_cast<const int>(gathered_batch_size),
+                       data.dim(1),
                        block_size);
 
     return true;
@@ -21,6 +21,114 @@ namespace caffe2 {
 
 REGISTER_CPU_OPERATOR(BatchMatMul, BatchMatMulOp<CPUContext>);
 
+namespace {
+
+vector<TensorShape> BatchMatMulShapeInference(
+    const OperatorDef& def,
+    const vector<TensorShape>& in) {
+  ArgumentHelper helper(def);
+  bool broadcast = helper.GetSingleArgument<int>("broadcast", 0);
+  if (!broadcast) {
+    const auto ndim = in[0].dims_size();
+    CAFFE_ENFORCE_GE(ndim, 2);
+    int a_dim0;
+    int b_dim1;
+    if (helper.GetSingleArgument<int>("trans_a", 0)) {
+      a_dim0 = in[0].dims(ndim - 1);
+    } else {
+      a_dim0 = in[0].dims(ndim - 2);
+    }
+
+    if (helper.GetSingleArgument<int>("trans_b", 0)) {
+      b_dim1 = in[1].dims(ndim - 2);
+    } else {
+      b_dim1 = in[1].dims(ndim - 1);
+    }
+
+    auto output_dims =
+        vector<TIndex>{in[0].dims().begin(), in[0].dims().end()};
+    output_dims[ndim - 2] = a_dim0;
+    output_dims[ndim - 1] = b_dim1;
+
+    return vector<TensorShape>{
+        CreateTensorShape(vector<TIndex>{output_dims}, in[0].data_type())};
+  } else {
+    auto ndims_A = in[0].dims_size();
+    auto ndims_B = in[1].dims_size();
+    std::vector<TIndex> dims_A(ndims_A), dims_B(ndims_B);
+    for (int i = 0; i < ndims_A; ++i) {
+      dims_A[i] = in[0].dims(i);
+    }
+    for (int i = 0; i < ndims_B; ++i) {
+      dims_B[i] = in[1].dims(i);
+    }
+    bool A_broadcasted = false, B_broadcasted = false;
+    if (ndims_A == 1) {
+      dims_A.insert(dims_A.begin(), 1);
+      ndims_A = 2;
+      A_broadcasted = true;
+    }
+    if (ndims_B == 1) {
+      dims_B.push_back(1);
+      ndims_B = 2;
+      B_broadcasted = true;
+    }
+    size_t M, N, K, K_dim;
+    if (helper.GetSingleArgument<int>("trans_a", 0)) {
+      M = dims_A[ndims_A - 1];
+      K = dims_A[ndims_A - 2];
+      K_dim = ndims_A - 2;
+    } else {
+      M = dims_A[ndims_A - 2];
+      K = dims_A[ndims_A - 1];
+      K_dim = ndims_A - 1;
+    }
+    if (helper.GetSingleArgument<int>("trans_b", 0)) {
+      N = dims_B[ndims_B - 2];
+    } else {
+      N = dims_B[ndims_B - 1];
+    }
+
+    std::vector<TIndex> new_dims;
+    if (ndims_A >= ndims_B) {
+      new_dims.assign(dims_A.begin(), dims_A.end() - 2);
+    } else {
+      new_dims.assign(dims_B.begin(), dims_B.end() - 2);
+    }
+    if (!A_broadcasted) {
+      new_dims.push_back(M);
+    }
+    if (!B_broadcasted) {
+      new_dims.push_back(N);
+    }
+    if (A_broadcasted && B_broadcasted) {
+      new_dims.push_back(1);
+    }
+    return vector<TensorShape>{
+        CreateTensorShape(vector<TIndex>{new_dims}, in[0].data_type())};
+  }
+}
+
+OpSchema::Cost CostInferenceForBatchMatMul(
+    const OperatorDef& def,
+    const vector<TensorShape>& in) {
+  struct OpSchema::Cost c;
+  ArgumentHelper helper(def);
+  const auto ndims_A = in[0].dims_size();
+  // Every output point is a dot product over K, of 2 flops per element.
+  uint64_t K = in[0].dims(ndims_A - 1);
+  if (ndims_A > 1 && helper.GetSingleArgument<int>("trans_a", 0)) {
+    K = in[0].dims(ndims_A - 2);
+  }
+  const TensorShape Y = BatchMatMulShapeInference(def, in)[0];
+  c.flops = 2 * nElemFromShape(Y) * K;
+  c.bytes_moved =
+      nBytesFromShape(in[0]) + nBytesFromShape(in[1]) + nBytesFromShape(Y);
+  return c;
+}
+
+} // namespace
+
 OPERATOR_SCHEMA(BatchMatMul)
     .NumInputs(2)
     .NumOutputs(1)
@@ -41,90 +149,13 @@ Batch Matrix multiplication Yi = Ai * Bi, where A has shape (dim0, dim1, ... M,
     .Arg(
         "broadcast",
         "Pass 1 to allow broadcasting of dimensions. Behavior is the same as numpy.matmul. Gradient is currently not supported when running in broadcast mode.")
-    .TensorInferenceFunction([](const OperatorDef& def,
-                                const vector<TensorShape>& in) {
-      ArgumentHelper helper(def);
-      bool broadcast = helper.GetSingleArgument<int>("broadcast", 0);
-      if (!broadcast) {
-        const auto ndim = in[0].dims_size();
-        CAFFE_ENFORCE_GE(ndim, 2);
-        int a_dim0;
-        int b_dim1;
-        if (helper.GetSingleArgument<int>("trans_a", 0)) {
-          a_dim0 = in[0].dims(ndim - 1);
-        } else {
-          a_dim0 = in[0].dims(ndim - 2);
-        }
-
-        if (helper.GetSingleArgument<int>("trans_b", 0)) {
-          b_dim1 = in[1].dims(ndim - 2);
-        } else {
-          b_dim1 = in[1].dims(ndim - 1);
-        }
-
-        auto output_dims =
-            vector<TIndex>{in[0].dims().begin(), in[0].dims().end()};
-        output_dims[ndim - 2] = a_dim0;
-        output_dims[ndim - 1] = b_dim1;
-
-        return vector<TensorShape>{
-            CreateTensorShape(vector<TIndex>{output_dims}, in[0].data_type())};
-      } else {
-        auto ndims_A = in[0].dims_size();
-        auto ndims_B = in[1].dims_size();
-        std::vector<TIndex> dims_A(ndims_A), dims_B(ndims_B);
-        for (int i = 0; i < ndims_A; ++i) {
-          dims_A[i] = in[0].dims(i);
-        }
-        for (int i = 0; i < ndims_B; ++i) {
-          dims_B[i] = in[1].dims(i);
-        }
-        bool A_broadcasted = false, B_broadcasted = false;
-        if (ndims_A == 1) {
-          dims_A.insert(dims_A.begin(), 1);
-          ndims_A = 2;
-          A_broadcasted = true;
-        }
-        if (ndims_B == 1) {
-          dims_B.push_back(1);
-          ndims_B = 2;
-          B_broadcasted = true;
-        }
-        size_t M, N, K, K_dim;
-        if (helper.GetSingleArgument<int>("trans_a", 0)) {
-          M = dims_A[ndims_A - 1];
-          K = dims_A[ndims_A - 2];
-          K_dim = ndims_A - 2;
-        } else {
-          M = dims_A[ndims_A - 2];
-          K = dims_A[ndims_A - 1];
-          K_dim = ndims_A - 1;
-        }
-        if (helper.GetSingleArgument<int>("trans_b", 0)) {
-          N = dims_B[ndims_B - 2];
-        } else {
-          N = dims_B[ndims_B - 1];
-        }
-
-        std::vector<TIndex> new_dims;
-        if (ndims_A >= ndims_B) {
-          new_dims.assign(dims_A.begin(), dims_A.end() - 2);
-        } else {
-          new_dims.assign(dims_B.begin(), dims_B.end() - 2);
-        }
-        if (!A_broadcasted) {
-          new_dims.push_back(M);
-        }
-        if (!B_broadcasted) {
-          new_dims.push_back(N);
-        }
-        if (A_broadcasted && B_broadcasted) {
-          new_dims.push_back(1);
-        }
-        return vector<TensorShape>{
-            CreateTensorShape(vector<TIndex>{new_dims}, in[0].data_type())};
-      }
-    });
+    .Arg(
+        "float16_compute",
+        "For float16 inputs on devices, pass 1 to accumulate in float16 "
+        "instead of float32")
+    .TensorInferenceFunction(BatchMatMulShapeInference)
+    .CostInferenceFunction(
+        OpSchema::CostInferenceFunctionType(CostInferenceForBatchMatMul));
 
 class GetBatchMatMulGradient : public GradientMakerBase {
   using GradientMakerBase::GradientMakerBase;
@@ -163,6 +194,15 @@ class GetBatchMatMulGradient : public GradientMakerBase {
       trans_both_arg.push_back(MakeArgument<int>("use_scratch", 1));
     }
 
+    if (ArgumentHelper::HasArgument(Def(), "float16_compute")) {
+      const auto float16_compute = MakeArgument<int>(
+          "float16_compute", GetArgument(Def(), "float16_compute").i());
+      no_trans_arg.push_back(float16_compute);
+      trans_a_arg.push_back(float16_compute);
+      trans_b_arg.push_back(float16_compute);
+      trans_both_arg.push_back(float16_compute);
+    }
+
     if (trans_a) {
       if (trans_b) {
         // A'B':
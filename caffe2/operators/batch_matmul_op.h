@@ -33,7 +33,9 @@ class BatchMatMulOp final : public Operator<Context> {
         trans_a_(OperatorBase::GetSingleArgument<int>("trans_a", 0)),
         trans_b_(OperatorBase::GetSingleArgument<int>("trans_b", 0)),
         broadcast_(OperatorBase::GetSingleArgument<int>("broadcast", 0)),
-        use_scratch_(OperatorBase::GetSingleArgument<int>("use_scratch", 0)) {
+        use_scratch_(OperatorBase::GetSingleArgument<int>("use_scratch", 0)),
+        float16_compute_(
+            OperatorBase::GetSingleArgument<bool>("float16_compute", false)) {
     if (use_scratch_) {
       scratch_ = std::make_shared<Tensor<Context>>();
     }
@@ -275,25 +277,73 @@ class BatchMatMulOp final : public Operator<Context> {
         return true;
       }
 
-      // TODO(T23893772): doing this in a loop is likely going to be slow on GPU
-      for (size_t p = 0; p < num_outer_batches; ++p) {
-        math::GemmBatched<T, Context, Engine>(
+      // The scratch path casts to fp32 and goes through GemmBatched.
+      if (use_scratch_) {
+        for (size_t p = 0; p < num_outer_batches; ++p) {
+          math::GemmBatched<T, Context, Engine>(
+              trans_a_ ? CblasTrans : CblasNoTrans,
+              trans_b_ ? CblasTrans : CblasNoTrans,
+              A_slice_size,
+              num_sub_batches,
+              B_slice_size,
+              num_sub_batches,
+              M,
+              N,
+              K,
+              1.0f,
+              data_A + p * A_stride,
+              data_B + p * B_stride,
+              0.0f,
+              Y_data + p * Y_stride,
+              &context_,
+              scratch_.get());
+        }
+        return true;
+      }
+
+      const TensorProto::DataType math_type = float16_compute_
+          ? TensorProto_DataType_FLOAT16
+          : TensorProto_DataType_FLOAT;
+      if (num_sub_batches == 1) {
+        // The outer batches are a single strided batch, with a stride of 0
+        // for the broadcasted operand.
+        math::GemmStridedBatched<T, Context, Engine>(
             trans_a_ ? CblasTrans : CblasNoTrans,
             trans_b_ ? CblasTrans : CblasNoTrans,
-            A_slice_size,
-            num_sub_batches,
-            B_slice_size,
-            num_sub_batches,
+            num_outer_batches,
             M,
             N,
             K,
             1.0f,
-            data_A + p * A_stride,
-            data_B + p * B_stride,
+            data_A,
+            A_stride,
+            data_B,
+            B_stride,
             0.0f,
-            Y_data + p * Y_stride,
+            Y_data,
+            Y_stride,
             &context_,
-            use_scratch_ ? scratch_.get() : nullptr);
+            math_type);
+      } else {
+        for (size_t p = 0; p < num_outer_batches; ++p) {
+          math::GemmStridedBatched<T, Context, Engine>(
+              trans_a_ ? CblasTrans : CblasNoTrans,
+              trans_b_ ? CblasTrans : CblasNoTrans,
+              num_sub_batches,
+              M,
+              N,
+              K,
+              1.0f,
+              data_A + p * A_stride,
+              M * K,
+              data_B + p * B_stride,
+              K * N,
+              0.0f,
+              Y_data + p * Y_stride,
+              M * N,
+              &context_,
+              math_type);
+        }
       }
     }
     return true;
@@ -306,6 +356,8 @@ class BatchMatMulOp final : public Operator<Context> {
 
   bool use_scratch_;
   std::shared_ptr<Tensor<Context>> scratch_;
+
+  bool float16_compute_;
 };
 
 } // namespace caffe2
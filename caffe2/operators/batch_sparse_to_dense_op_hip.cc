@@ -0,0 +1,215 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/batch_sparse_to_dense_op.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/top_k_hip.h"
+
+namespace caffe2 {
+
+namespace {
+
+// One block per batch row. Indices outside of [0, dense_last_dim) are
+// skipped, as they cannot be reported from the device.
+__global__ void BatchSparseToDenseKernel(const TIndex dense_last_dim,
+                                         const TIndex* offsets,
+                                         const TIndex* indices,
+                                         const float* values,
+                                         float* dense)
+{
+    const int row       = hipBlockIdx_x;
+    const TIndex offset = offsets[row];
+    const TIndex length = offsets[row + 1] - offset;
+    for(TIndex j = hipThreadIdx_x; j < length; j += hipBlockDim_x)
+    {
+        const TIndex index = indices[offset + j];
+        if(index >= 0 && index < dense_last_dim)
+        {
+            dense[row * dense_last_dim + index] = values[offset + j];
+        }
+    }
+}
+
+__global__ void BatchDenseToSparseKernel(const TIndex dense_last_dim,
+                                         const TIndex* offsets,
+                                         const TIndex* indices,
+                                         const float* dense,
+                                         float* values)
+{
+    const int row       = hipBlockIdx_x;
+    const TIndex offset = offsets[row];
+    const TIndex length = offsets[row + 1] - offset;
+    for(TIndex j = hipThreadIdx_x; j < length; j += hipBlockDim_x)
+    {
+        const TIndex index = indices[offset + j];
+        values[offset + j] = (index >= 0 && index < dense_last_dim)
+                                 ? dense[row * dense_last_dim + index]
+                                 : 0.0f;
+    }
+}
+
+// Computes the row offsets of lengths on the device and returns their sum,
+// which is the only value that has to come back to the host.
+TIndex LengthsToOffsets(const Tensor<HIPContext>& lengths,
+                        Tensor<HIPContext>* offsets,
+                        Tensor<HIPContext>* scratch,
+                        HIPContext* context)
+{
+    const int batch_size = lengths.size();
+    offsets->Resize(batch_size + 1);
+    TopKLengthsToOffsets<TIndex>(
+        batch_size, lengths.data<TIndex>(), offsets->mutable_data<TIndex>(), scratch, context);
+    TIndex lengths_sum = 0;
+    context->Copy<TIndex, HIPContext, CPUContext>(
+        1, offsets->data<TIndex>() + batch_size, &lengths_sum);
+    context->FinishDeviceComputation();
+    return lengths_sum;
+}
+
+} // namespace
+
+template <>
+class BatchSparseToDenseOp<float, HIPContext> : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+
+    BatchSparseToDenseOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws),
+          OP_SINGLE_ARG(TIndex, "dense_last_dim", dense_last_dim_, -1),
+          OP_SINGLE_ARG(float, "default_value", default_value_, 0.0f)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        auto& lengths = Input(LENGTHS);
+        auto& indices = Input(INDICES);
+        auto& values  = Input(VALUES);
+        auto* output  = Output(0);
+        CAFFE_ENFORCE_EQ(indices.size(), values.size());
+        CAFFE_ENFORCE_EQ(lengths.ndim(), 1);
+        CAFFE_ENFORCE_EQ(indices.ndim(), 1);
+
+        const TIndex batch_size = lengths.size();
+        CAFFE_ENFORCE_EQ(LengthsToOffsets(lengths, &offsets_, &scratch_, &context_),
+                         indices.size());
+
+        vector<TIndex> output_shape = {batch_size};
+        if(InputSize() == 4)
+        {
+            auto& shaper = Input(3);
+            CAFFE_ENFORCE_EQ(shaper.ndim(), 2);
+            if(dense_last_dim_ == -1)
+            {
+                dense_last_dim_ = shaper.dim(1);
+            }
+            else
+            {
+                CAFFE_ENFORCE(dense_last_dim_ == shaper.dim(1),
+                              "The last dim argument is not aligned with the shape input last dim");
+            }
+        }
+        else
+        {
+            CAFFE_ENFORCE(dense_last_dim_ >= 1, "The last dim of dense must be >= 1");
+        }
+        output_shape.push_back(dense_last_dim_);
+        output->Resize(output_shape);
+        float* output_data = output->mutable_data<float>();
+        math::Set<float, HIPContext>(output->size(), default_value_, output_data, &context_);
+        if(batch_size == 0)
+        {
+            return true;
+        }
+
+        hipLaunchKernelGGL((BatchSparseToDenseKernel),
+                           dim3(batch_size),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           dense_last_dim_,
+                           offsets_.data<TIndex>(),
+                           indices.data<TIndex>(),
+                           values.data<float>(),
+                           output_data);
+        return true;
+    }
+
+    private:
+    TIndex dense_last_dim_;
+    float default_value_;
+    Tensor<HIPContext> offsets_;
+    Tensor<HIPContext> scratch_;
+    INPUT_TAGS(LENGTHS, INDICES, VALUES);
+};
+
+template <>
+class BatchDenseToSparseOp<float, HIPContext> : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+
+    BatchDenseToSparseOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        auto& lengths = Input(LENGTHS);
+        auto& indices = Input(INDICES);
+        auto& dense   = Input(DENSE);
+        auto* output  = Output(0);
+        CAFFE_ENFORCE_EQ(lengths.ndim(), 1);
+        CAFFE_ENFORCE_EQ(indices.ndim(), 1);
+        CAFFE_ENFORCE_EQ(dense.ndim(), 2);
+
+        const TIndex batch_size = lengths.size();
+        CAFFE_ENFORCE_EQ(LengthsToOffsets(lengths, &offsets_, &scratch_, &context_),
+                         indices.size());
+        CAFFE_ENFORCE_EQ(batch_size, dense.dim(0));
+
+        output->Resize(indices.dims());
+        float* output_data = output->mutable_data<float>();
+        if(batch_size == 0)
+        {
+            return true;
+        }
+
+        hipLaunchKernelGGL((BatchDenseToSparseKernel),
+                           dim3(batch_size),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           dense.dim(1),
+                           offsets_.data<TIndex>(),
+                           indices.data<TIndex>(),
+                           dense.data<float>(),
+                           output_data);
+        return true;
+    }
+
+    private:
+    Tensor<HIPContext> offsets_;
+    Tensor<HIPContext> scratch_;
+    INPUT_TAGS(LENGTHS, INDICES, DENSE);
+};
+
+REGISTER_HIP_OPERATOR(BatchSparseToDense, BatchSparseToDenseOp<float, HIPContext>);
+REGISTER_HIP_OPERATOR(BatchDenseToSparse, BatchDenseToSparseOp<float, HIPContext>);
+
+} // namespace caffe2
@@ -0,0 +1,212 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "caffe2/operators/beam_search_ops.h"
+
+#include <algorithm>
+
+namespace caffe2 {
+
+namespace {
+
+bool ScoreGreater(
+    const std::pair<float, int>& lhs,
+    const std::pair<float, int>& rhs) {
+  return lhs.first > rhs.first ||
+      (lhs.first == rhs.first && lhs.second < rhs.second);
+}
+
+} // namespace
+
+template <>
+bool BeamSearchStepOp<CPUContext>::RunOnDevice() {
+  const auto& log_probs = Input(LOG_PROBS);
+  const auto& scores = Input(SCORES);
+  CAFFE_ENFORCE_GE(log_probs.ndim(), 2, "LOG_PROBS must be at least 2-D");
+  const int vocab_size = log_probs.dim32(log_probs.ndim() - 1);
+  const int num_hypos = log_probs.size_to_dim(log_probs.ndim() - 1);
+  const int k = beam_size_;
+  CAFFE_ENFORCE_GE(num_hypos, 1);
+  CAFFE_ENFORCE_GE(vocab_size, k, "beam_size is larger than the vocabulary");
+  CAFFE_ENFORCE_EQ(scores.size(), num_hypos);
+  const bool initial_step =
+      OperatorBase::Input<TensorCPU>(TIMESTEP).data<int32_t>()[0] == 0;
+  const int expanded = initial_step ? 1 : num_hypos;
+
+  const float* word_rewards = nullptr;
+  if (InputSize() > WORD_REWARDS && Input(WORD_REWARDS).size() > 0) {
+    word_rewards = Input(WORD_REWARDS).data<float>();
+  }
+  const int* translation_tokens = nullptr;
+  if (InputSize() > TRANSLATION_TOKENS) {
+    CAFFE_ENFORCE_EQ(Input(TRANSLATION_TOKENS).size(), vocab_size);
+    translation_tokens = Input(TRANSLATION_TOKENS).data<int>();
+  }
+
+  row_.resize(vocab_size);
+  candidates_.resize(expanded * k);
+  candidate_tokens_.resize(expanded * k);
+  for (int h = 0; h < expanded; ++h) {
+    const float* lp = log_probs.data<float>() + h * vocab_size;
+    for (int j = 0; j < vocab_size; ++j) {
+      row_[j] = std::make_pair(lp[j], j);
+    }
+    std::partial_sort(row_.begin(), row_.begin() + k, row_.end(), ScoreGreater);
+    for (int j = 0; j < k; ++j) {
+      const int c = h * k + j;
+      const int token = translation_tokens ? translation_tokens[row_[j].second]
+                                           : row_[j].second;
+      float score = row_[j].first + scores.data<float>()[h];
+      if (word_rewards) {
+        score += word_rewards[token];
+      }
+      candidates_[c] = std::make_pair(score, c);
+      candidate_tokens_[c] = token;
+    }
+  }
+  std::partial_sort(
+      candidates_.begin(), candidates_.begin() + k, candidates_.end(),
+      ScoreGreater);
+
+  auto* scores_t = Output(SCORES_T);
+  auto* tokens_t = Output(TOKENS_T);
+  auto* hypo_t = Output(HYPO_T);
+  auto* hypo_t_int32 = Output(HYPO_T_INT32);
+  for (auto* output : {scores_t, tokens_t, hypo_t, hypo_t_int32}) {
+    output->Resize(1, k);
+  }
+  auto* scores_t_data = scores_t->mutable_data<float>();
+  auto* tokens_t_data = tokens_t->mutable_data<float>();
+  auto* hypo_t_data = hypo_t->mutable_data<float>();
+  auto* hypo_t_int32_data = hypo_t_int32->mutable_data<int32_t>();
+  for (int i = 0; i < k; ++i) {
+    const int c = candidates_[i].second;
+    scores_t_data[i] = candidates_[i].first;
+    tokens_t_data[i] = candidate_tokens_[c];
+    hypo_t_data[i] = c / k;
+    hypo_t_int32_data[i] = c / k;
+  }
+  return true;
+}
+
+template <>
+bool BeamSearchBacktrackOp<CPUContext>::RunOnDevice() {
+  const auto& tokens = Input(TOKENS);
+  const auto& prev_indices = Input(PREV_INDICES);
+  const auto& scores = Input(SCORES);
+  CAFFE_ENFORCE_GE(tokens.ndim(), 2, "TOKENS must be [steps + 1, beam, ...]");
+  const int num_steps = tokens.dim32(0) - 1;
+  CAFFE_ENFORCE_GE(num_steps, 0);
+  const int beam_size = tokens.size_from_dim(1);
+  CAFFE_ENFORCE_EQ(prev_indices.size(), tokens.size());
+  CAFFE_ENFORCE_EQ(scores.size(), tokens.size());
+  const auto* tokens_data = tokens.data<int32_t>();
+  const auto* prev_data = prev_indices.data<int32_t>();
+  const auto* scores_data = scores.data<float>();
+
+  // The best hypothesis that ended with EOS, or ran until the last step.
+  int best_step = num_steps;
+  int best_hypo = 0;
+  for (int i = 0; i <= num_steps; ++i) {
+    for (int h = 0; h < beam_size; ++h) {
+      const int idx = i * beam_size + h;
+      if ((tokens_data[idx] == eos_token_id_ || i == num_steps) &&
+          scores_data[idx] > scores_data[best_step * beam_size + best_hypo]) {
+        best_step = i;
+        best_hypo = h;
+      }
+    }
+  }
+
+  auto* output_tokens = Output(OUTPUT_TOKENS);
+  auto* output_hypos = Output(OUTPUT_HYPOS);
+  auto* output_score = Output(OUTPUT_SCORE);
+  output_tokens->Resize(best_step);
+  output_hypos->Resize(best_step);
+  output_score->Resize(1);
+  output_score->mutable_data<float>()[0] =
+      scores_data[best_step * beam_size + best_hypo];
+  auto* output_tokens_data = output_tokens->mutable_data<int32_t>();
+  auto* output_hypos_data = output_hypos->mutable_data<int32_t>();
+  for (int i = best_step, h = best_hypo; i > 0; --i) {
+    CAFFE_ENFORCE(h >= 0 && h < beam_size, "Invalid backpointer ", h);
+    output_tokens_data[i - 1] = tokens_data[i * beam_size + h];
+    output_hypos_data[i - 1] = h;
+    h = prev_data[i * beam_size + h];
+  }
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(BeamSearchStep, BeamSearchStepOp<CPUContext>);
+REGISTER_CPU_OPERATOR(BeamSearchBacktrack, BeamSearchBacktrackOp<CPUContext>);
+
+OPERATOR_SCHEMA(BeamSearchStep)
+    .NumInputs(3, 5)
+    .NumOutputs(4)
+    .SetDoc(R"DOC(
+One step of beam search decoding. The beam_size best tokens of every
+hypothesis are scored with the score of the hypothesis and, optionally, the
+reward of the token; the beam_size best of those become the hypotheses of the
+next step. Only the first hypothesis is extended on the first step, when all
+of them are the same. Ties go to the lower index, as with TopK.
+
+This does in one operator what the TopK, Add, Reshape, Slice, Div and Gather
+operators of a Python built beam search do, without intermediate blobs.
+)DOC")
+    .Arg("beam_size", "Number of hypotheses kept")
+    .Input(
+        0,
+        "log_probs",
+        "Log probabilities, [num_hypos, vocab_size]; leading dimensions are "
+        "flattened")
+    .Input(1, "scores", "Scores of the hypotheses, num_hypos elements")
+    .Input(2, "timestep", "Current step, an int32 CPU tensor")
+    .Input(
+        3,
+        "word_rewards",
+        "Optional reward added to the score of every token, ignored when "
+        "empty")
+    .Input(
+        4,
+        "possible_translation_tokens",
+        "Optional int32 token of every column of log_probs")
+    .Output(0, "scores_t", "Scores of the new hypotheses, [1, beam_size]")
+    .Output(1, "tokens_t", "Their last token as floats, [1, beam_size]")
+    .Output(2, "hypo_t", "Their parent hypothesis as floats, [1, beam_size]")
+    .Output(3, "hypo_t_int32", "Their parent hypothesis, [1, beam_size]");
+
+OPERATOR_SCHEMA(BeamSearchBacktrack)
+    .NumInputs(3)
+    .NumOutputs(3)
+    .SetDoc(R"DOC(
+Finds the best scored hypothesis out of the beams of all the steps that either
+ended with eos_token_id or was still running at the last step, and follows its
+backpointers to recover its tokens. Step 0 holds the initial hypothesis and is
+not part of the output.
+)DOC")
+    .Arg("eos_token_id", "Token ending a hypothesis")
+    .Input(0, "tokens", "int32 token of every hypothesis, [steps + 1, beam]")
+    .Input(1, "prev_indices", "int32 parent of every hypothesis")
+    .Input(2, "scores", "Score of every hypothesis")
+    .Output(0, "output_tokens", "Tokens of the best hypothesis")
+    .Output(1, "output_hypos", "Hypothesis index of every output token")
+    .Output(2, "output_score", "Score of the best hypothesis");
+
+SHOULD_NOT_DO_GRADIENT(BeamSearchStep);
+SHOULD_NOT_DO_GRADIENT(BeamSearchBacktrack);
+
+} // namespace caffe2
@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CAFFE2_OPERATORS_BEAM_SEARCH_OPS_H_
+#define CAFFE2_OPERATORS_BEAM_SEARCH_OPS_H_
+
+#include <utility>
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+// One step of beam search: the beam_size best tokens of every hypothesis
+// are extended with the hypothesis score, and the beam_size best of those
+// become the next hypotheses. Only the first hypothesis is extended on the
+// first step. Ties go to the lower index, as with TopK.
+template <class Context>
+class BeamSearchStepOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  BeamSearchStepOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        OP_SINGLE_ARG(int, "beam_size", beam_size_, 0) {
+    CAFFE_ENFORCE_GE(beam_size_, 1, "beam_size must be >= 1");
+  }
+
+  bool RunOnDevice() override;
+
+ protected:
+  int beam_size_;
+  // score and index of the row or candidate, kept across steps
+  std::vector<std::pair<float, int>> row_;
+  std::vector<std::pair<float, int>> candidates_;
+  std::vector<int> candidate_tokens_;
+
+  INPUT_TAGS(LOG_PROBS, SCORES, TIMESTEP, WORD_REWARDS, TRANSLATION_TOKENS);
+  OUTPUT_TAGS(SCORES_T, TOKENS_T, HYPO_T, HYPO_T_INT32);
+};
+
+// Picks the best finished hypothesis out of the beams of all the steps and
+// follows its backpointers to the first step.
+template <class Context>
+class BeamSearchBacktrackOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  BeamSearchBacktrackOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        OP_SINGLE_ARG(int, "eos_token_id", eos_token_id_, -1) {
+    CAFFE_ENFORCE(
+        OperatorBase::HasArgument("eos_token_id"),
+        "eos_token_id must be specified");
+  }
+
+  bool RunOnDevice() override;
+
+ protected:
+  int eos_token_id_;
+
+  INPUT_TAGS(TOKENS, PREV_INDICES, SCORES);
+  OUTPUT_TAGS(OUTPUT_TOKENS, OUTPUT_HYPOS, OUTPUT_SCORE);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_BEAM_SEARCH_OPS_H_
@@ -0,0 +1,221 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/beam_search_ops.h"
+#include "caffe2/operators/operator_fallback_hip.h"
+#include "caffe2/operators/top_k_hip.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Scores the beam_size best tokens of every expanded hypothesis, read out of
+// the rows sorted by SegmentedSortDescending.
+__global__ void BeamSearchCandidatesKernel(const int num_candidates,
+                                           const int vocab_size,
+                                           const int beam_size,
+                                           const float* sorted_log_probs,
+                                           const int* sorted_indices,
+                                           const float* scores,
+                                           const float* word_rewards,
+                                           const int* translation_tokens,
+                                           float* candidate_scores,
+                                           int* candidate_tokens)
+{
+    HIP_1D_KERNEL_LOOP(c, num_candidates)
+    {
+        const int h     = c / beam_size;
+        const int pos   = h * vocab_size + c % beam_size;
+        const int col   = sorted_indices[pos] - h * vocab_size;
+        const int token = translation_tokens ? translation_tokens[col] : col;
+        float score     = sorted_log_probs[pos] + scores[h];
+        if(word_rewards)
+        {
+            score += word_rewards[token];
+        }
+        candidate_scores[c] = score;
+        candidate_tokens[c] = token;
+    }
+}
+
+__global__ void BeamSearchOutputKernel(const int beam_size,
+                                       const float* sorted_scores,
+                                       const int* sorted_candidates,
+                                       const int* candidate_tokens,
+                                       float* scores_t,
+                                       float* tokens_t,
+                                       float* hypo_t,
+                                       int* hypo_t_int32)
+{
+    HIP_1D_KERNEL_LOOP(i, beam_size)
+    {
+        const int c     = sorted_candidates[i];
+        scores_t[i]     = sorted_scores[i];
+        tokens_t[i]     = candidate_tokens[c];
+        hypo_t[i]       = c / beam_size;
+        hypo_t_int32[i] = c / beam_size;
+    }
+}
+
+} // namespace
+
+// The rows and then the candidates are sorted on the device, so the beams
+// never leave it; only the CPU timestep is read on the host.
+template <>
+class BeamSearchStepOp<HIPContext> final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    BeamSearchStepOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws),
+          OP_SINGLE_ARG(int, "beam_size", beam_size_, 0)
+    {
+        CAFFE_ENFORCE_GE(beam_size_, 1, "beam_size must be >= 1");
+    }
+
+    bool RunOnDevice() override
+    {
+        const auto& log_probs = Input(LOG_PROBS);
+        const auto& scores    = Input(SCORES);
+        CAFFE_ENFORCE_GE(log_probs.ndim(), 2, "LOG_PROBS must be at least 2-D");
+        const int vocab_size = log_probs.dim32(log_probs.ndim() - 1);
+        const int num_hypos  = log_probs.size_to_dim(log_probs.ndim() - 1);
+        const int k          = beam_size_;
+        CAFFE_ENFORCE_GE(num_hypos, 1);
+        CAFFE_ENFORCE_GE(vocab_size, k, "beam_size is larger than the vocabulary");
+        CAFFE_ENFORCE_EQ(scores.size(), num_hypos);
+        const bool initial_step =
+            OperatorBase::Input<TensorCPU>(TIMESTEP).data<int32_t>()[0] == 0;
+        const int expanded       = initial_step ? 1 : num_hypos;
+        const int num_candidates = expanded * k;
+
+        const float* word_rewards = nullptr;
+        if(InputSize() > WORD_REWARDS && Input(WORD_REWARDS).size() > 0)
+        {
+            word_rewards = Input(WORD_REWARDS).data<float>();
+        }
+        const int* translation_tokens = nullptr;
+        if(InputSize() > TRANSLATION_TOKENS)
+        {
+            CAFFE_ENFORCE_EQ(Input(TRANSLATION_TOKENS).size(), vocab_size);
+            translation_tokens = Input(TRANSLATION_TOKENS).data<int>();
+        }
+
+        row_offsets_.Resize(expanded + 1);
+        hipLaunchKernelGGL((TopKUniformOffsetsKernel<int>),
+                           dim3(CAFFE_GET_BLOCKS(expanded + 1)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           expanded + 1,
+                           vocab_size,
+                           row_offsets_.mutable_data<int>());
+        sorted_log_probs_.Resize(expanded * vocab_size);
+        sorted_indices_.Resize(expanded * vocab_size);
+        SegmentedSortDescending(expanded * vocab_size,
+                                expanded,
+                                log_probs.data<float>(),
+                                row_offsets_.data<int>(),
+                                sorted_log_probs_.mutable_data<float>(),
+                                sorted_indices_.mutable_data<int>(),
+                                &scratch_,
+                                &context_);
+
+        candidate_scores_.Resize(num_candidates);
+        candidate_tokens_.Resize(num_candidates);
+        hipLaunchKernelGGL((BeamSearchCandidatesKernel),
+                           dim3(CAFFE_GET_BLOCKS(num_candidates)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           num_candidates,
+                           vocab_size,
+                           k,
+                           sorted_log_probs_.data<float>(),
+                           sorted_indices_.data<int>(),
+                           scores.data<float>(),
+                           word_rewards,
+                           translation_tokens,
+                           candidate_scores_.mutable_data<float>(),
+                           candidate_tokens_.mutable_data<int>());
+
+        candidate_offsets_.Resize(2);
+        hipLaunchKernelGGL((TopKUniformOffsetsKernel<int>),
+                           dim3(1),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           2,
+                           num_candidates,
+                           candidate_offsets_.mutable_data<int>());
+        sorted_candidate_scores_.Resize(num_candidates);
+        sorted_candidates_.Resize(num_candidates);
+        SegmentedSortDescending(num_candidates,
+                                1,
+                                candidate_scores_.data<float>(),
+                                candidate_offsets_.data<int>(),
+                                sorted_candidate_scores_.mutable_data<float>(),
+                                sorted_candidates_.mutable_data<int>(),
+                                &scratch_,
+                                &context_);
+
+        auto* scores_t     = Output(SCORES_T);
+        auto* tokens_t     = Output(TOKENS_T);
+        auto* hypo_t       = Output(HYPO_T);
+        auto* hypo_t_int32 = Output(HYPO_T_INT32);
+        scores_t->Resize(1, k);
+        tokens_t->Resize(1, k);
+        hypo_t->Resize(1, k);
+        hypo_t_int32->Resize(1, k);
+        hipLaunchKernelGGL((BeamSearchOutputKernel),
+                           dim3(CAFFE_GET_BLOCKS(k)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           k,
+                           sorted_candidate_scores_.data<float>(),
+                           sorted_candidates_.data<int>(),
+                           candidate_tokens_.data<int>(),
+                           scores_t->mutable_data<float>(),
+                           tokens_t->mutable_data<float>(),
+                           hypo_t->mutable_data<float>(),
+                           hypo_t_int32->mutable_data<int32_t>());
+        return true;
+    }
+
+    private:
+    int beam_size_;
+    Tensor<HIPContext> row_offsets_;
+    Tensor<HIPContext> sorted_log_probs_;
+    Tensor<HIPContext> sorted_indices_;
+    Tensor<HIPContext> candidate_scores_;
+    Tensor<HIPContext> candidate_tokens_;
+    Tensor<HIPContext> candidate_offsets_;
+    Tensor<HIPContext> sorted_candidate_scores_;
+    Tensor<HIPContext> sorted_candidates_;
+    Tensor<HIPContext> scratch_;
+
+    INPUT_TAGS(LOG_PROBS, SCORES, TIMESTEP, WORD_REWARDS, TRANSLATION_TOKENS);
+    OUTPUT_TAGS(SCORES_T, TOKENS_T, HYPO_T, HYPO_T_INT32);
+};
+
+REGISTER_HIP_OPERATOR(BeamSearchStep, BeamSearchStepOp<HIPContext>);
+// Backtracking runs once per decoded sequence, over a few small tensors.
+REGISTER_HIP_OPERATOR(BeamSearchBacktrack,
+                      GPUFallbackOp<BeamSearchBacktrackOp<CPUContext>>);
+} // namespace caffe2
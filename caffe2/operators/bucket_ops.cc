@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/bucket_ops.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(PackBucket, PackBucketOp<CPUContext>);
+REGISTER_CPU_OPERATOR(UnpackBucket, UnpackBucketOp<CPUContext>);
+
+OPERATOR_SCHEMA(PackBucket)
+    .NumInputs(1, INT_MAX)
+    .NumOutputs(1)
+    .TensorInferenceFunction([](const OperatorDef& def,
+                                const vector<TensorShape>& in) {
+      int total = 0;
+      for (const auto& shape : in) {
+        int size = 1;
+        for (auto d : shape.dims()) {
+          size *= d;
+        }
+        total += size;
+      }
+      ArgumentHelper helper(def);
+      const int shards = helper.GetSingleArgument<int>("shards", 1);
+      if (shards > 1) {
+        const int padded = PaddedBucketSize(total, shards);
+        return vector<TensorShape>{CreateTensorShape(
+            vector<int>{shards, padded / shards}, in[0].data_type())};
+      }
+      return vector<TensorShape>{
+          CreateTensorShape(vector<int>{total}, in[0].data_type())};
+    })
+    .SetDoc(R"DOC(
+Copies all inputs back to back into a single 1-D tensor. All inputs must have
+the same data type. Together with UnpackBucket this lets a single collective
+(e.g. Allreduce) operate on many small tensors at once, which is bound by
+bandwidth rather than by the per-message latency.
+)DOC")
+    .Arg("shards", "If greater than 1, the bucket is zero padded to a multiple "
+         "of shards elements and shaped [shards, size / shards], the layout "
+         "NCCLReduceScatter splits across devices. Defaults to 1")
+    .Input(0, "X_1", "First tensor to pack; more tensors can follow.")
+    .Output(0, "bucket", "1-D tensor holding the elements of all inputs.");
+
+OPERATOR_SCHEMA(UnpackBucket)
+    .NumInputs(2, INT_MAX)
+    .NumOutputs(1, INT_MAX)
+    .AllowInplace([](int in, int out) { return in == out + 1; })
+    .TensorInferenceFunction([](const OperatorDef& def,
+                                const vector<TensorShape>& in) {
+      vector<TensorShape> out;
+      for (int i = 1; i < in.size(); ++i) {
+        out.push_back(in[i]);
+        out.back().set_data_type(in[0].data_type());
+      }
+      return out;
+    })
+    .SetDoc(R"DOC(
+Inverse of PackBucket. The first input is a bucket produced by PackBucket, the
+following N inputs give the shapes of the N outputs, which receive consecutive
+slices of the bucket. The outputs are usually the shape inputs themselves, so
+that the tensors are updated in place.
+)DOC")
+    .Arg("shards", "The shards the bucket was packed with; its padding is "
+         "dropped. Defaults to 1")
+    .Input(0, "bucket", "1-D tensor produced by PackBucket.")
+    .Input(1, "X_1", "Tensor giving the shape of the first output.")
+    .Output(0, "Y_1", "First slice of the bucket, reshaped like X_1.");
+
+SHOULD_NOT_DO_GRADIENT(PackBucket);
+SHOULD_NOT_DO_GRADIENT(UnpackBucket);
+
+} // namespace caffe2
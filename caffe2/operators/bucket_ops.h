@@ -0,0 +1,133 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_OPERATORS_BUCKET_OPS_H_
+#define CAFFE2_OPERATORS_BUCKET_OPS_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+// Rounds the number of elements of a bucket up to a multiple of shards.
+inline TIndex PaddedBucketSize(TIndex total, int shards) {
+  return (total + shards - 1) / shards * shards;
+}
+
+// Packs all inputs, which must share the same type, back to back into a
+// single 1-D tensor. Used to fuse many small collectives into one. With
+// shards > 1 the bucket is zero padded and shaped [shards, size / shards],
+// so that a reduce-scatter can split it evenly across devices.
+template <class Context>
+class PackBucketOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  PackBucketOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        OP_SINGLE_ARG(int, "shards", shards_, 1) {
+    CAFFE_ENFORCE_GE(shards_, 1);
+  }
+
+  bool RunOnDevice() override {
+    const auto& meta = Input(0).meta();
+    TIndex total = 0;
+    for (int i = 0; i < InputSize(); ++i) {
+      CAFFE_ENFORCE(
+          Input(i).meta() == meta,
+          "All inputs of PackBucket must have the same type, input ",
+          i,
+          " is ",
+          Input(i).meta().name(),
+          " while input 0 is ",
+          meta.name());
+      total += Input(i).size();
+    }
+
+    auto* bucket = Output(0);
+    const auto padded = PaddedBucketSize(total, shards_);
+    if (shards_ > 1) {
+      bucket->Resize(shards_, padded / shards_);
+    } else {
+      bucket->Resize(total);
+    }
+    auto* dst = static_cast<char*>(bucket->raw_mutable_data(meta));
+    for (int i = 0; i < InputSize(); ++i) {
+      const auto nbytes = Input(i).nbytes();
+      context_.template CopyBytes<Context, Context>(
+          nbytes, Input(i).raw_data(), dst);
+      dst += nbytes;
+    }
+    if (padded > total) {
+      // Zero bytes are zero for all the float types a bucket is reduced in.
+      math::Set<char, Context>(
+          (padded - total) * meta.itemsize(), 0, dst, &context_);
+    }
+    return true;
+  }
+
+ private:
+  int shards_;
+};
+
+// Inverse of PackBucket: input 0 is the bucket, inputs 1..N give the shapes
+// of the N outputs, which are filled with consecutive slices of the bucket.
+// Outputs are usually the shape inputs themselves (in-place). shards has to
+// match the PackBucket that made the bucket, the padding is dropped.
+template <class Context>
+class UnpackBucketOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  UnpackBucketOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        OP_SINGLE_ARG(int, "shards", shards_, 1) {
+    CAFFE_ENFORCE_GE(shards_, 1);
+  }
+
+  bool RunOnDevice() override {
+    const auto& bucket = Input(0);
+    CAFFE_ENFORCE_EQ(InputSize(), OutputSize() + 1);
+
+    TIndex total = 0;
+    for (int i = 1; i < InputSize(); ++i) {
+      total += Input(i).size();
+    }
+    CAFFE_ENFORCE_EQ(
+        PaddedBucketSize(total, shards_),
+        bucket.size(),
+        "The bucket does not match the size of the tensors it unpacks into");
+
+    const auto* src = static_cast<const char*>(bucket.raw_data());
+    for (int i = 0; i < OutputSize(); ++i) {
+      // Read the shape before resizing, the output may alias the input.
+      const auto dims = Input(i + 1).dims();
+      auto* output = Output(i);
+      output->Resize(dims);
+      const auto nbytes = output->size() * bucket.itemsize();
+      context_.template CopyBytes<Context, Context>(
+          nbytes, src, output->raw_mutable_data(bucket.meta()));
+      src += nbytes;
+    }
+    return true;
+  }
+
+ private:
+  int shards_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_BUCKET_OPS_H_
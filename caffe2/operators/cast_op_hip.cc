@@ -14,8 +14,10 @@
  * limitations under the License.
  */
 
+#include <type_traits>
 #include "hip/hip_runtime.h"
 #include "caffe2/core/context_hip.h"
+#include "caffe2/core/micro_ops_hip.h"
 #include "caffe2/operators/cast_op.h"
 #include "caffe2/utils/conversions.h"
 
@@ -43,6 +45,31 @@ bool CastOp<HIPContext>::DoRunWithType()
         // skip the rest of the computation if input is empty
         return true;
     }
+    if(std::is_same<SrcType, DstType>::value)
+    {
+        if(QueueHIPMicroOp(&context_, HIPMicroOp::kCopy, input.nbytes(), data, out))
+        {
+            return true;
+        }
+    }
+    else if(std::is_same<SrcType, float>::value && std::is_same<DstType, float16>::value)
+    {
+        if(QueueHIPMicroOp(&context_, HIPMicroOp::kFloatToHalf, N, data, out))
+        {
+            return true;
+        }
+    }
+    else if(std::is_same<SrcType, float16>::value && std::is_same<DstType, float>::value)
+    {
+        if(QueueHIPMicroOp(&context_, HIPMicroOp::kHalfToFloat, N, data, out))
+        {
+            return true;
+        }
+    }
+    else
+    {
+        MicroOps::Flush();
+    }
     hipLaunchKernelGGL((CastKernel<DstType, SrcType>),
                        dim3(CAFFE_GET_BLOCKS(N)),
                        dim3(CAFFE_HIP_NUM_THREADS),
@@ -119,5 +146,6 @@ void CastOp<HIPContext>::SetBody(TensorProto_DataType to)
 }
 
 REGISTER_HIP_OPERATOR(Cast, CastOp<HIPContext>);
+REGISTER_COALESCABLE_OPERATOR(HIP, Cast);
 
 } // namespace caffe2
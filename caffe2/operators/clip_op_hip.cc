@@ -15,6 +15,7 @@
  */
 
 #include "caffe2/core/context_hip.h"
+#include "caffe2/core/micro_ops_hip.h"
 #include "caffe2/operators/clip_op.h"
 #include "hip/hip_runtime.h"
 
@@ -65,6 +66,16 @@ bool ClipOp<float, HIPContext>::RunOnDevice()
     auto* Y = Output(0);
     CAFFE_ENFORCE_GT(X.size(), 0);
     Y->ResizeLike(X);
+    if(QueueHIPMicroOp(&context_,
+                       HIPMicroOp::kClip,
+                       X.size(),
+                       X.data<float>(),
+                       Y->mutable_data<float>(),
+                       min_,
+                       max_))
+    {
+        return true;
+    }
     hipLaunchKernelGGL((ClipKernel),
                        dim3(CAFFE_GET_BLOCKS(X.size())),
                        dim3(CAFFE_HIP_NUM_THREADS),
@@ -102,5 +113,6 @@ bool ClipGradientOp<float, HIPContext>::RunOnDevice()
 }
 
 REGISTER_HIP_OPERATOR(Clip, ClipOp<float, HIPContext>);
+REGISTER_COALESCABLE_OPERATOR(HIP, Clip);
 REGISTER_HIP_OPERATOR(ClipGradient, ClipGradientOp<float, HIPContext>);
 } // namespace caffe2
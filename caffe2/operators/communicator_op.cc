@@ -52,6 +52,7 @@ OPERATOR_SCHEMA(Broadcast)
     })
     .EnforceInplace([](int in, int out) { return (in - 1) == out; })
     .InputsCanCrossDevices()
+    .CommunicationOp()
     .IdenticalTypeAndShapeOfInput(0)
     .SetDoc(R"DOC(
 Does a broadcast operation from the root node to every other node. The tensor
@@ -66,6 +67,7 @@ OPERATOR_SCHEMA(Reduce)
     .NumInputs(2)
     .NumOutputs(1)
     .InputsCanCrossDevices()
+    .CommunicationOp()
     .IdenticalTypeAndShapeOfInput(0)
     .SetDoc(R"DOC(
 Does a reduce operation from every node to the root node. Currently only
@@ -83,17 +85,44 @@ OPERATOR_SCHEMA(Allreduce)
     .EnforceInplace([](int in, int out) { return (in - 1) == out; })
     .IdenticalTypeAndShapeOfInput(0)
     .InputsCanCrossDevices()
+    .CommunicationOp()
     .SetDoc(R"DOC(
 Does an allreduce operation among the nodes. Currently only Sum is supported.
 )DOC")
+    .Arg("wire_fp16", "(bool, default false) if set, fp32 tensors are "
+         "converted to fp16 on their device and reduced in fp16, which "
+         "halves the bytes sent at the cost of fp16 precision and range.")
     .Input(0, "comm_world", "The common world.")
     .Input(1, "X", "A tensor to be allreduced.")
     .Output(0, "Y", "The allreduced tensor, same on all nodes.");
 
+OPERATOR_SCHEMA(TopKAllreduce)
+    .NumInputs(3)
+    .NumOutputs(2)
+    .EnforceInplace({{1, 0}, {2, 1}})
+    .InputsCanCrossDevices()
+    .CommunicationOp()
+    .SetDoc(R"DOC(
+Does a sparsified sum allreduce of a float tensor among the nodes, with error
+feedback. Each node adds X to its residual, sends only the k entries of the
+result of largest magnitude, and keeps the other entries in the residual for
+the next run. Y is the sum of the entries sent by all nodes. The residual has
+to be initialized, e.g. to zeros, with the shape of X.
+)DOC")
+    .Arg("k", "(int) number of entries sent by each node.")
+    .Arg("ratio", "(float) fraction of the entries sent by each node, used "
+         "instead of k.")
+    .Input(0, "comm_world", "The common world.")
+    .Input(1, "X", "A tensor to be allreduced.")
+    .Input(2, "residual", "The entries of the previous runs not sent yet.")
+    .Output(0, "Y", "The sparsified sum, same on all nodes.")
+    .Output(1, "residual", "The updated residual.");
+
 OPERATOR_SCHEMA(Allgather)
     .NumInputs(2, INT_MAX)
     .NumOutputs(1)
     .InputsCanCrossDevices()
+    .CommunicationOp()
     .SetDoc(R"DOC(
 Does an allgather operation among the nodes.
 )DOC")
@@ -103,6 +132,7 @@ Does an allgather operation among the nodes.
 
 OPERATOR_SCHEMA(Barrier)
     .NumInputs(1)
+    .CommunicationOp()
     .SetDoc(R"DOC(
 Does a barrier operation among the nodes.
 )DOC")
@@ -111,6 +141,7 @@ Does a barrier operation among the nodes.
 OPERATOR_SCHEMA(SendTensor)
     .NumInputs({2, 4})
     .NumOutputs(0)
+    .CommunicationOp()
     .SetDoc(R"DOC(
 Sends the tensor to another node.
 )DOC")
@@ -137,6 +168,7 @@ Sends the tensor to another node.
 OPERATOR_SCHEMA(ReceiveTensor)
     .NumInputs({2, 4})
     .NumOutputs(3)
+    .CommunicationOp()
     .EnforceInplace({{1, 0}})
     .AllowInplace({{2, 1}, {3, 2}})
     .SetDoc(R"DOC(
@@ -184,6 +216,7 @@ SHOULD_NOT_DO_GRADIENT(Broadcast);
 SHOULD_NOT_DO_GRADIENT(Reduce);
 SHOULD_NOT_DO_GRADIENT(Allgather);
 SHOULD_NOT_DO_GRADIENT(Allreduce);
+SHOULD_NOT_DO_GRADIENT(TopKAllreduce);
 SHOULD_NOT_DO_GRADIENT(Barrier);
 SHOULD_NOT_DO_GRADIENT(SendTensor);
 SHOULD_NOT_DO_GRADIENT(ReceiveTensor);
@@ -196,6 +229,7 @@ REGISTER_CPU_OPERATOR(Broadcast, NoDefaultEngineOp<CPUContext>);
 REGISTER_CPU_OPERATOR(Reduce, NoDefaultEngineOp<CPUContext>);
 REGISTER_CPU_OPERATOR(Allgather, NoDefaultEngineOp<CPUContext>);
 REGISTER_CPU_OPERATOR(Allreduce, NoDefaultEngineOp<CPUContext>);
+REGISTER_CPU_OPERATOR(TopKAllreduce, NoDefaultEngineOp<CPUContext>);
 REGISTER_CPU_OPERATOR(Barrier, NoDefaultEngineOp<CPUContext>);
 REGISTER_CPU_OPERATOR(SendTensor, NoDefaultEngineOp<CPUContext>);
 REGISTER_CPU_OPERATOR(ReceiveTensor, NoDefaultEngineOp<CPUContext>);
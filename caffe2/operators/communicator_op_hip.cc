@@ -26,6 +26,7 @@ REGISTER_HIP_OPERATOR(Broadcast, NoDefaultEngineOp<HIPContext>);
 REGISTER_HIP_OPERATOR(Reduce, NoDefaultEngineOp<HIPContext>);
 REGISTER_HIP_OPERATOR(Allgather, NoDefaultEngineOp<HIPContext>);
 REGISTER_HIP_OPERATOR(Allreduce, NoDefaultEngineOp<HIPContext>);
+REGISTER_HIP_OPERATOR(TopKAllreduce, NoDefaultEngineOp<HIPContext>);
 REGISTER_HIP_OPERATOR(SendTensor, NoDefaultEngineOp<HIPContext>);
 REGISTER_HIP_OPERATOR(ReceiveTensor, NoDefaultEngineOp<HIPContext>);
 
@@ -64,9 +64,17 @@ class SplitOp final : public Operator<Context> {
   bool RunOnDevice() override;
 
  protected:
+  // Copies the columns of every output out of the input, viewed as a
+  // before x (input_channels * after) matrix. Contexts that can do all the
+  // outputs at once specialize it, by default it's CopyOutputsOneByOne.
+  void CopyOutputs(int before, int after, const int* axis_data);
+  void CopyOutputsOneByOne(int before, int after, const int* axis_data);
+
   int axis_;
   int add_axis_;
   vector<int> split_;
+  // Table of the outputs for the single copy, on the device.
+  Tensor<Context> parts_;
   // Input: X, optionally split
   // The split tensor is stored in CPU.
 };
@@ -94,8 +102,24 @@ class ConcatOp final : public Operator<Context> {
   bool RunOnDevice() override;
 
  protected:
+  // Copies every input into its columns of the output, viewed as a
+  // before x (output_channels * after) matrix. Contexts that can do all the
+  // inputs at once specialize it, by default it's CopyInputsOneByOne.
+  void CopyInputs(
+      int before,
+      int after,
+      int output_channels,
+      const int* axis_data);
+  void CopyInputsOneByOne(
+      int before,
+      int after,
+      int output_channels,
+      const int* axis_data);
+
   int axis_;
   int add_axis_;
+  // Table of the inputs for the single copy, on the device.
+  Tensor<Context> parts_;
   // Input: a number of tensors. Output: Y, split
   // The split are stored in CPU.
 };
@@ -155,27 +179,49 @@ bool SplitOp<Context>::RunOnDevice() {
   if (add_axis_) {
     output_dims.erase(output_dims.begin() + canonical_axis);
   }
-  size_t input_offset = 0;
   for (int i = 0; i < OutputSize(); ++i) {
-    auto* output = Output(i);
-    auto axis_dim = add_axis_ ? 1 : axis_data[i];
     if (!add_axis_) {
       output_dims[canonical_axis] = axis_data[i];
     }
-    output->Resize(output_dims);
+    Output(i)->Resize(output_dims);
+  }
+  CopyOutputs(before, after, axis_data);
+  return true;
+}
+
+template <class Context>
+void SplitOp<Context>::CopyOutputs(
+    int before,
+    int after,
+    const int* axis_data) {
+  CopyOutputsOneByOne(before, after, axis_data);
+}
+
+template <class Context>
+void SplitOp<Context>::CopyOutputsOneByOne(
+    int before,
+    int after,
+    const int* axis_data) {
+  auto& input = Input(0);
+  const int input_channels = add_axis_
+      ? OutputSize()
+      : std::accumulate(axis_data, axis_data + OutputSize(), 0);
+  size_t input_offset = 0;
+  for (int i = 0; i < OutputSize(); ++i) {
+    auto* output = Output(i);
+    auto axis_dim = add_axis_ ? 1 : axis_data[i];
     math::CopyMatrix<Context>(
         input.itemsize(),
         before,
         axis_dim * after,
         static_cast<const char*>(input.raw_data()) + input_offset,
-        input.dim32(canonical_axis) * after,
+        input_channels * after,
         output->raw_mutable_data(input.meta()),
         axis_dim * after,
         &context_,
         input.meta().copy());
     input_offset += axis_dim * after * input.itemsize();
   }
-  return true;
 }
 
 template <class Context>
@@ -249,10 +295,31 @@ bool ConcatOp<Context>::RunOnDevice() {
     output_dims[canonical_axis] = output_channels;
   }
   output->Resize(output_dims);
+  CopyInputs(before, after, output_channels, axis_data);
+  return true;
+}
+
+template <class Context>
+void ConcatOp<Context>::CopyInputs(
+    int before,
+    int after,
+    int output_channels,
+    const int* axis_data) {
+  CopyInputsOneByOne(before, after, output_channels, axis_data);
+}
+
+template <class Context>
+void ConcatOp<Context>::CopyInputsOneByOne(
+    int before,
+    int after,
+    int output_channels,
+    const int* axis_data) {
+  auto* output = Output(0);
+  auto& input_zero = Input(0);
   size_t output_offset = 0;
   for (int i = 0; i < InputSize(); ++i) {
     auto& input = Input(i);
-    auto axis_dim = add_axis_ ? 1 : input.dim32(canonical_axis);
+    auto axis_dim = axis_data[i];
     math::CopyMatrix<Context>(
         input.itemsize(),
         before,
@@ -266,7 +333,6 @@ bool ConcatOp<Context>::RunOnDevice() {
         input_zero.meta().copy());
     output_offset += axis_dim * after * input.itemsize();
   }
-  return true;
 }
 
 } // namespace caffe2
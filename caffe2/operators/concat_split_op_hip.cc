@@ -14,10 +14,208 @@
  * limitations under the License.
  */
 
+#include "caffe2/core/common_hip.h"
 #include "caffe2/core/context_hip.h"
 #include "caffe2/operators/concat_split_op.h"
+#include "hip/hip_runtime.h"
 
 namespace caffe2 {
+
+namespace {
+
+// One input of a Concat, or one output of a Split: a matrix of cols columns
+// that starts at column col_begin of the whole output or input.
+struct MultiCopyPart
+{
+    char* data;
+    int cols;
+    int col_begin;
+};
+
+/**
+ * Copies all the parts between whole, a rows x total_cols matrix, and their
+ * own matrices. The thread of every element of whole finds the part holding
+ * its column in the table, so any number of parts is done in one launch.
+ */
+template <typename T, bool kSplit>
+__global__ void MultiCopyKernel(const int size,
+                                const int total_cols,
+                                const int num_parts,
+                                const MultiCopyPart* parts,
+                                T* whole)
+{
+    HIP_1D_KERNEL_LOOP(index, size)
+    {
+        const int row = index / total_cols;
+        const int col = index % total_cols;
+        // The last part starting at or before col, empty parts start where
+        // the next one does and are skipped.
+        int lo = 0;
+        int hi = num_parts - 1;
+        while(lo < hi)
+        {
+            const int mid = (lo + hi + 1) / 2;
+            if(parts[mid].col_begin <= col)
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid - 1;
+            }
+        }
+        const MultiCopyPart& part = parts[lo];
+        T* part_data = reinterpret_cast<T*>(part.data) + row * part.cols + col - part.col_begin;
+        if(kSplit)
+        {
+            *part_data = whole[index];
+        }
+        else
+        {
+            whole[index] = *part_data;
+        }
+    }
+}
+
+template <bool kSplit>
+void LaunchMultiCopy(const int unit,
+                     const int size,
+                     const int total_cols,
+                     const int num_parts,
+                     const MultiCopyPart* parts,
+                     char* whole,
+                     HIPContext* context)
+{
+#define CAFFE2_LAUNCH_MULTI_COPY(T)                                      hipLaunchKernelGGL((MultiCopyKernel<T, kSplit>),                                        dim3(CAFFE_GET_BLOCKS(size)),                                        dim3(CAFFE_HIP_NUM_THREADS),                                         0,                                                                   context->hip_stream(),                                               size,                                                                total_cols,                                                          num_parts,                                                           parts,                                                               reinterpret_cast<T*>(whole))
+    switch(unit)
+    {
+    case 8: CAFFE2_LAUNCH_MULTI_COPY(uint64_t); break;
+    case 4: CAFFE2_LAUNCH_MULTI_COPY(uint32_t); break;
+    case 2: CAFFE2_LAUNCH_MULTI_COPY(uint16_t); break;
+    default: CAFFE2_LAUNCH_MULTI_COPY(uint8_t); break;
+    }
+#undef CAFFE2_LAUNCH_MULTI_COPY
+}
+
+/**
+ * Copies the parts, given their data and widths in bytes, with a single
+ * launch. The copy goes in the widest word dividing all the widths and
+ * addresses. Returns
+ * false if the sizes don't fit the kernel's int indexing, in which case
+ * nothing is done.
+ */
+template <bool kSplit>
+bool MultiCopy(const int rows,
+               const std::vector<char*>& data,
+               const std::vector<size_t>& bytes,
+               char* whole,
+               TensorHIP* device_parts,
+               HIPContext* context)
+{
+    const size_t total_bytes = std::accumulate(bytes.begin(), bytes.end(), size_t(0));
+    if(rows == 0 || total_bytes == 0)
+    {
+        return true;
+    }
+    size_t unit = 8;
+    auto fit_unit = [&unit](size_t n) {
+        while(n % unit != 0)
+        {
+            unit /= 2;
+        }
+    };
+    fit_unit(reinterpret_cast<uintptr_t>(whole));
+    for(size_t i = 0; i < data.size(); ++i)
+    {
+        fit_unit(bytes[i]);
+        fit_unit(reinterpret_cast<uintptr_t>(data[i]));
+    }
+    const size_t total_cols = total_bytes / unit;
+    if(total_cols * rows > std::numeric_limits<int>::max())
+    {
+        return false;
+    }
+
+    std::vector<MultiCopyPart> parts(data.size());
+    int col_begin = 0;
+    for(size_t i = 0; i < data.size(); ++i)
+    {
+        parts[i].data      = data[i];
+        parts[i].cols      = bytes[i] / unit;
+        parts[i].col_begin = col_begin;
+        col_begin += parts[i].cols;
+    }
+    // The table is copied from pageable memory, which is done with by the
+    // time the copy returns; the device copy is reused in stream order.
+    const TIndex table_bytes = parts.size() * sizeof(MultiCopyPart);
+    device_parts->Resize(table_bytes);
+    context->Copy<uint8_t, CPUContext, HIPContext>(
+        table_bytes,
+        reinterpret_cast<const uint8_t*>(parts.data()),
+        device_parts->mutable_data<uint8_t>());
+    LaunchMultiCopy<kSplit>(unit,
+                            total_cols * rows,
+                            total_cols,
+                            parts.size(),
+                            reinterpret_cast<const MultiCopyPart*>(device_parts->data<uint8_t>()),
+                            whole,
+                            context);
+    return true;
+}
+} // namespace
+
+template <>
+void ConcatOp<HIPContext>::CopyInputs(int before,
+                                      int after,
+                                      int output_channels,
+                                      const int* axis_data)
+{
+    const auto& meta = Input(0).meta();
+    auto* output_data = static_cast<char*>(Output(0)->raw_mutable_data(meta));
+    if(meta.copy() == nullptr)
+    {
+        std::vector<char*> data(InputSize());
+        std::vector<size_t> bytes(InputSize());
+        for(int i = 0; i < InputSize(); ++i)
+        {
+            // The kernel only reads the inputs of a Concat.
+            data[i]  = static_cast<char*>(const_cast<void*>(Input(i).raw_data()));
+            bytes[i] = static_cast<size_t>(axis_data[i]) * after * meta.itemsize();
+        }
+        if(MultiCopy<false>(before, data, bytes, output_data, &parts_, &context_))
+        {
+            return;
+        }
+    }
+    CopyInputsOneByOne(before, after, output_channels, axis_data);
+}
+
+template <>
+void SplitOp<HIPContext>::CopyOutputs(int before, int after, const int* axis_data)
+{
+    const auto& input = Input(0);
+    if(input.meta().copy() == nullptr)
+    {
+        std::vector<char*> data(OutputSize());
+        std::vector<size_t> bytes(OutputSize());
+        for(int i = 0; i < OutputSize(); ++i)
+        {
+            data[i]  = static_cast<char*>(Output(i)->raw_mutable_data(input.meta()));
+            bytes[i] = static_cast<size_t>(add_axis_ ? 1 : axis_data[i]) * after * input.itemsize();
+        }
+        if(MultiCopy<true>(before,
+                           data,
+                           bytes,
+                           static_cast<char*>(const_cast<void*>(input.raw_data())),
+                           &parts_,
+                           &context_))
+        {
+            return;
+        }
+    }
+    CopyOutputsOneByOne(before, after, axis_data);
+}
+
 REGISTER_HIP_OPERATOR(Split, SplitOp<HIPContext>);
 REGISTER_HIP_OPERATOR(Concat, ConcatOp<HIPContext>);
 
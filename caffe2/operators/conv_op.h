@@ -19,6 +19,7 @@
 
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/core/scratch_arena.h"
 #include "caffe2/operators/conv_op_shared.h"
 #include "caffe2/operators/conv_pool_op_base.h"
 
@@ -50,7 +51,6 @@ class ConvOp final : public ConvPoolOpBase<Context> {
   bool RunOnDeviceWithOrderNHWC() override;
 
  private:
-  Tensor<Context> col_buffer_;
   Tensor<Context> bias_multiplier_;
   Tensor<Context> img_shape_device_;
   Tensor<Context> col_buffer_shape_device_;
@@ -79,7 +79,6 @@ class ConvGradientOp final : public ConvPoolOpBase<Context> {
   bool RunOnDeviceWithOrderNHWC() override;
 
  private:
-  Tensor<Context> col_buffer_;
   Tensor<Context> bias_multiplier_;
   Tensor<Context> img_shape_device_;
   Tensor<Context> col_buffer_shape_device_;
@@ -0,0 +1,164 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/conv_op_cache_miopen.h"
+
+#include <fstream>
+#include <sstream>
+
+CAFFE2_DEFINE_string(caffe2_miopen_conv_algo_cache_file,
+                     "",
+                     "If set, MIOpen convolution algorithms found by the Find step "
+                     "are loaded from and appended to this file, so that later runs "
+                     "can skip the search.");
+
+namespace caffe2 {
+
+MIOPENConvAlgoCache& MIOPENConvAlgoCache::Get()
+{
+    // New it (never delete) so that ops destroyed during static destruction
+    // can still reach the cache.
+    static auto* cache = new MIOPENConvAlgoCache();
+    return *cache;
+}
+
+MIOPENConvAlgoCache::MIOPENConvAlgoCache()
+    : cache_file_(FLAGS_caffe2_miopen_conv_algo_cache_file)
+{
+    if(!cache_file_.empty())
+    {
+        auto n = Load(cache_file_);
+        VLOG(1) << "Loaded " << n << " MIOpen conv algorithms from " << cache_file_;
+    }
+}
+
+bool MIOPENConvAlgoCache::lookup(const std::string& key, int* algo)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = algos_.find(key);
+    if(it == algos_.end())
+    {
+        return false;
+    }
+    *algo = it->second;
+    return true;
+}
+
+void MIOPENConvAlgoCache::insert(const std::string& key, int algo)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = algos_.find(key);
+    if(it != algos_.end() && it->second == algo)
+    {
+        return;
+    }
+    algos_[key] = algo;
+    if(!cache_file_.empty())
+    {
+        Append(key, algo);
+    }
+}
+
+size_t MIOPENConvAlgoCache::size()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return algos_.size();
+}
+
+void MIOPENConvAlgoCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    algos_.clear();
+}
+
+size_t MIOPENConvAlgoCache::Load(const std::string& path)
+{
+    std::ifstream in(path);
+    if(!in.is_open())
+    {
+        VLOG(1) << "MIOpen conv algorithm cache file " << path << " does not exist yet.";
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    std::string key;
+    int algo;
+    // Each line is "<key> <algo>". Later lines win, so the file can simply be
+    // appended to when a shape is re-tuned.
+    while(in >> key >> algo)
+    {
+        algos_[key] = algo;
+        ++count;
+    }
+    return count;
+}
+
+void MIOPENConvAlgoCache::Save(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ofstream out(path, std::ios::trunc);
+    CAFFE_ENFORCE(out.is_open(), "Cannot open MIOpen conv algorithm cache file ", path);
+    for(const auto& kv : algos_)
+    {
+        out << kv.first << " " << kv.second << "\n";
+    }
+}
+
+void MIOPENConvAlgoCache::Append(const std::string& key, int algo)
+{
+    std::ofstream out(cache_file_, std::ios::app);
+    if(!out.is_open())
+    {
+        LOG(WARNING) << "Cannot write MIOpen conv algorithm cache file " << cache_file_;
+        return;
+    }
+    out << key << " " << algo << "\n";
+}
+
+std::string MIOPENConvAlgoKey(const std::string& direction,
+                              const std::string& device,
+                              int data_type,
+                              const std::vector<int>& x_dims,
+                              const std::vector<int>& w_dims,
+                              const std::vector<int>& conv_args)
+{
+    std::stringstream ss;
+    ss << direction << ";";
+    // Device names may contain spaces, which the file format uses as the
+    // key / value separator.
+    for(char c : device)
+    {
+        ss << (c == ' ' ? '_' : c);
+    }
+    ss << ";" << data_type << ";x";
+    for(auto d : x_dims)
+    {
+        ss << "," << d;
+    }
+    ss << ";w";
+    for(auto d : w_dims)
+    {
+        ss << "," << d;
+    }
+    ss << ";c";
+    for(auto a : conv_args)
+    {
+        ss << "," << a;
+    }
+    return ss.str();
+}
+
+} // namespace caffe2
@@ -0,0 +1,159 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_OPERATORS_CONV_OP_CACHE_MIOPEN_H_
+#define CAFFE2_OPERATORS_CONV_OP_CACHE_MIOPEN_H_
+
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/flags.h"
+#include "caffe2/core/logging.h"
+
+CAFFE2_DECLARE_string(caffe2_miopen_conv_algo_cache_file);
+
+namespace caffe2 {
+
+/**
+ * A process-wide cache of the algorithms chosen by the MIOpen Find step.
+ *
+ * Unlike AlgorithmsCache (conv_op_cache_cudnn.h), which lives inside a single
+ * operator, this cache is shared by every MIOpen convolution in the process,
+ * so identical layers only run miopenFind*Algorithm once. The key is a string
+ * describing the direction, device, data type, tensor and convolution
+ * descriptors (see MIOPENConvAlgoKey).
+ *
+ * If --caffe2_miopen_conv_algo_cache_file is set, the cache is loaded from
+ * that file on first use, and every newly found algorithm is appended to it,
+ * so a warm restart can skip the Find step entirely.
+ */
+class MIOPENConvAlgoCache
+{
+    public:
+    static MIOPENConvAlgoCache& Get();
+
+    // Returns the algorithm stored under key, calling generatingFunc (and
+    // recording its result) when there is none yet.
+    template <typename T>
+    T getAlgorithm(const std::string& key, std::function<T()> generatingFunc)
+    {
+        int algo;
+        if(lookup(key, &algo))
+        {
+            return static_cast<T>(algo);
+        }
+        T value = generatingFunc();
+        insert(key, static_cast<int>(value));
+        return value;
+    }
+
+    bool lookup(const std::string& key, int* algo);
+    void insert(const std::string& key, int algo);
+    size_t size();
+    void clear();
+
+    // Loads the entries stored in path, overriding existing ones. Returns
+    // the number of entries read.
+    size_t Load(const std::string& path);
+    // Writes all entries to path, replacing its content.
+    void Save(const std::string& path);
+
+    private:
+    MIOPENConvAlgoCache();
+    void Append(const std::string& key, int algo);
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, int> algos_;
+    std::string cache_file_;
+    DISABLE_COPY_AND_ASSIGN(MIOPENConvAlgoCache);
+};
+
+/**
+ * A small, per-operator LRU of algorithm choices keyed by the same strings as
+ * MIOPENConvAlgoCache. It lets an op whose input shapes alternate (variable
+ * resolution inference, a trailing partial batch) switch back to the
+ * algorithm tuned for a shape without going through the shared cache.
+ */
+template <typename T>
+class MIOPENConvAlgoLRU
+{
+    public:
+    explicit MIOPENConvAlgoLRU(size_t capacity) : capacity_(capacity) {}
+
+    bool lookup(const std::string& key, T* algo)
+    {
+        auto it = index_.find(key);
+        if(it == index_.end())
+        {
+            return false;
+        }
+        // Move the entry to the front as the most recently used one.
+        entries_.splice(entries_.begin(), entries_, it->second);
+        *algo = it->second->second;
+        return true;
+    }
+
+    void insert(const std::string& key, T algo)
+    {
+        if(capacity_ == 0)
+        {
+            return;
+        }
+        auto it = index_.find(key);
+        if(it != index_.end())
+        {
+            it->second->second = algo;
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return;
+        }
+        if(entries_.size() >= capacity_)
+        {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+        }
+        entries_.emplace_front(key, algo);
+        index_[key] = entries_.begin();
+    }
+
+    size_t size() const { return entries_.size(); }
+
+    private:
+    using Entry = std::pair<std::string, T>;
+    size_t capacity_;
+    std::list<Entry> entries_;
+    std::unordered_map<std::string, typename std::list<Entry>::iterator> index_;
+};
+
+/**
+ * Builds the cache key for a MIOpen convolution. direction is one of "fwd",
+ * "bwd_data" or "bwd_weights"; device identifies the hardware (e.g. the
+ * device name); conv_args holds mode, pads, strides, dilations and group.
+ */
+std::string MIOPENConvAlgoKey(const std::string& direction,
+                              const std::string& device,
+                              int data_type,
+                              const std::vector<int>& x_dims,
+                              const std::vector<int>& w_dims,
+                              const std::vector<int>& conv_args);
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_CONV_OP_CACHE_MIOPEN_H_
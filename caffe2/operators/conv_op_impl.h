@@ -196,7 +196,8 @@ bool ConvOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
     runWithSharedBuffer<Context>(ws_, f);
   } else {
-    f(&col_buffer_);
+    auto col_buffer = context_.scratch_arena()->Borrow();
+    f(col_buffer.get());
   }
   return true;
 }
@@ -349,7 +350,8 @@ bool ConvOp<T, Context>::RunOnDeviceWithOrderNHWC() {
     if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
       runWithSharedBuffer<Context>(ws_, f);
     } else {
-      f(&col_buffer_);
+      auto col_buffer = context_.scratch_arena()->Borrow();
+      f(col_buffer.get());
     }
   }
   return true;
@@ -399,7 +401,8 @@ bool ConvGradientOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   col_buffer_shape.push_back(C / group_ * kernel_dims_size);
   col_buffer_shape.insert(
       col_buffer_shape.end(), output_dims.begin(), output_dims.end());
-  col_buffer_.Resize(col_buffer_shape);
+  auto col_buffer = context_.scratch_arena()->Borrow();
+  col_buffer->Resize(col_buffer_shape);
 
   if (kernel_.size() != 2 && img_shape_device_.size() != img_shape.size()) {
     img_shape_device_.Resize(img_shape.size());
@@ -424,7 +427,7 @@ bool ConvGradientOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   const T* Xdata = X.template data<T>();
   const T* filter_data = filter.template data<T>();
   const T* dYdata = dY.template data<T>();
-  T* col_buffer_data = col_buffer_.template mutable_data<T>();
+  T* col_buffer_data = col_buffer->template mutable_data<T>();
   T* dfilter_data = dfilter->template mutable_data<T>();
 
   // Pre-setting the gradients to zero.
@@ -602,12 +605,13 @@ bool ConvGradientOp<T, Context>::RunOnDeviceWithOrderNHWC() {
   const int output_image_size = dY.dim32(1) * dY.dim32(2);
   // The col buffer is stored in CHW order as well - kernel_dim, and the height
   // and width.
-  col_buffer_.Resize(output_image_size, kernel_dim);
+  auto col_buffer = context_.scratch_arena()->Borrow();
+  col_buffer->Resize(output_image_size, kernel_dim);
 
   const T* Xdata = X.template data<T>();
   const T* const filter_data = filter.template data<T>();
   const T* const dYdata = dY.template data<T>();
-  T* col_buffer_data = col_buffer_.template mutable_data<T>();
+  T* col_buffer_data = col_buffer->template mutable_data<T>();
   T* dfilter_data = dfilter->template mutable_data<T>();
 
   // Pre-setting the gradients to zero.
@@ -17,6 +17,7 @@
 #include "caffe2/operators/conv_op.h"
 #include "caffe2/core/context_hip.h"
 #include "caffe2/core/miopen_wrapper.h"
+#include "caffe2/operators/conv_op_cache_miopen.h"
 #include "caffe2/operators/conv_pool_op_base.h"
 
 namespace caffe2 {
@@ -26,6 +27,9 @@ namespace caffe2 {
 // something very beneficial to more recent CNN models.
 static constexpr size_t kCONV_MIOPEN_WORKSPACE_LIMIT_BYTES = 64 * 1024 * 1024;
 
+// Number of per-shape algorithm choices each op remembers.
+static constexpr int kCONV_MIOPEN_ALGO_LRU_SIZE = 8;
+
 class MIOPENConvOpBase : public ConvPoolOpBase<HIPContext>
 {
     public:
@@ -37,7 +41,10 @@ class MIOPENConvOpBase : public ConvPoolOpBase<HIPContext>
           miopen_state_(OperatorBase::GetSingleArgument<size_t>("miopen_state", 0)),
           alpha_(OperatorBase::GetSingleArgument<float>("alpha", 1.0)),
           beta_(OperatorBase::GetSingleArgument<float>("beta", 0.0)),
-          exhaustive_search_(OperatorBase::GetSingleArgument<bool>("exhaustive_search", false))
+          exhaustive_search_(OperatorBase::GetSingleArgument<bool>("exhaustive_search", false)),
+          algo_lru_size_(
+              OperatorBase::GetSingleArgument<int>("algo_lru_size", kCONV_MIOPEN_ALGO_LRU_SIZE)),
+          batched_group_conv_(OperatorBase::GetSingleArgument<bool>("batched_group_conv", true))
     {
         bool unsupportedMIOArg = false;
         // Check if the conv parameters are supported by MIOpen
@@ -76,6 +83,18 @@ class MIOPENConvOpBase : public ConvPoolOpBase<HIPContext>
                                                        stride_w(),
                                                        dilation_h(),
                                                        dilation_w()));
+
+#if CAFFE2_MIOPEN_HAS_GROUP_CONV
+        // Let MIOpen run all groups of the whole batch in a single call.
+        // Otherwise grouped convolutions fall back to one call per image and
+        // group.
+        if(batched_group_conv_ && group_ > 1)
+        {
+            MIOPEN_ENFORCE(miopenSetConvolutionGroupCount(conv_desc_, group_));
+        }
+#else
+        batched_group_conv_ = false;
+#endif
     }
 
     ~MIOPENConvOpBase()
@@ -89,7 +108,61 @@ class MIOPENConvOpBase : public ConvPoolOpBase<HIPContext>
     }
 
     protected:
+    // Key of the current descriptors in the process-wide MIOpen algorithm
+    // cache. The MIOpen version is part of the key so that a persisted cache
+    // does not outlive a library upgrade.
+    std::string AlgoCacheKey(const std::string& direction,
+                             miopenDataType_t type,
+                             const vector<int>& x_dims,
+                             const vector<int>& w_dims)
+    {
+        return MIOPENConvAlgoKey(direction,
+                                 GetDeviceProperty(context_.hip_gpu_id()).name,
+                                 type,
+                                 x_dims,
+                                 w_dims,
+                                 {static_cast<int>(miopenCompiledVersion()),
+                                  mode_,
+                                  pad_t(),
+                                  pad_l(),
+                                  stride_h(),
+                                  stride_w(),
+                                  dilation_h(),
+                                  dilation_w(),
+                                  group_});
+    }
+
+    // Returns true if the input or filter dims differ from those of the
+    // previous run, in which case the algorithms have to be picked again.
+    bool ShapeChanged(const Tensor<HIPContext>& X, const Tensor<HIPContext>& W)
+    {
+        if(X.dims() == last_X_dims_ && W.dims() == last_W_dims_)
+        {
+            return false;
+        }
+        const bool first_run = last_X_dims_.empty();
+        last_X_dims_         = X.dims();
+        last_W_dims_         = W.dims();
+        return !first_run;
+    }
+
+    // Picks the algorithm for key from the op's LRU, then from the shared
+    // cache, and only runs find (the MIOpen Find step) if both miss.
+    template <typename T>
+    T FindAlgorithm(MIOPENConvAlgoLRU<T>* lru, const std::string& key, std::function<T()> find)
+    {
+        T algo;
+        if(!lru->lookup(key, &algo))
+        {
+            algo = MIOPENConvAlgoCache::Get().getAlgorithm<T>(key, find);
+            lru->insert(key, algo);
+        }
+        return algo;
+    }
+
     MIOPENWrapper miopen_wrapper_;
+    vector<TIndex> last_X_dims_;
+    vector<TIndex> last_W_dims_;
     miopenTensorDescriptor_t bottom_desc_;
     miopenTensorDescriptor_t bias_desc_;
     miopenTensorDescriptor_t weight_desc_;
@@ -102,6 +175,8 @@ class MIOPENConvOpBase : public ConvPoolOpBase<HIPContext>
     bool exhaustive_search_;
     const float alpha_;
     const float beta_;
+    const int algo_lru_size_;
+    bool batched_group_conv_;
 };
 
 class MIOPENConvOp final : public MIOPENConvOpBase
@@ -112,22 +187,12 @@ class MIOPENConvOp final : public MIOPENConvOpBase
           requestAlgoCount_(OperatorBase::GetSingleArgument<int>("requestAlgoCount_", 1)),
           returnedAlgoCount_(OperatorBase::GetSingleArgument<int>("returnedAlgoCount_", 1)),
           bestAlgoFound_(OperatorBase::GetSingleArgument<bool>("bestAlgoFound_", false)),
-          fwdConvWs(nullptr),
           fwdConvWsSize_(0),
-          fwd_algo_(miopenConvolutionFwdAlgoGEMM)
+          fwd_algo_(miopenConvolutionFwdAlgoGEMM),
+          fwd_algo_lru_(algo_lru_size_)
     {
     }
 
-    ~MIOPENConvOp()
-    {
-        if(fwdConvWs)
-        {
-            hipFree(fwdConvWs);
-            fwdConvWs      = nullptr;
-            fwdConvWsSize_ = 0;
-        }
-    }
-
     template <typename T_X, typename T_W, typename T_B, typename MATH, typename T_Y>
     bool DoRunWithType();
     bool RunOnDevice() override;
@@ -136,9 +201,11 @@ class MIOPENConvOp final : public MIOPENConvOpBase
     const int requestAlgoCount_;
     int returnedAlgoCount_;
     bool bestAlgoFound_;
-    char* fwdConvWs;
+    // Workspace memory is taken from the MIOPENState workspace, which is
+    // shared by all ops on the same device and state index.
     size_t fwdConvWsSize_;
     miopenConvFwdAlgorithm_t fwd_algo_;
+    MIOPENConvAlgoLRU<miopenConvFwdAlgorithm_t> fwd_algo_lru_;
     // Input: X, W, b
     // Output: Y
     INPUT_TAGS(INPUT, FILTER, BIAS);
@@ -154,35 +221,20 @@ class MIOPENConvGradientOp final : public MIOPENConvOpBase
           returnedAlgoCount_(OperatorBase::GetSingleArgument<int>("returnedAlgoCount_", 1)),
           bestDataAlgoFound_(OperatorBase::GetSingleArgument<bool>("bestAlgoFound", false)),
           bestWeightAlgoFound_(OperatorBase::GetSingleArgument<bool>("bestAlgoFound", false)),
-          bwdWeightWs(nullptr),
           bwdWeightWsSize_(0),
-          bwdDataWs(nullptr),
           bwdDataWsSize_(0),
           bwd_wei_algo_(miopenConvolutionBwdWeightsAlgoGEMM),
-          bwd_data_algo_(miopenConvolutionBwdDataAlgoGEMM)
+          bwd_data_algo_(miopenConvolutionBwdDataAlgoGEMM),
+          bwd_wei_algo_lru_(algo_lru_size_),
+          bwd_data_algo_lru_(algo_lru_size_)
     {
-        OPERATOR_NEEDS_FEATURE(group_ == 1,
-                               "Group convolution not supported yet for MIOpen ConvGradient.");
+        OPERATOR_NEEDS_FEATURE(group_ == 1 || batched_group_conv_,
+                               "Group convolution for MIOpen ConvGradient needs "
+                               "miopenSetConvolutionGroupCount.");
         CAFFE_ENFORCE(!(no_bias_ && OutputSize() == 3),
                       "If bias is not present, you should not have 3 grad output.");
     }
 
-    ~MIOPENConvGradientOp()
-    {
-        if(bwdWeightWs)
-        {
-            hipFree(bwdWeightWs);
-            bwdWeightWs      = nullptr;
-            bwdWeightWsSize_ = 0;
-        }
-        if(bwdDataWs)
-        {
-            hipFree(bwdDataWs);
-            bwdDataWs      = nullptr;
-            bwdDataWsSize_ = 0;
-        }
-    }
-
     template <typename T_X,
               typename T_DY,
               typename T_W,
@@ -202,10 +254,10 @@ class MIOPENConvGradientOp final : public MIOPENConvOpBase
     bool bestWeightAlgoFound_;
     miopenConvBwdWeightsAlgorithm_t bwd_wei_algo_;
     miopenConvBwdDataAlgorithm_t bwd_data_algo_;
+    MIOPENConvAlgoLRU<miopenConvBwdWeightsAlgorithm_t> bwd_wei_algo_lru_;
+    MIOPENConvAlgoLRU<miopenConvBwdDataAlgorithm_t> bwd_data_algo_lru_;
     size_t bwdWeightWsSize_;
     size_t bwdDataWsSize_;
-    char* bwdWeightWs;
-    char* bwdDataWs;
     // input: X, W, dY
     // output: dW, db, and optionally dX
     INPUT_TAGS(INPUT, FILTER, OUTPUT_GRAD);
@@ -231,6 +283,12 @@ bool MIOPENConvOp::DoRunWithType()
     const int M = Weight.dim32(0);
     ConvPoolOpBase<HIPContext>::SetOutputSize(X, Y, M);
 
+    if(ShapeChanged(X, Weight))
+    {
+        // The algorithm and workspace size were picked for other shapes.
+        bestAlgoFound_ = false;
+    }
+
     int N = X.dim32(0);
     int C = X.dim32(1);
     int H = X.dim32(2);
@@ -251,7 +309,7 @@ bool MIOPENConvOp::DoRunWithType()
                   "If you set group, the number of output channels should be divisible "
                   "by group.");
 
-    if(group_ > 1)
+    if(group_ > 1 && !batched_group_conv_)
     {
         int group_offset_filter = Weight.size() / group_;
 
@@ -288,10 +346,11 @@ bool MIOPENConvOp::DoRunWithType()
         int group_offset_Y = M / group_ * H_out * W_out * D_out;
         int batch_offset_Y = group_offset_Y * group_;
 
+        const vector<int> x_dims{1, C / group_, H, W};
+        const vector<int> w_dims{M / group_, C / group_, kernel_h(), kernel_w()};
+
         while(!bestAlgoFound_)
         {
-            miopenConvAlgoPerf_t perf;
-
             MIOPEN_ENFORCE(
                 miopenConvolutionForwardGetWorkSpaceSize(miopen_wrapper_.inline_miopen_handle(),
                                                          weight_desc_,
@@ -300,31 +359,30 @@ bool MIOPENConvOp::DoRunWithType()
                                                          top_desc_,
                                                          &fwdConvWsSize_));
 
-            if((fwdConvWsSize_ > 0) && (fwdConvWs == nullptr))
-            {
-                HIP_CHECK(hipMalloc(&fwdConvWs, fwdConvWsSize_));
-            }
-
-            miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
-                MIOPEN_ENFORCE(
-                    miopenFindConvolutionForwardAlgorithm(state->miopen_handle(),
-                                                          bottom_desc_,
-                                                          X.template data<T_X>(),
-                                                          weight_desc_,
-                                                          Weight.template data<T_W>(),
-                                                          conv_desc_,
-                                                          top_desc_,
-                                                          Y->template mutable_data<T_Y>(),
-                                                          requestAlgoCount_,
-                                                          &returnedAlgoCount_,
-                                                          &perf,
-                                                          fwdConvWs,
-                                                          fwdConvWsSize_,
-                                                          false));
-            });
-
+            fwd_algo_ = FindAlgorithm<miopenConvFwdAlgorithm_t>(
+                &fwd_algo_lru_,
+                AlgoCacheKey("fwd", miopenTypeWrapper<T_X>::type, x_dims, w_dims), [&]() {
+                    miopenConvAlgoPerf_t perf;
+                    miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
+                        MIOPEN_ENFORCE(miopenFindConvolutionForwardAlgorithm(
+                            state->miopen_handle(),
+                            bottom_desc_,
+                            X.template data<T_X>(),
+                            weight_desc_,
+                            Weight.template data<T_W>(),
+                            conv_desc_,
+                            top_desc_,
+                            Y->template mutable_data<T_Y>(),
+                            requestAlgoCount_,
+                            &returnedAlgoCount_,
+                            &perf,
+                            state->workspace().get(fwdConvWsSize_),
+                            fwdConvWsSize_,
+                            false));
+                    });
+                    return perf.fwd_algo;
+                });
             bestAlgoFound_ = true;
-            fwd_algo_      = perf.fwd_algo;
         }
 
         for(int b = 0; b < N; b++)
@@ -345,7 +403,7 @@ bool MIOPENConvOp::DoRunWithType()
                         top_desc_,
                         Y->template mutable_data<T_Y>() + (b * batch_offset_Y) +
                             (g * group_offset_Y),
-                        fwdConvWs,
+                        state->workspace().get(fwdConvWsSize_),
                         fwdConvWsSize_));
                 });
             }
@@ -372,10 +430,10 @@ bool MIOPENConvOp::DoRunWithType()
 
         hipDeviceSynchronize();
     }
-    else // no group
+    else // whole batch, groups handled by MIOpen
     {
         MIOPEN_ENFORCE(miopenSet4dTensorDescriptor(
-            weight_desc_, miopenTypeWrapper<T_W>::type, M, C, kernel_h(), kernel_w()));
+            weight_desc_, miopenTypeWrapper<T_W>::type, M, C / group_, kernel_h(), kernel_w()));
 
         MIOPEN_ENFORCE(
             miopenSet4dTensorDescriptor(bottom_desc_, miopenTypeWrapper<T_X>::type, N, C, H, W));
@@ -392,10 +450,11 @@ bool MIOPENConvOp::DoRunWithType()
                 bias_desc_, miopenTypeWrapper<T_B>::type, 1, C_out, 1, 1));
         }
 
+        const vector<int> x_dims{N, C, H, W};
+        const vector<int> w_dims{M, C / group_, kernel_h(), kernel_w()};
+
         while(!bestAlgoFound_)
         {
-            miopenConvAlgoPerf_t perf;
-
             MIOPEN_ENFORCE(
                 miopenConvolutionForwardGetWorkSpaceSize(miopen_wrapper_.inline_miopen_handle(),
                                                          weight_desc_,
@@ -404,30 +463,30 @@ bool MIOPENConvOp::DoRunWithType()
                                                          top_desc_,
                                                          &fwdConvWsSize_));
 
-            if((fwdConvWsSize_ > 0) && (fwdConvWs == nullptr))
-            {
-                HIP_CHECK(hipMalloc(&fwdConvWs, fwdConvWsSize_));
-            }
-
-            miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
-                MIOPEN_ENFORCE(
-                    miopenFindConvolutionForwardAlgorithm(state->miopen_handle(),
-                                                          bottom_desc_,
-                                                          X.template data<T_X>(),
-                                                          weight_desc_,
-                                                          Weight.template data<T_W>(),
-                                                          conv_desc_,
-                                                          top_desc_,
-                                                          Y->template mutable_data<T_Y>(),
-                                                          requestAlgoCount_,
-                                                          &returnedAlgoCount_,
-                                                          &perf,
-                                                          fwdConvWs,
-                                                          fwdConvWsSize_,
-                                                          false));
-            });
+            fwd_algo_ = FindAlgorithm<miopenConvFwdAlgorithm_t>(
+                &fwd_algo_lru_,
+                AlgoCacheKey("fwd", miopenTypeWrapper<T_X>::type, x_dims, w_dims), [&]() {
+                    miopenConvAlgoPerf_t perf;
+                    miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
+                        MIOPEN_ENFORCE(miopenFindConvolutionForwardAlgorithm(
+                            state->miopen_handle(),
+                            bottom_desc_,
+                            X.template data<T_X>(),
+                            weight_desc_,
+                            Weight.template data<T_W>(),
+                            conv_desc_,
+                            top_desc_,
+                            Y->template mutable_data<T_Y>(),
+                            requestAlgoCount_,
+                            &returnedAlgoCount_,
+                            &perf,
+                            state->workspace().get(fwdConvWsSize_),
+                            fwdConvWsSize_,
+                            false));
+                    });
+                    return perf.fwd_algo;
+                });
             bestAlgoFound_ = true;
-            fwd_algo_      = perf.fwd_algo;
         }
 
         miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
@@ -442,7 +501,7 @@ bool MIOPENConvOp::DoRunWithType()
                                                     &beta_,
                                                     top_desc_,
                                                     Y->template mutable_data<T_Y>(),
-                                                    fwdConvWs,
+                                                    state->workspace().get(fwdConvWsSize_),
                                                     fwdConvWsSize_));
         });
 
@@ -469,7 +528,6 @@ bool MIOPENConvOp::DoRunWithType()
 
     return true;
 }
-// TODO : enable fp16 support.
 bool MIOPENConvOp::RunOnDevice()
 {
     if(Input(0).IsType<float>())
@@ -480,9 +538,17 @@ bool MIOPENConvOp::RunOnDevice()
                              float,    // Math
                              float>(); // Y
     }
+    else if(Input(0).IsType<float16>())
+    {
+        return DoRunWithType<float16,    // X
+                             float16,    // W
+                             float16,    // B
+                             float,      // Math
+                             float16>(); // Y
+    }
     else
     {
-        LOG(FATAL) << "Only float (32bit) is supported by "
+        LOG(FATAL) << "Only float (32bit) and float16 are supported by "
                    << "miopen convolution, but input " << debug_def().input(0) << " has ["
                    << Input(0).meta().name() << "]";
     }
@@ -512,6 +578,13 @@ bool MIOPENConvGradientOp::DoRunWithType()
         Weight.ndim() == 4,
         "ConvGradient/TransGradient op with MIOpen engine is supported only for 2D convolutions");
 
+    if(ShapeChanged(X, Weight))
+    {
+        // The algorithms and workspace sizes were picked for other shapes.
+        bestDataAlgoFound_   = false;
+        bestWeightAlgoFound_ = false;
+    }
+
     const int M = Weight.dim32(0);
     int N = 0, C = 0, H = 0, W = 0, D = 0, N_out = 0, C_out = 0, H_out = 0, W_out = 0, D_out = 0;
 
@@ -536,7 +609,7 @@ bool MIOPENConvGradientOp::DoRunWithType()
                   "If you set group, the number of output channels should be divisible "
                   "by group.");
 
-    if(group_ > 1)
+    if(group_ > 1 && !batched_group_conv_)
     {
         int group_offset_filter = Weight.size() / group_;
         MIOPEN_ENFORCE(miopenSet4dTensorDescriptor(weight_desc_,
@@ -568,10 +641,11 @@ bool MIOPENConvGradientOp::DoRunWithType()
         int group_offset_Y = M / group_ * H_out * W_out * D_out;
         int batch_offset_Y = group_offset_Y * group_;
 
+        const vector<int> x_dims{1, C / group_, H, W};
+        const vector<int> w_dims{M / group_, C / group_, kernel_h(), kernel_w()};
+
         while(!bestDataAlgoFound_)
         {
-            miopenConvAlgoPerf_t perf;
-
             MIOPEN_ENFORCE(miopenConvolutionBackwardDataGetWorkSpaceSize(
                 miopen_wrapper_.inline_miopen_handle(),
                 top_desc_,
@@ -580,37 +654,34 @@ bool MIOPENConvGradientOp::DoRunWithType()
                 bottom_desc_,
                 &bwdDataWsSize_));
 
-            if((bwdDataWsSize_ > 0) && (bwdDataWs == nullptr))
-            {
-                HIP_CHECK(hipMalloc(&bwdDataWs, bwdDataWsSize_));
-            }
-
-            miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
-                MIOPEN_ENFORCE(
-                    miopenFindConvolutionBackwardDataAlgorithm(state->miopen_handle(),
-                                                               top_desc_,
-                                                               dY.template data<T_DY>(),
-                                                               weight_desc_,
-                                                               Weight.template data<T_W>(),
-                                                               conv_desc_,
-                                                               bottom_desc_,
-                                                               dX->template mutable_data<T_DX>(),
-                                                               requestAlgoCount_,
-                                                               &returnedAlgoCount_,
-                                                               &perf,
-                                                               bwdDataWs,
-                                                               bwdDataWsSize_,
-                                                               false));
-
-            });
+            bwd_data_algo_ = FindAlgorithm<miopenConvBwdDataAlgorithm_t>(
+                &bwd_data_algo_lru_,
+                AlgoCacheKey("bwd_data", miopenTypeWrapper<T_X>::type, x_dims, w_dims), [&]() {
+                    miopenConvAlgoPerf_t perf;
+                    miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
+                        MIOPEN_ENFORCE(miopenFindConvolutionBackwardDataAlgorithm(
+                            state->miopen_handle(),
+                            top_desc_,
+                            dY.template data<T_DY>(),
+                            weight_desc_,
+                            Weight.template data<T_W>(),
+                            conv_desc_,
+                            bottom_desc_,
+                            dX->template mutable_data<T_DX>(),
+                            requestAlgoCount_,
+                            &returnedAlgoCount_,
+                            &perf,
+                            state->workspace().get(bwdDataWsSize_),
+                            bwdDataWsSize_,
+                            false));
+                    });
+                    return perf.bwd_data_algo;
+                });
             bestDataAlgoFound_ = true;
-            bwd_data_algo_     = perf.bwd_data_algo;
         }
 
         while(!bestWeightAlgoFound_)
         {
-            miopenConvAlgoPerf_t perf;
-
             MIOPEN_ENFORCE(miopenConvolutionBackwardWeightsGetWorkSpaceSize(
                 miopen_wrapper_.inline_miopen_handle(),
                 top_desc_,
@@ -619,30 +690,30 @@ bool MIOPENConvGradientOp::DoRunWithType()
                 weight_desc_,
                 &bwdWeightWsSize_));
 
-            if((bwdWeightWsSize_ > 0) && (bwdWeightWs == nullptr))
-            {
-                HIP_CHECK(hipMalloc(&bwdWeightWs, bwdWeightWsSize_));
-            }
-
-            miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
-                MIOPEN_ENFORCE(
-                    miopenFindConvolutionBackwardWeightsAlgorithm(state->miopen_handle(),
-                                                                  top_desc_,
-                                                                  dY.template data<T_DY>(),
-                                                                  bottom_desc_,
-                                                                  X.template data<T_X>(),
-                                                                  conv_desc_,
-                                                                  weight_desc_,
-                                                                  dW->template mutable_data<T_DW>(),
-                                                                  requestAlgoCount_,
-                                                                  &returnedAlgoCount_,
-                                                                  &perf,
-                                                                  bwdWeightWs,
-                                                                  bwdWeightWsSize_,
-                                                                  false));
-            });
+            bwd_wei_algo_ = FindAlgorithm<miopenConvBwdWeightsAlgorithm_t>(
+                &bwd_wei_algo_lru_,
+                AlgoCacheKey("bwd_weights", miopenTypeWrapper<T_X>::type, x_dims, w_dims), [&]() {
+                    miopenConvAlgoPerf_t perf;
+                    miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
+                        MIOPEN_ENFORCE(miopenFindConvolutionBackwardWeightsAlgorithm(
+                            state->miopen_handle(),
+                            top_desc_,
+                            dY.template data<T_DY>(),
+                            bottom_desc_,
+                            X.template data<T_X>(),
+                            conv_desc_,
+                            weight_desc_,
+                            dW->template mutable_data<T_DW>(),
+                            requestAlgoCount_,
+                            &returnedAlgoCount_,
+                            &perf,
+                            state->workspace().get(bwdWeightWsSize_),
+                            bwdWeightWsSize_,
+                            false));
+                    });
+                    return perf.bwd_weights_algo;
+                });
             bestWeightAlgoFound_ = true;
-            bwd_wei_algo_        = perf.bwd_weights_algo;
         }
 
         for(int b = 0; b < N; b++)
@@ -663,7 +734,7 @@ bool MIOPENConvGradientOp::DoRunWithType()
                         bottom_desc_,
                         dX->template mutable_data<T_DX>() + (b * batch_offset_X) +
                             (g * group_offset_X),
-                        bwdDataWs,
+                        state->workspace().get(bwdDataWsSize_),
                         bwdDataWsSize_));
                 });
 
@@ -680,7 +751,7 @@ bool MIOPENConvGradientOp::DoRunWithType()
                         &beta_,
                         weight_desc_,
                         dW->template mutable_data<T_DW>() + g * group_offset_filter,
-                        bwdWeightWs,
+                        state->workspace().get(bwdWeightWsSize_),
                         bwdWeightWsSize_));
                 });
             }
@@ -705,10 +776,10 @@ bool MIOPENConvGradientOp::DoRunWithType()
             });
         }
     }
-    else // No group
+    else // whole batch, groups handled by MIOpen
     {
         MIOPEN_ENFORCE(miopenSet4dTensorDescriptor(
-            weight_desc_, miopenTypeWrapper<T_X>::type, M, C, kernel_h(), kernel_w()));
+            weight_desc_, miopenTypeWrapper<T_X>::type, M, C / group_, kernel_h(), kernel_w()));
 
         MIOPEN_ENFORCE(
             miopenSet4dTensorDescriptor(bottom_desc_, miopenTypeWrapper<T_X>::type, N, C, H, W));
@@ -725,10 +796,11 @@ bool MIOPENConvGradientOp::DoRunWithType()
                 miopenSet4dTensorDescriptor(bias_desc_, miopenTypeWrapper<T_B>::type, 1, M, 1, 1));
         }
 
+        const vector<int> x_dims{N, C, H, W};
+        const vector<int> w_dims{M, C / group_, kernel_h(), kernel_w()};
+
         while(!bestDataAlgoFound_)
         {
-            miopenConvAlgoPerf_t perf;
-
             MIOPEN_ENFORCE(miopenConvolutionBackwardDataGetWorkSpaceSize(
                 miopen_wrapper_.inline_miopen_handle(),
                 top_desc_,
@@ -737,38 +809,34 @@ bool MIOPENConvGradientOp::DoRunWithType()
                 bottom_desc_,
                 &bwdDataWsSize_));
 
-            if((bwdDataWsSize_ > 0) && (bwdDataWs == nullptr))
-            {
-                HIP_CHECK(hipMalloc(&bwdDataWs, bwdDataWsSize_));
-            }
-
-            miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
-                MIOPEN_ENFORCE(
-                    miopenFindConvolutionBackwardDataAlgorithm(state->miopen_handle(),
-                                                               top_desc_,
-                                                               dY.template data<T_DY>(),
-                                                               weight_desc_,
-                                                               Weight.template data<T_W>(),
-                                                               conv_desc_,
-                                                               bottom_desc_,
-                                                               dX->template mutable_data<T_DX>(),
-                                                               requestAlgoCount_,
-                                                               &returnedAlgoCount_,
-                                                               &perf,
-                                                               bwdDataWs,
-                                                               bwdDataWsSize_,
-                                                               false));
-
-            });
-
+            bwd_data_algo_ = FindAlgorithm<miopenConvBwdDataAlgorithm_t>(
+                &bwd_data_algo_lru_,
+                AlgoCacheKey("bwd_data", miopenTypeWrapper<T_X>::type, x_dims, w_dims), [&]() {
+                    miopenConvAlgoPerf_t perf;
+                    miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
+                        MIOPEN_ENFORCE(miopenFindConvolutionBackwardDataAlgorithm(
+                            state->miopen_handle(),
+                            top_desc_,
+                            dY.template data<T_DY>(),
+                            weight_desc_,
+                            Weight.template data<T_W>(),
+                            conv_desc_,
+                            bottom_desc_,
+                            dX->template mutable_data<T_DX>(),
+                            requestAlgoCount_,
+                            &returnedAlgoCount_,
+                            &perf,
+                            state->workspace().get(bwdDataWsSize_),
+                            bwdDataWsSize_,
+                            false));
+                    });
+                    return perf.bwd_data_algo;
+                });
             bestDataAlgoFound_ = true;
-            bwd_data_algo_     = perf.bwd_data_algo;
         }
 
         while(!bestWeightAlgoFound_)
         {
-            miopenConvAlgoPerf_t perf;
-
             MIOPEN_ENFORCE(miopenConvolutionBackwardWeightsGetWorkSpaceSize(
                 miopen_wrapper_.inline_miopen_handle(),
                 top_desc_,
@@ -777,31 +845,30 @@ bool MIOPENConvGradientOp::DoRunWithType()
                 weight_desc_,
                 &bwdWeightWsSize_));
 
-            if((bwdWeightWsSize_ > 0) && (bwdWeightWs == nullptr))
-            {
-                HIP_CHECK(hipMalloc(&bwdWeightWs, bwdWeightWsSize_));
-            }
-
-            miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
-                MIOPEN_ENFORCE(
-                    miopenFindConvolutionBackwardWeightsAlgorithm(state->miopen_handle(),
-                                                                  top_desc_,
-                                                                  dY.template data<T_DY>(),
-                                                                  bottom_desc_,
-                                                                  X.template data<T_X>(),
-                                                                  conv_desc_,
-                                                                  weight_desc_,
-                                                                  dW->template mutable_data<T_DW>(),
-                                                                  requestAlgoCount_,
-                                                                  &returnedAlgoCount_,
-                                                                  &perf,
-                                                                  bwdWeightWs,
-                                                                  bwdWeightWsSize_,
-                                                                  false));
-            });
-
+            bwd_wei_algo_ = FindAlgorithm<miopenConvBwdWeightsAlgorithm_t>(
+                &bwd_wei_algo_lru_,
+                AlgoCacheKey("bwd_weights", miopenTypeWrapper<T_X>::type, x_dims, w_dims), [&]() {
+                    miopenConvAlgoPerf_t perf;
+                    miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
+                        MIOPEN_ENFORCE(miopenFindConvolutionBackwardWeightsAlgorithm(
+                            state->miopen_handle(),
+                            top_desc_,
+                            dY.template data<T_DY>(),
+                            bottom_desc_,
+                            X.template data<T_X>(),
+                            conv_desc_,
+                            weight_desc_,
+                            dW->template mutable_data<T_DW>(),
+                            requestAlgoCount_,
+                            &returnedAlgoCount_,
+                            &perf,
+                            state->workspace().get(bwdWeightWsSize_),
+                            bwdWeightWsSize_,
+                            false));
+                    });
+                    return perf.bwd_weights_algo;
+                });
             bestWeightAlgoFound_ = true;
-            bwd_wei_algo_        = perf.bwd_weights_algo;
         }
 
         miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
@@ -816,7 +883,7 @@ bool MIOPENConvGradientOp::DoRunWithType()
                                                          &beta_,
                                                          bottom_desc_,
                                                          dX->template mutable_data<T_DX>(),
-                                                         bwdDataWs,
+                                                         state->workspace().get(bwdDataWsSize_),
                                                          bwdDataWsSize_));
         });
 
@@ -832,7 +899,7 @@ bool MIOPENConvGradientOp::DoRunWithType()
                                                             &beta_,
                                                             weight_desc_,
                                                             dW->template mutable_data<T_DW>(),
-                                                            bwdWeightWs,
+                                                            state->workspace().get(bwdWeightWsSize_),
                                                             bwdWeightWsSize_));
         });
 
@@ -872,6 +939,17 @@ bool MIOPENConvGradientOp::RunOnDevice()
                              float,    // dW
                              float>(); // db
     }
+    else if(Input(0).IsType<float16>())
+    {
+        return DoRunWithType<float16,    //  X
+                             float16,    // dY
+                             float16,    //  W
+                             float16,    //  b
+                             float,      // Math
+                             float16,    // dX
+                             float16,    // dW
+                             float16>(); // db
+    }
     else
     {
         LOG(FATAL) << "Unsupported input types";
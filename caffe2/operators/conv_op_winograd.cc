@@ -0,0 +1,448 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Conv engine for CPU servers, for the shapes that dominate vision models:
+// 3x3 stride 1 convolutions run as Winograd F(4x4, 3x3) and 1x1 stride 1 ones
+// as one GEMM per image, neither materializing an im2col buffer.
+//
+// For F(4x4, 3x3), the output is cut in 4x4 tiles, each one computed from a
+// 6x6 input tile d and a 3x3 filter g as
+//
+//   Y = A^T [(G g G^T) . (B^T d B)] A,
+//
+// where . is the elementwise product. Summed over input channels, the 36
+// elementwise products become 36 independent GEMMs with M x C filters and
+// C x tiles inputs. Tiles are processed in blocks sized to stay in cache, the
+// blocks are spread over the intra-op threads of CPUContext::ParallelFor and
+// the transformed filter is cached across runs.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+constexpr int kTile = 4;
+constexpr int kAlpha = kTile + 2;
+constexpr int kPositions = kAlpha * kAlpha;
+
+// Floats of transformed inputs and outputs per block, and bounds on the
+// number of tiles per block so that the GEMMs stay efficient.
+constexpr size_t kBlockFloats = 1 << 18;
+constexpr int kMinBlockTiles = 32;
+constexpr int kMaxBlockTiles = 512;
+
+// Number of filter elements folded into the fingerprint checked on every run.
+constexpr size_t kFingerprintSamples = 64;
+
+// u = G g for a column g of 3 taps (strided by gs), u of 6 values.
+inline void FilterTransform1D(const float* g, int gs, float* u, int us) {
+  const float g0 = g[0], g1 = g[gs], g2 = g[2 * gs];
+  u[0] = g0 * (1.f / 4);
+  u[us] = (g0 + g1 + g2) * (-1.f / 6);
+  u[2 * us] = (g0 - g1 + g2) * (-1.f / 6);
+  u[3 * us] = g0 * (1.f / 24) + g1 * (1.f / 12) + g2 * (1.f / 6);
+  u[4 * us] = g0 * (1.f / 24) - g1 * (1.f / 12) + g2 * (1.f / 6);
+  u[5 * us] = g2;
+}
+
+// v = B^T d for a column d of 6 values.
+inline void InputTransform1D(const float* d, int ds, float* v, int vs) {
+  const float d0 = d[0], d1 = d[ds], d2 = d[2 * ds], d3 = d[3 * ds],
+              d4 = d[4 * ds], d5 = d[5 * ds];
+  v[0] = 4 * d0 - 5 * d2 + d4;
+  v[vs] = -4 * (d1 + d2) + d3 + d4;
+  v[2 * vs] = 4 * (d1 - d2) - d3 + d4;
+  v[3 * vs] = 2 * (d3 - d1) - d2 + d4;
+  v[4 * vs] = 2 * (d1 - d3) - d2 + d4;
+  v[5 * vs] = 4 * d1 - 5 * d3 + d5;
+}
+
+// y = A^T m for a column m of 6 values, y of 4 values.
+inline void OutputTransform1D(const float* m, int ms, float* y, int ys) {
+  const float m0 = m[0], m1 = m[ms], m2 = m[2 * ms], m3 = m[3 * ms],
+              m4 = m[4 * ms], m5 = m[5 * ms];
+  const float s12 = m1 + m2, d12 = m1 - m2;
+  const float s34 = m3 + m4, d34 = m3 - m4;
+  y[0] = m0 + s12 + s34;
+  y[ys] = d12 + 2 * d34;
+  y[2 * ys] = s12 + 4 * s34;
+  y[3 * ys] = d12 + 8 * d34 + m5;
+}
+
+// Writes the 36 values of G g G^T for the 3x3 filter g to u[p * stride].
+void TransformFilter(const float* g, float* u, size_t stride) {
+  float t[kAlpha * 3];
+  for (int j = 0; j < 3; ++j) {
+    FilterTransform1D(g + j, 3, t + j, 3);
+  }
+  float r[kPositions];
+  for (int i = 0; i < kAlpha; ++i) {
+    FilterTransform1D(t + i * 3, 1, r + i * kAlpha, 1);
+  }
+  for (int p = 0; p < kPositions; ++p) {
+    u[p * stride] = r[p];
+  }
+}
+
+// Writes the 36 values of B^T d B to v[p * stride], for the 6x6 tile d of
+// the H x W image x at (h0, w0), zero outside of the image.
+void TransformInput(
+    const float* x,
+    int H,
+    int W,
+    int h0,
+    int w0,
+    float* v,
+    size_t stride) {
+  float d[kPositions];
+  const float* src = d;
+  int ld = kAlpha;
+  if (h0 >= 0 && w0 >= 0 && h0 + kAlpha <= H && w0 + kAlpha <= W) {
+    src = x + h0 * W + w0;
+    ld = W;
+  } else {
+    for (int i = 0; i < kAlpha; ++i) {
+      const int h = h0 + i;
+      for (int j = 0; j < kAlpha; ++j) {
+        const int w = w0 + j;
+        d[i * kAlpha + j] =
+            (h >= 0 && h < H && w >= 0 && w < W) ? x[h * W + w] : 0.f;
+      }
+    }
+  }
+  float t[kPositions];
+  for (int j = 0; j < kAlpha; ++j) {
+    InputTransform1D(src + j, ld, t + j, kAlpha);
+  }
+  float r[kPositions];
+  for (int i = 0; i < kAlpha; ++i) {
+    InputTransform1D(t + i * kAlpha, 1, r + i * kAlpha, 1);
+  }
+  for (int p = 0; p < kPositions; ++p) {
+    v[p * stride] = r[p];
+  }
+}
+
+// Computes the 4x4 tile A^T m A + bias from the 36 values m[p * stride] and
+// writes its part inside the oH x oW image y at (h0, w0).
+void TransformOutput(
+    const float* m,
+    size_t stride,
+    float bias,
+    float* y,
+    int oH,
+    int oW,
+    int h0,
+    int w0) {
+  float s[kPositions];
+  for (int p = 0; p < kPositions; ++p) {
+    s[p] = m[p * stride];
+  }
+  float t[kTile * kAlpha];
+  for (int j = 0; j < kAlpha; ++j) {
+    OutputTransform1D(s + j, kAlpha, t + j, kAlpha);
+  }
+  float r[kTile * kTile];
+  for (int i = 0; i < kTile; ++i) {
+    OutputTransform1D(t + i * kAlpha, 1, r + i * kTile, 1);
+  }
+  const int rows = std::min(kTile, oH - h0);
+  const int cols = std::min(kTile, oW - w0);
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) {
+      y[(h0 + i) * oW + w0 + j] = r[i * kTile + j] + bias;
+    }
+  }
+}
+
+uint64_t MixIn(uint64_t hash, float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  hash ^= bits;
+  return hash * 0x100000001b3ULL;
+}
+
+// Hashes kFingerprintSamples evenly spaced elements, including the first and
+// the last one.
+uint64_t Fingerprint(const float* ptr, size_t n) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  const size_t samples = std::min(n, kFingerprintSamples);
+  for (size_t i = 0; i < samples; ++i) {
+    hash = MixIn(hash, ptr[samples > 1 ? i * (n - 1) / (samples - 1) : 0]);
+  }
+  return hash;
+}
+
+} // namespace
+
+class WinogradConvOp final : public ConvPoolOpBase<CPUContext> {
+ public:
+  USE_CONV_POOL_BASE_FUNCTIONS(CPUContext);
+  WinogradConvOp(const OperatorDef& operator_def, Workspace* ws)
+      : ConvPoolOpBase<CPUContext>(operator_def, ws) {
+    OPERATOR_NEEDS_FEATURE(
+        order_ == StorageOrder::NCHW,
+        "The Winograd convolution only supports NCHW order.");
+    OPERATOR_NEEDS_FEATURE(
+        kernel_.size() == 2, "The Winograd convolution only supports 2D.");
+    OPERATOR_NEEDS_FEATURE(
+        stride_h() == 1 && stride_w() == 1 && dilation_h() == 1 &&
+            dilation_w() == 1,
+        "The Winograd convolution only supports stride 1 and no dilation.");
+    is_1x1_ = kernel_h() == 1 && kernel_w() == 1;
+    OPERATOR_NEEDS_FEATURE(
+        is_1x1_ || (kernel_h() == 3 && kernel_w() == 3),
+        "The Winograd convolution only supports 3x3 and 1x1 kernels.");
+    OPERATOR_NEEDS_FEATURE(
+        !is_1x1_ ||
+            std::all_of(
+                pads_.begin(), pads_.end(), [](int p) { return p == 0; }),
+        "The Winograd convolution does not pad 1x1 kernels.");
+  }
+  ~WinogradConvOp() {}
+
+  bool RunOnDeviceWithOrderNCHW() override {
+    const auto& X = Input(INPUT);
+    const auto& filter = Input(FILTER);
+    auto* Y = Output(0);
+    CAFFE_ENFORCE_EQ(X.ndim(), 4);
+    CAFFE_ENFORCE_EQ(filter.ndim(), 4);
+    const int C = X.dim32(1);
+    const int M = filter.dim32(0);
+    CAFFE_ENFORCE_EQ(C % group_, 0);
+    CAFFE_ENFORCE_EQ(M % group_, 0);
+    CAFFE_ENFORCE_EQ(filter.dim32(1), C / group_);
+    CAFFE_ENFORCE_EQ(filter.dim32(2), kernel_h());
+    CAFFE_ENFORCE_EQ(filter.dim32(3), kernel_w());
+    const float* bias = nullptr;
+    if (InputSize() == 3) {
+      const auto& b = Input(BIAS);
+      CAFFE_ENFORCE_EQ(b.ndim(), 1);
+      CAFFE_ENFORCE_EQ(b.dim32(0), M);
+      bias = b.data<float>();
+    }
+    ConvPoolOpBase<CPUContext>::SetOutputSize(X, Y, M);
+    if (Y->size() == 0) {
+      Y->mutable_data<float>();
+      return true;
+    }
+    if (is_1x1_) {
+      RunConv1x1(X, filter, bias, Y);
+    } else {
+      RunWinograd(X, filter, bias, Y);
+    }
+    return true;
+  }
+
+ private:
+  // Y[n] = W * X[n] per group, the input being its own column buffer.
+  void RunConv1x1(
+      const TensorCPU& X,
+      const TensorCPU& filter,
+      const float* bias,
+      TensorCPU* Y) {
+    const int N = X.dim32(0), C = X.dim32(1);
+    const int HW = X.dim32(2) * X.dim32(3);
+    const int M = filter.dim32(0);
+    const int C_g = C / group_, M_g = M / group_;
+    const float* Xdata = X.data<float>();
+    const float* Wdata = filter.data<float>();
+    float* Ydata = Y->mutable_data<float>();
+    for (int n = 0; n < N; ++n) {
+      for (int g = 0; g < group_; ++g) {
+        math::Gemm<float, CPUContext>(
+            CblasNoTrans,
+            CblasNoTrans,
+            M_g,
+            HW,
+            C_g,
+            1,
+            Wdata + static_cast<size_t>(g) * M_g * C_g,
+            Xdata + (static_cast<size_t>(n) * C + g * C_g) * HW,
+            0,
+            Ydata + (static_cast<size_t>(n) * M + g * M_g) * HW,
+            &context_);
+      }
+    }
+    if (bias) {
+      CPUContext::ParallelFor(
+          static_cast<size_t>(N) * M,
+          std::max<size_t>((1 << 16) / HW, 1),
+          [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+              const float b = bias[i % M];
+              float* y = Ydata + i * HW;
+              for (int k = 0; k < HW; ++k) {
+                y[k] += b;
+              }
+            }
+          });
+    }
+  }
+
+  // Transforms the filter into U[g][p][m][c], unless it is the one of the
+  // previous run.
+  void TransformFilters(const TensorCPU& filter) {
+    const float* data = filter.data<float>();
+    const uint64_t fingerprint = Fingerprint(data, filter.size());
+    if (data == filter_source_ && filter.dims() == filter_dims_ &&
+        fingerprint == filter_fingerprint_) {
+      return;
+    }
+    const int M = filter.dim32(0), C_g = filter.dim32(1);
+    const int M_g = M / group_;
+    const size_t stride = static_cast<size_t>(M_g) * C_g;
+    transformed_filter_.Resize(
+        vector<TIndex>{group_, kPositions, M_g, C_g});
+    float* U = transformed_filter_.mutable_data<float>();
+    for (int g = 0; g < group_; ++g) {
+      for (int m = 0; m < M_g; ++m) {
+        for (int c = 0; c < C_g; ++c) {
+          TransformFilter(
+              data + ((static_cast<size_t>(g) * M_g + m) * C_g + c) * 9,
+              U + g * kPositions * stride + m * C_g + c,
+              stride);
+        }
+      }
+    }
+    filter_source_ = data;
+    filter_dims_ = filter.dims();
+    filter_fingerprint_ = fingerprint;
+  }
+
+  void RunWinograd(
+      const TensorCPU& X,
+      const TensorCPU& filter,
+      const float* bias,
+      TensorCPU* Y) {
+    const int N = X.dim32(0), C = X.dim32(1), H = X.dim32(2), W = X.dim32(3);
+    const int M = filter.dim32(0);
+    const int oH = Y->dim32(2), oW = Y->dim32(3);
+    const int C_g = C / group_, M_g = M / group_;
+    TransformFilters(filter);
+
+    const int tiles_h = (oH + kTile - 1) / kTile;
+    const int tiles_w = (oW + kTile - 1) / kTile;
+    const int image_tiles = tiles_h * tiles_w;
+    const int tiles = N * image_tiles;
+    const int block_tiles = std::min(
+        tiles,
+        std::max(
+            kMinBlockTiles,
+            std::min<int>(
+                kMaxBlockTiles, kBlockFloats / (kPositions * (C_g + M_g)))));
+    const int blocks = (tiles + block_tiles - 1) / block_tiles;
+
+    const float* Xdata = X.data<float>();
+    const float* U = transformed_filter_.data<float>();
+    float* Ydata = Y->mutable_data<float>();
+    const int pad_top = pad_t(), pad_left = pad_l();
+
+    // Every job is a block of tiles of one group, on a thread that keeps its
+    // transformed inputs and outputs in cache from one step to the next.
+    CPUContext::ParallelFor(
+        static_cast<size_t>(blocks) * group_,
+        1,
+        [&](size_t begin, size_t end) {
+          CPUContext context;
+          std::vector<float> V(
+              static_cast<size_t>(kPositions) * C_g * block_tiles);
+          std::vector<float> O(
+              static_cast<size_t>(kPositions) * M_g * block_tiles);
+          for (size_t job = begin; job < end; ++job) {
+            const int g = job / blocks;
+            const int t0 = (job % blocks) * block_tiles;
+            const int nt = std::min(block_tiles, tiles - t0);
+            const size_t v_stride = static_cast<size_t>(C_g) * nt;
+            const size_t o_stride = static_cast<size_t>(M_g) * nt;
+            for (int t = 0; t < nt; ++t) {
+              const int n = (t0 + t) / image_tiles;
+              const int tile = (t0 + t) % image_tiles;
+              const int h0 = (tile / tiles_w) * kTile - pad_top;
+              const int w0 = (tile % tiles_w) * kTile - pad_left;
+              const float* x =
+                  Xdata + (static_cast<size_t>(n) * C + g * C_g) * H * W;
+              for (int c = 0; c < C_g; ++c) {
+                TransformInput(
+                    x + static_cast<size_t>(c) * H * W,
+                    H,
+                    W,
+                    h0,
+                    w0,
+                    V.data() + c * nt + t,
+                    v_stride);
+              }
+            }
+            const float* U_g =
+                U + static_cast<size_t>(g) * kPositions * M_g * C_g;
+            for (int p = 0; p < kPositions; ++p) {
+              math::Gemm<float, CPUContext>(
+                  CblasNoTrans,
+                  CblasNoTrans,
+                  M_g,
+                  nt,
+                  C_g,
+                  1,
+                  U_g + static_cast<size_t>(p) * M_g * C_g,
+                  V.data() + p * v_stride,
+                  0,
+                  O.data() + p * o_stride,
+                  &context);
+            }
+            for (int t = 0; t < nt; ++t) {
+              const int n = (t0 + t) / image_tiles;
+              const int tile = (t0 + t) % image_tiles;
+              const int h0 = (tile / tiles_w) * kTile;
+              const int w0 = (tile % tiles_w) * kTile;
+              for (int m = 0; m < M_g; ++m) {
+                const int channel = g * M_g + m;
+                TransformOutput(
+                    O.data() + m * nt + t,
+                    o_stride,
+                    bias ? bias[channel] : 0.f,
+                    Ydata + (static_cast<size_t>(n) * M + channel) * oH * oW,
+                    oH,
+                    oW,
+                    h0,
+                    w0);
+              }
+            }
+          }
+        });
+  }
+
+  bool is_1x1_;
+  TensorCPU transformed_filter_;
+  const float* filter_source_{nullptr};
+  vector<TIndex> filter_dims_;
+  uint64_t filter_fingerprint_{0};
+
+  INPUT_TAGS(INPUT, FILTER, BIAS);
+};
+
+REGISTER_CPU_OPERATOR_WITH_ENGINE(Conv, WINOGRAD, WinogradConvOp);
+REGISTER_CPU_OPERATOR_WITH_ENGINE(Conv2D, WINOGRAD, WinogradConvOp);
+
+} // namespace caffe2
@@ -59,9 +59,7 @@ class ConvPoolOpBase : public Operator<Context> {
             OperatorBase::GetSingleArgument<string>("order", "NCHW"))),
         shared_buffer_(
             OperatorBase::GetSingleArgument<int>("shared_buffer", 0)),
-        ws_(ws),
-        poolWs_(nullptr)
-  {
+        ws_(ws) {
     // For the padding, they should either be the legacy padding strategy
     // (VALID or SAME), or an explicit, non-negative value.
     if (legacy_pad_ == LegacyPadding::VALID ||
@@ -386,28 +384,53 @@ class ConvPoolOpBase : public Operator<Context> {
     const auto order =
         StringToStorageOrder(helper.GetSingleArgument<string>("order", "NCHW"));
 
-    unsigned long long Y_h;
-    unsigned long long Y_w;
-    unsigned long long kernel_h;
-    unsigned long long kernel_w;
-    unsigned long long in_channels;
-    unsigned long long out_channels;
-    if (order == StorageOrder::NHWC) {
-      Y_h = Y.dims(1);
-      Y_w = Y.dims(2);
-      kernel_h = W.dims(1);
-      kernel_w = W.dims(2);
-      in_channels = W.dims(3);
-      out_channels = W.dims(0);
+    // Every output point takes 2 flops per filter element, of which there
+    // are kernel size times input channels per group.
+    const int spatial_start = order == StorageOrder::NHWC ? 1 : 2;
+    const int spatial_end =
+        order == StorageOrder::NHWC ? W.dims_size() - 1 : W.dims_size();
+    unsigned long long kernel_size = 1;
+    for (int i = spatial_start; i < spatial_end; ++i) {
+      kernel_size *= W.dims(i);
+    }
+    const unsigned long long in_channels =
+        order == StorageOrder::NHWC ? W.dims(W.dims_size() - 1) : W.dims(1);
+    c.flops = nElemFromShape(Y) * kernel_size * in_channels * 2;
+    c.bytes_moved =
+        nBytesFromShape(X) + nBytesFromShape(W) + nBytesFromShape(Y);
+    if (inputs.size() > 2) {
+      c.bytes_moved += nBytesFromShape(inputs[2]);
+    }
+    return c;
+  }
+
+  static struct OpSchema::Cost CostInferenceForPool(
+      const OperatorDef& def,
+      const vector<TensorShape>& inputs) {
+    struct OpSchema::Cost c;
+    const TensorShape X = inputs[0];
+    const TensorShape Y = TensorInferenceForPool(def, inputs)[0];
+
+    // Every output point reads and combines a kernel of input points.
+    ArgumentHelper helper(def);
+    unsigned long long kernel_size = 1;
+    if (helper.GetSingleArgument<int>("global_pooling", 0)) {
+      kernel_size =
+          nElemFromShape(X) / std::max<uint64_t>(nElemFromShape(Y), 1);
+    } else if (helper.HasArgument("kernel")) {
+      const int kernel = helper.GetSingleArgument<int>("kernel", 1);
+      kernel_size = kernel * kernel;
+    } else if (
+        helper.HasArgument("kernel_h") && helper.HasArgument("kernel_w")) {
+      kernel_size = helper.GetSingleArgument<int>("kernel_h", 1) *
+          helper.GetSingleArgument<int>("kernel_w", 1);
     } else {
-      Y_h = Y.dims(2);
-      Y_w = Y.dims(3);
-      kernel_h = W.dims(2);
-      kernel_w = W.dims(3);
-      in_channels = W.dims(1);
-      out_channels = W.dims(0);
+      for (const int kernel : helper.GetRepeatedArgument<int>("kernels")) {
+        kernel_size *= kernel;
+      }
     }
-    c.flops = Y_h * Y_w * kernel_w * kernel_h * in_channels * out_channels * 2;
+    c.flops = nElemFromShape(Y) * kernel_size;
+    c.bytes_moved = nBytesFromShape(X) + nBytesFromShape(Y);
     return c;
   }
 
@@ -517,12 +540,7 @@ class ConvPoolOpBase : public Operator<Context> {
    return TensorInferenceForSchema(def, in, num_channels);
  }
 
- virtual ~ConvPoolOpBase() {
-   if(poolWs_ != nullptr) {
-     hipFree(poolWs_);
-     poolWs_ = nullptr;
-   }
- }
+ virtual ~ConvPoolOpBase() {}
 
 protected:
  LegacyPadding legacy_pad_;
@@ -542,7 +560,6 @@ protected:
  StorageOrder order_;
  bool shared_buffer_;
  Workspace* ws_;
- char* poolWs_;
 
  static inline void ComputeSizeAndPad(
      const int in_size,
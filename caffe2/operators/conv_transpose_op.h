@@ -19,6 +19,7 @@
 
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/core/scratch_arena.h"
 #include "caffe2/operators/conv_transpose_unpool_op_base.h"
 
 namespace caffe2 {
@@ -34,7 +35,10 @@ class ConvTransposeOp final : public ConvTransposeUnpoolBase<Context> {
   bool RunOnDeviceWithOrderNHWC() override;
 
  private:
-  Tensor<Context> col_buffer_;
+  // Computes the already sized NCHW output straight from the input, without
+  // col buffer, or returns false if Context has no such implementation.
+  bool RunWithoutColBuffer();
+
   Tensor<Context> bias_multiplier_;
   // Input: X, W, b
   // Output: Y
@@ -57,7 +61,6 @@ class ConvTransposeGradientOp final : public ConvTransposeUnpoolBase<Context> {
   bool RunOnDeviceWithOrderNHWC() override;
 
  private:
-  Tensor<Context> col_buffer_;
   Tensor<Context> bias_multiplier_;
   const bool no_bias_;
   // input: X, W, dY
@@ -17,8 +17,104 @@
 #include "caffe2/core/context_hip.h"
 #include "caffe2/operators/conv_transpose_op.h"
 #include "caffe2/operators/conv_transpose_op_impl.h"
+#include "caffe2/operators/implicit_gemm_conv_hip.h"
 
 namespace caffe2 {
+
+namespace {
+
+// The transposed convolution of one image as an implicit GEMM: z is the
+// image, m the output channel, k the (input channel, kernel row, kernel
+// column) and p the output position. B(k, p) is the input element that the
+// col2im of the col buffer would add to p, if any.
+struct ConvTransposeLoader
+{
+    const float* X;
+    const float* filter;
+    const float* bias;
+    float* Y;
+    int input_channels;
+    int output_channels;
+    int height;
+    int width;
+    int output_height;
+    int output_width;
+    int kernel_h;
+    int kernel_w;
+    int pad_t;
+    int pad_l;
+    int stride_h;
+    int stride_w;
+
+    __device__ float A(const int /* z */, const int m, const int k) const
+    {
+        const int kernel_size = kernel_h * kernel_w;
+        return filter[((k / kernel_size) * output_channels + m) * kernel_size + k % kernel_size];
+    }
+
+    __device__ float B(const int z, const int k, const int p) const
+    {
+        const int c  = k / (kernel_h * kernel_w);
+        const int i  = (k / kernel_w) % kernel_h;
+        const int j  = k % kernel_w;
+        const int th = p / output_width + pad_t - i;
+        const int tw = p % output_width + pad_l - j;
+        if(th < 0 || tw < 0 || th % stride_h != 0 || tw % stride_w != 0)
+        {
+            return 0.f;
+        }
+        const int h = th / stride_h;
+        const int w = tw / stride_w;
+        if(h >= height || w >= width)
+        {
+            return 0.f;
+        }
+        return X[((z * input_channels + c) * height + h) * width + w];
+    }
+
+    __device__ void Store(const int z, const int m, const int p, const float value) const
+    {
+        Y[(z * output_channels + m) * output_height * output_width + p] =
+            bias ? value + bias[m] : value;
+    }
+};
+
+} // namespace
+
+template <>
+bool ConvTransposeOp<float, HIPContext>::RunWithoutColBuffer()
+{
+    const auto& X      = Input(INPUT);
+    const auto& filter = Input(FILTER);
+    auto* Y            = Output(0);
+
+    ConvTransposeLoader loader;
+    loader.X               = X.data<float>();
+    loader.filter          = filter.data<float>();
+    loader.bias            = InputSize() == 3 ? Input(BIAS).data<float>() : nullptr;
+    loader.Y               = Y->mutable_data<float>();
+    loader.input_channels  = X.dim32(1);
+    loader.output_channels = filter.dim32(1);
+    loader.height          = X.dim32(2);
+    loader.width           = X.dim32(3);
+    loader.output_height   = Y->dim32(2);
+    loader.output_width    = Y->dim32(3);
+    loader.kernel_h        = kernel_h();
+    loader.kernel_w        = kernel_w();
+    loader.pad_t           = pad_t();
+    loader.pad_l           = pad_l();
+    loader.stride_h        = stride_h();
+    loader.stride_w        = stride_w();
+
+    implicit_gemm::ImplicitGemm(X.dim32(0),
+                                loader.output_channels,
+                                loader.output_height * loader.output_width,
+                                loader.input_channels * kernel_h() * kernel_w(),
+                                loader,
+                                &context_);
+    return true;
+}
+
 REGISTER_HIP_OPERATOR(ConvTranspose, ConvTransposeOp<float, HIPContext>);
 REGISTER_HIP_OPERATOR(ConvTransposeGradient, ConvTransposeGradientOp<float, HIPContext>);
 } // namespace caffe2
@@ -31,6 +31,11 @@ CAFFE2_DECLARE_bool(caffe2_force_shared_col_buffer);
 
 namespace caffe2 {
 
+template <typename T, class Context>
+bool ConvTransposeOp<T, Context>::RunWithoutColBuffer() {
+  return false;
+}
+
 template <typename T, class Context>
 bool ConvTransposeOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   const Tensor<Context>& X = Input(INPUT);
@@ -73,6 +78,10 @@ bool ConvTransposeOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   }
 #endif // !__ARM_NEON__
 
+  if (RunWithoutColBuffer()) {
+    return true;
+  }
+
   const T* Xdata = X.template data<T>();
   const T* filter_data = filter.template data<T>();
   T* Ydata = Y->template mutable_data<T>();
@@ -149,7 +158,8 @@ bool ConvTransposeOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
     runWithSharedBuffer<Context>(ws_, f);
   } else {
-    f(&col_buffer_);
+    auto col_buffer = context_.scratch_arena()->Borrow();
+    f(col_buffer.get());
   }
   return true;
 }
@@ -197,10 +207,10 @@ bool ConvTransposeOp<T, Context>::RunOnDeviceWithOrderNHWC() {
   const T* filter_data = filter.template data<T>();
   T* Ydata = Y->template mutable_data<T>();
 
-  auto f = [&](Tensor<Context>* /*col_buffer*/) {
-    col_buffer_.Resize(
+  auto f = [&](Tensor<Context>* col_buffer) {
+    col_buffer->Resize(
         vector<TIndex>{H, W, this->kernel_h(), this->kernel_w(), C});
-    T* col_buffer_data = col_buffer_.template mutable_data<T>();
+    T* col_buffer_data = col_buffer->template mutable_data<T>();
     for (auto image_id = 0; image_id < N; ++image_id) {
       // Weight term
       math::Gemm<T, Context>(
@@ -257,7 +267,8 @@ bool ConvTransposeOp<T, Context>::RunOnDeviceWithOrderNHWC() {
   if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
     runWithSharedBuffer<Context>(ws_, f);
   } else {
-    f(&col_buffer_);
+    auto col_buffer = context_.scratch_arena()->Borrow();
+    f(col_buffer.get());
   }
   return true;
 }
@@ -286,7 +297,8 @@ bool ConvTransposeGradientOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   const int kernel_dim = C * this->kernel_h() * this->kernel_w();
   const int output_image_size = dY.dim32(2) * dY.dim32(3);
   // The col buffer is stored in CHW order as well
-  col_buffer_.Resize(
+  auto col_buffer = context_.scratch_arena()->Borrow();
+  col_buffer->Resize(
       vector<TIndex>{C, this->kernel_h(), this->kernel_w(), H, W});
   if (!no_bias_) {
     auto* dbias = Output(BIAS_OR_INPUT_GRAD);
@@ -301,7 +313,7 @@ bool ConvTransposeGradientOp<T, Context>::RunOnDeviceWithOrderNCHW() {
           &context_);
     }
   }
-  T* col_buffer_data = col_buffer_.template mutable_data<T>();
+  T* col_buffer_data = col_buffer->template mutable_data<T>();
   const T* Xdata = X.template data<T>();
   const T* filter_data = filter.template data<T>();
   const T* dYdata = dY.template data<T>();
@@ -438,7 +450,8 @@ bool ConvTransposeGradientOp<T, Context>::RunOnDeviceWithOrderNHWC() {
   const int kernel_dim = C * this->kernel_h() * this->kernel_w();
   const int output_image_size = dY.dim32(1) * dY.dim32(2);
   // The col buffer is stored in HWC order as well
-  col_buffer_.Resize(
+  auto col_buffer = context_.scratch_arena()->Borrow();
+  col_buffer->Resize(
       vector<TIndex>{H, W, this->kernel_h(), this->kernel_w(), C});
   if (!no_bias_) {
     auto* dbias = Output(BIAS_OR_INPUT_GRAD);
@@ -453,7 +466,7 @@ bool ConvTransposeGradientOp<T, Context>::RunOnDeviceWithOrderNHWC() {
           &context_);
     }
   }
-  T* col_buffer_data = col_buffer_.template mutable_data<T>();
+  T* col_buffer_data = col_buffer->template mutable_data<T>();
   const T* Xdata = X.template data<T>();
   const T* filter_data = filter.template data<T>();
   const T* dYdata = dY.template data<T>();
@@ -0,0 +1,527 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/miopen_wrapper.h"
+#include "caffe2/operators/conv_op_cache_miopen.h"
+#include "caffe2/operators/conv_transpose_op.h"
+
+namespace caffe2 {
+
+// Same workspace limit and per-op LRU size as the MIOpen Conv op.
+static constexpr size_t kCONV_TRANSPOSE_MIOPEN_WORKSPACE_LIMIT_BYTES = 64 * 1024 * 1024;
+static constexpr int kCONV_TRANSPOSE_MIOPEN_ALGO_LRU_SIZE          = 8;
+
+// The transposed convolution of X (N, M, H, W) with the filter (M, C, kh, kw)
+// is the data gradient of the convolution of Y (N, C, H_out, W_out) with the
+// same filter. The descriptors below are those of that convolution: top_desc_
+// describes X and bottom_desc_ describes Y, so that the forward pass is a
+// MIOpen backward data call and the input gradient a MIOpen forward call.
+class MIOPENConvTransposeOpBase : public ConvTransposeUnpoolBase<HIPContext>
+{
+    public:
+    MIOPENConvTransposeOpBase(const OperatorDef& operator_def, Workspace* ws)
+        : ConvTransposeUnpoolBase<HIPContext>(operator_def, ws),
+          miopen_wrapper_(&context_),
+          miopen_ws_nbytes_limit_(OperatorBase::GetSingleArgument<size_t>(
+              "ws_nbytes_limit", kCONV_TRANSPOSE_MIOPEN_WORKSPACE_LIMIT_BYTES)),
+          miopen_state_(OperatorBase::GetSingleArgument<size_t>("miopen_state", 0)),
+          alpha_(OperatorBase::GetSingleArgument<float>("alpha", 1.0)),
+          beta_(OperatorBase::GetSingleArgument<float>("beta", 0.0)),
+          exhaustive_search_(OperatorBase::GetSingleArgument<bool>("exhaustive_search", false)),
+          requestAlgoCount_(OperatorBase::GetSingleArgument<int>("requestAlgoCount_", 1)),
+          returnedAlgoCount_(1),
+          algo_lru_size_(OperatorBase::GetSingleArgument<int>(
+              "algo_lru_size", kCONV_TRANSPOSE_MIOPEN_ALGO_LRU_SIZE))
+    {
+        OPERATOR_NEEDS_FEATURE(order_ == StorageOrder::NCHW,
+                               "MIOpen ConvTranspose only supports NCHW order.");
+        OPERATOR_NEEDS_FEATURE(kernel_.size() == 2,
+                               "MIOpen ConvTranspose only supports 2D convolutions.");
+        // With adj the output is larger than what the equivalent convolution
+        // maps back onto the input, which MIOpen rejects.
+        OPERATOR_NEEDS_FEATURE(adj_h() == 0 && adj_w() == 0,
+                               "MIOpen ConvTranspose does not support adj.");
+        OPERATOR_NEEDS_FEATURE(!(kernel_h() == 1 && kernel_w() == 1 && pad_t() + pad_l() > 0),
+                               "MIOpen ConvTranspose does not support padded 1x1 kernels.");
+
+        MIOPEN_ENFORCE(miopenCreateTensorDescriptor(&bottom_desc_));
+        MIOPEN_ENFORCE(miopenCreateTensorDescriptor(&bias_desc_));
+        MIOPEN_ENFORCE(miopenCreateTensorDescriptor(&weight_desc_));
+        MIOPEN_ENFORCE(miopenCreateTensorDescriptor(&top_desc_));
+        MIOPEN_ENFORCE(miopenCreateConvolutionDescriptor(&conv_desc_));
+    }
+
+    ~MIOPENConvTransposeOpBase()
+    {
+        MIOPEN_ENFORCE(miopenDestroyTensorDescriptor(bottom_desc_));
+        MIOPEN_ENFORCE(miopenDestroyTensorDescriptor(bias_desc_));
+        MIOPEN_ENFORCE(miopenDestroyTensorDescriptor(weight_desc_));
+        MIOPEN_ENFORCE(miopenDestroyTensorDescriptor(top_desc_));
+        MIOPEN_ENFORCE(miopenDestroyConvolutionDescriptor(conv_desc_));
+    }
+
+    protected:
+    // Sets the descriptors for X, the filter and Y (all NCHW) and returns
+    // true if they differ from those of the previous run, in which case the
+    // algorithms have to be picked again.
+    template <typename T>
+    bool SetDescriptors(const Tensor<HIPContext>& X,
+                        const Tensor<HIPContext>& filter,
+                        const vector<TIndex>& Y_dims)
+    {
+        if(X.dims() == last_X_dims_ && filter.dims() == last_filter_dims_)
+        {
+            return false;
+        }
+        last_X_dims_      = X.dims();
+        last_filter_dims_ = filter.dims();
+
+        CAFFE_ENFORCE_EQ(pad_t(),
+                         pad_b(),
+                         "The current padding scheme leads to unequal padding on the top and "
+                         "bottom, which is not supported by MIOpen.");
+        CAFFE_ENFORCE_EQ(pad_l(),
+                         pad_r(),
+                         "The current padding scheme leads to unequal padding on the left "
+                         "and right, which is not supported by MIOpen.");
+        MIOPEN_ENFORCE(miopenInitConvolutionDescriptor(
+            conv_desc_, miopenConvolution, pad_t(), pad_l(), stride_h(), stride_w(), 1, 1));
+
+        const int N = X.dim32(0);
+        const int M = X.dim32(1);
+        const int C = filter.dim32(1);
+        MIOPEN_ENFORCE(miopenSet4dTensorDescriptor(
+            top_desc_, miopenTypeWrapper<T>::type, N, M, X.dim32(2), X.dim32(3)));
+        MIOPEN_ENFORCE(miopenSet4dTensorDescriptor(
+            weight_desc_, miopenTypeWrapper<T>::type, M, C, kernel_h(), kernel_w()));
+        MIOPEN_ENFORCE(miopenSet4dTensorDescriptor(
+            bottom_desc_, miopenTypeWrapper<T>::type, N, C, Y_dims[2], Y_dims[3]));
+        MIOPEN_ENFORCE(
+            miopenSet4dTensorDescriptor(bias_desc_, miopenTypeWrapper<T>::type, 1, C, 1, 1));
+
+        x_dims_ = {N, M, X.dim32(2), X.dim32(3)};
+        w_dims_ = {M, C, kernel_h(), kernel_w()};
+        return true;
+    }
+
+    // Key of the current descriptors in the process-wide MIOpen algorithm
+    // cache, see MIOPENConvOpBase::AlgoCacheKey.
+    std::string AlgoCacheKey(const std::string& direction, miopenDataType_t type)
+    {
+        return MIOPENConvAlgoKey("transpose_" + direction,
+                                 GetDeviceProperty(context_.hip_gpu_id()).name,
+                                 type,
+                                 x_dims_,
+                                 w_dims_,
+                                 {static_cast<int>(miopenCompiledVersion()),
+                                  miopenConvolution,
+                                  pad_t(),
+                                  pad_l(),
+                                  stride_h(),
+                                  stride_w(),
+                                  1,
+                                  1,
+                                  1});
+    }
+
+    // Picks the algorithm for key from the op's LRU, then from the shared
+    // cache, and only runs find (the MIOpen Find step) if both miss.
+    template <typename T>
+    T FindAlgorithm(MIOPENConvAlgoLRU<T>* lru, const std::string& key, std::function<T()> find)
+    {
+        T algo;
+        if(!lru->lookup(key, &algo))
+        {
+            algo = MIOPENConvAlgoCache::Get().getAlgorithm<T>(key, find);
+            lru->insert(key, algo);
+        }
+        return algo;
+    }
+
+    MIOPENWrapper miopen_wrapper_;
+    vector<TIndex> last_X_dims_;
+    vector<TIndex> last_filter_dims_;
+    vector<int> x_dims_;
+    vector<int> w_dims_;
+    miopenTensorDescriptor_t bottom_desc_;
+    miopenTensorDescriptor_t bias_desc_;
+    miopenTensorDescriptor_t weight_desc_;
+    miopenTensorDescriptor_t top_desc_;
+    miopenConvolutionDescriptor_t conv_desc_;
+    const size_t miopen_ws_nbytes_limit_;
+    size_t miopen_state_;
+    const float alpha_;
+    const float beta_;
+    const bool exhaustive_search_;
+    const int requestAlgoCount_;
+    int returnedAlgoCount_;
+    const int algo_lru_size_;
+};
+
+class MIOPENConvTransposeOp final : public MIOPENConvTransposeOpBase
+{
+    public:
+    MIOPENConvTransposeOp(const OperatorDef& operator_def, Workspace* ws)
+        : MIOPENConvTransposeOpBase(operator_def, ws),
+          bwdDataWsSize_(0),
+          bwd_data_algo_(miopenConvolutionBwdDataAlgoGEMM),
+          bwd_data_algo_lru_(algo_lru_size_)
+    {
+    }
+
+    template <typename T>
+    bool DoRunWithType();
+    bool RunOnDevice() override;
+
+    private:
+    size_t bwdDataWsSize_;
+    miopenConvBwdDataAlgorithm_t bwd_data_algo_;
+    MIOPENConvAlgoLRU<miopenConvBwdDataAlgorithm_t> bwd_data_algo_lru_;
+    // Input: X, W, b
+    // Output: Y
+    INPUT_TAGS(INPUT, FILTER, BIAS);
+};
+
+class MIOPENConvTransposeGradientOp final : public MIOPENConvTransposeOpBase
+{
+    public:
+    MIOPENConvTransposeGradientOp(const OperatorDef& operator_def, Workspace* ws)
+        : MIOPENConvTransposeOpBase(operator_def, ws),
+          no_bias_(OperatorBase::GetSingleArgument<bool>("no_bias", false)),
+          fwdWsSize_(0),
+          bwdWeightWsSize_(0),
+          fwd_algo_(miopenConvolutionFwdAlgoGEMM),
+          bwd_wei_algo_(miopenConvolutionBwdWeightsAlgoGEMM),
+          fwd_algo_lru_(algo_lru_size_),
+          bwd_wei_algo_lru_(algo_lru_size_),
+          fwd_algo_picked_(false)
+    {
+        CAFFE_ENFORCE(!(no_bias_ && OutputSize() == 3),
+                      "If bias is not present, you should not have 3 grad output.");
+    }
+
+    template <typename T>
+    bool DoRunWithType();
+    bool RunOnDevice() override;
+
+    private:
+    const bool no_bias_;
+    size_t fwdWsSize_;
+    size_t bwdWeightWsSize_;
+    miopenConvFwdAlgorithm_t fwd_algo_;
+    miopenConvBwdWeightsAlgorithm_t bwd_wei_algo_;
+    MIOPENConvAlgoLRU<miopenConvFwdAlgorithm_t> fwd_algo_lru_;
+    MIOPENConvAlgoLRU<miopenConvBwdWeightsAlgorithm_t> bwd_wei_algo_lru_;
+    // The input gradient is optional, its algorithm is only picked by the
+    // first run with the current shapes that computes it.
+    bool fwd_algo_picked_;
+    // input: X, W, dY
+    // output: dW, optionally db and dX
+    INPUT_TAGS(INPUT, FILTER, OUTPUT_GRAD);
+    OUTPUT_TAGS(FILTER_GRAD, BIAS_OR_INPUT_GRAD, INPUT_GRAD);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Implementations
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+bool MIOPENConvTransposeOp::DoRunWithType()
+{
+    auto& X      = Input(INPUT);
+    auto& filter = Input(FILTER);
+    auto* Y      = Output(0);
+    CAFFE_ENFORCE_EQ(X.ndim(), 4);
+    CAFFE_ENFORCE_EQ(filter.ndim(), 4);
+    const int C = filter.dim32(1);
+    ConvTransposeUnpoolBase<HIPContext>::SetOutputSize(X, Y, C);
+    CAFFE_ENFORCE_EQ(filter.dim32(0), X.dim32(1));
+    CAFFE_ENFORCE_EQ(filter.dim32(2), kernel_h());
+    CAFFE_ENFORCE_EQ(filter.dim32(3), kernel_w());
+    if(InputSize() == 3)
+    {
+        auto& bias = Input(BIAS);
+        CAFFE_ENFORCE_EQ(bias.ndim(), 1);
+        CAFFE_ENFORCE_EQ(bias.dim32(0), C);
+    }
+
+    if(SetDescriptors<T>(X, filter, Y->dims()))
+    {
+        MIOPEN_ENFORCE(
+            miopenConvolutionBackwardDataGetWorkSpaceSize(miopen_wrapper_.inline_miopen_handle(),
+                                                          top_desc_,
+                                                          weight_desc_,
+                                                          conv_desc_,
+                                                          bottom_desc_,
+                                                          &bwdDataWsSize_));
+        CAFFE_ENFORCE_LE(bwdDataWsSize_,
+                         miopen_ws_nbytes_limit_,
+                         "MIOpen ConvTranspose needs more workspace than ws_nbytes_limit.");
+
+        bwd_data_algo_ = FindAlgorithm<miopenConvBwdDataAlgorithm_t>(
+            &bwd_data_algo_lru_, AlgoCacheKey("fwd", miopenTypeWrapper<T>::type), [&]() {
+                miopenConvAlgoPerf_t perf;
+                miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
+                    MIOPEN_ENFORCE(miopenFindConvolutionBackwardDataAlgorithm(
+                        state->miopen_handle(),
+                        top_desc_,
+                        X.template data<T>(),
+                        weight_desc_,
+                        filter.template data<T>(),
+                        conv_desc_,
+                        bottom_desc_,
+                        Y->template mutable_data<T>(),
+                        requestAlgoCount_,
+                        &returnedAlgoCount_,
+                        &perf,
+                        state->workspace().get(bwdDataWsSize_),
+                        bwdDataWsSize_,
+                        exhaustive_search_));
+                });
+                return perf.bwd_data_algo;
+            });
+    }
+
+    miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
+        MIOPEN_ENFORCE(miopenConvolutionBackwardData(state->miopen_handle(),
+                                                     &alpha_,
+                                                     top_desc_,
+                                                     X.template data<T>(),
+                                                     weight_desc_,
+                                                     filter.template data<T>(),
+                                                     conv_desc_,
+                                                     bwd_data_algo_,
+                                                     &beta_,
+                                                     bottom_desc_,
+                                                     Y->template mutable_data<T>(),
+                                                     state->workspace().get(bwdDataWsSize_),
+                                                     bwdDataWsSize_));
+    });
+
+    if(InputSize() == 3)
+    {
+        miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
+            MIOPEN_ENFORCE(miopenConvolutionForwardBias(state->miopen_handle(),
+                                                        &alpha_,
+                                                        bias_desc_,
+                                                        Input(BIAS).template data<T>(),
+                                                        &beta_,
+                                                        bottom_desc_,
+                                                        Y->template mutable_data<T>()));
+        });
+    }
+    return true;
+}
+
+bool MIOPENConvTransposeOp::RunOnDevice()
+{
+    if(Input(0).IsType<float>())
+    {
+        return DoRunWithType<float>();
+    }
+    else if(Input(0).IsType<float16>())
+    {
+        return DoRunWithType<float16>();
+    }
+    else
+    {
+        LOG(FATAL) << "Only float (32bit) and float16 are supported by "
+                   << "miopen convolution transpose, but input " << debug_def().input(0)
+                   << " has [" << Input(0).meta().name() << "]";
+    }
+    return true;
+}
+
+template <typename T>
+bool MIOPENConvTransposeGradientOp::DoRunWithType()
+{
+    auto& X       = Input(INPUT);
+    auto& filter  = Input(FILTER);
+    auto& dY      = Input(OUTPUT_GRAD);
+    auto* dfilter = Output(FILTER_GRAD);
+    CAFFE_ENFORCE_EQ(X.ndim(), 4);
+    CAFFE_ENFORCE_EQ(filter.ndim(), 4);
+    CAFFE_ENFORCE_EQ(dY.ndim(), 4);
+    CAFFE_ENFORCE_EQ(filter.dim32(0), X.dim32(1));
+    CAFFE_ENFORCE_EQ(filter.dim32(1), dY.dim32(1));
+    CAFFE_ENFORCE_EQ(filter.dim32(2), kernel_h());
+    CAFFE_ENFORCE_EQ(filter.dim32(3), kernel_w());
+    // Computes the pads of the legacy padding schemes.
+    Tensor<HIPContext> Y_shape;
+    ConvTransposeUnpoolBase<HIPContext>::SetOutputSize(X, &Y_shape, dY.dim32(1));
+    CAFFE_ENFORCE(Y_shape.dims() == dY.dims(), "dY does not have the ConvTranspose output shape.");
+    dfilter->ResizeLike(filter);
+
+    const bool compute_dX = OutputSize() == 3 || (no_bias_ && OutputSize() == 2);
+    Tensor<HIPContext>* dX = nullptr;
+    if(compute_dX)
+    {
+        dX = Output(no_bias_ ? BIAS_OR_INPUT_GRAD : INPUT_GRAD);
+        dX->ResizeLike(X);
+    }
+
+    if(SetDescriptors<T>(X, filter, dY.dims()))
+    {
+        MIOPEN_ENFORCE(miopenConvolutionBackwardWeightsGetWorkSpaceSize(
+            miopen_wrapper_.inline_miopen_handle(),
+            top_desc_,
+            bottom_desc_,
+            conv_desc_,
+            weight_desc_,
+            &bwdWeightWsSize_));
+        CAFFE_ENFORCE_LE(bwdWeightWsSize_,
+                         miopen_ws_nbytes_limit_,
+                         "MIOpen ConvTransposeGradient needs more workspace than ws_nbytes_limit.");
+
+        bwd_wei_algo_ = FindAlgorithm<miopenConvBwdWeightsAlgorithm_t>(
+            &bwd_wei_algo_lru_, AlgoCacheKey("bwd_weights", miopenTypeWrapper<T>::type), [&]() {
+                miopenConvAlgoPerf_t perf;
+                miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
+                    MIOPEN_ENFORCE(miopenFindConvolutionBackwardWeightsAlgorithm(
+                        state->miopen_handle(),
+                        top_desc_,
+                        X.template data<T>(),
+                        bottom_desc_,
+                        dY.template data<T>(),
+                        conv_desc_,
+                        weight_desc_,
+                        dfilter->template mutable_data<T>(),
+                        requestAlgoCount_,
+                        &returnedAlgoCount_,
+                        &perf,
+                        state->workspace().get(bwdWeightWsSize_),
+                        bwdWeightWsSize_,
+                        exhaustive_search_));
+                });
+                return perf.bwd_weights_algo;
+            });
+
+        fwd_algo_picked_ = false;
+    }
+
+    if(compute_dX && !fwd_algo_picked_)
+    {
+        MIOPEN_ENFORCE(
+            miopenConvolutionForwardGetWorkSpaceSize(miopen_wrapper_.inline_miopen_handle(),
+                                                     weight_desc_,
+                                                     bottom_desc_,
+                                                     conv_desc_,
+                                                     top_desc_,
+                                                     &fwdWsSize_));
+        CAFFE_ENFORCE_LE(
+            fwdWsSize_,
+            miopen_ws_nbytes_limit_,
+            "MIOpen ConvTransposeGradient needs more workspace than ws_nbytes_limit.");
+
+        fwd_algo_ = FindAlgorithm<miopenConvFwdAlgorithm_t>(
+            &fwd_algo_lru_, AlgoCacheKey("bwd_data", miopenTypeWrapper<T>::type), [&]() {
+                miopenConvAlgoPerf_t perf;
+                miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
+                    MIOPEN_ENFORCE(miopenFindConvolutionForwardAlgorithm(
+                        state->miopen_handle(),
+                        bottom_desc_,
+                        dY.template data<T>(),
+                        weight_desc_,
+                        filter.template data<T>(),
+                        conv_desc_,
+                        top_desc_,
+                        dX->template mutable_data<T>(),
+                        requestAlgoCount_,
+                        &returnedAlgoCount_,
+                        &perf,
+                        state->workspace().get(fwdWsSize_),
+                        fwdWsSize_,
+                        exhaustive_search_));
+                });
+                return perf.fwd_algo;
+            });
+        fwd_algo_picked_ = true;
+    }
+
+    miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
+        MIOPEN_ENFORCE(miopenConvolutionBackwardWeights(state->miopen_handle(),
+                                                        &alpha_,
+                                                        top_desc_,
+                                                        X.template data<T>(),
+                                                        bottom_desc_,
+                                                        dY.template data<T>(),
+                                                        conv_desc_,
+                                                        bwd_wei_algo_,
+                                                        &beta_,
+                                                        weight_desc_,
+                                                        dfilter->template mutable_data<T>(),
+                                                        state->workspace().get(bwdWeightWsSize_),
+                                                        bwdWeightWsSize_));
+    });
+
+    if(!no_bias_)
+    {
+        auto* dbias = Output(BIAS_OR_INPUT_GRAD);
+        dbias->Resize(dY.dim32(1));
+        miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
+            MIOPEN_ENFORCE(miopenConvolutionBackwardBias(state->miopen_handle(),
+                                                         &alpha_,
+                                                         bottom_desc_,
+                                                         dY.template data<T>(),
+                                                         &beta_,
+                                                         bias_desc_,
+                                                         dbias->template mutable_data<T>()));
+        });
+    }
+
+    if(compute_dX)
+    {
+        miopen_wrapper_.with_miopen_state(miopen_state_, [&](MIOPENState* state) {
+            MIOPEN_ENFORCE(miopenConvolutionForward(state->miopen_handle(),
+                                                    &alpha_,
+                                                    bottom_desc_,
+                                                    dY.template data<T>(),
+                                                    weight_desc_,
+                                                    filter.template data<T>(),
+                                                    conv_desc_,
+                                                    fwd_algo_,
+                                                    &beta_,
+                                                    top_desc_,
+                                                    dX->template mutable_data<T>(),
+                                                    state->workspace().get(fwdWsSize_),
+                                                    fwdWsSize_));
+        });
+    }
+    return true;
+}
+
+bool MIOPENConvTransposeGradientOp::RunOnDevice()
+{
+    if(Input(0).IsType<float>())
+    {
+        return DoRunWithType<float>();
+    }
+    else if(Input(0).IsType<float16>())
+    {
+        return DoRunWithType<float16>();
+    }
+    else
+    {
+        LOG(FATAL) << "Unsupported input types";
+    }
+    return true;
+}
+
+REGISTER_MIOPEN_OPERATOR(ConvTranspose, MIOPENConvTransposeOp);
+REGISTER_MIOPEN_OPERATOR(ConvTransposeGradient, MIOPENConvTransposeGradientOp);
+
+} // namespace caffe2
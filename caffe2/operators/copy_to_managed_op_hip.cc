@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/operator.h"
+#include "hip/hip_runtime.h"
+
+namespace caffe2 {
+
+// Copies a CPU tensor into managed memory, so that tables larger than the
+// device memory can be used by HIP ops. The pages prefer to stay on the host
+// and are mapped for the device, which reads the cold ones over the link
+// instead of migrating them back and forth; the hot ones are moved to the
+// device by the MANAGED engine of SparseLengthsSum.
+class CopyToManagedOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    CopyToManagedOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws),
+          read_mostly_(OperatorBase::GetSingleArgument<bool>("read_mostly", false))
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        auto& input  = OperatorBase::Input<TensorCPU>(0);
+        auto* output = Output(0);
+        CAFFE_ENFORCE(!input.meta().copy(), "CopyToManaged requires fundamental types.");
+        const size_t nbytes = input.nbytes();
+        if(nbytes == 0)
+        {
+            output->ResizeLike(input);
+            output->raw_mutable_data(input.meta());
+            return true;
+        }
+
+        // The managed buffer is kept as long as the output is not reallocated
+        // by someone else, so that running the op again only refreshes it.
+        if(managed_ == nullptr || output->meta() != input.meta() ||
+           output->nbytes() != nbytes || output->raw_data() != managed_)
+        {
+            output->ResizeLike(input);
+            auto allocation = HIPContext::NewManaged(nbytes);
+            output->ShareExternalPointer(
+                allocation.first, input.meta(), nbytes, allocation.second);
+            managed_ = allocation.first;
+
+            const int gpu = context_.hip_gpu_id();
+            HIP_ENFORCE(
+                hipMemAdvise(managed_, nbytes, hipMemAdviseSetPreferredLocation, hipCpuDeviceId));
+            HIP_ENFORCE(hipMemAdvise(managed_, nbytes, hipMemAdviseSetAccessedBy, gpu));
+            if(read_mostly_)
+            {
+                // Only for tables that are not trained: every write drops the
+                // copies of the page the devices have made.
+                HIP_ENFORCE(hipMemAdvise(managed_, nbytes, hipMemAdviseSetReadMostly, gpu));
+            }
+        }
+        context_.CopyBytes<CPUContext, HIPContext>(nbytes, input.raw_data(), managed_);
+        return true;
+    }
+
+    private:
+    bool read_mostly_;
+    void* managed_ = nullptr;
+};
+
+REGISTER_HIP_OPERATOR(CopyToManaged, CopyToManagedOp);
+
+} // namespace caffe2
@@ -39,6 +39,10 @@ class Counter {
     return count_++;
   }
 
+  T fetchAdd(T step) {
+    return count_.fetch_add(step);
+  }
+
   T retrieve() const {
     return count_.load();
   }
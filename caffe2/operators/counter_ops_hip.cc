@@ -14,14 +14,357 @@
  * limitations under the License.
  */
 
+#include "caffe2/core/blob_serialization.h"
 #include "caffe2/core/context_hip.h"
 #include "counter_ops.h"
 
 namespace caffe2 {
-REGISTER_HIP_OPERATOR(CreateCounter, CreateCounterOp<int64_t, HIPContext>);
-REGISTER_HIP_OPERATOR(ResetCounter, ResetCounterOp<int64_t, HIPContext>);
-REGISTER_HIP_OPERATOR(CountDown, CountDownOp<int64_t, HIPContext>);
-REGISTER_HIP_OPERATOR(CheckCounterDone, CheckCounterDoneOp<int64_t, HIPContext>);
-REGISTER_HIP_OPERATOR(CountUp, CountUpOp<int64_t, HIPContext>);
-REGISTER_HIP_OPERATOR(RetrieveCount, RetrieveCountOp<int64_t, HIPContext>);
+
+/**
+ * Counter of the HIP nets, kept in device memory and updated by kernels in
+ * stream order, so that the counter ops don't synchronize the host with the
+ * device. The ops copy their result asynchronously into their (pinned) CPU
+ * output, readable once the op event completes. The HIP counter ops also
+ * accept the Counter of CPU nets, e.g. when it is loaded from a checkpoint.
+ */
+template <typename T>
+class HIPCounter
+{
+    public:
+    HIPCounter(T count, HIPContext* context);
+
+    T* data() { return count_.template mutable_data<T>(); }
+
+    // Waits for the device and reads the counter, for serialization.
+    T retrieve() const;
+
+    private:
+    Tensor<HIPContext> count_;
+    int gpu_id_;
+};
+
+namespace {
+// The int64 counters are updated with the unsigned atomics of HIP, which wrap
+// around the same way.
+using AtomicType = unsigned long long;
+
+template <typename T>
+__global__ void SetCounterKernel(T* count, const T value, T* previous)
+{
+    const T old = static_cast<T>(
+        atomicExch(reinterpret_cast<AtomicType*>(count), static_cast<AtomicType>(value)));
+    if(previous != nullptr)
+    {
+        *previous = old;
+    }
+}
+
+template <typename T>
+__global__ void CountDownKernel(T* count, bool* done)
+{
+    const T old = static_cast<T>(
+        atomicAdd(reinterpret_cast<AtomicType*>(count), static_cast<AtomicType>(-1)));
+    *done = old <= 0;
+}
+
+template <typename T>
+__global__ void CheckCounterDoneKernel(const T* count, bool* done)
+{
+    *done = *count <= 0;
+}
+
+template <typename T>
+__global__ void CountUpKernel(T* count, T* previous)
+{
+    *previous = static_cast<T>(atomicAdd(reinterpret_cast<AtomicType*>(count), AtomicType(1)));
+}
+} // namespace
+
+template <typename T>
+HIPCounter<T>::HIPCounter(T count, HIPContext* context) : gpu_id_(context->hip_gpu_id())
+{
+    count_.Resize(1);
+    hipLaunchKernelGGL((SetCounterKernel<T>),
+                       dim3(1),
+                       dim3(1),
+                       0,
+                       context->hip_stream(),
+                       count_.template mutable_data<T>(),
+                       count,
+                       static_cast<T*>(nullptr));
+}
+
+template <typename T>
+T HIPCounter<T>::retrieve() const
+{
+    DeviceGuard guard(gpu_id_);
+    HIP_ENFORCE(hipDeviceSynchronize());
+    T count;
+    HIP_ENFORCE(hipMemcpy(&count, count_.template data<T>(), sizeof(T), hipMemcpyDeviceToHost));
+    return count;
+}
+
+template <typename T>
+class HIPCounterOpBase : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPCounterOpBase(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws)
+    {
+    }
+
+    protected:
+    bool IsHostCounter() { return OperatorBase::InputIsType<std::unique_ptr<Counter<T>>>(0); }
+
+    Counter<T>* HostCounter()
+    {
+        return OperatorBase::Input<std::unique_ptr<Counter<T>>>(0).get();
+    }
+
+    HIPCounter<T>* DeviceCounter()
+    {
+        return OperatorBase::Input<std::unique_ptr<HIPCounter<T>>>(0).get();
+    }
+
+    // Scalar CPU output
+    template <typename U>
+    U* Result(int idx)
+    {
+        auto* output = OperatorBase::Output<TensorCPU>(idx);
+        output->Resize(std::vector<int>{});
+        return output->template mutable_data<U>();
+    }
+
+    // Copies the device result into the CPU output without waiting for it.
+    template <typename U>
+    void CopyResult(int idx)
+    {
+        context_.template Copy<U, HIPContext, CPUContext>(
+            1, result_.template data<U>(), Result<U>(idx));
+    }
+
+    Tensor<HIPContext> result_;
+};
+
+template <typename T>
+class HIPCreateCounterOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPCreateCounterOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws),
+          init_count_(OperatorBase::GetSingleArgument<T>("init_count", 0))
+    {
+        CAFFE_ENFORCE_LE(0, init_count_, "negative init_count is not permitted.");
+    }
+
+    bool RunOnDevice() override
+    {
+        *OperatorBase::Output<std::unique_ptr<HIPCounter<T>>>(0) =
+            std::unique_ptr<HIPCounter<T>>(new HIPCounter<T>(init_count_, &context_));
+        return true;
+    }
+
+    private:
+    T init_count_ = 0;
+};
+
+template <typename T>
+class HIPResetCounterOp final : public HIPCounterOpBase<T>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPResetCounterOp(const OperatorDef& operator_def, Workspace* ws)
+        : HIPCounterOpBase<T>(operator_def, ws),
+          init_count_(OperatorBase::GetSingleArgument<T>("init_count", 0))
+    {
+        CAFFE_ENFORCE_LE(0, init_count_, "negative init_count is not permitted.");
+    }
+
+    bool RunOnDevice() override
+    {
+        if(this->IsHostCounter())
+        {
+            auto previous = this->HostCounter()->reset(init_count_);
+            if(OutputSize() == 1)
+            {
+                *this->template Result<T>(0) = previous;
+            }
+            return true;
+        }
+        T* previous = nullptr;
+        if(OutputSize() == 1)
+        {
+            this->result_.Resize(1);
+            previous = this->result_.template mutable_data<T>();
+        }
+        hipLaunchKernelGGL((SetCounterKernel<T>),
+                           dim3(1),
+                           dim3(1),
+                           0,
+                           context_.hip_stream(),
+                           this->DeviceCounter()->data(),
+                           init_count_,
+                           previous);
+        if(OutputSize() == 1)
+        {
+            this->template CopyResult<T>(0);
+        }
+        return true;
+    }
+
+    private:
+    T init_count_;
+};
+
+template <typename T>
+class HIPCountDownOp final : public HIPCounterOpBase<T>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPCountDownOp(const OperatorDef& operator_def, Workspace* ws)
+        : HIPCounterOpBase<T>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        if(this->IsHostCounter())
+        {
+            *this->template Result<bool>(0) = this->HostCounter()->countDown();
+            return true;
+        }
+        this->result_.Resize(1);
+        hipLaunchKernelGGL((CountDownKernel<T>),
+                           dim3(1),
+                           dim3(1),
+                           0,
+                           context_.hip_stream(),
+                           this->DeviceCounter()->data(),
+                           this->result_.template mutable_data<bool>());
+        this->template CopyResult<bool>(0);
+        return true;
+    }
+};
+
+template <typename T>
+class HIPCheckCounterDoneOp final : public HIPCounterOpBase<T>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPCheckCounterDoneOp(const OperatorDef& operator_def, Workspace* ws)
+        : HIPCounterOpBase<T>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        if(this->IsHostCounter())
+        {
+            *this->template Result<bool>(0) = this->HostCounter()->checkIfDone();
+            return true;
+        }
+        this->result_.Resize(1);
+        hipLaunchKernelGGL((CheckCounterDoneKernel<T>),
+                           dim3(1),
+                           dim3(1),
+                           0,
+                           context_.hip_stream(),
+                           this->DeviceCounter()->data(),
+                           this->result_.template mutable_data<bool>());
+        this->template CopyResult<bool>(0);
+        return true;
+    }
+};
+
+template <typename T>
+class HIPCountUpOp final : public HIPCounterOpBase<T>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPCountUpOp(const OperatorDef& operator_def, Workspace* ws)
+        : HIPCounterOpBase<T>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        if(this->IsHostCounter())
+        {
+            *this->template Result<T>(0) = this->HostCounter()->countUp();
+            return true;
+        }
+        this->result_.Resize(1);
+        hipLaunchKernelGGL((CountUpKernel<T>),
+                           dim3(1),
+                           dim3(1),
+                           0,
+                           context_.hip_stream(),
+                           this->DeviceCounter()->data(),
+                           this->result_.template mutable_data<T>());
+        this->template CopyResult<T>(0);
+        return true;
+    }
+};
+
+template <typename T>
+class HIPRetrieveCountOp final : public HIPCounterOpBase<T>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPRetrieveCountOp(const OperatorDef& operator_def, Workspace* ws)
+        : HIPCounterOpBase<T>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        if(this->IsHostCounter())
+        {
+            *this->template Result<T>(0) = this->HostCounter()->retrieve();
+            return true;
+        }
+        context_.template Copy<T, HIPContext, CPUContext>(
+            1, this->DeviceCounter()->data(), this->template Result<T>(0));
+        return true;
+    }
+};
+
+namespace {
+// Serialized as the counters of CPU nets, so that checkpoints can be loaded
+// by either kind of net.
+class HIPCounterSerializer : public BlobSerializerBase
+{
+    public:
+    HIPCounterSerializer() {}
+    ~HIPCounterSerializer() {}
+
+    void Serialize(const Blob& blob, const string& name, SerializationAcceptor acceptor) override
+    {
+        CAFFE_ENFORCE(blob.IsType<std::unique_ptr<HIPCounter<int64_t>>>());
+
+        BlobProto blob_proto;
+        blob_proto.set_name(name);
+        blob_proto.set_type("std::unique_ptr<Counter<int64_t>>");
+        TensorProto& proto = *blob_proto.mutable_tensor();
+        proto.set_name(name);
+        proto.set_data_type(TensorProto_DataType_INT64);
+        proto.add_dims(1);
+        proto.add_int64_data(blob.template Get<std::unique_ptr<HIPCounter<int64_t>>>()->retrieve());
+        acceptor(name, blob_proto.SerializeAsString());
+    }
+};
+} // namespace
+
+CAFFE_KNOWN_TYPE(std::unique_ptr<HIPCounter<int64_t>>);
+REGISTER_BLOB_SERIALIZER((TypeMeta::Id<std::unique_ptr<HIPCounter<int64_t>>>()),
+                         HIPCounterSerializer);
+
+REGISTER_HIP_OPERATOR(CreateCounter, HIPCreateCounterOp<int64_t>);
+REGISTER_HIP_OPERATOR(ResetCounter, HIPResetCounterOp<int64_t>);
+REGISTER_HIP_OPERATOR(CountDown, HIPCountDownOp<int64_t>);
+REGISTER_HIP_OPERATOR(CheckCounterDone, HIPCheckCounterDoneOp<int64_t>);
+REGISTER_HIP_OPERATOR(CountUp, HIPCountUpOp<int64_t>);
+REGISTER_HIP_OPERATOR(RetrieveCount, HIPRetrieveCountOp<int64_t>);
 } // namespace caffe2
@@ -62,14 +62,12 @@ class WorkspaceStack {
           std::make_shared<Workspace>(parent_ws, blob_bindings));
     } else {
       // when reusing workspace, make sure copies of external blobs are
-      // removed and blob bindings are set
+      // removed and blob bindings are set; only the bound names are looked
+      // up, as this runs on every iteration of a loop around the Do op
       auto& workspace = workspaces_[top_ + 1];
-      const auto& local_blobs = workspace->LocalBlobs();
-      std::unordered_set<std::string> local_blobs_set;
-      local_blobs_set.insert(local_blobs.begin(), local_blobs.end());
       bool found_local_copy = false;
       for (const auto& blob_pair : blob_bindings) {
-        if (local_blobs_set.count(blob_pair.first)) {
+        if (workspace->HasLocalBlob(blob_pair.first)) {
           workspace->RemoveBlob(blob_pair.first);
           found_local_copy = true;
         }
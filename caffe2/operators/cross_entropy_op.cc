@@ -195,6 +195,79 @@ bool WeightedSigmoidCrossEntropyWithLogitsGradientOp<float, CPUContext>::
   return true;
 }
 
+namespace {
+// Checks the weights of WeightedSigmoidCrossEntropyLoss(Gradient), if any,
+// and returns how many of them there are (0 without weights).
+template <class Context>
+TIndex LossWeightsSize(
+    const Tensor<Context>& logits,
+    const Tensor<Context>* weights) {
+  if (weights == nullptr) {
+    return 0;
+  }
+  const auto inner_size = logits.ndim() > 0 ? logits.dims().back() : 1;
+  CAFFE_ENFORCE(
+      weights->dims() == logits.dims() ||
+          (weights->ndim() == 1 && weights->size() == inner_size),
+      "weights must have the shape of the logits or of their last dimension");
+  return weights->size();
+}
+} // namespace
+
+template <>
+bool WeightedSigmoidCrossEntropyLossOp<float, CPUContext>::RunOnDevice() {
+  auto& logits = Input(0);
+  auto& targets = Input(1);
+  CAFFE_ENFORCE(logits.dims() == targets.dims());
+  const auto* weights = InputSize() > 2 ? &Input(2) : nullptr;
+  const auto weights_size = LossWeightsSize(logits, weights);
+  const auto size = logits.size();
+
+  auto* out = Output(0);
+  out->Resize(std::vector<TIndex>{});
+
+  auto* logits_ptr = logits.data<float>();
+  auto* targets_ptr = targets.data<float>();
+  auto* weights_ptr = weights_size > 0 ? weights->data<float>() : nullptr;
+
+  float value = 0;
+  for (TIndex i = 0; i < size; ++i) {
+    const float xent = sigmoid_xent_forward(logits_ptr[i], targets_ptr[i]);
+    value += weights_ptr ? xent * weights_ptr[i % weights_size] : xent;
+  }
+  *out->mutable_data<float>() = size > 0 ? -value / size : 0;
+  return true;
+}
+
+template <>
+bool WeightedSigmoidCrossEntropyLossGradientOp<float, CPUContext>::
+    RunOnDevice() {
+  auto& g = Input(0);
+  auto& logits = Input(1);
+  auto& targets = Input(2);
+  CAFFE_ENFORCE(logits.dims() == targets.dims());
+  CAFFE_ENFORCE_EQ(g.size(), 1);
+  const auto* weights = InputSize() > 3 ? &Input(3) : nullptr;
+  const auto weights_size = LossWeightsSize(logits, weights);
+  const auto size = logits.size();
+
+  auto* out = Output(0);
+  out->ResizeLike(logits);
+  auto* out_ptr = out->mutable_data<float>();
+
+  auto* logits_ptr = logits.data<float>();
+  auto* targets_ptr = targets.data<float>();
+  auto* weights_ptr = weights_size > 0 ? weights->data<float>() : nullptr;
+  const float g_factor = size > 0 ? -g.data<float>()[0] / size : 0;
+
+  for (TIndex i = 0; i < size; ++i) {
+    const float dxent = g_factor *
+        sigmoid_xent_backward(logits_ptr[i], targets_ptr[i]);
+    out_ptr[i] = weights_ptr ? dxent * weights_ptr[i % weights_size] : dxent;
+  }
+  return true;
+}
+
 template <>
 bool LabelCrossEntropyGradientOp<float, CPUContext>::RunOnDevice() {
   auto& X = Input(0);
@@ -402,6 +475,13 @@ REGISTER_CPU_OPERATOR(
     WeightedSigmoidCrossEntropyWithLogitsGradient,
     WeightedSigmoidCrossEntropyWithLogitsGradientOp<float, CPUContext>);
 
+REGISTER_CPU_OPERATOR(
+    WeightedSigmoidCrossEntropyLoss,
+    WeightedSigmoidCrossEntropyLossOp<float, CPUContext>);
+REGISTER_CPU_OPERATOR(
+    WeightedSigmoidCrossEntropyLossGradient,
+    WeightedSigmoidCrossEntropyLossGradientOp<float, CPUContext>);
+
 OPERATOR_SCHEMA(MakeTwoClass)
     .NumInputs(1)
     .NumOutputs(1)
@@ -466,6 +546,31 @@ OPERATOR_SCHEMA(WeightedSigmoidCrossEntropyWithLogitsGradient)
     .NumInputs(4)
     .NumOutputs(1);
 
+OPERATOR_SCHEMA(WeightedSigmoidCrossEntropyLoss)
+    .NumInputs(2, 3)
+    .NumOutputs(1)
+    .ScalarType(TensorProto::FLOAT)
+    .SetDoc(R"DOC(
+Given logits and targets of the same shape, (batch_size, num_classes), and
+optional weights, of the same shape or of shape (num_classes,) to weigh every
+task of a multi-task head, computes the scalar loss
+weights[r, c] * crossentropy(sigmoid(logits[r, c]), targets[r, c]) averaged
+over all positions r, c. This is the output of
+WeightedSigmoidCrossEntropyWithLogits (or SigmoidCrossEntropyWithLogits without
+weights) fed to AveragedLoss, computed in a single pass.
+)DOC")
+    .Input(0, "logits", "matrix of logits for each example and class.")
+    .Input(1, "targets", "matrix of targets, same shape as logits.")
+    .Input(
+        2,
+        "weights",
+        "optional weights, of the shape of logits or of their last dimension.")
+    .Output(0, "loss", "Scalar averaged loss.");
+
+OPERATOR_SCHEMA(WeightedSigmoidCrossEntropyLossGradient)
+    .NumInputs(3, 4)
+    .NumOutputs(1);
+
 struct GetMakeTwoClassGradient : public GradientMakerBase {
   using GradientMakerBase::GradientMakerBase;
   vector<OperatorDef> GetGradientDefs() override {
@@ -507,6 +612,24 @@ REGISTER_GRADIENT(
     WeightedSigmoidCrossEntropyWithLogits,
     GetWeightedSigmoidCrossEntropyWithLogitsGradient);
 
+struct GetWeightedSigmoidCrossEntropyLossGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    vector<string> inputs{GO(0), I(0), I(1)};
+    if (def_.input_size() > 2) {
+      inputs.push_back(I(2));
+    }
+    return SingleGradientDef(
+        "WeightedSigmoidCrossEntropyLossGradient",
+        "",
+        inputs,
+        vector<string>{GI(0)});
+  }
+};
+REGISTER_GRADIENT(
+    WeightedSigmoidCrossEntropyLoss,
+    GetWeightedSigmoidCrossEntropyLossGradient);
+
 REGISTER_CPU_OPERATOR(CrossEntropy,
                       CrossEntropyOp<float, CPUContext>);
 REGISTER_CPU_OPERATOR(CrossEntropyGradient,
@@ -113,6 +113,27 @@ class WeightedSigmoidCrossEntropyWithLogitsGradientOp final
   bool RunOnDevice() override;
 };
 
+// Weighted sigmoid cross entropy averaged over all the elements into a
+// scalar loss, as WeightedSigmoidCrossEntropyWithLogits followed by
+// AveragedLoss but without the intermediate tensors. The optional weights
+// have the shape of the logits or of their last dimension.
+template <typename T, class Context>
+class WeightedSigmoidCrossEntropyLossOp final : public Operator<Context> {
+ public:
+  USE_SIMPLE_CTOR_DTOR(WeightedSigmoidCrossEntropyLossOp);
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  bool RunOnDevice() override;
+};
+
+template <typename T, class Context>
+class WeightedSigmoidCrossEntropyLossGradientOp final
+    : public Operator<Context> {
+ public:
+  USE_SIMPLE_CTOR_DTOR(WeightedSigmoidCrossEntropyLossGradientOp);
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  bool RunOnDevice() override;
+};
+
 template <typename T, class Context>
 class CrossEntropyOp final : public Operator<Context> {
  public:
@@ -427,6 +427,157 @@ bool WeightedSigmoidCrossEntropyWithLogitsGradientOp<float, HIPContext>::RunOnDe
     return true;
 }
 
+namespace {
+
+// Blocks of the loss reduction, whose partial sums are added atomically to the
+// zeroed loss when there are more than one.
+constexpr int kLossMaxBlocks = 64;
+
+__device__ float loss_weight(const float* weights_ptr, const int weights_size, const int i)
+{
+    return weights_ptr == nullptr ? 1.f : weights_ptr[i % weights_size];
+}
+
+__global__ void WeightedSigmoidCrossEntropyLossKernel(const int size,
+                                                      const int weights_size,
+                                                      const bool accumulate,
+                                                      const float* logits_ptr,
+                                                      const float* targets_ptr,
+                                                      const float* weights_ptr,
+                                                      float* loss_ptr)
+{
+    float value = 0;
+    HIP_1D_KERNEL_LOOP(i, size)
+    {
+        value += sigmoid_xent_forward(logits_ptr[i], targets_ptr[i]) *
+                 loss_weight(weights_ptr, weights_size, i);
+    }
+
+    using BlockReduce = hipcub::BlockReduce<float, CAFFE_HIP_NUM_THREADS>;
+    __shared__ typename BlockReduce::TempStorage temp_storage;
+    float sum = BlockReduce(temp_storage).Sum(value);
+    if(hipThreadIdx_x == 0)
+    {
+        const float loss = -sum / size;
+        if(accumulate)
+        {
+            atomicAdd(loss_ptr, loss);
+        }
+        else
+        {
+            *loss_ptr = loss;
+        }
+    }
+}
+
+__global__ void WeightedSigmoidCrossEntropyLossGradientKernel(const int size,
+                                                              const int weights_size,
+                                                              const float* g_ptr,
+                                                              const float* logits_ptr,
+                                                              const float* targets_ptr,
+                                                              const float* weights_ptr,
+                                                              float* out_ptr)
+{
+    const float g_factor = -g_ptr[0] / size;
+    HIP_1D_KERNEL_LOOP(i, size)
+    {
+        out_ptr[i] = g_factor * sigmoid_xent_backward(logits_ptr[i], targets_ptr[i]) *
+                     loss_weight(weights_ptr, weights_size, i);
+    }
+}
+
+// Checks the weights, if any, and returns how many of them there are (0
+// without weights).
+int LossWeightsSize(const Tensor<HIPContext>& logits, const Tensor<HIPContext>* weights)
+{
+    if(weights == nullptr)
+    {
+        return 0;
+    }
+    const auto inner_size = logits.ndim() > 0 ? logits.dims().back() : 1;
+    CAFFE_ENFORCE(weights->dims() == logits.dims() ||
+                      (weights->ndim() == 1 && weights->size() == inner_size),
+                  "weights must have the shape of the logits or of their last dimension");
+    return weights->size();
+}
+} // namespace
+
+// The loss is reduced straight to its scalar, by a single block for the small
+// heads, so forward and backward take one kernel each.
+template <>
+bool WeightedSigmoidCrossEntropyLossOp<float, HIPContext>::RunOnDevice()
+{
+    auto& logits  = Input(0);
+    auto& targets = Input(1);
+    CAFFE_ENFORCE(logits.dims() == targets.dims());
+    const auto* weights    = InputSize() > 2 ? &Input(2) : nullptr;
+    const int weights_size = LossWeightsSize(logits, weights);
+    const int size         = logits.size();
+
+    auto* out = Output(0);
+    out->Resize(std::vector<TIndex>{});
+    auto* loss_ptr = out->mutable_data<float>();
+    if(size == 0)
+    {
+        math::Set<float, HIPContext>(1, 0.f, loss_ptr, &context_);
+        return true;
+    }
+
+    const int blocks = std::min(CAFFE_GET_BLOCKS(size), kLossMaxBlocks);
+    if(blocks > 1)
+    {
+        math::Set<float, HIPContext>(1, 0.f, loss_ptr, &context_);
+    }
+    hipLaunchKernelGGL((WeightedSigmoidCrossEntropyLossKernel),
+                       dim3(blocks),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       size,
+                       weights_size,
+                       blocks > 1,
+                       logits.data<float>(),
+                       targets.data<float>(),
+                       weights_size > 0 ? weights->data<float>() : nullptr,
+                       loss_ptr);
+    return true;
+}
+
+template <>
+bool WeightedSigmoidCrossEntropyLossGradientOp<float, HIPContext>::RunOnDevice()
+{
+    auto& g       = Input(0);
+    auto& logits  = Input(1);
+    auto& targets = Input(2);
+    CAFFE_ENFORCE(logits.dims() == targets.dims());
+    CAFFE_ENFORCE_EQ(g.size(), 1);
+    const auto* weights    = InputSize() > 3 ? &Input(3) : nullptr;
+    const int weights_size = LossWeightsSize(logits, weights);
+    const int size         = logits.size();
+
+    auto* out = Output(0);
+    out->ResizeLike(logits);
+    auto* out_ptr = out->mutable_data<float>();
+    if(size == 0)
+    {
+        return true;
+    }
+
+    hipLaunchKernelGGL((WeightedSigmoidCrossEntropyLossGradientKernel),
+                       dim3(CAFFE_GET_BLOCKS(size)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       size,
+                       weights_size,
+                       g.data<float>(),
+                       logits.data<float>(),
+                       targets.data<float>(),
+                       weights_size > 0 ? weights->data<float>() : nullptr,
+                       out_ptr);
+    return true;
+}
+
 REGISTER_HIP_OPERATOR(LabelCrossEntropy, LabelCrossEntropyOp<float, HIPContext>);
 REGISTER_HIP_OPERATOR(LabelCrossEntropyGradient, LabelCrossEntropyGradientOp<float, HIPContext>);
 
@@ -440,6 +591,11 @@ REGISTER_HIP_OPERATOR(WeightedSigmoidCrossEntropyWithLogits,
 REGISTER_HIP_OPERATOR(WeightedSigmoidCrossEntropyWithLogitsGradient,
                       WeightedSigmoidCrossEntropyWithLogitsGradientOp<float, HIPContext>);
 
+REGISTER_HIP_OPERATOR(WeightedSigmoidCrossEntropyLoss,
+                      WeightedSigmoidCrossEntropyLossOp<float, HIPContext>);
+REGISTER_HIP_OPERATOR(WeightedSigmoidCrossEntropyLossGradient,
+                      WeightedSigmoidCrossEntropyLossGradientOp<float, HIPContext>);
+
 REGISTER_HIP_OPERATOR(MakeTwoClass, MakeTwoClassOp<float, HIPContext>);
 REGISTER_HIP_OPERATOR(MakeTwoClassGradient, MakeTwoClassGradientOp<float, HIPContext>);
 
@@ -113,19 +113,15 @@ void TreeIterator::advance(
     std::vector<TOffset>& sizes,
     std::vector<TOffset>& limits,
     TOffset num) {
-  std::vector<TOffset> newOffsets;
   CAFFE_ENFORCE_EQ(lengths.size(), numLengthFields());
   CAFFE_ENFORCE_EQ(offsets.size(), numOffsetFields());
   sizes.resize(offsets.size());
-  newOffsets.resize(offsets.size());
   // first index, top level
   {
     auto limit = limits[0];
     auto offset = offsets[0];
     CAFFE_ENFORCE(limit >= offset, "Tried to advance past end of cursor.");
-    TOffset total = std::min(limit - offset, num);
-    sizes[0] = total;
-    newOffsets[0] = offset + total;
+    sizes[0] = std::min(limit - offset, num);
   }
   // child indices
   for (int j = 1; j < numOffsetFields(); ++j) {
@@ -142,9 +138,40 @@ void TreeIterator::advance(
         "tried to advance past the end of field ",
         j);
     sizes[j] = total;
-    newOffsets[j] = offset + total;
   }
-  offsets = newOffsets;
+  // only move the offsets once every field is known to be consistent
+  for (int j = 0; j < numOffsetFields(); ++j) {
+    offsets[j] += sizes[j];
+  }
+}
+
+TreeBatchPlan::TreeBatchPlan(const TreeIterator& it) {
+  for (const auto& field : it.fields()) {
+    fieldOffsetIds.push_back(it.offsetFieldIdFor(field));
+  }
+  parentOffsetIds.assign(1, -1);
+  for (int j = 0; j < it.numLengthFields(); ++j) {
+    const auto& lengthField = it.lengthField(j);
+    parentOffsetIds.push_back(it.offsetFieldIdFor(lengthField));
+    lengthInputIds.push_back(lengthField.id);
+  }
+  lengths.resize(lengthInputIds.size());
+  limits.resize(parentOffsetIds.size());
+  sizes.resize(parentOffsetIds.size());
+}
+
+void TreeBatchPlan::gather(const std::vector<const TensorCPU*>& inputs) {
+  static const TLength lenZero = 0;
+  CAFFE_ENFORCE_EQ(inputs.size(), fieldOffsetIds.size());
+  for (int i = 0; i < lengths.size(); ++i) {
+    const auto& in = *inputs[lengthInputIds[i]];
+    lengths[i] = in.size() > 0 ? in.data<int>() : &lenZero;
+  }
+  std::fill(limits.begin(), limits.end(), std::numeric_limits<TOffset>::max());
+  for (int i = 0; i < inputs.size(); ++i) {
+    auto& limit = limits[fieldOffsetIds[i]];
+    limit = std::min(limit, (TOffset)inputs[i]->dims()[0]);
+  }
 }
 
 TreeWalker::TreeWalker(const vector<const Blob*>& inputs, TreeCursor& cursor)
@@ -449,6 +476,23 @@ class UnPackRecordsOp : public Operator<CPUContext> {
   std::vector<std::string> fields_;
 };
 
+// Keeps the TreeBatchPlan of the cursor an op reads from, rebuilding it if
+// the op is given a different cursor.
+class TreeBatchPlanHolder {
+ public:
+  TreeBatchPlan& plan(const TreeCursor* cursor) {
+    if (cursor != cursor_) {
+      plan_.reset(new TreeBatchPlan(cursor->it));
+      cursor_ = cursor;
+    }
+    return *plan_;
+  }
+
+ private:
+  const TreeCursor* cursor_ = nullptr;
+  std::unique_ptr<TreeBatchPlan> plan_;
+};
+
 class ReadNextBatchOp : public Operator<CPUContext> {
  public:
   ReadNextBatchOp(const OperatorDef& operator_def, Workspace* ws)
@@ -461,37 +505,22 @@ class ReadNextBatchOp : public Operator<CPUContext> {
   bool RunOnDevice() override {
     auto& cursor = OperatorBase::Input<std::unique_ptr<TreeCursor>>(0);
     CAFFE_ENFORCE(InputSize() == cursor->it.fields().size() + 1);
-    std::vector<const TLength*> lengths;
-    std::vector<TOffset> limits;
-    std::vector<TOffset> sizes;
-    std::vector<TOffset> offsets;
-    TLength lenZero = 0;
-    sizes.resize(cursor->it.numOffsetFields());
-    // gather length data
-    lengths.resize(cursor->it.numLengthFields());
-    for (int i = 0; i < lengths.size(); ++i) {
-      auto& a = Input(cursor->it.lengthField(i).id + 1);
-      if (a.size() > 0) {
-        lengths[i] = a.data<int>();
-      } else {
-        lengths[i] = &lenZero;
-      }
-    }
-    // gather size limits
-    limits.assign(sizes.size(), std::numeric_limits<TOffset>::max());
-    for (int i = 0; i < cursor->it.fields().size(); ++i) {
-      int lengthFieldIdx = cursor->it.fields()[i].lengthFieldId + 1;
-      limits[lengthFieldIdx] =
-          std::min(limits[lengthFieldIdx], (TOffset)Input(i + 1).dims()[0]);
+    auto& plan = holder_.plan(cursor.get());
+    auto& sizes = plan.sizes;
+    inputs_.resize(InputSize() - 1);
+    for (int i = 0; i < inputs_.size(); ++i) {
+      inputs_[i] = &Input(i + 1);
     }
+    plan.gather(inputs_);
     // advance cursor
     {
       std::lock_guard<std::mutex> lock(cursor->mutex_);
       if (cursor->offsets.empty()) {
         cursor->offsets.assign(sizes.size(), 0);
       }
-      offsets = cursor->offsets;
-      cursor->it.advance(lengths, cursor->offsets, sizes, limits, batchSize_);
+      offsets_ = cursor->offsets;
+      cursor->it.advance(
+          plan.lengths, cursor->offsets, sizes, plan.limits, batchSize_);
       if (enforceBatchSize_ && sizes[0] < batchSize_) {
         // if we enforce batch_size but don't have enough rows left to
         // complete a full batch, return empty for all columns.
@@ -499,18 +528,18 @@ class ReadNextBatchOp : public Operator<CPUContext> {
         sizes.assign(sizes.size(), 0);
       }
     }
-    // gather data
-    std::vector<TIndex> outDim;
-    for (int i = 0; i < cursor->it.fields().size(); ++i) {
-      auto lengthIdx = cursor->it.fields()[i].lengthFieldId + 1;
+    // gather data: every field of the batch is one contiguous range of its
+    // input. Resizing to a size the output already had keeps its buffer.
+    for (int i = 0; i < inputs_.size(); ++i) {
+      auto lengthIdx = plan.fieldOffsetIds[i];
       auto size = sizes[lengthIdx];
-      auto offset = offsets[lengthIdx];
-      auto& in = Input(i + 1);
+      auto offset = offsets_[lengthIdx];
+      auto& in = *inputs_[i];
       auto innerSize = in.size_from_dim(1);
-      outDim = in.dims();
-      outDim[0] = size;
+      outDim_ = in.dims();
+      outDim_[0] = size;
       auto* out = Output(i);
-      out->Resize(outDim);
+      out->Resize(outDim_);
       void* src =
           (char*)in.raw_data() + offset * innerSize * in.meta().itemsize();
       void* dst = out->raw_mutable_data(in.meta()); // create the tensor
@@ -524,6 +553,10 @@ class ReadNextBatchOp : public Operator<CPUContext> {
   }
   int batchSize_;
   bool enforceBatchSize_;
+  TreeBatchPlanHolder holder_;
+  std::vector<const TensorCPU*> inputs_;
+  std::vector<TOffset> offsets_;
+  std::vector<TIndex> outDim_;
 };
 
 class ComputeOffsetOp : public Operator<CPUContext> {
@@ -535,44 +568,54 @@ class ComputeOffsetOp : public Operator<CPUContext> {
     auto& cursor = OperatorBase::Input<std::unique_ptr<TreeCursor>>(0);
     CAFFE_ENFORCE(InputSize() == cursor->it.fields().size() + 1);
     auto* out = Output(0);
-    std::vector<const TLength*> lengths;
-    std::vector<TOffset> limits;
-    std::vector<TOffset> sizes;
-    std::vector<TOffset> offsets;
-    TLength lenZero = 0;
-    sizes.resize(cursor->it.numOffsetFields());
-    // gather length data
-    lengths.resize(cursor->it.numLengthFields());
-    for (int i = 0; i < lengths.size(); ++i) {
-      auto& a = Input(cursor->it.lengthField(i).id + 1);
-      if (a.size() > 0) {
-        lengths[i] = a.data<int>();
-      } else {
-        lengths[i] = &lenZero;
-      }
+    auto& plan = holder_.plan(cursor.get());
+    const auto& limits = plan.limits;
+    const int numOffsets = plan.sizes.size();
+    inputs_.resize(InputSize() - 1);
+    for (int i = 0; i < inputs_.size(); ++i) {
+      inputs_[i] = &Input(i + 1);
     }
-    // gather size limits
-    limits.assign(sizes.size(), std::numeric_limits<TOffset>::max());
-    for (int i = 0; i < cursor->it.fields().size(); ++i) {
-      int lengthFieldIdx = cursor->it.fields()[i].lengthFieldId + 1;
-      limits[lengthFieldIdx] =
-          std::min(limits[lengthFieldIdx], (TOffset)Input(i + 1).dims()[0]);
+    plan.gather(inputs_);
+    if (cursor->offsets.empty()) {
+      cursor->offsets.assign(numOffsets, 0);
     }
-    out->Resize(limits.at(0) + 1, sizes.size());
+    const auto& start = cursor->offsets;
+    CAFFE_ENFORCE(
+        limits[0] >= start[0], "Tried to advance past end of cursor.");
+    // Row k holds the offsets after advancing the cursor by k records. Each
+    // column is a running sum of the lengths of its parent column, so the
+    // whole matrix is filled in one pass over the length fields.
+    const TOffset numRows = limits[0] + 1;
+    out->Resize(numRows, numOffsets);
     auto* out_data = out->mutable_data<int64_t>();
-    for (int k = 0; k <= limits.at(0); k++) {
-      // advance cursor
-      if (cursor->offsets.empty()) {
-        cursor->offsets.assign(sizes.size(), 0);
+    for (TOffset k = 0; k < numRows; ++k) {
+      out_data[k * numOffsets] = std::min(start[0] + k, limits[0]);
+    }
+    for (int j = 1; j < numOffsets; ++j) {
+      const int parent = plan.parentOffsetIds[j];
+      const TLength* length = plan.lengths[j - 1];
+      TOffset pos = start[parent];
+      TOffset offset = start[j];
+      for (TOffset k = 0; k < numRows; ++k) {
+        const TOffset parentOffset = out_data[k * numOffsets + parent];
+        for (; pos < parentOffset; ++pos) {
+          offset += length[pos];
+        }
+        out_data[k * numOffsets + j] = offset;
       }
-      // write output
-      std::copy(cursor->offsets.begin(), cursor->offsets.end(), out_data);
-      out_data += sizes.size();
-      cursor->it.advance(lengths, cursor->offsets, sizes, limits, 1);
+      CAFFE_ENFORCE(
+          offset <= limits[j],
+          "Inconsistent field length: ",
+          "tried to advance past the end of field ",
+          j);
     }
-    cursor->offsets.assign(sizes.size(), 0); // reSet after getting meta info
+    cursor->offsets.assign(numOffsets, 0); // reSet after getting meta info
     return true;
   }
+
+ private:
+  TreeBatchPlanHolder holder_;
+  std::vector<const TensorCPU*> inputs_;
 };
 
 class SortAndShuffleOp : public Operator<CPUContext> {
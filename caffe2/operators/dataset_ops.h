@@ -65,7 +65,7 @@ class TreeIterator {
   }
 
   // Get lengthField description for the given field
-  const FieldDesc* lengthFieldFor(const FieldDesc& desc) {
+  const FieldDesc* lengthFieldFor(const FieldDesc& desc) const {
     return (desc.lengthFieldId == -1)
         ? nullptr
         : &fields_.at(lengthFieldIds_.at(desc.lengthFieldId));
@@ -73,17 +73,17 @@ class TreeIterator {
 
   // Get lengthField description for the given lengthFieldId, where
   // 0 <= lengthFieldId < numLengthFields()
-  const FieldDesc& lengthField(int lengthFieldId) {
+  const FieldDesc& lengthField(int lengthFieldId) const {
     return fields_.at(lengthFieldIds_.at(lengthFieldId));
   }
 
   // Returns the index into the 'offset' vector for the given field.
-  int offsetFieldIdFor(const FieldDesc& fieldDesc) {
+  int offsetFieldIdFor(const FieldDesc& fieldDesc) const {
     return fieldDesc.lengthFieldId + 1;
   }
 
   // Returns the field description for all fields.
-  const std::vector<FieldDesc>& fields() {
+  const std::vector<FieldDesc>& fields() const {
     return fields_;
   }
 
@@ -106,6 +106,29 @@ class TreeCursor {
   TreeIterator it;
 };
 
+/**
+ * Layout of a dataset's schema as ReadNextBatch and ComputeOffset use it,
+ * built once from the cursor's TreeIterator: the offset entry every field is
+ * read at and the parent entry of every offset entry. The lengths, limits and
+ * sizes vectors are kept between batches, so reading a batch doesn't allocate.
+ */
+struct TreeBatchPlan {
+  explicit TreeBatchPlan(const TreeIterator& it);
+
+  // Points lengths at the length fields of inputs, where inputs[i] holds
+  // field i, and recomputes the limit of every offset entry.
+  void gather(const std::vector<const TensorCPU*>& inputs);
+
+  std::vector<int> fieldOffsetIds;
+  // parentOffsetIds[j] is the offset entry of the lengths of entry j; entry 0
+  // is the top level and has none.
+  std::vector<int> parentOffsetIds;
+  std::vector<int> lengthInputIds;
+  std::vector<const TLength*> lengths;
+  std::vector<TOffset> limits;
+  std::vector<TOffset> sizes;
+};
+
 /**
  * Simple wrapper class allowing an easy traversal of the tensors representing
  * the hirerarchical structure.
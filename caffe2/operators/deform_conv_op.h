@@ -19,6 +19,7 @@
 
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/core/scratch_arena.h"
 #include "caffe2/operators/conv_op_shared.h"
 #include "caffe2/operators/conv_pool_op_base.h"
 
@@ -86,7 +87,10 @@ class DeformConvOp final : public DeformConvOpBase<T, Context> {
   bool RunOnDeviceWithOrderNCHW() override;
 
  private:
-  Tensor<Context> col_buffer_;
+  // Computes the already sized output straight from the input, without col
+  // buffer, or returns false if Context has no such implementation.
+  bool RunWithoutColBuffer();
+
   Tensor<Context> bias_multiplier_;
   Tensor<Context> img_shape_device_;
   Tensor<Context> col_buffer_shape_device_;
@@ -112,7 +116,12 @@ class DeformConvGradientOp final : public DeformConvOpBase<T, Context> {
   bool RunOnDeviceWithOrderNCHW() override;
 
  private:
-  Tensor<Context> col_buffer_;
+  // Number of images whose column buffers are filled and consumed by a
+  // single launch of the im2col, col2im and col2im_coord helpers. The
+  // default is one image at a time; devices that gain from fewer and larger
+  // launches specialize it.
+  int ImagesPerLaunch(int num_images, int col_buffer_image_size);
+
   Tensor<Context> bias_multiplier_;
   Tensor<Context> img_shape_device_;
   Tensor<Context> col_buffer_shape_device_;
@@ -80,6 +80,7 @@
 #include "caffe2/core/context_hip.h"
 #include "caffe2/operators/deform_conv_op.h"
 #include "caffe2/operators/deform_conv_op_impl.h"
+#include "caffe2/operators/implicit_gemm_conv_hip.h"
 #include "hip/hip_runtime.h"
 
 namespace caffe2 {
@@ -653,6 +654,143 @@ void DeformConvOpBase<DType, Context>::DeformableCol2imCoord(const DType* data_c
                        grad_offset);
 }
 
+namespace {
+
+// The deformable convolution of one image and group as an implicit GEMM:
+// z is image * group + group index, m the output channel of the group, k the
+// (input channel of the group, kernel row, kernel column) and p the output
+// position. B samples the input like deformable_im2col_gpu_kernel.
+struct DeformConvLoader
+{
+    const float* X;
+    const float* offset;
+    const float* filter;
+    const float* bias;
+    float* Y;
+    int channels;
+    int height;
+    int width;
+    int group;
+    int group_channels;
+    int group_outputs;
+    int kernel_h;
+    int kernel_w;
+    int pad_h;
+    int pad_w;
+    int stride_h;
+    int stride_w;
+    int dilation_h;
+    int dilation_w;
+    int channel_per_deformable_group;
+    int deformable_group;
+    int height_col;
+    int width_col;
+
+    __device__ float A(const int z, const int m, const int k) const
+    {
+        const int g = z % group;
+        return filter[(g * group_outputs + m) * group_channels * kernel_h * kernel_w + k];
+    }
+
+    __device__ float B(const int z, const int k, const int p) const
+    {
+        const int n     = z / group;
+        const int c     = (z % group) * group_channels + k / (kernel_h * kernel_w);
+        const int i     = (k / kernel_w) % kernel_h;
+        const int j     = k % kernel_w;
+        const int h_col = p / width_col;
+        const int w_col = p % width_col;
+        const int h_in  = h_col * stride_h - pad_h;
+        const int w_in  = w_col * stride_w - pad_w;
+        const int col_size = height_col * width_col;
+        const float* data_offset =
+            offset + (n * deformable_group + c / channel_per_deformable_group) * 2 * kernel_h *
+                         kernel_w * col_size;
+        const float offset_h = data_offset[2 * (i * kernel_w + j) * col_size + p];
+        const float offset_w = data_offset[(2 * (i * kernel_w + j) + 1) * col_size + p];
+        const float h_im     = h_in + i * dilation_h + offset_h;
+        const float w_im     = w_in + j * dilation_w + offset_w;
+        if(h_im < 0 || w_im < 0 || h_im >= height || w_im >= width)
+        {
+            return 0.f;
+        }
+        return deformable_im2col_bilinear(X + ((n * channels + c) * height + h_in) * width + w_in,
+                                          width,
+                                          height - h_in,
+                                          width - w_in,
+                                          i * dilation_h + offset_h,
+                                          j * dilation_w + offset_w);
+    }
+
+    __device__ void Store(const int z, const int m, const int p, const float value) const
+    {
+        const int n       = z / group;
+        const int channel = (z % group) * group_outputs + m;
+        Y[(n * group * group_outputs + channel) * height_col * width_col + p] =
+            bias ? value + bias[channel] : value;
+    }
+};
+
+} // namespace
+
+template <>
+bool DeformConvOp<float, HIPContext>::RunWithoutColBuffer()
+{
+    const auto& X      = Input(INPUT);
+    const auto& offset = Input(OFFSET);
+    const auto& filter = Input(FILTER);
+    auto* Y            = Output(0);
+    CAFFE_ENFORCE_EQ(pad_t(), pad_b());
+    CAFFE_ENFORCE_EQ(pad_l(), pad_r());
+
+    DeformConvLoader loader;
+    loader.X                            = X.data<float>();
+    loader.offset                       = offset.data<float>();
+    loader.filter                       = filter.data<float>();
+    loader.bias                         = InputSize() == 4 ? Input(BIAS).data<float>() : nullptr;
+    loader.Y                            = Y->mutable_data<float>();
+    loader.channels                     = X.dim32(1);
+    loader.height                       = X.dim32(2);
+    loader.width                        = X.dim32(3);
+    loader.group                        = group_;
+    loader.group_channels               = X.dim32(1) / group_;
+    loader.group_outputs                = filter.dim32(0) / group_;
+    loader.kernel_h                     = kernel_h();
+    loader.kernel_w                     = kernel_w();
+    loader.pad_h                        = pad_t();
+    loader.pad_w                        = pad_l();
+    loader.stride_h                     = stride_h();
+    loader.stride_w                     = stride_w();
+    loader.dilation_h                   = dilation_h();
+    loader.dilation_w                   = dilation_w();
+    loader.channel_per_deformable_group = X.dim32(1) / deformable_group_;
+    loader.deformable_group             = deformable_group_;
+    loader.height_col                   = Y->dim32(2);
+    loader.width_col                    = Y->dim32(3);
+
+    implicit_gemm::ImplicitGemm(X.dim32(0) * group_,
+                                loader.group_outputs,
+                                loader.height_col * loader.width_col,
+                                loader.group_channels * kernel_h() * kernel_w(),
+                                loader,
+                                &context_);
+    return true;
+}
+
+// Upper bound of the column buffer of the gradient. Up to that size the
+// columns of several images are computed by one kernel launch instead of one
+// launch per image.
+static constexpr size_t kDeformConvGradientColBufferBytes = 64 * 1024 * 1024;
+
+template <>
+int DeformConvGradientOp<float, HIPContext>::ImagesPerLaunch(int num_images,
+                                                             int col_buffer_image_size)
+{
+    const size_t image_bytes = static_cast<size_t>(col_buffer_image_size) * sizeof(float);
+    const size_t images      = kDeformConvGradientColBufferBytes / std::max<size_t>(image_bytes, 1);
+    return std::max(1, std::min(num_images, static_cast<int>(images)));
+}
+
 REGISTER_HIP_OPERATOR(DeformConv, DeformConvOp<float, HIPContext>);
 REGISTER_HIP_OPERATOR(DeformConvGradient, DeformConvGradientOp<float, HIPContext>);
 
@@ -28,6 +28,11 @@
 
 namespace caffe2 {
 
+template <typename T, class Context>
+bool DeformConvOp<T, Context>::RunWithoutColBuffer() {
+  return false;
+}
+
 template <typename T, class Context>
 bool DeformConvOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   const Tensor<Context>& X = Input(INPUT);
@@ -148,6 +153,9 @@ bool DeformConvOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   if (InputSize() == 4) {
     bias_data = Input(BIAS).template data<T>();
   }
+  if (RunWithoutColBuffer()) {
+    return true;
+  }
 
   auto f = [&](Tensor<Context>* col_buffer) {
     col_buffer->Resize(buffer_shape);
@@ -198,11 +206,19 @@ bool DeformConvOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
     runWithSharedBuffer<Context>(ws_, f);
   } else {
-    f(&col_buffer_);
+    auto col_buffer = context_.scratch_arena()->Borrow();
+    f(col_buffer.get());
   }
   return true;
 }
 
+template <typename T, class Context>
+int DeformConvGradientOp<T, Context>::ImagesPerLaunch(
+    int /* num_images */,
+    int /* col_buffer_image_size */) {
+  return 1;
+}
+
 template <typename T, class Context>
 bool DeformConvGradientOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   auto& X = Input(INPUT);
@@ -289,22 +305,23 @@ bool DeformConvGradientOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   const int filter_offset = filter.size() / group_;
 
   // The col buffer is stored in CHW order as well - kernel_dim, and the
-  // height and width.
-  vector<TIndex> img_shape;
-  img_shape.assign(X.dims().begin() + 1, X.dims().end());
+  // height and width. It holds the columns of images_per_launch images, one
+  // after the other.
+  const int col_buffer_image_size = C * kernel_dims_size * output_image_size;
+  const int col_buffer_offset = col_buffer_image_size / group_;
+  const int images_per_launch = ImagesPerLaunch(N, col_buffer_image_size);
   vector<TIndex> col_buffer_shape;
-  col_buffer_shape.push_back(C * kernel_dims_size);
+  col_buffer_shape.push_back(images_per_launch * C * kernel_dims_size);
   col_buffer_shape.insert(
       col_buffer_shape.end(), output_dims.begin(), output_dims.end());
-  col_buffer_.Resize(col_buffer_shape);
-
-  const int col_buffer_offset = col_buffer_.size() / group_;
+  auto col_buffer = context_.scratch_arena()->Borrow();
+  col_buffer->Resize(col_buffer_shape);
 
   const T* Xdata = X.template data<T>();
   const T* filter_data = filter.template data<T>();
   const T* offset_data = offset.template data<T>();
   const T* dYdata = dY.template data<T>();
-  T* col_buffer_data = col_buffer_.template mutable_data<T>();
+  T* col_buffer_data = col_buffer->template mutable_data<T>();
   T* dfilter_data = dfilter->template mutable_data<T>();
   T* doffset_data = doffset->template mutable_data<T>();
 
@@ -336,75 +353,96 @@ bool DeformConvGradientOp<T, Context>::RunOnDeviceWithOrderNCHW() {
     math::Set<T, Context>(dX->size(), 0, dXdata, &context_);
   }
 
-  for (int image_id = 0; image_id < N; ++image_id) {
-    for (int group_id = 0; group_id < group_; ++group_id) {
-      math::Gemm<T, Context>(
-          CblasTrans,
-          CblasNoTrans,
-          kernel_dim,
-          output_image_size,
-          M / group_,
-          1,
-          filter_data + group_id * filter_offset,
-          dYdata + group_id * output_offset,
-          0,
-          col_buffer_data + group_id * col_buffer_offset,
-          &context_);
+  for (int image_id = 0; image_id < N; image_id += images_per_launch) {
+    const int images = std::min(images_per_launch, N - image_id);
+    for (int i = 0; i < images; ++i) {
+      for (int group_id = 0; group_id < group_; ++group_id) {
+        math::Gemm<T, Context>(
+            CblasTrans,
+            CblasNoTrans,
+            kernel_dim,
+            output_image_size,
+            M / group_,
+            1,
+            filter_data + group_id * filter_offset,
+            dYdata + (i * group_ + group_id) * output_offset,
+            0,
+            col_buffer_data + i * col_buffer_image_size +
+                group_id * col_buffer_offset,
+            &context_);
+      }
     }
 
+    // The helpers see the images of the launch as a single image with
+    // images * C channels and images * deformable_group_ offset groups, which
+    // is how consecutive images are laid out in X, offset and the col buffer.
+    vector<TIndex> launch_img_shape{1, images * C, X.dim(2), X.dim(3)};
+    vector<TIndex> launch_col_shape(col_buffer_shape);
+    launch_col_shape[0] = images * C * kernel_dims_size;
+    const int deformable_group = deformable_group_;
+    deformable_group_ *= images;
+
     // Gradient with respect to offsets
     DeformableCol2imCoord(
         col_buffer_data,
         Xdata,
         offset_data,
-        X.dims(),
-        col_buffer_shape,
+        launch_img_shape,
+        launch_col_shape,
         doffset_data);
 
     // Gradient with respect to input data
     if (dXdata) {
       DeformableCol2im(
-          col_buffer_data, offset_data, X.dims(), col_buffer_shape, dXdata);
-      dXdata += input_offset * group_;
+          col_buffer_data,
+          offset_data,
+          launch_img_shape,
+          launch_col_shape,
+          dXdata);
+      dXdata += input_offset * group_ * images;
     }
 
     // Gradient with respect to filter
     DeformableIm2col(
-        Xdata, offset_data, X.dims(), col_buffer_shape, col_buffer_data);
-
-    for (int group_id = 0; group_id < group_; ++group_id) {
-      math::Gemm<T, Context>(
-          CblasNoTrans,
-          CblasTrans,
-          M / group_,
-          kernel_dim,
-          output_image_size,
-          1,
-          dYdata + group_id * output_offset,
-          col_buffer_data + group_id * col_buffer_offset,
-          1,
-          dfilter_data + group_id * filter_offset,
-          &context_);
-    }
+        Xdata, offset_data, launch_img_shape, launch_col_shape, col_buffer_data);
+    deformable_group_ = deformable_group;
 
-    // Gradient with respect to bias
-    if (dbias_data) {
-      math::Gemv<T, Context>(
-          CblasNoTrans,
-          M,
-          output_image_size,
-          1,
-          dYdata,
-          bias_multiplier_.template data<T>(),
-          1,
-          dbias_data,
-          &context_);
+    for (int i = 0; i < images; ++i) {
+      for (int group_id = 0; group_id < group_; ++group_id) {
+        math::Gemm<T, Context>(
+            CblasNoTrans,
+            CblasTrans,
+            M / group_,
+            kernel_dim,
+            output_image_size,
+            1,
+            dYdata + (i * group_ + group_id) * output_offset,
+            col_buffer_data + i * col_buffer_image_size +
+                group_id * col_buffer_offset,
+            1,
+            dfilter_data + group_id * filter_offset,
+            &context_);
+      }
+
+      // Gradient with respect to bias
+      if (dbias_data) {
+        math::Gemv<T, Context>(
+            CblasNoTrans,
+            M,
+            output_image_size,
+            1,
+            dYdata + i * output_offset * group_,
+            bias_multiplier_.template data<T>(),
+            1,
+            dbias_data,
+            &context_);
+      }
     }
 
-    Xdata += input_offset * group_;
-    dYdata += output_offset * group_;
-    offset_data += offset_offset;
-    doffset_data += offset_offset;
+    Xdata += input_offset * group_ * images;
+    dYdata += output_offset * group_ * images;
+    offset_data += offset_offset * images;
+    doffset_data += offset_offset * images;
   }
 
   return true;
@@ -0,0 +1,255 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/operators/load_save_op.h"
+
+namespace caffe2 {
+
+namespace {
+constexpr auto kDeltaRowsSuffix = "_rows";
+constexpr auto kDeltaIndicesSuffix = "_indices";
+} // namespace
+
+class MarkDirtyRowsOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  MarkDirtyRowsOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(
+        this, Input(INDICES));
+  }
+
+  template <typename SIndex>
+  bool DoRunWithType() {
+    const auto& param = Input(PARAM);
+    const auto& indices = Input(INDICES);
+    auto* dirty = Output(DIRTY);
+    CAFFE_ENFORCE_GT(param.ndim(), 0, "PARAM has to have rows.");
+    const TIndex rows = param.dim(0);
+    if (dirty->size() != rows) {
+      // First run, or the table grew: new rows start clean.
+      TensorCPU old;
+      if (dirty->size() > 0) {
+        old.CopyFrom(*dirty);
+      }
+      dirty->Resize(rows);
+      auto* dirty_data = dirty->template mutable_data<uint8_t>();
+      memset(dirty_data, 0, rows);
+      if (old.size() > 0) {
+        memcpy(
+            dirty_data,
+            old.template data<uint8_t>(),
+            std::min<TIndex>(old.size(), rows));
+      }
+    }
+    auto* dirty_data = dirty->template mutable_data<uint8_t>();
+    const auto* indices_data = indices.template data<SIndex>();
+    for (TIndex i = 0; i < indices.size(); ++i) {
+      const SIndex idx = indices_data[i];
+      CAFFE_ENFORCE(
+          0 <= idx && idx < rows,
+          "Index out of bounds: ",
+          idx,
+          ", range 0 to ",
+          rows);
+      dirty_data[idx] = 1;
+    }
+    return true;
+  }
+
+ protected:
+  INPUT_TAGS(PARAM, INDICES);
+  OUTPUT_TAGS(DIRTY);
+};
+
+class SaveDeltaOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  SaveDeltaOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        ws_(ws),
+        absolute_path_(GetSingleArgument<int>("absolute_path", false)),
+        db_pattern_(GetSingleArgument<string>("db", "")),
+        db_type_(GetSingleArgument<string>("db_type", "")),
+        every_(GetSingleArgument<int>("every", 1)),
+        full_every_(GetSingleArgument<int>("full_every", 0)),
+        num_params_(OutputSize()) {
+    CAFFE_ENFORCE_GT(db_pattern_.size(), 0, "Must specify a db pattern.");
+    CAFFE_ENFORCE_GT(db_type_.size(), 0, "Must specify a db type.");
+    CAFFE_ENFORCE_GT(every_, 0, "Checkpoint interval should be positive.");
+    CAFFE_ENFORCE_GE(full_every_, 0);
+    CAFFE_ENFORCE_EQ(
+        InputSize(),
+        1 + 2 * num_params_,
+        "SaveDelta takes the iteration, then the params, then their dirty "
+        "rows.");
+    for (int i = 0; i < num_params_; ++i) {
+      CAFFE_ENFORCE_EQ(
+          operator_def.input(1 + num_params_ + i),
+          operator_def.output(i),
+          "The dirty rows are cleared in place.");
+      names_.push_back(operator_def.input(1 + i));
+    }
+  }
+
+  bool RunOnDevice() override {
+    const int64_t iter = Input(0).template data<int64_t>()[0];
+    const bool full = full_every_ > 0 && iter % full_every_ == 0;
+    if (!full && iter % every_ != 0) {
+      return true;
+    }
+    const string db_name = FormatString(db_pattern_, iter);
+    const string full_db_name =
+        absolute_path_ ? db_name : (ws_->RootFolder() + "/" + db_name);
+    std::unique_ptr<db::DB> out_db(
+        db::CreateDB(db_type_, full_db_name, db::NEW));
+    CAFFE_ENFORCE(out_db.get(), "Cannot open db for writing: ", full_db_name);
+    BlobSerializerBase::SerializationAcceptor acceptor =
+        [&](const std::string& blobName, const std::string& data) {
+          auto transaction = out_db->NewTransaction();
+          transaction->Put(blobName, data);
+          transaction->Commit();
+        };
+
+    for (int i = 0; i < num_params_; ++i) {
+      const auto& param = Input(1 + i);
+      auto* dirty = Output(i);
+      if (full) {
+        Blob blob;
+        blob.ShareExternal<TensorCPU>(const_cast<TensorCPU*>(&param));
+        blob.Serialize(names_[i], acceptor);
+      } else {
+        SaveDirtyRows(param, *dirty, names_[i], acceptor);
+      }
+      if (dirty->size() > 0) {
+        memset(dirty->template mutable_data<uint8_t>(), 0, dirty->size());
+      }
+    }
+    out_db->Close();
+    return true;
+  }
+
+ private:
+  void SaveDirtyRows(
+      const TensorCPU& param,
+      const TensorCPU& dirty,
+      const string& name,
+      BlobSerializerBase::SerializationAcceptor acceptor) {
+    CAFFE_ENFORCE(
+        param.meta().copy() == nullptr,
+        "Only tensors of fundamental types can be saved as deltas.");
+    CAFFE_ENFORCE_GT(param.ndim(), 0);
+    const uint8_t* dirty_data =
+        dirty.size() > 0 ? dirty.template data<uint8_t>() : nullptr;
+    // Rows added after the last MarkDirtyRows are not tracked yet.
+    const TIndex tracked = std::min<TIndex>(dirty.size(), param.dim(0));
+    Blob indices_blob;
+    auto* indices = indices_blob.GetMutable<TensorCPU>();
+    vector<int64_t> dirty_rows;
+    for (TIndex r = 0; r < tracked; ++r) {
+      if (dirty_data[r]) {
+        dirty_rows.push_back(r);
+      }
+    }
+    indices->Resize(dirty_rows.size());
+    std::copy(
+        dirty_rows.begin(),
+        dirty_rows.end(),
+        indices->template mutable_data<int64_t>());
+
+    Blob rows_blob;
+    auto* rows = rows_blob.GetMutable<TensorCPU>();
+    vector<TIndex> dims = param.dims();
+    dims[0] = dirty_rows.size();
+    rows->Resize(dims);
+    const size_t row_bytes = param.size_from_dim(1) * param.itemsize();
+    char* dst = static_cast<char*>(rows->raw_mutable_data(param.meta()));
+    const char* src = static_cast<const char*>(param.raw_data());
+    for (const auto r : dirty_rows) {
+      memcpy(dst, src + r * row_bytes, row_bytes);
+      dst += row_bytes;
+    }
+    rows_blob.Serialize(name + kDeltaRowsSuffix, acceptor);
+    indices_blob.Serialize(name + kDeltaIndicesSuffix, acceptor);
+  }
+
+  Workspace* ws_;
+  bool absolute_path_;
+  string db_pattern_;
+  string db_type_;
+  int every_;
+  int full_every_;
+  int num_params_;
+  vector<string> names_;
+};
+
+REGISTER_CPU_OPERATOR(MarkDirtyRows, MarkDirtyRowsOp);
+REGISTER_CPU_OPERATOR(SaveDelta, SaveDeltaOp);
+
+OPERATOR_SCHEMA(MarkDirtyRows)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Records the rows of PARAM that INDICES touch in DIRTY, a uint8 tensor with
+one entry per row of PARAM. Run it next to a sparse optimizer op (such as
+SparseAdagrad or SparseMomentumSGDUpdate) with the same PARAM and INDICES, so
+that SaveDelta only has to write the rows that changed. DIRTY is created on
+the first run and follows the number of rows of PARAM when it grows.
+)DOC")
+    .Input(0, "PARAM", "Parameter updated with INDICES.")
+    .Input(1, "INDICES", "Rows of PARAM that are updated.")
+    .Output(0, "DIRTY", "Rows of PARAM updated since SaveDelta cleared it.");
+
+OPERATOR_SCHEMA(SaveDelta)
+    .NumInputs(3, INT_MAX)
+    .NumOutputs(1, INT_MAX)
+    .SetDoc(R"DOC(
+Incremental checkpoint of sparse parameters. The inputs are the iteration
+counter (an int64 TensorCPU of size 1), the K parameters, then the K DIRTY
+tensors kept by MarkDirtyRows; the outputs are the DIRTY tensors, which are
+cleared every time the parameters are saved.
+
+Every `full_every` iterations the parameters are written whole. Otherwise,
+every `every` iterations only their dirty rows are written: for a parameter
+`name`, the blob `name_rows` holds the rows and `name_indices` their int64 row
+indices. The db name is `db` formatted with the iteration, as for Checkpoint.
+
+To restore, Load the last full snapshot then, in order, every later delta
+and apply it with ScatterAssign(name, name_indices, name_rows).
+)DOC")
+    .Arg(
+        "absolute_path",
+        "(int, default 0) if set, use the db path directly and do not prepend "
+        "the current root folder of the workspace.")
+    .Arg(
+        "db",
+        "(string) a pattern of the db name, formatted with the iteration.")
+    .Arg("db_type", "(string) the type of the db.")
+    .Arg("every", "(int, default 1) interval of the delta checkpoints.")
+    .Arg(
+        "full_every",
+        "(int, default 0) interval of the full snapshots, 0 for never.");
+
+SHOULD_NOT_DO_GRADIENT(MarkDirtyRows);
+SHOULD_NOT_DO_GRADIENT(SaveDelta);
+
+} // namespace caffe2
@@ -0,0 +1,210 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <hiprand_kernel.h>
+#include <limits>
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/dropout_op.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Every thread of the grid draws from its own Philox subsequence, one number
+// per element of its grid-stride loop, so the mask of a run only depends on
+// (seed, offset) and on the launch configuration, which only depends on N.
+// The gradient recomputes it instead of reading a stored mask.
+__device__ inline float PhiloxScale(hiprandStatePhilox4_32_10_t* state,
+                                    const float ratio,
+                                    const float scale)
+{
+    return hiprand_uniform(state) > ratio ? scale : 0.f;
+}
+
+__global__ void PhiloxDropoutKernel(const int N,
+                                    const float ratio,
+                                    const unsigned long long seed,
+                                    const unsigned long long offset,
+                                    const float* Xdata,
+                                    float* Ydata,
+                                    int64_t* maskdata)
+{
+    const int index   = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+    const float scale = 1. / (1. - ratio);
+    if(index == 0)
+    {
+        maskdata[0] = seed;
+        maskdata[1] = offset;
+    }
+    hiprandStatePhilox4_32_10_t state;
+    hiprand_init(seed, index, offset, &state);
+    HIP_1D_KERNEL_LOOP(i, N) { Ydata[i] = Xdata[i] * PhiloxScale(&state, ratio, scale); }
+}
+
+__global__ void PhiloxDropoutGradientKernel(const int N,
+                                            const float ratio,
+                                            const int64_t* maskdata,
+                                            const float* dYdata,
+                                            float* dXdata)
+{
+    const int index   = hipBlockIdx_x * hipBlockDim_x + hipThreadIdx_x;
+    const float scale = 1. / (1. - ratio);
+    hiprandStatePhilox4_32_10_t state;
+    hiprand_init(maskdata[0], index, maskdata[1], &state);
+    HIP_1D_KERNEL_LOOP(i, N) { dXdata[i] = dYdata[i] * PhiloxScale(&state, ratio, scale); }
+}
+
+// Number of random numbers a thread draws for N elements.
+int64_t DrawsPerThread(const int N)
+{
+    const int64_t threads = CAFFE_GET_BLOCKS(N) * CAFFE_HIP_NUM_THREADS;
+    return (N + threads - 1) / threads;
+}
+
+} // namespace
+
+/**
+ * Dropout with the PHILOX engine keeps no per-element mask. Its mask output
+ * is an int64 tensor of two elements, the Philox seed and offset of the run,
+ * and the gradient regenerates the mask from them. Unlike the default HIP
+ * Dropout, the op runs in place and never writes the random numbers out.
+ */
+class PhiloxDropoutOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    PhiloxDropoutOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws),
+          ratio_(OperatorBase::GetSingleArgument<float>("ratio", 0.5)),
+          is_test_(OperatorBase::GetSingleArgument<int>(OpSchema::Arg_IsTest, 0)),
+          seed_(operator_def.device_option().has_random_seed()
+                    ? operator_def.device_option().random_seed()
+                    : RandomNumberSeed()),
+          offset_(0)
+    {
+        CAFFE_ENFORCE_GE(ratio_, 0);
+        CAFFE_ENFORCE_LT(ratio_, 1);
+    }
+
+    bool RunOnDevice() override
+    {
+        auto& X = Input(0);
+        auto* Y = Output(0);
+        if(is_test_)
+        {
+            if(Y != &X)
+            {
+                Y->ResizeLike(X);
+                context_.Copy<float, HIPContext, HIPContext>(
+                    X.size(), X.data<float>(), Y->mutable_data<float>());
+            }
+            return true;
+        }
+        CAFFE_ENFORCE(X.size() < std::numeric_limits<int>::max());
+        const int N = X.size();
+        auto* mask  = Output(1);
+        mask->Resize(2);
+        const float* Xdata = X.data<float>();
+        Y->ResizeLike(X);
+        if(N == 0)
+        {
+            return true;
+        }
+        hipLaunchKernelGGL((PhiloxDropoutKernel),
+                           dim3(CAFFE_GET_BLOCKS(N)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           N,
+                           ratio_,
+                           seed_,
+                           offset_,
+                           Xdata,
+                           Y->mutable_data<float>(),
+                           mask->mutable_data<int64_t>());
+        // Skip the numbers of this run, so the next one draws fresh ones.
+        offset_ += DrawsPerThread(N);
+        return true;
+    }
+
+    protected:
+    float ratio_;
+    bool is_test_;
+    const unsigned long long seed_;
+    unsigned long long offset_;
+    // Input: X; Output: Y, mask (seed and offset).
+};
+
+class PhiloxDropoutGradientOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    PhiloxDropoutGradientOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws),
+          ratio_(OperatorBase::GetSingleArgument<float>("ratio", 0.5)),
+          is_test_(OperatorBase::GetSingleArgument<int>(OpSchema::Arg_IsTest, 0))
+    {
+        CAFFE_ENFORCE_GE(ratio_, 0);
+        CAFFE_ENFORCE_LT(ratio_, 1);
+    }
+
+    bool RunOnDevice() override
+    {
+        auto& dY = Input(0);
+        auto* dX = Output(0);
+        if(is_test_)
+        {
+            if(dX != &dY)
+            {
+                dX->ResizeLike(dY);
+                context_.Copy<float, HIPContext, HIPContext>(
+                    dY.size(), dY.data<float>(), dX->mutable_data<float>());
+            }
+            return true;
+        }
+        auto& mask = Input(1);
+        CAFFE_ENFORCE_EQ(mask.size(), 2, "The mask must come from a PHILOX Dropout");
+        CAFFE_ENFORCE(dY.size() < std::numeric_limits<int>::max());
+        const int N         = dY.size();
+        const float* dYdata = dY.data<float>();
+        dX->ResizeLike(dY);
+        if(N == 0)
+        {
+            return true;
+        }
+        hipLaunchKernelGGL((PhiloxDropoutGradientKernel),
+                           dim3(CAFFE_GET_BLOCKS(N)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           N,
+                           ratio_,
+                           mask.data<int64_t>(),
+                           dYdata,
+                           dX->mutable_data<float>());
+        return true;
+    }
+
+    protected:
+    float ratio_;
+    bool is_test_;
+    // Input: dY, mask (seed and offset); Output: dX
+};
+
+REGISTER_HIP_OPERATOR_WITH_ENGINE(Dropout, PHILOX, PhiloxDropoutOp);
+REGISTER_HIP_OPERATOR_WITH_ENGINE(DropoutGrad, PHILOX, PhiloxDropoutGradientOp);
+} // namespace caffe2
@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/operator_gradient.h"
+#include "caffe2/operators/elementwise_op.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Binary ops followed by a unary post-op, computed in a single pass on CPU.
+// They take the same arguments and broadcast the same way as the binary op.
+#define EIGEN_FUSED_FUNCTOR(name, binary, post_op)          \
+  REGISTER_CPU_OPERATOR(                                    \
+      name,                                                 \
+      BinaryElementwiseOp<                                  \
+          NumericTypes,                                     \
+          CPUContext,                                       \
+          EigenBinaryFunctor<                               \
+              Eigen##binary##Op,                            \
+              Eigen##post_op##PostOp>>);                    \
+  OPERATOR_SCHEMA(name)                                     \
+      .NumInputs(2)                                         \
+      .NumOutputs(1)                                        \
+      .AllowInplace({{0, 0}, {1, 0}})                       \
+      .CostInferenceFunction(PointwiseCostInference<2>)     \
+      .IdenticalTypeAndShapeOfInput(0)                      \
+      .FillUsing(FusedDocGenerator(#binary, #post_op));     \
+  SHOULD_NOT_DO_GRADIENT(name)
+
+std::function<void(OpSchema&)> FusedDocGenerator(
+    const char* binary,
+    const char* post_op) {
+  return [=](OpSchema& schema) {
+    string doc = R"DOC(
+Computes {binary} of A and B followed by {post_op} in a single pass over the
+data, with the same arguments and broadcast rules as {binary}. This is the
+same as running {binary} and then {post_op} in place on its output, without
+the second pass. Only implemented on CPU, and for inference only.
+)DOC";
+    ReplaceAll(doc, "{binary}", binary);
+    ReplaceAll(doc, "{post_op}", post_op);
+    schema.SetDoc(doc);
+    schema.Arg("broadcast", "Pass 1 to enable broadcasting");
+    schema.Arg(
+        "axis",
+        "If set, defines the broadcast dimensions. See doc for details.");
+    schema.Input(0, "A", "First operand");
+    schema.Input(1, "B", "Second operand, broadcast to A if broadcast=1");
+    schema.Output(0, "C", "Result, has same dimensions and type as A");
+  };
+}
+
+#define EIGEN_ADD(x, y) ((x) + (y))
+EIGEN_BINARY_OP(Add, EIGEN_ADD);
+#undef EIGEN_ADD
+#define EIGEN_SUB(x, y) ((x) - (y))
+EIGEN_BINARY_OP(Sub, EIGEN_SUB);
+#undef EIGEN_SUB
+#define EIGEN_MUL(x, y) ((x) * (y))
+EIGEN_BINARY_OP(Mul, EIGEN_MUL);
+#undef EIGEN_MUL
+
+} // namespace
+
+EIGEN_FUSED_FUNCTOR(AddRelu, Add, Relu);
+EIGEN_FUSED_FUNCTOR(SubRelu, Sub, Relu);
+EIGEN_FUSED_FUNCTOR(MulRelu, Mul, Relu);
+EIGEN_FUSED_FUNCTOR(SubAbs, Sub, Abs);
+EIGEN_FUSED_FUNCTOR(SubSqr, Sub, Sqr);
+
+#undef EIGEN_FUSED_FUNCTOR
+
+} // namespace caffe2
@@ -24,6 +24,7 @@
 #include "caffe2/core/tensor.h"
 #include "caffe2/utils/math.h"
 
+#include <algorithm>
 #include <tuple>
 
 namespace caffe2 {
@@ -149,6 +150,87 @@ std::tuple<size_t, size_t, size_t> calculate_broadcast_sizes(
   return std::make_tuple(pre, n, post);
 }
 
+// Returns the dims of B padded with 1s to align them with the dims of A
+// starting at axis, as understood by math::ComputeBroadcastStrides.
+template <typename Context>
+std::vector<int> calculate_broadcast_dims(
+    const Tensor<Context>& A,
+    const Tensor<Context>& B,
+    int axis) {
+  CAFFE_ENFORCE_GE(
+      A.ndim(),
+      B.ndim(),
+      "If you are doing broadcasting, input1 should have "
+      "a smaller or equal number of dimensions.");
+  if (axis == -1) {
+    axis = A.ndim() - B.ndim();
+  }
+  CAFFE_ENFORCE(
+      axis >= 0 && axis <= A.ndim() - B.ndim(),
+      "Broadcast axis should be in the range of"
+      "[0, A.ndim() - B.ndim()], but axis = ",
+      axis);
+  std::vector<int> b_dims(A.ndim() - axis, 1);
+  for (int i = 0; i < B.ndim(); ++i) {
+    b_dims[i] = B.dim32(i);
+  }
+  return b_dims;
+}
+
+// Runs the functor on b broadcast through the given strides. Functors that
+// cannot do it in a single pass are run on every row of the innermost dim.
+template <typename Functor, typename T, typename R, typename Context>
+auto run_with_strided_broadcast(
+    Functor* functor,
+    const T* a,
+    const T* b,
+    R* out,
+    const std::vector<int>& dims,
+    const std::vector<int>& b_strides,
+    Context* context,
+    int) -> decltype(functor->RunWithStridedBroadcast(
+                         a, b, out, dims, b_strides, context)) {
+  return functor->RunWithStridedBroadcast(a, b, out, dims, b_strides, context);
+}
+
+template <typename Functor, typename T, typename R, typename Context>
+void run_with_strided_broadcast(
+    Functor* functor,
+    const T* a,
+    const T* b,
+    R* out,
+    const std::vector<int>& dims,
+    const std::vector<int>& b_strides,
+    Context* context,
+    long) {
+  const int ndim = dims.size();
+  const int inner = dims.back();
+  size_t rows = 1;
+  for (int i = 0; i < ndim - 1; ++i) {
+    rows *= dims[i];
+  }
+  std::vector<int> index(ndim, 0);
+  for (size_t row = 0; row < rows; ++row) {
+    int b_offset = 0;
+    for (int i = 0; i < ndim - 1; ++i) {
+      b_offset += index[i] * b_strides[i];
+    }
+    if (b_strides.back() == 0) {
+      functor->template Run<true>(
+          inner, a + row * inner, b + b_offset, out + row * inner, context);
+    } else {
+      functor->template Run<false>(
+          inner, a + row * inner, b + b_offset, out + row * inner, context);
+    }
+    for (int i = ndim - 2; i >= 0; --i) {
+      if (++index[i] < dims[i]) {
+        break;
+      }
+      index[i] = 0;
+    }
+  }
+}
+
 /**
  * Performs a binary operation (e.g. +, - or /) with optional broadcast support.
  *
@@ -156,15 +238,20 @@ std::tuple<size_t, size_t, size_t> calculate_broadcast_sizes(
  *
  * If AllowBroadcast=false tensors has to be of exactly the same shape.
  *
- * If AllowBroadcast=true it support limited broadcasting of the right-hand-side
- * argument to match the shape of left-hand-side argument. Only suffix matching
- * is supported for now (1-dim expansion is allowed on both ends). E.g. this
- * will be accepted:
+ * If AllowBroadcast=true it support broadcasting of the right-hand-side
+ * argument to match the shape of left-hand-side argument. The dims of B are
+ * aligned with the dims of A starting at axis (the trailing dims by default),
+ * and every one of them has to be 1 or equal to the dim of A. E.g. this will be
+ * accepted:
  * A dims: 2 3 4 5 6
  * B dims:   1 4 1
  *           ^
  *           |
  *          axis = 1
+ *
+ * When the dims of B that are not 1 are not contiguous, e.g. B dims 3 1 5,
+ * the functor gets the strides of B through RunWithStridedBroadcast if it
+ * has one, or is run on every innermost row otherwise.
  */
 template <
     typename InputTypes,
@@ -237,13 +324,25 @@ class BinaryElementwiseOp : public Operator<Context> {
     } else if (B.size() == 1) {
       functor_.template Run<true>(A.size(), Adata, Bdata, Cdata, &context_);
     } else {
-      size_t pre, n, post;
-      std::tie(pre, n, post) = calculate_broadcast_sizes(A, B, axis_);
-      if (post == 1) {
-        functor_.RunWithBroadcast(Adata, Bdata, Cdata, pre, n, &context_);
-      } else {
-        functor_.RunWithBroadcast2(
-            Adata, Bdata, Cdata, pre, n, post, &context_);
+      std::vector<int> dims, b_strides;
+      math::ComputeBroadcastStrides(
+          std::vector<int>(A.dims().begin(), A.dims().end()),
+          calculate_broadcast_dims(A, B, axis_),
+          &dims,
+          &b_strides);
+      if (std::count(b_strides.begin(), b_strides.end(), 0) + 1 >=
+          dims.size()) {
+        size_t pre, n, post;
+        std::tie(pre, n, post) = calculate_broadcast_sizes(A, B, axis_);
+        if (post == 1) {
+          functor_.RunWithBroadcast(Adata, Bdata, Cdata, pre, n, &context_);
+        } else {
+          functor_.RunWithBroadcast2(
+              Adata, Bdata, Cdata, pre, n, post, &context_);
+        }
+      } else if (A.size() > 0) {
+        run_with_strided_broadcast(
+            &functor_, Adata, Bdata, Cdata, dims, b_strides, &context_, 0);
       }
     }
     return true;
@@ -392,55 +491,188 @@ bool DivGradientOp<Context>::RunOnDevice() {
   return true;
 }
 
+// Unary post-ops of EigenBinaryFunctor. They take and return Eigen array
+// expressions, so that they are fused with the binary op into one pass.
+struct EigenIdentityPostOp {
+  template <typename X>
+  const X& operator()(const X& x) const {
+    return x;
+  }
+};
+
+struct EigenReluPostOp {
+  template <typename X>
+  auto operator()(const X& x) const
+      -> decltype(x.max(typename X::Scalar(0))) {
+    return x.max(typename X::Scalar(0));
+  }
+};
+
+struct EigenAbsPostOp {
+  template <typename X>
+  auto operator()(const X& x) const -> decltype(x.abs()) {
+    return x.abs();
+  }
+};
+
+struct EigenSqrPostOp {
+  template <typename X>
+  auto operator()(const X& x) const -> decltype(x.square()) {
+    return x.square();
+  }
+};
+
+/**
+ * The functor of BinaryElementwiseOp for arithmetic operators on CPU.
+ *
+ * BinaryOp computes the op on Eigen array expressions, and PostOp is an
+ * optional unary op applied to its result. Both are built into a single
+ * Eigen expression, so every broadcast pattern is vectorized by Eigen and
+ * the post-op costs no extra pass over the output. Strided broadcasts are
+ * run on blocks made of the two innermost dims, one of which is broadcast:
+ * they are vectorized over the whole block rather than over its rows.
+ */
+// Smallest number of elements that an elementwise op runs on another thread.
+constexpr size_t kElementwiseParallelGrain = 1 << 16;
+
+template <class BinaryOp, class PostOp = EigenIdentityPostOp>
+struct EigenBinaryFunctor {
+  template <int b_is_scalar, typename T, typename R>
+  inline void Run(size_t n, const T* a, const T* b, R* out, CPUContext*) {
+    if (n < 2 * kElementwiseParallelGrain) {
+      RunOnRange<b_is_scalar>(n, a, b, out);
+      return;
+    }
+    CPUContext::ParallelFor(
+        n, kElementwiseParallelGrain, [&](size_t begin, size_t end) {
+          RunOnRange<b_is_scalar>(
+              end - begin, a + begin, b_is_scalar ? b : b + begin, out + begin);
+        });
+  }
+
+  template <typename T, typename R>
+  void RunWithBroadcast(
+      const T* a,
+      const T* b,
+      R* out,
+      size_t pre,
+      size_t n,
+      CPUContext*) {
+    EigenArrayMap<R>(out, n, pre) = post_op_(op_(
+        ConstEigenArrayMap<T>(a, n, pre).colwise(),
+        ConstEigenVectorArrayMap<T>(b, n)));
+  }
+
+  template <typename T, typename R>
+  void RunWithBroadcast2(
+      const T* a,
+      const T* b,
+      R* out,
+      size_t pre,
+      size_t n,
+      size_t post,
+      CPUContext*) {
+    for (int i = 0; i < pre; ++i) {
+      RunOnBlock(a + i * n * post, b, out + i * n * post, n, post, true);
+    }
+  }
+
+  template <typename T, typename R>
+  void RunWithStridedBroadcast(
+      const T* a,
+      const T* b,
+      R* out,
+      const std::vector<int>& dims,
+      const std::vector<int>& b_strides,
+      CPUContext*) {
+    // The dims alternate between broadcast and not broadcast ones, so of
+    // the two innermost dims exactly one is broadcast.
+    const int ndim = dims.size();
+    CAFFE_ENFORCE_GE(ndim, 2);
+    const int m = dims[ndim - 2];
+    const int inner = dims[ndim - 1];
+    const bool inner_is_broadcast = b_strides[ndim - 1] == 0;
+    size_t blocks = 1;
+    for (int i = 0; i < ndim - 2; ++i) {
+      blocks *= dims[i];
+    }
+    std::vector<int> index(std::max(ndim - 2, 0), 0);
+    for (size_t block = 0; block < blocks; ++block) {
+      int b_offset = 0;
+      for (int i = 0; i < ndim - 2; ++i) {
+        b_offset += index[i] * b_strides[i];
+      }
+      const size_t offset = block * m * inner;
+      RunOnBlock(
+          a + offset, b + b_offset, out + offset, m, inner, inner_is_broadcast);
+      for (int i = ndim - 3; i >= 0; --i) {
+        if (++index[i] < dims[i]) {
+          break;
+        }
+        index[i] = 0;
+      }
+    }
+  }
+
+ private:
+  template <int b_is_scalar, typename T, typename R>
+  inline void RunOnRange(size_t n, const T* a, const T* b, R* out) {
+    if (b_is_scalar) {
+      EigenVectorArrayMap<R>(out, n) =
+          post_op_(op_(ConstEigenVectorArrayMap<T>(a, n), b[0]));
+    } else {
+      EigenVectorArrayMap<R>(out, n) = post_op_(op_(
+          ConstEigenVectorArrayMap<T>(a, n),
+          ConstEigenVectorArrayMap<T>(b, n)));
+    }
+  }
+
+  // Runs on a row-major block of m x inner elements, where b has either
+  // one element per row (inner_is_broadcast) or one per column.
+  template <typename T, typename R>
+  void RunOnBlock(
+      const T* a,
+      const T* b,
+      R* out,
+      size_t m,
+      size_t inner,
+      bool inner_is_broadcast) {
+    if (inner_is_broadcast) {
+      EigenArrayMap<R>(out, inner, m) = post_op_(op_(
+          ConstEigenArrayMap<T>(a, inner, m).rowwise(),
+          Eigen::Map<const Eigen::Array<T, 1, Eigen::Dynamic>>(b, m)));
+    } else {
+      EigenArrayMap<R>(out, inner, m) = post_op_(op_(
+          ConstEigenArrayMap<T>(a, inner, m).colwise(),
+          ConstEigenVectorArrayMap<T>(b, inner)));
+    }
+  }
+
+  BinaryOp op_;
+  PostOp post_op_;
+};
+
+// Defines the Eigen##name##Op binary op of EigenBinaryFunctor from an
+// expression macro eigen_op(x, y).
+#define EIGEN_BINARY_OP(name, eigen_op)           \
+  struct Eigen##name##Op {                        \
+    template <typename X, typename Y>             \
+    auto operator()(const X& x, const Y& y) const \
+        -> decltype(eigen_op(x, y)) {             \
+      return eigen_op(x, y);                      \
+    }                                             \
+  }
+
 // For arithmetic operators, Eigen provides a good way to vectorize even
 // when broadcasting.
-#define EIGEN_FUNCTOR(name, eigen_op, input_type, output_type)               \
-  struct Eigen##name##Functor {                                              \
-    template <int b_is_scalar, typename T, typename R>                       \
-    inline void Run(size_t n, const T* a, const T* b, R* out, CPUContext*) { \
-      if (b_is_scalar) {                                                     \
-        EigenVectorArrayMap<R>(out, n) =                                     \
-            eigen_op((ConstEigenVectorArrayMap<T>(a, n)), (b[0]));           \
-      } else {                                                               \
-        EigenVectorArrayMap<R>(out, n) = eigen_op(                           \
-            (ConstEigenVectorArrayMap<T>(a, n)),                             \
-            (ConstEigenVectorArrayMap<T>(b, n)));                            \
-      }                                                                      \
-    }                                                                        \
-    template <typename T, typename R>                                        \
-    void RunWithBroadcast(                                                   \
-        const T* a,                                                          \
-        const T* b,                                                          \
-        R* out,                                                              \
-        size_t pre,                                                          \
-        size_t n,                                                            \
-        CPUContext*) {                                                       \
-      EigenArrayMap<R>(out, n, pre) = eigen_op(                              \
-          (ConstEigenArrayMap<T>(a, n, pre).colwise()),                      \
-          (ConstEigenVectorArrayMap<T>(b, n)));                              \
-    }                                                                        \
-    template <typename T, typename R>                                        \
-    void RunWithBroadcast2(                                                  \
-        const T* a,                                                          \
-        const T* b,                                                          \
-        R* out,                                                              \
-        size_t pre,                                                          \
-        size_t n,                                                            \
-        size_t post,                                                         \
-        CPUContext*) {                                                       \
-      for (int i = 0; i < pre; ++i) {                                        \
-        EigenArrayMap<R>(out + i * n * post, post, n) = eigen_op(            \
-            (ConstEigenArrayMap<T>(a + i * n * post, post, n).rowwise()),    \
-            (Eigen::Map<const Eigen::Array<T, 1, Eigen::Dynamic>>(b, n)));   \
-      }                                                                      \
-    }                                                                        \
-  };                                                                         \
-  REGISTER_CPU_OPERATOR(                                                     \
-      name,                                                                  \
-      BinaryElementwiseOp<                                                   \
-          input_type,                                                        \
-          CPUContext,                                                        \
-          Eigen##name##Functor,                                              \
+#define EIGEN_FUNCTOR(name, eigen_op, input_type, output_type) \
+  EIGEN_BINARY_OP(name, eigen_op);                             \
+  REGISTER_CPU_OPERATOR(                                       \
+      name,                                                    \
+      BinaryElementwiseOp<                                     \
+          input_type,                                          \
+          CPUContext,                                          \
+          EigenBinaryFunctor<Eigen##name##Op>,                 \
           output_type>)
 
 } // namespace caffe2
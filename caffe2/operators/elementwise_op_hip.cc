@@ -6,25 +6,73 @@
 #include "caffe2/core/context_hip.h"
 #include "caffe2/operators/elementwise_op.h"
 #include "caffe2/utils/conversions.h"
+#include "caffe2/utils/math_broadcast_hip.h"
 
 namespace caffe2 {
 
+namespace {
+
+// float16 inputs are computed in float. Arithmetic results are stored back
+// as float16, comparison results stay bool.
+template <typename R>
+struct HipFloat16Result
+{
+    using type = R;
+    static inline __device__ R From(const R r) { return r; }
+};
+
+template <>
+struct HipFloat16Result<float>
+{
+    using type = float16;
+    static inline __device__ float16 From(const float r) { return convert::To<float, float16>(r); }
+};
+
+template <typename T>
+using HipIfFloat16 = typename std::enable_if<std::is_same<T, float16>::value, int>::type;
+template <typename T>
+using HipIfNotFloat16 = typename std::enable_if<!std::is_same<T, float16>::value, int>::type;
+
+} // namespace
+
+using HipNumericTypes = TensorTypes<int32_t, int64_t, float, double, float16>;
+
 #define HIP_FUNCTOR(name, op, input_type, output_type)                                    \
+    struct name##Op                                                                       \
+    {                                                                                     \
+        template <typename T, HipIfNotFloat16<T> = 0>                                     \
+        inline __device__ auto operator()(const T x, const T y) const                     \
+            -> decltype(op(x, y))                                                         \
+        {                                                                                 \
+            return op(x, y);                                                              \
+        }                                                                                 \
+        template <typename T, HipIfFloat16<T> = 0>                                        \
+        inline __device__ typename HipFloat16Result<decltype(op(0.f, 0.f))>::type         \
+        operator()(const T x, const T y) const                                            \
+        {                                                                                 \
+            const float xf = convert::To<float16, float>(x);                              \
+            const float yf = convert::To<float16, float>(y);                              \
+            return HipFloat16Result<decltype(op(0.f, 0.f))>::From(op(xf, yf));            \
+        }                                                                                 \
+    };                                                                                    \
     template <int b_is_scalar, typename T, typename R>                                    \
     __global__ void name##Kernel(const T* a, const T* b, R* out, int n)                   \
     {                                                                                     \
-        HIP_1D_KERNEL_LOOP(i, n) { out[i] = op(a[i], b[b_is_scalar ? 0 : i]); }           \
+        HIP_1D_KERNEL_LOOP(i, n) { out[i] = name##Op()(a[i], b[b_is_scalar ? 0 : i]); }   \
     }                                                                                     \
     template <typename T, typename R>                                                     \
     __global__ void name##BroadcastKernel(const T* a, const T* b, R* out, int pre, int n) \
     {                                                                                     \
-        HIP_1D_KERNEL_LOOP(i, pre* n) { out[i] = op(a[i], b[i % n]); }                    \
+        HIP_1D_KERNEL_LOOP(i, pre* n) { out[i] = name##Op()(a[i], b[i % n]); }            \
     }                                                                                     \
     template <typename T, typename R>                                                     \
     __global__ void name##Broadcast2Kernel(                                               \
         const T* a, const T* b, R* out, int pre, int n, int post)                         \
     {                                                                                     \
-        HIP_1D_KERNEL_LOOP(i, pre* n* post) { out[i] = op(a[i], b[(i / post) % n]); }     \
+        HIP_1D_KERNEL_LOOP(i, pre* n* post)                                               \
+        {                                                                                 \
+            out[i] = name##Op()(a[i], b[(i / post) % n]);                                 \
+        }                                                                                 \
     }                                                                                     \
                                                                                           \
     struct Hip##name##Functor                                                             \
@@ -78,30 +126,40 @@ namespace caffe2 {
                                static_cast<int>(n),                                       \
                                static_cast<int>(post));                                   \
         }                                                                                 \
+        template <typename T, typename R>                                                 \
+        void RunWithStridedBroadcast(const T* a,                                          \
+                                     const T* b,                                          \
+                                     R* out,                                              \
+                                     const std::vector<int>& dims,                        \
+                                     const std::vector<int>& b_strides,                   \
+                                     HIPContext* context)                                 \
+        {                                                                                 \
+            LaunchBroadcastBinary(dims, b_strides, a, b, out, name##Op(), context);       \
+        }                                                                                 \
     };                                                                                    \
     REGISTER_HIP_OPERATOR(                                                                \
         name, BinaryElementwiseOp<input_type, HIPContext, Hip##name##Functor, output_type>)
 
 #define HIP_SUB(x, y) ((x) - (y))
-HIP_FUNCTOR(Sub, HIP_SUB, NumericTypes, SameTypeAsInput);
+HIP_FUNCTOR(Sub, HIP_SUB, HipNumericTypes, SameTypeAsInput);
 #undef HIP_SUB
 #define HIP_MUL(x, y) ((x) * (y))
-HIP_FUNCTOR(Mul, HIP_MUL, NumericTypes, SameTypeAsInput);
+HIP_FUNCTOR(Mul, HIP_MUL, HipNumericTypes, SameTypeAsInput);
 #undef HIP_MUL
 #define HIP_DIV(x, y) ((x) / (y))
-HIP_FUNCTOR(Div, HIP_DIV, NumericTypes, SameTypeAsInput);
+HIP_FUNCTOR(Div, HIP_DIV, HipNumericTypes, SameTypeAsInput);
 #undef HIP_DIV
 #define HIP_LT(x, y) ((x) < (y))
-HIP_FUNCTOR(LT, HIP_LT, NumericTypes, FixedType<bool>);
+HIP_FUNCTOR(LT, HIP_LT, HipNumericTypes, FixedType<bool>);
 #undef HIP_LT
 #define HIP_LE(x, y) ((x) <= (y))
-HIP_FUNCTOR(LE, HIP_LE, NumericTypes, FixedType<bool>);
+HIP_FUNCTOR(LE, HIP_LE, HipNumericTypes, FixedType<bool>);
 #undef HIP_LE
 #define HIP_GT(x, y) ((x) > (y))
-HIP_FUNCTOR(GT, HIP_GT, NumericTypes, FixedType<bool>);
+HIP_FUNCTOR(GT, HIP_GT, HipNumericTypes, FixedType<bool>);
 #undef HIP_GT
 #define HIP_GE(x, y) ((x) >= (y))
-HIP_FUNCTOR(GE, HIP_GE, NumericTypes, FixedType<bool>);
+HIP_FUNCTOR(GE, HIP_GE, HipNumericTypes, FixedType<bool>);
 #undef HIP_GE
 #define HIP_EQ(x, y) ((x) == (y))
 HIP_FUNCTOR(EQ, HIP_EQ, IntTypes, FixedType<bool>);
@@ -389,6 +447,14 @@ __global__ void binary_add_kernel_broadcast(
                                    convert::To<T, M>(no_post ? b[idx % n] : b[(idx / post) % n]));
     }
 }
+template <typename T, typename M>
+struct BinaryAddOp
+{
+    inline __device__ T operator()(const T a, const T b) const
+    {
+        return convert::To<M, T>(convert::To<T, M>(a) + convert::To<T, M>(b));
+    }
+};
 } // namespace
 
 // Actual Add operator, because the above macros are read-only.
@@ -475,6 +541,17 @@ class HIPAddOp final : public Operator<HIPContext>
         }
         else
         {
+            std::vector<int> dims, b_strides;
+            math::ComputeBroadcastStrides(std::vector<int>(X0.dims().begin(), X0.dims().end()),
+                                          calculate_broadcast_dims(X0, X1, axis_),
+                                          &dims,
+                                          &b_strides);
+            if(std::count(b_strides.begin(), b_strides.end(), 0) + 1 < dims.size())
+            {
+                LaunchBroadcastBinary(
+                    dims, b_strides, X0data, X1data, outputData, BinaryAddOp<T, M>(), &context_);
+                return true;
+            }
             size_t pre, n, post;
             std::tie(pre, n, post) = calculate_broadcast_sizes(X0, X1, axis_);
             if(post == 1)
@@ -26,6 +26,7 @@ OPERATOR_SCHEMA(Sum)
     .AllowInplace({{0, 0}})
     .InputsCanCrossDevices()
     .IdenticalTypeAndShapeOfInput(0)
+    .CostInferenceFunction(PointwiseCostInference<1>)
     .SetDoc(R"DOC(
 Element-wise sum of each of the input tensors. The first input tensor can be
 used in-place as the output tensor, in which case the sum will be done in
@@ -36,6 +36,7 @@ OPERATOR_SCHEMA(Exp)
     .NumOutputs(1)
     .AllowInplace({{0, 0}})
     .IdenticalTypeAndShape()
+    .CostInferenceFunction(PointwiseCostInference<1>)
     .SetDoc(R"DOC(
 Calculates the exponential of the given input tensor, element-wise. This
 operation can be done in an in-place fashion too, by providing the same input
@@ -55,6 +55,7 @@ REGISTER_CPU_OPERATOR(XavierFill, XavierFillOp<float, CPUContext>);
 REGISTER_CPU_OPERATOR(MSRAFill, MSRAFillOp<float, CPUContext>);
 REGISTER_CPU_OPERATOR(RangeFill, RangeFillOp<float, CPUContext>);
 REGISTER_CPU_OPERATOR(LengthsRangeFill, LengthsRangeFillOp<CPUContext>);
+REGISTER_CPU_OPERATOR(MultiFill, MultiFillOp<CPUContext>);
 
 OPERATOR_SCHEMA(ConstantFill)
     .NumInputs(0, 1)
@@ -274,4 +275,53 @@ output would be [0,1,2,3,0,1,2,0].
         "1D tensor whose size is the sum of `lengths`");
 NO_GRADIENT(LengthsRangeFill);
 
+OPERATOR_SCHEMA(MultiFill)
+    .NumInputs(0)
+    .NumOutputs(1, INT_MAX)
+    .TensorInferenceFunction(
+        [](const OperatorDef& def, const vector<TensorShape>& /* unused */) {
+          ArgumentHelper helper(def);
+          const auto ndims = helper.GetRepeatedArgument<int>("ndims");
+          const auto shapes = helper.GetRepeatedArgument<int>("shapes");
+          vector<TensorShape> out(def.output_size());
+          int next_dim = 0;
+          for (int i = 0; i < out.size(); ++i) {
+            out[i].set_data_type(TensorProto::FLOAT);
+            for (int d = 0; i < ndims.size() && d < ndims[i] &&
+                 next_dim < shapes.size();
+                 ++d) {
+              out[i].add_dims(shapes[next_dim++]);
+            }
+          }
+          return out;
+        })
+    .SetDoc(R"DOC(
+Fills every output with FLOAT values, each one with its own filler, in a single
+run of the operator. It replaces a sequence of filler operators without inputs
+in an init net, and on GPUs all the outputs are filled by one kernel launch
+instead of one launch per parameter.
+
+On HIP the random values come from a counter-based (Philox) generator keyed by
+the random seed of the device option and by the position of each element, so
+they do not depend on the launch configuration or on the other ops of the net.
+)DOC")
+    .Arg(
+        "fillers",
+        "One filler per output: UniformFill, GaussianFill, XavierFill, "
+        "MSRAFill or ConstantFill")
+    .Arg("ndims", "Number of dimensions of every output")
+    .Arg(
+        "shapes",
+        "The shapes of all the outputs, concatenated. Output i takes the next "
+        "ndims[i] values")
+    .Arg(
+        "a",
+        "Per output min of UniformFill, mean of GaussianFill and value of "
+        "ConstantFill. Defaults to 0")
+    .Arg(
+        "b",
+        "Per output max of UniformFill and std of GaussianFill. Defaults to 1")
+    .Output(0, "output", "The first filled tensor, followed by the others");
+NO_GRADIENT(MultiFill);
+
 }  // namespace caffe2
@@ -42,7 +42,12 @@ class FillerOp : public Operator<Context> {
         extra_shape_(ToVectorTIndex(
             OperatorBase::GetRepeatedArgument<int>("extra_shape"))),
         input_as_shape_(
-            OperatorBase::GetSingleArgument<bool>("input_as_shape", false)) {
+            OperatorBase::GetSingleArgument<bool>("input_as_shape", false)),
+        random_seed_(
+            operator_def.device_option().has_random_seed()
+                ? operator_def.device_option().random_seed()
+                : RandomNumberSeed()),
+        random_offset_(0) {
     if (InputSize()) {
       if (shape_.size() != 0) {
         CAFFE_THROW(
@@ -98,6 +103,11 @@ class FillerOp : public Operator<Context> {
   vector<TIndex> shape_;
   vector<TIndex> extra_shape_;
   bool input_as_shape_;
+  // Seed and counter of the counter-based (Philox) generator the random
+  // fillers use on HIP, see filler_op_hip.cc. The counter moves past the
+  // numbers of every run so the next one draws fresh ones.
+  const unsigned long long random_seed_;
+  unsigned long long random_offset_;
 };
 
 template <typename T, class Context>
@@ -523,6 +533,122 @@ class LengthsRangeFillOp : public Operator<Context> {
   }
 };
 
+// MultiFillOp fills all of its float outputs in one run, so that an init net
+// can initialize many parameters with one op (and one kernel launch on HIP)
+// instead of one per parameter. Output i takes the next ndims[i] values of
+// "shapes" as its shape and is filled by fillers[i].
+template <class Context>
+class MultiFillOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  // Xavier and MSRA fills are uniform and gaussian fills whose parameters
+  // only depend on the shape, which is known when the op is created.
+  enum FillerType { UNIFORM = 0, GAUSSIAN = 1, CONSTANT = 2 };
+
+  MultiFillOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        random_seed_(
+            operator_def.device_option().has_random_seed()
+                ? operator_def.device_option().random_seed()
+                : RandomNumberSeed()),
+        random_offset_(0) {
+    const auto fillers =
+        OperatorBase::GetRepeatedArgument<string>("fillers");
+    const auto ndims = OperatorBase::GetRepeatedArgument<int>("ndims");
+    const auto shapes = OperatorBase::GetRepeatedArgument<int>("shapes");
+    const auto a = OperatorBase::GetRepeatedArgument<float>("a");
+    const auto b = OperatorBase::GetRepeatedArgument<float>("b");
+    const int num_outputs = OutputSize();
+    CAFFE_ENFORCE_EQ(fillers.size(), num_outputs, "One filler per output");
+    CAFFE_ENFORCE_EQ(ndims.size(), num_outputs, "One ndims per output");
+    CAFFE_ENFORCE(
+        a.empty() || a.size() == num_outputs,
+        "a must be empty or have one value per output");
+    CAFFE_ENFORCE(
+        b.empty() || b.size() == num_outputs,
+        "b must be empty or have one value per output");
+    int next_dim = 0;
+    for (int i = 0; i < num_outputs; ++i) {
+      CAFFE_ENFORCE_GE(ndims[i], 0);
+      CAFFE_ENFORCE_LE(
+          next_dim + ndims[i], shapes.size(), "shapes is too short");
+      shapes_.emplace_back(
+          shapes.begin() + next_dim, shapes.begin() + next_dim + ndims[i]);
+      next_dim += ndims[i];
+      const auto& shape = shapes_.back();
+      const TIndex size = std::accumulate(
+          shape.begin(), shape.end(), TIndex(1), std::multiplies<TIndex>());
+      const float ai = a.empty() ? 0 : a[i];
+      const float bi = b.empty() ? 1 : b[i];
+      if (fillers[i] == "UniformFill") {
+        CAFFE_ENFORCE_LT(ai, bi, "Max value should be bigger than min value.");
+        AddFiller(UNIFORM, ai, bi);
+      } else if (fillers[i] == "GaussianFill") {
+        AddFiller(GAUSSIAN, ai, bi);
+      } else if (fillers[i] == "ConstantFill") {
+        AddFiller(CONSTANT, ai, 0);
+      } else if (fillers[i] == "XavierFill") {
+        CAFFE_ENFORCE_GT(size, 0, "XavierFill needs a non-empty shape");
+        const float scale = std::sqrt(3.f / (size / shape[0]));
+        AddFiller(UNIFORM, -scale, scale);
+      } else if (fillers[i] == "MSRAFill") {
+        CAFFE_ENFORCE_GE(shape.size(), 2, "MSRAFill needs at least 2 dims");
+        CAFFE_ENFORCE_GT(size, 0, "MSRAFill needs a non-empty shape");
+        const float scale = std::sqrt(2.f / (size / shape[1]));
+        AddFiller(GAUSSIAN, 0, scale);
+      } else {
+        CAFFE_THROW("Unsupported filler for MultiFill: ", fillers[i]);
+      }
+    }
+    CAFFE_ENFORCE_EQ(next_dim, shapes.size(), "shapes is too long");
+  }
+
+  bool RunOnDevice() override {
+    for (int i = 0; i < OutputSize(); ++i) {
+      Output(i)->Resize(shapes_[i]);
+    }
+    return Fill();
+  }
+
+  bool Fill() {
+    for (int i = 0; i < OutputSize(); ++i) {
+      auto* output = Output(i);
+      auto* data = output->template mutable_data<float>();
+      switch (types_[i]) {
+        case UNIFORM:
+          math::RandUniform<float, Context>(
+              output->size(), a_[i], b_[i], data, &context_);
+          break;
+        case GAUSSIAN:
+          math::RandGaussian<float, Context>(
+              output->size(), a_[i], b_[i], data, &context_);
+          break;
+        case CONSTANT:
+          math::Set<float, Context>(output->size(), a_[i], data, &context_);
+          break;
+      }
+    }
+    return true;
+  }
+
+ private:
+  void AddFiller(FillerType type, float a, float b) {
+    types_.push_back(type);
+    a_.push_back(a);
+    b_.push_back(b);
+  }
+
+  vector<vector<TIndex>> shapes_;
+  vector<FillerType> types_;
+  // (min, max) of the uniform fills, (mean, std) of the gaussian ones and
+  // (value, unused) of the constant ones.
+  vector<float> a_;
+  vector<float> b_;
+  // Same as in FillerOp.
+  const unsigned long long random_seed_;
+  unsigned long long random_offset_;
+};
+
 template <int VALUE_TYPE = TensorProto_DataType_FLOAT>
 inline std::vector<TensorShape> FillerTensorInference(
     const OperatorDef& def,
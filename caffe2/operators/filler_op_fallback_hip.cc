@@ -19,5 +19,6 @@
 #include "caffe2/operators/operator_fallback_hip.h"
 
 namespace caffe2 {
-REGISTER_HIP_OPERATOR(LengthsRangeFill, GPUFallbackOp<LengthsRangeFillOp<CPUContext>>);
+// Sampling without replacement is sequential, it stays on the CPU.
+REGISTER_HIP_OPERATOR(UniqueUniformFill, GPUFallbackOp<UniqueUniformFillOp<CPUContext>>);
 }
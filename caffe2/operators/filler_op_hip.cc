@@ -15,13 +15,164 @@
  */
 
 #include <cmath>
+#include <limits>
 #include "caffe2/core/context_hip.h"
 #include "caffe2/operators/filler_op.h"
 #include "hip/hip_runtime.h"
+#include <hiprand_kernel.h>
 
 namespace caffe2 {
 
 namespace {
+
+// The random fillers draw from a counter-based Philox generator: the elements
+// are handled in groups of four and group g takes the four numbers of Philox
+// subsequence g at the offset of the run. Every value then only depends on
+// (seed, offset, element index), not on the launch configuration or on the
+// other ops sharing the device, and a run draws exactly four numbers per
+// subsequence whatever the distribution.
+constexpr int kPhiloxGroupSize = 4;
+
+__host__ __device__ inline int PhiloxGroups(const int n)
+{
+    return (n + kPhiloxGroupSize - 1) / kPhiloxGroupSize;
+}
+
+__device__ inline void PhiloxFillGroup(hiprandStatePhilox4_32_10_t* state,
+                                       const int type,
+                                       const float a,
+                                       const float b,
+                                       const int n,
+                                       float* data)
+{
+    float v[kPhiloxGroupSize];
+    if(type == MultiFillOp<HIPContext>::UNIFORM)
+    {
+        // hiprand_uniform4 is in (0, 1], flip it into [a, b).
+        const float4 r = hiprand_uniform4(state);
+        v[0]           = b - (b - a) * r.x;
+        v[1]           = b - (b - a) * r.y;
+        v[2]           = b - (b - a) * r.z;
+        v[3]           = b - (b - a) * r.w;
+    }
+    else if(type == MultiFillOp<HIPContext>::GAUSSIAN)
+    {
+        const float4 r = hiprand_normal4(state);
+        v[0]           = a + b * r.x;
+        v[1]           = a + b * r.y;
+        v[2]           = a + b * r.z;
+        v[3]           = a + b * r.w;
+    }
+    else
+    {
+        v[0] = v[1] = v[2] = v[3] = a;
+    }
+    for(int i = 0; i < n; ++i)
+    {
+        data[i] = v[i];
+    }
+}
+
+__global__ void PhiloxFillKernel(const int n,
+                                 const int type,
+                                 const float a,
+                                 const float b,
+                                 const unsigned long long seed,
+                                 const unsigned long long offset,
+                                 float* data)
+{
+    HIP_1D_KERNEL_LOOP(g, PhiloxGroups(n))
+    {
+        hiprandStatePhilox4_32_10_t state;
+        hiprand_init(seed, g, offset, &state);
+        const int begin = g * kPhiloxGroupSize;
+        PhiloxFillGroup(
+            &state, type, a, b, min(kPhiloxGroupSize, n - begin), data + begin);
+    }
+}
+
+__global__ void PhiloxUniformIntFillKernel(const int n,
+                                           const int min_value,
+                                           const unsigned int range,
+                                           const unsigned long long seed,
+                                           const unsigned long long offset,
+                                           int* data)
+{
+    HIP_1D_KERNEL_LOOP(g, PhiloxGroups(n))
+    {
+        hiprandStatePhilox4_32_10_t state;
+        hiprand_init(seed, g, offset, &state);
+        const uint4 r   = hiprand4(&state);
+        const int begin = g * kPhiloxGroupSize;
+        const unsigned int v[kPhiloxGroupSize] = {r.x, r.y, r.z, r.w};
+        for(int i = 0; i < min(kPhiloxGroupSize, n - begin); ++i)
+        {
+            // A range of 0 is the whole int range, which wrapped around.
+            data[begin + i] = min_value + static_cast<int>(range ? v[i] % range : v[i]);
+        }
+    }
+}
+
+// One output of MultiFill, its groups are [group_begin, group_begin +
+// PhiloxGroups(size)) of the op's Philox subsequences.
+struct MultiFillSegment
+{
+    float* data;
+    int group_begin;
+    int size;
+    int type;
+    float a;
+    float b;
+};
+
+__global__ void PhiloxMultiFillKernel(const int num_groups,
+                                      const int num_segments,
+                                      const MultiFillSegment* segments,
+                                      const unsigned long long seed,
+                                      const unsigned long long offset)
+{
+    HIP_1D_KERNEL_LOOP(g, num_groups)
+    {
+        // Find the last segment starting at or before g, empty segments start
+        // where the next one does and are skipped.
+        int lo = 0;
+        int hi = num_segments - 1;
+        while(lo < hi)
+        {
+            const int mid = (lo + hi + 1) / 2;
+            if(segments[mid].group_begin <= g)
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid - 1;
+            }
+        }
+        const MultiFillSegment& segment = segments[lo];
+        const int begin = (g - segment.group_begin) * kPhiloxGroupSize;
+        hiprandStatePhilox4_32_10_t state;
+        hiprand_init(seed, g, offset, &state);
+        PhiloxFillGroup(&state,
+                        segment.type,
+                        segment.a,
+                        segment.b,
+                        min(kPhiloxGroupSize, segment.size - begin),
+                        segment.data + begin);
+    }
+}
+
+__global__ void LengthsRangeFillKernel(const int* offsets, const int* lengths, int* data)
+{
+    // One block per segment.
+    const int len = lengths[hipBlockIdx_x];
+    int* out      = data + offsets[hipBlockIdx_x];
+    for(int i = hipThreadIdx_x; i < len; i += hipBlockDim_x)
+    {
+        out[i] = i;
+    }
+}
+
 __global__ void FillRangeKernel(const int n, float* data)
 {
     HIP_1D_KERNEL_LOOP(index, n) { data[index] = index; }
@@ -33,6 +184,253 @@ FillDiagonalKernel(const int num_diagonal_elements, const TIndex step_size, cons
 {
     HIP_1D_KERNEL_LOOP(index, num_diagonal_elements) { data[index * step_size] = value; }
 }
+
+// Fills n floats with a Philox filler and skips the numbers of the run.
+void PhiloxFill(const int n,
+                const int type,
+                const float a,
+                const float b,
+                const unsigned long long seed,
+                unsigned long long* offset,
+                float* data,
+                HIPContext* context)
+{
+    if(n == 0)
+    {
+        return;
+    }
+    hipLaunchKernelGGL((PhiloxFillKernel),
+                       dim3(CAFFE_GET_BLOCKS(PhiloxGroups(n))),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context->hip_stream(),
+                       n,
+                       type,
+                       a,
+                       b,
+                       seed,
+                       *offset,
+                       data);
+    *offset += kPhiloxGroupSize;
+}
+} // namespace
+
+template <>
+bool UniformFillOp<float, HIPContext>::Fill(TensorHIP* output)
+{
+    float min = min_;
+    float max = max_;
+    if(InputSize() == 3)
+    {
+        CAFFE_ENFORCE_EQ(1, Input(1).size(), "min blob must be scalar");
+        CAFFE_ENFORCE_EQ(1, Input(2).size(), "max blob must be scalar");
+        // The bounds live on the device, read them back before deciding on
+        // the output shape.
+        context_.Copy<float, HIPContext, CPUContext>(1, Input(1).data<float>(), &min);
+        context_.Copy<float, HIPContext, CPUContext>(1, Input(2).data<float>(), &max);
+        context_.FinishDeviceComputation();
+        if(min > max)
+        {
+            auto shape = output->dims();
+            shape[0]   = 0;
+            output->Resize(shape);
+            output->mutable_data<float>();
+            return true;
+        }
+    }
+    PhiloxFill(output->size(),
+               MultiFillOp<HIPContext>::UNIFORM,
+               min,
+               max,
+               random_seed_,
+               &random_offset_,
+               output->mutable_data<float>(),
+               &context_);
+    return true;
+}
+
+template <>
+bool UniformFillOp<int, HIPContext>::Fill(TensorHIP* output)
+{
+    int min = min_;
+    int max = max_;
+    if(InputSize() == 3)
+    {
+        CAFFE_ENFORCE_EQ(1, Input(1).size(), "min blob must be scalar");
+        CAFFE_ENFORCE_EQ(1, Input(2).size(), "max blob must be scalar");
+        context_.Copy<int, HIPContext, CPUContext>(1, Input(1).data<int>(), &min);
+        context_.Copy<int, HIPContext, CPUContext>(1, Input(2).data<int>(), &max);
+        context_.FinishDeviceComputation();
+        if(min > max)
+        {
+            auto shape = output->dims();
+            shape[0]   = 0;
+            output->Resize(shape);
+            output->mutable_data<int>();
+            return true;
+        }
+    }
+    const int n = output->size();
+    if(n == 0)
+    {
+        output->mutable_data<int>();
+        return true;
+    }
+    // Like the CPU fill, both bounds are inclusive.
+    const unsigned int range =
+        static_cast<unsigned int>(max) - static_cast<unsigned int>(min) + 1u;
+    hipLaunchKernelGGL((PhiloxUniformIntFillKernel),
+                       dim3(CAFFE_GET_BLOCKS(PhiloxGroups(n))),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       n,
+                       min,
+                       range,
+                       random_seed_,
+                       random_offset_,
+                       output->mutable_data<int>());
+    random_offset_ += kPhiloxGroupSize;
+    return true;
+}
+
+template <>
+bool GaussianFillOp<float, HIPContext>::Fill(TensorHIP* output)
+{
+    PhiloxFill(output->size(),
+               MultiFillOp<HIPContext>::GAUSSIAN,
+               mean_,
+               std_,
+               random_seed_,
+               &random_offset_,
+               output->mutable_data<float>(),
+               &context_);
+    return true;
+}
+
+template <>
+bool XavierFillOp<float, HIPContext>::Fill(TensorHIP* output)
+{
+    const int fan_in  = output->size() / output->dim32(0);
+    const float scale = std::sqrt(3.f / fan_in);
+    PhiloxFill(output->size(),
+               MultiFillOp<HIPContext>::UNIFORM,
+               -scale,
+               scale,
+               random_seed_,
+               &random_offset_,
+               output->mutable_data<float>(),
+               &context_);
+    return true;
+}
+
+template <>
+bool MSRAFillOp<float, HIPContext>::Fill(TensorHIP* output)
+{
+    const int fan_out = output->size() / output->dim32(1);
+    const float scale = std::sqrt(2.f / fan_out);
+    PhiloxFill(output->size(),
+               MultiFillOp<HIPContext>::GAUSSIAN,
+               0.f,
+               scale,
+               random_seed_,
+               &random_offset_,
+               output->mutable_data<float>(),
+               &context_);
+    return true;
+}
+
+template <>
+bool MultiFillOp<HIPContext>::Fill()
+{
+    const int num_segments = OutputSize();
+    std::vector<MultiFillSegment> segments(num_segments);
+    int num_groups = 0;
+    for(int i = 0; i < num_segments; ++i)
+    {
+        auto* output = Output(i);
+        CAFFE_ENFORCE_LT(output->size(), std::numeric_limits<int>::max());
+        segments[i].data        = output->mutable_data<float>();
+        segments[i].group_begin = num_groups;
+        segments[i].size        = output->size();
+        segments[i].type        = types_[i];
+        segments[i].a           = a_[i];
+        segments[i].b           = b_[i];
+        CAFFE_ENFORCE_LT(num_groups,
+                         std::numeric_limits<int>::max() - PhiloxGroups(output->size()),
+                         "Too many elements for one MultiFill");
+        num_groups += PhiloxGroups(output->size());
+    }
+    if(num_groups == 0)
+    {
+        return true;
+    }
+    // The table of outputs is tiny, it goes to the device with the launch.
+    const TIndex table_bytes = num_segments * sizeof(MultiFillSegment);
+    TensorHIP device_segments(vector<TIndex>{table_bytes});
+    context_.Copy<uint8_t, CPUContext, HIPContext>(
+        table_bytes,
+        reinterpret_cast<const uint8_t*>(segments.data()),
+        device_segments.mutable_data<uint8_t>());
+    hipLaunchKernelGGL((PhiloxMultiFillKernel),
+                       dim3(CAFFE_GET_BLOCKS(num_groups)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       num_groups,
+                       num_segments,
+                       reinterpret_cast<const MultiFillSegment*>(device_segments.data<uint8_t>()),
+                       random_seed_,
+                       random_offset_);
+    // Both copies of the table have to outlive the copy and the launch.
+    context_.FinishDeviceComputation();
+    random_offset_ += kPhiloxGroupSize;
+    return true;
+}
+
+template <>
+bool LengthsRangeFillOp<HIPContext>::RunOnDevice()
+{
+    auto& input  = Input(0);
+    auto* output = Output(0);
+    CAFFE_ENFORCE_EQ(input.ndim(), 1, "Input must be a vector.");
+    const int num_segments = input.size();
+
+    // The output size depends on the lengths, read them back and send the
+    // start of every segment along with the launch.
+    TensorCPU lengths(vector<TIndex>{input.size()});
+    context_.Copy<int32_t, HIPContext, CPUContext>(
+        num_segments, input.data<int32_t>(), lengths.mutable_data<int32_t>());
+    context_.FinishDeviceComputation();
+    TensorCPU offsets(vector<TIndex>{input.size()});
+    const int32_t* lengths_data = lengths.data<int32_t>();
+    int32_t* offsets_data       = offsets.mutable_data<int32_t>();
+    int32_t len_sum             = 0;
+    for(int i = 0; i < num_segments; ++i)
+    {
+        offsets_data[i] = len_sum;
+        len_sum += lengths_data[i];
+    }
+    output->Resize(len_sum);
+    auto* output_data = output->mutable_data<int32_t>();
+    if(num_segments == 0 || len_sum == 0)
+    {
+        return true;
+    }
+    TensorHIP device_offsets(vector<TIndex>{input.size()});
+    context_.Copy<int32_t, CPUContext, HIPContext>(
+        num_segments, offsets_data, device_offsets.mutable_data<int32_t>());
+    hipLaunchKernelGGL((LengthsRangeFillKernel),
+                       dim3(num_segments),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       device_offsets.data<int32_t>(),
+                       input.data<int32_t>(),
+                       output_data);
+    // Both copies of the offsets have to outlive the copy and the launch.
+    context_.FinishDeviceComputation();
+    return true;
 }
 
 template <>
@@ -83,5 +481,7 @@ REGISTER_HIP_OPERATOR(GaussianFill, GaussianFillOp<float, HIPContext>);
 REGISTER_HIP_OPERATOR(XavierFill, XavierFillOp<float, HIPContext>);
 REGISTER_HIP_OPERATOR(MSRAFill, MSRAFillOp<float, HIPContext>);
 REGISTER_HIP_OPERATOR(RangeFill, RangeFillOp<float, HIPContext>);
+REGISTER_HIP_OPERATOR(LengthsRangeFill, LengthsRangeFillOp<HIPContext>);
+REGISTER_HIP_OPERATOR(MultiFill, MultiFillOp<HIPContext>);
 
 } // namespace caffe2
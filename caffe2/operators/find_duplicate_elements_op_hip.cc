@@ -0,0 +1,181 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <hipcub/hipcub.hpp>
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/find_duplicate_elements_op.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+template <typename T>
+__global__ void FindDuplicatesInitKernel(const int N, const T* data, T* keys, int* indices)
+{
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        // -0.0 and 0.0 compare equal but sort apart, fold them into one key
+        keys[i]    = data[i] == T(0) ? T(0) : data[i];
+        indices[i] = i;
+    }
+}
+
+// After a stable sort by value the first item of every run of equal values
+// is its first occurrence; every other item of the run is flagged.
+template <typename T>
+__global__ void FlagDuplicatesKernel(const int N,
+                                     const T* sorted_keys,
+                                     const int* sorted_indices,
+                                     bool* is_duplicate)
+{
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        if(i > 0 && sorted_keys[i] == sorted_keys[i - 1])
+        {
+            is_duplicate[sorted_indices[i]] = true;
+        }
+    }
+}
+} // namespace
+
+template <>
+class FindDuplicateElementsOp<HIPContext> final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    USE_DISPATCH_HELPER;
+    FindDuplicateElementsOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        return DispatchHelper<TensorTypes<float, double, int, long>>::call(this, Input(0));
+    }
+
+    template <typename T>
+    bool DoRunWithType()
+    {
+        const auto& data = Input(0);
+        CAFFE_ENFORCE(data.ndim() == 1, "data should be 1-D.");
+        const int N  = data.dims()[0];
+        auto* output = Output(0);
+        if(N == 0)
+        {
+            output->Resize(0);
+            output->template mutable_data<int64_t>();
+            return true;
+        }
+
+        keys_.Resize(2 * N * sizeof(T));
+        T* keys        = reinterpret_cast<T*>(keys_.template mutable_data<char>());
+        T* sorted_keys = keys + N;
+        indices_.Resize(2 * N);
+        int* indices        = indices_.template mutable_data<int>();
+        int* sorted_indices = indices + N;
+        hipLaunchKernelGGL((FindDuplicatesInitKernel<T>),
+                           dim3(CAFFE_GET_BLOCKS(N)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           N,
+                           data.template data<T>(),
+                           keys,
+                           indices);
+
+        size_t temp_storage_bytes = 0;
+        hipcub::DeviceRadixSort::SortPairs(nullptr,
+                                           temp_storage_bytes,
+                                           keys,
+                                           sorted_keys,
+                                           indices,
+                                           sorted_indices,
+                                           N,
+                                           0,
+                                           sizeof(T) * 8,
+                                           context_.hip_stream());
+        buffer_.Resize(temp_storage_bytes);
+        hipcub::DeviceRadixSort::SortPairs(static_cast<void*>(buffer_.template mutable_data<char>()),
+                                           temp_storage_bytes,
+                                           keys,
+                                           sorted_keys,
+                                           indices,
+                                           sorted_indices,
+                                           N,
+                                           0,
+                                           sizeof(T) * 8,
+                                           context_.hip_stream());
+
+        is_duplicate_.Resize(N);
+        bool* is_duplicate = is_duplicate_.template mutable_data<bool>();
+        math::Set<bool, HIPContext>(N, false, is_duplicate, &context_);
+        hipLaunchKernelGGL((FlagDuplicatesKernel<T>),
+                           dim3(CAFFE_GET_BLOCKS(N)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           N,
+                           sorted_keys,
+                           sorted_indices,
+                           is_duplicate);
+
+        // Compacting the flags in index order keeps the CPU op's ascending
+        // order of the duplicate indices
+        dup_indices_.Resize(N + 1);
+        int64_t* dup_indices = dup_indices_.template mutable_data<int64_t>();
+        int64_t* num_dups    = dup_indices + N;
+        hipcub::CountingInputIterator<int64_t> itr(0);
+        temp_storage_bytes = 0;
+        hipcub::DeviceSelect::Flagged(nullptr,
+                                      temp_storage_bytes,
+                                      itr,
+                                      is_duplicate,
+                                      dup_indices,
+                                      num_dups,
+                                      N,
+                                      context_.hip_stream());
+        buffer_.Resize(temp_storage_bytes);
+        hipcub::DeviceSelect::Flagged(static_cast<void*>(buffer_.template mutable_data<char>()),
+                                      temp_storage_bytes,
+                                      itr,
+                                      is_duplicate,
+                                      dup_indices,
+                                      num_dups,
+                                      N,
+                                      context_.hip_stream());
+
+        int64_t num_dups_host = 0;
+        context_.CopyBytes<HIPContext, CPUContext>(sizeof(int64_t), num_dups, &num_dups_host);
+        context_.FinishDeviceComputation();
+
+        output->Resize(num_dups_host);
+        context_.CopyBytes<HIPContext, HIPContext>(num_dups_host * sizeof(int64_t),
+                                                   dup_indices,
+                                                   output->template mutable_data<int64_t>());
+        return true;
+    }
+
+    private:
+    Tensor<HIPContext> keys_;
+    Tensor<HIPContext> indices_;
+    Tensor<HIPContext> is_duplicate_;
+    Tensor<HIPContext> dup_indices_;
+    Tensor<HIPContext> buffer_;
+};
+
+REGISTER_HIP_OPERATOR(FindDuplicateElements, FindDuplicateElementsOp<HIPContext>);
+} // namespace caffe2
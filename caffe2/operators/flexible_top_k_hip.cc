@@ -0,0 +1,224 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/flexible_top_k.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/top_k_hip.h"
+
+namespace caffe2 {
+
+namespace {
+
+// One block per row, which copies the first k[row] sorted entries of the row
+// to output_offsets[row].
+__global__ void FlexibleTopKGatherKernel(const int inner_size,
+                                         const TIndex* k,
+                                         const TIndex* output_offsets,
+                                         const float* sorted_keys,
+                                         const int* sorted_indices,
+                                         float* values,
+                                         TIndex* indices)
+{
+    const int row        = hipBlockIdx_x;
+    const int row_offset = row * inner_size;
+    const TIndex offset  = output_offsets[row];
+    for(int j = hipThreadIdx_x; j < k[row]; j += hipBlockDim_x)
+    {
+        values[offset + j]  = sorted_keys[row_offset + j];
+        indices[offset + j] = sorted_indices[row_offset + j] - row_offset;
+    }
+}
+
+__global__ void FlexibleTopKScatterKernel(const int inner_size,
+                                          const TIndex* k,
+                                          const TIndex* input_offsets,
+                                          const float* values,
+                                          const TIndex* indices,
+                                          float* output)
+{
+    const int row       = hipBlockIdx_x;
+    const TIndex offset = input_offsets[row];
+    for(int j = hipThreadIdx_x; j < k[row]; j += hipBlockDim_x)
+    {
+        output[row * inner_size + indices[offset + j]] = values[offset + j];
+    }
+}
+
+} // namespace
+
+template <>
+class FlexibleTopKOp<float, HIPContext> : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+
+    FlexibleTopKOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override;
+
+    private:
+    Tensor<HIPContext> offsets_;
+    Tensor<HIPContext> output_offsets_;
+    Tensor<HIPContext> sorted_keys_;
+    Tensor<HIPContext> sorted_indices_;
+    Tensor<HIPContext> scratch_;
+};
+
+template <>
+class FlexibleTopKGradientOp<float, HIPContext> : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+
+    FlexibleTopKGradientOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override;
+
+    private:
+    Tensor<HIPContext> input_offsets_;
+    Tensor<HIPContext> scratch_;
+};
+
+bool FlexibleTopKOp<float, HIPContext>::RunOnDevice()
+{
+    auto& input   = Input(0);
+    auto& k       = Input(1);
+    auto* values  = Output(0);
+    auto* indices = Output(1);
+
+    CAFFE_ENFORCE_GT(input.ndim(), 0);
+    vector<TIndex> input_dims = input.dims();
+    const int outer_size      = size_to_dim_(input_dims.size() - 1, input_dims);
+    const int inner_size      = input_dims.back();
+    CAFFE_ENFORCE_EQ(outer_size, k.size(), "first n-1 dims of input data and K does not match.");
+
+    // The output size depends on the values of K, so they have to be checked
+    // and summed on the host.
+    TensorCPU k_host(k, &context_);
+    context_.FinishDeviceComputation();
+    const TIndex* k_data = k_host.data<TIndex>();
+    TensorCPU output_offsets_host(vector<TIndex>{outer_size});
+    TIndex* output_offsets_data = output_offsets_host.mutable_data<TIndex>();
+    TIndex output_size          = 0;
+    for(TIndex i = 0; i < outer_size; ++i)
+    {
+        CAFFE_ENFORCE(inner_size >= k_data[i],
+                      "k should not be greater than last dim, error at index ",
+                      i,
+                      ", with value: ",
+                      k_data[i]);
+        CAFFE_ENFORCE(k_data[i] > 0,
+                      "k should be greater than 0, error at index ",
+                      i,
+                      ",  with value: ",
+                      k_data[i]);
+        output_offsets_data[i] = output_size;
+        output_size += k_data[i];
+    }
+    values->Resize(output_size);
+    indices->Resize(output_size);
+    float* values_data   = values->mutable_data<float>();
+    TIndex* indices_data = indices->mutable_data<TIndex>();
+    if(outer_size == 0)
+    {
+        return true;
+    }
+
+    offsets_.Resize(outer_size + 1);
+    hipLaunchKernelGGL((TopKUniformOffsetsKernel<int>),
+                       dim3(CAFFE_GET_BLOCKS(outer_size + 1)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       outer_size + 1,
+                       inner_size,
+                       offsets_.mutable_data<int>());
+    sorted_keys_.ResizeLike(input);
+    sorted_indices_.ResizeLike(input);
+    SegmentedSortDescending(input.size(),
+                            outer_size,
+                            input.data<float>(),
+                            offsets_.data<int>(),
+                            sorted_keys_.mutable_data<float>(),
+                            sorted_indices_.mutable_data<int>(),
+                            &scratch_,
+                            &context_);
+
+    output_offsets_.CopyFrom(output_offsets_host, &context_);
+    hipLaunchKernelGGL((FlexibleTopKGatherKernel),
+                       dim3(outer_size),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       inner_size,
+                       k.data<TIndex>(),
+                       output_offsets_.data<TIndex>(),
+                       sorted_keys_.data<float>(),
+                       sorted_indices_.data<int>(),
+                       values_data,
+                       indices_data);
+    return true;
+}
+
+bool FlexibleTopKGradientOp<float, HIPContext>::RunOnDevice()
+{
+    auto& original_input = Input(0);
+    auto& k              = Input(1);
+    auto& values         = Input(2);
+    auto& indices        = Input(3);
+    auto* output         = Output(0);
+
+    CAFFE_ENFORCE_GT(original_input.ndim(), 0);
+    vector<TIndex> original_dims = original_input.dims();
+    output->Resize(original_dims);
+    float* output_data = output->mutable_data<float>();
+    math::Set<float, HIPContext>(output->size(), 0.0f, output_data, &context_);
+
+    const int outer_size = k.size();
+    if(outer_size == 0)
+    {
+        return true;
+    }
+    input_offsets_.Resize(outer_size + 1);
+    TopKLengthsToOffsets<TIndex>(outer_size,
+                                 k.data<TIndex>(),
+                                 input_offsets_.mutable_data<TIndex>(),
+                                 &scratch_,
+                                 &context_);
+    hipLaunchKernelGGL((FlexibleTopKScatterKernel),
+                       dim3(outer_size),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       static_cast<int>(original_dims.back()),
+                       k.data<TIndex>(),
+                       input_offsets_.data<TIndex>(),
+                       values.data<float>(),
+                       indices.data<TIndex>(),
+                       output_data);
+    return true;
+}
+
+REGISTER_HIP_OPERATOR(FlexibleTopK, FlexibleTopKOp<float, HIPContext>);
+REGISTER_HIP_OPERATOR(FlexibleTopKGradient, FlexibleTopKGradientOp<float, HIPContext>);
+
+} // namespace caffe2
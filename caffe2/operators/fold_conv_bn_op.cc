@@ -0,0 +1,68 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/fold_conv_bn_op.h"
+
+#include <cmath>
+
+namespace caffe2 {
+
+template <>
+bool FoldConvBNOp<float, CPUContext>::DoRunWithBias(
+    const int M,
+    const int K,
+    const float* W,
+    const float* b,
+    const float* scale,
+    const float* bias,
+    const float* mean,
+    const float* var,
+    float* W_out,
+    float* b_out) {
+  for (int m = 0; m < M; ++m) {
+    const float s = scale[m] / std::sqrt(var[m] + epsilon_);
+    for (int k = 0; k < K; ++k) {
+      W_out[m * K + k] = W[m * K + k] * s;
+    }
+    b_out[m] = ((b ? b[m] : 0.f) - mean[m]) * s + bias[m];
+  }
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(FoldConvBN, FoldConvBNOp<float, CPUContext>);
+
+OPERATOR_SCHEMA(FoldConvBN)
+    .NumInputs(5, 6)
+    .NumOutputs(2)
+    .AllowInplace({{0, 0}})
+    .SetDoc(R"DOC(
+Computes the filter and bias of a Conv with the inference-mode SpatialBN that
+follows it folded in, so the pair can run as a single Conv. It is inserted by
+the FuseConvBN transform and recomputed on every run, which costs one pass
+over the filter and keeps the result valid if the parameters change.
+
+The inputs are the filter and, if the Conv has one, the bias of the Conv,
+followed by the scale, bias, running mean and running variance of the
+SpatialBN.
+)DOC")
+    .Arg("epsilon", "The epsilon of the folded SpatialBN. Defaults to 1e-5")
+    .Input(0, "filter", "The filter of the Conv, output channels first")
+    .Output(0, "folded_filter", "The filter with the SpatialBN folded in")
+    .Output(1, "folded_bias", "The bias with the SpatialBN folded in");
+
+SHOULD_NOT_DO_GRADIENT(FoldConvBN);
+
+} // namespace caffe2
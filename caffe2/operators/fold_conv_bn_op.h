@@ -0,0 +1,95 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_OPERATORS_FOLD_CONV_BN_OP_H_
+#define CAFFE2_OPERATORS_FOLD_CONV_BN_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+// Folds an inference SpatialBN into the filter and bias of the Conv feeding
+// it: W'[m] = W[m] * s[m] and b'[m] = (b[m] - mean[m]) * s[m] + bias[m], with
+// s[m] = scale[m] / sqrt(var[m] + epsilon). The output channel is the
+// outermost filter dimension in both NCHW and NHWC, so one kernel serves both.
+template <typename T, class Context>
+class FoldConvBNOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  FoldConvBNOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)) {
+    CAFFE_ENFORCE_GT(epsilon_, 0);
+  }
+
+  bool RunOnDevice() override {
+    const bool has_bias = InputSize() == 6;
+    const int offset = has_bias ? 2 : 1;
+    const auto& W = Input(0);
+    const auto& scale = Input(offset);
+    const auto& bias = Input(offset + 1);
+    const auto& mean = Input(offset + 2);
+    const auto& var = Input(offset + 3);
+    CAFFE_ENFORCE_GE(W.ndim(), 1);
+    const int M = W.dim32(0);
+    const int K = W.size_from_dim(1);
+    if (has_bias) {
+      CAFFE_ENFORCE_EQ(Input(1).size(), M);
+    }
+    CAFFE_ENFORCE_EQ(scale.size(), M);
+    CAFFE_ENFORCE_EQ(bias.size(), M);
+    CAFFE_ENFORCE_EQ(mean.size(), M);
+    CAFFE_ENFORCE_EQ(var.size(), M);
+
+    auto* W_out = Output(0);
+    auto* b_out = Output(1);
+    W_out->ResizeLike(W);
+    b_out->Resize(M);
+    return DoRunWithBias(
+        M,
+        K,
+        W.template data<T>(),
+        has_bias ? Input(1).template data<T>() : nullptr,
+        scale.template data<T>(),
+        bias.template data<T>(),
+        mean.template data<T>(),
+        var.template data<T>(),
+        W_out->template mutable_data<T>(),
+        b_out->template mutable_data<T>());
+  }
+
+ protected:
+  // b may be null, in which case the conv had no bias.
+  bool DoRunWithBias(
+      const int M,
+      const int K,
+      const T* W,
+      const T* b,
+      const T* scale,
+      const T* bias,
+      const T* mean,
+      const T* var,
+      T* W_out,
+      T* b_out);
+
+  float epsilon_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_FOLD_CONV_BN_OP_H_
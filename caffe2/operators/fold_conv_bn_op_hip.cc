@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hip/hip_runtime.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/fold_conv_bn_op.h"
+
+namespace caffe2 {
+
+namespace {
+
+__global__ void FoldConvBNKernel(const int M,
+                                 const int K,
+                                 const float epsilon,
+                                 const float* W,
+                                 const float* b,
+                                 const float* scale,
+                                 const float* bias,
+                                 const float* mean,
+                                 const float* var,
+                                 float* W_out,
+                                 float* b_out)
+{
+    HIP_1D_KERNEL_LOOP(i, M * K)
+    {
+        const int m   = i / K;
+        const float s = scale[m] * rsqrtf(var[m] + epsilon);
+        W_out[i]      = W[i] * s;
+        if(i % K == 0)
+        {
+            b_out[m] = ((b ? b[m] : 0.f) - mean[m]) * s + bias[m];
+        }
+    }
+}
+
+} // namespace
+
+template <>
+bool FoldConvBNOp<float, HIPContext>::DoRunWithBias(const int M,
+                                                    const int K,
+                                                    const float* W,
+                                                    const float* b,
+                                                    const float* scale,
+                                                    const float* bias,
+                                                    const float* mean,
+                                                    const float* var,
+                                                    float* W_out,
+                                                    float* b_out)
+{
+    hipLaunchKernelGGL((FoldConvBNKernel),
+                       dim3(CAFFE_GET_BLOCKS(M * K)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       M,
+                       K,
+                       epsilon_,
+                       W,
+                       b,
+                       scale,
+                       bias,
+                       mean,
+                       var,
+                       W_out,
+                       b_out);
+    return true;
+}
+
+REGISTER_HIP_OPERATOR(FoldConvBN, FoldConvBNOp<float, HIPContext>);
+
+} // namespace caffe2
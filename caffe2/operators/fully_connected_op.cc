@@ -61,6 +61,26 @@ std::vector<TensorShape> FCShapeInference(
   out[0] = CreateTensorShape(y_shape, in[0].data_type());
   return out;
 }
+
+OpSchema::Cost CostInferenceForFC(
+    const OperatorDef& def,
+    const vector<TensorShape>& in,
+    bool pretransposed_weight) {
+  struct OpSchema::Cost c;
+  ArgumentHelper helper(def);
+
+  auto axis = helper.GetSingleArgument<int32_t>("axis", 1);
+  const auto canonical_axis = canonical_axis_index_(axis, in[0].dims().size());
+  const uint64_t M = size_to_dim_(canonical_axis, GetDimsVector(in[0]));
+  const uint64_t K = size_from_dim_(canonical_axis, GetDimsVector(in[0]));
+  const TensorShape Y = FCShapeInference(def, in, pretransposed_weight)[0];
+  const uint64_t N = nElemFromShape(Y) / std::max<uint64_t>(M, 1);
+
+  c.flops = 2 * M * N * K + M * N;
+  c.bytes_moved = nBytesFromShape(in[0]) + nBytesFromShape(in[1]) +
+      nBytesFromShape(in[2]) + nBytesFromShape(Y);
+  return c;
+}
 } // namespace
 
 using namespace std::placeholders;
@@ -68,6 +88,7 @@ OPERATOR_SCHEMA(FCTransposed)
     .NumInputs(3)
     .NumOutputs(1)
     .TensorInferenceFunction(std::bind(FCShapeInference, _1, _2, true))
+    .CostInferenceFunction(std::bind(CostInferenceForFC, _1, _2, true))
     .SetDoc(R"DOC(
 Same as FC, but weight matrix is supposed to be already pretransposed.
 FCTransposed stands for calling blass with no noTrans, noTrans
@@ -77,6 +98,7 @@ OPERATOR_SCHEMA(FC)
     .NumInputs(3)
     .NumOutputs(1)
     .TensorInferenceFunction(std::bind(FCShapeInference, _1, _2, false))
+    .CostInferenceFunction(std::bind(CostInferenceForFC, _1, _2, false))
     .SetDoc(R"DOC(
     Computes the result of passing an input vector X into a fully
     connected layer with 2D weight matrix W and 1D bias vector b. That is,
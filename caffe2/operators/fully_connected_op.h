@@ -17,13 +17,52 @@
 #ifndef CAFFE2_OPERATORS_FULLY_CONNECTED_OP_H_
 #define CAFFE2_OPERATORS_FULLY_CONNECTED_OP_H_
 
+#include <type_traits>
+
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/perfkernels/fc_small_batch.h"
 #include "caffe2/utils/conversions.h"
 #include "caffe2/utils/math.h"
 
 namespace caffe2 {
 
+namespace fc_detail {
+
+// Small batches skip math::Gemm, which is tuned for large matrices, for the
+// dot product kernels of perfkernels/fc_small_batch.h. Only float on CPU has
+// such a kernel.
+template <typename T_X, typename T_W, typename T_B, typename T_Y, class Context>
+inline bool RunSmallBatch(
+    int /* M */,
+    int /* N */,
+    int /* K */,
+    const T_X* /* X */,
+    const T_W* /* W */,
+    const T_B* /* b */,
+    T_Y* /* Y */,
+    Context* /* context */) {
+  return false;
+}
+
+inline bool RunSmallBatch(
+    int M,
+    int N,
+    int K,
+    const float* X,
+    const float* W,
+    const float* b,
+    float* Y,
+    CPUContext* /* context */) {
+  if (M > kFullyConnectedSmallBatchM) {
+    return false;
+  }
+  FullyConnectedSmallBatch(M, N, K, X, W, b, Y);
+  return true;
+}
+
+} // namespace fc_detail
+
 // This is Caffe's InnerProductOp, with a name that fits its purpose better.
 template <
     class Context,
@@ -99,6 +138,19 @@ class FullyConnectedOp final : public Operator<Context> {
       return true;
     }
 
+    if (std::is_same<Engine, DefaultEngine>::value && TransposeWeight &&
+        fc_detail::RunSmallBatch(
+            M,
+            N,
+            K,
+            X.template data<T_X>(),
+            W.template data<T_W>(),
+            b.template data<T_B>(),
+            Y->template mutable_data<T_Y>(),
+            &context_)) {
+      return true;
+    }
+
     // default to FLOAT as math.h does.
     TensorProto::DataType math_type = TensorProto_DataType_FLOAT;
     if (fp16_type<MATH>()) {
@@ -0,0 +1,180 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/fused_activation_ops.h"
+
+namespace caffe2 {
+
+template <>
+struct FusedActivationKernels<CPUContext> {
+  using Types = TensorTypes<float>;
+
+  template <typename T, class Activation>
+  static void Forward(
+      const int size,
+      const int D,
+      const T* X,
+      const T* bias,
+      T* Y,
+      CPUContext* /* context */) {
+    if (bias == nullptr) {
+      for (int i = 0; i < size; ++i) {
+        Y[i] = Activation::Forward(X[i]);
+      }
+      return;
+    }
+    for (int i = 0; i < size; i += D) {
+      for (int j = 0; j < D; ++j) {
+        Y[i + j] = Activation::Forward(X[i + j] + bias[j]);
+      }
+    }
+  }
+
+  template <typename T, class Activation>
+  static void Backward(
+      const int size,
+      const int D,
+      const T* X,
+      const T* bias,
+      const T* dY,
+      T* dX,
+      T* dbias,
+      CPUContext* /* context */) {
+    if (bias == nullptr) {
+      for (int i = 0; i < size; ++i) {
+        dX[i] = dY[i] * Activation::Backward(X[i]);
+      }
+      return;
+    }
+    if (dbias != nullptr) {
+      std::fill(dbias, dbias + D, T(0));
+    }
+    for (int i = 0; i < size; i += D) {
+      for (int j = 0; j < D; ++j) {
+        dX[i + j] = dY[i + j] * Activation::Backward(X[i + j] + bias[j]);
+      }
+      if (dbias != nullptr) {
+        for (int j = 0; j < D; ++j) {
+          dbias[j] += dX[i + j];
+        }
+      }
+    }
+  }
+};
+
+namespace {
+
+// The gradient op of Foo is FooGradient, it takes the inputs of Foo and dY,
+// and outputs the gradients of all the inputs of Foo.
+class GetFusedActivationGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    vector<string> inputs;
+    vector<string> outputs;
+    for (int i = 0; i < def_.input_size(); ++i) {
+      inputs.push_back(I(i));
+      outputs.push_back(GI(i));
+    }
+    inputs.push_back(GO(0));
+    return SingleGradientDef(def_.type() + "Gradient", "", inputs, outputs);
+  }
+};
+
+} // namespace
+
+REGISTER_CPU_OPERATOR(Gelu, FusedActivationOp<GeluActivation, CPUContext>);
+REGISTER_CPU_OPERATOR(
+    GeluGradient,
+    FusedActivationGradientOp<GeluActivation, CPUContext>);
+REGISTER_CPU_OPERATOR(BiasGelu, FusedActivationOp<GeluActivation, CPUContext>);
+REGISTER_CPU_OPERATOR(
+    BiasGeluGradient,
+    FusedActivationGradientOp<GeluActivation, CPUContext>);
+REGISTER_CPU_OPERATOR(
+    BiasSwish,
+    FusedActivationOp<SwishActivation, CPUContext>);
+REGISTER_CPU_OPERATOR(
+    BiasSwishGradient,
+    FusedActivationGradientOp<SwishActivation, CPUContext>);
+
+OPERATOR_SCHEMA(Gelu)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}})
+    .IdenticalTypeAndShape()
+    .SetDoc(R"DOC(
+Gelu takes one input X and produces one output Y = X * Phi(X), where Phi is
+the cumulative distribution function of the standard normal distribution
+(the exact, erf based form). The gradient is computed from X alone.
+)DOC")
+    .Input(0, "X", "input tensor")
+    .Output(0, "Y", "output tensor");
+
+OPERATOR_SCHEMA(GeluGradient)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}, {1, 0}})
+    .SetDoc(R"DOC(
+GeluGradient takes X and dY and computes dX, without the output of Gelu.
+)DOC");
+
+OPERATOR_SCHEMA(BiasGelu)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}})
+    .IdenticalTypeAndShapeOfInput(0)
+    .SetDoc(R"DOC(
+BiasGelu computes Gelu(X + bias) in a single pass, bias being broadcast over
+the last dimension of X. The gradient is computed from X and bias alone.
+)DOC")
+    .Input(0, "X", "input tensor")
+    .Input(1, "bias", "1D tensor of the size of the last dimension of X")
+    .Output(0, "Y", "output tensor");
+
+OPERATOR_SCHEMA(BiasGeluGradient)
+    .NumInputs(3)
+    .NumOutputs(2)
+    .AllowInplace({{0, 0}, {2, 0}})
+    .SetDoc(R"DOC(
+BiasGeluGradient takes X, bias and dY and computes dX and dbias.
+)DOC");
+
+OPERATOR_SCHEMA(BiasSwish)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}})
+    .IdenticalTypeAndShapeOfInput(0)
+    .SetDoc(R"DOC(
+BiasSwish computes Swish(X + bias) in a single pass, bias being broadcast over
+the last dimension of X. The gradient is computed from X and bias alone.
+)DOC")
+    .Input(0, "X", "input tensor")
+    .Input(1, "bias", "1D tensor of the size of the last dimension of X")
+    .Output(0, "Y", "output tensor");
+
+OPERATOR_SCHEMA(BiasSwishGradient)
+    .NumInputs(3)
+    .NumOutputs(2)
+    .AllowInplace({{0, 0}, {2, 0}})
+    .SetDoc(R"DOC(
+BiasSwishGradient takes X, bias and dY and computes dX and dbias.
+)DOC");
+
+REGISTER_GRADIENT(Gelu, GetFusedActivationGradient);
+REGISTER_GRADIENT(BiasGelu, GetFusedActivationGradient);
+REGISTER_GRADIENT(BiasSwish, GetFusedActivationGradient);
+
+} // namespace caffe2
@@ -0,0 +1,155 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cmath>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+
+// The activations are evaluated in device code by the GPU kernels.
+#if defined(__CUDACC__) || defined(__HIPCC__)
+#define FUSED_ACTIVATION_DECL inline __host__ __device__
+#else
+#define FUSED_ACTIVATION_DECL inline
+#endif
+
+namespace caffe2 {
+
+// Activations are computed in float whatever the storage type. Backward
+// returns dY/dX at x, so that the gradient ops only need the input of the
+// forward op instead of its output or any intermediate.
+struct SwishActivation {
+  static FUSED_ACTIVATION_DECL float Forward(const float x) {
+    return x / (1.f + expf(-x));
+  }
+  static FUSED_ACTIVATION_DECL float Backward(const float x) {
+    const float sig = 1.f / (1.f + expf(-x));
+    return sig + x * sig * (1.f - sig);
+  }
+};
+
+// Exact (erf) form of Gelu, x * Phi(x).
+struct GeluActivation {
+  static FUSED_ACTIVATION_DECL float Forward(const float x) {
+    return 0.5f * x * (1.f + erff(x * 0.70710678118654752f));
+  }
+  static FUSED_ACTIVATION_DECL float Backward(const float x) {
+    return 0.5f * (1.f + erff(x * 0.70710678118654752f)) +
+        x * 0.39894228040143268f * expf(-0.5f * x * x);
+  }
+};
+
+// Forward and Backward are specialized per context, next to the
+// registrations. Types lists the storage types the context supports.
+//
+// Forward computes Y = act(X + bias), bias being broadcast over the last
+// dimension (of size D) or nullptr. Backward computes dX = dY * act'(X + bias)
+// and, if dbias is not nullptr, dbias as the sum of dX over the outer
+// dimensions.
+template <class Context>
+struct FusedActivationKernels;
+
+// Inputs X and an optional bias of the size of the last dimension of X.
+template <class Activation, class Context>
+class FusedActivationOp final : public Operator<Context> {
+ public:
+  USE_SIMPLE_CTOR_DTOR(FusedActivationOp);
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+
+  bool RunOnDevice() override {
+    return DispatchHelper<typename FusedActivationKernels<Context>::Types>::
+        call(this, Input(0));
+  }
+
+  template <typename T>
+  bool DoRunWithType() {
+    const auto& X = Input(0);
+    auto* Y = Output(0);
+    const T* bias_data = nullptr;
+    int D = 1;
+    if (InputSize() > 1) {
+      const auto& bias = Input(1);
+      CAFFE_ENFORCE_GE(X.ndim(), 1);
+      CAFFE_ENFORCE_EQ(bias.ndim(), 1);
+      CAFFE_ENFORCE_EQ(bias.dim32(0), X.dim32(X.ndim() - 1));
+      bias_data = bias.template data<T>();
+      D = bias.dim32(0);
+    }
+    Y->ResizeLike(X);
+    FusedActivationKernels<Context>::template Forward<T, Activation>(
+        X.size(),
+        D,
+        X.template data<T>(),
+        bias_data,
+        Y->template mutable_data<T>(),
+        &context_);
+    return true;
+  }
+};
+
+// Inputs X, the optional bias and dY, outputs dX and, with a bias, dbias.
+// Nothing but the inputs of the forward op is needed, and dX can be computed
+// in place of dY.
+template <class Activation, class Context>
+class FusedActivationGradientOp final : public Operator<Context> {
+ public:
+  USE_SIMPLE_CTOR_DTOR(FusedActivationGradientOp);
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+
+  bool RunOnDevice() override {
+    return DispatchHelper<typename FusedActivationKernels<Context>::Types>::
+        call(this, Input(0));
+  }
+
+  template <typename T>
+  bool DoRunWithType() {
+    const auto& X = Input(0);
+    const auto& dY = Input(InputSize() - 1);
+    auto* dX = Output(0);
+    CAFFE_ENFORCE_EQ(X.dims(), dY.dims());
+    const T* bias_data = nullptr;
+    T* dbias_data = nullptr;
+    int D = 1;
+    if (InputSize() > 2) {
+      const auto& bias = Input(1);
+      CAFFE_ENFORCE_GE(X.ndim(), 1);
+      CAFFE_ENFORCE_EQ(bias.ndim(), 1);
+      CAFFE_ENFORCE_EQ(bias.dim32(0), X.dim32(X.ndim() - 1));
+      bias_data = bias.template data<T>();
+      D = bias.dim32(0);
+      auto* dbias = Output(1);
+      dbias->ResizeLike(bias);
+      dbias_data = dbias->template mutable_data<T>();
+    }
+    dX->ResizeLike(X);
+    FusedActivationKernels<Context>::template Backward<T, Activation>(
+        X.size(),
+        D,
+        X.template data<T>(),
+        bias_data,
+        dY.template data<T>(),
+        dX->template mutable_data<T>(),
+        dbias_data,
+        &context_);
+    return true;
+  }
+};
+
+} // namespace caffe2
+
+#undef FUSED_ACTIVATION_DECL
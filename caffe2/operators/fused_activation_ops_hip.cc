@@ -0,0 +1,211 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hip/hip_runtime.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/fused_activation_ops.h"
+#include "caffe2/utils/conversions.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Elements are moved kVec at a time, in one 16 byte (float) or 8 byte
+// (float16) access, whenever the size and the bias allow it.
+constexpr int kVec = 4;
+
+template <typename T, int N>
+struct alignas(sizeof(T) * N) PackedVector
+{
+    T val[N];
+};
+
+template <typename T, class Activation, int N>
+__global__ void FusedActivationForwardKernel(
+    const int num_packs, const int D, const T* X, const T* bias, T* Y)
+{
+    const PackedVector<T, N>* x = reinterpret_cast<const PackedVector<T, N>*>(X);
+    PackedVector<T, N>* y       = reinterpret_cast<PackedVector<T, N>*>(Y);
+    HIP_1D_KERNEL_LOOP(i, num_packs)
+    {
+        const PackedVector<T, N> in = x[i];
+        PackedVector<T, N> out;
+        const int col = bias == nullptr ? 0 : (i * N) % D;
+#pragma unroll
+        for(int j = 0; j < N; ++j)
+        {
+            float v = convert::To<T, float>(in.val[j]);
+            if(bias != nullptr)
+            {
+                v += convert::To<T, float>(bias[col + j]);
+            }
+            out.val[j] = convert::To<float, T>(Activation::Forward(v));
+        }
+        y[i] = out;
+    }
+}
+
+template <typename T, class Activation, int N>
+__global__ void FusedActivationBackwardKernel(
+    const int num_packs, const int D, const T* X, const T* bias, const T* dY, T* dX)
+{
+    const PackedVector<T, N>* x  = reinterpret_cast<const PackedVector<T, N>*>(X);
+    const PackedVector<T, N>* dy = reinterpret_cast<const PackedVector<T, N>*>(dY);
+    PackedVector<T, N>* dx       = reinterpret_cast<PackedVector<T, N>*>(dX);
+    HIP_1D_KERNEL_LOOP(i, num_packs)
+    {
+        const PackedVector<T, N> in  = x[i];
+        const PackedVector<T, N> grad = dy[i];
+        PackedVector<T, N> out;
+        const int col = bias == nullptr ? 0 : (i * N) % D;
+#pragma unroll
+        for(int j = 0; j < N; ++j)
+        {
+            float v = convert::To<T, float>(in.val[j]);
+            if(bias != nullptr)
+            {
+                v += convert::To<T, float>(bias[col + j]);
+            }
+            out.val[j] = convert::To<float, T>(convert::To<T, float>(grad.val[j]) *
+                                               Activation::Backward(v));
+        }
+        dx[i] = out;
+    }
+}
+
+// One thread per column, consecutive threads read consecutive columns of a
+// row. Accumulated in float.
+template <typename T>
+__global__ void ColumnSumKernel(const int rows, const int D, const T* dX, T* dbias)
+{
+    HIP_1D_KERNEL_LOOP(j, D)
+    {
+        float sum = 0.f;
+        for(int i = 0; i < rows; ++i)
+        {
+            sum += convert::To<T, float>(dX[i * D + j]);
+        }
+        dbias[j] = convert::To<float, T>(sum);
+    }
+}
+
+} // namespace
+
+template <>
+struct FusedActivationKernels<HIPContext>
+{
+    using Types = TensorTypes<float, float16>;
+
+    template <typename T, class Activation>
+    static void Forward(
+        const int size, const int D, const T* X, const T* bias, T* Y, HIPContext* context)
+    {
+        if(size == 0)
+        {
+            return;
+        }
+        if(size % kVec == 0 && (bias == nullptr || D % kVec == 0))
+        {
+            hipLaunchKernelGGL((FusedActivationForwardKernel<T, Activation, kVec>),
+                               dim3(CAFFE_GET_BLOCKS(size / kVec)),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context->hip_stream(),
+                               size / kVec,
+                               D,
+                               X,
+                               bias,
+                               Y);
+        }
+        else
+        {
+            hipLaunchKernelGGL((FusedActivationForwardKernel<T, Activation, 1>),
+                               dim3(CAFFE_GET_BLOCKS(size)),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context->hip_stream(),
+                               size,
+                               D,
+                               X,
+                               bias,
+                               Y);
+        }
+    }
+
+    template <typename T, class Activation>
+    static void Backward(const int size,
+                         const int D,
+                         const T* X,
+                         const T* bias,
+                         const T* dY,
+                         T* dX,
+                         T* dbias,
+                         HIPContext* context)
+    {
+        if(size > 0)
+        {
+            if(size % kVec == 0 && (bias == nullptr || D % kVec == 0))
+            {
+                hipLaunchKernelGGL((FusedActivationBackwardKernel<T, Activation, kVec>),
+                                   dim3(CAFFE_GET_BLOCKS(size / kVec)),
+                                   dim3(CAFFE_HIP_NUM_THREADS),
+                                   0,
+                                   context->hip_stream(),
+                                   size / kVec,
+                                   D,
+                                   X,
+                                   bias,
+                                   dY,
+                                   dX);
+            }
+            else
+            {
+                hipLaunchKernelGGL((FusedActivationBackwardKernel<T, Activation, 1>),
+                                   dim3(CAFFE_GET_BLOCKS(size)),
+                                   dim3(CAFFE_HIP_NUM_THREADS),
+                                   0,
+                                   context->hip_stream(),
+                                   size,
+                                   D,
+                                   X,
+                                   bias,
+                                   dY,
+                                   dX);
+            }
+        }
+        if(dbias != nullptr && D > 0)
+        {
+            hipLaunchKernelGGL((ColumnSumKernel<T>),
+                               dim3(CAFFE_GET_BLOCKS(D)),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context->hip_stream(),
+                               size / D,
+                               D,
+                               dX,
+                               dbias);
+        }
+    }
+};
+
+REGISTER_HIP_OPERATOR(Gelu, FusedActivationOp<GeluActivation, HIPContext>);
+REGISTER_HIP_OPERATOR(GeluGradient, FusedActivationGradientOp<GeluActivation, HIPContext>);
+REGISTER_HIP_OPERATOR(BiasGelu, FusedActivationOp<GeluActivation, HIPContext>);
+REGISTER_HIP_OPERATOR(BiasGeluGradient, FusedActivationGradientOp<GeluActivation, HIPContext>);
+REGISTER_HIP_OPERATOR(BiasSwish, FusedActivationOp<SwishActivation, HIPContext>);
+REGISTER_HIP_OPERATOR(BiasSwishGradient, FusedActivationGradientOp<SwishActivation, HIPContext>);
+
+} // namespace caffe2
@@ -0,0 +1,146 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/gather_ranges_to_dense_op.h"
+#include "caffe2/core/context_hip.h"
+#include "hip/hip_runtime.h"
+
+namespace caffe2 {
+
+namespace {
+
+// One block per batch row, which gathers the range of output j of that row.
+// Data is moved in units of Unit, a word size that divides the item size.
+// Ranges whose length does not match the output are left zero filled, since
+// the mismatch cannot be reported from the device.
+template <typename Index, typename Unit>
+__global__ void GatherRangesToDenseKernel(const int num_outputs,
+                                          const int j,
+                                          const int length,
+                                          const int units_per_item,
+                                          const Index* ranges,
+                                          const Unit* data,
+                                          Unit* output)
+{
+    const int row            = hipBlockIdx_x;
+    const Index range_start  = ranges[(row * num_outputs + j) * 2];
+    const Index range_length = ranges[(row * num_outputs + j) * 2 + 1];
+    if(range_length != length)
+    {
+        return;
+    }
+    const int row_units = length * units_per_item;
+    const Unit* src     = data + range_start * units_per_item;
+    Unit* dst           = output + row * row_units;
+    for(int k = hipThreadIdx_x; k < row_units; k += hipBlockDim_x)
+    {
+        dst[k] = src[k];
+    }
+}
+
+} // namespace
+
+template <>
+class GatherRangesToDenseOp<HIPContext> final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+
+    GatherRangesToDenseOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws),
+          lengths_(OperatorBase::GetRepeatedArgument<int>("lengths"))
+    {
+        CAFFE_ENFORCE_GT(lengths_.size(), 0, "There has to be at least one length");
+        for(auto length : lengths_)
+        {
+            CAFFE_ENFORCE_GT(length, 0, "Each length should be positive");
+        }
+    }
+
+    bool RunOnDevice() override
+    {
+        return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(this, Input(RANGES));
+    }
+
+    template <typename Index>
+    bool DoRunWithType()
+    {
+        const auto itemsize = Input(DATA).meta().itemsize();
+        if(itemsize % sizeof(uint64_t) == 0)
+        {
+            return DoRunWithUnit<Index, uint64_t>();
+        }
+        if(itemsize % sizeof(uint32_t) == 0)
+        {
+            return DoRunWithUnit<Index, uint32_t>();
+        }
+        return DoRunWithUnit<Index, uint8_t>();
+    }
+
+    template <typename Index, typename Unit>
+    bool DoRunWithUnit()
+    {
+        auto& data   = Input(DATA);
+        auto& ranges = Input(RANGES);
+        CAFFE_ENFORCE_EQ(data.ndim(), 1, "Data has to be 1-D");
+        CAFFE_ENFORCE_EQ(ranges.ndim(), 3, "Data has to be 3-D");
+        CAFFE_ENFORCE_EQ(
+            ranges.dim(1), lengths_.size(), "Nummber of ranges should match number of lengths");
+        CAFFE_ENFORCE_EQ(
+            ranges.dim(1), OutputSize(), "Nummber of ranges should match number of outputs");
+        CAFFE_ENFORCE_EQ(ranges.dim(2), 2, "Ranges last dimension should be of size 2");
+        CAFFE_ENFORCE(data.meta().copy() == nullptr,
+                      "GatherRangesToDense on HIP only supports plain data types");
+
+        const int units_per_item = data.meta().itemsize() / sizeof(Unit);
+        const auto batchSize     = ranges.dim(0);
+        vector<TIndex> outputDims{batchSize, 0};
+        for(int j = 0; j < OutputSize(); ++j)
+        {
+            auto* output  = Output(j);
+            outputDims[1] = lengths_[j];
+            output->Resize(outputDims);
+            void* ptr = output->raw_mutable_data(data.meta());
+            HIP_CHECK(hipMemsetAsync(ptr, 0, output->nbytes(), context_.hip_stream()));
+            if(batchSize == 0)
+            {
+                continue;
+            }
+            hipLaunchKernelGGL((GatherRangesToDenseKernel<Index, Unit>),
+                               dim3(batchSize),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context_.hip_stream(),
+                               OutputSize(),
+                               j,
+                               lengths_[j],
+                               units_per_item,
+                               ranges.template data<Index>(),
+                               static_cast<const Unit*>(data.raw_data()),
+                               static_cast<Unit*>(ptr));
+        }
+        return true;
+    }
+
+    INPUT_TAGS(DATA, RANGES);
+
+    private:
+    vector<int> lengths_;
+};
+
+REGISTER_HIP_OPERATOR(GatherRangesToDense, GatherRangesToDenseOp<HIPContext>);
+
+} // namespace caffe2
@@ -0,0 +1,499 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/generate_proposals_op.h"
+#include "caffe2/operators/generate_proposals_op_util_boxes.h"
+#include "caffe2/operators/top_k_hip.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Boxes are compared 64 at a time, one bit per box in a 64-bit mask word.
+constexpr int kNMSBlockSize = 64;
+
+// The NMS mask takes pre_nms^2 / 8 bytes per image, 32MB with this many boxes.
+constexpr int kMaxNMSBoxes = 16384;
+
+inline int DivUp(const int a, const int b) { return (a + b - 1) / b; }
+
+// keys[n * K + k] = scores[n, a, h, w] with k = (h * W + w) * A + a, the
+// (H, W, A) order of the anchors.
+__global__ void GenerateProposalsTransposeScoresKernel(
+    const int N, const int A, const int H, const int W, const float* scores, float* keys)
+{
+    const int K = H * W * A;
+    HIP_1D_KERNEL_LOOP(i, N * K)
+    {
+        const int n = i / K;
+        const int k = i % K;
+        const int a = k % A;
+        const int hw = k / A;
+        keys[i] = scores[(n * A + a) * H * W + hw];
+    }
+}
+
+// Decodes the pre_nms top scoring anchors of every image into clipped boxes,
+// and marks the boxes that are too small or not centered in the image.
+// sorted_indices are positions in keys, i.e. n * K + k.
+__global__ void GenerateProposalsDecodeKernel(const int N,
+                                              const int A,
+                                              const int H,
+                                              const int W,
+                                              const int pre_nms,
+                                              const float feat_stride,
+                                              const float min_size,
+                                              const float bbox_xform_clip,
+                                              const int* sorted_indices,
+                                              const float* anchors,
+                                              const float* bbox_deltas,
+                                              const float* im_info,
+                                              float* boxes,
+                                              int* valid)
+{
+    const int K = H * W * A;
+    HIP_1D_KERNEL_LOOP(i, N * pre_nms)
+    {
+        const int n = i / pre_nms;
+        const int k = sorted_indices[n * K + i % pre_nms] - n * K;
+        const int a = k % A;
+        const int hw = k / A;
+        const float shift_x = (hw % W) * feat_stride;
+        const float shift_y = (hw / W) * feat_stride;
+        const float x1 = anchors[a * 4] + shift_x;
+        const float y1 = anchors[a * 4 + 1] + shift_y;
+        const float x2 = anchors[a * 4 + 2] + shift_x;
+        const float y2 = anchors[a * 4 + 3] + shift_y;
+
+        const float* deltas = bbox_deltas + n * 4 * K;
+        const float dx = deltas[(a * 4) * H * W + hw];
+        const float dy = deltas[(a * 4 + 1) * H * W + hw];
+        const float dw = fminf(deltas[(a * 4 + 2) * H * W + hw], bbox_xform_clip);
+        const float dh = fminf(deltas[(a * 4 + 3) * H * W + hw], bbox_xform_clip);
+
+        // Same transform as utils::bbox_transform with unit weights.
+        const float width = x2 - x1 + 1.0f;
+        const float height = y2 - y1 + 1.0f;
+        const float ctr_x = x1 + 0.5f * width;
+        const float ctr_y = y1 + 0.5f * height;
+        const float pred_ctr_x = dx * width + ctr_x;
+        const float pred_ctr_y = dy * height + ctr_y;
+        const float pred_w = expf(dw) * width;
+        const float pred_h = expf(dh) * height;
+
+        const float im_height = im_info[n * 3];
+        const float im_width = im_info[n * 3 + 1];
+        const float im_scale = im_info[n * 3 + 2];
+        float* box = boxes + i * 4;
+        box[0] = fmaxf(fminf(pred_ctr_x - 0.5f * pred_w, im_width - 1.0f), 0.0f);
+        box[1] = fmaxf(fminf(pred_ctr_y - 0.5f * pred_h, im_height - 1.0f), 0.0f);
+        box[2] = fmaxf(fminf(pred_ctr_x + 0.5f * pred_w, im_width - 1.0f), 0.0f);
+        box[3] = fmaxf(fminf(pred_ctr_y + 0.5f * pred_h, im_height - 1.0f), 0.0f);
+
+        // Same test as utils::filter_boxes.
+        const float ws = box[2] - box[0] + 1.0f;
+        const float hs = box[3] - box[1] + 1.0f;
+        const float scaled_min_size = min_size * im_scale;
+        valid[i] = ws >= scaled_min_size && hs >= scaled_min_size &&
+                   box[0] + ws / 2.0f < im_width && box[1] + hs / 2.0f < im_height;
+    }
+}
+
+__device__ inline float BoxIoU(const float* a, const float* b)
+{
+    const float w = fmaxf(fminf(a[2], b[2]) - fmaxf(a[0], b[0]) + 1.0f, 0.0f);
+    const float h = fmaxf(fminf(a[3], b[3]) - fmaxf(a[1], b[1]) + 1.0f, 0.0f);
+    const float inter = w * h;
+    const float area_a = (a[2] - a[0] + 1.0f) * (a[3] - a[1] + 1.0f);
+    const float area_b = (b[2] - b[0] + 1.0f) * (b[3] - b[1] + 1.0f);
+    return inter / (area_a + area_b - inter);
+}
+
+// mask[n][i][j / 64] has bit j % 64 set if box j comes after box i and
+// overlaps it by more than thresh. Grid is (col blocks, row blocks, N) with
+// kNMSBlockSize threads per block.
+__global__ void NMSMaskKernel(
+    const int num_boxes, const float thresh, const float* boxes, unsigned long long* mask)
+{
+    const int n = hipBlockIdx_z;
+    const int row_start = hipBlockIdx_y * kNMSBlockSize;
+    const int col_start = hipBlockIdx_x * kNMSBlockSize;
+    const int col_blocks = DivUp(num_boxes, kNMSBlockSize);
+    if(col_start + kNMSBlockSize <= row_start)
+    {
+        // Every column comes before every row, NMSReduceKernel never reads
+        // these words.
+        return;
+    }
+
+    const float* image_boxes = boxes + n * num_boxes * 4;
+    __shared__ float col_boxes[kNMSBlockSize * 4];
+    const int num_cols = min(num_boxes - col_start, kNMSBlockSize);
+    if(hipThreadIdx_x < num_cols)
+    {
+        for(int c = 0; c < 4; ++c)
+        {
+            col_boxes[hipThreadIdx_x * 4 + c] = image_boxes[(col_start + hipThreadIdx_x) * 4 + c];
+        }
+    }
+    __syncthreads();
+
+    const int row = row_start + hipThreadIdx_x;
+    if(row >= num_boxes)
+    {
+        return;
+    }
+    const float* row_box = image_boxes + row * 4;
+    unsigned long long bits = 0;
+    for(int j = max(row - col_start + 1, 0); j < num_cols; ++j)
+    {
+        if(BoxIoU(row_box, col_boxes + j * 4) > thresh)
+        {
+            bits |= 1ULL << j;
+        }
+    }
+    mask[(n * num_boxes + row) * col_blocks + hipBlockIdx_x] = bits;
+}
+
+// Greedy NMS of every image in score order, one block per image. The removed
+// bitmask lives in dynamic shared memory (col_blocks words) and starts with
+// the boxes rejected by the decode kernel. Writes the indices of the first
+// max_keep boxes kept to keep[n * max_keep] and their number to num_kept[n].
+__global__ void NMSReduceKernel(const int num_boxes,
+                                const int max_keep,
+                                const int* valid,
+                                const unsigned long long* mask,
+                                int* keep,
+                                int* num_kept)
+{
+    HIP_DYNAMIC_SHARED(unsigned long long, removed);
+    const int n = hipBlockIdx_x;
+    const int col_blocks = DivUp(num_boxes, kNMSBlockSize);
+    for(int b = hipThreadIdx_x; b < col_blocks; b += hipBlockDim_x)
+    {
+        unsigned long long bits = 0;
+        for(int j = 0; j < kNMSBlockSize && b * kNMSBlockSize + j < num_boxes; ++j)
+        {
+            if(!valid[n * num_boxes + b * kNMSBlockSize + j])
+            {
+                bits |= 1ULL << j;
+            }
+        }
+        removed[b] = bits;
+    }
+    __syncthreads();
+
+    int kept = 0;
+    for(int i = 0; i < num_boxes && kept < max_keep; ++i)
+    {
+        // Every thread reads the same word, so they all agree on the branch.
+        if(removed[i / kNMSBlockSize] & (1ULL << (i % kNMSBlockSize)))
+        {
+            continue;
+        }
+        if(hipThreadIdx_x == 0)
+        {
+            keep[n * max_keep + kept] = i;
+        }
+        ++kept;
+        __syncthreads();
+        const unsigned long long* row = mask + (n * num_boxes + i) * col_blocks;
+        for(int b = i / kNMSBlockSize + hipThreadIdx_x; b < col_blocks; b += hipBlockDim_x)
+        {
+            removed[b] |= row[b];
+        }
+        __syncthreads();
+    }
+    if(hipThreadIdx_x == 0)
+    {
+        num_kept[n] = kept;
+    }
+}
+
+// rois[offset + j] = [n, box], probs[offset + j] = score of the j-th box
+// kept for image n.
+__global__ void GenerateProposalsOutputKernel(const int N,
+                                              const int K,
+                                              const int pre_nms,
+                                              const int max_keep,
+                                              const int* keep,
+                                              const int* num_kept,
+                                              const int* offsets,
+                                              const float* boxes,
+                                              const float* sorted_keys,
+                                              float* rois,
+                                              float* probs)
+{
+    HIP_1D_KERNEL_LOOP(i, N * max_keep)
+    {
+        const int n = i / max_keep;
+        const int j = i % max_keep;
+        if(j >= num_kept[n])
+        {
+            continue;
+        }
+        const int box = keep[i];
+        const int out = offsets[n] + j;
+        rois[out * 5] = n;
+        for(int c = 0; c < 4; ++c)
+        {
+            rois[out * 5 + 1 + c] = boxes[(n * pre_nms + box) * 4 + c];
+        }
+        probs[out] = sorted_keys[n * K + box];
+    }
+}
+
+} // namespace
+
+// Runs the whole RPN proposal generation on the device: anchor decoding,
+// pre-NMS top-K through a segmented sort of the scores, and a bitmask NMS.
+// Only the number of boxes kept per image is copied back, to size the
+// outputs.
+template <>
+class GenerateProposalsOp<HIPContext> final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    GenerateProposalsOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws),
+          spatial_scale_(OperatorBase::GetSingleArgument<float>("spatial_scale", 1.0 / 16)),
+          feat_stride_(1.0 / spatial_scale_),
+          rpn_pre_nms_topN_(OperatorBase::GetSingleArgument<int>("pre_nms_topN", 6000)),
+          rpn_post_nms_topN_(OperatorBase::GetSingleArgument<int>("post_nms_topN", 300)),
+          rpn_nms_thresh_(OperatorBase::GetSingleArgument<float>("nms_thresh", 0.7f)),
+          rpn_min_size_(OperatorBase::GetSingleArgument<float>("min_size", 16))
+    {
+    }
+
+    bool RunOnDevice() override;
+
+    protected:
+    // spatial_scale_ must be declared before feat_stride_
+    float spatial_scale_{1.0};
+    float feat_stride_{1.0};
+    int rpn_pre_nms_topN_{6000};
+    int rpn_post_nms_topN_{300};
+    float rpn_nms_thresh_{0.7};
+    float rpn_min_size_{16};
+
+    private:
+    Tensor<HIPContext> keys_;
+    Tensor<HIPContext> sorted_keys_;
+    Tensor<HIPContext> sorted_indices_;
+    Tensor<HIPContext> segment_offsets_;
+    Tensor<HIPContext> boxes_;
+    Tensor<HIPContext> valid_;
+    Tensor<HIPContext> mask_;
+    Tensor<HIPContext> keep_;
+    Tensor<HIPContext> num_kept_;
+    Tensor<HIPContext> offsets_;
+    Tensor<HIPContext> scratch_;
+};
+
+bool GenerateProposalsOp<HIPContext>::RunOnDevice()
+{
+    const auto& scores = Input(0);
+    const auto& bbox_deltas = Input(1);
+    const auto& im_info = Input(2);
+    const auto& anchors = Input(3);
+    auto* out_rois = Output(0);
+    auto* out_rois_probs = Output(1);
+
+    CAFFE_ENFORCE_EQ(scores.ndim(), 4, scores.ndim());
+    CAFFE_ENFORCE(scores.template IsType<float>(), scores.meta().name());
+    const int N = scores.dim32(0);
+    const int A = scores.dim32(1);
+    const int H = scores.dim32(2);
+    const int W = scores.dim32(3);
+    const int K = H * W * A;
+
+    CAFFE_ENFORCE_EQ(bbox_deltas.dim32(0), N);
+    CAFFE_ENFORCE_EQ(bbox_deltas.dim32(1), 4 * A);
+    CAFFE_ENFORCE_EQ(bbox_deltas.dim32(2), H);
+    CAFFE_ENFORCE_EQ(bbox_deltas.dim32(3), W);
+    CAFFE_ENFORCE_EQ(im_info.dim32(0), N);
+    CAFFE_ENFORCE_EQ(im_info.dim32(1), 3);
+    CAFFE_ENFORCE_EQ(anchors.dim32(0), A);
+    CAFFE_ENFORCE_EQ(anchors.dim32(1), 4);
+
+    const int pre_nms = (rpn_pre_nms_topN_ <= 0 || rpn_pre_nms_topN_ >= K) ? K : rpn_pre_nms_topN_;
+    const int max_keep =
+        (rpn_post_nms_topN_ <= 0 || rpn_post_nms_topN_ >= pre_nms) ? pre_nms : rpn_post_nms_topN_;
+    CAFFE_ENFORCE_LE(pre_nms,
+                     kMaxNMSBoxes,
+                     "GenerateProposals on HIP runs NMS on at most ",
+                     kMaxNMSBoxes,
+                     " boxes per image, but ",
+                     pre_nms,
+                     " anchors are kept; set pre_nms_topN to a positive value of at most ",
+                     kMaxNMSBoxes,
+                     ".");
+    if(N == 0 || K == 0)
+    {
+        out_rois->Resize(0, 5);
+        out_rois->mutable_data<float>();
+        out_rois_probs->Resize(0);
+        out_rois_probs->mutable_data<float>();
+        return true;
+    }
+
+    // Sort the anchors of every image by score.
+    keys_.Resize(N * K);
+    sorted_keys_.Resize(N * K);
+    sorted_indices_.Resize(N * K);
+    segment_offsets_.Resize(N + 1);
+    hipLaunchKernelGGL((GenerateProposalsTransposeScoresKernel),
+                       dim3(CAFFE_GET_BLOCKS(N * K)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       N,
+                       A,
+                       H,
+                       W,
+                       scores.data<float>(),
+                       keys_.mutable_data<float>());
+    hipLaunchKernelGGL((TopKUniformOffsetsKernel<int>),
+                       dim3(CAFFE_GET_BLOCKS(N + 1)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       N + 1,
+                       K,
+                       segment_offsets_.mutable_data<int>());
+    SegmentedSortDescending(N * K,
+                            N,
+                            keys_.data<float>(),
+                            segment_offsets_.data<int>(),
+                            sorted_keys_.mutable_data<float>(),
+                            sorted_indices_.mutable_data<int>(),
+                            &scratch_,
+                            &context_);
+
+    // Decode, clip and filter the pre_nms best anchors.
+    boxes_.Resize(N * pre_nms, 4);
+    valid_.Resize(N * pre_nms);
+    hipLaunchKernelGGL((GenerateProposalsDecodeKernel),
+                       dim3(CAFFE_GET_BLOCKS(N * pre_nms)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       N,
+                       A,
+                       H,
+                       W,
+                       pre_nms,
+                       feat_stride_,
+                       rpn_min_size_,
+                       utils::BBOX_XFORM_CLIP_DEFAULT,
+                       sorted_indices_.data<int>(),
+                       anchors.data<float>(),
+                       bbox_deltas.data<float>(),
+                       im_info.data<float>(),
+                       boxes_.mutable_data<float>(),
+                       valid_.mutable_data<int>());
+
+    // NMS in score order.
+    const int col_blocks = DivUp(pre_nms, kNMSBlockSize);
+    mask_.Resize(N * pre_nms * col_blocks);
+    keep_.Resize(N * max_keep);
+    num_kept_.Resize(N);
+    auto* mask = reinterpret_cast<unsigned long long*>(mask_.mutable_data<int64_t>());
+    hipLaunchKernelGGL((NMSMaskKernel),
+                       dim3(col_blocks, col_blocks, N),
+                       dim3(kNMSBlockSize),
+                       0,
+                       context_.hip_stream(),
+                       pre_nms,
+                       rpn_nms_thresh_,
+                       boxes_.data<float>(),
+                       mask);
+    hipLaunchKernelGGL((NMSReduceKernel),
+                       dim3(N),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       col_blocks * sizeof(unsigned long long),
+                       context_.hip_stream(),
+                       pre_nms,
+                       max_keep,
+                       valid_.data<int>(),
+                       mask,
+                       keep_.mutable_data<int>(),
+                       num_kept_.mutable_data<int>());
+
+    // The output size is the only thing needed on the host.
+    TensorCPU num_kept_host(num_kept_, &context_);
+    context_.FinishDeviceComputation();
+    const int* num_kept = num_kept_host.data<int>();
+    const int total = std::accumulate(num_kept, num_kept + N, 0);
+    offsets_.Resize(N + 1);
+    TopKLengthsToOffsets<int>(
+        N, num_kept_.data<int>(), offsets_.mutable_data<int>(), &scratch_, &context_);
+
+    out_rois->Resize(total, 5);
+    out_rois_probs->Resize(total);
+    hipLaunchKernelGGL((GenerateProposalsOutputKernel),
+                       dim3(CAFFE_GET_BLOCKS(N * max_keep)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       N,
+                       K,
+                       pre_nms,
+                       max_keep,
+                       keep_.data<int>(),
+                       num_kept_.data<int>(),
+                       offsets_.data<int>(),
+                       boxes_.data<float>(),
+                       sorted_keys_.data<float>(),
+                       out_rois->mutable_data<float>(),
+                       out_rois_probs->mutable_data<float>());
+    return true;
+}
+
+REGISTER_HIP_OPERATOR(GenerateProposals, GenerateProposalsOp<HIPContext>);
+
+OPERATOR_SCHEMA(GenerateProposals)
+    .NumInputs(4)
+    .NumOutputs(2)
+    .SetDoc(R"DOC(
+Generate bounding box proposals for Faster RCNN. The proposals are generated for
+a list of images based on image score 'score', bounding box regression result
+'deltas' as well as predefined bounding box shapes 'anchors'. Greedy
+non-maximum suppression is applied to generate the final bounding boxes.
+
+The anchors of every image are ranked by score, the pre_nms_topN best ones
+are decoded, clipped to the image and filtered by min_size, and NMS keeps up
+to post_nms_topN of them. A value <= 0 for either keeps all the boxes; on HIP
+the boxes entering NMS are limited to 16384 per image.
+)DOC")
+    .Arg("spatial_scale", "(float) spatial scale, 1 / feature stride, default 1/16")
+    .Arg("pre_nms_topN", "(int) RPN_PRE_NMS_TOP_N, default 6000")
+    .Arg("post_nms_topN", "(int) RPN_POST_NMS_TOP_N, default 300")
+    .Arg("nms_thresh", "(float) RPN_NMS_THRESH, default 0.7")
+    .Arg("min_size", "(float) RPN_MIN_SIZE, default 16")
+    .Input(0, "scores", "Scores from conv layer, size (img_count, A, H, W)")
+    .Input(1,
+           "bbox_deltas",
+           "Bounding box deltas from conv layer, size (img_count, 4 * A, H, W)")
+    .Input(2, "im_info", "Image info, size (img_count, 3), format (height, width, scale)")
+    .Input(3, "anchors", "Bounding box anchors, size (A, 4)")
+    .Output(0, "rois", "Proposals, size (n x 5), format (image_index, x1, y1, x2, y2)")
+    .Output(1, "rois_probs", "Scores of the proposals, size (n)");
+
+SHOULD_NOT_DO_GRADIENT(GenerateProposals);
+
+} // namespace caffe2
@@ -41,6 +41,35 @@ void GluOp<float, CPUContext>::ComputeGlu(
   }
 }
 
+template <>
+void GluGradientOp<float, CPUContext>::ComputeGluGradient(
+    const int M,
+    const int split_dim,
+    const int N,
+    const float* Xdata,
+    const float* dYdata,
+    float* dXdata) {
+  const int xStride = 2 * split_dim * N;
+  const int yStride = split_dim * N;
+  for (int i = 0; i < M; ++i) {
+    const int idx = i * xStride;
+    const int idy = i * yStride;
+    for (int j = 0; j < split_dim; ++j) {
+      const int jN = j * N;
+      const int jdx1 = idx + jN;
+      const int jdx2 = idx + (j + split_dim) * N;
+      const int jdy = idy + jN;
+      for (int k = 0; k < N; ++k) {
+        const float x1 = Xdata[jdx1 + k];
+        const float sig = sigmoid(Xdata[jdx2 + k]);
+        const float dy = dYdata[jdy + k];
+        dXdata[jdx1 + k] = dy * sig;
+        dXdata[jdx2 + k] = dy * x1 * sig * (1. - sig);
+      }
+    }
+  }
+}
+
 OPERATOR_SCHEMA(Glu)
     .NumInputs(1)
     .NumOutputs(1)
@@ -53,5 +82,15 @@ OPERATOR_SCHEMA(Glu)
     .Input(0, "X", "1D input tensor")
     .Output(0, "Y", "1D output tensor");
 
+OPERATOR_SCHEMA(GluGradient)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+GluGradient takes X and dY and computes dX, recomputing the sigmoid of the
+second half of X instead of keeping intermediates of the forward pass.
+)DOC");
+
 REGISTER_CPU_OPERATOR(Glu, GluOp<float, CPUContext>);
+REGISTER_CPU_OPERATOR(GluGradient, GluGradientOp<float, CPUContext>);
+REGISTER_GRADIENT(Glu, GetGluGradient);
 } // namespace caffe2
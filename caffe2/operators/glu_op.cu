@@ -22,6 +22,28 @@ __global__ void glu_kernel(
     Ydata[i * yOffset + j * N + k] = x1 * (1. / (1. + exp(-x2)));
   }
 }
+
+__global__ void glu_gradient_kernel(
+    const int M,
+    const int split_dim_size,
+    const int N,
+    const float* Xdata,
+    const float* dYdata,
+    float* dXdata) {
+  const int xOffset = 2 * split_dim_size * N;
+  const int yOffset = split_dim_size * N;
+  CUDA_1D_KERNEL_LOOP(index, M * split_dim_size * N) {
+    const int i = index / split_dim_size / N;
+    const int j = index / N % split_dim_size;
+    const int k = index % N;
+    const int x1_index = i * xOffset + j * N + k;
+    const int x2_index = i * xOffset + (j + split_dim_size) * N + k;
+    const float sig = 1.f / (1.f + expf(-Xdata[x2_index]));
+    const float dy = dYdata[i * yOffset + j * N + k];
+    dXdata[x1_index] = dy * sig;
+    dXdata[x2_index] = dy * Xdata[x1_index] * sig * (1.f - sig);
+  }
+}
 } // namespace
 
 template <>
@@ -38,5 +60,22 @@ void GluOp<float, CUDAContext>::ComputeGlu(
       context_.cuda_stream()>>>(M, split_dim_size, N, x_data, y_data);
 }
 
+template <>
+void GluGradientOp<float, CUDAContext>::ComputeGluGradient(
+    const int M,
+    const int split_dim_size,
+    const int N,
+    const float* x_data,
+    const float* dy_data,
+    float* dx_data) {
+  glu_gradient_kernel<<<
+      CAFFE_GET_BLOCKS(M * N * split_dim_size),
+      CAFFE_CUDA_NUM_THREADS,
+      0,
+      context_.cuda_stream()>>>(
+      M, split_dim_size, N, x_data, dy_data, dx_data);
+}
+
 REGISTER_CUDA_OPERATOR(Glu, GluOp<float, CUDAContext>);
+REGISTER_CUDA_OPERATOR(GluGradient, GluGradientOp<float, CUDAContext>);
 } // namespace caffe2
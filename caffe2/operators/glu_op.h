@@ -50,6 +50,67 @@ class GluOp final : public Operator<Context> {
  private:
   const int dim_;
 };
+
+// Takes X and dY, the sigmoid of the second half of X is recomputed rather
+// than kept from the forward pass.
+template <typename T, class Context>
+class GluGradientOp final : public Operator<Context> {
+ public:
+  GluGradientOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        dim_(OperatorBase::GetSingleArgument<int>("dim", -1)) {}
+
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+
+  bool RunOnDevice() {
+    auto& X = Input(0);
+    auto& dY = Input(1);
+    auto* dX = Output(0);
+    const int split_index = dim_ == -1 ? X.ndim() - 1 : dim_;
+    CAFFE_ENFORCE_LT(split_index, X.ndim());
+    CAFFE_ENFORCE(
+        X.dim(split_index) % 2 == 0,
+        "Split dimension ",
+        X.dim(split_index),
+        " should be divided by two");
+    const int split_dim_size = X.dim(split_index) / 2;
+    const int M = X.size_to_dim(split_index);
+    const int N = X.size_from_dim(split_index + 1);
+    CAFFE_ENFORCE_EQ(dY.size(), M * split_dim_size * N);
+    dX->ResizeLike(X);
+    ComputeGluGradient(
+        M,
+        split_dim_size,
+        N,
+        X.template data<T>(),
+        dY.template data<T>(),
+        dX->template mutable_data<T>());
+    return true;
+  }
+
+ protected:
+  void ComputeGluGradient(
+      const int M,
+      const int split_dim_size,
+      const int N,
+      const T* X,
+      const T* dY,
+      T* dX);
+
+ private:
+  const int dim_;
+};
+
+class GetGluGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    return SingleGradientDef(
+        "GluGradient",
+        "",
+        vector<string>{I(0), GO(0)},
+        vector<string>{GI(0)});
+  }
+};
 } // namespace caffe2
 
 #endif // CAFFE2_OPERATOR_GLU_OP_H_
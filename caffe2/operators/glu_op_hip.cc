@@ -21,6 +21,29 @@ glu_kernel(const int M, const int split_dim_size, const int N, const float* Xdat
         Ydata[i * yOffset + j * N + k] = x1 * (1. / (1. + exp(-x2)));
     }
 }
+
+__global__ void glu_gradient_kernel(const int M,
+                                    const int split_dim_size,
+                                    const int N,
+                                    const float* Xdata,
+                                    const float* dYdata,
+                                    float* dXdata)
+{
+    const int xOffset = 2 * split_dim_size * N;
+    const int yOffset = split_dim_size * N;
+    HIP_1D_KERNEL_LOOP(index, M * split_dim_size * N)
+    {
+        const int i        = index / split_dim_size / N;
+        const int j        = index / N % split_dim_size;
+        const int k        = index % N;
+        const int x1_index = i * xOffset + j * N + k;
+        const int x2_index = i * xOffset + (j + split_dim_size) * N + k;
+        const float sig    = 1.f / (1.f + expf(-Xdata[x2_index]));
+        const float dy     = dYdata[i * yOffset + j * N + k];
+        dXdata[x1_index]   = dy * sig;
+        dXdata[x2_index]   = dy * Xdata[x1_index] * sig * (1.f - sig);
+    }
+}
 } // namespace
 
 template <>
@@ -39,5 +62,27 @@ void GluOp<float, HIPContext>::ComputeGlu(
                        y_data);
 }
 
+template <>
+void GluGradientOp<float, HIPContext>::ComputeGluGradient(const int M,
+                                                          const int split_dim_size,
+                                                          const int N,
+                                                          const float* x_data,
+                                                          const float* dy_data,
+                                                          float* dx_data)
+{
+    hipLaunchKernelGGL((glu_gradient_kernel),
+                       dim3(CAFFE_GET_BLOCKS(M * N * split_dim_size)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       M,
+                       split_dim_size,
+                       N,
+                       x_data,
+                       dy_data,
+                       dx_data);
+}
+
 REGISTER_HIP_OPERATOR(Glu, GluOp<float, HIPContext>);
+REGISTER_HIP_OPERATOR(GluGradient, GluGradientOp<float, HIPContext>);
 } // namespace caffe2
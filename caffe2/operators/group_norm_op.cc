@@ -0,0 +1,177 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/group_norm_op.h"
+#include "caffe2/utils/welford.h"
+
+namespace caffe2 {
+
+template <>
+void GroupNormOp<float, CPUContext>::ComputeGroupNorm(
+    const int N,
+    const int C,
+    const TIndex inner,
+    const float* X,
+    const float* gamma,
+    const float* beta,
+    float* Y,
+    float* mean,
+    float* stdev) {
+  const int channels_per_group = C / num_groups_;
+  const TIndex group_size = channels_per_group * inner;
+  for (int i = 0; i < N * num_groups_; ++i) {
+    const TIndex offset = i * group_size;
+    const auto moments = ComputeMoments(X + offset, group_size);
+    mean[i] = moments.mean;
+    stdev[i] = std::sqrt(moments.Variance() + epsilon_);
+    // y = gamma * (x - mean) / stdev + beta folded into one scale and bias
+    // per channel.
+    const int channel_begin = (i % num_groups_) * channels_per_group;
+    for (int j = 0; j < channels_per_group; ++j) {
+      const int c = channel_begin + j;
+      const float scale = gamma[c] / stdev[i];
+      const float bias = beta[c] - moments.mean * scale;
+      const TIndex channel_offset = offset + j * inner;
+      EigenVectorArrayMap<float>(Y + channel_offset, inner) =
+          ConstEigenVectorArrayMap<float>(X + channel_offset, inner) * scale +
+          bias;
+    }
+  }
+}
+
+template <>
+void GroupNormGradientOp<float, CPUContext>::ComputeGroupNormGradient(
+    const int N,
+    const int C,
+    const TIndex inner,
+    const float* dY,
+    const float* X,
+    const float* gamma,
+    const float* mean,
+    const float* stdev,
+    float* dX,
+    float* dgamma,
+    float* dbeta) {
+  const int channels_per_group = C / num_groups_;
+  const TIndex group_size = channels_per_group * inner;
+  std::fill(dgamma, dgamma + C, 0.0f);
+  std::fill(dbeta, dbeta + C, 0.0f);
+  for (int i = 0; i < N * num_groups_; ++i) {
+    const TIndex offset = i * group_size;
+    const int channel_begin = (i % num_groups_) * channels_per_group;
+    const float mu = mean[i];
+    const float inv_sigma = 1.0f / stdev[i];
+    // With xhat = (x - mean) / stdev and g = gamma * dy,
+    // dx = (g - mean(g) - xhat * mean(g * xhat)) / stdev.
+    // The two group sums come from sum(dy) and sum(dy * x) of every channel,
+    // which also give dbeta and dgamma.
+    float g_sum = 0.0f;
+    float gx_sum = 0.0f;
+    for (int j = 0; j < channels_per_group; ++j) {
+      const int c = channel_begin + j;
+      const TIndex channel_offset = offset + j * inner;
+      ConstEigenVectorArrayMap<float> dy(dY + channel_offset, inner);
+      const float dy_sum = dy.sum();
+      const float dy_x_sum =
+          (dy * ConstEigenVectorArrayMap<float>(X + channel_offset, inner))
+              .sum();
+      const float dy_xhat_sum = (dy_x_sum - mu * dy_sum) * inv_sigma;
+      dbeta[c] += dy_sum;
+      dgamma[c] += dy_xhat_sum;
+      g_sum += gamma[c] * dy_sum;
+      gx_sum += gamma[c] * dy_xhat_sum;
+    }
+    // dx = dy * gamma / stdev + x * a + b.
+    const float a = -gx_sum * inv_sigma * inv_sigma / group_size;
+    const float b = -g_sum * inv_sigma / group_size - mu * a;
+    for (int j = 0; j < channels_per_group; ++j) {
+      const int c = channel_begin + j;
+      const TIndex channel_offset = offset + j * inner;
+      EigenVectorArrayMap<float>(dX + channel_offset, inner) =
+          ConstEigenVectorArrayMap<float>(dY + channel_offset, inner) *
+              (gamma[c] * inv_sigma) +
+          ConstEigenVectorArrayMap<float>(X + channel_offset, inner) * a + b;
+    }
+  }
+}
+
+REGISTER_CPU_OPERATOR(GroupNorm, GroupNormOp<float, CPUContext>);
+REGISTER_CPU_OPERATOR(
+    GroupNormGradient,
+    GroupNormGradientOp<float, CPUContext>);
+
+OPERATOR_SCHEMA(GroupNorm)
+    .NumInputs(3)
+    .NumOutputs(3)
+    .CostInferenceFunction(PointwiseCostInference<5>)
+    .TensorInferenceFunction([](const OperatorDef& def,
+                                const vector<TensorShape>& in) {
+      ArgumentHelper helper(def);
+      const int num_groups = helper.GetSingleArgument<int>("num_groups", 32);
+      vector<TensorShape> out(3);
+      out[0] = in[0];
+      out[1] = CreateTensorShape(
+          vector<int>{static_cast<int>(in[0].dims(0)), num_groups},
+          TensorProto::FLOAT);
+      out[2] = out[1];
+      return out;
+    })
+    .SetDoc(R"DOC(
+Carries out group normalization as described in
+https://arxiv.org/abs/1803.08494. The channels of every sample are split into
+num_groups groups, and each group is normalized by its own mean and standard
+deviation before the per channel scale and bias are applied:
+
+y = scale * (x - \mu_g) / \sigma_g + bias
+
+The statistics of a group are computed in a single pass with Welford's
+algorithm. Only NCHW order is supported.
+)DOC")
+    .Arg("num_groups", "(int) default to 32; number of channel groups, has to "
+         "divide the number of channels.")
+    .Arg("epsilon", "(float) default to 1e-5; added to the variance before "
+         "taking the square root.")
+    .Arg("order", "A StorageOrder string, only NCHW is supported.")
+    .Input(0, "input", "The input tensor of shape N x C x ...")
+    .Input(1, "scale", "The 1-dimensional scale tensor of size C.")
+    .Input(2, "bias", "The 1-dimensional bias tensor of size C.")
+    .Output(0, "output", "The output tensor of the same shape as input.")
+    .Output(1, "mean", "The mean of every group, of shape N x num_groups.")
+    .Output(
+        2,
+        "stddev",
+        "The standard deviation of every group, of shape N x num_groups.");
+
+OPERATOR_SCHEMA(GroupNormGradient).NumInputs(5).NumOutputs(3);
+
+namespace {
+
+class GetGroupNormGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    return SingleGradientDef(
+        "GroupNormGradient",
+        "",
+        vector<string>{GO(0), I(0), I(1), O(1), O(2)},
+        vector<string>{GI(0), GI(1), GI(2)});
+  }
+};
+
+} // namespace
+
+REGISTER_GRADIENT(GroupNorm, GetGroupNormGradient);
+
+} // namespace caffe2
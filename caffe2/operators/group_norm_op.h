@@ -0,0 +1,174 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_OPERATORS_GROUP_NORM_OP_H_
+#define CAFFE2_OPERATORS_GROUP_NORM_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+// Normalizes every group of num_groups consecutive channels of a sample by
+// its own mean and standard deviation, then applies the per channel scale and
+// bias. Only NCHW is supported, so a group is a contiguous run of
+// (C / num_groups) * H * W values.
+template <typename T, class Context>
+class GroupNormOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  GroupNormOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        num_groups_(OperatorBase::GetSingleArgument<int>("num_groups", 32)),
+        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)),
+        order_(StringToStorageOrder(
+            OperatorBase::GetSingleArgument<string>("order", "NCHW"))) {
+    CAFFE_ENFORCE_GT(num_groups_, 0);
+    CAFFE_ENFORCE(epsilon_ >= 0, "Must pass a nonnegative epsilon.");
+    CAFFE_ENFORCE(
+        order_ == StorageOrder::NCHW, "GroupNorm only supports NCHW order.");
+  }
+  ~GroupNormOp() {}
+
+  bool RunOnDevice() override {
+    const auto& X = Input(INPUT);
+    const auto& gamma = Input(SCALE);
+    const auto& beta = Input(BIAS);
+    CAFFE_ENFORCE_GE(X.ndim(), 2);
+    const int N = X.dim32(0);
+    const int C = X.dim32(1);
+    CAFFE_ENFORCE_EQ(
+        C % num_groups_, 0, "The channels must be a multiple of num_groups.");
+    CAFFE_ENFORCE_EQ(gamma.size(), C);
+    CAFFE_ENFORCE_EQ(beta.size(), C);
+
+    auto* Y = Output(OUTPUT);
+    auto* mean = Output(MEAN);
+    auto* stdev = Output(STDEV);
+    Y->ResizeLike(X);
+    mean->Resize(N, num_groups_);
+    stdev->Resize(N, num_groups_);
+    ComputeGroupNorm(
+        N,
+        C,
+        X.size_from_dim(2),
+        X.template data<T>(),
+        gamma.template data<T>(),
+        beta.template data<T>(),
+        Y->template mutable_data<T>(),
+        mean->template mutable_data<T>(),
+        stdev->template mutable_data<T>());
+    return true;
+  }
+
+ protected:
+  // inner is H * W.
+  void ComputeGroupNorm(
+      const int N,
+      const int C,
+      const TIndex inner,
+      const T* X,
+      const T* gamma,
+      const T* beta,
+      T* Y,
+      T* mean,
+      T* stdev);
+
+  int num_groups_;
+  float epsilon_;
+  StorageOrder order_;
+
+  INPUT_TAGS(INPUT, SCALE, BIAS);
+  OUTPUT_TAGS(OUTPUT, MEAN, STDEV);
+};
+
+template <typename T, class Context>
+class GroupNormGradientOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  GroupNormGradientOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        num_groups_(OperatorBase::GetSingleArgument<int>("num_groups", 32)),
+        order_(StringToStorageOrder(
+            OperatorBase::GetSingleArgument<string>("order", "NCHW"))) {
+    CAFFE_ENFORCE_GT(num_groups_, 0);
+    CAFFE_ENFORCE(
+        order_ == StorageOrder::NCHW, "GroupNorm only supports NCHW order.");
+  }
+  ~GroupNormGradientOp() {}
+
+  bool RunOnDevice() override {
+    const auto& dY = Input(OUTPUT_GRAD);
+    const auto& X = Input(INPUT);
+    const auto& gamma = Input(SCALE);
+    const auto& mean = Input(MEAN);
+    const auto& stdev = Input(STDEV);
+    CAFFE_ENFORCE_GE(X.ndim(), 2);
+    CAFFE_ENFORCE_EQ(dY.size(), X.size());
+    const int N = X.dim32(0);
+    const int C = X.dim32(1);
+    CAFFE_ENFORCE_EQ(
+        C % num_groups_, 0, "The channels must be a multiple of num_groups.");
+    CAFFE_ENFORCE_EQ(gamma.size(), C);
+    CAFFE_ENFORCE_EQ(mean.size(), N * num_groups_);
+    CAFFE_ENFORCE_EQ(stdev.size(), N * num_groups_);
+
+    auto* dX = Output(INPUT_GRAD);
+    auto* dgamma = Output(SCALE_GRAD);
+    auto* dbeta = Output(BIAS_GRAD);
+    dX->ResizeLike(X);
+    dgamma->ResizeLike(gamma);
+    dbeta->ResizeLike(gamma);
+    ComputeGroupNormGradient(
+        N,
+        C,
+        X.size_from_dim(2),
+        dY.template data<T>(),
+        X.template data<T>(),
+        gamma.template data<T>(),
+        mean.template data<T>(),
+        stdev.template data<T>(),
+        dX->template mutable_data<T>(),
+        dgamma->template mutable_data<T>(),
+        dbeta->template mutable_data<T>());
+    return true;
+  }
+
+ protected:
+  void ComputeGroupNormGradient(
+      const int N,
+      const int C,
+      const TIndex inner,
+      const T* dY,
+      const T* X,
+      const T* gamma,
+      const T* mean,
+      const T* stdev,
+      T* dX,
+      T* dgamma,
+      T* dbeta);
+
+  int num_groups_;
+  StorageOrder order_;
+
+  INPUT_TAGS(OUTPUT_GRAD, INPUT, SCALE, MEAN, STDEV);
+  OUTPUT_TAGS(INPUT_GRAD, SCALE_GRAD, BIAS_GRAD);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_GROUP_NORM_OP_H_
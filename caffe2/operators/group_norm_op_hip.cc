@@ -0,0 +1,138 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/group_norm_op.h"
+#include "hip/hip_runtime.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/row_moments_hip.h"
+
+namespace caffe2 {
+
+namespace {
+
+// One block per channel: dgamma[c] = sum(dy * xhat), dbeta[c] = sum(dy) over
+// the samples and the H * W positions of channel c.
+__global__ void GroupNormParamGradientKernel(const int N,
+                                             const int C,
+                                             const int groups,
+                                             const TIndex inner,
+                                             const float* dY,
+                                             const float* X,
+                                             const float* mean,
+                                             const float* stdev,
+                                             float* dgamma,
+                                             float* dbeta)
+{
+    __shared__ FloatPair shared[CAFFE_HIP_NUM_THREADS];
+    const int channels_per_group = C / groups;
+    for(int c = hipBlockIdx_x; c < C; c += hipGridDim_x)
+    {
+        const int g    = c / channels_per_group;
+        FloatPair sums = {0.f, 0.f};
+        for(TIndex i = hipThreadIdx_x; i < N * inner; i += hipBlockDim_x)
+        {
+            const int n        = i / inner;
+            const TIndex index = (static_cast<TIndex>(n) * C + c) * inner + i % inner;
+            const int row      = n * groups + g;
+            const float dy     = dY[index];
+            sums.a += dy * (X[index] - mean[row]) / stdev[row];
+            sums.b += dy;
+        }
+        sums = RowAllReduce(sums, shared, FloatPairSum());
+        if(hipThreadIdx_x == 0)
+        {
+            dgamma[c] = sums.a;
+            dbeta[c]  = sums.b;
+        }
+    }
+}
+
+} // namespace
+
+template <>
+void GroupNormOp<float, HIPContext>::ComputeGroupNorm(const int N,
+                                                      const int C,
+                                                      const TIndex inner,
+                                                      const float* X,
+                                                      const float* gamma,
+                                                      const float* beta,
+                                                      float* Y,
+                                                      float* mean,
+                                                      float* stdev)
+{
+    LaunchRowNormalize<true>(static_cast<TIndex>(N) * num_groups_,
+                             (C / num_groups_) * inner,
+                             epsilon_,
+                             num_groups_,
+                             inner,
+                             gamma,
+                             beta,
+                             X,
+                             mean,
+                             stdev,
+                             Y,
+                             &context_);
+}
+
+template <>
+void GroupNormGradientOp<float, HIPContext>::ComputeGroupNormGradient(const int N,
+                                                                      const int C,
+                                                                      const TIndex inner,
+                                                                      const float* dY,
+                                                                      const float* X,
+                                                                      const float* gamma,
+                                                                      const float* mean,
+                                                                      const float* stdev,
+                                                                      float* dX,
+                                                                      float* dgamma,
+                                                                      float* dbeta)
+{
+    LaunchRowNormalizeGradient<true>(static_cast<TIndex>(N) * num_groups_,
+                                     (C / num_groups_) * inner,
+                                     num_groups_,
+                                     inner,
+                                     gamma,
+                                     dY,
+                                     X,
+                                     mean,
+                                     stdev,
+                                     dX,
+                                     &context_);
+    if(C == 0)
+    {
+        return;
+    }
+    hipLaunchKernelGGL((GroupNormParamGradientKernel),
+                       dim3(std::min(C, CAFFE_MAXIMUM_NUM_BLOCKS)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       N,
+                       C,
+                       num_groups_,
+                       inner,
+                       dY,
+                       X,
+                       mean,
+                       stdev,
+                       dgamma,
+                       dbeta);
+}
+
+REGISTER_HIP_OPERATOR(GroupNorm, GroupNormOp<float, HIPContext>);
+REGISTER_HIP_OPERATOR(GroupNormGradient, GroupNormGradientOp<float, HIPContext>);
+
+} // namespace caffe2
@@ -44,6 +44,9 @@ class HSoftmaxOpBase : public Operator<Context> {
   Tensor<Context> scale_;
   Tensor<Context> sum_multiplier_;
   Tensor<Context> bias_multiplier_;
+  // (sample, w_offset, w_length, target, output offset) of every path node
+  // of the batch, used by the HIP implementation.
+  Tensor<Context> node_table_;
   static constexpr T kLOG_THRESHOLD() {
     return 1e-20f;
   }
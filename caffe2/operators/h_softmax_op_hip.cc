@@ -0,0 +1,297 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cfloat>
+#include <hipcub/hipcub.hpp>
+#include "hip/hip_runtime.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/h_softmax_op.h"
+
+namespace caffe2 {
+
+namespace {
+
+constexpr int kNodeTableWidth = 5;
+
+// Lays out the path nodes of all the samples in the order of the CPU
+// implementation, so that the intermediate output matches it, and returns
+// the size of the intermediate output.
+int BuildNodeTable(const int* labels,
+                   int M,
+                   std::unordered_map<int, PathProto>& hierarchy,
+                   std::vector<int>* table)
+{
+    int output_offset = 0;
+    for(int sample = 0; sample < M; ++sample)
+    {
+        const PathProto& path = hierarchy[labels[sample]];
+        for(const PathNodeProto& node : path.path_nodes())
+        {
+            table->push_back(sample);
+            table->push_back(node.index());
+            table->push_back(node.length());
+            table->push_back(node.target());
+            table->push_back(output_offset);
+            // Output of FC + Output of Softmax
+            output_offset += 2 * node.length();
+        }
+    }
+    return output_offset;
+}
+
+// One block per path node: FC, softmax and cross entropy of the node.
+__global__ void HSoftmaxForwardKernel(const int K,
+                                      const int* node_table,
+                                      const float* X,
+                                      const float* W,
+                                      const float* b,
+                                      float* int_output,
+                                      float* Y)
+{
+    using BlockReduce = hipcub::BlockReduce<float, CAFFE_HIP_NUM_THREADS>;
+    __shared__ typename BlockReduce::TempStorage temp_storage;
+    __shared__ float row_max;
+    __shared__ float row_sum;
+
+    const int* node       = node_table + kNodeTableWidth * hipBlockIdx_x;
+    const int sample      = node[0];
+    const int w_offset    = node[1];
+    const int w_length    = node[2];
+    const int target      = node[3];
+    float* fc_output      = int_output + node[4];
+    float* softmax_output = fc_output + w_length;
+    const float* x        = X + sample * K;
+
+    float max_val = -FLT_MAX;
+    for(int j = hipThreadIdx_x; j < w_length; j += hipBlockDim_x)
+    {
+        const float* w = W + (w_offset + j) * K;
+        float val      = b[w_offset + j];
+        for(int k = 0; k < K; ++k)
+        {
+            val += w[k] * x[k];
+        }
+        fc_output[j] = val;
+        max_val      = fmaxf(max_val, val);
+    }
+    max_val = BlockReduce(temp_storage).Reduce(max_val, hipcub::Max());
+    if(hipThreadIdx_x == 0)
+    {
+        row_max = max_val;
+    }
+    __syncthreads();
+
+    float sum = 0;
+    for(int j = hipThreadIdx_x; j < w_length; j += hipBlockDim_x)
+    {
+        softmax_output[j] = expf(fc_output[j] - row_max);
+        sum += softmax_output[j];
+    }
+    sum = BlockReduce(temp_storage).Sum(sum);
+    if(hipThreadIdx_x == 0)
+    {
+        row_sum = sum;
+    }
+    __syncthreads();
+
+    for(int j = hipThreadIdx_x; j < w_length; j += hipBlockDim_x)
+    {
+        softmax_output[j] /= row_sum;
+    }
+    if(hipThreadIdx_x == 0)
+    {
+        const float p = expf(fc_output[target] - row_max) / row_sum;
+        atomicAdd(Y + sample, -logf(fmaxf(p, 1e-20f)));
+    }
+}
+
+// One block per path node: backward of the cross entropy, softmax and FC of
+// the node, accumulated into the gradients shared with the other nodes.
+__global__ void HSoftmaxGradientKernel(const int K,
+                                       const int* node_table,
+                                       const float* X,
+                                       const float* W,
+                                       const float* int_output,
+                                       const float* dY,
+                                       float* dX,
+                                       float* dW,
+                                       float* db,
+                                       float* dint_output)
+{
+    const int* node             = node_table + kNodeTableWidth * hipBlockIdx_x;
+    const int sample            = node[0];
+    const int w_offset          = node[1];
+    const int w_length          = node[2];
+    const int target            = node[3];
+    const float* softmax_output = int_output + node[4] + w_length;
+    float* dfc_output           = dint_output + node[4];
+    float* dsoftmax_output      = dfc_output + w_length;
+    const float* x              = X + sample * K;
+
+    const float p_target = softmax_output[target];
+    const float dentropy = -dY[sample] / fmaxf(p_target, 1e-20f);
+    for(int j = hipThreadIdx_x; j < w_length; j += hipBlockDim_x)
+    {
+        const float dj     = j == target ? dentropy : 0.f;
+        const float dfc    = softmax_output[j] * (dj - p_target * dentropy);
+        dsoftmax_output[j] = dj;
+        dfc_output[j]      = dfc;
+        atomicAdd(db + w_offset + j, dfc);
+    }
+    __syncthreads();
+
+    for(int k = hipThreadIdx_x; k < K; k += hipBlockDim_x)
+    {
+        float dx = 0;
+        for(int j = 0; j < w_length; ++j)
+        {
+            const int idx = (w_offset + j) * K + k;
+            atomicAdd(dW + idx, dfc_output[j] * x[k]);
+            dx += dfc_output[j] * W[idx];
+        }
+        atomicAdd(dX + sample * K + k, dx);
+    }
+}
+
+} // namespace
+
+template <>
+bool HSoftmaxOp<float, HIPContext>::RunOnDevice()
+{
+    auto& X                   = Input(0);
+    const auto& W             = Input(1);
+    const auto& b             = Input(2);
+    auto& label               = Input(3);
+    auto* Y                   = Output(0);
+    auto* intermediate_output = Output(1);
+
+    // Batch size
+    int M = X.ndim() > 1 ? X.dim32(0) : 1;
+    // Input feature dimension
+    int K = X.size() / M;
+    CAFFE_ENFORCE_GE(W.ndim(), 2); // N*K
+    CAFFE_ENFORCE_EQ(b.ndim(), 1); // N
+    CAFFE_ENFORCE_EQ(K, W.size() / (W.dim32(0)));
+    // Sum of output dimensions of all hierarchy nodes
+    int N = W.dim32(0);
+    CAFFE_ENFORCE_EQ(N, b.dim32(0));
+    Y->Resize(M);
+    math::Set<float, HIPContext>(M, 0.f, Y->mutable_data<float>(), &context_);
+
+    // The path nodes depend on the label values, so they are walked on the
+    // host once and the whole batch is then computed by a single kernel.
+    TensorCPU label_host(label, &context_);
+    context_.FinishDeviceComputation();
+    const int* labeldata = label_host.data<int>();
+    auto hierarchy       = getHierarchyForLabels(M, labeldata, hierarchy_all_map_);
+    std::vector<int> table;
+    int int_output_size = BuildNodeTable(labeldata, M, hierarchy, &table);
+    intermediate_output->Resize(int_output_size);
+    float* int_output_data = intermediate_output->mutable_data<float>();
+    const int num_nodes    = table.size() / kNodeTableWidth;
+    if(num_nodes == 0)
+    {
+        return true;
+    }
+    node_table_.Resize(table.size());
+    context_.Copy<int, CPUContext, HIPContext>(
+        table.size(), table.data(), node_table_.mutable_data<int>());
+
+    hipLaunchKernelGGL((HSoftmaxForwardKernel),
+                       dim3(num_nodes),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       K,
+                       node_table_.data<int>(),
+                       X.data<float>(),
+                       W.data<float>(),
+                       b.data<float>(),
+                       int_output_data,
+                       Y->mutable_data<float>());
+    return true;
+}
+
+template <>
+bool HSoftmaxGradientOp<float, HIPContext>::RunOnDevice()
+{
+    auto& X                      = Input(0);
+    const auto& W                = Input(1);
+    const auto& b                = Input(2);
+    auto& label                  = Input(3);
+    auto& intermediate_output    = Input(4);
+    auto& dY                     = Input(5);
+    auto* dX                     = Output(0);
+    auto* dW                     = Output(1);
+    auto* db                     = Output(2);
+    auto* dX_intermediate_output = Output(3);
+    dX->ResizeLike(X);
+    dW->ResizeLike(W);
+    db->ResizeLike(b);
+    dX_intermediate_output->ResizeLike(intermediate_output);
+
+    float* dX_data      = dX->mutable_data<float>();
+    float* dW_data      = dW->mutable_data<float>();
+    float* db_data      = db->mutable_data<float>();
+    float* dOutput_data = dX_intermediate_output->mutable_data<float>();
+
+    math::Set<float, HIPContext>(X.size(), 0.f, dX_data, &context_);
+    math::Set<float, HIPContext>(W.size(), 0.f, dW_data, &context_);
+    math::Set<float, HIPContext>(b.size(), 0.f, db_data, &context_);
+    math::Set<float, HIPContext>(intermediate_output.size(), 0.f, dOutput_data, &context_);
+
+    // Batch size
+    int M = X.ndim() > 1 ? X.dim32(0) : 1;
+    // Input feature dimension
+    int K = X.size() / M;
+
+    TensorCPU label_host(label, &context_);
+    context_.FinishDeviceComputation();
+    const int* labeldata = label_host.data<int>();
+    auto hierarchy       = getHierarchyForLabels(M, labeldata, hierarchy_all_map_);
+    std::vector<int> table;
+    CAFFE_ENFORCE_EQ(BuildNodeTable(labeldata, M, hierarchy, &table), intermediate_output.size());
+    const int num_nodes = table.size() / kNodeTableWidth;
+    if(num_nodes == 0)
+    {
+        return true;
+    }
+    node_table_.Resize(table.size());
+    context_.Copy<int, CPUContext, HIPContext>(
+        table.size(), table.data(), node_table_.mutable_data<int>());
+
+    hipLaunchKernelGGL((HSoftmaxGradientKernel),
+                       dim3(num_nodes),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       K,
+                       node_table_.data<int>(),
+                       X.data<float>(),
+                       W.data<float>(),
+                       intermediate_output.data<float>(),
+                       dY.data<float>(),
+                       dX_data,
+                       dW_data,
+                       db_data,
+                       dOutput_data);
+    return true;
+}
+
+REGISTER_HIP_OPERATOR(HSoftmax, HSoftmaxOp<float, HIPContext>);
+REGISTER_HIP_OPERATOR(HSoftmaxGradient, HSoftmaxGradientOp<float, HIPContext>);
+
+} // namespace caffe2
@@ -16,7 +16,45 @@
 
 #include "caffe2/operators/half_float_ops.h"
 
+#include <algorithm>
+
+#include "caffe2/perfkernels/fp16_conversion.h"
+#include "caffe2/utils/conversions.h"
+
 namespace caffe2 {
+
+template <>
+bool FloatToHalfOp<CPUContext>::RunOnDevice() {
+  auto& X = Input(0);
+  auto* Y = Output(0);
+  Y->ResizeLike(X);
+  FloatToFloat16(X.size(), X.data<float>(), Y->mutable_data<float16>());
+  return true;
+}
+
+template <>
+bool HalfToFloatOp<CPUContext>::RunOnDevice() {
+  auto& X = Input(0);
+  auto* Y = Output(0);
+  Y->ResizeLike(X);
+  Float16ToFloat(X.size(), X.data<float16>(), Y->mutable_data<float>());
+  return true;
+}
+
+bool Float16ConstantFillOp::RunOnDevice() {
+  auto* output = Output(0);
+  output->Resize(shape_);
+  const float16 value = convert::cpu_float2half_rn(
+      OperatorBase::GetSingleArgument<float>("value", 0.f));
+  float16* data = output->mutable_data<float16>();
+  std::fill(data, data + output->size(), value);
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(FloatToHalf, FloatToHalfOp<CPUContext>);
+REGISTER_CPU_OPERATOR(HalfToFloat, HalfToFloatOp<CPUContext>);
+REGISTER_CPU_OPERATOR(Float16ConstantFill, Float16ConstantFillOp);
+
 OPERATOR_SCHEMA(FloatToHalf)
     .NumInputs(1)
     .NumOutputs(1)
@@ -0,0 +1,148 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_OPERATORS_IMPLICIT_GEMM_CONV_HIP_H_
+#define CAFFE2_OPERATORS_IMPLICIT_GEMM_CONV_HIP_H_
+
+#include "caffe2/core/context_hip.h"
+#include "hip/hip_runtime.h"
+
+namespace caffe2 {
+
+// Implicit GEMM for convolution-like ops: computes, for every z of the grid,
+//
+//   Y(z, m, p) = sum_k A(z, m, k) * B(z, k, p)
+//
+// where A is the filter and B the column buffer of the op, without ever
+// materializing B: the tiles of both are loaded in shared memory by a Loader
+// with __device__ members
+//
+//   float A(int z, int m, int k) const;
+//   float B(int z, int k, int p) const;
+//   void Store(int z, int m, int p, float value) const;
+//
+// B gathers the input elements, e.g. the (possibly bilinear) samples of
+// the input of a convolution, and Store adds the bias and writes Y.
+namespace implicit_gemm {
+
+constexpr int kTileM  = 64;
+constexpr int kTileN  = 64;
+constexpr int kTileK  = 16;
+constexpr int kThread = 16;
+// Every thread computes kTileM / kThread x kTileN / kThread outputs.
+constexpr int kThreads = kThread * kThread;
+constexpr int kPerThread = kTileM / kThread;
+
+template <typename Loader>
+__global__ void ImplicitGemmKernel(const int M, const int N, const int K, const Loader loader)
+{
+    // The padding keeps the k-major stores of A off a single bank.
+    __shared__ float As[kTileK][kTileM + 1];
+    __shared__ float Bs[kTileK][kTileN];
+
+    const int tx = hipThreadIdx_x % kThread;
+    const int ty = hipThreadIdx_x / kThread;
+    const int m0 = hipBlockIdx_y * kTileM;
+    const int p0 = hipBlockIdx_x * kTileN;
+    const int z  = hipBlockIdx_z;
+
+    float acc[kPerThread][kPerThread];
+    for(int r = 0; r < kPerThread; ++r)
+    {
+        for(int c = 0; c < kPerThread; ++c)
+        {
+            acc[r][c] = 0;
+        }
+    }
+
+    for(int k0 = 0; k0 < K; k0 += kTileK)
+    {
+        // Consecutive threads read consecutive k of the filter, and
+        // consecutive output positions of the input.
+        for(int i = hipThreadIdx_x; i < kTileK * kTileM; i += kThreads)
+        {
+            const int kk = i % kTileK;
+            const int mm = i / kTileK;
+            As[kk][mm] =
+                (m0 + mm < M && k0 + kk < K) ? loader.A(z, m0 + mm, k0 + kk) : 0.f;
+        }
+        for(int i = hipThreadIdx_x; i < kTileK * kTileN; i += kThreads)
+        {
+            const int kk = i / kTileN;
+            const int pp = i % kTileN;
+            Bs[kk][pp] =
+                (p0 + pp < N && k0 + kk < K) ? loader.B(z, k0 + kk, p0 + pp) : 0.f;
+        }
+        __syncthreads();
+        for(int kk = 0; kk < kTileK; ++kk)
+        {
+            float a[kPerThread];
+            float b[kPerThread];
+            for(int r = 0; r < kPerThread; ++r)
+            {
+                a[r] = As[kk][ty + r * kThread];
+                b[r] = Bs[kk][tx + r * kThread];
+            }
+            for(int r = 0; r < kPerThread; ++r)
+            {
+                for(int c = 0; c < kPerThread; ++c)
+                {
+                    acc[r][c] += a[r] * b[c];
+                }
+            }
+        }
+        __syncthreads();
+    }
+
+    for(int r = 0; r < kPerThread; ++r)
+    {
+        const int m = m0 + ty + r * kThread;
+        for(int c = 0; c < kPerThread; ++c)
+        {
+            const int p = p0 + tx + c * kThread;
+            if(m < M && p < N)
+            {
+                loader.Store(z, m, p, acc[r][c]);
+            }
+        }
+    }
+}
+
+// Runs the implicit GEMM for Z independent M x N outputs with K terms.
+template <typename Loader>
+void ImplicitGemm(
+    const int Z, const int M, const int N, const int K, const Loader& loader, HIPContext* context)
+{
+    if(Z == 0 || M == 0 || N == 0)
+    {
+        return;
+    }
+    hipLaunchKernelGGL((ImplicitGemmKernel<Loader>),
+                       dim3((N + kTileN - 1) / kTileN, (M + kTileM - 1) / kTileM, Z),
+                       dim3(kThreads),
+                       0,
+                       context->hip_stream(),
+                       M,
+                       N,
+                       K,
+                       loader);
+}
+
+} // namespace implicit_gemm
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_IMPLICIT_GEMM_CONV_HIP_H_
@@ -20,6 +20,7 @@ namespace caffe2 {
 namespace {
 
 REGISTER_CPU_OPERATOR(IndexHash, IndexHashOp<CPUContext>);
+REGISTER_CPU_OPERATOR(PackedStringIndexHash, PackedStringIndexHashOp);
 
 OPERATOR_SCHEMA(IndexHash)
     .NumInputs(1)
@@ -35,7 +36,21 @@ specified number. All input and output indices are enforced to be positive.
     .Arg("seed", "seed for the hash function")
     .Arg("modulo", "must be > 0, hashed ids will be modulo this number");
 
+OPERATOR_SCHEMA(PackedStringIndexHash)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+IndexHash of packed strings (see StringPack): hashes the bytes of each string,
+the same way IndexHash hashes the bytes of an index, into an int64 index.
+)DOC")
+    .Input(0, "data", "1-D uint8 tensor with the bytes of all the strings.")
+    .Input(1, "lengths", "int32 tensor with the size of each string.")
+    .Output(0, "HashedIndices", "int64 hashed indices of the shape of lengths.")
+    .Arg("seed", "seed for the hash function")
+    .Arg("modulo", "must be > 0, hashed ids will be modulo this number");
+
 SHOULD_NOT_DO_GRADIENT(IndexHash);
+SHOULD_NOT_DO_GRADIENT(PackedStringIndexHash);
 
 } // namespace
 } // namespace caffe2
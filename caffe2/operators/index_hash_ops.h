@@ -19,6 +19,7 @@
 
 #include "caffe2/core/logging.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/operators/packed_strings.h"
 
 namespace caffe2 {
 
@@ -63,9 +64,13 @@ class IndexHashOp : public Operator<Context> {
  protected:
   template <typename T>
   T hash(T id) {
-    int8_t* bytes = (int8_t*)&id;
+    return hashBytes<T>((int8_t*)&id, sizeof(T) / sizeof(int8_t));
+  }
+
+  template <typename T>
+  T hashBytes(const int8_t* bytes, size_t size) {
     T hashed = seed_ * 0xDEADBEEF;
-    for (int i = 0; i < sizeof(T) / sizeof(int8_t); i++) {
+    for (size_t i = 0; i < size; i++) {
       hashed = hashed * 65537 + bytes[i];
     }
     hashed = static_cast<T>((modulo_ + hashed % modulo_) % modulo_);
@@ -80,6 +85,32 @@ class IndexHashOp : public Operator<Context> {
   int64_t modulo_;
 };
 
+// IndexHash of packed strings (see StringPack), hashing the bytes of each
+// string into an int64 index.
+class PackedStringIndexHashOp final : public IndexHashOp<CPUContext> {
+ public:
+  PackedStringIndexHashOp(const OperatorDef& operator_def, Workspace* ws)
+      : IndexHashOp<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    const auto& data = Input(0);
+    const auto& lengths = Input(1);
+    PackedStringOffsets(data, lengths, &offsets_);
+    auto* hashed_indices = Output(0);
+    hashed_indices->ResizeLike(lengths);
+    const auto* bytes = reinterpret_cast<const int8_t*>(data.data<uint8_t>());
+    auto* hashed_indices_data = hashed_indices->mutable_data<int64_t>();
+    for (TIndex i = 0; i < lengths.size(); i++) {
+      hashed_indices_data[i] = hashBytes<int64_t>(
+          bytes + offsets_[i], offsets_[i + 1] - offsets_[i]);
+    }
+    return true;
+  }
+
+ private:
+  std::vector<int64_t> offsets_;
+};
+
 } // namespace caffe2
 
 #endif // CAFFE2_OPERATORS_INDEX_HASH_OPS_H_
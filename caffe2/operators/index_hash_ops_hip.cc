@@ -0,0 +1,78 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <type_traits>
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/index_hash_ops.h"
+
+namespace caffe2 {
+
+namespace {
+// Same hash as IndexHashOp::hash on the CPU. The multiply-add chain is done on
+// the unsigned type so that its wrap-around is well defined on the device.
+template <typename T>
+__global__ void IndexHashKernel(
+    const int N, const int64_t seed, const int64_t modulo, const T* indices, T* hashed_indices)
+{
+    using U = typename std::make_unsigned<T>::type;
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        const U id = static_cast<U>(indices[i]);
+        U hashed   = static_cast<U>(static_cast<uint64_t>(seed) * 0xDEADBEEFULL);
+        for(int b = 0; b < sizeof(T); b++)
+        {
+            const int8_t byte = static_cast<int8_t>(id >> (8 * b));
+            hashed            = hashed * 65537 + static_cast<U>(static_cast<T>(byte));
+        }
+        const int64_t r   = static_cast<int64_t>(static_cast<T>(hashed)) % modulo;
+        hashed_indices[i] = static_cast<T>((modulo + r) % modulo);
+    }
+}
+} // namespace
+
+template <>
+template <typename T>
+bool IndexHashOp<HIPContext>::DoRunWithType()
+{
+    auto& indices        = Input(INDICES);
+    auto* hashed_indices = Output(HASHED_INDICES);
+    hashed_indices->ResizeLike(indices);
+
+    CAFFE_ENFORCE_GE(static_cast<int64_t>(std::numeric_limits<T>::max()),
+                     modulo_,
+                     "MODULO shouldn't be larger than the numeric limit of the indices");
+
+    const int N = indices.size();
+    if(N == 0)
+    {
+        hashed_indices->template mutable_data<T>();
+        return true;
+    }
+    hipLaunchKernelGGL((IndexHashKernel<T>),
+                       dim3(CAFFE_GET_BLOCKS(N)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       N,
+                       seed_,
+                       modulo_,
+                       indices.template data<T>(),
+                       hashed_indices->template mutable_data<T>());
+    return true;
+}
+
+REGISTER_HIP_OPERATOR(IndexHash, IndexHashOp<HIPContext>);
+} // namespace caffe2
@@ -14,15 +14,19 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <atomic>
 #include <limits>
+#include <memory>
 #include <mutex>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 #include "caffe2/core/blob_serialization.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/core/tensor.h"
+#include "caffe2/operators/packed_strings.h"
 
 namespace caffe2 {
 namespace {
@@ -52,44 +56,329 @@ struct IndexBase {
   const TypeMeta& Type() const { return meta_; }
 
   TIndexValue Size() {
-    std::lock_guard<std::mutex> guard(dictMutex_);
     return nextId_;
   }
 
  protected:
   int64_t maxElements_;
   TypeMeta meta_;
-  TIndexValue nextId_{1}; // guarded by dictMutex_
+  std::atomic<TIndexValue> nextId_{1};
   std::atomic<bool> frozen_{false};
   std::mutex dictMutex_;
 };
 
-template<typename T>
-struct Index: IndexBase {
+/**
+ * Index of integer keys, backed by an open-addressing hash table with linear
+ * probing so that concurrent IndexGet calls don't serialize on a mutex.
+ *
+ * Every slot goes through the states kEmpty -> kClaimed (the inserting thread
+ * owns it) -> kPending (key published, id not yet assigned) -> id > 0, or
+ * kFull when max_elements was reached. Lookups and inserts only use atomics
+ * on the slots. Growing the table (and Load / Store) waits for the in-flight
+ * Get calls to drain and runs exclusively.
+ */
+template <typename T>
+struct Index : IndexBase {
   explicit Index(TIndexValue maxElements)
-    : IndexBase(maxElements, TypeMeta::Make<T>()) {}
+      : IndexBase(maxElements, TypeMeta::Make<T>()),
+        table_(new Table(InitialCapacity(maxElements))) {}
+
+  ~Index() {
+    delete table_.load();
+  }
 
   void Get(const T* keys, TIndexValue* values, size_t numKeys) {
-    if (frozen_) {
-      FrozenGet(keys, values, numKeys);
-      return;
-    }
-    std::lock_guard<std::mutex> lock(dictMutex_);
+    const bool insert = !frozen_;
+    Enter();
     for (int i = 0; i < numKeys; ++i) {
-      auto it = dict_.find(keys[i]);
-      if (it != dict_.end()) {
-        values[i] = it->second;
-      } else if (nextId_ < maxElements_) {
-        auto newValue = nextId_++;
-        dict_.insert({keys[i], newValue});
-        values[i] = newValue;
-      } else {
-        CAFFE_THROW("Dict max size reached");
+      for (;;) {
+        Table* table = table_;
+        bool full = false;
+        auto value = Find(table, keys[i], insert, &full);
+        if (value >= 0) {
+          values[i] = value;
+          break;
+        }
+        Exit();
+        if (full) {
+          CAFFE_THROW("Dict max size reached");
+        }
+        Grow(table);
+        Enter();
       }
     }
+    Exit();
   }
 
   bool Load(const T* keys, size_t numKeys) {
+    CAFFE_ENFORCE(
+        numKeys <= maxElements_,
+        "Cannot load index: Tensor is larger than max_elements.");
+    std::unique_ptr<Table> table(new Table(
+        std::max(InitialCapacity(maxElements_), CapacityFor(numKeys))));
+    for (int i = 0; i < numKeys; ++i) {
+      CAFFE_ENFORCE(
+          table->Insert(keys[i], i + 1),
+          "Repeated elements found: cannot load into dictionary.");
+    }
+    // assume no `get` is inflight while this happens
+    std::lock_guard<std::mutex> lock(dictMutex_);
+    BeginExclusive();
+    // let the old table get destructed outside of the exclusive section
+    table.reset(table_.exchange(table.release()));
+    used_ = numKeys;
+    nextId_ = numKeys + 1;
+    EndExclusive();
+    return true;
+  }
+
+  template<typename Ctx>
+  bool Store(Tensor<Ctx>* out) {
+    std::lock_guard<std::mutex> lock(dictMutex_);
+    BeginExclusive();
+    Table* table = table_;
+    out->Resize(nextId_ - 1);
+    auto outData = out->template mutable_data<T>();
+    for (size_t i = 0; i < table->capacity; ++i) {
+      auto value = table->slots[i].value.load(std::memory_order_relaxed);
+      if (value > 0) {
+        outData[value - 1] = table->slots[i].key.load(std::memory_order_relaxed);
+      }
+    }
+    EndExclusive();
+    return true;
+  }
+
+ private:
+  static constexpr TIndexValue kEmpty = 0;
+  static constexpr TIndexValue kClaimed = -1;
+  static constexpr TIndexValue kPending = -2;
+  static constexpr TIndexValue kFull = -3;
+  static constexpr size_t kMinCapacity = 16;
+  static constexpr size_t kMaxInitialCapacity = 1 << 12;
+
+  struct Slot {
+    std::atomic<T> key;
+    std::atomic<TIndexValue> value;
+  };
+
+  struct Table {
+    explicit Table(size_t cap) : capacity(cap), slots(new Slot[cap]) {
+      for (size_t i = 0; i < capacity; ++i) {
+        slots[i].key.store(T(), std::memory_order_relaxed);
+        slots[i].value.store(kEmpty, std::memory_order_relaxed);
+      }
+    }
+
+    // Single-threaded insert used while building a table
+    bool Insert(T key, TIndexValue value) {
+      for (size_t pos = Hash(key) & (capacity - 1);;
+           pos = (pos + 1) & (capacity - 1)) {
+        auto& slot = slots[pos];
+        if (slot.value.load(std::memory_order_relaxed) == kEmpty) {
+          slot.key.store(key, std::memory_order_relaxed);
+          slot.value.store(value, std::memory_order_relaxed);
+          return true;
+        }
+        if (slot.key.load(std::memory_order_relaxed) == key) {
+          return false;
+        }
+      }
+    }
+
+    const size_t capacity;
+    std::unique_ptr<Slot[]> slots;
+  };
+
+  // The table is kept at most half full
+  static size_t CapacityFor(size_t numKeys) {
+    size_t capacity = kMinCapacity;
+    while (capacity < 2 * numKeys) {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+  static size_t InitialCapacity(TIndexValue maxElements) {
+    return CapacityFor(std::min<TIndexValue>(
+        std::max<TIndexValue>(maxElements, 0), kMaxInitialCapacity / 2));
+  }
+
+  // finalizer of MurmurHash3, spreads consecutive ids over the table
+  static size_t Hash(T key) {
+    uint64_t h = static_cast<uint64_t>(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return static_cast<size_t>(h);
+  }
+
+  // Returns the id of key, 0 if it is missing and insert is false, or -1 if
+  // the table has to grow (or, with *full set, max_elements was reached).
+  TIndexValue Find(Table* table, T key, bool insert, bool* full) {
+    const size_t mask = table->capacity - 1;
+    size_t pos = Hash(key) & mask;
+    for (;;) {
+      auto& slot = table->slots[pos];
+      auto value = slot.value.load(std::memory_order_acquire);
+      if (value == kEmpty) {
+        if (!insert) {
+          return 0;
+        }
+        // reserve room first so that the table never fills up
+        if (2 * (used_.fetch_add(1) + 1) > table->capacity) {
+          --used_;
+          return -1;
+        }
+        if (!slot.value.compare_exchange_strong(value, kClaimed)) {
+          // somebody else took the slot, look at it again
+          --used_;
+          continue;
+        }
+        slot.key.store(key, std::memory_order_relaxed);
+        slot.value.store(kPending, std::memory_order_release);
+        auto id = ReserveId();
+        slot.value.store(id > 0 ? id : kFull, std::memory_order_release);
+        if (id == 0) {
+          *full = true;
+          return -1;
+        }
+        return id;
+      }
+      while (value == kClaimed) {
+        std::this_thread::yield();
+        value = slot.value.load(std::memory_order_acquire);
+      }
+      if (slot.key.load(std::memory_order_relaxed) == key) {
+        while (value == kPending) {
+          std::this_thread::yield();
+          value = slot.value.load(std::memory_order_acquire);
+        }
+        if (value == kFull) {
+          *full = insert;
+          return insert ? -1 : 0;
+        }
+        return value;
+      }
+      pos = (pos + 1) & mask;
+    }
+  }
+
+  // Next consecutive id, or 0 once max_elements is reached
+  TIndexValue ReserveId() {
+    auto id = nextId_.load();
+    do {
+      if (id >= maxElements_) {
+        return 0;
+      }
+    } while (!nextId_.compare_exchange_weak(id, id + 1));
+    return id;
+  }
+
+  void Grow(Table* seen) {
+    std::lock_guard<std::mutex> lock(dictMutex_);
+    if (table_ != seen) {
+      // another thread grew it already
+      return;
+    }
+    BeginExclusive();
+    std::unique_ptr<Table> table(new Table(2 * seen->capacity));
+    for (size_t i = 0; i < seen->capacity; ++i) {
+      auto value = seen->slots[i].value.load(std::memory_order_relaxed);
+      if (value != kEmpty) {
+        table->Insert(
+            seen->slots[i].key.load(std::memory_order_relaxed), value);
+      }
+    }
+    table.reset(table_.exchange(table.release()));
+    EndExclusive();
+  }
+
+  // Get calls run concurrently between Enter() and Exit(); exclusive
+  // sections wait for them to drain and block new ones.
+  void Enter() {
+    for (;;) {
+      while (exclusive_) {
+        std::this_thread::yield();
+      }
+      ++inflight_;
+      if (!exclusive_) {
+        return;
+      }
+      --inflight_;
+    }
+  }
+
+  void Exit() {
+    --inflight_;
+  }
+
+  // dictMutex_ must be held
+  void BeginExclusive() {
+    exclusive_ = true;
+    while (inflight_ != 0) {
+      std::this_thread::yield();
+    }
+  }
+
+  void EndExclusive() {
+    exclusive_ = false;
+  }
+
+  std::atomic<Table*> table_;
+  std::atomic<size_t> used_{0};
+  std::atomic<int> inflight_{0};
+  std::atomic<bool> exclusive_{false};
+};
+
+template <typename T>
+constexpr TIndexValue Index<T>::kEmpty;
+template <typename T>
+constexpr TIndexValue Index<T>::kClaimed;
+template <typename T>
+constexpr TIndexValue Index<T>::kPending;
+template <typename T>
+constexpr TIndexValue Index<T>::kFull;
+template <typename T>
+constexpr size_t Index<T>::kMinCapacity;
+template <typename T>
+constexpr size_t Index<T>::kMaxInitialCapacity;
+
+// String keys stay in a mutex-protected map
+template <>
+struct Index<std::string> : IndexBase {
+  explicit Index(TIndexValue maxElements)
+    : IndexBase(maxElements, TypeMeta::Make<std::string>()) {}
+
+  void Get(const std::string* keys, TIndexValue* values, size_t numKeys) {
+    DoGet(
+        [keys](size_t i) -> const std::string& { return keys[i]; },
+        values,
+        numKeys);
+  }
+
+  // Get of packed strings (see StringPack). The keys are looked up through
+  // one reused std::string, only the inserted keys are allocated.
+  void Get(
+      const uint8_t* data,
+      const int64_t* offsets,
+      TIndexValue* values,
+      size_t numKeys) {
+    std::string key;
+    DoGet(
+        [&](size_t i) -> const std::string& {
+          key.assign(
+              reinterpret_cast<const char*>(data) + offsets[i],
+              offsets[i + 1] - offsets[i]);
+          return key;
+        },
+        values,
+        numKeys);
+  }
+
+  bool Load(const std::string* keys, size_t numKeys) {
     CAFFE_ENFORCE(
         numKeys <= maxElements_,
         "Cannot load index: Tensor is larger than max_elements.");
@@ -113,7 +402,7 @@ struct Index: IndexBase {
   bool Store(Tensor<Ctx>* out) {
     std::lock_guard<std::mutex> lock(dictMutex_);
     out->Resize(nextId_ - 1);
-    auto outData = out->template mutable_data<T>();
+    auto outData = out->template mutable_data<std::string>();
     for (const auto& entry : dict_) {
       outData[entry.second - 1] = entry.first;
     }
@@ -121,14 +410,37 @@ struct Index: IndexBase {
   }
 
  private:
-  void FrozenGet(const T* keys, TIndexValue* values, size_t numKeys) {
+  template <typename KeyAt>
+  void DoGet(KeyAt keyAt, TIndexValue* values, size_t numKeys) {
+    if (frozen_) {
+      FrozenGet(keyAt, values, numKeys);
+      return;
+    }
+    std::lock_guard<std::mutex> lock(dictMutex_);
+    for (int i = 0; i < numKeys; ++i) {
+      const auto& key = keyAt(i);
+      auto it = dict_.find(key);
+      if (it != dict_.end()) {
+        values[i] = it->second;
+      } else if (nextId_ < maxElements_) {
+        auto newValue = nextId_++;
+        dict_.insert({key, newValue});
+        values[i] = newValue;
+      } else {
+        CAFFE_THROW("Dict max size reached");
+      }
+    }
+  }
+
+  template <typename KeyAt>
+  void FrozenGet(KeyAt keyAt, TIndexValue* values, size_t numKeys) {
     for (int i = 0; i < numKeys; ++i) {
-      auto it = dict_.find(keys[i]);
+      auto it = dict_.find(keyAt(i));
       values[i] = it != dict_.end() ? it->second : 0;
     }
   }
 
-  std::unordered_map<T, TIndexValue> dict_;
+  std::unordered_map<std::string, TIndexValue> dict_;
 };
 
 // TODO(azzolini): support sizes larger than int32
@@ -157,6 +469,9 @@ class IndexGetOp: public Operator<CPUContext> {
    : Operator(operator_def, ws) {}
 
   bool RunOnDevice() override {
+    if (InputSize() == 3) {
+      return RunOnPackedStrings();
+    }
     return DispatchHelper<IndexKeyTypes>::call(this, Input(1));
   }
   template <typename T>
@@ -170,6 +485,26 @@ class IndexGetOp: public Operator<CPUContext> {
     dict->Get(keys.data<T>(), values->mutable_data<TIndexValue>(), keys.size());
     return true;
   }
+
+ private:
+  bool RunOnPackedStrings() {
+    auto& base = OperatorBase::Input<std::unique_ptr<IndexBase>>(0);
+    auto* dict = dynamic_cast_if_rtti<Index<std::string>*>(base.get());
+    CAFFE_ENFORCE(dict, "Packed string keys need a string index.");
+    const auto& data = Input(1);
+    const auto& lengths = Input(2);
+    PackedStringOffsets(data, lengths, &offsets_);
+    auto* values = Output(0);
+    values->ResizeLike(lengths);
+    dict->Get(
+        data.data<uint8_t>(),
+        offsets_.data(),
+        values->mutable_data<TIndexValue>(),
+        lengths.size());
+    return true;
+  }
+
+  std::vector<int64_t> offsets_;
 };
 
 class IndexLoadOp: public Operator<CPUContext> {
@@ -288,16 +623,20 @@ from 1 to max_elements. Zero is reserved for unknown keys.
   .Output(0, "handle", "Pointer to an Index instance.");
 
 OPERATOR_SCHEMA(IndexGet)
-  .NumInputs(2)
+  .NumInputs(2, 3)
   .NumOutputs(1)
   .SetDoc(R"DOC(
 Given an index handle and a tensor of keys, return an Int tensor of same shape
 containing the indices for each of the keys. If the index is frozen, unknown
 entries are given index 0. Otherwise, new entries are added into the index.
 If an insert is necessary but max_elements has been reached, fail.
+The keys of a string index can also be given as packed strings, the data and
+lengths outputs of StringPack, in which case the indices have the shape of
+lengths.
 )DOC")
   .Input(0, "handle", "Pointer to an Index instance.")
-  .Input(1, "keys", "Tensor of keys to be looked up.")
+  .Input(1, "keys", "Tensor of keys to be looked up, or packed strings data.")
+  .Input(2, "lengths", "(optional) Lengths of the packed string keys.")
   .Output(0, "indices", "Indices for each of the keys.");
 
 OPERATOR_SCHEMA(IndexFreeze)
@@ -123,6 +123,7 @@ OPERATOR_SCHEMA(InstanceNorm)
     .NumInputs(3)
     .NumOutputs(1, 3)
     .AllowInplace({{0,0}})
+    .CostInferenceFunction(PointwiseCostInference<5>)
     .SetDoc(R"DOC(
 Carries out instance normalization as described in the paper
 https://arxiv.org/abs/1607.08022. Depending on the mode it is being run,
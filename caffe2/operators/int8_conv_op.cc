@@ -0,0 +1,49 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/int8_conv_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8Conv, Int8ConvOp);
+
+OPERATOR_SCHEMA(Int8Conv)
+    .NumInputs(2, 3)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Quantized version of Conv for 2D NHWC inputs and no groups. X and Y are uint8,
+the filter (M x kernel_h x kernel_w x C) is int8 and the optional bias is
+float. Takes the same kernel, stride, pad and dilation arguments as Conv, and
+the same quantization arguments as Int8FC.
+)DOC")
+    .Arg("X_scale", "Scale of X. Defaults to 1")
+    .Arg("X_zero_point", "Zero point of X, also used as the padding value. "
+         "Defaults to 0")
+    .Arg("W_scale", "Scale of the filter, either a single value or a list "
+         "with one value per output channel. Defaults to 1")
+    .Arg("W_zero_point", "Zero point of the filter, either a single value or "
+         "a list with one value per output channel. Defaults to 0")
+    .Arg("Y_scale", "Scale of Y. Defaults to 1")
+    .Arg("Y_zero_point", "Zero point of Y. Defaults to 0")
+    .Arg("relu", "If 1, a Relu is fused into the output. Defaults to 0")
+    .Input(0, "X", "uint8 NHWC input")
+    .Input(1, "filter", "int8 filter of shape (M, kernel_h, kernel_w, C)")
+    .Input(2, "bias", "Optional float bias, in the real (not quantized) domain")
+    .Output(0, "Y", "uint8 NHWC output");
+
+NO_GRADIENT(Int8Conv);
+
+} // namespace caffe2
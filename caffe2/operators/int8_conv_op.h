@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_OPERATORS_INT8_CONV_OP_H_
+#define CAFFE2_OPERATORS_INT8_CONV_OP_H_
+
+#include <cstring>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+#include "caffe2/operators/int8_utils.h"
+
+namespace caffe2 {
+
+// Quantized 2D convolution in NHWC order, with uint8 X and Y, int8 filters of
+// shape (M, kernel_h, kernel_w, C) and a float bias. The input is unrolled with
+// an im2col that pads with the zero point of X, and multiplied with the filters
+// by the same int8 GEMM as Int8FC.
+class Int8ConvOp final : public ConvPoolOpBase<CPUContext> {
+ public:
+  USE_CONV_POOL_BASE_FUNCTIONS(CPUContext);
+  Int8ConvOp(const OperatorDef& operator_def, Workspace* ws)
+      : ConvPoolOpBase<CPUContext>(operator_def, ws),
+        relu_(OperatorBase::GetSingleArgument<bool>("relu", false)),
+        X_params_(int8::GetQuantParams(*this, "X")),
+        Y_params_(int8::GetQuantParams(*this, "Y")) {
+    OPERATOR_NEEDS_FEATURE(
+        order_ == StorageOrder::NHWC, "Int8Conv only supports NHWC order");
+    OPERATOR_NEEDS_FEATURE(group_ == 1, "Int8Conv does not support groups");
+    CAFFE_ENFORCE_EQ(kernel_.size(), 2, "Int8Conv only supports 2D kernels");
+  }
+
+  bool RunOnDeviceWithOrderNHWC() override {
+    const auto& X = Input(0);
+    const auto& filter = Input(1);
+    auto* Y = Output(0);
+    CAFFE_ENFORCE(X.IsType<std::uint8_t>(), "X must be uint8");
+    CAFFE_ENFORCE(filter.IsType<std::int8_t>(), "filter must be int8");
+    CAFFE_ENFORCE_EQ(X.ndim(), 4);
+    CAFFE_ENFORCE_EQ(filter.ndim(), 4);
+    const int N = X.dim32(0);
+    const int H = X.dim32(1);
+    const int W = X.dim32(2);
+    const int C = X.dim32(3);
+    const int M = filter.dim32(0);
+    CAFFE_ENFORCE_EQ(filter.dim32(1), kernel_h());
+    CAFFE_ENFORCE_EQ(filter.dim32(2), kernel_w());
+    CAFFE_ENFORCE_EQ(filter.dim32(3), C);
+    const float* bias = nullptr;
+    if (InputSize() == 3) {
+      const auto& b = Input(2);
+      CAFFE_ENFORCE_EQ(b.size(), M);
+      bias = b.data<float>();
+    }
+    if (W_params_.scales.size() != M) {
+      W_params_ = int8::GetWeightQuantParams(*this, M);
+    }
+
+    ConvPoolOpBase<CPUContext>::SetOutputSize(X, Y, M);
+    const int OH = Y->dim32(1);
+    const int OW = Y->dim32(2);
+    const int K = kernel_h() * kernel_w() * C;
+    const std::uint8_t* col = X.data<std::uint8_t>();
+    const bool is_1x1 = kernel_h() == 1 && kernel_w() == 1 && stride_h() == 1 &&
+        stride_w() == 1 && pad_t() == 0 && pad_l() == 0 && pad_b() == 0 &&
+        pad_r() == 0;
+    if (!is_1x1) {
+      col_buffer_.Resize(N * OH * OW, K);
+      Im2ColNHWC(
+          N, H, W, C, OH, OW, col, col_buffer_.mutable_data<std::uint8_t>());
+      col = col_buffer_.data<std::uint8_t>();
+    }
+    int8::Int8GemmRequantize(
+        N * OH * OW,
+        M,
+        K,
+        col,
+        X_params_,
+        filter.data<std::int8_t>(),
+        W_params_,
+        bias,
+        Y_params_,
+        relu_,
+        &acc_buffer_,
+        Y->mutable_data<std::uint8_t>());
+    return true;
+  }
+
+ private:
+  // Unrolls the kernel_h x kernel_w x C patches of X into the rows of col,
+  // filling the padding with the zero point of X (i.e. a real zero).
+  void Im2ColNHWC(
+      int N,
+      int H,
+      int W,
+      int C,
+      int OH,
+      int OW,
+      const std::uint8_t* X,
+      std::uint8_t* col) {
+    for (int n = 0; n < N; ++n) {
+      for (int oh = 0; oh < OH; ++oh) {
+        for (int ow = 0; ow < OW; ++ow) {
+          for (int kh = 0; kh < kernel_h(); ++kh) {
+            const int ih = oh * stride_h() - pad_t() + kh * dilation_h();
+            for (int kw = 0; kw < kernel_w(); ++kw) {
+              const int iw = ow * stride_w() - pad_l() + kw * dilation_w();
+              if (ih >= 0 && ih < H && iw >= 0 && iw < W) {
+                std::memcpy(col, X + ((n * H + ih) * W + iw) * C, C);
+              } else {
+                std::memset(col, X_params_.zero_point, C);
+              }
+              col += C;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  bool relu_;
+  int8::QuantParams X_params_;
+  int8::QuantParams Y_params_;
+  int8::WeightQuantParams W_params_;
+  TensorCPU col_buffer_;
+  TensorCPU acc_buffer_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_CONV_OP_H_
@@ -0,0 +1,51 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/int8_fc_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8FC, Int8FCOp);
+
+OPERATOR_SCHEMA(Int8FC)
+    .NumInputs(2, 3)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Quantized version of FC: computes Y = X * W^T + b, where X (M x K) and Y
+(M x N) are uint8, W (N x K) is int8 and the optional bias b (N) is float.
+Products are accumulated in int32 (with AVX2 or AVX512 VNNI kernels when the
+CPU has them), corrected for the zero points and requantized to the
+parameters of Y.
+)DOC")
+    .Arg("axis", "Same as in FC. Defaults to 1")
+    .Arg("axis_w", "Same as in FC. Defaults to 1")
+    .Arg("X_scale", "Scale of X. Defaults to 1")
+    .Arg("X_zero_point", "Zero point of X. Defaults to 0")
+    .Arg("W_scale", "Scale of W, either a single value or a list with one "
+         "value per output channel. Defaults to 1")
+    .Arg("W_zero_point", "Zero point of W, either a single value or a list "
+         "with one value per output channel. Defaults to 0")
+    .Arg("Y_scale", "Scale of Y. Defaults to 1")
+    .Arg("Y_zero_point", "Zero point of Y. Defaults to 0")
+    .Arg("relu", "If 1, a Relu is fused into the output. Defaults to 0")
+    .Input(0, "X", "uint8 input")
+    .Input(1, "W", "int8 weights")
+    .Input(2, "b", "Optional float bias, in the real (not quantized) domain")
+    .Output(0, "Y", "uint8 output");
+
+NO_GRADIENT(Int8FC);
+
+} // namespace caffe2
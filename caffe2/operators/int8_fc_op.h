@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_OPERATORS_INT8_FC_OP_H_
+#define CAFFE2_OPERATORS_INT8_FC_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/operators/int8_utils.h"
+
+namespace caffe2 {
+
+// Quantized counterpart of FullyConnectedOp: Y = X * W^T + b with uint8 X and
+// Y, int8 W and float b.
+class Int8FCOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  Int8FCOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        axis_(OperatorBase::GetSingleArgument<int32_t>("axis", 1)),
+        axis_w_(OperatorBase::GetSingleArgument<int32_t>("axis_w", 1)),
+        relu_(OperatorBase::GetSingleArgument<bool>("relu", false)),
+        X_params_(int8::GetQuantParams(*this, "X")),
+        Y_params_(int8::GetQuantParams(*this, "Y")) {}
+
+  bool RunOnDevice() override {
+    const auto& X = Input(0);
+    const auto& W = Input(1);
+    auto* Y = Output(0);
+    CAFFE_ENFORCE(X.IsType<std::uint8_t>(), "X must be uint8");
+    CAFFE_ENFORCE(W.IsType<std::int8_t>(), "W must be int8");
+    const auto canonical_axis = X.canonical_axis_index(axis_);
+    const int M = X.size_to_dim(canonical_axis);
+    const int K = X.size_from_dim(canonical_axis);
+    const int N = W.size_to_dim(W.canonical_axis_index(axis_w_));
+    CAFFE_ENFORCE_EQ(K, W.size() / N, "Dimension mismatch between X and W");
+    const float* bias = nullptr;
+    if (InputSize() == 3) {
+      const auto& b = Input(2);
+      CAFFE_ENFORCE_EQ(b.size(), N);
+      bias = b.data<float>();
+    }
+    if (W_params_.scales.size() != N) {
+      W_params_ = int8::GetWeightQuantParams(*this, N);
+    }
+
+    auto Y_shape = X.dims();
+    Y_shape.resize(canonical_axis + 1);
+    Y_shape[canonical_axis] = N;
+    Y->Resize(Y_shape);
+    if (M == 0) {
+      Y->mutable_data<std::uint8_t>();
+      return true;
+    }
+    int8::Int8GemmRequantize(
+        M,
+        N,
+        K,
+        X.data<std::uint8_t>(),
+        X_params_,
+        W.data<std::int8_t>(),
+        W_params_,
+        bias,
+        Y_params_,
+        relu_,
+        &acc_buffer_,
+        Y->mutable_data<std::uint8_t>());
+    return true;
+  }
+
+ protected:
+  size_t axis_;
+  size_t axis_w_;
+  bool relu_;
+  int8::QuantParams X_params_;
+  int8::QuantParams Y_params_;
+  int8::WeightQuantParams W_params_;
+  TensorCPU acc_buffer_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_FC_OP_H_
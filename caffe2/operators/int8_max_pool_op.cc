@@ -0,0 +1,37 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/int8_max_pool_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8MaxPool, Int8MaxPoolOp);
+
+OPERATOR_SCHEMA(Int8MaxPool)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Quantized version of MaxPool for 2D uint8 inputs, in NCHW or NHWC order. It
+takes the same kernel, stride and pad arguments as MaxPool. As quantization is
+monotonic, the output has the same scale and zero point as the input, so no
+quantization arguments are needed.
+)DOC")
+    .Input(0, "X", "uint8 input")
+    .Output(0, "Y", "uint8 output");
+
+NO_GRADIENT(Int8MaxPool);
+
+} // namespace caffe2
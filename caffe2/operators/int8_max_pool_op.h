@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_OPERATORS_INT8_MAX_POOL_OP_H_
+#define CAFFE2_OPERATORS_INT8_MAX_POOL_OP_H_
+
+#include <algorithm>
+#include <cstring>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+
+namespace caffe2 {
+
+// Max pooling of uint8 tensors. Since quantization is monotonic, the max of
+// the quantized values is the quantized max and Y keeps the parameters of X.
+class Int8MaxPoolOp final : public ConvPoolOpBase<CPUContext> {
+ public:
+  USE_CONV_POOL_BASE_FUNCTIONS(CPUContext);
+  Int8MaxPoolOp(const OperatorDef& operator_def, Workspace* ws)
+      : ConvPoolOpBase<CPUContext>(operator_def, ws) {
+    CAFFE_ENFORCE_EQ(kernel_.size(), 2, "Int8MaxPool only supports 2D pooling");
+    for (int i = 0; i < kernel_.size(); ++i) {
+      CAFFE_ENFORCE_EQ(
+          dilation_[i], 1, "Pooling op does not support dilation right now.");
+    }
+    if (!global_pooling_) {
+      for (int i = 0; i < kernel_.size(); ++i) {
+        CAFFE_ENFORCE(
+            pads_[i] < kernel_[i] && pads_[i + kernel_.size()] < kernel_[i],
+            "Pad should be smaller than kernel.");
+      }
+    }
+  }
+
+  bool RunOnDeviceWithOrderNHWC() override {
+    const auto& X = Input(0);
+    auto* Y = Output(0);
+    CAFFE_ENFORCE(X.IsType<std::uint8_t>(), "X must be uint8");
+    const int N = X.dim32(0);
+    const int H = X.dim32(1);
+    const int W = X.dim32(2);
+    const int C = X.dim32(3);
+    ConvPoolOpBase<CPUContext>::SetOutputSize(X, Y, C);
+    const int PH = Y->dim32(1);
+    const int PW = Y->dim32(2);
+    const std::uint8_t* Xdata = X.data<std::uint8_t>();
+    std::uint8_t* Ydata = Y->mutable_data<std::uint8_t>();
+    for (int n = 0; n < N; ++n) {
+      for (int ph = 0; ph < PH; ++ph) {
+        const int hstart = std::max(ph * stride_h() - pad_t(), 0);
+        const int hend = std::min(ph * stride_h() - pad_t() + kernel_h(), H);
+        for (int pw = 0; pw < PW; ++pw) {
+          const int wstart = std::max(pw * stride_w() - pad_l(), 0);
+          const int wend = std::min(pw * stride_w() - pad_l() + kernel_w(), W);
+          std::uint8_t* y = Ydata + ((n * PH + ph) * PW + pw) * C;
+          std::memset(y, 0, C);
+          // Channels are innermost so that the max vectorizes.
+          for (int h = hstart; h < hend; ++h) {
+            for (int w = wstart; w < wend; ++w) {
+              const std::uint8_t* x = Xdata + ((n * H + h) * W + w) * C;
+              for (int c = 0; c < C; ++c) {
+                y[c] = std::max(y[c], x[c]);
+              }
+            }
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  bool RunOnDeviceWithOrderNCHW() override {
+    const auto& X = Input(0);
+    auto* Y = Output(0);
+    CAFFE_ENFORCE(X.IsType<std::uint8_t>(), "X must be uint8");
+    const int N = X.dim32(0);
+    const int C = X.dim32(1);
+    const int H = X.dim32(2);
+    const int W = X.dim32(3);
+    ConvPoolOpBase<CPUContext>::SetOutputSize(X, Y, C);
+    const int PH = Y->dim32(2);
+    const int PW = Y->dim32(3);
+    const std::uint8_t* Xdata = X.data<std::uint8_t>();
+    std::uint8_t* Ydata = Y->mutable_data<std::uint8_t>();
+    for (int nc = 0; nc < N * C; ++nc) {
+      const std::uint8_t* x = Xdata + nc * H * W;
+      std::uint8_t* y = Ydata + nc * PH * PW;
+      for (int ph = 0; ph < PH; ++ph) {
+        const int hstart = std::max(ph * stride_h() - pad_t(), 0);
+        const int hend = std::min(ph * stride_h() - pad_t() + kernel_h(), H);
+        for (int pw = 0; pw < PW; ++pw) {
+          const int wstart = std::max(pw * stride_w() - pad_l(), 0);
+          const int wend = std::min(pw * stride_w() - pad_l() + kernel_w(), W);
+          std::uint8_t v = 0;
+          for (int h = hstart; h < hend; ++h) {
+            for (int w = wstart; w < wend; ++w) {
+              v = std::max(v, x[h * W + w]);
+            }
+          }
+          y[ph * PW + pw] = v;
+        }
+      }
+    }
+    return true;
+  }
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_MAX_POOL_OP_H_
@@ -0,0 +1,742 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <hipcub/hipcub.hpp>
+#include "hip/hip_runtime.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+#include "caffe2/operators/int8_utils.h"
+
+namespace caffe2 {
+
+// HIP implementations of the Int8* operators, with the same arguments and
+// numerics as the CPU ones (see int8_utils.h), so that a quantized net can be
+// moved between CPU and ROCm by changing its device option only.
+//
+// rocBLAS only has a signed int8 GEMM, so the uint8 activations are shifted by
+// -128 on the way into the GEMM (with their zero point shifted to match), and
+// the depth is zero padded to a multiple of 4 as rocBLAS' int8 kernels require.
+// Convolutions use an im2col into that layout followed by the same GEMM rather
+// than MIOpen, whose int8 convolutions need vectorized NCHW_VECT_C tensors.
+
+namespace {
+
+constexpr int kInt8Shift = 128;
+
+inline int RoundUpDepth(int K)
+{
+    return (K + 3) / 4 * 4;
+}
+
+__global__ void
+Int8QuantizeKernel(const int N, const float scale, const int zero_point, const float* X, uint8_t* Y)
+{
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        const float q = rintf(X[i] / scale) + zero_point;
+        Y[i]          = static_cast<uint8_t>(fminf(fmaxf(q, 0.0f), 255.0f));
+    }
+}
+
+template <typename T>
+__global__ void
+Int8DequantizeKernel(const int N, const float scale, const int zero_point, const T* X, float* Y)
+{
+    HIP_1D_KERNEL_LOOP(i, N) { Y[i] = scale * (static_cast<int>(X[i]) - zero_point); }
+}
+
+__global__ void Int8ReluKernel(const int N, const uint8_t zero, const uint8_t* X, uint8_t* Y)
+{
+    HIP_1D_KERNEL_LOOP(i, N) { Y[i] = X[i] > zero ? X[i] : zero; }
+}
+
+__global__ void Int8ReluRequantizeKernel(const int N,
+                                         const float X_scale,
+                                         const int X_zero_point,
+                                         const float Y_scale,
+                                         const int Y_zero_point,
+                                         const uint8_t* X,
+                                         uint8_t* Y)
+{
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        const float real = fmaxf(X_scale * (static_cast<int>(X[i]) - X_zero_point), 0.0f);
+        const float q    = rintf(real / Y_scale) + Y_zero_point;
+        Y[i]             = static_cast<uint8_t>(fminf(fmaxf(q, 0.0f), 255.0f));
+    }
+}
+
+// Copies the uint8 rows of X (M x K) into int8 rows of ldk bytes, shifted by
+// -128, with zeros in the padding.
+__global__ void
+Int8ShiftKernel(const int M, const int K, const int ldk, const uint8_t* X, int8_t* Y)
+{
+    HIP_1D_KERNEL_LOOP(i, M * ldk)
+    {
+        const int m = i / ldk;
+        const int k = i % ldk;
+        Y[i]        = k < K ? static_cast<int8_t>(static_cast<int>(X[m * K + k]) - kInt8Shift) : 0;
+    }
+}
+
+__global__ void Int8PadKernel(const int N, const int K, const int ldk, const int8_t* W, int8_t* Y)
+{
+    HIP_1D_KERNEL_LOOP(i, N * ldk)
+    {
+        const int n = i / ldk;
+        const int k = i % ldk;
+        Y[i]        = k < K ? W[n * K + k] : 0;
+    }
+}
+
+// NHWC im2col into the shifted, padded layout of Int8ShiftKernel. Pixels
+// outside of the image take the zero point of X.
+__global__ void Int8Im2ColNHWCKernel(const int rows,
+                                     const int ldk,
+                                     const int H,
+                                     const int W,
+                                     const int C,
+                                     const int OH,
+                                     const int OW,
+                                     const int kernel_h,
+                                     const int kernel_w,
+                                     const int stride_h,
+                                     const int stride_w,
+                                     const int pad_t,
+                                     const int pad_l,
+                                     const int dilation_h,
+                                     const int dilation_w,
+                                     const int X_zero_point,
+                                     const uint8_t* X,
+                                     int8_t* col)
+{
+    const int K = kernel_h * kernel_w * C;
+    HIP_1D_KERNEL_LOOP(i, rows * ldk)
+    {
+        const int row = i / ldk;
+        const int k   = i % ldk;
+        if(k >= K)
+        {
+            col[i] = 0;
+            continue;
+        }
+        const int c  = k % C;
+        const int kw = (k / C) % kernel_w;
+        const int kh = k / (C * kernel_w);
+        const int ow = row % OW;
+        const int oh = (row / OW) % OH;
+        const int n  = row / (OW * OH);
+        const int ih = oh * stride_h - pad_t + kh * dilation_h;
+        const int iw = ow * stride_w - pad_l + kw * dilation_w;
+        const int v =
+            (ih >= 0 && ih < H && iw >= 0 && iw < W) ? X[((n * H + ih) * W + iw) * C + c] : X_zero_point;
+        col[i] = static_cast<int8_t>(v - kInt8Shift);
+    }
+}
+
+// One block per row of the M x ldk matrix X.
+__global__ void Int8RowSumKernel(const int M, const int ldk, const int8_t* X, int* sums)
+{
+    using BlockReduce = hipcub::BlockReduce<int, CAFFE_HIP_NUM_THREADS>;
+    __shared__ BlockReduce::TempStorage temp_storage;
+    for(int m = hipBlockIdx_x; m < M; m += hipGridDim_x)
+    {
+        int sum = 0;
+        for(int k = hipThreadIdx_x; k < ldk; k += hipBlockDim_x)
+        {
+            sum += X[m * ldk + k];
+        }
+        sum = BlockReduce(temp_storage).Sum(sum);
+        if(hipThreadIdx_x == 0)
+        {
+            sums[m] = sum;
+        }
+        __syncthreads();
+    }
+}
+
+// Same correction and requantization as int8::Int8GemmRequantize.
+__global__ void Int8RequantizeKernel(const int M,
+                                     const int N,
+                                     const int K,
+                                     const int* acc,
+                                     const int* X_sums,
+                                     const int X_zero_point,
+                                     const int* W_sums,
+                                     const int* W_zero_points,
+                                     const float* multiplier,
+                                     const float* bias,
+                                     const float Y_scale,
+                                     const int Y_zero_point,
+                                     const float lower,
+                                     uint8_t* Y)
+{
+    HIP_1D_KERNEL_LOOP(i, M * N)
+    {
+        const int m  = i / N;
+        const int n  = i % N;
+        const int wz = W_zero_points[n];
+        const int a  = acc[i] - wz * X_sums[m] - X_zero_point * W_sums[n] + K * X_zero_point * wz;
+        const float offset = (bias ? bias[n] / Y_scale : 0.0f) + Y_zero_point;
+        const float q      = rintf(a * multiplier[n] + offset);
+        Y[i]               = static_cast<uint8_t>(fminf(fmaxf(q, lower), 255.0f));
+    }
+}
+
+template <bool kNHWC>
+__global__ void Int8MaxPoolKernel(const int nthreads,
+                                  const int C,
+                                  const int H,
+                                  const int W,
+                                  const int PH,
+                                  const int PW,
+                                  const int kernel_h,
+                                  const int kernel_w,
+                                  const int stride_h,
+                                  const int stride_w,
+                                  const int pad_t,
+                                  const int pad_l,
+                                  const uint8_t* X,
+                                  uint8_t* Y)
+{
+    HIP_1D_KERNEL_LOOP(index, nthreads)
+    {
+        int n, c, ph, pw;
+        if(kNHWC)
+        {
+            c  = index % C;
+            pw = (index / C) % PW;
+            ph = (index / C / PW) % PH;
+            n  = index / C / PW / PH;
+        }
+        else
+        {
+            pw = index % PW;
+            ph = (index / PW) % PH;
+            c  = (index / PW / PH) % C;
+            n  = index / PW / PH / C;
+        }
+        const int hstart = max(ph * stride_h - pad_t, 0);
+        const int wstart = max(pw * stride_w - pad_l, 0);
+        const int hend   = min(ph * stride_h - pad_t + kernel_h, H);
+        const int wend   = min(pw * stride_w - pad_l + kernel_w, W);
+        uint8_t v        = 0;
+        for(int h = hstart; h < hend; ++h)
+        {
+            for(int w = wstart; w < wend; ++w)
+            {
+                const int idx = kNHWC ? ((n * H + h) * W + w) * C + c : ((n * C + c) * H + h) * W + w;
+                v = X[idx] > v ? X[idx] : v;
+            }
+        }
+        Y[index] = v;
+    }
+}
+
+// Device state shared by Int8FC and Int8Conv: the per channel weight
+// parameters, which only depend on the arguments, and scratch buffers.
+class Int8GemmHIPHelper
+{
+    public:
+    void Run(const OperatorBase& op,
+             int M,
+             int N,
+             int K,
+             const uint8_t* X,
+             bool X_is_col,
+             const int8_t* W,
+             const float* bias,
+             int8::QuantParams X_params,
+             int8::QuantParams Y_params,
+             bool relu,
+             uint8_t* Y,
+             HIPContext* context)
+    {
+        const int ldk = RoundUpDepth(K);
+        if(W_params_.scales.size() != N)
+        {
+            W_params_ = int8::GetWeightQuantParams(op, N);
+            multiplier_host_.resize(N);
+            for(int n = 0; n < N; ++n)
+            {
+                multiplier_host_[n] = X_params.scale * W_params_.scales[n] / Y_params.scale;
+            }
+            multiplier_.Resize(N);
+            W_zero_points_.Resize(N);
+            context->Copy<float, CPUContext, HIPContext>(
+                N, multiplier_host_.data(), multiplier_.mutable_data<float>());
+            context->Copy<int, CPUContext, HIPContext>(
+                N, W_params_.zero_points.data(), W_zero_points_.mutable_data<int>());
+        }
+
+        // X is either the uint8 input or, for convolutions, an im2col already
+        // in the shifted and padded layout.
+        const int8_t* X8 = reinterpret_cast<const int8_t*>(X);
+        if(!X_is_col)
+        {
+            X8_.Resize(M, ldk);
+            hipLaunchKernelGGL((Int8ShiftKernel),
+                               dim3(CAFFE_GET_BLOCKS(M * ldk)),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context->hip_stream(),
+                               M,
+                               K,
+                               ldk,
+                               X,
+                               X8_.mutable_data<int8_t>());
+            X8 = X8_.data<int8_t>();
+        }
+        const int8_t* W8 = W;
+        if(ldk != K)
+        {
+            W8_.Resize(N, ldk);
+            hipLaunchKernelGGL((Int8PadKernel),
+                               dim3(CAFFE_GET_BLOCKS(N * ldk)),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context->hip_stream(),
+                               N,
+                               K,
+                               ldk,
+                               W,
+                               W8_.mutable_data<int8_t>());
+            W8 = W8_.data<int8_t>();
+        }
+
+        X_sums_.Resize(M);
+        W_sums_.Resize(N);
+        hipLaunchKernelGGL((Int8RowSumKernel),
+                           dim3(std::min(M, CAFFE_MAXIMUM_NUM_BLOCKS)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context->hip_stream(),
+                           M,
+                           ldk,
+                           X8,
+                           X_sums_.mutable_data<int>());
+        hipLaunchKernelGGL((Int8RowSumKernel),
+                           dim3(std::min(N, CAFFE_MAXIMUM_NUM_BLOCKS)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context->hip_stream(),
+                           N,
+                           ldk,
+                           W8,
+                           W_sums_.mutable_data<int>());
+
+        // Row major acc (M x N) = X8 * W8^T, i.e. column major acc^T = W8^T * X8.
+        acc_.Resize(M, N);
+        const int32_t alpha = 1;
+        const int32_t beta  = 0;
+        ROCBLAS_ENFORCE(rocblas_gemm_ex(context->get_rocblas_handle(),
+                                        rocblas_operation_transpose,
+                                        rocblas_operation_none,
+                                        N,
+                                        M,
+                                        ldk,
+                                        &alpha,
+                                        W8,
+                                        rocblas_datatype_i8_r,
+                                        ldk,
+                                        X8,
+                                        rocblas_datatype_i8_r,
+                                        ldk,
+                                        &beta,
+                                        acc_.mutable_data<int>(),
+                                        rocblas_datatype_i32_r,
+                                        N,
+                                        acc_.mutable_data<int>(),
+                                        rocblas_datatype_i32_r,
+                                        N,
+                                        rocblas_datatype_i32_r,
+                                        rocblas_gemm_algo_standard,
+                                        0,
+                                        0));
+
+        const float lower = relu ? std::max(Y_params.zero_point, 0) : 0;
+        hipLaunchKernelGGL((Int8RequantizeKernel),
+                           dim3(CAFFE_GET_BLOCKS(M * N)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context->hip_stream(),
+                           M,
+                           N,
+                           K,
+                           acc_.data<int>(),
+                           X_sums_.data<int>(),
+                           X_params.zero_point - kInt8Shift,
+                           W_sums_.data<int>(),
+                           W_zero_points_.data<int>(),
+                           multiplier_.data<float>(),
+                           bias,
+                           Y_params.scale,
+                           Y_params.zero_point,
+                           lower,
+                           Y);
+    }
+
+    private:
+    int8::WeightQuantParams W_params_;
+    std::vector<float> multiplier_host_;
+    Tensor<HIPContext> multiplier_;
+    Tensor<HIPContext> W_zero_points_;
+    Tensor<HIPContext> X8_;
+    Tensor<HIPContext> W8_;
+    Tensor<HIPContext> X_sums_;
+    Tensor<HIPContext> W_sums_;
+    Tensor<HIPContext> acc_;
+};
+
+} // namespace
+
+class Int8QuantizeHIPOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    Int8QuantizeHIPOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws), Y_params_(int8::GetQuantParams(*this, "Y"))
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        const auto& X = Input(0);
+        auto* Y       = Output(0);
+        Y->ResizeLike(X);
+        hipLaunchKernelGGL((Int8QuantizeKernel),
+                           dim3(CAFFE_GET_BLOCKS(X.size())),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           static_cast<const int>(X.size()),
+                           Y_params_.scale,
+                           Y_params_.zero_point,
+                           X.data<float>(),
+                           Y->mutable_data<uint8_t>());
+        return true;
+    }
+
+    private:
+    int8::QuantParams Y_params_;
+};
+
+class Int8DequantizeHIPOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    Int8DequantizeHIPOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws), X_params_(int8::GetQuantParams(*this, "X"))
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        return DispatchHelper<TensorTypes<uint8_t, int8_t>>::call(this, Input(0));
+    }
+
+    template <typename T>
+    bool DoRunWithType()
+    {
+        const auto& X = Input(0);
+        auto* Y       = Output(0);
+        Y->ResizeLike(X);
+        hipLaunchKernelGGL((Int8DequantizeKernel<T>),
+                           dim3(CAFFE_GET_BLOCKS(X.size())),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           static_cast<const int>(X.size()),
+                           X_params_.scale,
+                           X_params_.zero_point,
+                           X.template data<T>(),
+                           Y->mutable_data<float>());
+        return true;
+    }
+
+    private:
+    int8::QuantParams X_params_;
+};
+
+class Int8FCHIPOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    Int8FCHIPOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws),
+          axis_(OperatorBase::GetSingleArgument<int32_t>("axis", 1)),
+          axis_w_(OperatorBase::GetSingleArgument<int32_t>("axis_w", 1)),
+          relu_(OperatorBase::GetSingleArgument<bool>("relu", false)),
+          X_params_(int8::GetQuantParams(*this, "X")),
+          Y_params_(int8::GetQuantParams(*this, "Y"))
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        const auto& X = Input(0);
+        const auto& W = Input(1);
+        auto* Y       = Output(0);
+        CAFFE_ENFORCE(X.IsType<uint8_t>(), "X must be uint8");
+        CAFFE_ENFORCE(W.IsType<int8_t>(), "W must be int8");
+        const auto canonical_axis = X.canonical_axis_index(axis_);
+        const int M               = X.size_to_dim(canonical_axis);
+        const int K               = X.size_from_dim(canonical_axis);
+        const int N               = W.size_to_dim(W.canonical_axis_index(axis_w_));
+        CAFFE_ENFORCE_EQ(K, W.size() / N, "Dimension mismatch between X and W");
+        const float* bias = nullptr;
+        if(InputSize() == 3)
+        {
+            CAFFE_ENFORCE_EQ(Input(2).size(), N);
+            bias = Input(2).data<float>();
+        }
+        auto Y_shape = X.dims();
+        Y_shape.resize(canonical_axis + 1);
+        Y_shape[canonical_axis] = N;
+        Y->Resize(Y_shape);
+        if(M == 0)
+        {
+            Y->mutable_data<uint8_t>();
+            return true;
+        }
+        gemm_.Run(*this,
+                  M,
+                  N,
+                  K,
+                  X.data<uint8_t>(),
+                  false,
+                  W.data<int8_t>(),
+                  bias,
+                  X_params_,
+                  Y_params_,
+                  relu_,
+                  Y->mutable_data<uint8_t>(),
+                  &context_);
+        return true;
+    }
+
+    private:
+    size_t axis_;
+    size_t axis_w_;
+    bool relu_;
+    int8::QuantParams X_params_;
+    int8::QuantParams Y_params_;
+    Int8GemmHIPHelper gemm_;
+};
+
+class Int8ConvHIPOp final : public ConvPoolOpBase<HIPContext>
+{
+    public:
+    USE_CONV_POOL_BASE_FUNCTIONS(HIPContext);
+    Int8ConvHIPOp(const OperatorDef& operator_def, Workspace* ws)
+        : ConvPoolOpBase<HIPContext>(operator_def, ws),
+          relu_(OperatorBase::GetSingleArgument<bool>("relu", false)),
+          X_params_(int8::GetQuantParams(*this, "X")),
+          Y_params_(int8::GetQuantParams(*this, "Y"))
+    {
+        OPERATOR_NEEDS_FEATURE(order_ == StorageOrder::NHWC, "Int8Conv only supports NHWC order");
+        OPERATOR_NEEDS_FEATURE(group_ == 1, "Int8Conv does not support groups");
+        CAFFE_ENFORCE_EQ(kernel_.size(), 2, "Int8Conv only supports 2D kernels");
+    }
+
+    bool RunOnDeviceWithOrderNHWC() override
+    {
+        const auto& X      = Input(0);
+        const auto& filter = Input(1);
+        auto* Y            = Output(0);
+        CAFFE_ENFORCE(X.IsType<uint8_t>(), "X must be uint8");
+        CAFFE_ENFORCE(filter.IsType<int8_t>(), "filter must be int8");
+        CAFFE_ENFORCE_EQ(X.ndim(), 4);
+        CAFFE_ENFORCE_EQ(filter.ndim(), 4);
+        const int N = X.dim32(0);
+        const int H = X.dim32(1);
+        const int W = X.dim32(2);
+        const int C = X.dim32(3);
+        const int M = filter.dim32(0);
+        CAFFE_ENFORCE_EQ(filter.dim32(1), kernel_h());
+        CAFFE_ENFORCE_EQ(filter.dim32(2), kernel_w());
+        CAFFE_ENFORCE_EQ(filter.dim32(3), C);
+        const float* bias = nullptr;
+        if(InputSize() == 3)
+        {
+            CAFFE_ENFORCE_EQ(Input(2).size(), M);
+            bias = Input(2).data<float>();
+        }
+        ConvPoolOpBase<HIPContext>::SetOutputSize(X, Y, M);
+        const int OH   = Y->dim32(1);
+        const int OW   = Y->dim32(2);
+        const int rows = N * OH * OW;
+        const int K    = kernel_h() * kernel_w() * C;
+        const int ldk  = RoundUpDepth(K);
+        col_buffer_.Resize(rows, ldk);
+        hipLaunchKernelGGL((Int8Im2ColNHWCKernel),
+                           dim3(CAFFE_GET_BLOCKS(rows * ldk)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           rows,
+                           ldk,
+                           H,
+                           W,
+                           C,
+                           OH,
+                           OW,
+                           kernel_h(),
+                           kernel_w(),
+                           stride_h(),
+                           stride_w(),
+                           pad_t(),
+                           pad_l(),
+                           dilation_h(),
+                           dilation_w(),
+                           X_params_.zero_point,
+                           X.data<uint8_t>(),
+                           col_buffer_.mutable_data<int8_t>());
+        gemm_.Run(*this,
+                  rows,
+                  M,
+                  K,
+                  reinterpret_cast<const uint8_t*>(col_buffer_.data<int8_t>()),
+                  true,
+                  filter.data<int8_t>(),
+                  bias,
+                  X_params_,
+                  Y_params_,
+                  relu_,
+                  Y->mutable_data<uint8_t>(),
+                  &context_);
+        return true;
+    }
+
+    private:
+    bool relu_;
+    int8::QuantParams X_params_;
+    int8::QuantParams Y_params_;
+    Tensor<HIPContext> col_buffer_;
+    Int8GemmHIPHelper gemm_;
+};
+
+class Int8ReluHIPOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    Int8ReluHIPOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws),
+          X_params_(int8::GetQuantParams(*this, "X")),
+          Y_params_(int8::GetQuantParams(*this, "Y", X_params_))
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        const auto& X = Input(0);
+        auto* Y       = Output(0);
+        CAFFE_ENFORCE(X.IsType<uint8_t>(), "X must be uint8");
+        Y->ResizeLike(X);
+        if(X_params_.scale == Y_params_.scale && X_params_.zero_point == Y_params_.zero_point)
+        {
+            hipLaunchKernelGGL((Int8ReluKernel),
+                               dim3(CAFFE_GET_BLOCKS(X.size())),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context_.hip_stream(),
+                               static_cast<const int>(X.size()),
+                               static_cast<uint8_t>(std::min(std::max(X_params_.zero_point, 0), 255)),
+                               X.data<uint8_t>(),
+                               Y->mutable_data<uint8_t>());
+            return true;
+        }
+        hipLaunchKernelGGL((Int8ReluRequantizeKernel),
+                           dim3(CAFFE_GET_BLOCKS(X.size())),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           static_cast<const int>(X.size()),
+                           X_params_.scale,
+                           X_params_.zero_point,
+                           Y_params_.scale,
+                           Y_params_.zero_point,
+                           X.data<uint8_t>(),
+                           Y->mutable_data<uint8_t>());
+        return true;
+    }
+
+    private:
+    int8::QuantParams X_params_;
+    int8::QuantParams Y_params_;
+};
+
+class Int8MaxPoolHIPOp final : public ConvPoolOpBase<HIPContext>
+{
+    public:
+    USE_CONV_POOL_BASE_FUNCTIONS(HIPContext);
+    Int8MaxPoolHIPOp(const OperatorDef& operator_def, Workspace* ws)
+        : ConvPoolOpBase<HIPContext>(operator_def, ws)
+    {
+        CAFFE_ENFORCE_EQ(kernel_.size(), 2, "Int8MaxPool only supports 2D pooling");
+        for(int i = 0; i < kernel_.size(); ++i)
+        {
+            CAFFE_ENFORCE_EQ(dilation_[i], 1, "Pooling op does not support dilation right now.");
+        }
+    }
+
+    bool RunOnDeviceWithOrderNHWC() override { return RunWithOrder<true>(); }
+
+    bool RunOnDeviceWithOrderNCHW() override { return RunWithOrder<false>(); }
+
+    private:
+    template <bool kNHWC>
+    bool RunWithOrder()
+    {
+        const auto& X = Input(0);
+        auto* Y       = Output(0);
+        CAFFE_ENFORCE(X.IsType<uint8_t>(), "X must be uint8");
+        const int C = kNHWC ? X.dim32(3) : X.dim32(1);
+        const int H = kNHWC ? X.dim32(1) : X.dim32(2);
+        const int W = kNHWC ? X.dim32(2) : X.dim32(3);
+        ConvPoolOpBase<HIPContext>::SetOutputSize(X, Y, C);
+        const int PH = kNHWC ? Y->dim32(1) : Y->dim32(2);
+        const int PW = kNHWC ? Y->dim32(2) : Y->dim32(3);
+        hipLaunchKernelGGL((Int8MaxPoolKernel<kNHWC>),
+                           dim3(CAFFE_GET_BLOCKS(Y->size())),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           static_cast<const int>(Y->size()),
+                           C,
+                           H,
+                           W,
+                           PH,
+                           PW,
+                           kernel_h(),
+                           kernel_w(),
+                           stride_h(),
+                           stride_w(),
+                           pad_t(),
+                           pad_l(),
+                           X.data<uint8_t>(),
+                           Y->mutable_data<uint8_t>());
+        return true;
+    }
+};
+
+REGISTER_HIP_OPERATOR(Int8Quantize, Int8QuantizeHIPOp);
+REGISTER_HIP_OPERATOR(Int8Dequantize, Int8DequantizeHIPOp);
+REGISTER_HIP_OPERATOR(Int8FC, Int8FCHIPOp);
+REGISTER_HIP_OPERATOR(Int8Conv, Int8ConvHIPOp);
+REGISTER_HIP_OPERATOR(Int8Relu, Int8ReluHIPOp);
+REGISTER_HIP_OPERATOR(Int8MaxPool, Int8MaxPoolHIPOp);
+} // namespace caffe2
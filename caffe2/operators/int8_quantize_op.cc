@@ -0,0 +1,63 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/int8_quantize_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8Quantize, Int8QuantizeOp);
+REGISTER_CPU_OPERATOR(Int8Dequantize, Int8DequantizeOp);
+
+OPERATOR_SCHEMA(Int8Quantize)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .TensorInferenceFunction([](const OperatorDef& /* unused */,
+                                const vector<TensorShape>& in) {
+      vector<TensorShape> out(1, in[0]);
+      out[0].set_data_type(TensorProto::UINT8);
+      return out;
+    })
+    .SetDoc(R"DOC(
+Quantizes a float tensor to uint8 with Y = clamp(round(X / Y_scale) +
+Y_zero_point, 0, 255), for use by the other Int8* operators.
+)DOC")
+    .Arg("Y_scale", "Scale of the output. Defaults to 1")
+    .Arg("Y_zero_point", "Zero point of the output. Defaults to 0")
+    .Input(0, "X", "Float input tensor")
+    .Output(0, "Y", "uint8 quantized tensor");
+
+OPERATOR_SCHEMA(Int8Dequantize)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .TensorInferenceFunction([](const OperatorDef& /* unused */,
+                                const vector<TensorShape>& in) {
+      vector<TensorShape> out(1, in[0]);
+      out[0].set_data_type(TensorProto::FLOAT);
+      return out;
+    })
+    .SetDoc(R"DOC(
+Turns a uint8 or int8 quantized tensor back into floats with
+Y = X_scale * (X - X_zero_point).
+)DOC")
+    .Arg("X_scale", "Scale of the input. Defaults to 1")
+    .Arg("X_zero_point", "Zero point of the input. Defaults to 0")
+    .Input(0, "X", "uint8 or int8 quantized tensor")
+    .Output(0, "Y", "Float output tensor");
+
+NO_GRADIENT(Int8Quantize);
+NO_GRADIENT(Int8Dequantize);
+
+} // namespace caffe2
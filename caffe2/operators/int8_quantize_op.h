@@ -0,0 +1,81 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_OPERATORS_INT8_QUANTIZE_OP_H_
+#define CAFFE2_OPERATORS_INT8_QUANTIZE_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/operators/int8_utils.h"
+
+namespace caffe2 {
+
+class Int8QuantizeOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  Int8QuantizeOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        Y_params_(int8::GetQuantParams(*this, "Y")) {}
+
+  bool RunOnDevice() override {
+    const auto& X = Input(0);
+    auto* Y = Output(0);
+    Y->ResizeLike(X);
+    const float* Xdata = X.data<float>();
+    std::uint8_t* Ydata = Y->mutable_data<std::uint8_t>();
+    for (TIndex i = 0; i < X.size(); ++i) {
+      Ydata[i] = int8::QuantizeUint8(Xdata[i], Y_params_);
+    }
+    return true;
+  }
+
+ private:
+  int8::QuantParams Y_params_;
+};
+
+class Int8DequantizeOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  Int8DequantizeOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        X_params_(int8::GetQuantParams(*this, "X")) {}
+
+  bool RunOnDevice() override {
+    return DispatchHelper<TensorTypes<std::uint8_t, std::int8_t>>::call(
+        this, Input(0));
+  }
+
+  template <typename T>
+  bool DoRunWithType() {
+    const auto& X = Input(0);
+    auto* Y = Output(0);
+    Y->ResizeLike(X);
+    const T* Xdata = X.data<T>();
+    float* Ydata = Y->mutable_data<float>();
+    for (TIndex i = 0; i < X.size(); ++i) {
+      Ydata[i] =
+          X_params_.scale * (std::int32_t(Xdata[i]) - X_params_.zero_point);
+    }
+    return true;
+  }
+
+ private:
+  int8::QuantParams X_params_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_QUANTIZE_OP_H_
@@ -0,0 +1,42 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/int8_relu_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8Relu, Int8ReluOp);
+
+OPERATOR_SCHEMA(Int8Relu)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}})
+    .IdenticalTypeAndShape()
+    .SetDoc(R"DOC(
+Quantized version of Relu for uint8 tensors. If the output has the same
+quantization parameters as the input (the default), this clamps X below at
+X_zero_point; otherwise the result is requantized to Y_scale and Y_zero_point.
+)DOC")
+    .Arg("X_scale", "Scale of X. Defaults to 1")
+    .Arg("X_zero_point", "Zero point of X. Defaults to 0")
+    .Arg("Y_scale", "Scale of Y. Defaults to X_scale")
+    .Arg("Y_zero_point", "Zero point of Y. Defaults to X_zero_point")
+    .Input(0, "X", "uint8 input")
+    .Output(0, "Y", "uint8 output");
+
+NO_GRADIENT(Int8Relu);
+
+} // namespace caffe2
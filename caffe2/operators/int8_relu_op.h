@@ -0,0 +1,66 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_OPERATORS_INT8_RELU_OP_H_
+#define CAFFE2_OPERATORS_INT8_RELU_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/operators/int8_utils.h"
+
+namespace caffe2 {
+
+class Int8ReluOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  Int8ReluOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        X_params_(int8::GetQuantParams(*this, "X")),
+        Y_params_(int8::GetQuantParams(*this, "Y", X_params_)) {}
+
+  bool RunOnDevice() override {
+    const auto& X = Input(0);
+    auto* Y = Output(0);
+    CAFFE_ENFORCE(X.IsType<std::uint8_t>(), "X must be uint8");
+    Y->ResizeLike(X);
+    const std::uint8_t* Xdata = X.data<std::uint8_t>();
+    std::uint8_t* Ydata = Y->mutable_data<std::uint8_t>();
+    if (X_params_.scale == Y_params_.scale &&
+        X_params_.zero_point == Y_params_.zero_point) {
+      // Real zero is the zero point, so this is just a clamp.
+      const std::uint8_t zero =
+          std::min(std::max(X_params_.zero_point, 0), 255);
+      for (TIndex i = 0; i < X.size(); ++i) {
+        Ydata[i] = std::max(Xdata[i], zero);
+      }
+      return true;
+    }
+    for (TIndex i = 0; i < X.size(); ++i) {
+      const float real =
+          X_params_.scale * (std::int32_t(Xdata[i]) - X_params_.zero_point);
+      Ydata[i] = int8::QuantizeUint8(std::max(real, 0.0f), Y_params_);
+    }
+    return true;
+  }
+
+ private:
+  int8::QuantParams X_params_;
+  int8::QuantParams Y_params_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_RELU_OP_H_
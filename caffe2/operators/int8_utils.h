@@ -0,0 +1,163 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_OPERATORS_INT8_UTILS_H_
+#define CAFFE2_OPERATORS_INT8_UTILS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/perfkernels/int8_gemm.h"
+
+namespace caffe2 {
+namespace int8 {
+
+// The Int8* operators use affine quantization, real = scale * (q - zero_point),
+// with uint8 activations and int8 weights. The tensors only hold the quantized
+// values: the scale and zero point of an input or output called X are passed
+// as the X_scale and X_zero_point arguments of the operator (see
+// caffe2/python/int8_quantization.py, which fills them in from calibration).
+
+struct QuantParams {
+  float scale;
+  std::int32_t zero_point;
+};
+
+inline QuantParams GetQuantParams(
+    const OperatorBase& op,
+    const string& name,
+    QuantParams default_value = {1.0f, 0}) {
+  QuantParams params;
+  params.scale =
+      op.GetSingleArgument<float>(name + "_scale", default_value.scale);
+  params.zero_point = op.GetSingleArgument<std::int32_t>(
+      name + "_zero_point", default_value.zero_point);
+  CAFFE_ENFORCE_GT(params.scale, 0, name, "_scale must be positive");
+  return params;
+}
+
+// Quantization of the weights, given either per tensor (W_scale and
+// W_zero_point are single values) or per output channel (they are lists with
+// one value per channel).
+struct WeightQuantParams {
+  std::vector<float> scales;
+  std::vector<std::int32_t> zero_points;
+};
+
+inline WeightQuantParams GetWeightQuantParams(
+    const OperatorBase& op,
+    int channels) {
+  WeightQuantParams params;
+  params.scales = op.GetRepeatedArgument<float>("W_scale");
+  if (params.scales.empty()) {
+    params.scales.push_back(op.GetSingleArgument<float>("W_scale", 1.0f));
+  }
+  params.zero_points = op.GetRepeatedArgument<std::int32_t>("W_zero_point");
+  if (params.zero_points.empty()) {
+    params.zero_points.push_back(
+        op.GetSingleArgument<std::int32_t>("W_zero_point", 0));
+  }
+  if (params.scales.size() == 1) {
+    params.scales.resize(channels, params.scales[0]);
+  }
+  if (params.zero_points.size() == 1) {
+    params.zero_points.resize(channels, params.zero_points[0]);
+  }
+  CAFFE_ENFORCE_EQ(params.scales.size(), channels);
+  CAFFE_ENFORCE_EQ(params.zero_points.size(), channels);
+  for (int i = 0; i < channels; ++i) {
+    CAFFE_ENFORCE_GT(params.scales[i], 0);
+    CAFFE_ENFORCE(
+        params.zero_points[i] >= -128 && params.zero_points[i] <= 127,
+        "W_zero_point must be in the int8 range");
+  }
+  return params;
+}
+
+inline std::uint8_t QuantizeUint8(float real, QuantParams params) {
+  const float q = std::nearbyint(real / params.scale) + params.zero_point;
+  return static_cast<std::uint8_t>(std::min(std::max(q, 0.0f), 255.0f));
+}
+
+// Computes the quantized Y = X * W^T + b, with X (M x K) uint8, W (N x K) int8,
+// b (N) float or null and Y (M x N) uint8. The int32 products of Int8GemmNT are
+// corrected for the zero points with
+//   sum_k (x - xz)(w - wz) = sum_k xw - wz sum_k x - xz sum_k w + K xz wz,
+// then rescaled by X_scale * W_scale and requantized to Y's parameters. With
+// relu, Y is clamped below at its zero point, i.e. at a real value of zero.
+inline void Int8GemmRequantize(
+    int M,
+    int N,
+    int K,
+    const std::uint8_t* X,
+    QuantParams X_params,
+    const std::int8_t* W,
+    const WeightQuantParams& W_params,
+    const float* bias,
+    QuantParams Y_params,
+    bool relu,
+    TensorCPU* acc_buffer,
+    std::uint8_t* Y) {
+  acc_buffer->Resize(M, N);
+  std::int32_t* acc = acc_buffer->mutable_data<std::int32_t>();
+  Int8GemmNT(M, N, K, X, W, acc, N);
+
+  const std::int32_t xz = X_params.zero_point;
+  std::vector<std::int32_t> W_sums(N, 0);
+  if (xz != 0) {
+    for (int n = 0; n < N; ++n) {
+      for (int k = 0; k < K; ++k) {
+        W_sums[n] += W[n * K + k];
+      }
+    }
+  }
+  const bool has_W_zero_point = std::any_of(
+      W_params.zero_points.begin(),
+      W_params.zero_points.end(),
+      [](std::int32_t z) { return z != 0; });
+  std::vector<float> multiplier(N);
+  std::vector<float> offset(N);
+  for (int n = 0; n < N; ++n) {
+    multiplier[n] = X_params.scale * W_params.scales[n] / Y_params.scale;
+    offset[n] = (bias ? bias[n] / Y_params.scale : 0.0f) + Y_params.zero_point;
+  }
+  const float lower = relu ? std::max(Y_params.zero_point, 0) : 0;
+  for (int m = 0; m < M; ++m) {
+    std::int32_t X_sum = 0;
+    if (has_W_zero_point) {
+      for (int k = 0; k < K; ++k) {
+        X_sum += X[m * K + k];
+      }
+    }
+    for (int n = 0; n < N; ++n) {
+      const std::int32_t wz = W_params.zero_points[n];
+      const std::int32_t a =
+          acc[m * N + n] - wz * X_sum - xz * W_sums[n] + K * xz * wz;
+      const float q = std::nearbyint(a * multiplier[n] + offset[n]);
+      Y[m * N + n] =
+          static_cast<std::uint8_t>(std::min(std::max(q, lower), 255.0f));
+    }
+  }
+}
+
+} // namespace int8
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_UTILS_H_
@@ -19,6 +19,7 @@
 #include <vector>
 #include "caffe2/core/operator.h"
 #include "caffe2/core/tensor.h"
+#include "caffe2/operators/counter_ops.h"
 
 namespace caffe2 {
 namespace {
@@ -35,6 +36,10 @@ class LastNWindowCollectorOp : public Operator<Context> {
   }
 
   bool RunOnDevice() override {
+    if (InputSize() > MUTEX &&
+        OperatorBase::InputIsType<std::unique_ptr<Counter<int64_t>>>(MUTEX)) {
+      return collectLockFree();
+    }
     if (InputSize() > MUTEX) {
       auto& mutex = OperatorBase::Input<std::unique_ptr<std::mutex>>(MUTEX);
       std::lock_guard<std::mutex> guard(*mutex);
@@ -138,6 +143,64 @@ class LastNWindowCollectorOp : public Operator<Context> {
     return true;
   }
 
+  // Every writer reserves its rows with a single fetch-add on the cursor and
+  // copies them without a lock. The buffer can't be resized under concurrent
+  // writers, so it has to be allocated to num_to_collect rows beforehand.
+  bool collectLockFree() {
+    CAFFE_ENFORCE_LE(
+        OutputSize(),
+        NUM_VISITED,
+        "NUM_VISITED is not updated without a mutex, "
+        "use RetrieveCount on the cursor instead");
+    auto& cursor =
+        OperatorBase::Input<std::unique_ptr<Counter<int64_t>>>(MUTEX);
+    auto* output = Output(LAST_N);
+    const auto& input = Input(DATA);
+
+    CAFFE_ENFORCE_GE(input.ndim(), 1);
+    CAFFE_ENFORCE(
+        output->meta() == input.meta(),
+        "The buffer must be preallocated with the type of DATA");
+    CAFFE_ENFORCE_EQ(output->ndim(), input.ndim());
+    CAFFE_ENFORCE_EQ(
+        output->dim(0),
+        numToCollect_,
+        "The buffer must be preallocated to num_to_collect rows");
+    for (size_t i = 1; i < input.ndim(); ++i) {
+      CAFFE_ENFORCE_EQ(output->dim(i), input.dim(i));
+    }
+
+    const auto num_entries = input.dim(0);
+    if (num_entries == 0) {
+      return true;
+    }
+    const auto start = cursor->fetchAdd(num_entries);
+
+    // Only the last num_to_collect rows of a large batch are kept
+    const auto num_to_copy = std::min<TIndex>(num_entries, numToCollect_);
+    const auto pos = (start + num_entries - num_to_copy) % numToCollect_;
+    const auto first_chunk_size =
+        std::min<TIndex>(num_to_copy, numToCollect_ - pos);
+
+    auto block_size = input.size_from_dim(1);
+    auto block_bytesize = block_size * input.itemsize();
+    const auto* input_data = static_cast<const char*>(input.raw_data()) +
+        (num_entries - num_to_copy) * block_bytesize;
+    auto* output_data = static_cast<char*>(output->raw_mutable_data());
+
+    context_.template CopyItems<Context, Context>(
+        input.meta(),
+        first_chunk_size * block_size,
+        input_data,
+        output_data + pos * block_bytesize);
+    context_.template CopyItems<Context, Context>(
+        input.meta(),
+        (num_to_copy - first_chunk_size) * block_size,
+        input_data + first_chunk_size * block_bytesize,
+        output_data);
+    return true;
+  }
+
   INPUT_TAGS(LAST_N_IN, NEXT_IN, DATA, MUTEX, NUM_VISITED_IN);
   OUTPUT_TAGS(LAST_N, NEXT, NUM_VISITED);
 };
@@ -176,6 +239,16 @@ A possible output would be
 [[6,7],[7,8],[8,9],[9,10],[10,11],[11,12]]
 
 This is not thread safe unless a mutex is given.
+
+Instead of a mutex, a cursor created by `CreateCounter` can be given as the
+fourth input. Writers then reserve their rows with one atomic add on the cursor
+and copy them without locking, which scales to many concurrent writers. In
+this mode the buffer must be preallocated to `num_to_collect` rows of the type
+and shape of DATA (e.g. by `ConstantFill`), the next cursor input is left
+untouched, and the number of rows seen so far is the value of the cursor
+(`RetrieveCount`); NUM_VISITED can't be given. Rows are placed at
+`count % num_to_collect` as in the locked mode. A row may be torn only if other
+writers wrap around the whole buffer while it is being copied.
 )DOC")
     .Arg(
         "num_to_collect",
@@ -190,7 +263,11 @@ This is not thread safe unless a mutex is given.
         "The cursor pointing to the next position that should be replaced. "
         "Should be initialized to 0.")
     .Input(2, "DATA", "tensor to collect from")
-    .Input(3, "MUTEX", "(optional) mutex to use to make this thread-safe")
+    .Input(
+        3,
+        "MUTEX",
+        "(optional) mutex to use to make this thread-safe, or a counter "
+        "blob to collect lock-free")
     .Input(4, "NUM_VISITED", "")
     .Output(0, "last-N buffer", "Data stored in sessions")
     .Output(1, "next cursor", "Updated input cursor")
@@ -86,23 +86,61 @@ class CPUSparseLengthsReductionOp : public Operator<CPUContext> {
       in_weight = weightInput.template data<T>();
     }
 
-    // delegate work to perfkernel that branches based on architecture
-    EmbeddingLookup(
-        D,
-        M,
+    const size_t work = static_cast<size_t>(indices_size) * D;
+    if (M < 2 || work < 2 * kParallelGrain) {
+      // delegate work to perfkernel that branches based on architecture
+      EmbeddingLookup(
+          D,
+          M,
+          indices_size,
+          N,
+          in_data,
+          indices,
+          lengths,
+          in_weight,
+          nullptr, // scale_bias field is only used in SparseLengths8BitsRowwiseOp
+          USE_MEAN,
+          out_data);
+      return true;
+    }
+
+    // Large batches are split by segments over the intra-op threads, each
+    // chunk starting at the first index of its first segment.
+    offsets_.resize(M + 1);
+    offsets_[0] = 0;
+    for (TIndex i = 0; i < M; ++i) {
+      CAFFE_ENFORCE_GE(lengths[i], 0, "Negative length for segment ", i);
+      offsets_[i + 1] = offsets_[i] + lengths[i];
+    }
+    CAFFE_ENFORCE_EQ(
+        offsets_[M],
         indices_size,
-        N,
-        in_data,
-        indices,
-        lengths,
-        in_weight,
-        nullptr, // scale_bias field is only used in SparseLengths8BitsRowwiseOp
-        USE_MEAN,
-        out_data);
+        "Your input seems to be incorrect: the sum of lengths values should be "
+        "the size of the indices tensor, but it appears not.");
+    const size_t grain = std::max<size_t>(kParallelGrain * M / work, 1);
+    CPUContext::ParallelFor(M, grain, [&](size_t begin, size_t end) {
+      EmbeddingLookup(
+          D,
+          end - begin,
+          offsets_[end] - offsets_[begin],
+          N,
+          in_data,
+          indices + offsets_[begin],
+          lengths + begin,
+          in_weight ? in_weight + offsets_[begin] : nullptr,
+          nullptr,
+          USE_MEAN,
+          out_data + begin * D);
+    });
     return true;
   }
 
  private:
+  // Smallest number of gathered elements that runs on another thread.
+  static constexpr size_t kParallelGrain = 1 << 16;
+
+  vector<TIndex> offsets_;
+
   enum {
     DATA = 0, // Data input.
     WEIGHT = 1, // Weight input used in SparseLengthsWeightedSum
@@ -0,0 +1,420 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include <hipcub/hipcub.hpp>
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/conversions.h"
+#include "caffe2/utils/math.h"
+#include "hip/hip_runtime.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Threads per block of the reduction kernel. Each block holds
+// kReductionThreads / hipBlockDim_x segments.
+constexpr int kReductionThreads = 256;
+
+// One group of hipBlockDim_x lanes (a wavefront, or part of one when the
+// rows are narrow) reduces one segment. The lanes stride over the D columns
+// so that every row gathered from the table is read with coalesced loads,
+// and the sum is kept in float whatever the table type is, like the CPU
+// EmbeddingLookup does.
+template <typename InputType, typename IndexType, bool USE_WEIGHT, bool USE_MEAN>
+__global__ void sparse_lengths_reduction_kernel(const InputType* __restrict__ in,
+                                                const float* __restrict__ weights,
+                                                const IndexType* __restrict__ indices,
+                                                const int* __restrict__ offsets,
+                                                const int* __restrict__ lengths,
+                                                float* __restrict__ out,
+                                                int N,
+                                                int D,
+                                                int M)
+{
+    const int segment = hipBlockIdx_x * hipBlockDim_y + hipThreadIdx_y;
+    if(segment >= M)
+    {
+        return;
+    }
+
+    const int start = offsets[segment];
+    const int end   = start + lengths[segment];
+    const float scale =
+        (USE_MEAN && end > start) ? 1.0f / static_cast<float>(end - start) : 1.0f;
+
+    for(int col = hipThreadIdx_x; col < D; col += hipBlockDim_x)
+    {
+        float sum = 0.0f;
+        for(int line = start; line < end; ++line)
+        {
+            const IndexType idx = indices[line];
+            HIP_KERNEL_ASSERT(idx >= 0 && idx < N);
+            const float value =
+                convert::To<InputType, float>(in[static_cast<int64_t>(idx) * D + col]);
+            sum += USE_WEIGHT ? weights[line] * value : value;
+        }
+        out[static_cast<int64_t>(segment) * D + col] = sum * scale;
+    }
+}
+
+// Counts the uses of the blocks of block_bytes of the table that the rows
+// looked up lie in, for the hot row cache of the MANAGED engine.
+template <typename IndexType>
+__global__ void managed_block_count_kernel(const IndexType* __restrict__ indices,
+                                           int n,
+                                           int64_t row_bytes,
+                                           int64_t block_bytes,
+                                           int* __restrict__ counts)
+{
+    HIP_1D_KERNEL_LOOP(i, n)
+    {
+        const int64_t begin = static_cast<int64_t>(indices[i]) * row_bytes;
+        const int64_t last  = (begin + row_bytes - 1) / block_bytes;
+        for(int64_t block = begin / block_bytes; block <= last; ++block)
+        {
+            atomicAdd(&counts[block], 1);
+        }
+    }
+}
+
+// Halves the counts, so that the cache follows the lookups as they drift.
+__global__ void managed_block_decay_kernel(int n, int* __restrict__ counts)
+{
+    HIP_1D_KERNEL_LOOP(i, n) { counts[i] >>= 1; }
+}
+
+} // namespace
+
+// HIP counterpart of CPUSparseLengthsReductionOp (lengths_reducer_ops.h):
+// SparseLengths[Sum,WeightedSum,Mean] over a float or float16 table, with
+// int32 or int64 indices and a float output.
+template <typename T, class InputTypes, bool USE_WEIGHT = 0, bool USE_MEAN = 0>
+class HIPSparseLengthsReductionOp : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPSparseLengthsReductionOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws)
+    {
+        static_assert(!(USE_WEIGHT & USE_MEAN), "Cannot both specify weight and mean.");
+    }
+
+    ~HIPSparseLengthsReductionOp() {}
+
+    bool RunOnDevice() override { return DispatchHelper<InputTypes>::call(this, Input(DATA)); }
+
+    template <typename InputType>
+    bool DoRunWithType()
+    {
+        return DispatchHelper<TensorTypes2<int32_t, int64_t>, InputType>::call(this,
+                                                                                Input(INDICES));
+    }
+
+    template <typename InputType, typename IndexType>
+    bool DoRunWithType2()
+    {
+        auto& dataInput    = Input(DATA);
+        auto& indicesInput = Input(INDICES);
+        auto& lengthsInput = Input(LENGTHS);
+
+        CAFFE_ENFORCE_EQ(1, indicesInput.ndim(), "INDICES must be a vector");
+        CAFFE_ENFORCE_EQ(1, lengthsInput.ndim(), "LENGTHS must be a vector");
+        const TIndex N            = dataInput.dim(0);
+        const int D               = dataInput.size_from_dim(1);
+        const TIndex M            = lengthsInput.dim(0);
+        const TIndex indices_size = indicesInput.size();
+
+        auto* output = Output(0);
+        auto shape   = dataInput.dims();
+        shape[0]     = M;
+        output->Resize(shape);
+        T* out_data = output->template mutable_data<T>();
+
+        const T* in_weight = nullptr;
+        if(USE_WEIGHT)
+        { // static if
+            auto& weightInput = Input(WEIGHT);
+            CAFFE_ENFORCE_EQ(1, weightInput.ndim(), "WEIGHT must be a vector");
+            CAFFE_ENFORCE_EQ(weightInput.size(),
+                             indices_size,
+                             "Weight should have the same length as indices.");
+            in_weight = weightInput.template data<T>();
+        }
+
+        if(M == 0 || D == 0)
+        {
+            return true;
+        }
+
+        const int* lengths = lengthsInput.template data<int>();
+        offsets_.ResizeLike(lengthsInput);
+        exclusive_scan(lengths, M);
+
+        // Narrow rows get a narrower lane group, so that a wavefront reduces
+        // several segments at once instead of idling most of its lanes.
+        const int warp_size = GetDeviceProperty(CaffeHipGetDevice()).warpSize;
+        int lanes           = 1;
+        while(lanes < D && lanes < warp_size)
+        {
+            lanes *= 2;
+        }
+        const int segments_per_block = kReductionThreads / lanes;
+        const int blocks = (M + segments_per_block - 1) / segments_per_block;
+
+        hipLaunchKernelGGL(
+            (sparse_lengths_reduction_kernel<InputType, IndexType, USE_WEIGHT, USE_MEAN>),
+            dim3(blocks),
+            dim3(lanes, segments_per_block),
+            0,
+            context_.hip_stream(),
+            dataInput.template data<InputType>(),
+            in_weight,
+            indicesInput.template data<IndexType>(),
+            offsets_.template data<int>(),
+            lengths,
+            out_data,
+            static_cast<int>(N),
+            D,
+            static_cast<int>(M));
+        return true;
+    }
+
+    protected:
+    void exclusive_scan(const int* lengths, int len)
+    {
+        size_t temp_storage_bytes = 0;
+        hipcub::DeviceScan::ExclusiveSum(NULL,
+                                         temp_storage_bytes,
+                                         lengths,
+                                         offsets_.template mutable_data<int>(),
+                                         len,
+                                         context_.hip_stream());
+        scan_buffer_.Resize((temp_storage_bytes + sizeof(int)) / sizeof(int));
+        hipcub::DeviceScan::ExclusiveSum(
+            static_cast<void*>(scan_buffer_.template mutable_data<int>()),
+            temp_storage_bytes,
+            lengths,
+            offsets_.template mutable_data<int>(),
+            len,
+            context_.hip_stream());
+    }
+
+    enum
+    {
+        DATA    = 0,              // Data input.
+        WEIGHT  = 1,              // Weight input used in SparseLengthsWeightedSum
+        INDICES = 1 + USE_WEIGHT, // 1 in SparseLengths[Sum,Mean] and
+                                  // 2 in SparseLengthsWeightedSum
+        LENGTHS = 2 + USE_WEIGHT, // 2 in SparseLengths[Sum, Mean],
+                                  // 3 in SparseLengthsWeightedSum
+    };
+
+    Tensor<HIPContext> offsets_;
+    Tensor<HIPContext> scan_buffer_;
+};
+
+// MANAGED engine of SparseLengths[Sum,WeightedSum,Mean], for tables in managed
+// memory (see CopyToManaged) that can be larger than the device memory. The
+// lookups are those of the default engine; on top of them the op counts how
+// often every block of cache_block_bytes of the table is used, and every
+// cache_refresh_interval runs moves the cache_bytes worth of most used blocks
+// to the device and the blocks that fell out of them back to the host. The
+// counts are halved at every refresh, so that this is an LFU cache with aging.
+// Rows outside of the cache are read from the host over the link. Only one op
+// per table should use the engine, as each keeps its own idea of the cache.
+template <typename T, class InputTypes, bool USE_WEIGHT = 0, bool USE_MEAN = 0>
+class HIPManagedSparseLengthsReductionOp
+    : public HIPSparseLengthsReductionOp<T, InputTypes, USE_WEIGHT, USE_MEAN>
+{
+    public:
+    using Base = HIPSparseLengthsReductionOp<T, InputTypes, USE_WEIGHT, USE_MEAN>;
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPManagedSparseLengthsReductionOp(const OperatorDef& operator_def, Workspace* ws)
+        : Base(operator_def, ws),
+          cache_bytes_(OperatorBase::GetSingleArgument<int64_t>("cache_bytes", 0)),
+          block_bytes_(OperatorBase::GetSingleArgument<int64_t>("cache_block_bytes", 1 << 16)),
+          refresh_interval_(OperatorBase::GetSingleArgument<int>("cache_refresh_interval", 16))
+    {
+        CAFFE_ENFORCE_GT(block_bytes_, 0);
+        CAFFE_ENFORCE_EQ(block_bytes_ % 4096, 0, "cache_block_bytes must be a multiple of pages.");
+        CAFFE_ENFORCE_GT(refresh_interval_, 0);
+        if(cache_bytes_ == 0)
+        {
+            // Leave most of the device memory to the activations by default.
+            cache_bytes_ = GetDeviceProperty(context_.hip_gpu_id()).totalGlobalMem / 4;
+        }
+    }
+
+    bool RunOnDevice() override
+    {
+        if(!Base::RunOnDevice())
+        {
+            return false;
+        }
+        return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(this, Input(Base::INDICES));
+    }
+
+    template <typename IndexType>
+    bool DoRunWithType()
+    {
+        auto& dataInput    = Input(Base::DATA);
+        auto& indicesInput = Input(Base::INDICES);
+        if(dataInput.nbytes() == 0)
+        {
+            return true;
+        }
+        if(dataInput.raw_data() != table_ || dataInput.nbytes() != table_bytes_)
+        {
+            ResetCache(dataInput);
+        }
+        const int n = indicesInput.size();
+        if(n > 0)
+        {
+            hipLaunchKernelGGL((managed_block_count_kernel<IndexType>),
+                               dim3(CAFFE_GET_BLOCKS(n)),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context_.hip_stream(),
+                               indicesInput.template data<IndexType>(),
+                               n,
+                               static_cast<int64_t>(dataInput.nbytes() / dataInput.dim(0)),
+                               block_bytes_,
+                               counts_.template mutable_data<int>());
+        }
+        if(++runs_ % refresh_interval_ == 0)
+        {
+            Refresh();
+        }
+        return true;
+    }
+
+    private:
+    void ResetCache(const Tensor<HIPContext>& table)
+    {
+        hipPointerAttribute_t attributes;
+        HIP_ENFORCE(hipPointerGetAttributes(&attributes, table.raw_data()));
+        CAFFE_ENFORCE(attributes.isManaged,
+                      "The MANAGED engine needs a table in managed memory, see CopyToManaged.");
+        table_       = table.raw_data();
+        table_bytes_ = table.nbytes();
+        const TIndex num_blocks = (table_bytes_ + block_bytes_ - 1) / block_bytes_;
+        counts_.Resize(num_blocks);
+        math::Set<int, HIPContext>(
+            num_blocks, 0, counts_.template mutable_data<int>(), &context_);
+        cached_.assign(num_blocks, false);
+        runs_ = 0;
+    }
+
+    // Picks the most used blocks that fit in cache_bytes and migrates the
+    // blocks that enter or leave them. Ties are won by the blocks already on
+    // the device, so that blocks of equal counts do not keep swapping.
+    void Refresh()
+    {
+        const int gpu        = context_.hip_gpu_id();
+        const int num_blocks = counts_.size();
+        host_counts_.Resize(num_blocks);
+        context_.template Copy<int, HIPContext, CPUContext>(
+            num_blocks, counts_.template data<int>(), host_counts_.template mutable_data<int>());
+        hipLaunchKernelGGL(managed_block_decay_kernel,
+                           dim3(CAFFE_GET_BLOCKS(num_blocks)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           num_blocks,
+                           counts_.template mutable_data<int>());
+        context_.FinishDeviceComputation();
+        const int* counts = host_counts_.template data<int>();
+
+        std::vector<int> candidates;
+        for(int block = 0; block < num_blocks; ++block)
+        {
+            if(counts[block] > 0 || cached_[block])
+            {
+                candidates.push_back(block);
+            }
+        }
+        const size_t capacity = std::min<size_t>(candidates.size(), cache_bytes_ / block_bytes_);
+        auto hotter           = [&](int a, int b) {
+            return counts[a] != counts[b] ? counts[a] > counts[b] : cached_[a] > cached_[b];
+        };
+        std::nth_element(
+            candidates.begin(), candidates.begin() + capacity, candidates.end(), hotter);
+
+        char* table = static_cast<char*>(const_cast<void*>(table_));
+        auto migrate = [&](int block, int device) {
+            const size_t offset = static_cast<size_t>(block) * block_bytes_;
+            const size_t bytes  = std::min<size_t>(block_bytes_, table_bytes_ - offset);
+            HIP_ENFORCE(hipMemAdvise(
+                table + offset, bytes, hipMemAdviseSetPreferredLocation, device));
+            HIP_ENFORCE(hipMemPrefetchAsync(table + offset, bytes, device, context_.hip_stream()));
+        };
+        for(size_t i = capacity; i < candidates.size(); ++i)
+        {
+            if(cached_[candidates[i]])
+            {
+                migrate(candidates[i], hipCpuDeviceId);
+                cached_[candidates[i]] = false;
+            }
+        }
+        for(size_t i = 0; i < capacity; ++i)
+        {
+            if(!cached_[candidates[i]])
+            {
+                migrate(candidates[i], gpu);
+                cached_[candidates[i]] = true;
+            }
+        }
+    }
+
+    int64_t cache_bytes_;
+    int64_t block_bytes_;
+    int refresh_interval_;
+    int64_t runs_ = 0;
+    const void* table_  = nullptr;
+    size_t table_bytes_ = 0;
+    std::vector<bool> cached_;
+    Tensor<HIPContext> counts_;
+    TensorCPU host_counts_;
+};
+
+REGISTER_HIP_OPERATOR_STR(
+    "SparseLengthsSum",
+    HIPSparseLengthsReductionOp<float, TensorTypes<float, float16>, 0, 0>);
+REGISTER_HIP_OPERATOR_STR(
+    "SparseLengthsWeightedSum",
+    HIPSparseLengthsReductionOp<float, TensorTypes<float, float16>, 1, 0>);
+REGISTER_HIP_OPERATOR_STR(
+    "SparseLengthsMean",
+    HIPSparseLengthsReductionOp<float, TensorTypes<float, float16>, 0, 1>);
+
+REGISTER_HIP_OPERATOR_WITH_ENGINE(
+    SparseLengthsSum,
+    MANAGED,
+    HIPManagedSparseLengthsReductionOp<float, TensorTypes<float, float16>, 0, 0>);
+REGISTER_HIP_OPERATOR_WITH_ENGINE(
+    SparseLengthsWeightedSum,
+    MANAGED,
+    HIPManagedSparseLengthsReductionOp<float, TensorTypes<float, float16>, 1, 0>);
+REGISTER_HIP_OPERATOR_WITH_ENGINE(
+    SparseLengthsMean,
+    MANAGED,
+    HIPManagedSparseLengthsReductionOp<float, TensorTypes<float, float16>, 0, 1>);
+
+} // namespace caffe2
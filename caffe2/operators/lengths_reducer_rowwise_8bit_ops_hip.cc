@@ -0,0 +1,300 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <hipcub/hipcub.hpp>
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/operator.h"
+#include "hip/hip_runtime.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Threads per block of the reduction kernel, as in lengths_reducer_ops_hip.cc.
+constexpr int kReductionThreads = 256;
+
+// Rows of a multiple of kVec bytes are read kVec bytes at a time.
+constexpr int kVec = 4;
+
+template <int N>
+struct alignas(N) PackedBytes
+{
+    uint8_t val[N];
+};
+
+// Fused dequantization and reduction: out[segment] = sum of
+// w * (scale * q + bias) over the rows of the segment, where scale and bias
+// are those of the row, and w is its weight or 1. One group of hipBlockDim_x
+// lanes reduces one segment, each lane taking N consecutive columns at a
+// time, and the sums are kept in float.
+template <typename IndexType, bool USE_WEIGHTS, bool USE_MEAN, int N>
+__global__ void sparse_lengths_8bits_rowwise_kernel(const uint8_t* __restrict__ in,
+                                                    const float* __restrict__ weights,
+                                                    const IndexType* __restrict__ indices,
+                                                    const int* __restrict__ offsets,
+                                                    const int* __restrict__ lengths,
+                                                    const float* __restrict__ scale_bias,
+                                                    float* __restrict__ out,
+                                                    int num_rows,
+                                                    int D,
+                                                    int M)
+{
+    const int segment = hipBlockIdx_x * hipBlockDim_y + hipThreadIdx_y;
+    if(segment >= M)
+    {
+        return;
+    }
+
+    const int start = offsets[segment];
+    const int end   = start + lengths[segment];
+    const float mean_scale =
+        (USE_MEAN && end > start) ? 1.0f / static_cast<float>(end - start) : 1.0f;
+
+    for(int col = hipThreadIdx_x * N; col < D; col += hipBlockDim_x * N)
+    {
+        float sum[N];
+#pragma unroll
+        for(int j = 0; j < N; ++j)
+        {
+            sum[j] = 0.0f;
+        }
+        for(int line = start; line < end; ++line)
+        {
+            const IndexType idx = indices[line];
+            HIP_KERNEL_ASSERT(idx >= 0 && idx < num_rows);
+            const float w     = USE_WEIGHTS ? weights[line] : 1.0f;
+            const float scale = w * scale_bias[2 * idx];
+            const float bias  = w * scale_bias[2 * idx + 1];
+            const PackedBytes<N> q =
+                *reinterpret_cast<const PackedBytes<N>*>(in + static_cast<int64_t>(idx) * D + col);
+#pragma unroll
+            for(int j = 0; j < N; ++j)
+            {
+                sum[j] += scale * static_cast<float>(q.val[j]) + bias;
+            }
+        }
+#pragma unroll
+        for(int j = 0; j < N; ++j)
+        {
+            out[static_cast<int64_t>(segment) * D + col + j] = sum[j] * mean_scale;
+        }
+    }
+}
+
+__global__ void rowwise_8bit_dequantize_kernel(const int n,
+                                               const int D,
+                                               const uint8_t* __restrict__ in,
+                                               const float* __restrict__ scale_bias,
+                                               float* __restrict__ out)
+{
+    HIP_1D_KERNEL_LOOP(i, n)
+    {
+        const int row = i / D;
+        out[i]        = static_cast<float>(in[i]) * scale_bias[2 * row] + scale_bias[2 * row + 1];
+    }
+}
+
+} // namespace
+
+// HIP counterpart of SparseLengths8BitsRowwiseOp
+// (lengths_reducer_rowwise_8bit_ops.h). The table stays quantized in device
+// memory and is dequantized on the fly by the reduction kernel.
+template <bool USE_WEIGHTS = 0, bool USE_MEAN = 0>
+class HIPSparseLengths8BitsRowwiseOp : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    USE_SIMPLE_CTOR_DTOR(HIPSparseLengths8BitsRowwiseOp);
+
+    bool RunOnDevice() override
+    {
+        return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(this, Input(INDICES));
+    }
+
+    template <typename IndexType>
+    bool DoRunWithType()
+    {
+        auto& dataInput      = Input(DATA);
+        auto& indicesInput   = Input(INDICES);
+        auto& lengthsInput   = Input(LENGTHS);
+        auto& scaleBiasInput = Input(SCALE_BIAS);
+
+        CAFFE_ENFORCE_EQ(1, lengthsInput.ndim(), "LENGTHS must be a vector");
+        CAFFE_ENFORCE_EQ(1, indicesInput.ndim(), "INDICES must be a vector");
+        CAFFE_ENFORCE_EQ(2, scaleBiasInput.ndim(), "scale_bias has to be matrix");
+        CAFFE_ENFORCE_EQ(dataInput.dim(0),
+                         scaleBiasInput.dim(0),
+                         "scale_bias must have the same first dim as data");
+        CAFFE_ENFORCE_EQ(
+            2, scaleBiasInput.dim(1), "the second dim of scale_bias has to be equal to 2");
+        const TIndex N = dataInput.dim(0);
+        const int D    = dataInput.size_from_dim(1);
+        const TIndex M = lengthsInput.dim(0);
+
+        auto* output = Output(0);
+        auto shape   = dataInput.dims();
+        shape[0]     = M;
+        output->Resize(shape);
+        float* out_data = output->template mutable_data<float>();
+
+        const float* w = nullptr;
+        if(USE_WEIGHTS)
+        { // static if
+            auto& weightInput = Input(WEIGHTS);
+            CAFFE_ENFORCE_EQ(1, weightInput.ndim(), "WEIGHTS must be a vector");
+            CAFFE_ENFORCE_EQ(weightInput.size(),
+                             indicesInput.size(),
+                             "Weights should have the same length as indices.");
+            w = weightInput.template data<float>();
+        }
+
+        if(M == 0 || D == 0)
+        {
+            return true;
+        }
+
+        const int* lengths = lengthsInput.template data<int>();
+        offsets_.ResizeLike(lengthsInput);
+        size_t temp_storage_bytes = 0;
+        hipcub::DeviceScan::ExclusiveSum(NULL,
+                                         temp_storage_bytes,
+                                         lengths,
+                                         offsets_.template mutable_data<int>(),
+                                         M,
+                                         context_.hip_stream());
+        scan_buffer_.Resize((temp_storage_bytes + sizeof(int)) / sizeof(int));
+        hipcub::DeviceScan::ExclusiveSum(
+            static_cast<void*>(scan_buffer_.template mutable_data<int>()),
+            temp_storage_bytes,
+            lengths,
+            offsets_.template mutable_data<int>(),
+            M,
+            context_.hip_stream());
+
+        if(D % kVec == 0)
+        {
+            Launch<IndexType, kVec>(
+                dataInput, indicesInput, scaleBiasInput, lengths, w, out_data, N, D, M);
+        }
+        else
+        {
+            Launch<IndexType, 1>(
+                dataInput, indicesInput, scaleBiasInput, lengths, w, out_data, N, D, M);
+        }
+        return true;
+    }
+
+    private:
+    template <typename IndexType, int VEC>
+    void Launch(const Tensor<HIPContext>& dataInput,
+                const Tensor<HIPContext>& indicesInput,
+                const Tensor<HIPContext>& scaleBiasInput,
+                const int* lengths,
+                const float* w,
+                float* out_data,
+                TIndex N,
+                int D,
+                TIndex M)
+    {
+        // Narrow rows get a narrower lane group, as in the float reduction.
+        const int warp_size = GetDeviceProperty(CaffeHipGetDevice()).warpSize;
+        int lanes           = 1;
+        while(lanes * VEC < D && lanes < warp_size)
+        {
+            lanes *= 2;
+        }
+        const int segments_per_block = kReductionThreads / lanes;
+        const int blocks = (M + segments_per_block - 1) / segments_per_block;
+
+        hipLaunchKernelGGL(
+            (sparse_lengths_8bits_rowwise_kernel<IndexType, USE_WEIGHTS, USE_MEAN, VEC>),
+            dim3(blocks),
+            dim3(lanes, segments_per_block),
+            0,
+            context_.hip_stream(),
+            dataInput.template data<uint8_t>(),
+            w,
+            indicesInput.template data<IndexType>(),
+            offsets_.template data<int>(),
+            lengths,
+            scaleBiasInput.template data<float>(),
+            out_data,
+            static_cast<int>(N),
+            D,
+            static_cast<int>(M));
+    }
+
+    enum
+    {
+        DATA       = 0,
+        WEIGHTS    = 1,
+        INDICES    = 1 + USE_WEIGHTS,
+        LENGTHS    = 2 + USE_WEIGHTS,
+        SCALE_BIAS = 3 + USE_WEIGHTS
+    };
+
+    Tensor<HIPContext> offsets_;
+    Tensor<HIPContext> scan_buffer_;
+};
+
+class HIPRowwise8BitQuantizedToFloatOp : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    USE_SIMPLE_CTOR_DTOR(HIPRowwise8BitQuantizedToFloatOp);
+
+    bool RunOnDevice() override
+    {
+        auto& input      = Input(DATA_UINT8);
+        auto& scale_bias = Input(SCALE_BIAS);
+        auto* output     = Output(DATA_FLOAT);
+        CAFFE_ENFORCE_EQ(2, scale_bias.ndim(), "scale_bias has to be matrix");
+        CAFFE_ENFORCE_EQ(input.dim(0),
+                         scale_bias.dim(0),
+                         "scale_bias must have the same first dim as data");
+        CAFFE_ENFORCE_EQ(
+            2, scale_bias.dim(1), "the second dim of scale_bias has to be equal to 2");
+        output->ResizeLike(input);
+        const int n = input.size();
+        if(n == 0)
+        {
+            return true;
+        }
+        hipLaunchKernelGGL(rowwise_8bit_dequantize_kernel,
+                           dim3(CAFFE_GET_BLOCKS(n)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           n,
+                           static_cast<int>(input.size_from_dim(1)),
+                           input.template data<uint8_t>(),
+                           scale_bias.template data<float>(),
+                           output->template mutable_data<float>());
+        return true;
+    }
+
+    private:
+    INPUT_TAGS(DATA_UINT8, SCALE_BIAS);
+    OUTPUT_TAGS(DATA_FLOAT);
+};
+
+REGISTER_HIP_OPERATOR(Rowwise8BitQuantizedToFloat, HIPRowwise8BitQuantizedToFloatOp);
+REGISTER_HIP_OPERATOR(SparseLengthsSum8BitsRowwise, HIPSparseLengths8BitsRowwiseOp<>);
+REGISTER_HIP_OPERATOR(SparseLengthsWeightedSum8BitsRowwise, HIPSparseLengths8BitsRowwiseOp<1>);
+REGISTER_HIP_OPERATOR(SparseLengthsMean8BitsRowwise, HIPSparseLengths8BitsRowwiseOp<0, 1>);
+REGISTER_HIP_OPERATOR(SparseLengthsWeightedMean8BitsRowwise, HIPSparseLengths8BitsRowwiseOp<1, 1>);
+
+} // namespace caffe2
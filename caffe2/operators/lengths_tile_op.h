@@ -72,6 +72,9 @@ class LengthsTileOp : public Operator<Context> {
 
  private:
   TensorCPU lengths_host_;
+  // Row offsets of every tile, only used by the HIP implementation
+  TensorCPU offsets_host_;
+  Tensor<Context> offsets_;
 };
 
 } // namespace caffe2
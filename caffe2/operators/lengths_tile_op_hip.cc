@@ -18,5 +18,139 @@
 #include "caffe2/operators/lengths_tile_op.h"
 
 namespace caffe2 {
+
+namespace {
+// Each output item finds the input row it is tiled from by a binary search
+// over the exclusive prefix sum of the lengths, so consecutive threads write
+// consecutive items of the output.
+template <typename T>
+__global__ void LengthsTileKernel(const int N,
+                                  const int lengths_size,
+                                  const int block_size,
+                                  const int* offsets,
+                                  const T* data,
+                                  T* out)
+{
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        const int row = i / block_size;
+        int lo        = 0;
+        int hi        = lengths_size - 1;
+        // last segment whose offset is <= row; empty segments share offsets
+        // with the next one and are skipped by taking the rightmost match
+        while(lo < hi)
+        {
+            const int mid = (lo + hi + 1) / 2;
+            if(offsets[mid] <= row)
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid - 1;
+            }
+        }
+        out[i] = data[lo * block_size + i % block_size];
+    }
+}
+
+template <typename T>
+void LengthsTile(const int N,
+                 const int lengths_size,
+                 const int block_size,
+                 const int* offsets,
+                 const void* data,
+                 void* out,
+                 HIPContext* context)
+{
+    hipLaunchKernelGGL((LengthsTileKernel<T>),
+                       dim3(CAFFE_GET_BLOCKS(N)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context->hip_stream(),
+                       N,
+                       lengths_size,
+                       block_size,
+                       offsets,
+                       static_cast<const T*>(data),
+                       static_cast<T*>(out));
+}
+} // namespace
+
+template <>
+bool LengthsTileOp<HIPContext>::RunOnDevice()
+{
+    auto& data    = Input(DATA);
+    auto& lengths = Input(LENGTHS);
+    auto* output  = Output(0);
+
+    CAFFE_ENFORCE_EQ(lengths.ndim(), 1, "LENGTHS must be 1-D");
+    CAFFE_ENFORCE_GE(data.ndim(), 1, "DATA should be at least 1-D");
+    CAFFE_ENFORCE_EQ(lengths.size(), data.dim(0));
+    CAFFE_ENFORCE(data.meta().copy() == nullptr, "LengthsTile on HIP only supports POD data");
+
+    // The output size depends on the lengths, so they are read back once
+    lengths_host_.CopyFrom(lengths, &context_);
+    context_.FinishDeviceComputation();
+    const int lengths_size     = lengths_host_.size();
+    const int32_t* lengths_ptr = lengths_host_.data<int32_t>();
+
+    offsets_host_.Resize(lengths_size);
+    int* offsets_ptr     = offsets_host_.mutable_data<int>();
+    int32_t total_length = 0;
+    for(int i = 0; i < lengths_size; ++i)
+    {
+        CAFFE_ENFORCE_GE(lengths_ptr[i], 0);
+        offsets_ptr[i] = total_length;
+        total_length += lengths_ptr[i];
+    }
+
+    auto shape = data.dims();
+    shape[0]   = total_length;
+    output->Resize(shape);
+    void* out_ptr = output->raw_mutable_data(data.meta());
+    if(output->size() == 0)
+    {
+        return true;
+    }
+    offsets_.CopyFrom(offsets_host_, &context_);
+
+    // Items are copied in the widest unit that divides the row
+    const int row_bytes = data.size_from_dim(1) * data.meta().itemsize();
+    if(row_bytes % sizeof(uint64_t) == 0)
+    {
+        const int block_size = row_bytes / sizeof(uint64_t);
+        LengthsTile<uint64_t>(total_length * block_size,
+                              lengths_size,
+                              block_size,
+                              offsets_.data<int>(),
+                              data.raw_data(),
+                              out_ptr,
+                              &context_);
+    }
+    else if(row_bytes % sizeof(uint32_t) == 0)
+    {
+        const int block_size = row_bytes / sizeof(uint32_t);
+        LengthsTile<uint32_t>(total_length * block_size,
+                              lengths_size,
+                              block_size,
+                              offsets_.data<int>(),
+                              data.raw_data(),
+                              out_ptr,
+                              &context_);
+    }
+    else
+    {
+        LengthsTile<uint8_t>(total_length * row_bytes,
+                             lengths_size,
+                             row_bytes,
+                             offsets_.data<int>(),
+                             data.raw_data(),
+                             out_ptr,
+                             &context_);
+    }
+    return true;
+}
+
 REGISTER_HIP_OPERATOR(LengthsTile, LengthsTileOp<HIPContext>);
 } // namespace caffe2
@@ -0,0 +1,204 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/lengths_top_k_op.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/top_k_hip.h"
+
+namespace caffe2 {
+
+namespace {
+
+// One block per segment. Segments shorter than k are padded with value 0 and
+// index -1, like on the CPU.
+__global__ void LengthsTopKGatherKernel(const int k,
+                                        const int* offsets,
+                                        const float* sorted_keys,
+                                        const int* sorted_indices,
+                                        float* values,
+                                        int* indices)
+{
+    const int row    = hipBlockIdx_x;
+    const int offset = offsets[row];
+    const int length = offsets[row + 1] - offset;
+    for(int j = hipThreadIdx_x; j < k; j += hipBlockDim_x)
+    {
+        if(j < length)
+        {
+            values[row * k + j]  = sorted_keys[offset + j];
+            indices[row * k + j] = sorted_indices[offset + j] - offset;
+        }
+        else
+        {
+            values[row * k + j]  = 0;
+            indices[row * k + j] = -1;
+        }
+    }
+}
+
+__global__ void LengthsTopKScatterKernel(const int k,
+                                         const int num_indices,
+                                         const int* offsets,
+                                         const int* indices,
+                                         const float* dY,
+                                         float* dX)
+{
+    const int row    = hipBlockIdx_x;
+    const int offset = offsets[row];
+    const int length = min(offsets[row + 1] - offset, k);
+    for(int j = hipThreadIdx_x; j < length; j += hipBlockDim_x)
+    {
+        const int index = offset + indices[row * k + j];
+        if(index < num_indices)
+        {
+            dX[index] = dY[row * k + j];
+        }
+    }
+}
+
+} // namespace
+
+template <>
+class LengthsTopKOp<float, HIPContext> : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+
+    LengthsTopKOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws), OP_SINGLE_ARG(int, "k", k_, -1)
+    {
+        CAFFE_ENFORCE_GE(k_, 1, "k argument must be >= 1");
+    }
+
+    bool RunOnDevice() override
+    {
+        auto& X                   = Input(X_IN);
+        auto& Y                   = Input(Y_IN);
+        auto* output_topk_values  = Output(TOPK_VALUES_OUT);
+        auto* output_topk_indices = Output(TOPK_INDICES_OUT);
+        const int N               = Y.dim32(0);
+
+        output_topk_values->Resize(N, k_);
+        output_topk_indices->Resize(N, k_);
+        float* output_topk_values_data = output_topk_values->mutable_data<float>();
+        int* output_topk_indices_data  = output_topk_indices->mutable_data<int>();
+        if(N == 0)
+        {
+            return true;
+        }
+
+        offsets_.Resize(N + 1);
+        TopKLengthsToOffsets<int>(
+            N, Y.data<int>(), offsets_.mutable_data<int>(), &scan_scratch_, &context_);
+        sorted_keys_.ResizeLike(X);
+        sorted_indices_.ResizeLike(X);
+        SegmentedSortDescending(X.size(),
+                                N,
+                                X.data<float>(),
+                                offsets_.data<int>(),
+                                sorted_keys_.mutable_data<float>(),
+                                sorted_indices_.mutable_data<int>(),
+                                &sort_scratch_,
+                                &context_);
+        hipLaunchKernelGGL((LengthsTopKGatherKernel),
+                           dim3(N),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           k_,
+                           offsets_.data<int>(),
+                           sorted_keys_.data<float>(),
+                           sorted_indices_.data<int>(),
+                           output_topk_values_data,
+                           output_topk_indices_data);
+        return true;
+    }
+
+    private:
+    int k_;
+    Tensor<HIPContext> offsets_;
+    Tensor<HIPContext> sorted_keys_;
+    Tensor<HIPContext> sorted_indices_;
+    Tensor<HIPContext> scan_scratch_;
+    Tensor<HIPContext> sort_scratch_;
+    INPUT_TAGS(X_IN, Y_IN);
+    OUTPUT_TAGS(TOPK_VALUES_OUT, TOPK_INDICES_OUT);
+};
+
+template <>
+class LengthsTopKGradientOp<float, HIPContext> : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+
+    LengthsTopKGradientOp(const OperatorDef& def, Workspace* ws)
+        : Operator<HIPContext>(def, ws), OP_SINGLE_ARG(int, "k", k_, -1)
+    {
+        CAFFE_ENFORCE_GE(k_, 1, "k argument must be >= 1");
+    }
+
+    bool RunOnDevice() override
+    {
+        auto& input_len     = Input(LENGTH_IN);
+        auto& input_indices = Input(INDICES_IN);
+        auto& input_topk    = Input(DER_TOPK_IN);
+        auto* X_out         = Output(DER_X_OUT);
+        const int N         = input_len.size();
+        CAFFE_ENFORCE_GE(input_indices.ndim(), 2, "input dim must be >= 2");
+        CAFFE_ENFORCE_EQ(input_indices.size(), N * k_, "input_indices shape is not correct");
+        CAFFE_ENFORCE_EQ(input_topk.size(), N * k_, "input_topk shape is not correct");
+
+        offsets_.Resize(N + 1);
+        TopKLengthsToOffsets<int>(
+            N, input_len.data<int>(), offsets_.mutable_data<int>(), &scratch_, &context_);
+        // Only the total length is needed on the host, to size the output.
+        int num_indices = 0;
+        context_.Copy<int, HIPContext, CPUContext>(1, offsets_.data<int>() + N, &num_indices);
+        context_.FinishDeviceComputation();
+
+        X_out->Resize(num_indices);
+        float* X_out_data = X_out->mutable_data<float>();
+        math::Set<float, HIPContext>(num_indices, 0.0f, X_out_data, &context_);
+        if(N == 0)
+        {
+            return true;
+        }
+        hipLaunchKernelGGL((LengthsTopKScatterKernel),
+                           dim3(N),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           k_,
+                           num_indices,
+                           offsets_.data<int>(),
+                           input_indices.data<int>(),
+                           input_topk.data<float>(),
+                           X_out_data);
+        return true;
+    }
+
+    private:
+    int k_;
+    Tensor<HIPContext> offsets_;
+    Tensor<HIPContext> scratch_;
+    INPUT_TAGS(LENGTH_IN, INDICES_IN, DER_TOPK_IN);
+    OUTPUT_TAGS(DER_X_OUT);
+};
+
+REGISTER_HIP_OPERATOR(LengthsTopK, LengthsTopKOp<float, HIPContext>);
+REGISTER_HIP_OPERATOR(LengthsTopKGradient, LengthsTopKGradientOp<float, HIPContext>);
+
+} // namespace caffe2
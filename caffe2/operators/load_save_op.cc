@@ -123,7 +123,17 @@ db specified by the arguments.
         "(list of strings) if set, used instead of original "
         "blob names. Must be the same length as number of blobs.")
     .Arg("db", "(string) the path to the db to load.")
-    .Arg("db_type", "(string) the type of the db.");
+    .Arg("db_type", "(string) the type of the db.")
+    .Arg(
+        "num_threads",
+        "(int, default 1) number of blobs that are serialized at the same "
+        "time. Chunks are written to the db as soon as they are serialized.")
+    .Arg(
+        "async_save",
+        "(int, default 0) if set, the op copies its inputs on their device "
+        "and returns, and the copies are written in the background. The next "
+        "run of the op waits for the previous save to finish. This costs an "
+        "extra copy of the saved blobs in memory.");
 
 OPERATOR_SCHEMA(Checkpoint)
     .NumInputs(1, INT_MAX)
@@ -17,8 +17,11 @@
 #ifndef CAFFE2_OPERATORS_LOAD_SAVE_OP_H_
 #define CAFFE2_OPERATORS_LOAD_SAVE_OP_H_
 
+#include <atomic>
 #include <cstdio>
+#include <future>
 #include <map>
+#include <mutex>
 #include <unordered_set>
 
 #include "caffe2/core/blob_serialization.h"
@@ -434,8 +437,11 @@ class SaveOp final : public Operator<Context> {
         db_name_(OperatorBase::GetSingleArgument<string>("db", "")),
         db_type_(OperatorBase::GetSingleArgument<string>("db_type", "")),
         blob_names_(
-            OperatorBase::GetRepeatedArgument<string>("blob_name_overrides")) {
+            OperatorBase::GetRepeatedArgument<string>("blob_name_overrides")),
+        num_threads_(OperatorBase::GetSingleArgument<int>("num_threads", 1)),
+        async_save_(OperatorBase::GetSingleArgument<int>("async_save", 0)) {
     CAFFE_ENFORCE_GT(db_name_.size(), 0, "Must specify a db name.");
+    CAFFE_ENFORCE_GT(num_threads_, 0, "num_threads should be positive.");
     CAFFE_ENFORCE_GT(db_type_.size(), 0, "Must specify a db type.");
     CAFFE_ENFORCE(
         blob_names_.empty() ||
@@ -468,16 +474,76 @@ class SaveOp final : public Operator<Context> {
     }
   }
 
+  ~SaveOp() {
+    if (pending_save_.valid()) {
+      try {
+        pending_save_.get();
+      } catch (const std::exception& e) {
+        LOG(ERROR) << "Asynchronous save to " << db_name_
+                   << " failed: " << e.what();
+      }
+    }
+  }
+
   bool RunOnDevice() override {
+    // A save still running from the previous run has to finish first, so
+    // that its db is complete and an error it hit is not lost.
+    if (pending_save_.valid()) {
+      pending_save_.get();
+    }
     string full_db_name =
         absolute_path_ ? db_name_ : (ws_->RootFolder() + "/" + db_name_);
+    if (!async_save_) {
+      SaveBlobs(full_db_name, OperatorBase::Inputs(), {});
+      return true;
+    }
+
+    // Snapshot the inputs, so that they can be changed again as soon as the
+    // op returns. Tensors are copied on their own device, which is much
+    // faster than serializing them; other blobs are serialized right away.
+    const vector<const Blob*>& inputs = OperatorBase::Inputs();
+    snapshot_.resize(inputs.size());
+    vector<const Blob*> blobs(inputs.size());
+    vector<string> serialized(inputs.size());
+    for (int i = 0; i < inputs.size(); ++i) {
+      if (inputs[i]->template IsType<Tensor<Context>>()) {
+        snapshot_[i].template GetMutable<Tensor<Context>>()->CopyFrom(
+            inputs[i]->template Get<Tensor<Context>>(), &context_);
+        blobs[i] = &snapshot_[i];
+      } else if (inputs[i]->template IsType<TensorCPU>()) {
+        snapshot_[i].template GetMutable<TensorCPU>()->CopyFrom(
+            inputs[i]->template Get<TensorCPU>(), &context_);
+        blobs[i] = &snapshot_[i];
+      } else {
+        serialized[i] = inputs[i]->Serialize(blob_names_[i]);
+      }
+    }
+    context_.FinishDeviceComputation();
+    pending_save_ = std::async(
+        std::launch::async,
+        [this, full_db_name, blobs, serialized]() {
+          SaveBlobs(full_db_name, blobs, serialized);
+        });
+    return true;
+  }
+
+ private:
+  // Writes blobs[i] to the db, or serialized[i] for the blobs that are null.
+  // With num_threads_ > 1 several blobs are serialized at once, and every
+  // chunk is written as soon as it is ready.
+  void SaveBlobs(
+      const string& full_db_name,
+      const vector<const Blob*>& blobs,
+      const vector<string>& serialized) {
     std::unique_ptr<DB> out_db(
         caffe2::db::CreateDB(db_type_, full_db_name, caffe2::db::NEW));
     CAFFE_ENFORCE(out_db.get(), "Cannot open db for writing: ", full_db_name);
 
+    std::mutex db_mutex;
     BlobSerializerBase::SerializationAcceptor acceptor = [&](
         const std::string& blobName, const std::string& data) {
-      // transaction should take care of locking
+      // Not every db can take concurrent transactions.
+      std::lock_guard<std::mutex> guard(db_mutex);
       VLOG(2) << "Sending " << blobName << " blob's data of size "
               << data.size() << " to db";
       auto transaction = out_db->NewTransaction();
@@ -485,21 +551,39 @@ class SaveOp final : public Operator<Context> {
       transaction->Commit();
     };
 
-    const vector<const Blob*>& inputs = OperatorBase::Inputs();
-    for (int i = 0; i < inputs.size(); ++i) {
-      inputs[i]->Serialize(blob_names_[i], acceptor);
+    std::atomic<int> next_blob(0);
+    auto save_next_blobs = [&]() {
+      for (int i = next_blob++; i < blobs.size(); i = next_blob++) {
+        if (blobs[i]) {
+          blobs[i]->Serialize(blob_names_[i], acceptor);
+        } else {
+          acceptor(blob_names_[i], serialized[i]);
+        }
+      }
+    };
+    const int num_threads = std::min<int>(num_threads_, blobs.size());
+    std::vector<std::future<void>> futures;
+    for (int i = 1; i < num_threads; ++i) {
+      futures.emplace_back(std::async(std::launch::async, save_next_blobs));
+    }
+    save_next_blobs();
+    for (auto& future : futures) {
+      future.get();
     }
     out_db->Close();
-    return true;
   }
 
- private:
   Workspace* ws_;
   bool absolute_path_;
   string strip_prefix_;
   string db_name_;
   string db_type_;
   std::vector<std::string> blob_names_;
+  int num_threads_;
+  bool async_save_;
+  // The copies of the inputs the asynchronous save is writing.
+  vector<Blob> snapshot_;
+  std::future<void> pending_save_;
 };
 
 template <typename... Ts>
@@ -556,8 +640,10 @@ class CheckpointOp final : public Operator<Context> {
     if (iter % every_ == 0) {
       GetMutableArgument("db", true, &save_op_def_)
           ->set_s(FormatString(db_pattern_, iter));
-      SaveOp<Context> sub_op(save_op_def_, ws_);
-      return sub_op.Run();
+      // The op is kept until the next checkpoint, so that an asynchronous
+      // save can outlive this run.
+      save_op_.reset(new SaveOp<Context>(save_op_def_, ws_));
+      return save_op_->Run();
     } else {
       return true;
     }
@@ -568,6 +654,7 @@ class CheckpointOp final : public Operator<Context> {
   int every_;
   Workspace* ws_;
   OperatorDef save_op_def_;
+  std::unique_ptr<SaveOp<Context>> save_op_;
 };
 
 } // namespace caffe2
@@ -33,12 +33,12 @@ bool LRNOp<float, CPUContext>::RunOnDeviceWithOrderNCHW() {
   Y->ResizeLike(X);
   float* Ydata = Y->mutable_data<float>();
 
+  ScratchArena<CPUContext>::Buffer local_scale;
   if (OutputSize() > 1) {
     scale_ = Output(1);
   } else {
-    if (!scale_) {
-      scale_ = &local_scale_tensor_;
-    }
+    local_scale = context_.scratch_arena()->Borrow();
+    scale_ = local_scale.get();
   }
   scale_->ResizeLike(X);
   float* scale_data = scale_->mutable_data<float>();
@@ -98,12 +98,12 @@ bool LRNOp<float, CPUContext>::RunOnDeviceWithOrderNHWC() {
   Y->ResizeLike(X);
   float* Ydata = Y->mutable_data<float>();
 
+  ScratchArena<CPUContext>::Buffer local_scale;
   if (OutputSize() > 1) {
     scale_ = Output(1);
   } else {
-    if (!scale_) {
-      scale_ = &local_scale_tensor_;
-    }
+    local_scale = context_.scratch_arena()->Borrow();
+    scale_ = local_scale.get();
   }
   scale_->ResizeLike(X);
   float* scale_data = scale_->mutable_data<float>();
@@ -155,9 +155,8 @@ bool LRNGradientOp<float, CPUContext>::RunOnDeviceWithOrderNCHW() {
 
   const float* Xdata = X.data<float>();
   const float* Ydata = Y.data<float>();
-  if (!scale_) {
-    scale_ = &local_scale_tensor_;
-  }
+  auto local_scale = context_.scratch_arena()->Borrow();
+  scale_ = local_scale.get();
   scale_->ResizeLike(X);
   float* scale_data = scale_->mutable_data<float>();
   const float* dYdata = dY.data<float>();
@@ -258,9 +257,8 @@ bool LRNGradientOp<float, CPUContext>::RunOnDeviceWithOrderNHWC() {
   DCHECK_EQ(X.size(), Y.size());
   DCHECK_EQ(X.size(), dY.size());
   dX->ResizeLike(X);
-  if (!scale_) {
-    scale_ = &local_scale_tensor_;
-  }
+  auto local_scale = context_.scratch_arena()->Borrow();
+  scale_ = local_scale.get();
   scale_->ResizeLike(X);
   TensorCPU padded_ratio(vector<TIndex>(1, C + size_ - 1));
   float* padded_ratio_data = padded_ratio.mutable_data<float>();
@@ -319,7 +317,12 @@ bool LRNGradientOp<float, CPUContext>::RunOnDeviceWithOrderNHWC() {
 REGISTER_CPU_OPERATOR(LRN, LRNOp<float, CPUContext>);
 REGISTER_CPU_OPERATOR(LRNGradient, LRNGradientOp<float, CPUContext>);
 
-OPERATOR_SCHEMA(LRN).NumInputs(1).NumOutputs(1,2);
+// The running sum over the channel window makes the cost independent of the
+// size of the window.
+OPERATOR_SCHEMA(LRN)
+    .NumInputs(1)
+    .NumOutputs(1, 2)
+    .CostInferenceFunction(PointwiseCostInference<6>);
 OPERATOR_SCHEMA(LRNGradient).NumInputs(3).NumOutputs(1);
 
 class GetLRNGradient : public GradientMakerBase {
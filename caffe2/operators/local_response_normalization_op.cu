@@ -203,12 +203,12 @@ bool LRNOp<float, CUDAContext>::RunOnDeviceWithOrderNCHW() {
   const float* Xdata = X.data<float>();
   Y->ResizeLike(X);
   float* Ydata = Y->mutable_data<float>();
+  ScratchArena<CUDAContext>::Buffer local_scale;
   if (OutputSize() > 1) {
     scale_ = Output(1);
   } else {
-    if (!scale_) {
-      scale_ = &local_scale_tensor_;
-    }
+    local_scale = context_.scratch_arena()->Borrow();
+    scale_ = local_scale.get();
   }
   scale_->ResizeLike(X);
   float* scale_data = scale_->mutable_data<float>();
@@ -236,12 +236,12 @@ bool LRNOp<float, CUDAContext>::RunOnDeviceWithOrderNHWC() {
   const float* Xdata = X.data<float>();
   Y->ResizeLike(X);
   float* Ydata = Y->mutable_data<float>();
+  ScratchArena<CUDAContext>::Buffer local_scale;
   if (OutputSize() > 1) {
     scale_ = Output(1);
   } else {
-    if (!scale_) {
-      scale_ = &local_scale_tensor_;
-    }
+    local_scale = context_.scratch_arena()->Borrow();
+    scale_ = local_scale.get();
   }
   scale_->ResizeLike(X);
   float* scale_data = scale_->mutable_data<float>();
@@ -275,9 +275,8 @@ bool LRNGradientOp<float, CUDAContext>::RunOnDeviceWithOrderNCHW() {
 
   const float* Xdata = X.data<float>();
   const float* Ydata = Y.data<float>();
-  if (!scale_) {
-    scale_ = &local_scale_tensor_;
-  }
+  auto local_scale = context_.scratch_arena()->Borrow();
+  scale_ = local_scale.get();
   scale_->ResizeLike(X);
   float* scale_data = scale_->mutable_data<float>();
   int n_threads = N * H * W;
@@ -312,9 +311,8 @@ bool LRNGradientOp<float, CUDAContext>::RunOnDeviceWithOrderNHWC() {
   DCHECK_EQ(X.size(), Y.size());
   DCHECK_EQ(X.size(), dY.size());
   dX->ResizeLike(X);
-  if (!scale_) {
-    scale_ = &local_scale_tensor_;
-  }
+  auto local_scale = context_.scratch_arena()->Borrow();
+  scale_ = local_scale.get();
   scale_->ResizeLike(X);
 
   float* scale_data = scale_->mutable_data<float>();
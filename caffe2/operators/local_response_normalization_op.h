@@ -20,6 +20,7 @@
 #include "caffe2/core/context.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/core/scratch_arena.h"
 #include "caffe2/utils/math.h"
 
 namespace caffe2 {
@@ -83,7 +84,6 @@ class LRNOp final : public LRNOpBase<T, Context> {
   // Input: X; Output: Y, scale.
   OUTPUT_TAGS(OUTPUT, SCALE);
   Tensor<Context>* scale_ = nullptr;
-  Tensor<Context> local_scale_tensor_;
 };
 
 template <typename T, class Context>
@@ -100,7 +100,6 @@ class LRNGradientOp final : public LRNOpBase<T, Context> {
   // Input: X, Y, scale, dY; Output: dX
   INPUT_TAGS(INPUT, OUTPUT, SCALE, OUTPUT_GRAD);
   Tensor<Context>* scale_ = nullptr;
-  Tensor<Context> local_scale_tensor_;
 };
 
 } // namespace caffe2
@@ -253,16 +253,15 @@ bool LRNOp<float, HIPContext>::RunOnDeviceWithOrderNCHW()
     const float* Xdata = X.data<float>();
     Y->ResizeLike(X);
     float* Ydata = Y->mutable_data<float>();
+    ScratchArena<HIPContext>::Buffer local_scale;
     if(OutputSize() > 1)
     {
         scale_ = Output(1);
     }
     else
     {
-        if(!scale_)
-        {
-            scale_ = &local_scale_tensor_;
-        }
+        local_scale = context_.scratch_arena()->Borrow();
+        scale_      = local_scale.get();
     }
     scale_->ResizeLike(X);
     float* scale_data = scale_->mutable_data<float>();
@@ -310,16 +309,15 @@ bool LRNOp<float, HIPContext>::RunOnDeviceWithOrderNHWC()
     const float* Xdata = X.data<float>();
     Y->ResizeLike(X);
     float* Ydata = Y->mutable_data<float>();
+    ScratchArena<HIPContext>::Buffer local_scale;
     if(OutputSize() > 1)
     {
         scale_ = Output(1);
     }
     else
     {
-        if(!scale_)
-        {
-            scale_ = &local_scale_tensor_;
-        }
+        local_scale = context_.scratch_arena()->Borrow();
+        scale_      = local_scale.get();
     }
     scale_->ResizeLike(X);
     float* scale_data = scale_->mutable_data<float>();
@@ -373,10 +371,8 @@ bool LRNGradientOp<float, HIPContext>::RunOnDeviceWithOrderNCHW()
 
     const float* Xdata = X.data<float>();
     const float* Ydata = Y.data<float>();
-    if(!scale_)
-    {
-        scale_ = &local_scale_tensor_;
-    }
+    auto local_scale = context_.scratch_arena()->Borrow();
+    scale_           = local_scale.get();
     scale_->ResizeLike(X);
     float* scale_data = scale_->mutable_data<float>();
     int n_threads     = N * H * W;
@@ -437,10 +433,8 @@ bool LRNGradientOp<float, HIPContext>::RunOnDeviceWithOrderNHWC()
     DCHECK_EQ(X.size(), Y.size());
     DCHECK_EQ(X.size(), dY.size());
     dX->ResizeLike(X);
-    if(!scale_)
-    {
-        scale_ = &local_scale_tensor_;
-    }
+    auto local_scale = context_.scratch_arena()->Borrow();
+    scale_           = local_scale.get();
     scale_->ResizeLike(X);
 
     float* scale_data = scale_->mutable_data<float>();
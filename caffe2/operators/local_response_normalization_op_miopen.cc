@@ -77,9 +77,7 @@ class MIOPENLRNGradientOp final : public Operator<HIPContext>
           alpha_(OperatorBase::GetSingleArgument<float>("alpha", 0)),
           beta_(OperatorBase::GetSingleArgument<float>("beta", 0)),
           bias_(OperatorBase::GetSingleArgument<float>("bias", 1)),
-          do_backward_(OperatorBase::GetSingleArgument<bool>("do_backward", false)),
-          bwdLRNWs_(nullptr),
-          LRNBwdScratch(nullptr)
+          do_backward_(OperatorBase::GetSingleArgument<bool>("do_backward", false))
     {
         MIOPEN_ENFORCE(miopenCreateTensorDescriptor(&data_desc_));
         MIOPEN_ENFORCE(miopenCreateLRNDescriptor(&norm_desc_));
@@ -90,17 +88,6 @@ class MIOPENLRNGradientOp final : public Operator<HIPContext>
     {
         MIOPEN_ENFORCE(miopenDestroyTensorDescriptor(data_desc_));
         MIOPEN_ENFORCE(miopenDestroyLRNDescriptor(norm_desc_));
-
-        if(bwdLRNWs_)
-        {
-            hipFree(bwdLRNWs_);
-            bwdLRNWs_ = nullptr;
-        }
-        if(LRNBwdScratch)
-        {
-            hipFree(LRNBwdScratch);
-            LRNBwdScratch = nullptr;
-        }
     }
 
     template <typename T, typename M>
@@ -120,8 +107,8 @@ class MIOPENLRNGradientOp final : public Operator<HIPContext>
     const float beta_;
     const float bias_;
     const bool do_backward_;
-    float* bwdLRNWs_;
-    float* LRNBwdScratch;
+    Tensor<HIPContext> bwdLRNWs_;
+    Tensor<HIPContext> LRNBwdScratch_;
     // Input: X, Y, dY
     // Output: dX
 };
@@ -206,16 +193,13 @@ bool MIOPENLRNGradientOp::DoRunWithType()
 
     size_t ws_size = 0;
     MIOPEN_ENFORCE(miopenLRNGetWorkSpaceSize(data_desc_, &ws_size));
-    if(bwdLRNWs_ == nullptr)
-    {
-        HIP_CHECK(hipMalloc(&bwdLRNWs_, ws_size));
-    }
+    // The workspace and the recomputed forward output come from the caching
+    // allocator, and follow the input shape from run to run.
+    bwdLRNWs_.Resize(static_cast<TIndex>(ws_size));
+    void* bwdLRNWsData = ws_size > 0 ? bwdLRNWs_.mutable_data<uint8_t>() : nullptr;
 
     // Run fwd pass to populate workspace
-    if(LRNBwdScratch == nullptr)
-    {
-        HIP_CHECK(hipMalloc(&LRNBwdScratch, X.size() * sizeof(float)));
-    }
+    LRNBwdScratch_.ResizeLike(X);
     MIOPEN_ENFORCE(miopenLRNForward(miopen_wrapper_.inline_miopen_handle(),
                                     norm_desc_,
                                     &alpha_,
@@ -223,9 +207,9 @@ bool MIOPENLRNGradientOp::DoRunWithType()
                                     X.template data<T>(),
                                     &beta_,
                                     data_desc_,
-                                    LRNBwdScratch,
+                                    LRNBwdScratch_.template mutable_data<T>(),
                                     true,
-                                    bwdLRNWs_));
+                                    bwdLRNWsData));
 
     // run the bwd computation
     MIOPEN_ENFORCE(miopenLRNBackward(miopen_wrapper_.inline_miopen_handle(),
@@ -240,7 +224,7 @@ bool MIOPENLRNGradientOp::DoRunWithType()
                                      &beta_,
                                      data_desc_,
                                      dX->template mutable_data<T>(),
-                                     bwdLRNWs_));
+                                     bwdLRNWsData));
     return true;
 }
 
@@ -37,6 +37,7 @@ OPERATOR_SCHEMA(Log)
     .NumOutputs(1)
     .AllowInplace({{0, 0}})
     .IdenticalTypeAndShape()
+    .CostInferenceFunction(PointwiseCostInference<1>)
     .SetDoc(R"DOC(
 Calculates the natural log of the given input tensor, element-wise. This
 operation can be done in an in-place fashion too, by providing the same input
@@ -30,6 +30,11 @@ CAFFE_KNOWN_TYPE(MapType32To32);
 using MapType32To64 = MapTypeTraits<int32_t, int64_t>::MapType;
 CAFFE_KNOWN_TYPE(MapType32To64);
 
+CAFFE_KNOWN_TYPE(FlatMapType64To64);
+CAFFE_KNOWN_TYPE(FlatMapType64To32);
+CAFFE_KNOWN_TYPE(FlatMapType32To32);
+CAFFE_KNOWN_TYPE(FlatMapType32To64);
+
 namespace {
 
 REGISTER_BLOB_SERIALIZER(
@@ -48,6 +53,22 @@ REGISTER_BLOB_SERIALIZER(
     TypeMeta::Id<MapType32To64>(),
     MapSerializer<int32_t, int64_t>);
 
+REGISTER_BLOB_SERIALIZER(
+    TypeMeta::Id<FlatMapType64To64>(),
+    MapSerializer<int64_t, int64_t, FlatMapTypeTraits<int64_t, int64_t>>);
+
+REGISTER_BLOB_SERIALIZER(
+    TypeMeta::Id<FlatMapType64To32>(),
+    MapSerializer<int64_t, int32_t, FlatMapTypeTraits<int64_t, int32_t>>);
+
+REGISTER_BLOB_SERIALIZER(
+    TypeMeta::Id<FlatMapType32To32>(),
+    MapSerializer<int32_t, int32_t, FlatMapTypeTraits<int32_t, int32_t>>);
+
+REGISTER_BLOB_SERIALIZER(
+    TypeMeta::Id<FlatMapType32To64>(),
+    MapSerializer<int32_t, int64_t, FlatMapTypeTraits<int32_t, int64_t>>);
+
 REGISTER_BLOB_DESERIALIZER(
     (std::unordered_map<int64_t, int64_t>),
     MapDeserializer<int64_t, int64_t>);
@@ -64,9 +85,26 @@ REGISTER_BLOB_DESERIALIZER(
     (std::unordered_map<int32_t, int64_t>),
     MapDeserializer<int32_t, int64_t>);
 
+REGISTER_BLOB_DESERIALIZER(
+    (FlatMap<int64_t, int64_t>),
+    MapDeserializer<int64_t, int64_t, FlatMapTypeTraits<int64_t, int64_t>>);
+
+REGISTER_BLOB_DESERIALIZER(
+    (FlatMap<int64_t, int32_t>),
+    MapDeserializer<int64_t, int32_t, FlatMapTypeTraits<int64_t, int32_t>>);
+
+REGISTER_BLOB_DESERIALIZER(
+    (FlatMap<int32_t, int32_t>),
+    MapDeserializer<int32_t, int32_t, FlatMapTypeTraits<int32_t, int32_t>>);
+
+REGISTER_BLOB_DESERIALIZER(
+    (FlatMap<int32_t, int64_t>),
+    MapDeserializer<int32_t, int64_t, FlatMapTypeTraits<int32_t, int64_t>>);
+
 REGISTER_CPU_OPERATOR(CreateMap, CreateMapOp<CPUContext>);
 REGISTER_CPU_OPERATOR(KeyValueToMap, KeyValueToMapOp<CPUContext>);
 REGISTER_CPU_OPERATOR(MapToKeyValue, MapToKeyValueOp<CPUContext>);
+REGISTER_CPU_OPERATOR(MapLookup, MapLookupOp<CPUContext>);
 
 OPERATOR_SCHEMA(CreateMap)
     .NumInputs(0)
@@ -74,12 +112,17 @@ OPERATOR_SCHEMA(CreateMap)
     .SetDoc("Create an empty map blob")
     .Arg("key_dtype", "Key's TensorProto::DataType (default INT32)")
     .Arg("value_dtype", "Value's TensorProto::DataType (default INT32)")
+    .Arg(
+        "flat",
+        "If 1, create an open-addressing FlatMap, faster to look up with "
+        "MapLookup than the default std::unordered_map (default 0)")
     .Output(0, "map blob", "Blob reference to the map");
 
 OPERATOR_SCHEMA(KeyValueToMap)
     .NumInputs(2)
     .NumOutputs(1)
     .SetDoc("Convert key and value blob pairs into a map blob")
+    .Arg("flat", "If 1, the map is a FlatMap, see CreateMap (default 0)")
     .Input(0, "key blob", "Blob reference to the key")
     .Input(1, "value blob", "Blob reference to the value")
     .Output(0, "map blob", "Blob reference to the map");
@@ -91,5 +134,23 @@ OPERATOR_SCHEMA(MapToKeyValue)
     .Input(0, "map blob", "Blob reference to the map")
     .Output(0, "key blob", "Blob reference to the key")
     .Output(1, "value blob", "Blob reference to the value");
+
+OPERATOR_SCHEMA(MapLookup)
+    .NumInputs(2)
+    .NumOutputs(1, 2)
+    .SetDoc(R"DOC(
+Look keys up in a map blob. The values have the shape of the keys, the keys
+that are not in the map get default_value. The keys of FlatMaps (created with
+flat=1) are probed in batch, prefetching the slots of the next keys. The map is
+only read, so it can be shared, e.g. by Predictors using the same parent
+workspace.
+)DOC")
+    .Arg("default_value", "Value of the missing keys (default -1)")
+    .Input(0, "map blob", "Blob reference to the map")
+    .Input(1, "keys", "Keys to look up, of the key type of the map")
+    .Output(0, "values", "Values of the keys")
+    .Output(1, "found", "(optional) bool tensor, whether each key was found");
+
+NO_GRADIENT(MapLookup);
 }
 } // namespace caffe2
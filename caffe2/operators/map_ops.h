@@ -28,6 +28,7 @@
 #include "caffe2/core/blob_serialization.h"
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/utils/flat_map.h"
 
 namespace caffe2 {
 
@@ -55,17 +56,46 @@ struct MapTypeTraits {
   }
 };
 
+// Maps created with flat=1 are FlatMaps, faster to look up (see MapLookup)
+// for large ID remapping tables.
+template <typename KEY_T, typename VALUE_T>
+struct FlatMapTypeTraits {
+  using MapType = FlatMap<KEY_T, VALUE_T>;
+  static string MapTypeName() {
+    return string("(FlatMap<") + TypeNameTraits<KEY_T>::name + ", " +
+        TypeNameTraits<VALUE_T>::name + ">)";
+  }
+};
+
 using MapType64To64 = MapTypeTraits<int64_t, int64_t>::MapType;
 using MapType64To32 = MapTypeTraits<int64_t, int32_t>::MapType;
 using MapType32To32 = MapTypeTraits<int32_t, int32_t>::MapType;
 using MapType32To64 = MapTypeTraits<int32_t, int64_t>::MapType;
+using FlatMapType64To64 = FlatMapTypeTraits<int64_t, int64_t>::MapType;
+using FlatMapType64To32 = FlatMapTypeTraits<int64_t, int32_t>::MapType;
+using FlatMapType32To32 = FlatMapTypeTraits<int32_t, int32_t>::MapType;
+using FlatMapType32To64 = FlatMapTypeTraits<int32_t, int64_t>::MapType;
+
+// Calls f(key, value) for every entry of a map of either kind.
+template <typename MAP_T, typename F>
+void ForEachMapEntry(const MAP_T& map, F f) {
+  for (const auto& it : map) {
+    f(it.first, it.second);
+  }
+}
+
+template <typename KEY_T, typename VALUE_T, typename F>
+void ForEachMapEntry(const FlatMap<KEY_T, VALUE_T>& map, F f) {
+  map.ForEach(f);
+}
 
 template <class Context>
 class CreateMapOp final : public Operator<Context> {
  public:
   USE_OPERATOR_CONTEXT_FUNCTIONS;
   CreateMapOp(const OperatorDef& operator_def, Workspace* ws)
-      : Operator<Context>(operator_def, ws) {}
+      : Operator<Context>(operator_def, ws),
+        flat_(OperatorBase::GetSingleArgument<bool>("flat", false)) {}
   ~CreateMapOp() {}
 
   bool RunOnDevice() override {
@@ -91,8 +121,15 @@ class CreateMapOp final : public Operator<Context> {
   template <typename KEY_T, typename VALUE_T>
   bool DoRunWithType2() {
     // clear to make sure the map is empty
-    OperatorBase::Output<typename MapTypeTraits<KEY_T, VALUE_T>::MapType>(MAP)
-        ->clear();
+    if (flat_) {
+      OperatorBase::Output<
+          typename FlatMapTypeTraits<KEY_T, VALUE_T>::MapType>(MAP)
+          ->clear();
+    } else {
+      OperatorBase::Output<typename MapTypeTraits<KEY_T, VALUE_T>::MapType>(
+          MAP)
+          ->clear();
+    }
     return true;
   }
 
@@ -109,6 +146,9 @@ class CreateMapOp final : public Operator<Context> {
   }
 
   OUTPUT_TAGS(MAP);
+
+ private:
+  bool flat_;
 };
 
 template <class Context>
@@ -116,7 +156,8 @@ class KeyValueToMapOp final : public Operator<Context> {
  public:
   USE_OPERATOR_CONTEXT_FUNCTIONS;
   KeyValueToMapOp(const OperatorDef& operator_def, Workspace* ws)
-      : Operator<Context>(operator_def, ws) {}
+      : Operator<Context>(operator_def, ws),
+        flat_(OperatorBase::GetSingleArgument<bool>("flat", false)) {}
   ~KeyValueToMapOp() {}
 
   bool RunOnDevice() override {
@@ -133,7 +174,16 @@ class KeyValueToMapOp final : public Operator<Context> {
 
   template <typename KEY_T, typename VALUE_T>
   bool DoRunWithType2() {
-    using MapType = typename MapTypeTraits<KEY_T, VALUE_T>::MapType;
+    if (flat_) {
+      return FillMap<typename FlatMapTypeTraits<KEY_T, VALUE_T>::MapType>();
+    }
+    return FillMap<typename MapTypeTraits<KEY_T, VALUE_T>::MapType>();
+  }
+
+  template <typename MapType>
+  bool FillMap() {
+    using KEY_T = typename MapType::key_type;
+    using VALUE_T = typename MapType::mapped_type;
     const auto& key_input = Input(KEYS);
     const auto& value_input = Input(VALUES);
 
@@ -143,6 +193,7 @@ class KeyValueToMapOp final : public Operator<Context> {
     auto* value_data = value_input.template data<VALUE_T>();
 
     auto* map_data = OperatorBase::Output<MapType>(MAP);
+    map_data->reserve(map_data->size() + key_input.size());
 
     for (int i = 0; i < key_input.size(); ++i) {
       map_data->emplace(key_data[i], value_data[i]);
@@ -161,6 +212,9 @@ class KeyValueToMapOp final : public Operator<Context> {
 
   INPUT_TAGS(KEYS, VALUES);
   OUTPUT_TAGS(MAP);
+
+ private:
+  bool flat_;
 };
 
 template <class Context>
@@ -176,7 +230,11 @@ class MapToKeyValueOp final : public Operator<Context> {
         MapType64To64,
         MapType64To32,
         MapType32To32,
-        MapType32To64>>::call(this, OperatorBase::InputBlob(MAP));
+        MapType32To64,
+        FlatMapType64To64,
+        FlatMapType64To32,
+        FlatMapType32To32,
+        FlatMapType32To64>>::call(this, OperatorBase::InputBlob(MAP));
   }
 
   template <typename MAP_T>
@@ -191,12 +249,10 @@ class MapToKeyValueOp final : public Operator<Context> {
     auto* key_data = key_output->template mutable_data<key_type>();
     auto* value_data = value_output->template mutable_data<mapped_type>();
 
-    for (const auto& it : map_data) {
-      *key_data = it.first;
-      *value_data = it.second;
-      key_data++;
-      value_data++;
-    }
+    ForEachMapEntry(map_data, [&](key_type key, mapped_type value) {
+      *key_data++ = key;
+      *value_data++ = value;
+    });
 
     return true;
   }
@@ -205,10 +261,101 @@ class MapToKeyValueOp final : public Operator<Context> {
   OUTPUT_TAGS(KEYS, VALUES);
 };
 
-template <typename KEY_T, typename VALUE_T>
+// Looks the keys up in a map of either kind, FlatMaps are probed in batch.
+// The map is only read, so one map can serve any number of nets at once,
+// e.g. Predictors sharing the workspace that holds it.
+template <class Context>
+class MapLookupOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  MapLookupOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        default_value_(
+            OperatorBase::GetSingleArgument<int64_t>("default_value", -1)) {}
+  ~MapLookupOp() {}
+
+  bool RunOnDevice() override {
+    return DispatchHelper<TensorTypes<
+        MapType64To64,
+        MapType64To32,
+        MapType32To32,
+        MapType32To64,
+        FlatMapType64To64,
+        FlatMapType64To32,
+        FlatMapType32To32,
+        FlatMapType32To64>>::call(this, OperatorBase::InputBlob(MAP));
+  }
+
+  template <typename MAP_T>
+  bool DoRunWithType() {
+    using key_type = typename MAP_T::key_type;
+    using mapped_type = typename MAP_T::mapped_type;
+    const auto& map_data = OperatorBase::Input<MAP_T>(MAP);
+    const auto& keys = Input(KEYS);
+    CAFFE_ENFORCE(
+        keys.template IsType<key_type>(),
+        "Keys of type ",
+        keys.meta().name(),
+        " don't match the map");
+    auto* values = Output(VALUES);
+    values->ResizeLike(keys);
+    bool* found = nullptr;
+    if (OutputSize() > 1) {
+      Output(FOUND)->ResizeLike(keys);
+      found = Output(FOUND)->template mutable_data<bool>();
+    }
+    Lookup(
+        map_data,
+        keys.template data<key_type>(),
+        keys.size(),
+        static_cast<mapped_type>(default_value_),
+        values->template mutable_data<mapped_type>(),
+        found);
+    return true;
+  }
+
+  INPUT_TAGS(MAP, KEYS);
+  OUTPUT_TAGS(VALUES, FOUND);
+
+ private:
+  template <typename MAP_T>
+  static void Lookup(
+      const MAP_T& map,
+      const typename MAP_T::key_type* keys,
+      const size_t n,
+      const typename MAP_T::mapped_type default_value,
+      typename MAP_T::mapped_type* values,
+      bool* found) {
+    for (size_t i = 0; i < n; ++i) {
+      const auto it = map.find(keys[i]);
+      values[i] = it != map.end() ? it->second : default_value;
+      if (found != nullptr) {
+        found[i] = it != map.end();
+      }
+    }
+  }
+
+  template <typename KEY_T, typename VALUE_T>
+  static void Lookup(
+      const FlatMap<KEY_T, VALUE_T>& map,
+      const KEY_T* keys,
+      const size_t n,
+      const VALUE_T default_value,
+      VALUE_T* values,
+      bool* found) {
+    map.LookupBatch(keys, n, default_value, values, found);
+  }
+
+  int64_t default_value_;
+};
+
+template <
+    typename KEY_T,
+    typename VALUE_T,
+    class TRAITS = MapTypeTraits<KEY_T, VALUE_T>>
 class MapSerializer : public BlobSerializerBase {
  public:
-  using MapType = typename MapTypeTraits<KEY_T, VALUE_T>::MapType;
+  using MapType = typename TRAITS::MapType;
 
   void Serialize(
       const Blob& blob,
@@ -223,12 +370,10 @@ class MapSerializer : public BlobSerializerBase {
     value_tensor.Resize(sz);
     auto* key_data = key_tensor.mutable_data<KEY_T>();
     auto* value_data = value_tensor.mutable_data<VALUE_T>();
-    for (const auto& it : map_data) {
-      *key_data = it.first;
-      *value_data = it.second;
-      key_data++;
-      value_data++;
-    }
+    ForEachMapEntry(map_data, [&](KEY_T key, VALUE_T value) {
+      *key_data++ = key;
+      *value_data++ = value;
+    });
 
     TensorProtos tensor_protos;
     TensorSerializer<CPUContext> ser;
@@ -239,16 +384,19 @@ class MapSerializer : public BlobSerializerBase {
 
     BlobProto blob_proto;
     blob_proto.set_name(name);
-    blob_proto.set_type(MapTypeTraits<KEY_T, VALUE_T>::MapTypeName());
+    blob_proto.set_type(TRAITS::MapTypeName());
     blob_proto.set_content(tensor_protos.SerializeAsString());
     acceptor(name, blob_proto.SerializeAsString());
   }
 };
 
-template <typename KEY_T, typename VALUE_T>
+template <
+    typename KEY_T,
+    typename VALUE_T,
+    class TRAITS = MapTypeTraits<KEY_T, VALUE_T>>
 class MapDeserializer : public BlobDeserializerBase {
  public:
-  using MapType = typename MapTypeTraits<KEY_T, VALUE_T>::MapType;
+  using MapType = typename TRAITS::MapType;
 
   void Deserialize(const BlobProto& proto, Blob* blob) override {
     TensorProtos tensor_protos;
@@ -263,6 +411,7 @@ class MapDeserializer : public BlobDeserializerBase {
     auto* value_data = value_tensor.data<VALUE_T>();
 
     auto* map_ptr = blob->template GetMutable<MapType>();
+    map_ptr->reserve(map_ptr->size() + key_tensor.size());
     for (int i = 0; i < key_tensor.size(); ++i) {
       map_ptr->emplace(key_data[i], value_data[i]);
     }
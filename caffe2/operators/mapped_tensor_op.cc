@@ -0,0 +1,221 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/types.h"
+
+namespace caffe2 {
+
+namespace {
+
+// A mapped tensor file is a small header followed by the raw tensor data,
+// aligned so that it can be used in place once the file is mapped:
+//   char magic[4], int32 data_type, int32 ndim, int32 unused,
+//   int64 dims[ndim], padding up to kDataAlignment, data
+constexpr char kMagic[4] = {'C', '2', 'M', 'T'};
+constexpr size_t kHeaderSize = 4 + 3 * sizeof(int32_t);
+constexpr size_t kDataAlignment = 64;
+
+size_t DataOffset(int ndim) {
+  const size_t size = kHeaderSize + ndim * sizeof(int64_t);
+  return (size + kDataAlignment - 1) / kDataAlignment * kDataAlignment;
+}
+
+// Blob names may contain the separator of the scopes.
+string MappedTensorFile(const string& folder, const string& name) {
+  string file = name;
+  std::replace(file.begin(), file.end(), '/', '#');
+  return folder + "/" + file;
+}
+
+string FullFolder(Workspace* ws, const OperatorBase& op) {
+  const string folder = op.GetSingleArgument<string>("folder", "");
+  CAFFE_ENFORCE(!folder.empty(), "Must specify a folder.");
+  return op.GetSingleArgument<int>("absolute_path", 0)
+      ? folder
+      : ws->RootFolder() + "/" + folder;
+}
+
+} // namespace
+
+class SaveMappedOp final : public Operator<CPUContext> {
+ public:
+  SaveMappedOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        folder_(FullFolder(ws, *this)),
+        names_(operator_def.input().begin(), operator_def.input().end()) {}
+
+  bool RunOnDevice() override {
+    for (int i = 0; i < InputSize(); ++i) {
+      Save(Input(i), MappedTensorFile(folder_, names_[i]));
+    }
+    return true;
+  }
+
+ private:
+  void Save(const TensorCPU& tensor, const string& path) {
+    const TensorProto::DataType data_type = TypeMetaToDataType(tensor.meta());
+    CAFFE_ENFORCE(
+        data_type != TensorProto::STRING &&
+            data_type != TensorProto::UNDEFINED,
+        "Only tensors of a fixed-size type can be mapped, not ",
+        tensor.meta().name());
+    std::unique_ptr<FILE, int (*)(FILE*)> file(
+        fopen(path.c_str(), "wb"), &fclose);
+    CAFFE_ENFORCE(file, "Cannot open ", path, " for writing.");
+    string header(DataOffset(tensor.ndim()), '\0');
+    const int32_t fields[3] = {data_type, tensor.ndim(), 0};
+    memcpy(&header[0], kMagic, sizeof(kMagic));
+    memcpy(&header[sizeof(kMagic)], fields, sizeof(fields));
+    for (int d = 0; d < tensor.ndim(); ++d) {
+      const int64_t dim = tensor.dim(d);
+      memcpy(&header[kHeaderSize + d * sizeof(int64_t)], &dim, sizeof(dim));
+    }
+    CAFFE_ENFORCE_EQ(
+        fwrite(header.data(), 1, header.size(), file.get()), header.size());
+    if (tensor.nbytes()) {
+      CAFFE_ENFORCE_EQ(
+          fwrite(tensor.raw_data(), 1, tensor.nbytes(), file.get()),
+          tensor.nbytes(),
+          "Cannot write ",
+          path);
+    }
+  }
+
+  string folder_;
+  vector<string> names_;
+};
+
+class LoadMappedOp final : public Operator<CPUContext> {
+ public:
+  LoadMappedOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        folder_(FullFolder(ws, *this)),
+        names_(operator_def.output().begin(), operator_def.output().end()) {}
+
+  bool RunOnDevice() override {
+    for (int i = 0; i < OutputSize(); ++i) {
+      Map(MappedTensorFile(folder_, names_[i]), Output(i));
+    }
+    return true;
+  }
+
+ private:
+  void Map(const string& path, TensorCPU* tensor) {
+    int fd = open(path.c_str(), O_RDONLY);
+    CAFFE_ENFORCE_GE(fd, 0, "Cannot open ", path);
+    struct stat st;
+    const bool stat_ok = fstat(fd, &st) == 0;
+    const size_t size = stat_ok ? st.st_size : 0;
+    // Private and writable: pages come from the file as they are first
+    // touched, and an op writing to the tensor gets its own copy of the page
+    // instead of changing the file.
+    void* base = size
+        ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0)
+        : MAP_FAILED;
+    close(fd);
+    CAFFE_ENFORCE(stat_ok && base != MAP_FAILED, "Cannot map ", path);
+    std::shared_ptr<void> mapping(
+        base, [size](void* ptr) { munmap(ptr, size); });
+    const char* data = static_cast<const char*>(base);
+
+    CAFFE_ENFORCE(
+        size >= kHeaderSize && memcmp(data, kMagic, sizeof(kMagic)) == 0,
+        path,
+        " is not a mapped tensor file.");
+    int32_t fields[3];
+    memcpy(fields, data + sizeof(kMagic), sizeof(fields));
+    const auto data_type = static_cast<TensorProto::DataType>(fields[0]);
+    const int ndim = fields[1];
+    CAFFE_ENFORCE(
+        ndim >= 0 && size >= DataOffset(ndim), path, " is truncated.");
+    vector<TIndex> dims(ndim);
+    for (int d = 0; d < ndim; ++d) {
+      int64_t dim;
+      memcpy(&dim, data + kHeaderSize + d * sizeof(int64_t), sizeof(dim));
+      dims[d] = dim;
+    }
+    const TypeMeta& meta = DataTypeToTypeMeta(data_type);
+    tensor->Resize(dims);
+    CAFFE_ENFORCE_EQ(
+        size - DataOffset(ndim),
+        tensor->size() * meta.itemsize(),
+        path,
+        " does not hold the tensor its header describes.");
+    // The tensor keeps the whole file mapped for as long as it shares it.
+    tensor->ShareExternalPointer(
+        const_cast<char*>(data) + DataOffset(ndim),
+        meta,
+        0,
+        [mapping](void*) {});
+  }
+
+  string folder_;
+  vector<string> names_;
+};
+
+REGISTER_CPU_OPERATOR(SaveMapped, SaveMappedOp);
+REGISTER_CPU_OPERATOR(LoadMapped, LoadMappedOp);
+
+OPERATOR_SCHEMA(SaveMapped)
+    .NumInputs(1, INT_MAX)
+    .NumOutputs(0)
+    .SetDoc(R"DOC(
+Writes each input tensor to its own file of `folder`, as a small header and
+the raw data, so that LoadMapped can later map it instead of parsing it. Only
+tensors of a fixed-size type can be saved.
+)DOC")
+    .Arg("folder", "(string) the folder the files are written to.")
+    .Arg(
+        "absolute_path",
+        "(int, default 0) if set, use the folder directly and do not prepend "
+        "the current root folder of the workspace.");
+
+OPERATOR_SCHEMA(LoadMapped)
+    .NumInputs(0)
+    .NumOutputs(1, INT_MAX)
+    .SetDoc(R"DOC(
+Maps the files written by SaveMapped into the output tensors of the same
+name. Nothing is read up front: pages of a tensor are read from the file the
+first time they are accessed, and can be evicted again by the kernel, so
+loading is almost instant and only the rows in use stay in memory. This is
+meant for the huge embedding tables of an init_net. Writes to the tensors go
+to private copies of the pages, the files are never changed.
+)DOC")
+    .Arg("folder", "(string) the folder written by SaveMapped.")
+    .Arg(
+        "absolute_path",
+        "(int, default 0) if set, use the folder directly and do not prepend "
+        "the current root folder of the workspace.");
+
+SHOULD_NOT_DO_GRADIENT(SaveMapped);
+NO_GRADIENT(LoadMapped);
+
+} // namespace caffe2
+
+#endif // _WIN32
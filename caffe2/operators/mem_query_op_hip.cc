@@ -61,6 +61,50 @@ OPERATOR_SCHEMA(GetGPUMemoryUsage)
     )DOC");
 
 REGISTER_HIP_OPERATOR(GetGPUMemoryUsage, GetGPUMemoryUsageOp);
+
+class GetGPUMemoryPoolStatsOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    using Operator::Operator;
+
+    bool RunOnDevice() override
+    {
+        const auto pool_stats = HIPContext::MemoryPoolStats();
+
+        // The stats are meant to be polled from the host, so they are
+        // written to a CPU tensor to spare a device round trip.
+        auto* stats = OperatorBase::Output<TensorCPU>(0);
+        stats->Resize(pool_stats.size(), 6);
+        auto* data = stats->mutable_data<long>();
+        for(const auto& s : pool_stats)
+        {
+            *data++ = s.allocated_bytes;
+            *data++ = s.cached_bytes;
+            *data++ = s.largest_free_block;
+            *data++ = s.num_allocs;
+            *data++ = s.num_cache_hits;
+            *data++ = s.num_segments;
+        }
+        return true;
+    }
+};
+
+OPERATOR_SCHEMA(GetGPUMemoryPoolStats)
+    .NumInputs(0)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(Fetches the memory pool counters of every GPU. The result is
+      a CPU tensor of shape (num_gpus, 6) whose columns are: bytes in use,
+      bytes cached by the pool (in use or free), largest free block, number
+      of allocations, number of allocations served from the cache and number
+      of device allocations owned by the pool.
+
+      Unlike GetGPUMemoryUsage this does not need
+      --caffe2_gpu_memory_tracking, except that without a memory pool the
+      byte counts are only available with it.
+    )DOC");
+
+REGISTER_HIP_OPERATOR(GetGPUMemoryPoolStats, GetGPUMemoryPoolStatsOp);
 }
 
 } // namespace caffe2
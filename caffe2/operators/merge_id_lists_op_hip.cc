@@ -0,0 +1,270 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <hipcub/hipcub.hpp>
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/merge_id_lists_op.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+// Tags every id of one list with the sample it belongs to, found by a binary
+// search over the exclusive prefix sum of the list's lengths.
+template <typename T>
+__global__ void TagIdListKernel(const int N,
+                                const int batch_size,
+                                const int* offsets,
+                                const T* values,
+                                int* samples_out,
+                                T* values_out)
+{
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        int lo = 0;
+        int hi = batch_size - 1;
+        while(lo < hi)
+        {
+            const int mid = (lo + hi + 1) / 2;
+            if(offsets[mid] <= i)
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid - 1;
+            }
+        }
+        samples_out[i] = lo;
+        values_out[i]  = values[i];
+    }
+}
+
+// On ids sorted by (sample, id), keeps the first of every run of equal pairs
+// and counts it towards the sample's output length.
+template <typename T>
+__global__ void UniqueIdsKernel(
+    const int N, const int* samples, const T* values, bool* is_unique, int* out_lengths)
+{
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        const bool unique =
+            i == 0 || samples[i] != samples[i - 1] || values[i] != values[i - 1];
+        is_unique[i] = unique;
+        if(unique)
+        {
+            atomicAdd(out_lengths + samples[i], 1);
+        }
+    }
+}
+
+void exclusive_sum(
+    const int* in, int* out, int N, Tensor<HIPContext>* buffer, HIPContext* context)
+{
+    size_t temp_storage_bytes = 0;
+    hipcub::DeviceScan::ExclusiveSum(
+        nullptr, temp_storage_bytes, in, out, N, context->hip_stream());
+    buffer->Resize(temp_storage_bytes);
+    hipcub::DeviceScan::ExclusiveSum(static_cast<void*>(buffer->mutable_data<char>()),
+                                     temp_storage_bytes,
+                                     in,
+                                     out,
+                                     N,
+                                     context->hip_stream());
+}
+} // namespace
+
+// The ids of every sample are merged by tagging them with their sample,
+// radix-sorting the (sample, id) pairs and keeping the first of each run,
+// which gives the same sorted, deduplicated lists as the std::set on the CPU.
+template <>
+class MergeIdListsOp<HIPContext> final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    MergeIdListsOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(this, Input(1));
+    }
+
+    template <typename T>
+    bool DoRunWithType()
+    {
+        auto& first_lengths = Input(0);
+        CAFFE_ENFORCE_EQ(first_lengths.ndim(), 1, "LENGTHS should be 1-D");
+        const int batch_size = first_lengths.size();
+
+        auto* out_lengths = Output(0);
+        out_lengths->ResizeLike(first_lengths);
+        int* out_lengths_data = out_lengths->template mutable_data<int32_t>();
+        math::Set<int, HIPContext>(batch_size, 0, out_lengths_data, &context_);
+
+        int M = 0;
+        for(int i = 0; i < InputSize(); i += 2)
+        {
+            auto& lengths = Input(i);
+            CAFFE_ENFORCE_EQ(lengths.ndim(), 1, "LENGTHS should be 1-D");
+            CAFFE_ENFORCE_EQ(lengths.size(), batch_size, "LENGTHS should be equal");
+            auto& values = Input(i + 1);
+            CAFFE_ENFORCE_EQ(values.ndim(), 1, "VALUES should be 1-D");
+            M += values.size();
+        }
+
+        auto* out_values = Output(1);
+        if(M == 0 || batch_size == 0)
+        {
+            out_values->Resize(0);
+            out_values->template mutable_data<T>();
+            return true;
+        }
+
+        // two ping-pong halves for the sample tags and the ids
+        samples_.Resize(2 * M);
+        int* samples       = samples_.template mutable_data<int>();
+        int* samples_swap  = samples + M;
+        values_.Resize(2 * M * sizeof(T));
+        T* values          = reinterpret_cast<T*>(values_.template mutable_data<char>());
+        T* values_swap     = values + M;
+        offsets_.Resize(batch_size);
+        int* offsets = offsets_.template mutable_data<int>();
+
+        int base = 0;
+        for(int i = 0; i < InputSize(); i += 2)
+        {
+            auto& values_in = Input(i + 1);
+            const int N     = values_in.size();
+            if(N == 0)
+            {
+                continue;
+            }
+            exclusive_sum(Input(i).template data<int32_t>(), offsets, batch_size, &buffer_, &context_);
+            hipLaunchKernelGGL((TagIdListKernel<T>),
+                               dim3(CAFFE_GET_BLOCKS(N)),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context_.hip_stream(),
+                               N,
+                               batch_size,
+                               offsets,
+                               values_in.template data<T>(),
+                               samples + base,
+                               values + base);
+            base += N;
+        }
+
+        // Sort by id, then stably by sample, which only needs as many bits
+        // as the largest sample index
+        int sample_bits = 1;
+        while(sample_bits < 31 && (1 << sample_bits) < batch_size)
+        {
+            sample_bits++;
+        }
+        SortPairs(values, values_swap, samples, samples_swap, M, 0, sizeof(T) * 8);
+        SortPairs(samples_swap, samples, values_swap, values, M, 0, sample_bits);
+
+        is_unique_.Resize(M);
+        bool* is_unique = is_unique_.template mutable_data<bool>();
+        hipLaunchKernelGGL((UniqueIdsKernel<T>),
+                           dim3(CAFFE_GET_BLOCKS(M)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           M,
+                           samples,
+                           values,
+                           is_unique,
+                           out_lengths_data);
+
+        // the selected ids land in values_swap, followed by their count
+        int* num_selected         = samples_swap;
+        size_t temp_storage_bytes = 0;
+        hipcub::DeviceSelect::Flagged(nullptr,
+                                      temp_storage_bytes,
+                                      values,
+                                      is_unique,
+                                      values_swap,
+                                      num_selected,
+                                      M,
+                                      context_.hip_stream());
+        buffer_.Resize(temp_storage_bytes);
+        hipcub::DeviceSelect::Flagged(static_cast<void*>(buffer_.template mutable_data<char>()),
+                                      temp_storage_bytes,
+                                      values,
+                                      is_unique,
+                                      values_swap,
+                                      num_selected,
+                                      M,
+                                      context_.hip_stream());
+
+        int num_selected_host = 0;
+        context_.CopyBytes<HIPContext, CPUContext>(sizeof(int), num_selected, &num_selected_host);
+        context_.FinishDeviceComputation();
+
+        out_values->Resize(num_selected_host);
+        context_.CopyBytes<HIPContext, HIPContext>(num_selected_host * sizeof(T),
+                                                   values_swap,
+                                                   out_values->template mutable_data<T>());
+        return true;
+    }
+
+    private:
+    template <typename K, typename V>
+    void SortPairs(const K* keys_in,
+                   K* keys_out,
+                   const V* values_in,
+                   V* values_out,
+                   int N,
+                   int begin_bit,
+                   int end_bit)
+    {
+        size_t temp_storage_bytes = 0;
+        hipcub::DeviceRadixSort::SortPairs(nullptr,
+                                           temp_storage_bytes,
+                                           keys_in,
+                                           keys_out,
+                                           values_in,
+                                           values_out,
+                                           N,
+                                           begin_bit,
+                                           end_bit,
+                                           context_.hip_stream());
+        buffer_.Resize(temp_storage_bytes);
+        hipcub::DeviceRadixSort::SortPairs(static_cast<void*>(buffer_.template mutable_data<char>()),
+                                           temp_storage_bytes,
+                                           keys_in,
+                                           keys_out,
+                                           values_in,
+                                           values_out,
+                                           N,
+                                           begin_bit,
+                                           end_bit,
+                                           context_.hip_stream());
+    }
+
+    Tensor<HIPContext> samples_;
+    Tensor<HIPContext> values_;
+    Tensor<HIPContext> offsets_;
+    Tensor<HIPContext> is_unique_;
+    Tensor<HIPContext> buffer_;
+};
+
+REGISTER_HIP_OPERATOR(MergeIdLists, MergeIdListsOp<HIPContext>);
+} // namespace caffe2
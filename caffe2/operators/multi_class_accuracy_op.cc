@@ -71,6 +71,46 @@ bool MultiClassAccuracyOp<float, CPUContext>::RunOnDevice() {
 REGISTER_CPU_OPERATOR(
   MultiClassAccuracy, MultiClassAccuracyOp<float, CPUContext>);
 
+template <>
+bool AccumulateMultiClassAccuracyOp<float, CPUContext>::RunOnDevice() {
+  auto& X = Input(PREDICTION);
+  auto& label = Input(LABEL);
+  CAFFE_ENFORCE_EQ(X.ndim(), 2);
+  const int N = X.dim32(0);
+  const int D = X.dim32(1);
+  CAFFE_ENFORCE_EQ(label.ndim(), 1);
+  CAFFE_ENFORCE_EQ(label.dim32(0), N);
+  InitCounts(D);
+
+  const auto* Xdata = X.data<float>();
+  const auto* labeldata = label.data<int>();
+  auto* amounts = Output(AMOUNTS)->mutable_data<int64_t>();
+  auto* correct = Output(CORRECT)->mutable_data<int64_t>();
+  for (int i = 0; i < N; ++i) {
+    const int maxid =
+        std::max_element(Xdata + i * D, Xdata + (i + 1) * D) - (Xdata + i * D);
+    const int labelid = labeldata[i];
+    DCHECK_LT(labelid, D);
+    if (maxid == labelid) {
+      correct[labelid]++;
+    }
+    amounts[labelid]++;
+  }
+
+  auto* Y = Output(ACCURACIES);
+  Y->Resize(D);
+  auto* accuracies = Y->mutable_data<float>();
+  for (int i = 0; i < D; ++i) {
+    accuracies[i] =
+        amounts[i] ? static_cast<float>(correct[i]) / amounts[i] : 0.0f;
+  }
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(
+    AccumulateMultiClassAccuracy,
+    AccumulateMultiClassAccuracyOp<float, CPUContext>);
+
 OPERATOR_SCHEMA(MultiClassAccuracy)
   .NumInputs(2)
   .NumOutputs(2)
@@ -99,4 +139,38 @@ and predicted scores of each class for each instance.
     "1-D int tensor (D,) of number of instances for each class in the batch.");
 
 SHOULD_NOT_DO_GRADIENT(MultiClassAccuracy);
+
+OPERATOR_SCHEMA(AccumulateMultiClassAccuracy)
+    .NumInputs(2)
+    .NumOutputs(3)
+    .SetDoc(R"DOC(
+MultiClassAccuracy over all the batches seen so far. The numbers of instances
+and of correct predictions of every class are added to amounts and correct at
+every run, and the accuracies are their ratios. The counts are kept in the
+context of the op, so on a GPU they are updated without synchronizing with the
+host. They are created at the first run; feeding empty tensors to them starts
+over.
+)DOC")
+    .Input(
+        0,
+        "prediction",
+        "2-D float tensor (N,D,) of predicted scores of each class for "
+        "each data.")
+    .Input(1, "labels", "1-D int tensor (N,) of labels for each instance.")
+    .Output(
+        0,
+        "accuracies",
+        "1-D float tensor (D,) of accuracy for each class so far, zero for a "
+        "class without instances.")
+    .Output(
+        1,
+        "amounts",
+        "1-D int64 tensor (D,) of number of instances for each class so far.")
+    .Output(
+        2,
+        "correct",
+        "1-D int64 tensor (D,) of number of correct predictions for each "
+        "class so far.");
+
+SHOULD_NOT_DO_GRADIENT(AccumulateMultiClassAccuracy);
 }  // namespace caffe2
@@ -19,6 +19,7 @@
 
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
 
 namespace caffe2 {
 
@@ -33,6 +34,34 @@ class MultiClassAccuracyOp final : public Operator<Context> {
   INPUT_TAGS(PREDICTION, LABEL);
 };
 
+// MultiClassAccuracy over all the batches seen so far. The per class numbers
+// of instances and of correct predictions are summed in amounts and correct,
+// which stay in the context of the op.
+template <typename T, class Context>
+class AccumulateMultiClassAccuracyOp final : public Operator<Context> {
+ public:
+  USE_SIMPLE_CTOR_DTOR(AccumulateMultiClassAccuracyOp);
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  bool RunOnDevice() override;
+
+ protected:
+  // Starts counting from zero when the counts are new, were reset or do not
+  // have D classes.
+  void InitCounts(const int D) {
+    for (const int tag : {AMOUNTS, CORRECT}) {
+      auto* counts = Output(tag);
+      if (counts->size() != D || !counts->template IsType<int64_t>()) {
+        counts->Resize(D);
+        math::Set<int64_t, Context>(
+            D, 0, counts->template mutable_data<int64_t>(), &context_);
+      }
+    }
+  }
+
+  INPUT_TAGS(PREDICTION, LABEL);
+  OUTPUT_TAGS(ACCURACIES, AMOUNTS, CORRECT);
+};
+
 } // namespace caffe2
 
 #endif // CAFFE2_OPERATORS_MULTI_CLASS_ACCURACY_OP_H_
@@ -59,6 +59,47 @@ __global__ void MultiClassAccuracyDivideKernel(const int D, float* accuracies, c
         }
     }
 }
+
+// Adds the instances and the correct predictions of every class to amounts
+// and correct.
+__global__ void MultiClassCountKernel(const int N,
+                                      const int D,
+                                      const float* Xdata,
+                                      const int* labeldata,
+                                      unsigned long long* amounts,
+                                      unsigned long long* correct)
+{
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        float maxval = Xdata[i * D];
+        int maxid    = 0;
+        for(int j = 1; j < D; ++j)
+        {
+            if(Xdata[i * D + j] > maxval)
+            {
+                maxval = Xdata[i * D + j];
+                maxid  = j;
+            }
+        }
+        const int labelid = labeldata[i];
+        if(maxid == labelid)
+        {
+            atomicAdd(correct + labelid, 1ULL);
+        }
+        atomicAdd(amounts + labelid, 1ULL);
+    }
+}
+
+__global__ void MultiClassRatioKernel(const int D,
+                                      const int64_t* amounts,
+                                      const int64_t* correct,
+                                      float* accuracies)
+{
+    HIP_1D_KERNEL_LOOP(i, D)
+    {
+        accuracies[i] = amounts[i] ? static_cast<float>(correct[i]) / amounts[i] : 0.0f;
+    }
+}
 } // namespace
 
 template <>
@@ -108,4 +149,53 @@ bool MultiClassAccuracyOp<float, HIPContext>::RunOnDevice()
 }
 
 REGISTER_HIP_OPERATOR(MultiClassAccuracy, MultiClassAccuracyOp<float, HIPContext>);
+
+template <>
+bool AccumulateMultiClassAccuracyOp<float, HIPContext>::RunOnDevice()
+{
+    auto& X     = Input(PREDICTION);
+    auto& label = Input(LABEL);
+    CAFFE_ENFORCE_EQ(X.ndim(), 2);
+    const int N = X.dim32(0);
+    const int D = X.dim32(1);
+    CAFFE_ENFORCE_EQ(label.ndim(), 1);
+    CAFFE_ENFORCE_EQ(label.dim32(0), N);
+    InitCounts(D);
+
+    int64_t* amounts = Output(AMOUNTS)->mutable_data<int64_t>();
+    int64_t* correct = Output(CORRECT)->mutable_data<int64_t>();
+    auto* Y          = Output(ACCURACIES);
+    Y->Resize(D);
+    if(D == 0)
+    {
+        return true;
+    }
+    if(N > 0)
+    {
+        hipLaunchKernelGGL((MultiClassCountKernel),
+                           dim3(CAFFE_GET_BLOCKS(N)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           N,
+                           D,
+                           X.data<float>(),
+                           label.data<int>(),
+                           reinterpret_cast<unsigned long long*>(amounts),
+                           reinterpret_cast<unsigned long long*>(correct));
+    }
+    hipLaunchKernelGGL((MultiClassRatioKernel),
+                       dim3(CAFFE_GET_BLOCKS(D)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       D,
+                       amounts,
+                       correct,
+                       Y->mutable_data<float>());
+    return true;
+}
+
+REGISTER_HIP_OPERATOR(AccumulateMultiClassAccuracy,
+                      AccumulateMultiClassAccuracyOp<float, HIPContext>);
 } // namespace caffe2
@@ -14,7 +14,9 @@
  * limitations under the License.
  */
 
+#include <type_traits>
 #include "caffe2/core/context_hip.h"
+#include "caffe2/core/micro_ops_hip.h"
 #include "caffe2/operators/elementwise_op.h"
 #include "hip/hip_runtime.h"
 
@@ -31,6 +33,14 @@ struct NegativeCUDAFunctor
     template <typename T>
     inline void operator()(const int n, const T* x, T* y, HIPContext* device_context)
     {
+        if(!std::is_same<T, float>::value)
+        {
+            MicroOps::Flush();
+        }
+        else if(QueueHIPMicroOp(device_context, HIPMicroOp::kNegative, n, x, y))
+        {
+            return;
+        }
         hipLaunchKernelGGL((NegativeKernel<T>),
                            dim3(CAFFE_GET_BLOCKS(n)),
                            dim3(CAFFE_HIP_NUM_THREADS),
@@ -46,4 +56,5 @@ struct NegativeCUDAFunctor
 REGISTER_HIP_OPERATOR(
     Negative,
     UnaryElementwiseOp<TensorTypes<float, double, int, long>, HIPContext, NegativeCUDAFunctor>);
+REGISTER_COALESCABLE_OPERATOR(HIP, Negative);
 } // namespace caffe2
@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/offload_ops.h"
+
+namespace caffe2 {
+
+CAFFE_KNOWN_TYPE(OffloadedTensor);
+
+template <>
+bool OffloadToHostOp<CPUContext>::RunOnDevice() {
+  auto* state = OperatorBase::Output<OffloadedTensor>(0);
+  state->host.CopyFrom(Input(0), &context_);
+  state->on_host = true;
+  return true;
+}
+
+template <>
+bool PrefetchToDeviceOp<CPUContext>::RunOnDevice() {
+  auto* state = OperatorBase::Output<OffloadedTensor>(1);
+  Output(0)->CopyFrom(state->host, &context_);
+  state->on_host = false;
+  return true;
+}
+
+template <>
+bool WaitOffloadOp<CPUContext>::RunOnDevice() {
+  if (OperatorBase::Input<OffloadedTensor>(0).on_host) {
+    OperatorBase::Outputs()[0]->Reset();
+  }
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(OffloadToHost, OffloadToHostOp<CPUContext>);
+REGISTER_CPU_OPERATOR(PrefetchToDevice, PrefetchToDeviceOp<CPUContext>);
+REGISTER_CPU_OPERATOR(WaitOffload, WaitOffloadOp<CPUContext>);
+
+OPERATOR_SCHEMA(OffloadToHost)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Starts copying an activation to pinned host memory, so that it can be freed
+on the device until its gradient op needs it again. On GPU the copy runs on a
+stream of its own after the work queued so far, and the op does not wait for
+it. WaitOffload waits for the copy and frees the activation, and
+PrefetchToDevice brings it back. memonger.apply_offload adds these ops to a
+training net.
+)DOC")
+    .Arg(
+        "copy_stream_id",
+        "Stream of the copy, defaults to the first one the executors do not "
+        "use (--caffe2_streams_per_gpu)")
+    .Input(0, "X", "The activation.")
+    .Output(0, "offloaded", "The host copy of X.");
+
+OPERATOR_SCHEMA(PrefetchToDevice)
+    .NumInputs(1)
+    .NumOutputs(2)
+    .EnforceInplace({{0, 1}})
+    .SetDoc(R"DOC(
+Starts copying the host copy made by OffloadToHost back to the device, on the
+copy stream, without waiting for it. A WaitOffload op has to run before the
+activation is read.
+)DOC")
+    .Arg("copy_stream_id", "Stream of the copy, see OffloadToHost")
+    .Input(0, "offloaded", "The host copy, from OffloadToHost.")
+    .Output(0, "X", "The activation.")
+    .Output(1, "offloaded_out", "The host copy, in place.");
+
+OPERATOR_SCHEMA(WaitOffload)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Makes the ops after it wait for the last copy started by OffloadToHost or
+PrefetchToDevice, without blocking the host. After an OffloadToHost, it also
+frees the activation on the device.
+)DOC")
+    .Input(0, "offloaded", "The host copy, from OffloadToHost.")
+    .Output(0, "X", "The activation, freed after an offload.");
+
+SHOULD_NOT_DO_GRADIENT(OffloadToHost);
+SHOULD_NOT_DO_GRADIENT(PrefetchToDevice);
+SHOULD_NOT_DO_GRADIENT(WaitOffload);
+
+} // namespace caffe2
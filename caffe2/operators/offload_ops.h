@@ -0,0 +1,95 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_OPERATORS_OFFLOAD_OPS_H_
+#define CAFFE2_OPERATORS_OFFLOAD_OPS_H_
+
+#include <memory>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/flags.h"
+#include "caffe2/core/operator.h"
+
+CAFFE2_DECLARE_int(caffe2_streams_per_gpu);
+
+namespace caffe2 {
+
+// Host copy of an activation offloaded by OffloadToHost, in a blob of its own
+// until PrefetchToDevice brings it back.
+struct OffloadedTensor {
+  TensorCPU host;
+  // Direction of the last copy started
+  bool on_host = false;
+  // Device event recorded after the last copy, null on CPU
+  std::shared_ptr<void> copied;
+};
+
+// Starts copying input 0 to the host copy in output 0. On GPU the copy runs
+// on its own stream once the work queued so far on the stream of the op is
+// done, and the op does not wait for it. By default that stream is the first
+// one the executors do not run ops on.
+template <class Context>
+class OffloadToHostOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  OffloadToHostOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        copy_stream_id_(OperatorBase::GetSingleArgument<int>(
+            "copy_stream_id",
+            FLAGS_caffe2_streams_per_gpu)) {}
+
+  bool RunOnDevice() override;
+
+ private:
+  int copy_stream_id_;
+  // Device event the copy stream waits on, null on CPU
+  std::shared_ptr<void> ready_;
+};
+
+// Starts copying the host copy of input 0 back to output 0, like
+// OffloadToHost. Output 1 is the host copy, in place.
+template <class Context>
+class PrefetchToDeviceOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  PrefetchToDeviceOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        copy_stream_id_(OperatorBase::GetSingleArgument<int>(
+            "copy_stream_id",
+            FLAGS_caffe2_streams_per_gpu)) {}
+
+  bool RunOnDevice() override;
+
+ private:
+  int copy_stream_id_;
+  // Device event the copy stream waits on, null on CPU
+  std::shared_ptr<void> ready_;
+};
+
+// Makes the ops that follow wait for the last copy of the host copy of input
+// 0. If it was to the host, frees output 0, the offloaded blob.
+template <class Context>
+class WaitOffloadOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  USE_SIMPLE_CTOR_DTOR(WaitOffloadOp);
+
+  bool RunOnDevice() override;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_OFFLOAD_OPS_H_
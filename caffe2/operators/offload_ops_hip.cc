@@ -0,0 +1,146 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/offload_ops.h"
+#include "hip/hip_runtime.h"
+
+namespace caffe2 {
+
+namespace {
+
+struct HipCopyEvent
+{
+    explicit HipCopyEvent(int gpu_id) : gpu_id(gpu_id)
+    {
+        DeviceGuard guard(gpu_id);
+        HIP_ENFORCE(hipEventCreateWithFlags(&event, hipEventDisableTiming));
+    }
+    ~HipCopyEvent()
+    {
+        DeviceGuard guard(gpu_id);
+        HIP_CHECK(hipEventDestroy(event));
+    }
+
+    hipEvent_t event;
+    int gpu_id;
+};
+
+hipEvent_t CopyEvent(OffloadedTensor* state, int gpu_id)
+{
+    auto* copied = static_cast<HipCopyEvent*>(state->copied.get());
+    if(!copied || copied->gpu_id != gpu_id)
+    {
+        state->copied = std::make_shared<HipCopyEvent>(gpu_id);
+        copied        = static_cast<HipCopyEvent*>(state->copied.get());
+    }
+    return copied->event;
+}
+
+// Queues a copy on the copy stream after the work queued so far on the
+// stream of context, and after the last copy of state, which may have been
+// queued on the copy stream of another thread.
+void StartCopy(OffloadedTensor* state,
+               void* dst,
+               const void* src,
+               size_t nbytes,
+               hipMemcpyKind kind,
+               int copy_stream_id,
+               HIPContext* context,
+               std::shared_ptr<void>* ready_event)
+{
+    const int gpu_id = context->hip_gpu_id();
+    if(!*ready_event)
+    {
+        *ready_event = std::make_shared<HipCopyEvent>(gpu_id);
+    }
+    hipEvent_t ready              = static_cast<HipCopyEvent*>(ready_event->get())->event;
+    const hipStream_t copy_stream = HIPContext::hip_stream(gpu_id, copy_stream_id);
+    hipEvent_t copied             = CopyEvent(state, gpu_id);
+    HIP_ENFORCE(hipStreamWaitEvent(copy_stream, copied, 0));
+    HIP_ENFORCE(hipEventRecord(ready, context->hip_stream()));
+    HIP_ENFORCE(hipStreamWaitEvent(copy_stream, ready, 0));
+    if(nbytes > 0)
+    {
+        HIP_ENFORCE(hipMemcpyAsync(dst, src, nbytes, kind, copy_stream));
+    }
+    HIP_ENFORCE(hipEventRecord(copied, copy_stream));
+}
+
+} // namespace
+
+template <>
+bool OffloadToHostOp<HIPContext>::RunOnDevice()
+{
+    auto& X     = Input(0);
+    auto* state = OperatorBase::Output<OffloadedTensor>(0);
+    // The host tensor is pinned when a GPU is present.
+    state->host.ResizeLike(X);
+    void* host = state->host.raw_mutable_data(X.meta());
+    StartCopy(state,
+              host,
+              X.raw_data(),
+              X.nbytes(),
+              hipMemcpyDeviceToHost,
+              copy_stream_id_,
+              &context_,
+              &ready_);
+    state->on_host = true;
+    return true;
+}
+
+template <>
+bool PrefetchToDeviceOp<HIPContext>::RunOnDevice()
+{
+    auto* state = OperatorBase::Output<OffloadedTensor>(1);
+    auto* X     = Output(0);
+    X->ResizeLike(state->host);
+    void* data = X->raw_mutable_data(state->host.meta());
+    StartCopy(state,
+              data,
+              state->host.raw_data(),
+              state->host.nbytes(),
+              hipMemcpyHostToDevice,
+              copy_stream_id_,
+              &context_,
+              &ready_);
+    state->on_host = false;
+    return true;
+}
+
+template <>
+bool WaitOffloadOp<HIPContext>::RunOnDevice()
+{
+    const auto& state = OperatorBase::Input<OffloadedTensor>(0);
+    auto* copied      = static_cast<HipCopyEvent*>(state.copied.get());
+    if(copied)
+    {
+        HIP_ENFORCE(hipStreamWaitEvent(context_.hip_stream(), copied->event, 0));
+    }
+    if(state.on_host)
+    {
+        // Freed on the stream of the op, after the copy: the caching
+        // allocators only hand the memory out again to work queued after it.
+        OperatorBase::Outputs()[0]->Reset();
+    }
+    return true;
+}
+
+REGISTER_HIP_OPERATOR(OffloadToHost, OffloadToHostOp<HIPContext>);
+REGISTER_HIP_OPERATOR(PrefetchToDevice, PrefetchToDeviceOp<HIPContext>);
+REGISTER_HIP_OPERATOR(WaitOffload, WaitOffloadOp<HIPContext>);
+
+} // namespace caffe2
@@ -35,13 +35,26 @@ namespace caffe2 {
  * the CPU, you can do
  *     REGISTER_HIP_OPERATOR(MyMagic,
  *                            GPUFallbackOp<MyMagicOp, SkipIndices<0>>);
+ *
+ * All copies are issued asynchronously on the op's stream, staged through
+ * the (pinned) CPU tensors of the local workspace, with a single stream sync
+ * per run before the CPU op starts. That sync also guarantees that the
+ * output copies of the previous run are done before the CPU op overwrites
+ * the staging tensors. Inputs that do not change between runs, such as
+ * weights of an inference net, can be listed in the "static_inputs"
+ * argument: they are only copied again when their data pointer or shape
+ * changes.
  */
 template <class CPUOp, typename SkipOutputCopy = SkipIndices<>>
 class GPUFallbackOp final : public Operator<HIPContext>
 {
     public:
     USE_OPERATOR_FUNCTIONS(HIPContext);
-    GPUFallbackOp(const OperatorDef& def, Workspace* ws) : Operator<HIPContext>(def, ws)
+    GPUFallbackOp(const OperatorDef& def, Workspace* ws)
+        : Operator<HIPContext>(def, ws),
+          static_input_(def.input_size(), false),
+          cached_input_data_(def.input_size(), nullptr),
+          cached_input_dims_(def.input_size())
     {
         CAFFE_ENFORCE_EQ(def.device_option().device_type(), HIP);
         OperatorDef base_def_(def);
@@ -54,6 +67,11 @@ class GPUFallbackOp final : public Operator<HIPContext>
             local_input_blobs_.push_back(local_ws_.CreateBlob(name));
             CHECK_NOTNULL(local_input_blobs_.back());
         }
+        for(int i : OperatorBase::GetRepeatedArgument<int>("static_inputs"))
+        {
+            CAFFE_ENFORCE(i >= 0 && i < def.input_size(), "Invalid static input index ", i);
+            static_input_[i] = true;
+        }
         base_op_.reset(new CPUOp(base_def_, &local_ws_));
         for(const string& name : def.output())
         {
@@ -64,14 +82,25 @@ class GPUFallbackOp final : public Operator<HIPContext>
 
     bool RunOnDevice() override
     {
-        bool need_sync = false;
+        // The output copies of the previous run read from the local output
+        // tensors, so they have to be done before the CPU op runs again.
+        bool need_sync = outputs_in_flight_;
         for(int i = 0; i < InputSize(); ++i)
         {
             if(OperatorBase::InputIsType<TensorHIP>(i))
             {
-                local_input_blobs_[i]->template GetMutable<TensorCPU>()->CopyFrom(Input(i),
+                const auto& input = Input(i);
+                if(static_input_[i] && cached_input_data_[i] == input.raw_data() &&
+                   cached_input_dims_[i] == input.dims())
+                {
+                    VLOG(1) << "Input " << i << " is static and unchanged. Skipping copy.";
+                    continue;
+                }
+                local_input_blobs_[i]->template GetMutable<TensorCPU>()->CopyFrom(input,
                                                                                   &context_);
-                need_sync = true;
+                cached_input_data_[i] = input.raw_data();
+                cached_input_dims_[i] = input.dims();
+                need_sync             = true;
             }
             else
             {
@@ -82,6 +111,7 @@ class GPUFallbackOp final : public Operator<HIPContext>
                 local_input_blobs_[i]->ShareExternal(
                     const_cast<void*>(OperatorBase::Inputs()[i]->GetRaw()),
                     OperatorBase::Inputs()[i]->meta());
+                cached_input_data_[i] = nullptr;
             }
         }
 
@@ -90,6 +120,7 @@ class GPUFallbackOp final : public Operator<HIPContext>
         {
             context_.FinishDeviceComputation();
         }
+        outputs_in_flight_ = false;
 
         if(!base_op_->Run())
         {
@@ -108,6 +139,7 @@ class GPUFallbackOp final : public Operator<HIPContext>
                           "GPU fallback op currently does not support non-TensorCPU "
                           "output type who needs copying.");
             Output(i)->CopyFrom(local_output_blobs_[i]->template Get<TensorCPU>(), &context_);
+            outputs_in_flight_ = true;
         }
         return true;
     }
@@ -117,6 +149,10 @@ class GPUFallbackOp final : public Operator<HIPContext>
     vector<Blob*> local_input_blobs_;
     vector<Blob*> local_output_blobs_;
     std::unique_ptr<CPUOp> base_op_;
+    vector<bool> static_input_;
+    vector<const void*> cached_input_data_;
+    vector<vector<TIndex>> cached_input_dims_;
+    bool outputs_in_flight_ = false;
 };
 
 } // namespace caffe2
@@ -82,4 +82,41 @@ TEST(OperatorFallbackTest, GPUIncrementByOneOp)
     }
 }
 
+TEST(OperatorFallbackTest, GPUIncrementByOneOpStaticInput)
+{
+    if(!HasHipGPU())
+        return;
+    OperatorDef op_def =
+        CreateOperatorDef("IncrementByOne", "", vector<string>{"X"}, vector<string>{"Y"});
+    op_def.mutable_device_option()->set_device_type(HIP);
+    AddArgument<vector<int>>("static_inputs", vector<int>{0}, &op_def);
+    Workspace ws;
+    TensorCPU source_tensor(vector<TIndex>{2, 3});
+    for(int i = 0; i < 6; ++i)
+    {
+        source_tensor.mutable_data<float>()[i] = i;
+    }
+    ws.CreateBlob("X")->GetMutable<TensorHIP>()->CopyFrom(source_tensor);
+    unique_ptr<OperatorBase> op(CreateOperator(op_def, &ws));
+    EXPECT_TRUE(op.get() != nullptr);
+    for(int run = 0; run < 2; ++run)
+    {
+        EXPECT_TRUE(op->Run());
+        TensorCPU output_cpu(ws.GetBlob("Y")->Get<TensorHIP>());
+        EXPECT_EQ(output_cpu.dim(0), 2);
+        EXPECT_EQ(output_cpu.dim(1), 3);
+        for(int i = 0; i < 6; ++i)
+        {
+            EXPECT_EQ(output_cpu.data<float>()[i], i + 1);
+        }
+    }
+    // A change of shape invalidates the cached copy.
+    source_tensor.Resize(3, 2);
+    ws.GetBlob("X")->GetMutable<TensorHIP>()->CopyFrom(source_tensor);
+    EXPECT_TRUE(op->Run());
+    TensorCPU output_cpu(ws.GetBlob("Y")->Get<TensorHIP>());
+    EXPECT_EQ(output_cpu.dim(0), 3);
+    EXPECT_EQ(output_cpu.dim(1), 2);
+}
+
 } // namespace caffe2
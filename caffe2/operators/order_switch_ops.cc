@@ -16,8 +16,43 @@
 
 #include "caffe2/operators/order_switch_ops.h"
 
+#include <algorithm>
+
 namespace caffe2 {
 
+namespace {
+
+// Transposes each of the N rows x cols matrices of X into Y, in tiles small
+// enough for the reads and the writes of a tile to stay in cache.
+void TransposeImages(
+    const int N,
+    const int rows,
+    const int cols,
+    const float* X,
+    float* Y) {
+  constexpr int kTile = 32;
+  const size_t image_size = static_cast<size_t>(rows) * cols;
+  CPUContext::ParallelFor(N, 1, [&](size_t begin, size_t end) {
+    for (size_t n = begin; n < end; ++n) {
+      const float* x = X + n * image_size;
+      float* y = Y + n * image_size;
+      for (int i0 = 0; i0 < rows; i0 += kTile) {
+        const int i1 = std::min(i0 + kTile, rows);
+        for (int j0 = 0; j0 < cols; j0 += kTile) {
+          const int j1 = std::min(j0 + kTile, cols);
+          for (int i = i0; i < i1; ++i) {
+            for (int j = j0; j < j1; ++j) {
+              y[j * rows + i] = x[i * cols + j];
+            }
+          }
+        }
+      }
+    }
+  });
+}
+
+} // namespace
+
 template <>
 bool NHWC2NCHWOp<float, CPUContext>::RunOnDevice() {
   auto& X = Input(0);
@@ -25,17 +60,7 @@ bool NHWC2NCHWOp<float, CPUContext>::RunOnDevice() {
   CAFFE_ENFORCE(X.ndim() == 4);
   const int N = X.dim32(0), H = X.dim32(1), W = X.dim32(2), C = X.dim32(3);
   Y->Resize(N, C, H, W);
-  const float* Xdata = X.data<float>();
-  float* Ydata = Y->mutable_data<float>();
-  for (int n = 0; n < N; ++n) {
-    for (int h = 0; h < H; ++h) {
-      for (int w = 0; w < W; ++w) {
-        for (int c = 0; c < C; ++c) {
-          Ydata[((n * C + c) * H + h) * W + w] = *(Xdata++);
-        }
-      }
-    }
-  }
+  TransposeImages(N, H * W, C, X.data<float>(), Y->mutable_data<float>());
   return true;
 }
 
@@ -46,17 +71,7 @@ bool NCHW2NHWCOp<float, CPUContext>::RunOnDevice() {
   CAFFE_ENFORCE(X.ndim() == 4);
   const int N = X.dim32(0), C = X.dim32(1), H = X.dim32(2), W = X.dim32(3);
   Y->Resize(N, H, W, C);
-  const float* Xdata = X.data<float>();
-  float* Ydata = Y->mutable_data<float>();
-  for (int n = 0; n < N; ++n) {
-    for (int c = 0; c < C; ++c) {
-      for (int h = 0; h < H; ++h) {
-        for (int w = 0; w < W; ++w) {
-          Ydata[((n * H + h) * W + w) * C + c] = *(Xdata++);
-        }
-      }
-    }
-  }
+  TransposeImages(N, C, H * W, X.data<float>(), Y->mutable_data<float>());
   return true;
 }
 
@@ -0,0 +1,189 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/pack_rnn_sequence_op.h"
+
+namespace caffe2 {
+
+namespace {
+// Both kernels walk the packed T x N x D layout, one thread per item, and map
+// item (r, c, k) to row offsets[c] + r of the sequence when r < lengths[c].
+template <typename T>
+__global__ void PackRNNSequenceKernel(const int64_t N,
+                                      const int cols,
+                                      const int64_t block_size,
+                                      const int* lengths,
+                                      const int* offsets,
+                                      const T* values,
+                                      T* out)
+{
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        const int64_t item = i / block_size;
+        const int r        = item / cols;
+        const int c        = item % cols;
+        out[i]             = r < lengths[c]
+                     ? values[(offsets[c] + r) * block_size + i % block_size]
+                     : T(0);
+    }
+}
+
+template <typename T>
+__global__ void UnpackRNNSequenceKernel(const int64_t N,
+                                        const int cols,
+                                        const int64_t block_size,
+                                        const int* lengths,
+                                        const int* offsets,
+                                        const T* values,
+                                        T* out)
+{
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        const int64_t item = i / block_size;
+        const int r        = item / cols;
+        const int c        = item % cols;
+        if(r < lengths[c])
+        {
+            out[(offsets[c] + r) * block_size + i % block_size] = values[i];
+        }
+    }
+}
+
+template <bool Forward>
+class HIPPackRNNSequenceOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPPackRNNSequenceOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        return DispatchHelper<TensorTypes<int32_t, int64_t, float, double>>::call(this,
+                                                                                  Input(0));
+    }
+
+    template <typename ValT>
+    bool DoRunWithType()
+    {
+        // The value is copied from the sequence to the pack
+        // if Forward is true, and vice versa
+        const int dim_offset = Forward ? 1 : 2;
+        auto& values         = Input(INPUTVALUE);
+        CAFFE_ENFORCE_GT(values.ndim(), dim_offset);
+        const TIndex block_size = values.size_from_dim(dim_offset);
+
+        auto& lengths = Input(LENGTHS);
+        CAFFE_ENFORCE_EQ(lengths.ndim(), 1);
+        const int cols = lengths.size();
+
+        // rows and the output size come from the lengths, so they are read
+        // back once and their exclusive prefix sum is built on the host
+        lengths_host_.CopyFrom(lengths, &context_);
+        context_.FinishDeviceComputation();
+        const int32_t* lengths_ptr = lengths_host_.data<int32_t>();
+        offsets_host_.Resize(cols);
+        int* offsets_ptr = offsets_host_.mutable_data<int>();
+        int rows         = 0;
+        int length_sum   = 0;
+        for(int c = 0; c < cols; ++c)
+        {
+            offsets_ptr[c] = length_sum;
+            length_sum += lengths_ptr[c];
+            rows = std::max(rows, lengths_ptr[c]);
+        }
+        CAFFE_ENFORCE_GE(rows, 0);
+        if(!Forward)
+        {
+            CAFFE_ENFORCE_GE(values.dim(0), rows);
+            CAFFE_ENFORCE_EQ(values.dim(1), cols);
+        }
+
+        vector<TIndex> shape;
+        // the output shape is rows * cols for the pack,
+        // or length_sum for the sequence
+        if(Forward)
+        {
+            shape.push_back(rows);
+            shape.push_back(cols);
+        }
+        else
+        {
+            shape.push_back(length_sum);
+        }
+        // insert the dim for the feature
+        shape.insert(shape.end(), values.dims().begin() + dim_offset, values.dims().end());
+
+        auto* output = Output(OUTPUTVALUE);
+        output->Resize(shape);
+        ValT* output_data = output->template mutable_data<ValT>();
+
+        const int64_t N = static_cast<int64_t>(rows) * cols * block_size;
+        if(N == 0)
+        {
+            return true;
+        }
+        offsets_.CopyFrom(offsets_host_, &context_);
+
+        if(Forward)
+        {
+            hipLaunchKernelGGL((PackRNNSequenceKernel<ValT>),
+                               dim3(CAFFE_GET_BLOCKS(N)),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context_.hip_stream(),
+                               N,
+                               cols,
+                               static_cast<int64_t>(block_size),
+                               lengths.template data<int32_t>(),
+                               offsets_.template data<int>(),
+                               values.template data<ValT>(),
+                               output_data);
+        }
+        else
+        {
+            hipLaunchKernelGGL((UnpackRNNSequenceKernel<ValT>),
+                               dim3(CAFFE_GET_BLOCKS(N)),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context_.hip_stream(),
+                               N,
+                               cols,
+                               static_cast<int64_t>(block_size),
+                               lengths.template data<int32_t>(),
+                               offsets_.template data<int>(),
+                               values.template data<ValT>(),
+                               output_data);
+        }
+        return true;
+    }
+
+    private:
+    INPUT_TAGS(INPUTVALUE, LENGTHS);
+    OUTPUT_TAGS(OUTPUTVALUE);
+
+    TensorCPU lengths_host_;
+    TensorCPU offsets_host_;
+    Tensor<HIPContext> offsets_;
+};
+} // namespace
+
+REGISTER_HIP_OPERATOR(PackRNNSequence, HIPPackRNNSequenceOp<true>);
+REGISTER_HIP_OPERATOR(UnpackRNNSequence, HIPPackRNNSequenceOp<false>);
+} // namespace caffe2
@@ -0,0 +1,173 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/perfkernels/packed_sgemm.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Number of weight elements folded into the fingerprint checked on every run.
+constexpr size_t kFingerprintSamples = 64;
+
+uint64_t MixIn(uint64_t hash, float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  hash ^= bits;
+  return hash * 0x100000001b3ULL;
+}
+
+} // namespace
+
+// FC with the weight packed once into the panels PackedSgemm reads, instead of
+// letting math::Gemm repack it on every call. Like the MKL PACKED engine it
+// caches the packed weight across runs, but it repacks whenever the weight
+// blob is reallocated, reshaped or its sampled fingerprint changes, so it is
+// safe to use while the weight is still being written to between runs.
+class PackedSgemmFCOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  PackedSgemmFCOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        axis_(OperatorBase::GetSingleArgument<int32_t>("axis", 1)),
+        axis_w_(OperatorBase::GetSingleArgument<int32_t>("axis_w", 1)) {}
+  ~PackedSgemmFCOp() {}
+
+  bool RunOnDevice() override {
+    const auto& X = Input(0);
+    const auto& W = Input(1);
+    const auto& b = Input(2);
+    auto* Y = Output(0);
+    CAFFE_ENFORCE(b.ndim() == 1, b.ndim());
+    const auto canonical_axis = X.canonical_axis_index(axis_);
+    const auto M = X.size_to_dim(canonical_axis);
+    const auto K = X.size_from_dim(canonical_axis);
+    const auto canonical_axis_w = W.canonical_axis_index(axis_w_);
+    const int N = W.size_to_dim(canonical_axis_w);
+
+    auto dimErrorString = [&]() {
+      return MakeString(
+          "Dimension mismatch: ",
+          "X: ",
+          X.dims(),
+          ", W: ",
+          W.dims(),
+          ", b: ",
+          b.dims(),
+          ", axis: ",
+          axis_,
+          ", M: ",
+          M,
+          ", N: ",
+          N,
+          ", K: ",
+          K);
+    };
+
+    CAFFE_ENFORCE(M == X.size() / K, dimErrorString());
+    CAFFE_ENFORCE(K == W.size() / N, dimErrorString());
+    CAFFE_ENFORCE(N == b.dim32(0), dimErrorString());
+    CAFFE_ENFORCE(N == b.size(), dimErrorString());
+
+    Y_shape_cache_ = X.dims();
+    // This is an invariant of canonical_axis, so we can DCHECK.
+    DCHECK_LE(canonical_axis + 1, Y_shape_cache_.size());
+    Y_shape_cache_.resize(canonical_axis + 1);
+    Y_shape_cache_[canonical_axis] = N;
+    Y->Resize(Y_shape_cache_);
+    CAFFE_ENFORCE(M * N == Y->size(), dimErrorString());
+
+    if (X.size() == 0) {
+      // skip the rest of the computation if X is empty
+      Y->mutable_data<float>();
+      return true;
+    }
+
+    const float* W_data = W.data<float>();
+    const uint64_t fingerprint = Fingerprint(W_data, W.size());
+    if (W_data != packed_source_ || N != packed_N_ || K != packed_K_ ||
+        fingerprint != packed_fingerprint_) {
+      packed_.Resize(PackedSgemmSize(N, K));
+      PackedSgemmPack(N, K, W_data, packed_.mutable_data<float>());
+      packed_source_ = W_data;
+      packed_N_ = N;
+      packed_K_ = K;
+      packed_fingerprint_ = fingerprint;
+      packed_hash_ = Hash(W_data, W.size());
+    }
+    // The fingerprint only samples the weight, so in debug mode also make
+    // sure that no element changed in place behind its back.
+    DCHECK_EQ(packed_hash_, Hash(W_data, W.size()))
+        << "The weight of FC with the PACKED_SGEMM engine changed in place "
+           "without changing its sampled elements, so the packed copy is "
+           "stale.";
+
+    PackedSgemm(
+        M,
+        N,
+        K,
+        X.data<float>(),
+        packed_.data<float>(),
+        b.data<float>(),
+        Y->mutable_data<float>(),
+        N);
+    return true;
+  }
+
+ protected:
+  // Hashes kFingerprintSamples evenly spaced elements, including the first
+  // and the last one.
+  static uint64_t Fingerprint(const float* ptr, size_t n) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    if (n <= kFingerprintSamples) {
+      for (size_t i = 0; i < n; ++i) {
+        hash = MixIn(hash, ptr[i]);
+      }
+      return hash;
+    }
+    for (size_t i = 0; i < kFingerprintSamples; ++i) {
+      hash = MixIn(hash, ptr[i * (n - 1) / (kFingerprintSamples - 1)]);
+    }
+    return hash;
+  }
+  static uint64_t Hash(const float* ptr, size_t n) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < n; ++i) {
+      hash = MixIn(hash, ptr[i]);
+    }
+    return hash;
+  }
+
+  size_t axis_{1};
+  size_t axis_w_{1};
+  vector<TIndex> Y_shape_cache_;
+  Tensor<CPUContext> packed_;
+  const float* packed_source_{nullptr};
+  int packed_N_{-1};
+  TIndex packed_K_{-1};
+  uint64_t packed_fingerprint_{0};
+  uint64_t packed_hash_{0};
+};
+
+REGISTER_CPU_OPERATOR_WITH_ENGINE(FC, PACKED_SGEMM, PackedSgemmFCOp);
+
+} // namespace caffe2
@@ -0,0 +1,61 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_OPERATORS_PACKED_STRINGS_H_
+#define CAFFE2_OPERATORS_PACKED_STRINGS_H_
+
+#include <vector>
+
+#include "caffe2/core/logging.h"
+#include "caffe2/core/tensor.h"
+
+namespace caffe2 {
+
+/**
+ * Packed strings hold a tensor of strings without a std::string per element:
+ * a uint8 data tensor with the bytes of all the strings back to back, and an
+ * int32 lengths tensor of the shape of the string tensor with the size of
+ * each string. StringPack and StringUnpack convert them from and to a
+ * Tensor<std::string>.
+ *
+ * Checks data and lengths and fills offsets with the position of each string
+ * in data, followed by the size of data.
+ */
+inline void PackedStringOffsets(
+    const TensorCPU& data,
+    const TensorCPU& lengths,
+    std::vector<int64_t>* offsets) {
+  CAFFE_ENFORCE(
+      data.IsType<uint8_t>(),
+      "Packed strings data should be uint8, got ",
+      data.meta().name());
+  CAFFE_ENFORCE_EQ(data.ndim(), 1, "Packed strings data should be 1-D");
+  const auto* lengths_data = lengths.data<int>();
+  offsets->resize(lengths.size() + 1);
+  int64_t offset = 0;
+  for (TIndex i = 0; i < lengths.size(); ++i) {
+    CAFFE_ENFORCE_GE(lengths_data[i], 0, "Negative string length");
+    (*offsets)[i] = offset;
+    offset += lengths_data[i];
+  }
+  (*offsets)[lengths.size()] = offset;
+  CAFFE_ENFORCE_EQ(
+      offset, data.size(), "Lengths don't add up to the size of data");
+}
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_PACKED_STRINGS_H_
@@ -17,6 +17,9 @@
 #ifndef CAFFE2_OPERATORS_PARTITION_OPS_H_
 #define CAFFE2_OPERATORS_PARTITION_OPS_H_
 
+#include <algorithm>
+#include <cstring>
+
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
 
@@ -30,6 +33,78 @@ static inline int moduloPartition(Index key, int numPartitions) {
   return shard;
 }
 
+// The keys are histogrammed and scattered in up to kPartitionMaxChunks chunks
+// of at least kPartitionChunkSize keys, on separate threads. Chunk c covers
+// the keys [n * c / num_chunks, n * (c + 1) / num_chunks).
+constexpr TIndex kPartitionChunkSize = 16384;
+constexpr TIndex kPartitionMaxChunks = 64;
+
+static inline int numPartitionChunks(TIndex n) {
+  return std::max<TIndex>(
+      1, std::min(n / kPartitionChunkSize, kPartitionMaxChunks));
+}
+
+static inline TIndex partitionChunkBegin(TIndex n, int numChunks, int chunk) {
+  return n * chunk / numChunks;
+}
+
+// Counting sort of the n keys by shard: stores the shard of every key into
+// shards, the number of keys of every shard into counts and, at
+// chunkOffsets[chunk * numPartitions + shard], the index within the shard of
+// the first key of the chunk that goes to the shard, which lets every chunk
+// scatter its keys independently while keeping their order.
+template <typename Index>
+void partitionOffsets(
+    const Index* keys,
+    TIndex n,
+    int numPartitions,
+    int numChunks,
+    vector<int>* shards,
+    vector<TIndex>* counts,
+    vector<TIndex>* chunkOffsets) {
+  shards->resize(n);
+  chunkOffsets->assign(numChunks * numPartitions, 0);
+  int* shardsData = shards->data();
+  TIndex* offsetsData = chunkOffsets->data();
+  CPUContext::ParallelFor(numChunks, 1, [&](size_t begin, size_t end) {
+    for (size_t c = begin; c < end; ++c) {
+      TIndex* chunkCounts = offsetsData + c * numPartitions;
+      const TIndex last = partitionChunkBegin(n, numChunks, c + 1);
+      for (TIndex p = partitionChunkBegin(n, numChunks, c); p < last; ++p) {
+        const int shard = moduloPartition(keys[p], numPartitions);
+        shardsData[p] = shard;
+        ++chunkCounts[shard];
+      }
+    }
+  });
+  counts->assign(numPartitions, 0);
+  for (int c = 0; c < numChunks; ++c) {
+    for (int j = 0; j < numPartitions; ++j) {
+      const TIndex chunkCount = offsetsData[c * numPartitions + j];
+      offsetsData[c * numPartitions + j] = (*counts)[j];
+      (*counts)[j] += chunkCount;
+    }
+  }
+}
+
+// Copies a block of the given number of bytes of a type without a copy
+// function, with a fixed size copy for the common 4 and 8 byte blocks.
+static inline void copyPartitionBlock(
+    size_t nbytes,
+    const char* src,
+    char* dst) {
+  switch (nbytes) {
+    case 4:
+      memcpy(dst, src, 4);
+      break;
+    case 8:
+      memcpy(dst, src, 8);
+      break;
+    default:
+      memcpy(dst, src, nbytes);
+  }
+}
+
 class GatherByKeyOp : public Operator<CPUContext> {
  public:
   USE_DISPATCH_HELPER;
@@ -84,37 +159,62 @@ class GatherByKeyOp : public Operator<CPUContext> {
     for (int i = 0; i < numPartitions; ++i) {
       inputDatas_[i] = static_cast<const char*>(Input(i + 1).raw_data());
     }
-    inStartOffsets_.assign(numPartitions, 0);
-    Index outStartOffset = 0;
-    int currentShard = -1;
 
-    // 2. copy from inputs into output based on shard for each input key
+    // 2. find where the keys of every chunk start in each input
     const auto numEntries = keysTensor.size();
-    for (int64_t i = 0; i <= numEntries; ++i) {
-      auto newShard =
-          i < numEntries ? moduloPartition(keysData[i], numPartitions) : -1;
-      if (newShard != currentShard) {
-        if (currentShard != -1) {
-          auto inStartOffset = inStartOffsets_[currentShard];
-          auto numItems = i - outStartOffset;
+    const int numChunks = numPartitionChunks(numEntries);
+    partitionOffsets(
+        keysData,
+        numEntries,
+        numPartitions,
+        numChunks,
+        &shards_,
+        &counts_,
+        &chunkOffsets_);
+    for (int i = 0; i < numPartitions; ++i) {
+      CAFFE_ENFORCE_EQ(
+          counts_[i],
+          Input(i + 1).dim(0),
+          "Number of keys of shard ",
+          i,
+          " does not match the size of its input");
+    }
+
+    // 3. copy from inputs into output based on shard for each input key, in
+    // runs of consecutive keys of the same shard
+    const size_t itemBytes = blockSize * meta.itemsize();
+    CPUContext::ParallelFor(numChunks, 1, [&](size_t begin, size_t end) {
+      for (size_t c = begin; c < end; ++c) {
+        const TIndex* inStartOffsets = chunkOffsets_.data() + c * numPartitions;
+        std::vector<TIndex> inOffsets(
+            inStartOffsets, inStartOffsets + numPartitions);
+        const TIndex last = partitionChunkBegin(numEntries, numChunks, c + 1);
+        TIndex i = partitionChunkBegin(numEntries, numChunks, c);
+        while (i < last) {
+          const int shard = shards_[i];
+          TIndex runEnd = i + 1;
+          while (runEnd < last && shards_[runEnd] == shard) {
+            ++runEnd;
+          }
+          const TIndex numItems = runEnd - i;
           context_.template CopyItems<CPUContext, CPUContext>(
               meta,
               numItems * blockSize,
-              inputDatas_[currentShard] +
-                  inStartOffset * blockSize * meta.itemsize(),
-              outData + outStartOffset * blockSize * meta.itemsize());
-          inStartOffsets_[currentShard] += numItems;
+              inputDatas_[shard] + inOffsets[shard] * itemBytes,
+              outData + i * itemBytes);
+          inOffsets[shard] += numItems;
+          i = runEnd;
         }
-        currentShard = newShard;
-        outStartOffset = i;
       }
-    }
+    });
 
     return true;
   }
 
   std::vector<const char*> inputDatas_;
-  std::vector<int64_t> inStartOffsets_;
+  std::vector<int> shards_;
+  std::vector<TIndex> counts_;
+  std::vector<TIndex> chunkOffsets_;
 };
 
 class PartitionOpBase : public Operator<CPUContext> {
@@ -140,11 +240,9 @@ class PartitionOpBase : public Operator<CPUContext> {
     auto& main_input = Input(mainInputIndex);
     TIndex size = main_input.size();
     const Index* data = main_input.template data<Index>();
-    counts_.assign(partitions, 0);
-    for (TIndex p = 0; p < size; p++) {
-      int shard = moduloPartition(data[p], partitions);
-      ++counts_[shard];
-    }
+    const int numChunks = numPartitionChunks(size);
+    partitionOffsets(
+        data, size, partitions, numChunks, &shards_, &counts_, &chunk_offsets_);
 
     raw_datas_.resize(inputSize);
     block_sizes_.resize(inputSize);
@@ -185,34 +283,52 @@ class PartitionOpBase : public Operator<CPUContext> {
       }
     }
 
-    counts_.assign(partitions, 0);
-    for (TIndex p = 0; p < size; p++) {
-      int shard = moduloPartition(data[p], partitions);
-      TIndex idx = counts_[shard]++;
-
-      // special case first input
-      static_cast<Index*>(out_datas_[shard * inputSize + mainInputIndex])[idx] =
-          pack_first_input_ ? ((data[p] - shard) / partitions) : data[p];
-
-      int baseIndex = shard * inputSize;
-      for (int i = mainInputIndex + 1; i < inputSize; ++i) {
-        auto bs = block_sizes_[i];
-        auto meta = metas_[i];
-        // special case for small bs?
-        context_.template CopyItems<CPUContext, CPUContext>(
-            meta,
-            bs,
-            static_cast<const char*>(raw_datas_[i]) + p * bs * meta.itemsize(),
-            static_cast<char*>(out_datas_[baseIndex + i]) +
-                idx * bs * meta.itemsize());
+    // Every chunk scatters its elements, one input at a time, to the
+    // positions of its keys within their shards.
+    CPUContext::ParallelFor(numChunks, 1, [&](size_t begin, size_t end) {
+      std::vector<TIndex> offsets(partitions);
+      for (size_t c = begin; c < end; ++c) {
+        const TIndex first = partitionChunkBegin(size, numChunks, c);
+        const TIndex last = partitionChunkBegin(size, numChunks, c + 1);
+        const TIndex* chunkOffsets = chunk_offsets_.data() + c * partitions;
+
+        // special case first input
+        offsets.assign(chunkOffsets, chunkOffsets + partitions);
+        for (TIndex p = first; p < last; ++p) {
+          const int shard = shards_[p];
+          auto* out = static_cast<Index*>(
+              out_datas_[shard * inputSize + mainInputIndex]);
+          out[offsets[shard]++] =
+              pack_first_input_ ? ((data[p] - shard) / partitions) : data[p];
+        }
+
+        for (int i = mainInputIndex + 1; i < inputSize; ++i) {
+          const auto& meta = metas_[i];
+          const auto bs = block_sizes_[i];
+          const size_t nbytes = bs * meta.itemsize();
+          const char* src = static_cast<const char*>(raw_datas_[i]);
+          offsets.assign(chunkOffsets, chunkOffsets + partitions);
+          for (TIndex p = first; p < last; ++p) {
+            const int shard = shards_[p];
+            char* dst = static_cast<char*>(out_datas_[shard * inputSize + i]) +
+                offsets[shard]++ * nbytes;
+            if (meta.copy()) {
+              meta.copy()(src + p * nbytes, dst, bs);
+            } else {
+              copyPartitionBlock(nbytes, src + p * nbytes, dst);
+            }
+          }
+        }
       }
-    }
+    });
   }
 
   bool pack_first_input_;
 
   // use member fields to reuse memory
+  vector<int> shards_;
   vector<TIndex> counts_;
+  vector<TIndex> chunk_offsets_;
   vector<TIndex> block_sizes_;
   vector<TypeMeta> metas_;
   vector<const void*> raw_datas_;
@@ -267,10 +383,10 @@ class LengthsPartitionOp : public PartitionOpBase {
     // Apply sharding to all parameters except lengths
     ApplyPartition<Index>(true /* skipFirstArgument */);
 
-    // Compute lengths after sharding
+    // Compute lengths after sharding, from the shards of the keys left in
+    // shards_ by ApplyPartition
     auto& main_input = Input(1);
     TIndex size = main_input.size();
-    const Index* data = main_input.template data<Index>();
 
     auto& length_input = Input(0);
     TIndex elements = length_input.size();
@@ -296,8 +412,7 @@ class LengthsPartitionOp : public PartitionOpBase {
         out_length_[j][i] = 0;
       }
       for (int j = 0; j < lengths_data[i]; ++j, ++index) {
-        int shard = moduloPartition(data[index], partitions);
-        ++out_length_[shard][i];
+        ++out_length_[shards_[index]][i];
       }
     }
     return true;
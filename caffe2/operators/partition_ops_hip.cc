@@ -0,0 +1,635 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <hipcub/hipcub.hpp>
+#include <limits>
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/partition_ops.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Number of keys every thread of the counting and ranking kernels goes
+// through in order, so that the keys of a shard keep their order.
+constexpr int kKeysPerThread = 64;
+
+template <typename Index>
+__device__ int DeviceModuloPartition(const Index key, const int num_partitions)
+{
+    const int shard = key % num_partitions;
+    return shard < 0 ? shard + num_partitions : shard;
+}
+
+// Stores the shard of every key and counts the keys of every chunk of
+// kKeysPerThread keys that go to each shard, into the shard major counts.
+template <typename Index>
+__global__ void ShardCountKernel(const int N,
+                                 const int num_chunks,
+                                 const int num_partitions,
+                                 const Index* keys,
+                                 int* shards,
+                                 int* counts)
+{
+    HIP_1D_KERNEL_LOOP(c, num_chunks)
+    {
+        const int last = min(N, static_cast<int>(c + 1) * kKeysPerThread);
+        for(int i = static_cast<int>(c) * kKeysPerThread; i < last; ++i)
+        {
+            const int shard = DeviceModuloPartition(keys[i], num_partitions);
+            shards[i]       = shard;
+            ++counts[shard * num_chunks + c];
+        }
+    }
+}
+
+// From the exclusive prefix sum of the shard major counts, gives the start of
+// every shard in the keys ordered by shard. starts[num_partitions] is N.
+__global__ void ShardStartsKernel(
+    const int N, const int num_chunks, const int num_partitions, const int* offsets, int* starts)
+{
+    HIP_1D_KERNEL_LOOP(s, num_partitions + 1)
+    {
+        starts[s] = s < num_partitions ? offsets[s * num_chunks] : N;
+    }
+}
+
+// Gives every key its position within its shard, advancing the offsets of its
+// chunk.
+__global__ void ShardRankKernel(const int N,
+                                const int num_chunks,
+                                const int* shards,
+                                const int* starts,
+                                int* offsets,
+                                int* positions)
+{
+    HIP_1D_KERNEL_LOOP(c, num_chunks)
+    {
+        const int last = min(N, static_cast<int>(c + 1) * kKeysPerThread);
+        for(int i = static_cast<int>(c) * kKeysPerThread; i < last; ++i)
+        {
+            const int shard = shards[i];
+            positions[i]    = offsets[shard * num_chunks + c]++ - starts[shard];
+        }
+    }
+}
+
+template <typename Index>
+__global__ void ScatterKeysKernel(const int N,
+                                  const int num_partitions,
+                                  const bool pack,
+                                  const int* shards,
+                                  const int* positions,
+                                  const Index* keys,
+                                  Index* const* out)
+{
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        const int shard          = shards[i];
+        out[shard][positions[i]] = pack ? (keys[i] - shard) / num_partitions : keys[i];
+    }
+}
+
+template <typename W>
+__global__ void ScatterBlocksKernel(const int N,
+                                    const int words,
+                                    const int* shards,
+                                    const int* positions,
+                                    const W* src,
+                                    W* const* dst)
+{
+    HIP_1D_KERNEL_LOOP(i, static_cast<size_t>(N) * words)
+    {
+        const size_t k = i / words;
+        dst[shards[k]][static_cast<size_t>(positions[k]) * words + i - k * words] = src[i];
+    }
+}
+
+template <typename W>
+__global__ void GatherBlocksKernel(const int N,
+                                   const int words,
+                                   const int* shards,
+                                   const int* positions,
+                                   const W* const* src,
+                                   W* dst)
+{
+    HIP_1D_KERNEL_LOOP(i, static_cast<size_t>(N) * words)
+    {
+        const size_t k = i / words;
+        dst[i] = src[shards[k]][static_cast<size_t>(positions[k]) * words + i - k * words];
+    }
+}
+
+// Counts the keys of every shard in each segment of the lengths, one thread
+// per segment.
+__global__ void ShardLengthsKernel(const int num_segments,
+                                   const int num_partitions,
+                                   const int* lengths,
+                                   const int* segment_offsets,
+                                   const int* shards,
+                                   int* const* out_lengths)
+{
+    HIP_1D_KERNEL_LOOP(i, num_segments)
+    {
+        for(int s = 0; s < num_partitions; ++s)
+        {
+            out_lengths[s][i] = 0;
+        }
+        const int last = segment_offsets[i] + lengths[i];
+        for(int j = segment_offsets[i]; j < last; ++j)
+        {
+            ++out_lengths[shards[j]][i];
+        }
+    }
+}
+
+// Copies N blocks of nbytes between src and the rows of the shards, in words
+// of the largest size that divides nbytes.
+template <typename W>
+void LaunchCopyBlocks(const bool gather,
+                      const int N,
+                      const size_t nbytes,
+                      const int* shards,
+                      const int* positions,
+                      const void* src,
+                      void* const* ptrs,
+                      void* dst,
+                      HIPContext* context)
+{
+    const int words = nbytes / sizeof(W);
+    if(gather)
+    {
+        hipLaunchKernelGGL((GatherBlocksKernel<W>),
+                           dim3(CAFFE_GET_BLOCKS(static_cast<size_t>(N) * words)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context->hip_stream(),
+                           N,
+                           words,
+                           shards,
+                           positions,
+                           reinterpret_cast<const W* const*>(ptrs),
+                           static_cast<W*>(dst));
+    }
+    else
+    {
+        hipLaunchKernelGGL((ScatterBlocksKernel<W>),
+                           dim3(CAFFE_GET_BLOCKS(static_cast<size_t>(N) * words)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context->hip_stream(),
+                           N,
+                           words,
+                           shards,
+                           positions,
+                           static_cast<const W*>(src),
+                           reinterpret_cast<W* const*>(ptrs));
+    }
+}
+
+void CopyBlocks(const bool gather,
+                const int N,
+                const size_t nbytes,
+                const int* shards,
+                const int* positions,
+                const void* src,
+                void* const* ptrs,
+                void* dst,
+                HIPContext* context)
+{
+    if(N == 0 || nbytes == 0)
+    {
+        return;
+    }
+    if(nbytes % sizeof(uint64_t) == 0)
+    {
+        LaunchCopyBlocks<uint64_t>(
+            gather, N, nbytes, shards, positions, src, ptrs, dst, context);
+    }
+    else if(nbytes % sizeof(uint32_t) == 0)
+    {
+        LaunchCopyBlocks<uint32_t>(
+            gather, N, nbytes, shards, positions, src, ptrs, dst, context);
+    }
+    else if(nbytes % sizeof(uint16_t) == 0)
+    {
+        LaunchCopyBlocks<uint16_t>(
+            gather, N, nbytes, shards, positions, src, ptrs, dst, context);
+    }
+    else
+    {
+        LaunchCopyBlocks<uint8_t>(gather, N, nbytes, shards, positions, src, ptrs, dst, context);
+    }
+}
+
+} // namespace
+
+// The keys are sorted by shard with a stable counting sort: chunks of
+// kKeysPerThread keys are histogrammed, the exclusive prefix sum of the shard
+// major histograms gives every chunk the start of its keys in each shard, and
+// the chunks rank their keys in order. The blocks are then moved one per
+// thread to their rank in the output of their shard, whose pointers are
+// passed to the kernels in a table.
+class HIPPartitionOpBase : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+
+    HIPPartitionOpBase(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws),
+          OP_SINGLE_ARG(int, "pack_first_input", pack_first_input_, 0)
+    {
+    }
+
+    protected:
+    // Fills shards_ and positions_ for the N keys, and counts_ on the host.
+    template <typename Index>
+    void RankKeys(const Index* keys, const int N, const int num_partitions)
+    {
+        const int num_chunks = (N + kKeysPerThread - 1) / kKeysPerThread;
+        const int num_counts = num_chunks * num_partitions;
+        shards_.Resize(N);
+        positions_.Resize(N);
+        chunk_counts_.Resize(num_counts);
+        chunk_offsets_.Resize(num_counts);
+        starts_.Resize(num_partitions + 1);
+        int* counts  = chunk_counts_.mutable_data<int>();
+        int* offsets = chunk_offsets_.mutable_data<int>();
+        if(N > 0)
+        {
+            math::Set<int, HIPContext>(num_counts, 0, counts, &context_);
+            hipLaunchKernelGGL((ShardCountKernel<Index>),
+                               dim3(CAFFE_GET_BLOCKS(num_chunks)),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context_.hip_stream(),
+                               N,
+                               num_chunks,
+                               num_partitions,
+                               keys,
+                               shards_.mutable_data<int>(),
+                               counts);
+            size_t temp_storage_bytes = 0;
+            hipcub::DeviceScan::ExclusiveSum(
+                nullptr, temp_storage_bytes, counts, offsets, num_counts, context_.hip_stream());
+            scan_buffer_.Resize(temp_storage_bytes);
+            hipcub::DeviceScan::ExclusiveSum(
+                static_cast<void*>(scan_buffer_.mutable_data<char>()),
+                temp_storage_bytes,
+                counts,
+                offsets,
+                num_counts,
+                context_.hip_stream());
+            hipLaunchKernelGGL((ShardStartsKernel),
+                               dim3(CAFFE_GET_BLOCKS(num_partitions + 1)),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context_.hip_stream(),
+                               N,
+                               num_chunks,
+                               num_partitions,
+                               offsets,
+                               starts_.mutable_data<int>());
+            hipLaunchKernelGGL((ShardRankKernel),
+                               dim3(CAFFE_GET_BLOCKS(num_chunks)),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context_.hip_stream(),
+                               N,
+                               num_chunks,
+                               shards_.data<int>(),
+                               starts_.data<int>(),
+                               offsets,
+                               positions_.mutable_data<int>());
+            host_starts_.CopyFrom(starts_, &context_);
+            context_.FinishDeviceComputation();
+        }
+        counts_.resize(num_partitions);
+        for(int s = 0; s < num_partitions; ++s)
+        {
+            counts_[s] = N > 0 ? host_starts_.data<int>()[s + 1] - host_starts_.data<int>()[s] : 0;
+        }
+    }
+
+    // Copies the host pointers into table, for the kernels.
+    void* const* DevicePointers(const vector<void*>& ptrs, Tensor<HIPContext>* table)
+    {
+        table->Resize(ptrs.size() * sizeof(void*));
+        context_.CopyBytes<CPUContext, HIPContext>(
+            ptrs.size() * sizeof(void*), ptrs.data(), table->mutable_data<char>());
+        return reinterpret_cast<void* const*>(table->data<char>());
+    }
+
+    template <typename Index>
+    void ApplyPartition(bool skipFirstArgument)
+    {
+        CAFFE_ENFORCE_EQ(
+            OutputSize() % InputSize(), 0, "Output number must be a multiple of input number");
+        const int partitions     = OutputSize() / InputSize();
+        const int inputSize      = InputSize();
+        const int mainInputIndex = skipFirstArgument;
+        CAFFE_ENFORCE_GT(partitions, 0, "Invalid number of partitions");
+
+        auto& main_input = Input(mainInputIndex);
+        CAFFE_ENFORCE_LT(main_input.size(), std::numeric_limits<int>::max());
+        const int size = main_input.size();
+        RankKeys(main_input.template data<Index>(), size, partitions);
+
+        out_ptrs_.resize(inputSize * partitions);
+        for(int i = mainInputIndex; i < inputSize; ++i)
+        {
+            auto& input = Input(i);
+            if(i > mainInputIndex)
+            {
+                CAFFE_ENFORCE_GE(input.ndim(),
+                                 main_input.ndim(),
+                                 "Prefix of extra input's shape must match main input's shape, ",
+                                 "input: ",
+                                 i);
+                for(int j = 0; j < main_input.ndim(); ++j)
+                {
+                    CAFFE_ENFORCE_GE(input.dim(j),
+                                     main_input.dim(j),
+                                     "Prefix of extra input's shape must match main input's "
+                                     "shape, ",
+                                     "input: ",
+                                     i,
+                                     ", dim ",
+                                     j);
+                }
+                CAFFE_ENFORCE(!input.meta().copy(), "Only fundamental types are supported");
+            }
+            // shape = partition_size + suffix of input dims
+            vector<TIndex> shape(input.dims().begin() + main_input.ndim() - 1,
+                                 input.dims().end());
+            for(int j = 0; j < partitions; ++j)
+            {
+                auto* output = Output(i + j * inputSize);
+                shape[0]     = counts_[j];
+                output->Resize(shape);
+                out_ptrs_[i * partitions + j] = output->raw_mutable_data(input.meta());
+            }
+        }
+        if(size == 0)
+        {
+            return;
+        }
+
+        void* const* ptrs = DevicePointers(out_ptrs_, &ptrs_);
+        hipLaunchKernelGGL((ScatterKeysKernel<Index>),
+                           dim3(CAFFE_GET_BLOCKS(size)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           size,
+                           partitions,
+                           static_cast<bool>(pack_first_input_),
+                           shards_.data<int>(),
+                           positions_.data<int>(),
+                           main_input.template data<Index>(),
+                           reinterpret_cast<Index* const*>(ptrs + mainInputIndex * partitions));
+        for(int i = mainInputIndex + 1; i < inputSize; ++i)
+        {
+            auto& input = Input(i);
+            CopyBlocks(false,
+                       size,
+                       input.size_from_dim(main_input.ndim()) * input.meta().itemsize(),
+                       shards_.data<int>(),
+                       positions_.data<int>(),
+                       input.raw_data(),
+                       ptrs + i * partitions,
+                       nullptr,
+                       &context_);
+        }
+    }
+
+    bool pack_first_input_;
+
+    Tensor<HIPContext> shards_;
+    Tensor<HIPContext> positions_;
+    Tensor<HIPContext> chunk_counts_;
+    Tensor<HIPContext> chunk_offsets_;
+    Tensor<HIPContext> starts_;
+    Tensor<HIPContext> scan_buffer_;
+    Tensor<HIPContext> ptrs_;
+    TensorCPU host_starts_;
+    vector<int> counts_;
+    vector<void*> out_ptrs_;
+};
+
+class HIPPartitionOp final : public HIPPartitionOpBase
+{
+    public:
+    USE_DISPATCH_HELPER;
+
+    HIPPartitionOp(const OperatorDef& operator_def, Workspace* ws)
+        : HIPPartitionOpBase(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(this, Input(0));
+    }
+
+    template <typename Index>
+    bool DoRunWithType()
+    {
+        ApplyPartition<Index>(false /* skipFirstArgument */);
+        return true;
+    }
+};
+
+class HIPLengthsPartitionOp final : public HIPPartitionOpBase
+{
+    public:
+    USE_DISPATCH_HELPER;
+
+    HIPLengthsPartitionOp(const OperatorDef& operator_def, Workspace* ws)
+        : HIPPartitionOpBase(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(this, Input(1));
+    }
+
+    template <typename Index>
+    bool DoRunWithType()
+    {
+        CAFFE_ENFORCE(OutputSize() % InputSize() == 0,
+                      "Output number must be a multiple of input number");
+        const int partitions = OutputSize() / InputSize();
+        CAFFE_ENFORCE_GT(partitions, 0, "Invalid number of partitions");
+        CAFFE_ENFORCE_EQ(Input(1).ndim(),
+                         1,
+                         "Only 1-D tensors supported as a partitioning tensor for sharding");
+
+        // Apply sharding to all parameters except lengths
+        ApplyPartition<Index>(true /* skipFirstArgument */);
+
+        // Compute lengths after sharding, from the shards of the keys left in
+        // shards_ by ApplyPartition
+        const int size       = Input(1).size();
+        auto& length_input   = Input(0);
+        const int elements   = length_input.size();
+        const int* lengths   = length_input.template data<int32_t>();
+        vector<void*> out_lengths(partitions);
+        for(int i = 0; i < partitions; ++i)
+        {
+            auto* output = Output(i * InputSize());
+            output->Resize(elements);
+            out_lengths[i] = output->template mutable_data<int32_t>();
+        }
+        if(elements == 0)
+        {
+            CAFFE_ENFORCE_EQ(size, 0, "Total length is not matching to the number of elements");
+            return true;
+        }
+
+        segment_offsets_.Resize(elements);
+        int* segment_offsets      = segment_offsets_.mutable_data<int>();
+        size_t temp_storage_bytes = 0;
+        hipcub::DeviceScan::ExclusiveSum(
+            nullptr, temp_storage_bytes, lengths, segment_offsets, elements, context_.hip_stream());
+        scan_buffer_.Resize(temp_storage_bytes);
+        hipcub::DeviceScan::ExclusiveSum(static_cast<void*>(scan_buffer_.mutable_data<char>()),
+                                         temp_storage_bytes,
+                                         lengths,
+                                         segment_offsets,
+                                         elements,
+                                         context_.hip_stream());
+        int last_offset = 0;
+        int last_length = 0;
+        context_.Copy<int, HIPContext, CPUContext>(
+            1, segment_offsets + elements - 1, &last_offset);
+        context_.Copy<int, HIPContext, CPUContext>(1, lengths + elements - 1, &last_length);
+        context_.FinishDeviceComputation();
+        CAFFE_ENFORCE(last_offset + last_length == size,
+                      "Total length is not matching to the number of elements");
+
+        int* const* out_lengths_table =
+            reinterpret_cast<int* const*>(DevicePointers(out_lengths, &length_ptrs_));
+        hipLaunchKernelGGL((ShardLengthsKernel),
+                           dim3(CAFFE_GET_BLOCKS(elements)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           elements,
+                           partitions,
+                           lengths,
+                           segment_offsets,
+                           shards_.data<int>(),
+                           out_lengths_table);
+        return true;
+    }
+
+    private:
+    Tensor<HIPContext> segment_offsets_;
+    Tensor<HIPContext> length_ptrs_;
+};
+
+class HIPGatherByKeyOp final : public HIPPartitionOpBase
+{
+    public:
+    USE_DISPATCH_HELPER;
+
+    HIPGatherByKeyOp(const OperatorDef& operator_def, Workspace* ws)
+        : HIPPartitionOpBase(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(this, Input(0));
+    }
+
+    template <typename Index>
+    bool DoRunWithType()
+    {
+        const auto numPartitions = InputSize() - 1;
+        CAFFE_ENFORCE_GE(numPartitions, 1);
+        const auto& keysTensor = Input(0);
+        const auto& keysShape  = keysTensor.dims();
+        CAFFE_ENFORCE_EQ(keysShape.size(), 1, "Only 1D keys tensor supported currently.");
+        CAFFE_ENFORCE_LT(keysTensor.size(), std::numeric_limits<int>::max());
+
+        // 1. Shape and type consistency checks
+        const auto& in0Shape = Input(1).dims();
+        CAFFE_ENFORCE_GE(in0Shape.size(), 1);
+
+        vector<TIndex> outShape(keysShape);
+        outShape.insert(outShape.end(), in0Shape.begin() + 1, in0Shape.end());
+
+        auto totalSize = in0Shape[0];
+        auto meta      = Input(1).meta();
+        CAFFE_ENFORCE(!meta.copy(), "Only fundamental types are supported");
+        for(int i = 2; i < InputSize(); ++i)
+        {
+            const auto& input = Input(i);
+            CAFFE_ENFORCE(meta == input.meta());
+            CAFFE_ENFORCE_GE(input.ndim(), 1);
+            CAFFE_ENFORCE(std::equal(outShape.begin() + keysShape.size(),
+                                     outShape.end(),
+                                     input.dims().begin() + 1));
+            totalSize += input.dim(0);
+        }
+        CAFFE_ENFORCE_EQ(keysTensor.size(), totalSize);
+
+        auto* outTensor = Output(0);
+        outTensor->Resize(outShape);
+        void* outData        = outTensor->raw_mutable_data(meta);
+        const auto blockSize = outTensor->size_from_dim(1);
+
+        // 2. rank the keys within their shards and gather their blocks
+        const int numEntries = keysTensor.size();
+        RankKeys(keysTensor.template data<Index>(), numEntries, numPartitions);
+        in_ptrs_.resize(numPartitions);
+        for(int i = 0; i < numPartitions; ++i)
+        {
+            CAFFE_ENFORCE_EQ(counts_[i],
+                             Input(i + 1).dim(0),
+                             "Number of keys of shard ",
+                             i,
+                             " does not match the size of its input");
+            in_ptrs_[i] = const_cast<void*>(Input(i + 1).raw_data());
+        }
+        if(numEntries > 0)
+        {
+            CopyBlocks(true,
+                       numEntries,
+                       blockSize * meta.itemsize(),
+                       shards_.data<int>(),
+                       positions_.data<int>(),
+                       nullptr,
+                       DevicePointers(in_ptrs_, &ptrs_),
+                       outData,
+                       &context_);
+        }
+        return true;
+    }
+
+    private:
+    vector<void*> in_ptrs_;
+};
+
+REGISTER_HIP_OPERATOR(Partition, HIPPartitionOp);
+REGISTER_HIP_OPERATOR(LengthsPartition, HIPLengthsPartitionOp);
+REGISTER_HIP_OPERATOR(GatherByKey, HIPGatherByKeyOp);
+
+} // namespace caffe2
@@ -39,6 +39,29 @@ bool PerplexityOp<float, CPUContext>::RunOnDevice() {
 
 REGISTER_CPU_OPERATOR(Perplexity, PerplexityOp<float, CPUContext>);
 
+template <>
+bool AccumulatePerplexityOp<float, CPUContext>::RunOnDevice() {
+  auto& X = Input(0);
+  CAFFE_ENFORCE_EQ(X.ndim(), 1);
+  const int N = X.dim32(0);
+  const auto* Xdata = X.data<float>();
+
+  double* sums = InitSums();
+  for (int i = 0; i < N; ++i) {
+    sums[0] -= std::log(static_cast<double>(Xdata[i]));
+  }
+  sums[1] += N;
+  auto* Y = Output(PERPLEXITY);
+  Y->Resize(vector<TIndex>());
+  *(Y->mutable_data<float>()) =
+      sums[1] ? static_cast<float>(std::exp(sums[0] / sums[1])) : 1.0f;
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(
+    AccumulatePerplexity,
+    AccumulatePerplexityOp<float, CPUContext>);
+
 OPERATOR_SCHEMA(Perplexity).NumInputs(1).NumOutputs(1)
 .SetDoc(R"DOC(
 Perplexity calculates how well a probability distribution predicts a sample.
@@ -53,4 +76,22 @@ single (float) perplexity value for the batch.
         "batch");
 
 SHOULD_NOT_DO_GRADIENT(Perplexity);
+
+OPERATOR_SCHEMA(AccumulatePerplexity)
+    .NumInputs(1)
+    .NumOutputs(2)
+    .SetDoc(R"DOC(
+Perplexity over all the batches seen so far, exp(-sum(log(p)) / count). The
+sums are kept in the context of the op, so on a GPU the running perplexity is
+updated without synchronizing with the host. sums is created at the first run;
+feeding an empty tensor to it starts over.
+)DOC")
+    .Input(0, "probabilities", "1-D tensor with the probability of the true "
+           "label of every sample of the batch")
+    .Output(0, "perplexity", "Scalar tensor with the perplexity over all the "
+            "batches so far")
+    .Output(1, "sums", "1-D tensor (Tensor<double>) of size 2 with the sum of "
+            "-log(p) and the number of samples");
+
+SHOULD_NOT_DO_GRADIENT(AccumulatePerplexity);
 }  // namespace caffe2
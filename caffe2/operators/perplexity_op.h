@@ -19,6 +19,7 @@
 
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
 
 namespace caffe2 {
 
@@ -28,6 +29,34 @@ class PerplexityOp final : public Operator<Context> {
   USE_SIMPLE_CTOR_DTOR(PerplexityOp);
   USE_OPERATOR_CONTEXT_FUNCTIONS;
   bool RunOnDevice() override;
+
+ protected:
+  Tensor<Context> log_sum_;
+};
+
+// Perplexity over all the batches seen so far: sums holds the sum of
+// -log(p) and the number of samples, in the context of the op so that a
+// GPU can keep it up to date without synchronizing with the host.
+template <typename T, class Context>
+class AccumulatePerplexityOp final : public Operator<Context> {
+ public:
+  USE_SIMPLE_CTOR_DTOR(AccumulatePerplexityOp);
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  bool RunOnDevice() override;
+
+ protected:
+  // Starts from zero when sums is new or was reset.
+  double* InitSums() {
+    auto* sums = Output(SUMS);
+    if (sums->size() != 2 || !sums->template IsType<double>()) {
+      sums->Resize(2);
+      math::Set<double, Context>(
+          2, 0, sums->template mutable_data<double>(), &context_);
+    }
+    return sums->template mutable_data<double>();
+  }
+
+  OUTPUT_TAGS(PERPLEXITY, SUMS);
 };
 
 } // namespace caffe2
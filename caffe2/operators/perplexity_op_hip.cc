@@ -14,22 +14,61 @@
  * limitations under the License.
  */
 
+#include <hipcub/hipcub.hpp>
 #include "caffe2/core/context_hip.h"
 #include "caffe2/operators/perplexity_op.h"
 #include "caffe2/utils/math.h"
-#include <thrust/device_vector.h>
-#include <thrust/transform_reduce.h>
-#include <thrust/system/cuda/execution_policy.h>
+#include "hip/hip_runtime.h"
 
 namespace caffe2 {
 
-struct perplexity_function
+namespace {
+// *log_sum -= sum(log(X)), accumulated in double.
+__global__ void NegativeLogSumKernel(const int N, const float* X, double* log_sum)
 {
-    perplexity_function(float p) : pow(p) {}
-    __host__ __device__ float operator()(float x) const { return powf(1.0f / x, pow); }
-    float pow;
-};
+    using BlockReduce = hipcub::BlockReduce<double, CAFFE_HIP_NUM_THREADS>;
+    __shared__ typename BlockReduce::TempStorage temp_storage;
+    double sum = 0;
+    HIP_1D_KERNEL_LOOP(i, N) { sum -= log(static_cast<double>(X[i])); }
+    sum = BlockReduce(temp_storage).Sum(sum);
+    if(hipThreadIdx_x == 0)
+    {
+        atomicAdd(log_sum, sum);
+    }
+}
+
+// perplexity = exp(log_sum / count), 1 for no samples as the empty product.
+__global__ void PerplexityKernel(const double* log_sum, const double count, float* perplexity)
+{
+    *perplexity = count ? static_cast<float>(exp(*log_sum / count)) : 1.0f;
+}
+
+// sums[1] += N, then the perplexity of sums.
+__global__ void AccumulatePerplexityKernel(const int N, double* sums, float* perplexity)
+{
+    sums[1] += N;
+    *perplexity = sums[1] ? static_cast<float>(exp(sums[0] / sums[1])) : 1.0f;
+}
+
+void LaunchNegativeLogSum(const int N, const float* X, double* log_sum, HIPContext* context)
+{
+    if(N == 0)
+    {
+        return;
+    }
+    hipLaunchKernelGGL((NegativeLogSumKernel),
+                       dim3(CAFFE_GET_BLOCKS(N)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context->hip_stream(),
+                       N,
+                       X,
+                       log_sum);
+}
+} // namespace
 
+// The perplexity stays on the device, instead of being reduced by thrust to
+// the host and copied back.
 template <>
 bool PerplexityOp<float, HIPContext>::RunOnDevice()
 {
@@ -40,22 +79,44 @@ bool PerplexityOp<float, HIPContext>::RunOnDevice()
     int N = X.dim32(0);
 
     Y->Resize(vector<TIndex>());
-    float* Ydata       = Y->mutable_data<float>();
-    const float* Xdata = X.data<float>();
-
-    float perplexity = thrust::transform_reduce(
-#if THRUST_VERSION >= 100800
-        thrust::cuda::par.on(context_.hip_stream()),
-#endif // THRUST_VERSION >= 100800
-        Xdata,
-        Xdata + N,
-        perplexity_function(1.0f / N),
-        1.0f,
-        thrust::multiplies<float>());
-
-    math::Set<float, HIPContext>(1, perplexity, Ydata, &context_);
+    log_sum_.Resize(1);
+    double* log_sum = log_sum_.mutable_data<double>();
+    math::Set<double, HIPContext>(1, 0, log_sum, &context_);
+    LaunchNegativeLogSum(N, X.data<float>(), log_sum, &context_);
+    hipLaunchKernelGGL((PerplexityKernel),
+                       dim3(1),
+                       dim3(1),
+                       0,
+                       context_.hip_stream(),
+                       log_sum,
+                       static_cast<double>(N),
+                       Y->mutable_data<float>());
     return true;
 }
 
 REGISTER_HIP_OPERATOR(Perplexity, PerplexityOp<float, HIPContext>);
+
+template <>
+bool AccumulatePerplexityOp<float, HIPContext>::RunOnDevice()
+{
+    auto& X = Input(0);
+    CAFFE_ENFORCE_EQ(X.ndim(), 1);
+    const int N = X.dim32(0);
+
+    double* sums = InitSums();
+    auto* Y      = Output(PERPLEXITY);
+    Y->Resize(vector<TIndex>());
+    LaunchNegativeLogSum(N, X.data<float>(), sums, &context_);
+    hipLaunchKernelGGL((AccumulatePerplexityKernel),
+                       dim3(1),
+                       dim3(1),
+                       0,
+                       context_.hip_stream(),
+                       N,
+                       sums,
+                       Y->mutable_data<float>());
+    return true;
+}
+
+REGISTER_HIP_OPERATOR(AccumulatePerplexity, AccumulatePerplexityOp<float, HIPContext>);
 } // namespace caffe2
@@ -0,0 +1,137 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/persistent_lstm_op.h"
+
+#include "caffe2/operators/lstm_unit_op.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+template <>
+bool PersistentLSTMOp<CPUContext>::RunOnDevice() {
+  const auto& X = Input(GATES_INPUT);
+  const auto& W = Input(WEIGHT);
+  CAFFE_ENFORCE_EQ(X.ndim(), 3);
+  const int T = X.dim32(0);
+  const int N = X.dim32(1);
+  const int D = Input(HIDDEN_INIT).dim32(2);
+  CAFFE_ENFORCE_EQ(X.dim32(2), 4 * D);
+  CAFFE_ENFORCE_EQ(Input(HIDDEN_INIT).size(), N * D);
+  CAFFE_ENFORCE_EQ(Input(CELL_INIT).size(), N * D);
+  CAFFE_ENFORCE_EQ(W.ndim(), 2);
+  CAFFE_ENFORCE_EQ(W.dim32(0), 4 * D);
+  CAFFE_ENFORCE_EQ(W.dim32(1), D);
+
+  std::vector<int32_t> all_valid;
+  const int32_t* seqLengths = nullptr;
+  if (InputSize() > SEQ_LENGTHS) {
+    CAFFE_ENFORCE_EQ(Input(SEQ_LENGTHS).size(), N);
+    seqLengths = Input(SEQ_LENGTHS).template data<int32_t>();
+  } else {
+    all_valid.assign(N, T);
+    seqLengths = all_valid.data();
+  }
+
+  auto* hidden_all = Output(HIDDEN_ALL);
+  hidden_all->Resize(T, N, D);
+  Output(HIDDEN_OUTPUT)->ResizeLike(Input(HIDDEN_INIT));
+  Output(CELL_OUTPUT)->ResizeLike(Input(CELL_INIT));
+  auto* H = hidden_all->template mutable_data<float>();
+  auto* C = Output(CELL_OUTPUT)->template mutable_data<float>();
+
+  // Gates of the current timestep, then two cell state buffers.
+  buffer_.Resize(4 * N * D + 2 * N * D);
+  auto* gates = buffer_.template mutable_data<float>();
+  float* cell[2] = {gates + 4 * N * D, gates + 5 * N * D};
+
+  const float* H_prev = Input(HIDDEN_INIT).template data<float>();
+  const float* C_prev = Input(CELL_INIT).template data<float>();
+  for (int t = 0; t < T; ++t) {
+    context_.template Copy<float, CPUContext, CPUContext>(
+        4 * N * D, X.template data<float>() + t * 4 * N * D, gates);
+    math::Gemm<float, CPUContext>(
+        CblasNoTrans,
+        CblasTrans,
+        N,
+        4 * D,
+        D,
+        1,
+        H_prev,
+        W.template data<float>(),
+        1,
+        gates,
+        &context_);
+    float* H_t = H + t * N * D;
+    detail::LSTMUnit<float, CPUContext>(
+        N,
+        D,
+        t,
+        H_prev,
+        C_prev,
+        gates,
+        seqLengths,
+        false,
+        cell[t % 2],
+        H_t,
+        forget_bias_,
+        &context_);
+    H_prev = H_t;
+    C_prev = cell[t % 2];
+  }
+  context_.template Copy<float, CPUContext, CPUContext>(
+      N * D, H_prev, Output(HIDDEN_OUTPUT)->template mutable_data<float>());
+  context_.template Copy<float, CPUContext, CPUContext>(N * D, C_prev, C);
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(PersistentLSTM, PersistentLSTMOp<CPUContext>);
+OPERATOR_SCHEMA(PersistentLSTM)
+    .NumInputs(4, 5)
+    .NumOutputs(3)
+    .SetDoc(R"DOC(
+PersistentLSTM runs a single-layer LSTM over a whole sequence, for inference.
+It computes the same thing as a RecurrentNetwork whose step net is an FC of
+the previous hidden state (without a bias) followed by LSTMUnit, with the
+input projection (including the biases) done beforehand.
+
+On HIP all the timesteps run in one kernel launch. Each workgroup keeps its
+slice of the recurrent weights in LDS (when it fits), and the workgroups
+synchronize between timesteps, so the weights are not reloaded from memory
+at every step. This pays off at small batch sizes, where the step-by-step
+execution is bound by launches and weight reads.
+)DOC")
+    .Arg("forget_bias", "Bias term to add in while calculating forget gate")
+    .Input(
+        0,
+        "gates_input",
+        "Input projection of the gates, (T, N, 4 * D), in the input, forget, "
+        "output, cell order of LSTMUnit")
+    .Input(1, "hidden_init", "Initial hidden state, (1, N, D)")
+    .Input(2, "cell_init", "Initial cell state, (1, N, D)")
+    .Input(3, "weight", "Recurrent weights, (4 * D, D)")
+    .Input(
+        4,
+        "seq_lengths",
+        "Optional int32 sequence lengths, (N). The states are carried over "
+        "the timesteps past the end of a sequence")
+    .Output(0, "hidden_all", "Hidden state of every timestep, (T, N, D)")
+    .Output(1, "hidden_output", "Final hidden state, (1, N, D)")
+    .Output(2, "cell_output", "Final cell state, (1, N, D)");
+
+NO_GRADIENT(PersistentLSTM);
+
+} // namespace caffe2
@@ -0,0 +1,50 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_OPERATORS_PERSISTENT_LSTM_OP_H_
+#define CAFFE2_OPERATORS_PERSISTENT_LSTM_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+// Runs a whole single-layer LSTM sequence for inference: for each timestep
+// the gates are GATES_INPUT[t] + H[t - 1] * WEIGHT^T, followed by LSTMUnit.
+// The HIP implementation does every timestep in one kernel launch that keeps
+// its slice of the recurrent weights in LDS.
+template <class Context>
+class PersistentLSTMOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  PersistentLSTMOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        forget_bias_(
+            OperatorBase::GetSingleArgument<float>("forget_bias", 0.0)) {}
+
+  bool RunOnDevice() override;
+
+ protected:
+  INPUT_TAGS(GATES_INPUT, HIDDEN_INIT, CELL_INIT, WEIGHT, SEQ_LENGTHS);
+  OUTPUT_TAGS(HIDDEN_ALL, HIDDEN_OUTPUT, CELL_OUTPUT);
+
+  float forget_bias_;
+  Tensor<Context> buffer_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_PERSISTENT_LSTM_OP_H_
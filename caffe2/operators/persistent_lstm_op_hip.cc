@@ -0,0 +1,235 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/persistent_lstm_op.h"
+#include "hip/hip_runtime.h"
+
+namespace caffe2 {
+
+namespace {
+
+constexpr int kPersistentLSTMThreads = 256;
+
+__device__ float persistent_sigmoid(const float x) { return 1.0f / (1.0f + expf(-x)); }
+
+// Grid-wide barrier. All the workgroups must be resident, which the launch
+// guarantees by using at most one workgroup per compute unit.
+__device__ void GridSync(unsigned int* count, volatile unsigned int* generation, unsigned int nblocks)
+{
+    __syncthreads();
+    if(hipThreadIdx_x == 0)
+    {
+        const unsigned int gen = *generation;
+        __threadfence();
+        if(atomicAdd(count, 1) == nblocks - 1)
+        {
+            atomicExch(count, 0);
+            __threadfence();
+            atomicAdd(const_cast<unsigned int*>(generation), 1);
+        }
+        else
+        {
+            while(*generation == gen)
+            {
+            }
+        }
+        __threadfence();
+    }
+    __syncthreads();
+}
+
+// Workgroup b owns the hidden units [b * units, (b + 1) * units): it keeps
+// their rows of the recurrent weights (in LDS if weights_in_lds) and their
+// cell states across the timesteps, and writes their hidden states to
+// hidden_all[t], which every workgroup reads back after the barrier.
+__global__ void PersistentLSTMKernel(const int T,
+                                     const int N,
+                                     const int D,
+                                     const int units,
+                                     const bool weights_in_lds,
+                                     const float* X,
+                                     const float* H_init,
+                                     const float* C_init,
+                                     const float* W,
+                                     const int32_t* seqLengths,
+                                     const float forget_bias,
+                                     float* hidden_all,
+                                     float* C_out,
+                                     unsigned int* barrier)
+{
+    HIP_DYNAMIC_SHARED(float, smem)
+    const int u0 = hipBlockIdx_x * units;
+    const int nu = min(units, D - u0);
+    float* w_lds = smem;
+    float* h_lds = w_lds + (weights_in_lds ? 4 * units * D : 0);
+    float* g_lds = h_lds + N * D;
+    float* c_lds = g_lds + 4 * N * units;
+
+    if(weights_in_lds)
+    {
+        for(int i = hipThreadIdx_x; i < 4 * nu * D; i += hipBlockDim_x)
+        {
+            const int row = i / D;
+            const int k   = i % D;
+            w_lds[i]      = W[((row / nu) * D + u0 + row % nu) * D + k];
+        }
+    }
+    for(int i = hipThreadIdx_x; i < N * nu; i += hipBlockDim_x)
+    {
+        c_lds[i] = C_init[(i / nu) * D + u0 + i % nu];
+    }
+
+    for(int t = 0; t < T; ++t)
+    {
+        const float* H_prev = t == 0 ? H_init : hidden_all + (t - 1) * N * D;
+        for(int i = hipThreadIdx_x; i < N * D; i += hipBlockDim_x)
+        {
+            h_lds[i] = H_prev[i];
+        }
+        __syncthreads();
+
+        // Gates of the owned units, laid out as [n][gate][unit].
+        for(int i = hipThreadIdx_x; i < 4 * N * nu; i += hipBlockDim_x)
+        {
+            const int n    = i / (4 * nu);
+            const int gate = (i / nu) % 4;
+            const int j    = i % nu;
+            const float* w = weights_in_lds ? w_lds + (gate * nu + j) * D
+                                            : W + (gate * D + u0 + j) * D;
+            const float* h = h_lds + n * D;
+            float acc      = X[(t * N + n) * 4 * D + gate * D + u0 + j];
+            for(int k = 0; k < D; ++k)
+            {
+                acc += w[k] * h[k];
+            }
+            g_lds[i] = acc;
+        }
+        __syncthreads();
+
+        for(int i = hipThreadIdx_x; i < N * nu; i += hipBlockDim_x)
+        {
+            const int n = i / nu;
+            const int j = i % nu;
+            float* H_t  = hidden_all + (t * N + n) * D + u0 + j;
+            if(seqLengths && t >= seqLengths[n])
+            {
+                *H_t = h_lds[n * D + u0 + j];
+                continue;
+            }
+            const float* g = g_lds + n * 4 * nu + j;
+            const float in = persistent_sigmoid(g[0]);
+            const float f  = persistent_sigmoid(g[nu] + forget_bias);
+            const float o  = persistent_sigmoid(g[2 * nu]);
+            const float c  = f * c_lds[i] + in * tanhf(g[3 * nu]);
+            c_lds[i]       = c;
+            *H_t           = o * tanhf(c);
+        }
+        GridSync(barrier, barrier + 1, hipGridDim_x);
+    }
+
+    for(int i = hipThreadIdx_x; i < N * nu; i += hipBlockDim_x)
+    {
+        C_out[(i / nu) * D + u0 + i % nu] = c_lds[i];
+    }
+}
+
+} // namespace
+
+template <>
+bool PersistentLSTMOp<HIPContext>::RunOnDevice()
+{
+    const auto& X = Input(GATES_INPUT);
+    const auto& W = Input(WEIGHT);
+    CAFFE_ENFORCE_EQ(X.ndim(), 3);
+    const int T = X.dim32(0);
+    const int N = X.dim32(1);
+    const int D = Input(HIDDEN_INIT).dim32(2);
+    CAFFE_ENFORCE_EQ(X.dim32(2), 4 * D);
+    CAFFE_ENFORCE_EQ(Input(HIDDEN_INIT).size(), N * D);
+    CAFFE_ENFORCE_EQ(Input(CELL_INIT).size(), N * D);
+    CAFFE_ENFORCE_EQ(W.ndim(), 2);
+    CAFFE_ENFORCE_EQ(W.dim32(0), 4 * D);
+    CAFFE_ENFORCE_EQ(W.dim32(1), D);
+    const int32_t* seqLengths = nullptr;
+    if(InputSize() > SEQ_LENGTHS)
+    {
+        CAFFE_ENFORCE_EQ(Input(SEQ_LENGTHS).size(), N);
+        seqLengths = Input(SEQ_LENGTHS).template data<int32_t>();
+    }
+
+    auto* hidden_all = Output(HIDDEN_ALL);
+    hidden_all->Resize(T, N, D);
+    Output(HIDDEN_OUTPUT)->ResizeLike(Input(HIDDEN_INIT));
+    Output(CELL_OUTPUT)->ResizeLike(Input(CELL_INIT));
+    auto* H = hidden_all->template mutable_data<float>();
+    auto* C = Output(CELL_OUTPUT)->template mutable_data<float>();
+    if(T == 0 || N == 0 || D == 0)
+    {
+        context_.template Copy<float, HIPContext, HIPContext>(
+            N * D, Input(HIDDEN_INIT).template data<float>(),
+            Output(HIDDEN_OUTPUT)->template mutable_data<float>());
+        context_.template Copy<float, HIPContext, HIPContext>(
+            N * D, Input(CELL_INIT).template data<float>(), C);
+        return true;
+    }
+
+    // One workgroup per compute unit at most, so that all of them are
+    // resident for the grid barrier.
+    const auto& prop  = GetDeviceProperty(context_.hip_gpu_id());
+    const int nblocks = std::min(prop.multiProcessorCount, D);
+    const int units   = (D + nblocks - 1) / nblocks;
+    const size_t state_bytes = sizeof(float) * (N * D + 5 * N * units);
+    const size_t weight_bytes = sizeof(float) * 4 * units * D;
+    CAFFE_ENFORCE_LE(state_bytes,
+                     prop.sharedMemPerBlock,
+                     "Batch too large for PersistentLSTM, use RecurrentNetwork instead");
+    const bool weights_in_lds = state_bytes + weight_bytes <= prop.sharedMemPerBlock;
+    VLOG(1) << "PersistentLSTM: " << (D + units - 1) / units << " workgroups of " << units
+            << " units, weights in " << (weights_in_lds ? "LDS" : "global memory");
+
+    // count and generation of the grid barrier
+    buffer_.Resize(2);
+    auto* barrier = reinterpret_cast<unsigned int*>(buffer_.template mutable_data<int>());
+    HIP_ENFORCE(hipMemsetAsync(barrier, 0, 2 * sizeof(unsigned int), context_.hip_stream()));
+
+    hipLaunchKernelGGL((PersistentLSTMKernel),
+                       dim3((D + units - 1) / units),
+                       dim3(kPersistentLSTMThreads),
+                       weights_in_lds ? state_bytes + weight_bytes : state_bytes,
+                       context_.hip_stream(),
+                       T,
+                       N,
+                       D,
+                       units,
+                       weights_in_lds,
+                       X.template data<float>(),
+                       Input(HIDDEN_INIT).template data<float>(),
+                       Input(CELL_INIT).template data<float>(),
+                       W.template data<float>(),
+                       seqLengths,
+                       forget_bias_,
+                       H,
+                       C,
+                       barrier);
+    context_.template Copy<float, HIPContext, HIPContext>(
+        N * D, H + (T - 1) * N * D, Output(HIDDEN_OUTPUT)->template mutable_data<float>());
+    return true;
+}
+
+REGISTER_HIP_OPERATOR(PersistentLSTM, PersistentLSTMOp<HIPContext>);
+
+} // namespace caffe2
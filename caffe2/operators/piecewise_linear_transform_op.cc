@@ -16,8 +16,101 @@
 
 #include "caffe2/operators/piecewise_linear_transform_op.h"
 
+#include "caffe2/perfkernels/piecewise_linear.h"
+
 namespace caffe2 {
 
+namespace {
+// Number of elements below which the transform is not split across threads.
+constexpr TIndex kPiecewiseLinearGrainSize = 16384;
+} // namespace
+
+template <>
+bool PiecewiseLinearTransformOp<float, CPUContext>::TransformGeneral() {
+  auto& X = Input(0);
+  auto* Y = Output(0);
+  CAFFE_ENFORCE_EQ(X.ndim(), 2);
+  TIndex N = X.dim32(0);
+  TIndex M = X.dim32(1);
+  Y->ResizeLike(X);
+  const auto* Xdata = X.data<float>();
+  float* Ydata = Y->mutable_data<float>();
+
+  const float* bounds;
+  const float* slopes;
+  const float* intercepts;
+  TIndex num_func_per_group;
+  TIndex num_group;
+  GetTransParamData(
+      &bounds, &slopes, &intercepts, &num_func_per_group, &num_group);
+  CAFFE_ENFORCE_EQ(num_group, M);
+
+  // Every row applies the M groups to its M columns.
+  CPUContext::ParallelFor(
+      N,
+      std::max<TIndex>(1, kPiecewiseLinearGrainSize / std::max<TIndex>(M, 1)),
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          PiecewiseLinear(
+              M,
+              Xdata + i * M,
+              bounds,
+              slopes,
+              intercepts,
+              num_func_per_group,
+              1,
+              Ydata + i * M);
+        }
+      });
+  return true;
+}
+
+template <>
+bool PiecewiseLinearTransformOp<float, CPUContext>::TransformBinary() {
+  auto& X = Input(PREDICTIONS);
+  auto* Y = Output(0);
+  CAFFE_ENFORCE(X.ndim() == 1 || X.ndim() == 2);
+  TIndex N = X.dim32(0);
+  TIndex M = X.ndim() == 2 ? X.dim32(1) : 1;
+  CAFFE_ENFORCE(
+      M == 1 || M == 2,
+      "If binary is set to true, the input must be Nx2 or Nx1 tensor");
+  Y->ResizeLike(X);
+  const auto* Xdata = X.data<float>();
+  float* Ydata = Y->mutable_data<float>();
+
+  const float* bounds;
+  const float* slopes;
+  const float* intercepts;
+  TIndex num_func_per_group;
+  TIndex num_group;
+  GetTransParamData(
+      &bounds, &slopes, &intercepts, &num_func_per_group, &num_group);
+  CAFFE_ENFORCE_EQ(num_group, 1);
+
+  // With two columns, both are transformed by the single group, which keeps
+  // the loads contiguous, and the first one is then overwritten by the
+  // complement of the second.
+  CPUContext::ParallelFor(
+      N, kPiecewiseLinearGrainSize / M, [&](size_t begin, size_t end) {
+        PiecewiseLinear(
+            (end - begin) * M,
+            Xdata + begin * M,
+            bounds,
+            slopes,
+            intercepts,
+            num_func_per_group,
+            0,
+            Ydata + begin * M);
+        if (M == 2) {
+          for (size_t i = begin; i < end; ++i) {
+            Ydata[i * M] = 1.0f - Ydata[i * M + 1];
+          }
+        }
+      });
+  return true;
+}
+
 REGISTER_CPU_OPERATOR(
     PiecewiseLinearTransform,
     PiecewiseLinearTransformOp<float, CPUContext>);
@@ -0,0 +1,258 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/piecewise_linear_transform_op.h"
+#include "hip/hip_runtime.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Transforms x by the group of num_fnc pieces at bounds, slopes and
+// intercepts, the piece being found by a lower bound search of the bounds.
+__device__ float PiecewiseLinear(const float x,
+                                 const float* bounds,
+                                 const float* slopes,
+                                 const float* intercepts,
+                                 const int num_fnc)
+{
+    if(x <= bounds[0])
+    {
+        return slopes[0] * bounds[0] + intercepts[0];
+    }
+    if(x >= bounds[num_fnc])
+    {
+        return slopes[num_fnc - 1] * bounds[num_fnc] + intercepts[num_fnc - 1];
+    }
+    // First bound not less than x, in (0, num_fnc).
+    int lo = 1;
+    int hi = num_fnc;
+    while(lo < hi)
+    {
+        const int mid = (lo + hi) / 2;
+        if(bounds[mid] < x)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return slopes[lo - 1] * x + intercepts[lo - 1];
+}
+
+__global__ void PieceWiseLinearTransformGeneralKernel(const int N,
+                                                      const int M,
+                                                      const int num_fnc_per_grp,
+                                                      const float* bounds,
+                                                      const float* slopes,
+                                                      const float* intercepts,
+                                                      const float* X,
+                                                      float* Y)
+{
+    HIP_1D_KERNEL_LOOP(i, N * M)
+    {
+        const int col = i % M;
+        Y[i]          = PiecewiseLinear(X[i],
+                               bounds + col * (num_fnc_per_grp + 1),
+                               slopes + col * num_fnc_per_grp,
+                               intercepts + col * num_fnc_per_grp,
+                               num_fnc_per_grp);
+    }
+}
+
+__global__ void PieceWiseLinearTransformBinaryKernel1(const int N,
+                                                      const int num_fnc_per_grp,
+                                                      const float* bounds,
+                                                      const float* slopes,
+                                                      const float* intercepts,
+                                                      const float* X,
+                                                      float* Y)
+{
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        Y[i] = PiecewiseLinear(X[i], bounds, slopes, intercepts, num_fnc_per_grp);
+    }
+}
+
+__global__ void PieceWiseLinearTransformBinaryKernel2(const int N,
+                                                      const int num_fnc_per_grp,
+                                                      const float* bounds,
+                                                      const float* slopes,
+                                                      const float* intercepts,
+                                                      const float* X,
+                                                      float* Y)
+{
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        const float y =
+            PiecewiseLinear(X[2 * i + 1], bounds, slopes, intercepts, num_fnc_per_grp);
+        Y[2 * i + 1] = y;
+        Y[2 * i]     = 1.0f - y;
+    }
+}
+
+} // namespace
+
+template <>
+void PiecewiseLinearTransformOp<float, HIPContext>::setUpTensors(TIndex& num_func_per_group,
+                                                                 TIndex& num_group,
+                                                                 TIndex M)
+{
+    if(transform_param_from_arg_)
+    {
+        InferNumFunctionsPerGroup(bounds_from_arg_.size(),
+                                  slopes_from_arg_.size(),
+                                  intercepts_from_arg_.size(),
+                                  &num_func_per_group,
+                                  &num_group);
+        if(!gpu_copied_)
+        {
+            CAFFE_ENFORCE_EQ(InputSize(), 1);
+            bounds_device_.Resize(bounds_from_arg_.size());
+            slopes_device_.Resize(slopes_from_arg_.size());
+            intercepts_device_.Resize(intercepts_from_arg_.size());
+            context_.Copy<float, CPUContext, HIPContext>(bounds_from_arg_.size(),
+                                                         bounds_from_arg_.data(),
+                                                         bounds_device_.mutable_data<float>());
+            context_.Copy<float, CPUContext, HIPContext>(slopes_from_arg_.size(),
+                                                         slopes_from_arg_.data(),
+                                                         slopes_device_.mutable_data<float>());
+            context_.Copy<float, CPUContext, HIPContext>(intercepts_from_arg_.size(),
+                                                         intercepts_from_arg_.data(),
+                                                         intercepts_device_.mutable_data<float>());
+            gpu_copied_ = true;
+        }
+    }
+    else
+    {
+        CAFFE_ENFORCE_EQ(InputSize(), 4);
+        auto& bounds_input     = Input(BOUNDS);
+        auto& slopes_input     = Input(SLOPES);
+        auto& intercepts_input = Input(INTERCEPTS);
+        InferNumFunctionsPerGroup(bounds_input.size(),
+                                  slopes_input.size(),
+                                  intercepts_input.size(),
+                                  &num_func_per_group,
+                                  &num_group);
+        bounds_device_.CopyFrom<HIPContext>(bounds_input, &context_);
+        slopes_device_.CopyFrom<HIPContext>(slopes_input, &context_);
+        intercepts_device_.CopyFrom<HIPContext>(intercepts_input, &context_);
+    }
+
+    if(binary_)
+    {
+        CAFFE_ENFORCE_EQ(num_group, 1);
+    }
+    else
+    {
+        CAFFE_ENFORCE_EQ(num_group, M);
+    }
+}
+
+template <>
+bool PiecewiseLinearTransformOp<float, HIPContext>::TransformGeneral()
+{
+    auto& X = Input(0);
+    auto* Y = Output(0);
+    CAFFE_ENFORCE_EQ(X.ndim(), 2);
+    TIndex N = X.dim32(0);
+    TIndex M = X.dim32(1);
+    Y->ResizeLike(X);
+
+    TIndex num_func_per_group;
+    TIndex num_group;
+    setUpTensors(num_func_per_group, num_group, M);
+
+    if(X.size() == 0)
+    {
+        return true;
+    }
+    hipLaunchKernelGGL((PieceWiseLinearTransformGeneralKernel),
+                       dim3(CAFFE_GET_BLOCKS(X.size())),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       static_cast<int>(N),
+                       static_cast<int>(M),
+                       static_cast<int>(num_func_per_group),
+                       bounds_device_.data<float>(),
+                       slopes_device_.data<float>(),
+                       intercepts_device_.data<float>(),
+                       X.data<float>(),
+                       Y->mutable_data<float>());
+    return true;
+}
+
+template <>
+bool PiecewiseLinearTransformOp<float, HIPContext>::TransformBinary()
+{
+    auto& X = Input(PREDICTIONS);
+    auto* Y = Output(0);
+    CAFFE_ENFORCE(X.ndim() == 1 || X.ndim() == 2);
+    TIndex N = X.dim32(0);
+    TIndex M = X.ndim() == 2 ? X.dim32(1) : 1;
+    CAFFE_ENFORCE(M == 1 || M == 2,
+                  "If binary is set to true, the input must be Nx2 or Nx1 tensor");
+    Y->ResizeLike(X);
+
+    TIndex num_func_per_group;
+    TIndex num_group;
+    setUpTensors(num_func_per_group, num_group, M);
+
+    if(N == 0)
+    {
+        return true;
+    }
+    // One thread per row, the second column gives both outputs when M is 2.
+    if(M == 1)
+    {
+        hipLaunchKernelGGL((PieceWiseLinearTransformBinaryKernel1),
+                           dim3(CAFFE_GET_BLOCKS(N)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           static_cast<int>(N),
+                           static_cast<int>(num_func_per_group),
+                           bounds_device_.data<float>(),
+                           slopes_device_.data<float>(),
+                           intercepts_device_.data<float>(),
+                           X.data<float>(),
+                           Y->mutable_data<float>());
+    }
+    else
+    {
+        hipLaunchKernelGGL((PieceWiseLinearTransformBinaryKernel2),
+                           dim3(CAFFE_GET_BLOCKS(N)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           static_cast<int>(N),
+                           static_cast<int>(num_func_per_group),
+                           bounds_device_.data<float>(),
+                           slopes_device_.data<float>(),
+                           intercepts_device_.data<float>(),
+                           X.data<float>(),
+                           Y->mutable_data<float>());
+    }
+    return true;
+}
+
+REGISTER_HIP_OPERATOR(PiecewiseLinearTransform, PiecewiseLinearTransformOp<float, HIPContext>);
+
+} // namespace caffe2
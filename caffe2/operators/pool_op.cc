@@ -25,6 +25,9 @@ using std::min;
 
 namespace {
 
+// Number of output values pooled by a chunk of the NHWC ParallelFor.
+constexpr int kNHWCParallelGrain = 1 << 14;
+
 #ifdef __ARM_NEON__
 
 bool isNeon4x4p0s0Eligible(
@@ -641,27 +644,35 @@ bool PoolOp<T, Context, PoolType>::RunOnDeviceWithOrderNHWC() {
       }
       break;
     case 2:
-      for (int n = 0; n < X.dim32(0); ++n) {
-        for (int ph = 0; ph < pooled_height; ++ph) {
-          int hstart = ph * stride_h() - pad_t();
-          int hend = min(hstart + kernel_h(), height);
-          hstart = max(hstart, 0);
-          for (int pw = 0; pw < pooled_width; ++pw) {
-            int wstart = pw * stride_w() - pad_l();
-            int wend = min(wstart + kernel_w(), width);
-            wstart = max(wstart, 0);
-            const int y_col = (n * pooled_height + ph) * pooled_width + pw;
-            Ymat.col(y_col).setConstant(PoolType::initialize());
-            for (int h = hstart; h < hend; ++h) {
-              for (int w = wstart; w < wend; ++w) {
-                const int x_col = (n * height + h) * width + w;
-                PoolType::process(x_col, y_col, Xmat, Ymat);
+      // The output rows of every image are independent, the channels of a
+      // pixel are processed together.
+      CPUContext::ParallelFor(
+          static_cast<size_t>(X.dim32(0)) * pooled_height,
+          max(1, kNHWCParallelGrain / max(1, pooled_width * channels)),
+          [&](size_t begin, size_t end) {
+            for (size_t row = begin; row < end; ++row) {
+              const int n = row / pooled_height;
+              const int ph = row % pooled_height;
+              int hstart = ph * stride_h() - pad_t();
+              int hend = min(hstart + kernel_h(), height);
+              hstart = max(hstart, 0);
+              for (int pw = 0; pw < pooled_width; ++pw) {
+                int wstart = pw * stride_w() - pad_l();
+                int wend = min(wstart + kernel_w(), width);
+                wstart = max(wstart, 0);
+                const int y_col = row * pooled_width + pw;
+                Ymat.col(y_col).setConstant(PoolType::initialize());
+                for (int h = hstart; h < hend; ++h) {
+                  for (int w = wstart; w < wend; ++w) {
+                    const int x_col = (n * height + h) * width + w;
+                    PoolType::process(x_col, y_col, Xmat, Ymat);
+                  }
+                }
+                PoolType::finalize(
+                    (hend - hstart) * (wend - wstart), y_col, Ymat);
               }
             }
-            PoolType::finalize((hend - hstart) * (wend - wstart), y_col, Ymat);
-          }
-        }
-      }
+          });
       break;
     case 3:
       for (int n = 0; n < X.dim32(0); ++n) {
@@ -775,6 +786,8 @@ REGISTER_CPU_OPERATOR(
 OPERATOR_SCHEMA(AveragePool)
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(OpSchema::CostInferenceFunctionType(
+        ConvPoolOpBase<CPUContext>::CostInferenceForPool))
     .TensorInferenceFunction(ConvPoolOpBase<CPUContext>::TensorInferenceForPool)
     .FillUsing(AveragePoolDocGenerator(""));
 
@@ -795,6 +808,8 @@ REGISTER_CPU_OPERATOR(
 OPERATOR_SCHEMA(AveragePool2D)
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(OpSchema::CostInferenceFunctionType(
+        ConvPoolOpBase<CPUContext>::CostInferenceForPool))
     .TensorInferenceFunction(ConvPoolOpBase<CPUContext>::TensorInferenceForPool)
     .FillUsing(AveragePoolDocGenerator("2D"));
 
@@ -813,6 +828,8 @@ REGISTER_CPU_OPERATOR(MaxPool, PoolOp<float, CPUContext, MaxPool<float>>);
 OPERATOR_SCHEMA(MaxPool)
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(OpSchema::CostInferenceFunctionType(
+        ConvPoolOpBase<CPUContext>::CostInferenceForPool))
     .TensorInferenceFunction(ConvPoolOpBase<CPUContext>::TensorInferenceForPool)
     .FillUsing(MaxPoolDocGenerator(""));
 
@@ -829,6 +846,8 @@ REGISTER_CPU_OPERATOR(MaxPool2D, PoolOp<float, CPUContext, MaxPool<float>>);
 OPERATOR_SCHEMA(MaxPool2D)
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(OpSchema::CostInferenceFunctionType(
+        ConvPoolOpBase<CPUContext>::CostInferenceForPool))
     .TensorInferenceFunction(ConvPoolOpBase<CPUContext>::TensorInferenceForPool)
     .FillUsing(MaxPoolDocGenerator("2D"));
 
@@ -26,10 +26,7 @@ class MIOPENPoolOp : public ConvPoolOpBase<HIPContext>
         : ConvPoolOpBase<HIPContext>(operator_def, ws),
           miopen_wrapper_(&context_),
           alpha_(OperatorBase::GetSingleArgument<float>("alpha", 1.0)),
-          beta_(OperatorBase::GetSingleArgument<float>("beta", 0.0)),
-          do_backward_(OperatorBase::GetSingleArgument<bool>("do_backward", true)),
-          poolWsSize_(0)
-
+          beta_(OperatorBase::GetSingleArgument<float>("beta", 0.0))
     {
         MIOPEN_ENFORCE(miopenCreateTensorDescriptor(&bottom_desc_));
         MIOPEN_ENFORCE(miopenCreateTensorDescriptor(&top_desc_));
@@ -56,7 +53,6 @@ class MIOPENPoolOp : public ConvPoolOpBase<HIPContext>
         MIOPEN_ENFORCE(miopenDestroyTensorDescriptor(bottom_desc_));
         MIOPEN_ENFORCE(miopenDestroyTensorDescriptor(top_desc_));
         MIOPEN_ENFORCE(miopenDestroyPoolingDescriptor(pooling_desc_));
-        poolWsSize_ = 0;
     }
 
     template <typename T, typename M>
@@ -94,13 +90,9 @@ class MIOPENPoolOp : public ConvPoolOpBase<HIPContext>
         MIOPEN_ENFORCE(miopenSet4dTensorDescriptor(
             top_desc_, miopenTypeWrapper<T>::type, N_out, C_out, H_out, W_out));
 
-        MIOPEN_ENFORCE(miopenPoolingGetWorkSpaceSize(top_desc_, &poolWsSize_));
-
-        if((poolWsSize_ > 0) && (poolWs_ == nullptr))
-        {
-            HIP_CHECK(hipMalloc(&poolWs_, poolWsSize_));
-        }
-
+        // The gradient op reruns the forward pass to fill its own index
+        // workspace, so nothing consumes one from here: run forward-only,
+        // which needs no workspace and skips writing the indices.
         const T* Xdata = X.template data<T>();
         T* Ydata       = Y->template mutable_data<T>();
         MIOPEN_ENFORCE(miopenPoolingForward(miopen_wrapper_.inline_miopen_handle(),
@@ -111,9 +103,9 @@ class MIOPENPoolOp : public ConvPoolOpBase<HIPContext>
                                             &beta_,
                                             top_desc_,
                                             Ydata,
-                                            do_backward_,
-                                            poolWs_,
-                                            poolWsSize_));
+                                            false,
+                                            nullptr,
+                                            0));
 
         return true;
     }
@@ -135,13 +127,11 @@ class MIOPENPoolOp : public ConvPoolOpBase<HIPContext>
     }
 
     protected:
-    size_t poolWsSize_;
     MIOPENWrapper miopen_wrapper_;
     miopenTensorDescriptor_t bottom_desc_;
     miopenTensorDescriptor_t top_desc_;
     miopenPoolingDescriptor_t pooling_desc_;
     miopenPoolingMode_t mode_;
-    bool do_backward_;
     const float alpha_;
     const float beta_;
 
@@ -156,8 +146,7 @@ class MIOPENPoolGradientOp : public ConvPoolOpBase<HIPContext>
           miopen_wrapper_(&context_),
           alpha_(OperatorBase::GetSingleArgument<float>("alpha", 1.0)),
           beta_(OperatorBase::GetSingleArgument<float>("beta", 0.0)),
-          poolWsSize_(0),
-          poolBwdScratch(nullptr)
+          poolWsSize_(0)
     {
         MIOPEN_ENFORCE(miopenCreateTensorDescriptor(&bottom_desc_));
         MIOPEN_ENFORCE(miopenCreateTensorDescriptor(&top_desc_));
@@ -182,13 +171,6 @@ class MIOPENPoolGradientOp : public ConvPoolOpBase<HIPContext>
         MIOPEN_ENFORCE(miopenDestroyTensorDescriptor(bottom_desc_));
         MIOPEN_ENFORCE(miopenDestroyTensorDescriptor(top_desc_));
         MIOPEN_ENFORCE(miopenDestroyPoolingDescriptor(pooling_desc_));
-        poolWsSize_ = 0;
-
-        if(poolBwdScratch)
-        {
-            hipFree(poolBwdScratch);
-            poolBwdScratch = nullptr;
-        }
     }
 
     template <typename T, typename M>
@@ -233,15 +215,11 @@ class MIOPENPoolGradientOp : public ConvPoolOpBase<HIPContext>
 
         MIOPEN_ENFORCE(miopenPoolingGetWorkSpaceSize(top_desc_, &poolWsSize_));
 
-        if((poolWsSize_ > 0) && (poolWs_ == nullptr))
-        {
-            HIP_CHECK(hipMalloc(&poolWs_, poolWsSize_));
-        }
-
-        if(poolBwdScratch == nullptr)
-        {
-            HIP_CHECK(hipMalloc(&poolBwdScratch, Y.size() * sizeof(float)));
-        }
+        // The index workspace and the recomputed forward output come from the
+        // caching allocator, and follow the input shape from run to run.
+        poolWs_.Resize(static_cast<TIndex>(poolWsSize_));
+        void* poolWsData = poolWsSize_ > 0 ? poolWs_.mutable_data<uint8_t>() : nullptr;
+        poolBwdScratch_.ResizeLike(Y);
 
         // Carry out the pooling computation.
         const T* Xdata  = X.template data<T>();
@@ -256,9 +234,9 @@ class MIOPENPoolGradientOp : public ConvPoolOpBase<HIPContext>
                                             Xdata,
                                             &beta_,
                                             top_desc_,
-                                            poolBwdScratch,
+                                            poolBwdScratch_.template mutable_data<T>(),
                                             true,
-                                            poolWs_,
+                                            poolWsData,
                                             poolWsSize_));
 
         MIOPEN_ENFORCE(miopenPoolingBackward(miopen_wrapper_.inline_miopen_handle(),
@@ -273,7 +251,7 @@ class MIOPENPoolGradientOp : public ConvPoolOpBase<HIPContext>
                                              &beta_,
                                              bottom_desc_,
                                              dXdata,
-                                             poolWs_));
+                                             poolWsData));
 
         return true;
     }
@@ -306,7 +284,8 @@ class MIOPENPoolGradientOp : public ConvPoolOpBase<HIPContext>
     miopenPoolingMode_t mode_;
     const float alpha_;
     const float beta_;
-    float* poolBwdScratch;
+    Tensor<HIPContext> poolWs_;
+    Tensor<HIPContext> poolBwdScratch_;
 };
 
 namespace {
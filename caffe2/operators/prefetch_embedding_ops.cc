@@ -0,0 +1,95 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "caffe2/operators/prefetch_embedding_ops.h"
+
+namespace caffe2 {
+
+CAFFE_KNOWN_TYPE(PrefetchedEmbeddings);
+
+template <>
+std::function<void()> PrefetchSparseLengthsSumOp<CPUContext>::PrepareCopy(
+    PrefetchedEmbeddings* /* unused */) {
+  return nullptr;
+}
+
+template <>
+bool WaitSparseLengthsSumOp<CPUContext>::RunOnDevice() {
+  auto* state = OperatorBase::Output<PrefetchedEmbeddings>(1);
+  state->Collect();
+  Output(0)->CopyFrom(state->host, &context_);
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(
+    PrefetchSparseLengthsSum,
+    PrefetchSparseLengthsSumOp<CPUContext>);
+REGISTER_CPU_OPERATOR(WaitSparseLengthsSum, WaitSparseLengthsSumOp<CPUContext>);
+
+OPERATOR_SCHEMA(PrefetchSparseLengthsSum)
+    .NumInputs(3)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Starts the SparseLengthsSum of the next batch on a pool of CPU threads and
+returns without waiting for it, for embedding tables kept on the host while
+the dense part of the model runs on a GPU. On GPU the pooled embeddings are
+then copied to the device on a stream of their own. WaitSparseLengthsSum
+takes them in the next iteration, so the lookup and the copy of batch k + 1
+run while batch k is computed:
+
+  iteration k: pooled = WaitSparseLengthsSum(prefetched)               # k
+               prefetched = PrefetchSparseLengthsSum(table, idx, len)  # k + 1
+               ... dense towers on pooled ...
+
+The indices and lengths come from the next batch of the reader, e.g. from a
+prefetching queue, and are copied by the op. The first batch is started
+before the first iteration. The table is read in place while the lookup runs
+and must not be resized meanwhile; rows updated by the iteration are read
+before or after the update, as in Hogwild training.
+
+The ops have no gradient: they are meant for tables the net does not train,
+or whose updates are computed by other ops.
+)DOC")
+    .Arg("num_threads", "Number of lookup threads, 4 by default")
+    .Arg(
+        "copy_stream_id",
+        "Stream of the copy to the device, defaults to the one after the high "
+        "priority communication stream (--caffe2_streams_per_gpu + 1)")
+    .Input(0, "DATA", "Tensor<float> of the embeddings, on the host")
+    .Input(1, "INDICES", "Integer vector of the rows of the next batch")
+    .Input(2, "LENGTHS", "Vector<int> of the lengths of its segments")
+    .Output(0, "prefetched", "The lookup in flight");
+
+OPERATOR_SCHEMA(WaitSparseLengthsSum)
+    .NumInputs(1)
+    .NumOutputs(2)
+    .EnforceInplace({{0, 1}})
+    .SetDoc(R"DOC(
+Waits for the lookup started by the last PrefetchSparseLengthsSum and
+outputs its pooled embeddings on the device of the op, the shape of DATA
+with its first dimension set to the number of segments. On GPU the op only
+blocks the host until the copy of the batch is done, which the lookup
+threads wait for, and does not wait for the work queued on the device.
+)DOC")
+    .Input(0, "prefetched", "The output of PrefetchSparseLengthsSum")
+    .Output(0, "OUTPUT", "The pooled embeddings")
+    .Output(1, "prefetched_out", "The prefetched state, in place");
+
+SHOULD_NOT_DO_GRADIENT(PrefetchSparseLengthsSum);
+SHOULD_NOT_DO_GRADIENT(WaitSparseLengthsSum);
+
+} // namespace caffe2
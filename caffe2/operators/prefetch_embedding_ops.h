@@ -0,0 +1,233 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CAFFE2_OPERATORS_PREFETCH_EMBEDDING_OPS_H_
+#define CAFFE2_OPERATORS_PREFETCH_EMBEDDING_OPS_H_
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/flags.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/perfkernels/embedding_lookup.h"
+#include "caffe2/utils/thread_pool.h"
+
+CAFFE2_DECLARE_int(caffe2_streams_per_gpu);
+
+namespace caffe2 {
+
+// Pooled embeddings of the batch PrefetchSparseLengthsSum looks up ahead on
+// the CPU, in a blob of their own until WaitSparseLengthsSum hands them over.
+struct PrefetchedEmbeddings {
+  ~PrefetchedEmbeddings() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return remaining_ == 0; });
+  }
+
+  // Whether a batch was started and not taken yet; its buffers are in use.
+  bool pending() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_;
+  }
+
+  // Starts a batch looked up by num_tasks tasks.
+  void Start(const int num_tasks) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CAFFE_ENFORCE(!pending_);
+    pending_ = true;
+    remaining_ = num_tasks;
+    error_.clear();
+  }
+
+  // Ends a task of the batch with the error it ran into, if any. The last
+  // one runs finish, which copies the batch to the device, before the batch
+  // is done.
+  void EndTask(const std::function<void()>& finish, const std::string& error) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!error.empty()) {
+      error_ = error;
+    }
+    if (remaining_ > 1) {
+      --remaining_;
+      return;
+    }
+    if (error_.empty() && finish) {
+      lock.unlock();
+      try {
+        finish();
+      } catch (const std::exception& e) {
+        error_ = e.what();
+      }
+      lock.lock();
+    }
+    remaining_ = 0;
+    // Under the lock, the state may be destroyed as soon as it is released.
+    done_.notify_all();
+  }
+
+  // Waits for the batch and takes it, rethrowing the error of its lookup.
+  void Collect() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    CAFFE_ENFORCE(pending_, "PrefetchSparseLengthsSum has started no batch");
+    done_.wait(lock, [this] { return remaining_ == 0; });
+    pending_ = false;
+    CAFFE_ENFORCE(error_.empty(), "Prefetching embeddings failed: ", error_);
+  }
+
+  // Copies of the indices and the lengths, so that the inputs of the op can
+  // be refilled before the lookup is over, and the offsets of the segments.
+  TensorCPU indices;
+  TensorCPU lengths;
+  vector<TIndex> offsets;
+  // Pooled embeddings on the host, pinned when a GPU is present.
+  TensorCPU host;
+  // Device copy of the pooled embeddings and its events, null on CPU
+  std::shared_ptr<void> device;
+  std::unique_ptr<TaskThreadPool> pool;
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable done_;
+  bool pending_ = false;
+  int remaining_ = 0;
+  std::string error_;
+};
+
+// Starts the SparseLengthsSum of a batch on a pool of CPU threads and, on
+// GPU, the copy of its result to the device on a stream of its own, so that
+// WaitSparseLengthsSum can take it in the next iteration.
+template <class Context>
+class PrefetchSparseLengthsSumOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  PrefetchSparseLengthsSumOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        num_threads_(OperatorBase::GetSingleArgument<int>("num_threads", 4)),
+        copy_stream_id_(OperatorBase::GetSingleArgument<int>(
+            "copy_stream_id",
+            FLAGS_caffe2_streams_per_gpu + 1)) {
+    CAFFE_ENFORCE_GT(num_threads_, 0);
+  }
+
+  bool RunOnDevice() override {
+    return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(
+        this, OperatorBase::Input<TensorCPU>(INDICES));
+  }
+
+  template <typename IndexType>
+  bool DoRunWithType() {
+    const auto& data = OperatorBase::Input<TensorCPU>(DATA);
+    const auto& indices = OperatorBase::Input<TensorCPU>(INDICES);
+    const auto& lengths = OperatorBase::Input<TensorCPU>(LENGTHS);
+    CAFFE_ENFORCE_GE(data.ndim(), 1, "DATA should be at least 1-D");
+    CAFFE_ENFORCE_EQ(1, indices.ndim(), "INDICES must be a vector");
+    CAFFE_ENFORCE_EQ(1, lengths.ndim(), "LENGTHS must be a vector");
+    auto* state = OperatorBase::Output<PrefetchedEmbeddings>(0);
+    CAFFE_ENFORCE(
+        !state->pending(),
+        "WaitSparseLengthsSum has to take the previous batch first");
+
+    const int output_size = lengths.dim32(0);
+    state->offsets.resize(output_size + 1);
+    state->offsets[0] = 0;
+    const int* lengths_data = lengths.template data<int>();
+    for (int i = 0; i < output_size; ++i) {
+      state->offsets[i + 1] = state->offsets[i] + lengths_data[i];
+    }
+    CAFFE_ENFORCE_EQ(
+        state->offsets.back(),
+        indices.size(),
+        "The lengths do not sum to the number of indices");
+    state->indices.CopyFrom(indices);
+    state->lengths.CopyFrom(lengths);
+    auto shape = data.dims();
+    shape[0] = output_size;
+    state->host.Resize(shape);
+    float* out = state->host.template mutable_data<float>();
+    const std::function<void()> finish = PrepareCopy(state);
+    if (!state->pool) {
+      state->pool.reset(new TaskThreadPool(num_threads_));
+    }
+
+    // Every task pools a contiguous range of the segments. The table is read
+    // in place and must outlive the lookup; rows updated meanwhile are read
+    // before or after the update, as in Hogwild training.
+    const TIndex block_size = data.size_from_dim(1);
+    const TIndex data_size = data.dim(0);
+    const float* table = data.template data<float>();
+    const IndexType* index_data = state->indices.template data<IndexType>();
+    lengths_data = state->lengths.template data<int>();
+    const TIndex* offsets = state->offsets.data();
+    const int num_tasks = std::max(1, std::min(num_threads_, output_size));
+    state->Start(num_tasks);
+    for (int t = 0; t < num_tasks; ++t) {
+      const int begin = static_cast<int64_t>(output_size) * t / num_tasks;
+      const int end = static_cast<int64_t>(output_size) * (t + 1) / num_tasks;
+      state->pool->run([=]() {
+        std::string error;
+        try {
+          EmbeddingLookup<IndexType, float, float>(
+              block_size,
+              end - begin,
+              offsets[end] - offsets[begin],
+              data_size,
+              table,
+              index_data + offsets[begin],
+              lengths_data + begin,
+              nullptr,
+              nullptr,
+              false,
+              out + begin * block_size);
+        } catch (const std::exception& e) {
+          error = e.what();
+        }
+        state->EndTask(finish, error);
+      });
+    }
+    return true;
+  }
+
+ private:
+  // Allocates the device copy of the pooled embeddings, if any, and returns
+  // what starts it once they are computed.
+  std::function<void()> PrepareCopy(PrefetchedEmbeddings* state);
+
+  INPUT_TAGS(DATA, INDICES, LENGTHS);
+  int num_threads_;
+  int copy_stream_id_;
+};
+
+// Waits for the batch started by the last PrefetchSparseLengthsSum and copies
+// its pooled embeddings to output 0. Output 1 is the prefetched state, in
+// place.
+template <class Context>
+class WaitSparseLengthsSumOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  USE_SIMPLE_CTOR_DTOR(WaitSparseLengthsSumOp);
+
+  bool RunOnDevice() override;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_PREFETCH_EMBEDDING_OPS_H_
@@ -0,0 +1,101 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/prefetch_embedding_ops.h"
+#include "hip/hip_runtime.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Device copy of the pooled embeddings, and the event recorded after
+// WaitSparseLengthsSum has read it, which the copy of the next batch waits
+// for.
+struct HipEmbeddingsCopy
+{
+    explicit HipEmbeddingsCopy(int gpu_id) : gpu_id(gpu_id)
+    {
+        DeviceGuard guard(gpu_id);
+        HIP_ENFORCE(hipEventCreateWithFlags(&consumed, hipEventDisableTiming));
+    }
+    ~HipEmbeddingsCopy()
+    {
+        DeviceGuard guard(gpu_id);
+        HIP_CHECK(hipEventDestroy(consumed));
+    }
+
+    Tensor<HIPContext> tensor;
+    hipEvent_t consumed;
+    int gpu_id;
+};
+
+} // namespace
+
+template <>
+std::function<void()>
+PrefetchSparseLengthsSumOp<HIPContext>::PrepareCopy(PrefetchedEmbeddings* state)
+{
+    const int gpu_id = context_.hip_gpu_id();
+    auto* copy       = static_cast<HipEmbeddingsCopy*>(state->device.get());
+    if(!copy || copy->gpu_id != gpu_id)
+    {
+        state->device = std::make_shared<HipEmbeddingsCopy>(gpu_id);
+        copy          = static_cast<HipEmbeddingsCopy*>(state->device.get());
+    }
+    if(copy->tensor.size() != state->host.size())
+    {
+        // The old buffer is freed, the previous batch must have been read.
+        HIP_ENFORCE(hipEventSynchronize(copy->consumed));
+    }
+    copy->tensor.ResizeLike(state->host);
+    float* dst                = copy->tensor.mutable_data<float>();
+    const float* src          = state->host.data<float>();
+    const size_t nbytes       = state->host.nbytes();
+    const hipEvent_t consumed = copy->consumed;
+    const int copy_stream_id  = copy_stream_id_;
+    return [=]() {
+        // On a lookup thread, which has its own streams.
+        DeviceGuard guard(gpu_id);
+        const hipStream_t stream = HIPContext::hip_stream(gpu_id, copy_stream_id);
+        HIP_ENFORCE(hipStreamWaitEvent(stream, consumed, 0));
+        if(nbytes > 0)
+        {
+            HIP_ENFORCE(hipMemcpyAsync(dst, src, nbytes, hipMemcpyHostToDevice, stream));
+        }
+        // Blocks the lookup thread only, the host buffer can then be refilled
+        // and the device copy read from any stream.
+        HIP_ENFORCE(hipStreamSynchronize(stream));
+    };
+}
+
+template <>
+bool WaitSparseLengthsSumOp<HIPContext>::RunOnDevice()
+{
+    auto* state = OperatorBase::Output<PrefetchedEmbeddings>(1);
+    state->Collect();
+    auto* copy = static_cast<HipEmbeddingsCopy*>(state->device.get());
+    CAFFE_ENFORCE(copy, "The batch was prefetched on the CPU");
+    Output(0)->CopyFrom(copy->tensor, &context_);
+    HIP_ENFORCE(hipEventRecord(copy->consumed, context_.hip_stream()));
+    return true;
+}
+
+REGISTER_HIP_OPERATOR(PrefetchSparseLengthsSum, PrefetchSparseLengthsSumOp<HIPContext>);
+REGISTER_HIP_OPERATOR(WaitSparseLengthsSum, WaitSparseLengthsSumOp<HIPContext>);
+
+} // namespace caffe2
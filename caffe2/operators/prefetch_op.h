@@ -17,12 +17,18 @@
 #ifndef CAFFE2_OPERATORS_PREFETCH_OP_H_
 #define CAFFE2_OPERATORS_PREFETCH_OP_H_
 
+#include <atomic>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <thread> // NOLINT
+#include <vector>
 
 #include "caffe2/core/context.h"
+#include "caffe2/core/event.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/core/stats.h"
+#include "caffe2/core/timer.h"
 
 namespace caffe2 {
 
@@ -33,6 +39,17 @@ namespace caffe2 {
 // For any operator that is derived from PrefetchOperator, it should
 // explicitly call the Finalize() function in its destructor, so that the
 // prefetching thread is properly destructed.
+//
+// On devices, up to prefetch_buffers batches (default 1) are prefetched ahead
+// of the consumer, each into its own slot. Prefetch() should fill the slot
+// prefetch_slot() and hand its host tensors to CopyToDeviceAsync(), which
+// copies them on the stream of the prefetching thread without blocking it;
+// CopyPrefetched() reads the slot consume_slot(). Instead of synchronizing
+// the copies on the host, the prefetching thread records an event that Run()
+// makes the stream of the operator wait on.
+//
+// Every operator exports the time spent in Prefetch() and waiting for it in
+// the StatRegistry, under "prefetch/<op name or type>", see PrefetchStats.
 
 // Note: We inherit from OperatorBase since we control the
 // synchronization properties of this operator ourselves (we inform
@@ -44,10 +61,28 @@ class PrefetchOperator : public OperatorBase {
   PrefetchOperator(const OperatorDef& operator_def, Workspace* ws)
       : OperatorBase(operator_def, ws),
         context_(operator_def.device_option()),
-        prefetched_(false),
-        prefetch_success_(true),
-        finalize_(false) {
+        // On the CPU the consumer reads the prefetched tensors directly, so
+        // there can only be one batch in flight.
+        num_slots_(
+            std::is_same<Context, CPUContext>::value
+                ? 1
+                : OperatorBase::GetSingleArgument<int>("prefetch_buffers", 1)),
+        slot_success_(num_slots_, true),
+        host_buffers_(num_slots_),
+        produced_(0),
+        consumed_(0),
+        finalize_(false),
+        prefetch_stats_(
+            "prefetch/" +
+            (operator_def.name().empty() ? operator_def.type()
+                                         : operator_def.name())) {
+    CAFFE_ENFORCE_GT(num_slots_, 0, "prefetch_buffers must be positive");
     context_.SwitchToDevice(0);
+    if (Context::HasAsyncPartDefault()) {
+      for (int i = 0; i < num_slots_; ++i) {
+        ready_events_.emplace_back(new Event(operator_def.device_option()));
+      }
+    }
   }
 
   virtual ~PrefetchOperator() noexcept {
@@ -61,11 +96,9 @@ class PrefetchOperator : public OperatorBase {
     if (prefetch_thread_.get()) {
       {
         std::unique_lock<std::mutex> lock(prefetch_access_mutex_);
-        while (!prefetched_)
-          consumer_.wait(lock);
         finalize_ = true;
-        prefetched_ = false;
       }
+      // The worker finishes the batch it is prefetching, if any, and quits.
       producer_.notify_one();
       prefetch_thread_->join();
       prefetch_thread_.reset();
@@ -85,19 +118,49 @@ class PrefetchOperator : public OperatorBase {
           new std::thread([this] { this->PrefetchWorker(); }));
     }
     context_.SwitchToDevice(0);
-    std::unique_lock<std::mutex> lock(prefetch_access_mutex_);
-    while (!prefetched_)
-      consumer_.wait(lock);
-    if (!prefetch_success_) {
+    {
+      std::unique_lock<std::mutex> lock(prefetch_access_mutex_);
+      if (produced_ == consumed_) {
+        // The consumer is starved: no prefetched batch is ready.
+        Timer timer;
+        while (produced_ == consumed_)
+          consumer_.wait(lock);
+        CAFFE_EVENT(prefetch_stats_, starved_runs);
+        CAFFE_EVENT(
+            prefetch_stats_,
+            wait_us,
+            static_cast<int64_t>(timer.MicroSeconds()));
+      }
+    }
+    // The slot is ours until consumed_ moves on, the prefetching thread keeps
+    // filling the other ones meanwhile.
+    const int slot = consume_slot();
+    if (!slot_success_[slot]) {
       LOG(ERROR) << "Prefetching failed.";
       return false;
     }
+    if (!ready_events_.empty()) {
+      context_.WaitEvent(*ready_events_[slot]);
+    }
+    Timer copy_timer;
     if (!CopyPrefetched()) {
       LOG(ERROR) << "Error when copying prefetched data.";
       return false;
     }
-    prefetched_ = false;
+    // Our outputs must be ready when we return, and the slot must not be
+    // refilled while it is still being copied from.
     context_.FinishDeviceComputation();
+    CAFFE_EVENT(
+        prefetch_stats_,
+        copy_us,
+        static_cast<int64_t>(copy_timer.MicroSeconds()));
+    if (!ready_events_.empty()) {
+      ready_events_[slot]->Reset();
+    }
+    {
+      std::unique_lock<std::mutex> lock(prefetch_access_mutex_);
+      ++consumed_;
+    }
     producer_.notify_one();
     return true;
   }
@@ -105,25 +168,42 @@ class PrefetchOperator : public OperatorBase {
   void PrefetchWorker() {
     context_.SwitchToDevice();
     std::unique_lock<std::mutex> lock(prefetch_access_mutex_);
-    while (prefetched_)
-      producer_.wait(lock);
     while (!finalize_) {
-      // We will need to run a FinishDeviceComputation() call because the
-      // prefetcher thread and the main thread are potentially using different
-      // streams (like on GPU).
+      if (produced_ - consumed_ == num_slots_) {
+        producer_.wait(lock);
+        continue;
+      }
+      const int slot = prefetch_slot();
+      lock.unlock();
+      bool success = false;
+      Timer timer;
       try {
-        prefetch_success_ = Prefetch();
-        context_.FinishDeviceComputation();
+        success = Prefetch();
+        // The prefetcher thread and the main thread are potentially using
+        // different streams (like on GPU), so the main thread waits for our
+        // copies with an event, or with a FinishDeviceComputation() call
+        // where there are none.
+        if (!ready_events_.empty()) {
+          context_.Record(ready_events_[slot].get());
+        } else {
+          context_.FinishDeviceComputation();
+        }
       } catch (const std::exception& e) {
         // TODO: propagate exception_ptr to the caller side
         LOG(ERROR) << "Prefetching error " << e.what();
-        prefetch_success_ = false;
+        success = false;
       }
-      prefetched_ = true;
+      CAFFE_EVENT(
+          prefetch_stats_,
+          prefetch_us,
+          static_cast<int64_t>(timer.MicroSeconds()));
+      lock.lock();
+      slot_success_[slot] = success;
+      ++produced_;
       consumer_.notify_one();
-      while (prefetched_)
-        producer_.wait(lock);
     }
+    lock.unlock();
+    context_.FinishDeviceComputation();
   }
 
   // You will need to implement this instead of the Run function.
@@ -131,16 +211,63 @@ class PrefetchOperator : public OperatorBase {
   virtual bool CopyPrefetched() = 0;
 
  protected:
+  int prefetch_slots() const {
+    return num_slots_;
+  }
+  // Slot filled by Prefetch(), only valid on the prefetching thread.
+  int prefetch_slot() const {
+    return produced_ % num_slots_;
+  }
+  // Slot read by CopyPrefetched(), only valid on the calling thread.
+  int consume_slot() const {
+    return consumed_ % num_slots_;
+  }
+
+  // Copies src to dst from Prefetch(), asynchronously on devices. src is
+  // then swapped with the host buffer kept for buffer_id in the current slot,
+  // so that the memory being copied from stays untouched until the slot is
+  // consumed while src can be refilled right away. The host buffers are
+  // pinned whenever the device's pinned CPU allocator is on.
+  void CopyToDeviceAsync(TensorCPU* src, Tensor<Context>* dst, int buffer_id) {
+    dst->CopyFrom(*src, &context_);
+    auto& buffers = host_buffers_[prefetch_slot()];
+    if (buffers.size() <= static_cast<size_t>(buffer_id)) {
+      buffers.resize(buffer_id + 1);
+    }
+    buffers[buffer_id].swap(*src);
+    // Keep the shape, the type is set again by the next mutable_data() call
+    src->ResizeLike(buffers[buffer_id]);
+  }
+
   Context context_;
   std::mutex prefetch_access_mutex_;
   std::condition_variable producer_, consumer_;
-  // prefetched_ is used to tell the operator that it is done.
-  std::atomic<bool> prefetched_;
-  // prefetch_success_ is used to see if prefetching failed or not.
-  std::atomic<bool> prefetch_success_;
+  const int num_slots_;
+  // Whether prefetching the batch of every slot succeeded.
+  vector<char> slot_success_;
+  // Host buffers of every slot, see CopyToDeviceAsync().
+  vector<vector<TensorCPU>> host_buffers_;
+  // Recorded after the device copies of every slot, if Context has streams.
+  vector<std::unique_ptr<Event>> ready_events_;
+  // Number of batches prefetched and consumed so far.
+  std::atomic<int64_t> produced_;
+  std::atomic<int64_t> consumed_;
   // finalize_ is used to tell the prefetcher to quit.
   std::atomic<bool> finalize_;
   unique_ptr<std::thread> prefetch_thread_;
+
+  struct PrefetchStats {
+    CAFFE_STAT_CTOR(PrefetchStats);
+    // Time spent in Prefetch(), including the device copies it issues, per
+    // batch.
+    CAFFE_AVG_EXPORTED_STAT(prefetch_us);
+    // Number of Run() calls that found no batch ready, and how long they
+    // waited for one.
+    CAFFE_EXPORTED_STAT(starved_runs);
+    CAFFE_AVG_EXPORTED_STAT(wait_us);
+    // Time spent in CopyPrefetched() and waiting for the device, per batch.
+    CAFFE_AVG_EXPORTED_STAT(copy_us);
+  } prefetch_stats_;
 };
 
 } // namespace caffe2
@@ -0,0 +1,273 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "hip/hip_runtime.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Codebooks of up to kSharedCodebookSize floats are staged in shared memory
+// (LDS) by every block, larger ones are read from global memory.
+constexpr int kSharedCodebookSize = 4096;
+
+// The gradient blocks each accumulate into a shared copy of the codebook
+// gradient before adding it to the global one, so that there are no more
+// than kMaxGradientBlocks global atomics per codebook entry.
+constexpr int kMaxGradientBlocks = 64;
+
+template <typename CodeT, bool SHARED_CODEBOOK>
+__global__ void quant_decode_kernel(
+    const int n, const int cb_size, const float* codebook, const CodeT* codes, float* out)
+{
+    HIP_DYNAMIC_SHARED(float, shared_codebook)
+    const float* cb = codebook;
+    if(SHARED_CODEBOOK)
+    {
+        for(int i = hipThreadIdx_x; i < cb_size; i += hipBlockDim_x)
+        {
+            shared_codebook[i] = codebook[i];
+        }
+        __syncthreads();
+        cb = shared_codebook;
+    }
+    HIP_1D_KERNEL_LOOP(i, n)
+    {
+        const int code = codes[i];
+        HIP_KERNEL_ASSERT(code >= 0 && code < cb_size);
+        out[i] = cb[code];
+    }
+}
+
+template <typename CodeT, bool SHARED_CODEBOOK>
+__global__ void quant_decode_gradient_kernel(
+    const int n, const int cb_size, const CodeT* codes, const float* grad, float* cb_grad)
+{
+    HIP_DYNAMIC_SHARED(float, shared_grad)
+    float* acc = cb_grad;
+    if(SHARED_CODEBOOK)
+    {
+        for(int i = hipThreadIdx_x; i < cb_size; i += hipBlockDim_x)
+        {
+            shared_grad[i] = 0.f;
+        }
+        __syncthreads();
+        acc = shared_grad;
+    }
+    HIP_1D_KERNEL_LOOP(i, n)
+    {
+        const int code = codes[i];
+        HIP_KERNEL_ASSERT(code >= 0 && code < cb_size);
+        atomicAdd(&acc[code], grad[i]);
+    }
+    if(SHARED_CODEBOOK)
+    {
+        __syncthreads();
+        for(int i = hipThreadIdx_x; i < cb_size; i += hipBlockDim_x)
+        {
+            if(shared_grad[i] != 0.f)
+            {
+                atomicAdd(&cb_grad[i], shared_grad[i]);
+            }
+        }
+    }
+}
+
+template <typename CodeT>
+void QuantDecode(
+    const int n, const int cb_size, const float* codebook, const CodeT* codes, float* out,
+    HIPContext* context)
+{
+    if(cb_size <= kSharedCodebookSize)
+    {
+        hipLaunchKernelGGL((quant_decode_kernel<CodeT, true>),
+                           dim3(CAFFE_GET_BLOCKS(n)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           cb_size * sizeof(float),
+                           context->hip_stream(),
+                           n,
+                           cb_size,
+                           codebook,
+                           codes,
+                           out);
+    }
+    else
+    {
+        hipLaunchKernelGGL((quant_decode_kernel<CodeT, false>),
+                           dim3(CAFFE_GET_BLOCKS(n)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context->hip_stream(),
+                           n,
+                           cb_size,
+                           codebook,
+                           codes,
+                           out);
+    }
+}
+
+template <typename CodeT>
+void QuantDecodeGradient(
+    const int n, const int cb_size, const CodeT* codes, const float* grad, float* cb_grad,
+    HIPContext* context)
+{
+    if(cb_size <= kSharedCodebookSize)
+    {
+        hipLaunchKernelGGL((quant_decode_gradient_kernel<CodeT, true>),
+                           dim3(std::min(CAFFE_GET_BLOCKS(n), kMaxGradientBlocks)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           cb_size * sizeof(float),
+                           context->hip_stream(),
+                           n,
+                           cb_size,
+                           codes,
+                           grad,
+                           cb_grad);
+    }
+    else
+    {
+        hipLaunchKernelGGL((quant_decode_gradient_kernel<CodeT, false>),
+                           dim3(CAFFE_GET_BLOCKS(n)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context->hip_stream(),
+                           n,
+                           cb_size,
+                           codes,
+                           grad,
+                           cb_grad);
+    }
+}
+
+} // namespace
+
+// HIP counterparts of QuantDecodeOp and QuantDecodeGradientOp
+// (quant_decode_op.h), for a float codebook and uint8, uint16 or int32 codes.
+class HIPQuantDecodeOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPQuantDecodeOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        CAFFE_ENFORCE_GT(InputSize(), 1);
+        // first input is the codebook
+        CAFFE_ENFORCE_EQ(InputSize(), OutputSize() + 1);
+
+        const auto& codebook = Input(0);
+        CAFFE_ENFORCE(codebook.template IsType<float>(), codebook.meta().name());
+
+        for(int i = 0; i < OutputSize(); i++)
+        {
+            code_index_ = i + 1;
+            CAFFE_ENFORCE(DispatchHelper<TensorTypes<uint8_t, uint16_t, int32_t>>::call(
+                this, Input(code_index_)));
+        }
+        return true;
+    }
+
+    template <typename CodeT>
+    bool DoRunWithType()
+    {
+        const auto& codebook = Input(0);
+        const auto& codes    = Input(code_index_);
+        auto* output         = Output(code_index_ - 1);
+        output->ResizeLike(codes);
+        if(codes.size() > 0)
+        {
+            QuantDecode<CodeT>(codes.size(),
+                               codebook.size(),
+                               codebook.template data<float>(),
+                               codes.template data<CodeT>(),
+                               output->template mutable_data<float>(),
+                               &context_);
+        }
+        return true;
+    }
+
+    private:
+    int code_index_ = 1;
+};
+
+class HIPQuantDecodeGradientOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPQuantDecodeGradientOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        // Inputs: 1 codebook, n tensors of codes, and n corresponding gradients.
+        CAFFE_ENFORCE(InputSize() >= 3 && InputSize() % 2 == 1);
+        const int num_code_tensors = (InputSize() - 1) / 2;
+        CAFFE_ENFORCE_EQ(OutputSize(), 1);
+
+        const auto& codebook = Input(0);
+        CAFFE_ENFORCE(codebook.template IsType<float>(), codebook.meta().name());
+
+        auto* gradient = Output(0);
+        gradient->ResizeLike(codebook);
+        math::Set<float, HIPContext>(
+            gradient->size(), 0.f, gradient->template mutable_data<float>(), &context_);
+
+        for(int i = 0; i < num_code_tensors; i++)
+        {
+            code_index_ = i + 1;
+            CAFFE_ENFORCE(DispatchHelper<TensorTypes<uint8_t, uint16_t, int32_t>>::call(
+                this, Input(code_index_)));
+        }
+        return true;
+    }
+
+    template <typename CodeT>
+    bool DoRunWithType()
+    {
+        const int num_code_tensors = (InputSize() - 1) / 2;
+        const auto& codes          = Input(code_index_);
+        const auto& grad           = Input(code_index_ + num_code_tensors);
+        CAFFE_ENFORCE_EQ(codes.size(), grad.size());
+        if(codes.size() > 0)
+        {
+            QuantDecodeGradient<CodeT>(codes.size(),
+                                       Input(0).size(),
+                                       codes.template data<CodeT>(),
+                                       grad.template data<float>(),
+                                       Output(0)->template mutable_data<float>(),
+                                       &context_);
+        }
+        return true;
+    }
+
+    private:
+    int code_index_ = 1;
+};
+
+REGISTER_HIP_OPERATOR(QuantDecode, HIPQuantDecodeOp);
+REGISTER_HIP_OPERATOR(QuantDecodeGradient, HIPQuantDecodeGradientOp);
+
+} // namespace caffe2
@@ -53,15 +53,19 @@ HIPRecurrentNetworkExecutor::~HIPRecurrentNetworkExecutor()
  * Special execution for HIP. It tries to run ops with as little overhead as
  * possible, but to identify opportunities to run ops with "frontier execution"
  * parallelism, i.e by starting kernel from next timestep in parallel with
- * the current timestep. This is done by assigning streams.
+ * the current timestep. This is done by assigning streams: timestep t runs
+ * on stream t % max_streams and waits on events of its recurrent parents
+ * only, so with enough streams layer l of timestep t overlaps layer l + 1 of
+ * timestep t - 1.
  */
 void HIPRecurrentNetworkExecutor::_ExecRange(int from, int to)
 {
     int direction = to > from ? 1 : -1;
 
+    int num_streams = max_hip_streams_ > 0 ? max_hip_streams_ : std::max(2, wavefront_width_);
     int max_streams = max_parallel_timesteps_ > 0
-                          ? std::min(max_parallel_timesteps_, max_hip_streams_)
-                          : max_hip_streams_;
+                          ? std::min(max_parallel_timesteps_, num_streams)
+                          : num_streams;
     int stream_seq = 0;
     int num_ops    = timestep_ops_[0].size();
 
@@ -134,7 +138,8 @@ void HIPRecurrentNetworkExecutor::_ExecRange(int from, int to)
                         // Create event for recurrent connections
                         if(events_[event_idx] == nullptr)
                         {
-                            HIP_CHECK(hipEventCreate(&events_[event_idx]));
+                            HIP_CHECK(hipEventCreateWithFlags(&events_[event_idx],
+                                                              hipEventDisableTiming));
                         }
                         HIP_CHECK(hipEventRecord(events_[event_idx],
                                                  HIPContext::hip_stream(gpu_id, stream_id)));
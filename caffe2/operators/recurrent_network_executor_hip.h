@@ -82,6 +82,43 @@ class HIPRecurrentNetworkExecutor : public RecurrentNetworkExecutorBase
             }
         }
         LOG(INFO) << "Analyzed ops for timestep parallelism: " << has_timestep_parallelism_;
+
+        /**
+          * Each timestep runs on its own stream, so the number of timesteps
+          * that can be in flight at once is the width of the wavefront: an op
+          * that waits on the previous timestep but not on any earlier op of
+          * its own timestep (e.g. the first op of each layer of a stacked
+          * LSTM) can run one timestep behind the ops before it.
+          */
+        wavefront_width_ = 0;
+        std::vector<bool> downstream(timestep_ops_template_.size(), false);
+        for(auto& rnn_op : timestep_ops_template_)
+        {
+            int i = rnn_op.order;
+            if(rnn_op.link_op ||
+               (rnn_op.num_dynamic_inputs == 0 && rnn_op.num_recurrent_inputs == 0))
+            {
+                continue;
+            }
+            bool has_recurrent_parent = false;
+            for(int parent : rnn_op.parents)
+            {
+                if(parent > i)
+                {
+                    has_recurrent_parent = true;
+                }
+                else if(downstream[parent])
+                {
+                    downstream[i] = true;
+                }
+            }
+            if(has_recurrent_parent && !downstream[i])
+            {
+                wavefront_width_++;
+                downstream[i] = true;
+            }
+        }
+        LOG(INFO) << "Analyzed ops for wavefront width: " << wavefront_width_;
     }
 
     public:
@@ -92,7 +129,9 @@ class HIPRecurrentNetworkExecutor : public RecurrentNetworkExecutorBase
 
     std::vector<hipEvent_t> events_;
     bool has_timestep_parallelism_ = false;
-    int max_hip_streams_           = 2;
+    int wavefront_width_           = 0;
+    // 0 picks the number of streams from the wavefront width.
+    int max_hip_streams_ = 0;
 };
 }
 #endif
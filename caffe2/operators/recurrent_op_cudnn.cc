@@ -522,96 +522,11 @@ bool RecurrentParamAccessOp<T, mode>::RunOnDevice() {
 }
 
 REGISTER_CUDNN_OPERATOR(Recurrent, RecurrentOp<float>);
-OPERATOR_SCHEMA(Recurrent).NumInputs(4).NumOutputs(5).SetDoc(R"DOC(
-
-Recurrent wraps the CuDNN R5 RNN implementation. See the CuDNN R5
-documentation for more information.
-
-In general, the implementation takes an input (TxNxD) tensor, the
-hidden state input (NxD), the cell input (NxD), and a weight tensor
-(effectively an opaque blob, where the size and layout is dictated by
-CuDNN).
-
-The outputs are the output (again, TxNxD), the final hidden/cell
-states (NxD). These can be reset (at sequence boundaries across
-minibatches) by multiplying by zero.
-
-The CuDNN arguments (hidden_size, bidirectional, num_layers, rnn_mode,
-input_mode) are passed directly through to CuDNN.
-
-)DOC");
 REGISTER_CUDNN_OPERATOR(RecurrentGradient, RecurrentGradientOp<float>);
-OPERATOR_SCHEMA(RecurrentGradient)
-    .NumInputs(7)
-    .NumOutputs(6)
-    .AllowInplace({{4, 5}});
-
 REGISTER_CUDNN_OPERATOR(
     RecurrentParamSet,
     RecurrentParamAccessOp<float, SET_PARAM>);
-OPERATOR_SCHEMA(RecurrentParamSet)
-    .NumInputs(3)
-    .NumOutputs(1)
-    .EnforceInplace({{1, 0}})
-    .SetDoc("Set individual parameters of a recurrent net.")
-    .Arg("param_type", R"DOC(Type of param to be set:
-                  "input_gate_w", "forget_gate_w", "cell_w", "output_gate_w"
-                  "input_gate_b", "forget_gate_b", "cell_b", "output_gate_b"
-                  )DOC")
-    .Arg("input_type", "'recurrent' or 'input'")
-    .Arg("layer", "layer index (starting from 0)")
-    .Input(0, "input", R"DOC(Input blob. Needed for inferring the shapes.
-                        A dummy tensor matching the input shape is ok.)DOC")
-    .Input(1, "all_params", "Blob holding all the parameters")
-    .Input(2, "param", "Values for the specified parameter")
-    .Output(
-        0,
-        "all_params",
-        "Blob holding all the parameters (same as input(1))");
-
 REGISTER_CUDNN_OPERATOR(
     RecurrentParamGet,
     RecurrentParamAccessOp<float, GET_PARAM>);
-OPERATOR_SCHEMA(RecurrentParamGet)
-    .NumInputs(2)
-    .NumOutputs(1)
-    .SetDoc("Retrieve individual parameters of a recurrent net op.")
-    .Arg("param_type", R"DOC(Type of param to be set:
-                  "input_gate_w", "forget_gate_w", "cell_w", "output_gate_w"
-                  "input_gate_b", "forget_gate_b", "cell_b", "output_gate_b"
-                  )DOC")
-    .Arg("input_type", "'recurrent' or 'input'")
-    .Arg("layer", "layer index (starting from 0)")
-    .Input(0, "input", R"DOC(Input blob. Needed for inferring the shapes.
-                        A dummy tensor matching the input shape is ok.)DOC")
-    .Input(1, "all_params", "Blob holding all the parameters")
-    .Output(0, "param", "Blob holding the requested values");
-
-struct GetRecurrentGradient : public GradientMakerBase {
-  using GradientMakerBase::GradientMakerBase;
-  vector<OperatorDef> GetGradientDefs() override {
-    return SingleGradientDef(
-        "RecurrentGradient",
-        "",
-        vector<string>{I(0), // INPUT
-                       I(1), // HIDDEN_INPUT
-                       I(2), // CELL_INPUT
-                       I(3), // WEIGHT
-                       O(3), // RNN_SCRATCH
-                       O(0), // OUTPUT
-                       GO(0)}, // GRAD_OUTPUT
-        // TODO: not currently using these gradients, investigate t16675365
-        //     GO(1), // GRAD_HIDDEN_OUTPUT
-        //     GO(2)}, // GRAD_CELL_OUTPUT
-        vector<string>{
-            GI(0), // GRAD_INPUT
-            GI(1), // GRAD_HIDDEN_INPUT
-            GI(2), // GRAD_CELL_INPUT
-            GI(3), // GRAD_WEIGHT
-            O(4), // DROPOUT_STATES
-            O(3) // RNN_SCRATCH
-        });
-  }
-};
-REGISTER_GRADIENT(Recurrent, GetRecurrentGradient);
 }
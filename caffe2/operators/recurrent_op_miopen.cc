@@ -0,0 +1,496 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/recurrent_op_miopen.h"
+#include "caffe2/utils/math.h"
+
+#include <map>
+
+namespace caffe2 {
+
+namespace detail {
+
+template <typename T>
+MIOPENTensorDescriptors<T>::MIOPENTensorDescriptors(size_t n,
+                                                    const std::vector<int>& dim,
+                                                    const std::vector<int>& stride)
+{
+    descs_.resize(n);
+    CAFFE_ENFORCE_EQ(dim.size(), stride.size());
+    for(auto i = 0; i < n; ++i)
+    {
+        MIOPEN_ENFORCE(miopenCreateTensorDescriptor(&descs_[i]));
+        MIOPEN_ENFORCE(miopenSetTensorDescriptor(descs_[i],
+                                                 miopenTypeWrapper<T>::type,
+                                                 dim.size(),
+                                                 const_cast<int*>(dim.data()),
+                                                 const_cast<int*>(stride.data())));
+    }
+}
+
+template <typename T>
+MIOPENTensorDescriptors<T>::~MIOPENTensorDescriptors()
+{
+    for(auto desc : descs_)
+    {
+        miopenDestroyTensorDescriptor(desc);
+    }
+}
+} // namespace detail
+
+template <typename T>
+MIOPENRecurrentBaseOp<T>::MIOPENRecurrentBaseOp(const OperatorDef& operator_def, Workspace* ws)
+    : Operator<HIPContext>(operator_def, ws),
+      miopen_wrapper_(&context_),
+      weightsNbytes_(0),
+      reserveNbytes_(0),
+      miopenWsNbytes_(0)
+{
+    MIOPEN_ENFORCE(miopenCreateRNNDescriptor(&rnnDesc_));
+    MIOPEN_ENFORCE(miopenCreateTensorDescriptor(&wDesc_));
+    MIOPEN_ENFORCE(miopenCreateTensorDescriptor(&hxDesc_));
+    MIOPEN_ENFORCE(miopenCreateTensorDescriptor(&cxDesc_));
+    MIOPEN_ENFORCE(miopenCreateTensorDescriptor(&hyDesc_));
+    MIOPEN_ENFORCE(miopenCreateTensorDescriptor(&cyDesc_));
+}
+
+template <typename T>
+MIOPENRecurrentBaseOp<T>::~MIOPENRecurrentBaseOp()
+{
+    MIOPEN_ENFORCE(miopenDestroyRNNDescriptor(rnnDesc_));
+    MIOPEN_ENFORCE(miopenDestroyTensorDescriptor(wDesc_));
+    MIOPEN_ENFORCE(miopenDestroyTensorDescriptor(hxDesc_));
+    MIOPEN_ENFORCE(miopenDestroyTensorDescriptor(cxDesc_));
+    MIOPEN_ENFORCE(miopenDestroyTensorDescriptor(hyDesc_));
+    MIOPEN_ENFORCE(miopenDestroyTensorDescriptor(cyDesc_));
+}
+
+template <typename T>
+void MIOPENRecurrentBaseOp<T>::initialize(const Tensor<HIPContext>& input,
+                                          Tensor<HIPContext>* dropoutStates,
+                                          Tensor<HIPContext>* output,
+                                          Tensor<HIPContext>* hiddenOutput,
+                                          Tensor<HIPContext>* cellOutput)
+{
+    static_assert(sizeof(T) == 4, ""); // workaround clang bug
+    CAFFE_ENFORCE_GE(input.ndim(), 3);
+    const int seqLength  = input.dim(0);
+    const int batchSize  = input.dim(1);
+    const int inputDim   = input.dim(2);
+    const int hiddenSize = OperatorBase::GetSingleArgument<int>("hidden_size", 0);
+    CAFFE_ENFORCE_GT(hiddenSize, 0);
+    const auto bidirectional = OperatorBase::GetSingleArgument<int>("bidirectional", 0);
+    CAFFE_ENFORCE(bidirectional == 0 || bidirectional == 1);
+    const auto numDirections = bidirectional == 1 ? 2 : 1;
+    const auto outputDim     = hiddenSize * numDirections;
+    const auto rnnDirection  = bidirectional == 1 ? miopenRNNbidirection : miopenRNNunidirection;
+    const auto numLayers     = OperatorBase::GetSingleArgument<int>("num_layers", 0);
+    CAFFE_ENFORCE_GT(numLayers, 0);
+    const auto& rnnModeStr = OperatorBase::GetSingleArgument<string>("rnn_mode", "");
+    CAFFE_ENFORCE(rnnModeStr == "lstm" || rnnModeStr == "gru");
+    const auto rnnMode      = rnnModeStr == "lstm" ? miopenLSTM : miopenGRU;
+    const auto& rnnInputStr = OperatorBase::GetSingleArgument<string>("input_mode", "");
+    CAFFE_ENFORCE(rnnInputStr == "linear" || rnnInputStr == "skip");
+    const auto rnnInput = rnnInputStr == "linear" ? miopenRNNlinear : miopenRNNskip;
+
+    // Dropout setup: the MIOpen RNN has no dropout, the states stay empty.
+    {
+        CAFFE_ENFORCE_GE(OperatorBase::GetSingleArgument<float>("dropout", 1.0),
+                         1.0,
+                         "Dropout is not supported by the MIOpen Recurrent op");
+        if(dropoutStates)
+        {
+            dropoutStates->Resize(std::vector<int>{0});
+            dropoutStates->template mutable_data<T>();
+        }
+    }
+
+    // RNN setup
+    {
+        MIOPEN_ENFORCE(miopenSetRNNDescriptor(rnnDesc_,
+                                              hiddenSize,
+                                              numLayers,
+                                              rnnInput,
+                                              rnnDirection,
+                                              rnnMode,
+                                              miopenRNNwithBias,
+                                              miopenRNNdefault,
+                                              miopenTypeWrapper<T>::type));
+    }
+    // X setup
+    {
+        xDesc_.reset(new detail::MIOPENTensorDescriptors<T>(
+            seqLength, {batchSize, inputDim}, {inputDim, 1}));
+    }
+    // Y setup
+    {
+        yDesc_.reset(new detail::MIOPENTensorDescriptors<T>(
+            seqLength, {batchSize, outputDim}, {outputDim, 1}));
+
+        if(output)
+        {
+            output->Resize(std::vector<int>{seqLength, batchSize, outputDim});
+        }
+    }
+
+    // Hidden/Cell setup
+    {
+        std::array<int, 3> dim{numLayers * numDirections, batchSize, hiddenSize};
+        std::array<int, 3> stride{batchSize * hiddenSize, hiddenSize, 1};
+        for(auto desc : {hxDesc_, cxDesc_, hyDesc_, cyDesc_})
+        {
+            MIOPEN_ENFORCE(miopenSetTensorDescriptor(
+                desc, miopenTypeWrapper<T>::type, 3, dim.data(), stride.data()));
+        }
+
+        if(hiddenOutput)
+        {
+            hiddenOutput->Resize(
+                std::vector<int>{numLayers * numDirections, batchSize, hiddenSize});
+        }
+
+        if(cellOutput)
+        {
+            cellOutput->Resize(
+                std::vector<int>{numLayers * numDirections, batchSize, hiddenSize});
+        }
+    }
+
+    // Weights setup
+    {
+        MIOPEN_ENFORCE(miopenGetRNNParamsSize(miopen_wrapper_.inline_miopen_handle(),
+                                              rnnDesc_,
+                                              xDesc_->descs()[0],
+                                              &weightsNbytes_,
+                                              miopenTypeWrapper<T>::type));
+        MIOPEN_ENFORCE(miopenGetRNNParamsDescriptor(miopen_wrapper_.inline_miopen_handle(),
+                                                    rnnDesc_,
+                                                    xDesc_->descs()[0],
+                                                    wDesc_,
+                                                    miopenTypeWrapper<T>::type));
+    }
+
+    // RNN workspace and training reserve sizes
+    {
+        MIOPEN_ENFORCE(miopenGetRNNWorkspaceSize(miopen_wrapper_.inline_miopen_handle(),
+                                                 rnnDesc_,
+                                                 seqLength,
+                                                 xDesc_->descs(),
+                                                 &miopenWsNbytes_));
+        MIOPEN_ENFORCE(miopenGetRNNTrainingReserveSize(miopen_wrapper_.inline_miopen_handle(),
+                                                       rnnDesc_,
+                                                       seqLength,
+                                                       xDesc_->descs(),
+                                                       &reserveNbytes_));
+    }
+}
+
+template <typename T>
+bool MIOPENRecurrentOp<T>::RunOnDevice()
+{
+    const int seqLength = Input(INPUT).dim32(0);
+    if(Input(INPUT).dims() != cachedInputDims_)
+    {
+        initialize(Input(INPUT),
+                   Output(DROPOUT_STATES),
+                   Output(OUTPUT),
+                   Output(HIDDEN_OUTPUT),
+                   Output(CELL_OUTPUT));
+        cachedInputDims_ = Input(INPUT).dims();
+    }
+
+    // Validation checks
+    CAFFE_ENFORCE_EQ(Input(WEIGHT).nbytes(), weightsNbytes_);
+
+    // Training reserve
+    Output(RNN_SCRATCH)->Resize(
+        std::vector<int>{static_cast<int>(reserveNbytes_ / 4)}); // sizeof(T) - workaround clang bug
+    Output(RNN_SCRATCH)->template mutable_data<T>();
+
+    auto InputData  = [this](int i) { return this->Input(i).template data<T>(); };
+    auto OutputData = [this](int i) { return this->Output(i)->template mutable_data<T>(); };
+
+    if(OperatorBase::GetSingleArgument<int>(OpSchema::Arg_IsTest, 0))
+    {
+        miopen_wrapper_.with_miopen_state(0, [&](MIOPENState* state) {
+            MIOPEN_ENFORCE(miopenRNNForwardInference(state->miopen_handle(),
+                                                     rnnDesc_,
+                                                     seqLength,
+                                                     xDesc_->descs(),
+                                                     InputData(INPUT),
+                                                     hxDesc_,
+                                                     InputData(HIDDEN_INPUT),
+                                                     cxDesc_,
+                                                     InputData(CELL_INPUT),
+                                                     wDesc_,
+                                                     InputData(WEIGHT),
+                                                     yDesc_->descs(),
+                                                     OutputData(OUTPUT),
+                                                     hyDesc_,
+                                                     OutputData(HIDDEN_OUTPUT),
+                                                     cyDesc_,
+                                                     OutputData(CELL_OUTPUT),
+                                                     state->workspace().get(miopenWsNbytes_),
+                                                     miopenWsNbytes_));
+        });
+    }
+    else
+    {
+        miopen_wrapper_.with_miopen_state(0, [&](MIOPENState* state) {
+            MIOPEN_ENFORCE(miopenRNNForwardTraining(state->miopen_handle(),
+                                                    rnnDesc_,
+                                                    seqLength,
+                                                    xDesc_->descs(),
+                                                    InputData(INPUT),
+                                                    hxDesc_,
+                                                    InputData(HIDDEN_INPUT),
+                                                    cxDesc_,
+                                                    InputData(CELL_INPUT),
+                                                    wDesc_,
+                                                    InputData(WEIGHT),
+                                                    yDesc_->descs(),
+                                                    OutputData(OUTPUT),
+                                                    hyDesc_,
+                                                    OutputData(HIDDEN_OUTPUT),
+                                                    cyDesc_,
+                                                    OutputData(CELL_OUTPUT),
+                                                    state->workspace().get(miopenWsNbytes_),
+                                                    miopenWsNbytes_,
+                                                    OutputData(RNN_SCRATCH),
+                                                    reserveNbytes_));
+        });
+    }
+
+    return true;
+}
+
+template <typename T>
+bool MIOPENRecurrentGradientOp<T>::RunOnDevice()
+{
+    const int seqLength = Input(INPUT).dim32(0);
+    if(Input(INPUT).dims() != cachedInputDims_)
+    {
+        initialize(Input(INPUT), Output(DROPOUT_STATES));
+        cachedInputDims_ = Input(INPUT).dims();
+    }
+    CAFFE_ENFORCE_EQ(reserveNbytes_, Input(RNN_SCRATCH).nbytes());
+    Output(GRAD_INPUT)->ResizeLike(Input(INPUT));
+    Output(GRAD_HIDDEN_INPUT)->ResizeLike(Input(HIDDEN_INPUT));
+    Output(GRAD_CELL_INPUT)->ResizeLike(Input(CELL_INPUT));
+
+    Output(GRAD_WEIGHT)->ResizeLike(Input(WEIGHT));
+    math::Set<T, HIPContext>(Output(GRAD_WEIGHT)->size(),
+                             0.0,
+                             Output(GRAD_WEIGHT)->template mutable_data<T>(),
+                             &context_);
+
+    // The scratch is updated in place by the backward pass.
+    auto* reserve   = Output(RNN_SCRATCH_OUT)->template mutable_data<T>();
+    auto InputData  = [this](int i) { return this->Input(i).template data<T>(); };
+    auto OutputData = [this](int i) { return this->Output(i)->template mutable_data<T>(); };
+
+    miopen_wrapper_.with_miopen_state(0, [&](MIOPENState* state) {
+        MIOPEN_ENFORCE(miopenRNNBackwardData(state->miopen_handle(),
+                                             rnnDesc_,
+                                             seqLength,
+                                             yDesc_->descs(),
+                                             InputData(OUTPUT),
+                                             yDesc_->descs(),
+                                             InputData(GRAD_OUTPUT),
+                                             hyDesc_,
+                                             // Like the CuDNN op, ignore these
+                                             // gradient inputs.
+                                             nullptr,
+                                             cyDesc_,
+                                             nullptr,
+                                             wDesc_,
+                                             InputData(WEIGHT),
+                                             hxDesc_,
+                                             InputData(HIDDEN_INPUT),
+                                             cxDesc_,
+                                             InputData(CELL_INPUT),
+                                             xDesc_->descs(),
+                                             OutputData(GRAD_INPUT),
+                                             hxDesc_,
+                                             OutputData(GRAD_HIDDEN_INPUT),
+                                             cxDesc_,
+                                             OutputData(GRAD_CELL_INPUT),
+                                             state->workspace().get(miopenWsNbytes_),
+                                             miopenWsNbytes_,
+                                             reserve,
+                                             reserveNbytes_));
+        MIOPEN_ENFORCE(miopenRNNBackwardWeights(state->miopen_handle(),
+                                                rnnDesc_,
+                                                seqLength,
+                                                xDesc_->descs(),
+                                                InputData(INPUT),
+                                                hxDesc_,
+                                                InputData(HIDDEN_INPUT),
+                                                yDesc_->descs(),
+                                                InputData(OUTPUT),
+                                                wDesc_,
+                                                OutputData(GRAD_WEIGHT),
+                                                state->workspace().get(miopenWsNbytes_),
+                                                miopenWsNbytes_,
+                                                reserve,
+                                                reserveNbytes_));
+    });
+
+    return true;
+}
+
+template <typename T, MIOPENRecurrentParamOpMode mode>
+bool MIOPENRecurrentParamAccessOp<T, mode>::RunOnDevice()
+{
+    if(Input(0).dims() != cachedInputDims_)
+    {
+        initialize(Input(0));
+        cachedInputDims_ = Input(0).dims();
+    }
+
+    if(mode == SET_PARAM)
+    {
+        CAFFE_ENFORCE_EQ(weightsNbytes_ / 4, Input(1).size(), "Incorrect weight initialization");
+    }
+
+    int layer              = OperatorBase::GetSingleArgument<int>("layer", 0);
+    std::string param_type = OperatorBase::GetSingleArgument<string>("param_type", "");
+    std::string input_type = OperatorBase::GetSingleArgument<string>("input_type", "");
+    CAFFE_ENFORCE_EQ(OperatorBase::GetSingleArgument<string>("rnn_mode", ""),
+                     "lstm",
+                     "Only LSTM parameters can be accessed");
+
+    // Mapping to MIOpen ids, whose LSTM gate order differs from CuDNN's
+    std::map<string, int> weight_constants = {
+        {"input_gate_w", 0}, {"forget_gate_w", 1}, {"output_gate_w", 2}, {"cell_w", 3}};
+    std::map<string, int> bias_constants = {
+        {"input_gate_b", 0}, {"forget_gate_b", 1}, {"output_gate_b", 2}, {"cell_b", 3}};
+    const bool is_bias = bias_constants.find(param_type) != bias_constants.end();
+    CAFFE_ENFORCE(is_bias || weight_constants.find(param_type) != weight_constants.end(),
+                  "Unknown param type:",
+                  param_type);
+    const int param_id =
+        (is_bias ? bias_constants[param_type] : weight_constants[param_type]) +
+        4 * (input_type == "recurrent");
+
+    auto handle = miopen_wrapper_.inline_miopen_handle();
+    miopenTensorDescriptor_t paramDesc;
+    MIOPEN_ENFORCE(miopenCreateTensorDescriptor(&paramDesc));
+    // With a null destination only the descriptor of the param is filled in.
+    size_t paramNbytes;
+    if(is_bias)
+    {
+        MIOPEN_ENFORCE(miopenGetRNNLayerBias(handle,
+                                             rnnDesc_,
+                                             layer,
+                                             xDesc_->descs()[0],
+                                             wDesc_,
+                                             Input(1).template data<T>(),
+                                             param_id,
+                                             paramDesc,
+                                             nullptr));
+        MIOPEN_ENFORCE(miopenGetRNNLayerBiasSize(handle, rnnDesc_, layer, param_id, &paramNbytes));
+    }
+    else
+    {
+        MIOPEN_ENFORCE(miopenGetRNNLayerParam(handle,
+                                              rnnDesc_,
+                                              layer,
+                                              xDesc_->descs()[0],
+                                              wDesc_,
+                                              Input(1).template data<T>(),
+                                              param_id,
+                                              paramDesc,
+                                              nullptr));
+        MIOPEN_ENFORCE(miopenGetRNNLayerParamSize(
+            handle, rnnDesc_, layer, xDesc_->descs()[0], param_id, &paramNbytes));
+    }
+
+    if(mode == SET_PARAM)
+    {
+        CAFFE_ENFORCE_EQ(paramNbytes / sizeof(T), Input(2).size());
+        auto* all_params = Output(0)->template mutable_data<T>();
+        if(is_bias)
+        {
+            MIOPEN_ENFORCE(miopenSetRNNLayerBias(handle,
+                                                 rnnDesc_,
+                                                 layer,
+                                                 xDesc_->descs()[0],
+                                                 wDesc_,
+                                                 all_params,
+                                                 param_id,
+                                                 paramDesc,
+                                                 Input(2).template data<T>()));
+        }
+        else
+        {
+            MIOPEN_ENFORCE(miopenSetRNNLayerParam(handle,
+                                                  rnnDesc_,
+                                                  layer,
+                                                  xDesc_->descs()[0],
+                                                  wDesc_,
+                                                  all_params,
+                                                  param_id,
+                                                  paramDesc,
+                                                  Input(2).template data<T>()));
+        }
+    }
+    else
+    {
+        int numDims;
+        MIOPEN_ENFORCE(miopenGetTensorDescriptorSize(paramDesc, &numDims));
+        std::vector<int> dims(numDims), strides(numDims);
+        miopenDataType_t dt;
+        MIOPEN_ENFORCE(miopenGetTensorDescriptor(paramDesc, &dt, dims.data(), strides.data()));
+        Output(0)->Resize(dims);
+        CAFFE_ENFORCE_EQ(Output(0)->nbytes(), paramNbytes);
+        auto* param = Output(0)->template mutable_data<T>();
+        if(is_bias)
+        {
+            MIOPEN_ENFORCE(miopenGetRNNLayerBias(handle,
+                                                 rnnDesc_,
+                                                 layer,
+                                                 xDesc_->descs()[0],
+                                                 wDesc_,
+                                                 Input(1).template data<T>(),
+                                                 param_id,
+                                                 paramDesc,
+                                                 param));
+        }
+        else
+        {
+            MIOPEN_ENFORCE(miopenGetRNNLayerParam(handle,
+                                                  rnnDesc_,
+                                                  layer,
+                                                  xDesc_->descs()[0],
+                                                  wDesc_,
+                                                  Input(1).template data<T>(),
+                                                  param_id,
+                                                  paramDesc,
+                                                  param));
+        }
+    }
+    MIOPEN_ENFORCE(miopenDestroyTensorDescriptor(paramDesc));
+
+    return true;
+}
+
+REGISTER_MIOPEN_OPERATOR(Recurrent, MIOPENRecurrentOp<float>);
+REGISTER_MIOPEN_OPERATOR(RecurrentGradient, MIOPENRecurrentGradientOp<float>);
+REGISTER_MIOPEN_OPERATOR(RecurrentParamSet, MIOPENRecurrentParamAccessOp<float, SET_PARAM>);
+REGISTER_MIOPEN_OPERATOR(RecurrentParamGet, MIOPENRecurrentParamAccessOp<float, GET_PARAM>);
+
+} // namespace caffe2
@@ -0,0 +1,163 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_OPERATORS_RECURRENT_OP_MIOPEN_H_
+#define CAFFE2_OPERATORS_RECURRENT_OP_MIOPEN_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/miopen_wrapper.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+namespace detail {
+
+template <typename T>
+class MIOPENTensorDescriptors
+{
+    public:
+    MIOPENTensorDescriptors(size_t n, const std::vector<int>& dim, const std::vector<int>& stride);
+    ~MIOPENTensorDescriptors();
+    const miopenTensorDescriptor_t* descs() const { return descs_.data(); }
+
+    private:
+    std::vector<miopenTensorDescriptor_t> descs_;
+};
+
+} // namespace detail
+
+template <typename T>
+class MIOPENRecurrentBaseOp : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    MIOPENRecurrentBaseOp(const OperatorDef& operator_def, Workspace* ws);
+    virtual ~MIOPENRecurrentBaseOp();
+
+    protected:
+    // Sets up the descriptors and the sizes below for the shape of input.
+    // They are cached by the ops until the input shape changes.
+    void initialize(const Tensor<HIPContext>& input,
+                    Tensor<HIPContext>* dropoutStates = nullptr,
+                    // If passed, reshapes to the appropriate size
+                    Tensor<HIPContext>* output       = nullptr,
+                    Tensor<HIPContext>* hiddenOutput = nullptr,
+                    Tensor<HIPContext>* cellOutput   = nullptr);
+
+    MIOPENWrapper miopen_wrapper_;
+    miopenRNNDescriptor_t rnnDesc_;
+    miopenTensorDescriptor_t wDesc_;
+    miopenTensorDescriptor_t hxDesc_;
+    miopenTensorDescriptor_t cxDesc_;
+    miopenTensorDescriptor_t hyDesc_;
+    miopenTensorDescriptor_t cyDesc_;
+
+    std::unique_ptr<detail::MIOPENTensorDescriptors<T>> xDesc_;
+    std::unique_ptr<detail::MIOPENTensorDescriptors<T>> yDesc_;
+
+    std::vector<TIndex> cachedInputDims_;
+    size_t weightsNbytes_;
+    size_t reserveNbytes_;
+    size_t miopenWsNbytes_;
+};
+
+#define USE_MIOPEN_RECURRENT_BASE_FUNCTIONS            \
+    USE_OPERATOR_FUNCTIONS(HIPContext);                \
+    using MIOPENRecurrentBaseOp<T>::miopen_wrapper_;   \
+    using MIOPENRecurrentBaseOp<T>::rnnDesc_;          \
+    using MIOPENRecurrentBaseOp<T>::wDesc_;            \
+    using MIOPENRecurrentBaseOp<T>::hxDesc_;           \
+    using MIOPENRecurrentBaseOp<T>::cxDesc_;           \
+    using MIOPENRecurrentBaseOp<T>::hyDesc_;           \
+    using MIOPENRecurrentBaseOp<T>::cyDesc_;           \
+    using MIOPENRecurrentBaseOp<T>::xDesc_;            \
+    using MIOPENRecurrentBaseOp<T>::yDesc_;            \
+    using MIOPENRecurrentBaseOp<T>::cachedInputDims_;  \
+    using MIOPENRecurrentBaseOp<T>::weightsNbytes_;    \
+    using MIOPENRecurrentBaseOp<T>::reserveNbytes_;    \
+    using MIOPENRecurrentBaseOp<T>::miopenWsNbytes_;   \
+    using MIOPENRecurrentBaseOp<T>::initialize;
+
+template <typename T>
+class MIOPENRecurrentOp : public MIOPENRecurrentBaseOp<T>
+{
+    public:
+    USE_MIOPEN_RECURRENT_BASE_FUNCTIONS
+    MIOPENRecurrentOp(const OperatorDef& operator_def, Workspace* ws)
+        : MIOPENRecurrentBaseOp<T>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override;
+
+    protected:
+    INPUT_TAGS(INPUT, HIDDEN_INPUT, CELL_INPUT, WEIGHT);
+    OUTPUT_TAGS(OUTPUT, HIDDEN_OUTPUT, CELL_OUTPUT, RNN_SCRATCH, DROPOUT_STATES);
+};
+
+enum MIOPENRecurrentParamOpMode
+{
+    SET_PARAM,
+    GET_PARAM
+};
+
+template <typename T, MIOPENRecurrentParamOpMode mode>
+class MIOPENRecurrentParamAccessOp : public MIOPENRecurrentBaseOp<T>
+{
+    public:
+    USE_MIOPEN_RECURRENT_BASE_FUNCTIONS
+    MIOPENRecurrentParamAccessOp(const OperatorDef& operator_def, Workspace* ws)
+        : MIOPENRecurrentBaseOp<T>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override;
+};
+
+template <typename T>
+class MIOPENRecurrentGradientOp : public MIOPENRecurrentBaseOp<T>
+{
+    public:
+    USE_MIOPEN_RECURRENT_BASE_FUNCTIONS
+    MIOPENRecurrentGradientOp(const OperatorDef& operator_def, Workspace* ws)
+        : MIOPENRecurrentBaseOp<T>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override;
+
+    protected:
+    INPUT_TAGS(INPUT,
+               HIDDEN_INPUT,
+               CELL_INPUT,
+               WEIGHT,
+               RNN_SCRATCH,
+               OUTPUT,
+               GRAD_OUTPUT,
+               GRAD_HIDDEN_OUTPUT,
+               GRAD_CELL_OUTPUT);
+    OUTPUT_TAGS(GRAD_INPUT,
+                GRAD_HIDDEN_INPUT,
+                GRAD_CELL_INPUT,
+                GRAD_WEIGHT,
+                DROPOUT_STATES,
+                RNN_SCRATCH_OUT);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_RECURRENT_OP_MIOPEN_H_
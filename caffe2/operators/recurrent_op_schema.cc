@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+// Schemas of the fused RNN ops, shared by the CuDNN and MIOpen
+// implementations.
+OPERATOR_SCHEMA(Recurrent).NumInputs(4).NumOutputs(5).SetDoc(R"DOC(
+
+Recurrent wraps the fused RNN implementation of CuDNN (R5 and later, CUDNN
+engine on CUDA) or MIOpen (MIOPEN engine on HIP). See their documentation
+for more information.
+
+In general, the implementation takes an input (TxNxD) tensor, the
+hidden state input (NxD), the cell input (NxD), and a weight tensor
+(effectively an opaque blob, where the size and layout is dictated by
+the library; weights laid out by one library cannot be used with the
+other).
+
+The outputs are the output (again, TxNxD), the final hidden/cell
+states (NxD). These can be reset (at sequence boundaries across
+minibatches) by multiplying by zero.
+
+The arguments (hidden_size, bidirectional, num_layers, rnn_mode,
+input_mode) are passed directly through to the library. MIOpen does not
+support dropout.
+
+)DOC");
+OPERATOR_SCHEMA(RecurrentGradient)
+    .NumInputs(7)
+    .NumOutputs(6)
+    .AllowInplace({{4, 5}});
+
+OPERATOR_SCHEMA(RecurrentParamSet)
+    .NumInputs(3)
+    .NumOutputs(1)
+    .EnforceInplace({{1, 0}})
+    .SetDoc("Set individual parameters of a recurrent net.")
+    .Arg("param_type", R"DOC(Type of param to be set:
+                  "input_gate_w", "forget_gate_w", "cell_w", "output_gate_w"
+                  "input_gate_b", "forget_gate_b", "cell_b", "output_gate_b"
+                  )DOC")
+    .Arg("input_type", "'recurrent' or 'input'")
+    .Arg("layer", "layer index (starting from 0)")
+    .Input(0, "input", R"DOC(Input blob. Needed for inferring the shapes.
+                        A dummy tensor matching the input shape is ok.)DOC")
+    .Input(1, "all_params", "Blob holding all the parameters")
+    .Input(2, "param", "Values for the specified parameter")
+    .Output(
+        0,
+        "all_params",
+        "Blob holding all the parameters (same as input(1))");
+
+OPERATOR_SCHEMA(RecurrentParamGet)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .SetDoc("Retrieve individual parameters of a recurrent net op.")
+    .Arg("param_type", R"DOC(Type of param to be set:
+                  "input_gate_w", "forget_gate_w", "cell_w", "output_gate_w"
+                  "input_gate_b", "forget_gate_b", "cell_b", "output_gate_b"
+                  )DOC")
+    .Arg("input_type", "'recurrent' or 'input'")
+    .Arg("layer", "layer index (starting from 0)")
+    .Input(0, "input", R"DOC(Input blob. Needed for inferring the shapes.
+                        A dummy tensor matching the input shape is ok.)DOC")
+    .Input(1, "all_params", "Blob holding all the parameters")
+    .Output(0, "param", "Blob holding the requested values");
+
+struct GetRecurrentGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    return SingleGradientDef(
+        "RecurrentGradient",
+        "",
+        vector<string>{I(0), // INPUT
+                       I(1), // HIDDEN_INPUT
+                       I(2), // CELL_INPUT
+                       I(3), // WEIGHT
+                       O(3), // RNN_SCRATCH
+                       O(0), // OUTPUT
+                       GO(0)}, // GRAD_OUTPUT
+        // TODO: not currently using these gradients, investigate t16675365
+        //     GO(1), // GRAD_HIDDEN_OUTPUT
+        //     GO(2)}, // GRAD_CELL_OUTPUT
+        vector<string>{
+            GI(0), // GRAD_INPUT
+            GI(1), // GRAD_HIDDEN_INPUT
+            GI(2), // GRAD_CELL_INPUT
+            GI(3), // GRAD_WEIGHT
+            O(4), // DROPOUT_STATES
+            O(3) // RNN_SCRATCH
+        });
+  }
+};
+REGISTER_GRADIENT(Recurrent, GetRecurrentGradient);
+
+} // namespace caffe2
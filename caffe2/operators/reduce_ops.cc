@@ -0,0 +1,152 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/reduce_ops.h"
+#include "caffe2/core/operator_gradient.h"
+
+namespace caffe2 {
+
+template <>
+template <typename T>
+void ReduceSumOp<CPUContext>::ReduceRun(
+    const TIndex outer,
+    const TIndex run,
+    const TIndex inner,
+    const T divisor,
+    const T* X,
+    T* Y) {
+  // Each outer slice is an inner x run column major matrix.
+  for (TIndex o = 0; o < outer; ++o) {
+    EigenVectorMap<T>(Y + o * inner, inner) =
+        ConstEigenMatrixMap<T>(X + o * run * inner, inner, run)
+            .rowwise()
+            .sum() /
+        divisor;
+  }
+}
+
+template <>
+template <typename T>
+void ReduceSumGradientOp<CPUContext>::ExpandRun(
+    const TIndex outer,
+    const TIndex run,
+    const TIndex inner,
+    const T divisor,
+    const T* dY,
+    T* dX) {
+  for (TIndex o = 0; o < outer; ++o) {
+    EigenMatrixMap<T>(dX + o * run * inner, inner, run).colwise() =
+        ConstEigenVectorMap<T>(dY + o * inner, inner) / divisor;
+  }
+}
+
+REGISTER_CPU_OPERATOR(ReduceSum, ReduceSumOp<CPUContext>);
+REGISTER_CPU_OPERATOR(ReduceSumGradient, ReduceSumGradientOp<CPUContext>);
+REGISTER_CPU_OPERATOR(ReduceMean, ReduceMeanOp<CPUContext>);
+REGISTER_CPU_OPERATOR(ReduceMeanGradient, ReduceMeanGradientOp<CPUContext>);
+
+namespace {
+
+vector<TensorShape> ReduceShapeInference(
+    const OperatorDef& def,
+    const vector<TensorShape>& in) {
+  ArgumentHelper helper(def);
+  const vector<int> axes = helper.GetRepeatedArgument<int>("axes");
+  const int keep_dims = helper.GetSingleArgument<int>("keepdims", 1);
+  const int ndim = in[0].dims_size();
+  vector<bool> reduced(ndim, axes.empty());
+  for (const int axis : axes) {
+    reduced[canonical_axis_index_(axis, ndim)] = true;
+  }
+  vector<int> output_dims;
+  for (int i = 0; i < ndim; ++i) {
+    if (!reduced[i]) {
+      output_dims.push_back(in[0].dims(i));
+    } else if (keep_dims) {
+      output_dims.push_back(1);
+    }
+  }
+  return vector<TensorShape>{
+      CreateTensorShape(output_dims, in[0].data_type())};
+}
+
+} // namespace
+
+OPERATOR_SCHEMA(ReduceSum)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .TensorInferenceFunction(ReduceShapeInference)
+    .SetDoc(R"DOC(
+Computes the sum of the input tensor's elements along the provided axes, or
+all of them when axes is not given. The resulting tensor has the same rank as
+the input if keepdims equals 1, otherwise the reduced dimensions are pruned.
+)DOC")
+    .Arg("axes", "A list of integers, along which to reduce.")
+    .Arg(
+        "keepdims",
+        "Keep the reduced dimension(s) or not, default 1 keeps the reduced "
+        "dimension(s).")
+    .Input(0, "data", "An input tensor.")
+    .Output(0, "reduced", "Reduced output tensor.");
+
+OPERATOR_SCHEMA(ReduceSumGradient).NumInputs(2).NumOutputs(1);
+
+OPERATOR_SCHEMA(ReduceMean)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .TensorInferenceFunction(ReduceShapeInference)
+    .SetDoc(R"DOC(
+Computes the mean of the input tensor's elements along the provided axes, or
+all of them when axes is not given. The resulting tensor has the same rank as
+the input if keepdims equals 1, otherwise the reduced dimensions are pruned.
+)DOC")
+    .Arg("axes", "A list of integers, along which to reduce.")
+    .Arg(
+        "keepdims",
+        "Keep the reduced dimension(s) or not, default 1 keeps the reduced "
+        "dimension(s).")
+    .Input(0, "data", "An input tensor.")
+    .Output(0, "reduced", "Reduced output tensor.");
+
+OPERATOR_SCHEMA(ReduceMeanGradient).NumInputs(2).NumOutputs(1);
+
+class GetReduceSumGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    return SingleGradientDef(
+        "ReduceSumGradient",
+        "",
+        vector<string>{GO(0), I(0)},
+        vector<string>{GI(0)});
+  }
+};
+
+REGISTER_GRADIENT(ReduceSum, GetReduceSumGradient);
+
+class GetReduceMeanGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    return SingleGradientDef(
+        "ReduceMeanGradient",
+        "",
+        vector<string>{GO(0), I(0)},
+        vector<string>{GI(0)});
+  }
+};
+
+REGISTER_GRADIENT(ReduceMean, GetReduceMeanGradient);
+
+} // namespace caffe2
@@ -0,0 +1,284 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_OPERATORS_REDUCE_OPS_H_
+#define CAFFE2_OPERATORS_REDUCE_OPS_H_
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+// Splits the dims of an input reduced over axes into runs of neighbouring
+// dims that are all reduced or all kept, dropping the dims of size 1. A
+// reduction over any set of axes is then a reduction of each reduced run of
+// an [outer, run, inner] view, one after the other.
+inline void MergeReduceDims(
+    const vector<TIndex>& dims,
+    const vector<bool>& reduced,
+    vector<TIndex>* run_dims,
+    vector<bool>* run_reduced) {
+  run_dims->clear();
+  run_reduced->clear();
+  for (int i = 0; i < dims.size(); ++i) {
+    if (dims[i] == 1) {
+      continue;
+    }
+    if (!run_dims->empty() && run_reduced->back() == reduced[i]) {
+      run_dims->back() *= dims[i];
+    } else {
+      run_dims->push_back(dims[i]);
+      run_reduced->push_back(reduced[i]);
+    }
+  }
+}
+
+template <class Context>
+class ReduceSumOp : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  ReduceSumOp(const OperatorDef& operator_def, Workspace* ws)
+      : ReduceSumOp(operator_def, ws, false) {}
+  ReduceSumOp(const OperatorDef& operator_def, Workspace* ws, bool average)
+      : Operator<Context>(operator_def, ws),
+        axes_(OperatorBase::GetRepeatedArgument<int>("axes")),
+        keep_dims_(OperatorBase::GetSingleArgument<int>("keepdims", 1)),
+        average_(average) {}
+  ~ReduceSumOp() {}
+
+  bool RunOnDevice() override {
+    return DispatchHelper<TensorTypes<int, long, float, double>>::call(
+        this, Input(0));
+  }
+
+  template <typename T>
+  bool DoRunWithType() {
+    const auto& X = Input(0);
+    auto* Y = Output(0);
+
+    vector<bool> reduced(X.ndim(), axes_.empty());
+    for (const int axis : axes_) {
+      const int canonical_axis = X.canonical_axis_index(axis);
+      CAFFE_ENFORCE(!reduced[canonical_axis], "Axis ", axis, " repeated.");
+      reduced[canonical_axis] = true;
+    }
+    vector<TIndex> output_dims;
+    TIndex count = 1;
+    for (int i = 0; i < X.ndim(); ++i) {
+      if (reduced[i]) {
+        count *= X.dim(i);
+        if (keep_dims_) {
+          output_dims.push_back(1);
+        }
+      } else {
+        output_dims.push_back(X.dim(i));
+      }
+    }
+    Y->Resize(output_dims);
+    if (Y->size() == 0) {
+      return true;
+    }
+    T* Ydata = Y->template mutable_data<T>();
+    if (count == 0) {
+      math::Set<T, Context>(Y->size(), T(0), Ydata, &context_);
+      return true;
+    }
+
+    vector<TIndex> run_dims;
+    vector<bool> run_reduced;
+    MergeReduceDims(X.dims(), reduced, &run_dims, &run_reduced);
+    const int passes =
+        std::count(run_reduced.begin(), run_reduced.end(), true);
+    if (passes == 0) {
+      context_.template Copy<T, Context, Context>(
+          X.size(), X.template data<T>(), Ydata);
+      return true;
+    }
+
+    // The innermost reduced run goes first, the mean divides once at the
+    // end.
+    const T* in = X.template data<T>();
+    for (int pass = 1, i = run_dims.size() - 1; i >= 0; --i) {
+      if (!run_reduced[i]) {
+        continue;
+      }
+      const TIndex outer = std::accumulate(
+          run_dims.begin(),
+          run_dims.begin() + i,
+          TIndex(1),
+          std::multiplies<TIndex>());
+      const TIndex inner = std::accumulate(
+          run_dims.begin() + i + 1,
+          run_dims.end(),
+          TIndex(1),
+          std::multiplies<TIndex>());
+      T* out = Ydata;
+      if (pass < passes) {
+        buffers_[pass % 2].Resize(outer * inner);
+        out = buffers_[pass % 2].template mutable_data<T>();
+      }
+      const T divisor = average_ && pass == passes ? T(count) : T(1);
+      ReduceRun<T>(outer, run_dims[i], inner, divisor, in, out);
+      in = out;
+      run_dims.erase(run_dims.begin() + i);
+      ++pass;
+    }
+    return true;
+  }
+
+ protected:
+  // Y[o, i] = sum(X[o, :, i]) / divisor for an outer x run x inner input.
+  template <typename T>
+  void ReduceRun(
+      const TIndex outer,
+      const TIndex run,
+      const TIndex inner,
+      const T divisor,
+      const T* X,
+      T* Y);
+
+  vector<int> axes_;
+  int keep_dims_;
+  bool average_;
+  Tensor<Context> buffers_[2];
+  // Partial sums of long runs split across blocks.
+  Tensor<Context> scratch_;
+};
+
+template <class Context>
+class ReduceMeanOp final : public ReduceSumOp<Context> {
+ public:
+  ReduceMeanOp(const OperatorDef& operator_def, Workspace* ws)
+      : ReduceSumOp<Context>(operator_def, ws, true) {}
+  ~ReduceMeanOp() {}
+};
+
+// dX = dY broadcast over the reduced axes, divided by the count of the mean.
+template <class Context>
+class ReduceSumGradientOp : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  ReduceSumGradientOp(const OperatorDef& operator_def, Workspace* ws)
+      : ReduceSumGradientOp(operator_def, ws, false) {}
+  ReduceSumGradientOp(
+      const OperatorDef& operator_def,
+      Workspace* ws,
+      bool average)
+      : Operator<Context>(operator_def, ws),
+        axes_(OperatorBase::GetRepeatedArgument<int>("axes")),
+        average_(average) {}
+  ~ReduceSumGradientOp() {}
+
+  bool RunOnDevice() override {
+    return DispatchHelper<TensorTypes<int, long, float, double>>::call(
+        this, Input(0));
+  }
+
+  template <typename T>
+  bool DoRunWithType() {
+    const auto& dY = Input(0);
+    const auto& X = Input(1);
+    auto* dX = Output(0);
+
+    vector<bool> reduced(X.ndim(), axes_.empty());
+    TIndex count = 1;
+    for (const int axis : axes_) {
+      reduced[X.canonical_axis_index(axis)] = true;
+    }
+    for (int i = 0; i < X.ndim(); ++i) {
+      count *= reduced[i] ? X.dim(i) : 1;
+    }
+    CAFFE_ENFORCE_EQ(dY.size() * count, X.size());
+    dX->ResizeLike(X);
+    if (X.size() == 0) {
+      return true;
+    }
+    T* dXdata = dX->template mutable_data<T>();
+
+    vector<TIndex> run_dims;
+    vector<bool> run_reduced;
+    MergeReduceDims(X.dims(), reduced, &run_dims, &run_reduced);
+    const int passes =
+        std::count(run_reduced.begin(), run_reduced.end(), true);
+    const T divisor = average_ ? T(count) : T(1);
+    if (passes == 0) {
+      context_.template Copy<T, Context, Context>(
+          X.size(), dY.template data<T>(), dXdata);
+      return true;
+    }
+
+    // Undo the reduction passes: the outermost reduced run is expanded
+    // first, while the ones after it are still missing from inner.
+    const T* in = dY.template data<T>();
+    for (int pass = 1, i = 0; i < run_dims.size(); ++i) {
+      if (!run_reduced[i]) {
+        continue;
+      }
+      const TIndex outer = std::accumulate(
+          run_dims.begin(),
+          run_dims.begin() + i,
+          TIndex(1),
+          std::multiplies<TIndex>());
+      TIndex inner = 1;
+      for (int j = i + 1; j < run_dims.size(); ++j) {
+        inner *= run_reduced[j] ? 1 : run_dims[j];
+      }
+      T* out = dXdata;
+      if (pass < passes) {
+        buffers_[pass % 2].Resize(outer * run_dims[i] * inner);
+        out = buffers_[pass % 2].template mutable_data<T>();
+      }
+      ExpandRun<T>(
+          outer, run_dims[i], inner, pass == 1 ? divisor : T(1), in, out);
+      in = out;
+      ++pass;
+    }
+    return true;
+  }
+
+ protected:
+  // dX[o, :, i] = dY[o, i] / divisor for an outer x run x inner dX.
+  template <typename T>
+  void ExpandRun(
+      const TIndex outer,
+      const TIndex run,
+      const TIndex inner,
+      const T divisor,
+      const T* dY,
+      T* dX);
+
+  vector<int> axes_;
+  bool average_;
+  Tensor<Context> buffers_[2];
+};
+
+template <class Context>
+class ReduceMeanGradientOp final : public ReduceSumGradientOp<Context> {
+ public:
+  ReduceMeanGradientOp(const OperatorDef& operator_def, Workspace* ws)
+      : ReduceSumGradientOp<Context>(operator_def, ws, true) {}
+  ~ReduceMeanGradientOp() {}
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_REDUCE_OPS_H_
@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/reduce_ops.h"
+#include "hip/hip_runtime.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/reduce_sum_hip.h"
+
+namespace caffe2 {
+
+namespace {
+
+template <typename T>
+__global__ void ExpandRunKernel(const TIndex size,
+                                const TIndex run,
+                                const TIndex inner,
+                                const T divisor,
+                                const T* dY,
+                                T* dX)
+{
+    HIP_1D_KERNEL_LOOP(i, size) { dX[i] = dY[i / (run * inner) * inner + i % inner] / divisor; }
+}
+
+} // namespace
+
+template <>
+template <typename T>
+void ReduceSumOp<HIPContext>::ReduceRun(const TIndex outer,
+                                        const TIndex run,
+                                        const TIndex inner,
+                                        const T divisor,
+                                        const T* X,
+                                        T* Y)
+{
+    if(inner == 1)
+    {
+        LaunchRowwiseSum<T>(outer, run, divisor, X, Y, &scratch_, &context_);
+    }
+    else
+    {
+        LaunchColumnwiseSum<T>(outer, run, inner, divisor, X, Y, &scratch_, &context_);
+    }
+}
+
+template <>
+template <typename T>
+void ReduceSumGradientOp<HIPContext>::ExpandRun(const TIndex outer,
+                                                const TIndex run,
+                                                const TIndex inner,
+                                                const T divisor,
+                                                const T* dY,
+                                                T* dX)
+{
+    const TIndex size = outer * run * inner;
+    hipLaunchKernelGGL((ExpandRunKernel<T>),
+                       dim3(CAFFE_GET_BLOCKS(size)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       size,
+                       run,
+                       inner,
+                       divisor,
+                       dY,
+                       dX);
+}
+
+REGISTER_HIP_OPERATOR(ReduceSum, ReduceSumOp<HIPContext>);
+REGISTER_HIP_OPERATOR(ReduceSumGradient, ReduceSumGradientOp<HIPContext>);
+REGISTER_HIP_OPERATOR(ReduceMean, ReduceMeanOp<HIPContext>);
+REGISTER_HIP_OPERATOR(ReduceMeanGradient, ReduceMeanGradientOp<HIPContext>);
+
+} // namespace caffe2
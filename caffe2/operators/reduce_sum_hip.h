@@ -0,0 +1,278 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <hipcub/hipcub.hpp>
+#include "caffe2/core/common_hip.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/row_copy_hip.h"
+#include "hip/hip_runtime.h"
+
+namespace caffe2 {
+
+/**
+ * Sums over the rows or the columns of a matrix, with the tiling picked from
+ * its shape, for the ReduceFront* / ReduceBack* and ReduceSum / ReduceMean
+ * ops.
+ *
+ * - Row sums lay the blocks out as in row_copy_hip.h, a short row is summed by
+ *   a few lanes and a block covers many of them.
+ * - Column sums take a tile of up to a wavefront of consecutive columns, so
+ *   the reads are coalesced, and the threads of the tile split the rows.
+ * - When that leaves too few blocks to fill the device, i.e. a few very long
+ *   rows or columns, each one is cut into splits of at least
+ *   kReduceSplitSize values whose partial sums are added in a second pass.
+ *
+ * The result is divided by divisor (the count of a mean, else 1) in T, as the
+ * CPU ops do.
+ */
+
+constexpr TIndex kReduceSplitSize = 4096;
+constexpr TIndex kReduceMinBlocks = 128;
+// A wavefront of consecutive columns per column sum tile.
+constexpr int kReduceTileColumns = 64;
+
+// Y[s] = sum(X[s / splits, chunk s % splits]) / divisor for each of the
+// rows * splits segments of a rows x cols matrix.
+template <typename T>
+__global__ void RowwiseSumKernel(const TIndex segments,
+                                 const TIndex splits,
+                                 const TIndex cols,
+                                 const T divisor,
+                                 const T* X,
+                                 T* Y)
+{
+    __shared__ T shared[CAFFE_HIP_NUM_THREADS];
+    const TIndex chunk = (cols + splits - 1) / splits;
+    for(TIndex segment_base = hipBlockIdx_x * hipBlockDim_y; segment_base < segments;
+        segment_base += hipGridDim_x * hipBlockDim_y)
+    {
+        const TIndex segment = segment_base + hipThreadIdx_y;
+        T sum                = 0;
+        if(segment < segments)
+        {
+            const T* x         = X + (segment / splits) * cols;
+            const TIndex begin = (segment % splits) * chunk;
+            const TIndex end   = begin + chunk < cols ? begin + chunk : cols;
+            for(TIndex j = begin + hipThreadIdx_x; j < end; j += hipBlockDim_x)
+            {
+                sum += x[j];
+            }
+        }
+        sum = RowAllReduce(sum, shared, hipcub::Sum());
+        if(segment < segments && hipThreadIdx_x == 0)
+        {
+            Y[segment] = sum / divisor;
+        }
+    }
+}
+
+// Y[a, s, c] = sum(X[a, chunk s, c]) / divisor for a batch x rows x cols
+// input. A block covers hipBlockDim_x consecutive columns and its
+// hipThreadIdx_y lanes accumulate interleaved rows, then reduce in shared
+// memory.
+template <typename T>
+__global__ void ColumnwiseSumKernel(const TIndex batch,
+                                    const TIndex rows,
+                                    const TIndex cols,
+                                    const TIndex splits,
+                                    const T divisor,
+                                    const T* X,
+                                    T* Y)
+{
+    __shared__ T shared[CAFFE_HIP_NUM_THREADS];
+    const TIndex col_tiles = (cols + hipBlockDim_x - 1) / hipBlockDim_x;
+    const TIndex chunk     = (rows + splits - 1) / splits;
+    const TIndex tiles     = batch * splits * col_tiles;
+    T* lane                = shared + hipThreadIdx_y * hipBlockDim_x + hipThreadIdx_x;
+    for(TIndex tile = hipBlockIdx_x; tile < tiles; tile += hipGridDim_x)
+    {
+        const TIndex col   = (tile % col_tiles) * hipBlockDim_x + hipThreadIdx_x;
+        const TIndex split = (tile / col_tiles) % splits;
+        const TIndex a     = tile / (col_tiles * splits);
+        const TIndex begin = split * chunk;
+        const TIndex end   = begin + chunk < rows ? begin + chunk : rows;
+        T sum              = 0;
+        if(col < cols)
+        {
+            const T* x = X + a * rows * cols + col;
+            for(TIndex r = begin + hipThreadIdx_y; r < end; r += hipBlockDim_y)
+            {
+                sum += x[r * cols];
+            }
+        }
+        *lane = sum;
+        __syncthreads();
+        for(int stride = hipBlockDim_y / 2; stride > 0; stride /= 2)
+        {
+            if(hipThreadIdx_y < stride)
+            {
+                *lane += lane[stride * hipBlockDim_x];
+            }
+            __syncthreads();
+        }
+        if(hipThreadIdx_y == 0 && col < cols)
+        {
+            Y[(a * splits + split) * cols + col] = *lane / divisor;
+        }
+        __syncthreads();
+    }
+}
+
+// Y[r] = sum(X[r, :]) / divisor. buffer holds the partial sums when the rows
+// are split.
+template <typename T>
+void LaunchRowwiseSum(const TIndex rows,
+                      const TIndex cols,
+                      const T divisor,
+                      const T* X,
+                      T* Y,
+                      Tensor<HIPContext>* buffer,
+                      HIPContext* context)
+{
+    if(rows == 0)
+    {
+        return;
+    }
+    dim3 block    = RowCopyBlock(cols);
+    TIndex splits = 1;
+    if((rows + block.y - 1) / block.y < kReduceMinBlocks && cols > kReduceSplitSize)
+    {
+        splits = std::min((cols + kReduceSplitSize - 1) / kReduceSplitSize,
+                          (kReduceMinBlocks + rows - 1) / rows);
+    }
+    if(splits == 1)
+    {
+        hipLaunchKernelGGL((RowwiseSumKernel<T>),
+                           RowCopyGrid(rows, block),
+                           block,
+                           0,
+                           context->hip_stream(),
+                           rows,
+                           TIndex(1),
+                           cols,
+                           divisor,
+                           X,
+                           Y);
+        return;
+    }
+    buffer->Resize(rows * splits);
+    T* partial = buffer->template mutable_data<T>();
+    hipLaunchKernelGGL((RowwiseSumKernel<T>),
+                       RowCopyGrid(rows * splits, block),
+                       block,
+                       0,
+                       context->hip_stream(),
+                       rows * splits,
+                       splits,
+                       cols,
+                       T(1),
+                       X,
+                       partial);
+    block = RowCopyBlock(splits);
+    hipLaunchKernelGGL((RowwiseSumKernel<T>),
+                       RowCopyGrid(rows, block),
+                       block,
+                       0,
+                       context->hip_stream(),
+                       rows,
+                       TIndex(1),
+                       splits,
+                       divisor,
+                       partial,
+                       Y);
+}
+
+inline dim3 ColumnwiseSumBlock(TIndex cols)
+{
+    int tile_cols = 1;
+    while(tile_cols < cols && tile_cols < kReduceTileColumns)
+    {
+        tile_cols *= 2;
+    }
+    return dim3(tile_cols, CAFFE_HIP_NUM_THREADS / tile_cols);
+}
+
+// Y[a, c] = sum(X[a, :, c]) / divisor for a batch x rows x cols input.
+template <typename T>
+void LaunchColumnwiseSum(const TIndex batch,
+                         const TIndex rows,
+                         const TIndex cols,
+                         const T divisor,
+                         const T* X,
+                         T* Y,
+                         Tensor<HIPContext>* buffer,
+                         HIPContext* context)
+{
+    if(batch == 0 || cols == 0)
+    {
+        return;
+    }
+    const dim3 block       = ColumnwiseSumBlock(cols);
+    const TIndex col_tiles = (cols + block.x - 1) / block.x;
+    const TIndex tiles     = batch * col_tiles;
+    TIndex splits          = 1;
+    if(tiles < kReduceMinBlocks && rows * block.x > kReduceSplitSize)
+    {
+        splits = std::min((rows * block.x + kReduceSplitSize - 1) / kReduceSplitSize,
+                          (kReduceMinBlocks + tiles - 1) / tiles);
+    }
+    if(splits == 1)
+    {
+        hipLaunchKernelGGL((ColumnwiseSumKernel<T>),
+                           dim3(std::min<TIndex>(tiles, CAFFE_MAXIMUM_NUM_BLOCKS)),
+                           block,
+                           0,
+                           context->hip_stream(),
+                           batch,
+                           rows,
+                           cols,
+                           TIndex(1),
+                           divisor,
+                           X,
+                           Y);
+        return;
+    }
+    buffer->Resize(batch * splits * cols);
+    T* partial = buffer->template mutable_data<T>();
+    hipLaunchKernelGGL((ColumnwiseSumKernel<T>),
+                       dim3(std::min<TIndex>(tiles * splits, CAFFE_MAXIMUM_NUM_BLOCKS)),
+                       block,
+                       0,
+                       context->hip_stream(),
+                       batch,
+                       rows,
+                       cols,
+                       splits,
+                       T(1),
+                       X,
+                       partial);
+    hipLaunchKernelGGL((ColumnwiseSumKernel<T>),
+                       dim3(std::min<TIndex>(tiles, CAFFE_MAXIMUM_NUM_BLOCKS)),
+                       block,
+                       0,
+                       context->hip_stream(),
+                       batch,
+                       splits,
+                       cols,
+                       TIndex(1),
+                       divisor,
+                       partial,
+                       Y);
+}
+
+} // namespace caffe2
@@ -76,6 +76,8 @@ class SumReduceDimsOp final : public Operator<Context> {
   template <typename T>
   void Compute(int rows, int cols, const T* in_data, T* out_data);
   int num_reduce_dims_;
+  // Partial sums of long rows or columns split across blocks.
+  Tensor<Context> buffer_;
 };
 
 template <class Context, bool FIRSTDIMS, bool NORMALIZE>
@@ -16,6 +16,7 @@
 
 #include <hipcub/hipcub.hpp>
 #include "caffe2/core/context_hip.h"
+#include "caffe2/operators/reduce_sum_hip.h"
 #include "caffe2/operators/reduction_front_back_ops.h"
 #include "hip/hip_runtime.h"
 #include <cfloat>
@@ -37,51 +38,6 @@ rowwise_fill_kernel(const int rows, const int cols, const float alpha, const T*
     HIP_1D_KERNEL_LOOP(i, rows * cols) { dX[i] = dY[i / cols] * alpha; }
 }
 
-template <typename T>
-__global__ void
-rowwise_sum_kernel(const int rows, const int cols, const float alpha, const T* data, T* out)
-{
-    using BlockReduce = hipcub::BlockReduce<float, CAFFE_HIP_NUM_THREADS>;
-    __shared__ typename BlockReduce::TempStorage temp_storage;
-    for(int rowIndex = hipBlockIdx_x; rowIndex < rows; rowIndex += hipGridDim_x)
-    {
-        T sum               = 0;
-        const int rowOffset = rowIndex * cols;
-        for(int colIndex = hipThreadIdx_x; colIndex < cols; colIndex += hipBlockDim_x)
-        {
-            sum += data[rowOffset + colIndex];
-        }
-        sum = BlockReduce(temp_storage).Reduce(sum, hipcub::Sum());
-        if(hipThreadIdx_x == 0)
-        {
-            out[rowIndex] = alpha * sum;
-        }
-        __syncthreads();
-    }
-}
-
-template <typename T>
-__global__ void
-columnwise_sum_kernel(const int rows, const int cols, const float alpha, const T* data, T* out)
-{
-    using BlockReduce = hipcub::BlockReduce<float, CAFFE_HIP_NUM_THREADS>;
-    __shared__ typename BlockReduce::TempStorage temp_storage;
-    for(int colIndex = hipBlockIdx_x; colIndex < cols; colIndex += hipGridDim_x)
-    {
-        T sum = 0;
-        for(int rowIndex = hipThreadIdx_x; rowIndex < rows; rowIndex += hipBlockDim_x)
-        {
-            sum += data[rowIndex * cols + colIndex];
-        }
-        sum = BlockReduce(temp_storage).Reduce(sum, hipcub::Sum());
-        if(hipThreadIdx_x == 0)
-        {
-            out[colIndex] = alpha * sum;
-        }
-        __syncthreads();
-    }
-}
-
 } // anonymous namespace
 
 /***
@@ -96,16 +52,7 @@ void SumReduceDimsOp<HIPContext, true, false>::Compute(int rows,
                                                        const T* in_data,
                                                        T* out_data)
 {
-    hipLaunchKernelGGL((columnwise_sum_kernel<T>),
-                       dim3(std::min(cols, CAFFE_MAXIMUM_NUM_BLOCKS)),
-                       dim3(CAFFE_HIP_NUM_THREADS),
-                       0,
-                       context_.hip_stream(),
-                       rows,
-                       cols,
-                       1.0f,
-                       in_data,
-                       out_data);
+    LaunchColumnwiseSum<T>(1, rows, cols, T(1), in_data, out_data, &buffer_, &context_);
 }
 
 // ReduceBackSum: rowwise sum
@@ -116,16 +63,7 @@ void SumReduceDimsOp<HIPContext, false, false>::Compute(int rows,
                                                         const T* in_data,
                                                         T* out_data)
 {
-    hipLaunchKernelGGL((rowwise_sum_kernel<T>),
-                       dim3(std::min(rows, CAFFE_MAXIMUM_NUM_BLOCKS)),
-                       dim3(CAFFE_HIP_NUM_THREADS),
-                       0,
-                       context_.hip_stream(),
-                       rows,
-                       cols,
-                       1.0f,
-                       in_data,
-                       out_data);
+    LaunchRowwiseSum<T>(rows, cols, T(1), in_data, out_data, &buffer_, &context_);
 }
 
 // ReduceFrontSumGradient
@@ -186,16 +124,7 @@ void SumReduceDimsOp<HIPContext, true, true>::Compute(int rows,
                                                       const T* in_data,
                                                       T* out_data)
 {
-    hipLaunchKernelGGL((columnwise_sum_kernel),
-                       dim3(std::min(cols, CAFFE_MAXIMUM_NUM_BLOCKS)),
-                       dim3(CAFFE_HIP_NUM_THREADS),
-                       0,
-                       context_.hip_stream(),
-                       rows,
-                       cols,
-                       static_cast<const float>(1.0 / static_cast<float>(rows)),
-                       in_data,
-                       out_data);
+    LaunchColumnwiseSum<T>(1, rows, cols, T(rows), in_data, out_data, &buffer_, &context_);
 }
 
 // ReduceBackMean: rowwise mean
@@ -206,16 +135,7 @@ void SumReduceDimsOp<HIPContext, false, true>::Compute(int rows,
                                                        const T* in_data,
                                                        T* out_data)
 {
-    hipLaunchKernelGGL((rowwise_sum_kernel),
-                       dim3(std::min(rows, CAFFE_MAXIMUM_NUM_BLOCKS)),
-                       dim3(CAFFE_HIP_NUM_THREADS),
-                       0,
-                       context_.hip_stream(),
-                       rows,
-                       cols,
-                       static_cast<const float>(1.0 / static_cast<float>(cols)),
-                       in_data,
-                       out_data);
+    LaunchRowwiseSum<T>(rows, cols, T(cols), in_data, out_data, &buffer_, &context_);
 }
 
 // ReduceFrontMeanGradient
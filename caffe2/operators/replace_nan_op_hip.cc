@@ -1,5 +1,7 @@
+#include <type_traits>
 #include "hip/hip_runtime.h"
 #include "caffe2/core/context_hip.h"
+#include "caffe2/core/micro_ops_hip.h"
 #include "caffe2/operators/replace_nan_op.h"
 
 namespace caffe2 {
@@ -26,6 +28,15 @@ template <>
 template <typename T>
 void ReplaceNaNOp<HIPContext>::ReplaceNaN(const T& value, const TIndex size, const T* X, T* Y)
 {
+    if(!std::is_same<T, float>::value)
+    {
+        MicroOps::Flush();
+    }
+    else if(QueueHIPMicroOp(
+                &context_, HIPMicroOp::kReplaceNaN, size, X, Y, static_cast<float>(value)))
+    {
+        return;
+    }
     hipLaunchKernelGGL((replace_nan_kernel),
                        dim3(CAFFE_GET_BLOCKS(size)),
                        dim3(CAFFE_HIP_NUM_THREADS),
@@ -37,4 +48,5 @@ void ReplaceNaNOp<HIPContext>::ReplaceNaN(const T& value, const TIndex size, con
                        Y);
 }
 REGISTER_HIP_OPERATOR(ReplaceNaN, ReplaceNaNOp<HIPContext>);
+REGISTER_COALESCABLE_OPERATOR(HIP, ReplaceNaN);
 } // namespace caffe2
@@ -14,7 +14,10 @@
  * limitations under the License.
  */
 
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <random>
 #include <string>
 #include <vector>
 #include "caffe2/core/operator.h"
@@ -22,6 +25,58 @@
 #include "caffe2/operators/map_ops.h"
 
 namespace caffe2 {
+
+/**
+ * Independent reservoirs for concurrent writers of ShardedReservoirSampling.
+ * Each shard samples the rows routed to it, ReadReservoirShards merges them
+ * into one uniform sample of everything seen.
+ */
+class ReservoirShards {
+ public:
+  struct Shard {
+    std::mutex mutex;
+    // num_to_collect rows once anything was written, the first
+    // min(num_visited, num_to_collect) ones are filled
+    TensorCPU reservoir;
+    int64_t num_visited = 0;
+    std::mt19937 gen;
+  };
+
+  ReservoirShards(int num_shards, int num_to_collect)
+      : num_to_collect_(num_to_collect), shards_(num_shards) {}
+
+  // Locks a shard for writing. The search starts from a round-robin shard
+  // and takes the first one that is free, so writers only wait when every
+  // shard is busy.
+  Shard& acquire(std::unique_lock<std::mutex>* lock) {
+    const auto start = next_.fetch_add(1);
+    for (size_t i = 0; i < shards_.size(); ++i) {
+      auto& shard = shards_[(start + i) % shards_.size()];
+      std::unique_lock<std::mutex> try_lock(shard.mutex, std::try_to_lock);
+      if (try_lock.owns_lock()) {
+        *lock = std::move(try_lock);
+        return shard;
+      }
+    }
+    auto& shard = shards_[start % shards_.size()];
+    *lock = std::unique_lock<std::mutex>(shard.mutex);
+    return shard;
+  }
+
+  int num_to_collect() const {
+    return num_to_collect_;
+  }
+
+  std::vector<Shard>& shards() {
+    return shards_;
+  }
+
+ private:
+  const int num_to_collect_;
+  std::vector<Shard> shards_;
+  std::atomic<size_t> next_{0};
+};
+
 namespace {
 
 template <class Context>
@@ -213,6 +268,177 @@ class ReservoirSamplingOp final : public Operator<Context> {
   }
 };
 
+class CreateReservoirShardsOp final : public Operator<CPUContext> {
+ public:
+  CreateReservoirShardsOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        numShards_(OperatorBase::GetSingleArgument<int>("num_shards", 16)),
+        numToCollect_(
+            OperatorBase::GetSingleArgument<int>("num_to_collect", -1)) {
+    CAFFE_ENFORCE_GT(numShards_, 0);
+    CAFFE_ENFORCE_GT(numToCollect_, 0);
+  }
+
+  bool RunOnDevice() override {
+    auto* shards = new ReservoirShards(numShards_, numToCollect_);
+    for (auto& shard : shards->shards()) {
+      shard.gen.seed(context_.RandGenerator()());
+    }
+    OperatorBase::Output<std::unique_ptr<ReservoirShards>>(0)->reset(shards);
+    return true;
+  }
+
+ private:
+  const int numShards_;
+  const int numToCollect_;
+};
+
+class ShardedReservoirSamplingOp final : public Operator<CPUContext> {
+ public:
+  using Operator::Operator;
+
+  bool RunOnDevice() override {
+    auto& shards = OperatorBase::Input<std::unique_ptr<ReservoirShards>>(0);
+    const auto& input = Input(1);
+    CAFFE_ENFORCE_GE(input.ndim(), 1);
+    const auto num_entries = input.dim(0);
+    if (num_entries == 0) {
+      return true;
+    }
+    const auto num_to_collect = shards->num_to_collect();
+    std::unique_lock<std::mutex> lock;
+    auto& shard = shards->acquire(&lock);
+    auto& reservoir = shard.reservoir;
+
+    if (reservoir.size() <= 0) {
+      auto dims = input.dims();
+      dims[0] = num_to_collect;
+      reservoir.Resize(dims);
+      reservoir.raw_mutable_data(input.meta());
+    }
+    CAFFE_ENFORCE(reservoir.meta() == input.meta());
+    CAFFE_ENFORCE_EQ(reservoir.ndim(), input.ndim());
+    for (size_t i = 1; i < input.ndim(); ++i) {
+      CAFFE_ENFORCE_EQ(reservoir.dim(i), input.dim(i));
+    }
+
+    auto block_size = input.size_from_dim(1);
+    auto block_bytesize = block_size * input.itemsize();
+    const auto* input_data = static_cast<const char*>(input.raw_data());
+    auto* reservoir_data = static_cast<char*>(reservoir.raw_mutable_data());
+    for (int i = 0; i < num_entries; ++i) {
+      int64_t pos = shard.num_visited;
+      if (pos >= num_to_collect) {
+        // uniform between [0, num_visited]
+        std::uniform_int_distribution<int64_t> uniformDist(0, pos);
+        pos = uniformDist(shard.gen);
+      }
+      if (pos < num_to_collect) {
+        context_.template CopyItems<CPUContext, CPUContext>(
+            input.meta(),
+            block_size,
+            input_data + i * block_bytesize,
+            reservoir_data + pos * block_bytesize);
+      }
+      ++shard.num_visited;
+    }
+    return true;
+  }
+};
+
+class ReadReservoirShardsOp final : public Operator<CPUContext> {
+ public:
+  using Operator::Operator;
+
+  bool RunOnDevice() override {
+    auto& shards = OperatorBase::Input<std::unique_ptr<ReservoirShards>>(0);
+    auto* output = Output(RESERVOIR);
+    const auto num_to_collect = shards->num_to_collect();
+
+    std::vector<std::unique_lock<std::mutex>> locks;
+    const TensorCPU* first = nullptr;
+    int64_t num_visited = 0;
+    for (auto& shard : shards->shards()) {
+      locks.emplace_back(shard.mutex);
+      if (shard.num_visited == 0) {
+        continue;
+      }
+      if (first) {
+        CAFFE_ENFORCE(shard.reservoir.meta() == first->meta());
+        CAFFE_ENFORCE(shard.reservoir.dims() == first->dims());
+      } else {
+        first = &shard.reservoir;
+      }
+      num_visited += shard.num_visited;
+    }
+    if (OutputSize() > NUM_VISITED) {
+      Output(NUM_VISITED)->Resize(std::vector<TIndex>());
+      *Output(NUM_VISITED)->template mutable_data<int64_t>() = num_visited;
+    }
+    if (!first) {
+      // Nothing has been collected yet
+      output->Resize(0);
+      output->template mutable_data<float>();
+      return true;
+    }
+
+    // Every shard holds a uniform sample of the rows it saw. Picking the
+    // shard of each output row with probability proportional to the rows it
+    // saw and not yet picked, then a random unused row of that shard, gives
+    // a uniform sample of all the rows. A shard is never asked for more rows
+    // than it holds.
+    std::vector<int64_t> remaining;
+    std::vector<std::vector<int64_t>> unused;
+    for (auto& shard : shards->shards()) {
+      remaining.push_back(shard.num_visited);
+      unused.emplace_back();
+      for (int64_t i = 0; i < std::min<int64_t>(shard.num_visited,
+                                                num_to_collect);
+           ++i) {
+        unused.back().push_back(i);
+      }
+    }
+
+    auto dims = first->dims();
+    dims[0] = std::min<int64_t>(num_visited, num_to_collect);
+    output->Resize(dims);
+    auto* output_data =
+        static_cast<char*>(output->raw_mutable_data(first->meta()));
+    const auto block_size = first->size_from_dim(1);
+    const auto block_bytesize = block_size * first->itemsize();
+    auto& gen = context_.RandGenerator();
+    auto num_remaining = num_visited;
+    for (TIndex row = 0; row < dims[0]; ++row) {
+      std::uniform_int_distribution<int64_t> pickRow(0, num_remaining - 1);
+      auto r = pickRow(gen);
+      size_t s = 0;
+      while (r >= remaining[s]) {
+        r -= remaining[s++];
+      }
+      std::uniform_int_distribution<size_t> pickUnused(
+          0, unused[s].size() - 1);
+      const auto j = pickUnused(gen);
+      const auto pos = unused[s][j];
+      unused[s][j] = unused[s].back();
+      unused[s].pop_back();
+      --remaining[s];
+      --num_remaining;
+
+      const auto* shard_data =
+          static_cast<const char*>(shards->shards()[s].reservoir.raw_data());
+      context_.template CopyItems<CPUContext, CPUContext>(
+          first->meta(),
+          block_size,
+          shard_data + pos * block_bytesize,
+          output_data + row * block_bytesize);
+    }
+    return true;
+  }
+
+ private:
+  OUTPUT_TAGS(RESERVOIR, NUM_VISITED);
+};
+
 REGISTER_CPU_OPERATOR(ReservoirSampling, ReservoirSamplingOp<CPUContext>);
 
 OPERATOR_SCHEMA(ReservoirSampling)
@@ -268,6 +494,59 @@ This operator is thread-safe.
     .Output(2, "OBJECT_TO_POS_MAP", "(Optional) Same as the input")
     .Output(3, "POS_TO_OBJECT", "(Optional) Same as the input");
 
+REGISTER_CPU_OPERATOR(CreateReservoirShards, CreateReservoirShardsOp);
+REGISTER_CPU_OPERATOR(ShardedReservoirSampling, ShardedReservoirSamplingOp);
+REGISTER_CPU_OPERATOR(ReadReservoirShards, ReadReservoirShardsOp);
+
+OPERATOR_SCHEMA(CreateReservoirShards)
+    .NumInputs(0)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Creates the sharded reservoir used by `ShardedReservoirSampling` and
+`ReadReservoirShards`. Each shard is a reservoir of `num_to_collect` rows with
+its own lock and random generator.
+)DOC")
+    .Arg("num_shards", "Number of shards, 16 by default")
+    .Arg("num_to_collect", "The number of rows sampled")
+    .Output(0, "shards", "Blob containing a unique_ptr<ReservoirShards>");
+
+OPERATOR_SCHEMA(ShardedReservoirSampling)
+    .NumInputs(2)
+    .NumOutputs(0)
+    .SetDoc(R"DOC(
+Collect `DATA` into one shard of `SHARDS`, like `ReservoirSampling` does for a
+single reservoir. Concurrent writers pick different shards, so they only wait
+on each other when there are more writers than shards. The shards are merged
+into one uniform sample of all the rows seen by `ReadReservoirShards`.
+Deduplication by object id is not supported.
+
+This operator is thread-safe.
+)DOC")
+    .Input(0, "SHARDS", "Blob created by `CreateReservoirShards`")
+    .Input(
+        1,
+        "DATA",
+        "Tensor to collect from. The first dimension is assumed to be batch "
+        "size. If the object to be collected is represented by multiple "
+        "tensors, use `PackRecords` to pack them into single tensor.");
+
+OPERATOR_SCHEMA(ReadReservoirShards)
+    .NumInputs(1)
+    .NumOutputs(1, 2)
+    .SetDoc(R"DOC(
+Merge the shards of `SHARDS` into `RESERVOIR`, a uniform sample of at most
+`num_to_collect` of the rows given to `ShardedReservoirSampling` so far. The
+row order is random. Writers are blocked while the shards are read.
+)DOC")
+    .Input(0, "SHARDS", "Blob created by `CreateReservoirShards`")
+    .Output(0, "RESERVOIR", "The merged sample")
+    .Output(1, "NUM_VISITED", "(Optional, int64) Number of rows seen so far");
+
 SHOULD_NOT_DO_GRADIENT(ReservoirSampling);
+SHOULD_NOT_DO_GRADIENT(CreateReservoirShards);
+SHOULD_NOT_DO_GRADIENT(ShardedReservoirSampling);
+SHOULD_NOT_DO_GRADIENT(ReadReservoirShards);
 } // namespace
+
+CAFFE_KNOWN_TYPE(std::unique_ptr<ReservoirShards>);
 } // namespace caffe2
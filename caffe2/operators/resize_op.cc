@@ -74,17 +74,41 @@ bool ResizeNearestOp<float, CPUContext>::RunOnDevice() {
   const auto& X = Input(0);
   auto* Y = Output(0);
 
+  CAFFE_ENFORCE_EQ(4, X.ndim());
+  const bool nchw = order_ == StorageOrder::NCHW;
   const int batch_size = X.dim32(0),
-            num_channels = X.dim32(1),
-            input_height = X.dim32(2),
-            input_width = X.dim32(3);
+            num_channels = X.dim32(nchw ? 1 : 3),
+            input_height = X.dim32(nchw ? 2 : 1),
+            input_width = X.dim32(nchw ? 3 : 2);
   int output_width = input_width * width_scale_;
   int output_height = input_height * height_scale_;
-  Y->Resize(batch_size, num_channels, output_height, output_width);
+  if (nchw) {
+    Y->Resize(batch_size, num_channels, output_height, output_width);
+  } else {
+    Y->Resize(batch_size, output_height, output_width, num_channels);
+  }
 
   const float* Xdata = X.data<float>();
   float* Ydata = Y->mutable_data<float>();
 
+  if (!nchw) {
+    for (int n = 0; n < batch_size; ++n) {
+      for (int y = 0; y < output_height; ++y) {
+        const int in_y = std::min((int)(y / height_scale_), (input_height - 1));
+        for (int x = 0; x < output_width; ++x) {
+          const int in_x = std::min((int)(x / width_scale_), (input_width - 1));
+          memcpy(
+              Ydata + (y * output_width + x) * num_channels,
+              Xdata + (in_y * input_width + in_x) * num_channels,
+              num_channels * sizeof(float));
+        }
+      }
+      Xdata += input_height * input_width * num_channels;
+      Ydata += output_height * output_width * num_channels;
+    }
+    return true;
+  }
+
   // Specialized implementation for fast 2x upsampling
   if (width_scale_ == 2.0 && height_scale_ == 2.0) {
     resizeNearest2x(
@@ -117,13 +141,14 @@ bool ResizeNearestGradientOp<float, CPUContext>::RunOnDevice() {
 
   const auto& inputDims = dY.dims();
   CAFFE_ENFORCE_EQ(4, inputDims.size());
+  const bool nchw = order_ == StorageOrder::NCHW;
   const int batch_size = dY.dim32(0),
-            num_channels = dY.dim32(1),
-            input_height = dY.dim32(2),
-            input_width = dY.dim32(3);
-  const int output_height = X.dim32(2);
-  const int output_width = X.dim32(3);
-  dX->Resize(batch_size, num_channels, output_height, output_width);
+            num_channels = dY.dim32(nchw ? 1 : 3),
+            input_height = dY.dim32(nchw ? 2 : 1),
+            input_width = dY.dim32(nchw ? 3 : 2);
+  const int output_height = X.dim32(nchw ? 2 : 1);
+  const int output_width = X.dim32(nchw ? 3 : 2);
+  dX->ResizeLike(X);
   math::Set<float, CPUContext>(dX->size(),
                                0.0f,
                                dX->mutable_data<float>(),
@@ -132,6 +157,28 @@ bool ResizeNearestGradientOp<float, CPUContext>::RunOnDevice() {
   const float* dYdata = dY.data<float>();
   float* dXdata = dX->mutable_data<float>();
 
+  if (!nchw) {
+    for (int n = 0; n < batch_size; ++n) {
+      for (int y = 0; y < input_height; ++y) {
+        const int out_y = std::min((int)(y / height_scale_),
+                                   (output_height - 1));
+        for (int x = 0; x < input_width; ++x) {
+          const int out_x = std::min((int)(x / width_scale_),
+                                     (output_width - 1));
+          float* dXpixel =
+              dXdata + (out_y * output_width + out_x) * num_channels;
+          const float* dYpixel = dYdata + (y * input_width + x) * num_channels;
+          for (int c = 0; c < num_channels; ++c) {
+            dXpixel[c] += dYpixel[c];
+          }
+        }
+      }
+      dYdata += input_height * input_width * num_channels;
+      dXdata += output_height * output_width * num_channels;
+    }
+    return true;
+  }
+
   for (int n = 0; n < batch_size; ++n) {
     for (int c = 0; c < num_channels; ++c) {
       for (int y = 0; y < input_height; ++y) {
@@ -151,9 +198,227 @@ bool ResizeNearestGradientOp<float, CPUContext>::RunOnDevice() {
   return true;
 }
 
+namespace {
+
+// Taps of every output coordinate of a dimension.
+void ComputeBilinearTaps(
+    const int in_size,
+    const int out_size,
+    const float scale,
+    const bool align_corners,
+    vector<int>* lo,
+    vector<int>* hi,
+    vector<float>* lambda) {
+  lo->resize(out_size);
+  hi->resize(out_size);
+  lambda->resize(out_size);
+  const float ratio = BilinearRatio(in_size, out_size, scale, align_corners);
+  for (int i = 0; i < out_size; ++i) {
+    BilinearTaps(
+        i,
+        ratio,
+        in_size,
+        align_corners,
+        lo->data() + i,
+        hi->data() + i,
+        lambda->data() + i);
+  }
+}
+
+// Interpolates an input row at the x taps.
+void InterpolateRow(
+    const int output_width,
+    const int* x_lo,
+    const int* x_hi,
+    const float* x_lambda,
+    const float* in,
+    float* out) {
+  for (int x = 0; x < output_width; ++x) {
+    out[x] = in[x_lo[x]] + (in[x_hi[x]] - in[x_lo[x]]) * x_lambda[x];
+  }
+}
+
+} // namespace
+
+template <>
+bool ResizeBilinearOp<CPUContext>::RunOnDevice() {
+  return DispatchHelper<TensorTypes<float>>::call(this, Input(0));
+}
+
+template <>
+template <typename T>
+bool ResizeBilinearOp<CPUContext>::DoRunWithType() {
+  const auto& X = Input(0);
+  auto* Y = Output(0);
+  CAFFE_ENFORCE_EQ(4, X.ndim());
+  const bool nchw = order_ == StorageOrder::NCHW;
+  const int batch_size = X.dim32(0),
+            num_channels = X.dim32(nchw ? 1 : 3),
+            input_height = X.dim32(nchw ? 2 : 1),
+            input_width = X.dim32(nchw ? 3 : 2);
+  const int output_height = input_height * height_scale_;
+  const int output_width = input_width * width_scale_;
+  if (nchw) {
+    Y->Resize(batch_size, num_channels, output_height, output_width);
+  } else {
+    Y->Resize(batch_size, output_height, output_width, num_channels);
+  }
+  const T* Xdata = X.template data<T>();
+  T* Ydata = Y->template mutable_data<T>();
+  if (Y->size() == 0) {
+    return true;
+  }
+
+  ComputeBilinearTaps(
+      input_height, output_height, height_scale_, align_corners_, &y_lo_,
+      &y_hi_, &y_lambda_);
+  ComputeBilinearTaps(
+      input_width, output_width, width_scale_, align_corners_, &x_lo_,
+      &x_hi_, &x_lambda_);
+
+  if (nchw) {
+    // Every output row blends two input rows interpolated at the x taps,
+    // which are kept while the next output rows use them too. The blend is
+    // a loop over contiguous rows, which the compiler vectorizes.
+    row_lo_.resize(output_width);
+    row_hi_.resize(output_width);
+    for (int plane = 0; plane < batch_size * num_channels; ++plane) {
+      int lo_row = -1;
+      int hi_row = -1;
+      for (int y = 0; y < output_height; ++y) {
+        if (y_lo_[y] != lo_row) {
+          if (y_lo_[y] == hi_row) {
+            std::swap(row_lo_, row_hi_);
+            std::swap(lo_row, hi_row);
+          } else {
+            InterpolateRow(
+                output_width, x_lo_.data(), x_hi_.data(), x_lambda_.data(),
+                Xdata + y_lo_[y] * input_width, row_lo_.data());
+            lo_row = y_lo_[y];
+          }
+        }
+        if (y_hi_[y] != hi_row) {
+          InterpolateRow(
+              output_width, x_lo_.data(), x_hi_.data(), x_lambda_.data(),
+              Xdata + y_hi_[y] * input_width, row_hi_.data());
+          hi_row = y_hi_[y];
+        }
+        const float ly = y_lambda_[y];
+        const float* lo = row_lo_.data();
+        const float* hi = row_hi_.data();
+        T* out = Ydata + y * output_width;
+        for (int x = 0; x < output_width; ++x) {
+          out[x] = lo[x] + (hi[x] - lo[x]) * ly;
+        }
+      }
+      Xdata += input_height * input_width;
+      Ydata += output_height * output_width;
+    }
+    return true;
+  }
+
+  // NHWC: the four input pixels of an output pixel are blended over their
+  // contiguous channels, which the compiler vectorizes.
+  const int input_row = input_width * num_channels;
+  for (int n = 0; n < batch_size; ++n) {
+    for (int y = 0; y < output_height; ++y) {
+      const T* r0 = Xdata + y_lo_[y] * input_row;
+      const T* r1 = Xdata + y_hi_[y] * input_row;
+      const float ly = y_lambda_[y];
+      for (int x = 0; x < output_width; ++x) {
+        const float lx = x_lambda_[x];
+        const float w00 = (1 - ly) * (1 - lx), w01 = (1 - ly) * lx;
+        const float w10 = ly * (1 - lx), w11 = ly * lx;
+        const T* p00 = r0 + x_lo_[x] * num_channels;
+        const T* p01 = r0 + x_hi_[x] * num_channels;
+        const T* p10 = r1 + x_lo_[x] * num_channels;
+        const T* p11 = r1 + x_hi_[x] * num_channels;
+        T* out = Ydata + (y * output_width + x) * num_channels;
+        for (int c = 0; c < num_channels; ++c) {
+          out[c] = w00 * p00[c] + w01 * p01[c] + w10 * p10[c] + w11 * p11[c];
+        }
+      }
+    }
+    Xdata += input_height * input_row;
+    Ydata += output_height * output_width * num_channels;
+  }
+  return true;
+}
+
+template <>
+bool ResizeBilinearGradientOp<CPUContext>::RunOnDevice() {
+  return DispatchHelper<TensorTypes<float>>::call(this, Input(0));
+}
+
+template <>
+template <typename T>
+bool ResizeBilinearGradientOp<CPUContext>::DoRunWithType() {
+  const auto& dY = Input(0);
+  const auto& X = Input(1);
+  auto* dX = Output(0);
+  CAFFE_ENFORCE_EQ(4, dY.ndim());
+  CAFFE_ENFORCE_EQ(4, X.ndim());
+  const bool nchw = order_ == StorageOrder::NCHW;
+  const int batch_size = dY.dim32(0),
+            num_channels = dY.dim32(nchw ? 1 : 3),
+            output_height = dY.dim32(nchw ? 2 : 1),
+            output_width = dY.dim32(nchw ? 3 : 2);
+  const int input_height = X.dim32(nchw ? 2 : 1);
+  const int input_width = X.dim32(nchw ? 3 : 2);
+  dX->ResizeLike(X);
+  T* dXdata = dX->template mutable_data<T>();
+  math::Set<T, CPUContext>(dX->size(), 0, dXdata, &context_);
+  const T* dYdata = dY.template data<T>();
+  if (dY.size() == 0) {
+    return true;
+  }
+
+  ComputeBilinearTaps(
+      input_height, output_height, height_scale_, align_corners_, &y_lo_,
+      &y_hi_, &y_lambda_);
+  ComputeBilinearTaps(
+      input_width, output_width, width_scale_, align_corners_, &x_lo_,
+      &x_hi_, &x_lambda_);
+
+  // Each output pixel gives its gradient back to its four input pixels.
+  const int C = nchw ? 1 : num_channels;
+  const int planes = nchw ? batch_size * num_channels : batch_size;
+  const int input_row = input_width * C;
+  for (int plane = 0; plane < planes; ++plane) {
+    for (int y = 0; y < output_height; ++y) {
+      T* r0 = dXdata + y_lo_[y] * input_row;
+      T* r1 = dXdata + y_hi_[y] * input_row;
+      const float ly = y_lambda_[y];
+      for (int x = 0; x < output_width; ++x) {
+        const float lx = x_lambda_[x];
+        const float w00 = (1 - ly) * (1 - lx), w01 = (1 - ly) * lx;
+        const float w10 = ly * (1 - lx), w11 = ly * lx;
+        T* p00 = r0 + x_lo_[x] * C;
+        T* p01 = r0 + x_hi_[x] * C;
+        T* p10 = r1 + x_lo_[x] * C;
+        T* p11 = r1 + x_hi_[x] * C;
+        const T* g = dYdata + (y * output_width + x) * C;
+        for (int c = 0; c < C; ++c) {
+          p00[c] += w00 * g[c];
+          p01[c] += w01 * g[c];
+          p10[c] += w10 * g[c];
+          p11[c] += w11 * g[c];
+        }
+      }
+    }
+    dXdata += input_height * input_row;
+    dYdata += output_height * output_width * C;
+  }
+  return true;
+}
+
 REGISTER_CPU_OPERATOR(ResizeNearest, ResizeNearestOp<float, CPUContext>);
 REGISTER_CPU_OPERATOR(ResizeNearestGradient,
                       ResizeNearestGradientOp<float, CPUContext>);
+REGISTER_CPU_OPERATOR(ResizeBilinear, ResizeBilinearOp<CPUContext>);
+REGISTER_CPU_OPERATOR(
+    ResizeBilinearGradient,
+    ResizeBilinearGradientOp<CPUContext>);
 
 // Input: X, output: Y
 OPERATOR_SCHEMA(ResizeNearest)
@@ -161,12 +426,14 @@ OPERATOR_SCHEMA(ResizeNearest)
     .NumOutputs(1)
     .Arg("width_scale", "Scale along width dimension")
     .Arg("height_scale", "Scale along height dimension")
+    .Arg("order", "NCHW (default) or NHWC")
     .SetDoc(R"DOC(
             Resizes the spatial dimensions of the input using nearest neighbor
             interpolation. The `width_scale` and `height_scale` arguments
             control the size of the output, which is given by:
             output_width = floor(input_width * width_scale)
             output_height = floor(output_height * height_scale)
+            On HIP, float16 inputs are also supported.
             )DOC")
     .Input(0, "X", "Input tensor")
     .Output(0, "Y", "Output tensor");
@@ -176,7 +443,41 @@ OPERATOR_SCHEMA(ResizeNearestGradient)
     .NumInputs(2)
     .NumOutputs(1)
     .Arg("width_scale", "Scale along width dimension")
-    .Arg("height_scale", "Scale along height dimension");
+    .Arg("height_scale", "Scale along height dimension")
+    .Arg("order", "NCHW (default) or NHWC");
+
+// Input: X, output: Y
+OPERATOR_SCHEMA(ResizeBilinear)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .Arg("width_scale", "Scale along width dimension")
+    .Arg("height_scale", "Scale along height dimension")
+    .Arg(
+        "align_corners",
+        "If true, the centers of the corner pixels of the input and output "
+        "are aligned, otherwise pixel centers are at half-integer coordinates "
+        "and the scales are the exact ratios of the sizes. Defaults to false")
+    .Arg("order", "NCHW (default) or NHWC")
+    .SetDoc(R"DOC(
+Resizes the spatial dimensions of the input using bilinear interpolation, e.g.
+to upsample the feature maps of an FPN or segmentation decoder. The size of
+the output is given by:
+  output_width = floor(input_width * width_scale)
+  output_height = floor(input_height * height_scale)
+The scales need not be integers and can be smaller than 1. On HIP, float16
+inputs are also supported and interpolated in float.
+)DOC")
+    .Input(0, "X", "4-D input tensor")
+    .Output(0, "Y", "4-D output tensor");
+
+// Input: dY, X, output: dX
+OPERATOR_SCHEMA(ResizeBilinearGradient)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .Arg("width_scale", "Scale along width dimension")
+    .Arg("height_scale", "Scale along height dimension")
+    .Arg("align_corners", "See ResizeBilinear")
+    .Arg("order", "NCHW (default) or NHWC");
 
 class GetResizeNearestGradient : public GradientMakerBase {
   using GradientMakerBase::GradientMakerBase;
@@ -189,4 +490,16 @@ class GetResizeNearestGradient : public GradientMakerBase {
 };
 REGISTER_GRADIENT(ResizeNearest, GetResizeNearestGradient);
 
+class GetResizeBilinearGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    return SingleGradientDef(
+        "ResizeBilinearGradient",
+        "",
+        vector<string>{GO(0), I(0)},
+        vector<string>{GI(0)});
+  }
+};
+REGISTER_GRADIENT(ResizeBilinear, GetResizeBilinearGradient);
+
 } // namespace caffe2
@@ -20,13 +20,24 @@
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
 
+// The bilinear taps are also computed by the HIP kernels.
+#if defined(__CUDACC__) || defined(__HIPCC__)
+#define RESIZE_DECL inline __host__ __device__
+#else
+#define RESIZE_DECL inline
+#endif
+
 namespace caffe2 {
 
 template <typename T, class Context>
 class ResizeNearestOp final : public Operator<Context> {
  public:
   ResizeNearestOp(const OperatorDef& operator_def, Workspace* ws)
-      : Operator<Context>(operator_def, ws), width_scale_(1), height_scale_(1) {
+      : Operator<Context>(operator_def, ws),
+        width_scale_(1),
+        height_scale_(1),
+        order_(StringToStorageOrder(
+            OperatorBase::GetSingleArgument<string>("order", "NCHW"))) {
     if (HasArgument("width_scale")) {
       width_scale_ = static_cast<T>(
           OperatorBase::GetSingleArgument<float>("width_scale", 1));
@@ -37,35 +48,156 @@ class ResizeNearestOp final : public Operator<Context> {
     }
     CAFFE_ENFORCE_GT(width_scale_, 0);
     CAFFE_ENFORCE_GT(height_scale_, 0);
+    CAFFE_ENFORCE(order_ == StorageOrder::NCHW || order_ == StorageOrder::NHWC);
   }
   USE_OPERATOR_CONTEXT_FUNCTIONS;
 
   bool RunOnDevice() override;
 
+  template <typename D>
+  bool DoRunWithType();
+
  protected:
   T width_scale_;
   T height_scale_;
+  StorageOrder order_;
 };
 
 template <typename T, class Context>
 class ResizeNearestGradientOp final : public Operator<Context> {
  public:
   ResizeNearestGradientOp(const OperatorDef& operator_def, Workspace* ws)
-      : Operator<Context>(operator_def, ws), width_scale_(1), height_scale_(1) {
+      : Operator<Context>(operator_def, ws),
+        width_scale_(1),
+        height_scale_(1),
+        order_(StringToStorageOrder(
+            OperatorBase::GetSingleArgument<string>("order", "NCHW"))) {
     width_scale_ = static_cast<T>(
         OperatorBase::GetSingleArgument<float>("width_scale", 1));
     height_scale_ = static_cast<T>(
         OperatorBase::GetSingleArgument<float>("height_scale", 1));
     CAFFE_ENFORCE_GT(width_scale_, 0);
     CAFFE_ENFORCE_GT(height_scale_, 0);
+    CAFFE_ENFORCE(order_ == StorageOrder::NCHW || order_ == StorageOrder::NHWC);
   }
   USE_OPERATOR_CONTEXT_FUNCTIONS;
 
   bool RunOnDevice() override;
 
+  template <typename D>
+  bool DoRunWithType();
+
  protected:
   T width_scale_;
   T height_scale_;
+  StorageOrder order_;
+  // float accumulator of the gradient of the float16 inputs on GPUs
+  Tensor<Context> dX_float_;
+};
+
+// Ratio of the input to the output coordinates of the bilinear resize of a
+// dimension of in_size into out_size with the given scale. With
+// align_corners, the centers of the corner pixels of the input and the
+// output are aligned, otherwise pixel centers are at half-integer
+// coordinates and the scale is the exact ratio.
+RESIZE_DECL float BilinearRatio(
+    const int in_size,
+    const int out_size,
+    const float scale,
+    const bool align_corners) {
+  if (align_corners) {
+    return out_size > 1 ? static_cast<float>(in_size - 1) / (out_size - 1)
+                        : 0.f;
+  }
+  return 1.f / scale;
+}
+
+// Input coordinates lo and hi = lo + 1 (clamped) of output coordinate dst,
+// and the weight lambda of hi.
+RESIZE_DECL void BilinearTaps(
+    const int dst,
+    const float ratio,
+    const int in_size,
+    const bool align_corners,
+    int* lo,
+    int* hi,
+    float* lambda) {
+  float src = align_corners ? dst * ratio : (dst + 0.5f) * ratio - 0.5f;
+  src = src < 0.f ? 0.f : src;
+  *lo = static_cast<int>(src);
+  *lo = *lo < in_size - 1 ? *lo : in_size - 1;
+  *hi = *lo < in_size - 1 ? *lo + 1 : *lo;
+  *lambda = src - *lo;
+  *lambda = *lambda < 1.f ? *lambda : 1.f;
+}
+
+template <class Context>
+class ResizeBilinearOp final : public Operator<Context> {
+ public:
+  ResizeBilinearOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        width_scale_(OperatorBase::GetSingleArgument<float>("width_scale", 1)),
+        height_scale_(
+            OperatorBase::GetSingleArgument<float>("height_scale", 1)),
+        align_corners_(
+            OperatorBase::GetSingleArgument<bool>("align_corners", false)),
+        order_(StringToStorageOrder(
+            OperatorBase::GetSingleArgument<string>("order", "NCHW"))) {
+    CAFFE_ENFORCE_GT(width_scale_, 0);
+    CAFFE_ENFORCE_GT(height_scale_, 0);
+    CAFFE_ENFORCE(order_ == StorageOrder::NCHW || order_ == StorageOrder::NHWC);
+  }
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+
+  bool RunOnDevice() override;
+
+  template <typename T>
+  bool DoRunWithType();
+
+ protected:
+  float width_scale_;
+  float height_scale_;
+  bool align_corners_;
+  StorageOrder order_;
+  // Taps of the output rows and columns and interpolated input rows on CPU
+  vector<int> y_lo_, y_hi_, x_lo_, x_hi_;
+  vector<float> y_lambda_, x_lambda_;
+  vector<float> row_lo_, row_hi_;
+};
+
+template <class Context>
+class ResizeBilinearGradientOp final : public Operator<Context> {
+ public:
+  ResizeBilinearGradientOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        width_scale_(OperatorBase::GetSingleArgument<float>("width_scale", 1)),
+        height_scale_(
+            OperatorBase::GetSingleArgument<float>("height_scale", 1)),
+        align_corners_(
+            OperatorBase::GetSingleArgument<bool>("align_corners", false)),
+        order_(StringToStorageOrder(
+            OperatorBase::GetSingleArgument<string>("order", "NCHW"))) {
+    CAFFE_ENFORCE_GT(width_scale_, 0);
+    CAFFE_ENFORCE_GT(height_scale_, 0);
+    CAFFE_ENFORCE(order_ == StorageOrder::NCHW || order_ == StorageOrder::NHWC);
+  }
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+
+  bool RunOnDevice() override;
+
+  template <typename T>
+  bool DoRunWithType();
+
+ protected:
+  float width_scale_;
+  float height_scale_;
+  bool align_corners_;
+  StorageOrder order_;
+  // Taps of the output rows and columns on CPU
+  vector<int> y_lo_, y_hi_, x_lo_, x_hi_;
+  vector<float> y_lambda_, x_lambda_;
+  // float accumulator of the gradient of the float16 inputs on GPUs
+  Tensor<Context> dX_float_;
 };
 
 } // namespace caffe2
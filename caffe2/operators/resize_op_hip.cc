@@ -15,7 +15,10 @@
  * limitations under the License.
  */
 
+#include <type_traits>
+
 #include "caffe2/core/context_hip.h"
+#include "caffe2/utils/conversions.h"
 #include "caffe2/utils/math.h"
 #include "resize_op.h"
 
@@ -23,7 +26,19 @@ namespace caffe2 {
 
 namespace {
 
+// NHWC pixels are moved kVec channels at a time, in one 16 byte (float) or
+// 8 byte (float16) access, whenever the number of channels allows it.
+constexpr int kVec = 4;
+
+template <typename T, int N>
+struct alignas(sizeof(T) * N) PackedVector
+{
+    T val[N];
+};
+
+template <typename T>
 __global__ void NearestNeighborKernel(const int size,
+                                      const bool nchw,
                                       const int num_channels,
                                       const int input_height,
                                       const int input_width,
@@ -31,28 +46,39 @@ __global__ void NearestNeighborKernel(const int size,
                                       const int output_width,
                                       const float height_scale,
                                       const float width_scale,
-                                      const float* X,
-                                      float* Y)
+                                      const T* X,
+                                      T* Y)
 {
     HIP_1D_KERNEL_LOOP(index, size)
     {
-
         int indexTemp = index;
-        const int w   = indexTemp % output_width;
+        int c         = 0;
+        if(!nchw)
+        {
+            c = indexTemp % num_channels;
+            indexTemp /= num_channels;
+        }
+        const int w = indexTemp % output_width;
         indexTemp /= output_width;
         const int h = indexTemp % output_height;
         indexTemp /= output_height;
-        const int c = indexTemp % num_channels;
-        indexTemp /= num_channels;
+        if(nchw)
+        {
+            c = indexTemp % num_channels;
+            indexTemp /= num_channels;
+        }
         const int n = indexTemp;
 
         const int in_y = fminf(h / height_scale, input_height - 1);
         const int in_x = fminf(w / width_scale, input_width - 1);
-        Y[index]       = X[((n * num_channels + c) * input_height + in_y) * input_width + in_x];
+        Y[index] = nchw ? X[((n * num_channels + c) * input_height + in_y) * input_width + in_x]
+                        : X[((n * input_height + in_y) * input_width + in_x) * num_channels + c];
     }
 }
 
+template <typename T>
 __global__ void NearestNeighborGradientKernel(const int size,
+                                              const bool nchw,
                                               const int num_channels,
                                               const int input_height,
                                               const int input_width,
@@ -60,51 +86,262 @@ __global__ void NearestNeighborGradientKernel(const int size,
                                               const int output_width,
                                               const float height_scale,
                                               const float width_scale,
-                                              const float* dY,
+                                              const T* dY,
                                               float* dX)
 {
     HIP_1D_KERNEL_LOOP(index, size)
     {
         int indexTemp = index;
-        const int x   = indexTemp % input_width;
+        int c         = 0;
+        if(!nchw)
+        {
+            c = indexTemp % num_channels;
+            indexTemp /= num_channels;
+        }
+        const int x = indexTemp % input_width;
         indexTemp /= input_width;
         const int y = indexTemp % input_height;
         indexTemp /= input_height;
-        const int c = indexTemp % num_channels;
-        indexTemp /= num_channels;
+        if(nchw)
+        {
+            c = indexTemp % num_channels;
+            indexTemp /= num_channels;
+        }
         const int n = indexTemp;
 
         const int out_y = fminf(y / height_scale, output_height - 1);
         const int out_x = fminf(x / width_scale, output_width - 1);
         const int out_index =
-            ((n * num_channels + c) * output_height + out_y) * output_width + out_x;
-        atomicAdd(dX + out_index, __ldg(dY + index));
+            nchw ? ((n * num_channels + c) * output_height + out_y) * output_width + out_x
+                 : ((n * output_height + out_y) * output_width + out_x) * num_channels + c;
+        atomicAdd(dX + out_index, convert::To<T, float>(dY[index]));
+    }
+}
+
+template <typename T>
+__global__ void BilinearNCHWKernel(const int size,
+                                   const int input_height,
+                                   const int input_width,
+                                   const int output_height,
+                                   const int output_width,
+                                   const float height_ratio,
+                                   const float width_ratio,
+                                   const bool align_corners,
+                                   const T* X,
+                                   T* Y)
+{
+    HIP_1D_KERNEL_LOOP(index, size)
+    {
+        const int x     = index % output_width;
+        const int y     = (index / output_width) % output_height;
+        const int plane = index / (output_width * output_height);
+        int y0, y1, x0, x1;
+        float ly, lx;
+        BilinearTaps(y, height_ratio, input_height, align_corners, &y0, &y1, &ly);
+        BilinearTaps(x, width_ratio, input_width, align_corners, &x0, &x1, &lx);
+
+        const T* in   = X + plane * input_height * input_width;
+        const T* r0   = in + y0 * input_width;
+        const T* r1   = in + y1 * input_width;
+        const float a = convert::To<T, float>(r0[x0]);
+        const float b = convert::To<T, float>(r0[x1]);
+        const float c = convert::To<T, float>(r1[x0]);
+        const float d = convert::To<T, float>(r1[x1]);
+        const float top    = a + (b - a) * lx;
+        const float bottom = c + (d - c) * lx;
+        Y[index]           = convert::To<float, T>(top + (bottom - top) * ly);
+    }
+}
+
+// Each thread computes N contiguous channels of an output pixel.
+template <typename T, int N>
+__global__ void BilinearNHWCKernel(const int num_packs,
+                                   const int channel_packs,
+                                   const int input_height,
+                                   const int input_width,
+                                   const int output_height,
+                                   const int output_width,
+                                   const float height_ratio,
+                                   const float width_ratio,
+                                   const bool align_corners,
+                                   const T* X,
+                                   T* Y)
+{
+    const PackedVector<T, N>* x_packs = reinterpret_cast<const PackedVector<T, N>*>(X);
+    PackedVector<T, N>* y_packs       = reinterpret_cast<PackedVector<T, N>*>(Y);
+    HIP_1D_KERNEL_LOOP(index, num_packs)
+    {
+        const int cp = index % channel_packs;
+        const int x  = (index / channel_packs) % output_width;
+        const int y  = (index / (channel_packs * output_width)) % output_height;
+        const int n  = index / (channel_packs * output_width * output_height);
+        int y0, y1, x0, x1;
+        float ly, lx;
+        BilinearTaps(y, height_ratio, input_height, align_corners, &y0, &y1, &ly);
+        BilinearTaps(x, width_ratio, input_width, align_corners, &x0, &x1, &lx);
+
+        const int base = n * input_height;
+        const PackedVector<T, N> p00 =
+            x_packs[((base + y0) * input_width + x0) * channel_packs + cp];
+        const PackedVector<T, N> p01 =
+            x_packs[((base + y0) * input_width + x1) * channel_packs + cp];
+        const PackedVector<T, N> p10 =
+            x_packs[((base + y1) * input_width + x0) * channel_packs + cp];
+        const PackedVector<T, N> p11 =
+            x_packs[((base + y1) * input_width + x1) * channel_packs + cp];
+        const float w00 = (1 - ly) * (1 - lx), w01 = (1 - ly) * lx;
+        const float w10 = ly * (1 - lx), w11 = ly * lx;
+        PackedVector<T, N> out;
+#pragma unroll
+        for(int j = 0; j < N; ++j)
+        {
+            out.val[j] = convert::To<float, T>(w00 * convert::To<T, float>(p00.val[j]) +
+                                               w01 * convert::To<T, float>(p01.val[j]) +
+                                               w10 * convert::To<T, float>(p10.val[j]) +
+                                               w11 * convert::To<T, float>(p11.val[j]));
+        }
+        y_packs[index] = out;
+    }
+}
+
+// Each output pixel gives its gradient back to its four input pixels.
+template <typename T>
+__global__ void BilinearGradientKernel(const int size,
+                                       const bool nchw,
+                                       const int num_channels,
+                                       const int input_height,
+                                       const int input_width,
+                                       const int output_height,
+                                       const int output_width,
+                                       const float height_ratio,
+                                       const float width_ratio,
+                                       const bool align_corners,
+                                       const T* dY,
+                                       float* dX)
+{
+    HIP_1D_KERNEL_LOOP(index, size)
+    {
+        int indexTemp = index;
+        int c         = 0;
+        if(!nchw)
+        {
+            c = indexTemp % num_channels;
+            indexTemp /= num_channels;
+        }
+        const int x = indexTemp % output_width;
+        indexTemp /= output_width;
+        const int y = indexTemp % output_height;
+        indexTemp /= output_height;
+        // The n * C + c plane in NCHW, the image n in NHWC.
+        const int plane = indexTemp;
+        int y0, y1, x0, x1;
+        float ly, lx;
+        BilinearTaps(y, height_ratio, input_height, align_corners, &y0, &y1, &ly);
+        BilinearTaps(x, width_ratio, input_width, align_corners, &x0, &x1, &lx);
+
+        const int C       = nchw ? 1 : num_channels;
+        float* in         = dX + plane * input_height * input_width * C + c;
+        const float g     = convert::To<T, float>(dY[index]);
+        atomicAdd(in + (y0 * input_width + x0) * C, (1 - ly) * (1 - lx) * g);
+        atomicAdd(in + (y0 * input_width + x1) * C, (1 - ly) * lx * g);
+        atomicAdd(in + (y1 * input_width + x0) * C, ly * (1 - lx) * g);
+        atomicAdd(in + (y1 * input_width + x1) * C, ly * lx * g);
+    }
+}
+
+template <typename T>
+__global__ void FloatToTypeKernel(const int size, const float* X, T* Y)
+{
+    HIP_1D_KERNEL_LOOP(index, size)
+    {
+        Y[index] = convert::To<float, T>(X[index]);
+    }
+}
+
+// The float gradient of dX: dX itself for float, the float scratch for
+// float16, which ReleaseGradient then converts to dX.
+template <typename T>
+float* GradientAccumulator(Tensor<HIPContext>* dX,
+                           Tensor<HIPContext>* dX_float,
+                           HIPContext* context)
+{
+    float* acc;
+    if(std::is_same<T, float>::value)
+    {
+        acc = reinterpret_cast<float*>(dX->template mutable_data<T>());
+    }
+    else
+    {
+        dX_float->ResizeLike(*dX);
+        acc = dX_float->template mutable_data<float>();
+    }
+    math::Set<float, HIPContext>(dX->size(), 0.0f, acc, context);
+    return acc;
+}
+
+template <typename T>
+void ReleaseGradient(const Tensor<HIPContext>& dX_float,
+                     Tensor<HIPContext>* dX,
+                     HIPContext* context)
+{
+    if(std::is_same<T, float>::value || dX->size() == 0)
+    {
+        return;
     }
+    hipLaunchKernelGGL((FloatToTypeKernel<T>),
+                       dim3(CAFFE_GET_BLOCKS(dX->size())),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context->hip_stream(),
+                       static_cast<const int>(dX->size()),
+                       dX_float.data<float>(),
+                       dX->template mutable_data<T>());
 }
 
 } // namespace
 
 template <>
 bool ResizeNearestOp<float, HIPContext>::RunOnDevice()
+{
+    return DispatchHelper<TensorTypes<float, float16>>::call(this, Input(0));
+}
+
+template <>
+template <typename D>
+bool ResizeNearestOp<float, HIPContext>::DoRunWithType()
 {
     const auto& X = Input(0);
     auto* Y       = Output(0);
 
     const auto& inputDims = X.dims();
     CAFFE_ENFORCE_EQ(4, inputDims.size());
-    const int batch_size = X.dim32(0), num_channels = X.dim32(1), input_height = X.dim32(2),
-              input_width = X.dim32(3);
-    int output_width      = input_width * width_scale_;
-    int output_height     = input_height * height_scale_;
-    Y->Resize(batch_size, num_channels, output_height, output_width);
+    const bool nchw      = order_ == StorageOrder::NCHW;
+    const int batch_size = X.dim32(0), num_channels = X.dim32(nchw ? 1 : 3),
+              input_height = X.dim32(nchw ? 2 : 1), input_width = X.dim32(nchw ? 3 : 2);
+    int output_width  = input_width * width_scale_;
+    int output_height = input_height * height_scale_;
+    if(nchw)
+    {
+        Y->Resize(batch_size, num_channels, output_height, output_width);
+    }
+    else
+    {
+        Y->Resize(batch_size, output_height, output_width, num_channels);
+    }
 
     const auto size = Y->size();
-    hipLaunchKernelGGL((NearestNeighborKernel),
+    if(size == 0)
+    {
+        Y->template mutable_data<D>();
+        return true;
+    }
+    hipLaunchKernelGGL((NearestNeighborKernel<D>),
                        dim3(CAFFE_GET_BLOCKS(size)),
                        dim3(CAFFE_HIP_NUM_THREADS),
                        0,
                        context_.hip_stream(),
                        static_cast<const int>(size),
+                       nchw,
                        num_channels,
                        input_height,
                        input_width,
@@ -112,14 +349,21 @@ bool ResizeNearestOp<float, HIPContext>::RunOnDevice()
                        output_width,
                        static_cast<const float>(height_scale_),
                        static_cast<const float>(width_scale_),
-                       X.data<float>(),
-                       Y->mutable_data<float>());
+                       X.template data<D>(),
+                       Y->template mutable_data<D>());
 
     return true;
 }
 
 template <>
 bool ResizeNearestGradientOp<float, HIPContext>::RunOnDevice()
+{
+    return DispatchHelper<TensorTypes<float, float16>>::call(this, Input(0));
+}
+
+template <>
+template <typename D>
+bool ResizeNearestGradientOp<float, HIPContext>::DoRunWithType()
 {
     const auto& dY = Input(0);
     const auto& X  = Input(1);
@@ -127,33 +371,194 @@ bool ResizeNearestGradientOp<float, HIPContext>::RunOnDevice()
 
     const auto& inputDims = dY.dims();
     CAFFE_ENFORCE_EQ(4, inputDims.size());
-    const int batch_size = dY.dim32(0), num_channels = dY.dim32(1), input_height = dY.dim32(2),
-              input_width = dY.dim32(3);
-    int output_height     = X.dim32(2);
-    int output_width      = X.dim32(3);
-    dX->Resize(batch_size, num_channels, output_height, output_width);
-    math::Set<float, HIPContext>(dX->size(), 0.0f, dX->mutable_data<float>(), &context_);
+    const bool nchw      = order_ == StorageOrder::NCHW;
+    const int batch_size = dY.dim32(0), num_channels = dY.dim32(nchw ? 1 : 3),
+              input_height = dY.dim32(nchw ? 2 : 1), input_width = dY.dim32(nchw ? 3 : 2);
+    int output_height = X.dim32(nchw ? 2 : 1);
+    int output_width  = X.dim32(nchw ? 3 : 2);
+    if(nchw)
+    {
+        dX->Resize(batch_size, num_channels, output_height, output_width);
+    }
+    else
+    {
+        dX->Resize(batch_size, output_height, output_width, num_channels);
+    }
+    float* dX_acc = GradientAccumulator<D>(dX, &dX_float_, &context_);
 
     const auto size = dY.size();
-    hipLaunchKernelGGL((NearestNeighborGradientKernel),
-                       dim3(CAFFE_GET_BLOCKS(size)),
-                       dim3(CAFFE_HIP_NUM_THREADS),
-                       0,
-                       context_.hip_stream(),
-                       static_cast<const int>(size),
-                       num_channels,
-                       input_height,
-                       input_width,
-                       output_height,
-                       output_width,
-                       static_cast<const float>(height_scale_),
-                       static_cast<const float>(width_scale_),
-                       dY.data<float>(),
-                       dX->mutable_data<float>());
+    if(size > 0)
+    {
+        hipLaunchKernelGGL((NearestNeighborGradientKernel<D>),
+                           dim3(CAFFE_GET_BLOCKS(size)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           static_cast<const int>(size),
+                           nchw,
+                           num_channels,
+                           input_height,
+                           input_width,
+                           output_height,
+                           output_width,
+                           static_cast<const float>(height_scale_),
+                           static_cast<const float>(width_scale_),
+                           dY.template data<D>(),
+                           dX_acc);
+    }
+    ReleaseGradient<D>(dX_float_, dX, &context_);
+
+    return true;
+}
 
+template <>
+bool ResizeBilinearOp<HIPContext>::RunOnDevice()
+{
+    return DispatchHelper<TensorTypes<float, float16>>::call(this, Input(0));
+}
+
+template <>
+template <typename T>
+bool ResizeBilinearOp<HIPContext>::DoRunWithType()
+{
+    const auto& X = Input(0);
+    auto* Y       = Output(0);
+    CAFFE_ENFORCE_EQ(4, X.ndim());
+    const bool nchw      = order_ == StorageOrder::NCHW;
+    const int batch_size = X.dim32(0), num_channels = X.dim32(nchw ? 1 : 3),
+              input_height = X.dim32(nchw ? 2 : 1), input_width = X.dim32(nchw ? 3 : 2);
+    const int output_height = input_height * height_scale_;
+    const int output_width  = input_width * width_scale_;
+    if(nchw)
+    {
+        Y->Resize(batch_size, num_channels, output_height, output_width);
+    }
+    else
+    {
+        Y->Resize(batch_size, output_height, output_width, num_channels);
+    }
+    const T* Xdata = X.template data<T>();
+    T* Ydata       = Y->template mutable_data<T>();
+    const int size = Y->size();
+    if(size == 0)
+    {
+        return true;
+    }
+    const float height_ratio =
+        BilinearRatio(input_height, output_height, height_scale_, align_corners_);
+    const float width_ratio =
+        BilinearRatio(input_width, output_width, width_scale_, align_corners_);
+
+    if(nchw)
+    {
+        hipLaunchKernelGGL((BilinearNCHWKernel<T>),
+                           dim3(CAFFE_GET_BLOCKS(size)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           size,
+                           input_height,
+                           input_width,
+                           output_height,
+                           output_width,
+                           height_ratio,
+                           width_ratio,
+                           align_corners_,
+                           Xdata,
+                           Ydata);
+    }
+    else if(num_channels % kVec == 0)
+    {
+        hipLaunchKernelGGL((BilinearNHWCKernel<T, kVec>),
+                           dim3(CAFFE_GET_BLOCKS(size / kVec)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           size / kVec,
+                           num_channels / kVec,
+                           input_height,
+                           input_width,
+                           output_height,
+                           output_width,
+                           height_ratio,
+                           width_ratio,
+                           align_corners_,
+                           Xdata,
+                           Ydata);
+    }
+    else
+    {
+        hipLaunchKernelGGL((BilinearNHWCKernel<T, 1>),
+                           dim3(CAFFE_GET_BLOCKS(size)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           size,
+                           num_channels,
+                           input_height,
+                           input_width,
+                           output_height,
+                           output_width,
+                           height_ratio,
+                           width_ratio,
+                           align_corners_,
+                           Xdata,
+                           Ydata);
+    }
+    return true;
+}
+
+template <>
+bool ResizeBilinearGradientOp<HIPContext>::RunOnDevice()
+{
+    return DispatchHelper<TensorTypes<float, float16>>::call(this, Input(0));
+}
+
+template <>
+template <typename T>
+bool ResizeBilinearGradientOp<HIPContext>::DoRunWithType()
+{
+    const auto& dY = Input(0);
+    const auto& X  = Input(1);
+    auto* dX       = Output(0);
+    CAFFE_ENFORCE_EQ(4, dY.ndim());
+    CAFFE_ENFORCE_EQ(4, X.ndim());
+    const bool nchw        = order_ == StorageOrder::NCHW;
+    const int num_channels = dY.dim32(nchw ? 1 : 3), output_height = dY.dim32(nchw ? 2 : 1),
+              output_width = dY.dim32(nchw ? 3 : 2);
+    const int input_height = X.dim32(nchw ? 2 : 1);
+    const int input_width  = X.dim32(nchw ? 3 : 2);
+    dX->ResizeLike(X);
+    float* dX_acc = GradientAccumulator<T>(dX, &dX_float_, &context_);
+
+    const int size = dY.size();
+    if(size > 0)
+    {
+        hipLaunchKernelGGL(
+            (BilinearGradientKernel<T>),
+            dim3(CAFFE_GET_BLOCKS(size)),
+            dim3(CAFFE_HIP_NUM_THREADS),
+            0,
+            context_.hip_stream(),
+            size,
+            nchw,
+            num_channels,
+            input_height,
+            input_width,
+            output_height,
+            output_width,
+            BilinearRatio(input_height, output_height, height_scale_, align_corners_),
+            BilinearRatio(input_width, output_width, width_scale_, align_corners_),
+            align_corners_,
+            dY.template data<T>(),
+            dX_acc);
+    }
+    ReleaseGradient<T>(dX_float_, dX, &context_);
     return true;
 }
 
 REGISTER_HIP_OPERATOR(ResizeNearest, ResizeNearestOp<float, HIPContext>);
 REGISTER_HIP_OPERATOR(ResizeNearestGradient, ResizeNearestGradientOp<float, HIPContext>);
+REGISTER_HIP_OPERATOR(ResizeBilinear, ResizeBilinearOp<HIPContext>);
+REGISTER_HIP_OPERATOR(ResizeBilinearGradient, ResizeBilinearGradientOp<HIPContext>);
 } // namespace caffe2
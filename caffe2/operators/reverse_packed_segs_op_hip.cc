@@ -22,6 +22,9 @@ namespace caffe2 {
 
 namespace {
 
+// One thread per output item: item k of (segment, batch) is read from the
+// mirrored segment of the same batch entry, so consecutive threads read and
+// write consecutive items even for small embeddings.
 template <typename T, typename LengthType>
 __global__ void ReversePackedSegments_kernel(size_t max_length,
                                              size_t batch_size,
@@ -30,38 +33,21 @@ __global__ void ReversePackedSegments_kernel(size_t max_length,
                                              const T* data_ptr,
                                              T* rev_data_ptr)
 {
-
-    const int block_id = blockIdx.x;
-
-    // index into [0, batch_size)
-    const int batch = block_id / max_length;
-    // index into [0, segment)
-    const int segment = block_id % max_length;
-
-    if(batch >= batch_size || segment >= max_length)
-        return;
-
-    const int seg_length = lengths_ptr[batch];
-
-    // unique data pointer for this CTA
-    const T* local_data_ptr = data_ptr + (segment * batch_size + batch) * block_size;
-
-    // unique pointer for result
-    T* local_rev_data_ptr;
-    if(segment < seg_length)
+    const size_t N = max_length * batch_size * block_size;
+    HIP_1D_KERNEL_LOOP(i, N)
     {
-        local_rev_data_ptr =
-            rev_data_ptr + ((seg_length - 1 - segment) * batch_size + batch) * block_size;
-    }
-    else
-    {
-        local_rev_data_ptr = rev_data_ptr + (segment * batch_size + batch) * block_size;
-    }
-
-    // copy using 1 element / thread for now
-    for(int idx = threadIdx.x; idx < block_size; idx += blockDim.x)
-    {
-        local_rev_data_ptr[idx] = local_data_ptr[idx];
+        const size_t row     = i / block_size;
+        // index into [0, max_length)
+        const size_t segment = row / batch_size;
+        // index into [0, batch_size)
+        const size_t batch   = row % batch_size;
+
+        const size_t seg_length = lengths_ptr[batch];
+        const size_t src_segment =
+            segment < seg_length ? seg_length - 1 - segment : segment;
+
+        rev_data_ptr[i] =
+            data_ptr[(src_segment * batch_size + batch) * block_size + i % block_size];
     }
 }
 
@@ -97,11 +83,15 @@ void ReversePackedSegsOp<HIPContext>::DoRunWithLengthType()
     // reversed data
     T* rev_data_ptr = output->template mutable_data<T>();
 
-    const int grid = max_length * batch_size;
+    const size_t N = max_length * batch_size * block_size;
+    if(N == 0)
+    {
+        return;
+    }
 
     hipLaunchKernelGGL((ReversePackedSegments_kernel<T, LengthType>),
-                       dim3(grid),
-                       dim3(512),
+                       dim3(CAFFE_GET_BLOCKS(N)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
                        0,
                        context_.hip_stream(),
                        max_length,
@@ -0,0 +1,519 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "roi_align_op.h"
+
+#include <vector>
+
+namespace caffe2 {
+
+namespace {
+
+// The 4 neighbours of a sampling point and their bilinear weights. An
+// out-of-range point has zero weights, so it contributes nothing.
+template <typename T>
+struct BilinearPoint {
+  int pos[4];
+  T w[4];
+};
+
+template <typename T>
+BilinearPoint<T> MakeBilinearPoint(int height, int width, T y, T x) {
+  BilinearPoint<T> p = {{0, 0, 0, 0}, {0, 0, 0, 0}};
+  if (y < -1.0 || y > height || x < -1.0 || x > width) {
+    return p;
+  }
+  y = std::max(y, T(0));
+  x = std::max(x, T(0));
+  int y_low = static_cast<int>(y);
+  int x_low = static_cast<int>(x);
+  int y_high;
+  int x_high;
+  if (y_low >= height - 1) {
+    y_high = y_low = height - 1;
+    y = static_cast<T>(y_low);
+  } else {
+    y_high = y_low + 1;
+  }
+  if (x_low >= width - 1) {
+    x_high = x_low = width - 1;
+    x = static_cast<T>(x_low);
+  } else {
+    x_high = x_low + 1;
+  }
+  const T ly = y - y_low;
+  const T lx = x - x_low;
+  const T hy = T(1) - ly;
+  const T hx = T(1) - lx;
+  p.pos[0] = y_low * width + x_low;
+  p.pos[1] = y_low * width + x_high;
+  p.pos[2] = y_high * width + x_low;
+  p.pos[3] = y_high * width + x_high;
+  p.w[0] = hy * hx;
+  p.w[1] = hy * lx;
+  p.w[2] = ly * hx;
+  p.w[3] = ly * lx;
+  return p;
+}
+
+// Computes the sampling points of every bin of a RoI, grouped by bin in
+// output order, and returns the number of points per bin.
+template <typename T>
+int RoIAlignSamplingPoints(
+    const T* roi,
+    T spatial_scale,
+    int height,
+    int width,
+    int pooled_height,
+    int pooled_width,
+    int sampling_ratio,
+    std::vector<BilinearPoint<T>>* points) {
+  const T roi_start_w = roi[1] * spatial_scale;
+  const T roi_start_h = roi[2] * spatial_scale;
+  const T roi_end_w = roi[3] * spatial_scale;
+  const T roi_end_h = roi[4] * spatial_scale;
+  // Force malformed RoIs to be 1x1
+  const T roi_width = std::max(roi_end_w - roi_start_w, T(1));
+  const T roi_height = std::max(roi_end_h - roi_start_h, T(1));
+  const T bin_size_h = roi_height / pooled_height;
+  const T bin_size_w = roi_width / pooled_width;
+  // Adaptive number of samples per bin when sampling_ratio <= 0
+  const int grid_h = sampling_ratio > 0
+      ? sampling_ratio
+      : static_cast<int>(std::ceil(roi_height / pooled_height));
+  const int grid_w = sampling_ratio > 0
+      ? sampling_ratio
+      : static_cast<int>(std::ceil(roi_width / pooled_width));
+
+  points->clear();
+  points->reserve(pooled_height * pooled_width * grid_h * grid_w);
+  for (int ph = 0; ph < pooled_height; ++ph) {
+    for (int pw = 0; pw < pooled_width; ++pw) {
+      for (int iy = 0; iy < grid_h; ++iy) {
+        const T y = roi_start_h + ph * bin_size_h +
+            (iy + T(0.5)) * bin_size_h / grid_h;
+        for (int ix = 0; ix < grid_w; ++ix) {
+          const T x = roi_start_w + pw * bin_size_w +
+              (ix + T(0.5)) * bin_size_w / grid_w;
+          points->push_back(MakeBilinearPoint(height, width, y, x));
+        }
+      }
+    }
+  }
+  return grid_h * grid_w;
+}
+
+// Pools one RoI from the (channels, height, width) image data into the
+// (channels, pooled_height, pooled_width) output.
+template <typename T>
+void RoIAlignForwardRoI(
+    const T* roi,
+    const T* data,
+    T spatial_scale,
+    int channels,
+    int height,
+    int width,
+    int pooled_height,
+    int pooled_width,
+    int sampling_ratio,
+    std::vector<BilinearPoint<T>>* points,
+    T* out) {
+  const int count = RoIAlignSamplingPoints(
+      roi,
+      spatial_scale,
+      height,
+      width,
+      pooled_height,
+      pooled_width,
+      sampling_ratio,
+      points);
+  const int pooled_size = pooled_height * pooled_width;
+  for (int c = 0; c < channels; ++c) {
+    const T* channel_data = data + c * height * width;
+    const BilinearPoint<T>* p = points->data();
+    for (int i = 0; i < pooled_size; ++i) {
+      T sum = 0;
+      for (int s = 0; s < count; ++s, ++p) {
+        sum += p->w[0] * channel_data[p->pos[0]] +
+            p->w[1] * channel_data[p->pos[1]] +
+            p->w[2] * channel_data[p->pos[2]] +
+            p->w[3] * channel_data[p->pos[3]];
+      }
+      out[c * pooled_size + i] = count > 0 ? sum / count : T(0);
+    }
+  }
+}
+
+// Accumulates the gradient of one RoI into the (channels, height, width)
+// image gradient.
+template <typename T>
+void RoIAlignBackwardRoI(
+    const T* roi,
+    const T* out_diff,
+    T spatial_scale,
+    int channels,
+    int height,
+    int width,
+    int pooled_height,
+    int pooled_width,
+    int sampling_ratio,
+    std::vector<BilinearPoint<T>>* points,
+    T* diff) {
+  const int count = RoIAlignSamplingPoints(
+      roi,
+      spatial_scale,
+      height,
+      width,
+      pooled_height,
+      pooled_width,
+      sampling_ratio,
+      points);
+  if (count == 0) {
+    return;
+  }
+  const int pooled_size = pooled_height * pooled_width;
+  for (int c = 0; c < channels; ++c) {
+    T* channel_diff = diff + c * height * width;
+    const BilinearPoint<T>* p = points->data();
+    for (int i = 0; i < pooled_size; ++i) {
+      const T g = out_diff[c * pooled_size + i] / count;
+      for (int s = 0; s < count; ++s, ++p) {
+        for (int k = 0; k < 4; ++k) {
+          channel_diff[p->pos[k]] += p->w[k] * g;
+        }
+      }
+    }
+  }
+}
+
+} // namespace
+
+template <>
+bool RoIAlignOp<float, CPUContext>::RunOnDevice() {
+  const auto& X = Input(0); // Input data to pool, NCHW
+  const auto& R = Input(1); // RoIs
+  auto* Y = Output(0); // RoI pooled data
+
+  CAFFE_ENFORCE_EQ(X.ndim(), 4);
+  CAFFE_ENFORCE_EQ(R.ndim(), 2);
+  // Each RoI is of the form [batch_index x1 y1 x2 y2]
+  CAFFE_ENFORCE_EQ(R.dim32(1), 5);
+  const int batch_size = X.dim32(0);
+  const int channels = X.dim32(1);
+  const int height = X.dim32(2);
+  const int width = X.dim32(3);
+  const int num_rois = R.dim32(0);
+
+  Y->Resize(num_rois, channels, pooled_height_, pooled_width_);
+  const float* rois = R.data<float>();
+  float* Ydata = Y->mutable_data<float>();
+  std::vector<BilinearPoint<float>> points;
+  for (int n = 0; n < num_rois; ++n) {
+    const float* roi = rois + n * 5;
+    const int roi_batch_id = roi[0];
+    CAFFE_ENFORCE_GE(roi_batch_id, 0);
+    CAFFE_ENFORCE_LT(roi_batch_id, batch_size);
+    RoIAlignForwardRoI(
+        roi,
+        X.data<float>() + roi_batch_id * X.size_from_dim(1),
+        spatial_scale_,
+        channels,
+        height,
+        width,
+        pooled_height_,
+        pooled_width_,
+        sampling_ratio_,
+        &points,
+        Ydata + n * Y->size_from_dim(1));
+  }
+  return true;
+}
+
+template <>
+bool RoIAlignGradientOp<float, CPUContext>::RunOnDevice() {
+  const auto& X = Input(0); // Input data to pool
+  const auto& R = Input(1); // RoIs
+  const auto& dY = Input(2); // Gradient of net w.r.t. output of "forward" op
+  auto* dX = Output(0); // Gradient of net w.r.t. input to "forward" op
+
+  CAFFE_ENFORCE_EQ(R.dim32(1), 5);
+  CAFFE_ENFORCE_EQ(dY.dim32(0), R.dim32(0));
+  dX->ResizeLike(X);
+  // Must zero-out dX before accumulating gradients
+  math::Set<float, CPUContext>(
+      dX->size(), 0.f, dX->mutable_data<float>(), &context_);
+
+  const float* rois = R.data<float>();
+  std::vector<BilinearPoint<float>> points;
+  for (int n = 0; n < R.dim32(0); ++n) {
+    const float* roi = rois + n * 5;
+    const int roi_batch_id = roi[0];
+    CAFFE_ENFORCE_GE(roi_batch_id, 0);
+    CAFFE_ENFORCE_LT(roi_batch_id, X.dim32(0));
+    RoIAlignBackwardRoI(
+        roi,
+        dY.data<float>() + n * dY.size_from_dim(1),
+        spatial_scale_,
+        X.dim32(1),
+        X.dim32(2),
+        X.dim32(3),
+        pooled_height_,
+        pooled_width_,
+        sampling_ratio_,
+        &points,
+        dX->mutable_data<float>() + roi_batch_id * X.size_from_dim(1));
+  }
+  return true;
+}
+
+template <>
+bool MultiLevelRoIAlignOp<float, CPUContext>::RunOnDevice() {
+  const int num_levels = max_level_ - min_level_ + 1;
+  const auto& X0 = Input(0);
+  const auto& R = Input(num_levels);
+  auto* Y = Output(0);
+
+  CAFFE_ENFORCE_EQ(R.ndim(), 2);
+  CAFFE_ENFORCE_EQ(R.dim32(1), 5);
+  for (int l = 0; l < num_levels; ++l) {
+    CAFFE_ENFORCE_EQ(Input(l).ndim(), 4);
+    CAFFE_ENFORCE_EQ(Input(l).dim32(0), X0.dim32(0));
+    CAFFE_ENFORCE_EQ(Input(l).dim32(1), X0.dim32(1));
+  }
+  const int num_rois = R.dim32(0);
+  Y->Resize(num_rois, X0.dim32(1), pooled_height_, pooled_width_);
+
+  const float* rois = R.data<float>();
+  float* Ydata = Y->mutable_data<float>();
+  std::vector<BilinearPoint<float>> points;
+  for (int n = 0; n < num_rois; ++n) {
+    const float* roi = rois + n * 5;
+    const int roi_batch_id = roi[0];
+    CAFFE_ENFORCE_GE(roi_batch_id, 0);
+    CAFFE_ENFORCE_LT(roi_batch_id, X0.dim32(0));
+    const int level = RoIAlignFPNLevel(
+        roi, min_level_, max_level_, canonical_scale_, canonical_level_);
+    const auto& X = Input(level - min_level_);
+    RoIAlignForwardRoI(
+        roi,
+        X.data<float>() + roi_batch_id * X.size_from_dim(1),
+        1.0f / (1 << level),
+        X.dim32(1),
+        X.dim32(2),
+        X.dim32(3),
+        pooled_height_,
+        pooled_width_,
+        sampling_ratio_,
+        &points,
+        Ydata + n * Y->size_from_dim(1));
+  }
+  return true;
+}
+
+template <>
+bool MultiLevelRoIAlignGradientOp<float, CPUContext>::RunOnDevice() {
+  const int num_levels = max_level_ - min_level_ + 1;
+  const auto& R = Input(num_levels);
+  const auto& dY = Input(num_levels + 1);
+
+  CAFFE_ENFORCE_EQ(R.dim32(1), 5);
+  CAFFE_ENFORCE_EQ(dY.dim32(0), R.dim32(0));
+  for (int l = 0; l < num_levels; ++l) {
+    auto* dX = Output(l);
+    dX->ResizeLike(Input(l));
+    math::Set<float, CPUContext>(
+        dX->size(), 0.f, dX->mutable_data<float>(), &context_);
+  }
+
+  const float* rois = R.data<float>();
+  std::vector<BilinearPoint<float>> points;
+  for (int n = 0; n < R.dim32(0); ++n) {
+    const float* roi = rois + n * 5;
+    const int roi_batch_id = roi[0];
+    const int level = RoIAlignFPNLevel(
+        roi, min_level_, max_level_, canonical_scale_, canonical_level_);
+    const auto& X = Input(level - min_level_);
+    CAFFE_ENFORCE_GE(roi_batch_id, 0);
+    CAFFE_ENFORCE_LT(roi_batch_id, X.dim32(0));
+    RoIAlignBackwardRoI(
+        roi,
+        dY.data<float>() + n * dY.size_from_dim(1),
+        1.0f / (1 << level),
+        X.dim32(1),
+        X.dim32(2),
+        X.dim32(3),
+        pooled_height_,
+        pooled_width_,
+        sampling_ratio_,
+        &points,
+        Output(level - min_level_)->mutable_data<float>() +
+            roi_batch_id * X.size_from_dim(1));
+  }
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(RoIAlign, RoIAlignOp<float, CPUContext>);
+REGISTER_CPU_OPERATOR(RoIAlignGradient, RoIAlignGradientOp<float, CPUContext>);
+REGISTER_CPU_OPERATOR(
+    MultiLevelRoIAlign,
+    MultiLevelRoIAlignOp<float, CPUContext>);
+REGISTER_CPU_OPERATOR(
+    MultiLevelRoIAlignGradient,
+    MultiLevelRoIAlignGradientOp<float, CPUContext>);
+
+// Input: X, rois
+// Output: Y
+OPERATOR_SCHEMA(RoIAlign)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .TensorInferenceFunction([](const OperatorDef& def,
+                                const vector<TensorShape>& in) {
+      ArgumentHelper helper(def);
+      const TensorShape& X = in[0];
+      const TensorShape& R = in[1];
+      const int pooled_height = helper.GetSingleArgument<int>("pooled_h", 1);
+      const int pooled_width = helper.GetSingleArgument<int>("pooled_w", 1);
+      const int num_rois = R.dims(0);
+      const int num_channels = X.dims(1);
+      return vector<TensorShape>({CreateTensorShape(
+          vector<int>({num_rois, num_channels, pooled_height, pooled_width}),
+          X.data_type())});
+    })
+    .SetDoc(R"DOC(
+Region of Interest (RoI) align operation as used in Mask R-CNN. Every output
+bin is the average of bilinearly interpolated samples of X, without
+quantizing the RoI or bin boundaries.
+)DOC")
+    .Arg("order", "A StorageOrder string (Default: \"NCHW\").")
+    .Arg("pooled_h", "The pooled output height (Default: 1).")
+    .Arg("pooled_w", "The pooled output width (Default: 1).")
+    .Arg(
+        "spatial_scale",
+        "Multiplicative spatial scale factor to translate ROI coords from "
+        "their input scale to the scale used when pooling (Default: 1.0).")
+    .Arg(
+        "sampling_ratio",
+        "Number of sampling points in the interpolation grid used to compute "
+        "the output value of each pooled output bin. If > 0, then exactly "
+        "sampling_ratio x sampling_ratio grid points are used. If <= 0, then "
+        "an adaptive number of grid points are used (computed as "
+        "ceil(roi_width / pooled_w), and likewise for height) (Default: -1).")
+    .Input(
+        0,
+        "X",
+        "The input 4-D tensor of data. Only NCHW order is currently supported.")
+    .Input(
+        1,
+        "rois",
+        "RoIs (Regions of Interest) to pool over. Should be a 2-D tensor of "
+        "shape (num_rois, 5) given as [[batch_id, x1, y1, x2, y2], ...].")
+    .Output(
+        0,
+        "Y",
+        "RoI pooled output 4-D tensor of shape "
+        "(num_rois, channels, pooled_h, pooled_w).");
+
+// Input: X, rois, dY (aka "gradOutput")
+// Output: dX (aka "gradInput")
+OPERATOR_SCHEMA(RoIAlignGradient).NumInputs(3).NumOutputs(1);
+
+// Input: X_min_level, ..., X_max_level, rois
+// Output: Y
+OPERATOR_SCHEMA(MultiLevelRoIAlign)
+    .NumInputs(2, kRoIAlignMaxLevels + 1)
+    .NumOutputs(1)
+    .TensorInferenceFunction([](const OperatorDef& def,
+                                const vector<TensorShape>& in) {
+      ArgumentHelper helper(def);
+      const TensorShape& X = in[0];
+      const TensorShape& R = in.back();
+      const int pooled_height = helper.GetSingleArgument<int>("pooled_h", 1);
+      const int pooled_width = helper.GetSingleArgument<int>("pooled_w", 1);
+      const int num_rois = R.dims(0);
+      const int num_channels = X.dims(1);
+      return vector<TensorShape>({CreateTensorShape(
+          vector<int>({num_rois, num_channels, pooled_height, pooled_width}),
+          X.data_type())});
+    })
+    .SetDoc(R"DOC(
+RoIAlign over the levels of a feature pyramid (FPN) in a single op. Every RoI
+is assigned to the level
+
+  clamp(floor(canonical_level + log2(sqrt(area) / canonical_scale)),
+        min_level, max_level)
+
+and pooled from that level's feature map with a spatial scale of 1 / 2^level.
+The output keeps the input order of the RoIs, so it replaces a
+distribute / per-level RoIAlign / concat / restore sequence.
+)DOC")
+    .Arg("pooled_h", "The pooled output height (Default: 1).")
+    .Arg("pooled_w", "The pooled output width (Default: 1).")
+    .Arg("sampling_ratio", "See RoIAlign (Default: -1).")
+    .Arg("min_level", "Finest pyramid level, of the first input (Default: 2).")
+    .Arg("max_level", "Coarsest pyramid level (Default: 5).")
+    .Arg(
+        "canonical_scale",
+        "RoI scale that is mapped to canonical_level (Default: 224).")
+    .Arg("canonical_level", "Level of canonical_scale RoIs (Default: 4).")
+    .Input(
+        0,
+        "X_min_level",
+        "Feature maps of levels min_level to max_level, all NCHW with the "
+        "same N and C, followed by the RoIs given as [[batch_id, x1, y1, x2, "
+        "y2], ...] in image coordinates.")
+    .Output(
+        0,
+        "Y",
+        "RoI pooled output 4-D tensor of shape "
+        "(num_rois, channels, pooled_h, pooled_w).");
+
+// Input: X_min_level, ..., X_max_level, rois, dY
+// Output: dX_min_level, ..., dX_max_level
+OPERATOR_SCHEMA(MultiLevelRoIAlignGradient)
+    .NumInputs(3, kRoIAlignMaxLevels + 2)
+    .NumOutputs(1, kRoIAlignMaxLevels);
+
+class GetRoIAlignGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    return SingleGradientDef(
+        "RoIAlignGradient",
+        "",
+        vector<string>{I(0), I(1), GO(0)},
+        vector<string>{GI(0)});
+  }
+};
+
+class GetMultiLevelRoIAlignGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    vector<string> inputs;
+    vector<string> outputs;
+    for (int i = 0; i < def_.input_size() - 1; ++i) {
+      inputs.push_back(I(i));
+      outputs.push_back(GI(i));
+    }
+    inputs.push_back(I(def_.input_size() - 1));
+    inputs.push_back(GO(0));
+    return SingleGradientDef(
+        "MultiLevelRoIAlignGradient", "", inputs, outputs);
+  }
+};
+
+REGISTER_GRADIENT(RoIAlign, GetRoIAlignGradient);
+REGISTER_GRADIENT(MultiLevelRoIAlign, GetMultiLevelRoIAlignGradient);
+
+} // namespace caffe2
@@ -0,0 +1,198 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ROI_ALIGN_OP_H_
+#define ROI_ALIGN_OP_H_
+
+#include <cmath>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+template <typename T, class Context>
+class RoIAlignOp final : public Operator<Context> {
+ public:
+  RoIAlignOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        order_(StringToStorageOrder(
+            OperatorBase::GetSingleArgument<string>("order", "NCHW"))),
+        spatial_scale_(
+            OperatorBase::GetSingleArgument<float>("spatial_scale", 1.)),
+        pooled_height_(OperatorBase::GetSingleArgument<int>("pooled_h", 1)),
+        pooled_width_(OperatorBase::GetSingleArgument<int>("pooled_w", 1)),
+        sampling_ratio_(
+            OperatorBase::GetSingleArgument<int>("sampling_ratio", -1)) {
+    CAFFE_ENFORCE_GT(spatial_scale_, 0);
+    CAFFE_ENFORCE_GT(pooled_height_, 0);
+    CAFFE_ENFORCE_GT(pooled_width_, 0);
+    CAFFE_ENFORCE_EQ(
+        order_, StorageOrder::NCHW, "Only NCHW order is supported right now.");
+  }
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+
+  bool RunOnDevice() override {
+    CAFFE_NOT_IMPLEMENTED;
+  }
+
+ protected:
+  StorageOrder order_;
+  float spatial_scale_;
+  int pooled_height_;
+  int pooled_width_;
+  int sampling_ratio_;
+};
+
+template <typename T, class Context>
+class RoIAlignGradientOp final : public Operator<Context> {
+ public:
+  RoIAlignGradientOp(const OperatorDef& def, Workspace* ws)
+      : Operator<Context>(def, ws),
+        spatial_scale_(
+            OperatorBase::GetSingleArgument<float>("spatial_scale", 1.)),
+        pooled_height_(OperatorBase::GetSingleArgument<int>("pooled_h", 1)),
+        pooled_width_(OperatorBase::GetSingleArgument<int>("pooled_w", 1)),
+        sampling_ratio_(
+            OperatorBase::GetSingleArgument<int>("sampling_ratio", -1)) {
+    CAFFE_ENFORCE_GT(spatial_scale_, 0);
+    CAFFE_ENFORCE_GT(pooled_height_, 0);
+    CAFFE_ENFORCE_GT(pooled_width_, 0);
+    CAFFE_ENFORCE_EQ(
+        StringToStorageOrder(
+            OperatorBase::GetSingleArgument<string>("order", "NCHW")),
+        StorageOrder::NCHW,
+        "Only NCHW order is supported right now.");
+  }
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+
+  bool RunOnDevice() override {
+    CAFFE_NOT_IMPLEMENTED;
+  }
+
+ protected:
+  float spatial_scale_;
+  int pooled_height_;
+  int pooled_width_;
+  int sampling_ratio_;
+};
+
+// FPN levels are given as one feature map per level, level l having a
+// spatial scale of 1 / 2^l. Every RoI is pooled from the level of its size,
+// as in Detectron's map_rois_to_fpn_levels.
+constexpr int kRoIAlignMaxLevels = 8;
+
+// Returns the FPN level of a RoI [batch_id, x1, y1, x2, y2].
+template <typename T>
+inline int RoIAlignFPNLevel(
+    const T* roi,
+    int min_level,
+    int max_level,
+    T canonical_scale,
+    int canonical_level) {
+  const T area = (roi[3] - roi[1] + T(1)) * (roi[4] - roi[2] + T(1));
+  const T scale = std::sqrt(area > T(0) ? area : T(0));
+  const int level = static_cast<int>(std::floor(
+      canonical_level + std::log2(scale / canonical_scale + T(1e-6))));
+  return std::min(std::max(level, min_level), max_level);
+}
+
+// RoIAlign over a feature pyramid in one op: inputs are the feature maps of
+// levels min_level..max_level followed by the RoIs, and the output keeps the
+// RoIs in their input order, so no distribute / restore step is needed.
+template <typename T, class Context>
+class MultiLevelRoIAlignOp final : public Operator<Context> {
+ public:
+  MultiLevelRoIAlignOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        pooled_height_(OperatorBase::GetSingleArgument<int>("pooled_h", 1)),
+        pooled_width_(OperatorBase::GetSingleArgument<int>("pooled_w", 1)),
+        sampling_ratio_(
+            OperatorBase::GetSingleArgument<int>("sampling_ratio", -1)),
+        min_level_(OperatorBase::GetSingleArgument<int>("min_level", 2)),
+        max_level_(OperatorBase::GetSingleArgument<int>("max_level", 5)),
+        canonical_scale_(
+            OperatorBase::GetSingleArgument<float>("canonical_scale", 224)),
+        canonical_level_(
+            OperatorBase::GetSingleArgument<int>("canonical_level", 4)) {
+    CAFFE_ENFORCE_GT(pooled_height_, 0);
+    CAFFE_ENFORCE_GT(pooled_width_, 0);
+    CAFFE_ENFORCE_LE(min_level_, max_level_);
+    CAFFE_ENFORCE_LE(max_level_ - min_level_ + 1, kRoIAlignMaxLevels);
+    CAFFE_ENFORCE_EQ(
+        InputSize(),
+        max_level_ - min_level_ + 2,
+        "Expected one feature map per level followed by the RoIs");
+  }
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+
+  bool RunOnDevice() override {
+    CAFFE_NOT_IMPLEMENTED;
+  }
+
+ protected:
+  int pooled_height_;
+  int pooled_width_;
+  int sampling_ratio_;
+  int min_level_;
+  int max_level_;
+  float canonical_scale_;
+  int canonical_level_;
+};
+
+template <typename T, class Context>
+class MultiLevelRoIAlignGradientOp final : public Operator<Context> {
+ public:
+  MultiLevelRoIAlignGradientOp(const OperatorDef& def, Workspace* ws)
+      : Operator<Context>(def, ws),
+        pooled_height_(OperatorBase::GetSingleArgument<int>("pooled_h", 1)),
+        pooled_width_(OperatorBase::GetSingleArgument<int>("pooled_w", 1)),
+        sampling_ratio_(
+            OperatorBase::GetSingleArgument<int>("sampling_ratio", -1)),
+        min_level_(OperatorBase::GetSingleArgument<int>("min_level", 2)),
+        max_level_(OperatorBase::GetSingleArgument<int>("max_level", 5)),
+        canonical_scale_(
+            OperatorBase::GetSingleArgument<float>("canonical_scale", 224)),
+        canonical_level_(
+            OperatorBase::GetSingleArgument<int>("canonical_level", 4)) {
+    CAFFE_ENFORCE_GT(pooled_height_, 0);
+    CAFFE_ENFORCE_GT(pooled_width_, 0);
+    CAFFE_ENFORCE_LE(min_level_, max_level_);
+    CAFFE_ENFORCE_LE(max_level_ - min_level_ + 1, kRoIAlignMaxLevels);
+    CAFFE_ENFORCE_EQ(InputSize(), max_level_ - min_level_ + 3);
+    CAFFE_ENFORCE_EQ(OutputSize(), max_level_ - min_level_ + 1);
+  }
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+
+  bool RunOnDevice() override {
+    CAFFE_NOT_IMPLEMENTED;
+  }
+
+ protected:
+  int pooled_height_;
+  int pooled_width_;
+  int sampling_ratio_;
+  int min_level_;
+  int max_level_;
+  float canonical_scale_;
+  int canonical_level_;
+};
+
+} // namespace caffe2
+
+#endif // ROI_ALIGN_OP_H_
@@ -0,0 +1,523 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cfloat>
+
+#include "caffe2/core/context_hip.h"
+#include "roi_align_op.h"
+
+namespace caffe2 {
+
+namespace {
+
+template <typename T>
+inline __device__ T gpu_atomic_add(const T val, T* address);
+
+template <>
+inline __device__ float gpu_atomic_add(const float val, float* address)
+{
+    return atomicAdd(address, val);
+}
+
+// Neighbours and weights of a sampling point, false if it is outside of the
+// feature map.
+template <typename T>
+__device__ bool BilinearCoefficients(const int height,
+                                     const int width,
+                                     T y,
+                                     T x,
+                                     int* pos,
+                                     T* w)
+{
+    if(y < -1.0 || y > height || x < -1.0 || x > width)
+    {
+        return false;
+    }
+    y         = y <= 0 ? T(0) : y;
+    x         = x <= 0 ? T(0) : x;
+    int y_low = static_cast<int>(y);
+    int x_low = static_cast<int>(x);
+    int y_high;
+    int x_high;
+    if(y_low >= height - 1)
+    {
+        y_high = y_low = height - 1;
+        y              = static_cast<T>(y_low);
+    }
+    else
+    {
+        y_high = y_low + 1;
+    }
+    if(x_low >= width - 1)
+    {
+        x_high = x_low = width - 1;
+        x              = static_cast<T>(x_low);
+    }
+    else
+    {
+        x_high = x_low + 1;
+    }
+    const T ly = y - y_low;
+    const T lx = x - x_low;
+    const T hy = T(1) - ly;
+    const T hx = T(1) - lx;
+    pos[0]     = y_low * width + x_low;
+    pos[1]     = y_low * width + x_high;
+    pos[2]     = y_high * width + x_low;
+    pos[3]     = y_high * width + x_high;
+    w[0]       = hy * hx;
+    w[1]       = hy * lx;
+    w[2]       = ly * hx;
+    w[3]       = ly * lx;
+    return true;
+}
+
+// Sampling grid of the output bin (ph, pw) of a RoI.
+template <typename T>
+struct RoIAlignBin
+{
+    T start_h;
+    T start_w;
+    T step_h;
+    T step_w;
+    int grid_h;
+    int grid_w;
+};
+
+template <typename T>
+__device__ RoIAlignBin<T> MakeRoIAlignBin(const T* roi,
+                                          const T spatial_scale,
+                                          const int pooled_height,
+                                          const int pooled_width,
+                                          const int sampling_ratio,
+                                          const int ph,
+                                          const int pw)
+{
+    const T roi_start_w = roi[1] * spatial_scale;
+    const T roi_start_h = roi[2] * spatial_scale;
+    // Force malformed RoIs to be 1x1
+    const T roi_width  = max(roi[3] * spatial_scale - roi_start_w, T(1));
+    const T roi_height = max(roi[4] * spatial_scale - roi_start_h, T(1));
+    const T bin_size_h = roi_height / pooled_height;
+    const T bin_size_w = roi_width / pooled_width;
+
+    RoIAlignBin<T> bin;
+    // Adaptive number of samples per bin when sampling_ratio <= 0
+    bin.grid_h  = sampling_ratio > 0 ? sampling_ratio : ceil(roi_height / pooled_height);
+    bin.grid_w  = sampling_ratio > 0 ? sampling_ratio : ceil(roi_width / pooled_width);
+    bin.start_h = roi_start_h + ph * bin_size_h;
+    bin.start_w = roi_start_w + pw * bin_size_w;
+    bin.step_h  = bin_size_h / bin.grid_h;
+    bin.step_w  = bin_size_w / bin.grid_w;
+    return bin;
+}
+
+template <typename T>
+__device__ T RoIAlignBinForward(
+    const RoIAlignBin<T>& bin, const T* data, const int height, const int width)
+{
+    T sum = 0;
+    int pos[4];
+    T w[4];
+    for(int iy = 0; iy < bin.grid_h; ++iy)
+    {
+        const T y = bin.start_h + (iy + T(0.5)) * bin.step_h;
+        for(int ix = 0; ix < bin.grid_w; ++ix)
+        {
+            const T x = bin.start_w + (ix + T(0.5)) * bin.step_w;
+            if(BilinearCoefficients(height, width, y, x, pos, w))
+            {
+                sum += w[0] * data[pos[0]] + w[1] * data[pos[1]] + w[2] * data[pos[2]] +
+                       w[3] * data[pos[3]];
+            }
+        }
+    }
+    const int count = bin.grid_h * bin.grid_w;
+    return count > 0 ? sum / count : T(0);
+}
+
+template <typename T>
+__device__ void RoIAlignBinBackward(
+    const RoIAlignBin<T>& bin, const T top_diff, const int height, const int width, T* diff)
+{
+    const int count = bin.grid_h * bin.grid_w;
+    if(count == 0)
+    {
+        return;
+    }
+    const T g = top_diff / count;
+    int pos[4];
+    T w[4];
+    for(int iy = 0; iy < bin.grid_h; ++iy)
+    {
+        const T y = bin.start_h + (iy + T(0.5)) * bin.step_h;
+        for(int ix = 0; ix < bin.grid_w; ++ix)
+        {
+            const T x = bin.start_w + (ix + T(0.5)) * bin.step_w;
+            if(BilinearCoefficients(height, width, y, x, pos, w))
+            {
+                for(int k = 0; k < 4; ++k)
+                {
+                    gpu_atomic_add(static_cast<T>(w[k] * g), diff + pos[k]);
+                }
+            }
+        }
+    }
+}
+
+// Same as RoIAlignFPNLevel in roi_align_op.h.
+template <typename T>
+__device__ int RoIAlignFPNLevelDevice(
+    const T* roi, const int min_level, const int max_level, const T canonical_scale, const int canonical_level)
+{
+    const T area  = (roi[3] - roi[1] + T(1)) * (roi[4] - roi[2] + T(1));
+    const T scale = sqrt(area > T(0) ? area : T(0));
+    const int level =
+        static_cast<int>(floor(canonical_level + log2(scale / canonical_scale + T(1e-6))));
+    return min(max(level, min_level), max_level);
+}
+
+template <typename T>
+__global__ void RoIAlignForward(const int nthreads,
+                                const T* bottom_data,
+                                const T spatial_scale,
+                                const int channels,
+                                const int height,
+                                const int width,
+                                const int pooled_height,
+                                const int pooled_width,
+                                const int sampling_ratio,
+                                const T* bottom_rois,
+                                T* top_data)
+{
+    HIP_1D_KERNEL_LOOP(index, nthreads)
+    {
+        // (n, c, ph, pw) is an element in the pooled output
+        int pw = index % pooled_width;
+        int ph = (index / pooled_width) % pooled_height;
+        int c  = (index / pooled_width / pooled_height) % channels;
+        int n  = index / pooled_width / pooled_height / channels;
+
+        const T* offset_bottom_rois = bottom_rois + n * 5;
+        int roi_batch_ind           = offset_bottom_rois[0];
+        const RoIAlignBin<T> bin    = MakeRoIAlignBin(
+            offset_bottom_rois, spatial_scale, pooled_height, pooled_width, sampling_ratio, ph, pw);
+        const T* offset_bottom_data = bottom_data + (roi_batch_ind * channels + c) * height * width;
+        top_data[index]             = RoIAlignBinForward(bin, offset_bottom_data, height, width);
+    }
+}
+
+template <typename T>
+__global__ void RoIAlignBackward(const int nthreads,
+                                 const T* top_diff,
+                                 const T spatial_scale,
+                                 const int channels,
+                                 const int height,
+                                 const int width,
+                                 const int pooled_height,
+                                 const int pooled_width,
+                                 const int sampling_ratio,
+                                 T* bottom_diff,
+                                 const T* bottom_rois)
+{
+    HIP_1D_KERNEL_LOOP(index, nthreads)
+    {
+        // (n, c, ph, pw) is an element in the pooled output
+        int pw = index % pooled_width;
+        int ph = (index / pooled_width) % pooled_height;
+        int c  = (index / pooled_width / pooled_height) % channels;
+        int n  = index / pooled_width / pooled_height / channels;
+
+        const T* offset_bottom_rois = bottom_rois + n * 5;
+        int roi_batch_ind           = offset_bottom_rois[0];
+        const RoIAlignBin<T> bin    = MakeRoIAlignBin(
+            offset_bottom_rois, spatial_scale, pooled_height, pooled_width, sampling_ratio, ph, pw);
+        T* offset_bottom_diff = bottom_diff + (roi_batch_ind * channels + c) * height * width;
+        RoIAlignBinBackward(bin, top_diff[index], height, width, offset_bottom_diff);
+    }
+}
+
+// The feature maps of all pyramid levels, passed by value so that a single
+// launch can pool from any of them.
+template <typename T>
+struct RoIAlignLevels
+{
+    T* data[kRoIAlignMaxLevels];
+    int height[kRoIAlignMaxLevels];
+    int width[kRoIAlignMaxLevels];
+};
+
+struct RoIAlignFPNArgs
+{
+    int min_level;
+    int max_level;
+    float canonical_scale;
+    int canonical_level;
+};
+
+template <typename T>
+__global__ void MultiLevelRoIAlignForward(const int nthreads,
+                                          const RoIAlignLevels<const T> levels,
+                                          const RoIAlignFPNArgs fpn,
+                                          const int channels,
+                                          const int pooled_height,
+                                          const int pooled_width,
+                                          const int sampling_ratio,
+                                          const T* bottom_rois,
+                                          T* top_data)
+{
+    HIP_1D_KERNEL_LOOP(index, nthreads)
+    {
+        // (n, c, ph, pw) is an element in the pooled output
+        int pw = index % pooled_width;
+        int ph = (index / pooled_width) % pooled_height;
+        int c  = (index / pooled_width / pooled_height) % channels;
+        int n  = index / pooled_width / pooled_height / channels;
+
+        const T* offset_bottom_rois = bottom_rois + n * 5;
+        int roi_batch_ind           = offset_bottom_rois[0];
+        const int level             = RoIAlignFPNLevelDevice(offset_bottom_rois,
+                                                 fpn.min_level,
+                                                 fpn.max_level,
+                                                 static_cast<T>(fpn.canonical_scale),
+                                                 fpn.canonical_level);
+        const int l                 = level - fpn.min_level;
+        const RoIAlignBin<T> bin    = MakeRoIAlignBin(offset_bottom_rois,
+                                                   T(1) / (1 << level),
+                                                   pooled_height,
+                                                   pooled_width,
+                                                   sampling_ratio,
+                                                   ph,
+                                                   pw);
+        const int height            = levels.height[l];
+        const int width             = levels.width[l];
+        const T* offset_bottom_data =
+            levels.data[l] + (roi_batch_ind * channels + c) * height * width;
+        top_data[index] = RoIAlignBinForward(bin, offset_bottom_data, height, width);
+    }
+}
+
+template <typename T>
+__global__ void MultiLevelRoIAlignBackward(const int nthreads,
+                                           const T* top_diff,
+                                           const RoIAlignFPNArgs fpn,
+                                           const int channels,
+                                           const int pooled_height,
+                                           const int pooled_width,
+                                           const int sampling_ratio,
+                                           RoIAlignLevels<T> diffs,
+                                           const T* bottom_rois)
+{
+    HIP_1D_KERNEL_LOOP(index, nthreads)
+    {
+        // (n, c, ph, pw) is an element in the pooled output
+        int pw = index % pooled_width;
+        int ph = (index / pooled_width) % pooled_height;
+        int c  = (index / pooled_width / pooled_height) % channels;
+        int n  = index / pooled_width / pooled_height / channels;
+
+        const T* offset_bottom_rois = bottom_rois + n * 5;
+        int roi_batch_ind           = offset_bottom_rois[0];
+        const int level             = RoIAlignFPNLevelDevice(offset_bottom_rois,
+                                                 fpn.min_level,
+                                                 fpn.max_level,
+                                                 static_cast<T>(fpn.canonical_scale),
+                                                 fpn.canonical_level);
+        const int l                 = level - fpn.min_level;
+        const RoIAlignBin<T> bin    = MakeRoIAlignBin(offset_bottom_rois,
+                                                   T(1) / (1 << level),
+                                                   pooled_height,
+                                                   pooled_width,
+                                                   sampling_ratio,
+                                                   ph,
+                                                   pw);
+        const int height      = diffs.height[l];
+        const int width       = diffs.width[l];
+        T* offset_bottom_diff = diffs.data[l] + (roi_batch_ind * channels + c) * height * width;
+        RoIAlignBinBackward(bin, top_diff[index], height, width, offset_bottom_diff);
+    }
+}
+
+} // namespace
+
+template <>
+bool RoIAlignOp<float, HIPContext>::RunOnDevice()
+{
+    auto& X = Input(0);  // Input data to pool
+    auto& R = Input(1);  // RoIs
+    auto* Y = Output(0); // RoI pooled data
+
+    // Handle empty rois
+    if(R.size() == 0)
+    {
+        Y->Resize(0, X.dim32(1), pooled_height_, pooled_width_);
+        // mutable_data calls are needed to allocate the tensors
+        Y->mutable_data<float>();
+        return true;
+    }
+
+    CAFFE_ENFORCE_EQ(R.dim32(1), 5);
+    Y->Resize(R.dim32(0), X.dim32(1), pooled_height_, pooled_width_);
+    int output_size = Y->size();
+    hipLaunchKernelGGL((RoIAlignForward<float>),
+                       dim3(CAFFE_GET_BLOCKS(output_size)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       output_size,
+                       X.data<float>(),
+                       spatial_scale_,
+                       X.dim32(1),
+                       X.dim32(2),
+                       X.dim32(3),
+                       pooled_height_,
+                       pooled_width_,
+                       sampling_ratio_,
+                       R.data<float>(),
+                       Y->mutable_data<float>());
+    return true;
+}
+
+template <>
+bool RoIAlignGradientOp<float, HIPContext>::RunOnDevice()
+{
+    auto& X  = Input(0); // Input data to pool
+    auto& R  = Input(1); // RoIs
+    auto& dY = Input(2); // Gradient of net w.r.t. output of "forward" op
+    // (aka "gradOutput")
+    auto* dX = Output(0); // Gradient of net w.r.t. input to "forward" op
+    // (aka "gradInput")
+
+    dX->ResizeLike(X);
+    // Must zero-out dX before accumulating gradients
+    math::Set<float, HIPContext>(dX->size(), 0.f, dX->mutable_data<float>(), &context_);
+    if(dY.size() > 0)
+    { // Handle possibly empty gradient if there were no rois
+        hipLaunchKernelGGL((RoIAlignBackward<float>),
+                           dim3(CAFFE_GET_BLOCKS(dY.size())),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           dY.size(),
+                           dY.data<float>(),
+                           spatial_scale_,
+                           X.dim32(1),
+                           X.dim32(2),
+                           X.dim32(3),
+                           pooled_height_,
+                           pooled_width_,
+                           sampling_ratio_,
+                           dX->mutable_data<float>(),
+                           R.data<float>());
+    }
+    return true;
+}
+
+template <>
+bool MultiLevelRoIAlignOp<float, HIPContext>::RunOnDevice()
+{
+    const int num_levels = max_level_ - min_level_ + 1;
+    auto& X0             = Input(0);
+    auto& R              = Input(num_levels);
+    auto* Y              = Output(0);
+
+    RoIAlignLevels<const float> levels;
+    for(int l = 0; l < num_levels; ++l)
+    {
+        auto& X = Input(l);
+        CAFFE_ENFORCE_EQ(X.ndim(), 4);
+        CAFFE_ENFORCE_EQ(X.dim32(0), X0.dim32(0));
+        CAFFE_ENFORCE_EQ(X.dim32(1), X0.dim32(1));
+        levels.data[l]   = X.data<float>();
+        levels.height[l] = X.dim32(2);
+        levels.width[l]  = X.dim32(3);
+    }
+
+    // Handle empty rois
+    if(R.size() == 0)
+    {
+        Y->Resize(0, X0.dim32(1), pooled_height_, pooled_width_);
+        Y->mutable_data<float>();
+        return true;
+    }
+
+    CAFFE_ENFORCE_EQ(R.dim32(1), 5);
+    Y->Resize(R.dim32(0), X0.dim32(1), pooled_height_, pooled_width_);
+    const RoIAlignFPNArgs fpn{min_level_, max_level_, canonical_scale_, canonical_level_};
+    int output_size = Y->size();
+    hipLaunchKernelGGL((MultiLevelRoIAlignForward<float>),
+                       dim3(CAFFE_GET_BLOCKS(output_size)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       output_size,
+                       levels,
+                       fpn,
+                       X0.dim32(1),
+                       pooled_height_,
+                       pooled_width_,
+                       sampling_ratio_,
+                       R.data<float>(),
+                       Y->mutable_data<float>());
+    return true;
+}
+
+template <>
+bool MultiLevelRoIAlignGradientOp<float, HIPContext>::RunOnDevice()
+{
+    const int num_levels = max_level_ - min_level_ + 1;
+    auto& R              = Input(num_levels);
+    auto& dY             = Input(num_levels + 1);
+
+    RoIAlignLevels<float> diffs;
+    for(int l = 0; l < num_levels; ++l)
+    {
+        auto& X  = Input(l);
+        auto* dX = Output(l);
+        dX->ResizeLike(X);
+        // Must zero-out dX before accumulating gradients
+        math::Set<float, HIPContext>(dX->size(), 0.f, dX->mutable_data<float>(), &context_);
+        diffs.data[l]   = dX->mutable_data<float>();
+        diffs.height[l] = X.dim32(2);
+        diffs.width[l]  = X.dim32(3);
+    }
+    if(dY.size() > 0)
+    { // Handle possibly empty gradient if there were no rois
+        const RoIAlignFPNArgs fpn{min_level_, max_level_, canonical_scale_, canonical_level_};
+        hipLaunchKernelGGL((MultiLevelRoIAlignBackward<float>),
+                           dim3(CAFFE_GET_BLOCKS(dY.size())),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           dY.size(),
+                           dY.data<float>(),
+                           fpn,
+                           Input(0).dim32(1),
+                           pooled_height_,
+                           pooled_width_,
+                           sampling_ratio_,
+                           diffs,
+                           R.data<float>());
+    }
+    return true;
+}
+
+REGISTER_HIP_OPERATOR(RoIAlign, RoIAlignOp<float, HIPContext>);
+REGISTER_HIP_OPERATOR(RoIAlignGradient, RoIAlignGradientOp<float, HIPContext>);
+REGISTER_HIP_OPERATOR(MultiLevelRoIAlign, MultiLevelRoIAlignOp<float, HIPContext>);
+REGISTER_HIP_OPERATOR(MultiLevelRoIAlignGradient, MultiLevelRoIAlignGradientOp<float, HIPContext>);
+
+} // namespace caffe2
@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <initializer_list>
+
+#include "caffe2/core/common_hip.h"
+#include "hip/hip_runtime.h"
+
+namespace caffe2 {
+
+/**
+ * Helpers for kernels that move or reduce whole rows (Gather, ScatterAssign,
+ * BatchGather, the row normalizations and sums, ...). A row is copied in
+ * words of up to 16 bytes, a block covers several narrow rows at once, or up
+ * to all its threads for a wide one: hipThreadIdx_x runs along a row and
+ * hipThreadIdx_y over the block's rows.
+ */
+
+// Widest word of 16, 8, 4, 2 or 1 bytes dividing the row size in bytes and
+// all the base addresses.
+inline int RowCopyWordSize(size_t row_bytes, std::initializer_list<const void*> ptrs)
+{
+    int word_size = 16;
+    auto fit      = [&word_size](size_t n) {
+        while(n % word_size != 0)
+        {
+            word_size /= 2;
+        }
+    };
+    fit(row_bytes);
+    for(const void* p : ptrs)
+    {
+        fit(reinterpret_cast<uintptr_t>(p));
+    }
+    return word_size;
+}
+
+inline dim3 RowCopyBlock(TIndex row_words)
+{
+    int threads_per_row = 1;
+    while(threads_per_row < row_words && threads_per_row < CAFFE_HIP_NUM_THREADS)
+    {
+        threads_per_row *= 2;
+    }
+    return dim3(threads_per_row, CAFFE_HIP_NUM_THREADS / threads_per_row);
+}
+
+inline dim3 RowCopyGrid(TIndex num_rows, const dim3& block)
+{
+    return dim3(std::min<TIndex>((num_rows + block.y - 1) / block.y, CAFFE_MAXIMUM_NUM_BLOCKS));
+}
+
+#define HIP_ROW_LOOP(row, num_rows)                                  \
+    for(TIndex row = hipBlockIdx_x * hipBlockDim_y + hipThreadIdx_y; \
+        row < (num_rows);                                            \
+        row += hipGridDim_x * hipBlockDim_y)
+
+#define HIP_ROW_WORD_LOOP(j, row_words) \
+    for(TIndex j = hipThreadIdx_x; j < (row_words); j += hipBlockDim_x)
+
+// Reduces v over the threads of each row of the block, all of them get the
+// result. shared holds a V per thread of the block. Every thread of the block
+// has to call it, hipBlockDim_x is a power of two.
+template <typename V, typename Reduce>
+__device__ V RowAllReduce(V v, V* shared, Reduce reduce)
+{
+    V* row_shared              = shared + hipThreadIdx_y * hipBlockDim_x;
+    row_shared[hipThreadIdx_x] = v;
+    __syncthreads();
+    for(int stride = hipBlockDim_x / 2; stride > 0; stride /= 2)
+    {
+        if(hipThreadIdx_x < stride)
+        {
+            row_shared[hipThreadIdx_x] =
+                reduce(row_shared[hipThreadIdx_x], row_shared[hipThreadIdx_x + stride]);
+        }
+        __syncthreads();
+    }
+    const V result = row_shared[0];
+    __syncthreads();
+    return result;
+}
+
+// Expands LAUNCH(W) with W the word type of word_size bytes.
+#define DISPATCH_ROW_COPY_WORD(word_size, LAUNCH) \
+    switch(word_size)                             \
+    {                                             \
+    case 16: LAUNCH(uint4); break;                \
+    case 8: LAUNCH(uint2); break;                 \
+    case 4: LAUNCH(uint32_t); break;              \
+    case 2: LAUNCH(uint16_t); break;              \
+    default: LAUNCH(uint8_t); break;              \
+    }
+
+} // namespace caffe2
@@ -0,0 +1,260 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "caffe2/core/common_hip.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/row_copy_hip.h"
+#include "caffe2/utils/welford.h"
+#include "hip/hip_runtime.h"
+
+namespace caffe2 {
+
+/**
+ * Kernels normalizing the rows of a rows x cols matrix by their own mean and
+ * standard deviation, shared by LayerNorm and GroupNorm, whose rows are the
+ * groups of channels of a sample. The statistics come from a single Welford
+ * pass, so the input is read once for them and once for the output.
+ *
+ * Blocks are laid out as in row_copy_hip.h: the hipThreadIdx_x threads of a
+ * row reduce together, so a narrow row is done by a few lanes of a wavefront
+ * and a wide one by the whole block.
+ *
+ * With kAffine, element j of row r (sample r / groups, group r % groups) is
+ * in channel (r % groups) * (cols / inner) + j / inner, whose gamma and beta
+ * are applied.
+ */
+
+struct FloatPair
+{
+    float a;
+    float b;
+};
+
+struct WelfordCombine
+{
+    __device__ WelfordMoments<float> operator()(WelfordMoments<float> x,
+                                                const WelfordMoments<float>& y) const
+    {
+        x.Combine(y);
+        return x;
+    }
+};
+
+struct FloatPairSum
+{
+    __device__ FloatPair operator()(const FloatPair& x, const FloatPair& y) const
+    {
+        FloatPair sum = {x.a + y.a, x.b + y.b};
+        return sum;
+    }
+};
+
+template <bool kAffine>
+__device__ inline TIndex RowNormChannel(const TIndex row,
+                                        const TIndex j,
+                                        const TIndex cols,
+                                        const int groups,
+                                        const TIndex inner)
+{
+    return (row % groups) * (cols / inner) + j / inner;
+}
+
+// Y = (X - mean) / stdev, then gamma and beta with kAffine.
+template <bool kAffine>
+__global__ void RowNormalizeKernel(const TIndex rows,
+                                   const TIndex cols,
+                                   const float epsilon,
+                                   const int groups,
+                                   const TIndex inner,
+                                   const float* gamma,
+                                   const float* beta,
+                                   const float* X,
+                                   float* mean,
+                                   float* stdev,
+                                   float* Y)
+{
+    __shared__ WelfordMoments<float> shared[CAFFE_HIP_NUM_THREADS];
+    for(TIndex row_base = hipBlockIdx_x * hipBlockDim_y; row_base < rows;
+        row_base += hipGridDim_x * hipBlockDim_y)
+    {
+        const TIndex row = row_base + hipThreadIdx_y;
+        const bool valid = row < rows;
+        const float* x   = X + row * cols;
+
+        WelfordMoments<float> moments = {0.f, 0.f, 0.f};
+        if(valid)
+        {
+            HIP_ROW_WORD_LOOP(j, cols) { moments.Update(x[j]); }
+        }
+        moments = RowAllReduce(moments, shared, WelfordCombine());
+        if(!valid)
+        {
+            continue;
+        }
+
+        const float sigma = sqrtf(moments.Variance() + epsilon);
+        if(hipThreadIdx_x == 0)
+        {
+            mean[row]  = moments.mean;
+            stdev[row] = sigma;
+        }
+        const float inv_sigma = 1.f / sigma;
+        float* y              = Y + row * cols;
+        HIP_ROW_WORD_LOOP(j, cols)
+        {
+            float v = (x[j] - moments.mean) * inv_sigma;
+            if(kAffine)
+            {
+                const TIndex c = RowNormChannel<kAffine>(row, j, cols, groups, inner);
+                v              = v * gamma[c] + beta[c];
+            }
+            y[j] = v;
+        }
+    }
+}
+
+// With xhat = (x - mean) / stdev and g = dy * gamma (dy without kAffine),
+// dx = (g - mean(g) - xhat * mean(g * xhat)) / stdev, both means taken in one
+// pass over the row.
+template <bool kAffine>
+__global__ void RowNormalizeGradientKernel(const TIndex rows,
+                                           const TIndex cols,
+                                           const int groups,
+                                           const TIndex inner,
+                                           const float* gamma,
+                                           const float* dY,
+                                           const float* X,
+                                           const float* mean,
+                                           const float* stdev,
+                                           float* dX)
+{
+    __shared__ FloatPair shared[CAFFE_HIP_NUM_THREADS];
+    for(TIndex row_base = hipBlockIdx_x * hipBlockDim_y; row_base < rows;
+        row_base += hipGridDim_x * hipBlockDim_y)
+    {
+        const TIndex row      = row_base + hipThreadIdx_y;
+        const bool valid      = row < rows;
+        const float* x        = X + row * cols;
+        const float* dy       = dY + row * cols;
+        const float mu        = valid ? mean[row] : 0.f;
+        const float inv_sigma = valid ? 1.f / stdev[row] : 0.f;
+
+        FloatPair sums = {0.f, 0.f};
+        if(valid)
+        {
+            HIP_ROW_WORD_LOOP(j, cols)
+            {
+                const float g = kAffine
+                                    ? dy[j] * gamma[RowNormChannel<kAffine>(row, j, cols, groups, inner)]
+                                    : dy[j];
+                sums.a += g;
+                sums.b += g * (x[j] - mu) * inv_sigma;
+            }
+        }
+        sums = RowAllReduce(sums, shared, FloatPairSum());
+        if(!valid)
+        {
+            continue;
+        }
+
+        const float g_mean  = sums.a / cols;
+        const float gx_mean = sums.b / cols;
+        float* dx           = dX + row * cols;
+        HIP_ROW_WORD_LOOP(j, cols)
+        {
+            const float g = kAffine
+                                ? dy[j] * gamma[RowNormChannel<kAffine>(row, j, cols, groups, inner)]
+                                : dy[j];
+            dx[j] = (g - g_mean - (x[j] - mu) * inv_sigma * gx_mean) * inv_sigma;
+        }
+    }
+}
+
+template <bool kAffine>
+void LaunchRowNormalize(const TIndex rows,
+                        const TIndex cols,
+                        const float epsilon,
+                        const int groups,
+                        const TIndex inner,
+                        const float* gamma,
+                        const float* beta,
+                        const float* X,
+                        float* mean,
+                        float* stdev,
+                        float* Y,
+                        HIPContext* context)
+{
+    if(rows == 0)
+    {
+        return;
+    }
+    const dim3 block = RowCopyBlock(cols);
+    hipLaunchKernelGGL((RowNormalizeKernel<kAffine>),
+                       RowCopyGrid(rows, block),
+                       block,
+                       0,
+                       context->hip_stream(),
+                       rows,
+                       cols,
+                       epsilon,
+                       groups,
+                       inner,
+                       gamma,
+                       beta,
+                       X,
+                       mean,
+                       stdev,
+                       Y);
+}
+
+template <bool kAffine>
+void LaunchRowNormalizeGradient(const TIndex rows,
+                                const TIndex cols,
+                                const int groups,
+                                const TIndex inner,
+                                const float* gamma,
+                                const float* dY,
+                                const float* X,
+                                const float* mean,
+                                const float* stdev,
+                                float* dX,
+                                HIPContext* context)
+{
+    if(rows == 0 || cols == 0)
+    {
+        return;
+    }
+    const dim3 block = RowCopyBlock(cols);
+    hipLaunchKernelGGL((RowNormalizeGradientKernel<kAffine>),
+                       RowCopyGrid(rows, block),
+                       block,
+                       0,
+                       context->hip_stream(),
+                       rows,
+                       cols,
+                       groups,
+                       inner,
+                       gamma,
+                       dY,
+                       X,
+                       mean,
+                       stdev,
+                       dX);
+}
+
+} // namespace caffe2
@@ -0,0 +1,326 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/sampled_softmax_with_loss_op.h"
+
+#include <cfloat>
+#include <random>
+
+namespace caffe2 {
+
+namespace {
+
+// Log of the expected number of times the class is drawn by num_sampled
+// draws from the log-uniform (Zipfian) distribution over range classes:
+// P(id) = log((id + 2) / (id + 1)) / log(range + 1).
+inline float LogExpectedCount(int id, int num_sampled, int range) {
+  return std::log(
+      num_sampled * std::log1p(1.f / (id + 1)) / std::log(range + 1.f));
+}
+
+} // namespace
+
+template <>
+bool SampledSoftmaxWithLossOp<float, CPUContext>::RunOnDevice() {
+  const auto& X = Input(0);
+  const auto& W = Input(1);
+  const auto& b = Input(2);
+  const auto& labels = Input(3);
+  auto* avg_loss = Output(0);
+  auto* P = Output(1);
+  auto* sampled = Output(2);
+
+  CAFFE_ENFORCE_EQ(X.ndim(), 2);
+  CAFFE_ENFORCE_EQ(W.ndim(), 2);
+  const int N = X.dim32(0);
+  const int K = X.dim32(1);
+  const int V = W.dim32(0);
+  CAFFE_ENFORCE_EQ(W.dim32(1), K);
+  CAFFE_ENFORCE_EQ(b.size(), V);
+  CAFFE_ENFORCE_EQ(labels.size(), N);
+  const int S = InputSize() > 4 ? Input(4).size() : num_sampled_;
+  CAFFE_ENFORCE_GT(S, 0, "num_sampled must be positive");
+
+  sampled->Resize(S);
+  int* sampled_data = sampled->mutable_data<int>();
+  if (InputSize() > 4) {
+    context_.Copy<int, CPUContext, CPUContext>(
+        S, Input(4).data<int>(), sampled_data);
+  } else {
+    std::uniform_real_distribution<float> dist(0.f, 1.f);
+    const float log_range = std::log(V + 1.f);
+    for (int s = 0; s < S; ++s) {
+      const float u = dist(context_.RandGenerator());
+      const int id = static_cast<int>(std::exp(u * log_range)) - 1;
+      sampled_data[s] = std::min(std::max(id, 0), V - 1);
+    }
+  }
+
+  const float* Xdata = X.data<float>();
+  const float* Wdata = W.data<float>();
+  const float* bdata = b.data<float>();
+  const int* label_data = labels.data<int>();
+  sampled_weights_.Resize(S, K);
+  float* sampled_weights_data = sampled_weights_.mutable_data<float>();
+  for (int s = 0; s < S; ++s) {
+    CAFFE_ENFORCE(
+        sampled_data[s] >= 0 && sampled_data[s] < V,
+        "Sampled class out of range: ",
+        sampled_data[s]);
+    context_.Copy<float, CPUContext, CPUContext>(
+        K, Wdata + sampled_data[s] * K, sampled_weights_data + s * K);
+  }
+  logits_.Resize(N, S);
+  math::Gemm<float, CPUContext>(
+      CblasNoTrans,
+      CblasTrans,
+      N,
+      S,
+      K,
+      1,
+      Xdata,
+      sampled_weights_data,
+      0,
+      logits_.mutable_data<float>(),
+      &context_);
+
+  // Column 0 holds the true class, columns 1..S the sampled ones.
+  P->Resize(N, S + 1);
+  float* Pdata = P->mutable_data<float>();
+  const float* logits_data = logits_.data<float>();
+  float loss_sum = 0;
+  for (int i = 0; i < N; ++i) {
+    const int label = label_data[i];
+    CAFFE_ENFORCE(
+        label >= 0 && label < V,
+        "Label seems incorrect: label value larger than number of classes: ",
+        label,
+        " vs ",
+        V);
+    float* Prow = Pdata + i * (S + 1);
+    float dot = 0;
+    math::Dot<float, CPUContext>(
+        K, Xdata + i * K, Wdata + label * K, &dot, &context_);
+    Prow[0] = dot + bdata[label] - LogExpectedCount(label, S, V);
+    float rowmax = Prow[0];
+    for (int s = 0; s < S; ++s) {
+      const int id = sampled_data[s];
+      Prow[s + 1] = remove_accidental_hits_ && id == label
+          ? -FLT_MAX
+          : logits_data[i * S + s] + bdata[id] - LogExpectedCount(id, S, V);
+      rowmax = std::max(rowmax, Prow[s + 1]);
+    }
+    float sum = 0;
+    for (int j = 0; j <= S; ++j) {
+      Prow[j] = std::exp(Prow[j] - rowmax);
+      sum += Prow[j];
+    }
+    loss_sum += std::log(sum) - std::log(Prow[0]);
+    for (int j = 0; j <= S; ++j) {
+      Prow[j] /= sum;
+    }
+  }
+
+  avg_loss->Resize(vector<TIndex>());
+  avg_loss->mutable_data<float>()[0] = N > 0 ? loss_sum / N : 0;
+  return true;
+}
+
+template <>
+bool SampledSoftmaxWithLossGradientOp<float, CPUContext>::RunOnDevice() {
+  const auto& X = Input(0);
+  const auto& W = Input(1);
+  const auto& labels = Input(2);
+  const auto& sampled = Input(3);
+  const auto& P = Input(4);
+  const auto& d_avg_loss = Input(5);
+  auto* dX = Output(0);
+  auto* dW_indices = Output(1);
+  auto* dW_values = Output(2);
+  auto* db_values = Output(3);
+
+  const int N = X.dim32(0);
+  const int K = X.dim32(1);
+  const int S = sampled.size();
+  CAFFE_ENFORCE_EQ(P.size(), N * (S + 1));
+
+  const float* Xdata = X.data<float>();
+  const float* Wdata = W.data<float>();
+  const float* Pdata = P.data<float>();
+  const int* label_data = labels.data<int>();
+  const int* sampled_data = sampled.data<int>();
+  const float scale = N > 0 ? d_avg_loss.data<float>()[0] / N : 0;
+
+  // Gradient w.r.t. the logits: P - onehot(0).
+  label_grad_.Resize(N);
+  sampled_grad_.Resize(N, S);
+  float* label_grad_data = label_grad_.mutable_data<float>();
+  float* sampled_grad_data = sampled_grad_.mutable_data<float>();
+  for (int i = 0; i < N; ++i) {
+    label_grad_data[i] = (Pdata[i * (S + 1)] - 1) * scale;
+    for (int s = 0; s < S; ++s) {
+      sampled_grad_data[i * S + s] = Pdata[i * (S + 1) + s + 1] * scale;
+    }
+  }
+
+  sampled_weights_.Resize(S, K);
+  float* sampled_weights_data = sampled_weights_.mutable_data<float>();
+  for (int s = 0; s < S; ++s) {
+    context_.Copy<float, CPUContext, CPUContext>(
+        K, Wdata + sampled_data[s] * K, sampled_weights_data + s * K);
+  }
+
+  // dX = dL_sampled * W_sampled + dL_label * W_label
+  dX->ResizeLike(X);
+  float* dXdata = dX->mutable_data<float>();
+  math::Gemm<float, CPUContext>(
+      CblasNoTrans,
+      CblasNoTrans,
+      N,
+      K,
+      S,
+      1,
+      sampled_grad_data,
+      sampled_weights_data,
+      0,
+      dXdata,
+      &context_);
+
+  // Sparse gradients of W and b: the rows of the true classes come first,
+  // then the rows of the sampled classes.
+  dW_indices->Resize(N + S);
+  int* dW_indices_data = dW_indices->mutable_data<int>();
+  context_.Copy<int, CPUContext, CPUContext>(N, label_data, dW_indices_data);
+  context_.Copy<int, CPUContext, CPUContext>(
+      S, sampled_data, dW_indices_data + N);
+  dW_values->Resize(N + S, K);
+  float* dW_values_data = dW_values->mutable_data<float>();
+  db_values->Resize(N + S);
+  float* db_values_data = db_values->mutable_data<float>();
+  for (int i = 0; i < N; ++i) {
+    math::Axpy<float, CPUContext>(
+        K,
+        label_grad_data[i],
+        Wdata + label_data[i] * K,
+        dXdata + i * K,
+        &context_);
+    math::Scale<float, CPUContext>(
+        K,
+        label_grad_data[i],
+        Xdata + i * K,
+        dW_values_data + i * K,
+        &context_);
+    db_values_data[i] = label_grad_data[i];
+  }
+  math::Gemm<float, CPUContext>(
+      CblasTrans,
+      CblasNoTrans,
+      S,
+      K,
+      N,
+      1,
+      sampled_grad_data,
+      Xdata,
+      0,
+      dW_values_data + N * K,
+      &context_);
+  for (int s = 0; s < S; ++s) {
+    float sum = 0;
+    for (int i = 0; i < N; ++i) {
+      sum += sampled_grad_data[i * S + s];
+    }
+    db_values_data[N + s] = sum;
+  }
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(
+    SampledSoftmaxWithLoss,
+    SampledSoftmaxWithLossOp<float, CPUContext>);
+REGISTER_CPU_OPERATOR(
+    SampledSoftmaxWithLossGradient,
+    SampledSoftmaxWithLossGradientOp<float, CPUContext>);
+
+OPERATOR_SCHEMA(SampledSoftmaxWithLoss)
+    .NumInputs(4, 5)
+    .NumOutputs(3)
+    .TensorInferenceFunction(
+        [](const OperatorDef& def, const vector<TensorShape>& in) {
+          ArgumentHelper helper(def);
+          const int num_sampled = in.size() > 4
+              ? size_from_dim_(0, GetDimsVector(in[4]))
+              : helper.GetSingleArgument<int>("num_sampled", 0);
+          vector<TensorShape> out(3);
+          out[0].set_data_type(in[0].data_type());
+          out[1].set_data_type(in[0].data_type());
+          out[1].add_dims(in[0].dims(0));
+          out[1].add_dims(num_sampled + 1);
+          out[2].set_data_type(TensorProto::INT32);
+          out[2].add_dims(num_sampled);
+          return out;
+        })
+    .SetDoc(R"DOC(
+Sampled softmax cross-entropy loss of a fully connected output layer, for
+very large numbers of classes. Instead of the logits of all the classes, only
+the logits of the true class and of num_sampled classes drawn from the
+log-uniform (Zipfian) distribution P(c) = log((c + 2) / (c + 1)) / log(V + 1)
+are computed, so the cost scales with num_sampled instead of V. This assumes
+that the classes are sorted by decreasing frequency. The samples are shared by
+the whole batch, and the logits are corrected by the log of the expected count
+of their class.
+The gradients of W and b are sparse (GradientSlice) over the true and sampled
+classes.
+)DOC")
+    .Arg("num_sampled", "Number of classes to sample per run")
+    .Arg(
+        "remove_accidental_hits",
+        "Whether sampled classes that match the true class of an example are "
+        "ignored for that example. Defaults to 1")
+    .Input(0, "X", "Input of the output layer, N x K")
+    .Input(1, "W", "Weights of the output layer, V x K")
+    .Input(2, "b", "Bias of the output layer, V")
+    .Input(3, "labels", "True classes, N int32")
+    .Input(
+        4,
+        "sampled",
+        "Optional int32 classes to use instead of drawing num_sampled ones")
+    .Output(0, "loss", "Average loss")
+    .Output(
+        1,
+        "softmax",
+        "Softmax over the true (column 0) and sampled classes, N x "
+        "(num_sampled + 1)")
+    .Output(2, "sampled", "Sampled classes, num_sampled int32");
+
+// Input: X, W, labels, sampled, P, dY; Output: dX, dW/db indices, dW, db
+OPERATOR_SCHEMA(SampledSoftmaxWithLossGradient).NumInputs(6).NumOutputs(4);
+
+class GetSampledSoftmaxWithLossGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    auto defs = SingleGradientDef(
+        "SampledSoftmaxWithLossGradient",
+        "",
+        vector<string>{I(0), I(1), I(3), O(2), O(1), GO(0)},
+        vector<string>{GI(0), GI_I(1), GI_V(1), GI_V(2)});
+    // W and b share the indices of their slices.
+    SetSparse(2, GI_I(1), GI_V(2));
+    return defs;
+  }
+};
+REGISTER_GRADIENT(SampledSoftmaxWithLoss, GetSampledSoftmaxWithLossGradient);
+
+} // namespace caffe2
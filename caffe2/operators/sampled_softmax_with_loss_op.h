@@ -0,0 +1,68 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_OPERATORS_SAMPLED_SOFTMAX_WITH_LOSS_OP_H_
+#define CAFFE2_OPERATORS_SAMPLED_SOFTMAX_WITH_LOSS_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+template <typename T, class Context>
+class SampledSoftmaxWithLossOp final : public Operator<Context> {
+ public:
+  SampledSoftmaxWithLossOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        num_sampled_(OperatorBase::GetSingleArgument<int>("num_sampled", 0)),
+        remove_accidental_hits_(OperatorBase::GetSingleArgument<bool>(
+            "remove_accidental_hits",
+            true)) {}
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+
+  bool RunOnDevice() override;
+
+ protected:
+  int num_sampled_;
+  bool remove_accidental_hits_;
+
+  Tensor<Context> sampled_weights_; // Rows of W of the sampled classes
+  Tensor<Context> logits_; // X * sampled_weights_'
+  Tensor<Context> losses_; // Per example loss
+  Tensor<Context> uniforms_;
+  Tensor<Context> scratch_;
+};
+
+template <typename T, class Context>
+class SampledSoftmaxWithLossGradientOp final : public Operator<Context> {
+ public:
+  SampledSoftmaxWithLossGradientOp(const OperatorDef& def, Workspace* ws)
+      : Operator<Context>(def, ws) {}
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+
+  bool RunOnDevice() override;
+
+ protected:
+  Tensor<Context> sampled_weights_;
+  Tensor<Context> sampled_grad_; // dLoss/dlogits of the sampled classes
+  Tensor<Context> label_grad_; // dLoss/dlogits of the true classes
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_SAMPLED_SOFTMAX_WITH_LOSS_OP_H_
@@ -0,0 +1,406 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cfloat>
+#include <hipcub/hipcub.hpp>
+#include "hip/hip_runtime.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/sampled_softmax_with_loss_op.h"
+
+namespace caffe2 {
+
+namespace {
+
+// See LogExpectedCount in sampled_softmax_with_loss_op.cc.
+__device__ float LogExpectedCount(int id, int num_sampled, int range)
+{
+    return logf(num_sampled * log1pf(1.f / (id + 1)) / logf(range + 1.f));
+}
+
+__global__ void LogUniformSampleKernel(const int S, const int V, const float* uniforms, int* sampled)
+{
+    const float log_range = logf(V + 1.f);
+    HIP_1D_KERNEL_LOOP(s, S)
+    {
+        const int id = static_cast<int>(expf(uniforms[s] * log_range)) - 1;
+        sampled[s]   = min(max(id, 0), V - 1);
+    }
+}
+
+__global__ void GatherRowsKernel(
+    const int S, const int K, const int* ids, const float* W, float* rows)
+{
+    HIP_1D_KERNEL_LOOP(i, S * K)
+    {
+        const int s = i / K;
+        const int k = i % K;
+        HIP_KERNEL_ASSERT(ids[s] >= 0);
+        rows[i] = W[ids[s] * K + k];
+    }
+}
+
+// One block per example: assembles the corrected logits of the true
+// (column 0) and sampled classes, and computes their softmax and the loss.
+__global__ void SampledSoftmaxKernel(const int S,
+                                     const int K,
+                                     const int V,
+                                     const bool remove_accidental_hits,
+                                     const float* X,
+                                     const float* W,
+                                     const float* b,
+                                     const int* labels,
+                                     const int* sampled,
+                                     const float* logits,
+                                     float* P,
+                                     float* losses)
+{
+    using BlockReduce = hipcub::BlockReduce<float, CAFFE_HIP_NUM_THREADS>;
+    __shared__ typename BlockReduce::TempStorage temp_storage;
+    __shared__ float true_logit;
+    __shared__ float row_max;
+    __shared__ float row_sum;
+
+    const int i     = hipBlockIdx_x;
+    const int label = labels[i];
+    HIP_KERNEL_ASSERT(label >= 0 && label < V);
+    float* Prow = P + i * (S + 1);
+
+    float dot = 0;
+    for(int k = hipThreadIdx_x; k < K; k += hipBlockDim_x)
+    {
+        dot += X[i * K + k] * W[label * K + k];
+    }
+    dot = BlockReduce(temp_storage).Sum(dot);
+    if(hipThreadIdx_x == 0)
+    {
+        true_logit = dot + b[label] - LogExpectedCount(label, S, V);
+        Prow[0]    = true_logit;
+    }
+    __syncthreads();
+
+    float max_val = true_logit;
+    for(int s = hipThreadIdx_x; s < S; s += hipBlockDim_x)
+    {
+        const int id = sampled[s];
+        const float val =
+            remove_accidental_hits && id == label
+                ? -FLT_MAX
+                : logits[i * S + s] + b[id] - LogExpectedCount(id, S, V);
+        Prow[s + 1] = val;
+        max_val     = fmaxf(max_val, val);
+    }
+    max_val = BlockReduce(temp_storage).Reduce(max_val, hipcub::Max());
+    if(hipThreadIdx_x == 0)
+    {
+        row_max = max_val;
+    }
+    __syncthreads();
+
+    float sum = 0;
+    for(int j = hipThreadIdx_x; j <= S; j += hipBlockDim_x)
+    {
+        sum += expf(Prow[j] - row_max);
+    }
+    sum = BlockReduce(temp_storage).Sum(sum);
+    if(hipThreadIdx_x == 0)
+    {
+        row_sum   = sum;
+        losses[i] = logf(sum) - (true_logit - row_max);
+    }
+    __syncthreads();
+
+    for(int j = hipThreadIdx_x; j <= S; j += hipBlockDim_x)
+    {
+        Prow[j] = expf(Prow[j] - row_max) / row_sum;
+    }
+}
+
+// Splits P - onehot(0), scaled by dY / N, into the true and sampled parts.
+__global__ void SampledSoftmaxLogitsGradientKernel(const int N,
+                                                   const int S,
+                                                   const float* P,
+                                                   const float* dY,
+                                                   float* label_grad,
+                                                   float* sampled_grad,
+                                                   float* db_values)
+{
+    const float scale = dY[0] / N;
+    HIP_1D_KERNEL_LOOP(idx, N * (S + 1))
+    {
+        const int i      = idx / (S + 1);
+        const int j      = idx % (S + 1);
+        const float grad = (P[idx] - (j == 0)) * scale;
+        if(j == 0)
+        {
+            label_grad[i] = grad;
+            db_values[i]  = grad;
+        }
+        else
+        {
+            sampled_grad[i * S + j - 1] = grad;
+        }
+    }
+}
+
+// Adds the true class term to dX and writes the true class rows of dW.
+__global__ void SampledSoftmaxLabelGradientKernel(const int N,
+                                                  const int K,
+                                                  const float* X,
+                                                  const float* W,
+                                                  const int* labels,
+                                                  const float* label_grad,
+                                                  float* dX,
+                                                  float* dW_values)
+{
+    HIP_1D_KERNEL_LOOP(idx, N * K)
+    {
+        const int i = idx / K;
+        const int k = idx % K;
+        dX[idx] += label_grad[i] * W[labels[i] * K + k];
+        dW_values[idx] = label_grad[i] * X[idx];
+    }
+}
+
+__global__ void ColumnSumKernel(const int N, const int S, const float* data, float* sums)
+{
+    HIP_1D_KERNEL_LOOP(s, S)
+    {
+        float sum = 0;
+        for(int i = 0; i < N; ++i)
+        {
+            sum += data[i * S + s];
+        }
+        sums[s] = sum;
+    }
+}
+
+} // namespace
+
+template <>
+bool SampledSoftmaxWithLossOp<float, HIPContext>::RunOnDevice()
+{
+    const auto& X      = Input(0);
+    const auto& W      = Input(1);
+    const auto& b      = Input(2);
+    const auto& labels = Input(3);
+    auto* avg_loss     = Output(0);
+    auto* P            = Output(1);
+    auto* sampled      = Output(2);
+
+    CAFFE_ENFORCE_EQ(X.ndim(), 2);
+    CAFFE_ENFORCE_EQ(W.ndim(), 2);
+    const int N = X.dim32(0);
+    const int K = X.dim32(1);
+    const int V = W.dim32(0);
+    CAFFE_ENFORCE_EQ(W.dim32(1), K);
+    CAFFE_ENFORCE_EQ(b.size(), V);
+    CAFFE_ENFORCE_EQ(labels.size(), N);
+    const int S = InputSize() > 4 ? Input(4).size() : num_sampled_;
+    CAFFE_ENFORCE_GT(S, 0, "num_sampled must be positive");
+
+    // The negative classes are drawn on the device, shared by the batch.
+    sampled->Resize(S);
+    int* sampled_data = sampled->mutable_data<int>();
+    if(InputSize() > 4)
+    {
+        context_.Copy<int, HIPContext, HIPContext>(S, Input(4).data<int>(), sampled_data);
+    }
+    else
+    {
+        uniforms_.Resize(S);
+        math::RandUniform<float, HIPContext>(
+            S, 0.f, 1.f, uniforms_.mutable_data<float>(), &context_);
+        hipLaunchKernelGGL((LogUniformSampleKernel),
+                           dim3(CAFFE_GET_BLOCKS(S)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           S,
+                           V,
+                           uniforms_.data<float>(),
+                           sampled_data);
+    }
+
+    sampled_weights_.Resize(S, K);
+    hipLaunchKernelGGL((GatherRowsKernel),
+                       dim3(CAFFE_GET_BLOCKS(S * K)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       S,
+                       K,
+                       sampled_data,
+                       W.data<float>(),
+                       sampled_weights_.mutable_data<float>());
+    logits_.Resize(N, S);
+    math::Gemm<float, HIPContext>(CblasNoTrans,
+                                  CblasTrans,
+                                  N,
+                                  S,
+                                  K,
+                                  1,
+                                  X.data<float>(),
+                                  sampled_weights_.data<float>(),
+                                  0,
+                                  logits_.mutable_data<float>(),
+                                  &context_);
+
+    P->Resize(N, S + 1);
+    losses_.Resize(N);
+    avg_loss->Resize(vector<TIndex>());
+    float* avg_loss_data = avg_loss->mutable_data<float>();
+    if(N == 0)
+    {
+        math::Set<float, HIPContext>(1, 0.f, avg_loss_data, &context_);
+        return true;
+    }
+    hipLaunchKernelGGL((SampledSoftmaxKernel),
+                       dim3(N),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       S,
+                       K,
+                       V,
+                       remove_accidental_hits_,
+                       X.data<float>(),
+                       W.data<float>(),
+                       b.data<float>(),
+                       labels.data<int>(),
+                       sampled_data,
+                       logits_.data<float>(),
+                       P->mutable_data<float>(),
+                       losses_.mutable_data<float>());
+    math::Sum<float, HIPContext>(N, losses_.data<float>(), avg_loss_data, &context_, &scratch_);
+    math::Scale<float, HIPContext>(1, 1.f / N, avg_loss_data, avg_loss_data, &context_);
+    return true;
+}
+
+template <>
+bool SampledSoftmaxWithLossGradientOp<float, HIPContext>::RunOnDevice()
+{
+    const auto& X          = Input(0);
+    const auto& W          = Input(1);
+    const auto& labels     = Input(2);
+    const auto& sampled    = Input(3);
+    const auto& P          = Input(4);
+    const auto& d_avg_loss = Input(5);
+    auto* dX               = Output(0);
+    auto* dW_indices       = Output(1);
+    auto* dW_values        = Output(2);
+    auto* db_values        = Output(3);
+
+    const int N = X.dim32(0);
+    const int K = X.dim32(1);
+    const int S = sampled.size();
+    CAFFE_ENFORCE_EQ(P.size(), N * (S + 1));
+
+    dX->ResizeLike(X);
+    dW_indices->Resize(N + S);
+    dW_values->Resize(N + S, K);
+    db_values->Resize(N + S);
+    int* dW_indices_data  = dW_indices->mutable_data<int>();
+    float* dW_values_data = dW_values->mutable_data<float>();
+    float* db_values_data = db_values->mutable_data<float>();
+    // The rows of the true classes come first, then the sampled ones.
+    context_.Copy<int, HIPContext, HIPContext>(N, labels.data<int>(), dW_indices_data);
+    context_.Copy<int, HIPContext, HIPContext>(S, sampled.data<int>(), dW_indices_data + N);
+    if(N == 0)
+    {
+        math::Set<float, HIPContext>(S * K, 0.f, dW_values_data, &context_);
+        math::Set<float, HIPContext>(S, 0.f, db_values_data, &context_);
+        return true;
+    }
+
+    label_grad_.Resize(N);
+    sampled_grad_.Resize(N, S);
+    hipLaunchKernelGGL((SampledSoftmaxLogitsGradientKernel),
+                       dim3(CAFFE_GET_BLOCKS(N * (S + 1))),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       N,
+                       S,
+                       P.data<float>(),
+                       d_avg_loss.data<float>(),
+                       label_grad_.mutable_data<float>(),
+                       sampled_grad_.mutable_data<float>(),
+                       db_values_data);
+    hipLaunchKernelGGL((ColumnSumKernel),
+                       dim3(CAFFE_GET_BLOCKS(S)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       N,
+                       S,
+                       sampled_grad_.data<float>(),
+                       db_values_data + N);
+
+    sampled_weights_.Resize(S, K);
+    hipLaunchKernelGGL((GatherRowsKernel),
+                       dim3(CAFFE_GET_BLOCKS(S * K)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       S,
+                       K,
+                       sampled.data<int>(),
+                       W.data<float>(),
+                       sampled_weights_.mutable_data<float>());
+    // dX = dL_sampled * W_sampled + dL_label * W_label
+    math::Gemm<float, HIPContext>(CblasNoTrans,
+                                  CblasNoTrans,
+                                  N,
+                                  K,
+                                  S,
+                                  1,
+                                  sampled_grad_.data<float>(),
+                                  sampled_weights_.data<float>(),
+                                  0,
+                                  dX->mutable_data<float>(),
+                                  &context_);
+    hipLaunchKernelGGL((SampledSoftmaxLabelGradientKernel),
+                       dim3(CAFFE_GET_BLOCKS(N * K)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       N,
+                       K,
+                       X.data<float>(),
+                       W.data<float>(),
+                       labels.data<int>(),
+                       label_grad_.data<float>(),
+                       dX->mutable_data<float>(),
+                       dW_values_data);
+    math::Gemm<float, HIPContext>(CblasTrans,
+                                  CblasNoTrans,
+                                  S,
+                                  K,
+                                  N,
+                                  1,
+                                  sampled_grad_.data<float>(),
+                                  X.data<float>(),
+                                  0,
+                                  dW_values_data + N * K,
+                                  &context_);
+    return true;
+}
+
+REGISTER_HIP_OPERATOR(SampledSoftmaxWithLoss, SampledSoftmaxWithLossOp<float, HIPContext>);
+REGISTER_HIP_OPERATOR(SampledSoftmaxWithLossGradient,
+                      SampledSoftmaxWithLossGradientOp<float, HIPContext>);
+
+} // namespace caffe2
@@ -15,6 +15,7 @@
  */
 
 #include "caffe2/core/context_hip.h"
+#include "caffe2/core/micro_ops_hip.h"
 #include "caffe2/operators/scale_op.h"
 
 namespace caffe2 {
@@ -22,9 +23,29 @@ namespace caffe2 {
 template <>
 bool ScaleOp<HIPContext>::RunOnDevice()
 {
+    auto& X = Input(0);
+    if(X.IsType<float>())
+    {
+        auto* Y = Output(0);
+        Y->ResizeLike(X);
+        if(QueueHIPMicroOp(&context_,
+                           HIPMicroOp::kScale,
+                           X.size(),
+                           X.data<float>(),
+                           Y->mutable_data<float>(),
+                           scale_))
+        {
+            return true;
+        }
+    }
+    else
+    {
+        MicroOps::Flush();
+    }
     return DispatchHelper<TensorTypes<float16, float>>::call(this, Input(0));
 }
 
 REGISTER_HIP_OPERATOR(Scale, ScaleOp<HIPContext>);
+REGISTER_COALESCABLE_OPERATOR(HIP, Scale);
 
 } // namespace caffe2
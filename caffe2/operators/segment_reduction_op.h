@@ -2021,6 +2021,32 @@ i.e. `len(LENGTHS)`. Other dimensions are inherited from the input tensor.
         "Aggregated output tensor. Has the first dimension of K "
         "(the number of segments).");
     ReducerDef::PopulateSchema(schema);
+    schema.CostInferenceFunction(
+        OpSchema::CostInferenceFunctionType(CostInferenceForSparseLengths));
+  }
+  // Every index pulls in a slice of DATA and reduces it into its segment,
+  // with a multiply per element more for a weighted reduction.
+  static OpSchema::Cost CostInferenceForSparseLengths(
+      const OperatorDef& /* unused */,
+      const vector<TensorShape>& inputs) {
+    struct OpSchema::Cost c;
+    const TensorShape& data = inputs[0];
+    const uint64_t data_size = nElemFromShape(data);
+    const uint64_t block_size = data.dims_size() > 0
+        ? data_size / std::max<uint64_t>(data.dims(0), 1)
+        : 1;
+    const uint64_t item_size =
+        nBytesFromShape(data) / std::max<uint64_t>(data_size, 1);
+    const uint64_t num_indices =
+        nElemFromShape(inputs[Reducer::kInputCount]);
+    const uint64_t num_segments =
+        nElemFromShape(inputs[Reducer::kInputCount + 1]);
+    c.flops = num_indices * block_size * Reducer::kInputCount;
+    c.bytes_moved = (num_indices + num_segments) * block_size * item_size;
+    for (int i = 1; i < inputs.size(); ++i) {
+      c.bytes_moved += nBytesFromShape(inputs[i]);
+    }
+    return c;
   }
   using Reducer = typename ReducerDef::template Reducer<T, Context>;
   using ReducerGradient =
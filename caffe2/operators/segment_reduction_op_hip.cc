@@ -272,65 +272,6 @@ __global__ void sparse_length_sum_kernel(const T* __restrict__ in,
     }
 }
 
-template <typename T, typename IndexType, bool ExactBlock = false>
-__global__ void sparse_length_weighted_sum_kernel(const T* __restrict__ in,
-                                                  const T* __restrict__ in_weights,
-                                                  T* __restrict__ out,
-                                                  const int* __restrict__ prefix_sum_length_data,
-                                                  const IndexType* __restrict__ indices,
-                                                  int N,
-                                                  int post,
-                                                  int len_length,
-                                                  int len_indices)
-{
-    // len_length blocks
-    int group = hipBlockIdx_x;
-
-    int start = group == 0 ? 0 : prefix_sum_length_data[group - 1];
-    int end   = prefix_sum_length_data[group];
-    HIP_KERNEL_ASSERT(start <= len_indices);
-    HIP_KERNEL_ASSERT(end <= len_indices);
-
-    HIP_DYNAMIC_SHARED(T, reduceVals)
-
-    if(ExactBlock)
-    {
-        T sum = (T)0;
-
-        in += hipThreadIdx_x;
-        for(int line = start + hipThreadIdx_y; line < end; line += hipBlockDim_y)
-        {
-            sum += in_weights[line] * in[indices[line] * post];
-        }
-
-        reduceVals[hipThreadIdx_y * hipBlockDim_x + hipThreadIdx_x] = sum;
-        __syncthreads();
-
-        if(hipThreadIdx_y == 0)
-        {
-            sum = (T)0;
-            for(int i = 0; i < hipBlockDim_y; ++i)
-            {
-                sum += reduceVals[i * hipBlockDim_x + hipThreadIdx_x];
-            }
-
-            out[group * post + hipThreadIdx_x] = sum;
-        }
-    }
-    else
-    {
-        for(int i = hipThreadIdx_x; i < post; i += hipBlockDim_x)
-        {
-            T sum = (T)0;
-            for(int line = start; line < end; ++line)
-            {
-                sum += in_weights[line] * in[indices[line] * post + i];
-            }
-            out[group * post + i] = sum;
-        }
-    }
-}
-
 } // namespace
 
 template <typename T, class Context = HIPContext, bool SparseFused = true>
@@ -489,117 +430,6 @@ class HIPSparseLengthsSumOp : public Operator<HIPContext>
     Tensor<Context> inclusive_scan_length_buffer_;
 };
 
-template <typename T, class Context = HIPContext, bool SparseFused = true>
-class HIPSparseLengthsWeightedSumOp : public Operator<HIPContext>
-{
-    public:
-    USE_OPERATOR_CONTEXT_FUNCTIONS;
-    HIPSparseLengthsWeightedSumOp(const OperatorDef& operator_def, Workspace* ws)
-        : Operator<HIPContext>(operator_def, ws)
-    {
-    }
-
-    ~HIPSparseLengthsWeightedSumOp() {}
-
-    bool RunOnDevice() override
-    {
-        return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(this, Input(INDICES));
-    }
-
-    template <typename IndexType>
-    bool DoRunWithType()
-    {
-        auto& dataInput    = Input(DATA);
-        auto& weightsInput = Input(WEIGHTS);
-        auto& indicesInput = Input(INDICES);
-        auto& lengthsInput = Input(LENGTHS);
-        auto* output       = Output(0);
-
-        CAFFE_ENFORCE_EQ(1, weightsInput.ndim(), "WEIGHTS must be a vector");
-        CAFFE_ENFORCE_EQ(1, indicesInput.ndim(), "INDICES must be a vector");
-        CAFFE_ENFORCE_EQ(1, lengthsInput.ndim(), "LENGTHS must be a vector");
-
-        const TIndex dataSize = dataInput.dim(0);
-        // Either first dim the data or how much we pull in indexies from it
-        const TIndex dataToReduceSize = indicesInput.dim(0);
-        const TIndex outputSize       = lengthsInput.dim(0);
-        const int len_length          = outputSize;
-
-        auto shape = dataInput.dims();
-        shape[0]   = outputSize;
-        output->Resize(shape);
-
-        inclusive_scan_length_buffer_.ResizeLike(lengthsInput);
-        inclusive_scan_wrapper(lengthsInput.template data<int>(),
-                               len_length,
-                               &inclusive_scan_buffer_,
-                               &inclusive_scan_length_buffer_,
-                               &context_);
-
-        const IndexType* indices     = indicesInput.template data<IndexType>();
-        const T* in_data             = dataInput.template data<T>();
-        const T* in_weights          = weightsInput.template data<T>();
-        T* out_data                  = output->template mutable_data<T>();
-        auto* prefix_sum_length_data = inclusive_scan_length_buffer_.template data<int>();
-        int N                        = dataSize;
-        int post                     = dataInput.size_from_dim(1);
-
-        auto maxThreads = GetDeviceProperty(CaffeHipGetDevice()).maxThreadsPerBlock;
-        if(post <= maxThreads)
-        {
-            int multiple = std::min(maxThreads / post, 16);
-            dim3 block(post, multiple);
-            size_t smem = sizeof(T) * post * multiple;
-
-            hipLaunchKernelGGL((sparse_length_weighted_sum_kernel<T, IndexType, true>),
-                               dim3(len_length),
-                               dim3(block),
-                               smem,
-                               context_.hip_stream(),
-                               in_data,
-                               in_weights,
-                               out_data,
-                               prefix_sum_length_data,
-                               indices,
-                               N,
-                               post,
-                               len_length,
-                               static_cast<int>(dataToReduceSize));
-        }
-        else
-        {
-            hipLaunchKernelGGL((sparse_length_weighted_sum_kernel<T, IndexType, false>),
-                               dim3(len_length),
-                               dim3(maxThreads),
-                               0,
-                               context_.hip_stream(),
-                               in_data,
-                               in_weights,
-                               out_data,
-                               prefix_sum_length_data,
-                               indices,
-                               N,
-                               post,
-                               len_length,
-                               static_cast<int>(dataToReduceSize));
-        }
-        return true;
-    }
-
-    enum
-    {
-        DATA    = 0,
-        WEIGHTS = 1,
-        INDICES = 2,
-        LENGTHS = 3
-    };
-
-    private:
-    // menber field to manage memory
-    Tensor<Context> inclusive_scan_buffer_;
-    Tensor<Context> inclusive_scan_length_buffer_;
-};
-
 template <typename SIndex>
 __global__ void MaxSegmentKernel(int n, const SIndex* segment_ids, SIndex* max_segment)
 {
@@ -619,15 +449,20 @@ __global__ void MaxSegmentKernel(int n, const SIndex* segment_ids, SIndex* max_s
 }
 
 template <typename SIndex, typename T>
-__global__ void UnsortedSegmentSumKernel(
-    int n, int slize_sz, const SIndex* segments, const T* data, T* out, int* scales)
+__global__ void UnsortedSegmentSumKernel(int n,
+                                         int slize_sz,
+                                         const SIndex* segments,
+                                         const T* data,
+                                         const T* weights,
+                                         T* out,
+                                         int* scales)
 {
     HIP_1D_KERNEL_LOOP(i, n)
     {
         int slice_idx  = i / slize_sz;
         int j          = i % slize_sz;
         SIndex segment = segments[slice_idx];
-        atomicAdd(&out[segment * slize_sz + j], data[i]);
+        atomicAdd(&out[segment * slize_sz + j], weights ? weights[slice_idx] * data[i] : data[i]);
         if(scales && j == 0)
         {
             atomicAdd(&scales[segment], 1);
@@ -645,13 +480,204 @@ __global__ void SegmentScalingKernel(int m, int slize_sz, const int* scales, T*
     }
 }
 
-template <typename T, typename SIndex, bool mean>
+template <typename SIndex>
+__global__ void segment_lengths_kernel(int N, const SIndex* X, SIndex* Y)
+{
+    HIP_1D_KERNEL_LOOP(i, N) { atomicAdd(&Y[X[i]], 1); }
+}
+
+// Reducers of the segment ops below. Every output slice is owned by a single
+// thread, which reduces the rows of its segment in order, so unlike the
+// atomicAdd based kernels above the results are deterministic.
+enum SegmentReducer
+{
+    kSegmentSum,
+    kSegmentMean,
+    kSegmentWeightedSum,
+    kSegmentMax,
+};
+
+// offsets = [0, inclusive_sum(lengths)], K + 1 entries.
+inline void lengths_to_offsets(const int* lengths,
+                               int K,
+                               Tensor<HIPContext>* temp_buffer,
+                               Tensor<HIPContext>* offsets,
+                               HIPContext* context)
+{
+    offsets->Resize(K + 1);
+    int* offsets_data = offsets->mutable_data<int>();
+    math::Set<int, HIPContext>(1, 0, offsets_data, context);
+    if(K == 0)
+    {
+        return;
+    }
+    size_t temp_storage_bytes = 0;
+    hipcub::DeviceScan::InclusiveSum(
+        nullptr, temp_storage_bytes, lengths, offsets_data + 1, K, context->hip_stream());
+    temp_buffer->Resize((temp_storage_bytes + sizeof(int)) / sizeof(int));
+    hipcub::DeviceScan::InclusiveSum(static_cast<void*>(temp_buffer->mutable_data<int>()),
+                                     temp_storage_bytes,
+                                     lengths,
+                                     offsets_data + 1,
+                                     K,
+                                     context->hip_stream());
+}
+
+// Returns the segment of the row, i.e. the last k with offsets[k] <= row.
+__device__ inline int segment_of_row(const int* offsets, int K, int row)
+{
+    int lo = 0;
+    int hi = K - 1;
+    while(lo < hi)
+    {
+        const int mid = (lo + hi + 1) / 2;
+        if(offsets[mid] <= row)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+// One block per segment. rows optionally maps the sorted positions to the
+// rows of data, for segments that are not contiguous.
+template <typename T, int Reducer>
+__global__ void segment_reduce_kernel(const int K,
+                                      const int post,
+                                      const int* offsets,
+                                      const int* rows,
+                                      const T* data,
+                                      const T* weights,
+                                      T* out)
+{
+    for(int k = hipBlockIdx_x; k < K; k += hipGridDim_x)
+    {
+        const int start = offsets[k];
+        const int end   = offsets[k + 1];
+        for(int j = hipThreadIdx_x; j < post; j += hipBlockDim_x)
+        {
+            T acc = 0;
+            for(int r = start; r < end; ++r)
+            {
+                const int row = rows ? rows[r] : r;
+                const T val   = data[row * post + j];
+                if(Reducer == kSegmentMax)
+                {
+                    acc = (r == start || val > acc) ? val : acc;
+                }
+                else if(Reducer == kSegmentWeightedSum)
+                {
+                    acc += weights[row] * val;
+                }
+                else
+                {
+                    acc += val;
+                }
+            }
+            if(Reducer == kSegmentMean && end > start)
+            {
+                acc /= (end - start);
+            }
+            out[k * post + j] = acc;
+        }
+    }
+}
+
+// Gradient of the Sum, Mean and WeightedSum reducers. The segment of a row is
+// read from segment_ids if given, otherwise searched in offsets; offsets are
+// only required for Mean when segment_ids are given.
+template <typename T, typename SIndex, int Reducer>
+__global__ void segment_reduce_gradient_kernel(const int N,
+                                               const int post,
+                                               const int K,
+                                               const SIndex* segment_ids,
+                                               const int* offsets,
+                                               const T* weights,
+                                               const T* segment_grads,
+                                               T* data_grads)
+{
+    HIP_1D_KERNEL_LOOP(i, N * post)
+    {
+        const int row = i / post;
+        const int j   = i % post;
+        const int seg = segment_ids ? segment_ids[row] : segment_of_row(offsets, K, row);
+        T grad        = segment_grads[seg * post + j];
+        if(Reducer == kSegmentMean)
+        {
+            grad /= offsets[seg + 1] - offsets[seg];
+        }
+        else if(Reducer == kSegmentWeightedSum)
+        {
+            grad *= weights[row];
+        }
+        data_grads[i] = grad;
+    }
+}
+
+template <typename T>
+__global__ void lengths_max_gradient_kernel(const int N,
+                                            const int post,
+                                            const int K,
+                                            const int* offsets,
+                                            const T* data,
+                                            const T* forward_output,
+                                            const T* segment_grads,
+                                            T* data_grads)
+{
+    HIP_1D_KERNEL_LOOP(i, N * post)
+    {
+        const int seg = segment_of_row(offsets, K, i / post);
+        const int idx = seg * post + i % post;
+        data_grads[i] = data[i] == forward_output[idx] ? segment_grads[idx] : T(0);
+    }
+}
+
+// One block per row: scalars_grads[row] = <segment_grads[seg], data[row]>.
+template <typename T>
+__global__ void lengths_weighted_sum_scalars_gradient_kernel(const int N,
+                                                             const int post,
+                                                             const int K,
+                                                             const int* offsets,
+                                                             const T* data,
+                                                             const T* segment_grads,
+                                                             T* scalars_grads)
+{
+    using BlockReduce = hipcub::BlockReduce<T, CAFFE_HIP_NUM_THREADS>;
+    __shared__ typename BlockReduce::TempStorage temp_storage;
+    for(int row = hipBlockIdx_x; row < N; row += hipGridDim_x)
+    {
+        const int seg = segment_of_row(offsets, K, row);
+        T sum         = 0;
+        for(int j = hipThreadIdx_x; j < post; j += hipBlockDim_x)
+        {
+            sum += segment_grads[seg * post + j] * data[row * post + j];
+        }
+        sum = BlockReduce(temp_storage).Sum(sum);
+        if(hipThreadIdx_x == 0)
+        {
+            scalars_grads[row] = sum;
+        }
+        __syncthreads();
+    }
+}
+
+__global__ void segment_iota_kernel(const int N, int* out)
+{
+    HIP_1D_KERNEL_LOOP(i, N) { out[i] = i; }
+}
+
+template <typename T, typename SIndex, bool mean, bool weighted = false>
 class HIPUnsortedSegmentSumOp : public Operator<HIPContext>
 {
     public:
     USE_OPERATOR_FUNCTIONS(HIPContext);
     HIPUnsortedSegmentSumOp(const OperatorDef& operator_def, Workspace* ws)
-        : Operator<HIPContext>(operator_def, ws)
+        : Operator<HIPContext>(operator_def, ws),
+          deterministic_(OperatorBase::GetSingleArgument<bool>("deterministic", false))
     {
     }
 
@@ -660,8 +686,9 @@ class HIPUnsortedSegmentSumOp : public Operator<HIPContext>
     bool RunOnDevice() override
     {
         auto& data        = Input(0);
-        auto& segment_ids = Input(1);
+        auto& segment_ids = Input(InputSize() - 1);
         auto* output      = Output(0);
+        const T* weights  = weighted ? Input(1).template data<T>() : nullptr;
 
         if(segment_ids.size() == 0 || data.size() == 0)
         {
@@ -677,6 +704,11 @@ class HIPUnsortedSegmentSumOp : public Operator<HIPContext>
         }
 
         CAFFE_ENFORCE_EQ(1, segment_ids.ndim(), "SEGMENT_IDS must be a vector");
+        CAFFE_ENFORCE_EQ(data.dim(0), segment_ids.dim(0));
+        if(weighted)
+        {
+            CAFFE_ENFORCE_EQ(Input(1).size(), segment_ids.size(), "SCALARS must be a vector");
+        }
         TIndex slize_sz = data.size_from_dim(1);
 
         K_tensor_.Resize(1);
@@ -726,6 +758,11 @@ class HIPUnsortedSegmentSumOp : public Operator<HIPContext>
         dims[0]   = K + 1;
         output->Resize(dims);
 
+        if(deterministic_)
+        {
+            return RunDeterministic(K + 1, slize_sz, weights);
+        }
+
         // Clear the output as we will be accumulating the values
         math::Set<T, HIPContext>(
             output->size(), T(0), output->template mutable_data<T>(), &context_);
@@ -741,6 +778,7 @@ class HIPUnsortedSegmentSumOp : public Operator<HIPContext>
                                static_cast<int>(slize_sz),
                                segment_ids.template data<SIndex>(),
                                data.template data<T>(),
+                               weights,
                                output->template mutable_data<T>(),
                                nullptr);
         }
@@ -761,6 +799,7 @@ class HIPUnsortedSegmentSumOp : public Operator<HIPContext>
                                static_cast<int>(slize_sz),
                                segment_ids.template data<SIndex>(),
                                data.template data<T>(),
+                               weights,
                                output->template mutable_data<T>(),
                                scaling_factors_.template mutable_data<int>());
             // Divide by the scaling factors to get means
@@ -778,17 +817,88 @@ class HIPUnsortedSegmentSumOp : public Operator<HIPContext>
     }
 
     private:
+    // Sorts the rows by segment (stably, so in their original order within a
+    // segment) and reduces every segment in a single thread per column.
+    bool RunDeterministic(int K, int slize_sz, const T* weights)
+    {
+        auto& data        = Input(0);
+        auto& segment_ids = Input(InputSize() - 1);
+        auto* output      = Output(0);
+        const int N       = segment_ids.size();
+
+        rows_.Resize(2 * N);
+        sorted_ids_.Resize(N);
+        hipLaunchKernelGGL((segment_iota_kernel),
+                           dim3(CAFFE_GET_BLOCKS(N)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           N,
+                           rows_.template mutable_data<int>());
+        size_t temp_storage_bytes = 0;
+        hipcub::DeviceRadixSort::SortPairs(nullptr,
+                                           temp_storage_bytes,
+                                           segment_ids.template data<SIndex>(),
+                                           sorted_ids_.template mutable_data<SIndex>(),
+                                           rows_.template data<int>(),
+                                           rows_.template mutable_data<int>() + N,
+                                           N,
+                                           0,
+                                           sizeof(SIndex) * 8,
+                                           context_.hip_stream());
+        buffer_tensor_.Resize(temp_storage_bytes);
+        hipcub::DeviceRadixSort::SortPairs(
+            static_cast<void*>(buffer_tensor_.template mutable_data<char>()),
+            temp_storage_bytes,
+            segment_ids.template data<SIndex>(),
+            sorted_ids_.template mutable_data<SIndex>(),
+            rows_.template data<int>(),
+            rows_.template mutable_data<int>() + N,
+            N,
+            0,
+            sizeof(SIndex) * 8,
+            context_.hip_stream());
+
+        scaling_factors_.Resize(K);
+        math::Set<int, HIPContext>(
+            K, int(0), scaling_factors_.template mutable_data<int>(), &context_);
+        hipLaunchKernelGGL((segment_lengths_kernel<int>),
+                           dim3(CAFFE_GET_BLOCKS(N)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           N,
+                           sorted_ids_.template data<SIndex>(),
+                           scaling_factors_.template mutable_data<int>());
+        lengths_to_offsets(
+            scaling_factors_.template data<int>(), K, &buffer_tensor_, &offsets_, &context_);
+        hipLaunchKernelGGL((segment_reduce_kernel<T, kReducer>),
+                           dim3(std::min(K, CAFFE_MAXIMUM_NUM_BLOCKS)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           K,
+                           slize_sz,
+                           offsets_.template data<int>(),
+                           rows_.template data<int>() + N,
+                           data.template data<T>(),
+                           weights,
+                           output->template mutable_data<T>());
+        return true;
+    }
+
+    static constexpr int kReducer =
+        mean ? kSegmentMean : (weighted ? kSegmentWeightedSum : kSegmentSum);
+
+    bool deterministic_;
     Tensor<HIPContext> buffer_tensor_;
     Tensor<HIPContext> K_tensor_;
     Tensor<HIPContext> scaling_factors_; // for mean
+    Tensor<HIPContext> sorted_ids_;
+    Tensor<HIPContext> rows_;
+    Tensor<HIPContext> offsets_;
 };
 
-template <typename SIndex>
-__global__ void segment_lengths_kernel(int N, const SIndex* X, SIndex* Y)
-{
-    HIP_1D_KERNEL_LOOP(i, N) { atomicAdd(&Y[X[i]], 1); }
-}
-
 template <typename T, typename SIndex, bool LOGEXP = false>
 __global__ void sorted_segment_mean_kernel(
     const SIndex K, const int N, const SIndex* S, const SIndex* I, const T* X, T* Y)
@@ -973,9 +1083,6 @@ class SortedSegmentRangeMeanGradientOp : public Operator<Context>
 };
 
 REGISTER_HIP_OPERATOR_STR("LengthsSum", HIPSparseLengthsSumOp<float, HIPContext, false>);
-REGISTER_HIP_OPERATOR_STR("SparseLengthsSum", HIPSparseLengthsSumOp<float, HIPContext, true>);
-REGISTER_HIP_OPERATOR_STR("SparseLengthsWeightedSum",
-                          HIPSparseLengthsWeightedSumOp<float, HIPContext, true>);
 REGISTER_HIP_OPERATOR_STR("UnsortedSegmentSum", HIPUnsortedSegmentSumOp<float, int, false>);
 REGISTER_HIP_OPERATOR_STR("UnsortedSegmentMean", HIPUnsortedSegmentSumOp<float, int, true>);
 REGISTER_HIP_OPERATOR_STR("SortedSegmentRangeMean", SortedSegmentRangeMeanOp<float, int, false>);
@@ -986,6 +1093,383 @@ REGISTER_HIP_OPERATOR_STR("SortedSegmentRangeMeanGradient",
 REGISTER_HIP_OPERATOR_STR("SortedSegmentRangeLogMeanExpGradient",
                           SortedSegmentRangeMeanGradientOp<float, int, true>);
 
+// SortedSegment{Sum,Mean,WeightedSum}: inputs DATA, [SCALARS], SEGMENT_IDS.
+template <typename T, typename SIndex, int Reducer>
+class HIPSortedSegmentReduceOp : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPSortedSegmentReduceOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        auto& data        = Input(0);
+        auto& segment_ids = Input(InputSize() - 1);
+        auto* output      = Output(0);
+        const T* weights =
+            Reducer == kSegmentWeightedSum ? Input(1).template data<T>() : nullptr;
+
+        CAFFE_ENFORCE_EQ(1, segment_ids.ndim(), "SEGMENT_IDS must be a vector");
+        CAFFE_ENFORCE_EQ(data.dim(0), segment_ids.dim(0));
+        const int N    = segment_ids.size();
+        const int post = data.size_from_dim(1);
+        auto dims      = data.dims();
+        if(N == 0)
+        {
+            dims[0] = 0;
+            output->Resize(dims);
+            output->template mutable_data<T>();
+            return true;
+        }
+
+        // The segments are sorted, so the last id gives their number.
+        SIndex K = 0;
+        context_.CopyBytes<HIPContext, CPUContext>(
+            sizeof(SIndex), segment_ids.template data<SIndex>() + N - 1, &K);
+        context_.FinishDeviceComputation();
+        K += 1;
+        dims[0] = K;
+        output->Resize(dims);
+
+        lengths_.Resize(K);
+        math::Set<int, HIPContext>(K, 0, lengths_.template mutable_data<int>(), &context_);
+        hipLaunchKernelGGL((segment_lengths_kernel<int>),
+                           dim3(CAFFE_GET_BLOCKS(N)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           N,
+                           segment_ids.template data<SIndex>(),
+                           lengths_.template mutable_data<int>());
+        lengths_to_offsets(lengths_.template data<int>(), K, &buffer_, &offsets_, &context_);
+        hipLaunchKernelGGL((segment_reduce_kernel<T, Reducer>),
+                           dim3(std::min(static_cast<int>(K), CAFFE_MAXIMUM_NUM_BLOCKS)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           static_cast<int>(K),
+                           post,
+                           offsets_.template data<int>(),
+                           nullptr,
+                           data.template data<T>(),
+                           weights,
+                           output->template mutable_data<T>());
+        return true;
+    }
+
+    private:
+    Tensor<HIPContext> lengths_;
+    Tensor<HIPContext> offsets_;
+    Tensor<HIPContext> buffer_;
+};
+
+// Lengths{Mean,WeightedSum,Max}: inputs DATA, [SCALARS], LENGTHS.
+template <typename T, int Reducer>
+class HIPLengthsReduceOp : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPLengthsReduceOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        auto& data    = Input(0);
+        auto& lengths = Input(InputSize() - 1);
+        auto* output  = Output(0);
+        const T* weights =
+            Reducer == kSegmentWeightedSum ? Input(1).template data<T>() : nullptr;
+
+        CAFFE_ENFORCE_EQ(1, lengths.ndim(), "LENGTHS must be a vector");
+        if(Reducer == kSegmentWeightedSum)
+        {
+            CAFFE_ENFORCE_EQ(Input(1).size(), data.dim(0), "SCALARS must be a vector");
+        }
+        const int K    = lengths.size();
+        const int post = data.size_from_dim(1);
+        auto dims      = data.dims();
+        dims[0]        = K;
+        output->Resize(dims);
+        T* output_data = output->template mutable_data<T>();
+        if(K == 0)
+        {
+            return true;
+        }
+
+        lengths_to_offsets(lengths.template data<int>(), K, &buffer_, &offsets_, &context_);
+        hipLaunchKernelGGL((segment_reduce_kernel<T, Reducer>),
+                           dim3(std::min(K, CAFFE_MAXIMUM_NUM_BLOCKS)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           K,
+                           post,
+                           offsets_.template data<int>(),
+                           nullptr,
+                           data.template data<T>(),
+                           weights,
+                           output_data);
+        return true;
+    }
+
+    private:
+    Tensor<HIPContext> offsets_;
+    Tensor<HIPContext> buffer_;
+};
+
+// Gradient of the Sum, Mean and WeightedSum reducers of the SortedSegment,
+// UnsortedSegment and Lengths ops: inputs [SCALARS], SEGMENT_GRADS and
+// SEGMENT_IDS or LENGTHS.
+template <typename T, typename SIndex, int Reducer, bool Lengths>
+class HIPSegmentReduceGradientOp : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPSegmentReduceGradientOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        auto& segment_grads = Input(InputSize() - 2);
+        auto& segments      = Input(InputSize() - 1);
+        auto* data_grads    = Output(0);
+        const T* weights =
+            Reducer == kSegmentWeightedSum ? Input(0).template data<T>() : nullptr;
+
+        CAFFE_ENFORCE_EQ(1, segments.ndim(), "SEGMENT_IDS/LENGTHS must be a vector");
+        CAFFE_ENFORCE_GT(segment_grads.ndim(), 0);
+        const int K    = segment_grads.dim32(0);
+        const int post = segment_grads.size_from_dim(1);
+
+        int N = 0;
+        const SIndex* segment_ids = nullptr;
+        if(Lengths)
+        {
+            CAFFE_ENFORCE_EQ(segments.size(), K);
+            lengths_to_offsets(segments.template data<int>(), K, &buffer_, &offsets_, &context_);
+            context_.CopyBytes<HIPContext, CPUContext>(
+                sizeof(int), offsets_.template data<int>() + K, &N);
+            context_.FinishDeviceComputation();
+        }
+        else
+        {
+            N           = segments.size();
+            segment_ids = segments.template data<SIndex>();
+            if(Reducer == kSegmentMean && N > 0)
+            {
+                lengths_.Resize(K);
+                math::Set<int, HIPContext>(
+                    K, 0, lengths_.template mutable_data<int>(), &context_);
+                hipLaunchKernelGGL((segment_lengths_kernel<int>),
+                                   dim3(CAFFE_GET_BLOCKS(N)),
+                                   dim3(CAFFE_HIP_NUM_THREADS),
+                                   0,
+                                   context_.hip_stream(),
+                                   N,
+                                   segment_ids,
+                                   lengths_.template mutable_data<int>());
+                lengths_to_offsets(
+                    lengths_.template data<int>(), K, &buffer_, &offsets_, &context_);
+            }
+        }
+
+        auto dims = segment_grads.dims();
+        dims[0]   = N;
+        data_grads->Resize(dims);
+        T* data_grads_data = data_grads->template mutable_data<T>();
+        if(N == 0 || post == 0)
+        {
+            return true;
+        }
+        hipLaunchKernelGGL((segment_reduce_gradient_kernel<T, SIndex, Reducer>),
+                           dim3(CAFFE_GET_BLOCKS(N * post)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           N,
+                           post,
+                           K,
+                           segment_ids,
+                           offsets_.size() > 0 ? offsets_.template data<int>() : nullptr,
+                           weights,
+                           segment_grads.template data<T>(),
+                           data_grads_data);
+        return true;
+    }
+
+    private:
+    Tensor<HIPContext> lengths_;
+    Tensor<HIPContext> offsets_;
+    Tensor<HIPContext> buffer_;
+};
+
+// Inputs: SCALARS, SEGMENT_GRADS, LENGTHS, DATA. Outputs: DATA and SCALARS
+// gradients.
+template <typename T>
+class HIPLengthsWeightedSumWithMainInputGradientOp : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPLengthsWeightedSumWithMainInputGradientOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        auto& scalars       = Input(0);
+        auto& segment_grads = Input(1);
+        auto& lengths       = Input(2);
+        auto& data          = Input(3);
+        auto* data_grads    = Output(0);
+        auto* scalars_grads = Output(1);
+
+        CAFFE_ENFORCE_EQ(1, lengths.ndim(), "LENGTHS must be a vector");
+        const int K    = lengths.size();
+        const int N    = data.dim32(0);
+        const int post = segment_grads.size_from_dim(1);
+        CAFFE_ENFORCE_EQ(segment_grads.dim32(0), K);
+        CAFFE_ENFORCE_EQ(scalars.size(), N);
+        auto dims = segment_grads.dims();
+        dims[0]   = N;
+        data_grads->Resize(dims);
+        scalars_grads->ResizeLike(scalars);
+        T* data_grads_data    = data_grads->template mutable_data<T>();
+        T* scalars_grads_data = scalars_grads->template mutable_data<T>();
+        if(N == 0)
+        {
+            return true;
+        }
+
+        lengths_to_offsets(lengths.template data<int>(), K, &buffer_, &offsets_, &context_);
+        hipLaunchKernelGGL((segment_reduce_gradient_kernel<T, int, kSegmentWeightedSum>),
+                           dim3(CAFFE_GET_BLOCKS(N * post)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           N,
+                           post,
+                           K,
+                           nullptr,
+                           offsets_.template data<int>(),
+                           scalars.template data<T>(),
+                           segment_grads.template data<T>(),
+                           data_grads_data);
+        hipLaunchKernelGGL((lengths_weighted_sum_scalars_gradient_kernel<T>),
+                           dim3(std::min(N, CAFFE_MAXIMUM_NUM_BLOCKS)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           N,
+                           post,
+                           K,
+                           offsets_.template data<int>(),
+                           data.template data<T>(),
+                           segment_grads.template data<T>(),
+                           scalars_grads_data);
+        return true;
+    }
+
+    private:
+    Tensor<HIPContext> offsets_;
+    Tensor<HIPContext> buffer_;
+};
+
+// Inputs: FORWARD_OUTPUT, SEGMENT_GRADS, LENGTHS, DATA. The gradient goes to
+// every row that equals the max, as on CPU.
+template <typename T>
+class HIPLengthsMaxWithMainInputAndForwardOutputGradientOp : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPLengthsMaxWithMainInputAndForwardOutputGradientOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        auto& forward_output = Input(0);
+        auto& segment_grads  = Input(1);
+        auto& lengths        = Input(2);
+        auto& data           = Input(3);
+        auto* data_grads     = Output(0);
+
+        CAFFE_ENFORCE_EQ(1, lengths.ndim(), "LENGTHS must be a vector");
+        const int K    = lengths.size();
+        const int N    = data.dim32(0);
+        const int post = data.size_from_dim(1);
+        CAFFE_ENFORCE_EQ(segment_grads.dim32(0), K);
+        CAFFE_ENFORCE_EQ(forward_output.size(), segment_grads.size());
+        data_grads->ResizeLike(data);
+        T* data_grads_data = data_grads->template mutable_data<T>();
+        if(N == 0 || post == 0)
+        {
+            return true;
+        }
+
+        lengths_to_offsets(lengths.template data<int>(), K, &buffer_, &offsets_, &context_);
+        hipLaunchKernelGGL((lengths_max_gradient_kernel<T>),
+                           dim3(CAFFE_GET_BLOCKS(N * post)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           N,
+                           post,
+                           K,
+                           offsets_.template data<int>(),
+                           data.template data<T>(),
+                           forward_output.template data<T>(),
+                           segment_grads.template data<T>(),
+                           data_grads_data);
+        return true;
+    }
+
+    private:
+    Tensor<HIPContext> offsets_;
+    Tensor<HIPContext> buffer_;
+};
+
+REGISTER_HIP_OPERATOR_STR("SortedSegmentSum",
+                          HIPSortedSegmentReduceOp<float, int, kSegmentSum>);
+REGISTER_HIP_OPERATOR_STR("SortedSegmentMean",
+                          HIPSortedSegmentReduceOp<float, int, kSegmentMean>);
+REGISTER_HIP_OPERATOR_STR("SortedSegmentWeightedSum",
+                          HIPSortedSegmentReduceOp<float, int, kSegmentWeightedSum>);
+REGISTER_HIP_OPERATOR_STR("UnsortedSegmentWeightedSum",
+                          HIPUnsortedSegmentSumOp<float, int, false, true>);
+REGISTER_HIP_OPERATOR_STR("LengthsMean", HIPLengthsReduceOp<float, kSegmentMean>);
+REGISTER_HIP_OPERATOR_STR("LengthsWeightedSum", HIPLengthsReduceOp<float, kSegmentWeightedSum>);
+REGISTER_HIP_OPERATOR_STR("LengthsMax", HIPLengthsReduceOp<float, kSegmentMax>);
+
+REGISTER_HIP_OPERATOR_STR("SortedSegmentSumGradient",
+                          HIPSegmentReduceGradientOp<float, int, kSegmentSum, false>);
+REGISTER_HIP_OPERATOR_STR("SortedSegmentMeanGradient",
+                          HIPSegmentReduceGradientOp<float, int, kSegmentMean, false>);
+REGISTER_HIP_OPERATOR_STR("SortedSegmentWeightedSumGradient",
+                          HIPSegmentReduceGradientOp<float, int, kSegmentWeightedSum, false>);
+REGISTER_HIP_OPERATOR_STR("UnsortedSegmentSumGradient",
+                          HIPSegmentReduceGradientOp<float, int, kSegmentSum, false>);
+REGISTER_HIP_OPERATOR_STR("UnsortedSegmentMeanGradient",
+                          HIPSegmentReduceGradientOp<float, int, kSegmentMean, false>);
+REGISTER_HIP_OPERATOR_STR("UnsortedSegmentWeightedSumGradient",
+                          HIPSegmentReduceGradientOp<float, int, kSegmentWeightedSum, false>);
+REGISTER_HIP_OPERATOR_STR("LengthsMeanGradient",
+                          HIPSegmentReduceGradientOp<float, int, kSegmentMean, true>);
+REGISTER_HIP_OPERATOR_STR("LengthsWeightedSumGradient",
+                          HIPSegmentReduceGradientOp<float, int, kSegmentWeightedSum, true>);
+REGISTER_HIP_OPERATOR_STR("LengthsWeightedSumWithMainInputGradient",
+                          HIPLengthsWeightedSumWithMainInputGradientOp<float>);
+REGISTER_HIP_OPERATOR_STR("LengthsMaxWithMainInputAndForwardOutputGradient",
+                          HIPLengthsMaxWithMainInputAndForwardOutputGradientOp<float>);
+
 template <typename T, class Context = HIPContext>
 class HIPSparseLengthsSumGradientWithIndicesOp : public Operator<HIPContext>
 {
@@ -125,14 +125,16 @@ __global__ void RemovePaddingKernel(const T* in,
     out_start_idx *= block_size;
     in_start_idx *= block_size;
 
-    int len                 = len_blocks * block_size;
+    // the payload is the padded segment without its start and end padding
+    int len = (len_blocks - start_padding_width_blocks - end_padding_width_blocks) * block_size;
     int start_padding_width = start_padding_width_blocks * block_size;
 
     // payload
-    T* out_ptr = out + out_start_idx;
+    const T* in_ptr = in + in_start_idx + start_padding_width;
+    T* out_ptr      = out + out_start_idx;
     for(int i = hipThreadIdx_x; i < len; i += hipBlockDim_x)
     {
-        out_ptr[in_start_idx + i] = in[i + start_padding_width];
+        out_ptr[i] = in_ptr[i];
     }
 
     // update the lengths
@@ -410,4 +412,180 @@ void GatherPaddingOp<HIPContext>::GatherPadding(const int outer_size,
 }
 REGISTER_HIP_OPERATOR(RemovePadding, RemovePaddingOp<HIPContext>);
 REGISTER_HIP_OPERATOR(GatherPadding, GatherPaddingOp<HIPContext>);
+
+namespace {
+// One block per sample: copies the sample's rows, or writes a single zero row
+// in place of an empty sample. in_offsets / out_offsets are in rows.
+template <typename T>
+__global__ void pad_empty_samples_kernel(const int lengths_size,
+                                         const int block_size,
+                                         const int* lengths,
+                                         const int* in_offsets,
+                                         const int* out_offsets,
+                                         const T* in,
+                                         T* out)
+{
+    for(int s = hipBlockIdx_x; s < lengths_size; s += hipGridDim_x)
+    {
+        T* out_ptr = out + out_offsets[s] * block_size;
+        if(lengths[s] == 0)
+        {
+            for(int i = hipThreadIdx_x; i < block_size; i += hipBlockDim_x)
+            {
+                out_ptr[i] = T(0);
+            }
+        }
+        else
+        {
+            const T* in_ptr = in + in_offsets[s] * block_size;
+            const int len   = lengths[s] * block_size;
+            for(int i = hipThreadIdx_x; i < len; i += hipBlockDim_x)
+            {
+                out_ptr[i] = in_ptr[i];
+            }
+        }
+    }
+}
+
+__global__ void pad_empty_lengths_kernel(const int N, const int* lengths, int* out_lengths)
+{
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        out_lengths[i] = lengths[i] == 0 ? 1 : lengths[i];
+    }
+}
+
+template <typename T>
+void pad_empty_samples(const int lengths_size,
+                       const int block_size,
+                       const int* lengths,
+                       const int* in_offsets,
+                       const int* out_offsets,
+                       const void* in,
+                       void* out,
+                       HIPContext* context)
+{
+    hipLaunchKernelGGL((pad_empty_samples_kernel<T>),
+                       dim3(std::min(lengths_size, CAFFE_MAXIMUM_NUM_BLOCKS)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context->hip_stream(),
+                       lengths_size,
+                       block_size,
+                       lengths,
+                       in_offsets,
+                       out_offsets,
+                       static_cast<const T*>(in),
+                       static_cast<T*>(out));
+}
+} // namespace
+
+template <>
+bool PadEmptySamplesOp<HIPContext>::RunOnDevice()
+{
+    auto& lengths = Input(0);
+    CAFFE_ENFORCE(lengths.ndim() == 1, "LENGTH should be 1-D");
+    const int lengths_size = lengths.size();
+
+    // The output sizes depend on the lengths, so they are read back once and
+    // the per-sample row offsets are built on the host.
+    TensorCPU lengths_host(lengths, &context_);
+    context_.FinishDeviceComputation();
+    const int32_t* lengths_ptr = lengths_host.data<int32_t>();
+
+    TensorCPU offsets_host;
+    offsets_host.Resize(2, lengths_size);
+    int* in_offsets  = offsets_host.mutable_data<int>();
+    int* out_offsets = in_offsets + lengths_size;
+    int need_padding = 0;
+    int sum_len      = 0;
+    for(int i = 0; i < lengths_size; ++i)
+    {
+        in_offsets[i]  = sum_len;
+        out_offsets[i] = sum_len + need_padding;
+        if(lengths_ptr[i] == 0)
+        {
+            need_padding++;
+        }
+        sum_len += lengths_ptr[i];
+    }
+
+    auto* out_lengths = Output(0);
+    out_lengths->Resize(lengths_size);
+    if(lengths_size > 0)
+    {
+        hipLaunchKernelGGL((pad_empty_lengths_kernel),
+                           dim3(CAFFE_GET_BLOCKS(lengths_size)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           lengths_size,
+                           lengths.data<int32_t>(),
+                           out_lengths->mutable_data<int32_t>());
+    }
+
+    // offsets_host has to outlive the upload
+    Tensor<HIPContext> offsets(offsets_host, &context_);
+    context_.FinishDeviceComputation();
+
+    for(int k = 0; k < InputSize() - 1; k++)
+    {
+        auto& features = Input(1 + k);
+        CAFFE_ENFORCE(features.ndim() >= 1, "FEATURE should at least 1-D");
+        CAFFE_ENFORCE(features.dim(0) == sum_len, "FEATURE and LENGTH should be consistent");
+        const int block_size = features.size_from_dim(1);
+
+        auto* out_features = Output(1 + k);
+        auto out_dims      = features.dims();
+        out_dims.at(0) += need_padding;
+        out_features->Resize(out_dims);
+        void* out_ptr = out_features->raw_mutable_data(features.meta());
+        if(lengths_size == 0 || out_features->size() == 0)
+        {
+            continue;
+        }
+
+        // Rows are copied in the widest unit the item size allows
+        const int* offsets_ptr = offsets.data<int>();
+        const size_t itemsize  = features.meta().itemsize();
+        CAFFE_ENFORCE(features.meta().copy() == nullptr,
+                      "PadEmptySamples on HIP only supports POD features");
+        if(itemsize == 8)
+        {
+            pad_empty_samples<uint64_t>(lengths_size,
+                                        block_size,
+                                        lengths.data<int32_t>(),
+                                        offsets_ptr,
+                                        offsets_ptr + lengths_size,
+                                        features.raw_data(),
+                                        out_ptr,
+                                        &context_);
+        }
+        else if(itemsize == 4)
+        {
+            pad_empty_samples<uint32_t>(lengths_size,
+                                        block_size,
+                                        lengths.data<int32_t>(),
+                                        offsets_ptr,
+                                        offsets_ptr + lengths_size,
+                                        features.raw_data(),
+                                        out_ptr,
+                                        &context_);
+        }
+        else
+        {
+            pad_empty_samples<uint8_t>(lengths_size,
+                                       block_size * itemsize,
+                                       lengths.data<int32_t>(),
+                                       offsets_ptr,
+                                       offsets_ptr + lengths_size,
+                                       features.raw_data(),
+                                       out_ptr,
+                                       &context_);
+        }
+    }
+    return true;
+}
+
+REGISTER_HIP_OPERATOR(PadEmptySamples, PadEmptySamplesOp<HIPContext>);
 } // namespace caffe2
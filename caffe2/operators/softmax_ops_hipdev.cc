@@ -319,6 +319,112 @@ void Softmax(const int N,
     }
 }
 
+// Running (max, sum of exp(x - max)) pair of the online softmax normalizer.
+struct MaxSumPair
+{
+    float max;
+    float sum;
+};
+
+struct MaxSumPairMerge
+{
+    __device__ MaxSumPair operator()(const MaxSumPair& a, const MaxSumPair& b) const
+    {
+        // -FLT_MAX instead of -inf keeps exp() of the empty partials at 0.
+        const float m = fmaxf(a.max, b.max);
+        return MaxSumPair{m, a.sum * expf(a.max - m) + b.sum * expf(b.max - m)};
+    }
+};
+
+// One block per (row, chunk of K): reduces the chunk to its (max, sum) pair
+// in a single pass over the logits.
+__global__ void OnlineSoftmaxChunkKernel(const int D,
+                                         const int chunk,
+                                         const float* Xdata,
+                                         float* partials)
+{
+    using BlockReduce = hipcub::BlockReduce<MaxSumPair, CAFFE_HIP_NUM_THREADS>;
+    __shared__ typename BlockReduce::TempStorage temp_storage;
+
+    const int row     = hipBlockIdx_x;
+    const int begin   = hipBlockIdx_y * chunk;
+    const int end     = min(begin + chunk, D);
+    const float* Xrow = Xdata + static_cast<size_t>(row) * D;
+
+    MaxSumPair val{-FLT_MAX, 0.f};
+    for(int j = begin + hipThreadIdx_x; j < end; j += hipBlockDim_x)
+    {
+        const float x = Xrow[j];
+        if(x > val.max)
+        {
+            val.sum = val.sum * expf(val.max - x) + 1.f;
+            val.max = x;
+        }
+        else
+        {
+            val.sum += expf(x - val.max);
+        }
+    }
+    val = BlockReduce(temp_storage).Reduce(val, MaxSumPairMerge());
+    if(hipThreadIdx_x == 0)
+    {
+        const int idx     = row * hipGridDim_y + hipBlockIdx_y;
+        partials[2 * idx]     = val.max;
+        partials[2 * idx + 1] = val.sum;
+    }
+}
+
+// Merges the chunk partials of each row into its log-sum-exp and computes
+// the loss straight from the label logit.
+__global__ void OnlineSoftmaxLossKernel(const int N,
+                                        const int D,
+                                        const int num_chunks,
+                                        const float* Xdata,
+                                        const float* partials,
+                                        const int* labeldata,
+                                        const float* weights,
+                                        float* lsedata,
+                                        float* Ydata)
+{
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        HIP_KERNEL_ASSERT(labeldata[i] >= 0 && labeldata[i] < D);
+        MaxSumPair val{-FLT_MAX, 0.f};
+        for(int c = 0; c < num_chunks; ++c)
+        {
+            const int idx = i * num_chunks + c;
+            val = MaxSumPairMerge()(val, MaxSumPair{partials[2 * idx], partials[2 * idx + 1]});
+        }
+        const float lse = val.max + logf(val.sum);
+        float weight    = weights ? weights[i] : 1.0;
+        lsedata[i]      = lse;
+        Ydata[i]        = (lse - Xdata[static_cast<size_t>(i) * D + labeldata[i]]) * weight;
+    }
+}
+
+// dX = (softmax(X) - onehot(label)) * weight * scale * dY, with the softmax
+// recomputed from the saved per-row log-sum-exp.
+__global__ void OnlineSoftmaxGradientKernel(const int N,
+                                            const int D,
+                                            const float* Xdata,
+                                            const float* lsedata,
+                                            const int* labeldata,
+                                            const float* weights,
+                                            const float scale,
+                                            const float* dYdata,
+                                            float* dXdata)
+{
+    const float dY = dYdata[0] * scale;
+    HIP_1D_KERNEL_LOOP(i, N * D)
+    {
+        int row      = i / D;
+        int d        = i % D;
+        float val    = expf(Xdata[i] - lsedata[row]) - 1.0 * (d == labeldata[row]);
+        float weight = weights ? weights[row] : 1.0;
+        dXdata[i]    = val * weight * dY;
+    }
+}
+
 } // namespace
 
 template <>
@@ -334,7 +440,6 @@ bool SoftmaxWithLossOp<float, HIPContext>::RunOnDevice()
     int N, D;
     N = X.size_to_dim(canonical_axis); // batch size
     D = X.size_from_dim(canonical_axis);
-    P->ResizeLike(X);
     total_weight_ptr_.Resize(1);
 
     if(label_prob_mode_)
@@ -361,55 +466,93 @@ bool SoftmaxWithLossOp<float, HIPContext>::RunOnDevice()
     {
         losses_.Resize(N);
     }
-    if(rowmax_.size() != N)
+    if(online_)
     {
-        rowmax_.Resize(N);
-    }
-    if(sum_multiplier_.size() != D)
-    {
-        sum_multiplier_.Resize(D);
-        math::Set<float, HIPContext>(D, 1.f, sum_multiplier_.mutable_data<float>(), &context_);
-    }
-    Softmax(N,
-            D,
-            X.data<float>(),
-            sum_multiplier_.data<float>(),
-            losses_.mutable_data<float>(),
-            rowmax_.mutable_data<float>(),
-            P->mutable_data<float>(),
-            !label_prob_mode_, // logarithmic output
-            &context_);
-    // Compute label xent loss per example
-    if(!label_prob_mode_)
-    {
-        hipLaunchKernelGGL((LabelCrossEntropyKernel),
+        CAFFE_ENFORCE(!label_prob_mode_, "online mode only supports integer labels");
+        const int chunk      = chunk_size_ > 0 ? std::min(chunk_size_, D) : D;
+        const int num_chunks = (D + chunk - 1) / chunk;
+        CAFFE_ENFORCE_LE(num_chunks, 65535, "chunk_size is too small for ", D, " classes");
+        // Only the per-row log-sum-exp is kept for the gradient.
+        P->Resize(N);
+        // rowmax_ holds the (max, sum) partials of every chunk here.
+        rowmax_.Resize(2 * N * num_chunks);
+        hipLaunchKernelGGL((OnlineSoftmaxChunkKernel),
+                           dim3(N, num_chunks),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           static_cast<const int>(D),
+                           static_cast<const int>(chunk),
+                           X.data<float>(),
+                           rowmax_.mutable_data<float>());
+        hipLaunchKernelGGL((OnlineSoftmaxLossKernel),
                            dim3(CAFFE_GET_BLOCKS(N)),
                            dim3(CAFFE_HIP_NUM_THREADS),
                            0,
                            context_.hip_stream(),
                            static_cast<const int>(N),
                            static_cast<const int>(D),
-                           P->data<float>(),
+                           static_cast<const int>(num_chunks),
+                           X.data<float>(),
+                           rowmax_.data<float>(),
                            T.data<int>(),
                            weights,
+                           P->mutable_data<float>(),
                            losses_.mutable_data<float>());
-        // Since we had logarithmic output, we need to exponentiate
-        // them again.
-        math::Exp<float, HIPContext>(N * D, P->data<float>(), P->mutable_data<float>(), &context_);
     }
     else
     {
-        hipLaunchKernelGGL((ProbCrossEntropyKernel),
-                           dim3(std::min(N, CAFFE_MAXIMUM_NUM_BLOCKS)),
-                           dim3(CAFFE_HIP_NUM_THREADS),
-                           0,
-                           context_.hip_stream(),
-                           static_cast<const int>(N),
-                           static_cast<const int>(D),
-                           P->data<float>(),
-                           T.data<float>(),
-                           weights,
-                           losses_.mutable_data<float>());
+        P->ResizeLike(X);
+        if(rowmax_.size() != N)
+        {
+            rowmax_.Resize(N);
+        }
+        if(sum_multiplier_.size() != D)
+        {
+            sum_multiplier_.Resize(D);
+            math::Set<float, HIPContext>(D, 1.f, sum_multiplier_.mutable_data<float>(), &context_);
+        }
+        Softmax(N,
+                D,
+                X.data<float>(),
+                sum_multiplier_.data<float>(),
+                losses_.mutable_data<float>(),
+                rowmax_.mutable_data<float>(),
+                P->mutable_data<float>(),
+                !label_prob_mode_, // logarithmic output
+                &context_);
+        // Compute label xent loss per example
+        if(!label_prob_mode_)
+        {
+            hipLaunchKernelGGL((LabelCrossEntropyKernel),
+                               dim3(CAFFE_GET_BLOCKS(N)),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context_.hip_stream(),
+                               static_cast<const int>(N),
+                               static_cast<const int>(D),
+                               P->data<float>(),
+                               T.data<int>(),
+                               weights,
+                               losses_.mutable_data<float>());
+            // Since we had logarithmic output, we need to exponentiate
+            // them again.
+            math::Exp<float, HIPContext>(N * D, P->data<float>(), P->mutable_data<float>(), &context_);
+        }
+        else
+        {
+            hipLaunchKernelGGL((ProbCrossEntropyKernel),
+                               dim3(std::min(N, CAFFE_MAXIMUM_NUM_BLOCKS)),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context_.hip_stream(),
+                               static_cast<const int>(N),
+                               static_cast<const int>(D),
+                               P->data<float>(),
+                               T.data<float>(),
+                               weights,
+                               losses_.mutable_data<float>());
+        }
     }
 
     float total_weight = N;
@@ -550,7 +693,7 @@ bool SoftmaxWithLossGradientOp<float, HIPContext>::RunOnDevice()
     N = X.size_to_dim(canonical_axis); // batch size
     D = X.size_from_dim(canonical_axis);
 
-    if(only_loss_)
+    if(only_loss_ && !online_)
     {
         // Memory saving trick to share the buffer with the softmax output.
         // Softmax output is thus overwritten.
@@ -578,6 +721,40 @@ bool SoftmaxWithLossGradientOp<float, HIPContext>::RunOnDevice()
         }
     }
 
+    if(online_)
+    {
+        CAFFE_ENFORCE(!label_prob_mode_, "online mode only supports integer labels");
+        CAFFE_ENFORCE_EQ(P.size(), N, "online mode expects the per-row log-sum-exp");
+        float total_weight = N;
+        if(weights)
+        {
+            math::Sum<float, HIPContext>(
+                N, weights, total_weight_ptr_.mutable_data<float>(), &context_, &scratch_);
+            hipMemcpyAsync(&total_weight,
+                           total_weight_ptr_.data<float>(),
+                           sizeof(float),
+                           hipMemcpyDeviceToHost,
+                           context_.hip_stream());
+        }
+        // The softmax, label subtraction, weighting and both scalings are
+        // fused into a single pass over dX.
+        hipLaunchKernelGGL((OnlineSoftmaxGradientKernel),
+                           dim3(CAFFE_GET_BLOCKS(N * D)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           static_cast<const int>(N),
+                           static_cast<const int>(D),
+                           X.data<float>(),
+                           P.data<float>(),
+                           T.data<int>(),
+                           weights,
+                           total_weight > 0 ? scale_ / total_weight : 1.f,
+                           d_avg_loss.data<float>(),
+                           dX->mutable_data<float>());
+        return true;
+    }
+
     // Subtract 1 from labeled positions
     if(!label_prob_mode_)
     {
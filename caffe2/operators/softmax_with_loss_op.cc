@@ -46,7 +46,10 @@ OPERATOR_SCHEMA(SoftmaxWithLoss)
 
           out[0].set_data_type(logits.data_type());
           out[0].add_dims(batch_size);
-          out[0].add_dims(num_classes);
+          if (!helper.GetSingleArgument<bool>("online", false) ||
+              def.device_option().device_type() != HIP) {
+            out[0].add_dims(num_classes);
+          }
 
           return out;
         })
@@ -63,6 +66,18 @@ Use parameter label_prob=1 to enable inputting labels as a probability
 distribution.
 Optional third input blob can be used to weight the samples for the loss.
 )DOC")
+    .Arg(
+        "online",
+        "HIP only, integer labels only: compute the softmax normalizer in a "
+        "single online (running max and sum) pass and output the per-example "
+        "log-sum-exp (N) instead of the N x D probabilities. The gradient "
+        "recomputes the probabilities from it. Other devices ignore it. "
+        "Defaults to 0")
+    .Arg(
+        "chunk_size",
+        "With online, split every row into chunks of this many classes that "
+        "are reduced by separate blocks, for very large label spaces with "
+        "small batches. Defaults to 0 (one block per row)")
     .Input(0, "logits", "Unscaled log probabilities")
     .Input(1, "labels", "Ground truth")
     .Input(
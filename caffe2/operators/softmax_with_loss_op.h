@@ -33,7 +33,9 @@ class SoftmaxWithLossOp final : public Operator<Context> {
         label_prob_mode_(OperatorBase::GetSingleArgument<int>("label_prob", 0)),
         order_(StringToStorageOrder(
             OperatorBase::GetSingleArgument<string>("order", "NCHW"))),
-        axis_(OperatorBase::GetSingleArgument<int>("axis", 1)) {
+        axis_(OperatorBase::GetSingleArgument<int>("axis", 1)),
+        online_(OperatorBase::GetSingleArgument<bool>("online", false)),
+        chunk_size_(OperatorBase::GetSingleArgument<int>("chunk_size", 0)) {
     CAFFE_ENFORCE(scale_ >= 0);
     CAFFE_ENFORCE_EQ(
         order_, StorageOrder::NCHW, "Only NCHW order is supported right now.");
@@ -47,6 +49,9 @@ class SoftmaxWithLossOp final : public Operator<Context> {
   int label_prob_mode_;
   StorageOrder order_;
   int axis_;
+  // Only honored by the HIP implementation, see the schema.
+  bool online_;
+  int chunk_size_;
 
   Tensor<Context> losses_; // Per example loss
   Tensor<Context> rowmax_; // per example row max
@@ -66,7 +71,8 @@ class SoftmaxWithLossGradientOp final : public Operator<Context> {
         order_(StringToStorageOrder(
             OperatorBase::GetSingleArgument<string>("order", "NCHW"))),
         only_loss_(OperatorBase::GetSingleArgument<bool>("only_loss", false)),
-        axis_(OperatorBase::GetSingleArgument<int>("axis", 1)) {
+        axis_(OperatorBase::GetSingleArgument<int>("axis", 1)),
+        online_(OperatorBase::GetSingleArgument<bool>("online", false)) {
     CAFFE_ENFORCE(scale_ >= 0);
     CAFFE_ENFORCE_EQ(
         order_, StorageOrder::NCHW, "Only NCHW order is supported right now.");
@@ -84,6 +90,7 @@ class SoftmaxWithLossGradientOp final : public Operator<Context> {
   StorageOrder order_;
   bool only_loss_;
   int axis_;
+  bool online_;
   Tensor<Context> scratch_;
 };
 
@@ -0,0 +1,485 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <numeric>
+#include <hipcub/hipcub.hpp>
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/sparse_to_dense_mask_op.h"
+
+namespace caffe2 {
+
+namespace {
+// Maps every sparse entry to its output cell row * cols + feature, or -1 when
+// its id is invalid or not in the mask. winners[cell] ends up holding the last
+// entry of the row with that id, which is the one the CPU op keeps.
+template <typename TInd>
+__global__ void SparseToDenseMaskCellsKernel(const int N,
+                                             const int rows,
+                                             const int cols,
+                                             const TInd* indices,
+                                             const int* offsets,
+                                             const int64_t* mask_ids,
+                                             const int* mask_features,
+                                             int* cells,
+                                             int* winners)
+{
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        const TInd id = indices[i];
+        int feature   = -1;
+        if(id >= 0 && id < std::numeric_limits<TInd>::max())
+        {
+            int lo = 0;
+            int hi = cols - 1;
+            while(lo < hi)
+            {
+                const int mid = (lo + hi) / 2;
+                if(mask_ids[mid] < id)
+                {
+                    lo = mid + 1;
+                }
+                else
+                {
+                    hi = mid;
+                }
+            }
+            feature = mask_ids[lo] == id ? mask_features[lo] : -1;
+        }
+        int row = 0;
+        if(offsets != nullptr)
+        {
+            int lo = 0;
+            int hi = rows - 1;
+            while(lo < hi)
+            {
+                const int mid = (lo + hi + 1) / 2;
+                if(offsets[mid] <= i)
+                {
+                    lo = mid;
+                }
+                else
+                {
+                    hi = mid - 1;
+                }
+            }
+            row = lo;
+        }
+        const int cell = feature < 0 ? -1 : row * cols + feature;
+        cells[i]       = cell;
+        if(cell >= 0)
+        {
+            atomicMax(winners + cell, static_cast<int>(i));
+        }
+    }
+}
+
+template <typename T>
+__global__ void SparseToDenseMaskKernel(const int N,
+                                        const int block_size,
+                                        const int* winners,
+                                        const T* values,
+                                        const T* default_value,
+                                        T* output,
+                                        bool* presence_mask)
+{
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        const int cell   = i / block_size;
+        const int k      = i % block_size;
+        const int winner = winners[cell];
+        output[i]        = winner >= 0 ? values[winner * block_size + k] : default_value[k];
+        if(presence_mask != nullptr && k == 0)
+        {
+            presence_mask[cell] = winner >= 0;
+        }
+    }
+}
+
+template <typename T>
+__global__ void SparseToDenseMaskGradientKernel(const int N,
+                                                const int block_size,
+                                                const int* cells,
+                                                const int* winners,
+                                                const T* gradient_output,
+                                                T* gradient_values)
+{
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        const int entry = i / block_size;
+        const int cell  = cells[entry];
+        gradient_values[i] = cell >= 0 && winners[cell] == entry
+                                 ? gradient_output[cell * block_size + i % block_size]
+                                 : T(0);
+    }
+}
+
+template <typename T>
+void SparseToDenseMask(const int N,
+                       const int block_size,
+                       const int* winners,
+                       const void* values,
+                       const void* default_value,
+                       void* output,
+                       bool* presence_mask,
+                       HIPContext* context)
+{
+    hipLaunchKernelGGL((SparseToDenseMaskKernel<T>),
+                       dim3(CAFFE_GET_BLOCKS(N)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context->hip_stream(),
+                       N,
+                       block_size,
+                       winners,
+                       static_cast<const T*>(values),
+                       static_cast<const T*>(default_value),
+                       static_cast<T*>(output),
+                       presence_mask);
+}
+
+template <typename T>
+void SparseToDenseMaskGradient(const int N,
+                               const int block_size,
+                               const int* cells,
+                               const int* winners,
+                               const void* gradient_output,
+                               void* gradient_values,
+                               HIPContext* context)
+{
+    hipLaunchKernelGGL((SparseToDenseMaskGradientKernel<T>),
+                       dim3(CAFFE_GET_BLOCKS(N)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context->hip_stream(),
+                       N,
+                       block_size,
+                       cells,
+                       winners,
+                       static_cast<const T*>(gradient_output),
+                       static_cast<T*>(gradient_values));
+}
+
+// Calls F<T> with the widest unsigned type that divides a block of
+// block_nbytes, and the block size in units of that type.
+#define DISPATCH_BY_BLOCK_BYTES(block_nbytes, F, ...)                           \
+    if((block_nbytes) % sizeof(uint64_t) == 0)                                  \
+    {                                                                           \
+        F<uint64_t>((block_nbytes) / sizeof(uint64_t), __VA_ARGS__);            \
+    }                                                                           \
+    else if((block_nbytes) % sizeof(uint32_t) == 0)                             \
+    {                                                                           \
+        F<uint32_t>((block_nbytes) / sizeof(uint32_t), __VA_ARGS__);            \
+    }                                                                           \
+    else                                                                        \
+    {                                                                           \
+        F<uint8_t>((block_nbytes), __VA_ARGS__);                                \
+    }
+
+// The mask is kept on the device sorted by id, so that every sparse entry
+// finds its feature with a binary search instead of the CPU hash lookups.
+class HIPSparseToDenseMaskBase : public SparseToDenseMaskBase<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPSparseToDenseMaskBase(const OperatorDef& operator_def, Workspace* ws)
+        : SparseToDenseMaskBase<HIPContext>(operator_def, ws)
+    {
+        std::vector<int64_t> mask = OperatorBase::GetRepeatedArgument<int64_t>("mask");
+        std::vector<int> order(mask.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&mask](int a, int b) { return mask[a] < mask[b]; });
+
+        TensorCPU mask_ids_host;
+        mask_ids_host.Resize(mask.size());
+        TensorCPU mask_features_host;
+        mask_features_host.Resize(mask.size());
+        for(int i = 0; i < mask.size(); i++)
+        {
+            mask_ids_host.mutable_data<int64_t>()[i]  = mask[order[i]];
+            mask_features_host.mutable_data<int>()[i] = order[i];
+        }
+        mask_ids_.CopyFrom(mask_ids_host, &context_);
+        mask_features_.CopyFrom(mask_features_host, &context_);
+        context_.FinishDeviceComputation();
+    }
+
+    protected:
+    // Fills cells_ for the N entries and winners_ for the rows * cols cells
+    template <typename TInd>
+    void ComputeCells(const TInd* indices, const int N, const int32_t* lengths, const int rows)
+    {
+        const int cols = this->featuresCount_;
+        winners_.Resize(rows * cols);
+        math::Set<int, HIPContext>(
+            rows * cols, -1, winners_.template mutable_data<int>(), &context_);
+        cells_.Resize(N);
+        if(N == 0)
+        {
+            return;
+        }
+
+        const int* offsets_ptr = nullptr;
+        if(lengths != nullptr && rows > 0)
+        {
+            offsets_.Resize(rows);
+            size_t temp_storage_bytes = 0;
+            hipcub::DeviceScan::ExclusiveSum(nullptr,
+                                             temp_storage_bytes,
+                                             lengths,
+                                             offsets_.template mutable_data<int>(),
+                                             rows,
+                                             context_.hip_stream());
+            buffer_.Resize(temp_storage_bytes);
+            hipcub::DeviceScan::ExclusiveSum(
+                static_cast<void*>(buffer_.template mutable_data<char>()),
+                temp_storage_bytes,
+                lengths,
+                offsets_.template mutable_data<int>(),
+                rows,
+                context_.hip_stream());
+            offsets_ptr = offsets_.template data<int>();
+        }
+
+        hipLaunchKernelGGL((SparseToDenseMaskCellsKernel<TInd>),
+                           dim3(CAFFE_GET_BLOCKS(N)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           N,
+                           rows,
+                           cols,
+                           indices,
+                           offsets_ptr,
+                           mask_ids_.template data<int64_t>(),
+                           mask_features_.template data<int>(),
+                           cells_.template mutable_data<int>(),
+                           winners_.template mutable_data<int>());
+    }
+
+    Tensor<HIPContext> mask_ids_;
+    Tensor<HIPContext> mask_features_;
+    Tensor<HIPContext> offsets_;
+    Tensor<HIPContext> cells_;
+    Tensor<HIPContext> winners_;
+    Tensor<HIPContext> buffer_;
+};
+
+class HIPSparseToDenseMaskOp final : public HIPSparseToDenseMaskBase
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPSparseToDenseMaskOp(const OperatorDef& operator_def, Workspace* ws)
+        : HIPSparseToDenseMaskBase(operator_def, ws),
+          returnPresenceMask_(OperatorBase::GetSingleArgument<bool>("return_presence_mask", false))
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(this, Input(INDICES));
+    }
+
+    template <typename TInd>
+    bool DoRunWithType()
+    {
+        auto& sparse_indices = Input(INDICES);
+        CAFFE_ENFORCE_EQ(sparse_indices.ndim(), 1);
+        auto& sparse_values = Input(VALUES);
+        CAFFE_ENFORCE_GE(sparse_values.ndim(), 1);
+        CAFFE_ENFORCE_EQ(sparse_indices.size(), sparse_values.dim(0));
+        auto& default_value = Input(DEFAULT);
+        CAFFE_ENFORCE_EQ(default_value.ndim() + 1, sparse_values.ndim());
+        CAFFE_ENFORCE_EQ(default_value.size(), sparse_values.size_from_dim(1));
+        CAFFE_ENFORCE(sparse_values.meta() == default_value.meta());
+        CAFFE_ENFORCE(sparse_values.meta().copy() == nullptr,
+                      "SparseToDenseMask on HIP only supports POD values");
+
+        const int cols             = this->featuresCount_;
+        int rows                   = 1;
+        const int32_t* lengths_ptr = nullptr;
+        vector<TIndex> shape;
+        if(InputSize() == 4)
+        {
+            auto& lengths = Input(LENGTHS);
+            CAFFE_ENFORCE_EQ(lengths.ndim(), 1);
+            lengths_ptr = lengths.template data<int32_t>();
+            rows        = lengths.dim32(0);
+            shape.push_back(rows);
+        }
+        shape.push_back(cols);
+        bool* presence_mask_data = nullptr;
+        if(returnPresenceMask_)
+        {
+            auto* presence_mask = Output(PRESENCEMASK);
+            presence_mask->Resize(shape);
+            presence_mask_data = presence_mask->template mutable_data<bool>();
+        }
+        shape.insert(shape.end(), default_value.dims().begin(), default_value.dims().end());
+        auto* output = Output(OUTPUTVALUE);
+        output->Resize(shape);
+        void* output_data = output->raw_mutable_data(sparse_values.meta());
+        if(rows * cols == 0)
+        {
+            return true;
+        }
+
+        // Invalid (negative) sparse indices are skipped like on the CPU, but
+        // without the warning and the max_skipped_indices check, which would
+        // need a host synchronization.
+        ComputeCells(sparse_indices.template data<TInd>(),
+                     sparse_indices.dim32(0),
+                     lengths_ptr,
+                     rows);
+
+        const int cells        = rows * cols;
+        const int block_nbytes = default_value.nbytes();
+        if(block_nbytes == 0)
+        {
+            return true;
+        }
+        DISPATCH_BY_BLOCK_BYTES(block_nbytes,
+                                LaunchSparseToDenseMask,
+                                cells,
+                                sparse_values.raw_data(),
+                                default_value.raw_data(),
+                                output_data,
+                                presence_mask_data);
+        return true;
+    }
+
+    private:
+    template <typename T>
+    void LaunchSparseToDenseMask(const int block_size,
+                                 const int cells,
+                                 const void* values,
+                                 const void* default_value,
+                                 void* output,
+                                 bool* presence_mask)
+    {
+        SparseToDenseMask<T>(cells * block_size,
+                             block_size,
+                             winners_.template data<int>(),
+                             values,
+                             default_value,
+                             output,
+                             presence_mask,
+                             &context_);
+    }
+
+    bool returnPresenceMask_;
+
+    INPUT_TAGS(INDICES, VALUES, DEFAULT, LENGTHS);
+    OUTPUT_TAGS(OUTPUTVALUE, PRESENCEMASK);
+};
+
+class HIPSparseToDenseMaskGradientOp final : public HIPSparseToDenseMaskBase
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPSparseToDenseMaskGradientOp(const OperatorDef& operator_def, Workspace* ws)
+        : HIPSparseToDenseMaskBase(operator_def, ws)
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(this, Input(INDICES));
+    }
+
+    template <typename TInd>
+    bool DoRunWithType()
+    {
+        auto& sparse_indices = Input(INDICES);
+        CAFFE_ENFORCE_EQ(sparse_indices.ndim(), 1);
+        auto& gradient_output = Input(GOUTPUT);
+        CAFFE_ENFORCE(gradient_output.meta().copy() == nullptr,
+                      "SparseToDenseMaskGradient on HIP only supports POD values");
+
+        const int cols             = this->featuresCount_;
+        int rows                   = 1;
+        int iter_offset            = 1;
+        const int32_t* lengths_ptr = nullptr;
+        const int default_length   = sparse_indices.dim32(0);
+        if(InputSize() > LENGTHS)
+        {
+            // if the LENGTHS is set, the gradient_output has dim:
+            // lengths * mask.size() * feature_dim
+            auto& lengths = Input(LENGTHS);
+            CAFFE_ENFORCE_EQ(lengths.ndim(), 1);
+            lengths_ptr = lengths.template data<int32_t>();
+            rows        = lengths.dim32(0);
+            CAFFE_ENFORCE_GE(gradient_output.ndim(), 2);
+            CAFFE_ENFORCE_EQ(gradient_output.dim(0), rows);
+            CAFFE_ENFORCE_EQ(gradient_output.dim(1), cols);
+            iter_offset += 1;
+        }
+        else
+        {
+            // if the LENGTHS is not set, the gradient_output has dim:
+            // mask.size() * feature_dim
+            CAFFE_ENFORCE_GE(gradient_output.ndim(), 1);
+            CAFFE_ENFORCE_EQ(gradient_output.dim(0), cols);
+        }
+        vector<TIndex> shape;
+        shape.push_back(default_length);
+        // insert feature_dim
+        shape.insert(shape.end(),
+                     gradient_output.dims().begin() + iter_offset,
+                     gradient_output.dims().end());
+        auto* output = Output(GVALUES);
+        output->Resize(shape);
+        void* output_data = output->raw_mutable_data(gradient_output.meta());
+
+        const int block_nbytes = gradient_output.size_from_dim(iter_offset) * gradient_output.itemsize();
+        if(default_length == 0 || block_nbytes == 0)
+        {
+            return true;
+        }
+        ComputeCells(sparse_indices.template data<TInd>(), default_length, lengths_ptr, rows);
+        DISPATCH_BY_BLOCK_BYTES(block_nbytes,
+                                LaunchSparseToDenseMaskGradient,
+                                default_length,
+                                gradient_output.raw_data(),
+                                output_data);
+        return true;
+    }
+
+    private:
+    template <typename T>
+    void LaunchSparseToDenseMaskGradient(const int block_size,
+                                         const int N,
+                                         const void* gradient_output,
+                                         void* gradient_values)
+    {
+        SparseToDenseMaskGradient<T>(N * block_size,
+                                     block_size,
+                                     cells_.template data<int>(),
+                                     winners_.template data<int>(),
+                                     gradient_output,
+                                     gradient_values,
+                                     &context_);
+    }
+
+    INPUT_TAGS(INDICES, GOUTPUT, LENGTHS);
+    OUTPUT_TAGS(GVALUES);
+};
+
+#undef DISPATCH_BY_BLOCK_BYTES
+} // namespace
+
+REGISTER_HIP_OPERATOR(SparseToDenseMask, HIPSparseToDenseMaskOp);
+REGISTER_HIP_OPERATOR(SparseToDenseMaskGradient, HIPSparseToDenseMaskGradientOp);
+} // namespace caffe2
@@ -151,4 +151,28 @@ class GetSpatialBNGradient : public GradientMakerBase {
   }
 };
 REGISTER_GRADIENT(SpatialBN, GetSpatialBNGradient);
+
+// Input: X, scale, Y, dY, saved_mean, saved_inv_var
+// Output: dX, dscale, dbias, dZ
+OPERATOR_SCHEMA(SpatialBNAddReluGradient)
+    .NumInputs(6)
+    .NumOutputs(4)
+    .AllowInplace({{3, 3}});
+
+class GetSpatialBNAddReluGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    CAFFE_ENFORCE_EQ(def_.input_size(), 6);
+    CAFFE_ENFORCE_EQ(
+        def_.output_size(),
+        5,
+        "SpatialBNAddRelu only has a gradient in training mode.");
+    return SingleGradientDef(
+        "SpatialBNAddReluGradient",
+        "",
+        vector<string>{I(0), I(1), O(0), GO(0), O(3), O(4)},
+        vector<string>{GI(0), GI(1), GI(2), GI(5)});
+  }
+};
+REGISTER_GRADIENT(SpatialBNAddRelu, GetSpatialBNAddReluGradient);
 }
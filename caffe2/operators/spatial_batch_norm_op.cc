@@ -79,14 +79,9 @@ bool SpatialBNOp<CPUContext>::RunOnDevice() {
       }
       case StorageOrder::NHWC: {
         ConstEigenArrayMap<float> X_arr(X.data<float>(), C, N * sample_size);
-        for (int i = 0; i < N * sample_size; ++i) {
-          mean += X_arr.col(i);
-        }
-        mean /= N * sample_size;
-        for (int i = 0; i < N * sample_size; ++i) {
-          var += (X_arr.col(i) - mean) * (X_arr.col(i) - mean);
-        }
-        var /= N * sample_size;
+        mean = X_arr.rowwise().sum() / (N * sample_size);
+        var = (X_arr.colwise() - mean).square().rowwise().sum() /
+            (N * sample_size);
         break;
       }
       default:
@@ -144,12 +139,20 @@ bool SpatialBNOp<CPUContext>::RunOnDevice() {
       bias_arr - mean_arr * inv_std * scale_arr;
   switch (order_) {
     case StorageOrder::NHWC: {
-      EigenArrayMap<float>(Y->mutable_data<float>(), C, N * sample_size) =
-          (ConstEigenArrayMap<float>(X.data<float>(), C, N * sample_size)
-               .colwise() *
-           new_scale)
-              .colwise() +
-          new_bias;
+      // Every pixel is normalized independently.
+      const float* Xdata = X.data<float>();
+      float* Ydata = Y->mutable_data<float>();
+      CPUContext::ParallelFor(
+          N * sample_size,
+          std::max(1, (1 << 16) / std::max(1, C)),
+          [&](size_t begin, size_t end) {
+            EigenArrayMap<float>(Ydata + begin * C, C, end - begin) =
+                (ConstEigenArrayMap<float>(Xdata + begin * C, C, end - begin)
+                     .colwise() *
+                 new_scale)
+                    .colwise() +
+                new_bias;
+          });
       break;
     }
     case StorageOrder::NCHW: {
@@ -169,37 +172,44 @@ bool SpatialBNOp<CPUContext>::RunOnDevice() {
 
 REGISTER_CPU_OPERATOR(SpatialBN, SpatialBNOp<CPUContext>);
 
+namespace {
+
+vector<TensorShape> SpatialBNShapeInference(
+    const OperatorDef& def,
+    const vector<TensorShape>& in) {
+  ArgumentHelper helper(def);
+  bool is_test = helper.GetSingleArgument<int>(OpSchema::Arg_IsTest, 0);
+
+  if (!is_test) {
+    vector<TensorShape> out;
+    StorageOrder order = StringToStorageOrder(
+        helper.GetSingleArgument<string>("order", "NCHW"));
+    const TensorShape& X = in[0];
+    const int C =
+        (order == StorageOrder::NCHW ? X.dims(1) : X.dims(X.dims_size() - 1));
+
+    out.push_back(in[0]);
+    TensorShape meanvar_tp =
+        CreateTensorShape(vector<int>{C}, TensorProto::FLOAT);
+    out.push_back(meanvar_tp); // RUNNING_MEAN
+    out.push_back(meanvar_tp); // RUNNING_MEAN
+    out.push_back(meanvar_tp); // SAVED_MEAN
+    out.push_back(meanvar_tp); // SAVED_VAR
+    return out;
+  } else {
+    return vector<TensorShape>{in[0]};
+  }
+}
+
+} // namespace
+
 OPERATOR_SCHEMA(SpatialBN)
     .NumInputs(5)
     .NumOutputs({1, 5})
     .AllowInplace({{0, 0}})
     .EnforceInplace({{3, 1}, {4, 2}})
-    .TensorInferenceFunction(
-        [](const OperatorDef& def, const vector<TensorShape>& in) {
-          ArgumentHelper helper(def);
-          bool is_test = helper.GetSingleArgument<int>(OpSchema::Arg_IsTest, 0);
-
-          if (!is_test) {
-            vector<TensorShape> out;
-            StorageOrder order = StringToStorageOrder(
-                helper.GetSingleArgument<string>("order", "NCHW"));
-            const TensorShape& X = in[0];
-            const int C =
-                (order == StorageOrder::NCHW ? X.dims(1)
-                                             : X.dims(X.dims_size() - 1));
-
-            out.push_back(in[0]);
-            TensorShape meanvar_tp =
-                CreateTensorShape(vector<int>{C}, TensorProto::FLOAT);
-            out.push_back(meanvar_tp); // RUNNING_MEAN
-            out.push_back(meanvar_tp); // RUNNING_MEAN
-            out.push_back(meanvar_tp); // SAVED_MEAN
-            out.push_back(meanvar_tp); // SAVED_VAR
-            return out;
-          } else {
-            return vector<TensorShape>{in[0]};
-          }
-        })
+    .TensorInferenceFunction(SpatialBNShapeInference)
+    .CostInferenceFunction(PointwiseCostInference<4>)
     .SetDoc(R"DOC(
 Carries out spatial batch normalization as described in the paper
 https://arxiv.org/abs/1502.03167 . Depending on the mode it is being run,
@@ -264,4 +274,52 @@ Output case #2: Y (test mode)
         "Saved variance used during training to speed up "
         "gradient computation. Should not be used for testing.");
 
+// Only implemented for HIPContext, where SpatialBN runs on MIOpen.
+OPERATOR_SCHEMA(SpatialBNAddRelu)
+    .NumInputs(6)
+    .NumOutputs({1, 5})
+    .AllowInplace({{0, 0}})
+    .EnforceInplace({{3, 1}, {4, 2}})
+    .TensorInferenceFunction(SpatialBNShapeInference)
+    .CostInferenceFunction(PointwiseCostInference<6>)
+    .SetDoc(R"DOC(
+Computes Y = max(SpatialBN(X, scale, bias, mean, var) + Z, 0), the
+normalization, residual add and ReLU at the end of a residual block, writing
+the activation once instead of three times. The arguments and the outputs
+after Y are those of SpatialBN. Only the NCHW order is supported. The
+FuseBNAddRelu transform rewrites SpatialBN -> Sum -> Relu chains into this
+operator.
+)DOC")
+    .ArgIsTest(
+        "If set to nonzero, run spatial batch normalization in test mode.")
+    .Arg("epsilon", "The epsilon value to use to avoid division by zero.")
+    .Arg("order", "A StorageOrder string.")
+    .Arg(
+        "momentum",
+        "Factor used in computing the running mean and variance."
+        "e.g., running_mean = running_mean * momentum + mean * (1 - momentum)")
+    .Input(0, "X", "The input 4-dimensional tensor of shape NCHW.")
+    .Input(1, "scale", "The scale as a 1-dimensional tensor of size C.")
+    .Input(2, "bias", "The bias as a 1-dimensional tensor of size C.")
+    .Input(
+        3,
+        "mean",
+        "The running mean (training) or the estimated mean (testing) "
+        "as a 1-dimensional tensor of size C.")
+    .Input(
+        4,
+        "var",
+        "The running variance (training) or the estimated "
+        "variance (testing) as a 1-dimensional tensor of size C.")
+    .Input(
+        5,
+        "Z",
+        "The residual added to the normalized input, of the same shape as X. "
+        "Must not be in-place with Y.")
+    .Output(0, "Y", "The output 4-dimensional tensor of the same shape as X.")
+    .Output(1, "mean", "The running mean, in-place with the input mean.")
+    .Output(2, "var", "The running variance, in-place with the input var.")
+    .Output(3, "saved_mean", "Saved mean used by the gradient.")
+    .Output(4, "saved_var", "Saved inverse variance used by the gradient.");
+
 } // namespace caffe2
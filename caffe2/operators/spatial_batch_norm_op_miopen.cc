@@ -24,7 +24,7 @@ const double MIOPEN_BN_MIN_EPSILON = 1e-6;
 
 namespace caffe2 {
 
-class MIOpenSpatialBNOp final : public SpatialBNOp<HIPContext>
+class MIOpenSpatialBNOp : public SpatialBNOp<HIPContext>
 {
     public:
     USE_OPERATOR_FUNCTIONS(HIPContext);
@@ -109,6 +109,81 @@ class MIOpenSpatialBNGradientOp final : public SpatialBNGradientOp<HIPContext>
     miopenBatchNormMode_t mode_;
 };
 
+// SpatialBN followed by a residual add and a ReLU. The normalization
+// writes Y, and a single pass then adds Z and clamps Y in place.
+class MIOpenSpatialBNAddReluOp final : public MIOpenSpatialBNOp
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    MIOpenSpatialBNAddReluOp(const OperatorDef& operator_def, Workspace* ws)
+        : MIOpenSpatialBNOp(operator_def, ws)
+    {
+        CAFFE_ENFORCE_EQ(InputSize(), 6);
+    }
+
+    bool RunOnDevice() override;
+
+    protected:
+    // The residual follows the SpatialBN inputs.
+    enum { RESIDUAL = EST_VAR + 1 };
+};
+
+class MIOpenSpatialBNAddReluGradientOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    MIOpenSpatialBNAddReluGradientOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws),
+          miopen_wrapper_(&context_),
+          epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)),
+          alpha_(OperatorBase::GetSingleArgument<float>("alpha", 1.0)),
+          beta_(OperatorBase::GetSingleArgument<float>("beta", 0.0)),
+          mode_(miopenBNSpatial)
+    {
+        MIOPEN_ENFORCE(miopenCreateTensorDescriptor(&data_desc_));
+        MIOPEN_ENFORCE(miopenCreateTensorDescriptor(&bn_param_desc_));
+        // Match the epsilon the forward op ran with.
+        epsilon_ = std::max(epsilon_, MIOPEN_BN_MIN_EPSILON);
+    }
+
+    ~MIOpenSpatialBNAddReluGradientOp()
+    {
+        MIOPEN_ENFORCE(miopenDestroyTensorDescriptor(data_desc_));
+        MIOPEN_ENFORCE(miopenDestroyTensorDescriptor(bn_param_desc_));
+    }
+
+    bool RunOnDevice() override;
+
+    protected:
+    MIOPENWrapper miopen_wrapper_;
+    miopenTensorDescriptor_t data_desc_;
+    miopenTensorDescriptor_t bn_param_desc_;
+    vector<TIndex> miopen_input_dims_;
+    double epsilon_;
+    float alpha_;
+    float beta_;
+    miopenBatchNormMode_t mode_;
+
+    INPUT_TAGS(INPUT, SCALE, OUTPUT, OUTPUT_GRAD, SAVED_MEAN, SAVED_INV_VAR);
+    OUTPUT_TAGS(INPUT_GRAD, SCALE_GRAD, BIAS_GRAD, RESIDUAL_GRAD);
+};
+
+namespace {
+__global__ void AddReluKernel(const int N, const float* Z, float* Y)
+{
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        const float y = Y[i] + Z[i];
+        Y[i]          = y > 0 ? y : 0;
+    }
+}
+
+__global__ void ReluGradientKernel(const int N, const float* Y, const float* dY, float* dX)
+{
+    HIP_1D_KERNEL_LOOP(i, N) { dX[i] = Y[i] > 0 ? dY[i] : 0; }
+}
+} // namespace
+
 ////////////////////////////////////////////////////////////////////////////////
 // Implementations
 ////////////////////////////////////////////////////////////////////////////////
@@ -252,6 +327,11 @@ bool MIOpenSpatialBNOp::RunOnDevice()
     {
         return DoRunWithType<float, float>();
     }
+    else if(Input(0).IsType<float16>())
+    {
+        // scale, bias and the statistics stay float
+        return DoRunWithType<float16, float>();
+    }
     else
     {
         LOG(FATAL) << "Unsupported input types";
@@ -328,6 +408,11 @@ bool MIOpenSpatialBNGradientOp::RunOnDevice()
     {
         return DoRunWithType<float, float>();
     }
+    else if(Input(0).IsType<float16>())
+    {
+        // scale, bias and the statistics stay float
+        return DoRunWithType<float16, float>();
+    }
     else
     {
         LOG(FATAL) << "Unsupported input types";
@@ -335,6 +420,97 @@ bool MIOpenSpatialBNGradientOp::RunOnDevice()
     return true;
 }
 
+bool MIOpenSpatialBNAddReluOp::RunOnDevice()
+{
+    const auto& X = Input(INPUT);
+    const auto& Z = Input(RESIDUAL);
+    CAFFE_ENFORCE(X.IsType<float>(), "SpatialBNAddRelu only supports float");
+    CAFFE_ENFORCE_EQ(Z.dims(), X.dims());
+    auto* Y = Output(OUTPUT);
+    CAFFE_ENFORCE(Y != &Z, "SpatialBNAddRelu cannot write Y in-place with Z");
+
+    DoRunWithType<float, float>();
+    hipLaunchKernelGGL((AddReluKernel),
+                       dim3(CAFFE_GET_BLOCKS(Y->size())),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       static_cast<const int>(Y->size()),
+                       Z.data<float>(),
+                       Y->mutable_data<float>());
+    return true;
+}
+
+bool MIOpenSpatialBNAddReluGradientOp::RunOnDevice()
+{
+    const auto& X     = Input(INPUT);
+    const auto& scale = Input(SCALE);
+    const auto& Y     = Input(OUTPUT);
+    const auto& dY    = Input(OUTPUT_GRAD);
+    CAFFE_ENFORCE(X.IsType<float>(), "SpatialBNAddReluGradient only supports float");
+
+    CAFFE_ENFORCE_GE(X.ndim(), 3);
+    const int N = X.dim32(0);
+    const int C = X.dim32(1);
+    const int H = X.dim32(2);
+    const int W = X.ndim() > 3 ? X.dim32(3) : 1;
+    CAFFE_ENFORCE_EQ(scale.ndim(), 1);
+    CAFFE_ENFORCE_EQ(scale.dim32(0), C);
+    CAFFE_ENFORCE_EQ(Y.dims(), X.dims());
+    CAFFE_ENFORCE_EQ(dY.dims(), X.dims());
+    if(X.dims() != miopen_input_dims_)
+    {
+        VLOG(1) << "Setting descriptors.";
+        miopen_input_dims_ = X.dims();
+        MIOPEN_ENFORCE(
+            miopenSet4dTensorDescriptor(data_desc_, miopenTypeWrapper<float>::type, N, C, H, W));
+
+        MIOPEN_ENFORCE(miopenDeriveBNTensorDescriptor(bn_param_desc_, data_desc_, mode_));
+    }
+
+    // The ReLU gradient is also the gradient of the residual, and of the
+    // normalized input, so dZ is computed first and fed to the BN backward.
+    auto* dX     = Output(INPUT_GRAD);
+    auto* dScale = Output(SCALE_GRAD);
+    auto* dBias  = Output(BIAS_GRAD);
+    auto* dZ     = Output(RESIDUAL_GRAD);
+    CAFFE_ENFORCE(dX != dZ, "SpatialBNAddReluGradient cannot write dX in-place with dZ");
+    dZ->ResizeLike(dY);
+    hipLaunchKernelGGL((ReluGradientKernel),
+                       dim3(CAFFE_GET_BLOCKS(Y.size())),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       static_cast<const int>(Y.size()),
+                       Y.data<float>(),
+                       dY.data<float>(),
+                       dZ->mutable_data<float>());
+
+    dX->ResizeLike(X);
+    dScale->ResizeLike(scale);
+    dBias->ResizeLike(scale);
+    MIOPEN_ENFORCE(miopenBatchNormalizationBackward(miopen_wrapper_.inline_miopen_handle(),
+                                                    mode_,
+                                                    &alpha_,
+                                                    &beta_,
+                                                    &alpha_,
+                                                    &beta_,
+                                                    data_desc_,
+                                                    X.data<float>(),
+                                                    data_desc_,
+                                                    dZ->data<float>(),
+                                                    data_desc_,
+                                                    dX->mutable_data<float>(),
+                                                    bn_param_desc_,
+                                                    scale.data<float>(),
+                                                    dScale->mutable_data<float>(),
+                                                    dBias->mutable_data<float>(),
+                                                    epsilon_,
+                                                    Input(SAVED_MEAN).data<float>(),
+                                                    Input(SAVED_INV_VAR).data<float>()));
+    return true;
+}
+
 // Since there is no default implementation for spatial batch normalization,
 // we will register the miopen version as the default as well.
 REGISTER_HIP_OPERATOR(SpatialBN, MIOpenSpatialBNOp);
@@ -342,4 +518,7 @@ REGISTER_HIP_OPERATOR(SpatialBNGradient, MIOpenSpatialBNGradientOp);
 
 REGISTER_MIOPEN_OPERATOR(SpatialBN, MIOpenSpatialBNOp);
 REGISTER_MIOPEN_OPERATOR(SpatialBNGradient, MIOpenSpatialBNGradientOp);
+
+REGISTER_HIP_OPERATOR(SpatialBNAddRelu, MIOpenSpatialBNAddReluOp);
+REGISTER_HIP_OPERATOR(SpatialBNAddReluGradient, MIOpenSpatialBNAddReluGradientOp);
 } // namespace caffe2
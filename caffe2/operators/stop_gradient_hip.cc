@@ -15,8 +15,32 @@
  */
 
 #include "caffe2/core/context_hip.h"
+#include "caffe2/core/micro_ops_hip.h"
 #include "caffe2/operators/stop_gradient.h"
 
 namespace caffe2 {
+template <>
+bool StopGradientOp<HIPContext>::RunOnDevice()
+{
+    const auto& in = Input(0);
+    auto* out      = Output(0);
+    if(out == &in)
+    {
+        return true;
+    }
+    out->ResizeLike(in);
+    if(QueueHIPMicroOp(&context_,
+                       HIPMicroOp::kCopy,
+                       in.nbytes(),
+                       in.raw_data(),
+                       out->raw_mutable_data(in.meta())))
+    {
+        return true;
+    }
+    out->CopyFrom(in, &context_);
+    return true;
+}
+
 REGISTER_HIP_OPERATOR(StopGradient, StopGradientOp<HIPContext>);
+REGISTER_COALESCABLE_OPERATOR(HIP, StopGradient);
 } // namespace caffe2
@@ -16,6 +16,7 @@
 
 #include "caffe2/operators/string_ops.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/operators/packed_strings.h"
 
 namespace caffe2 {
 
@@ -116,6 +117,182 @@ using StringElementwiseOp = UnaryElementwiseWithArgsOp<
     ForEach<ScalarFunctor>,
     TypeMap>;
 
+class StringPackOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  StringPackOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    const auto& strings = Input(0);
+    auto* data = Output(0);
+    auto* lengths = Output(1);
+    const auto* strings_data = strings.data<std::string>();
+    lengths->ResizeLike(strings);
+    auto* lengths_data = lengths->mutable_data<int>();
+    TIndex size = 0;
+    for (TIndex i = 0; i < strings.size(); ++i) {
+      lengths_data[i] = strings_data[i].size();
+      size += strings_data[i].size();
+    }
+    data->Resize(size);
+    auto* bytes = data->mutable_data<uint8_t>();
+    for (TIndex i = 0; i < strings.size(); ++i) {
+      std::copy(strings_data[i].begin(), strings_data[i].end(), bytes);
+      bytes += strings_data[i].size();
+    }
+    return true;
+  }
+};
+
+class StringUnpackOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  StringUnpackOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    const auto& data = Input(0);
+    const auto& lengths = Input(1);
+    PackedStringOffsets(data, lengths, &offsets_);
+    auto* strings = Output(0);
+    strings->ResizeLike(lengths);
+    auto* strings_data = strings->mutable_data<std::string>();
+    const char* bytes = reinterpret_cast<const char*>(data.data<uint8_t>());
+    for (TIndex i = 0; i < lengths.size(); ++i) {
+      strings_data[i].assign(
+          bytes + offsets_[i], offsets_[i + 1] - offsets_[i]);
+    }
+    return true;
+  }
+
+ private:
+  std::vector<int64_t> offsets_;
+};
+
+// Functors of PackedStringSubstrOp give the [begin, begin + size) range of
+// each string that is kept.
+struct PackedPrefix {
+  explicit PackedPrefix(OperatorBase& op)
+      : length_(op.GetSingleArgument<int>("length", 3)) {
+    CAFFE_ENFORCE_GE(length_, 0);
+  }
+  void operator()(int length, int* begin, int* size) const {
+    *begin = 0;
+    *size = std::min(length, length_);
+  }
+
+ private:
+  int length_;
+};
+
+struct PackedSuffix {
+  explicit PackedSuffix(OperatorBase& op)
+      : length_(op.GetSingleArgument<int>("length", 3)) {
+    CAFFE_ENFORCE_GE(length_, 0);
+  }
+  void operator()(int length, int* begin, int* size) const {
+    *size = std::min(length, length_);
+    *begin = length - *size;
+  }
+
+ private:
+  int length_;
+};
+
+template <typename Functor>
+class PackedStringSubstrOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  PackedStringSubstrOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws), functor_(*this) {}
+
+  bool RunOnDevice() override {
+    const auto& data = Input(0);
+    const auto& lengths = Input(1);
+    PackedStringOffsets(data, lengths, &offsets_);
+    const auto* lengths_data = lengths.data<int>();
+    const auto* bytes = data.data<uint8_t>();
+
+    // The output sizes are known before anything is copied, so the output
+    // data is allocated once for the whole batch.
+    auto* out_lengths = Output(1);
+    out_lengths->ResizeLike(lengths);
+    auto* out_lengths_data = out_lengths->mutable_data<int>();
+    begins_.resize(lengths.size());
+    TIndex out_size = 0;
+    for (TIndex i = 0; i < lengths.size(); ++i) {
+      functor_(lengths_data[i], &begins_[i], &out_lengths_data[i]);
+      out_size += out_lengths_data[i];
+    }
+    auto* out_data = Output(0);
+    out_data->Resize(out_size);
+    auto* out_bytes = out_data->mutable_data<uint8_t>();
+    for (TIndex i = 0; i < lengths.size(); ++i) {
+      const auto* begin = bytes + offsets_[i] + begins_[i];
+      out_bytes = std::copy(begin, begin + out_lengths_data[i], out_bytes);
+    }
+    return true;
+  }
+
+ private:
+  Functor functor_;
+  std::vector<int64_t> offsets_;
+  std::vector<int> begins_;
+};
+
+struct PackedStartsWith {
+  explicit PackedStartsWith(OperatorBase& op)
+      : prefix_(op.GetSingleArgument<std::string>("prefix", "")) {}
+  bool operator()(const char* str, int length) const {
+    return length >= static_cast<int>(prefix_.size()) &&
+        std::equal(prefix_.begin(), prefix_.end(), str);
+  }
+
+ private:
+  std::string prefix_;
+};
+
+struct PackedEndsWith {
+  explicit PackedEndsWith(OperatorBase& op)
+      : suffix_(op.GetSingleArgument<std::string>("suffix", "")) {}
+  bool operator()(const char* str, int length) const {
+    const int size = suffix_.size();
+    return length >= size &&
+        std::equal(suffix_.begin(), suffix_.end(), str + length - size);
+  }
+
+ private:
+  std::string suffix_;
+};
+
+template <typename Functor>
+class PackedStringPredicateOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  PackedStringPredicateOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws), functor_(*this) {}
+
+  bool RunOnDevice() override {
+    const auto& data = Input(0);
+    const auto& lengths = Input(1);
+    PackedStringOffsets(data, lengths, &offsets_);
+    const char* bytes = reinterpret_cast<const char*>(data.data<uint8_t>());
+    auto* output = Output(0);
+    output->ResizeLike(lengths);
+    auto* output_data = output->mutable_data<bool>();
+    for (TIndex i = 0; i < lengths.size(); ++i) {
+      output_data[i] =
+          functor_(bytes + offsets_[i], offsets_[i + 1] - offsets_[i]);
+    }
+    return true;
+  }
+
+ private:
+  Functor functor_;
+  std::vector<int64_t> offsets_;
+};
+
 REGISTER_CPU_OPERATOR(StringPrefix, StringElementwiseOp<Prefix>);
 REGISTER_CPU_OPERATOR(StringSuffix, StringElementwiseOp<Suffix>);
 REGISTER_CPU_OPERATOR(
@@ -125,6 +302,20 @@ REGISTER_CPU_OPERATOR(
     StringEndsWith,
     StringElementwiseOp<EndsWith, FixedType<bool>>);
 REGISTER_CPU_OPERATOR(StringJoin, StringJoinOp<CPUContext>);
+REGISTER_CPU_OPERATOR(StringPack, StringPackOp);
+REGISTER_CPU_OPERATOR(StringUnpack, StringUnpackOp);
+REGISTER_CPU_OPERATOR(
+    PackedStringPrefix,
+    PackedStringSubstrOp<PackedPrefix>);
+REGISTER_CPU_OPERATOR(
+    PackedStringSuffix,
+    PackedStringSubstrOp<PackedSuffix>);
+REGISTER_CPU_OPERATOR(
+    PackedStringStartsWith,
+    PackedStringPredicateOp<PackedStartsWith>);
+REGISTER_CPU_OPERATOR(
+    PackedStringEndsWith,
+    PackedStringPredicateOp<PackedEndsWith>);
 
 OPERATOR_SCHEMA(StringPrefix)
     .NumInputs(1)
@@ -199,10 +390,87 @@ element is treated as a row.
         "1-D tensor of strings created by joining row elements from the "
         "input tensor.");
 
+OPERATOR_SCHEMA(StringPack)
+    .NumInputs(1)
+    .NumOutputs(2)
+    .SetDoc(R"DOC(
+Packs a string tensor into one byte tensor with the strings back to back and
+the lengths of the strings. The Packed* string ops and IndexGet work on packed
+strings without allocating a std::string per element.
+)DOC")
+    .Input(0, "strings", "Tensor of std::string.")
+    .Output(0, "data", "1-D uint8 tensor with the bytes of all the strings.")
+    .Output(
+        1,
+        "lengths",
+        "int32 tensor of the shape of strings with the size of each string.");
+
+OPERATOR_SCHEMA(StringUnpack)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Converts packed strings (see StringPack) back into a string tensor.
+)DOC")
+    .Input(0, "data", "1-D uint8 tensor with the bytes of all the strings.")
+    .Input(1, "lengths", "int32 tensor with the size of each string.")
+    .Output(0, "strings", "Tensor of std::string of the shape of lengths.");
+
+OPERATOR_SCHEMA(PackedStringPrefix)
+    .NumInputs(2)
+    .NumOutputs(2)
+    .SetDoc(R"DOC(
+StringPrefix on packed strings (see StringPack).
+)DOC")
+    .Arg("length", "Maximum size of the prefix, in bytes.")
+    .Input(0, "data", "1-D uint8 tensor with the bytes of all the strings.")
+    .Input(1, "lengths", "int32 tensor with the size of each string.")
+    .Output(0, "prefixes_data", "Bytes of the prefixes.")
+    .Output(1, "prefixes_lengths", "Lengths of the prefixes.");
+
+OPERATOR_SCHEMA(PackedStringSuffix)
+    .NumInputs(2)
+    .NumOutputs(2)
+    .SetDoc(R"DOC(
+StringSuffix on packed strings (see StringPack).
+)DOC")
+    .Arg("length", "Maximum size of the suffix, in bytes.")
+    .Input(0, "data", "1-D uint8 tensor with the bytes of all the strings.")
+    .Input(1, "lengths", "int32 tensor with the size of each string.")
+    .Output(0, "suffixes_data", "Bytes of the suffixes.")
+    .Output(1, "suffixes_lengths", "Lengths of the suffixes.");
+
+OPERATOR_SCHEMA(PackedStringStartsWith)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+StringStartsWith on packed strings (see StringPack).
+)DOC")
+    .Arg("prefix", "The prefix to check input strings against.")
+    .Input(0, "data", "1-D uint8 tensor with the bytes of all the strings.")
+    .Input(1, "lengths", "int32 tensor with the size of each string.")
+    .Output(0, "bools", "Tensor of bools of same shape as lengths.");
+
+OPERATOR_SCHEMA(PackedStringEndsWith)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+StringEndsWith on packed strings (see StringPack).
+)DOC")
+    .Arg("suffix", "The suffix to check input strings against.")
+    .Input(0, "data", "1-D uint8 tensor with the bytes of all the strings.")
+    .Input(1, "lengths", "int32 tensor with the size of each string.")
+    .Output(0, "bools", "Tensor of bools of same shape as lengths.");
+
 SHOULD_NOT_DO_GRADIENT(StringPrefix);
 SHOULD_NOT_DO_GRADIENT(StringSuffix);
 SHOULD_NOT_DO_GRADIENT(StringStartsWith);
 SHOULD_NOT_DO_GRADIENT(StringEndsWith);
 SHOULD_NOT_DO_GRADIENT(StringJoin);
+SHOULD_NOT_DO_GRADIENT(StringPack);
+SHOULD_NOT_DO_GRADIENT(StringUnpack);
+SHOULD_NOT_DO_GRADIENT(PackedStringPrefix);
+SHOULD_NOT_DO_GRADIENT(PackedStringSuffix);
+SHOULD_NOT_DO_GRADIENT(PackedStringStartsWith);
+SHOULD_NOT_DO_GRADIENT(PackedStringEndsWith);
 }
 } // namespace caffe2
@@ -33,25 +33,30 @@ template <>
 template <typename T>
 bool SwishGradientOp<CPUContext>::DoRunWithType() {
   auto& Xin = Input(X);
-  auto& Yin = Input(Y);
-  auto& DYin = Input(DY);
+  auto& DYin = Input(InputSize() - 1);
   auto* DXout = Output(DX);
-  CAFFE_ENFORCE_EQ(Xin.size(), Yin.size());
-  CAFFE_ENFORCE_EQ(DYin.size(), Yin.size());
-  DXout->ResizeLike(Yin);
+  CAFFE_ENFORCE_EQ(DYin.size(), Xin.size());
+  DXout->ResizeLike(Xin);
 
   const float* Xdata = Xin.template data<float>();
-  const float* Ydata = Yin.template data<float>();
   const float* dYdata = DYin.template data<float>();
   float* dXdata = DXout->template mutable_data<float>();
 
   EigenVectorArrayMap<float> dXvec(dXdata, DXout->size());
   ConstEigenVectorArrayMap<float> Xvec(Xdata, Xin.size());
-  ConstEigenVectorArrayMap<float> Yvec(Ydata, Yin.size());
   ConstEigenVectorArrayMap<float> dYvec(dYdata, DYin.size());
 
-  // dx = dy * (y + sigmoid(x)*(1-y))
-  dXvec = dYvec * (Yvec + (1. / (1. + (-Xvec).exp())) * (1. - Yvec));
+  if (InputSize() == 3) {
+    auto& Yin = Input(Y);
+    CAFFE_ENFORCE_EQ(Xin.size(), Yin.size());
+    ConstEigenVectorArrayMap<float> Yvec(Yin.template data<float>(), Yin.size());
+    // dx = dy * (y + sigmoid(x)*(1-y))
+    dXvec = dYvec * (Yvec + (1. / (1. + (-Xvec).exp())) * (1. - Yvec));
+  } else {
+    // dx = dy * (s + x*s*(1-s)), s = sigmoid(x)
+    const auto sig = 1. / (1. + (-Xvec).exp());
+    dXvec = dYvec * (sig + Xvec * sig * (1. - sig));
+  }
   return true;
 }
 
@@ -75,14 +80,16 @@ tensor elementwise.
 )DOC")
     .Input(0, "X", "1D input tensor")
     .Output(0, "Y", "1D output tensor");
-// Input: X, Y, dY, output: dX
+// Input: X, [Y,] dY, output: dX
 OPERATOR_SCHEMA(SwishGradient)
-    .NumInputs(3)
+    .NumInputs(2, 3)
     .NumOutputs(1)
-    .AllowInplace({{2, 0}})
+    .AllowInplace({{1, 0}, {2, 0}})
     .SetDoc(R"DOC(
-SwishGradient takes X, Y and dY and uses this to update dX according to the
-chain rule and derivatives of the swish function.
+SwishGradient takes X, optionally Y, and dY and uses this to update dX
+according to the chain rule and derivatives of the swish function. Without Y
+the sigmoid of X is recomputed, which is what the gradient of Swish uses so that
+Y doesn't have to be kept for the backward pass.
 )DOC");
 
 REGISTER_GRADIENT(Swish, GetSwishGradient);
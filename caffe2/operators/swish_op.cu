@@ -37,6 +37,16 @@ SwishGradientKernel(const int N, const T* x, const T* y, const T* dy, T* dx) {
   }
 }
 
+// Recomputes the sigmoid from x, without y.
+template <typename T>
+__global__ void
+SwishGradientFromInputKernel(const int N, const T* x, const T* dy, T* dx) {
+  CUDA_1D_KERNEL_LOOP(i, N) {
+    const T sig = 1. / (1. + exp(-x[i]));
+    dx[i] = dy[i] * (sig + x[i] * sig * (1. - sig));
+  }
+}
+
 struct SwishCUDAFunctor {
   template <typename T>
   inline void
@@ -54,23 +64,30 @@ template <>
 template <typename T>
 bool SwishGradientOp<CUDAContext>::DoRunWithType() {
   auto& Xin = Input(X);
-  auto& Yin = Input(Y);
-  auto& DYin = Input(DY);
+  auto& DYin = Input(InputSize() - 1);
   auto* DXout = Output(DX);
-  CAFFE_ENFORCE_EQ(Xin.size(), Yin.size());
-  CAFFE_ENFORCE_EQ(DYin.size(), Yin.size());
-  DXout->ResizeLike(Yin);
+  CAFFE_ENFORCE_EQ(DYin.size(), Xin.size());
+  DXout->ResizeLike(Xin);
 
   const int n = Xin.size();
   const T* x = Xin.template data<T>();
-  const T* y = Yin.template data<T>();
   const T* dy = DYin.template data<T>();
   T* dx = DXout->template mutable_data<T>();
-  SwishGradientKernel<T>
-      <<<CAFFE_GET_BLOCKS(n),
-         CAFFE_CUDA_NUM_THREADS,
-         0,
-         context_.cuda_stream()>>>(n, x, y, dy, dx);
+  if (InputSize() == 3) {
+    auto& Yin = Input(Y);
+    CAFFE_ENFORCE_EQ(Xin.size(), Yin.size());
+    SwishGradientKernel<T>
+        <<<CAFFE_GET_BLOCKS(n),
+           CAFFE_CUDA_NUM_THREADS,
+           0,
+           context_.cuda_stream()>>>(n, x, Yin.template data<T>(), dy, dx);
+  } else {
+    SwishGradientFromInputKernel<T>
+        <<<CAFFE_GET_BLOCKS(n),
+           CAFFE_CUDA_NUM_THREADS,
+           0,
+           context_.cuda_stream()>>>(n, x, dy, dx);
+  }
   return true;
 }
 
@@ -34,17 +34,21 @@ class SwishGradientOp final : public Operator<Context> {
   }
 
  protected:
+  // Y is optional: the gradient is recomputed from X when only X and DY are
+  // given.
   INPUT_TAGS(X, Y, DY);
   OUTPUT_TAGS(DX);
 };
 
+// The gradient recomputes the sigmoid from X instead of keeping Y alive until
+// the backward pass.
 class GetSwishGradient : public GradientMakerBase {
   using GradientMakerBase::GradientMakerBase;
   vector<OperatorDef> GetGradientDefs() override {
     return SingleGradientDef(
         "SwishGradient",
         "",
-        vector<string>{I(0), O(0), GO(0)},
+        vector<string>{I(0), GO(0)},
         vector<string>{GI(0)});
   }
 };
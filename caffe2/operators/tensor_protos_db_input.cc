@@ -35,6 +35,12 @@ corresponding index in the TensorProtos objects in the DB.
   .Arg("batch_size", "(int, default 0) the number of samples in a batch. The "
        "default value of 0 means that the operator will attempt to insert the "
        "entire data in a single output blob.")
+  .Arg("prefetch_buffers", "(int, default 1) on devices, the number of "
+       "batches that can be prefetched and copied to the device ahead of the "
+       "one being consumed.")
+  .Arg("decode_threads", "(int, default 1) number of threads that parse and "
+       "deserialize the records of a batch in parallel. The records are still "
+       "read from the DB in order by the prefetch thread.")
   .Input(0, "data", "A pre-initialized DB reader. Typically, this is obtained "
          "by calling CreateDB operator with a db_name and a db_type. The "
          "resulting output blob is a DB Reader tensor")
@@ -17,11 +17,14 @@
 #ifndef CAFFE2_OPERATORS_TENSOR_PROTOS_DB_INPUT_H_
 #define CAFFE2_OPERATORS_TENSOR_PROTOS_DB_INPUT_H_
 
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <mutex>
 
 #include "caffe2/core/db.h"
 #include "caffe2/operators/prefetch_op.h"
+#include "caffe2/utils/thread_pool.h"
 
 namespace caffe2 {
 
@@ -39,12 +42,35 @@ class TensorProtosDBInput final : public PrefetchOperator<Context> {
   bool CopyPrefetched() override;
 
  private:
+  // Per decode thread scratch, kept across batches so that parsing and
+  // deserialization reuse their allocations.
+  struct DecodeState {
+    TensorProtos protos;
+    vector<TensorCPU> tensors;
+    CPUContext context;
+  };
+
+  // Parses a record and deserializes its tensors into state->tensors.
+  void Decode(const char* data, size_t size, DecodeState* state);
+  // Copies the tensors of state into slot item_id of the batch.
+  void CopyToBatch(DecodeState* state, int item_id);
+  // Decodes the records read into records_ for the items [begin, end).
+  void DecodeItems(int begin, int end, size_t thread_id);
+
   // Prefetch will always just happen on the CPU side.
   vector<Blob> prefetched_blobs_;
+  // On devices, the batch of every prefetch slot is copied here from Prefetch.
+  vector<vector<Tensor<Context>>> prefetched_on_device_;
   int batch_size_;
-  bool shape_inferred_ = false;
   string key_;
-  string value_;
+  int num_decode_threads_;
+  std::unique_ptr<TaskThreadPool> thread_pool_;
+  vector<DecodeState> decode_states_;
+  // With decode threads, the records of a batch are read here and parsed in
+  // parallel. The strings keep their capacity from one batch to the next.
+  vector<string> records_;
+  // Start of the data of every output in the current batch.
+  vector<char*> batch_data_;
 };
 
 template <class Context>
@@ -53,20 +79,83 @@ TensorProtosDBInput<Context>::TensorProtosDBInput(
     Workspace* ws)
     : PrefetchOperator<Context>(operator_def, ws),
       prefetched_blobs_(operator_def.output_size()),
+      prefetched_on_device_(
+          this->prefetch_slots(),
+          vector<Tensor<Context>>(operator_def.output_size())),
       batch_size_(
-          OperatorBase::template GetSingleArgument<int>("batch_size", 0)) {}
+          OperatorBase::template GetSingleArgument<int>("batch_size", 0)),
+      num_decode_threads_(std::max(
+          1,
+          OperatorBase::template GetSingleArgument<int>("decode_threads", 1))),
+      decode_states_(num_decode_threads_),
+      batch_data_(operator_def.output_size()) {
+  if (num_decode_threads_ > 1 && batch_size_ > 1) {
+    thread_pool_.reset(new TaskThreadPool(num_decode_threads_));
+    records_.resize(batch_size_);
+  }
+}
+
+template <class Context>
+void TensorProtosDBInput<Context>::Decode(
+    const char* data,
+    size_t size,
+    DecodeState* state) {
+  CAFFE_ENFORCE(state->protos.ParseFromArray(data, size));
+  CAFFE_ENFORCE(state->protos.protos_size() == OutputSize());
+  state->tensors.resize(OutputSize());
+  TensorDeserializer<CPUContext> deserializer;
+  for (int i = 0; i < OutputSize(); ++i) {
+    if (state->protos.protos(i).has_device_detail()) {
+      state->protos.mutable_protos(i)->clear_device_detail();
+    }
+    deserializer.Deserialize(state->protos.protos(i), &state->tensors[i]);
+  }
+}
+
+template <class Context>
+void TensorProtosDBInput<Context>::CopyToBatch(
+    DecodeState* state,
+    int item_id) {
+  for (int i = 0; i < OutputSize(); ++i) {
+    const TensorCPU& src = state->tensors[i];
+    const TensorCPU& dst = prefetched_blobs_[i].template Get<TensorCPU>();
+    CAFFE_ENFORCE(
+        src.meta() == dst.meta() && src.size() * batch_size_ == dst.size(),
+        "All the TensorProtos of a batch should have the same type and size.");
+    // The context of the decode thread is used, the one of the operator may
+    // be a device context.
+    state->context.template CopyItems<CPUContext, CPUContext>(
+        src.meta(),
+        src.size(),
+        src.raw_data(),
+        batch_data_[i] + src.nbytes() * item_id);
+  }
+}
+
+template <class Context>
+void TensorProtosDBInput<Context>::DecodeItems(
+    int begin,
+    int end,
+    size_t thread_id) {
+  DecodeState* state = &decode_states_[thread_id];
+  for (int item_id = begin; item_id < end; ++item_id) {
+    Decode(records_[item_id].data(), records_[item_id].size(), state);
+    CopyToBatch(state, item_id);
+  }
+}
 
 template <class Context>
 bool TensorProtosDBInput<Context>::Prefetch() {
   const db::DBReader& reader = OperatorBase::Input<db::DBReader>(0);
-  TensorDeserializer<CPUContext> deserializer;
   if (batch_size_ == 0) {
     // We do not need to construct a batch. As a result, we will simply
     // deserialize everything into the target prefetched blob.
-    reader.Read(&key_, &value_);
-    TensorProtos protos;
-    CAFFE_ENFORCE(protos.ParseFromString(value_));
+    TensorProtos& protos = decode_states_[0].protos;
+    reader.ReadView(&key_, [&protos](const char* data, size_t size) {
+      CAFFE_ENFORCE(protos.ParseFromArray(data, size));
+    });
     CAFFE_ENFORCE(protos.protos_size() == OutputSize());
+    TensorDeserializer<CPUContext> deserializer;
     for (int i = 0; i < protos.protos_size(); ++i) {
       if (protos.protos(i).has_device_detail()) {
         protos.mutable_protos(i)->clear_device_detail();
@@ -76,46 +165,81 @@ bool TensorProtosDBInput<Context>::Prefetch() {
           prefetched_blobs_[i].template GetMutable<TensorCPU>());
     }
   } else {
-    vector<TensorCPU> temp_tensors(OutputSize());
-    for (int item_id = 0; item_id < batch_size_; ++item_id) {
-      reader.Read(&key_, &value_);
-      TensorProtos protos;
-      CAFFE_ENFORCE(protos.ParseFromString(value_));
-      CAFFE_ENFORCE(protos.protos_size() == OutputSize());
-      if (!shape_inferred_) {
-        // First, set the shape of all the blobs.
-        for (int i = 0; i < protos.protos_size(); ++i) {
-          vector<int> dims(
-              protos.protos(i).dims().begin(), protos.protos(i).dims().end());
-          dims.insert(dims.begin(), batch_size_);
-          prefetched_blobs_[i].template GetMutable<TensorCPU>()->Resize(dims);
-        }
+    // The first item sets the shape of the batch. The batch tensors keep
+    // their memory as long as the shape does not change.
+    DecodeState* first = &decode_states_[0];
+    if (thread_pool_) {
+      reader.Read(&key_, &records_[0]);
+      Decode(records_[0].data(), records_[0].size(), first);
+    } else {
+      reader.ReadView(&key_, [this, first](const char* data, size_t size) {
+        Decode(data, size, first);
+      });
+    }
+    for (int i = 0; i < OutputSize(); ++i) {
+      const TensorCPU& src = first->tensors[i];
+      vector<TIndex> dims(src.dims());
+      dims.insert(dims.begin(), batch_size_);
+      auto* dst = prefetched_blobs_[i].template GetMutable<TensorCPU>();
+      dst->Resize(dims);
+      batch_data_[i] = static_cast<char*>(dst->raw_mutable_data(src.meta()));
+    }
+    CopyToBatch(first, 0);
+
+    if (thread_pool_) {
+      // The records are read in order, then parsed into disjoint slices of
+      // the batch by the decode threads.
+      for (int item_id = 1; item_id < batch_size_; ++item_id) {
+        reader.Read(&key_, &records_[item_id]);
       }
-      for (int i = 0; i < protos.protos_size(); ++i) {
-        TensorCPU* dst = prefetched_blobs_[i].template GetMutable<TensorCPU>();
-        TensorCPU& src = temp_tensors[i];
-        if (protos.protos(i).has_device_detail()) {
-          protos.mutable_protos(i)->clear_device_detail();
-        }
-        deserializer.Deserialize(protos.protos(i), &src);
-        DCHECK_EQ(src.size() * batch_size_, dst->size());
-        this->context_.template CopyItems<CPUContext, CPUContext>(
-            src.meta(),
-            src.size(),
-            src.raw_data(),
-            static_cast<char*>(dst->raw_mutable_data(src.meta())) +
-                src.nbytes() * item_id);
+      const int items_per_task =
+          (batch_size_ - 1 + num_decode_threads_ - 1) / num_decode_threads_;
+      for (int begin = 1; begin < batch_size_; begin += items_per_task) {
+        const int end = std::min(begin + items_per_task, batch_size_);
+        thread_pool_->runTaskWithID(std::bind(
+            &TensorProtosDBInput<Context>::DecodeItems,
+            this,
+            begin,
+            end,
+            std::placeholders::_1));
+      }
+      thread_pool_->waitWorkComplete();
+    } else {
+      for (int item_id = 1; item_id < batch_size_; ++item_id) {
+        reader.ReadView(&key_, [this, first](const char* data, size_t size) {
+          Decode(data, size, first);
+        });
+        CopyToBatch(first, item_id);
       }
     }
   }
+  if (!std::is_same<Context, CPUContext>::value) {
+    // Start the host to device copies right away, so that they overlap with
+    // the computation of the current batch.
+    auto& device_tensors = prefetched_on_device_[this->prefetch_slot()];
+    for (int i = 0; i < OutputSize(); ++i) {
+      this->CopyToDeviceAsync(
+          prefetched_blobs_[i].template GetMutable<TensorCPU>(),
+          &device_tensors[i],
+          i);
+    }
+  }
   return true;
 }
 
 template <class Context>
 bool TensorProtosDBInput<Context>::CopyPrefetched() {
+  if (std::is_same<Context, CPUContext>::value) {
+    for (int i = 0; i < OutputSize(); ++i) {
+      OperatorBase::Output<Tensor<Context>>(i)->CopyFrom(
+          prefetched_blobs_[i].template Get<TensorCPU>(), &this->context_);
+    }
+    return true;
+  }
+  const auto& device_tensors = prefetched_on_device_[this->consume_slot()];
   for (int i = 0; i < OutputSize(); ++i) {
     OperatorBase::Output<Tensor<Context>>(i)->CopyFrom(
-        prefetched_blobs_[i].template Get<TensorCPU>(), &this->context_);
+        device_tensors[i], &this->context_);
   }
   return true;
 }
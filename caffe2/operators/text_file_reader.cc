@@ -20,35 +20,46 @@
 #include "caffe2/core/types.h"
 #include "caffe2/operators/text_file_reader_utils.h"
 #include "caffe2/utils/string_utils.h"
+#include "caffe2/utils/thread_pool.h"
+
+#include <condition_variable>
+#include <cstring>
+#include <exception>
 
 namespace caffe2 {
 
 struct TextFileReaderInstance {
   TextFileReaderInstance(
-      const std::vector<char>& delims,
-      char escape,
       const std::string& filename,
       int numPasses,
-      const std::vector<int>& types)
+      const std::vector<int>& types,
+      int numThreads)
       : fileReader(filename),
-        tokenizer(Tokenizer(delims, escape), &fileReader, numPasses),
-        fieldTypes(types) {
+        lineReader(&fileReader, numPasses),
+        fieldTypes(types),
+        numThreads(numThreads) {
     for (const auto dt : fieldTypes) {
       fieldMetas.push_back(
           DataTypeToTypeMeta(static_cast<TensorProto_DataType>(dt)));
       fieldByteSizes.push_back(fieldMetas.back().itemsize());
     }
+    if (numThreads > 1) {
+      // The reading thread parses a part of every batch itself.
+      pool.reset(new TaskThreadPool(numThreads - 1));
+    }
   }
 
   FileReader fileReader;
-  BufferedTokenizer tokenizer;
+  LineBlockReader lineReader;
   std::vector<int> fieldTypes;
   std::vector<TypeMeta> fieldMetas;
   std::vector<size_t> fieldByteSizes;
   size_t rowsRead{0};
+  const int numThreads;
+  std::unique_ptr<TaskThreadPool> pool;
 
-  // hack to guarantee thread-safeness of the read op
-  // TODO(azzolini): support multi-threaded reading.
+  // Only cutting the file into batches is serialized, the lines of a batch
+  // are parsed outside of the lock.
   std::mutex globalMutex_;
 };
 
@@ -58,20 +69,23 @@ class CreateTextFileReaderOp : public Operator<CPUContext> {
       : Operator<CPUContext>(operator_def, ws),
         filename_(GetSingleArgument<string>("filename", "")),
         numPasses_(GetSingleArgument<int>("num_passes", 1)),
+        numThreads_(GetSingleArgument<int>("num_threads", 1)),
         fieldTypes_(GetRepeatedArgument<int>("field_types")) {
     CAFFE_ENFORCE(fieldTypes_.size() > 0, "field_types arg must be non-empty");
+    CAFFE_ENFORCE_GE(numThreads_, 1);
   }
 
   bool RunOnDevice() override {
     *OperatorBase::Output<std::unique_ptr<TextFileReaderInstance>>(0) =
         std::unique_ptr<TextFileReaderInstance>(new TextFileReaderInstance(
-            {'\n', '\t'}, '\0', filename_, numPasses_, fieldTypes_));
+            filename_, numPasses_, fieldTypes_, numThreads_));
     return true;
   }
 
  private:
   std::string filename_;
   int numPasses_;
+  int numThreads_;
   std::vector<int> fieldTypes_;
 };
 
@@ -85,13 +99,13 @@ inline void convert(
       static_cast<std::string*>(dst)->assign(src_start, src_end);
     } break;
     case TensorProto_DataType_FLOAT: {
-      // TODO(azzolini): avoid copy, use faster convertion
-      std::string str_copy(src_start, src_end);
-      const char* src_copy = str_copy.c_str();
-      char* src_copy_end;
-      float val = strtof(src_copy, &src_copy_end);
-      if (src_copy == src_copy_end) {
-        throw std::runtime_error("Invalid float: " + str_copy);
+      // Fields are followed by a delimiter, and the batch by a '\0', so
+      // strtof stops within the line without copying the field.
+      char* parsed_end;
+      float val = strtof(src_start, &parsed_end);
+      if (parsed_end == src_start || parsed_end > src_end) {
+        throw std::runtime_error(
+            "Invalid float: " + std::string(src_start, src_end));
       }
       *static_cast<float*>(dst) = val;
     } break;
@@ -119,60 +133,115 @@ class TextFileReaderReadOp : public Operator<CPUContext> {
             to_string(instance->fieldTypes.size()) + " got " +
             to_string(numFields));
 
-    // char* datas[numFields];
-    // MSVC does not allow using const int, so we will need to dynamically allocate
-    // it.
-    std::vector<char*> datas(numFields);
+    size_t firstRow;
+    {
+      std::lock_guard<std::mutex> guard(instance->globalMutex_);
+      instance->lineReader.next(batchSize_, &block_, &lineStarts_);
+      firstRow = instance->rowsRead;
+      instance->rowsRead += lineStarts_.size();
+    }
+    const int rowsRead = lineStarts_.size();
+
+    datas_.resize(numFields);
     for (int i = 0; i < numFields; ++i) {
-      Output(i)->Resize(batchSize_);
-      datas[i] = (char*)Output(i)->raw_mutable_data(instance->fieldMetas[i]);
+      Output(i)->Resize(rowsRead);
+      datas_[i] = (char*)Output(i)->raw_mutable_data(instance->fieldMetas[i]);
     }
 
-    int rowsRead = 0;
-    {
-      // TODO(azzolini): support multi-threaded reading
-      std::lock_guard<std::mutex> guard(instance->globalMutex_);
+    const int numTasks = std::min<int>(
+        instance->numThreads, (rowsRead + kMinRowsPerTask - 1) / kMinRowsPerTask);
+    if (numTasks <= 1) {
+      ParseRows(*instance, firstRow, 0, rowsRead);
+      return true;
+    }
 
-      bool finished = false;
-      Token token;
-      while (!finished && (rowsRead < batchSize_)) {
-        int field;
-        for (field = 0; field < numFields; ++field) {
-          finished = !instance->tokenizer.next(token);
-          if (finished) {
-            CAFFE_ENFORCE(
-                field == 0, "Invalid number of fields at end of file.");
-            break;
-          }
-          CAFFE_ENFORCE(
-              (field == 0 && token.startDelimId == 0) ||
-                  (field > 0 && token.startDelimId == 1),
-              "Invalid number of columns at row ",
-              instance->rowsRead + rowsRead + 1);
-          const auto& meta = instance->fieldMetas[field];
-          char*& data = datas[field];
-          convert(
-              (TensorProto_DataType)instance->fieldTypes[field],
-              token.start,
-              token.end,
-              data);
-          data += instance->fieldByteSizes[field];
-        }
-        if (!finished) {
-          ++rowsRead;
+    // Every task parses a contiguous range of rows into its own part of the
+    // outputs, so the rows keep the order of the file.
+    std::mutex mutex;
+    std::condition_variable done;
+    int remaining = numTasks - 1;
+    std::exception_ptr error;
+    auto runTask = [&](int task) {
+      try {
+        ParseRows(
+            *instance,
+            firstRow,
+            static_cast<int64_t>(rowsRead) * task / numTasks,
+            static_cast<int64_t>(rowsRead) * (task + 1) / numTasks);
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (!error) {
+          error = std::current_exception();
         }
       }
-      instance->rowsRead += rowsRead;
+    };
+    for (int task = 1; task < numTasks; ++task) {
+      instance->pool->run([&, task]() {
+        runTask(task);
+        std::lock_guard<std::mutex> guard(mutex);
+        if (--remaining == 0) {
+          done.notify_one();
+        }
+      });
     }
-
-    for (int i = 0; i < numFields; ++i) {
-      Output(i)->Shrink(rowsRead);
+    runTask(0);
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      done.wait(lock, [&]() { return remaining == 0; });
+    }
+    if (error) {
+      std::rethrow_exception(error);
     }
     return true;
   }
 
  private:
+  // Below this, a batch is not worth splitting across threads.
+  static constexpr int kMinRowsPerTask = 256;
+
+  void ParseRows(
+      const TextFileReaderInstance& instance,
+      size_t firstRow,
+      int begin,
+      int end) const {
+    const int numFields = datas_.size();
+    for (int row = begin; row < end; ++row) {
+      const char* pos = block_.data() + lineStarts_[row];
+      // Every line ends with '\n', which is not part of the last field.
+      const char* lineEnd = (row + 1 < lineStarts_.size()
+                                 ? block_.data() + lineStarts_[row + 1]
+                                 : block_.data() + block_.size()) -
+          1;
+      for (int field = 0; field < numFields; ++field) {
+        const char* fieldEnd = static_cast<const char*>(
+            std::memchr(pos, '\t', lineEnd - pos));
+        if (field == numFields - 1) {
+          CAFFE_ENFORCE(
+              fieldEnd == nullptr,
+              "Invalid number of columns at row ",
+              firstRow + row + 1);
+          fieldEnd = lineEnd;
+        } else {
+          CAFFE_ENFORCE(
+              fieldEnd != nullptr,
+              "Invalid number of columns at row ",
+              firstRow + row + 1);
+        }
+        convert(
+            (TensorProto_DataType)instance.fieldTypes[field],
+            pos,
+            fieldEnd,
+            datas_[field] + row * instance.fieldByteSizes[field]);
+        pos = fieldEnd + 1;
+      }
+    }
+  }
+
   TIndex batchSize_;
+  // The current batch, and the offset of each of its rows.
+  std::string block_;
+  std::vector<size_t> lineStarts_;
+  std::vector<char*> datas_;
 };
 
 CAFFE_KNOWN_TYPE(std::unique_ptr<TextFileReaderInstance>);
@@ -186,6 +255,10 @@ OPERATOR_SCHEMA(CreateTextFileReader)
     .SetDoc("Create a text file reader. Fields are delimited by <TAB>.")
     .Arg("filename", "Path to the file.")
     .Arg("num_passes", "Number of passes over the file.")
+    .Arg(
+        "num_threads",
+        "Number of threads parsing the rows of each batch. Batches of less "
+        "than 256 rows per thread use fewer threads. Defaults to 1.")
     .Arg(
         "field_types",
         "List with type of each field. Type enum is found at core.DataType.")
@@ -93,6 +93,59 @@ void Tokenizer::next(char* start, char* end, TokenizedString& tokenized) {
   }
 }
 
+size_t LineBlockReader::next(
+    size_t maxLines,
+    std::string* block,
+    std::vector<size_t>* lineStarts) {
+  block->clear();
+  lineStarts->clear();
+  while (lineStarts->size() < maxLines) {
+    // memchr is vectorized, so finding the line ends is cheap compared to
+    // parsing the lines.
+    const char* begin = pending_.data() + offset_;
+    const char* end = pending_.data() + pending_.size();
+    const char* pos = begin;
+    while (lineStarts->size() < maxLines) {
+      const char* newline =
+          static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+      if (!newline) {
+        break;
+      }
+      lineStarts->push_back(block->size() + (pos - begin));
+      pos = newline + 1;
+    }
+    block->append(begin, pos);
+    offset_ += pos - begin;
+    if (lineStarts->size() == maxLines || !refill()) {
+      break;
+    }
+  }
+  return lineStarts->size();
+}
+
+bool LineBlockReader::refill() {
+  // Only the beginning of an incomplete line is left.
+  pending_.erase(0, offset_);
+  offset_ = 0;
+  while (pass_ < numPasses_) {
+    CharRange range;
+    (*provider_)(range);
+    if (range.start != nullptr) {
+      pending_.append(range.start, range.end);
+      return true;
+    }
+    ++pass_;
+    if (pass_ < numPasses_) {
+      provider_->reset();
+    }
+    if (!pending_.empty()) {
+      pending_.push_back('\n');
+      return true;
+    }
+  }
+  return false;
+}
+
 FileReader::FileReader(const std::string& path, size_t bufferSize)
     : bufferSize_(bufferSize), buffer_(new char[bufferSize]) {
   fd_ = open(path.c_str(), O_RDONLY, 0777);
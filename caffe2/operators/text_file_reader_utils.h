@@ -120,6 +120,34 @@ class BufferedTokenizer {
   int pass_{0};
 };
 
+// Cuts the stream of a StringProvider into blocks of whole lines, so that
+// the lines of a block can be parsed independently (e.g. on several threads).
+// The last line of every pass gets a '\n' if it had none. There is no escape
+// character: every '\n' ends a line.
+class LineBlockReader {
+ public:
+  explicit LineBlockReader(StringProvider* p, int numPasses = 1)
+      : provider_(p), numPasses_(numPasses) {}
+
+  // Replaces block with the next (up to) maxLines lines, and lineStarts with
+  // the offset of every line in block. Returns the number of lines, 0 once
+  // every pass is done.
+  size_t next(
+      size_t maxLines,
+      std::string* block,
+      std::vector<size_t>* lineStarts);
+
+ private:
+  bool refill();
+
+  StringProvider* provider_;
+  // Bytes read from the provider, pending_[offset_:] not returned yet.
+  std::string pending_;
+  size_t offset_{0};
+  int numPasses_;
+  int pass_{0};
+};
+
 class FileReader : public StringProvider {
  public:
   explicit FileReader(const std::string& path, size_t bufferSize = 65536);
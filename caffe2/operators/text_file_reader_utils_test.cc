@@ -135,4 +135,48 @@ TEST(TextFileReaderUtilsTest, TokenizeTest) {
   std::remove(tmpname);
 }
 
+TEST(TextFileReaderUtilsTest, LineBlockReaderTest) {
+  struct ChunkProvider : public StringProvider {
+    explicit ChunkProvider(const std::string& str) : ch(str) {}
+    std::string ch;
+    size_t charIdx{0};
+    void operator()(CharRange& range) override {
+      if (charIdx >= ch.size()) {
+        range.start = nullptr;
+        range.end = nullptr;
+      } else {
+        size_t endIdx = std::min(charIdx + 3, ch.size());
+        range.start = &ch.front() + charIdx;
+        range.end = &ch.front() + endIdx;
+        charIdx = endIdx;
+      }
+    }
+    void reset() override {
+      charIdx = 0;
+    }
+  };
+
+  // The last line has no '\n', and gets one at the end of every pass.
+  const std::vector<std::string> lines = {"a\t1", "", "bcdefgh\t2", "c\t3"};
+  ChunkProvider provider("a\t1\n\nbcdefgh\t2\nc\t3");
+  LineBlockReader reader(&provider, 2);
+  std::string block;
+  std::vector<size_t> lineStarts;
+  std::vector<std::string> read;
+  while (reader.next(3, &block, &lineStarts) > 0) {
+    EXPECT_LE(lineStarts.size(), 3);
+    EXPECT_EQ('\n', block.back());
+    for (int i = 0; i < lineStarts.size(); ++i) {
+      const size_t end =
+          i + 1 < lineStarts.size() ? lineStarts[i + 1] : block.size();
+      read.emplace_back(block, lineStarts[i], end - lineStarts[i] - 1);
+    }
+  }
+  ASSERT_EQ(2 * lines.size(), read.size());
+  for (int i = 0; i < read.size(); ++i) {
+    EXPECT_EQ(lines[i % lines.size()], read[i]);
+  }
+  EXPECT_EQ(0, reader.next(3, &block, &lineStarts));
+}
+
 } // namespace caffe2
@@ -0,0 +1,188 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/operators/top_k.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/top_k_hip.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Copies the first k sorted entries of every row. As rows are contiguous,
+// the position of a sorted entry in the input is also its flattened index.
+__global__ void TopKGatherKernel(const int outer_size,
+                                 const int inner_size,
+                                 const int k,
+                                 const float* sorted_keys,
+                                 const int* sorted_indices,
+                                 float* values,
+                                 TIndex* indices,
+                                 TIndex* flatten_indices)
+{
+    HIP_1D_KERNEL_LOOP(i, outer_size * k)
+    {
+        const int row  = i / k;
+        const int src  = row * inner_size + i % k;
+        values[i]      = sorted_keys[src];
+        indices[i]     = sorted_indices[src] - row * inner_size;
+        if(flatten_indices != nullptr)
+        {
+            flatten_indices[i] = sorted_indices[src];
+        }
+    }
+}
+
+__global__ void TopKScatterKernel(const int length,
+                                  const int k,
+                                  const int original_last_dim,
+                                  const float* values,
+                                  const TIndex* indices,
+                                  float* output)
+{
+    HIP_1D_KERNEL_LOOP(i, length)
+    {
+        output[(i / k) * original_last_dim + indices[i]] = values[i];
+    }
+}
+
+} // namespace
+
+template <>
+class TopKOp<float, HIPContext> : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+
+    TopKOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws), OP_SINGLE_ARG(int, "k", k_, -1)
+    {
+        CAFFE_ENFORCE(k_ >= 1, "k argument must be >= 1");
+    }
+
+    bool RunOnDevice() override
+    {
+        auto& input           = Input(0);
+        auto* values          = Output(0);
+        auto* indices         = Output(1);
+        auto* flatten_indices = OutputSize() > 2 ? Output(2) : nullptr;
+
+        vector<TIndex> in_dims = input.dims();
+        CAFFE_ENFORCE(in_dims.back() >= k_, "k argment should not be greater than last dim");
+
+        vector<TIndex> out_dims = in_dims;
+        out_dims.back()         = k_;
+        const int outer_size    = size_to_dim_(in_dims.size() - 1, in_dims);
+        const int inner_size    = in_dims.back();
+
+        values->Resize(out_dims);
+        indices->Resize(out_dims);
+        if(flatten_indices)
+        {
+            flatten_indices->Resize(outer_size * k_);
+        }
+        if(outer_size == 0)
+        {
+            values->mutable_data<float>();
+            indices->mutable_data<TIndex>();
+            if(flatten_indices)
+            {
+                flatten_indices->mutable_data<TIndex>();
+            }
+            return true;
+        }
+
+        offsets_.Resize(outer_size + 1);
+        hipLaunchKernelGGL((TopKUniformOffsetsKernel<int>),
+                           dim3(CAFFE_GET_BLOCKS(outer_size + 1)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           outer_size + 1,
+                           inner_size,
+                           offsets_.mutable_data<int>());
+        sorted_keys_.ResizeLike(input);
+        sorted_indices_.ResizeLike(input);
+        SegmentedSortDescending(input.size(),
+                                outer_size,
+                                input.data<float>(),
+                                offsets_.data<int>(),
+                                sorted_keys_.mutable_data<float>(),
+                                sorted_indices_.mutable_data<int>(),
+                                &scratch_,
+                                &context_);
+
+        hipLaunchKernelGGL((TopKGatherKernel),
+                           dim3(CAFFE_GET_BLOCKS(outer_size * k_)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           outer_size,
+                           inner_size,
+                           k_,
+                           sorted_keys_.data<float>(),
+                           sorted_indices_.data<int>(),
+                           values->mutable_data<float>(),
+                           indices->mutable_data<TIndex>(),
+                           flatten_indices ? flatten_indices->mutable_data<TIndex>() : nullptr);
+        return true;
+    }
+
+    private:
+    int k_;
+    Tensor<HIPContext> offsets_;
+    Tensor<HIPContext> sorted_keys_;
+    Tensor<HIPContext> sorted_indices_;
+    Tensor<HIPContext> scratch_;
+};
+
+template <>
+bool TopKGradientOp<float, HIPContext>::RunOnDevice()
+{
+    auto& values         = Input(0);
+    auto& indices        = Input(1);
+    auto& original_input = Input(2);
+    auto* output         = Output(0);
+
+    vector<TIndex> in_dims       = values.dims();
+    vector<TIndex> original_dims = original_input.dims();
+    output->Resize(original_dims);
+    float* output_data = output->mutable_data<float>();
+    math::Set<float, HIPContext>(output->size(), 0.0f, output_data, &context_);
+
+    const int length = values.size();
+    if(length == 0)
+    {
+        return true;
+    }
+    hipLaunchKernelGGL((TopKScatterKernel),
+                       dim3(CAFFE_GET_BLOCKS(length)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       length,
+                       static_cast<int>(in_dims.back()),
+                       static_cast<int>(original_dims.back()),
+                       values.data<float>(),
+                       indices.data<TIndex>(),
+                       output_data);
+    return true;
+}
+
+REGISTER_HIP_OPERATOR(TopK, TopKOp<float, HIPContext>);
+REGISTER_HIP_OPERATOR(TopKGradient, TopKGradientOp<float, HIPContext>);
+
+} // namespace caffe2
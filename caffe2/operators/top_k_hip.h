@@ -0,0 +1,122 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_OPERATORS_TOP_K_HIP_H_
+#define CAFFE2_OPERATORS_TOP_K_HIP_H_
+
+#include <hipcub/hipcub.hpp>
+#include "caffe2/core/context_hip.h"
+#include "caffe2/utils/math.h"
+#include "hip/hip_runtime.h"
+
+namespace caffe2 {
+
+// Device selection shared by the HIP TopK ops. Every segment is sorted with
+// hipcub's segmented radix sort instead of the heap / radix selection of the
+// CUDA TopK, which relies on 32 wide warps.
+
+template <typename Index>
+__global__ void TopKIotaKernel(const int n, Index* out)
+{
+    HIP_1D_KERNEL_LOOP(i, n) { out[i] = i; }
+}
+
+// offsets[i] = i * segment_size
+template <typename Index>
+__global__ void TopKUniformOffsetsKernel(const int n, const Index segment_size, Index* offsets)
+{
+    HIP_1D_KERNEL_LOOP(i, n) { offsets[i] = i * segment_size; }
+}
+
+// Sorts every segment [offsets[i], offsets[i + 1]) of keys in descending
+// order, and stores in sorted_indices the position in keys of every sorted
+// key. The sort is stable, so equal keys keep the lower index first, which
+// is the tie break of the CPU ops. offsets has num_segments + 1 entries.
+inline void SegmentedSortDescending(const int num_items,
+                                    const int num_segments,
+                                    const float* keys,
+                                    const int* offsets,
+                                    float* sorted_keys,
+                                    int* sorted_indices,
+                                    Tensor<HIPContext>* scratch,
+                                    HIPContext* context)
+{
+    size_t temp_storage_bytes = 0;
+    hipcub::DeviceSegmentedRadixSort::SortPairsDescending(nullptr,
+                                                          temp_storage_bytes,
+                                                          keys,
+                                                          sorted_keys,
+                                                          static_cast<const int*>(nullptr),
+                                                          sorted_indices,
+                                                          num_items,
+                                                          num_segments,
+                                                          offsets,
+                                                          offsets + 1,
+                                                          0,
+                                                          sizeof(float) * 8,
+                                                          context->hip_stream());
+    // The temporary storage comes first, followed by the unsorted indices.
+    const auto temp_ints = static_cast<TIndex>((temp_storage_bytes + sizeof(int) - 1) / sizeof(int));
+    scratch->Resize(temp_ints + num_items);
+    int* temp_storage = scratch->mutable_data<int>();
+    int* indices      = temp_storage + temp_ints;
+    hipLaunchKernelGGL((TopKIotaKernel<int>),
+                       dim3(CAFFE_GET_BLOCKS(num_items)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context->hip_stream(),
+                       num_items,
+                       indices);
+    hipcub::DeviceSegmentedRadixSort::SortPairsDescending(static_cast<void*>(temp_storage),
+                                                          temp_storage_bytes,
+                                                          keys,
+                                                          sorted_keys,
+                                                          indices,
+                                                          sorted_indices,
+                                                          num_items,
+                                                          num_segments,
+                                                          offsets,
+                                                          offsets + 1,
+                                                          0,
+                                                          sizeof(float) * 8,
+                                                          context->hip_stream());
+}
+
+// Fills offsets[0..n] with the exclusive prefix sums of lengths[0..n).
+template <typename T>
+void TopKLengthsToOffsets(
+    const int n, const T* lengths, T* offsets, Tensor<HIPContext>* scratch, HIPContext* context)
+{
+    math::Set<T, HIPContext>(1, 0, offsets, context);
+    if(n == 0)
+    {
+        return;
+    }
+    size_t temp_storage_bytes = 0;
+    hipcub::DeviceScan::InclusiveSum(
+        nullptr, temp_storage_bytes, lengths, offsets + 1, n, context->hip_stream());
+    scratch->Resize((temp_storage_bytes + sizeof(T) - 1) / sizeof(T));
+    hipcub::DeviceScan::InclusiveSum(static_cast<void*>(scratch->mutable_data<T>()),
+                                     temp_storage_bytes,
+                                     lengths,
+                                     offsets + 1,
+                                     n,
+                                     context->hip_stream());
+}
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_TOP_K_HIP_H_
@@ -26,15 +26,20 @@ namespace caffe2 {
 #define COMPILE_TIME_CUDA_MAX_TRANSPOSE_DIMS 6
 
 namespace {
-// TODO(jiayq): one possible optimization is to copy the buffer into a shared
-// memory location to speed up access.
+// Passed by value as a kernel argument, so no host to device copy is needed.
+struct TransposeParams {
+  int from_counts[COMPILE_TIME_CUDA_MAX_TRANSPOSE_DIMS];
+  int to_counts[COMPILE_TIME_CUDA_MAX_TRANSPOSE_DIMS];
+  int axes[COMPILE_TIME_CUDA_MAX_TRANSPOSE_DIMS];
+};
+
 template <typename Dtype>
 __global__ void transpose_gpu(const int nthreads, const Dtype* from_data,
-  Dtype* to_data, const int* buffer, const int num_axes) {
+  Dtype* to_data, const TransposeParams params, const int num_axes) {
   int from_inds[COMPILE_TIME_CUDA_MAX_TRANSPOSE_DIMS];
-  const int* from_counts = buffer;
-  const int* to_counts = buffer + num_axes;
-  const int* axes = buffer + num_axes * 2;
+  const int* from_counts = params.from_counts;
+  const int* to_counts = params.to_counts;
+  const int* axes = params.axes;
   CUDA_1D_KERNEL_LOOP(index, nthreads) {
     int from_index = index, to_index = 0;
     for (int i = num_axes - 1; i >= 0; --i) {
@@ -55,7 +60,7 @@ template <typename T>
 bool TransposeOp<CUDAContext>::DoRunWithType() {
   const auto& input = Input(0);
   auto* output = Output(0);
-  return TransposeCUDA<T>(axes_, context_, input, output, buffer_cpu_, buffer_);
+  return TransposeCUDA<T>(axes_, context_, input, output);
 }
 
 template <typename T>
@@ -63,9 +68,7 @@ bool TransposeCUDA(
     vector<int>& axes,
     CUDAContext& context,
     const Tensor<CUDAContext>& input,
-    Tensor<CUDAContext>* output,
-    TensorCPU& buffer_cpu,
-    Tensor<CUDAContext>& buffer) {
+    Tensor<CUDAContext>* output) {
   int count = input.size();
   int ndim = input.ndim();
   CAFFE_ENFORCE(
@@ -75,23 +78,12 @@ bool TransposeCUDA(
       ndim <= COMPILE_TIME_CUDA_MAX_TRANSPOSE_DIMS,
       "Input ndim exceeds compile time max.");
 
-  // Buffer contains the following data:
-  // (1) the dimenions of the inputs
-  // (2) the dimension of the outputs
-  // (3) the axis mapping from inputs to outputs
-  buffer_cpu.Resize(3 * ndim);
-  int* buffer_data = buffer_cpu.mutable_data<int>();
-  for (int i = 0; i < ndim; ++i) {
-    *(buffer_data++) = input.dim32(i);
-  }
-  for (int i = 0; i < ndim; ++i) {
-    *(buffer_data++) = output->dim32(i);
-  }
+  TransposeParams params;
   for (int i = 0; i < ndim; ++i) {
-    *(buffer_data++) = axes[i];
+    params.from_counts[i] = input.dim32(i);
+    params.to_counts[i] = output->dim32(i);
+    params.axes[i] = axes[i];
   }
-  // Copy the dimension information to GPU.
-  buffer.CopyFrom(buffer_cpu, &context);
   transpose_gpu<T>
       <<<CAFFE_GET_BLOCKS(count),
          CAFFE_CUDA_NUM_THREADS,
@@ -100,7 +92,7 @@ bool TransposeCUDA(
           count,
           input.template data<T>(),
           output->template mutable_data<T>(),
-          buffer.data<int>(),
+          params,
           ndim);
   return true;
 }
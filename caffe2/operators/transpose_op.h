@@ -71,10 +71,6 @@ class TransposeOp final : public Operator<Context> {
 
   std::vector<int> axes_;
   std::vector<TIndex> new_dims_;
-  // buffer_ is used in TransposeOp<CUDAContext> so we can obtain a consistent
-  // buffer on the GPU. It is not used in the CPUContext implementation.
-  Tensor<Context> buffer_;
-  TensorCPU buffer_cpu_;
 };
 
 } // namespace caffe2
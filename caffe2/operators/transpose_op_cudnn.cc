@@ -97,8 +97,7 @@ class CuDNNTransposeOp final : public Operator<CUDAContext> {
 #if CUDNN_VERSION_MIN(6, 0, 0)
     if (typedesc == CUDNN_DATA_INT32) {
       // CUDNN Transpose only support float for now
-      return TransposeCUDA<int>(
-          axes_, context_, input, output, buffer_cpu_, buffer_);
+      return TransposeCUDA<int>(axes_, context_, input, output);
     }
 #endif
 
@@ -155,10 +154,6 @@ class CuDNNTransposeOp final : public Operator<CUDAContext> {
   CuDNNWrapper cudnn_wrapper_;
   std::vector<int> axes_;
   std::vector<TIndex> new_dims_;
-
-  // This buffers are needed if need to call non-CUDNN version of transpose
-  Tensor<CUDAContext> buffer_;
-  TensorCPU buffer_cpu_;
 };
 
 REGISTER_CUDNN_OPERATOR(Transpose, CuDNNTransposeOp);
@@ -26,9 +26,7 @@ bool TransposeCUDA(
     vector<int>& axes,
     CUDAContext& context,
     const Tensor<CUDAContext>& input,
-    Tensor<CUDAContext>* output,
-    TensorCPU& buffer_cpu,
-    Tensor<CUDAContext>& buffer);
+    Tensor<CUDAContext>* output);
 }
 
 #endif // CAFFE2_OPERATORS_TRANSPOSE_H_
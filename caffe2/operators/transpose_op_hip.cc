@@ -14,12 +14,14 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
-
 #include "caffe2/operators/transpose_op.h"
 #include "caffe2/operators/transpose_op_hip.h"
 #include <limits>
 
 #include "caffe2/core/context_hip.h"
+#include "caffe2/core/kernel_autotune_hip.h"
+#include "caffe2/utils/fixed_divisor.h"
+#include "caffe2/utils/math_broadcast_hip.h"
 
 namespace caffe2 {
 
@@ -27,35 +29,191 @@ namespace caffe2 {
 #define COMPILE_TIME_HIP_MAX_TRANSPOSE_DIMS 6
 
 namespace {
-// TODO(jiayq): one possible optimization is to copy the buffer into a shared
-// memory location to speed up access.
-template <typename Dtype>
-__global__ void transpose_gpu(const int nthreads,
-                              const Dtype* from_data,
-                              Dtype* to_data,
-                              const int* buffer,
-                              const int num_axes)
+
+constexpr int kTransposeTileDim   = 32;
+constexpr int kTransposeBlockRows = 8;
+// Below this size of the two dims swapped by a tile, most of the threads of a
+// tiled transpose would be idle.
+constexpr int kTransposeMinTiledDim = 8;
+constexpr int kMaxGridDim           = 65535;
+
+// Passed by value as a kernel argument, so no host to device copy is needed.
+struct TransposeParams
+{
+    int ndim;
+    FixedDivisor<int32_t> y_dims[COMPILE_TIME_HIP_MAX_TRANSPOSE_DIMS];
+    // The stride in X of the axis behind every axis of Y.
+    int x_strides[COMPILE_TIME_HIP_MAX_TRANSPOSE_DIMS];
+};
+
+// Every thread writes one element of Y. When the innermost axis is kept the
+// reads are contiguous too.
+template <typename T>
+__global__ void TransposeKernel(const int nthreads, const TransposeParams p, const T* X, T* Y)
 {
-    int from_inds[COMPILE_TIME_HIP_MAX_TRANSPOSE_DIMS];
-    const int* from_counts = buffer;
-    const int* to_counts   = buffer + num_axes;
-    const int* axes        = buffer + num_axes * 2;
     HIP_1D_KERNEL_LOOP(index, nthreads)
     {
-        int from_index = index, to_index = 0;
-        for(int i = num_axes - 1; i >= 0; --i)
+        int remaining = index;
+        int x_index   = 0;
+        for(int i = p.ndim - 1; i >= 0; --i)
+        {
+            int q, r;
+            p.y_dims[i].divMod(remaining, q, r);
+            x_index += r * p.x_strides[i];
+            remaining = q;
+        }
+        Y[index] = X[x_index];
+    }
+}
+
+struct TiledTransposeParams
+{
+    // The tile swaps the innermost axis of X, of size cols, with the axis that
+    // becomes the innermost axis of Y, of size rows.
+    int rows;
+    int cols;
+    int x_row_stride;
+    int y_col_stride;
+    // The remaining axes, in the order of Y.
+    int batch_ndim;
+    FixedDivisor<int32_t> batch_dims[COMPILE_TIME_HIP_MAX_TRANSPOSE_DIMS];
+    int batch_x_strides[COMPILE_TIME_HIP_MAX_TRANSPOSE_DIMS];
+    int batch_y_strides[COMPILE_TIME_HIP_MAX_TRANSPOSE_DIMS];
+};
+
+// Every block transposes a kTransposeTileDim square through shared memory, so
+// that both the reads from X and the writes to Y are coalesced.
+template <typename T>
+__global__ void TiledTransposeKernel(const int batch, const TiledTransposeParams p, const T* X, T* Y)
+{
+    __shared__ T tile[kTransposeTileDim][kTransposeTileDim + 1];
+    const int r0 = hipBlockIdx_y * kTransposeTileDim;
+    const int c0 = hipBlockIdx_x * kTransposeTileDim;
+    for(int b = hipBlockIdx_z; b < batch; b += hipGridDim_z)
+    {
+        int remaining = b;
+        int x_offset  = 0;
+        int y_offset  = 0;
+        for(int i = p.batch_ndim - 1; i >= 0; --i)
+        {
+            int q, r;
+            p.batch_dims[i].divMod(remaining, q, r);
+            x_offset += r * p.batch_x_strides[i];
+            y_offset += r * p.batch_y_strides[i];
+            remaining = q;
+        }
+        const int c = c0 + hipThreadIdx_x;
+        for(int j = hipThreadIdx_y; j < kTransposeTileDim; j += kTransposeBlockRows)
         {
-            from_inds[i] = from_index % from_counts[i];
-            from_index   = from_index / from_counts[i];
+            const int r = r0 + j;
+            if(r < p.rows && c < p.cols)
+            {
+                tile[j][hipThreadIdx_x] = X[x_offset + r * p.x_row_stride + c];
+            }
         }
-        for(int i = 0; i < num_axes - 1; i++)
+        __syncthreads();
+        const int r = r0 + hipThreadIdx_x;
+        for(int j = hipThreadIdx_y; j < kTransposeTileDim; j += kTransposeBlockRows)
         {
-            to_index = (to_index + from_inds[axes[i]]) * to_counts[i + 1];
+            const int col = c0 + j;
+            if(r < p.rows && col < p.cols)
+            {
+                Y[y_offset + col * p.y_col_stride + r] = tile[hipThreadIdx_x][j];
+            }
         }
-        to_index += from_inds[axes[num_axes - 1]];
-        to_data[to_index] = from_data[index];
+        __syncthreads();
     }
 }
+
+// Drops the axes of size 1 and merges the axes of X that stay next to each
+// other in Y, e.g. NCHW -> NHWC becomes (N, C, HW) -> (N, HW, C).
+void SimplifyTranspose(const vector<int>& x_dims,
+                       const vector<int>& axes,
+                       vector<int>* dims,
+                       vector<int>* perm)
+{
+    const int ndim = x_dims.size();
+    vector<int> reduced(ndim, -1);
+    vector<int> reduced_dims;
+    for(int i = 0; i < ndim; ++i)
+    {
+        if(x_dims[i] != 1)
+        {
+            reduced[i] = reduced_dims.size();
+            reduced_dims.push_back(x_dims[i]);
+        }
+    }
+    vector<int> reduced_perm;
+    for(const int axis : axes)
+    {
+        if(reduced[axis] >= 0)
+        {
+            reduced_perm.push_back(reduced[axis]);
+        }
+    }
+    const int reduced_ndim = reduced_dims.size();
+    vector<int> position(reduced_ndim);
+    for(int i = 0; i < reduced_ndim; ++i)
+    {
+        position[reduced_perm[i]] = i;
+    }
+    vector<int> merged(reduced_ndim);
+    dims->clear();
+    for(int i = 0; i < reduced_ndim; ++i)
+    {
+        if(i > 0 && position[i] == position[i - 1] + 1)
+        {
+            merged[i] = merged[i - 1];
+            dims->back() *= reduced_dims[i];
+        }
+        else
+        {
+            merged[i] = dims->size();
+            dims->push_back(reduced_dims[i]);
+        }
+    }
+    perm->clear();
+    for(int i = 0; i < reduced_ndim; ++i)
+    {
+        const int axis = reduced_perm[i];
+        if(axis == 0 || merged[axis] != merged[axis - 1])
+        {
+            perm->push_back(merged[axis]);
+        }
+    }
+}
+
+template <typename T>
+void LaunchTranspose(const vector<int>& dims,
+                     const vector<int>& perm,
+                     const vector<int>& x_strides,
+                     const int count,
+                     const T* X,
+                     T* Y,
+                     HIPContext& context)
+{
+    TransposeParams p;
+    p.ndim = dims.size();
+    for(int i = 0; i < p.ndim; ++i)
+    {
+        p.y_dims[i]    = FixedDivisor<int32_t>(dims[perm[i]]);
+        p.x_strides[i] = x_strides[perm[i]];
+    }
+    // X and Y never alias, the kernel can always be tuned.
+    HipTunedLaunch(
+        "Transpose", count, context.hip_stream(), true, [&](const HipLaunchConfig& config) {
+            hipLaunchKernelGGL((TransposeKernel<T>),
+                               dim3(config.blocks(count)),
+                               dim3(config.threads),
+                               0,
+                               context.hip_stream(),
+                               count,
+                               p,
+                               X,
+                               Y);
+        });
+}
+
 } // namespace
 
 template <>
@@ -64,54 +222,115 @@ bool TransposeOp<HIPContext>::DoRunWithType()
 {
     const auto& input = Input(0);
     auto* output      = Output(0);
-    return TransposeHIP<T>(axes_, context_, input, output, buffer_cpu_, buffer_);
+    return TransposeHIP<T>(axes_, context_, input, output);
 }
 
 template <typename T>
-bool TransposeHIP(vector<int>& axes,
+bool TransposeHIP(const vector<int>& axes,
                   HIPContext& context,
                   const Tensor<HIPContext>& input,
-                  Tensor<HIPContext>* output,
-                  TensorCPU& buffer_cpu,
-                  Tensor<HIPContext>& buffer)
+                  Tensor<HIPContext>* output)
 {
     int count = input.size();
-    int ndim  = input.ndim();
     CAFFE_ENFORCE(count < std::numeric_limits<int>::max(),
                   "Transpose op on GPU only supports int32");
+    const T* X = input.template data<T>();
+    T* Y       = output->template mutable_data<T>();
+    if(count == 0)
+    {
+        return true;
+    }
+
+    vector<int> dims, perm;
+    SimplifyTranspose(vector<int>(input.dims().begin(), input.dims().end()), axes, &dims, &perm);
+    const int ndim = dims.size();
     CAFFE_ENFORCE(ndim <= COMPILE_TIME_HIP_MAX_TRANSPOSE_DIMS,
                   "Input ndim exceeds compile time max.");
+    // Nothing moves: the data keeps its layout.
+    if(ndim <= 1)
+    {
+        context.template Copy<T, HIPContext, HIPContext>(count, X, Y);
+        return true;
+    }
 
-    // Buffer contains the following data:
-    // (1) the dimenions of the inputs
-    // (2) the dimension of the outputs
-    // (3) the axis mapping from inputs to outputs
-    buffer_cpu.Resize(3 * ndim);
-    int* buffer_data = buffer_cpu.mutable_data<int>();
-    for(int i = 0; i < ndim; ++i)
+    vector<int> x_strides(ndim), y_strides(ndim);
+    x_strides[ndim - 1] = 1;
+    y_strides[ndim - 1] = 1;
+    for(int i = ndim - 2; i >= 0; --i)
     {
-        *(buffer_data++) = input.dim32(i);
+        x_strides[i] = x_strides[i + 1] * dims[i + 1];
+        y_strides[i] = y_strides[i + 1] * dims[perm[i + 1]];
     }
-    for(int i = 0; i < ndim; ++i)
+
+    const int inner = perm[ndim - 1];
+    if(inner == ndim - 1)
     {
-        *(buffer_data++) = output->dim32(i);
+        // The innermost axis is kept, so whole rows are copied. Move four
+        // elements at a time when the rows allow it.
+        if(dims[inner] % 4 == 0 && IsPack4Aligned(X) && IsPack4Aligned(Y))
+        {
+            vector<int> packed_dims(dims), packed_strides(x_strides);
+            packed_dims[inner] /= 4;
+            for(int i = 0; i < ndim - 1; ++i)
+            {
+                packed_strides[i] /= 4;
+            }
+            LaunchTranspose(packed_dims,
+                            perm,
+                            packed_strides,
+                            count / 4,
+                            reinterpret_cast<const Pack4<T>*>(X),
+                            reinterpret_cast<Pack4<T>*>(Y),
+                            context);
+        }
+        else
+        {
+            LaunchTranspose(dims, perm, x_strides, count, X, Y, context);
+        }
+        return true;
     }
+
+    const int rows      = dims[inner];
+    const int cols      = dims[ndim - 1];
+    const int row_tiles = (rows + kTransposeTileDim - 1) / kTransposeTileDim;
+    const int col_tiles = (cols + kTransposeTileDim - 1) / kTransposeTileDim;
+    if(std::min(rows, cols) < kTransposeMinTiledDim || row_tiles > kMaxGridDim ||
+       col_tiles > kMaxGridDim)
+    {
+        LaunchTranspose(dims, perm, x_strides, count, X, Y, context);
+        return true;
+    }
+
+    TiledTransposeParams p;
+    p.rows         = rows;
+    p.cols         = cols;
+    p.x_row_stride = x_strides[inner];
+    p.batch_ndim   = 0;
+    int batch      = 1;
     for(int i = 0; i < ndim; ++i)
     {
-        *(buffer_data++) = axes[i];
+        if(perm[i] == ndim - 1)
+        {
+            p.y_col_stride = y_strides[i];
+        }
+        else if(perm[i] != inner)
+        {
+            p.batch_dims[p.batch_ndim]      = FixedDivisor<int32_t>(dims[perm[i]]);
+            p.batch_x_strides[p.batch_ndim] = x_strides[perm[i]];
+            p.batch_y_strides[p.batch_ndim] = y_strides[i];
+            ++p.batch_ndim;
+            batch *= dims[perm[i]];
+        }
     }
-    // Copy the dimension information to GPU.
-    buffer.CopyFrom(buffer_cpu, &context);
-    hipLaunchKernelGGL((transpose_gpu<T>),
-                       dim3(CAFFE_GET_BLOCKS(count)),
-                       dim3(CAFFE_HIP_NUM_THREADS),
+    hipLaunchKernelGGL((TiledTransposeKernel<T>),
+                       dim3(col_tiles, row_tiles, std::min(batch, kMaxGridDim)),
+                       dim3(kTransposeTileDim, kTransposeBlockRows),
                        0,
                        context.hip_stream(),
-                       count,
-                       input.template data<T>(),
-                       output->template mutable_data<T>(),
-                       buffer.data<int>(),
-                       ndim);
+                       batch,
+                       p,
+                       X,
+                       Y);
     return true;
 }
 
@@ -21,13 +21,12 @@
 
 namespace caffe2 {
 
+// Writes output, already resized, as input with its dims permuted by axes.
 template <typename T>
-bool TransposeHIP(vector<int>& axes,
+bool TransposeHIP(const vector<int>& axes,
                   HIPContext& context,
                   const Tensor<HIPContext>& input,
-                  Tensor<HIPContext>* output,
-                  TensorCPU& buffer_cpu,
-                  Tensor<HIPContext>& buffer);
+                  Tensor<HIPContext>* output);
 }
 
 #endif // CAFFE2_OPERATORS_TRANSPOSE_H_
@@ -17,6 +17,32 @@
 #include "caffe2/operators/tt_linear_op.h"
 
 namespace caffe2 {
+
+template <>
+void TTPermuteCore<float, CPUContext>(
+    const int rows,
+    const int rank,
+    const int out,
+    const float* core,
+    float* permuted,
+    CPUContext* context) {
+  math::Transpose<float, CPUContext>(
+      {rows, rank, out}, {out, rows, rank}, {2, 0, 1}, core, permuted, context);
+}
+
+template <>
+void TTTransposeAddBias<float, CPUContext>(
+    const int rows,
+    const int cols,
+    const float* X,
+    const float* bias,
+    float* Y,
+    CPUContext* /* context */) {
+  EigenMatrixMap<float> Y_mat(Y, rows, cols);
+  Y_mat = ConstEigenMatrixMap<float>(X, cols, rows).transpose();
+  Y_mat.colwise() += ConstEigenVectorMap<float>(bias, rows);
+}
+
 namespace {
 
 REGISTER_CPU_OPERATOR(TT, TTLinearOp<float, CPUContext>);
@@ -29,6 +29,27 @@
 
 namespace caffe2 {
 
+// Permutes a TT-core from (rows, rank, out) to (out, rows, rank), so that the
+// product with the core lands in the order the next core reads it.
+template <typename T, class Context>
+void TTPermuteCore(
+    const int rows,
+    const int rank,
+    const int out,
+    const T* core,
+    T* permuted,
+    Context* context);
+
+// Y = trans(X) + bias, X being rows-by-cols and bias of size rows.
+template <typename T, class Context>
+void TTTransposeAddBias(
+    const int rows,
+    const int cols,
+    const T* X,
+    const T* bias,
+    T* Y,
+    Context* context);
+
 template <typename T, class Context, class Engine = DefaultEngine>
 class TTLinearOp final : public Operator<Context> {
  public:
@@ -37,8 +58,7 @@ class TTLinearOp final : public Operator<Context> {
       : Operator<Context>(operator_def, ws),
         inp_sizes_(OperatorBase::GetRepeatedArgument<int>("inp_sizes")),
         out_sizes_(OperatorBase::GetRepeatedArgument<int>("out_sizes")),
-        tt_ranks_(OperatorBase::GetRepeatedArgument<int>("tt_ranks")),
-        Y_temp_(unique_ptr<Blob>(new Blob())) {}
+        tt_ranks_(OperatorBase::GetRepeatedArgument<int>("tt_ranks")) {}
   ~TTLinearOp() {}
 
   bool RunOnDevice() override {
@@ -55,6 +75,12 @@ class TTLinearOp final : public Operator<Context> {
         inp_sizes_.size(),
         ", out_sizes has size: ",
         out_sizes_.size());
+    CAFFE_ENFORCE(
+        tt_ranks_.size() == inp_sizes_.size() + 1,
+        "tt_ranks has size: ",
+        tt_ranks_.size(),
+        ", inp_sizes has size: ",
+        inp_sizes_.size());
     CAFFE_ENFORCE(
         cores.ndim() == 1, "Number of dimensions in cores: ", cores.ndim());
     // batch size
@@ -62,14 +88,16 @@ class TTLinearOp final : public Operator<Context> {
 
     // dimension d of tensors
     const int d = inp_sizes_.size();
+    CAFFE_ENFORCE_GT(d, 0);
 
     // Keep track of index of current core in multiplication
     int cores_idx = 0;
 
-    // Temporary buffer to facilitate multiplication of TT-cores with input
-    auto Y_buf = Y_temp_->GetMutable<Tensor<Context>>();
-    Y_buf->ResizeLike(X);
-    Y_buf->CopyFrom(X);
+    // The intermediate outputs alternate between the two buffers, the first
+    // core reads X directly.
+    const T* Y_buf = X.template data<T>();
+    int Y_buf_size = X.size();
+    int curr_buf = 0;
 
     // The overall forward pass involves multiplication with each core, where
     // each core has sizes dictated by inp_sizes_ and out_sizes_. Each core thus
@@ -78,108 +106,82 @@ class TTLinearOp final : public Operator<Context> {
       int curr_rows = inp_sizes_[i] * tt_ranks_[i + 1];
       int curr_cols = tt_ranks_[i] * out_sizes_[i];
 
-      // TODO Replace by Reshape(), once wrappers are written
-      Y_buf->Resize(Y_buf->size() / curr_rows, curr_rows);
-      Y->Resize(Y_buf->size() / curr_rows, curr_cols);
-
       // Defensive checks
-      CAFFE_ENFORCE(Y_buf->size() % curr_rows == 0, Y_buf->size(), curr_rows);
+      CAFFE_ENFORCE(Y_buf_size % curr_rows == 0, Y_buf_size, curr_rows);
       CAFFE_ENFORCE(
           cores_idx + curr_rows * curr_cols <= cores.size(),
           cores_idx + curr_rows * curr_cols,
           cores.size());
-
-      // Multiply ith core with the intermediate output
-      math::Gemm<float, Context, Engine>(
+      const int M = Y_buf_size / curr_rows;
+
+      // The product of the intermediate output (M-by-curr_rows) with the ith
+      // core is needed with the out_sizes_[i] dimension moved first. With the
+      // core permuted accordingly, it is one GEMM per output index, all in a
+      // single batched GEMM, writing an M-by-tt_ranks_[i] block each.
+      permuted_core_.Resize(curr_rows * curr_cols);
+      TTPermuteCore<T, Context>(
+          curr_rows,
+          tt_ranks_[i],
+          out_sizes_[i],
+          cores.template data<T>() + cores_idx,
+          permuted_core_.template mutable_data<T>(),
+          &context_);
+      buffers_[curr_buf].Resize(M * curr_cols);
+      math::GemmStridedBatched<T, Context, Engine>(
           CblasNoTrans,
           CblasNoTrans,
-          Y_buf->size() / curr_rows,
-          curr_cols,
+          out_sizes_[i],
+          M,
+          tt_ranks_[i],
           curr_rows,
           1,
-          Y_buf->template data<float>(),
-          cores.template data<float>() + cores_idx,
+          Y_buf,
           0,
-          Y->template mutable_data<float>(),
+          permuted_core_.template data<T>(),
+          curr_rows * tt_ranks_[i],
+          0,
+          buffers_[curr_buf].template mutable_data<T>(),
+          M * tt_ranks_[i],
           &context_);
 
-      CAFFE_ENFORCE(Y->size() % out_sizes_[i] == 0, Y->size(), out_sizes_[i]);
-
-      // TODO Add GPU support by writing a generic wrapper.
-      auto Y_mat = EigenMatrixMap<float>(
-          Y->template mutable_data<float>(),
-          Y->size() / out_sizes_[i],
-          out_sizes_[i]);
-      Y_mat = ConstEigenMatrixMap<float>(
-                  Y->template data<float>(),
-                  out_sizes_[i],
-                  Y->size() / out_sizes_[i])
-                  .transpose()
-                  .eval();
-
-      // Resize operation
-      Y_buf->Resize(Y->dim32(0), Y->dim32(1));
-      context_.template Copy<float, CPUContext, CPUContext>(
-          Y->size(),
-          Y->template data<float>(),
-          Y_buf->template mutable_data<float>());
-
+      Y_buf = buffers_[curr_buf].template data<T>();
+      Y_buf_size = M * curr_cols;
+      curr_buf ^= 1;
       cores_idx += curr_rows * curr_cols;
     }
 
-    // TODO Add GPU support by writing a generic wrapper.
-    auto Y_mat = EigenMatrixMap<float>(
-        Y->template mutable_data<float>(), batch_size, Y->size() / batch_size);
-    Y_mat = ConstEigenMatrixMap<float>(
-                Y->template data<float>(), Y->size() / batch_size, batch_size)
-                .transpose()
-                .eval();
-    // TODO Replace by Reshape(), once wrappers are written
-    Y->Resize(batch_size, Y->size() / batch_size);
-
     // Check that output size of Y is the element-wise product of out_sizes
     int prod_out_sizes = 1;
     for (int i = 0; i < out_sizes_.size(); i++) {
       prod_out_sizes *= out_sizes_[i];
     }
     CAFFE_ENFORCE(
-        Y->dim32(1) == prod_out_sizes,
-        "Output dimension of Y: ",
-        Y->dim32(1),
-        ", product of out_sizes: ",
-        prod_out_sizes);
-
-    // Add bias term
-    if (bias_multiplier_.size() != batch_size) {
-      // If the helper bias multiplier is not M, reshape and fill it with one.
-      bias_multiplier_.Resize(batch_size);
-      math::Set<T, Context>(
-          batch_size,
-          static_cast<T>(1),
-          bias_multiplier_.template mutable_data<T>(),
-          &context_);
-    }
-    math::Gemm<T, Context, Engine>(
-        CblasNoTrans,
-        CblasNoTrans,
-        Y->dim32(0),
-        Y->dim32(1),
-        1,
-        1,
-        bias_multiplier_.template data<T>(),
+        Y_buf_size == batch_size * prod_out_sizes,
+        "Output size of Y: ",
+        Y_buf_size,
+        ", batch size times product of out_sizes: ",
+        batch_size * prod_out_sizes);
+    CAFFE_ENFORCE_EQ(b.dim32(0), prod_out_sizes);
+
+    // The batch is the last dimension of the intermediate output, Y is its
+    // transpose, and the bias is added on the way.
+    Y->Resize(batch_size, prod_out_sizes);
+    TTTransposeAddBias<T, Context>(
+        prod_out_sizes,
+        batch_size,
+        Y_buf,
         b.template data<T>(),
-        1,
         Y->template mutable_data<T>(),
         &context_);
     return true;
   }
 
  protected:
-  Tensor<Context> bias_multiplier_;
   std::vector<int> inp_sizes_;
   std::vector<int> out_sizes_;
   std::vector<int> tt_ranks_;
-  std::unique_ptr<Blob> Y_temp_;
+  Tensor<Context> permuted_core_;
+  Tensor<Context> buffers_[2];
 };
 
 // TODO: Complete after verifying utility of TT-layer's forward pass.
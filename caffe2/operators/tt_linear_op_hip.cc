@@ -0,0 +1,106 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hip/hip_runtime.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/operators/tt_linear_op.h"
+
+namespace caffe2 {
+
+namespace {
+
+__global__ void tt_permute_core_kernel(
+    const int n, const int rows, const int rank, const int out, const float* core, float* permuted)
+{
+    HIP_1D_KERNEL_LOOP(index, n)
+    {
+        // index runs over the permuted (out, rows, rank) core.
+        const int r     = index % rank;
+        const int k     = index / rank % rows;
+        const int o     = index / rank / rows;
+        permuted[index] = core[(k * rank + r) * out + o];
+    }
+}
+
+__global__ void tt_transpose_add_bias_kernel(
+    const int n, const int rows, const int cols, const float* X, const float* bias, float* Y)
+{
+    HIP_1D_KERNEL_LOOP(index, n)
+    {
+        // index runs over Y, cols-by-rows, so that the writes are coalesced.
+        const int i = index % rows;
+        const int j = index / rows;
+        Y[index]    = X[i * cols + j] + bias[i];
+    }
+}
+
+} // namespace
+
+template <>
+void TTPermuteCore<float, HIPContext>(const int rows,
+                                      const int rank,
+                                      const int out,
+                                      const float* core,
+                                      float* permuted,
+                                      HIPContext* context)
+{
+    const int n = rows * rank * out;
+    if(n == 0)
+    {
+        return;
+    }
+    hipLaunchKernelGGL(tt_permute_core_kernel,
+                       dim3(CAFFE_GET_BLOCKS(n)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context->hip_stream(),
+                       n,
+                       rows,
+                       rank,
+                       out,
+                       core,
+                       permuted);
+}
+
+template <>
+void TTTransposeAddBias<float, HIPContext>(const int rows,
+                                           const int cols,
+                                           const float* X,
+                                           const float* bias,
+                                           float* Y,
+                                           HIPContext* context)
+{
+    const int n = rows * cols;
+    if(n == 0)
+    {
+        return;
+    }
+    hipLaunchKernelGGL(tt_transpose_add_bias_kernel,
+                       dim3(CAFFE_GET_BLOCKS(n)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context->hip_stream(),
+                       n,
+                       rows,
+                       cols,
+                       X,
+                       bias,
+                       Y);
+}
+
+REGISTER_HIP_OPERATOR(TT, TTLinearOp<float, HIPContext>);
+
+} // namespace caffe2
@@ -96,6 +96,13 @@ REGISTER_CPU_OPERATOR(
     CopyOnDeviceLike,
     CopyOnDeviceLikeOp<CPUContext, CPUContext, CPUContext>);
 REGISTER_CPU_OPERATOR(Copy, CopyOp<CPUContext, CPUContext, CPUContext>);
+// On CPU there is nothing to wait for, the copy is done right away.
+REGISTER_CPU_OPERATOR(
+    AsyncCopyToHost,
+    CopyOp<CPUContext, CPUContext, CPUContext>);
+REGISTER_CPU_OPERATOR(
+    CopyToManaged,
+    CopyOp<CPUContext, CPUContext, CPUContext>);
 REGISTER_CPU_OPERATOR(LengthsToShape, LengthsToShapeOp<CPUContext>);
 REGISTER_CPU_OPERATOR(HasElements, HasElementsOp<CPUContext>);
 REGISTER_CPU_OPERATOR(IsEmpty, IsEmptyOp<CPUContext>);
@@ -331,6 +338,56 @@ Copy tensor for GPU to CPU context. Must be run under GPU device option.
     .Input(0, "input", "The input tensor.")
     .Output(0, "output", "Tensor that will contain a copy of the input.");
 
+OPERATOR_SCHEMA(AsyncCopyToHost)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .InputsCanCrossDevices()
+    .DeviceInferenceFunction([](const OperatorDef& def) {
+      vector<DeviceOption> in_dev(def.input_size(), def.device_option());
+      vector<DeviceOption> out_dev(def.output_size(), DeviceOption());
+      return std::make_pair(in_dev, out_dev);
+    })
+    .SetDoc(R"DOC(
+Copies the input to a CPU tensor without blocking on the device, for fetching
+metrics such as the accumulators of AccumulateAccuracy while training runs.
+
+On GPU every run hands out the copy started by an earlier run if it has
+finished, and starts a new one; when the previous copy is still in flight the
+output is left as it is. The output thus lags the input by at least one run,
+and is empty until the first copy has finished. On CPU this is a plain Copy.
+The copy only overlaps with the computation under the async executors: the
+simple net waits for the stream of every op.
+)DOC")
+    .Input(0, "input", "The input tensor.")
+    .Output(0, "output", "CPU tensor with the input of an earlier run.");
+
+OPERATOR_SCHEMA(CopyToManaged)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .IdenticalTypeAndShape()
+    .InputsCanCrossDevices()
+    .DeviceInferenceFunction([](const OperatorDef& def) {
+      auto op_device =
+          def.has_device_option() ? def.device_option() : DeviceOption();
+      vector<DeviceOption> in_dev(def.input_size(), DeviceOption());
+      vector<DeviceOption> out_dev(def.output_size(), op_device);
+      return std::make_pair(in_dev, out_dev);
+    })
+    .SetDoc(R"DOC(
+Copies a CPU tensor into managed memory on HIP, for embedding tables that do
+not fit in the device memory. The pages of the output prefer the host and are
+mapped for the device, which faults in what it reads; pair the table with the
+MANAGED engine of SparseLengths[Sum,WeightedSum,Mean] to keep its most used
+rows on the device. Ops that resize the output reallocate it in device memory.
+On CPU this is a plain Copy.
+)DOC")
+    .Arg(
+        "read_mostly",
+        "1 to let the device keep read-only copies of the pages it reads. "
+        "Only for tables that are not trained. Defaults to 0")
+    .Input(0, "input", "The input CPU tensor.")
+    .Output(0, "output", "Tensor in managed memory with a copy of the input.");
+
 OPERATOR_SCHEMA(CopyCPUToGPU)
     .NumInputs(1)
     .NumOutputs(1)
@@ -886,6 +943,8 @@ struct GetCPUToGPUGradient : public GradientMakerBase {
   }
 };
 REGISTER_GRADIENT(CopyCPUToGPU, GetCPUToGPUGradient);
+SHOULD_NOT_DO_GRADIENT(AsyncCopyToHost);
+SHOULD_NOT_DO_GRADIENT(CopyToManaged);
 
 SHOULD_NOT_DO_GRADIENT(Unique);
 SHOULD_NOT_DO_GRADIENT(LengthsToSegmentIds);
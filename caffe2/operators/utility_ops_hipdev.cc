@@ -26,6 +26,7 @@
 #include <thrust/system/cuda/execution_policy.h>
 #include <thrust/unique.h>
 #include "caffe2/core/context_hip.h"
+#include "caffe2/operators/row_copy_hip.h"
 #include "flatten_op.h"
 #include "minmax_ops.h"
 #include "utility_ops.h"
@@ -227,16 +228,21 @@ bool SelectGradientOpBase<float, HIPContext>::RunOnDevice()
     return true;
 }
 
-template <typename T_INDEX>
-__global__ void
-GatherKernel(const float* X, float* Y, const T_INDEX* indices, const int N, const int block_size)
+template <typename T_INDEX, typename W>
+__global__ void GatherKernel(const W* X,
+                             W* Y,
+                             const T_INDEX* indices,
+                             const TIndex N,
+                             const TIndex num_rows,
+                             const TIndex row_words)
 {
-    for(int i = hipBlockIdx_x; i < N; i += hipGridDim_x)
+    HIP_ROW_LOOP(i, N)
     {
-        T_INDEX idx             = indices[i];
-        const float* src_offset = X + idx * block_size;
-        float* dst_offset       = Y + i * block_size;
-        for(int j = hipThreadIdx_x; j < block_size; j += hipBlockDim_x)
+        const T_INDEX idx = indices[i];
+        HIP_KERNEL_ASSERT(0 <= idx && idx < num_rows);
+        const W* src_offset = X + idx * row_words;
+        W* dst_offset       = Y + i * row_words;
+        HIP_ROW_WORD_LOOP(j, row_words)
         {
             dst_offset[j] = src_offset[j];
         }
@@ -263,33 +269,40 @@ bool GatherOp<HIPContext>::DoRunWithType()
     shape.insert(shape.end(), data.dims().begin() + 1, data.dims().end());
     output->Resize(shape);
 
-    int block_size      = data.size() / data.dim(0);
     auto block_bytesize = data.size_from_dim(1) * data.meta().itemsize();
     CAFFE_ENFORCE(block_bytesize == data.nbytes() / data.dim(0),
                   "block_bytesize should be consistent with data dim");
-    int N = indices.size();
+    const TIndex N = indices.size();
 
-    auto src_base     = static_cast<const float*>(data.raw_data());
+    auto src_base     = data.raw_data();
     const Index* idxs = indices.template data<Index>();
-    auto out          = static_cast<float*>(output->raw_mutable_data(data.meta()));
+    auto out          = output->raw_mutable_data(data.meta());
 
     // return early when the input is empty, since HIP kernel will fail for
     // empty input.
-    if(N <= 0)
+    if(N <= 0 || block_bytesize == 0)
     {
         return true;
     }
 
-    hipLaunchKernelGGL((GatherKernel),
-                       dim3(std::min(N, CAFFE_MAXIMUM_NUM_BLOCKS)),
-                       dim3(CAFFE_HIP_NUM_THREADS),
-                       0,
-                       context_.hip_stream(),
-                       src_base,
-                       out,
-                       idxs,
-                       static_cast<const int>(N),
-                       static_cast<const int>(block_size));
+    // Rows are moved as raw words, so any type of data can be gathered.
+    const int word_size = RowCopyWordSize(block_bytesize, {src_base, out});
+    const TIndex words  = block_bytesize / word_size;
+    const dim3 block    = RowCopyBlock(words);
+#define GATHER_LAUNCH(W)                                    \
+    hipLaunchKernelGGL((GatherKernel<Index, W>),            \
+                       RowCopyGrid(N, block),               \
+                       block,                               \
+                       0,                                   \
+                       context_.hip_stream(),               \
+                       static_cast<const W*>(src_base),     \
+                       static_cast<W*>(out),                \
+                       idxs,                                \
+                       N,                                   \
+                       data.dim(0),                         \
+                       words)
+    DISPATCH_ROW_COPY_WORD(word_size, GATHER_LAUNCH);
+#undef GATHER_LAUNCH
     return true;
 }
 
@@ -301,8 +314,10 @@ REGISTER_HIP_OPERATOR(Gather, GatherOp<HIPContext>);
  * i=0,...,N-1
  * b=0,...,B-1
  * idx=Indices[i]
+ * The slices are read kVec floats at a time and laid out as rows of words,
+ * see row_copy_hip.h; repeated indices are handled by the atomic adds.
  */
-template <typename T_INDEX>
+template <typename T_INDEX, int kVec>
 __global__ void AxpySliceKernel(const float* weight0,
                                 const TIndex N,
                                 const TIndex B,
@@ -315,7 +330,8 @@ __global__ void AxpySliceKernel(const float* weight0,
 {
     // This implementation requires that the first weight is 1.0
     HIP_KERNEL_ASSERT(weight0[0] == 1.0);
-    for(int i = hipBlockIdx_x; i < N; i += hipGridDim_x)
+    const TIndex slice_words = slice_size / kVec;
+    HIP_ROW_LOOP(i, N)
     {
         T_INDEX idx     = Indices[i];
         float* y_offset = Y + (idx * slice_size);
@@ -323,9 +339,20 @@ __global__ void AxpySliceKernel(const float* weight0,
         {
             float a               = *alpha[b];
             const float* x_offset = X[b] + (i * slice_size);
-            for(int j = hipThreadIdx_x; j < slice_size; j += hipBlockDim_x)
+            HIP_ROW_WORD_LOOP(j, slice_words)
             {
-                atomicAdd(&y_offset[j], a * x_offset[j]);
+                if(kVec == 4)
+                {
+                    const float4 x = reinterpret_cast<const float4*>(x_offset)[j];
+                    atomicAdd(&y_offset[j * 4], a * x.x);
+                    atomicAdd(&y_offset[j * 4 + 1], a * x.y);
+                    atomicAdd(&y_offset[j * 4 + 2], a * x.z);
+                    atomicAdd(&y_offset[j * 4 + 3], a * x.w);
+                }
+                else
+                {
+                    atomicAdd(&y_offset[j], a * x_offset[j]);
+                }
             }
         }
     }
@@ -358,6 +385,10 @@ bool ScatterWeightedSumOp<float, HIPContext>::DoRunWithType()
     TIndex block_size = M / N;
 
     float* data = output->template mutable_data<float>();
+    if(K == 0)
+    {
+        return true;
+    }
 
     // In order to have all device pointers of x_i (and weight_i similarly)
     // consecutively in device memory, copy pointers to a host vector and then
@@ -373,29 +404,43 @@ bool ScatterWeightedSumOp<float, HIPContext>::DoRunWithType()
     const float** x_data_device  = x_data_device_.mutable_data<const float*>();
     const float** weights_device = weights_device_.mutable_data<const float*>();
 
+    // The slices are read as float4 when all of them are aligned for it.
+    bool vectorize = block_size % 4 == 0;
     for(int inp = 3; inp < InputSize(); inp += 2)
     {
         int idx           = (inp - 3) / 2;
         x_data_host[idx]  = static_cast<const float*>(Input(inp).raw_data());
         weights_host[idx] = static_cast<const float*>(Input(inp + 1).raw_data());
+        vectorize &= RowCopyWordSize(0, {x_data_host[idx]}) == 16;
     }
     context_.Copy<const float*, CPUContext, HIPContext>(B, x_data_host, x_data_device);
     context_.Copy<const float*, CPUContext, HIPContext>(B, weights_host, weights_device);
 
-    hipLaunchKernelGGL((AxpySliceKernel),
-                       dim3(std::min<TIndex>(K, CAFFE_MAXIMUM_NUM_BLOCKS)),
-                       dim3(CAFFE_HIP_NUM_THREADS),
-                       0,
-                       context_.hip_stream(),
-                       weight0.template data<float>(),
-                       K,
-                       B,
-                       block_size,
-                       weights_device,
-                       x_data_device,
-                       indices.template data<Index>(),
-                       data,
-                       M);
+    const dim3 block = RowCopyBlock(vectorize ? block_size / 4 : block_size);
+#define AXPY_SLICE_LAUNCH(VEC)                                      \
+    hipLaunchKernelGGL((AxpySliceKernel<Index, VEC>),               \
+                       RowCopyGrid(K, block),                       \
+                       block,                                       \
+                       0,                                           \
+                       context_.hip_stream(),                       \
+                       weight0.template data<float>(),              \
+                       K,                                           \
+                       B,                                           \
+                       block_size,                                  \
+                       weights_device,                              \
+                       x_data_device,                               \
+                       indices.template data<Index>(),              \
+                       data,                                        \
+                       M)
+    if(vectorize)
+    {
+        AXPY_SLICE_LAUNCH(4);
+    }
+    else
+    {
+        AXPY_SLICE_LAUNCH(1);
+    }
+#undef AXPY_SLICE_LAUNCH
 
     return true;
 }
@@ -404,17 +449,17 @@ REGISTER_HIP_OPERATOR(ScatterWeightedSum, ScatterWeightedSumOp<float, HIPContext
 
 namespace {
 
-template <typename Index, typename T>
+template <typename Index, typename W>
 __global__ void scatter_assign_kernel(
-    T* data, const Index* idxs, const T* slicesData, TIndex N, TIndex K, TIndex block_size)
+    W* data, const Index* idxs, const W* slicesData, TIndex N, TIndex K, TIndex row_words)
 {
-    for(TIndex i = hipBlockIdx_x; i < K; i += hipGridDim_x)
+    HIP_ROW_LOOP(i, K)
     {
         Index idx = idxs[i];
         HIP_KERNEL_ASSERT(0 <= idx && idx < N);
-        const T* src = slicesData + block_size * i;
-        T* dest      = data + block_size * idx;
-        for(TIndex j = hipThreadIdx_x; j < block_size; j += hipBlockDim_x)
+        const W* src = slicesData + row_words * i;
+        W* dest      = data + row_words * idx;
+        HIP_ROW_WORD_LOOP(j, row_words)
         {
             dest[j] = src[j];
         }
@@ -428,17 +473,28 @@ template <typename Index, typename T>
 void ScatterAssignOp<HIPContext>::DoScatterAssign(
     T* data, const Index* idxs, const T* slicesData, TIndex N, TIndex K, TIndex block_size)
 {
-    hipLaunchKernelGGL((scatter_assign_kernel),
-                       dim3(std::min(K, static_cast<TIndex>(CAFFE_MAXIMUM_NUM_BLOCKS))),
-                       dim3(CAFFE_HIP_NUM_THREADS),
-                       0,
-                       context_.hip_stream(),
-                       data,
-                       idxs,
-                       slicesData,
-                       N,
-                       K,
-                       block_size);
+    if(K == 0 || block_size == 0)
+    {
+        return;
+    }
+    const size_t block_bytesize = block_size * sizeof(T);
+    const int word_size         = RowCopyWordSize(block_bytesize, {data, slicesData});
+    const TIndex words          = block_bytesize / word_size;
+    const dim3 block            = RowCopyBlock(words);
+#define SCATTER_ASSIGN_LAUNCH(W)                                \
+    hipLaunchKernelGGL((scatter_assign_kernel<Index, W>),       \
+                       RowCopyGrid(K, block),                   \
+                       block,                                   \
+                       0,                                       \
+                       context_.hip_stream(),                   \
+                       reinterpret_cast<W*>(data),              \
+                       idxs,                                    \
+                       reinterpret_cast<const W*>(slicesData),  \
+                       N,                                       \
+                       K,                                       \
+                       words)
+    DISPATCH_ROW_COPY_WORD(word_size, SCATTER_ASSIGN_LAUNCH);
+#undef SCATTER_ASSIGN_LAUNCH
 }
 
 REGISTER_HIP_OPERATOR(ScatterAssign, ScatterAssignOp<HIPContext>);
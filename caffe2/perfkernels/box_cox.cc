@@ -0,0 +1,58 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "caffe2/perfkernels/box_cox.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+void BoxCox__base(
+    int N,
+    int D,
+    const float* x,
+    const float* lambda1,
+    const float* lambda2,
+    float eps,
+    float* y) {
+  for (int i = 0; i < N; ++i) {
+    for (int j = 0; j < D; ++j, ++x, ++y) {
+      const float tmp = std::max(*x + lambda2[j], eps);
+      if (lambda1[j] == 0) {
+        *y = std::log(tmp);
+      } else {
+        *y = (std::pow(tmp, lambda1[j]) - 1) / lambda1[j];
+      }
+    }
+  }
+}
+
+void BoxCox(
+    int N,
+    int D,
+    const float* x,
+    const float* lambda1,
+    const float* lambda2,
+    float eps,
+    float* y) {
+  AVX2_FMA_DO(BoxCox, N, D, x, lambda1, lambda2, eps, y);
+  BASE_DO(BoxCox, N, D, x, lambda1, lambda2, eps, y);
+}
+
+} // namespace caffe2
@@ -0,0 +1,35 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+namespace caffe2 {
+
+// Box-Cox transform of an N x D row major matrix, column j with the
+// parameters lambda1[j] and lambda2[j]:
+//   y = ln(max(x + lambda2, eps))                      if lambda1 == 0
+//   y = (max(x + lambda2, eps)^lambda1 - 1) / lambda1  otherwise
+// The AVX2 kernel computes the power as exp(lambda1 * ln(.)) with
+// polynomial approximations of single precision accuracy.
+void BoxCox(
+    int N,
+    int D,
+    const float* x,
+    const float* lambda1,
+    const float* lambda2,
+    float eps,
+    float* y);
+
+} // namespace caffe2
@@ -0,0 +1,124 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "caffe2/perfkernels/box_cox.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Natural logarithm of positive normal floats, after the single precision
+// logf of the Cephes library: x = 2^e * m with m in [sqrt(1/2), sqrt(2)),
+// and ln(m) from a polynomial in m - 1.
+inline __m256 Log(__m256 x) {
+  const __m256 one = _mm256_set1_ps(1.f);
+  __m256i e = _mm256_srli_epi32(_mm256_castps_si256(x), 23);
+  // Mantissa in [0.5, 1).
+  x = _mm256_or_ps(
+      _mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(0x807fffff))),
+      _mm256_set1_ps(0.5f));
+  __m256 fe = _mm256_add_ps(
+      _mm256_cvtepi32_ps(_mm256_sub_epi32(e, _mm256_set1_epi32(127))), one);
+  const __m256 small = _mm256_cmp_ps(
+      x, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+  fe = _mm256_sub_ps(fe, _mm256_and_ps(one, small));
+  x = _mm256_add_ps(_mm256_sub_ps(x, one), _mm256_and_ps(x, small));
+
+  const __m256 z = _mm256_mul_ps(x, x);
+  __m256 p = _mm256_set1_ps(7.0376836292e-2f);
+  p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(-1.1514610310e-1f));
+  p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(1.1676998740e-1f));
+  p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(-1.2420140846e-1f));
+  p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(1.4249322787e-1f));
+  p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(-1.6668057665e-1f));
+  p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(2.0000714765e-1f));
+  p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(-2.4999993993e-1f));
+  p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(3.3333331174e-1f));
+  p = _mm256_mul_ps(_mm256_mul_ps(p, x), z);
+  p = _mm256_fmadd_ps(fe, _mm256_set1_ps(-2.12194440e-4f), p);
+  p = _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, p);
+  x = _mm256_add_ps(x, p);
+  return _mm256_fmadd_ps(fe, _mm256_set1_ps(0.693359375f), x);
+}
+
+// Exponential after the Cephes expf: e^x = 2^n * e^r with |r| <= ln(2) / 2.
+// The input is clamped to the range of finite results.
+inline __m256 Exp(__m256 x) {
+  x = _mm256_min_ps(x, _mm256_set1_ps(88.3762626647949f));
+  x = _mm256_max_ps(x, _mm256_set1_ps(-87.3365447504019f));
+  const __m256 n = _mm256_floor_ps(_mm256_fmadd_ps(
+      x, _mm256_set1_ps(1.44269504088896341f), _mm256_set1_ps(0.5f)));
+  x = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+  x = _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), x);
+
+  const __m256 z = _mm256_mul_ps(x, x);
+  __m256 p = _mm256_set1_ps(1.9875691500e-4f);
+  p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(1.3981999507e-3f));
+  p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(8.3334519073e-3f));
+  p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(4.1665795894e-2f));
+  p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(1.6666665459e-1f));
+  p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(5.0000001201e-1f));
+  p = _mm256_add_ps(_mm256_fmadd_ps(p, z, x), _mm256_set1_ps(1.f));
+
+  const __m256i pow2n = _mm256_slli_epi32(
+      _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+  return _mm256_mul_ps(p, _mm256_castsi256_ps(pow2n));
+}
+
+} // namespace
+
+void BoxCox__avx2_fma(
+    int N,
+    int D,
+    const float* x,
+    const float* lambda1,
+    const float* lambda2,
+    float eps,
+    float* y) {
+  const __m256 mm_eps = _mm256_set1_ps(eps);
+  const __m256 one = _mm256_set1_ps(1.f);
+  const __m256 zero = _mm256_setzero_ps();
+  for (int i = 0; i < N; ++i, x += D, y += D) {
+    int j = 0;
+    for (; j + 8 <= D; j += 8) {
+      const __m256 l1 = _mm256_loadu_ps(lambda1 + j);
+      const __m256 t = _mm256_max_ps(
+          _mm256_add_ps(_mm256_loadu_ps(x + j), _mm256_loadu_ps(lambda2 + j)),
+          mm_eps);
+      const __m256 log_t = Log(t);
+      // The lanes with a zero lambda1 divide by zero, they take log_t.
+      const __m256 power = _mm256_div_ps(
+          _mm256_sub_ps(Exp(_mm256_mul_ps(l1, log_t)), one), l1);
+      _mm256_storeu_ps(
+          y + j,
+          _mm256_blendv_ps(power, log_t, _mm256_cmp_ps(l1, zero, _CMP_EQ_OQ)));
+    }
+    for (; j < D; ++j) {
+      const float tmp = std::max(x[j] + lambda2[j], eps);
+      if (lambda1[j] == 0) {
+        y[j] = std::log(tmp);
+      } else {
+        y[j] = (std::pow(tmp, lambda1[j]) - 1) / lambda1[j];
+      }
+    }
+  }
+}
+
+} // namespace caffe2
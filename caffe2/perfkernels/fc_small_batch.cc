@@ -0,0 +1,58 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/perfkernels/fc_small_batch.h"
+
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+void FullyConnectedSmallBatch__base(
+    int M,
+    int N,
+    int K,
+    const float* X,
+    const float* W,
+    const float* bias,
+    float* Y) {
+  for (int n = 0; n < N; ++n) {
+    const float* w = W + static_cast<size_t>(n) * K;
+    for (int m = 0; m < M; ++m) {
+      const float* x = X + static_cast<size_t>(m) * K;
+      float acc = 0;
+      for (int k = 0; k < K; ++k) {
+        acc += x[k] * w[k];
+      }
+      Y[static_cast<size_t>(m) * N + n] = acc + (bias ? bias[n] : 0.f);
+    }
+  }
+}
+
+void FullyConnectedSmallBatch(
+    int M,
+    int N,
+    int K,
+    const float* X,
+    const float* W,
+    const float* bias,
+    float* Y) {
+  AVX512_DO(FullyConnectedSmallBatch, M, N, K, X, W, bias, Y);
+  AVX2_FMA_DO(FullyConnectedSmallBatch, M, N, K, X, W, bias, Y);
+  BASE_DO(FullyConnectedSmallBatch, M, N, K, X, W, bias, Y);
+}
+
+} // namespace caffe2
@@ -0,0 +1,42 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace caffe2 {
+
+// FC for the batch sizes of online inference: Y = X * W^T + bias, with X of
+// size M x K, W of size N x K and Y of size M x N, all row major and
+// contiguous. Every output is a dot product of a row of X with a row of W, so
+// unlike a general GEMM nothing is packed and no thread is started: the rows
+// of X stay in registers or L1 while W is streamed once.
+//
+// FullyConnectedOp takes this path on CPU for M <= kFullyConnectedSmallBatchM.
+constexpr int kFullyConnectedSmallBatchM = 8;
+
+// bias has N elements and may be nullptr.
+void FullyConnectedSmallBatch(
+    int M,
+    int N,
+    int K,
+    const float* X,
+    const float* W,
+    const float* bias,
+    float* Y);
+
+} // namespace caffe2
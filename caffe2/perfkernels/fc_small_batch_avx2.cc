@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <immintrin.h>
+#include <algorithm>
+
+#include "caffe2/perfkernels/fc_small_batch.h"
+
+namespace caffe2 {
+
+namespace {
+
+// A tile is MR rows of X against kNR rows of W: 4 x 3 accumulators, the kNR
+// rows of W and one row of X fit in the 16 ymm registers.
+constexpr int kMR = 4;
+constexpr int kNR = 3;
+
+inline float ReduceAdd(__m256 v) {
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_movehdup_ps(s));
+  return _mm_cvtss_f32(s);
+}
+
+// Rows of W past nr alias the first one and their outputs are dropped, so
+// that the tile always has compile time sizes.
+template <int MR>
+inline void Tile(
+    int nr,
+    int K,
+    const float* X,
+    const float* W,
+    const float* bias,
+    float* Y,
+    int N) {
+  const float* w[kNR];
+  for (int j = 0; j < kNR; ++j) {
+    w[j] = W + static_cast<size_t>(j < nr ? j : 0) * K;
+  }
+  __m256 acc[MR][kNR];
+  for (int i = 0; i < MR; ++i) {
+    for (int j = 0; j < kNR; ++j) {
+      acc[i][j] = _mm256_setzero_ps();
+    }
+  }
+  int k = 0;
+  for (; k + 8 <= K; k += 8) {
+    __m256 wv[kNR];
+    for (int j = 0; j < kNR; ++j) {
+      wv[j] = _mm256_loadu_ps(w[j] + k);
+    }
+    for (int i = 0; i < MR; ++i) {
+      const __m256 x = _mm256_loadu_ps(X + static_cast<size_t>(i) * K + k);
+      for (int j = 0; j < kNR; ++j) {
+        acc[i][j] = _mm256_fmadd_ps(x, wv[j], acc[i][j]);
+      }
+    }
+  }
+  if (k < K) {
+    const __m256i mask = _mm256_cmpgt_epi32(
+        _mm256_set1_epi32(K - k), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256 wv[kNR];
+    for (int j = 0; j < kNR; ++j) {
+      wv[j] = _mm256_maskload_ps(w[j] + k, mask);
+    }
+    for (int i = 0; i < MR; ++i) {
+      const __m256 x =
+          _mm256_maskload_ps(X + static_cast<size_t>(i) * K + k, mask);
+      for (int j = 0; j < kNR; ++j) {
+        acc[i][j] = _mm256_fmadd_ps(x, wv[j], acc[i][j]);
+      }
+    }
+  }
+  for (int i = 0; i < MR; ++i) {
+    for (int j = 0; j < nr; ++j) {
+      Y[static_cast<size_t>(i) * N + j] =
+          ReduceAdd(acc[i][j]) + (bias ? bias[j] : 0.f);
+    }
+  }
+}
+
+} // namespace
+
+void FullyConnectedSmallBatch__avx2_fma(
+    int M,
+    int N,
+    int K,
+    const float* X,
+    const float* W,
+    const float* bias,
+    float* Y) {
+  // The kNR rows of W of a tile are reused from L1 by all the row blocks of X.
+  for (int n0 = 0; n0 < N; n0 += kNR) {
+    const int nr = std::min(kNR, N - n0);
+    const float* w = W + static_cast<size_t>(n0) * K;
+    const float* b = bias ? bias + n0 : nullptr;
+    for (int m0 = 0; m0 < M; m0 += kMR) {
+      const float* x = X + static_cast<size_t>(m0) * K;
+      float* y = Y + static_cast<size_t>(m0) * N + n0;
+      switch (std::min(kMR, M - m0)) {
+#define CAFFE2_FC_SMALL_BATCH_CASE(R)  \
+  case R:                              \
+    Tile<R>(nr, K, x, w, b, y, N);     \
+    break;
+        CAFFE2_FC_SMALL_BATCH_CASE(1)
+        CAFFE2_FC_SMALL_BATCH_CASE(2)
+        CAFFE2_FC_SMALL_BATCH_CASE(3)
+        CAFFE2_FC_SMALL_BATCH_CASE(4)
+#undef CAFFE2_FC_SMALL_BATCH_CASE
+      }
+    }
+  }
+}
+
+} // namespace caffe2
@@ -0,0 +1,123 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <immintrin.h>
+#include <algorithm>
+
+#include "caffe2/perfkernels/fc_small_batch.h"
+
+namespace caffe2 {
+
+namespace {
+
+// 8 x 3 accumulators, the kNR rows of W and one row of X take 28 of the 32
+// zmm registers, so a whole small batch is one row block.
+constexpr int kMR = 8;
+constexpr int kNR = 3;
+
+// Rows of W past nr alias the first one and their outputs are dropped, so
+// that the tile always has compile time sizes.
+template <int MR>
+inline void Tile(
+    int nr,
+    int K,
+    const float* X,
+    const float* W,
+    const float* bias,
+    float* Y,
+    int N) {
+  const float* w[kNR];
+  for (int j = 0; j < kNR; ++j) {
+    w[j] = W + static_cast<size_t>(j < nr ? j : 0) * K;
+  }
+  __m512 acc[MR][kNR];
+  for (int i = 0; i < MR; ++i) {
+    for (int j = 0; j < kNR; ++j) {
+      acc[i][j] = _mm512_setzero_ps();
+    }
+  }
+  int k = 0;
+  for (; k + 16 <= K; k += 16) {
+    __m512 wv[kNR];
+    for (int j = 0; j < kNR; ++j) {
+      wv[j] = _mm512_loadu_ps(w[j] + k);
+    }
+    for (int i = 0; i < MR; ++i) {
+      const __m512 x = _mm512_loadu_ps(X + static_cast<size_t>(i) * K + k);
+      for (int j = 0; j < kNR; ++j) {
+        acc[i][j] = _mm512_fmadd_ps(x, wv[j], acc[i][j]);
+      }
+    }
+  }
+  if (k < K) {
+    const __mmask16 mask = (1u << (K - k)) - 1;
+    __m512 wv[kNR];
+    for (int j = 0; j < kNR; ++j) {
+      wv[j] = _mm512_maskz_loadu_ps(mask, w[j] + k);
+    }
+    for (int i = 0; i < MR; ++i) {
+      const __m512 x =
+          _mm512_maskz_loadu_ps(mask, X + static_cast<size_t>(i) * K + k);
+      for (int j = 0; j < kNR; ++j) {
+        acc[i][j] = _mm512_fmadd_ps(x, wv[j], acc[i][j]);
+      }
+    }
+  }
+  for (int i = 0; i < MR; ++i) {
+    for (int j = 0; j < nr; ++j) {
+      Y[static_cast<size_t>(i) * N + j] =
+          _mm512_reduce_add_ps(acc[i][j]) + (bias ? bias[j] : 0.f);
+    }
+  }
+}
+
+} // namespace
+
+void FullyConnectedSmallBatch__avx512(
+    int M,
+    int N,
+    int K,
+    const float* X,
+    const float* W,
+    const float* bias,
+    float* Y) {
+  for (int n0 = 0; n0 < N; n0 += kNR) {
+    const int nr = std::min(kNR, N - n0);
+    const float* w = W + static_cast<size_t>(n0) * K;
+    const float* b = bias ? bias + n0 : nullptr;
+    for (int m0 = 0; m0 < M; m0 += kMR) {
+      const float* x = X + static_cast<size_t>(m0) * K;
+      float* y = Y + static_cast<size_t>(m0) * N + n0;
+      switch (std::min(kMR, M - m0)) {
+#define CAFFE2_FC_SMALL_BATCH_CASE(R)  \
+  case R:                              \
+    Tile<R>(nr, K, x, w, b, y, N);     \
+    break;
+        CAFFE2_FC_SMALL_BATCH_CASE(1)
+        CAFFE2_FC_SMALL_BATCH_CASE(2)
+        CAFFE2_FC_SMALL_BATCH_CASE(3)
+        CAFFE2_FC_SMALL_BATCH_CASE(4)
+        CAFFE2_FC_SMALL_BATCH_CASE(5)
+        CAFFE2_FC_SMALL_BATCH_CASE(6)
+        CAFFE2_FC_SMALL_BATCH_CASE(7)
+        CAFFE2_FC_SMALL_BATCH_CASE(8)
+#undef CAFFE2_FC_SMALL_BATCH_CASE
+      }
+    }
+  }
+}
+
+} // namespace caffe2
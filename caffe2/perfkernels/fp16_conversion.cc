@@ -0,0 +1,47 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "caffe2/perfkernels/fp16_conversion.h"
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/conversions.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+void FloatToFloat16__base(int N, const float* x, float16* y) {
+  for (int i = 0; i < N; ++i) {
+    y[i] = convert::cpu_float2half_rn(x[i]);
+  }
+}
+
+void Float16ToFloat__base(int N, const float16* x, float* y) {
+  for (int i = 0; i < N; ++i) {
+    y[i] = convert::cpu_half2float(x[i]);
+  }
+}
+
+void FloatToFloat16(int N, const float* x, float16* y) {
+  AVX512_DO(FloatToFloat16, N, x, y);
+  AVX_F16C_DO(FloatToFloat16, N, x, y);
+  BASE_DO(FloatToFloat16, N, x, y);
+}
+
+void Float16ToFloat(int N, const float16* x, float* y) {
+  AVX512_DO(Float16ToFloat, N, x, y);
+  AVX_F16C_DO(Float16ToFloat, N, x, y);
+  BASE_DO(Float16ToFloat, N, x, y);
+}
+
+} // namespace caffe2
@@ -0,0 +1,28 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "caffe2/core/types.h"
+
+namespace caffe2 {
+
+// Converts N floats to half precision with round to nearest even, and N
+// halfs back to float. They are used by the CPU FloatToHalf and HalfToFloat
+// operators; x and y must not overlap.
+void FloatToFloat16(int N, const float* x, float16* y);
+void Float16ToFloat(int N, const float16* x, float* y);
+
+} // namespace caffe2
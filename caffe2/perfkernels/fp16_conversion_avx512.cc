@@ -0,0 +1,62 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <immintrin.h>
+
+#include "caffe2/perfkernels/fp16_conversion.h"
+
+namespace caffe2 {
+
+// The tails go through the same vector instructions as the rest, so every
+// element is rounded the same way.
+void FloatToFloat16__avx512(int N, const float* x, float16* y) {
+  int i = 0;
+  for (; i + 16 <= N; i += 16) {
+    const __m256i h =
+        _mm512_cvtps_ph(_mm512_loadu_ps(x + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + i), h);
+  }
+  if (i < N) {
+    const __mmask16 mask = (1 << (N - i)) - 1;
+    const __m256i h = _mm512_cvtps_ph(
+        _mm512_maskz_loadu_ps(mask, x + i), _MM_FROUND_TO_NEAREST_INT);
+    alignas(32) uint16_t tail[16];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(tail), h);
+    for (int j = 0; i + j < N; ++j) {
+      y[i + j].x = tail[j];
+    }
+  }
+}
+
+void Float16ToFloat__avx512(int N, const float16* x, float* y) {
+  int i = 0;
+  for (; i + 16 <= N; i += 16) {
+    const __m256i h =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+    _mm512_storeu_ps(y + i, _mm512_cvtph_ps(h));
+  }
+  if (i < N) {
+    const __mmask16 mask = (1 << (N - i)) - 1;
+    alignas(32) uint16_t tail[16] = {0};
+    for (int j = 0; i + j < N; ++j) {
+      tail[j] = x[i + j].x;
+    }
+    const __m512 f = _mm512_cvtph_ps(
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(tail)));
+    _mm512_mask_storeu_ps(y + i, mask, f);
+  }
+}
+
+} // namespace caffe2
@@ -20,6 +20,47 @@ from __future__ import unicode_literals
 import argparse
 import sys
 
+# Generates embedding_lookup_<isa>.cc, e.g.
+#   python hp_emblookup_codegen.py --isa avx512 --prefetch-distance 16
+# The output is then run through clang-format before being checked in.
+
+
+# Per-ISA building blocks. "width" is the number of floats per vector
+# register; the templates take the address of the first element to load.
+isas = {
+    "avx2": {
+        "suffix": "avx2_fma",
+        "width": 8,
+        "vtype": "__m256",
+        "prefix": "_mm256",
+        "float16": "_mm256_cvtph_ps(_mm_loadu_si128("
+                   "reinterpret_cast<const __m128i*>(%s)))",
+        "uint8_t": "_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64("
+                   "reinterpret_cast<const __m128i*>(%s))))",
+        "htype": "__m128i",
+    },
+    "avx512": {
+        "suffix": "avx512",
+        "width": 16,
+        "vtype": "__m512",
+        "prefix": "_mm512",
+        "float16": "_mm512_cvtph_ps(_mm256_loadu_si256("
+                   "reinterpret_cast<const __m256i*>(%s)))",
+        "uint8_t": "_mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128("
+                   "reinterpret_cast<const __m128i*>(%s))))",
+        "htype": "__m256i",
+    },
+}
+
+
+def load(InType, isa, addr):
+    if InType == "float":
+        return isa["prefix"] + "_loadu_ps(" + addr + ")"
+    elif InType == "float16" or InType == "uint8_t":
+        return isa["float16" if InType == "float16" else "uint8_t"] % addr
+    else:
+        assert False
+
 
 def unroll(uf, IndexType, InType, OutType, use_weights, isa):
 
@@ -36,26 +77,21 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa):
 
         return size
 
+    width = isa["width"]
+    vtype = isa["vtype"]
+    mm = isa["prefix"]
+
     def compute(regid, InType, use_weights, isa, prefetch):
         code = []
 
-        if InType == "float":
-            code.append("vop%d = _mm256_fmadd_ps(vwgt,  \
-                  _mm256_loadu_ps(ip + (%d)), vop%d);" % (regid, regid, regid))
-
-        elif InType == "float16":
-            code.append("vop%d = _mm256_fmadd_ps(vwgt,  \
-                   _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ip + (%d)))), \
-                   vop%d);"
-                        % (regid, regid, regid))
-        elif InType == "uint8_t":
-            code.append("vop%d = _mm256_fmadd_ps(vwgt,  \
-                   _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(ip + (%d))))), \
-                   _mm256_add_ps(vop%d, vbio));"
-                        % (regid, regid, regid))
+        if InType == "uint8_t":
+            code.append("vop%d = %s_fmadd_ps(vwgt, %s, %s_add_ps(vop%d, vbio));"
+                        % (regid, mm, load(InType, isa, "ip + (%d)" % regid),
+                           mm, regid))
         else:
-            assert False
-
+            code.append("vop%d = %s_fmadd_ps(vwgt, %s, vop%d);"
+                        % (regid, mm, load(InType, isa, "ip + (%d)" % regid),
+                           regid))
 
         if prefetch == True:
             code.append("_mm_prefetch((&ip_next_T0[%d]), _MM_HINT_T0);" % (regid))
@@ -71,8 +107,8 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa):
                 " rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {")
     code.append(OutType + " *op = &out[rangeIndex * block_size];")
     for i in range(0, uf):
-        j = 8 * i
-        code.append("__m256 vop" + str(j) + " = _mm256_setzero_ps();")
+        j = width * i
+        code.append(vtype + " vop" + str(j) + " = " + mm + "_setzero_ps();")
 
     # inner loop
     code.append("for (" + IndexType +
@@ -89,13 +125,13 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa):
         code.append("}")
         code.append("bio = wgt * scale_bias[2 * idx + 1];");
         code.append("wgt = wgt * scale_bias[2 * idx];");
-        code.append("__m256 vbio = _mm256_set1_ps(bio);")
+        code.append(vtype + " vbio = " + mm + "_set1_ps(bio);")
     else:
         code.append(OutType + " wgt = 1.f;")
         code.append("if (weights) {")
         code.append("wgt = weights[dataInd];")
         code.append("}")
-    code.append("__m256 vwgt = _mm256_set1_ps(wgt);")
+    code.append(vtype + " vwgt = " + mm + "_set1_ps(wgt);")
 
     code.append("const  " + InType + " *ip = &input[idx * block_size];")
     code.append("const  " + IndexType +
@@ -107,7 +143,7 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa):
                 " *ip_next_T0 = &input[idx_pref_T0 * block_size];")
 
     for i in range(0, uf):
-        j = 8 * i
+        j = width * i
         cachelinesize = 64
         byteoffset = sizeof(InType) * j
         prefetch = ((byteoffset % cachelinesize) == 0)
@@ -116,17 +152,17 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa):
 
     code.append("if (normalize_by_lengths == false) {")
     for i in range(0, uf):
-        j = 8 * i
+        j = width * i
         code.append(
-            "_mm256_storeu_ps(&op[" + str(j) + "], vop" + str(j) + ");")
+            mm + "_storeu_ps(&op[" + str(j) + "], vop" + str(j) + ");")
     code.append("} else if (lengths[rangeIndex]) {")
     # inv of length
     code.append(
-        "__m256 vlen_inv = _mm256_set1_ps(1.0f / lengths[rangeIndex]);")
+        vtype + " vlen_inv = " + mm + "_set1_ps(1.0f / lengths[rangeIndex]);")
     for i in range(0, uf):
-        j = 8 * i
+        j = width * i
         code.append(
-            "_mm256_storeu_ps(&op[" + str(j) + "], _mm256_mul_ps(" + "vop" + str(j) + ", vlen_inv));")
+            mm + "_storeu_ps(&op[" + str(j) + "], " + mm + "_mul_ps(" + "vop" + str(j) + ", vlen_inv));")
     code.append("}")
 
     code.append("}")
@@ -135,26 +171,20 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa):
 
 def generic(IndexType, InType, OutType, use_weights, isa):
 
+    width = isa["width"]
+    vtype = isa["vtype"]
+    mm = isa["prefix"]
+
     def compute(InType, use_weights, isa):
         code = []
-        if InType == "float":
-            code.append("_mm256_storeu_ps(&op[j], \
-                                 _mm256_fmadd_ps(vwgt,_mm256_loadu_ps(&ip[j]), _mm256_loadu_ps(&op[j])) \
-                                   );")
-        elif InType == "float16":
-            code.append("_mm256_storeu_ps(&op[j], \
-                   _mm256_fmadd_ps(vwgt, \
-                     _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&ip[j]))), _mm256_loadu_ps(&op[j])) \
-                                   );")
-        elif InType == "uint8_t":
-            code.append("_mm256_storeu_ps(&op[j], \
-                   _mm256_fmadd_ps(vwgt, \
-                     _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&ip[j])))), \
-                     _mm256_add_ps(_mm256_loadu_ps(&op[j]), vbio) ) \
-                                   );")
+        if InType == "uint8_t":
+            code.append("%s_storeu_ps(&op[j], %s_fmadd_ps(vwgt, %s, "
+                        "%s_add_ps(%s_loadu_ps(&op[j]), vbio)));"
+                        % (mm, mm, load(InType, isa, "&ip[j]"), mm, mm))
         else:
-            assert False
-
+            code.append("%s_storeu_ps(&op[j], %s_fmadd_ps(vwgt, %s, "
+                        "%s_loadu_ps(&op[j])));"
+                        % (mm, mm, load(InType, isa, "&ip[j]"), mm))
 
         code.append("_mm_prefetch((&ip_next_T0[j]), _MM_HINT_T0);")
 
@@ -168,8 +198,8 @@ def generic(IndexType, InType, OutType, use_weights, isa):
 
     # initialize to 0
     code.append("TIndex j = 0;")
-    code.append("for(; j + 8 <= block_size; j += 8) {")
-    code.append("_mm256_storeu_ps(op + j, _mm256_setzero_ps());")
+    code.append("for(; j + %d <= block_size; j += %d) {" % (width, width))
+    code.append(mm + "_storeu_ps(op + j, " + mm + "_setzero_ps());")
     code.append("}")
     code.append("for(; j < block_size; j++) {")
     code.append("op[j] = 0.0f;")
@@ -191,13 +221,13 @@ def generic(IndexType, InType, OutType, use_weights, isa):
         code.append("assert (scale_bias);")
         code.append("bio = wgt * scale_bias[2 * idx + 1];");
         code.append("wgt = wgt * scale_bias[2 * idx];");
-        code.append("__m256 vbio = _mm256_set1_ps(bio);")
+        code.append(vtype + " vbio = " + mm + "_set1_ps(bio);")
     else:
         code.append(OutType + " wgt = 1.f;")
         code.append("if (weights) {")
         code.append("wgt = weights[dataInd];")
         code.append("}")
-    code.append("__m256 vwgt = _mm256_set1_ps(wgt);")
+    code.append(vtype + " vwgt = " + mm + "_set1_ps(wgt);")
 
     code.append("const  " + InType + " *ip = &input[idx * block_size];")
     code.append("const  " + IndexType +
@@ -210,19 +240,20 @@ def generic(IndexType, InType, OutType, use_weights, isa):
 
     # compute and store main loop
     code.append("j = 0;")
-    code.append("for(; j + 8 <= block_size; j += 8) {")
+    code.append("for(; j + %d <= block_size; j += %d) {" % (width, width))
     code.extend(compute(InType, use_weights, isa))
     code.append("}")
     # leftover
     if InType == "float16":
         #code.append("float16 vtmp1[8] __attribute__((aligned(64)));")
-        code.append("float16 vtmp1[8] CAFFE2_ALIGNED(64);")
+        code.append("float16 vtmp1[%d] CAFFE2_ALIGNED(64);" % width)
     code.append("for(; j < block_size; j++) {")
     if InType == "float":
         code.append("op[j] += wgt * ip[j];")
     elif InType == "float16":
         code.append("vtmp1[0] = ip[j];")
-        code.append("__m256 vtmp2 = _mm256_cvtph_ps(*((__m128i*)vtmp1));")
+        code.append("%s vtmp2 = %s_cvtph_ps(*((%s*)vtmp1));"
+                    % (vtype, mm, isa["htype"]))
         code.append("op[j] += wgt * ((float*)(&vtmp2))[0];")
     elif InType == "uint8_t":
         code.append("op[j] += wgt * ((float)ip[j]) + bio;")
@@ -235,11 +266,11 @@ def generic(IndexType, InType, OutType, use_weights, isa):
 
     code.append("if (normalize_by_lengths && lengths[rangeIndex]) {")
     code.append("float len_inv = 1.0f / lengths[rangeIndex];")
-    code.append("__m256 vlen_inv = _mm256_set1_ps(len_inv);")
+    code.append(vtype + " vlen_inv = " + mm + "_set1_ps(len_inv);")
     code.append("j = 0;")
-    code.append("for(; j + 8 <= block_size; j += 8) {")
+    code.append("for(; j + %d <= block_size; j += %d) {" % (width, width))
     code.append(
-        "_mm256_storeu_ps(&op[j], _mm256_mul_ps(_mm256_loadu_ps(&op[j]), vlen_inv));")
+        mm + "_storeu_ps(&op[j], " + mm + "_mul_ps(" + mm + "_loadu_ps(&op[j]), vlen_inv));")
     code.append("}")
     code.append("for(; j < block_size; j++) {")
     code.append("op[j] = len_inv * op[j];")
@@ -255,8 +286,13 @@ def generic(IndexType, InType, OutType, use_weights, isa):
 # start main code
 parser = argparse.ArgumentParser()
 parser.add_argument('-f', nargs=1, help="file name")
+parser.add_argument('--isa', default="avx2", choices=sorted(isas.keys()),
+                    help="instruction set to generate the kernels for")
+parser.add_argument('--prefetch-distance', type=int, default=16,
+                    help="how many indices ahead the rows are prefetched")
 opts = parser.parse_args()
-filename = "embedding_lookup_avx2.cc"
+isa = isas[opts.isa]
+filename = "embedding_lookup_" + opts.isa + ".cc"
 if opts.f:
     filename = (opts.f)[0]
 fout = open(filename, 'w')
@@ -305,7 +341,7 @@ for o in options:
     [IndexType, InType, OutType] = o
 
     fn = "void EmbeddingLookup_" + IndexType + \
-        "_" + InType + "_" + OutType + "__avx2_fma"
+        "_" + InType + "_" + OutType + "__" + isa["suffix"]
     code.append(fn + "(")
     code.append("const TIndex block_size,")
     code.append("const TIndex output_size,")
@@ -320,24 +356,24 @@ for o in options:
     code.append(OutType + "* out)")
 
     code.append("{")
-    code.append("const " + IndexType + " prefdist_T0 = 16;")
+    code.append("const " + IndexType + " prefdist_T0 = %d;"
+                % opts.prefetch_distance)
     #code.append("printf(\"calling " + fn + "\\n\");");
     if InType != "uint8_t":
         code.append("CAFFE_ENFORCE(scale_bias == nullptr, \"scale_bias must be nullptr\");");
     else:
         code.append("CAFFE_ENFORCE(scale_bias != nullptr, \"scale_bias must not be nullptr\");");
 
-    code.append("if (block_size == 128) {")
-    code.extend(unroll(16, IndexType, InType, OutType, True, "AVX2"))
-    code.append("} else if (block_size == 64) {")
-    code.extend(unroll(8, IndexType, InType, OutType, True, "AVX2"))
-    code.append("} else if (block_size == 32) {")
-    code.extend(unroll(4, IndexType, InType, OutType, True, "AVX2"))
-    code.append("} else if (block_size == 16) {")
-    code.extend(unroll(2, IndexType, InType, OutType, True, "AVX2"))
+    # Fully unrolled versions for the common embedding sizes.
+    prefix = "if"
+    for block_size in [128, 64, 32, 16]:
+        code.append(prefix + " (block_size == %d) {" % block_size)
+        code.extend(unroll(block_size // isa["width"], IndexType, InType,
+                           OutType, True, isa))
+        prefix = "} else if"
     code.append("} else {")
     code.append("// generic code")
-    code.extend(generic(IndexType, InType, OutType, True, "AVX2"))
+    code.extend(generic(IndexType, InType, OutType, True, isa))
     code.append("}")
 
 
@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <immintrin.h>
+#include <algorithm>
+#include <cstdint>
+
+namespace caffe2 {
+
+namespace {
+
+// Rows of B whose dot products are computed against each loaded slice of A.
+constexpr int kBlockN = 4;
+// Rows of A are processed in blocks of about this many bytes, so the block
+// stays in L2 while all of B is streamed against it.
+constexpr int kBlockABytes = 128 * 1024;
+
+template <int NB>
+inline void DotRows(
+    int K,
+    const std::uint8_t* a,
+    const std::int8_t* b,
+    std::int32_t* c) {
+  __m256i acc[NB];
+  for (int j = 0; j < NB; ++j) {
+    acc[j] = _mm256_setzero_si256();
+  }
+  int k = 0;
+  for (; k + 16 <= K; k += 16) {
+    // Widening to 16 bits and using madd keeps the products exact.
+    const __m256i av = _mm256_cvtepu8_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + k)));
+    for (int j = 0; j < NB; ++j) {
+      const __m256i bv = _mm256_cvtepi8_epi16(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j * K + k)));
+      acc[j] = _mm256_add_epi32(acc[j], _mm256_madd_epi16(av, bv));
+    }
+  }
+  for (int j = 0; j < NB; ++j) {
+    __m128i s = _mm_add_epi32(
+        _mm256_castsi256_si128(acc[j]), _mm256_extracti128_si256(acc[j], 1));
+    s = _mm_hadd_epi32(s, s);
+    s = _mm_hadd_epi32(s, s);
+    std::int32_t r = _mm_cvtsi128_si32(s);
+    for (int kk = k; kk < K; ++kk) {
+      r += std::int32_t(a[kk]) * std::int32_t(b[j * K + kk]);
+    }
+    c[j] = r;
+  }
+}
+
+} // namespace
+
+void Int8GemmNT__avx2(
+    int M,
+    int N,
+    int K,
+    const std::uint8_t* A,
+    const std::int8_t* B,
+    std::int32_t* C,
+    int ldc) {
+  const int blockM = std::max(1, kBlockABytes / std::max(K, 1));
+  for (int m0 = 0; m0 < M; m0 += blockM) {
+    const int m1 = std::min(M, m0 + blockM);
+    int n = 0;
+    for (; n + kBlockN <= N; n += kBlockN) {
+      for (int m = m0; m < m1; ++m) {
+        DotRows<kBlockN>(K, A + m * K, B + n * K, C + m * ldc + n);
+      }
+    }
+    for (; n < N; ++n) {
+      for (int m = m0; m < m1; ++m) {
+        DotRows<1>(K, A + m * K, B + n * K, C + m * ldc + n);
+      }
+    }
+  }
+}
+
+} // namespace caffe2
@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <immintrin.h>
+#include <algorithm>
+#include <cstdint>
+
+namespace caffe2 {
+
+namespace {
+
+// See int8_gemm_avx2.cc for the blocking.
+constexpr int kBlockN = 4;
+constexpr int kBlockABytes = 128 * 1024;
+
+template <int NB>
+inline void DotRows(
+    int K,
+    const std::uint8_t* a,
+    const std::int8_t* b,
+    std::int32_t* c) {
+  __m512i acc[NB];
+  for (int j = 0; j < NB; ++j) {
+    acc[j] = _mm512_setzero_si512();
+  }
+  int k = 0;
+  for (; k + 64 <= K; k += 64) {
+    const __m512i av = _mm512_loadu_si512(a + k);
+    for (int j = 0; j < NB; ++j) {
+      // vpdpbusd sums four u8 * s8 products into each int32 lane without
+      // intermediate saturation.
+      acc[j] =
+          _mm512_dpbusd_epi32(acc[j], av, _mm512_loadu_si512(b + j * K + k));
+    }
+  }
+  if (k < K) {
+    const __mmask64 mask = (1ULL << (K - k)) - 1;
+    const __m512i av = _mm512_maskz_loadu_epi8(mask, a + k);
+    for (int j = 0; j < NB; ++j) {
+      acc[j] = _mm512_dpbusd_epi32(
+          acc[j], av, _mm512_maskz_loadu_epi8(mask, b + j * K + k));
+    }
+  }
+  for (int j = 0; j < NB; ++j) {
+    c[j] = _mm512_reduce_add_epi32(acc[j]);
+  }
+}
+
+} // namespace
+
+void Int8GemmNT__avx512_vnni(
+    int M,
+    int N,
+    int K,
+    const std::uint8_t* A,
+    const std::int8_t* B,
+    std::int32_t* C,
+    int ldc) {
+  const int blockM = std::max(1, kBlockABytes / std::max(K, 1));
+  for (int m0 = 0; m0 < M; m0 += blockM) {
+    const int m1 = std::min(M, m0 + blockM);
+    int n = 0;
+    for (; n + kBlockN <= N; n += kBlockN) {
+      for (int m = m0; m < m1; ++m) {
+        DotRows<kBlockN>(K, A + m * K, B + n * K, C + m * ldc + n);
+      }
+    }
+    for (; n < N; ++n) {
+      for (int m = m0; m < m1; ++m) {
+        DotRows<1>(K, A + m * K, B + n * K, C + m * ldc + n);
+      }
+    }
+  }
+}
+
+} // namespace caffe2
@@ -0,0 +1,169 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/perfkernels/packed_sgemm.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Depth of the panel slices, kKC * kPackedSgemmNR floats (16KB) stay in L1.
+constexpr int kKC = 256;
+
+constexpr int kBaseMR = 4;
+
+void PackedSgemmMicroKernel__base(
+    int mr,
+    int nr,
+    int kc,
+    const float* A,
+    int lda,
+    const float* B,
+    const float* bias,
+    bool accumulate,
+    float* C,
+    int ldc) {
+  for (int i = 0; i < mr; ++i) {
+    float acc[kPackedSgemmNR] = {0};
+    for (int k = 0; k < kc; ++k) {
+      const float a = A[i * lda + k];
+      for (int j = 0; j < kPackedSgemmNR; ++j) {
+        acc[j] += a * B[k * kPackedSgemmNR + j];
+      }
+    }
+    for (int j = 0; j < nr; ++j) {
+      const float init = accumulate ? C[i * ldc + j] : (bias ? bias[j] : 0.f);
+      C[i * ldc + j] = init + acc[j];
+    }
+  }
+}
+
+} // namespace
+
+size_t PackedSgemmSize(int N, int K) {
+  const size_t panels = (N + kPackedSgemmNR - 1) / kPackedSgemmNR;
+  return panels * K * kPackedSgemmNR;
+}
+
+void PackedSgemmPack(int N, int K, const float* W, float* packed) {
+  const int panels = (N + kPackedSgemmNR - 1) / kPackedSgemmNR;
+  for (int p = 0; p < panels; ++p) {
+    float* panel = packed + static_cast<size_t>(p) * K * kPackedSgemmNR;
+    const int n0 = p * kPackedSgemmNR;
+    const int nr = std::min(kPackedSgemmNR, N - n0);
+    if (nr < kPackedSgemmNR) {
+      std::memset(panel, 0, sizeof(float) * K * kPackedSgemmNR);
+    }
+    for (int j = 0; j < nr; ++j) {
+      const float* w = W + static_cast<size_t>(n0 + j) * K;
+      for (int k = 0; k < K; ++k) {
+        panel[k * kPackedSgemmNR + j] = w[k];
+      }
+    }
+  }
+}
+
+namespace detail {
+
+void PackedSgemmDriver(
+    int M,
+    int N,
+    int K,
+    const float* A,
+    const float* packed,
+    const float* bias,
+    float* C,
+    int ldc,
+    int mr,
+    PackedSgemmMicroKernel kernel) {
+  const int panels = (N + kPackedSgemmNR - 1) / kPackedSgemmNR;
+  if (K == 0) {
+    for (int i = 0; i < M; ++i) {
+      for (int j = 0; j < N; ++j) {
+        C[i * ldc + j] = bias ? bias[j] : 0.f;
+      }
+    }
+    return;
+  }
+  for (int k0 = 0; k0 < K; k0 += kKC) {
+    const int kc = std::min(kKC, K - k0);
+    for (int p = 0; p < panels; ++p) {
+      const int n0 = p * kPackedSgemmNR;
+      const int nr = std::min(kPackedSgemmNR, N - n0);
+      const float* B =
+          packed + (static_cast<size_t>(p) * K + k0) * kPackedSgemmNR;
+      for (int m0 = 0; m0 < M; m0 += mr) {
+        kernel(
+            std::min(mr, M - m0),
+            nr,
+            kc,
+            A + static_cast<size_t>(m0) * K + k0,
+            K,
+            B,
+            bias ? bias + n0 : nullptr,
+            k0 > 0,
+            C + static_cast<size_t>(m0) * ldc + n0,
+            ldc);
+      }
+    }
+  }
+}
+
+} // namespace detail
+
+void PackedSgemm__base(
+    int M,
+    int N,
+    int K,
+    const float* A,
+    const float* packed,
+    const float* bias,
+    float* C,
+    int ldc) {
+  detail::PackedSgemmDriver(
+      M,
+      N,
+      K,
+      A,
+      packed,
+      bias,
+      C,
+      ldc,
+      kBaseMR,
+      PackedSgemmMicroKernel__base);
+}
+
+void PackedSgemm(
+    int M,
+    int N,
+    int K,
+    const float* A,
+    const float* packed,
+    const float* bias,
+    float* C,
+    int ldc) {
+  AVX512_DO(PackedSgemm, M, N, K, A, packed, bias, C, ldc);
+  AVX2_FMA_DO(PackedSgemm, M, N, K, A, packed, bias, C, ldc);
+  BASE_DO(PackedSgemm, M, N, K, A, packed, bias, C, ldc);
+}
+
+} // namespace caffe2
@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace caffe2 {
+
+// Single precision GEMM against a weight matrix packed once ahead of time,
+// for FC layers whose weight doesn't change between runs.
+//
+// The weight W (N x K, row major, i.e. the layout FC uses) is packed into
+// ceil(N / kPackedSgemmNR) panels of K x kPackedSgemmNR floats, zero padded
+// past N, so that the micro-kernels read kPackedSgemmNR consecutive output
+// columns with one or two vector loads for every k.
+constexpr int kPackedSgemmNR = 16;
+
+// Number of floats needed to pack a N x K weight.
+size_t PackedSgemmSize(int N, int K);
+
+// Packs W (N x K, row major) into packed, which must hold PackedSgemmSize(N, K)
+// floats.
+void PackedSgemmPack(int N, int K, const float* W, float* packed);
+
+// Computes C = A * W^T + bias, with A of size M x K (row major, contiguous),
+// W packed by PackedSgemmPack and C of size M x N with a row stride of ldc.
+// bias has N elements and may be nullptr.
+void PackedSgemm(
+    int M,
+    int N,
+    int K,
+    const float* A,
+    const float* packed,
+    const float* bias,
+    float* C,
+    int ldc);
+
+namespace detail {
+
+// Computes the mr x nr tile C = A * B (+ C when accumulate, + bias otherwise)
+// for mr <= the kernel's rows, nr <= kPackedSgemmNR, where B is a kc x
+// kPackedSgemmNR slice of a panel and A has a row stride of lda.
+using PackedSgemmMicroKernel = void (*)(
+    int mr,
+    int nr,
+    int kc,
+    const float* A,
+    int lda,
+    const float* B,
+    const float* bias,
+    bool accumulate,
+    float* C,
+    int ldc);
+
+// Cache-blocked loop nest shared by all instruction sets: every kc x NR slice
+// of a panel is reused from L1 for all row blocks of A.
+void PackedSgemmDriver(
+    int M,
+    int N,
+    int K,
+    const float* A,
+    const float* packed,
+    const float* bias,
+    float* C,
+    int ldc,
+    int mr,
+    PackedSgemmMicroKernel kernel);
+
+} // namespace detail
+
+} // namespace caffe2
@@ -0,0 +1,134 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <immintrin.h>
+#include <algorithm>
+
+#include "caffe2/perfkernels/packed_sgemm.h"
+
+namespace caffe2 {
+
+namespace {
+
+// 6 rows x 16 columns of accumulators take 12 of the 16 ymm registers.
+constexpr int kMR = 6;
+
+template <int MR>
+inline void MicroKernel(
+    int nr,
+    int kc,
+    const float* A,
+    int lda,
+    const float* B,
+    const float* bias,
+    bool accumulate,
+    float* C,
+    int ldc) {
+  __m256 acc[MR][2];
+  for (int i = 0; i < MR; ++i) {
+    acc[i][0] = _mm256_setzero_ps();
+    acc[i][1] = _mm256_setzero_ps();
+  }
+  for (int k = 0; k < kc; ++k) {
+    const __m256 b0 = _mm256_loadu_ps(B + k * kPackedSgemmNR);
+    const __m256 b1 = _mm256_loadu_ps(B + k * kPackedSgemmNR + 8);
+    for (int i = 0; i < MR; ++i) {
+      const __m256 a = _mm256_broadcast_ss(A + i * lda + k);
+      acc[i][0] = _mm256_fmadd_ps(a, b0, acc[i][0]);
+      acc[i][1] = _mm256_fmadd_ps(a, b1, acc[i][1]);
+    }
+  }
+  if (nr == kPackedSgemmNR) {
+    for (int i = 0; i < MR; ++i) {
+      float* c = C + i * ldc;
+      __m256 init0, init1;
+      if (accumulate) {
+        init0 = _mm256_loadu_ps(c);
+        init1 = _mm256_loadu_ps(c + 8);
+      } else if (bias) {
+        init0 = _mm256_loadu_ps(bias);
+        init1 = _mm256_loadu_ps(bias + 8);
+      } else {
+        init0 = init1 = _mm256_setzero_ps();
+      }
+      _mm256_storeu_ps(c, _mm256_add_ps(init0, acc[i][0]));
+      _mm256_storeu_ps(c + 8, _mm256_add_ps(init1, acc[i][1]));
+    }
+    return;
+  }
+  // Partial last panel: go through a buffer so nothing past N is touched
+  alignas(32) float tile[kPackedSgemmNR];
+  for (int i = 0; i < MR; ++i) {
+    float* c = C + i * ldc;
+    _mm256_store_ps(tile, acc[i][0]);
+    _mm256_store_ps(tile + 8, acc[i][1]);
+    for (int j = 0; j < nr; ++j) {
+      c[j] = (accumulate ? c[j] : (bias ? bias[j] : 0.f)) + tile[j];
+    }
+  }
+}
+
+void PackedSgemmMicroKernel__avx2_fma(
+    int mr,
+    int nr,
+    int kc,
+    const float* A,
+    int lda,
+    const float* B,
+    const float* bias,
+    bool accumulate,
+    float* C,
+    int ldc) {
+  switch (mr) {
+#define CAFFE2_PACKED_SGEMM_CASE(R)                                  \
+  case R:                                                            \
+    MicroKernel<R>(nr, kc, A, lda, B, bias, accumulate, C, ldc);     \
+    break;
+    CAFFE2_PACKED_SGEMM_CASE(1)
+    CAFFE2_PACKED_SGEMM_CASE(2)
+    CAFFE2_PACKED_SGEMM_CASE(3)
+    CAFFE2_PACKED_SGEMM_CASE(4)
+    CAFFE2_PACKED_SGEMM_CASE(5)
+    CAFFE2_PACKED_SGEMM_CASE(6)
+#undef CAFFE2_PACKED_SGEMM_CASE
+  }
+}
+
+} // namespace
+
+void PackedSgemm__avx2_fma(
+    int M,
+    int N,
+    int K,
+    const float* A,
+    const float* packed,
+    const float* bias,
+    float* C,
+    int ldc) {
+  detail::PackedSgemmDriver(
+      M,
+      N,
+      K,
+      A,
+      packed,
+      bias,
+      C,
+      ldc,
+      kMR,
+      PackedSgemmMicroKernel__avx2_fma);
+}
+
+} // namespace caffe2
@@ -0,0 +1,123 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <immintrin.h>
+#include <algorithm>
+
+#include "caffe2/perfkernels/packed_sgemm.h"
+
+namespace caffe2 {
+
+namespace {
+
+// One zmm holds the 16 columns of a panel row, 12 rows of accumulators leave
+// room for the panel row and the broadcasts among the 32 zmm registers.
+constexpr int kMR = 12;
+
+template <int MR>
+inline void MicroKernel(
+    int nr,
+    int kc,
+    const float* A,
+    int lda,
+    const float* B,
+    const float* bias,
+    bool accumulate,
+    float* C,
+    int ldc) {
+  __m512 acc[MR];
+  for (int i = 0; i < MR; ++i) {
+    acc[i] = _mm512_setzero_ps();
+  }
+  for (int k = 0; k < kc; ++k) {
+    const __m512 b = _mm512_loadu_ps(B + k * kPackedSgemmNR);
+    for (int i = 0; i < MR; ++i) {
+      acc[i] = _mm512_fmadd_ps(_mm512_set1_ps(A[i * lda + k]), b, acc[i]);
+    }
+  }
+  // The partial last panel is handled with a store mask
+  const __mmask16 mask = static_cast<__mmask16>((1u << nr) - 1);
+  for (int i = 0; i < MR; ++i) {
+    float* c = C + i * ldc;
+    __m512 init;
+    if (accumulate) {
+      init = _mm512_maskz_loadu_ps(mask, c);
+    } else if (bias) {
+      init = _mm512_maskz_loadu_ps(mask, bias);
+    } else {
+      init = _mm512_setzero_ps();
+    }
+    _mm512_mask_storeu_ps(c, mask, _mm512_add_ps(init, acc[i]));
+  }
+}
+
+void PackedSgemmMicroKernel__avx512(
+    int mr,
+    int nr,
+    int kc,
+    const float* A,
+    int lda,
+    const float* B,
+    const float* bias,
+    bool accumulate,
+    float* C,
+    int ldc) {
+  switch (mr) {
+#define CAFFE2_PACKED_SGEMM_CASE(R)                                  \
+  case R:                                                            \
+    MicroKernel<R>(nr, kc, A, lda, B, bias, accumulate, C, ldc);     \
+    break;
+    CAFFE2_PACKED_SGEMM_CASE(1)
+    CAFFE2_PACKED_SGEMM_CASE(2)
+    CAFFE2_PACKED_SGEMM_CASE(3)
+    CAFFE2_PACKED_SGEMM_CASE(4)
+    CAFFE2_PACKED_SGEMM_CASE(5)
+    CAFFE2_PACKED_SGEMM_CASE(6)
+    CAFFE2_PACKED_SGEMM_CASE(7)
+    CAFFE2_PACKED_SGEMM_CASE(8)
+    CAFFE2_PACKED_SGEMM_CASE(9)
+    CAFFE2_PACKED_SGEMM_CASE(10)
+    CAFFE2_PACKED_SGEMM_CASE(11)
+    CAFFE2_PACKED_SGEMM_CASE(12)
+#undef CAFFE2_PACKED_SGEMM_CASE
+  }
+}
+
+} // namespace
+
+void PackedSgemm__avx512(
+    int M,
+    int N,
+    int K,
+    const float* A,
+    const float* packed,
+    const float* bias,
+    float* C,
+    int ldc) {
+  detail::PackedSgemmDriver(
+      M,
+      N,
+      K,
+      A,
+      packed,
+      bias,
+      C,
+      ldc,
+      kMR,
+      PackedSgemmMicroKernel__avx512);
+}
+
+} // namespace caffe2
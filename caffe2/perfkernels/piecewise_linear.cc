@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "caffe2/perfkernels/piecewise_linear.h"
+
+#include <algorithm>
+
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+void PiecewiseLinear__base(
+    int n,
+    const float* x,
+    const float* bounds,
+    const float* slopes,
+    const float* intercepts,
+    int num_funcs,
+    int group_stride,
+    float* y) {
+  for (int i = 0; i < n; ++i) {
+    const int g = i * group_stride;
+    const float* b = bounds + g * (num_funcs + 1);
+    const float* s = slopes + g * num_funcs;
+    const float* c = intercepts + g * num_funcs;
+    const float v = x[i];
+    if (v <= b[0]) {
+      y[i] = s[0] * b[0] + c[0];
+    } else if (v >= b[num_funcs]) {
+      y[i] = s[num_funcs - 1] * b[num_funcs] + c[num_funcs - 1];
+    } else if (num_funcs <= kPiecewiseLinearMaxScan) {
+      // Number of inner bounds below v, i.e. lower_bound - bounds - 1.
+      int k = 0;
+      for (int j = 1; j < num_funcs; ++j) {
+        k += b[j] < v;
+      }
+      y[i] = s[k] * v + c[k];
+    } else {
+      const int k = std::lower_bound(b, b + num_funcs + 1, v) - b - 1;
+      y[i] = s[k] * v + c[k];
+    }
+  }
+}
+
+void PiecewiseLinear(
+    int n,
+    const float* x,
+    const float* bounds,
+    const float* slopes,
+    const float* intercepts,
+    int num_funcs,
+    int group_stride,
+    float* y) {
+  AVX2_FMA_DO(
+      PiecewiseLinear,
+      n,
+      x,
+      bounds,
+      slopes,
+      intercepts,
+      num_funcs,
+      group_stride,
+      y);
+  BASE_DO(
+      PiecewiseLinear,
+      n,
+      x,
+      bounds,
+      slopes,
+      intercepts,
+      num_funcs,
+      group_stride,
+      y);
+}
+
+} // namespace caffe2
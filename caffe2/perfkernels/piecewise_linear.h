@@ -0,0 +1,42 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+namespace caffe2 {
+
+// Piecewise linear transform of n floats. Element i belongs to group
+// g = i * group_stride, so a group_stride of 0 applies a single group to all
+// of x and a group_stride of 1 gives every element its own group, as in a row
+// of PiecewiseLinearTransform. A group has num_funcs pieces: num_funcs + 1
+// sorted bounds starting at bounds + g * (num_funcs + 1), and num_funcs slopes
+// and intercepts starting at g * num_funcs. Inputs below the first bound or
+// above the last one are clamped to it. Groups of up to
+// kPiecewiseLinearMaxScan pieces find the piece of every element by a
+// branchless scan of the bounds, which vectorizes across elements; more
+// pieces are binary searched.
+constexpr int kPiecewiseLinearMaxScan = 32;
+
+void PiecewiseLinear(
+    int n,
+    const float* x,
+    const float* bounds,
+    const float* slopes,
+    const float* intercepts,
+    int num_funcs,
+    int group_stride,
+    float* y);
+
+} // namespace caffe2
@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <immintrin.h>
+
+#include "caffe2/perfkernels/piecewise_linear.h"
+
+namespace caffe2 {
+
+void PiecewiseLinear__base(
+    int n,
+    const float* x,
+    const float* bounds,
+    const float* slopes,
+    const float* intercepts,
+    int num_funcs,
+    int group_stride,
+    float* y);
+
+// Eight elements at a time: the bounds of their groups are broadcast or
+// gathered one by one and compared with the clamped inputs, which counts the
+// piece of every lane. Its slope and intercept are then gathered.
+void PiecewiseLinear__avx2_fma(
+    int n,
+    const float* x,
+    const float* bounds,
+    const float* slopes,
+    const float* intercepts,
+    int num_funcs,
+    int group_stride,
+    float* y) {
+  if (num_funcs > kPiecewiseLinearMaxScan) {
+    PiecewiseLinear__base(
+        n, x, bounds, slopes, intercepts, num_funcs, group_stride, y);
+    return;
+  }
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i last_func = _mm256_set1_epi32(num_funcs - 1);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    // Group of every lane, and the offsets of its bounds and pieces.
+    const __m256i g = _mm256_mullo_epi32(
+        _mm256_add_epi32(_mm256_set1_epi32(i), lanes),
+        _mm256_set1_epi32(group_stride));
+    const __m256i bound_offset =
+        _mm256_mullo_epi32(g, _mm256_set1_epi32(num_funcs + 1));
+    const __m256i func_offset =
+        _mm256_mullo_epi32(g, _mm256_set1_epi32(num_funcs));
+
+    const __m256 v = _mm256_loadu_ps(x + i);
+    const __m256 lo = _mm256_i32gather_ps(bounds, bound_offset, 4);
+    const __m256 hi = _mm256_i32gather_ps(
+        bounds + num_funcs, bound_offset, 4);
+    const __m256 clamped = _mm256_min_ps(_mm256_max_ps(v, lo), hi);
+
+    // The compare masks are -1 where the bound is below the input.
+    __m256i k = _mm256_setzero_si256();
+    for (int j = 1; j < num_funcs; ++j) {
+      const __m256 b = _mm256_i32gather_ps(bounds + j, bound_offset, 4);
+      k = _mm256_sub_epi32(
+          k, _mm256_castps_si256(_mm256_cmp_ps(b, clamped, _CMP_LT_OQ)));
+    }
+    // Inputs above the last bound use the last piece, unless they are also
+    // below the first one.
+    const __m256i above = _mm256_castps_si256(_mm256_and_ps(
+        _mm256_cmp_ps(v, hi, _CMP_GE_OQ), _mm256_cmp_ps(v, lo, _CMP_GT_OQ)));
+    k = _mm256_blendv_epi8(k, last_func, above);
+
+    const __m256i piece = _mm256_add_epi32(func_offset, k);
+    const __m256 s = _mm256_i32gather_ps(slopes, piece, 4);
+    const __m256 c = _mm256_i32gather_ps(intercepts, piece, 4);
+    _mm256_storeu_ps(y + i, _mm256_fmadd_ps(s, clamped, c));
+  }
+  PiecewiseLinear__base(
+      n - i,
+      x + i,
+      bounds + i * group_stride * (num_funcs + 1),
+      slopes + i * group_stride * num_funcs,
+      intercepts + i * group_stride * num_funcs,
+      num_funcs,
+      group_stride,
+      y + i);
+}
+
+} // namespace caffe2
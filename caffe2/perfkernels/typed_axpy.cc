@@ -58,6 +58,7 @@ void TypedAxpy<float16, float>(
     const float a,
     const float16* x,
     float* y) {
+  AVX512_DO(TypedAxpy_float16_float, N, a, x, y);
   AVX2_FMA_DO(TypedAxpy_float16_float, N, a, x, y);
   AVX_F16C_DO(TypedAxpy_float16_float, N, a, x, y);
   BASE_DO(TypedAxpy_float16_float, N, a, x, y);
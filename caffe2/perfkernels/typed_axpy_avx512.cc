@@ -0,0 +1,54 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <immintrin.h>
+
+#include "caffe2/core/types.h"
+#include "caffe2/perfkernels/typed_axpy.h"
+
+namespace caffe2 {
+
+void TypedAxpy_float16_float__avx512(
+    int N,
+    const float a,
+    const float16* x,
+    float* y) {
+  const __m512 mma = _mm512_set1_ps(a);
+  int current = 0;
+  for (; current + 16 <= N; current += 16) {
+    const __m512 mmx = _mm512_cvtph_ps(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + current)));
+    _mm512_storeu_ps(
+        y + current,
+        _mm512_fmadd_ps(mmx, mma, _mm512_loadu_ps(y + current)));
+  }
+  if (current < N) {
+    // The tail is converted like the full vectors, see Float16ToFloat.
+    const __mmask16 mask = (1 << (N - current)) - 1;
+    alignas(32) uint16_t tail[16] = {0};
+    for (int i = 0; current + i < N; ++i) {
+      tail[i] = x[current + i].x;
+    }
+    const __m512 mmx = _mm512_cvtph_ps(
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(tail)));
+    _mm512_mask_storeu_ps(
+        y + current,
+        mask,
+        _mm512_fmadd_ps(
+            mmx, mma, _mm512_maskz_loadu_ps(mask, y + current)));
+  }
+}
+
+} // namespace caffe2
@@ -68,6 +68,8 @@ def Parallelize(
     cpu_device=False,
     num_threads_per_device=4,
     shared_model=False,
+    allreduce_bucket_bytes=0,
+    hierarchical_allreduce=False,
 ):
     '''
     Function to create a model that can run on many GPUs or CPUs.
@@ -113,6 +115,17 @@ def Parallelize(
       blobs_to_keep :   A list of blob names to keep and don't free during
                         dynamic memory optimization (for example loss blob).
       cpu_device        Use CPU instead of GPU.
+      allreduce_bucket_bytes: (only for distributed training) if > 0, dense
+                        gradients are packed into buckets of up to this many
+                        bytes, and each bucket is reduced with a single
+                        Allreduce instead of one Allreduce per gradient.
+      hierarchical_allreduce: (only for distributed GPU training) reduce
+                        every gradient in three steps: an NCCL reduce-scatter
+                        across the local GPUs, an allreduce of each GPU's
+                        shard with the same GPU of the other nodes, and an
+                        NCCL allgather. Each GPU moves only 1 / len(devices)
+                        of the gradient across nodes. Uses the Gloo or MPI
+                        engine given in the rendezvous.
     '''
     assert scope.CurrentDeviceScope() is None \
         or scope.CurrentDeviceScope().device_type == caffe2_pb2.CPU, \
@@ -133,6 +146,10 @@ def Parallelize(
         model_helper_obj._shared_model = False
         device_name = "GPU"
         assert shared_model is False, "Shared model only supported on CPU"
+        if workspace.has_hip:
+            # Set up all the devices at once rather than one after the other
+            # as the nets first run on them.
+            workspace.InitializeHipDevices(devices)
     else:
         model_helper_obj._device_type = caffe2_pb2.CPU
         model_helper_obj._device_prefix = "cpu"
@@ -269,6 +286,8 @@ def Parallelize(
             rendezvous,
             use_nccl,
             max_concurrent_distributed_ops,
+            allreduce_bucket_bytes,
+            hierarchical_allreduce,
         )
     else:
         log.info("NOTE: Param builder function did not create any parameters.")
@@ -1130,7 +1149,8 @@ def _SyncAllParamsSingleHost(devices, model, net, unique_param_names):
 
 
 def _AllReduceBlobs(blob_names, devices, model, net, rendezvous, use_nccl,
-                    max_concurrent_distributed_ops):
+                    max_concurrent_distributed_ops, allreduce_bucket_bytes=0,
+                    hierarchical_allreduce=False):
     if rendezvous is None or rendezvous['num_shards'] <= 1:
         _AllReduceBlobsSingleHost(
             blob_names,
@@ -1139,6 +1159,17 @@ def _AllReduceBlobs(blob_names, devices, model, net, rendezvous, use_nccl,
             net,
             use_nccl
         )
+    elif hierarchical_allreduce and len(devices) > 1:
+        assert model._device_type != caffe2_pb2.CPU, \
+            "Hierarchical allreduce needs NCCL, it is only supported on GPUs"
+        _AllReduceBlobsHierarchical(
+            blob_names,
+            devices,
+            model,
+            net,
+            rendezvous,
+            allreduce_bucket_bytes,
+        )
     else:
         _AllReduceBlobsDistributed(
             blob_names,
@@ -1147,6 +1178,7 @@ def _AllReduceBlobs(blob_names, devices, model, net, rendezvous, use_nccl,
             net,
             rendezvous,
             max_concurrent_distributed_ops,
+            allreduce_bucket_bytes,
         )
 
 
@@ -1250,6 +1282,7 @@ def _AllReduceBlobsDistributed(
     net,
     rendezvous,
     max_concurrent_distributed_ops,
+    allreduce_bucket_bytes=0,
 ):
     num_workers = model.net.Proto().num_workers
     assert num_workers > 1, "Please specify more than 1 worker"
@@ -1268,7 +1301,14 @@ def _AllReduceBlobsDistributed(
 
     nccl_control_blob = None
 
-    for blob_name in blob_names:
+    buckets = _BucketBlobsForAllreduce(blob_names, model, allreduce_bucket_bytes)
+
+    for bucket in buckets:
+        if len(bucket) == 1:
+            blob_name = bucket[0]
+        else:
+            blob_name = _PackBucket(bucket, devices, model, net)
+
         master_blob = model._device_grouped_blobs[blob_name][devices[0]]
         blobs_group = list(viewvalues(model._device_grouped_blobs[blob_name]))
 
@@ -1323,6 +1363,213 @@ def _AllReduceBlobsDistributed(
             # Step 3: broadcast locally
             _Broadcast(devices, model, net, blob_name)
 
+        if len(bucket) > 1:
+            _UnpackBucket(bucket, blob_name, devices, model, net)
+
+
+def _AllReduceBlobsHierarchical(
+    blob_names,
+    devices,
+    model,
+    net,
+    rendezvous,
+    allreduce_bucket_bytes=0,
+):
+    '''
+    Reduces each bucket of gradients with a reduce-scatter across the local
+    GPUs, an allreduce of every GPU's shard across the nodes and an allgather
+    across the local GPUs. The shards of GPU i of all nodes are reduced over
+    their own common world, so the inter-node traffic of each GPU is
+    1 / len(devices) of the bucket and the local GPUs use the fabric in
+    parallel instead of all of it going through the master GPU.
+    '''
+    num_workers = model.net.Proto().num_workers
+    assert num_workers > 1, "Please specify more than 1 worker"
+    engine = rendezvous['engine']
+    assert engine in ('GLOO', 'MPI'), \
+        "Hierarchical allreduce supports the GLOO and MPI engines, not " + engine
+    shards = len(devices)
+
+    # One common world per local GPU, the collectives on each are chained
+    # with control inputs so that all nodes issue them in the same order.
+    common_worlds = []
+    for i, d in enumerate(devices):
+        cw_name = "hierarchical_allreduce_{}_cw".format(i)
+        if engine == 'MPI':
+            common_worlds.append(model.param_init_net.MPICreateCommonWorld(
+                [], cw_name))
+        else:
+            common_worlds.append(_CreateOrCloneCommonWorld(
+                model.param_init_net,
+                cw_name,
+                rendezvous=rendezvous,
+                status_blob="create_{}_status".format(cw_name),
+            ))
+    cw_control = [None] * shards
+    nccl_control_blob = None
+
+    buckets = _BucketBlobsForAllreduce(blob_names, model, allreduce_bucket_bytes)
+    for bucket in buckets:
+        bucket_name = _NextBucketName(
+            "hierarchical_bucket", devices, model, net)
+        device_opts = []
+        packed = []
+        for d in devices:
+            blobs = [model._device_grouped_blobs[b][d] for b in bucket]
+            device_opt = model._blob_to_device.get(
+                str(blobs[0]), core.DeviceOption(model._device_type, d))
+            device_opts.append(device_opt)
+            with core.DeviceScope(device_opt):
+                packed.append(net.PackBucket(
+                    blobs,
+                    "{}_{}/{}".format(model._device_prefix, d, bucket_name),
+                    shards=shards,
+                ))
+
+        # Step 1: GPU i gets the sum of row i of the local packed buckets.
+        local_shards = [str(p) + "_shard" for p in packed]
+        with core.DeviceScope(device_opts[0]):
+            local_shards = net.NCCLReduceScatter(
+                packed, local_shards, control_input=nccl_control_blob)
+
+        # Step 2: the shards are summed with the same GPU of the other nodes.
+        for i, shard in enumerate(local_shards):
+            with core.DeviceScope(device_opts[i]):
+                if engine == 'MPI':
+                    net.MPIAllreduce(
+                        [common_worlds[i], shard],
+                        shard,
+                        control_input=cw_control[i],
+                    )
+                else:
+                    net.Allreduce(
+                        [common_worlds[i], shard],
+                        shard,
+                        engine=engine,
+                        control_input=cw_control[i],
+                        status_blob="allreduce_{}_{}_status".format(
+                            bucket_name, i),
+                    )
+            cw_control[i] = shard
+
+        # Step 3: every GPU gathers all the reduced shards.
+        gathered = [str(p) + "_reduced" for p in packed]
+        with core.DeviceScope(device_opts[0]):
+            gathered = net.NCCLAllGather(local_shards, gathered)
+        nccl_control_blob = gathered[0]
+
+        for i, d in enumerate(devices):
+            blobs = [model._device_grouped_blobs[b][d] for b in bucket]
+            with core.DeviceScope(device_opts[i]):
+                net.UnpackBucket([gathered[i]] + blobs, blobs, shards=shards)
+
+
+def _BlobBytesFromInitNet(model):
+    '''
+    Returns (size in bytes, item size) of the params created with an explicit
+    shape by the param init net, keyed by the namescope-stripped gradient
+    name.
+    '''
+    master_prefix = "{}_{}/".format(model._device_prefix, model._devices[0])
+    param_bytes = {}
+    for op in model.param_init_net.Proto().op:
+        shape = [a.ints for a in op.arg if a.name == "shape"]
+        if len(shape) == 0 or len(op.output) != 1:
+            continue
+        if not op.output[0].startswith(master_prefix):
+            continue
+        itemsize = 2 if "Float16" in op.type else 4
+        param_bytes[op.output[0]] = (
+            int(np.prod(shape[0])) * itemsize, itemsize)
+
+    grad_bytes = {}
+    for p, g in viewitems(model.param_to_grad):
+        if isinstance(g, core.BlobReference) and str(p) in param_bytes:
+            grad_bytes[stripBlobName(g)] = param_bytes[str(p)]
+    return grad_bytes
+
+
+def _BucketBlobsForAllreduce(blob_names, model, bucket_bytes):
+    '''
+    Splits blob_names, in order, into lists of consecutive blobs whose total
+    size does not exceed bucket_bytes. Blobs of unknown size, or larger than
+    bucket_bytes, get a bucket of their own.
+    '''
+    if bucket_bytes <= 0:
+        return [[b] for b in blob_names]
+
+    blob_bytes = _BlobBytesFromInitNet(model)
+    buckets = []
+    current = []
+    current_bytes = 0
+    current_itemsize = None
+    for blob_name in blob_names:
+        nbytes, itemsize = blob_bytes.get(blob_name, (None, None))
+        if nbytes is None or nbytes >= bucket_bytes:
+            buckets.append([blob_name])
+            continue
+        # PackBucket needs all the blobs to have the same type.
+        if current and (current_bytes + nbytes > bucket_bytes or
+                        itemsize != current_itemsize):
+            buckets.append(current)
+            current = []
+            current_bytes = 0
+        current.append(blob_name)
+        current_bytes += nbytes
+        current_itemsize = itemsize
+    if current:
+        buckets.append(current)
+
+    log.info("Reducing {} blobs in {} buckets of up to {} bytes".format(
+        len(blob_names), len(buckets), bucket_bytes))
+    return buckets
+
+
+def _NextBucketName(prefix, devices, model, net):
+    '''
+    Returns the first "<prefix>_<i>" that no earlier allreduce of the model or
+    net has packed into, so that the buckets of several calls don't collide.
+    '''
+    index = 0
+    while True:
+        bucket_name = "{}_{}".format(prefix, index)
+        if bucket_name not in model._device_grouped_blobs and not any(
+            net.BlobIsDefined(
+                "{}_{}/{}".format(model._device_prefix, d, bucket_name))
+            for d in devices
+        ):
+            return bucket_name
+        index += 1
+
+
+def _PackBucket(bucket, devices, model, net):
+    '''
+    Packs the blobs in bucket into one flat blob per device, and registers it
+    as a device grouped blob so that it can be reduced like any other.
+    '''
+    bucket_name = _NextBucketName("allreduce_bucket", devices, model, net)
+    grouped = {}
+    for d in devices:
+        first_blob = model._device_grouped_blobs[bucket[0]][d]
+        device_opt = model._blob_to_device.get(
+            str(first_blob), core.DeviceOption(model._device_type, d))
+        with core.DeviceScope(device_opt):
+            grouped[d] = net.PackBucket(
+                [model._device_grouped_blobs[b][d] for b in bucket],
+                "{}_{}/{}".format(model._device_prefix, d, bucket_name),
+            )
+        model._blob_to_device[str(grouped[d])] = device_opt
+    model._device_grouped_blobs[bucket_name] = grouped
+    return bucket_name
+
+
+def _UnpackBucket(bucket, bucket_name, devices, model, net):
+    for d in devices:
+        blobs = [model._device_grouped_blobs[b][d] for b in bucket]
+        bucket_blob = model._device_grouped_blobs[bucket_name][d]
+        with core.DeviceScope(model._blob_to_device[str(bucket_blob)]):
+            net.UnpackBucket([bucket_blob] + blobs, blobs)
+
 
 def _AllReduceBlobsSingleHost(blob_names, devices, model, net, use_nccl):
     """Performs NCCL AllReduce to distribute blobs to all the GPUs."""
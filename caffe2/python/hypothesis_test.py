@@ -475,6 +475,74 @@ class TestOperators(hu.HypothesisTestCase):
         import numpy.testing as npt
         npt.assert_almost_equal(output, new_output, decimal=5)
 
+    def test_last_n_windows_lock_free(self):
+        num_to_collect = 7
+        init_net = core.Net('init_net')
+        init_net.ConstantFill([], 'output', shape=[num_to_collect, 2],
+                              value=-1.0)
+        init_net.ConstantFill([], 'next', shape=[], value=0,
+                              dtype=core.DataType.INT32)
+        init_net.CreateCounter([], 'cursor', init_count=0)
+        steps = []
+        for i in range(8):
+            workspace.FeedBlob('input:%d' % i, np.full(
+                [3, 2], i, dtype=np.float32))
+            collect_net = core.Net('collect_net:%d' % i)
+            collect_net.LastNWindowCollector(
+                ['output', 'next', 'input:%d' % i, 'cursor'],
+                ['output', 'next'],
+                num_to_collect=num_to_collect,
+            )
+            steps.append(core.execution_step(
+                'collect:%d' % i, collect_net, num_iter=10))
+        plan = core.Plan('collect_data')
+        plan.AddStep(core.execution_step('init', init_net))
+        plan.AddStep(core.execution_step(
+            'collect', steps, concurrent_substeps=True))
+        workspace.RunPlan(plan)
+
+        count_net = core.Net('count_net')
+        count_net.RetrieveCount(['cursor'], ['count'])
+        workspace.RunNetOnce(count_net)
+        self.assertEqual(workspace.FetchBlob('count'), 8 * 10 * 3)
+        # Every row was written whole by one of the writers
+        output = workspace.FetchBlob('output')
+        self.assertEqual(output.shape, (num_to_collect, 2))
+        for row in output:
+            self.assertIn(row[0], range(8))
+            self.assertEqual(row[0], row[1])
+
+    def test_sharded_reservoir_sampling(self):
+        num_to_collect = 20
+        init_net = core.Net('init_net')
+        init_net.CreateReservoirShards(
+            [], 'shards', num_shards=4, num_to_collect=num_to_collect)
+        steps = []
+        for i in range(8):
+            workspace.FeedBlob('input:%d' % i, np.arange(
+                i * 50, (i + 1) * 50, dtype=np.int64).reshape([25, 2]))
+            net = core.Net('sample_net:%d' % i)
+            net.ShardedReservoirSampling(['shards', 'input:%d' % i], [])
+            steps.append(core.execution_step(
+                'sample:%d' % i, net, num_iter=4))
+        plan = core.Plan('sample_data')
+        plan.AddStep(core.execution_step('init', init_net))
+        plan.AddStep(core.execution_step(
+            'sample', steps, concurrent_substeps=True))
+        workspace.RunPlan(plan)
+
+        read_net = core.Net('read_net')
+        read_net.ReadReservoirShards(['shards'], ['reservoir', 'num_visited'])
+        workspace.RunNetOnce(read_net)
+        self.assertEqual(workspace.FetchBlob('num_visited'), 8 * 4 * 25)
+        reservoir = workspace.FetchBlob('reservoir')
+        self.assertEqual(reservoir.shape, (num_to_collect, 2))
+        # Rows are sampled whole; a row may be sampled once per time it was
+        # seen (each input is seen 4 times)
+        np.testing.assert_array_equal(reservoir[:, 1], reservoir[:, 0] + 1)
+        self.assertTrue(np.all(reservoir[:, 0] % 2 == 0))
+        self.assertTrue(np.all(reservoir < 8 * 50))
+
     @given(dtype=st.sampled_from([np.float32, np.float64, np.int32, np.bool]))
     def test_print(self, dtype):
         data = np.random.permutation(6).astype(dtype)
@@ -544,6 +612,40 @@ class TestOperators(hu.HypothesisTestCase):
             return (grad_o, ms_o, mom_o)
         self.assertReferenceChecks(gc, op, [grad, ms, mom, lr], rmsprop)
 
+    @given(inputs=hu.tensors(n=4),
+           decay=st.floats(min_value=0.1, max_value=0.9),
+           momentum=st.floats(min_value=0.1, max_value=0.9),
+           lr=st.floats(min_value=0.1, max_value=0.9),
+           epsilon=st.floats(min_value=1e-5, max_value=1e-2),
+           data_strategy=st.data(),
+           **hu.gcs)
+    def test_sparse_rmsprop_sgd(self, inputs, decay, momentum, lr, epsilon,
+                                data_strategy, gc, dc):
+        param, ms, mom, grad = inputs
+        ms = np.abs(ms) + 0.01
+        lr = np.asarray([lr], dtype=np.float32)
+        # Indices may repeat, repeated rows are updated in order
+        indices = data_strategy.draw(
+            hu.tensor(dtype=np.int64, min_dim=1, max_dim=1,
+                      elements=st.sampled_from(np.arange(param.shape[0]))))
+        grad = grad[indices]
+        op = core.CreateOperator(
+            "SparseRmsProp",
+            ["param", "ms", "mom", "indices", "grad", "lr"],
+            ["param", "ms", "mom"],
+            momentum=momentum, decay=decay, epsilon=epsilon, device_option=gc)
+
+        def sparse_rmsprop(param, ms, mom, indices, grad, lr):
+            param, ms, mom = np.copy(param), np.copy(ms), np.copy(mom)
+            for i, index in enumerate(indices):
+                ms[index] += (1. - decay) * (np.square(grad[i]) - ms[index])
+                mom[index] = momentum * mom[index] + \
+                    lr[0] * grad[i] / np.sqrt(epsilon + ms[index])
+                param[index] += mom[index]
+            return (param, ms, mom)
+        self.assertReferenceChecks(
+            gc, op, [param, ms, mom, indices, grad, lr], sparse_rmsprop)
+
     # Reference
     @staticmethod
     def _dense_ftrl(alpha, beta, lambda1, lambda2, w, nz, g):
@@ -1107,13 +1209,15 @@ class TestOperators(hu.HypothesisTestCase):
             reference=log_ref)
         self.assertGradientChecks(gc, op, [input_tensor], 0, [0])
 
-    def test_blobs_dequeue_timeout(self):
+    @given(lock_free=st.booleans())
+    def test_blobs_dequeue_timeout(self, lock_free):
         op = core.CreateOperator(
             "CreateBlobsQueue",
             [],
             ["queue"],
             capacity=5,
-            num_blobs=1)
+            num_blobs=1,
+            lock_free=lock_free)
         self.ws.run(op)
         t = time.time()
         op = core.CreateOperator(
@@ -1129,9 +1233,10 @@ class TestOperators(hu.HypothesisTestCase):
            num_elements=st.integers(1, 100),
            capacity=st.integers(1, 5),
            num_blobs=st.integers(1, 3),
+           lock_free=st.booleans(),
            do=st.sampled_from(hu.device_options))
     def test_blobs_queue_threading(self, num_threads, num_elements,
-                                   capacity, num_blobs, do):
+                                   capacity, num_blobs, lock_free, do):
         """
         - Construct matrices of size N x D
         - Start K threads
@@ -1152,6 +1257,7 @@ class TestOperators(hu.HypothesisTestCase):
             ["queue"],
             capacity=capacity,
             num_blobs=num_blobs,
+            lock_free=lock_free,
             device_option=do)
         self.ws.run(op)
 
@@ -1218,12 +1324,14 @@ class TestOperators(hu.HypothesisTestCase):
            num_consumers=st.integers(1, 10),
            capacity=st.integers(1, 5),
            num_blobs=st.integers(1, 3),
+           lock_free=st.booleans(),
            do=st.sampled_from(hu.device_options))
     def test_safe_blobs_queue(self, num_producers, num_consumers,
-                              capacity, num_blobs, do):
+                              capacity, num_blobs, lock_free, do):
         init_net = core.Net('init_net')
         queue = init_net.CreateBlobsQueue(
-            [], 1, capacity=capacity, num_blobs=num_blobs)
+            [], 1, capacity=capacity, num_blobs=num_blobs,
+            lock_free=lock_free)
         producer_steps = []
         truth = 0
         for i in range(num_producers):
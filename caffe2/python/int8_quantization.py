@@ -0,0 +1,192 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+## @package int8_quantization
+# Module caffe2.python.int8_quantization
+"""Calibration and conversion of float nets to the Int8* CPU operators.
+
+collect_ranges runs a float net on representative inputs and records the range
+of every float blob. quantize_net then uses those ranges to rewrite FC, NHWC
+Conv, Relu and MaxPool into Int8FC, Int8Conv, Int8Relu and Int8MaxPool.
+Int8Quantize and Int8Dequantize are inserted where the net moves between float
+and quantized operators. Weights are quantized symmetrically to int8, either
+per output channel or per tensor, and are fed into the workspace as
+"<weight>_int8".
+"""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import copy
+
+import numpy as np
+
+from caffe2.python import core, workspace
+
+QUANTIZED_SUFFIX = "_int8"
+
+
+def collect_ranges(net, feeds, ranges=None):
+    """Runs `net` once for each dict of {blob name: value} in `feeds` and
+    returns a dict of {blob name: (min, max)} over all float blobs the net
+    writes. Pass the result back in as `ranges` to keep accumulating."""
+    net = net.Proto() if isinstance(net, core.Net) else net
+    ranges = {} if ranges is None else ranges
+    workspace.CreateNet(net, overwrite=True)
+    blobs = set(b for op in net.op for b in op.output)
+    for feed in feeds:
+        for name, value in feed.items():
+            workspace.FeedBlob(name, value)
+        workspace.RunNet(net.name)
+        for name in blobs:
+            value = workspace.FetchBlob(name)
+            if not isinstance(value, np.ndarray) or \
+                    value.dtype != np.float32 or value.size == 0:
+                continue
+            lo, hi = float(value.min()), float(value.max())
+            if name in ranges:
+                lo = min(lo, ranges[name][0])
+                hi = max(hi, ranges[name][1])
+            ranges[name] = (lo, hi)
+    return ranges
+
+
+def choose_quantization_params(lo, hi):
+    """Returns the (scale, zero_point) mapping [lo, hi] onto uint8. The range
+    is widened to contain 0 so that zero (e.g. padding) is exact."""
+    lo = min(lo, 0.0)
+    hi = max(hi, 0.0)
+    scale = (hi - lo) / 255.0
+    if scale == 0:
+        return 1.0, 0
+    zero_point = int(np.clip(np.round(-lo / scale), 0, 255))
+    return float(scale), zero_point
+
+
+def quantize_weights(w, per_channel=True):
+    """Symmetrically quantizes `w` to int8, per output channel (the first
+    dimension) or per tensor. Returns (w_int8, scales)."""
+    w = np.asarray(w, dtype=np.float32)
+    if per_channel:
+        max_abs = np.abs(w.reshape(w.shape[0], -1)).max(axis=1)
+    else:
+        max_abs = np.array([np.abs(w).max()])
+    scales = np.where(max_abs > 0, max_abs / 127.0, 1.0).astype(np.float32)
+    s = scales.reshape((-1,) + (1,) * (w.ndim - 1)) if per_channel else scales
+    w_int8 = np.clip(np.round(w / s), -127, 127).astype(np.int8)
+    return w_int8, [float(x) for x in scales]
+
+
+def _is_2d(args):
+    if "kernels" in args:
+        return len(args["kernels"].ints) == 2
+    return True
+
+
+def _quantizable(op):
+    args = {a.name: a for a in op.arg}
+    if op.type == "FC":
+        return True
+    if op.type == "Conv":
+        order = args["order"].s if "order" in args else b"NCHW"
+        group = args["group"].i if "group" in args else 1
+        return order in (b"NHWC", "NHWC") and group == 1 and _is_2d(args)
+    if op.type == "MaxPool":
+        return _is_2d(args)
+    return op.type == "Relu"
+
+
+def quantize_net(net, ranges, per_channel=True):
+    """Returns a copy of `net` in which the operators supported by the Int8*
+    operators run quantized, using the blob `ranges` from collect_ranges.
+    The weights of FC and Conv are read from, and their quantized versions
+    written to, the current workspace. Blobs without a recorded range keep
+    running in float."""
+    net = net.Proto() if isinstance(net, core.Net) else net
+    qnet = copy.deepcopy(net)
+    del qnet.op[:]
+    # Quantized blobs that are up to date, with their (scale, zero_point),
+    # and float blobs that are up to date.
+    quantized = {}
+    float_blobs = set(net.external_input)
+
+    def add(op, device_option):
+        if device_option is not None:
+            op.device_option.CopyFrom(device_option)
+        qnet.op.extend([op])
+
+    def ensure_quantized(name, device_option):
+        if name not in quantized:
+            scale, zero_point = choose_quantization_params(*ranges[name])
+            add(core.CreateOperator(
+                "Int8Quantize", [name], [name + QUANTIZED_SUFFIX],
+                Y_scale=scale, Y_zero_point=zero_point), device_option)
+            quantized[name] = (scale, zero_point)
+        return quantized[name]
+
+    def ensure_float(name, device_option):
+        if name not in float_blobs and name in quantized:
+            scale, zero_point = quantized[name]
+            add(core.CreateOperator(
+                "Int8Dequantize", [name + QUANTIZED_SUFFIX], [name],
+                X_scale=scale, X_zero_point=zero_point), device_option)
+            float_blobs.add(name)
+
+    for op in net.op:
+        device_option = op.device_option if op.HasField("device_option") \
+            else None
+        X = op.input[0] if op.input else None
+        if _quantizable(op) and all(b in ranges for b in op.output) and \
+                (X in quantized or X in ranges):
+            X_scale, X_zero_point = ensure_quantized(X, device_option)
+            Y = op.output[0]
+            args = [a for a in op.arg]
+            kwargs = {}
+            inputs = [X + QUANTIZED_SUFFIX]
+            if op.type in ("FC", "Conv"):
+                Y_scale, Y_zero_point = choose_quantization_params(*ranges[Y])
+                w_int8, w_scales = quantize_weights(
+                    workspace.FetchBlob(op.input[1]), per_channel)
+                workspace.FeedBlob(op.input[1] + QUANTIZED_SUFFIX, w_int8)
+                inputs += [op.input[1] + QUANTIZED_SUFFIX] + list(op.input[2:])
+                kwargs = dict(
+                    X_scale=X_scale, X_zero_point=X_zero_point,
+                    W_scale=w_scales, W_zero_point=0,
+                    Y_scale=Y_scale, Y_zero_point=Y_zero_point)
+            elif op.type == "Relu":
+                # Keeping the input's parameters turns Int8Relu into a clamp.
+                Y_scale, Y_zero_point = X_scale, X_zero_point
+                kwargs = dict(X_scale=X_scale, X_zero_point=X_zero_point)
+            else:
+                Y_scale, Y_zero_point = X_scale, X_zero_point
+            qop = core.CreateOperator(
+                "Int8" + op.type, inputs, [Y + QUANTIZED_SUFFIX], **kwargs)
+            qop.arg.extend(args)
+            add(qop, device_option)
+            quantized[Y] = (Y_scale, Y_zero_point)
+            float_blobs.discard(Y)
+            continue
+        for name in op.input:
+            ensure_float(name, device_option)
+        new_op = copy.deepcopy(op)
+        add(new_op, None)
+        for name in op.output:
+            quantized.pop(name, None)
+            float_blobs.add(name)
+
+    for name in net.external_output:
+        ensure_float(name, None)
+    return qnet
@@ -0,0 +1,85 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import unittest
+
+import numpy as np
+
+from caffe2.python import core, int8_quantization, workspace
+
+
+class Int8QuantizationTest(unittest.TestCase):
+    def setUp(self):
+        workspace.ResetWorkspace()
+
+    def test_choose_quantization_params(self):
+        scale, zero_point = int8_quantization.choose_quantization_params(
+            -1.0, 3.0)
+        self.assertAlmostEqual(scale, 4.0 / 255)
+        self.assertEqual(zero_point, 64)
+        # Ranges are widened to include zero.
+        scale, zero_point = int8_quantization.choose_quantization_params(
+            2.0, 5.1)
+        self.assertAlmostEqual(scale, 0.02)
+        self.assertEqual(zero_point, 0)
+
+    def test_quantize_weights(self):
+        w = np.array([[1.0, -0.25], [0.01, 0.04]], dtype=np.float32)
+        w_int8, scales = int8_quantization.quantize_weights(w)
+        self.assertEqual(w_int8.dtype, np.int8)
+        np.testing.assert_array_equal(w_int8, [[127, -32], [32, 127]])
+        np.testing.assert_allclose(scales, [1.0 / 127, 0.04 / 127], rtol=1e-6)
+
+    def test_quantize_net(self):
+        np.random.seed(0)
+        net = core.Net("mlp")
+        net.FC(["X", "W1", "b1"], "h")
+        net.Relu("h", "h")
+        net.FC(["h", "W2", "b2"], "Y")
+        net.Softmax("Y", "P")
+        net.AddExternalOutput("P")
+        for name, shape in [("W1", (32, 16)), ("b1", (32,)),
+                            ("W2", (10, 32)), ("b2", (10,))]:
+            workspace.FeedBlob(
+                name, np.random.randn(*shape).astype(np.float32) * 0.3)
+
+        feeds = [{"X": np.random.randn(8, 16).astype(np.float32)}
+                 for _ in range(4)]
+        ranges = int8_quantization.collect_ranges(net, feeds)
+        self.assertIn("X", ranges)
+        qnet = int8_quantization.quantize_net(net, ranges)
+        types = [op.type for op in qnet.op]
+        self.assertEqual(
+            types,
+            ["Int8Quantize", "Int8FC", "Int8Relu", "Int8FC", "Int8Dequantize",
+             "Softmax"])
+
+        X = np.random.randn(8, 16).astype(np.float32)
+        workspace.FeedBlob("X", X)
+        workspace.RunNetOnce(net)
+        P_float = workspace.FetchBlob("P")
+        workspace.FeedBlob("X", X)
+        workspace.RunNetOnce(qnet)
+        P_int8 = workspace.FetchBlob("P")
+        np.testing.assert_allclose(P_int8, P_float, atol=0.05)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -173,6 +173,99 @@ def optimize_inference_for_dag(net, input_blobs, namescope=""):
     return optim
 
 
+def _num_forward_ops(netproto):
+    # The first gradient op, or the op filling the gradient of the losses
+    for idx, op in enumerate(netproto.op):
+        if op.is_gradient_op or \
+                any(str(b).endswith("_grad") for b in op.output):
+            return idx
+    return len(netproto.op)
+
+
+def apply_recomputation(
+    net,
+    num_forward_ops=None,
+    segment_starts=None,
+    dont_drop_blobs=None,
+):
+    '''
+    Gradient checkpointing: frees the activations used only inside a segment
+    of the forward ops once the segment has run, and reruns the ops producing
+    them right before the gradient ops that need them. Trades an extra forward
+    pass over all but the last segment for the memory of those activations.
+
+    num_forward_ops defaults to the index of the first gradient op (or of the
+    op filling the gradient of the losses). segment_starts are forward op
+    indices, by default the forward ops are cut every sqrt(num_forward_ops).
+    Blobs fetched after the net has run, e.g. for metrics, have to be listed
+    in dont_drop_blobs as they may be freed otherwise.
+
+    Returns an optimized protobuf (assign to net._net)
+    '''
+    netproto = net.Proto()
+    if num_forward_ops is None:
+        num_forward_ops = _num_forward_ops(netproto)
+    start_time = time.time()
+    optim_str = C.memonger_apply_recomputation(
+        netproto.SerializeToString(),
+        num_forward_ops,
+        [] if segment_starts is None else list(segment_starts),
+        set() if dont_drop_blobs is None else
+        set(str(s).encode('utf-8') for s in dont_drop_blobs),
+    )
+    log.info("Memonger recomputation took {} secs".format(
+        time.time() - start_time),
+    )
+
+    optim = caffe2_pb2.NetDef()
+    optim.ParseFromString(optim_str)
+    return optim
+
+
+def apply_offload(
+    net,
+    blob_bytes,
+    peak_flops=0,
+    peak_bandwidth=0,
+    host_bandwidth=0,
+    min_bytes=1 << 20,
+    num_forward_ops=None,
+):
+    '''
+    Activation offload: copies the activations of blob_bytes (name to size
+    in bytes) of at least min_bytes to pinned host memory after their last
+    forward write, frees them on the device after their last forward read,
+    and prefetches them back ahead of their gradient ops. The copies run on
+    a stream of their own. They are placed from the cost model of the ops,
+    for a device with the given peak flops and memory bandwidth and host copy
+    bandwidth, in bytes per second, so the shapes of the blobs have to be in
+    the workspace, e.g. after a run of the net. Without host_bandwidth, the
+    copies are taken as instant.
+
+    Returns an optimized protobuf (assign to net._net)
+    '''
+    netproto = net.Proto()
+    if num_forward_ops is None:
+        num_forward_ops = _num_forward_ops(netproto)
+    start_time = time.time()
+    optim_str = C.memonger_apply_offload(
+        netproto.SerializeToString(),
+        num_forward_ops,
+        {str(b): int(n) for b, n in viewitems(blob_bytes)},
+        peak_flops,
+        peak_bandwidth,
+        host_bandwidth,
+        min_bytes,
+    )
+    log.info("Memonger offload took {} secs".format(
+        time.time() - start_time),
+    )
+
+    optim = caffe2_pb2.NetDef()
+    optim.ParseFromString(optim_str)
+    return optim
+
+
 def estimate_memory_usage(protos, shapes, types, devicescope):
     import numpy as np
     '''
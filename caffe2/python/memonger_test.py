@@ -238,6 +238,105 @@ class MemongerTest(hu.HypothesisTestCase):
         np.testing.assert_almost_equal(loss, optimized_loss)
         np.testing.assert_almost_equal(grad, optimized_grad)
 
+    @given(input_dim=st.integers(min_value=1, max_value=4),
+           output_dim=st.integers(min_value=1, max_value=4),
+           batch_size=st.integers(min_value=1, max_value=4),
+           segment_starts=st.sampled_from([None, [4, 9], [2, 3, 12]]))
+    def test_apply_recomputation(
+            self, input_dim, output_dim, batch_size, segment_starts):
+        m = model_helper.ModelHelper()
+        blob = brew.fc(m, "data", "fc0", dim_in=input_dim, dim_out=output_dim)
+        for i in range(1, 8):
+            blob = brew.relu(m, blob, blob)
+            blob = brew.fc(
+                m, blob, "fc{}".format(i), dim_in=output_dim,
+                dim_out=output_dim)
+        blob.Softmax([], "pred") \
+            .LabelCrossEntropy(["label"], ["xent"]) \
+            .AveragedLoss([], "loss")
+        input_to_grad = m.AddGradientOperators(["loss"])
+        optim_proto = memonger.apply_recomputation(
+            m.net, segment_starts=segment_starts)
+
+        # Some activations are freed, and the ops writing them run again
+        # among the gradient ops
+        op_types = [op.type for op in optim_proto.op]
+        self.assertIn("Free", op_types)
+        self.assertGreater(op_types.count("FC"), 8)
+        first_grad = min(
+            i for i, op in enumerate(optim_proto.op) if op.is_gradient_op)
+        self.assertIn("FC", op_types[first_grad:])
+
+        data = np.random.randn(batch_size, input_dim).astype(np.float32)
+        label = np.random.randint(
+            low=0, high=output_dim, size=(batch_size,)).astype(np.int32)
+        workspace.RunNetOnce(m.param_init_net)
+        workspace.FeedBlob("data", data)
+        workspace.FeedBlob("label", label)
+        workspace.RunNetOnce(m.net)
+        loss = workspace.FetchBlob("loss")
+        grads = [workspace.FetchBlob(str(input_to_grad[p]))
+                 for p in m.params]
+        # Twice, as the freed activations are written again by the next run
+        workspace.CreateNet(optim_proto, overwrite=True)
+        for _ in range(2):
+            workspace.RunNet(optim_proto.name)
+            np.testing.assert_almost_equal(loss, workspace.FetchBlob("loss"))
+            for p, grad in zip(m.params, grads):
+                np.testing.assert_almost_equal(
+                    grad, workspace.FetchBlob(str(input_to_grad[p])))
+
+    @given(input_dim=st.integers(min_value=1, max_value=4),
+           output_dim=st.integers(min_value=1, max_value=4),
+           batch_size=st.integers(min_value=1, max_value=4))
+    def test_apply_offload(self, input_dim, output_dim, batch_size):
+        m = model_helper.ModelHelper()
+        blob = "data"
+        for i in range(4):
+            blob = brew.fc(
+                m, blob, "fc{}".format(i),
+                dim_in=input_dim if i == 0 else output_dim,
+                dim_out=output_dim)
+            blob = brew.relu(m, blob, blob)
+        blob.Softmax([], "pred") \
+            .LabelCrossEntropy(["label"], ["xent"]) \
+            .AveragedLoss([], "loss")
+        input_to_grad = m.AddGradientOperators(["loss"])
+
+        data = np.random.randn(batch_size, input_dim).astype(np.float32)
+        label = np.random.randint(
+            low=0, high=output_dim, size=(batch_size,)).astype(np.int32)
+        workspace.RunNetOnce(m.param_init_net)
+        workspace.FeedBlob("data", data)
+        workspace.FeedBlob("label", label)
+        workspace.RunNetOnce(m.net)
+        loss = workspace.FetchBlob("loss")
+        grads = [workspace.FetchBlob(str(input_to_grad[p]))
+                 for p in m.params]
+        blob_bytes = {
+            "fc{}".format(i): workspace.FetchBlob("fc{}".format(i)).nbytes
+            for i in range(4)}
+
+        # With copies that take far longer than the net, nothing moves
+        slow_proto = memonger.apply_offload(
+            m.net, blob_bytes, peak_flops=1e12, peak_bandwidth=1e12,
+            host_bandwidth=1e-3, min_bytes=0)
+        self.assertNotIn(
+            "OffloadToHost", [op.type for op in slow_proto.op])
+
+        optim_proto = memonger.apply_offload(m.net, blob_bytes, min_bytes=0)
+        op_types = [op.type for op in optim_proto.op]
+        self.assertEqual(op_types.count("OffloadToHost"), 4)
+        self.assertEqual(op_types.count("PrefetchToDevice"), 4)
+        self.assertEqual(op_types.count("WaitOffload"), 8)
+        workspace.CreateNet(optim_proto, overwrite=True)
+        for _ in range(2):
+            workspace.RunNet(optim_proto.name)
+            np.testing.assert_almost_equal(loss, workspace.FetchBlob("loss"))
+            for p, grad in zip(m.params, grads):
+                np.testing.assert_almost_equal(
+                    grad, workspace.FetchBlob(str(input_to_grad[p])))
+
     @unittest.skipIf(not workspace.has_gpu_support, "No gpu support.")
     def test_memonger_mix_cpu_gpu(self):
         '''
@@ -0,0 +1,54 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import unittest
+import hypothesis.strategies as st
+from hypothesis import given
+import numpy as np
+from caffe2.python import core, workspace
+import caffe2.python.hypothesis_test_util as hu
+import caffe2.python.mkl_test_util as mu
+
+
+@unittest.skipIf(not workspace.C.has_mkldnn,
+                 "Skipping as we do not have mkldnn.")
+class MKLConcatTest(hu.HypothesisTestCase):
+    @given(num_inputs=st.integers(1, 4),
+           batch_size=st.integers(1, 3),
+           size=st.integers(1, 7),
+           **mu.gcs)
+    def test_mkl_concat(self, num_inputs, batch_size, size, gc, dc):
+        channels = [np.random.randint(1, 5) for _ in range(num_inputs)]
+        inputs = [
+            np.random.rand(batch_size, c, size, size).astype(np.float32) - 0.5
+            for c in channels]
+        op = core.CreateOperator(
+            "Concat",
+            ["X{}".format(i) for i in range(num_inputs)],
+            ["Y", "split_info"],
+            order="NCHW",
+        )
+        self.assertDeviceChecks(dc, op, inputs, [0])
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
@@ -46,6 +46,29 @@ class MKLFcTest(hu.HypothesisTestCase):
 
         self.assertDeviceChecks(dc, op, [X, W, b], [0])
 
+    @given(n=st.integers(1, 5), m=st.integers(1, 5),
+           k=st.integers(1, 5), **mu.gcs)
+    def test_mkl_fc_relu(self, n, m, k, gc, dc):
+        X = np.random.rand(m, k).astype(np.float32) - 0.5
+        W = np.random.rand(n, k).astype(np.float32) - 0.5
+        b = np.random.rand(n).astype(np.float32) - 0.5
+
+        op = core.CreateOperator(
+            'FC',
+            ['X', 'W', 'b'],
+            ["Y"],
+            relu=True,
+            device_option=mu.mkl_do,
+        )
+        self.ws.create_blob("X").feed(X, mu.mkl_do)
+        self.ws.create_blob("W").feed(W, mu.mkl_do)
+        self.ws.create_blob("b").feed(b, mu.mkl_do)
+        self.ws.run(op)
+        np.testing.assert_allclose(
+            self.ws.blobs["Y"].fetch(),
+            np.maximum(np.dot(X, W.T) + b, 0),
+            atol=1e-4, rtol=1e-4)
+
 
 if __name__ == "__main__":
     import unittest
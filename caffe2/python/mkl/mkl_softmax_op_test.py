@@ -0,0 +1,63 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import unittest
+import hypothesis.strategies as st
+from hypothesis import given
+import numpy as np
+from caffe2.python import core, workspace
+import caffe2.python.hypothesis_test_util as hu
+import caffe2.python.mkl_test_util as mu
+
+
+@unittest.skipIf(not workspace.C.has_mkldnn,
+                 "Skipping as we do not have mkldnn.")
+class MKLSoftmaxTest(hu.HypothesisTestCase):
+    @given(n=st.integers(1, 5), d=st.integers(1, 20), **mu.gcs)
+    def test_mkl_softmax(self, n, d, gc, dc):
+        X = np.random.rand(n, d).astype(np.float32) - 0.5
+        op = core.CreateOperator("Softmax", ["X"], ["Y"])
+        self.assertDeviceChecks(dc, op, [X], [0])
+
+    @given(n=st.integers(1, 4), m=st.integers(1, 10), k=st.integers(1, 10),
+           **mu.gcs)
+    def test_mkl_fc_softmax(self, n, m, k, gc, dc):
+        # The output of the inner product is read without conversion.
+        X = np.random.rand(m, k).astype(np.float32) - 0.5
+        W = np.random.rand(n, k).astype(np.float32) - 0.5
+        b = np.random.rand(n).astype(np.float32) - 0.5
+        net = core.Net("fc_softmax")
+        net.FC(["X", "W", "b"], "fc")
+        net.Softmax("fc", "Y")
+        for blob, value in zip(["X", "W", "b"], [X, W, b]):
+            self.ws.create_blob(blob).feed(value, mu.mkl_do)
+        net.Proto().device_option.CopyFrom(mu.mkl_do)
+        self.ws.run(net)
+        logits = np.dot(X, W.T) + b
+        expected = np.exp(logits - logits.max(axis=1, keepdims=True))
+        expected /= expected.sum(axis=1, keepdims=True)
+        np.testing.assert_allclose(
+            self.ws.blobs["Y"].fetch(), expected, atol=1e-4, rtol=1e-4)
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
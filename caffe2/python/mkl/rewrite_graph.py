@@ -75,6 +75,114 @@ def rewrite_run_net_simple(net):
         op.engine = ""
 
 
+# Operators with a native MKL implementation. The MKL fallback operators are
+# left out, as they convert their inputs and outputs on every run.
+MKL_OPERATORS = set([
+    "AveragePool", "Concat", "Conv", "FC", "LRN", "MaxPool", "Relu",
+    "Softmax", "SpatialBN", "Sum",
+])
+
+# Outputs of MKL operators that are TensorCPU rather than MKLMemory.
+MKL_CPU_OUTPUTS = {
+    "Concat": [1],
+}
+
+
+def _runs_on_mkl(op, mkl_operators):
+    if op.type not in mkl_operators:
+        return False
+    for arg in op.arg:
+        if arg.name == "order" and arg.s in (b"NHWC", "NHWC"):
+            return False
+    return True
+
+
+def rewrite_run_net(net, init_net=None, mkl_operators=MKL_OPERATORS):
+    """Runs the MKL capable operators of net on MKL, the others on CPU.
+
+    Consecutive MKL operators hand their MKLMemory outputs to each other
+    directly, so the blobs keep the internal layout the producer chose and
+    the consumer can take it without a reorder. Copies between TensorCPU and
+    MKLMemory are only inserted where an MKL operator reads a blob written
+    by a CPU operator or the reverse, and each version of a blob is copied
+    at most once.
+
+    If init_net is given, the blobs it produces are taken as parameters:
+    they stay on CPU and the copies to MKL of the ones read by MKL operators
+    are appended to init_net, so that they are not repeated on every run.
+    """
+    def mkl_tmp(name):
+        return "{}__MKL__".format(name)
+
+    mkl_device = core.DeviceOption(device_type=caffe2_pb2.MKLDNN)
+    params = set()
+    if init_net is not None:
+        for op in init_net.op:
+            params.update(op.output)
+        # A parameter written by net has to be copied again after that.
+        for op in net.op:
+            params.difference_update(op.output)
+    # The blobs whose current value is on CPU, and the ones that have it on
+    # MKL.
+    on_cpu = set(net.external_input)
+    on_mkl = set()
+
+    def copy_op(op_type, src, dst):
+        op = core.CreateOperator(op_type, src, dst)
+        op.device_option.CopyFrom(mkl_device)
+        return op
+
+    ops = []
+    for op in net.op:
+        op = copy.deepcopy(op)
+        if _runs_on_mkl(op, mkl_operators):
+            for blob in op.input:
+                if blob in on_mkl:
+                    continue
+                copy_in = copy_op("CopyCPUToMKL", blob, mkl_tmp(blob))
+                if blob in params:
+                    init_net.op.extend([copy_in])
+                else:
+                    ops.append(copy_in)
+                on_mkl.add(blob)
+            cpu_outputs = MKL_CPU_OUTPUTS.get(op.type, [])
+            outputs = []
+            for i, blob in enumerate(op.output):
+                if i in cpu_outputs:
+                    on_mkl.discard(blob)
+                    on_cpu.add(blob)
+                    outputs.append(blob)
+                else:
+                    on_cpu.discard(blob)
+                    on_mkl.add(blob)
+                    outputs.append(mkl_tmp(blob))
+            op.input[:] = [mkl_tmp(blob) for blob in op.input]
+            op.output[:] = outputs
+            op.device_option.MergeFrom(mkl_device)
+            op.engine = ""
+        else:
+            for blob in op.input:
+                if blob in on_mkl and blob not in on_cpu:
+                    ops.append(copy_op("CopyMKLToCPU", mkl_tmp(blob), blob))
+                    on_cpu.add(blob)
+            on_mkl.difference_update(op.output)
+            on_cpu.update(op.output)
+        ops.append(op)
+
+    for blob in net.external_output:
+        if blob in on_mkl and blob not in on_cpu:
+            ops.append(copy_op("CopyMKLToCPU", mkl_tmp(blob), blob))
+    del net.op[:]
+    net.op.extend(ops)
+
+
+def rewrite_model_helper(model, mkl_operators=MKL_OPERATORS):
+    model = copy.deepcopy(model)
+    rewrite_run_net(
+        model.net.Proto(), model.param_init_net.Proto(), mkl_operators)
+    return model
+
+
 def rewrite_model_helper_simple(model):
     model = copy.deepcopy(model)
     # All parameter initialization should run on MKL
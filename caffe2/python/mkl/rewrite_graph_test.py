@@ -195,6 +195,39 @@ def complex_resnet():
     return model, [(1, 1, 224, 224)]
 
 
+def mixed_cnn():
+    model = ModelHelper(name="r", arg_scope={"order": "NCHW", "is_test": True})
+    brew.conv(
+        model, "data", 'conv1', 3, 16, kernel=3, stride=1
+    )
+    brew.relu(model, 'conv1', 'conv1')
+    # Sigmoid has no native MKL implementation and stays on CPU.
+    model.net.Sigmoid('conv1', 'sig1')
+    brew.max_pool(model, 'sig1', 'pool1', kernel=2, stride=2)
+    brew.conv(
+        model, 'pool1', 'conv2', 16, 16, kernel=3, stride=1
+    )
+    return model, [(1, 3, 32, 32)]
+
+
+class MKLRewritePassTest(unittest.TestCase):
+    def test_copies_only_at_boundaries(self):
+        cpu_model, _ = mixed_cnn()
+        cpu_model = deterministic_io(cpu_model)
+        mkl_model = rewrite_graph.rewrite_model_helper(cpu_model)
+        types = [op.type for op in mkl_model.Proto().op]
+        self.assertEqual(types, [
+            "CopyCPUToMKL", "Conv", "Relu", "CopyMKLToCPU", "Sigmoid",
+            "CopyCPUToMKL", "MaxPool", "Conv", "CopyMKLToCPU"])
+        # The weights are copied once, by the init net.
+        init_copies = [op.input[0] for op in mkl_model.InitProto().op
+                       if op.type == "CopyCPUToMKL"]
+        self.assertEqual(
+            sorted(init_copies), ["conv1_b", "conv1_w", "conv2_b", "conv2_w"])
+        external_output = mkl_model.Proto().external_output[0]
+        self.assertEqual(mkl_model.Proto().op[-1].output[0], external_output)
+
+
 @unittest.skipIf(not workspace.C.has_mkldnn,
                  "Skipping as we do not have mkldnn.")
 class MKLRewriteTest(hu.HypothesisTestCase):
@@ -215,6 +248,22 @@ class MKLRewriteTest(hu.HypothesisTestCase):
         np.testing.assert_allclose(run(cpu_model), run(mkl_model),
                                    atol=1e-4, rtol=1e-4)
 
+    @given(gen=st.sampled_from([simple_mlp, simple_cnn, mixed_cnn]))
+    def test_mkl_rewrite(self, gen):
+        cpu_model, (shape,) = gen()
+        cpu_model = deterministic_io(cpu_model)
+        mkl_model = rewrite_graph.rewrite_model_helper(cpu_model)
+        X = np.random.randn(*shape).astype(np.float32)
+
+        def run(model):
+            self.ws.run(model.InitProto())
+            self.ws.create_blob(model.Proto().external_input[0]).feed(X)
+            self.ws.run(model.Proto())
+            return self.ws.blobs[model.Proto().external_output[0]].fetch()
+
+        np.testing.assert_allclose(run(cpu_model), run(mkl_model),
+                                   atol=1e-4, rtol=1e-4)
+
     def test_mkl_resnet_rewrite(self):
         cpu_model, (shape,) = complex_resnet()
         cpu_model = deterministic_io(cpu_model)
@@ -205,108 +205,29 @@ class BeamSearchForwardOnly(object):
                 axis=0,
             )
 
-        # [beam_size, beam_size]
-        best_scores_per_hypo, best_tokens_per_hypo = self.step_model.net.TopK(
-            log_probs,
-            ['best_scores_per_hypo', 'best_tokens_per_hypo_indices'],
-            k=self.beam_size,
-        )
+        # The per hypothesis TopK, the scoring and the TopK over all the
+        # candidates are done by a single operator.
+        step_inputs = [log_probs, self.scores_t_prev, self.timestep]
+        if word_rewards is not None or possible_translation_tokens:
+            if word_rewards is None:
+                # an empty tensor stands for no rewards
+                word_rewards = self.model.param_init_net.ConstantFill(
+                    [],
+                    'no_word_rewards',
+                    shape=[0],
+                    value=0.0,
+                    dtype=core.DataType.FLOAT,
+                )
+            step_inputs.append(word_rewards)
         if possible_translation_tokens:
-            # [beam_size, beam_size]
-            best_tokens_per_hypo = self.step_model.net.Gather(
-                [possible_translation_tokens, best_tokens_per_hypo],
-                ['best_tokens_per_hypo']
-            )
-
-        # [beam_size]
-        scores_t_prev_squeezed, _ = self.step_model.net.Reshape(
-            self.scores_t_prev,
-            ['scores_t_prev_squeezed', 'scores_t_prev_old_shape'],
-            shape=[self.beam_size],
-        )
-        # [beam_size, beam_size]
-        output_scores = self.step_model.net.Add(
-            [best_scores_per_hypo, scores_t_prev_squeezed],
-            'output_scores',
-            broadcast=1,
-            axis=0,
-        )
-        if word_rewards is not None:
-            # [beam_size, beam_size]
-            word_rewards_for_best_tokens_per_hypo = self.step_model.net.Gather(
-                [word_rewards, best_tokens_per_hypo],
-                'word_rewards_for_best_tokens_per_hypo',
-            )
-            # [beam_size, beam_size]
-            output_scores = self.step_model.net.Add(
-                [output_scores, word_rewards_for_best_tokens_per_hypo],
-                'output_scores',
-            )
-        # [beam_size * beam_size]
-        output_scores_flattened, _ = self.step_model.net.Reshape(
-            [output_scores],
-            [output_scores, 'output_scores_old_shape'],
-            shape=[-1],
-        )
-        MINUS_ONE_INT32 = self.model.param_init_net.ConstantFill(
-            [],
-            'MINUS_ONE_INT32',
-            value=-1,
-            shape=[1],
-            dtype=core.DataType.INT32,
-        )
-        BEAM_SIZE = self.model.param_init_net.ConstantFill(
-            [],
-            'beam_size',
-            shape=[1],
-            value=self.beam_size,
-            dtype=core.DataType.INT32,
-        )
-
-        # current_beam_size (predecessor states from previous step)
-        # is 1 on first step (so we just need beam_size scores),
-        # and beam_size subsequently (so we need all beam_size * beam_size
-        # scores)
-        slice_end = self.step_model.net.Conditional(
-            [on_initial_step, BEAM_SIZE, MINUS_ONE_INT32],
-            ['slice_end'],
-        )
-
-        # [current_beam_size * beam_size]
-        output_scores_flattened_slice = self.step_model.net.Slice(
-            [output_scores_flattened, ZERO, slice_end],
-            'output_scores_flattened_slice',
-        )
-        # [1, current_beam_size * beam_size]
-        output_scores_flattened_slice, _ = self.step_model.net.Reshape(
-            output_scores_flattened_slice,
-            [
-                output_scores_flattened_slice,
-                'output_scores_flattened_slice_old_shape',
-            ],
-            shape=[1, -1],
-        )
-        # [1, beam_size]
-        scores_t, best_indices = self.step_model.net.TopK(
-            output_scores_flattened_slice,
-            ['scores_t', 'best_indices'],
-            k=self.beam_size,
-        )
-        BEAM_SIZE_64 = self.model.param_init_net.Cast(
-            BEAM_SIZE,
-            'BEAM_SIZE_64',
-            to=core.DataType.INT64,
-        )
+            step_inputs.append(possible_translation_tokens)
         # [1, beam_size]
-        hypo_t_int32 = self.step_model.net.Div(
-            [best_indices, BEAM_SIZE_64],
-            'hypo_t_int32',
-            broadcast=1,
-        )
-        hypo_t = self.step_model.net.Cast(
-            hypo_t_int32,
-            'hypo_t',
-            to=core.DataType.FLOAT,
+        scores_t, tokens_t, hypo_t, hypo_t_int32 = (
+            self.step_model.net.BeamSearchStep(
+                step_inputs,
+                ['scores_t', 'tokens_t', 'hypo_t', 'hypo_t_int32'],
+                beam_size=self.beam_size,
+            )
         )
 
         # [beam_size, encoder_length, 1]
@@ -320,24 +241,6 @@ class BeamSearchForwardOnly(object):
             [attention_t, 'attention_t_old_shape'],
             shape=[1, self.beam_size, -1],
         )
-        # [beam_size * beam_size]
-        best_tokens_per_hypo_flatten, _ = self.step_model.net.Reshape(
-            best_tokens_per_hypo,
-            [
-                'best_tokens_per_hypo_flatten',
-                'best_tokens_per_hypo_old_shape',
-            ],
-            shape=[-1],
-        )
-        tokens_t_int32 = self.step_model.net.Gather(
-            [best_tokens_per_hypo_flatten, best_indices],
-            'tokens_t_int32',
-        )
-        tokens_t = self.step_model.net.Cast(
-            tokens_t_int32,
-            'tokens_t',
-            to=core.DataType.FLOAT,
-        )
 
         def choose_state_per_hypo(state_config):
             state_flattened, _ = self.step_model.net.Reshape(
@@ -406,6 +406,19 @@ class Seq2SeqModelCaffe2EnsembleDecoder(object):
             data_dependencies=[],
             word_rewards=word_rewards,
         )
+        (
+            self.output_tokens,
+            self.output_hypos,
+            self.output_score,
+        ) = self.model.net.BeamSearchBacktrack(
+            [
+                self.output_token_beam_list,
+                self.output_prev_index_beam_list,
+                self.output_score_beam_list,
+            ],
+            ['output_tokens', 'output_hypos', 'output_score'],
+            eos_token_id=seq2seq_util.EOS_ID,
+        )
 
         workspace.RunNetOnce(self.model.param_init_net)
         workspace.FeedBlob(
@@ -478,53 +491,23 @@ class Seq2SeqModelCaffe2EnsembleDecoder(object):
 
         workspace.RunNet(self.model.net)
 
-        num_steps = max_output_seq_len
-        score_beam_list = workspace.FetchBlob(self.output_score_beam_list)
-        token_beam_list = (
-            workspace.FetchBlob(self.output_token_beam_list)
-        )
-        prev_index_beam_list = (
-            workspace.FetchBlob(self.output_prev_index_beam_list)
-        )
-
         attention_weights_beam_list = (
             workspace.FetchBlob(self.output_attention_weights_beam_list)
         )
-        best_indices = (num_steps, 0)
-        for i in range(num_steps + 1):
-            for hyp_index in range(self.beam_size):
-                if (
-                    (
-                        token_beam_list[i][hyp_index][0] ==
-                        seq2seq_util.EOS_ID or
-                        i == num_steps
-                    ) and
-                    (
-                        score_beam_list[i][hyp_index][0] >
-                        score_beam_list[best_indices[0]][best_indices[1]][0]
-                    )
-                ):
-                    best_indices = (i, hyp_index)
-
-        i, hyp_index = best_indices
-        output = []
-        attention_weights_per_token = []
-        best_score = -score_beam_list[i][hyp_index][0]
-        while i > 0:
-            output.append(token_beam_list[i][hyp_index][0])
-            attention_weights_per_token.append(
-                attention_weights_beam_list[i][hyp_index]
-            )
-            hyp_index = prev_index_beam_list[i][hyp_index][0]
-            i -= 1
+        output = workspace.FetchBlob(self.output_tokens).tolist()
+        best_score = -workspace.FetchBlob(self.output_score)[0]
+        # the output token i was chosen at step i + 1
+        attention_weights_per_token = [
+            attention_weights_beam_list[i + 1][hyp_index]
+            for i, hyp_index in enumerate(
+                workspace.FetchBlob(self.output_hypos))
+        ]
 
-        attention_weights_per_token = reversed(attention_weights_per_token)
         # encoder_inputs are reversed, see get_batch func
         attention_weights_per_token = [
             list(reversed(attention_weights))[:len(numberized_input)]
             for attention_weights in attention_weights_per_token
         ]
-        output = list(reversed(output))
         return output, attention_weights_per_token, best_score
 
 
@@ -18,7 +18,7 @@ from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
 
-from caffe2.python import workspace
+from caffe2.python import core, workspace
 from caffe2.python.core import Plan, to_execution_step, Net
 from caffe2.python.task import Task, TaskGroup, final_output
 from caffe2.python.net_builder import ops, NetBuilder
@@ -261,6 +261,38 @@ class TestNetBuilder(unittest.TestCase):
             self.assertEquals(total2.fetch(), NUM_INSTANCES * (NUM_ITERS ** 2))
             self.assertEquals(total3.fetch(), NUM_INSTANCES * (NUM_ITERS ** 2))
 
+    def test_concurrent_substeps_repeated(self):
+        """
+        The producer blocks on the queue until the consumer dequeues, so the
+        two concurrent substeps only finish if they run at the same time,
+        every time the outer step runs them.
+        """
+        NUM_ITERS = 20
+        NUM_ITEMS = 3
+        init_net = core.Net('init')
+        queue = init_net.CreateBlobsQueue(
+            [], 'queue', capacity=1, num_blobs=1)
+        counter = init_net.CreateCounter([], 'counter', init_count=0)
+        init_net.ConstantFill([], 'item', shape=[1], value=1.0)
+        producer = core.Net('producer')
+        producer.EnqueueBlobs([queue, 'item'], ['item'])
+        consumer = core.Net('consumer')
+        consumer.DequeueBlobs([queue], ['dequeued'])
+        consumer.CountUp([counter], ['unused'])
+        inner = core.execution_step('inner', [
+            core.execution_step('produce', producer, num_iter=NUM_ITEMS),
+            core.execution_step('consume', consumer, num_iter=NUM_ITEMS),
+        ], concurrent_substeps=True)
+        plan = Plan('repeated')
+        plan.AddStep(core.execution_step('init', init_net))
+        plan.AddStep(core.execution_step('outer', [inner], num_iter=NUM_ITERS))
+        workspace.ResetWorkspace()
+        self.assertTrue(workspace.RunPlan(plan))
+        retrieve = core.Net('retrieve')
+        retrieve.RetrieveCount([counter], ['count'])
+        workspace.RunNetOnce(retrieve)
+        self.assertEquals(workspace.FetchBlob('count'), NUM_ITERS * NUM_ITEMS)
+
     def test_if_net(self):
         with NetBuilder() as nb:
             x0 = ops.Const(0)
@@ -149,6 +149,46 @@ class TestAdagrad(hu.HypothesisTestCase):
                 ref_sparse
             )
 
+    @given(inputs=hu.tensors(n=3),
+           lr=st.floats(min_value=0.01, max_value=0.99,
+                        allow_nan=False, allow_infinity=False),
+           epsilon=st.floats(min_value=0.01, max_value=0.99,
+                             allow_nan=False, allow_infinity=False),
+           data_strategy=st.data(),
+           **hu.gcs)
+    def test_sparse_adagrad_duplicate_indices(self, inputs, lr, epsilon,
+                                              data_strategy, gc, dc):
+        param, momentum, grad = inputs
+        momentum = np.abs(momentum)
+        lr = np.array([lr], dtype=np.float32)
+
+        # Duplicated indices are applied one after the other, in order
+        indices = data_strategy.draw(
+            hu.tensor1d(min_len=1, max_len=2 * grad.shape[0], dtype=np.int64,
+                        elements=st.sampled_from(np.arange(grad.shape[0]))),
+        )
+        grad = np.random.rand(
+            *((indices.shape[0],) + grad.shape[1:])).astype(np.float32)
+
+        op = core.CreateOperator(
+            "SparseAdagrad",
+            ["param", "momentum", "indices", "grad", "lr"],
+            ["param", "momentum"],
+            epsilon=epsilon,
+            device_option=gc)
+
+        def ref_sparse(param, momentum, indices, grad, lr):
+            param_out = np.copy(param)
+            momentum_out = np.copy(momentum)
+            for i, index in enumerate(indices):
+                param_out[index], momentum_out[index] = self.ref_adagrad(
+                    param_out[index], momentum_out[index], grad[i], lr,
+                    epsilon)
+            return (param_out, momentum_out)
+
+        self.assertReferenceChecks(
+            gc, op, [param, momentum, indices, grad, lr], ref_sparse)
+
     @given(inputs=hu.tensors(n=2),
            lr=st.floats(min_value=0.01, max_value=0.99,
                         allow_nan=False, allow_infinity=False),
@@ -259,6 +299,48 @@ class TestAdagrad(hu.HypothesisTestCase):
             [param, momentum, indices, grad, lr],
             ref_row_wise_sparse)
 
+    @given(inputs=hu.tensors(n=1),
+           lr=st.floats(min_value=0.01, max_value=0.99,
+                        allow_nan=False, allow_infinity=False),
+           epsilon=st.floats(min_value=0.01, max_value=0.99,
+                             allow_nan=False, allow_infinity=False),
+           data_strategy=st.data(),
+           **hu.gcs)
+    def test_row_wise_sparse_adagrad_duplicate_indices(
+            self, inputs, lr, epsilon, data_strategy, gc, dc):
+        param = inputs[0]
+        lr = np.array([lr], dtype=np.float32)
+        momentum = np.random.rand(param.shape[0]).astype(np.float32)
+
+        indices = data_strategy.draw(
+            hu.tensor1d(min_len=1, max_len=2 * param.shape[0], dtype=np.int64,
+                        elements=st.sampled_from(np.arange(param.shape[0]))),
+        )
+        grad = np.random.rand(
+            *((indices.shape[0],) + param.shape[1:])).astype(np.float32)
+
+        op = core.CreateOperator(
+            "RowWiseSparseAdagrad",
+            ["param", "momentum", "indices", "grad", "lr"],
+            ["param", "momentum"],
+            epsilon=epsilon,
+            device_option=gc)
+
+        def ref_row_wise_sparse(param, momentum, indices, grad, lr):
+            param_out = np.copy(param)
+            momentum_out = np.copy(momentum)
+            for i, index in enumerate(indices):
+                param_out[index], momentum_out[index] = \
+                    self.ref_row_wise_adagrad(
+                        param_out[index], momentum_out[index], grad[i], lr,
+                        epsilon)
+            return (param_out, momentum_out)
+
+        self.assertReferenceChecks(
+            gc, op,
+            [param, momentum, indices, grad, lr],
+            ref_row_wise_sparse)
+
     @given(inputs=hu.tensors(n=1),
            lr=st.floats(min_value=0.01, max_value=0.99,
                         allow_nan=False, allow_infinity=False),
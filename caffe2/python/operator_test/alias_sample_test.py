@@ -0,0 +1,118 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import numpy as np
+
+from hypothesis import given
+import hypothesis.strategies as st
+
+from caffe2.python import core
+from caffe2.python import workspace
+import caffe2.python.hypothesis_test_util as hu
+
+
+def alias_table_mass(prob, alias):
+    # Probability of every index of the table of each row.
+    k = prob.shape[-1]
+    prob = prob.reshape(-1, k)
+    alias = alias.reshape(-1, k)
+    mass = np.zeros(prob.shape)
+    for r in range(prob.shape[0]):
+        for j in range(k):
+            mass[r, j] += prob[r, j] / k
+            mass[r, alias[r, j]] += (1 - prob[r, j]) / k
+    return mass
+
+
+class TestAliasSample(hu.HypothesisTestCase):
+    @given(
+        rows=st.integers(min_value=0, max_value=8),
+        k=st.integers(min_value=1, max_value=64),
+        one_dim=st.booleans(),
+        **hu.gcs
+    )
+    def test_alias_table_create(self, rows, k, one_dim, gc, dc):
+        if one_dim:
+            rows = 1
+        weights = np.random.rand(rows, k).astype(np.float32)
+        # Some items are never sampled
+        weights[weights < 0.2] = 0
+        weights[:, 0] += 0.1
+        if one_dim:
+            weights = weights.reshape(k)
+
+        op = core.CreateOperator(
+            "AliasTableCreate", ["weights"], ["prob", "alias"],
+            device_option=gc)
+        workspace.FeedBlob("weights", weights, device_option=gc)
+        workspace.RunOperatorOnce(op)
+        prob = workspace.FetchBlob("prob")
+        alias = workspace.FetchBlob("alias")
+        self.assertEqual(prob.shape, weights.shape)
+        self.assertEqual(alias.shape, weights.shape)
+        self.assertTrue(((prob >= 0) & (prob <= 1)).all())
+        self.assertTrue(((alias >= 0) & (alias < k)).all())
+
+        w = weights.reshape(-1, k)
+        np.testing.assert_allclose(
+            alias_table_mass(prob, alias),
+            w / w.sum(axis=1, keepdims=True),
+            atol=1e-5)
+        self.assertDeviceChecks(dc, op, [weights], [0, 1])
+
+    @given(
+        k=st.integers(min_value=1, max_value=16),
+        **hu.gcs
+    )
+    def test_alias_sample(self, k, gc, dc):
+        rows = 3
+        num_samples = 20000
+        weights = np.random.rand(rows, k).astype(np.float32) + 0.05
+        weights[1, :] = 0
+        weights[1, k - 1] = 1
+
+        workspace.FeedBlob("weights", weights, device_option=gc)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "AliasTableCreate", ["weights"], ["prob", "alias"],
+            device_option=gc))
+        op = core.CreateOperator(
+            "AliasSample", ["prob", "alias"], ["samples"],
+            num_samples=num_samples, device_option=gc)
+        workspace.RunOperatorOnce(op)
+        samples = workspace.FetchBlob("samples")
+        self.assertEqual(samples.shape, (rows, num_samples))
+        self.assertTrue(((samples >= 0) & (samples < k)).all())
+        # A row of a single positive weight always gives its index.
+        self.assertTrue((samples[1] == k - 1).all())
+
+        expected = weights / weights.sum(axis=1, keepdims=True)
+        for r in range(rows):
+            freq = np.bincount(samples[r], minlength=k) / num_samples
+            np.testing.assert_allclose(freq, expected[r], atol=0.02)
+
+        # The next run draws different samples.
+        workspace.RunOperatorOnce(op)
+        if k > 1:
+            self.assertFalse(
+                (workspace.FetchBlob("samples")[0] == samples[0]).all())
+
+    @given(num_samples=st.integers(min_value=0, max_value=100), **hu.gcs)
+    def test_alias_sample_1d(self, num_samples, gc, dc):
+        weights = np.array([0, 3, 0, 1], dtype=np.float32)
+        workspace.FeedBlob("weights", weights, device_option=gc)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "AliasTableCreate", ["weights"], ["prob", "alias"],
+            device_option=gc))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "AliasSample", ["prob", "alias"], ["samples"],
+            num_samples=num_samples, device_option=gc))
+        samples = workspace.FetchBlob("samples")
+        self.assertEqual(samples.shape, (num_samples,))
+        self.assertTrue(np.in1d(samples, [1, 3]).all())
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
@@ -18,7 +18,7 @@ from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
 
-from caffe2.python import core
+from caffe2.python import core, workspace
 from hypothesis import given
 import caffe2.python.hypothesis_test_util as hu
 import hypothesis.strategies as st
@@ -49,7 +49,7 @@ class TestAPMeterOps(hu.HypothesisTestCase):
                             dtype=np.int32,
                             elements=st.integers(min_value=0,
                                                  max_value=1)),
-           **hu.gcs_cpu_only)
+           **hu.gcs)
     def test_average_precision(self, predictions, labels, gc, dc):
         op = core.CreateOperator(
             "APMeter",
@@ -77,7 +77,7 @@ class TestAPMeterOps(hu.HypothesisTestCase):
                             dtype=np.int32,
                             elements=st.integers(min_value=0,
                                                  max_value=1)),
-           **hu.gcs_cpu_only)
+           **hu.gcs)
     def test_average_precision_small_buffer(self, predictions, labels, gc, dc):
         op_small_buffer = core.CreateOperator(
             "APMeter",
@@ -97,3 +97,38 @@ class TestAPMeterOps(hu.HypothesisTestCase):
             inputs=[predictions, labels],
             reference=op_ref
         )
+
+    @given(num_batches=st.integers(1, 4),
+           N=st.integers(1, 5),
+           D=st.integers(1, 4),
+           **hu.gcs)
+    def test_average_precision_accumulates(self, num_batches, N, D, gc, dc):
+        # The op keeps the predictions of the earlier runs in its buffer. Ties
+        # make the order of the samples matter, so the scores are coarse.
+        op = core.CreateOperator(
+            "APMeter",
+            ["predictions", "labels"],
+            ["AP"],
+            buffer_size=20,
+            device_option=gc,
+        )
+        predictions = np.random.randint(4, size=(num_batches * N, D)).astype(
+            np.float32)
+        labels = np.random.randint(2, size=(num_batches * N, D)).astype(
+            np.int32)
+        net = core.Net("apmeter")
+        net.Proto().op.extend([op])
+        workspace.ResetWorkspace()
+        for i in range(num_batches):
+            workspace.FeedBlob(
+                "predictions", predictions[i * N:(i + 1) * N],
+                device_option=gc)
+            workspace.FeedBlob(
+                "labels", labels[i * N:(i + 1) * N], device_option=gc)
+            if i == 0:
+                workspace.CreateNet(net)
+            workspace.RunNet(net.Name())
+        np.testing.assert_allclose(
+            workspace.FetchBlob("AP"),
+            calculate_ap(predictions, labels),
+            rtol=1e-5, atol=1e-5)
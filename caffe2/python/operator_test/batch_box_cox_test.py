@@ -19,6 +19,7 @@ from __future__ import print_function
 from __future__ import unicode_literals
 
 from caffe2.python import core
+from caffe2.python.workspace import has_hip
 from hypothesis import given
 
 import caffe2.python.hypothesis_test_util as hu
@@ -69,7 +70,7 @@ def _inputs(draw):
 class TestBatchBoxCox(hu.HypothesisTestCase):
     @given(
         inputs=_inputs(),
-        **hu.gcs_cpu_only
+        **(hu.gcs if has_hip else hu.gcs_cpu_only)
     )
     def test_batch_box_cox(self, inputs, gc, dc):
         self.batch_box_cox(inputs, gc, dc)
@@ -0,0 +1,144 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import hypothesis.strategies as st
+import numpy as np
+
+from caffe2.python import core, workspace
+from hypothesis import given
+import caffe2.python.hypothesis_test_util as hu
+
+
+def beam_search_step_ref(log_probs, scores, timestep, k, word_rewards=None,
+                         translation_tokens=None):
+    expanded = 1 if timestep == 0 else log_probs.shape[0]
+    candidates = []
+    tokens = []
+    for h in range(expanded):
+        cols = sorted(
+            range(log_probs.shape[1]), key=lambda j: (-log_probs[h, j], j))
+        for col in cols[:k]:
+            token = (
+                translation_tokens[col] if translation_tokens is not None
+                else col)
+            score = log_probs[h, col] + scores[h]
+            if word_rewards is not None:
+                score += word_rewards[token]
+            candidates.append((-score, len(candidates)))
+            tokens.append(token)
+    best = sorted(candidates)[:k]
+    scores_t = np.array([[-s for s, _ in best]], dtype=np.float32)
+    tokens_t = np.array([[tokens[c] for _, c in best]], dtype=np.float32)
+    hypo_t = np.array([[c // k for _, c in best]], dtype=np.int32)
+    return scores_t, tokens_t, hypo_t
+
+
+class TestBeamSearchOps(hu.HypothesisTestCase):
+
+    @given(num_hypos=st.integers(1, 5),
+           vocab_size=st.integers(5, 30),
+           timestep=st.integers(0, 2),
+           use_word_rewards=st.booleans(),
+           use_translation_tokens=st.booleans(),
+           **(hu.gcs if workspace.has_hip else hu.gcs_cpu_only))
+    def test_beam_search_step(self, num_hypos, vocab_size, timestep,
+                              use_word_rewards, use_translation_tokens,
+                              gc, dc):
+        k = num_hypos
+        log_probs = np.log(
+            np.random.rand(num_hypos, vocab_size).astype(np.float32))
+        scores = np.random.randn(num_hypos).astype(np.float32)
+        inputs = ['log_probs', 'scores', 'timestep']
+        workspace.FeedBlob('log_probs', log_probs, device_option=gc)
+        workspace.FeedBlob('scores', scores, device_option=gc)
+        workspace.FeedBlob(
+            'timestep', np.array([timestep], dtype=np.int32),
+            device_option=hu.cpu_do)
+
+        word_rewards = None
+        translation_tokens = None
+        if use_word_rewards or use_translation_tokens:
+            # An empty tensor stands for no rewards.
+            word_rewards = np.random.randn(
+                2 * vocab_size if use_word_rewards else 0).astype(np.float32)
+            workspace.FeedBlob('word_rewards', word_rewards, device_option=gc)
+            if not use_word_rewards:
+                word_rewards = None
+            inputs.append('word_rewards')
+        if use_translation_tokens:
+            translation_tokens = np.random.permutation(
+                2 * vocab_size)[:vocab_size].astype(np.int32)
+            workspace.FeedBlob(
+                'translation_tokens', translation_tokens, device_option=gc)
+            inputs.append('translation_tokens')
+
+        op = core.CreateOperator(
+            'BeamSearchStep',
+            inputs,
+            ['scores_t', 'tokens_t', 'hypo_t', 'hypo_t_int32'],
+            beam_size=k,
+            device_option=gc,
+        )
+        workspace.RunOperatorOnce(op)
+
+        scores_t, tokens_t, hypo_t = beam_search_step_ref(
+            log_probs, scores, timestep, k, word_rewards, translation_tokens)
+        np.testing.assert_allclose(
+            workspace.FetchBlob('scores_t'), scores_t, rtol=1e-5)
+        np.testing.assert_array_equal(
+            workspace.FetchBlob('tokens_t'), tokens_t)
+        np.testing.assert_array_equal(workspace.FetchBlob('hypo_t'), hypo_t)
+        np.testing.assert_array_equal(
+            workspace.FetchBlob('hypo_t_int32'), hypo_t)
+
+    def test_beam_search_backtrack(self):
+        eos = 9
+        # [steps + 1, beam]
+        tokens = np.array(
+            [[0, 0], [3, 4], [eos, 5], [6, 7]], dtype=np.int32)
+        prev = np.array([[0, 0], [0, 0], [1, 0], [1, 1]], dtype=np.int32)
+        scores = np.array(
+            [[0, 0], [-1, -2], [-2.5, -3], [-4, -3.5]], dtype=np.float32)
+        workspace.FeedBlob('tokens', tokens)
+        workspace.FeedBlob('prev', prev)
+        workspace.FeedBlob('scores', scores)
+
+        def run(eos_token_id):
+            workspace.RunOperatorOnce(core.CreateOperator(
+                'BeamSearchBacktrack',
+                ['tokens', 'prev', 'scores'],
+                ['output_tokens', 'output_hypos', 'output_score'],
+                eos_token_id=eos_token_id,
+            ))
+            return (
+                workspace.FetchBlob('output_tokens').tolist(),
+                workspace.FetchBlob('output_hypos').tolist(),
+                workspace.FetchBlob('output_score')[0],
+            )
+
+        # The finished hypothesis at step 2 beats the ones of the last step.
+        self.assertEqual(run(eos), ([4, eos], [1, 0], -2.5))
+        # Without it, the best hypothesis of the last step wins.
+        self.assertEqual(run(-1), ([3, 5, 7], [0, 1, 1], -3.5))
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
@@ -48,7 +48,19 @@ class BlobsQueueDBTest(unittest.TestCase):
                 )
         self._test_create_blobs_queue_db(add_blobs)
 
-    def _test_create_blobs_queue_db(self, add_blobs_fun):
+    def test_create_blobs_queue_db_decode_threads(self):
+        def add_blobs(queue, num_samples):
+            blob = core.BlobReference("blob")
+            status = core.BlobReference("blob_status")
+            for i in range(num_samples):
+                self._add_blob_to_queue(
+                    queue, self._create_test_tensor_protos(i), blob, status
+                )
+        # The items have to stay in the order of the queue when they are
+        # parsed by several threads.
+        self._test_create_blobs_queue_db(add_blobs, decode_threads=4)
+
+    def _test_create_blobs_queue_db(self, add_blobs_fun, decode_threads=1):
         num_samples = 10000
         batch_size = 10
         init_net = core.Net('init_net')
@@ -65,7 +77,8 @@ class BlobsQueueDBTest(unittest.TestCase):
         add_blobs_fun(queue, num_samples)
 
         net.TensorProtosDBInput(
-            [reader], ['image', 'label'], batch_size=batch_size)
+            [reader], ['image', 'label'], batch_size=batch_size,
+            decode_threads=decode_threads)
         workspace.CreateNet(net)
 
         close_net = core.Net('close_net')
@@ -0,0 +1,94 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from hypothesis import given
+import hypothesis.strategies as st
+import numpy as np
+
+from caffe2.python import core
+import caffe2.python.hypothesis_test_util as hu
+
+
+class TestBucketOps(hu.HypothesisTestCase):
+    @given(n=st.integers(1, 5), seed=st.integers(0, 1000), **hu.gcs)
+    def test_pack_unpack_bucket(self, n, seed, gc, dc):
+        np.random.seed(seed)
+        Xs = [
+            np.random.rand(
+                *np.random.randint(1, 4, size=np.random.randint(1, 4))
+            ).astype(np.float32)
+            for _ in range(n)
+        ]
+        names = ["X_{}".format(i) for i in range(n)]
+
+        pack = core.CreateOperator("PackBucket", names, ["bucket"])
+
+        def pack_ref(*Xs):
+            return np.concatenate([X.flatten() for X in Xs]),
+
+        self.assertReferenceChecks(gc, pack, Xs, pack_ref)
+        self.assertDeviceChecks(dc, pack, Xs, [0])
+
+        bucket = pack_ref(*Xs)[0] * 2
+        unpack = core.CreateOperator(
+            "UnpackBucket", ["bucket"] + names, names)
+
+        def unpack_ref(bucket, *Xs):
+            return [X * 2 for X in Xs]
+
+        self.assertReferenceChecks(gc, unpack, [bucket] + Xs, unpack_ref)
+        self.assertDeviceChecks(dc, unpack, [bucket] + Xs, list(range(n)))
+
+    @given(n=st.integers(1, 4), shards=st.integers(2, 8),
+           seed=st.integers(0, 1000), **hu.gcs)
+    def test_pack_unpack_sharded_bucket(self, n, shards, seed, gc, dc):
+        np.random.seed(seed)
+        Xs = [
+            np.random.rand(*np.random.randint(1, 5, size=2)).astype(np.float32)
+            for _ in range(n)
+        ]
+        names = ["X_{}".format(i) for i in range(n)]
+
+        pack = core.CreateOperator(
+            "PackBucket", names, ["bucket"], shards=shards)
+
+        def pack_ref(*Xs):
+            flat = np.concatenate([X.flatten() for X in Xs])
+            padded = -(-flat.size // shards) * shards
+            flat = np.pad(flat, (0, padded - flat.size), 'constant')
+            return flat.reshape(shards, padded // shards),
+
+        self.assertReferenceChecks(gc, pack, Xs, pack_ref)
+        self.assertDeviceChecks(dc, pack, Xs, [0])
+
+        bucket = pack_ref(*Xs)[0] * 2
+        unpack = core.CreateOperator(
+            "UnpackBucket", ["bucket"] + names, names, shards=shards)
+
+        def unpack_ref(bucket, *Xs):
+            return [X * 2 for X in Xs]
+
+        self.assertReferenceChecks(gc, unpack, [bucket] + Xs, unpack_ref)
+        self.assertDeviceChecks(dc, unpack, [bucket] + Xs, list(range(n)))
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
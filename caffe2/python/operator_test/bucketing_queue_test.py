@@ -0,0 +1,121 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+from caffe2.python import core, workspace
+from caffe2.python.test_util import TestCase
+
+import numpy as np
+import numpy.testing as npt
+
+
+class TestBucketingQueue(TestCase):
+    def _enqueue(self, queue, sequences, labels=None):
+        net = core.Net('enqueue')
+        for i, seq in enumerate(sequences):
+            workspace.FeedBlob('seq_%d' % i, seq)
+            inputs = [queue, 'seq_%d' % i]
+            if labels is not None:
+                workspace.FeedBlob('label_%d' % i, labels[i])
+                inputs.append('label_%d' % i)
+            net.EnqueueBucketingQueue(inputs, [])
+        workspace.RunNetOnce(net)
+
+    def test_full_buckets(self):
+        net = core.Net('init')
+        queue = net.CreateBucketingQueue(
+            [], 1, capacity=10, num_blobs=2, bucket_boundaries=[4],
+            batch_size=2)
+        workspace.RunNetOnce(net)
+
+        lengths = [2, 7, 3, 9]
+        sequences = [
+            np.arange(l * 2, dtype=np.float32).reshape(l, 2) + 1
+            for l in lengths
+        ]
+        labels = [np.array(i, dtype=np.int32) for i in range(len(lengths))]
+        self._enqueue(queue, sequences, labels)
+
+        dequeue = core.Net('dequeue')
+        dequeue.DequeueBucketingQueue(
+            [queue], ['batch', 'label', 'lengths'])
+        # The short bucket fills first, with the first and third examples.
+        for expected in [[0, 2], [1, 3]]:
+            workspace.RunNetOnce(dequeue)
+            batch = workspace.FetchBlob('batch')
+            batch_lengths = [lengths[i] for i in expected]
+            self.assertEqual(batch.shape, (2, max(batch_lengths), 2))
+            npt.assert_array_equal(
+                workspace.FetchBlob('lengths'), batch_lengths)
+            npt.assert_array_equal(workspace.FetchBlob('label'), expected)
+            for row, i in enumerate(expected):
+                npt.assert_array_equal(
+                    batch[row, :lengths[i]], sequences[i])
+                self.assertTrue((batch[row, lengths[i]:] == 0).all())
+
+    def test_time_major_flush_on_close(self):
+        net = core.Net('init')
+        queue = net.CreateBucketingQueue(
+            [], 1, capacity=10, num_blobs=1, bucket_boundaries=[2, 4, 8],
+            batch_size=4)
+        workspace.RunNetOnce(net)
+
+        lengths = [1, 3, 6]
+        sequences = [np.full((l, 3), l, dtype=np.float32) for l in lengths]
+        self._enqueue(queue, sequences)
+
+        close = core.Net('close')
+        close.CloseBucketingQueue([queue], [])
+        workspace.RunNetOnce(close)
+
+        dequeue = core.Net('dequeue')
+        dequeue.DequeueBucketingQueue(
+            [queue], ['batch', 'lengths'], time_major=True)
+        seen = []
+        for _ in range(len(lengths)):
+            workspace.RunNetOnce(dequeue)
+            batch = workspace.FetchBlob('batch')
+            (length,) = workspace.FetchBlob('lengths')
+            self.assertEqual(batch.shape, (length, 1, 3))
+            npt.assert_array_equal(batch[:, 0], sequences[lengths.index(length)])
+            seen.append(length)
+        self.assertEqual(sorted(seen), lengths)
+        # Dequeuing more should fail now since the queue is closed and empty
+        with self.assertRaises(RuntimeError):
+            workspace.RunNetOnce(dequeue)
+
+    def test_max_latency(self):
+        net = core.Net('init')
+        queue = net.CreateBucketingQueue(
+            [], 1, capacity=10, num_blobs=1, bucket_boundaries=[4],
+            batch_size=8, max_latency_ms=20)
+        workspace.RunNetOnce(net)
+
+        self._enqueue(queue, [np.ones((3,), dtype=np.int64)] * 2)
+        dequeue = core.Net('dequeue')
+        dequeue.DequeueBucketingQueue([queue], ['batch', 'lengths'])
+        # The bucket is not full, it is flushed after max_latency_ms.
+        workspace.RunNetOnce(dequeue)
+        npt.assert_array_equal(workspace.FetchBlob('lengths'), [3, 3])
+        npt.assert_array_equal(
+            workspace.FetchBlob('batch'), np.ones((2, 3), dtype=np.int64))
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
@@ -141,6 +141,39 @@ class TestConcatSplitOps(hu.HypothesisTestCase):
         self.assertDeviceChecks(dc, op, input_tensors, outputs_with_grad)
         self.assertGradientChecks(gc, op, input_tensors, 0, outputs_with_grad)
 
+    @given(num_inputs=st.integers(64, 150),
+           rows=st.integers(1, 4),
+           dtype=st.sampled_from([np.float32, np.float64, np.uint8,
+                                  np.int16]),
+           **hu.gcs)
+    def test_concat_split_many_inputs(self, num_inputs, rows, dtype, gc, dc):
+        # Lots of small inputs of uneven widths, as in feature interaction
+        # layers, are copied in a single launch on HIP.
+        widths = np.random.randint(0, 4, size=num_inputs).astype(np.int32)
+        splits = [(np.random.rand(rows, w) * 100).astype(dtype)
+                  for w in widths]
+
+        concat = core.CreateOperator(
+            "Concat",
+            ['X_{}'.format(i) for i in range(num_inputs)],
+            ['concat_result', 'split_info'],
+            axis=1,
+        )
+        self.assertReferenceChecks(
+            gc, concat, splits, lambda *splits: (
+                np.concatenate(splits, axis=1), widths))
+
+        split = core.CreateOperator(
+            "Split",
+            ['input'],
+            ['X_{}'.format(i) for i in range(num_inputs)],
+            axis=1,
+            split=widths,
+        )
+        self.assertReferenceChecks(
+            gc, split, [np.concatenate(splits, axis=1)],
+            lambda input: splits)
+
 
 if __name__ == "__main__":
     unittest.main()
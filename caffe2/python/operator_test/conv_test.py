@@ -451,6 +451,52 @@ class TestConvolution(hu.HypothesisTestCase):
                 atol=1e-4,
                 rtol=1e-4)
 
+    @given(op_type=st.sampled_from(["Conv", "Conv2D"]),
+           kernel=st.sampled_from([1, 3]),
+           pad=st.integers(0, 2),
+           size=st.integers(1, 14),
+           input_channels=st.integers(1, 8),
+           output_channels=st.integers(1, 8),
+           group=st.integers(1, 2),
+           batch_size=st.integers(1, 3),
+           use_bias=st.booleans(),
+           **hu.gcs_cpu_only)
+    def test_convolution_winograd(self, op_type, kernel, pad, size,
+                                  input_channels, output_channels, group,
+                                  batch_size, use_bias, gc, dc):
+        if kernel == 1:
+            pad = 0
+        assume(size + 2 * pad >= kernel)
+        input_channels *= group
+        output_channels *= group
+
+        X = np.random.rand(
+            batch_size, input_channels, size, size).astype(np.float32) - 0.5
+        w = np.random.rand(
+            output_channels, input_channels // group, kernel, kernel).astype(
+                np.float32) - 0.5
+        b = np.random.rand(output_channels).astype(np.float32) - 0.5
+        inputs = [X, w, b] if use_bias else [X, w]
+
+        outputs = []
+        for engine in ["", "WINOGRAD"]:
+            op = core.CreateOperator(
+                op_type,
+                ["X", "w", "b"] if use_bias else ["X", "w"],
+                ["Y"],
+                kernel=kernel,
+                pad=pad,
+                group=group,
+                order="NCHW",
+                engine=engine,
+                device_option=gc,
+            )
+            for name, value in zip(["X", "w", "b"], inputs):
+                self.ws.create_blob(name).feed(value, device_option=gc)
+            self.ws.run(op)
+            outputs.append(self.ws.blobs["Y"].fetch())
+        np.testing.assert_allclose(outputs[0], outputs[1], atol=1e-4, rtol=1e-3)
+
     @given(num_workers=st.integers(1, 4),
            net_type=st.sampled_from(
                ["simple", "dag"] +
@@ -20,7 +20,9 @@ from __future__ import unicode_literals
 
 from caffe2.python import core, workspace
 from caffe2.python.test_util import TestCase
+import caffe2.python.hypothesis_test_util as hu
 import tempfile
+import unittest
 
 
 class TestCounterOps(TestCase):
@@ -94,6 +96,36 @@ class TestCounterOps(TestCase):
                 'RetrieveCount', ['serialized_c'], ['t8']))
             assert workspace.FetchBlob('t8') == 22
 
+    @unittest.skipIf(not workspace.has_hip, "No HIP support.")
+    def test_hip_counter_ops(self):
+        def run(op_type, inputs, outputs, **kwargs):
+            workspace.RunOperatorOnce(core.CreateOperator(
+                op_type, inputs, outputs, device_option=hu.gpu_do, **kwargs))
+            # the results of the counter ops are CPU tensors
+            return workspace.FetchBlob('t') if outputs == ['t'] else None
+
+        run('CreateCounter', [], ['c'], init_count=2)
+        assert not run('CountDown', ['c'], ['t'])  # 2 -> 1
+        assert not run('CheckCounterDone', ['c'], ['t'])
+        assert not run('CountDown', ['c'], ['t'])  # 1 -> 0
+        assert run('CheckCounterDone', ['c'], ['t'])
+        assert run('CountDown', ['c'], ['t'])  # 0 -> -1
+        assert run('CountUp', ['c'], ['t']) == -1  # -1 -> 0
+        assert run('RetrieveCount', ['c'], ['t']) == 0
+        assert run('ResetCounter', ['c'], ['t'], init_count=5) == 0
+        assert run('RetrieveCount', ['c'], ['t']) == 5
+
+        # the device counter is saved as a CPU counter, which the HIP ops
+        # accept as well
+        with tempfile.NamedTemporaryFile() as tmp:
+            run('Save', ['c'], [], absolute_path=1, db_type='minidb',
+                db=tmp.name)
+            run('Load', [], ['c'], absolute_path=1, db_type='minidb',
+                db=tmp.name)
+        assert run('RetrieveCount', ['c'], ['t']) == 5
+        assert not run('CountDown', ['c'], ['t'])
+        assert run('RetrieveCount', ['c'], ['t']) == 4
+
 if __name__ == "__main__":
     import unittest
     unittest.main()
@@ -141,6 +141,46 @@ class TestCrossEntropyOps(hu.HypothesisTestCase):
             output_to_grad='xentropy',
             grad_reference=weighted_sigmoid_xentr_logit_grad_ref)
 
+    @given(n=st.integers(1, 40),
+           t=st.integers(1, 20),
+           weights=st.sampled_from(['none', 'task', 'element']),
+           **hu.gcs)
+    def test_weighted_sigmoid_cross_entropy_loss(self, n, t, weights, gc, dc):
+        logits = np.random.uniform(-2, 2, (n, t)).astype(np.float32)
+        targets = np.random.randint(0, 2, (n, t)).astype(np.float32)
+        inputs = [logits, targets]
+        if weights == 'task':
+            inputs.append(np.random.rand(t).astype(np.float32))
+        elif weights == 'element':
+            inputs.append(np.random.rand(n, t).astype(np.float32))
+
+        def weighted_sigmoid_xentr_loss_ref(logits, targets, weights=None):
+            s = sigmoid_cross_entropy_with_logits(logits, targets)
+            if weights is not None:
+                s = s * weights
+            return (np.array(np.mean(s), dtype=np.float32), )
+
+        def weighted_sigmoid_xentr_loss_grad_ref(g_out, outputs, fwd_inputs):
+            fwd_logits, fwd_targets = fwd_inputs[:2]
+            m = sigmoid(fwd_logits) - fwd_targets
+            if len(fwd_inputs) > 2:
+                m = m * fwd_inputs[2]
+            g_in = g_out * m / fwd_logits.size
+            return (g_in, ) + (None, ) * (len(fwd_inputs) - 1)
+
+        op = core.CreateOperator(
+            'WeightedSigmoidCrossEntropyLoss',
+            ['logits', 'targets', 'weights'][:len(inputs)],
+            ['loss'])
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=op,
+            inputs=inputs,
+            reference=weighted_sigmoid_xentr_loss_ref,
+            output_to_grad='loss',
+            grad_reference=weighted_sigmoid_xentr_loss_grad_ref)
+        self.assertDeviceChecks(dc, op, inputs, [0])
+
     @given(n=st.integers(2, 10),
            b=st.integers(1, 5),
            **hu.gcs_cpu_only)
@@ -25,10 +25,12 @@ from caffe2.python.schema import (
     FeedRecord
 )
 from caffe2.python.test_util import TestCase
+import caffe2.python.hypothesis_test_util as hu
 
 import numpy.testing as npt
 
 import string
+import unittest
 
 from hypothesis import given
 import hypothesis.strategies as st
@@ -599,6 +601,42 @@ class TestDatasetOps(TestCase):
         npt.assert_array_equal(input_array[[2, 0, 1, 2, 2, 0, 1]],
                                reference_result)
 
+    @unittest.skipIf(not workspace.C.has_hip or not workspace.has_gpu_support,
+                     "No HIP support.")
+    def test_append_hip(self):
+        chunks = [np.random.rand(n, 3).astype(np.float32) for n in
+                  [2, 1, 5, 3, 7, 1]]
+        workspace.FeedBlob('dataset', chunks[0], device_option=hu.gpu_do)
+        net = core.Net('append')
+        net.Append(['dataset', 'chunk'], ['dataset'])
+        net.Proto().device_option.CopyFrom(hu.gpu_do)
+        for chunk in chunks[1:]:
+            workspace.FeedBlob('chunk', chunk, device_option=hu.gpu_do)
+            workspace.RunNetOnce(net)
+        npt.assert_array_equal(
+            workspace.FetchBlob('dataset'), np.concatenate(chunks))
+
+    @unittest.skipIf(not workspace.C.has_hip or not workspace.has_gpu_support,
+                     "No HIP support.")
+    def test_last_n_window_ops_hip(self):
+        input_array =\
+            np.array(list(range(1, 7)), dtype=np.float32).reshape(3, 2)
+        workspace.FeedBlob('input', input_array, device_option=hu.gpu_do)
+        workspace.CreateBlob('output')
+        # The cursor stays on the host.
+        workspace.FeedBlob('next', np.array(0, dtype=np.int32))
+        collect_net = core.Net('collect_net')
+        collect_net.LastNWindowCollector(
+            ['output', 'next', 'input'],
+            ['output', 'next'],
+            num_to_collect=7,
+        )
+        collect_net.Proto().device_option.CopyFrom(hu.gpu_do)
+        for _ in range(3):
+            workspace.RunNetOnce(collect_net)
+        npt.assert_array_equal(input_array[[1, 2, 2, 0, 1, 2, 0]],
+                               workspace.FetchBlob('output'))
+
     def test_collect_tensor_ops(self):
         init_net = core.Net('init_net')
         blobs = ['blob_1', 'blob_2', 'blob_3']
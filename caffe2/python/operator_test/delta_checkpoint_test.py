@@ -0,0 +1,78 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import os
+import shutil
+import tempfile
+import unittest
+
+import numpy as np
+
+from caffe2.python import core, test_util, workspace
+
+
+class TestDeltaCheckpoint(test_util.TestCase):
+
+    def testDeltaThenRestore(self):
+        workspace.ResetWorkspace()
+        tmp_folder = tempfile.mkdtemp()
+        db = os.path.join(tmp_folder, "ckpt_%d")
+        param = np.random.rand(10, 3).astype(np.float32)
+        workspace.FeedBlob("param", param)
+
+        net = core.Net("train")
+        net.MarkDirtyRows(["param", "indices"], "dirty")
+        net.ScatterAssign(["param", "indices", "update"], "param")
+        net.SaveDelta(["iter", "param", "dirty"], "dirty", absolute_path=1,
+                      db=db, db_type="minidb", every=1, full_every=2)
+        workspace.FeedBlob("iter", np.array([0], dtype=np.int64))
+        workspace.FeedBlob("indices", np.array([1, 4], dtype=np.int64))
+        workspace.FeedBlob("update", np.zeros((2, 3), dtype=np.float32))
+        self.assertTrue(workspace.RunNetOnce(net))
+        full = workspace.FetchBlob("param")
+        np.testing.assert_array_equal(workspace.FetchBlob("dirty"),
+                                      np.zeros(10, dtype=np.uint8))
+
+        workspace.FeedBlob("iter", np.array([1], dtype=np.int64))
+        workspace.FeedBlob("indices", np.array([7, 1, 7], dtype=np.int64))
+        workspace.FeedBlob("update", np.ones((3, 3), dtype=np.float32))
+        self.assertTrue(workspace.RunNetOnce(net))
+        final = workspace.FetchBlob("param")
+
+        # Rebuild the parameter from the full snapshot and the delta.
+        workspace.ResetWorkspace()
+        self.assertTrue(workspace.RunOperatorOnce(core.CreateOperator(
+            "Load", [], ["param"], absolute_path=1, db=db % 0,
+            db_type="minidb")))
+        np.testing.assert_array_equal(workspace.FetchBlob("param"), full)
+        self.assertTrue(workspace.RunOperatorOnce(core.CreateOperator(
+            "Load", [], ["param_rows", "param_indices"], absolute_path=1,
+            db=db % 1, db_type="minidb")))
+        np.testing.assert_array_equal(workspace.FetchBlob("param_indices"),
+                                      [1, 7])
+        self.assertTrue(workspace.RunOperatorOnce(core.CreateOperator(
+            "ScatterAssign", ["param", "param_indices", "param_rows"],
+            "param")))
+        np.testing.assert_array_equal(workspace.FetchBlob("param"), final)
+        shutil.rmtree(tmp_folder)
+
+
+if __name__ == "__main__":
+    unittest.main()
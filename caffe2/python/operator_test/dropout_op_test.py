@@ -19,6 +19,7 @@ from __future__ import print_function
 from __future__ import unicode_literals
 
 from hypothesis import assume, given
+import unittest
 import hypothesis.strategies as st
 import numpy as np
 
@@ -32,7 +33,7 @@ class TestDropout(hu.HypothesisTestCase):
     @given(X=hu.tensor(),
            in_place=st.booleans(),
            ratio=st.floats(0, 0.999),
-           engine=st.sampled_from(["" if workspace.has_hip else "CUDNN"]),
+           engine=st.sampled_from(["", "PHILOX"] if workspace.has_hip else ["CUDNN"]),
            **hu.gcs)
     def test_dropout_is_test(self, X, in_place, ratio, engine, gc, dc):
         """Test with is_test=True for a deterministic reference impl."""
@@ -60,7 +61,7 @@ class TestDropout(hu.HypothesisTestCase):
     @given(X=hu.tensor(),
            in_place=st.booleans(),
            output_mask=st.booleans(),
-           engine=st.sampled_from(["" if workspace.has_hip else "CUDNN"]),
+           engine=st.sampled_from(["", "PHILOX"] if workspace.has_hip else ["CUDNN"]),
            **hu.gcs)
     def test_dropout_ratio0(self, X, in_place, output_mask, engine, gc, dc):
         """Test with ratio=0 for a deterministic reference impl."""
@@ -86,5 +87,30 @@ class TestDropout(hu.HypothesisTestCase):
 
         self.assertReferenceChecks(
             gc, op, [X], reference_dropout_ratio0,
-            # Don't check the mask with cuDNN because it's packed data
-            outputs_to_check=None if (engine != 'CUDNN') else [0])
+            # Don't check the mask with cuDNN or Philox because it's packed data
+            outputs_to_check=None if (engine == '') else [0])
+
+    @unittest.skipIf(not workspace.has_hip, "No HIP support.")
+    @given(X=hu.tensor(min_dim=1, max_dim=3),
+           ratio=st.floats(0.1, 0.9),
+           in_place=st.booleans())
+    def test_dropout_philox_mask(self, X, ratio, in_place):
+        """The PHILOX gradient must regenerate the mask of the forward pass."""
+        device_option = core.DeviceOption(caffe2_pb2.HIP, 0)
+        Y = "X" if in_place else "Y"
+        op = core.CreateOperator("Dropout", ["X"], [Y, "mask"], ratio=ratio,
+                                 engine="PHILOX", device_option=device_option)
+        grad_op = core.CreateOperator("DropoutGrad", ["dY", "mask"], ["dX"],
+                                      ratio=ratio, engine="PHILOX",
+                                      device_option=device_option)
+        X = X + 1.0
+        workspace.FeedBlob("X", X, device_option)
+        workspace.FeedBlob("dY", np.ones_like(X), device_option)
+        workspace.RunOperatorOnce(op)
+        workspace.RunOperatorOnce(grad_op)
+        Y = workspace.FetchBlob(Y)
+        dX = workspace.FetchBlob("dX")
+        self.assertEqual(workspace.FetchBlob("mask").size, 2)
+        np.testing.assert_allclose(Y, X * dX, rtol=1e-5)
+        np.testing.assert_allclose(
+            np.unique(dX[dX != 0]), [1. / (1. - ratio)], rtol=1e-5)
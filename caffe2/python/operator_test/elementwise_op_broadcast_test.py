@@ -183,6 +183,37 @@ class TestElementwiseBroadcast(hu.HypothesisTestCase):
         self.assertDeviceChecks(dc, op, [X, Y], [0])
         self.assertGradientChecks(gc, op, [X, Y], 1, [0])
 
+    @given(**hu.gcs)
+    def test_broadcast_strided(self, gc, dc):
+        # dims of Y that are not 1 do not have to be contiguous
+        ops = [("Add", np.add), ("Sub", np.subtract),
+               ("Mul", np.multiply), ("Div", np.divide)]
+        shapes = [
+            # interleaved broadcast dims
+            ((2, 3, 4, 5), (3, 1, 5), {}),
+            ((2, 3, 4, 5), (2, 1, 4, 1), {}),
+            # contiguous innermost dim of a multiple of 4 elements
+            ((2, 3, 4, 8), (2, 1, 4, 8), {}),
+            # aligned with axis
+            ((2, 3, 4, 5, 6), (3, 1, 5), {"axis": 1}),
+        ]
+        for name, ref in ops:
+            for x_shape, y_shape, kwargs in shapes:
+                X = np.random.rand(*x_shape).astype(np.float32)
+                Y = np.random.rand(*y_shape).astype(np.float32) + 0.5
+                op = core.CreateOperator(
+                    name, ["X", "Y"], "out", broadcast=1, **kwargs)
+                workspace.FeedBlob("X", X)
+                workspace.FeedBlob("Y", Y)
+                workspace.RunOperatorOnce(op)
+                out = workspace.FetchBlob("out")
+                axis = kwargs.get("axis", X.ndim - Y.ndim)
+                Y_aligned = Y.reshape(
+                    (1,) * axis + y_shape +
+                    (1,) * (X.ndim - axis - Y.ndim))
+                np.testing.assert_array_almost_equal(out, ref(X, Y_aligned))
+                self.assertDeviceChecks(dc, op, [X, Y], [0])
+
     @given(**hu.gcs)
     def test_broadcast_scalar(self, gc, dc):
         # broadcasting constant
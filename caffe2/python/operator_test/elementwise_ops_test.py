@@ -146,6 +146,28 @@ class TestElementwiseOps(hu.HypothesisTestCase):
             reference=swish_gradient,
         )
 
+    @given(n=st.integers(5, 6), m=st.integers(4, 6), **hu.gcs)
+    def test_swish_gradient_from_input(self, n, m, gc, dc):
+
+        def swish_gradient(X, dY):
+            sig = 1. / (1. + np.exp(-X))
+            return [dY * (sig + X * sig * (1. - sig))]
+
+        X = np.random.rand(n, m).astype(np.float32)
+        dY = np.random.rand(n, m).astype(np.float32)
+        op = core.CreateOperator(
+            "SwishGradient",
+            ["X", "grad"],
+            "grad"
+        )
+
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=op,
+            inputs=[X, dY],
+            reference=swish_gradient,
+        )
+
     @given(n=st.integers(5, 6), m=st.integers(4, 6), **hu.gcs)
     def test_sigmoid(self, n, m, gc, dc):
         X = np.random.rand(n, m).astype(np.float32)
@@ -168,3 +190,38 @@ class TestElementwiseOps(hu.HypothesisTestCase):
 
         self.assertGradientChecks(
             gc, op, [X], 0, [0], stepsize=1e-4, threshold=1e-2)
+
+    @given(n=st.integers(2, 5), m=st.integers(2, 6),
+           d=st.integers(2, 4), **hu.gcs_cpu_only)
+    def test_fused_binary_post_ops(self, n, m, d, gc, dc):
+        ops = [
+            ("AddRelu", lambda x, y: np.maximum(x + y, 0)),
+            ("SubRelu", lambda x, y: np.maximum(x - y, 0)),
+            ("MulRelu", lambda x, y: np.maximum(x * y, 0)),
+            ("SubAbs", lambda x, y: np.abs(x - y)),
+            ("SubSqr", lambda x, y: np.square(x - y)),
+        ]
+        X = np.random.randn(n, m, d, 3).astype(np.float32)
+        # no broadcast, scalar, trailing dims and strided broadcast
+        cases = [
+            (np.random.randn(n, m, d, 3), {}),
+            (np.random.randn(1), {"broadcast": 1}),
+            (np.random.randn(d, 3), {"broadcast": 1}),
+            (np.random.randn(m, 1, 3), {"broadcast": 1}),
+            (np.random.randn(n, 1, d, 1), {"broadcast": 1}),
+        ]
+        for name, ref in ops:
+            for Y, kwargs in cases:
+                Y = Y.astype(np.float32)
+                op = core.CreateOperator(name, ["X", "Y"], ["Z"], **kwargs)
+                Y_aligned = Y.reshape((1,) * (X.ndim - Y.ndim) + Y.shape)
+
+                def fused_op(X, Y):
+                    return [ref(X, Y_aligned)]
+
+                self.assertReferenceChecks(
+                    device_option=gc,
+                    op=op,
+                    inputs=[X, Y],
+                    reference=fused_op,
+                )
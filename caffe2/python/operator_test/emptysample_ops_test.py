@@ -18,9 +18,11 @@ from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
 
+from caffe2.proto import caffe2_pb2
 from caffe2.python import core, workspace
 from caffe2.python.test_util import TestCase
 import numpy as np
+import unittest
 
 
 lengths = [[0], [1, 2], [1, 0, 2, 0]]
@@ -43,22 +45,26 @@ features2_exp = [[0],
 
 
 class TestEmptySampleOps(TestCase):
-    def test_emptysample(self):
+    def _test_emptysample(self, device_option):
         for i in range(0, 3):
             PadEmptyTest = core.CreateOperator(
                 'PadEmptySamples',
                 ['lengths', 'features1', 'features2'],
                 ['out_lengths', 'out_features1', 'out_features2'],
+                device_option=device_option,
             )
             workspace.FeedBlob(
                 'lengths',
-                np.array(lengths[i], dtype=np.int32))
+                np.array(lengths[i], dtype=np.int32),
+                device_option)
             workspace.FeedBlob(
                 'features1',
-                np.array(features1[i], dtype=np.int64))
+                np.array(features1[i], dtype=np.int64),
+                device_option)
             workspace.FeedBlob(
                 'features2',
-                np.array(features2[i], dtype=np.int64))
+                np.array(features2[i], dtype=np.int64),
+                device_option)
             workspace.RunOperatorOnce(PadEmptyTest)
             np.testing.assert_allclose(
                 lengths_exp[i],
@@ -73,6 +79,12 @@ class TestEmptySampleOps(TestCase):
                 workspace.FetchBlob('out_features2'),
                 atol=1e-4, rtol=1e-4, err_msg='Mismatch in features2')
 
+    def test_emptysample(self):
+        self._test_emptysample(core.DeviceOption(caffe2_pb2.CPU))
+
+    @unittest.skipIf(not workspace.has_hip, "No HIP support.")
+    def test_emptysample_hip(self):
+        self._test_emptysample(core.DeviceOption(caffe2_pb2.HIP, 0))
+
 if __name__ == "__main__":
-    import unittest
     unittest.main()
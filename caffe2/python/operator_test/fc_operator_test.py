@@ -129,6 +129,74 @@ class TestFcOperator(hu.HypothesisTestCase):
             self.assertGradientChecks(gc, op, [X, W, b], i, [0],
                                       threshold=threshold, stepsize=stepsize)
 
+    @settings(max_examples=30)
+    @given(n=st.integers(1, 40),
+           m=st.integers(1, 12),
+           k=st.integers(1, 300),
+           **hu.gcs_cpu_only)
+    def test_fc_small_batch(self, n, m, k, gc, dc):
+        # Batches of up to 8 rows take the small batch kernels on CPU, the
+        # k range covers their vector loops and tails.
+        X = np.random.rand(m, k).astype(np.float32) - 0.5
+        W = np.random.rand(n, k).astype(np.float32) - 0.5
+        b = np.random.rand(n).astype(np.float32) - 0.5
+
+        def fc_op(X, W, b):
+            return [np.dot(X, W.transpose()) + b]
+
+        op = core.CreateOperator(
+            'FC',
+            ['X', 'W', 'b'],
+            'out',
+        )
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=op,
+            inputs=[X, W, b],
+            reference=fc_op,
+        )
+
+    @settings(max_examples=20)
+    @given(n=st.integers(1, 40),
+           m=st.integers(0, 15),
+           k=st.integers(1, 300),
+           multi_dim=st.sampled_from([True, False]),
+           **hu.gcs_cpu_only)
+    def test_fc_packed_sgemm(self, n, m, k, multi_dim, gc, dc):
+        X = np.random.rand(m, k).astype(np.float32) - 0.5
+        if multi_dim:
+            W = np.random.rand(n, k, 1, 1).astype(np.float32) - 0.5
+        else:
+            W = np.random.rand(n, k).astype(np.float32) - 0.5
+        b = np.random.rand(n).astype(np.float32) - 0.5
+
+        op = core.CreateOperator(
+            'FC',
+            ['X', 'W', 'b'],
+            'out',
+            engine='PACKED_SGEMM',
+        )
+        workspace.FeedBlob('X', X)
+        workspace.FeedBlob('W', W)
+        workspace.FeedBlob('b', b)
+        net = core.Net('packed_fc')
+        net.Proto().op.extend([op])
+        workspace.CreateNet(net, True)
+
+        def check(W):
+            workspace.RunNet(net.Name())
+            np.testing.assert_allclose(
+                workspace.FetchBlob('out'),
+                np.dot(X, W.reshape(n, k).transpose()) + b,
+                rtol=1e-4, atol=1e-4)
+
+        check(W)
+        # The packed weight is cached by the op, it has to be repacked when
+        # the weight changes between runs.
+        W = W * 2 + 0.25
+        workspace.FeedBlob('W', W)
+        check(W)
+
 if __name__ == "__main__":
     import unittest
     unittest.main()
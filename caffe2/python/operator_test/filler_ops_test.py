@@ -26,6 +26,7 @@ from hypothesis import given
 import caffe2.python.hypothesis_test_util as hu
 
 import numpy as np
+import unittest
 
 
 def _fill_diagonal(shape, value):
@@ -227,7 +228,60 @@ class TestFillerOperator(hu.HypothesisTestCase):
             assert np.count_nonzero(blob_out) > 0, "All generated elements are "
             "zeros. Is the random generator functioning correctly?"
 
+    @given(**hu.gcs)
+    def test_multi_fill_op(self, gc, dc):
+        op = core.CreateOperator(
+            'MultiFill',
+            [],
+            ['uniform', 'gaussian', 'xavier', 'msra', 'constant', 'empty'],
+            fillers=['UniformFill', 'GaussianFill', 'XavierFill', 'MSRAFill',
+                     'ConstantFill', 'GaussianFill'],
+            ndims=[1, 2, 2, 4, 1, 2],
+            shapes=[1001, 33, 31, 64, 7, 8, 4, 3, 3, 5, 3, 0],
+            a=[-2.0, 3.0, 0.0, 0.0, 0.5, 0.0],
+            b=[2.0, 0.5, 1.0, 1.0, 1.0, 1.0],
+        )
+        for device_option in dc:
+            op.device_option.CopyFrom(device_option)
+            op.device_option.random_seed = 1701
+            assert workspace.RunOperatorOnce(op), "MultiFill op did not run "
+            "successfully"
+
+            uniform = workspace.FetchBlob('uniform')
+            self.assertEqual(uniform.shape, (1001,))
+            self.assertTrue(np.all(uniform >= -2.0))
+            self.assertTrue(np.all(uniform < 2.0))
+            gaussian = workspace.FetchBlob('gaussian')
+            self.assertEqual(gaussian.shape, (33, 31))
+            self.assertLess(abs(np.mean(gaussian) - 3.0), 0.2)
+            xavier = workspace.FetchBlob('xavier')
+            self.assertEqual(xavier.shape, (64, 7))
+            self.assertTrue(np.all(np.abs(xavier) <= np.sqrt(3.0 / 7)))
+            msra = workspace.FetchBlob('msra')
+            self.assertEqual(msra.shape, (8, 4, 3, 3))
+            self.assertGreater(np.count_nonzero(msra), 0)
+            np.testing.assert_array_equal(
+                workspace.FetchBlob('constant'), np.full(5, 0.5, np.float32))
+            self.assertEqual(workspace.FetchBlob('empty').shape, (3, 0))
+
+            # The same seed gives the same values whenever the op is created.
+            assert workspace.RunOperatorOnce(op)
+            np.testing.assert_array_equal(
+                workspace.FetchBlob('uniform'), uniform)
+
+    @unittest.skipIf(not workspace.has_hip, "No HIP support.")
+    def test_philox_fill_reproducible(self):
+        # On HIP every value only depends on the seed and on its position, so
+        # the first elements are the same whatever the size of the tensor.
+        outputs = []
+        for size in [37, 100003]:
+            op = core.CreateOperator(
+                'GaussianFill', [], 'out', shape=[size], device_option=hu.gpu_do)
+            op.device_option.random_seed = 7
+            workspace.RunOperatorOnce(op)
+            outputs.append(workspace.FetchBlob('out'))
+        np.testing.assert_array_equal(outputs[0], outputs[1][:37])
+
 
 if __name__ == "__main__":
-    import unittest
     unittest.main()
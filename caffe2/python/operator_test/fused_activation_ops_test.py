@@ -0,0 +1,126 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from caffe2.python import core
+from hypothesis import given
+import caffe2.python.hypothesis_test_util as hu
+import hypothesis.strategies as st
+import numpy as np
+import math
+
+
+def gelu(x):
+    erf = np.vectorize(math.erf)
+    return 0.5 * x * (1. + erf(x / math.sqrt(2.)))
+
+
+def gelu_derivative(x):
+    erf = np.vectorize(math.erf)
+    return (0.5 * (1. + erf(x / math.sqrt(2.))) +
+            x * np.exp(-0.5 * x * x) / math.sqrt(2. * math.pi))
+
+
+def swish(x):
+    return x / (1. + np.exp(-x))
+
+
+def swish_derivative(x):
+    sig = 1. / (1. + np.exp(-x))
+    return sig + x * sig * (1. - sig)
+
+
+class TestFusedActivationOps(hu.HypothesisTestCase):
+
+    @given(n=st.integers(1, 10), m=st.integers(1, 9), **hu.gcs)
+    def test_gelu(self, n, m, gc, dc):
+        X = np.random.randn(n, m).astype(np.float32)
+        op = core.CreateOperator("Gelu", ["X"], ["Y"])
+
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=op,
+            inputs=[X],
+            reference=lambda X: [gelu(X)],
+        )
+        self.assertDeviceChecks(dc, op, [X], [0])
+        self.assertGradientChecks(
+            gc, op, [X], 0, [0], stepsize=1e-3, threshold=1e-2)
+
+    @given(n=st.integers(1, 10), m=st.integers(1, 9), **hu.gcs)
+    def test_gelu_gradient_inplace(self, n, m, gc, dc):
+        X = np.random.randn(n, m).astype(np.float32)
+        dY = np.random.randn(n, m).astype(np.float32)
+        op = core.CreateOperator("GeluGradient", ["X", "grad"], ["grad"])
+
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=op,
+            inputs=[X, dY],
+            reference=lambda X, dY: [dY * gelu_derivative(X)],
+        )
+
+    @given(n=st.integers(0, 10),
+           m=st.integers(1, 9),
+           activation=st.sampled_from(["Gelu", "Swish"]),
+           **hu.gcs)
+    def test_bias_activation(self, n, m, activation, gc, dc):
+        X = np.random.randn(n, m).astype(np.float32)
+        bias = np.random.randn(m).astype(np.float32)
+        forward, derivative = {
+            "Gelu": (gelu, gelu_derivative),
+            "Swish": (swish, swish_derivative),
+        }[activation]
+        op = core.CreateOperator("Bias" + activation, ["X", "bias"], ["Y"])
+
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=op,
+            inputs=[X, bias],
+            reference=lambda X, bias: [forward(X + bias)],
+        )
+        self.assertDeviceChecks(dc, op, [X, bias], [0])
+
+        dY = np.random.randn(n, m).astype(np.float32)
+        grad_op = core.CreateOperator(
+            "Bias" + activation + "Gradient",
+            ["X", "bias", "dY"],
+            ["dX", "dbias"],
+        )
+
+        def bias_activation_gradient(X, bias, dY):
+            dX = dY * derivative(X + bias)
+            return [dX, dX.sum(axis=0)]
+
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=grad_op,
+            inputs=[X, bias, dY],
+            reference=bias_activation_gradient,
+        )
+        if n > 0:
+            for i in range(2):
+                self.assertGradientChecks(
+                    gc, op, [X, bias], i, [0],
+                    stepsize=1e-3, threshold=1e-2)
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
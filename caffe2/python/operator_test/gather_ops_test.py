@@ -47,6 +47,29 @@ class TestGatherOps(hu.HypothesisTestCase):
 
         self.assertReferenceChecks(gc, op, [data, ind], ref_gather)
 
+    @given(rows_num=st.integers(1, 50),
+           index_num=st.integers(0, 50),
+           row_width=st.integers(1, 300),
+           dtype=st.sampled_from([np.float32, np.float64, np.int64,
+                                  np.uint8]),
+           index_type=st.sampled_from([np.int32, np.int64]),
+           **hu.gcs)
+    def test_gather_row_widths(self, rows_num, index_num, row_width, dtype,
+                               index_type, gc, dc):
+        # Row sizes of every alignment, copied with different word sizes.
+        data = (np.random.random((rows_num, row_width)) * 100).astype(dtype)
+        ind = np.random.randint(rows_num, size=(index_num, )).astype(
+            index_type)
+        op = core.CreateOperator(
+            'Gather',
+            ['data', 'ind'],
+            ['output'])
+
+        def ref_gather(data, ind):
+            return [data[ind]]
+
+        self.assertReferenceChecks(gc, op, [data, ind], ref_gather)
+
 
 @st.composite
 def _inputs(draw):
@@ -86,6 +109,27 @@ class TestBatchGatherOps(hu.HypothesisTestCase):
         self.assertReferenceChecks(gc, op, [data, ind], ref_batch_gather)
         self.assertGradientChecks(gc, op, [data, ind], 0, [0])
 
+    @given(batch_size=st.integers(1, 5),
+           rows_num=st.integers(1, 20),
+           index_num=st.integers(1, 20),
+           row_width=st.integers(1, 100),
+           **hu.gcs)
+    def test_batch_gather_int64_indices(self, batch_size, rows_num, index_num,
+                                        row_width, gc, dc):
+        data = np.random.random(
+            (batch_size, rows_num, row_width)).astype(np.float32)
+        ind = np.random.randint(rows_num, size=(index_num, )).astype(np.int64)
+        op = core.CreateOperator(
+            'BatchGather',
+            ['data', 'ind'],
+            ['output'])
+
+        def ref_batch_gather(data, ind):
+            return [data[:, ind]]
+
+        self.assertReferenceChecks(gc, op, [data, ind], ref_batch_gather)
+        self.assertGradientChecks(gc, op, [data, ind], 0, [0])
+
 
 if __name__ == "__main__":
     import unittest
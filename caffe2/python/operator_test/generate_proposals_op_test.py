@@ -0,0 +1,148 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from caffe2.python import core, workspace
+import caffe2.python.hypothesis_test_util as hu
+
+from hypothesis import given
+import hypothesis.strategies as st
+import numpy as np
+import unittest
+
+BBOX_XFORM_CLIP = np.log(1000. / 16.)
+
+
+def box_iou(a, b):
+    w = max(min(a[2], b[2]) - max(a[0], b[0]) + 1., 0.)
+    h = max(min(a[3], b[3]) - max(a[1], b[1]) + 1., 0.)
+    inter = w * h
+    area_a = (a[2] - a[0] + 1.) * (a[3] - a[1] + 1.)
+    area_b = (b[2] - b[0] + 1.) * (b[3] - b[1] + 1.)
+    return inter / (area_a + area_b - inter)
+
+
+def generate_proposals_ref(scores, bbox_deltas, im_info, anchors,
+                           spatial_scale, pre_nms_topN, post_nms_topN,
+                           nms_thresh, min_size):
+    N, A, H, W = scores.shape
+    feat_stride = 1. / spatial_scale
+    # All the anchors in (H, W, A) order.
+    shift_x, shift_y = np.meshgrid(np.arange(W) * feat_stride,
+                                   np.arange(H) * feat_stride)
+    shifts = np.vstack((shift_x.ravel(), shift_y.ravel(),
+                        shift_x.ravel(), shift_y.ravel())).transpose()
+    all_anchors = (anchors[np.newaxis, :, :] +
+                   shifts[:, np.newaxis, :]).reshape(-1, 4)
+
+    rois = []
+    probs = []
+    for n in range(N):
+        deltas = bbox_deltas[n].transpose((1, 2, 0)).reshape(-1, 4)
+        image_scores = scores[n].transpose((1, 2, 0)).reshape(-1)
+        order = np.argsort(-image_scores, kind='mergesort')
+        if 0 < pre_nms_topN < len(order):
+            order = order[:pre_nms_topN]
+
+        height, width, scale = im_info[n]
+        boxes = []
+        for k in order:
+            x1, y1, x2, y2 = all_anchors[k]
+            dx, dy, dw, dh = deltas[k]
+            dw = min(dw, BBOX_XFORM_CLIP)
+            dh = min(dh, BBOX_XFORM_CLIP)
+            w = x2 - x1 + 1.
+            h = y2 - y1 + 1.
+            ctr_x = x1 + 0.5 * w + dx * w
+            ctr_y = y1 + 0.5 * h + dy * h
+            pred_w = np.exp(dw) * w
+            pred_h = np.exp(dh) * h
+            box = np.array([ctr_x - 0.5 * pred_w, ctr_y - 0.5 * pred_h,
+                            ctr_x + 0.5 * pred_w, ctr_y + 0.5 * pred_h])
+            box[0::2] = np.clip(box[0::2], 0., width - 1.)
+            box[1::2] = np.clip(box[1::2], 0., height - 1.)
+            ws = box[2] - box[0] + 1.
+            hs = box[3] - box[1] + 1.
+            valid = (ws >= min_size * scale and hs >= min_size * scale and
+                     box[0] + ws / 2. < width and box[1] + hs / 2. < height)
+            if valid:
+                boxes.append((box, image_scores[k]))
+
+        # Greedy NMS in score order.
+        kept = []
+        for box, score in boxes:
+            if 0 < post_nms_topN <= len(kept):
+                break
+            if all(box_iou(box, other) <= nms_thresh for other, _ in kept):
+                kept.append((box, score))
+        for box, score in kept:
+            rois.append(np.concatenate(([n], box)))
+            probs.append(score)
+
+    return (np.array(rois, dtype=np.float32).reshape(-1, 5),
+            np.array(probs, dtype=np.float32))
+
+
+class TestGenerateProposalsOp(hu.HypothesisTestCase):
+    @unittest.skipIf(not workspace.has_gpu_support, "No gpu support.")
+    @given(N=st.integers(1, 3),
+           A=st.integers(1, 4),
+           H=st.integers(1, 8),
+           W=st.integers(1, 8),
+           pre_nms_topN=st.sampled_from([-1, 20, 6000]),
+           post_nms_topN=st.sampled_from([-1, 10, 300]),
+           nms_thresh=st.sampled_from([0.3, 0.7]),
+           **hu.gcs_gpu_only)
+    def test_generate_proposals(self, N, A, H, W, pre_nms_topN, post_nms_topN,
+                                nms_thresh, gc, dc):
+        spatial_scale = 1. / 16
+        min_size = 4.
+        # Distinct scores, so that the order of the anchors is well defined.
+        scores = np.random.permutation(N * A * H * W).astype(np.float32)
+        scores = (scores / scores.size).reshape(N, A, H, W)
+        bbox_deltas = (np.random.randn(N, 4 * A, H, W) * 0.2).astype(
+            np.float32)
+        im_info = np.tile(
+            np.array([[H * 16., W * 16., 1.]], dtype=np.float32), (N, 1))
+        sizes = np.random.uniform(8., 64., size=(A, 2))
+        anchors = np.hstack((-sizes / 2, sizes / 2)).astype(np.float32)
+
+        op = core.CreateOperator(
+            "GenerateProposals",
+            ["scores", "bbox_deltas", "im_info", "anchors"],
+            ["rois", "rois_probs"],
+            spatial_scale=spatial_scale,
+            pre_nms_topN=pre_nms_topN,
+            post_nms_topN=post_nms_topN,
+            nms_thresh=nms_thresh,
+            min_size=min_size,
+        )
+
+        def ref(scores, bbox_deltas, im_info, anchors):
+            return generate_proposals_ref(
+                scores, bbox_deltas, im_info, anchors, spatial_scale,
+                pre_nms_topN, post_nms_topN, nms_thresh, min_size)
+
+        self.assertReferenceChecks(
+            gc, op, [scores, bbox_deltas, im_info, anchors], ref,
+            threshold=1e-3)
+
+
+if __name__ == "__main__":
+    unittest.main()
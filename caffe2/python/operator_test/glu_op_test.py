@@ -34,5 +34,16 @@ class TestGlu(hu.HypothesisTestCase):
         op = core.CreateOperator("Glu", ["X"], ["Y"], dim=axis)
         self.assertReferenceChecks(gc, op, [X], glu_ref)
 
+    @given(
+        M=st.integers(1, 4),
+        split=st.integers(1, 5),
+        N=st.integers(1, 4),
+        **hu.gcs
+    )
+    def test_glu_gradient(self, M, split, N, gc, dc):
+        X = np.random.randn(M, 2 * split, N).astype(np.float32)
+        op = core.CreateOperator("Glu", ["X"], ["Y"], dim=1)
+        self.assertGradientChecks(gc, op, [X], 0, [0])
+
 if __name__ == "__main__":
     unittest.main()
@@ -0,0 +1,79 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from caffe2.python import core
+from hypothesis import given
+import caffe2.python.hypothesis_test_util as hu
+import hypothesis.strategies as st
+import numpy as np
+
+
+class TestGroupNormOp(hu.HypothesisTestCase):
+    @given(N=st.integers(1, 3),
+           G=st.integers(1, 4),
+           D=st.integers(1, 3),
+           H=st.integers(1, 5),
+           W=st.integers(1, 5),
+           offset=st.sampled_from([0.0, 1000.0]),
+           **hu.gcs)
+    def test_group_norm(self, N, G, D, H, W, offset, gc, dc):
+        C = G * D
+        epsilon = 1e-5
+        # The offset checks that the single pass statistics stay accurate
+        # when the mean is large compared to the spread.
+        X = np.random.randn(N, C, H, W).astype(np.float32) + offset
+        gamma = np.random.randn(C).astype(np.float32)
+        beta = np.random.randn(C).astype(np.float32)
+
+        op = core.CreateOperator(
+            "GroupNorm",
+            ["X", "gamma", "beta"],
+            ["Y", "mean", "stdev"],
+            num_groups=G,
+            epsilon=epsilon,
+        )
+
+        def group_norm_ref(X, gamma, beta):
+            grouped = X.reshape(N, G, -1).astype(np.float64)
+            mean = grouped.mean(axis=2)
+            stdev = np.sqrt(grouped.var(axis=2) + epsilon)
+            Y = (grouped - mean[:, :, None]) / stdev[:, :, None]
+            Y = Y.reshape(N, C, H, W) * gamma.reshape(1, C, 1, 1) + \
+                beta.reshape(1, C, 1, 1)
+            return [Y.astype(np.float32), mean.astype(np.float32),
+                    stdev.astype(np.float32)]
+
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=op,
+            inputs=[X, gamma, beta],
+            reference=group_norm_ref,
+            threshold=1e-3,
+        )
+        self.assertDeviceChecks(dc, op, [X, gamma, beta], [0, 1, 2])
+        if offset == 0.0:
+            for i in range(3):
+                self.assertGradientChecks(gc, op, [X, gamma, beta], i, [0])
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
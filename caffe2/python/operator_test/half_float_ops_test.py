@@ -0,0 +1,67 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from caffe2.python import core, workspace
+from hypothesis import given
+import caffe2.python.hypothesis_test_util as hu
+import hypothesis.strategies as st
+import numpy as np
+
+
+class TestHalfFloatOps(hu.HypothesisTestCase):
+
+    # The sizes cover the vector loops of the CPU kernels and their tails.
+    @given(n=st.integers(0, 100), **hu.gcs_cpu_only)
+    def test_float_to_half(self, n, gc, dc):
+        X = (np.random.randn(n) * 10).astype(np.float32)
+        # Subnormals and values that overflow half precision.
+        X[:n // 4] *= 1e-6
+        X[n // 4:n // 3] *= 1e4
+
+        op = core.CreateOperator('FloatToHalf', ['X'], ['Y'])
+
+        def ref(X):
+            return [X.astype(np.float16)]
+
+        self.assertReferenceChecks(gc, op, [X], ref)
+
+    @given(n=st.integers(0, 100), **hu.gcs_cpu_only)
+    def test_half_to_float(self, n, gc, dc):
+        X = (np.random.randn(n) * 10).astype(np.float16)
+        X[:n // 4] *= np.float16(1e-6)
+
+        workspace.FeedBlob('X', X)
+        workspace.RunOperatorOnce(
+            core.CreateOperator('HalfToFloat', ['X'], ['Y']))
+        np.testing.assert_array_equal(
+            workspace.FetchBlob('Y'), X.astype(np.float32))
+
+    @given(value=st.floats(-10, 10), **hu.gcs_cpu_only)
+    def test_float16_constant_fill(self, value, gc, dc):
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'Float16ConstantFill', [], ['Y'], shape=[2, 3], value=value))
+        np.testing.assert_array_equal(
+            workspace.FetchBlob('Y'),
+            np.full([2, 3], value, dtype=np.float16))
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
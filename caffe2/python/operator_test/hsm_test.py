@@ -191,8 +191,7 @@ class TestHsm(hu.HypothesisTestCase):
 
     # Test to compare gradient calculated using the gradient operator and the
     # symmetric derivative calculated using Euler Method
-    # TODO : convert to both cpu and gpu test when ready.
-    @given(**hu.gcs_cpu_only)
+    @given(**hu.gcs)
     def test_hsm_gradient(self, gc, dc):
         samples = 10
         dim_in = 5
@@ -252,8 +252,8 @@ def create_test(output_dir, width, height, default_bound, minsize, crop, means,
 
 def run_test(
         size_tuple, means, stds, label_type, num_labels, is_test, scale_jitter_type,
-        color_jitter, color_lighting, dc, validator, output1=None, output2_size=None):
-    # TODO: Does not test on GPU and does not test use_gpu_transform
+        color_jitter, color_lighting, dc, validator, output1=None, output2_size=None,
+        gpu_augmentation=False):
     # WARNING: Using ModelHelper automatically does NHWC to NCHW
     # transformation if needed.
     width, height, minsize, crop = size_tuple
@@ -277,6 +277,7 @@ def run_test(
         output2_size=output2_size
     )
     for device_option in dc:
+        use_gpu = device_option.device_type != caffe2_pb2.CPU
         with hu.temp_workspace():
             reader_net = core.Net('reader')
             reader_net.CreateDB(
@@ -309,7 +310,8 @@ def run_test(
                 bounding_width=width - 5,
                 mean_per_channel=means,
                 std_per_channel=stds,
-                use_gpu_transform=(device_option.device_type == 1),
+                use_gpu_transform=use_gpu,
+                use_gpu_augmentation=(use_gpu and gpu_augmentation),
                 label_type=label_type,
                 num_labels=num_labels,
                 output_sizes=output_sizes,
@@ -335,12 +337,14 @@ def run_test(
 class TestImport(hu.HypothesisTestCase):
     def validate_image_and_label(
             self, expected_images, device_option, count_images, label_type,
-            is_test, scale_jitter_type, color_jitter, color_lighting):
+            is_test, scale_jitter_type, color_jitter, color_lighting,
+            gpu_augmentation=False):
         l = workspace.FetchBlob('label')
         result = workspace.FetchBlob('data').astype(np.int32)
         # If we don't use_gpu_transform, the output is in NHWC
         # Our reference output is CHW so we swap
-        if device_option.device_type != 1:
+        use_gpu = device_option.device_type != caffe2_pb2.CPU
+        if not use_gpu:
             expected = [img.swapaxes(0, 1).swapaxes(1, 2) for
                         (img, _, _, _) in expected_images]
         else:
@@ -357,6 +361,11 @@ class TestImport(hu.HypothesisTestCase):
                 # color lightin), we only compare blob shape
                 for (s1, s2) in zip(expected[i].shape, result[i].shape):
                     self.assertEqual(s1, s2)
+            elif use_gpu and gpu_augmentation:
+                # the GPU resamples with its own filters, which differ from
+                # OpenCV's by a rounding here and there
+                self.assertLessEqual(
+                    np.abs(expected[i] - result[i]).mean(), 1)
             else:
                 self.assertEqual((expected[i] - result[i] > 1).sum(), 0)
         # End for
@@ -380,20 +389,23 @@ class TestImport(hu.HypothesisTestCase):
         scale_jitter_type=st.integers(min_value=0, max_value=1),
         color_jitter=st.integers(min_value=0, max_value=1),
         color_lighting=st.integers(min_value=0, max_value=1),
+        gpu_augmentation=st.booleans(),
         **hu.gcs)
     @settings(verbosity=Verbosity.verbose)
     def test_imageinput(
             self, size_tuple, means, stds, label_type,
             num_labels, is_test, scale_jitter_type, color_jitter, color_lighting,
-            gc, dc):
+            gpu_augmentation, gc, dc):
         def validator(expected_images, device_option, count_images):
             self.validate_image_and_label(
                 expected_images, device_option, count_images, label_type,
-                is_test, scale_jitter_type, color_jitter, color_lighting)
+                is_test, scale_jitter_type, color_jitter, color_lighting,
+                gpu_augmentation)
         # End validator
         run_test(
             size_tuple, means, stds, label_type, num_labels, is_test,
-            scale_jitter_type, color_jitter, color_lighting, dc, validator)
+            scale_jitter_type, color_jitter, color_lighting, dc, validator,
+            gpu_augmentation=gpu_augmentation)
     # End test_imageinput
 
     @given(size_tuple=st.tuples(
@@ -17,11 +17,13 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
-from caffe2.python import core
+from caffe2.proto import caffe2_pb2
+from caffe2.python import core, workspace
 from hypothesis import given
 import caffe2.python.hypothesis_test_util as hu
 import hypothesis.strategies as st
 import numpy as np
+import unittest
 
 
 class TestIndexHashOps(hu.HypothesisTestCase):
@@ -53,3 +55,47 @@ class TestIndexHashOps(hu.HypothesisTestCase):
 
         self.assertDeviceChecks(dc, op, [indices], [0])
         self.assertReferenceChecks(gc, op, [indices], index_hash)
+
+    @given(
+        strings=st.lists(st.binary(max_size=8), min_size=0, max_size=10),
+        seed=st.integers(min_value=0, max_value=10),
+        modulo=st.integers(min_value=100000, max_value=200000),
+        **hu.gcs_cpu_only
+    )
+    def test_packed_string_index_hash(self, strings, seed, modulo, gc, dc):
+        data = np.frombuffer(b''.join(strings), dtype=np.uint8)
+        lengths = np.array([len(s) for s in strings], dtype=np.int32)
+        op = core.CreateOperator("PackedStringIndexHash",
+                                 ["data", "lengths"], ["hashed_indices"],
+                                 seed=seed, modulo=modulo)
+
+        def packed_string_index_hash(data, lengths):
+            hashed_indices = []
+            offset = 0
+            for length in lengths:
+                hashed = np.int64(0xDEADBEEF * seed)
+                for b in data[offset:offset + length].view(np.int8):
+                    hashed = np.int64(hashed * 65537 + b)
+                hashed = (modulo + hashed % modulo) % modulo
+                hashed_indices.append(hashed)
+                offset += length
+            return [np.array(hashed_indices, dtype=np.int64)]
+
+        self.assertReferenceChecks(
+            gc, op, [data, lengths], packed_string_index_hash)
+
+    @unittest.skipIf(not workspace.has_hip, "No HIP support.")
+    @given(
+        indices=st.sampled_from([
+            np.int32, np.int64
+        ]).flatmap(lambda dtype: hu.tensor(min_dim=1, max_dim=1, dtype=dtype)),
+        seed=st.integers(min_value=0, max_value=10),
+        modulo=st.integers(min_value=100000, max_value=200000)
+    )
+    def test_index_hash_ops_hip(self, indices, seed, modulo):
+        op = core.CreateOperator("IndexHash",
+                                 ["indices"], ["hashed_indices"],
+                                 seed=seed, modulo=modulo)
+        dc = [core.DeviceOption(caffe2_pb2.CPU),
+              core.DeviceOption(caffe2_pb2.HIP, 0)]
+        self.assertDeviceChecks(dc, op, [indices], [0])
@@ -147,6 +147,54 @@ class TestIndexOps(TestCase):
     def test_long_index_ops(self):
         self._test_index_ops(list(range(8)), np.int64, 'LongIndexCreate')
 
+    def test_long_index_growth(self):
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'LongIndexCreate', [], ['index'], max_elements=20001))
+        keys = np.random.permutation(20000).astype(np.int64) * 7919 - 100
+        workspace.FeedBlob('keys', keys)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'IndexGet', ['index', 'keys'], ['ids']))
+        np.testing.assert_array_equal(
+            workspace.FetchBlob('ids'), np.arange(1, 20001))
+
+        # lookups of known keys return the same ids in any order
+        workspace.FeedBlob('keys', keys[::-1].copy())
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'IndexGet', ['index', 'keys'], ['ids']))
+        np.testing.assert_array_equal(
+            workspace.FetchBlob('ids'), np.arange(20000, 0, -1))
+
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'IndexStore', ['index'], ['stored']))
+        np.testing.assert_array_equal(workspace.FetchBlob('stored'), keys)
+
+        # the index is full now
+        workspace.FeedBlob('new_key', np.array([1], dtype=np.int64))
+        with self.assertRaises(RuntimeError):
+            workspace.RunOperatorOnce(core.CreateOperator(
+                'IndexGet', ['index', 'new_key'], ['new_id']))
+
+    def test_packed_string_index_get(self):
+        words = [b'apple', b'', b'pear', b'apple', b'fig', b'pear']
+        workspace.FeedBlob('words', np.array(words, dtype=object))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'StringPack', ['words'], ['data', 'lengths']))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'StringIndexCreate', [], ['index'], max_elements=10))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'IndexGet', ['index', 'data', 'lengths'], ['ids']))
+        np.testing.assert_array_equal(
+            workspace.FetchBlob('ids'), [1, 2, 3, 1, 4, 3])
+
+        # packed and unpacked keys share the same entries
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'IndexFreeze', ['index'], ['index']))
+        workspace.FeedBlob(
+            'words2', np.array([b'fig', b'kiwi', b'apple'], dtype=object))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'IndexGet', ['index', 'words2'], ['ids2']))
+        np.testing.assert_array_equal(workspace.FetchBlob('ids2'), [4, 0, 1])
+
 if __name__ == "__main__":
     import unittest
     unittest.main()
@@ -0,0 +1,217 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from caffe2.python import core
+import caffe2.python.hypothesis_test_util as hu
+
+from hypothesis import given
+import hypothesis.strategies as st
+import numpy as np
+import unittest
+
+
+def _requantize(acc, multiplier, offset, Y_zero_point, relu):
+    q = np.round(acc * multiplier + offset)
+    lower = Y_zero_point if relu else 0
+    return np.clip(q, lower, 255).astype(np.float32)
+
+
+def _int8_gemm_ref(X, W, b, X_params, W_scale, W_zero_point, Y_params, relu):
+    X_scale, X_zero_point = X_params
+    Y_scale, Y_zero_point = Y_params
+    acc = (X.astype(np.int64) - X_zero_point).dot(
+        (W.astype(np.int64) - W_zero_point[:, None]).T)
+    multiplier = X_scale * W_scale / Y_scale
+    offset = (b / Y_scale if b is not None else 0) + Y_zero_point
+    return _requantize(acc, multiplier, offset, Y_zero_point, relu)
+
+
+def _im2col_nhwc(X, kernel, stride, pad, pad_value):
+    N, H, W, C = X.shape
+    Xp = np.full((N, H + 2 * pad, W + 2 * pad, C), pad_value, dtype=X.dtype)
+    Xp[:, pad:pad + H, pad:pad + W, :] = X
+    OH = (H + 2 * pad - kernel) // stride + 1
+    OW = (W + 2 * pad - kernel) // stride + 1
+    col = np.empty((N, OH, OW, kernel * kernel * C), dtype=X.dtype)
+    for oh in range(OH):
+        for ow in range(OW):
+            patch = Xp[:, oh * stride:oh * stride + kernel,
+                       ow * stride:ow * stride + kernel, :]
+            col[:, oh, ow, :] = patch.reshape(N, -1)
+    return col
+
+
+class TestInt8Ops(hu.HypothesisTestCase):
+    @given(size=st.integers(1, 100),
+           scale=st.floats(0.01, 1.0),
+           zero_point=st.integers(0, 255),
+           **hu.gcs)
+    def test_int8_quantize_dequantize(self, size, scale, zero_point, gc, dc):
+        X = (np.random.randn(size) * 50).astype(np.float32)
+
+        def quantize_ref(X):
+            q = np.round(X / scale) + zero_point
+            return (np.clip(q, 0, 255).astype(np.float32),)
+
+        op = core.CreateOperator(
+            "Int8Quantize", ["X"], ["Y"],
+            Y_scale=scale, Y_zero_point=zero_point)
+        self.assertReferenceChecks(gc, op, [X], quantize_ref, threshold=1.0)
+        self.assertDeviceChecks(dc, op, [X], [0], threshold=1.0)
+
+        Xq = np.random.randint(0, 256, size).astype(np.uint8)
+
+        def dequantize_ref(Xq):
+            return (scale * (Xq.astype(np.float32) - zero_point),)
+
+        op = core.CreateOperator(
+            "Int8Dequantize", ["Xq"], ["Y"],
+            X_scale=scale, X_zero_point=zero_point)
+        self.assertReferenceChecks(gc, op, [Xq], dequantize_ref)
+        self.assertDeviceChecks(dc, op, [Xq], [0])
+
+    @given(M=st.integers(1, 10),
+           N=st.integers(1, 20),
+           K=st.integers(1, 300),
+           per_channel=st.booleans(),
+           with_bias=st.booleans(),
+           relu=st.booleans(),
+           **hu.gcs)
+    def test_int8_fc(self, M, N, K, per_channel, with_bias, relu, gc, dc):
+        X = np.random.randint(0, 256, (M, K)).astype(np.uint8)
+        W = np.random.randint(-128, 128, (N, K)).astype(np.int8)
+        b = np.random.randn(N).astype(np.float32)
+        X_params = (0.05, 17)
+        Y_params = (0.5 * np.sqrt(K), 100)
+        if per_channel:
+            W_scale = np.random.rand(N).astype(np.float32) * 0.1 + 0.01
+            W_zero_point = np.random.randint(-10, 10, N)
+        else:
+            W_scale = np.full(N, 0.05, dtype=np.float32)
+            W_zero_point = np.full(N, 3)
+
+        op = core.CreateOperator(
+            "Int8FC",
+            ["X", "W", "b"] if with_bias else ["X", "W"],
+            ["Y"],
+            X_scale=X_params[0], X_zero_point=X_params[1],
+            W_scale=[float(s) for s in W_scale] if per_channel
+            else float(W_scale[0]),
+            W_zero_point=[int(z) for z in W_zero_point] if per_channel
+            else int(W_zero_point[0]),
+            Y_scale=Y_params[0], Y_zero_point=Y_params[1],
+            relu=relu)
+
+        def ref(X, W, b=None):
+            return (_int8_gemm_ref(
+                X, W, b, X_params, W_scale, W_zero_point, Y_params, relu),)
+
+        inputs = [X, W, b] if with_bias else [X, W]
+        self.assertReferenceChecks(gc, op, inputs, ref, threshold=1.0)
+        self.assertDeviceChecks(dc, op, inputs, [0], threshold=1.0)
+
+    @given(kernel=st.integers(1, 3),
+           stride=st.integers(1, 2),
+           pad=st.integers(0, 1),
+           size=st.integers(3, 8),
+           C=st.integers(1, 40),
+           M=st.integers(1, 10),
+           **hu.gcs)
+    def test_int8_conv(self, kernel, stride, pad, size, C, M, gc, dc):
+        pad = min(pad, kernel - 1)
+        X = np.random.randint(0, 256, (2, size, size, C)).astype(np.uint8)
+        W = np.random.randint(-128, 128, (M, kernel, kernel, C)).astype(
+            np.int8)
+        b = np.random.randn(M).astype(np.float32)
+        X_params = (0.05, 120)
+        Y_params = (0.2 * kernel * np.sqrt(C), 128)
+        W_scale = np.random.rand(M).astype(np.float32) * 0.1 + 0.01
+        W_zero_point = np.zeros(M, dtype=np.int64)
+
+        op = core.CreateOperator(
+            "Int8Conv", ["X", "W", "b"], ["Y"],
+            kernel=kernel, stride=stride, pad=pad, order="NHWC",
+            X_scale=X_params[0], X_zero_point=X_params[1],
+            W_scale=[float(s) for s in W_scale], W_zero_point=0,
+            Y_scale=Y_params[0], Y_zero_point=Y_params[1])
+
+        def ref(X, W, b):
+            col = _im2col_nhwc(X, kernel, stride, pad, X_params[1])
+            Y = _int8_gemm_ref(
+                col.reshape(-1, col.shape[-1]), W.reshape(M, -1), b,
+                X_params, W_scale, W_zero_point, Y_params, False)
+            return (Y.reshape(col.shape[:3] + (M,)),)
+
+        self.assertReferenceChecks(gc, op, [X, W, b], ref, threshold=1.0)
+        self.assertDeviceChecks(dc, op, [X, W, b], [0], threshold=1.0)
+
+    @given(size=st.integers(1, 100),
+           zero_point=st.integers(0, 255),
+           requantize=st.booleans(),
+           **hu.gcs)
+    def test_int8_relu(self, size, zero_point, requantize, gc, dc):
+        X = np.random.randint(0, 256, size).astype(np.uint8)
+        kwargs = dict(X_scale=0.1, X_zero_point=zero_point)
+        if requantize:
+            kwargs.update(Y_scale=0.05, Y_zero_point=0)
+        op = core.CreateOperator("Int8Relu", ["X"], ["Y"], **kwargs)
+
+        def ref(X):
+            if not requantize:
+                return (np.maximum(X, zero_point).astype(np.float32),)
+            real = np.maximum(0.1 * (X.astype(np.float32) - zero_point), 0)
+            return (np.clip(np.round(real / 0.05), 0, 255).astype(
+                np.float32),)
+
+        self.assertReferenceChecks(gc, op, [X], ref, threshold=1.0)
+        self.assertDeviceChecks(dc, op, [X], [0], threshold=1.0)
+
+    @given(kernel=st.integers(1, 3),
+           stride=st.integers(1, 2),
+           pad=st.integers(0, 1),
+           size=st.integers(3, 8),
+           C=st.integers(1, 20),
+           order=st.sampled_from(["NCHW", "NHWC"]),
+           **hu.gcs)
+    def test_int8_max_pool(self, kernel, stride, pad, size, C, order, gc, dc):
+        pad = min(pad, kernel - 1)
+        X = np.random.randint(0, 256, (2, size, size, C)).astype(np.uint8)
+        if order == "NCHW":
+            X = X.transpose(0, 3, 1, 2).copy()
+        kwargs = dict(kernel=kernel, stride=stride, pad=pad, order=order)
+        op = core.CreateOperator("Int8MaxPool", ["X"], ["Y"], **kwargs)
+        float_op = core.CreateOperator("MaxPool", ["X"], ["Y"], **kwargs)
+
+        # As the padding never wins the max for uint8 inputs, the float
+        # operator is an exact reference.
+        def ref(X):
+            from caffe2.python import workspace
+            workspace.FeedBlob("X_float", X.astype(np.float32))
+            float_op.input[0] = "X_float"
+            float_op.output[0] = "Y_float"
+            workspace.RunOperatorOnce(float_op)
+            return (workspace.FetchBlob("Y_float"),)
+
+        self.assertReferenceChecks(gc, op, [X], ref)
+        self.assertDeviceChecks(dc, op, [X], [0])
+
+
+if __name__ == "__main__":
+    unittest.main()
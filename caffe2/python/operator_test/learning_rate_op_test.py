@@ -18,13 +18,14 @@ from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
 
-from caffe2.python import core
+from caffe2.python import core, workspace
 import caffe2.python.hypothesis_test_util as hu
 
 from hypothesis import given
 
 import numpy as np
 import math
+import unittest
 
 
 class TestLearningRate(hu.HypothesisTestCase):
@@ -93,7 +94,45 @@ class TestLearningRate(hu.HypothesisTestCase):
         )
         self.assertReferenceChecks(gc, op, [iter], ref)
 
+    @unittest.skipIf(not workspace.has_hip, "No HIP support.")
+    def test_learning_rate_device_iter(self):
+        # With the counter on the device, Iter and LearningRate run without
+        # reading it on the host and give the same rates as on the CPU.
+        policies = [
+            dict(policy="fixed"),
+            dict(policy="step", stepsize=3, gamma=0.5),
+            dict(policy="exp", gamma=0.9),
+            dict(policy="inv", gamma=0.1, power=0.75),
+            dict(policy="poly", power=2.0, max_iter=100),
+            dict(policy="linearWarmup", start_multiplier=0.1, num_iter=5),
+            dict(policy="constantWarmup", multiplier=0.3, num_iter=5),
+            dict(policy="alter", active_first=True, active_period=2,
+                 inactive_period=3),
+            dict(policy="hill", num_iter=4, start_multiplier=0.2, gamma=0.1,
+                 power=0.5, end_multiplier=0.3),
+        ]
+        for args in policies:
+            workspace.FeedBlob(
+                'iter', np.array([0], dtype=np.int64), device_option=hu.gpu_do)
+            workspace.FeedBlob(
+                'iter_cpu', np.array([0], dtype=np.int64))
+            for _ in range(8):
+                workspace.RunOperatorOnce(core.CreateOperator(
+                    'Iter', 'iter', 'iter', device_option=hu.gpu_do))
+                workspace.RunOperatorOnce(core.CreateOperator(
+                    'Iter', 'iter_cpu', 'iter_cpu'))
+                workspace.RunOperatorOnce(core.CreateOperator(
+                    'LearningRate', 'iter', 'lr', base_lr=-0.1,
+                    device_option=hu.gpu_do, **args))
+                workspace.RunOperatorOnce(core.CreateOperator(
+                    'LearningRate', 'iter_cpu', 'lr_cpu', base_lr=-0.1,
+                    **args))
+                np.testing.assert_array_equal(
+                    workspace.FetchBlob('iter'), workspace.FetchBlob('iter_cpu'))
+                np.testing.assert_allclose(
+                    workspace.FetchBlob('lr'), workspace.FetchBlob('lr_cpu'),
+                    rtol=1e-5)
+
 
 if __name__ == "__main__":
-    import unittest
     unittest.main()
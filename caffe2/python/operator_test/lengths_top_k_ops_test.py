@@ -18,6 +18,7 @@ from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
 from caffe2.python import core
+from caffe2.python.workspace import has_hip
 from hypothesis import given
 import caffe2.python.hypothesis_test_util as hu
 import hypothesis.strategies as st
@@ -27,7 +28,7 @@ import numpy as np
 class TestLengthsTopKOps(hu.HypothesisTestCase):
     @given(N=st.integers(min_value=0, max_value=10),
            K=st.integers(min_value=1, max_value=10),
-           **hu.gcs_cpu_only)
+           **(hu.gcs if has_hip else hu.gcs_cpu_only))
     def test_lengths_top_k_op(self, N, K, gc, dc):
         lens = np.random.randint(low=1, high=2 * K + 1, size=N).astype(np.int32)
         X = []
@@ -58,7 +59,7 @@ class TestLengthsTopKOps(hu.HypothesisTestCase):
 
     @given(N=st.integers(min_value=0, max_value=10),
            K=st.integers(min_value=1, max_value=10),
-           **hu.gcs_cpu_only)
+           **(hu.gcs if has_hip else hu.gcs_cpu_only))
     def test_lengths_top_k_empty_op(self, N, K, gc, dc):
         lens = np.zeros((N, ), dtype=np.int32)
         X = np.array([], dtype=np.float32)
@@ -194,6 +194,48 @@ class TestLoadSave(TestLoadSaveBase):
             if e.errno != errno.ENOENT:
                 raise
 
+    @given(num_threads=st.integers(min_value=1, max_value=4),
+           async_save=st.booleans())
+    def testParallelAndAsyncSave(self, num_threads, async_save):
+        workspace.ResetWorkspace()
+        arrays = [np.random.rand(*shape).astype(np.float32)
+                  for shape in [(2, 3), (0,), (1000,), (7, 1), (1000000,)]]
+        names = [str(i) for i in range(len(arrays))]
+        for name, arr in zip(names, arrays):
+            self.assertTrue(workspace.FeedBlob(name, arr))
+        workspace.FeedBlob("str", b"a string blob")
+
+        tmp_folder = tempfile.mkdtemp()
+        db_name = os.path.join(tmp_folder, "db")
+        net = core.Net("save")
+        net.Save(names + ["str"], [], absolute_path=1, db=db_name,
+                 db_type=self._db_type, num_threads=num_threads,
+                 async_save=int(async_save))
+        # Keep the net, so that an asynchronous save is still running when
+        # RunNet returns.
+        workspace.CreateNet(net)
+        self.assertTrue(workspace.RunNet(net.Name()))
+        # Change the inputs while the save is in flight: the db has to hold
+        # the values at the time of the run.
+        for name, arr in zip(names, arrays):
+            workspace.FeedBlob(name, np.zeros_like(arr))
+        workspace.FeedBlob("str", b"another string")
+        # Destroying the net, and so the Save op, waits for the save to finish.
+        workspace.ResetWorkspace()
+
+        op = core.CreateOperator(
+            "Load", [], names + ["str"], absolute_path=1, db=db_name,
+            db_type=self._db_type)
+        self.assertTrue(workspace.RunOperatorOnce(op))
+        for name, arr in zip(names, arrays):
+            np.testing.assert_array_equal(workspace.FetchBlob(name), arr)
+        self.assertEqual(workspace.FetchBlob("str"), b"a string blob")
+        try:
+            shutil.rmtree(tmp_folder)
+        except OSError as e:
+            if e.errno != errno.ENOENT:
+                raise
+
     def testLoadExcessblobs(self):
         tmp_folder = tempfile.mkdtemp()
         tmp_file, arrays = self.saveFile(tmp_folder, "db", self._db_type, 0)
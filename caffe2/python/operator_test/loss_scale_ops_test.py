@@ -0,0 +1,84 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from caffe2.python import core
+import caffe2.python.hypothesis_test_util as hu
+
+from hypothesis import given
+import hypothesis.strategies as st
+import numpy as np
+import unittest
+
+
+class TestLossScaleOps(hu.HypothesisTestCase):
+    @given(sizes=st.lists(st.sampled_from([0, 1, 7, 40000]),
+                          min_size=1, max_size=4),
+           inf=st.booleans(),
+           **hu.gcs)
+    def test_unscale_gradients(self, sizes, inf, gc, dc):
+        loss_scale = np.array([1024], dtype=np.float32)
+        grads = [(np.random.randn(n) * 1024).astype(np.float32)
+                 for n in sizes]
+        if inf and sizes[-1] > 0:
+            grads[-1][-1] = np.inf
+        names = ["grad_%d" % i for i in range(len(sizes))]
+
+        def ref(loss_scale, *grads):
+            unscaled = [g / loss_scale[0] for g in grads]
+            found_inf = not all(np.isfinite(g).all() for g in unscaled)
+            if found_inf:
+                unscaled = [np.zeros_like(g) for g in unscaled]
+            return unscaled + [np.array([found_inf], dtype=np.float32)]
+
+        op = core.CreateOperator(
+            "UnscaleGradients",
+            ["loss_scale"] + names,
+            names + ["found_inf"],
+        )
+        self.assertReferenceChecks(gc, op, [loss_scale] + grads, ref)
+
+    @given(found_inf=st.booleans(),
+           good_steps=st.integers(min_value=0, max_value=4),
+           **hu.gcs)
+    def test_update_loss_scale(self, found_inf, good_steps, gc, dc):
+        growth_interval = 4
+
+        def ref(loss_scale, good_steps, found_inf):
+            if found_inf[0] > 0:
+                return (np.maximum(loss_scale * 0.5, 1).astype(np.float32),
+                        np.array([0], dtype=np.int32))
+            if good_steps[0] + 1 >= growth_interval:
+                return (loss_scale * 2, np.array([0], dtype=np.int32))
+            return (loss_scale, good_steps + 1)
+
+        op = core.CreateOperator(
+            "UpdateLossScale",
+            ["loss_scale", "good_steps", "found_inf"],
+            ["loss_scale", "good_steps"],
+            growth_interval=growth_interval,
+        )
+        inputs = [np.array([1.5], dtype=np.float32),
+                  np.array([good_steps], dtype=np.int32),
+                  np.array([float(found_inf)], dtype=np.float32)]
+        self.assertReferenceChecks(gc, op, inputs, ref)
+
+
+if __name__ == "__main__":
+    unittest.main()
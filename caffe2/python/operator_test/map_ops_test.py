@@ -45,14 +45,15 @@ class TestMap(hu.HypothesisTestCase):
 
     def test_map(self):
 
-        def test_map_func(KEY_T, VALUE_T):
+        def test_map_func(KEY_T, VALUE_T, flat=False):
             model_file = os.path.join(tempfile.mkdtemp(), 'db')
             key_data = np.asarray([0, 1, 2, 3, 4, 5, 6, 7, 8, 9], dtype=KEY_T)
             value_data = np.asarray([2, 3, 3, 3, 3, 2, 3, 3, 3, 3], dtype=VALUE_T)
             workspace.FeedBlob("key_data", key_data)
             workspace.FeedBlob("value_data", value_data)
             save_net = core.Net("save_net")
-            save_net.KeyValueToMap(["key_data", "value_data"], "map_data")
+            save_net.KeyValueToMap(
+                ["key_data", "value_data"], "map_data", flat=flat)
             save_net.Save(
                 ["map_data"], [],
                 db=model_file,
@@ -79,6 +80,34 @@ class TestMap(hu.HypothesisTestCase):
         test_map_func(np.int64, np.int32)
         test_map_func(np.int32, np.int32)
         test_map_func(np.int32, np.int64)
+        for KEY_T, VALUE_T in itertools.product([np.int32, np.int64], repeat=2):
+            test_map_func(KEY_T, VALUE_T, flat=True)
+
+    def test_map_lookup(self):
+        for KEY_T, flat in itertools.product([np.int32, np.int64], [0, 1]):
+            # The smallest key is the empty slot marker of FlatMap
+            key_data = np.asarray(
+                [np.iinfo(KEY_T).min] + list(range(-500, 1500, 3)),
+                dtype=KEY_T)
+            value_data = np.arange(key_data.size, dtype=np.int64)
+            keys = np.random.randint(-600, 1600, size=(20, 50)).astype(KEY_T)
+            keys[0, :3] = np.iinfo(KEY_T).min
+            workspace.FeedBlob("key_data", key_data)
+            workspace.FeedBlob("value_data", value_data)
+            workspace.FeedBlob("keys", keys)
+            workspace.RunOperatorOnce(core.CreateOperator(
+                "KeyValueToMap", ["key_data", "value_data"], "map", flat=flat))
+            workspace.RunOperatorOnce(core.CreateOperator(
+                "MapLookup", ["map", "keys"], ["values", "found"],
+                default_value=-7))
+
+            table = dict(zip(key_data, value_data))
+            expected = np.vectorize(lambda k: table.get(k, -7))(keys)
+            np.testing.assert_array_equal(
+                workspace.FetchBlob("values"), expected)
+            np.testing.assert_array_equal(
+                workspace.FetchBlob("found"),
+                np.vectorize(lambda k: k in table)(keys))
 
 
 if __name__ == "__main__":
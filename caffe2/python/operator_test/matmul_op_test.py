@@ -150,13 +150,16 @@ class TestBatchMatMul(hu.HypothesisTestCase):
         trans_a=st.booleans(),
         trans_b=st.booleans(),
         dtype=st.sampled_from([np.float32, np.float16]),
+        float16_compute=st.booleans(),
         **hu.gcs
     )
-    def test_batch_matmul(self, C, M, K, N, trans_a, trans_b, dtype, gc, dc):
+    def test_batch_matmul(self, C, M, K, N, trans_a, trans_b, dtype,
+                          float16_compute, gc, dc):
         if dtype == np.float16:
-            # fp16 is only supported with CUDA
-            assume(gc.device_type == caffe2_pb2.CUDA)
-            dc = [d for d in dc if d.device_type == caffe2_pb2.CUDA]
+            # fp16 is only supported with CUDA and HIP
+            assume(gc.device_type in [caffe2_pb2.CUDA, caffe2_pb2.HIP])
+            dc = [d for d in dc
+                  if d.device_type in [caffe2_pb2.CUDA, caffe2_pb2.HIP]]
 
         batch_dims = np.random.randint(
             low=1,
@@ -171,7 +174,8 @@ class TestBatchMatMul(hu.HypothesisTestCase):
             Y = Y.swapaxes(-1, -2)
 
         op = core.CreateOperator(
-            'BatchMatMul', ['X', 'Y'], 'out', trans_a=trans_a, trans_b=trans_b
+            'BatchMatMul', ['X', 'Y'], 'out', trans_a=trans_a, trans_b=trans_b,
+            float16_compute=int(float16_compute)
         )
 
         def matmul_ref(X, Y, trans_a, trans_b, dtype):
@@ -19,11 +19,13 @@ from __future__ import print_function
 from __future__ import unicode_literals
 
 import numpy as np
+import unittest
 
 from hypothesis import given
 import hypothesis.strategies as st
 
-from caffe2.python import core
+from caffe2.proto import caffe2_pb2
+from caffe2.python import core, workspace
 import caffe2.python.hypothesis_test_util as hu
 
 import hypothesis.extra.numpy as hnp
@@ -97,3 +99,18 @@ class TestMergeIdListsOp(hu.HypothesisTestCase):
         )
         self.assertDeviceChecks(dc, op, inputs, [0])
         self.assertReferenceChecks(gc, op, inputs, merge_id_lists_ref)
+
+    @unittest.skipIf(not workspace.has_hip, "No HIP support.")
+    @given(inputs=id_list_batch())
+    def test_merge_id_lists_op_hip(self, inputs):
+        num_inputs = int(len(inputs) / 2)
+        op = core.CreateOperator(
+            "MergeIdLists",
+            ["{prefix}_{i}".format(prefix=p, i=i)
+                for i in range(num_inputs)
+                for p in ["lengths", "values"]],
+            ["merged_lengths", "merged_values"]
+        )
+        dc = [core.DeviceOption(caffe2_pb2.CPU),
+              core.DeviceOption(caffe2_pb2.HIP, 0)]
+        self.assertDeviceChecks(dc, op, inputs, [0, 1])
@@ -0,0 +1,170 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from caffe2.proto import caffe2_pb2
+from caffe2.python import core, workspace
+from hypothesis import given
+import caffe2.python.hypothesis_test_util as hu
+import hypothesis.strategies as st
+import numpy as np
+
+
+class TestMetricAccumulators(hu.HypothesisTestCase):
+    def _run_batches(self, gc, ops, batches, fetch):
+        # The accumulators keep their state in their outputs, so the batches
+        # are fed one at a time to the same net.
+        net = core.Net("metric_accumulators")
+        for op in ops:
+            op.device_option.CopyFrom(gc)
+        net.Proto().op.extend(ops)
+        workspace.ResetWorkspace()
+        for name, value in batches[0].items():
+            workspace.FeedBlob(name, value, device_option=gc)
+        workspace.CreateNet(net)
+        results = []
+        for batch in batches:
+            for name, value in batch.items():
+                workspace.FeedBlob(name, value, device_option=gc)
+            workspace.RunNet(net.Name())
+            results.append([workspace.FetchBlob(name) for name in fetch])
+        return results
+
+    @given(num_batches=st.integers(1, 3),
+           N=st.integers(0, 10),
+           D=st.integers(1, 5),
+           top_k=st.integers(1, 3),
+           **hu.gcs)
+    def test_accumulate_accuracy(self, num_batches, N, D, top_k, gc, dc):
+        batches = [{
+            "prediction": np.random.rand(N, D).astype(np.float32),
+            "labels": np.random.randint(D, size=N).astype(np.int32),
+        } for _ in range(num_batches)]
+        op = core.CreateOperator(
+            "AccumulateAccuracy",
+            ["prediction", "labels"],
+            ["accuracy", "counts"],
+            top_k=top_k,
+        )
+        results = self._run_batches(
+            gc, [op], batches, ["accuracy", "counts"])
+
+        correct = 0
+        total = 0
+        for batch, (accuracy, counts) in zip(batches, results):
+            ranks = np.argsort(-batch["prediction"], axis=1, kind='mergesort')
+            correct += sum(
+                label in ranks[i, :top_k]
+                for i, label in enumerate(batch["labels"]))
+            total += N
+            np.testing.assert_array_equal(counts, [correct, total])
+            np.testing.assert_allclose(
+                accuracy, correct / total if total else 0, rtol=1e-5)
+
+    @given(num_batches=st.integers(1, 3),
+           N=st.integers(0, 10),
+           **hu.gcs)
+    def test_accumulate_perplexity(self, num_batches, N, gc, dc):
+        batches = [{
+            "probabilities":
+                np.random.uniform(0.01, 1, size=N).astype(np.float32),
+        } for _ in range(num_batches)]
+        op = core.CreateOperator(
+            "AccumulatePerplexity",
+            ["probabilities"],
+            ["perplexity", "sums"],
+        )
+        results = self._run_batches(
+            gc, [op], batches, ["perplexity", "sums"])
+
+        probabilities = np.empty(0)
+        for batch, (perplexity, sums) in zip(batches, results):
+            probabilities = np.concatenate(
+                [probabilities, batch["probabilities"]])
+            np.testing.assert_allclose(
+                sums, [-np.log(probabilities).sum(), len(probabilities)],
+                rtol=1e-4, atol=1e-4)
+            expected = np.exp(-np.log(probabilities).mean()) \
+                if len(probabilities) else 1
+            np.testing.assert_allclose(perplexity, expected, rtol=1e-4)
+
+    @given(num_batches=st.integers(1, 3),
+           N=st.integers(0, 10),
+           D=st.integers(1, 5),
+           **hu.gcs)
+    def test_accumulate_multi_class_accuracy(self, num_batches, N, D, gc, dc):
+        batches = [{
+            "prediction": np.random.rand(N, D).astype(np.float32),
+            "labels": np.random.randint(D, size=N).astype(np.int32),
+        } for _ in range(num_batches)]
+        op = core.CreateOperator(
+            "AccumulateMultiClassAccuracy",
+            ["prediction", "labels"],
+            ["accuracies", "amounts", "correct"],
+        )
+        results = self._run_batches(
+            gc, [op], batches, ["accuracies", "amounts", "correct"])
+
+        amounts = np.zeros(D, dtype=np.int64)
+        correct = np.zeros(D, dtype=np.int64)
+        for batch, (accuracies, out_amounts, out_correct) in zip(
+                batches, results):
+            max_ids = np.argmax(batch["prediction"], axis=1)
+            for max_id, label in zip(max_ids, batch["labels"]):
+                amounts[label] += 1
+                correct[label] += max_id == label
+            np.testing.assert_array_equal(out_amounts, amounts)
+            np.testing.assert_array_equal(out_correct, correct)
+            np.testing.assert_allclose(
+                accuracies, correct / np.maximum(amounts, 1), rtol=1e-5)
+
+    @given(num_batches=st.integers(2, 4),
+           N=st.integers(1, 10),
+           **hu.gcs)
+    def test_async_copy_to_host(self, num_batches, N, gc, dc):
+        batches = [{
+            "labels": np.zeros(N, dtype=np.int32),
+            "prediction": np.random.rand(N, 2).astype(np.float32),
+        } for _ in range(num_batches)]
+        ops = [
+            core.CreateOperator(
+                "AccumulateAccuracy",
+                ["prediction", "labels"],
+                ["accuracy", "counts"],
+            ),
+            core.CreateOperator(
+                "AsyncCopyToHost", ["counts"], ["counts_host"]),
+        ]
+        results = self._run_batches(
+            gc, ops, batches, ["counts", "counts_host"])
+
+        # The host copy can lag behind, but always holds the counts of one of
+        # the runs so far.
+        seen = []
+        for counts, counts_host in results:
+            seen.append(list(counts))
+            if counts_host.size:
+                self.assertIn(list(counts_host), seen)
+        if gc.device_type == caffe2_pb2.CPU:
+            np.testing.assert_array_equal(results[-1][1], results[-1][0])
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
@@ -0,0 +1,201 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from caffe2.python import core, workspace
+import caffe2.python.hypothesis_test_util as hu
+
+from hypothesis import given
+import hypothesis.strategies as st
+import numpy as np
+import unittest
+
+
+def _momentum_sgd(grad, moment, param, lr, momentum, nesterov):
+    if not nesterov:
+        ng = lr * grad + momentum * moment
+        return ng, ng, param - ng
+    m_new = momentum * moment + lr * grad
+    ng = (1 + momentum) * m_new - momentum * moment
+    return ng, m_new, param - ng
+
+
+def _adam(param, mom1, mom2, grad, lr, it, beta1, beta2, epsilon):
+    t = it + 1
+    rate = lr * np.sqrt(1 - np.power(beta2, t)) / (1 - np.power(beta1, t))
+    mom1_out = beta1 * mom1 + (1 - beta1) * grad
+    mom2_out = beta2 * mom2 + (1 - beta2) * np.square(grad)
+    param_out = param + rate * mom1_out / (np.sqrt(mom2_out) + epsilon)
+    return param_out, mom1_out, mom2_out
+
+
+class TestMultiTensorSGD(hu.HypothesisTestCase):
+    # sizes include a zero sized blob and blobs spanning several chunks
+    @given(sizes=st.lists(st.sampled_from([0, 1, 7, 100, 40000]),
+                          min_size=1, max_size=5),
+           nesterov=st.booleans(),
+           **hu.gcs)
+    def test_multi_tensor_momentum_sgd(self, sizes, nesterov, gc, dc):
+        momentum = 0.9
+        lr = np.random.rand(1).astype(np.float32)
+        inputs = [lr]
+        names = ["lr"]
+        outputs = []
+        for i, n in enumerate(sizes):
+            inputs += [np.random.rand(n).astype(np.float32) for _ in range(3)]
+            blobs = ["grad_%d" % i, "moment_%d" % i, "param_%d" % i]
+            names += blobs
+            outputs += blobs
+
+        def ref(lr, *args):
+            res = []
+            for i in range(0, len(args), 3):
+                res += _momentum_sgd(
+                    args[i], args[i + 1], args[i + 2], lr, momentum, nesterov)
+            return res
+
+        op = core.CreateOperator(
+            "MultiTensorMomentumSGDUpdate",
+            names,
+            outputs,
+            momentum=momentum,
+            nesterov=int(nesterov),
+        )
+        self.assertReferenceChecks(gc, op, inputs, ref)
+
+    @given(sizes=st.lists(st.sampled_from([1, 7, 40000]),
+                          min_size=1, max_size=3),
+           **hu.gcs)
+    def test_multi_tensor_momentum_sgd_fp16_master(self, sizes, gc, dc):
+        momentum = 0.9
+        lr = np.random.rand(1).astype(np.float32)
+        inputs = [lr]
+        names = ["lr"]
+        outputs = []
+        for i, n in enumerate(sizes):
+            master = np.random.rand(n).astype(np.float32)
+            inputs += [
+                np.random.rand(n).astype(np.float16),
+                np.random.rand(n).astype(np.float32),
+                master.astype(np.float16),
+                master,
+            ]
+            blobs = ["grad_%d" % i, "moment_%d" % i, "param_%d" % i,
+                     "master_%d" % i]
+            names += blobs
+            outputs += blobs
+
+        def ref(lr, *args):
+            res = []
+            for i in range(0, len(args), 4):
+                ng, m, w = _momentum_sgd(
+                    args[i].astype(np.float32), args[i + 1], args[i + 3],
+                    lr, momentum, False)
+                res += [ng.astype(np.float16), m, w.astype(np.float16), w]
+            return res
+
+        op = core.CreateOperator(
+            "MultiTensorMomentumSGDUpdate",
+            names,
+            outputs,
+            momentum=momentum,
+            master_weights=1,
+        )
+        self.assertReferenceChecks(gc, op, inputs, ref, threshold=1e-2)
+
+    @given(sizes=st.lists(st.sampled_from([0, 1, 7, 100, 40000]),
+                          min_size=1, max_size=5),
+           it=st.integers(min_value=0, max_value=10000),
+           master_weights=st.booleans(),
+           **hu.gcs)
+    def test_multi_tensor_adam(self, sizes, it, master_weights, gc, dc):
+        beta1, beta2, epsilon = 0.9, 0.999, 1e-5
+        lr = np.random.rand(1).astype(np.float32)
+        it = np.array([it], dtype=np.int64)
+        inputs = [lr, it]
+        names = ["lr", "iter"]
+        outputs = []
+        for i, n in enumerate(sizes):
+            param = np.random.rand(n).astype(np.float32)
+            inputs += [param,
+                       np.random.rand(n).astype(np.float32),
+                       np.random.rand(n).astype(np.float32),
+                       np.random.randn(n).astype(np.float32)]
+            names += ["param_%d" % i, "mom1_%d" % i, "mom2_%d" % i,
+                      "grad_%d" % i]
+            outputs += ["param_%d" % i, "mom1_%d" % i, "mom2_%d" % i]
+            if master_weights:
+                inputs.append(param.copy())
+                names.append("master_%d" % i)
+                outputs.append("master_%d" % i)
+        group = 5 if master_weights else 4
+
+        def ref(lr, it, *args):
+            res = []
+            for i in range(0, len(args), group):
+                param_out, mom1_out, mom2_out = _adam(
+                    args[i], args[i + 1], args[i + 2], args[i + 3], lr, it,
+                    beta1, beta2, epsilon)
+                res += [param_out, mom1_out, mom2_out]
+                if master_weights:
+                    res.append(param_out)
+            return res
+
+        op = core.CreateOperator(
+            "MultiTensorAdam",
+            names,
+            outputs,
+            beta1=beta1,
+            beta2=beta2,
+            epsilon=epsilon,
+            master_weights=int(master_weights),
+        )
+        # Iter lives on the CPU
+        self.assertReferenceChecks(
+            gc, op, inputs, ref, input_device_options={'iter': hu.cpu_do})
+
+    def test_multi_tensor_adam_master_weights_inplace(self):
+        names = ["lr", "iter"]
+        outputs = []
+        for i in range(2):
+            names += ["param_%d" % i, "mom1_%d" % i, "mom2_%d" % i,
+                      "grad_%d" % i, "master_%d" % i]
+            outputs += ["param_%d" % i, "mom1_%d" % i, "mom2_%d" % i,
+                        "master_%d" % i]
+        workspace.FeedBlob("lr", np.array([0.1], dtype=np.float32))
+        workspace.FeedBlob("iter", np.array([0], dtype=np.int64))
+        for name in names[2:]:
+            workspace.FeedBlob(name, np.random.rand(3).astype(np.float32))
+        self.assertTrue(workspace.RunOperatorOnce(core.CreateOperator(
+            "MultiTensorAdam", names, outputs, master_weights=1)))
+        np.testing.assert_array_equal(
+            workspace.FetchBlob("param_1"), workspace.FetchBlob("master_1"))
+
+        # Without master weights, input 10 and output 6 would both be
+        # param_2, so the schema lets them share a blob; with master weights
+        # they are grad_1 and mom2_1, which must not.
+        outputs[6] = "grad_1"
+        with self.assertRaises(RuntimeError):
+            workspace.RunOperatorOnce(core.CreateOperator(
+                "MultiTensorAdam", names, outputs, master_weights=1))
+
+
+
+if __name__ == "__main__":
+    unittest.main()
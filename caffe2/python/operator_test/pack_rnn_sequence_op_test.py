@@ -18,11 +18,13 @@ from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
 
-from caffe2.python import core
+from caffe2.proto import caffe2_pb2
+from caffe2.python import core, workspace
 from hypothesis import given
 import caffe2.python.hypothesis_test_util as hu
 import hypothesis.strategies as st
 import numpy as np
+import unittest
 
 
 class TestPackRNNSequenceOperator(hu.HypothesisTestCase):
@@ -100,6 +102,27 @@ class TestPackRNNSequenceOperator(hu.HypothesisTestCase):
         self.assertGradientChecks(gc, op, [values, lengths], 0, [0])
 
 
+    @unittest.skipIf(not workspace.has_hip, "No HIP support.")
+    @given(n=st.integers(0, 10), k=st.integers(1, 5),
+           dim=st.integers(1, 5), forward=st.booleans())
+    def test_pack_rnn_sequence_hip(self, n, k, dim, forward):
+        lengths = np.random.randint(k, size=n).astype(np.int32) + 1
+        if forward:
+            values = np.random.rand(sum(lengths), dim).astype(np.float32)
+        else:
+            T = max(lengths) if any(lengths) else 0
+            values = np.random.rand(T, n, dim).astype(np.float32)
+
+        op = core.CreateOperator(
+            'PackRNNSequence' if forward else 'UnpackRNNSequence',
+            ['values', 'lengths'],
+            'out'
+        )
+        dc = [core.DeviceOption(caffe2_pb2.CPU),
+              core.DeviceOption(caffe2_pb2.HIP, 0)]
+        self.assertDeviceChecks(dc, op, [values, lengths], [0])
+        self.assertGradientChecks(dc[1], op, [values, lengths], 0, [0])
+
+
 if __name__ == "__main__":
-    import unittest
     unittest.main()
@@ -116,6 +116,33 @@ class TestPartitionOps(TestCase):
                     np.testing.assert_array_equal(expected, actual)
 
 
+    def testPartitionLargeInput(self):
+        # Enough keys for several chunks, each histogrammed and scattered on
+        # its own thread, and many shards.
+        parts = 67
+        n = 50000
+        keys = np.random.randint(-10**6, 10**6, n).astype(np.int64)
+        values = rand_array(n, 3)
+        workspace.FeedBlob('keys', keys)
+        workspace.FeedBlob('values', values)
+        outs = []
+        for i in range(parts):
+            outs += ['keys_p{}'.format(i), 'values_p{}'.format(i)]
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'Partition', ['keys', 'values'], outs))
+
+        shards = keys % parts
+        for i in range(parts):
+            np.testing.assert_array_equal(
+                keys[shards == i], workspace.FetchBlob(outs[2 * i]))
+            np.testing.assert_array_equal(
+                values[shards == i], workspace.FetchBlob(outs[2 * i + 1]))
+
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'GatherByKey', ['keys'] + outs[1::2], 'values_gathered'))
+        np.testing.assert_array_equal(
+            values, workspace.FetchBlob('values_gathered'))
+
     def testLengthsPartition(self):
         for main_dims, parts, main_type, extra_ins, pack in self.test_configs():
             # For LengthsSharding only 1-D tensors supported as a first input
@@ -0,0 +1,93 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from caffe2.python import core
+import caffe2.python.hypothesis_test_util as hu
+
+from hypothesis import given
+import hypothesis.strategies as st
+import numpy as np
+import unittest
+
+
+def _sigmoid(x):
+    return 1. / (1. + np.exp(-x))
+
+
+def _persistent_lstm(gates_input, hidden, cell, weight, seq_lengths,
+                     forget_bias):
+    D = hidden.shape[2]
+    hidden_all = []
+    for t in range(gates_input.shape[0]):
+        gates = gates_input[t] + hidden[0].dot(weight.T)
+        i = _sigmoid(gates[:, :D])
+        f = _sigmoid(gates[:, D:2 * D] + forget_bias)
+        o = _sigmoid(gates[:, 2 * D:3 * D])
+        g = np.tanh(gates[:, 3 * D:])
+        c = f * cell[0] + i * g
+        h = o * np.tanh(c)
+        valid = (t < seq_lengths)[:, None]
+        hidden = np.where(valid, h, hidden[0])[None]
+        cell = np.where(valid, c, cell[0])[None]
+        hidden_all.append(hidden[0])
+    hidden_all = np.array(hidden_all, dtype=np.float32).reshape(
+        gates_input.shape[0], gates_input.shape[1], D)
+    return hidden_all, hidden, cell
+
+
+class TestPersistentLSTM(hu.HypothesisTestCase):
+    @given(T=st.integers(0, 6),
+           N=st.integers(1, 8),
+           D=st.integers(1, 70),
+           forget_bias=st.floats(0, 1),
+           use_seq_lengths=st.booleans(),
+           **hu.gcs)
+    def test_persistent_lstm(self, T, N, D, forget_bias, use_seq_lengths,
+                             gc, dc):
+        gates_input = np.random.randn(T, N, 4 * D).astype(np.float32)
+        hidden = np.random.randn(1, N, D).astype(np.float32)
+        cell = np.random.randn(1, N, D).astype(np.float32)
+        weight = (np.random.randn(4 * D, D) / np.sqrt(D)).astype(np.float32)
+        seq_lengths = np.random.randint(0, T + 1, size=N).astype(np.int32)
+        inputs = [gates_input, hidden, cell, weight]
+        names = ["gates_input", "hidden", "cell", "weight"]
+        if use_seq_lengths:
+            inputs.append(seq_lengths)
+            names.append("seq_lengths")
+        else:
+            seq_lengths = np.full(N, T, dtype=np.int32)
+
+        op = core.CreateOperator(
+            "PersistentLSTM",
+            names,
+            ["hidden_all", "hidden_output", "cell_output"],
+            forget_bias=forget_bias,
+        )
+
+        def ref(*args):
+            return _persistent_lstm(
+                gates_input, hidden, cell, weight, seq_lengths, forget_bias)
+
+        self.assertReferenceChecks(gc, op, inputs, ref, threshold=1e-3)
+        self.assertDeviceChecks(dc, op, inputs, [0, 1, 2])
+
+
+if __name__ == "__main__":
+    unittest.main()
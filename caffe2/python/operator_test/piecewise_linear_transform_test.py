@@ -73,6 +73,33 @@ class TestPiecewiseLinearTransform(hu.HypothesisTestCase):
         self.assertReferenceChecks(gc, op, [X], piecewise)
         self.assertDeviceChecks(dc, op, [X], [0])
 
+    @given(n=st.integers(1, 40), m=st.integers(1, 40), **hu.gcs)
+    def test_wide_predictions_params_from_input(self, n, m, gc, dc):
+        # Rows wide enough for the vectorized CPU kernel and its tail, with
+        # both scanned and binary searched numbers of pieces.
+        slopes = np.random.uniform(-1, 1, (m, n)).astype(np.float32)
+        intercepts = np.random.uniform(-1, 1, (m, n)).astype(np.float32)
+        bounds = np.random.uniform(0.1, 0.9,
+                                   (m, n + 1)).astype(np.float32)
+        bounds.sort()
+        X = np.random.uniform(0, 1, (2 * n + 1, m)).astype(np.float32)
+
+        op = core.CreateOperator(
+            "PiecewiseLinearTransform",
+            ["X", "bounds", "slopes", "intercepts"],
+            ["Y"],
+        )
+
+        def piecewise(x, bounds, slopes, intercepts):
+            return [np.vstack([
+                self.transform(
+                    x[:, j], bounds[j, :], slopes[j, :], intercepts[j, :])
+                for j in range(m)]).transpose()]
+
+        self.assertReferenceChecks(
+            gc, op, [X, bounds, slopes, intercepts], piecewise)
+        self.assertDeviceChecks(dc, op, [X, bounds, slopes, intercepts], [0])
+
     @given(n=st.integers(1, 100), **hu.gcs)
     def test_binary_predictions_params_from_arg(self, n, gc, dc):
         slopes = np.random.uniform(-1, 1, size=n).astype(np.float32)
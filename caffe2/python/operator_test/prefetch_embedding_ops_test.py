@@ -0,0 +1,89 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import numpy as np
+
+from hypothesis import given
+import hypothesis.strategies as st
+
+from caffe2.python import core
+from caffe2.python import workspace
+import caffe2.python.hypothesis_test_util as hu
+
+
+def sparse_lengths_sum(table, indices, lengths):
+    out = np.zeros((len(lengths),) + table.shape[1:], dtype=np.float32)
+    offset = 0
+    for i, length in enumerate(lengths):
+        out[i] = table[indices[offset:offset + length]].sum(axis=0)
+        offset += length
+    return out
+
+
+class TestPrefetchEmbeddingOps(hu.HypothesisTestCase):
+    @given(
+        rows=st.integers(min_value=1, max_value=100),
+        dim=st.integers(min_value=1, max_value=16),
+        batch=st.integers(min_value=0, max_value=20),
+        num_threads=st.integers(min_value=1, max_value=4),
+        index_type=st.sampled_from([np.int32, np.int64]),
+        **hu.gcs
+    )
+    def test_pipelined_lookups(self, rows, dim, batch, num_threads,
+                               index_type, gc, dc):
+        table = np.random.rand(rows, dim).astype(np.float32)
+        # The inputs stay on the host, only the pooled embeddings are on gc.
+        workspace.FeedBlob("table", table)
+        prefetch = core.CreateOperator(
+            "PrefetchSparseLengthsSum", ["table", "indices", "lengths"],
+            ["prefetched"], num_threads=num_threads, device_option=gc)
+        wait = core.CreateOperator(
+            "WaitSparseLengthsSum", ["prefetched"], ["pooled", "prefetched"],
+            device_option=gc)
+
+        def feed_batch():
+            lengths = np.random.randint(0, 5, size=batch).astype(np.int32)
+            indices = np.random.randint(
+                0, rows, size=lengths.sum()).astype(index_type)
+            workspace.FeedBlob("indices", indices)
+            workspace.FeedBlob("lengths", lengths)
+            return sparse_lengths_sum(table, indices, lengths)
+
+        expected = feed_batch()
+        workspace.RunOperatorOnce(prefetch)
+        for _ in range(3):
+            # The inputs of the next batch are fed while the lookup runs.
+            next_expected = feed_batch()
+            workspace.RunOperatorOnce(wait)
+            np.testing.assert_allclose(
+                workspace.FetchBlob("pooled"), expected, rtol=1e-5)
+            workspace.RunOperatorOnce(prefetch)
+            expected = next_expected
+        workspace.RunOperatorOnce(wait)
+        np.testing.assert_allclose(
+            workspace.FetchBlob("pooled"), expected, rtol=1e-5)
+
+        # Every batch is taken once.
+        with self.assertRaises(RuntimeError):
+            workspace.RunOperatorOnce(wait)
+
+    @given(**hu.gcs)
+    def test_bad_index(self, gc, dc):
+        workspace.FeedBlob("table", np.random.rand(10, 4).astype(np.float32))
+        workspace.FeedBlob("indices", np.array([3, 10], dtype=np.int32))
+        workspace.FeedBlob("lengths", np.array([2], dtype=np.int32))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "PrefetchSparseLengthsSum", ["table", "indices", "lengths"],
+            ["prefetched"], device_option=gc))
+        # The error of the lookup threads is raised by the wait.
+        with self.assertRaises(RuntimeError):
+            workspace.RunOperatorOnce(core.CreateOperator(
+                "WaitSparseLengthsSum", ["prefetched"],
+                ["pooled", "prefetched"], device_option=gc))
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
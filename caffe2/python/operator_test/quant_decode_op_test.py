@@ -0,0 +1,73 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from caffe2.python import core
+from hypothesis import given
+import caffe2.python.hypothesis_test_util as hu
+import hypothesis.strategies as st
+import numpy as np
+
+
+class TestQuantDecodeOp(hu.HypothesisTestCase):
+
+    @given(cb_size=st.sampled_from([3, 256, 5000]),
+           code_type=st.sampled_from([np.uint8, np.uint16, np.int32]),
+           sizes=st.lists(st.integers(0, 2000), min_size=1, max_size=3),
+           **hu.gcs)
+    def test_quant_decode(self, cb_size, code_type, sizes, gc, dc):
+        cb_size = min(cb_size, np.iinfo(code_type).max + 1)
+        codebook = np.random.randn(cb_size).astype(np.float32)
+        codes = [np.random.randint(0, cb_size, size=n).astype(code_type)
+                 for n in sizes]
+        code_names = ["codes_{}".format(i) for i in range(len(codes))]
+        op = core.CreateOperator(
+            "QuantDecode",
+            ["codebook"] + code_names,
+            ["decoded_{}".format(i) for i in range(len(codes))])
+
+        def quant_decode_ref(codebook, *codes):
+            return [codebook[c] for c in codes]
+
+        self.assertReferenceChecks(
+            gc, op, [codebook] + codes, quant_decode_ref)
+        self.assertDeviceChecks(
+            dc, op, [codebook] + codes, list(range(len(codes))))
+
+        grads = [np.random.randn(n).astype(np.float32) for n in sizes]
+        grad_op = core.CreateOperator(
+            "QuantDecodeGradient",
+            ["codebook"] + code_names +
+            ["grad_{}".format(i) for i in range(len(codes))],
+            ["codebook_grad"])
+
+        def quant_decode_gradient_ref(codebook, *inputs):
+            cb_grad = np.zeros_like(codebook)
+            for c, g in zip(inputs[:len(codes)], inputs[len(codes):]):
+                np.add.at(cb_grad, c.astype(np.int64), g)
+            return [cb_grad]
+
+        self.assertReferenceChecks(
+            gc, grad_op, [codebook] + codes + grads,
+            quant_decode_gradient_ref, threshold=1e-3)
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
@@ -180,6 +180,41 @@ class TestReBatchingQueue(TestCase):
                 workspace.FetchBlob(tensors[idx])[:5]
             )
 
+    def test_rebatching_queue_dynamic_batching(self):
+        net = core.Net('net')
+        workspace.FeedBlob("request_0", np.array([0, 1, 2], np.int32))
+        workspace.FeedBlob("request_1", np.array([3, 4], np.int32))
+
+        queue = net.CreateRebatchingQueue([], 1, capacity=10, num_blobs=1)
+        ids = [
+            net.EnqueueRebatchingQueue(
+                [queue, "request_0"], 1, enqueue_batch=True),
+            net.EnqueueRebatchingQueue(
+                [queue, "request_1"], 1, enqueue_batch=True),
+        ]
+
+        # 4 rows of int32 would be over the budget
+        bytes_limited = net.DequeueRebatchingQueue(
+            [queue], 2, num_elements=5, max_bytes=12, output_request_ids=True)
+        # Only 2 rows are left, the latency bound makes us return them
+        latency_limited = net.DequeueRebatchingQueue(
+            [queue], 2, num_elements=5, max_latency_ms=10,
+            output_request_ids=True)
+
+        workspace.RunNetOnce(net)
+
+        id_0 = workspace.FetchBlob(ids[0])
+        id_1 = workspace.FetchBlob(ids[1])
+        self.assertNotEqual(id_0, id_1)
+        npt.assert_array_equal(
+            workspace.FetchBlob(bytes_limited[0]), [0, 1, 2])
+        npt.assert_array_equal(
+            workspace.FetchBlob(bytes_limited[1]), [id_0] * 3)
+        npt.assert_array_equal(
+            workspace.FetchBlob(latency_limited[0]), [3, 4])
+        npt.assert_array_equal(
+            workspace.FetchBlob(latency_limited[1]), [id_1] * 2)
+
     @given(
         num_producers=st.integers(1, 5),
         num_consumers=st.integers(1, 5),
@@ -148,3 +148,89 @@ class TestReduceFrontReductions(hu.HypothesisTestCase):
             return [np.mean(X, axis=(0, 1, 2, 3)[4 - num_reduce_dim:])]
 
         self.reduce_op_test("ReduceBackMean", ref_sum, X, num_reduce_dim, gc)
+
+    @given(shape=st.sampled_from([(2, 20000), (20000, 3), (40, 300)]),
+           front=st.booleans(),
+           mean=st.booleans(),
+           **hu.gcs)
+    def test_reduce_long_rows_and_columns(self, shape, front, mean, gc, dc):
+        # Few long rows or columns are split across blocks on the GPU.
+        X = np.random.rand(*shape).astype(np.float32)
+        op_name = "Reduce{}{}".format(
+            "Front" if front else "Back", "Mean" if mean else "Sum")
+        axis = 0 if front else 1
+
+        def ref(X):
+            return [np.mean(X, axis=axis) if mean else np.sum(X, axis=axis)]
+
+        op = core.CreateOperator(op_name, ["X"], ["Y"], num_reduce_dim=1)
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=op,
+            inputs=[X],
+            reference=ref,
+            threshold=1e-3,
+        )
+        self.assertDeviceChecks(dc, op, [X], [0])
+
+
+class TestReduceOps(hu.HypothesisTestCase):
+
+    @given(shape=st.lists(st.integers(1, 5), min_size=1, max_size=4),
+           keepdims=st.booleans(),
+           mean=st.booleans(),
+           data=st.data(),
+           **hu.gcs)
+    def test_reduce_axes(self, shape, keepdims, mean, data, gc, dc):
+        ndim = len(shape)
+        axes = data.draw(st.lists(
+            st.integers(0, ndim - 1), max_size=ndim, unique=True))
+        X = np.random.rand(*shape).astype(np.float32)
+        op = core.CreateOperator(
+            "ReduceMean" if mean else "ReduceSum",
+            ["X"],
+            ["Y"],
+            axes=axes,
+            keepdims=int(keepdims),
+        )
+
+        def ref(X):
+            reduce_axes = tuple(axes) if axes else None
+            f = np.mean if mean else np.sum
+            return [np.array(f(X, axis=reduce_axes, keepdims=keepdims))]
+
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=op,
+            inputs=[X],
+            reference=ref,
+        )
+        self.assertDeviceChecks(dc, op, [X], [0])
+        self.assertGradientChecks(
+            gc, op, [X], 0, [0], stepsize=1e-2, threshold=1e-2)
+
+    @given(mean=st.booleans(), **hu.gcs)
+    def test_reduce_interleaved_axes(self, mean, gc, dc):
+        # Two reduced runs with kept dims between them take two passes.
+        X = np.random.rand(3, 4, 70, 5, 2).astype(np.float32)
+        axes = [0, 2, 4]
+        op = core.CreateOperator(
+            "ReduceMean" if mean else "ReduceSum",
+            ["X"],
+            ["Y"],
+            axes=axes,
+            keepdims=0,
+        )
+
+        def ref(X):
+            f = np.mean if mean else np.sum
+            return [f(X, axis=tuple(axes))]
+
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=op,
+            inputs=[X],
+            reference=ref,
+            threshold=1e-3,
+        )
+        self.assertDeviceChecks(dc, op, [X], [0])
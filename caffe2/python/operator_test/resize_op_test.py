@@ -21,7 +21,7 @@ import numpy as np
 import hypothesis.strategies as st
 import unittest
 import caffe2.python.hypothesis_test_util as hu
-from caffe2.python import core
+from caffe2.python import core, workspace
 from hypothesis import given
 
 
@@ -117,6 +117,126 @@ class TestResize(hu.HypothesisTestCase):
         self.assertDeviceChecks(dc, op, [dY, X], [0])
         self.assertReferenceChecks(gc, op, [dY, X], ref)
 
+    @given(height_scale=st.floats(0.25, 4.0) | st.just(2.0),
+           width_scale=st.floats(0.25, 4.0) | st.just(2.0),
+           height=st.integers(4, 16),
+           width=st.integers(4, 16),
+           num_channels=st.integers(1, 8),
+           batch_size=st.integers(1, 2),
+           seed=st.integers(0, 65535),
+           **hu.gcs)
+    def test_nearest_nhwc(self, height_scale, width_scale, height, width,
+                          num_channels, batch_size, seed, gc, dc):
+        np.random.seed(seed)
+        X = np.random.rand(
+            batch_size, num_channels, height, width).astype(np.float32)
+        nchw_op = core.CreateOperator(
+            "ResizeNearest", ["X"], ["Y"],
+            width_scale=width_scale, height_scale=height_scale,
+            device_option=gc)
+        self.ws.create_blob("X").feed(X, device_option=gc)
+        self.ws.run(nchw_op)
+        Y = self.ws.blobs["Y"].fetch()
+
+        op = core.CreateOperator(
+            "ResizeNearest", ["X"], ["Y"],
+            width_scale=width_scale, height_scale=height_scale,
+            order="NHWC")
+
+        def ref(X_nhwc):
+            return Y.transpose(0, 2, 3, 1),
+
+        X_nhwc = X.transpose(0, 2, 3, 1).copy()
+        self.assertReferenceChecks(gc, op, [X_nhwc], ref)
+        self.assertDeviceChecks(dc, op, [X_nhwc], [0])
+        self.assertGradientChecks(
+            gc, op, [X_nhwc], 0, [0], stepsize=0.1, threshold=1e-2)
+
+    @given(height_scale=st.floats(0.25, 4.0) | st.just(2.0),
+           width_scale=st.floats(0.25, 4.0) | st.just(2.0),
+           height=st.integers(4, 16),
+           width=st.integers(4, 16),
+           num_channels=st.integers(1, 8),
+           batch_size=st.integers(1, 2),
+           align_corners=st.booleans(),
+           order=st.sampled_from(["NCHW", "NHWC"]),
+           seed=st.integers(0, 65535),
+           **hu.gcs)
+    def test_bilinear(self, height_scale, width_scale, height, width,
+                      num_channels, batch_size, align_corners, order, seed,
+                      gc, dc):
+        np.random.seed(seed)
+        op = core.CreateOperator(
+            "ResizeBilinear",
+            ["X"],
+            ["Y"],
+            width_scale=width_scale,
+            height_scale=height_scale,
+            align_corners=align_corners,
+            order=order,
+        )
+
+        X = np.random.rand(
+            batch_size, num_channels, height, width).astype(np.float32)
+        if order == "NHWC":
+            X = X.transpose(0, 2, 3, 1).copy()
+
+        def taps(in_size, out_size, scale):
+            dst = np.arange(out_size, dtype=np.float32)
+            if align_corners:
+                ratio = (in_size - 1) / (out_size - 1) if out_size > 1 else 0
+                src = dst * ratio
+            else:
+                src = (dst + 0.5) / scale - 0.5
+            src = np.maximum(src, 0)
+            lo = np.minimum(src.astype(np.int32), in_size - 1)
+            hi = np.minimum(lo + 1, in_size - 1)
+            return lo, hi, np.minimum(src - lo, 1)
+
+        def ref(X):
+            X_nchw = X if order == "NCHW" else X.transpose(0, 3, 1, 2)
+            y0, y1, ly = taps(
+                height, np.int32(height * height_scale), height_scale)
+            x0, x1, lx = taps(
+                width, np.int32(width * width_scale), width_scale)
+            ly = ly[:, None]
+            top = (X_nchw[:, :, y0][:, :, :, x0] * (1 - lx) +
+                   X_nchw[:, :, y0][:, :, :, x1] * lx)
+            bottom = (X_nchw[:, :, y1][:, :, :, x0] * (1 - lx) +
+                      X_nchw[:, :, y1][:, :, :, x1] * lx)
+            Y = top * (1 - ly) + bottom * ly
+            if order == "NHWC":
+                Y = Y.transpose(0, 2, 3, 1)
+            return Y.astype(np.float32),
+
+        self.assertReferenceChecks(gc, op, [X], ref, threshold=1e-4)
+        self.assertDeviceChecks(dc, op, [X], [0])
+        self.assertGradientChecks(
+            gc, op, [X], 0, [0], stepsize=0.05, threshold=1e-2)
+
+    @unittest.skipIf(not workspace.has_gpu_support, "No gpu support")
+    @given(height=st.integers(4, 16),
+           width=st.integers(4, 16),
+           num_channels=st.sampled_from([3, 4, 8]),
+           order=st.sampled_from(["NCHW", "NHWC"]),
+           seed=st.integers(0, 65535))
+    def test_bilinear_fp16(self, height, width, num_channels, order, seed):
+        np.random.seed(seed)
+        shape = (2, num_channels, height, width) if order == "NCHW" else \
+            (2, height, width, num_channels)
+        X = np.random.rand(*shape).astype(np.float32)
+        results = []
+        for dtype in [np.float32, np.float16]:
+            op = core.CreateOperator(
+                "ResizeBilinear", ["X"], ["Y"],
+                width_scale=1.5, height_scale=2.0, order=order,
+                device_option=hu.gpu_do)
+            self.ws.create_blob("X").feed(
+                X.astype(dtype), device_option=hu.gpu_do)
+            self.ws.run(op)
+            results.append(self.ws.blobs["Y"].fetch().astype(np.float32))
+        np.testing.assert_allclose(results[0], results[1], atol=1e-2)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -0,0 +1,160 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import numpy as np
+
+from hypothesis import given
+import hypothesis.strategies as st
+
+from caffe2.python import core
+import caffe2.python.hypothesis_test_util as hu
+
+
+def _bilinear(data, y, x):
+    height, width = data.shape[-2:]
+    if y < -1.0 or y > height or x < -1.0 or x > width:
+        return np.zeros(data.shape[:-2], dtype=data.dtype)
+    y = max(y, 0.0)
+    x = max(x, 0.0)
+    y_low = min(int(y), height - 1)
+    x_low = min(int(x), width - 1)
+    y_high = min(y_low + 1, height - 1)
+    x_high = min(x_low + 1, width - 1)
+    y = y_low if y_low == height - 1 else y
+    x = x_low if x_low == width - 1 else x
+    ly = y - y_low
+    lx = x - x_low
+    return ((1 - ly) * (1 - lx) * data[..., y_low, x_low] +
+            (1 - ly) * lx * data[..., y_low, x_high] +
+            ly * (1 - lx) * data[..., y_high, x_low] +
+            ly * lx * data[..., y_high, x_high])
+
+
+def _roi_align_ref(X, rois, spatial_scale, pooled_h, pooled_w,
+                   sampling_ratio):
+    Y = np.zeros(
+        (rois.shape[0], X.shape[1], pooled_h, pooled_w), dtype=np.float32)
+    for n, roi in enumerate(rois):
+        start_w, start_h, end_w, end_h = roi[1:] * spatial_scale
+        roi_w = max(end_w - start_w, 1.0)
+        roi_h = max(end_h - start_h, 1.0)
+        bin_h = roi_h / pooled_h
+        bin_w = roi_w / pooled_w
+        grid_h = sampling_ratio if sampling_ratio > 0 \
+            else int(np.ceil(roi_h / pooled_h))
+        grid_w = sampling_ratio if sampling_ratio > 0 \
+            else int(np.ceil(roi_w / pooled_w))
+        data = X[int(roi[0])]
+        for ph in range(pooled_h):
+            for pw in range(pooled_w):
+                acc = np.zeros(X.shape[1], dtype=np.float64)
+                for iy in range(grid_h):
+                    y = start_h + ph * bin_h + (iy + 0.5) * bin_h / grid_h
+                    for ix in range(grid_w):
+                        x = start_w + pw * bin_w + (ix + 0.5) * bin_w / grid_w
+                        acc += _bilinear(data, y, x)
+                Y[n, :, ph, pw] = acc / max(grid_h * grid_w, 1)
+    return Y
+
+
+def _random_rois(num_rois, batch_size, height, width, scale):
+    x1 = np.random.uniform(0, width * scale * 0.8, num_rois)
+    y1 = np.random.uniform(0, height * scale * 0.8, num_rois)
+    w = np.random.uniform(1, width * scale * 0.5, num_rois)
+    h = np.random.uniform(1, height * scale * 0.5, num_rois)
+    batch = np.random.randint(0, batch_size, num_rois)
+    return np.stack([batch, x1, y1, x1 + w, y1 + h], axis=1).astype(
+        np.float32)
+
+
+class TestRoIAlign(hu.HypothesisTestCase):
+    @given(batch_size=st.integers(1, 2),
+           channels=st.integers(1, 3),
+           height=st.integers(4, 10),
+           width=st.integers(4, 10),
+           num_rois=st.integers(0, 5),
+           pooled=st.integers(1, 3),
+           sampling_ratio=st.integers(-1, 2),
+           **hu.gcs)
+    def test_roi_align(self, batch_size, channels, height, width, num_rois,
+                       pooled, sampling_ratio, gc, dc):
+        spatial_scale = 0.5
+        X = np.random.rand(batch_size, channels, height, width).astype(
+            np.float32)
+        rois = _random_rois(num_rois, batch_size, height, width, 2.0)
+        op = core.CreateOperator(
+            "RoIAlign", ["X", "rois"], ["Y"],
+            spatial_scale=spatial_scale,
+            pooled_h=pooled,
+            pooled_w=pooled,
+            sampling_ratio=sampling_ratio)
+
+        def ref(X, rois):
+            return (_roi_align_ref(
+                X, rois, spatial_scale, pooled, pooled, sampling_ratio),)
+
+        self.assertReferenceChecks(gc, op, [X, rois], ref)
+        self.assertDeviceChecks(dc, op, [X, rois], [0])
+        if num_rois > 0:
+            self.assertGradientChecks(gc, op, [X, rois], 0, [0])
+
+    @given(num_rois=st.integers(0, 10),
+           channels=st.integers(1, 2),
+           sampling_ratio=st.integers(-1, 2),
+           **hu.gcs)
+    def test_multi_level_roi_align(self, num_rois, channels, sampling_ratio,
+                                   gc, dc):
+        min_level, max_level = 2, 4
+        image_size = 128
+        Xs = [np.random.rand(2, channels, image_size >> l, image_size >> l)
+              .astype(np.float32) for l in range(min_level, max_level + 1)]
+        rois = _random_rois(num_rois, 2, image_size, image_size, 1.0)
+        op = core.CreateOperator(
+            "MultiLevelRoIAlign",
+            ["X{}".format(l) for l in range(len(Xs))] + ["rois"], ["Y"],
+            pooled_h=2,
+            pooled_w=2,
+            sampling_ratio=sampling_ratio,
+            min_level=min_level,
+            max_level=max_level,
+            canonical_scale=64,
+            canonical_level=3)
+
+        def ref(*inputs):
+            Xs, rois = inputs[:-1], inputs[-1]
+            Y = np.zeros((len(rois), channels, 2, 2), dtype=np.float32)
+            for n, roi in enumerate(rois):
+                area = (roi[3] - roi[1] + 1) * (roi[4] - roi[2] + 1)
+                level = int(np.floor(3 + np.log2(np.sqrt(area) / 64 + 1e-6)))
+                level = min(max(level, min_level), max_level)
+                Y[n] = _roi_align_ref(
+                    Xs[level - min_level], roi[None], 1.0 / 2 ** level,
+                    2, 2, sampling_ratio)[0]
+            return (Y,)
+
+        self.assertReferenceChecks(gc, op, Xs + [rois], ref)
+        self.assertDeviceChecks(dc, op, Xs + [rois], [0])
+        if num_rois > 0:
+            self.assertGradientChecks(gc, op, Xs + [rois], 0, [0])
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
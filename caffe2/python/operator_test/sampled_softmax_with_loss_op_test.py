@@ -0,0 +1,106 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+from caffe2.python import core, workspace
+from hypothesis import given
+import caffe2.python.hypothesis_test_util as hu
+import hypothesis.strategies as st
+import numpy as np
+
+
+def log_expected_count(ids, num_sampled, num_classes):
+    return np.log(num_sampled * np.log1p(1. / (ids + 1)) /
+                  np.log(num_classes + 1))
+
+
+class TestSampledSoftmaxWithLoss(hu.HypothesisTestCase):
+
+    @given(n=st.integers(1, 5),
+           K=st.integers(1, 8),
+           V=st.sampled_from([10, 100]),
+           num_sampled=st.integers(1, 8),
+           remove_accidental_hits=st.booleans(),
+           **hu.gcs)
+    def test_sampled_softmax_with_loss(
+            self, n, K, V, num_sampled, remove_accidental_hits, gc, dc):
+        X = np.random.randn(n, K).astype(np.float32)
+        W = np.random.randn(V, K).astype(np.float32)
+        b = np.random.randn(V).astype(np.float32)
+        label = np.random.randint(0, V, size=n).astype(np.int32)
+        sampled = np.random.randint(0, V, size=num_sampled).astype(np.int32)
+        # Make accidental hits likely
+        sampled[0] = label[0]
+
+        def ref(X, W, b, label, sampled):
+            ids = np.concatenate(
+                [label[:, np.newaxis], np.tile(sampled, (n, 1))], axis=1)
+            logits = np.einsum("nk,njk->nj", X, W[ids]) + b[ids] - \
+                log_expected_count(ids, num_sampled, V)
+            if remove_accidental_hits:
+                logits[:, 1:][sampled[np.newaxis, :] == label[:, np.newaxis]] = \
+                    -np.finfo(np.float32).max
+            logits -= logits.max(axis=1, keepdims=True)
+            probs = np.exp(logits)
+            probs /= probs.sum(axis=1, keepdims=True)
+            loss = -np.mean(np.log(probs[:, 0]))
+            return (np.array(loss, dtype=np.float32),
+                    probs.astype(np.float32), sampled)
+
+        op = core.CreateOperator(
+            "SampledSoftmaxWithLoss",
+            ["X", "W", "b", "label", "sampled_in"],
+            ["loss", "probs", "sampled"],
+            remove_accidental_hits=remove_accidental_hits,
+        )
+        inputs = [X, W, b, label, sampled]
+        self.assertReferenceChecks(gc, op, inputs, ref)
+        self.assertDeviceChecks(dc, op, inputs, [0, 1, 2])
+        self.assertGradientChecks(
+            gc, op, inputs, 0, [0], stepsize=1e-3, threshold=1e-2)
+
+    @given(n=st.integers(1, 5),
+           V=st.sampled_from([10, 1000]),
+           num_sampled=st.integers(1, 64),
+           **hu.gcs)
+    def test_sampled_softmax_with_loss_sampling(self, n, V, num_sampled, gc, dc):
+        X = np.random.randn(n, 4).astype(np.float32)
+        W = np.random.randn(V, 4).astype(np.float32)
+        b = np.random.randn(V).astype(np.float32)
+        label = np.random.randint(0, V, size=n).astype(np.int32)
+        op = core.CreateOperator(
+            "SampledSoftmaxWithLoss",
+            ["X", "W", "b", "label"],
+            ["loss", "probs", "sampled"],
+            num_sampled=num_sampled,
+            device_option=gc,
+        )
+        for name, value in zip(["X", "W", "b", "label"], [X, W, b, label]):
+            workspace.FeedBlob(name, value, gc)
+        workspace.RunOperatorOnce(op)
+        sampled = workspace.FetchBlob("sampled")
+        self.assertEqual(sampled.shape, (num_sampled,))
+        self.assertTrue(np.all((sampled >= 0) & (sampled < V)))
+        probs = workspace.FetchBlob("probs")
+        self.assertEqual(probs.shape, (n, num_sampled + 1))
+        np.testing.assert_allclose(probs.sum(axis=1), 1., rtol=1e-4)
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
@@ -20,6 +20,7 @@ from __future__ import unicode_literals
 from caffe2.python import core
 from functools import partial
 from hypothesis import given
+import hypothesis.strategies as st
 
 from caffe2.python import workspace
 import caffe2.python.hypothesis_test_util as hu
@@ -328,7 +329,31 @@ class TestSegmentOps(hu.HypothesisTestCase):
             ),
             REFERENCES_ALL,
             gpu=workspace.has_gpu_support,
-            grad_check=False,
+        )(self)
+
+    def test_unsorted_segment_ops_deterministic_gpu(self):
+        SegmentsTester()._test(
+            'UnsortedSegment',
+            hu.segmented_tensor(
+                dtype=np.float32,
+                is_sorted=False,
+                allow_empty=True,
+            ),
+            REFERENCES_ALL,
+            gpu=workspace.has_gpu_support,
+            operator_args={'deterministic': True},
+        )(self)
+
+    def test_sorted_segment_ops_gpu(self):
+        SegmentsTester()._test(
+            'SortedSegment',
+            hu.segmented_tensor(
+                dtype=np.float32,
+                is_sorted=True,
+                allow_empty=True
+            ),
+            REFERENCES_ALL,
+            gpu=workspace.has_gpu_support,
         )(self)
 
     def test_sparse_sorted_segment_ops(self):
@@ -365,6 +390,19 @@ class TestSegmentOps(hu.HypothesisTestCase):
             REFERENCES_ALL + REFERENCES_LENGTHS_ONLY
         )(self)
 
+    def test_lengths_ops_gpu(self):
+        LengthsTester()._test(
+            'Lengths',
+            hu.lengths_tensor(
+                dtype=np.float32,
+                min_value=1,
+                max_value=5,
+                allow_empty=True
+            ),
+            REFERENCES_ALL + REFERENCES_LENGTHS_ONLY,
+            gpu=workspace.has_gpu_support,
+        )(self)
+
     def test_sparse_lengths_ops(self):
         for itype in [np.int32, np.int64]:
             LengthsTester()._test(
@@ -413,6 +451,47 @@ class TestSegmentOps(hu.HypothesisTestCase):
         self.assertDeviceChecks(dc, op, [X, segments], [0])
         self.assertGradientChecks(gc, op, [X, segments], 0, [0])
 
+    @unittest.skipIf(not workspace.has_gpu_support, "No gpu support")
+    @given(**hu.gcs)
+    def test_unsorted_sums_deterministic(self, gc, dc):
+        X = np.random.rand(10000, 32).astype(np.float32)
+        segments = np.random.randint(0, 100, size=10000).astype(np.int32)
+        op = core.CreateOperator(
+            "UnsortedSegmentSum", ["X", "segments"], "out",
+            deterministic=True, device_option=gc)
+        workspace.FeedBlob("X", X, gc)
+        workspace.FeedBlob("segments", segments, gc)
+        workspace.RunOperatorOnce(op)
+        out = workspace.FetchBlob("out")
+        workspace.RunOperatorOnce(op)
+        np.testing.assert_array_equal(out, workspace.FetchBlob("out"))
+        self.assertDeviceChecks(dc, op, [X, segments], [0])
+
+    @given(op_name=st.sampled_from(["SortedSegmentWeightedSum",
+                                    "UnsortedSegmentWeightedSum",
+                                    "LengthsWeightedSum"]),
+           grad_on_weights=st.booleans(),
+           **hu.gcs)
+    def test_segment_weighted_sum(self, op_name, grad_on_weights, gc, dc):
+        X = np.random.rand(12, 3, 4).astype(np.float32)
+        W = np.random.rand(12).astype(np.float32)
+        if op_name == "LengthsWeightedSum":
+            segments = np.array([3, 0, 5, 4]).astype(np.int32)
+        else:
+            segments = np.array(
+                [0, 0, 1, 1, 1, 2, 2, 2, 2, 2, 3, 3]).astype(np.int32)
+            if op_name.startswith("Unsorted"):
+                np.random.shuffle(segments)
+            # Only the Lengths op supports gradients on the weights
+            grad_on_weights = False
+        op = core.CreateOperator(
+            op_name, ["X", "W", "segments"], "out",
+            grad_on_weights=grad_on_weights)
+        self.assertDeviceChecks(dc, op, [X, W, segments], [0])
+        self.assertGradientChecks(gc, op, [X, W, segments], 0, [0])
+        if grad_on_weights:
+            self.assertGradientChecks(gc, op, [X, W, segments], 1, [0])
+
     @unittest.skipIf(not workspace.has_gpu_support, "No gpu support")
     @given(**hu.gcs)
     def test_unsorted_means_large(self, gc, dc):
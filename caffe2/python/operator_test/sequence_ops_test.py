@@ -17,7 +17,8 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
-from caffe2.python import core
+from caffe2.proto import caffe2_pb2
+from caffe2.python import core, workspace
 from hypothesis import given
 import caffe2.python.hypothesis_test_util as hu
 import hypothesis.strategies as st
@@ -200,6 +201,24 @@ class TestSequenceOps(hu.HypothesisTestCase):
             inputs=[data, lengths],
             reference=partial(_remove_padding_ref, start_pad_width, end_pad_width))
 
+    @unittest.skipIf(not workspace.has_hip, "No HIP support.")
+    @given(start_pad_width=st.integers(min_value=1, max_value=2),
+           end_pad_width=st.integers(min_value=0, max_value=2),
+           args=_gen_test_add_padding(with_pad_data=False, is_remove=True))
+    def test_remove_padding_hip(self, start_pad_width, end_pad_width, args):
+        lengths, data = args
+        op = core.CreateOperator(
+            'RemovePadding',
+            ['data', 'lengths'],
+            ['output', 'lengths_out'],
+            padding_width=start_pad_width,
+            end_padding_width=end_pad_width)
+        self.assertReferenceChecks(
+            device_option=core.DeviceOption(caffe2_pb2.HIP, 0),
+            op=op,
+            inputs=[data, lengths],
+            reference=partial(_remove_padding_ref, start_pad_width, end_pad_width))
+
     @given(start_pad_width=st.integers(min_value=0, max_value=2),
            end_pad_width=st.integers(min_value=0, max_value=2),
            args=_gen_test_add_padding(with_pad_data=True),
@@ -322,6 +341,21 @@ class TestSequenceOps(hu.HypothesisTestCase):
             inputs=[data],
             reference=op_ref)
 
+    @unittest.skipIf(not workspace.has_hip, "No HIP support.")
+    @given(elements=st.lists(st.integers(min_value=-5, max_value=5),
+                             min_size=0,
+                             max_size=100),
+           dtype=st.sampled_from([np.int32, np.int64, np.float32]))
+    def test_find_duplicate_elements_hip(self, elements, dtype):
+        elements = np.array(elements, dtype=dtype)
+        op = core.CreateOperator(
+            "FindDuplicateElements",
+            ["elements"],
+            ["indices"])
+        dc = [core.DeviceOption(caffe2_pb2.CPU),
+              core.DeviceOption(caffe2_pb2.HIP, 0)]
+        self.assertDeviceChecks(dc, op, [elements], [0])
+
 
 if __name__ == "__main__":
     import unittest
@@ -17,6 +17,7 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
+from caffe2.proto import caffe2_pb2
 from caffe2.python import core, workspace
 from hypothesis import given
 import caffe2.python.hypothesis_test_util as hu
@@ -195,6 +196,43 @@ class TestSoftmaxOps(hu.HypothesisTestCase):
         self.assertGradientChecks(
             gc, op, [X, label], 0, [1], stepsize=1e-4, threshold=1e-2)
 
+    @unittest.skipIf(not workspace.has_hip, "No HIP support.")
+    @given(n=st.integers(1, 8),
+           D=st.sampled_from([4, 79, 1000, 5003]),
+           chunk_size=st.sampled_from([0, 64, 1000]),
+           weighted=st.booleans())
+    def test_softmax_with_loss_online(self, n, D, chunk_size, weighted):
+        device_option = core.DeviceOption(caffe2_pb2.HIP, 0)
+        X = (np.random.rand(n, D) * 10).astype(np.float32)
+        label = (np.random.rand(n) * D).astype(np.int32)
+        weights = np.random.rand(n).astype(np.float32)
+        inputs = ["X", "label", "weights"] if weighted else ["X", "label"]
+        op = core.CreateOperator(
+            "SoftmaxWithLoss", inputs, ["lse", "avgloss"],
+            online=True, chunk_size=chunk_size, device_option=device_option)
+        grad_op = core.CreateOperator(
+            "SoftmaxWithLossGradient", inputs + ["lse", "davgloss"], ["dX"],
+            online=True, device_option=device_option)
+        for name, value in zip(["X", "label", "weights", "davgloss"],
+                               [X, label, weights, np.float32(2.)]):
+            workspace.FeedBlob(name, value, device_option)
+        workspace.RunOperatorOnce(op)
+        workspace.RunOperatorOnce(grad_op)
+
+        rowmax = X.max(axis=1, keepdims=True)
+        lse = np.log(np.exp(X - rowmax).sum(axis=1)) + rowmax[:, 0]
+        w = weights if weighted else np.ones(n, dtype=np.float32)
+        loss = np.sum((lse - X[np.arange(n), label]) * w) / np.sum(w)
+        dX = np.exp(X - lse[:, np.newaxis])
+        dX[np.arange(n), label] -= 1.
+        dX *= 2. * w[:, np.newaxis] / np.sum(w)
+        np.testing.assert_allclose(
+            workspace.FetchBlob("lse"), lse, rtol=1e-4, atol=1e-4)
+        np.testing.assert_allclose(
+            workspace.FetchBlob("avgloss"), loss, rtol=1e-4, atol=1e-4)
+        np.testing.assert_allclose(
+            workspace.FetchBlob("dX"), dX, rtol=1e-4, atol=1e-5)
+
     @given(
         n=st.integers(2, 5),
         D=st.integers(4, 16),
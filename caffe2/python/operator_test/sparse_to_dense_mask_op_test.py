@@ -18,11 +18,13 @@ from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
 
-from caffe2.python import core
+from caffe2.proto import caffe2_pb2
+from caffe2.python import core, workspace
 from hypothesis import given
 import caffe2.python.hypothesis_test_util as hu
 import hypothesis.strategies as st
 import numpy as np
+import unittest
 
 
 class TestFcOperator(hu.HypothesisTestCase):
@@ -119,6 +121,40 @@ class TestFcOperator(hu.HypothesisTestCase):
             gc, op, [indices, values, default, lengths], 1, [0])
 
 
+    @unittest.skipIf(not workspace.has_hip, "No HIP support.")
+    @given(n=st.integers(1, 10), k=st.integers(1, 5),
+           use_length=st.booleans(), int64_ids=st.booleans(),
+           dim=st.integers(0, 2))
+    def test_sparse_to_dense_mask_hip(self, n, k, use_length, int64_ids, dim):
+        lengths = np.random.randint(k, size=n).astype(np.int32) + 1
+        N = sum(lengths)
+        offset = 10000000000 if int64_ids else 0
+        # ids 3 and 4 are not in the mask, duplicates keep the last value
+        indices = np.random.randint(5, size=N) + offset
+        shape = tuple(np.random.randint(5, size=dim) + 1)
+        values = np.random.rand(*((N,) + shape)).astype(np.float32)
+        default = np.random.rand(*shape).astype(np.float32)
+        mask = np.arange(3) + offset
+        np.random.shuffle(mask)
+
+        input_str = ['indices', 'values', 'default']
+        input_data = [indices, values, default]
+        if use_length:
+            input_str.append('lengths')
+            input_data.append(lengths)
+
+        op = core.CreateOperator(
+            'SparseToDenseMask',
+            input_str,
+            ['output', 'presence_mask'],
+            mask=mask,
+            return_presence_mask=True,
+        )
+        dc = [core.DeviceOption(caffe2_pb2.CPU),
+              core.DeviceOption(caffe2_pb2.HIP, 0)]
+        self.assertDeviceChecks(dc, op, input_data, [0, 1])
+        self.assertGradientChecks(dc[1], op, input_data, 1, [0])
+
+
 if __name__ == "__main__":
-    import unittest
     unittest.main()
@@ -17,7 +17,7 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
-from caffe2.python import core
+from caffe2.python import core, workspace
 from hypothesis import given
 
 import caffe2.python.hypothesis_test_util as hu
@@ -280,6 +280,111 @@ class TestSpecializedSegmentOps(hu.HypothesisTestCase):
         with self.assertRaises(RuntimeError):
             self.ws.run(op)
 
+    @given(batchsize=st.integers(1, 20),
+           fptype=st.sampled_from([np.float16, np.float32]),
+           blocksize=st.sampled_from([8, 17, 32, 64, 85, 96, 128, 163]),
+           op_type=st.sampled_from(
+               ["SparseLengthsSum", "SparseLengthsMean",
+                "SparseLengthsWeightedSum"]),
+           **hu.gcs)
+    def test_sparse_lengths_reduction_devices(
+            self, batchsize, fptype, blocksize, op_type, gc, dc):
+
+        tblsize = 300
+        Tbl = np.random.rand(tblsize, blocksize).astype(fptype)
+        # empty segments are allowed and must produce zeros
+        Lengths = np.random.randint(0, 30, size=batchsize).astype(np.int32)
+        Indices = np.random.randint(
+            0, tblsize, size=sum(Lengths)).astype(np.int64)
+
+        if op_type == "SparseLengthsWeightedSum":
+            Weights = np.random.rand(sum(Lengths)).astype(np.float32)
+            inputs = [Tbl, Weights, Indices, Lengths]
+            op = core.CreateOperator(op_type, [
+                                     "Tbl", "Weights", "Indices", "Lengths"], "out")
+        else:
+            inputs = [Tbl, Indices, Lengths]
+            op = core.CreateOperator(op_type, [
+                                     "Tbl", "Indices", "Lengths"], "out")
+
+        threshold = 1e-4 if fptype == np.float32 else 1e-2
+        self.assertDeviceChecks(dc, op, inputs, [0], threshold=threshold)
+
+    @given(batchsize=st.integers(1, 20),
+           blocksize=st.sampled_from([8, 17, 32, 64, 85, 96, 128, 163]),
+           op_type=st.sampled_from(
+               ["SparseLengthsSum8BitsRowwise",
+                "SparseLengthsMean8BitsRowwise",
+                "SparseLengthsWeightedSum8BitsRowwise",
+                "SparseLengthsWeightedMean8BitsRowwise"]),
+           **hu.gcs)
+    def test_sparse_lengths_8BitsRowwiseOp_devices(
+            self, batchsize, blocksize, op_type, gc, dc):
+
+        tblsize = 300
+        Tbl = np.random.randint(
+            256, size=(tblsize, blocksize)).astype(np.uint8)
+        Lengths = np.random.randint(0, 30, size=batchsize).astype(np.int32)
+        Indices = np.random.randint(
+            0, tblsize, size=sum(Lengths)).astype(np.int64)
+        Scale_Bias = np.random.rand(tblsize, 2).astype(np.float32)
+
+        if "Weighted" in op_type:
+            Weights = np.random.rand(sum(Lengths)).astype(np.float32)
+            inputs = [Tbl, Weights, Indices, Lengths, Scale_Bias]
+            op = core.CreateOperator(op_type, [
+                "Tbl", "Weights", "Indices", "Lengths", "Scale_Bias"], "out")
+        else:
+            inputs = [Tbl, Indices, Lengths, Scale_Bias]
+            op = core.CreateOperator(op_type, [
+                "Tbl", "Indices", "Lengths", "Scale_Bias"], "out")
+
+        self.assertDeviceChecks(dc, op, inputs, [0], threshold=1e-4)
+
+        dequant = core.CreateOperator(
+            "Rowwise8BitQuantizedToFloat", ["Tbl", "Scale_Bias"], "out")
+        self.assertDeviceChecks(dc, dequant, [Tbl, Scale_Bias], [0])
+
+    @given(batchsize=st.integers(1, 20),
+           blocksize=st.sampled_from([8, 17, 64, 163]),
+           reducer=st.sampled_from(["SparseLengthsSum", "SparseLengthsMean"]),
+           **hu.gcs)
+    def test_sparse_lengths_sum_managed(
+            self, batchsize, blocksize, reducer, gc, dc):
+        tblsize = 300
+        Tbl = np.random.rand(tblsize, blocksize).astype(np.float32)
+        workspace.FeedBlob("Tbl_cpu", Tbl)
+
+        # A cache of two pages refreshed at every run keeps migrating blocks
+        # between runs, which must not change the lookups.
+        net = core.Net("managed_sls")
+        net.Proto().device_option.CopyFrom(gc)
+        net.CopyToManaged("Tbl_cpu", "Tbl")
+        net.Proto().op.extend([core.CreateOperator(
+            reducer, ["Tbl", "Indices", "Lengths"], "out",
+            engine="MANAGED", cache_bytes=8192, cache_block_bytes=4096,
+            cache_refresh_interval=1)])
+
+        for run in range(3):
+            Lengths = np.random.randint(
+                1, 30, size=batchsize).astype(np.int32)
+            Indices = np.random.randint(
+                0, tblsize, size=sum(Lengths)).astype(np.int64)
+            workspace.FeedBlob("Indices", Indices, device_option=gc)
+            workspace.FeedBlob("Lengths", Lengths, device_option=gc)
+            if run == 0:
+                workspace.CreateNet(net, True)
+            workspace.RunNet(net.Name())
+
+            rptr = np.cumsum(np.insert(Lengths, [0], [0]))
+            ref = np.zeros((batchsize, blocksize), dtype=np.float32)
+            for i in range(batchsize):
+                ref[i] = Tbl[Indices[rptr[i]:rptr[i + 1]]].sum(axis=0)
+                if reducer == "SparseLengthsMean":
+                    ref[i] /= Lengths[i]
+            np.testing.assert_allclose(
+                workspace.FetchBlob("out"), ref, rtol=1e-4, atol=1e-4)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -17,7 +17,7 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
-from caffe2.python import core
+from caffe2.python import core, workspace
 from hypothesis import given
 import caffe2.python.hypothesis_test_util as hu
 import hypothesis.strategies as st
@@ -128,6 +128,46 @@ class TestStringOps(hu.HypothesisTestCase):
             [strings],
             string_ends_with_ref)
 
+    @given(strings=_string_lists(alphabet=['a', 'b', 'c']),
+           length=st.integers(0, 4))
+    def test_packed_string_ops(self, strings, length):
+        strings = np.array(
+            [a.encode('utf-8') for a in strings], dtype=np.object
+        )
+        workspace.FeedBlob('strings', strings)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'StringPack', ['strings'], ['data', 'lengths']))
+        np.testing.assert_array_equal(
+            workspace.FetchBlob('lengths'), [len(s) for s in strings])
+
+        def run(op_type, outputs, **kwargs):
+            workspace.RunOperatorOnce(core.CreateOperator(
+                op_type, ['data', 'lengths'], outputs, **kwargs))
+            return [workspace.FetchBlob(o) for o in outputs]
+
+        def unpack(data, lengths):
+            workspace.FeedBlob('packed_data', data)
+            workspace.FeedBlob('packed_lengths', lengths)
+            workspace.RunOperatorOnce(core.CreateOperator(
+                'StringUnpack', ['packed_data', 'packed_lengths'], ['out']))
+            return list(workspace.FetchBlob('out'))
+
+        self.assertEqual(
+            unpack(workspace.FetchBlob('data'), workspace.FetchBlob('lengths')),
+            list(strings))
+        self.assertEqual(
+            unpack(*run('PackedStringPrefix', ['p', 'pl'], length=length)),
+            [s[:length] for s in strings])
+        self.assertEqual(
+            unpack(*run('PackedStringSuffix', ['s', 'sl'], length=length)),
+            [s[len(s) - min(len(s), length):] for s in strings])
+        np.testing.assert_array_equal(
+            run('PackedStringStartsWith', ['b'], prefix='a')[0],
+            [s.startswith(b'a') for s in strings])
+        np.testing.assert_array_equal(
+            run('PackedStringEndsWith', ['b'], suffix='ab')[0],
+            [s.endswith(b'ab') for s in strings])
+
 if __name__ == "__main__":
     import unittest
     unittest.main()
@@ -22,6 +22,7 @@ from caffe2.python.text_file_reader import TextFileReader
 from caffe2.python.test_util import TestCase
 from caffe2.python.schema import Struct, Scalar, FetchRecord
 import tempfile
+from itertools import product
 import numpy as np
 
 
@@ -47,7 +48,7 @@ class TestTextFileReader(TestCase):
             )
             txt_file.flush()
 
-            for num_passes in range(1, 3):
+            for num_passes, num_threads in product(range(1, 3), (1, 4)):
                 for batch_size in range(1, len(row_data) + 2):
                     init_net = core.Net('init_net')
                     reader = TextFileReader(
@@ -55,7 +56,8 @@ class TestTextFileReader(TestCase):
                         filename=txt_file.name,
                         schema=schema,
                         batch_size=batch_size,
-                        num_passes=num_passes)
+                        num_passes=num_passes,
+                        num_threads=num_threads)
                     workspace.RunNetOnce(init_net)
 
                     net = core.Net('read_net')
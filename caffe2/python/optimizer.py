@@ -103,21 +103,30 @@ class Optimizer(object):
 
     def build_lr(self, net, param_init_net, base_learning_rate,
                  learning_rate_blob=None, policy="fixed",
-                 iter_val=0, **kwargs):
+                 iter_val=0, iter_on_device=False, **kwargs):
         if learning_rate_blob is None:
             learning_rate_blob = self.make_unique_blob_name('lr')
 
         optimization_iter_blob = _OPTIMIZER_ITERATION_NAME
         if not param_init_net.BlobIsDefined(optimization_iter_blob):
+            iter_device = core.DeviceOption(caffe2_pb2.CPU)
+            current_scope = scope.CurrentDeviceScope()
+            if (iter_on_device and current_scope is not None and
+                    current_scope.device_type == caffe2_pb2.HIP):
+                # The HIP Iter, LearningRate and Adam ops keep the counter on
+                # the device, the step then never syncs with the host for it.
+                iter_device = current_scope
             # Add training operators.
-            with core.DeviceScope(core.DeviceOption(caffe2_pb2.CPU)):
+            with core.DeviceScope(iter_device):
                 iteration = param_init_net.ConstantFill(
                     [], optimization_iter_blob, shape=[1],
                     value=iter_val,
                     dtype=core.DataType.INT64)
+            with core.DeviceScope(core.DeviceOption(caffe2_pb2.CPU)):
                 iter_mutex = param_init_net.CreateMutex(
                     [], ["iteration_mutex"]
                 )
+            with core.DeviceScope(iter_device):
                 net.AtomicIter([iter_mutex, iteration], [iteration])
         else:
             iteration = param_init_net.GetBlobRef(optimization_iter_blob)
@@ -16,17 +16,24 @@
 
 #include "pybind_state.h"
 
+#include <algorithm>
+#include <atomic>
+#include <set>
+#include <thread>
+
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
 #include "caffe2/contrib/script/compiler.h"
 #include "caffe2/core/asan.h"
 #include "caffe2/core/db.h"
+#include "caffe2/core/net_async_base.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/core/predictor.h"
 #include "caffe2/core/stats.h"
 #include "caffe2/core/transform.h"
 #include "caffe2/mkl/mkl_utils.h"
+#include "caffe2/observers/memory_observer.h"
 #include "caffe2/observers/runcnt_observer.h"
 #include "caffe2/observers/time_observer.h"
 #include "caffe2/utils/cpuid.h"
@@ -184,6 +191,191 @@ py::object fetchBlob(Workspace* ws, const std::string& name) {
     return py::bytes(ss.str());
   }
 }
+namespace {
+
+// A host to host copy that is deferred until the GIL has been released.
+struct PendingCopy {
+  const void* src;
+  void* dst;
+  size_t nbytes;
+};
+
+// Below this many bytes in total, copies stay on the calling thread.
+constexpr size_t kParallelCopyBytes = 1 << 20;
+// Large tensors are split into chunks of this size so that a single big
+// blob is also spread across threads.
+constexpr size_t kCopyChunkBytes = 256 << 10;
+constexpr size_t kMaxCopyThreads = 8;
+
+void RunPendingCopies(const std::vector<PendingCopy>& copies) {
+  size_t total_bytes = 0;
+  for (const auto& copy : copies) {
+    total_bytes += copy.nbytes;
+  }
+  const size_t num_threads = std::min(
+      {kMaxCopyThreads,
+       static_cast<size_t>(std::thread::hardware_concurrency()),
+       total_bytes / kParallelCopyBytes});
+  if (num_threads <= 1) {
+    for (const auto& copy : copies) {
+      memcpy(copy.dst, copy.src, copy.nbytes);
+    }
+    return;
+  }
+
+  std::vector<PendingCopy> chunks;
+  for (const auto& copy : copies) {
+    for (size_t offset = 0; offset < copy.nbytes; offset += kCopyChunkBytes) {
+      chunks.push_back(PendingCopy{
+          static_cast<const char*>(copy.src) + offset,
+          static_cast<char*>(copy.dst) + offset,
+          std::min(kCopyChunkBytes, copy.nbytes - offset)});
+    }
+  }
+  std::atomic<size_t> next_chunk(0);
+  auto worker = [&]() {
+    for (size_t i = next_chunk++; i < chunks.size(); i = next_chunk++) {
+      memcpy(chunks[i].dst, chunks[i].src, chunks[i].nbytes);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < num_threads; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+// Resizes the blob's CPU tensor for a numeric numpy array and queues the copy
+// of its data. Returns false if the array needs the regular feeder.
+bool QueueCPUFeed(
+    PyArrayObject* original_array,
+    Blob* blob,
+    std::vector<PendingCopy>* copies,
+    std::vector<py::object>* arrays) {
+  const auto npy_type = PyArray_TYPE(original_array);
+  if (npy_type == NPY_OBJECT || npy_type == NPY_UNICODE) {
+    return false;
+  }
+  const TypeMeta& meta = NumpyTypeToCaffe(npy_type);
+  if (meta.id() == 0) {
+    return false;
+  }
+  PyArrayObject* array = PyArray_GETCONTIGUOUS(original_array);
+  arrays->push_back(
+      py::reinterpret_steal<py::object>(reinterpret_cast<PyObject*>(array)));
+  const int ndim = PyArray_NDIM(array);
+  const npy_intp* npy_dims = PyArray_DIMS(array);
+  std::vector<TIndex> dims(npy_dims, npy_dims + ndim);
+  auto* tensor = blob->GetMutable<TensorCPU>();
+  tensor->Resize(dims);
+  copies->push_back(PendingCopy{PyArray_DATA(array),
+                                tensor->raw_mutable_data(meta),
+                                tensor->size() * meta.itemsize()});
+  return true;
+}
+
+// Whether a caller-provided array can receive a fetched tensor as is.
+bool CanFetchInto(
+    const py::object& obj,
+    int numpy_type,
+    const std::vector<npy_intp>& dims) {
+  if (obj.is_none() || !PyArray_Check(obj.ptr())) {
+    return false;
+  }
+  auto* array = reinterpret_cast<PyArrayObject*>(obj.ptr());
+  if (PyArray_TYPE(array) != numpy_type ||
+      !PyArray_IS_C_CONTIGUOUS(array) || !PyArray_ISWRITEABLE(array) ||
+      PyArray_NDIM(array) != static_cast<int>(dims.size())) {
+    return false;
+  }
+  return std::equal(dims.begin(), dims.end(), PyArray_DIMS(array));
+}
+
+} // namespace
+
+std::vector<py::object> fetchBlobs(
+    Workspace* ws,
+    const std::vector<std::string>& names,
+    const std::vector<py::object>& outputs) {
+  CAFFE_ENFORCE(
+      outputs.empty() || outputs.size() == names.size(),
+      "Expected one output array per blob");
+  std::vector<py::object> result;
+  std::vector<PendingCopy> copies;
+  result.reserve(names.size());
+  for (int i = 0; i < names.size(); ++i) {
+    CAFFE_ENFORCE(ws->HasBlob(names[i]), "Can't find blob: ", names[i]);
+    const auto& blob = *ws->GetBlob(names[i]);
+    const int numpy_type =
+        blob.IsType<TensorCPU>() && blob.Get<TensorCPU>().size() > 0
+        ? CaffeToNumpyType(blob.Get<TensorCPU>().meta())
+        : -1;
+    if (numpy_type == -1 || numpy_type == NPY_OBJECT) {
+      result.push_back(fetchBlob(ws, names[i]));
+      continue;
+    }
+    const auto& tensor = blob.Get<TensorCPU>();
+    std::vector<npy_intp> npy_dims(tensor.dims().begin(), tensor.dims().end());
+    if (!outputs.empty() && CanFetchInto(outputs[i], numpy_type, npy_dims)) {
+      result.push_back(outputs[i]);
+    } else {
+      result.push_back(py::reinterpret_steal<py::object>(PyArray_SimpleNew(
+          tensor.ndim(), npy_dims.data(), numpy_type)));
+    }
+    copies.push_back(PendingCopy{
+        tensor.raw_data(),
+        PyArray_DATA(reinterpret_cast<PyArrayObject*>(result.back().ptr())),
+        tensor.nbytes()});
+  }
+  {
+    py::gil_scoped_release g;
+    RunPendingCopies(copies);
+  }
+  return result;
+}
+
+void feedBlobs(
+    Workspace* ws,
+    const std::vector<std::string>& names,
+    const std::vector<py::object>& args,
+    const DeviceOption& option) {
+  CAFFE_ENFORCE_EQ(names.size(), args.size(), "Expected one value per blob");
+  CAFFE_ENFORCE_EQ(
+      std::set<std::string>(names.begin(), names.end()).size(),
+      names.size(),
+      "Cannot feed the same blob twice in one call");
+  std::vector<PendingCopy> copies;
+  // Keeps the contiguous arrays alive until their data has been copied.
+  std::vector<py::object> arrays;
+  for (int i = 0; i < names.size(); ++i) {
+    auto* blob = ws->CreateBlob(names[i]);
+    const auto& arg = args[i];
+    if (PyArray_Check(arg.ptr())) {
+      auto* array = reinterpret_cast<PyArrayObject*>(arg.ptr());
+      if (option.device_type() == CPU &&
+          QueueCPUFeed(array, blob, &copies, &arrays)) {
+        continue;
+      }
+      auto feeder = CreateFeeder(option.device_type());
+      CAFFE_ENFORCE(feeder, "Unknown device type encountered in FeedBlobs.");
+      feeder->Feed(option, array, blob);
+    } else if (PyBytes_Check(arg.ptr()) || PyUnicode_Check(arg.ptr())) {
+      *blob->GetMutable<std::string>() = arg.cast<std::string>();
+    } else {
+      CAFFE_THROW(
+          "Unexpected type of argument for blob ",
+          names[i],
+          " - only numpy array or string are supported for feeding");
+    }
+  }
+  {
+    py::gil_scoped_release g;
+    RunPendingCopies(copies);
+  }
+}
 } // namespace python_detail
 
 class GetPythonGradient : public GradientMakerBase {
@@ -470,6 +662,14 @@ void addObjectMethods(py::module& m) {
             return py::cast(self->CreateBlob(name));
           },
           py::return_value_policy::reference_internal)
+      .def(
+          "get_blob",
+          [](Workspace* self, const std::string& name) -> py::object {
+            auto* blob = self->GetBlob(name);
+            CAFFE_ENFORCE(blob, "Can't find blob: ", name);
+            return py::cast(blob);
+          },
+          py::return_value_policy::reference_internal)
       .def("fetch_blob", &python_detail::fetchBlob)
       .def(
           "has_blob",
@@ -850,6 +1050,15 @@ void addGlobalMethods(py::module& m) {
     CAFFE_ENFORCE(gWorkspace);
     return gWorkspace->HasBlob(name);
   });
+  m.def(
+      "get_blob",
+      [](const std::string& name) -> py::object {
+        CAFFE_ENFORCE(gWorkspace);
+        auto* blob = gWorkspace->GetBlob(name);
+        CAFFE_ENFORCE(blob, "Can't find blob: ", name);
+        return py::cast(blob);
+      },
+      py::return_value_policy::reference);
   m.def(
       "create_net",
       [](py::bytes net_def, bool overwrite) {
@@ -912,6 +1121,11 @@ void addGlobalMethods(py::module& m) {
           observer = net->AttachObserver(std::move(net_ob));
         }
 
+        if (observer_type.compare("MemoryObserver") == 0) {
+          observer =
+              net->AttachObserver(make_unique<MemoryNetObserver>(net));
+        }
+
         CAFFE_ENFORCE(observer != nullptr);
         return py::cast(observer);
       });
@@ -949,6 +1163,22 @@ void addGlobalMethods(py::module& m) {
         return stat;
       });
 
+  m.def(
+      "dump_async_net_trace",
+      [](const std::string& name, const std::string& filename) {
+        CAFFE_ENFORCE(gWorkspace);
+        auto* net =
+            dynamic_cast_if_rtti<AsyncNetBase*>(gWorkspace->GetNet(name));
+        CAFFE_ENFORCE(net, "Didn't find async net: ", name);
+        CAFFE_ENFORCE(
+            net->tracer(),
+            "Net ",
+            name,
+            " is not traced, run with --caffe2_net_async_tracing");
+        py::gil_scoped_release g;
+        net->tracer()->DumpChromeTrace(filename);
+      });
+
   m.def("delete_net", [](const std::string& name) {
     CAFFE_ENFORCE(gWorkspace);
     gWorkspace->DeleteNet(name);
@@ -1070,6 +1300,49 @@ void addGlobalMethods(py::module& m) {
         CAFFE_ENFORCE(optimized_proto.SerializeToString(&protob));
         return py::bytes(protob);
       });
+  m.def(
+      "memonger_apply_recomputation",
+      [](const py::bytes& net_def,
+         int num_forward_ops,
+         const std::vector<int>& segment_starts,
+         const std::unordered_set<string>& dont_drop_blob_names) {
+        NetDef net;
+        CAFFE_ENFORCE(
+            ParseProtobufFromLargeString(net_def.cast<std::string>(), &net));
+        py::gil_scoped_release g;
+        NetDef optimized = caffe2::memonger::apply_recomputation(
+            net, num_forward_ops, segment_starts, dont_drop_blob_names);
+        std::string protob;
+        CAFFE_ENFORCE(optimized.SerializeToString(&protob));
+        return py::bytes(protob);
+      });
+  m.def(
+      "memonger_apply_offload",
+      [](const py::bytes& net_def,
+         int num_forward_ops,
+         const std::unordered_map<string, size_t>& blob_bytes,
+         double peak_flops,
+         double peak_bandwidth,
+         double host_bandwidth,
+         size_t min_bytes) {
+        CAFFE_ENFORCE(gWorkspace);
+        NetDef net;
+        CAFFE_ENFORCE(
+            ParseProtobufFromLargeString(net_def.cast<std::string>(), &net));
+        // Shapes of the blobs of the workspace, e.g. after a run of the net
+        const auto cost_model = NetCostModel::FromWorkspace(net, gWorkspace);
+        py::gil_scoped_release g;
+        caffe2::memonger::OffloadOptions options;
+        options.peak_flops = peak_flops;
+        options.peak_bandwidth = peak_bandwidth;
+        options.host_bandwidth = host_bandwidth;
+        options.min_bytes = min_bytes;
+        NetDef optimized = caffe2::memonger::apply_offload(
+            net, num_forward_ops, cost_model, blob_bytes, options);
+        std::string protob;
+        CAFFE_ENFORCE(optimized.SerializeToString(&protob));
+        return py::bytes(protob);
+      });
   m.def(
       "memonger_optimize_inference_net",
       [](const py::bytes& net_def,
@@ -1163,6 +1436,38 @@ void addGlobalMethods(py::module& m) {
       py::arg("name"),
       py::arg("arg"),
       py::arg("device_option") = py::none());
+  m.def(
+      "fetch_blobs",
+      [](const std::vector<std::string>& names, py::object outputs) {
+        CAFFE_ENFORCE(gWorkspace);
+        return python_detail::fetchBlobs(
+            gWorkspace,
+            names,
+            outputs.is(py::none()) ? std::vector<py::object>()
+                                   : outputs.cast<std::vector<py::object>>());
+      },
+      "Fetch several blobs, copying CPU tensors with the GIL released. "
+      "Arrays in outputs with the right dtype and shape are filled in place.",
+      py::arg("names"),
+      py::arg("outputs") = py::none());
+  m.def(
+      "feed_blobs",
+      [](const std::vector<std::string>& names,
+         const std::vector<py::object>& args,
+         py::object device_option) {
+        CAFFE_ENFORCE(gWorkspace);
+        DeviceOption option;
+        if (!device_option.is(py::none())) {
+          CAFFE_ENFORCE(ParseProtobufFromLargeString(
+              py::bytes(device_option).cast<std::string>(), &option));
+        }
+        python_detail::feedBlobs(gWorkspace, names, args, option);
+        return true;
+      },
+      "Feed several blobs, copying numpy arrays to CPU with the GIL released.",
+      py::arg("names"),
+      py::arg("args"),
+      py::arg("device_option") = py::none());
   m.def("serialize_blob", [](const std::string& name) {
     CAFFE_ENFORCE(gWorkspace);
     auto* blob = gWorkspace->GetBlob(name);
@@ -25,11 +25,17 @@ const DLDeviceType* CaffeToDLDeviceType(int device_type) {
   static std::map<int, DLDeviceType> dl_device_type_map{
       {CPU, kCPU},
       {CUDA, kGPU},
+      {HIP, kROCM},
   };
   const auto it = dl_device_type_map.find(device_type);
   return it == dl_device_type_map.end() ? nullptr : &it->second;
 }
 
+int DLDeviceId(const DeviceOption& device_option) {
+  return device_option.device_type() == HIP ? device_option.hip_gpu_id()
+                                            : device_option.cuda_gpu_id();
+}
+
 const DLDataType* CaffeToDLType(const TypeMeta& meta) {
   static std::map<CaffeTypeId, DLDataType> dl_type_map{
       {TypeMeta::Id<int8_t>(), DLDataType{0, 8, 1}},
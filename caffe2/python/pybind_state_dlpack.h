@@ -22,6 +22,8 @@
 #include "caffe2/proto/caffe2.pb.h"
 #include "caffe2/python/dlpack.h"
 
+#include <memory>
+
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -36,6 +38,9 @@ const DLDataType* CaffeToDLType(const TypeMeta& meta);
 
 const TypeMeta& DLTypeToCaffe(const DLDataType& dl_type);
 
+// Device id of a DeviceOption in its own device type's id field.
+int DLDeviceId(const DeviceOption& device_option);
+
 template <class Context>
 class DLPackWrapper {
  public:
@@ -50,7 +55,7 @@ class DLPackWrapper {
         "Unsupported device type: ",
         device_option.device_type());
     tensor_context.device_type = *device_type_ptr;
-    tensor_context.device_id = device_option.cuda_gpu_id();
+    tensor_context.device_id = DLDeviceId(device_option);
 
     if (tensor->size() <= 0) {
       tensor->Resize(0);
@@ -103,7 +108,7 @@ class DLPackWrapper {
     int dlpack_device_id = dlTensor->ctx.device_id;
     CAFFE_ENFORCE_EQ(
         dlpack_device_id,
-        device_option.cuda_gpu_id(),
+        DLDeviceId(device_option),
         "Expected same device id for DLPack and C2 tensors");
 
     std::vector<TIndex> dims;
@@ -141,5 +146,64 @@ class DLPackWrapper {
   DLManagedTensor managed_tensor;
 };
 
+// Exports a tensor as a DLPack capsule that owns a reference to the tensor's
+// memory, so unlike DLPackWrapper::data() it stays valid after the blob is
+// freed or reallocated. The capsule follows the usual DLPack protocol: a
+// consumer renames it to "used_dltensor" and calls the deleter when done; an
+// unconsumed capsule releases the memory when it is garbage collected.
+template <class Context>
+py::object ShareTensorToDLPack(
+    const Tensor<Context>& tensor,
+    const DeviceOption& device_option) {
+  struct SharedDLTensor {
+    DLManagedTensor managed_tensor;
+    Tensor<Context> tensor;
+  };
+
+  auto device_type_ptr = CaffeToDLDeviceType(device_option.device_type());
+  CAFFE_ENFORCE(
+      device_type_ptr,
+      "Unsupported device type: ",
+      device_option.device_type());
+  CAFFE_ENFORCE_GT(tensor.ndim(), 0, "Cannot share a tensor without shape");
+  auto type_ptr = CaffeToDLType(tensor.meta());
+  CAFFE_ENFORCE(
+      type_ptr,
+      "Tensor type is not supported in DLPack: ",
+      tensor.meta().name());
+
+  std::unique_ptr<SharedDLTensor> shared(new SharedDLTensor());
+  shared->tensor.Resize(tensor.dims());
+  shared->tensor.ShareData(tensor);
+
+  DLTensor& dlTensor = shared->managed_tensor.dlTensor;
+  dlTensor.data = const_cast<void*>(shared->tensor.raw_data());
+  dlTensor.ctx.device_type = *device_type_ptr;
+  dlTensor.ctx.device_id = DLDeviceId(device_option);
+  dlTensor.ndim = shared->tensor.ndim();
+  dlTensor.dtype = *type_ptr;
+  dlTensor.shape = const_cast<int64_t*>(shared->tensor.dims().data());
+  dlTensor.strides = nullptr;
+  dlTensor.byte_offset = 0;
+  shared->managed_tensor.ctx = shared.get();
+  shared->managed_tensor.destructor = [](DLManagedTensor* self) {
+    delete static_cast<SharedDLTensor*>(self->ctx);
+  };
+
+  PyObject* capsule = PyCapsule_New(
+      &shared->managed_tensor, "dltensor", [](PyObject* obj) {
+        // Only free the tensor if no consumer has taken ownership of it.
+        if (!PyCapsule_IsValid(obj, "dltensor")) {
+          return;
+        }
+        auto* managed = static_cast<DLManagedTensor*>(
+            PyCapsule_GetPointer(obj, "dltensor"));
+        managed->destructor(managed);
+      });
+  CAFFE_ENFORCE(capsule, "Could not create DLPack capsule");
+  shared.release();
+  return py::reinterpret_steal<py::object>(capsule);
+}
+
 } // namespace python
 } // namespace caffe2
@@ -35,6 +35,10 @@ void addHIPGlobalMethods(py::module& m)
         CAFFE_ENFORCE(caffe2::GetHipPeerAccessPattern(&pattern));
         return pattern;
     });
+    m.def("initialize_hip_devices", [](const std::vector<int>& gpu_ids) {
+        py::gil_scoped_release g;
+        InitializeHipDevices(gpu_ids);
+    });
     m.def("get_device_properties", [](int deviceid) {
         auto& prop = GetDeviceProperty(deviceid);
         std::map<std::string, py::object> obj;
@@ -43,6 +47,59 @@ void addHIPGlobalMethods(py::module& m)
         obj["minor"] = py::cast(prop.minor);
         return obj;
     });
+    // Zero-copy counterparts of fetch_blob/feed_blob: the DLPack tensor and
+    // the blob share the same device memory, without going through numpy.
+    m.def("fetch_blob_dlpack", [](Workspace* ws, const std::string& name) {
+        CAFFE_ENFORCE(ws);
+        const auto* blob = ws->GetBlob(name);
+        CAFFE_ENFORCE(blob, "Can't find blob: ", name);
+        DeviceOption option;
+        if(blob->IsType<TensorHIP>())
+        {
+            const auto& tensor = blob->Get<TensorHIP>();
+            option.set_device_type(HIP);
+            option.set_hip_gpu_id(GetGPUIDForPointer(tensor.raw_data()));
+            return ShareTensorToDLPack(tensor, option);
+        }
+        CAFFE_ENFORCE(blob->IsType<TensorCPU>(),
+                      "Blob ",
+                      name,
+                      " is not a tensor, but ",
+                      blob->meta().name());
+        option.set_device_type(CPU);
+        return ShareTensorToDLPack(blob->Get<TensorCPU>(), option);
+    });
+    m.def("feed_blob_dlpack",
+          [](Workspace* ws, const std::string& name, py::object obj, py::object device_option) {
+              CAFFE_ENFORCE(ws);
+              DeviceOption option;
+              if(!device_option.is(py::none()))
+              {
+                  CAFFE_ENFORCE(
+                      option.ParseFromString(py::bytes(device_option).cast<std::string>()));
+              }
+              auto* blob = ws->CreateBlob(name);
+              if(option.device_type() == HIP)
+              {
+                  DLPackWrapper<HIPContext> wrapper(blob->GetMutable<TensorHIP>(), option);
+                  wrapper.feed(obj);
+              }
+              else
+              {
+                  CAFFE_ENFORCE_EQ(option.device_type(),
+                                   CPU,
+                                   "Unsupported device type for DLPack feed: ",
+                                   option.device_type());
+                  DLPackWrapper<CPUContext> wrapper(blob->GetMutable<TensorCPU>(), option);
+                  wrapper.feed(obj);
+              }
+              return true;
+          },
+          "",
+          py::arg("workspace"),
+          py::arg("name"),
+          py::arg("arg"),
+          py::arg("device_option") = py::none());
 };
 
 void addHIPObjectMethods(py::module& m)
@@ -0,0 +1,176 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+## @package shm_data_workers
+# Module caffe2.python.shm_data_workers
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+
+'''
+This module provides a multiprocess data input mechanism for Caffe2 nets:
+the fetcher functions run in worker processes, out of the GIL of the
+trainer, and hand their batches over through a shared memory queue (see
+contrib/shm_mutex/shm_queue.h) instead of FeedBlob. It requires Caffe2 to be
+built with USE_SHM_MUTEX.
+
+Basic usage is as follows:
+   coordinator = shm_data_workers.init_shm_data_input_workers(
+      net,
+      ["data", "label"],
+      my_fetch_fun,
+      batch_size=32,
+      slot_bytes=32 * (3 * 224 * 224 + 1) * 4,
+      num_worker_processes=4,
+   )
+   ...
+   coordinator.start()
+   ...
+   coordinator.stop()
+
+The fetcher function has the call signature of the data_workers ones,
+   my_fetch_fun(worker_id, batch_size)
+and returns a list of numpy arrays, one per input blob. It runs in a forked
+process with a workspace of its own, so it must not rely on state of the
+trainer changed after start() nor use GPUs. Each list is a record of the
+queue, fed as is (there is no rebatching to batch_size), and has to fit in
+'slot_bytes' bytes, the tensors taking their size rounded up to 64 bytes.
+
+The net gets a SharedMemoryQueueDequeue op that sets the input blobs to the
+next record without copying it, so init_shm_data_input_workers has to be
+called before the ops reading the input blobs are added. The record stays in
+its slot until the next run of the net dequeues the following one.
+
+'timeout' is the timeout in seconds after which if no data is available, the
+net will fail (default 600s = 10 mins).
+'''
+
+import itertools
+import logging
+import multiprocessing
+import os
+
+from caffe2.python import core, workspace
+
+log = logging.getLogger("shm_data_workers")
+log.setLevel(logging.INFO)
+
+_segment_ids = itertools.count()
+
+
+def init_shm_data_input_workers(
+    net,
+    input_blob_names,
+    fetch_fun,
+    batch_size,
+    slot_bytes,
+    num_worker_processes=2,
+    num_slots=None,
+    segment=None,
+    timeout=600,
+):
+    if segment is None:
+        segment = "/caffe2_shm_data_{}_{}".format(
+            os.getpid(), next(_segment_ids))
+    if num_slots is None:
+        num_slots = max(2, 2 * num_worker_processes)
+    queue = core.ScopedBlobReference(
+        "shm_data_queue_{}".format(segment.lstrip("/")))
+    # Created by the trainer before the workers, which only open it.
+    workspace.RunOperatorOnce(
+        core.CreateOperator(
+            "CreateSharedMemoryQueue",
+            [], [queue],
+            segment=segment,
+            num_slots=num_slots,
+            num_blobs=len(input_blob_names),
+            slot_bytes=slot_bytes,
+            recreate=True))
+    net.SharedMemoryQueueDequeue(
+        queue, input_blob_names, timeout_secs=float(timeout))
+    return ShmDataInputCoordinator(
+        segment, queue, input_blob_names, fetch_fun, batch_size,
+        num_worker_processes)
+
+
+class ShmDataInputCoordinator(object):
+    def __init__(self, segment, queue, input_blob_names, fetch_fun,
+                 batch_size, num_worker_processes):
+        self._segment = segment
+        self._queue = queue
+        self._input_blob_names = [str(b) for b in input_blob_names]
+        self._fetch_fun = fetch_fun
+        self._batch_size = batch_size
+        self._num_worker_processes = num_worker_processes
+        self._processes = []
+
+    def start(self):
+        assert not self._processes, "Workers already started"
+        for worker_id in range(self._num_worker_processes):
+            process = multiprocessing.Process(
+                target=_run_worker,
+                name="shm_data_workers fetcher id {}".format(worker_id),
+                args=[self._segment, self._input_blob_names,
+                      self._fetch_fun, worker_id, self._batch_size],
+            )
+            process.daemon = True
+            process.start()
+            self._processes.append(process)
+
+    def stop(self, timeout=10):
+        '''
+        Closes the queue, which stops the workers, and removes its segment.
+        '''
+        workspace.RunOperatorOnce(
+            core.CreateOperator(
+                "CloseSharedMemoryQueue", [self._queue], [], unlink=True))
+        success = True
+        for process in self._processes:
+            process.join(timeout)
+            if process.is_alive():
+                log.warning("Worker {} did not stop, terminating it".format(
+                    process.name))
+                process.terminate()
+                success = False
+            elif process.exitcode != 0:
+                log.error("Worker {} exited with code {}".format(
+                    process.name, process.exitcode))
+                success = False
+        self._processes = []
+        return success
+
+
+def _run_worker(segment, input_blob_names, fetch_fun, worker_id, batch_size):
+    workspace.SwitchWorkspace(
+        "shm_data_workers_{}".format(worker_id), True)
+    queue = "shm_data_queue"
+    status = "shm_data_queue_closed"
+    workspace.RunOperatorOnce(
+        core.CreateOperator(
+            "CreateSharedMemoryQueue", [], [queue], segment=segment))
+    net = core.Net("shm_data_workers_enqueue_{}".format(worker_id))
+    net.SharedMemoryQueueEnqueue([queue] + input_blob_names, [status])
+    workspace.CreateNet(net)
+    while True:
+        data = fetch_fun(worker_id, batch_size)
+        assert len(data) == len(input_blob_names), \
+            "Expecting data blob for each input"
+        for blob_name, value in zip(input_blob_names, data):
+            workspace.FeedBlob(blob_name, value)
+        workspace.RunNet(net.Proto().name)
+        if workspace.FetchBlob(status):
+            return
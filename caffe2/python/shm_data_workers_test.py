@@ -0,0 +1,119 @@
+# Copyright (c) 2016-present, Facebook, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+##############################################################################
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import numpy as np
+import os
+import unittest
+
+from caffe2.python import core, workspace, model_helper
+from caffe2.python import timeout_guard
+import caffe2.python.shm_data_workers as shm_data_workers
+
+
+def dummy_fetcher(fetcher_id, batch_size):
+    n = np.random.randint(batch_size) + 1
+    data = np.full((n, 3), fetcher_id, dtype=np.float32)
+    labels = np.arange(n, dtype=np.int32)
+    return [data, labels]
+
+
+@unittest.skipIf(not core.IsOperator('SharedMemoryQueueDequeue'),
+                 'Built without USE_SHM_MUTEX')
+class ShmDataWorkersTest(unittest.TestCase):
+
+    def testQueueOps(self):
+        workspace.ResetWorkspace()
+        segment = "/caffe2_shm_queue_test_{}".format(os.getpid())
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "CreateSharedMemoryQueue", [], ["queue"], segment=segment,
+            num_slots=2, num_blobs=2, slot_bytes=1024, recreate=True))
+        enqueue = core.CreateOperator(
+            "SharedMemoryQueueEnqueue", ["queue", "x", "y"], ["closed"])
+        dequeue = core.CreateOperator(
+            "SharedMemoryQueueDequeue", ["queue"], ["x_out", "y_out", "empty"],
+            timeout_secs=1.0)
+
+        records = [
+            (np.random.rand(4, 5).astype(np.float32),
+             np.arange(i, dtype=np.int64))
+            for i in range(5)
+        ]
+        for x, y in records:
+            workspace.FeedBlob("x", x)
+            workspace.FeedBlob("y", y)
+            workspace.RunOperatorOnce(enqueue)
+            self.assertFalse(workspace.FetchBlob("closed"))
+            workspace.RunOperatorOnce(dequeue)
+            self.assertFalse(workspace.FetchBlob("empty"))
+            np.testing.assert_array_equal(workspace.FetchBlob("x_out"), x)
+            np.testing.assert_array_equal(workspace.FetchBlob("y_out"), y)
+
+        # The ready records are still read after the queue is closed.
+        workspace.RunOperatorOnce(enqueue)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "CloseSharedMemoryQueue", ["queue"], [], unlink=True))
+        workspace.RunOperatorOnce(enqueue)
+        self.assertTrue(workspace.FetchBlob("closed"))
+        workspace.RunOperatorOnce(dequeue)
+        self.assertFalse(workspace.FetchBlob("empty"))
+        workspace.RunOperatorOnce(dequeue)
+        self.assertTrue(workspace.FetchBlob("empty"))
+
+        # A record larger than the slots is rejected.
+        workspace.FeedBlob("x", np.zeros(1024, dtype=np.float32))
+        with self.assertRaises(RuntimeError):
+            workspace.RunOperatorOnce(enqueue)
+
+    def testWorkers(self):
+        workspace.ResetWorkspace()
+
+        model = model_helper.ModelHelper(name="test")
+        coordinator = shm_data_workers.init_shm_data_input_workers(
+            model,
+            ["data", "label"],
+            dummy_fetcher,
+            batch_size=32,
+            slot_bytes=32 * 4 * 4 + 128,
+            num_worker_processes=2,
+        )
+        coordinator.start()
+
+        workspace.RunNetOnce(model.param_init_net)
+        workspace.CreateNet(model.net)
+
+        seen_workers = set()
+        for _i in range(200):
+            with timeout_guard.CompleteInTimeOrDie(5):
+                workspace.RunNet(model.net.Proto().name)
+
+            data = workspace.FetchBlob("data")
+            labels = workspace.FetchBlob("label")
+            self.assertEqual(data.shape[1], 3)
+            self.assertEqual(data.shape[0], labels.shape[0])
+            self.assertTrue((data == data[0, 0]).all())
+            np.testing.assert_array_equal(labels, np.arange(labels.shape[0]))
+            seen_workers.add(int(data[0, 0]))
+
+        self.assertTrue(coordinator.stop())
+        self.assertTrue(seen_workers <= set([0, 1]))
+
+
+if __name__ == "__main__":
+    unittest.main()
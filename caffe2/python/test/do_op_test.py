@@ -72,6 +72,34 @@ class DoOpTest(TestCase):
         outer_Z_val = workspace.FetchBlob("outer_Z")
         self.assertTrue(np.all(outer_Z_val == np.asarray([3])))
 
+    def test_reused_workspace_copies(self):
+        # The second run reuses the workspace of the first one, which holds
+        # local copies of the external blobs.
+        subnet = core.Net("subnet")
+        subnet.Add(["X", "Y"], "Z")
+
+        net = core.Net("net")
+        net.CreateScope([], "W")
+        net.Do(
+            ["outer_X", "outer_Y", "W"],
+            ["outer_Z", "W"],
+            net=subnet.Proto(),
+            inner_blobs=["X", "Y", "Z"],
+            outer_blobs_idx=[0, 1, 2],
+            copy_external_blobs=True,
+        )
+
+        workspace.ResetWorkspace()
+        workspace.FeedBlob("outer_X", np.asarray([1, 2]))
+        workspace.FeedBlob("outer_Y", np.asarray([3, 4]))
+        workspace.CreateNet(net)
+        for i in range(3):
+            workspace.FeedBlob("outer_X", np.asarray([1, 2]) * i)
+            workspace.RunNet(net.Name())
+            outer_Z_val = workspace.FetchBlob("outer_Z")
+            self.assertTrue(
+                np.all(outer_Z_val == np.asarray([1, 2]) * i + [3, 4]))
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -28,7 +28,8 @@ class TextFileReader(Reader):
     """
     Wrapper around operators for reading from text files.
     """
-    def __init__(self, init_net, filename, schema, num_passes=1, batch_size=1):
+    def __init__(self, init_net, filename, schema, num_passes=1, batch_size=1,
+                 num_threads=1):
         """
         Create op for building a TextFileReader instance in the workspace.
 
@@ -39,6 +40,7 @@ class TextFileReader(Reader):
                          Currently, only support Struct of strings.
             num_passes : Number of passes over the data.
             batch_size : Number of rows to read at a time.
+            num_threads: Number of threads parsing the rows of a batch.
         """
         assert isinstance(schema, Struct), 'Schema must be a schema.Struct'
         for name, child in schema.get_children():
@@ -51,6 +53,7 @@ class TextFileReader(Reader):
             [],
             filename=filename,
             num_passes=num_passes,
+            num_threads=num_threads,
             field_types=field_types)
         self._batch_size = batch_size
 
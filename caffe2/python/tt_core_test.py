@@ -20,6 +20,8 @@ from __future__ import unicode_literals
 
 import numpy as np
 import unittest
+from hypothesis import given
+import hypothesis.strategies as st
 
 from caffe2.python import core, workspace, tt_core
 import caffe2.python.hypothesis_test_util as hu
@@ -92,6 +94,34 @@ class TestTTSVD(hu.HypothesisTestCase):
         self.assertAlmostEquals(np.linalg.norm(Y_fc - Y_sparse_tt),
                                 39.974, delta=1e-3)
 
+    @given(batch_size=st.integers(1, 8), **hu.gcs)
+    def test_full_tt_batch(self, batch_size, gc, dc):
+        inp_sizes = [2, 3, 2]
+        out_sizes = [3, 2, 2]
+        size = 12
+        X = np.random.rand(batch_size, size).astype(np.float32) - 0.5
+        W = np.random.rand(size, size).astype(np.float32) - 0.5
+        b = np.random.rand(size).astype(np.float32) - 0.5
+
+        # Full ranks make the decomposition exact.
+        full_tt_ranks = [1, 6, 4, 1]
+        cores = tt_core.matrix_to_tt(W, inp_sizes, out_sizes, full_tt_ranks)
+        op = core.CreateOperator(
+            "TT",
+            ["X", "b", "cores"],
+            ["Y"],
+            inp_sizes=inp_sizes,
+            out_sizes=out_sizes,
+            tt_ranks=full_tt_ranks,
+        )
+
+        def fc_ref(X, b, cores):
+            return [np.dot(X, W.transpose()) + b]
+
+        self.assertReferenceChecks(
+            gc, op, [X, b, cores], fc_ref, threshold=1e-3)
+        self.assertDeviceChecks(dc, op, [X, b, cores], [0])
+
 
 if __name__ == '__main__':
     unittest.main()
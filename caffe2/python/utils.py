@@ -243,6 +243,39 @@ def GetGPUMemoryUsageStats():
     }
 
 
+def GetGPUMemoryPoolStats():
+    """Get the memory pool counters of every GPU, as a list of dicts. The
+       fragmentation is the share of the free cached memory that is not in
+       the largest free block."""
+    from caffe2.python import workspace, core
+    workspace.RunOperatorOnce(
+        core.CreateOperator(
+            "GetGPUMemoryPoolStats",
+            [],
+            ["____mem_pool____"],
+            device_option=core.DeviceOption(caffe2_pb2.HIP, 0),
+        ),
+    )
+    b = workspace.FetchBlob("____mem_pool____")
+    stats = []
+    for row in b:
+        allocated, cached, largest_free, allocs, hits, segments = \
+            [int(v) for v in row]
+        free = cached - allocated
+        stats.append({
+            'allocated_bytes': allocated,
+            'cached_bytes': cached,
+            'largest_free_block': largest_free,
+            'num_allocs': allocs,
+            'num_cache_hits': hits,
+            'num_segments': segments,
+            'hit_rate': float(hits) / allocs if allocs > 0 else 0.0,
+            'fragmentation':
+                1.0 - float(largest_free) / free if free > 0 else 0.0,
+        })
+    return stats
+
+
 def ResetBlobs(blobs):
     from caffe2.python import workspace, core
     workspace.RunOperatorOnce(
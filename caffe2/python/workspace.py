@@ -42,6 +42,7 @@ Blobs = C.blobs
 CreateBlob = C.create_blob
 CurrentWorkspace = C.current_workspace
 DeserializeBlob = C.deserialize_blob
+GetBlob = C.get_blob
 GlobalInit = C.global_init
 HasBlob = C.has_blob
 RegisteredOperators = C.registered_operators
@@ -50,6 +51,7 @@ SwitchWorkspace = C.switch_workspace
 RootFolder = C.root_folder
 Workspaces = C.workspaces
 BenchmarkNet = C.benchmark_net
+DumpAsyncNetTrace = C.dump_async_net_trace
 GetStats = C.get_stats
 
 operator_tracebacks = defaultdict(dict)
@@ -73,6 +75,34 @@ if has_gpu_support:
         return np.asarray(C.get_hip_peer_access_pattern())
 
     GetDeviceProperties = C.get_device_properties
+
+    if has_hip:
+        def InitializeHipDevices(gpu_ids):
+            """Initializes the given devices in parallel.
+
+            Devices are otherwise initialized one by one, the first time they
+            are used.
+            """
+            C.initialize_hip_devices(list(gpu_ids))
+
+        def FetchBlobDLPack(name):
+            """Fetches a tensor blob as a DLPack capsule sharing its memory."""
+            return C.fetch_blob_dlpack(
+                C.Workspace.current, StringifyBlobName(name))
+
+        def FeedBlobDLPack(name, capsule, device_option=None):
+            """Feeds a DLPack capsule into a blob without copying its data.
+
+            The device option defaults to the current device scope and has to
+            match the device of the DLPack tensor.
+            """
+            if device_option is None:
+                device_option = scope.CurrentDeviceScope()
+            return C.feed_blob_dlpack(
+                C.Workspace.current,
+                StringifyBlobName(name),
+                capsule,
+                StringifyProto(device_option) if device_option else None)
 else:
     NumHipDevices = lambda: 0 # noqa
     SetDefaultGPUID = lambda x: None # noqa
@@ -80,6 +110,7 @@ else:
     #GetCuDNNVersion = lambda: 0 # noqa
     #GetCuDNNVersion = lambda: 0 # noqa
     GetHipPeerAccessPattern = lambda: np.array([]) # noqa
+    InitializeHipDevices = lambda x: None # noqa
     GetDeviceProperties = lambda x: None # noqa
 
 
@@ -309,15 +340,51 @@ def FeedBlob(name, arr, device_option=None):
     Returns:
       True or False, stating whether the feed is successful.
     """
+    if device_option is None:
+        device_option = scope.CurrentDeviceScope()
+    arr = _PrepareFeedArray(name, arr, device_option)
+
+    name = StringifyBlobName(name)
+    if device_option is not None:
+        return C.feed_blob(name, arr, StringifyProto(device_option))
+    else:
+        return C.feed_blob(name, arr)
+
+
+def FeedBlobs(blobs, device_option=None):
+    """Feeds several blobs into the workspace in a single call.
+
+    Numpy arrays fed to CPU are copied with the GIL released, spread over
+    several threads when there is enough data.
+
+    Inputs:
+      blobs: a dict (or a list of pairs) from blob names to TensorProto
+          objects, numpy arrays or strings, as accepted by FeedBlob.
+      device_option (optional): the device option to feed all the data with.
+    Returns:
+      True or False, stating whether the feed is successful.
+    """
+    if device_option is None:
+        device_option = scope.CurrentDeviceScope()
+    items = blobs.items() if isinstance(blobs, dict) else blobs
+    names = []
+    arrs = []
+    for name, arr in items:
+        arrs.append(_PrepareFeedArray(name, arr, device_option))
+        names.append(StringifyBlobName(name))
+    if device_option is not None:
+        return C.feed_blobs(names, arrs, StringifyProto(device_option))
+    else:
+        return C.feed_blobs(names, arrs)
+
+
+def _PrepareFeedArray(name, arr, device_option):
     if type(arr) is caffe2_pb2.TensorProto:
         arr = utils.Caffe2TensorToNumpyArray(arr)
     if type(arr) is np.ndarray and arr.dtype.kind in 'SU':
         # Plain NumPy strings are weird, let's use objects instead
         arr = arr.astype(np.object)
 
-    if device_option is None:
-        device_option = scope.CurrentDeviceScope()
-
     if device_option and device_option.device_type == caffe2_pb2.HIP:
         if arr.dtype == np.dtype('float64'):
             logger.warning(
@@ -326,23 +393,23 @@ def FeedBlob(name, arr, device_option=None):
                 " Blob: {}".format(name) +
                 " type: {}".format(str(arr.dtype))
             )
-
-    name = StringifyBlobName(name)
-    if device_option is not None:
-        return C.feed_blob(name, arr, StringifyProto(device_option))
-    else:
-        return C.feed_blob(name, arr)
+    return arr
 
 
-def FetchBlobs(names):
+def FetchBlobs(names, outputs=None):
     """Fetches a list of blobs from the workspace.
 
+    CPU tensors are copied with the GIL released in a single call.
+
     Inputs:
         names: list of names of blobs - strings or BlobReferences
+        outputs (optional): list of numpy arrays, one per blob, to copy the
+            tensors into. Entries that are None or do not match the tensor's
+            dtype and shape are replaced by newly allocated arrays.
     Returns:
         list of fetched blobs
     """
-    return [FetchBlob(name) for name in names]
+    return C.fetch_blobs([StringifyBlobName(name) for name in names], outputs)
 
 
 def FetchBlob(name):
@@ -249,6 +249,32 @@ class TestWorkspace(unittest.TestCase):
         self.assertEquals(s1, fetch1)
         self.assertEquals(s2, fetch2)
 
+    def testFeedFetchBlobs(self):
+        small = np.random.rand(3, 4).astype(np.float32)
+        large = np.random.rand(1 << 19).astype(np.float64)
+        self.assertTrue(workspace.FeedBlobs(
+            {'small': small, 'large': large[::2], 'str': b'text'}))
+        fetched = workspace.FetchBlobs(['small', 'large', 'str'])
+        np.testing.assert_array_equal(fetched[0], small)
+        np.testing.assert_array_equal(fetched[1], large[::2])
+        self.assertEqual(fetched[2], b'text')
+
+        outputs = [np.empty((3, 4), dtype=np.float32), np.empty(1), None]
+        fetched = workspace.FetchBlobs(['small', 'large', 'str'], outputs)
+        self.assertIs(fetched[0], outputs[0])
+        self.assertIsNot(fetched[1], outputs[1])
+        np.testing.assert_array_equal(outputs[0], small)
+        np.testing.assert_array_equal(fetched[1], large[::2])
+
+    def testGetBlob(self):
+        workspace.FeedBlob('handle', np.arange(4, dtype=np.float32))
+        blob = workspace.GetBlob('handle')
+        np.testing.assert_array_equal(blob.fetch(), np.arange(4))
+        blob.feed(np.ones(2, dtype=np.float32))
+        np.testing.assert_array_equal(workspace.FetchBlob('handle'), [1, 1])
+        with self.assertRaises(RuntimeError):
+            workspace.GetBlob('not_a_blob')
+
     def testFetchFeedViaBlobDict(self):
         self.assertEqual(
             workspace.RunNetOnce(self.net.Proto().SerializeToString()), True)
@@ -335,6 +361,18 @@ class TestWorkspaceGPU(test_util.TestCase):
         self.assertEqual(pattern.shape[0], pattern.shape[1])
         self.assertEqual(pattern.shape[0], workspace.NumGpuDevices())
 
+    @unittest.skipIf(not workspace.has_hip, "No HIP support.")
+    def testInitializeHipDevices(self):
+        devices = list(range(workspace.NumHipDevices()))
+        workspace.InitializeHipDevices(devices)
+        # Initializing again is a no-op, and the devices work as usual.
+        workspace.InitializeHipDevices(devices)
+        for gpu_id in devices:
+            arr = np.random.randn(3).astype(np.float32)
+            workspace.FeedBlob(
+                "testblob", arr, core.DeviceOption(caffe2_pb2.HIP, gpu_id))
+            np.testing.assert_array_equal(workspace.FetchBlob("testblob"), arr)
+
 
 @unittest.skipIf(not workspace.C.has_mkldnn, "No MKLDNN support.")
 class TestWorkspaceMKLDNN(test_util.TestCase):
@@ -21,6 +21,7 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <thread>
 
 #include "caffe2/core/blob_stats.h"
 #include "caffe2/core/logging.h"
@@ -37,6 +38,9 @@ static constexpr uint64_t SDT_TIMEOUT = (uint64_t)-1;
 static constexpr uint64_t SDT_ABORT = (uint64_t)-2;
 static constexpr uint64_t SDT_CANCEL = (uint64_t)-3;
 
+// Number of attempts a blocked LockFreeBlobsQueue call makes before it sleeps.
+static constexpr int kLockFreeSpinCount = 64;
+
 BlobsQueue::BlobsQueue(
     Workspace* ws,
     const std::string& queueName,
@@ -173,4 +177,206 @@ void BlobsQueue::doWrite(const std::vector<Blob*>& inputs) {
   cv_.notify_all();
 }
 
+LockFreeBlobsQueue::LockFreeBlobsQueue(
+    Workspace* ws,
+    const std::string& queueName,
+    size_t capacity,
+    size_t numBlobs,
+    bool enforceUniqueName,
+    const std::vector<std::string>& fieldNames)
+    : BlobsQueue(
+          ws,
+          queueName,
+          capacity,
+          numBlobs,
+          enforceUniqueName,
+          fieldNames),
+      capacity_(capacity),
+      sequence_(new std::atomic<int64_t>[capacity]) {
+  CAFFE_ENFORCE_GT(capacity, 0, "A lock free queue needs a capacity");
+  // Slot i is free for the writer at position i
+  for (int64_t i = 0; i < capacity_; ++i) {
+    sequence_[i].store(i, std::memory_order_relaxed);
+  }
+}
+
+bool LockFreeBlobsQueue::tryClaimWrite(int64_t* pos) {
+  int64_t writer = writer_.load(std::memory_order_relaxed);
+  while (true) {
+    const int64_t seq =
+        sequence_[writer % capacity_].load(std::memory_order_acquire);
+    if (seq == writer) {
+      if (writer_.compare_exchange_weak(
+              writer, writer + 1, std::memory_order_relaxed)) {
+        *pos = writer;
+        return true;
+      }
+    } else if (seq < writer) {
+      // The slot still holds the record written a lap ago
+      return false;
+    } else {
+      writer = writer_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool LockFreeBlobsQueue::tryClaimRead(int64_t* pos) {
+  int64_t reader = reader_.load(std::memory_order_relaxed);
+  while (true) {
+    const int64_t seq =
+        sequence_[reader % capacity_].load(std::memory_order_acquire);
+    if (seq == reader + 1) {
+      if (reader_.compare_exchange_weak(
+              reader, reader + 1, std::memory_order_relaxed)) {
+        *pos = reader;
+        return true;
+      }
+    } else if (seq < reader + 1) {
+      // The record at this position is not written yet
+      return false;
+    } else {
+      reader = reader_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void LockFreeBlobsQueue::doWrite(
+    int64_t pos,
+    const std::vector<Blob*>& inputs) {
+  auto& result = queue_[pos % capacity_];
+  CAFFE_ENFORCE(inputs.size() >= result.size());
+  for (auto i = 0; i < result.size(); ++i) {
+    using std::swap;
+    swap(*(inputs[i]), *(result[i]));
+  }
+  sequence_[pos % capacity_].store(pos + 1, std::memory_order_release);
+  CAFFE_SDT(
+      queue_write_end,
+      name_.c_str(),
+      (void*)this,
+      reader_.load(std::memory_order_relaxed) + capacity_ - pos - 1);
+  wakeWaiters();
+}
+
+void LockFreeBlobsQueue::doRead(
+    int64_t pos,
+    const std::vector<Blob*>& inputs) {
+  auto& result = queue_[pos % capacity_];
+  CAFFE_ENFORCE(inputs.size() >= result.size());
+  for (auto i = 0; i < result.size(); ++i) {
+    auto bytes = BlobStat::sizeBytes(*result[i]);
+    CAFFE_EVENT(stats_, queue_dequeued_bytes, bytes, i);
+    using std::swap;
+    swap(*(inputs[i]), *(result[i]));
+  }
+  // Free the slot for the writer of the next lap
+  sequence_[pos % capacity_].store(pos + capacity_, std::memory_order_release);
+  CAFFE_SDT(
+      queue_read_end,
+      name_.c_str(),
+      (void*)this,
+      writer_.load(std::memory_order_relaxed) - pos - 1);
+  CAFFE_EVENT(stats_, queue_dequeued_records);
+  wakeWaiters();
+}
+
+template <typename Claim>
+bool LockFreeBlobsQueue::waitFor(Claim claim, float timeout_secs) {
+  for (int i = 0; i < kLockFreeSpinCount; ++i) {
+    if (claim()) {
+      return true;
+    }
+    if (closing_) {
+      return false;
+    }
+    std::this_thread::yield();
+  }
+
+  const auto deadline = std::chrono::steady_clock::now() +
+      std::chrono::milliseconds(int(timeout_secs * 1000));
+  std::unique_lock<std::mutex> g(waitMutex_);
+  waiters_.fetch_add(1);
+  // Pairs with the fence in wakeWaiters(): either the waker sees us waiting,
+  // or we see the slot it has just published.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  bool claimed = claim();
+  while (!claimed && !closing_) {
+    if (timeout_secs > 0) {
+      if (waitCv_.wait_until(g, deadline) == std::cv_status::timeout) {
+        claimed = claim();
+        break;
+      }
+    } else {
+      waitCv_.wait(g);
+    }
+    claimed = claim();
+  }
+  waiters_.fetch_sub(1);
+  return claimed;
+}
+
+void LockFreeBlobsQueue::wakeWaiters() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiters_.load(std::memory_order_relaxed) > 0) {
+    std::lock_guard<std::mutex> g(waitMutex_);
+    waitCv_.notify_all();
+  }
+}
+
+bool LockFreeBlobsQueue::blockingRead(
+    const std::vector<Blob*>& inputs,
+    float timeout_secs) {
+  auto keeper = this->shared_from_this();
+  const auto& name = name_.c_str();
+  CAFFE_SDT(queue_read_start, name, (void*)this, SDT_BLOCKING_OP);
+  CAFFE_EVENT(stats_, queue_balance, -1);
+  int64_t pos;
+  if (!waitFor([this, &pos]() { return tryClaimRead(&pos); }, timeout_secs)) {
+    if (timeout_secs > 0 && !closing_) {
+      LOG(ERROR) << "DequeueBlobs timed out in " << timeout_secs << " secs";
+      CAFFE_SDT(queue_read_end, name, (void*)this, SDT_TIMEOUT);
+    } else {
+      CAFFE_SDT(queue_read_end, name, (void*)this, SDT_CANCEL);
+    }
+    return false;
+  }
+  doRead(pos, inputs);
+  return true;
+}
+
+bool LockFreeBlobsQueue::tryWrite(const std::vector<Blob*>& inputs) {
+  auto keeper = this->shared_from_this();
+  const auto& name = name_.c_str();
+  CAFFE_SDT(queue_write_start, name, (void*)this, SDT_NONBLOCKING_OP);
+  int64_t pos;
+  if (!tryClaimWrite(&pos)) {
+    CAFFE_SDT(queue_write_end, name, (void*)this, SDT_ABORT);
+    return false;
+  }
+  CAFFE_EVENT(stats_, queue_balance, 1);
+  doWrite(pos, inputs);
+  return true;
+}
+
+bool LockFreeBlobsQueue::blockingWrite(const std::vector<Blob*>& inputs) {
+  auto keeper = this->shared_from_this();
+  const auto& name = name_.c_str();
+  CAFFE_SDT(queue_write_start, name, (void*)this, SDT_BLOCKING_OP);
+  CAFFE_EVENT(stats_, queue_balance, 1);
+  int64_t pos;
+  if (!waitFor([this, &pos]() { return tryClaimWrite(&pos); }, 0.0f)) {
+    CAFFE_SDT(queue_write_end, name, (void*)this, SDT_ABORT);
+    return false;
+  }
+  doWrite(pos, inputs);
+  return true;
+}
+
+void LockFreeBlobsQueue::close() {
+  closing_ = true;
+
+  std::lock_guard<std::mutex> g(waitMutex_);
+  waitCv_.notify_all();
+}
+
 } // namespace caffe2
@@ -31,7 +31,8 @@
 namespace caffe2 {
 
 // A thread-safe, bounded, blocking queue.
-// Modelled as a circular buffer.
+// Modelled as a circular buffer. See LockFreeBlobsQueue below for a variant
+// that does not lock.
 
 // Containing blobs are owned by the workspace.
 // On read, we swap out the underlying data for the blob passed in for blobs
@@ -46,31 +47,24 @@ class BlobsQueue : public std::enable_shared_from_this<BlobsQueue> {
       bool enforceUniqueName,
       const std::vector<std::string>& fieldNames = {});
 
-  ~BlobsQueue() {
+  virtual ~BlobsQueue() {
     close();
   }
 
-  bool blockingRead(
+  virtual bool blockingRead(
       const std::vector<Blob*>& inputs,
       float timeout_secs = 0.0f);
-  bool tryWrite(const std::vector<Blob*>& inputs);
-  bool blockingWrite(const std::vector<Blob*>& inputs);
-  void close();
+  virtual bool tryWrite(const std::vector<Blob*>& inputs);
+  virtual bool blockingWrite(const std::vector<Blob*>& inputs);
+  virtual void close();
   size_t getNumBlobs() const {
     return numBlobs_;
   }
 
- private:
-  bool canWrite();
-  void doWrite(const std::vector<Blob*>& inputs);
-
+ protected:
   std::atomic<bool> closing_{false};
 
   size_t numBlobs_;
-  std::mutex mutex_; // protects all variables in the class.
-  std::condition_variable cv_;
-  int64_t reader_{0};
-  int64_t writer_{0};
   std::vector<std::vector<Blob*>> queue_;
   const std::string name_;
 
@@ -80,5 +74,72 @@ class BlobsQueue : public std::enable_shared_from_this<BlobsQueue> {
     CAFFE_EXPORTED_STAT(queue_dequeued_records);
     CAFFE_DETAILED_EXPORTED_STAT(queue_dequeued_bytes);
   } stats_;
+
+ private:
+  bool canWrite();
+  void doWrite(const std::vector<Blob*>& inputs);
+
+  std::mutex mutex_; // protects reader_, writer_ and the slots.
+  std::condition_variable cv_;
+  int64_t reader_{0};
+  int64_t writer_{0};
+};
+
+// A BlobsQueue where readers and writers claim slots with a compare-and-swap
+// on their cursor instead of taking a lock, so that many reader nets can feed
+// from one queue without contending on it. Every slot carries a sequence
+// number telling whether it is free for the writer at a position or filled
+// for the reader at that position (a bounded MPMC ring as described by
+// Dmitry Vyukov). Blobs are swapped in and out of the slots like in
+// BlobsQueue.
+//
+// Blocked calls spin for a little while and then sleep on a condition
+// variable that is only notified when someone is waiting.
+class LockFreeBlobsQueue : public BlobsQueue {
+ public:
+  LockFreeBlobsQueue(
+      Workspace* ws,
+      const std::string& queueName,
+      size_t capacity,
+      size_t numBlobs,
+      bool enforceUniqueName,
+      const std::vector<std::string>& fieldNames = {});
+
+  ~LockFreeBlobsQueue() override {
+    close();
+  }
+
+  bool blockingRead(const std::vector<Blob*>& inputs, float timeout_secs = 0.0f)
+      override;
+  bool tryWrite(const std::vector<Blob*>& inputs) override;
+  bool blockingWrite(const std::vector<Blob*>& inputs) override;
+  void close() override;
+
+ private:
+  // Claim the next position to write or read, return false if the queue is
+  // full or empty respectively.
+  bool tryClaimWrite(int64_t* pos);
+  bool tryClaimRead(int64_t* pos);
+  void doWrite(int64_t pos, const std::vector<Blob*>& inputs);
+  void doRead(int64_t pos, const std::vector<Blob*>& inputs);
+  // Waits until claim() succeeds. Returns false if the queue is closed, or
+  // after timeout_secs if it is positive.
+  template <typename Claim>
+  bool waitFor(Claim claim, float timeout_secs);
+  void wakeWaiters();
+
+  const int64_t capacity_;
+  std::unique_ptr<std::atomic<int64_t>[]> sequence_;
+  // The cursors are written by different threads, keep them on their own
+  // cache lines.
+  char pad0_[64];
+  std::atomic<int64_t> writer_{0};
+  char pad1_[64 - sizeof(std::atomic<int64_t>)];
+  std::atomic<int64_t> reader_{0};
+  char pad2_[64 - sizeof(std::atomic<int64_t>)];
+
+  std::atomic<int> waiters_{0};
+  std::mutex waitMutex_;
+  std::condition_variable waitCv_;
 };
 } // namespace caffe2
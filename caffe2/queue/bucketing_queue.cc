@@ -0,0 +1,300 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bucketing_queue.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace caffe2 {
+
+namespace {
+
+// Concatenates the elements along a new first dimension, padding every
+// tensor with zeros along its first dimension to the longest of the batch.
+template <typename Element>
+void padAndConcat(
+    CPUContext& context,
+    const std::vector<Element>& batch,
+    const std::vector<TensorCPU*>& outputs,
+    bool timeMajor) {
+  const TIndex batchSize = batch.size();
+  for (int j = 0; j < outputs.size(); ++j) {
+    const auto& first = batch[0].tensors[j];
+    auto* output = outputs[j];
+    if (first.ndim() == 0) {
+      output->Resize(batchSize);
+      auto* dst = static_cast<char*>(output->raw_mutable_data(first.meta()));
+      for (int i = 0; i < batchSize; ++i) {
+        const auto& input = batch[i].tensors[j];
+        CAFFE_ENFORCE(input.meta() == first.meta());
+        CAFFE_ENFORCE_EQ(input.ndim(), 0);
+        context.CopyItems<CPUContext, CPUContext>(
+            input.meta(), 1, input.raw_data(), dst + i * input.itemsize());
+      }
+      continue;
+    }
+
+    TIndex maxLength = 0;
+    for (const auto& element : batch) {
+      const auto& input = element.tensors[j];
+      CAFFE_ENFORCE(input.meta() == first.meta());
+      CAFFE_ENFORCE_EQ(input.ndim(), first.ndim());
+      for (int k = 1; k < input.ndim(); ++k) {
+        CAFFE_ENFORCE_EQ(input.dim(k), first.dim(k));
+      }
+      maxLength = std::max(maxLength, input.dim(0));
+    }
+    auto dims = first.dims();
+    dims[0] = maxLength;
+    dims.insert(timeMajor ? dims.begin() + 1 : dims.begin(), batchSize);
+    output->Resize(dims);
+    auto* dst = static_cast<char*>(output->raw_mutable_data(first.meta()));
+    const auto itemSize = first.itemsize();
+    const auto innerSize = first.size_from_dim(1);
+    bool padded = false;
+    for (const auto& element : batch) {
+      padded |= element.tensors[j].dim(0) != maxLength;
+    }
+    if (padded) {
+      // A reused output of a non-POD type (e.g. strings) would keep stale
+      // values in the padding.
+      CAFFE_ENFORCE(
+          !first.meta().copy(),
+          "Only tensors of POD types can be padded, got ",
+          first.meta().name());
+      std::memset(dst, 0, output->nbytes());
+    }
+
+    for (int i = 0; i < batchSize; ++i) {
+      const auto& input = batch[i].tensors[j];
+      const auto* src = static_cast<const char*>(input.raw_data());
+      if (!timeMajor) {
+        context.CopyItems<CPUContext, CPUContext>(
+            input.meta(),
+            input.size(),
+            src,
+            dst + i * maxLength * innerSize * itemSize);
+        continue;
+      }
+      for (int t = 0; t < input.dim(0); ++t) {
+        context.CopyItems<CPUContext, CPUContext>(
+            input.meta(),
+            innerSize,
+            src + t * innerSize * itemSize,
+            dst + (t * batchSize + i) * innerSize * itemSize);
+      }
+    }
+  }
+}
+} // anonymous namespace
+
+BucketingQueue::BucketingQueue(
+    size_t capacity,
+    size_t numBlobs,
+    std::vector<int64_t> bucketBoundaries,
+    size_t batchSize,
+    float maxLatencySecs,
+    size_t lengthBlob,
+    const std::string& name)
+    : capacity_(capacity),
+      numBlobs_(numBlobs),
+      bucketBoundaries_(std::move(bucketBoundaries)),
+      batchSize_(batchSize),
+      maxLatencySecs_(maxLatencySecs),
+      lengthBlob_(lengthBlob),
+      buckets_(bucketBoundaries_.size() + 1),
+      stats_(name) {
+  CAFFE_ENFORCE_GT(capacity_, 0);
+  CAFFE_ENFORCE_GT(batchSize_, 0);
+  CAFFE_ENFORCE_LT(lengthBlob_, numBlobs_);
+  CAFFE_ENFORCE(
+      std::is_sorted(bucketBoundaries_.begin(), bucketBoundaries_.end()),
+      "Bucket boundaries must be sorted");
+}
+
+BucketingQueue::~BucketingQueue() {
+  close();
+}
+
+size_t BucketingQueue::bucketFor(int64_t length) const {
+  return std::lower_bound(
+             bucketBoundaries_.begin(), bucketBoundaries_.end(), length) -
+      bucketBoundaries_.begin();
+}
+
+int BucketingQueue::readyBucket(
+    std::chrono::steady_clock::time_point now) const {
+  int oldest = -1;
+  int oldestFull = -1;
+  int fullest = -1;
+  for (int b = 0; b < buckets_.size(); ++b) {
+    const auto& bucket = buckets_[b];
+    if (bucket.empty()) {
+      continue;
+    }
+    const auto olderThan = [&](int other) {
+      return other < 0 ||
+          bucket.front().enqueueTime < buckets_[other].front().enqueueTime;
+    };
+    if (olderThan(oldest)) {
+      oldest = b;
+    }
+    if (bucket.size() >= batchSize_ && olderThan(oldestFull)) {
+      oldestFull = b;
+    }
+    if (fullest < 0 || bucket.size() > buckets_[fullest].size()) {
+      fullest = b;
+    }
+  }
+  if (oldestFull >= 0) {
+    return oldestFull;
+  }
+  if (size_ >= capacity_ || isClosed_) {
+    return fullest;
+  }
+  if (oldest >= 0 && maxLatencySecs_ > 0 &&
+      buckets_[oldest].front().enqueueTime +
+              std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                  std::chrono::duration<float>(maxLatencySecs_)) <=
+          now) {
+    return oldest;
+  }
+  return -1;
+}
+
+bool BucketingQueue::enqueue(
+    CPUContext& context,
+    const std::vector<const TensorCPU*>& inputs) {
+  CAFFE_ENFORCE_EQ(numBlobs_, inputs.size());
+  Element element;
+  element.tensors.resize(inputs.size());
+  for (int i = 0; i < inputs.size(); ++i) {
+    element.tensors[i].CopyFrom(*inputs[i], &context);
+  }
+  const auto& lengthTensor = element.tensors[lengthBlob_];
+  CAFFE_ENFORCE_GE(
+      lengthTensor.ndim(), 1, "The length blob must have a length dimension");
+  element.length = lengthTensor.dim(0);
+  const auto bucket = bucketFor(element.length);
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cvOverflow_.wait(lock, [this] { return size_ < capacity_ || isClosed_; });
+    if (isClosed_) {
+      return false;
+    }
+    element.enqueueTime = std::chrono::steady_clock::now();
+    buckets_[bucket].push_back(std::move(element));
+    ++size_;
+  }
+  cvEmpty_.notify_all();
+  return true;
+}
+
+bool BucketingQueue::dequeue(
+    CPUContext& context,
+    const std::vector<TensorCPU*>& outputs,
+    TensorCPU* lengths,
+    bool timeMajor) {
+  CAFFE_ENFORCE_EQ(numBlobs_, outputs.size());
+  std::vector<Element> batch;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      const int b = readyBucket(std::chrono::steady_clock::now());
+      if (b >= 0) {
+        auto& bucket = buckets_[b];
+        const auto n = std::min(batchSize_, bucket.size());
+        for (int i = 0; i < n; ++i) {
+          batch.push_back(std::move(bucket.front()));
+          bucket.pop_front();
+        }
+        size_ -= n;
+        break;
+      }
+      if (isClosed_) {
+        return false;
+      }
+      if (maxLatencySecs_ > 0 && size_ > 0) {
+        // Wake up when the oldest element is due.
+        auto deadline = std::chrono::steady_clock::time_point::max();
+        for (const auto& bucket : buckets_) {
+          if (!bucket.empty()) {
+            deadline = std::min(deadline, bucket.front().enqueueTime);
+          }
+        }
+        cvEmpty_.wait_until(
+            lock,
+            deadline +
+                std::chrono::duration_cast<
+                    std::chrono::steady_clock::duration>(
+                    std::chrono::duration<float>(maxLatencySecs_)));
+      } else {
+        cvEmpty_.wait(lock);
+      }
+    }
+  }
+  cvOverflow_.notify_all();
+
+  padAndConcat(context, batch, outputs, timeMajor);
+  lengths->Resize(batch.size());
+  auto* lengthsData = lengths->mutable_data<int32_t>();
+  int64_t maxLength = 0;
+  int64_t items = 0;
+  for (int i = 0; i < batch.size(); ++i) {
+    lengthsData[i] = batch[i].length;
+    maxLength = std::max(maxLength, batch[i].length);
+    items += batch[i].length;
+  }
+  CAFFE_EVENT(stats_, bucketing_queue_batches);
+  CAFFE_EVENT(stats_, bucketing_queue_items, items);
+  CAFFE_EVENT(
+      stats_, bucketing_queue_padding, maxLength * batch.size() - items);
+  return true;
+}
+
+size_t BucketingQueue::numBlobs() const {
+  return numBlobs_;
+}
+
+size_t BucketingQueue::numBuckets() const {
+  return buckets_.size();
+}
+
+std::vector<size_t> BucketingQueue::bucketSizes() const {
+  std::lock_guard<std::mutex> g(mutex_);
+  std::vector<size_t> sizes;
+  for (const auto& bucket : buckets_) {
+    sizes.push_back(bucket.size());
+  }
+  return sizes;
+}
+
+bool BucketingQueue::isClosed() const {
+  std::lock_guard<std::mutex> g(mutex_);
+  return isClosed_;
+}
+
+void BucketingQueue::close() {
+  {
+    std::lock_guard<std::mutex> g(mutex_);
+    isClosed_ = true;
+  }
+  cvEmpty_.notify_all();
+  cvOverflow_.notify_all();
+}
+} // caffe2
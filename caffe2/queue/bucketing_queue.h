@@ -0,0 +1,116 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "caffe2/core/logging.h"
+#include "caffe2/core/stats.h"
+#include "caffe2/core/tensor.h"
+
+namespace caffe2 {
+
+// A queue of variable length examples that batches them by length, so that
+// the batches of sequence models are padded as little as possible.
+//
+// Every element is one example, its length is the first dimension of its
+// lengthBlob-th tensor. It goes to the first bucket whose boundary is at
+// least that long, or into the last bucket if there is none. A batch is
+// dequeued from a single bucket:
+// - once the bucket holds batchSize elements;
+// - once the oldest element of the bucket has waited maxLatencySecs, if
+//   positive, as a partial batch;
+// - from the fullest bucket when the queue is full, so that producers never
+//   block forever on buckets that do not fill up;
+// - from whatever is left once the queue is closed.
+// Every tensor of the batch is padded with zeros along its first dimension
+// to the longest one of the batch (not to the bucket boundary).
+class BucketingQueue {
+ public:
+  BucketingQueue(
+      size_t capacity,
+      size_t numBlobs,
+      std::vector<int64_t> bucketBoundaries,
+      size_t batchSize,
+      float maxLatencySecs,
+      size_t lengthBlob,
+      const std::string& name);
+
+  ~BucketingQueue();
+
+  // Enqueues one example, its tensors are copied.
+  bool enqueue(
+      CPUContext& context,
+      const std::vector<const TensorCPU*>& inputs);
+
+  // Dequeues a batch into outputs, with the length of every element in
+  // lengths. If timeMajor, the padded tensors are laid out [T, N, ...]
+  // instead of [N, T, ...]. Returns false once the queue is closed and
+  // empty.
+  bool dequeue(
+      CPUContext& context,
+      const std::vector<TensorCPU*>& outputs,
+      TensorCPU* lengths,
+      bool timeMajor = false);
+
+  size_t numBlobs() const;
+  size_t numBuckets() const;
+  // Number of elements in every bucket.
+  std::vector<size_t> bucketSizes() const;
+
+  bool isClosed() const;
+  void close();
+
+ private:
+  struct Element {
+    std::vector<TensorCPU> tensors;
+    int64_t length;
+    std::chrono::steady_clock::time_point enqueueTime;
+  };
+
+  size_t bucketFor(int64_t length) const;
+  // The bucket a batch can be dequeued from right now, or -1.
+  int readyBucket(std::chrono::steady_clock::time_point now) const;
+
+  const size_t capacity_;
+  const size_t numBlobs_;
+  const std::vector<int64_t> bucketBoundaries_;
+  const size_t batchSize_;
+  const float maxLatencySecs_;
+  const size_t lengthBlob_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cvEmpty_;
+  std::condition_variable cvOverflow_;
+  bool isClosed_{false};
+  size_t size_{0};
+  std::vector<std::deque<Element>> buckets_;
+
+  struct BucketingQueueStats {
+    CAFFE_STAT_CTOR(BucketingQueueStats);
+    CAFFE_EXPORTED_STAT(bucketing_queue_batches);
+    // Items of the length dimension dequeued, and the padding added to them.
+    CAFFE_EXPORTED_STAT(bucketing_queue_items);
+    CAFFE_EXPORTED_STAT(bucketing_queue_padding);
+  } stats_;
+};
+} // caffe2
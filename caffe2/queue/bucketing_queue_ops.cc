@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bucketing_queue_ops.h"
+
+namespace caffe2 {
+
+CAFFE_KNOWN_TYPE(BucketingQueuePtr);
+
+namespace {
+
+REGISTER_CPU_OPERATOR(CreateBucketingQueue, CreateBucketingQueueOp);
+REGISTER_CPU_OPERATOR(EnqueueBucketingQueue, EnqueueBucketingQueueOp);
+REGISTER_CPU_OPERATOR(DequeueBucketingQueue, DequeueBucketingQueueOp);
+REGISTER_CPU_OPERATOR(CloseBucketingQueue, CloseBucketingQueueOp);
+
+NO_GRADIENT(CreateBucketingQueue);
+NO_GRADIENT(EnqueueBucketingQueue);
+NO_GRADIENT(DequeueBucketingQueue);
+NO_GRADIENT(CloseBucketingQueue);
+
+OPERATOR_SCHEMA(CreateBucketingQueue)
+    .NumInputs(0)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+      Creates a queue that batches variable length examples by length.
+
+      Every example goes to the first bucket whose boundary is at least its
+      length, the first dimension of its length_blob-th tensor, or to the
+      last bucket if it is longer than all boundaries. A batch is dequeued
+      from one bucket once it holds batch_size examples, once its oldest
+      example has waited max_latency_ms, when the queue is full, or when the
+      queue is closed. Batches are padded to their longest example instead
+      of the longest one of a random batch.
+)DOC")
+    .Output(0, "queue", "object representing the queue")
+    .Arg("num_blobs", "Number of tensors of every example")
+    .Arg("capacity", "Maximal number of examples the queue can hold")
+    .Arg(
+        "bucket_boundaries",
+        "Sorted list of the longest length of every bucket but the last one")
+    .Arg("batch_size", "Number of examples of a full batch")
+    .Arg(
+        "max_latency_ms",
+        "If positive, a bucket is flushed as a partial batch once its oldest "
+        "example has waited that many milliseconds. By default buckets are "
+        "only flushed when full, or when the queue is full or closed.")
+    .Arg(
+        "length_blob",
+        "Index of the tensor whose first dimension is the length of the "
+        "example. Defaults to 0");
+
+OPERATOR_SCHEMA(CloseBucketingQueue)
+    .NumInputs(1)
+    .NumOutputs(0)
+    .SetDoc(R"DOC(
+      Closes the queue. The examples left are still dequeued, batch by batch.
+)DOC")
+    .Input(0, "queue", "object representing the queue");
+
+OPERATOR_SCHEMA(EnqueueBucketingQueue)
+    .NumInputs(2, INT_MAX)
+    .NumOutputs(0)
+    .SetDoc(R"DOC(
+      Enqueues one example into the queue, as num_blobs tensors.
+      If the queue is closed this operation will fail.
+)DOC")
+    .Input(0, "queue", "object representing the queue")
+    .Input(1, "tensor", "First tensor of the example");
+
+OPERATOR_SCHEMA(DequeueBucketingQueue)
+    .NumInputs(1)
+    .NumOutputs(2, INT_MAX)
+    .SetDoc(R"DOC(
+      Dequeues a batch of examples of the same bucket.
+
+      Every tensor is stacked along a new batch dimension, and padded with
+      zeros along its first dimension to the longest one of the batch.
+      Scalars are stacked into vectors. The last output holds the length of
+      every example. Fails once the queue is closed and empty.
+)DOC")
+    .Input(0, "queue", "object representing the queue")
+    .Output(0, "tensor", "First tensor of the batch")
+    .Output(1, "lengths", "(last output) int32 length of every example")
+    .Arg(
+        "time_major",
+        "If set, padded tensors are laid out [T, N, ...] as the recurrent "
+        "ops expect, instead of [N, T, ...]");
+}
+}
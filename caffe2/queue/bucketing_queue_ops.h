@@ -0,0 +1,105 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "bucketing_queue.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+using BucketingQueuePtr = std::unique_ptr<BucketingQueue>;
+
+class CreateBucketingQueueOp : public Operator<CPUContext> {
+ public:
+  CreateBucketingQueueOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator(operator_def, ws), name_(operator_def.output(0)) {}
+
+  bool RunOnDevice() override {
+    *OperatorBase::Output<BucketingQueuePtr>(0) =
+        BucketingQueuePtr(new BucketingQueue(
+            OperatorBase::GetSingleArgument<int>("capacity", 1),
+            OperatorBase::GetSingleArgument<int>("num_blobs", 1),
+            OperatorBase::GetRepeatedArgument<int64_t>("bucket_boundaries"),
+            OperatorBase::GetSingleArgument<int>("batch_size", 1),
+            OperatorBase::GetSingleArgument<float>("max_latency_ms", 0) / 1000,
+            OperatorBase::GetSingleArgument<int>("length_blob", 0),
+            name_));
+    return true;
+  }
+
+ private:
+  // Names the stats of the queue.
+  std::string name_;
+};
+
+class EnqueueBucketingQueueOp : public Operator<CPUContext> {
+ public:
+  EnqueueBucketingQueueOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    auto& queue = Inputs()[0]->template Get<BucketingQueuePtr>();
+    CAFFE_ENFORCE(queue);
+    CAFFE_ENFORCE_EQ(InputSize(), queue->numBlobs() + 1);
+    std::vector<const TensorCPU*> inputTensors;
+    inputTensors.reserve(InputSize() - 1);
+    for (int i = 1; i < InputSize(); ++i) {
+      inputTensors.push_back(&Input(i));
+    }
+    return queue->enqueue(context_, inputTensors);
+  }
+};
+
+class DequeueBucketingQueueOp : public Operator<CPUContext> {
+ public:
+  DequeueBucketingQueueOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator(operator_def, ws),
+        timeMajor_(OperatorBase::GetSingleArgument<bool>("time_major", false)) {
+  }
+
+  bool RunOnDevice() override {
+    auto& queue = Inputs()[0]->template Get<BucketingQueuePtr>();
+    CAFFE_ENFORCE(queue);
+    CAFFE_ENFORCE_EQ(OutputSize(), queue->numBlobs() + 1);
+
+    std::vector<TensorCPU*> outputTensors;
+    outputTensors.reserve(OutputSize() - 1);
+    for (int i = 0; i < OutputSize() - 1; ++i) {
+      outputTensors.push_back(Output(i));
+    }
+    return queue->dequeue(
+        context_, outputTensors, Output(OutputSize() - 1), timeMajor_);
+  }
+
+ private:
+  bool timeMajor_;
+};
+
+class CloseBucketingQueueOp : public Operator<CPUContext> {
+ public:
+  CloseBucketingQueueOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    CAFFE_ENFORCE_EQ(InputSize(), 1);
+    auto& queue = Inputs()[0]->template Get<BucketingQueuePtr>();
+    CAFFE_ENFORCE(queue);
+    queue->close();
+    return true;
+  }
+};
+} // caffe2
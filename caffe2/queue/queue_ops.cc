@@ -33,7 +33,15 @@ REGISTER_CPU_OPERATOR(
     WeightedSampleDequeueBlobs,
     WeightedSampleDequeueBlobsOp<CPUContext>);
 
-OPERATOR_SCHEMA(CreateBlobsQueue).NumInputs(0).NumOutputs(1);
+OPERATOR_SCHEMA(CreateBlobsQueue)
+    .NumInputs(0)
+    .NumOutputs(1)
+    .Arg("capacity", "Number of records the queue can hold, default: 1")
+    .Arg("num_blobs", "Number of blobs in a record, default: 1")
+    .Arg(
+        "lock_free",
+        "If true, create a queue whose readers and writers do not lock, "
+        "which scales better with many concurrent readers, default: false");
 OPERATOR_SCHEMA(EnqueueBlobs)
     .NumInputsOutputs([](int inputs, int outputs) {
       return inputs >= 2 && outputs >= 1 && inputs == outputs + 1;
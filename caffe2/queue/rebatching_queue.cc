@@ -111,10 +111,22 @@ std::vector<std::vector<TensorCPU>> split(
 
   return outputs;
 }
+
+size_t nbytes(const std::vector<TensorCPU>& element) {
+  size_t bytes = 0;
+  for (const auto& tensor : element) {
+    bytes += tensor.nbytes();
+  }
+  return bytes;
+}
 } // anonymous namespace
 
 RebatchingQueue::RebatchingQueue(size_t capacity, size_t numBlobs)
-    : capacity_(capacity), numBlobs_(numBlobs), queue_(capacity) {}
+    : capacity_(capacity),
+      numBlobs_(numBlobs),
+      queue_(capacity),
+      requestIds_(capacity),
+      enqueueTimes_(capacity) {}
 
 RebatchingQueue::~RebatchingQueue() {
   close();
@@ -127,19 +139,36 @@ bool RebatchingQueue::canRead() const {
 bool RebatchingQueue::dequeue(
     CPUContext& context,
     size_t numElements,
-    const std::vector<TensorCPU*>& outputs) {
+    const std::vector<TensorCPU*>& outputs,
+    float maxLatencySecs,
+    size_t maxBytes,
+    std::vector<int64_t>* requestIds) {
   std::vector<std::vector<TensorCPU>> results;
   results.reserve(numElements);
+  if (requestIds) {
+    requestIds->clear();
+  }
+
+  // Set when the first element is dequeued if maxLatencySecs is used
+  std::chrono::steady_clock::time_point deadline;
+  size_t bytes = 0;
+  bool budgetExhausted = false;
 
   for (;;) {
-    if (results.size() == numElements) {
+    if (results.size() == numElements || budgetExhausted) {
       break;
     }
 
     {
       std::unique_lock<std::mutex> lock(mutex_);
 
-      cvEmpty_.wait(lock, [this] { return canRead() || isClosed_; });
+      const auto ready = [this] { return canRead() || isClosed_; };
+      if (results.empty() || maxLatencySecs <= 0) {
+        cvEmpty_.wait(lock, ready);
+      } else if (!cvEmpty_.wait_until(lock, deadline, ready)) {
+        // The oldest element of the batch has waited long enough
+        break;
+      }
 
       // We only want to stop reading if the queue is empty and closed
       if (!canRead() && isClosed_) {
@@ -147,7 +176,25 @@ bool RebatchingQueue::dequeue(
       }
 
       do {
-        results.push_back(std::move(queue_[tail_++ % capacity()]));
+        const auto idx = tail_ % capacity();
+        if (maxBytes > 0) {
+          const auto elementBytes = nbytes(queue_[idx]);
+          if (!results.empty() && bytes + elementBytes > maxBytes) {
+            budgetExhausted = true;
+            break;
+          }
+          bytes += elementBytes;
+        }
+        if (results.empty() && maxLatencySecs > 0) {
+          deadline = enqueueTimes_[idx] +
+              std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                         std::chrono::duration<float>(maxLatencySecs));
+        }
+        if (requestIds) {
+          requestIds->push_back(requestIds_[idx]);
+        }
+        results.push_back(std::move(queue_[idx]));
+        ++tail_;
       } while (canRead() && results.size() < numElements);
     }
 
@@ -173,7 +220,8 @@ bool RebatchingQueue::canWrite() const {
 
 bool RebatchingQueue::enqueueOne(
     CPUContext& /*context*/,
-    const std::vector<const TensorCPU*>& inputs) {
+    const std::vector<const TensorCPU*>& inputs,
+    int64_t* requestId) {
   std::vector<std::vector<TensorCPU>> splittedInputs;
   splittedInputs.emplace_back();
   auto& tensorVector = splittedInputs.back();
@@ -182,22 +230,32 @@ bool RebatchingQueue::enqueueOne(
     tensorVector.push_back(*tensorPtr);
   }
 
-  return enqueue(std::move(splittedInputs));
+  return enqueue(std::move(splittedInputs), requestId);
 }
 
 bool RebatchingQueue::enqueueMany(
     CPUContext& context,
-    const std::vector<const TensorCPU*>& inputs) {
+    const std::vector<const TensorCPU*>& inputs,
+    int64_t* requestId) {
   CAFFE_ENFORCE_EQ(numBlobs_, inputs.size());
 
   std::vector<std::vector<TensorCPU>> splittedInputs;
   splittedInputs = split(context, inputs);
-  return enqueue(std::move(splittedInputs));
+  return enqueue(std::move(splittedInputs), requestId);
 }
 
 bool RebatchingQueue::enqueue(
-    std::vector<std::vector<TensorCPU>> splittedInputs) {
+    std::vector<std::vector<TensorCPU>> splittedInputs,
+    int64_t* requestId) {
   int idx = 0;
+  int64_t id;
+  {
+    std::lock_guard<std::mutex> g(mutex_);
+    id = nextRequestId_++;
+  }
+  if (requestId) {
+    *requestId = id;
+  }
   for (;;) {
     if (idx >= splittedInputs.size()) {
       break;
@@ -214,8 +272,12 @@ bool RebatchingQueue::enqueue(
         return false;
       }
 
+      const auto now = std::chrono::steady_clock::now();
       do {
-        queue_[head_++ % capacity()] = std::move(splittedInputs[idx++]);
+        const auto slot = head_++ % capacity();
+        queue_[slot] = std::move(splittedInputs[idx++]);
+        requestIds_[slot] = id;
+        enqueueTimes_[slot] = now;
       } while (canWrite() && idx < splittedInputs.size());
     }
 
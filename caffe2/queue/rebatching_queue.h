@@ -17,6 +17,7 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
@@ -39,18 +40,34 @@ class RebatchingQueue {
 
   ~RebatchingQueue();
 
+  // Every enqueue call is a request, its id is returned in requestId if not
+  // null. All the elements of one request share its id.
   bool enqueueOne(
       CPUContext& context,
-      const std::vector<const TensorCPU*>& inputs);
+      const std::vector<const TensorCPU*>& inputs,
+      int64_t* requestId = nullptr);
 
   bool enqueueMany(
       CPUContext& context,
-      const std::vector<const TensorCPU*>& inputs);
-
+      const std::vector<const TensorCPU*>& inputs,
+      int64_t* requestId = nullptr);
+
+  // Dequeues up to numElements elements, concatenated into outputs.
+  //
+  // For dynamic batching, the batch can also be cut short:
+  // - if maxLatencySecs > 0, once the first element of the batch has waited
+  //   that long since it was enqueued;
+  // - if maxBytes > 0, before an element would bring the batch over maxBytes
+  //   (a batch always gets at least one element).
+  // The request id of every element is then returned in requestIds if not
+  // null, so that the results can be sliced back to their requests.
   bool dequeue(
       CPUContext& context,
       size_t numElements,
-      const std::vector<TensorCPU*>& outputs);
+      const std::vector<TensorCPU*>& outputs,
+      float maxLatencySecs = 0,
+      size_t maxBytes = 0,
+      std::vector<int64_t>* requestIds = nullptr);
 
   size_t capacity() const;
 
@@ -61,7 +78,9 @@ class RebatchingQueue {
   void close();
 
  private:
-  bool enqueue(std::vector<std::vector<TensorCPU>> splittedInputs);
+  bool enqueue(
+      std::vector<std::vector<TensorCPU>> splittedInputs,
+      int64_t* requestId);
 
   bool canWrite() const;
   bool canRead() const;
@@ -75,10 +94,14 @@ class RebatchingQueue {
 
   uint64_t head_{0};
   uint64_t tail_{0};
+  int64_t nextRequestId_{0};
 
   std::condition_variable cvEmpty_;
   std::condition_variable cvOverflow_;
 
   std::vector<std::vector<TensorCPU>> queue_;
+  // Request id and enqueue time of every element of queue_
+  std::vector<int64_t> requestIds_;
+  std::vector<std::chrono::steady_clock::time_point> enqueueTimes_;
 };
 } // caffe2
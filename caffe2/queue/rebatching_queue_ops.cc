@@ -54,7 +54,7 @@ OPERATOR_SCHEMA(CloseRebatchingQueue)
 
 OPERATOR_SCHEMA(EnqueueRebatchingQueue)
     .NumInputs(2, INT_MAX)
-    .NumOutputs(0)
+    .NumOutputs(0, 1)
     .SetDoc(R"DOC(
       Enqueues Tensors into the queue.
       Number of input tensors should be equal to the number of components passed
@@ -62,9 +62,12 @@ OPERATOR_SCHEMA(EnqueueRebatchingQueue)
       If the Queue is closed this operation will fail.
       If enqueue_batch argument is set. We will split the input tensors by the
       first dimension to produce single queue elements.
+      Every enqueue is a request, whose id can be output to match it with the
+      request_ids output of DequeueRebatchingQueue.
 )DOC")
     .Input(0, "queue", "object representing the queue")
     .Input(1, "tensor", "First tensor to enque. ")
+    .Output(0, "request_id", "(optional) int64 scalar id of this request")
     .Arg(
         "enqueue_batch",
         "Are we enqueuing a batch or just a single element. \
@@ -79,11 +82,30 @@ OPERATOR_SCHEMA(DequeueRebatchingQueue)
       If num_elements > 1 the returned elements will be concatenated into one
       tensor per component.
 
+      For dynamic batching, a batch of fewer than num_elements elements is
+      returned as soon as its first element has waited max_latency_ms since
+      it was enqueued, or as soon as the next element would bring it over
+      max_bytes, whichever comes first. With output_request_ids, the last
+      output holds the request id of every returned element so that the
+      results can be sliced back to their requests.
+
 )DOC")
     .Input(0, "rebatching_queue", "object representing the queue")
     .Input(1, "tensor", "First tensor to enqueue")
     .Arg(
         "num_elements",
-        "Number of elements to dequeue. By default we dequeue one element.");
+        "Number of elements to dequeue. By default we dequeue one element.")
+    .Arg(
+        "max_latency_ms",
+        "If positive, return a partial batch once its oldest element has "
+        "waited that many milliseconds. By default we wait for num_elements.")
+    .Arg(
+        "max_bytes",
+        "If positive, upper bound on the number of bytes of a batch, a batch "
+        "always has at least one element. By default there is no bound.")
+    .Arg(
+        "output_request_ids",
+        "If set, the last output is an int64 tensor with the request id of "
+        "every dequeued element.");
 }
 }
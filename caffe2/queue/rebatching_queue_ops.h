@@ -52,8 +52,16 @@ class EnqueueRebatchingQueueOp : public Operator<CPUContext> {
       inputTensors.push_back(&Input(i));
     }
 
-    return enqueueBatch_ ? queue->enqueueMany(context_, inputTensors)
-                         : queue->enqueueOne(context_, inputTensors);
+    int64_t requestId;
+    const bool success = enqueueBatch_
+        ? queue->enqueueMany(context_, inputTensors, &requestId)
+        : queue->enqueueOne(context_, inputTensors, &requestId);
+    if (success && OutputSize() > 0) {
+      auto* output = Output(0);
+      output->Resize(std::vector<TIndex>{});
+      *output->mutable_data<int64_t>() = requestId;
+    }
+    return success;
   }
 
  private:
@@ -64,23 +72,53 @@ class DequeueRebatchingQueueOp : public Operator<CPUContext> {
  public:
   DequeueRebatchingQueueOp(const OperatorDef& operator_def, Workspace* ws)
       : Operator(operator_def, ws),
-        numElements_(OperatorBase::GetSingleArgument<int>("num_elements", 1)) {}
+        numElements_(OperatorBase::GetSingleArgument<int>("num_elements", 1)),
+        maxLatencySecs_(
+            OperatorBase::GetSingleArgument<float>("max_latency_ms", 0) /
+            1000),
+        maxBytes_(OperatorBase::GetSingleArgument<int64_t>("max_bytes", 0)),
+        outputRequestIds_(
+            OperatorBase::GetSingleArgument<bool>("output_request_ids", false)) {
+    CAFFE_ENFORCE_GE(maxBytes_, 0);
+  }
 
   bool RunOnDevice() override {
     auto& queue = Inputs()[0]->template Get<RebatchingQueuePtr>();
     CHECK(queue);
 
+    const int numTensors = OutputSize() - outputRequestIds_;
     std::vector<TensorCPU*> outputTensors;
-    outputTensors.reserve(OutputSize());
-    for (int i = 0; i < OutputSize(); ++i) {
+    outputTensors.reserve(numTensors);
+    for (int i = 0; i < numTensors; ++i) {
       outputTensors.push_back(Output(i));
     }
 
-    return queue->dequeue(context_, numElements_, outputTensors);
+    if (!queue->dequeue(
+            context_,
+            numElements_,
+            outputTensors,
+            maxLatencySecs_,
+            maxBytes_,
+            outputRequestIds_ ? &requestIds_ : nullptr)) {
+      return false;
+    }
+    if (outputRequestIds_) {
+      auto* output = Output(numTensors);
+      output->Resize(requestIds_.size());
+      context_.Copy<int64_t, CPUContext, CPUContext>(
+          requestIds_.size(),
+          requestIds_.data(),
+          output->mutable_data<int64_t>());
+    }
+    return true;
   }
 
  private:
   int numElements_;
+  float maxLatencySecs_;
+  int64_t maxBytes_;
+  bool outputRequestIds_;
+  std::vector<int64_t> requestIds_;
 };
 
 class CloseRebatchingQueueOp : public Operator<CPUContext> {
@@ -14,10 +14,10 @@
  * limitations under the License.
  */
 
-#include <hipcub/hipcub.hpp>
 #include "adagrad_op.h"
 #include "caffe2/core/common_hip.h"
 #include "caffe2/core/context_hip.h"
+#include "caffe2/sgd/sparse_sort_hip.h"
 #include "caffe2/utils/mixed_utils_hip.h"
 #include "hip/hip_runtime.h"
 
@@ -69,28 +69,44 @@ void adagrad_update<HIPContext>(int N,
                        lr);
 }
 
+/**
+ * Calculate SparseAdagrad over sorted indices. The block that sees the first
+ * occurrence of a row owns it: it keeps the row's moment and weights in
+ * registers while walking all occurrences, and writes them back once.
+ */
 template <typename SIndex, typename THalf>
-__global__ void SparseAdagradKernel(const size_t N,
-                                    const size_t grad_slice_sz,
+__global__ void SparseAdagradKernel(const int num_indices,
+                                    const int grad_slice_sz,
                                     const float epsilon,
                                     THalf* param,
                                     THalf* param_mom,
-                                    const SIndex* indices,
+                                    const SIndex* sorted_indices,
+                                    const int* sorted_positions,
                                     const float* grad,
                                     const float* lr)
 {
     const float LR = lr[0];
-    HIP_1D_KERNEL_LOOP(i, N)
+    for(int i = hipBlockIdx_x; i < num_indices; i += hipGridDim_x)
     {
-        const size_t gradIdx  = i;
-        const SIndex index    = indices[i / grad_slice_sz];
-        const size_t paramIdx = index * grad_slice_sz + (i % grad_slice_sz);
-
-        float mom_new = mixed_add(grad[gradIdx] * grad[gradIdx], param_mom[paramIdx]);
-        mixed_store(&mom_new, &(param_mom[paramIdx]));
-        float param_new =
-            mixed_add(LR * grad[gradIdx] / (sqrtf(mom_new) + epsilon), param[paramIdx]);
-        mixed_store(&param_new, &(param[paramIdx]));
+        const SIndex index = sorted_indices[i];
+        if(i > 0 && sorted_indices[i - 1] == index)
+        {
+            continue;
+        }
+        for(int j = hipThreadIdx_x; j < grad_slice_sz; j += hipBlockDim_x)
+        {
+            const size_t paramIdx = static_cast<size_t>(index) * grad_slice_sz + j;
+            float mom             = mixed_add(0.0f, param_mom[paramIdx]);
+            float weight          = mixed_add(0.0f, param[paramIdx]);
+            for(int k = i; k < num_indices && sorted_indices[k] == index; ++k)
+            {
+                const float g = grad[static_cast<size_t>(sorted_positions[k]) * grad_slice_sz + j];
+                mom += g * g;
+                weight += LR * g / (sqrtf(mom) + epsilon);
+            }
+            mixed_store(&mom, &(param_mom[paramIdx]));
+            mixed_store(&weight, &(param[paramIdx]));
+        }
     }
 }
 
@@ -101,7 +117,7 @@ __global__ void SparseAdagradKernel(const size_t N,
  * grad: pointer to the gradients
  * param: pointer to weights
  * param_mom: pointer to the momentum
- * indices: keys
+ * sorted_indices, sorted_positions: keys sorted by SortIndicesWithPositions
  */
 template <typename SIndex>
 __global__ void RowWiseSparseAdagradKernel(const int M,
@@ -109,37 +125,48 @@ __global__ void RowWiseSparseAdagradKernel(const int M,
                                            const float epsilon,
                                            float* param,
                                            float* param_mom,
-                                           const SIndex* indices,
+                                           const SIndex* sorted_indices,
+                                           const int* sorted_positions,
                                            const float* grad,
                                            const float* lr)
 {
     using BlockReduce = hipcub::BlockReduce<float, CAFFE_HIP_NUM_THREADS>;
     __shared__ BlockReduce::TempStorage temp_storage;
+    __shared__ float step;
     // in case gridDim is smaller than M
     for(int i = hipBlockIdx_x; i < M; i += hipGridDim_x)
     {
-        const SIndex index = indices[i];
-        float sum_squares  = 0.0;
-        __shared__ float row_sum_squares_avg;
-
-        // in case N is bigger than block size which is 512 by default
-        for(int j = hipThreadIdx_x; j < N; j += hipBlockDim_x)
-        {
-            const float x_ij = grad[i * N + j];
-            sum_squares += x_ij * x_ij;
-        }
-        float reduce_result = BlockReduce(temp_storage).Sum(sum_squares);
-        if(hipThreadIdx_x == 0)
+        const SIndex index = sorted_indices[i];
+        if(i > 0 && sorted_indices[i - 1] == index)
         {
-            row_sum_squares_avg = reduce_result / (float)N;
-            param_mom[index] += row_sum_squares_avg;
+            continue;
         }
-        __syncthreads();
-        // update param
-        float step = lr[0] / (sqrtf(param_mom[index]) + epsilon);
-        for(int j = hipThreadIdx_x; j < N; j += hipBlockDim_x)
+        float* param_row = param + static_cast<size_t>(index) * N;
+        // apply the occurrences of this row in their original order
+        for(int k = i; k < M && sorted_indices[k] == index; ++k)
         {
-            param[index * N + j] = param[index * N + j] + grad[i * N + j] * step;
+            const float* grad_row = grad + static_cast<size_t>(sorted_positions[k]) * N;
+            float sum_squares     = 0.0;
+            // in case N is bigger than block size which is 512 by default
+            for(int j = hipThreadIdx_x; j < N; j += hipBlockDim_x)
+            {
+                const float x_ij = grad_row[j];
+                sum_squares += x_ij * x_ij;
+            }
+            float reduce_result = BlockReduce(temp_storage).Sum(sum_squares);
+            if(hipThreadIdx_x == 0)
+            {
+                param_mom[index] += reduce_result / (float)N;
+                step = lr[0] / (sqrtf(param_mom[index]) + epsilon);
+            }
+            __syncthreads();
+            // update param
+            for(int j = hipThreadIdx_x; j < N; j += hipBlockDim_x)
+            {
+                param_row[j] = param_row[j] + grad_row[j] * step;
+            }
+            // temp_storage and step are reused by the next occurrence
+            __syncthreads();
         }
     }
 }
@@ -182,14 +209,7 @@ class HIPSparseAdagradOp final : public Operator<Context>
     template <typename IndexType, typename THalf>
     bool DoRunWithType2()
     {
-        const auto* lr       = Input(LR).template data<T>();
-        const auto* indices  = Input(INDICES).template data<IndexType>();
-        const auto* gradIn   = Input(GRAD).template data<T>();
-        const auto* paramIn  = Input(PARAM).template data<THalf>();
-        const auto* momentIn = Input(MOMENT_1).template data<THalf>();
-        auto* paramOut       = Output(OUTPUT_PARAM)->template mutable_data<THalf>();
-        auto* momentOut      = Output(OUTPUT_MOMENT_1)->template mutable_data<THalf>();
-
+        auto n             = Input(INDICES).size();
         auto N             = Input(GRAD).size();
         auto grad_slice_sz = Input(GRAD).size_from_dim(Input(INDICES).ndim());
         if(N == 0)
@@ -197,17 +217,28 @@ class HIPSparseAdagradOp final : public Operator<Context>
             // empty grad, nothing to do here, not even launching the kernel
             return true;
         }
+        SortIndicesWithPositions<IndexType>(n,
+                                            Input(INDICES).template data<IndexType>(),
+                                            &sorted_indices_,
+                                            &sorted_positions_,
+                                            &positions_,
+                                            &sort_buffer_,
+                                            &context_);
+
+        // one block per row, with the threads striding over the row
+        const int threads = SparseRowThreads(grad_slice_sz);
         hipLaunchKernelGGL((SparseAdagradKernel<IndexType, THalf>),
-                           dim3(CAFFE_GET_BLOCKS(N)),
-                           dim3(CAFFE_HIP_NUM_THREADS),
+                           dim3(std::min<int>(n, CAFFE_MAXIMUM_NUM_BLOCKS)),
+                           dim3(threads),
                            0,
                            context_.hip_stream(),
-                           static_cast<const size_t>(N),
-                           static_cast<const size_t>(grad_slice_sz),
+                           static_cast<const int>(n),
+                           static_cast<const int>(grad_slice_sz),
                            static_cast<const float>(epsilon_),
                            Output(OUTPUT_PARAM)->template mutable_data<THalf>(),
                            Output(OUTPUT_MOMENT_1)->template mutable_data<THalf>(),
-                           Input(INDICES).template data<IndexType>(),
+                           sorted_indices_.template data<IndexType>(),
+                           sorted_positions_.template data<int>(),
                            Input(GRAD).template data<float>(),
                            Input(LR).template data<float>());
         return true;
@@ -215,42 +246,86 @@ class HIPSparseAdagradOp final : public Operator<Context>
 
     protected:
     T epsilon_;
+    Tensor<Context> sorted_indices_;
+    Tensor<Context> sorted_positions_;
+    Tensor<Context> positions_;
+    Tensor<Context> sort_buffer_;
     INPUT_TAGS(PARAM, MOMENT_1, INDICES, GRAD, LR);
     OUTPUT_TAGS(OUTPUT_PARAM, OUTPUT_MOMENT_1);
 };
 
-template <>
-template <typename SIndex>
-bool RowWiseSparseAdagradOp<float, HIPContext>::DoRunWithType()
+template <typename T, class Context>
+class HIPRowWiseSparseAdagradOp final : public Operator<Context>
 {
-    auto N = Input(GRAD).size();
-    if(N == 0)
+    public:
+    USE_OPERATOR_CONTEXT_FUNCTIONS;
+    HIPRowWiseSparseAdagradOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<Context>(operator_def, ws),
+          epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f))
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        // Enforce shapes
+        CAFFE_ENFORCE_EQ(Input(PARAM).dims()[0], Input(MOMENT_1).size());
+        CAFFE_ENFORCE_EQ(Input(LR).size(), 1);
+        CAFFE_ENFORCE_EQ(Input(PARAM).size_from_dim(1),
+                         Input(GRAD).size_from_dim(Input(INDICES).ndim()));
+
+        return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(this, Input(INDICES));
+    }
+
+    template <typename SIndex>
+    bool DoRunWithType()
     {
-        // empty grad, nothing to do here, not even launching the kernel
+        auto N = Input(GRAD).size();
+        if(N == 0)
+        {
+            // empty grad, nothing to do here, not even launching the kernel
+            return true;
+        }
+        // size of the 1st dimension of the input gradient
+        auto GRAD_M = Input(GRAD).dim32(0);
+        auto GRAD_N = N / GRAD_M;
+
+        SortIndicesWithPositions<SIndex>(GRAD_M,
+                                         Input(INDICES).template data<SIndex>(),
+                                         &sorted_indices_,
+                                         &sorted_positions_,
+                                         &positions_,
+                                         &sort_buffer_,
+                                         &context_);
+
+        // each thread block will handle multiple rows of the input and output
+        hipLaunchKernelGGL((RowWiseSparseAdagradKernel<SIndex>),
+                           dim3(std::min(GRAD_M, CAFFE_MAXIMUM_NUM_BLOCKS)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context_.hip_stream(),
+                           static_cast<const int>(GRAD_M),
+                           static_cast<const int>(GRAD_N),
+                           static_cast<const float>(epsilon_),
+                           Output(OUTPUT_PARAM)->template mutable_data<float>(),
+                           Output(OUTPUT_MOMENT_1)->template mutable_data<float>(),
+                           sorted_indices_.template data<SIndex>(),
+                           sorted_positions_.template data<int>(),
+                           Input(GRAD).template data<float>(),
+                           Input(LR).template data<float>());
         return true;
     }
-    // size of the 1st dimension of the input gradient
-    auto GRAD_M = Input(GRAD).dim32(0);
-    auto GRAD_N = N / GRAD_M;
 
-    // each thread block will handle multiple rows of the input and output
-    hipLaunchKernelGGL((RowWiseSparseAdagradKernel),
-                       dim3(min(GRAD_M, CAFFE_MAXIMUM_NUM_BLOCKS)),
-                       dim3(CAFFE_HIP_NUM_THREADS),
-                       0,
-                       context_.hip_stream(),
-                       static_cast<const int>(GRAD_M),
-                       static_cast<const int>(GRAD_N),
-                       static_cast<const float>(epsilon_),
-                       Output(OUTPUT_PARAM)->template mutable_data<float>(),
-                       Output(OUTPUT_MOMENT_1)->template mutable_data<float>(),
-                       Input(INDICES).template data<SIndex>(),
-                       Input(GRAD).template data<float>(),
-                       Input(LR).template data<float>());
-    return true;
-}
+    protected:
+    T epsilon_;
+    Tensor<Context> sorted_indices_;
+    Tensor<Context> sorted_positions_;
+    Tensor<Context> positions_;
+    Tensor<Context> sort_buffer_;
+    INPUT_TAGS(PARAM, MOMENT_1, INDICES, GRAD, LR);
+    OUTPUT_TAGS(OUTPUT_PARAM, OUTPUT_MOMENT_1);
+};
 
 REGISTER_HIP_OPERATOR(Adagrad, AdagradOp<float, HIPContext>);
 REGISTER_HIP_OPERATOR(SparseAdagrad, HIPSparseAdagradOp<float, HIPContext>);
-REGISTER_HIP_OPERATOR(RowWiseSparseAdagrad, RowWiseSparseAdagradOp<float, HIPContext>);
+REGISTER_HIP_OPERATOR(RowWiseSparseAdagrad, HIPRowWiseSparseAdagradOp<float, HIPContext>);
 }
@@ -17,10 +17,25 @@
 #include "adam_op.h"
 #include "caffe2/core/common_hip.h"
 #include "caffe2/core/context_hip.h"
+#include "caffe2/sgd/sparse_sort_hip.h"
 #include "hip/hip_runtime.h"
 
 namespace caffe2 {
 
+// With the iteration counter on the device (see IterOp<HIPContext>) the bias
+// correction is computed by every thread instead of being passed in, so the
+// step does not read the counter back to the host.
+__device__ inline float
+AdamCorrection(const float correction, const int64_t* iter, const float beta1, const float beta2)
+{
+    if(iter == nullptr)
+    {
+        return correction;
+    }
+    const float t = iter[0] + 1;
+    return sqrtf(1.0f - powf(beta2, t)) / (1.0f - powf(beta1, t));
+}
+
 __global__ void AdamUpdate(int N,
                            const float* g,
                            const float* m,
@@ -89,8 +104,10 @@ __global__ void AdamCompute(int N,
                             float beta2,
                             float eps_hat,
                             float correction,
-                            const float* lr)
+                            const float* lr,
+                            const int64_t* iter)
 {
+    correction = AdamCorrection(correction, iter, beta1, beta2);
     HIP_1D_KERNEL_LOOP(i, N)
     {
         float gi = g[i];
@@ -134,68 +151,193 @@ void adam_compute<HIPContext>(int N,
                        beta2,
                        eps_hat,
                        correction,
-                       lr);
+                       lr,
+                       nullptr);
+}
+
+template <>
+bool AdamOp<float, HIPContext>::RunOnDevice()
+{
+    float correction       = 0;
+    const int64_t* iter_data = nullptr;
+    if(OperatorBase::InputIsType<TensorCPU>(ITER))
+    {
+        // Same as the other devices.
+        const auto iter = OperatorBase::Input<TensorCPU>(ITER).data<int64_t>()[0];
+        const auto t    = iter + 1;
+        correction      = std::sqrt(1.f - std::pow(beta2_, t)) / (1.f - std::pow(beta1_, t));
+    }
+    else
+    {
+        CAFFE_ENFORCE_EQ(Input(ITER).size(), 1);
+        iter_data = Input(ITER).data<int64_t>();
+    }
+    CAFFE_ENFORCE(Input(LR).size() == 1);
+    CAFFE_ENFORCE(Input(GRAD).size() == Input(PARAM).size());
+    CAFFE_ENFORCE(Input(GRAD).size() == Input(MOMENT_1).size());
+    CAFFE_ENFORCE(Input(GRAD).size() == Input(MOMENT_2).size());
+    Output(OUTPUT_PARAM)->ResizeLike(Input(PARAM));
+    Output(OUTPUT_MOMENT_1)->ResizeLike(Input(MOMENT_1));
+    Output(OUTPUT_MOMENT_2)->ResizeLike(Input(MOMENT_2));
+    const int N = Input(GRAD).size();
+    hipLaunchKernelGGL((AdamCompute),
+                       dim3(CAFFE_GET_BLOCKS(N)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       N,
+                       Input(PARAM).data<float>(),
+                       Input(GRAD).data<float>(),
+                       Input(MOMENT_1).data<float>(),
+                       Input(MOMENT_2).data<float>(),
+                       Output(OUTPUT_PARAM)->mutable_data<float>(),
+                       Output(OUTPUT_MOMENT_1)->mutable_data<float>(),
+                       Output(OUTPUT_MOMENT_2)->mutable_data<float>(),
+                       beta1_,
+                       beta2_,
+                       epsilon_,
+                       correction,
+                       Input(LR).data<float>(),
+                       iter_data);
+    return true;
 }
 
+/**
+ * SparseAdam over sorted indices: the block that sees the first occurrence of
+ * a row applies all of its occurrences in order, like the CPU op does, with
+ * the row's moments and weights in registers. Occurrences of a row used to be
+ * applied concurrently and raced on the moments.
+ */
 template <typename SIndex>
-__global__ void SparseAdamKernel(const size_t N,
-                                 const size_t grad_slice_sz,
+__global__ void SparseAdamKernel(const int num_indices,
+                                 const int grad_slice_sz,
                                  const float beta1,
                                  const float beta2,
                                  const float epsilon,
                                  float* param,
                                  float* mom1,
                                  float* mom2,
-                                 const SIndex* indices,
+                                 const SIndex* sorted_indices,
+                                 const int* sorted_positions,
                                  const float* grad,
-                                 const float correction,
+                                 float correction,
                                  const float* lr,
-                                 const float iter)
+                                 const int64_t* iter)
 {
-    HIP_1D_KERNEL_LOOP(i, N)
+    correction     = AdamCorrection(correction, iter, beta1, beta2);
+    const float LR = lr[0];
+    for(int i = hipBlockIdx_x; i < num_indices; i += hipGridDim_x)
     {
-        const size_t gradIdx  = i;
-        const SIndex index    = indices[i / grad_slice_sz];
-        const size_t paramIdx = index * grad_slice_sz + (i % grad_slice_sz);
-
-        float m1n = mom1[paramIdx] = mom1[paramIdx] * beta1 + grad[gradIdx] * (1.0f - beta1);
-        float m2n                  = mom2[paramIdx] =
-            mom2[paramIdx] * beta2 + grad[gradIdx] * grad[gradIdx] * (1.0f - beta2);
-        param[paramIdx] += lr[0] * correction * m1n / (sqrt(m2n) + epsilon);
+        const SIndex index = sorted_indices[i];
+        if(i > 0 && sorted_indices[i - 1] == index)
+        {
+            continue;
+        }
+        for(int j = hipThreadIdx_x; j < grad_slice_sz; j += hipBlockDim_x)
+        {
+            const size_t paramIdx = static_cast<size_t>(index) * grad_slice_sz + j;
+            float m1              = mom1[paramIdx];
+            float m2              = mom2[paramIdx];
+            float w               = param[paramIdx];
+            for(int k = i; k < num_indices && sorted_indices[k] == index; ++k)
+            {
+                const float g = grad[static_cast<size_t>(sorted_positions[k]) * grad_slice_sz + j];
+                m1            = m1 * beta1 + g * (1.0f - beta1);
+                m2            = m2 * beta2 + g * g * (1.0f - beta2);
+                w += LR * correction * m1 / (sqrtf(m2) + epsilon);
+            }
+            mom1[paramIdx]  = m1;
+            mom2[paramIdx]  = m2;
+            param[paramIdx] = w;
+        }
     }
 }
 
-template <>
-template <typename SIndex>
-bool SparseAdamOp<float, HIPContext>::DoRunWithType()
+class HIPSparseAdamOp final : public Operator<HIPContext>
 {
-    auto N             = Input(GRAD).size();
-    auto grad_slice_sz = Input(GRAD).size_from_dim(Input(INDICES).ndim());
-    const auto iter    = OperatorBase::Input<TensorCPU>(ITER).template data<int64_t>()[0];
-    const float correction =
-        std::sqrt(1.0f - std::pow(beta2_, iter + 1)) / (1.0f - std::pow(beta1_, iter + 1));
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPSparseAdamOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws),
+          beta1_(OperatorBase::GetSingleArgument<float>("beta1", 0.9f)),
+          beta2_(OperatorBase::GetSingleArgument<float>("beta2", 0.999f)),
+          epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f))
+    {
+    }
 
-    hipLaunchKernelGGL((SparseAdamKernel<SIndex>),
-                       dim3(CAFFE_GET_BLOCKS(N)),
-                       dim3(CAFFE_HIP_NUM_THREADS),
-                       0,
-                       context_.hip_stream(),
-                       N,
-                       grad_slice_sz,
-                       beta1_,
-                       beta2_,
-                       epsilon_,
-                       Output(OUTPUT_PARAM)->template mutable_data<float>(),
-                       Output(OUTPUT_MOMENT_1)->template mutable_data<float>(),
-                       Output(OUTPUT_MOMENT_2)->template mutable_data<float>(),
-                       Input(INDICES).template data<SIndex>(),
-                       Input(GRAD).template data<float>(),
-                       correction,
-                       Input(LR).template data<float>(),
-                       iter);
-    return true;
-}
+    bool RunOnDevice() override
+    {
+        // Enforce shapes
+        CAFFE_ENFORCE_EQ(Input(PARAM).size(), Input(MOMENT_1).size());
+        CAFFE_ENFORCE_EQ(Input(PARAM).size(), Input(MOMENT_2).size());
+        CAFFE_ENFORCE_EQ(Input(PARAM).size_from_dim(1),
+                         Input(GRAD).size_from_dim(Input(INDICES).ndim()));
+        CAFFE_ENFORCE_EQ(Input(LR).size(), 1);
+        return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(this, Input(INDICES));
+    }
+
+    template <typename SIndex>
+    bool DoRunWithType()
+    {
+        const auto n = Input(INDICES).size();
+        if(n == 0 || Input(GRAD).size() == 0)
+        {
+            return true;
+        }
+        const auto grad_slice_sz = Input(GRAD).size_from_dim(Input(INDICES).ndim());
+        float correction         = 0;
+        const int64_t* iter_data = nullptr;
+        if(OperatorBase::InputIsType<TensorCPU>(ITER))
+        {
+            const auto iter = OperatorBase::Input<TensorCPU>(ITER).data<int64_t>()[0];
+            correction =
+                std::sqrt(1.0f - std::pow(beta2_, iter + 1)) / (1.0f - std::pow(beta1_, iter + 1));
+        }
+        else
+        {
+            iter_data = Input(ITER).data<int64_t>();
+        }
+        SortIndicesWithPositions<SIndex>(n,
+                                         Input(INDICES).data<SIndex>(),
+                                         &sorted_indices_,
+                                         &sorted_positions_,
+                                         &positions_,
+                                         &sort_buffer_,
+                                         &context_);
+        hipLaunchKernelGGL((SparseAdamKernel<SIndex>),
+                           dim3(std::min<int>(n, CAFFE_MAXIMUM_NUM_BLOCKS)),
+                           dim3(SparseRowThreads(grad_slice_sz)),
+                           0,
+                           context_.hip_stream(),
+                           static_cast<const int>(n),
+                           static_cast<const int>(grad_slice_sz),
+                           beta1_,
+                           beta2_,
+                           epsilon_,
+                           Output(OUTPUT_PARAM)->mutable_data<float>(),
+                           Output(OUTPUT_MOMENT_1)->mutable_data<float>(),
+                           Output(OUTPUT_MOMENT_2)->mutable_data<float>(),
+                           sorted_indices_.data<SIndex>(),
+                           sorted_positions_.data<int>(),
+                           Input(GRAD).data<float>(),
+                           correction,
+                           Input(LR).data<float>(),
+                           iter_data);
+        return true;
+    }
+
+    protected:
+    float beta1_;
+    float beta2_;
+    float epsilon_;
+    Tensor<HIPContext> sorted_indices_;
+    Tensor<HIPContext> sorted_positions_;
+    Tensor<HIPContext> positions_;
+    Tensor<HIPContext> sort_buffer_;
+    INPUT_TAGS(PARAM, MOMENT_1, MOMENT_2, INDICES, GRAD, LR, ITER);
+    OUTPUT_TAGS(OUTPUT_PARAM, OUTPUT_MOMENT_1, OUTPUT_MOMENT_2);
+};
 
 REGISTER_HIP_OPERATOR(Adam, AdamOp<float, HIPContext>);
-REGISTER_HIP_OPERATOR(SparseAdam, SparseAdamOp<float, HIPContext>);
+REGISTER_HIP_OPERATOR(SparseAdam, HIPSparseAdamOp);
 }
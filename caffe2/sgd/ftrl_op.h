@@ -33,7 +33,7 @@ struct FtrlParams {
   T lambda2;
 };
 
-// TODO(dzhulgakov): implement GPU version if necessary
+// The HIP versions live in ftrl_op_hip.cc.
 template <typename T, class Context>
 class FtrlOp final : public Operator<Context> {
  public:
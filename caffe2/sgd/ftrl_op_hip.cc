@@ -0,0 +1,227 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/common_hip.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/sgd/ftrl_op.h"
+#include "caffe2/sgd/sparse_sort_hip.h"
+#include "hip/hip_runtime.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Same as ftrl_compute, n and z are the adjacent pair of n_z of the weight.
+__device__ inline void
+FtrlCompute(const FtrlParams<float>& params, const float alphaInv, const float g, float& w, float& n, float& z)
+{
+    const float new_n = n + g * g;
+    const float sigma = (sqrtf(new_n) - sqrtf(n)) * alphaInv;
+    n                 = new_n;
+    z                 = z + g - sigma * w;
+    if(fabsf(z) > params.lambda1)
+    {
+        const float sgn_z = z < 0 ? -1.f : 1.f;
+        w = (params.lambda1 * sgn_z - z) / ((params.beta + sqrtf(new_n)) * alphaInv + params.lambda2);
+    }
+    else
+    {
+        w = 0.f;
+    }
+}
+
+// The run time alpha, if any, is read on the device to avoid a host sync.
+__device__ inline float FtrlAlphaInv(const FtrlParams<float>& params, const float* alpha)
+{
+    return alpha == nullptr ? params.alphaInv : 1.f / alpha[0];
+}
+
+__global__ void FtrlKernel(const int N,
+                           const FtrlParams<float> params,
+                           const float* alpha,
+                           const float* w,
+                           const float* nz,
+                           const float* g,
+                           float* new_w,
+                           float* new_nz)
+{
+    const float alphaInv = FtrlAlphaInv(params, alpha);
+    HIP_1D_KERNEL_LOOP(i, N)
+    {
+        float wi = w[i];
+        float n  = nz[i * 2];
+        float z  = nz[i * 2 + 1];
+        FtrlCompute(params, alphaInv, g[i], wi, n, z);
+        new_w[i]          = wi;
+        new_nz[i * 2]     = n;
+        new_nz[i * 2 + 1] = z;
+    }
+}
+
+/**
+ * SparseFtrl over sorted indices: the block that sees the first occurrence of
+ * a row applies all of its occurrences in order, see SparseAdagradKernel.
+ */
+template <typename SIndex>
+__global__ void SparseFtrlKernel(const int num_indices,
+                                 const int block_size,
+                                 const FtrlParams<float> params,
+                                 const float* alpha,
+                                 float* w,
+                                 float* nz,
+                                 const SIndex* sorted_indices,
+                                 const int* sorted_positions,
+                                 const float* grad)
+{
+    const float alphaInv = FtrlAlphaInv(params, alpha);
+    for(int i = hipBlockIdx_x; i < num_indices; i += hipGridDim_x)
+    {
+        const SIndex index = sorted_indices[i];
+        if(i > 0 && sorted_indices[i - 1] == index)
+        {
+            continue;
+        }
+        for(int j = hipThreadIdx_x; j < block_size; j += hipBlockDim_x)
+        {
+            const size_t x = static_cast<size_t>(index) * block_size + j;
+            float wx       = w[x];
+            float n        = nz[x * 2];
+            float z        = nz[x * 2 + 1];
+            for(int k = i; k < num_indices && sorted_indices[k] == index; ++k)
+            {
+                FtrlCompute(params,
+                            alphaInv,
+                            grad[static_cast<size_t>(sorted_positions[k]) * block_size + j],
+                            wx,
+                            n,
+                            z);
+            }
+            w[x]          = wx;
+            nz[x * 2]     = n;
+            nz[x * 2 + 1] = z;
+        }
+    }
+}
+} // namespace
+
+template <>
+bool FtrlOp<float, HIPContext>::RunOnDevice()
+{
+    CAFFE_ENFORCE_EQ(Input(GRAD).size(), Input(VAR).size());
+    CAFFE_ENFORCE_EQ(Input(GRAD).size() * 2, Input(N_Z).size());
+    const float* alpha = nullptr;
+    if(ALPHA < InputSize())
+    {
+        CAFFE_ENFORCE_EQ(Input(ALPHA).size(), 1, "alpha should be real-valued");
+        alpha = Input(ALPHA).data<float>();
+    }
+    Output(OUTPUT_VAR)->ResizeLike(Input(VAR));
+    Output(OUTPUT_N_Z)->ResizeLike(Input(N_Z));
+    const int N = Input(GRAD).size();
+    if(N == 0)
+    {
+        return true;
+    }
+    hipLaunchKernelGGL((FtrlKernel),
+                       dim3(CAFFE_GET_BLOCKS(N)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context_.hip_stream(),
+                       N,
+                       params_,
+                       alpha,
+                       Input(VAR).data<float>(),
+                       Input(N_Z).data<float>(),
+                       Input(GRAD).data<float>(),
+                       Output(OUTPUT_VAR)->mutable_data<float>(),
+                       Output(OUTPUT_N_Z)->mutable_data<float>());
+    return true;
+}
+
+class HIPSparseFtrlOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPSparseFtrlOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws), params_(this)
+    {
+        CAFFE_ENFORCE(!HasArgument("alpha") || ALPHA >= InputSize(),
+                      "Cannot specify alpha by both input and argument");
+    }
+
+    bool RunOnDevice() override
+    {
+        CAFFE_ENFORCE_EQ(&Input(VAR), Output(OUTPUT_VAR), "In place operation is required");
+        CAFFE_ENFORCE_EQ(&Input(N_Z), Output(OUTPUT_N_Z), "In place operation is required");
+        CAFFE_ENFORCE_EQ(Input(VAR).size() * 2, Input(N_Z).size());
+        return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(this, Input(INDICES));
+    }
+
+    template <typename SIndex>
+    bool DoRunWithType()
+    {
+        const auto& var    = Input(VAR);
+        const auto n       = Input(INDICES).size();
+        const float* alpha = nullptr;
+        if(ALPHA < InputSize())
+        {
+            CAFFE_ENFORCE_EQ(Input(ALPHA).size(), 1, "alpha should be real-valued");
+            alpha = Input(ALPHA).data<float>();
+        }
+        if(n == 0 || var.size() == 0)
+        {
+            return true;
+        }
+        const auto block_size = var.size() / var.dim(0);
+        CAFFE_ENFORCE_EQ(Input(GRAD).size(), n * block_size);
+        SortIndicesWithPositions<SIndex>(n,
+                                         Input(INDICES).data<SIndex>(),
+                                         &sorted_indices_,
+                                         &sorted_positions_,
+                                         &positions_,
+                                         &sort_buffer_,
+                                         &context_);
+        hipLaunchKernelGGL((SparseFtrlKernel<SIndex>),
+                           dim3(std::min<int>(n, CAFFE_MAXIMUM_NUM_BLOCKS)),
+                           dim3(SparseRowThreads(block_size)),
+                           0,
+                           context_.hip_stream(),
+                           static_cast<const int>(n),
+                           static_cast<const int>(block_size),
+                           params_,
+                           alpha,
+                           Output(OUTPUT_VAR)->mutable_data<float>(),
+                           Output(OUTPUT_N_Z)->mutable_data<float>(),
+                           sorted_indices_.data<SIndex>(),
+                           sorted_positions_.data<int>(),
+                           Input(GRAD).data<float>());
+        return true;
+    }
+
+    protected:
+    FtrlParams<float> params_;
+    Tensor<HIPContext> sorted_indices_;
+    Tensor<HIPContext> sorted_positions_;
+    Tensor<HIPContext> positions_;
+    Tensor<HIPContext> sort_buffer_;
+    INPUT_TAGS(VAR, N_Z, INDICES, GRAD, ALPHA);
+    OUTPUT_TAGS(OUTPUT_VAR, OUTPUT_N_Z);
+};
+
+REGISTER_HIP_OPERATOR(Ftrl, FtrlOp<float, HIPContext>);
+REGISTER_HIP_OPERATOR(SparseFtrl, HIPSparseFtrlOp);
+
+} // namespace caffe2
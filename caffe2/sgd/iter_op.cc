@@ -50,6 +50,11 @@ OPERATOR_SCHEMA(Iter)
     .SetDoc(R"DOC(
 Stores a singe integer, that gets incremented on each call to Run().
 Useful for tracking the iteration count during SGD, for example.
+
+The counter is an int64_t TensorCPU. HIP ops also accept a counter that lives
+on the device, which is then incremented by a kernel, so that the training
+step does not touch host memory. LearningRate and Adam read such a counter on
+the device too.
 )DOC");
 
 OPERATOR_SCHEMA(AtomicIter)
@@ -62,7 +67,11 @@ updates are carried out atomically. This can be used in e.g. Hogwild sgd
 algorithms.
 )DOC")
     .Input(0, "mutex", "The mutex used to do atomic increment.")
-    .Input(1, "iter", "The iter counter as an int64_t TensorCPU.");
+    .Input(
+        1,
+        "iter",
+        "The iter counter as an int64_t TensorCPU, or on the device for "
+        "HIP ops, see Iter.");
 
 NO_GRADIENT(Iter);
 NO_GRADIENT(AtomicIter);
@@ -38,11 +38,12 @@ inline void IncrementIter(TensorCPU* output) {
   (*iter)++;
 }
 
-// IterOp runs an iteration counter. I cannot think of a case where we would
-// need to access the iter variable on device, so this will always produce a
-// tensor on the CPU side. If the blob already exists and is a tensor<int64_t>
-// object, we will simply increment it (this emulates the case when we want to
-// resume training). Otherwise we will have the iter starting with 0.
+// IterOp runs an iteration counter. This produces a tensor on the CPU side,
+// except for the HIP op which also increments a counter already living on the
+// device (see iter_op_hip.cc) for steps that must not touch the host. If the
+// blob already exists and is a tensor<int64_t> object, we will simply
+// increment it (this emulates the case when we want to resume training).
+// Otherwise we will have the iter starting with 0.
 template <class Context>
 class IterOp final : public Operator<Context> {
  public:
@@ -19,6 +19,66 @@
 
 namespace caffe2 {
 
+namespace {
+__global__ void IncrementIterKernel(int64_t* iter)
+{
+    atomicAdd(reinterpret_cast<unsigned long long*>(iter), 1ULL);
+}
+
+// Besides the usual CPU counter, the HIP ops also increment a counter that
+// lives on the device (an int64 HIP tensor of one element, e.g. made by a HIP
+// ConstantFill), with a one thread kernel. The step then neither reads nor
+// writes host memory, which launch graphs need. The device counter is not
+// checked for overflow.
+bool IncrementDeviceIter(TensorHIP* output, HIPContext* context)
+{
+    CAFFE_ENFORCE_EQ(output->size(), 1, "The output of IterOp exists, but not of the right size.");
+    hipLaunchKernelGGL((IncrementIterKernel),
+                       dim3(1),
+                       dim3(1),
+                       0,
+                       context->hip_stream(),
+                       output->mutable_data<int64_t>());
+    return true;
+}
+} // namespace
+
+template <>
+bool IterOp<HIPContext>::RunOnDevice()
+{
+    if(OperatorBase::OutputIsType<TensorHIP>(0))
+    {
+        return IncrementDeviceIter(OperatorBase::Output<TensorHIP>(0), &context_);
+    }
+    if(InputSize() == 0 && !OperatorBase::OutputIsType<TensorCPU>(0))
+    {
+        LOG(ERROR) << "You are using an old definition of IterOp that will "
+                      "be deprecated soon. More specifically, IterOp now "
+                      "requires an explicit in-place input and output.";
+        auto* output = OperatorBase::Output<TensorCPU>(0);
+        VLOG(1) << "Initializing iter counter.";
+        output->Resize(1);
+        output->mutable_data<int64_t>()[0] = 0;
+    }
+    IncrementIter(OperatorBase::Output<TensorCPU>(0));
+    return true;
+}
+
+template <>
+bool AtomicIterOp<HIPContext>::RunOnDevice()
+{
+    auto& mutex = OperatorBase::Input<std::unique_ptr<std::mutex>>(0);
+    std::lock_guard<std::mutex> lg(*mutex);
+    if(OperatorBase::OutputIsType<TensorHIP>(0))
+    {
+        // The increment is atomic on the device, ops running on other
+        // streams can share the counter.
+        return IncrementDeviceIter(OperatorBase::Output<TensorHIP>(0), &context_);
+    }
+    IncrementIter(OperatorBase::Output<TensorCPU>(0));
+    return true;
+}
+
 REGISTER_HIP_OPERATOR(Iter, IterOp<HIPContext>);
 REGISTER_HIP_OPERATOR(AtomicIter, AtomicIterOp<HIPContext>);
 
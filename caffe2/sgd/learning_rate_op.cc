@@ -57,6 +57,9 @@ train_net.LearningRate(*iterations*, "*label*", base_lr=*float*,
 Example usage:
 train_net.LearningRate(200, "LR", base_lr=-0.1,
                             policy="step", stepsize=20, gamma=0.9)
+
+On HIP, the iterations can also be a counter on the device (see Iter): the
+rate is then computed by a kernel, without copying the counter to the host.
 )DOC")
     .Arg("base_lr", "(float, required) base learning rate")
     .Arg("policy", "(float, default 1.0) strategy for gamma enforcement")
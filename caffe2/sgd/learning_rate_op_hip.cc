@@ -16,7 +16,175 @@
 
 #include "caffe2/core/context_hip.h"
 #include "caffe2/sgd/learning_rate_op.h"
+#include "caffe2/utils/math.h"
+#include "hip/hip_runtime.h"
 
 namespace caffe2 {
+
+namespace {
+
+enum DeviceLearningRatePolicy
+{
+    FIXED,
+    ALTER,
+    STEP,
+    EXP,
+    INV,
+    POLY,
+    LINEAR_WARMUP,
+    CONSTANT_WARMUP,
+    HILL,
+};
+
+// The parameters of a learning rate functor, passed by value to the kernel
+// that evaluates it when the iteration counter lives on the device.
+struct DeviceLearningRate
+{
+    DeviceLearningRatePolicy policy = FIXED;
+    float gamma                     = 0;
+    float power                     = 0;
+    float multiplier                = 0;
+    float end_multiplier            = 0;
+    long long period                = 0;
+    long long inactive_period       = 0;
+    bool active_first               = true;
+};
+
+DeviceLearningRate ToDeviceLearningRate(const LearningRateFunctor<float>& functor)
+{
+    DeviceLearningRate p;
+    if(dynamic_cast<const FixedLearningRate<float>*>(&functor))
+    {
+        p.policy = FIXED;
+    }
+    else if(auto* f = dynamic_cast<const AlternateLearningRate<float>*>(&functor))
+    {
+        p.policy          = ALTER;
+        p.period          = f->active_period_;
+        p.inactive_period = f->inactive_period_;
+        p.active_first    = f->active_first_;
+    }
+    else if(auto* f = dynamic_cast<const StepLearningRate<float>*>(&functor))
+    {
+        p.policy = STEP;
+        p.period = f->stepsize_;
+        p.gamma  = f->gamma_;
+    }
+    else if(auto* f = dynamic_cast<const ExpLearningRate<float>*>(&functor))
+    {
+        p.policy = EXP;
+        p.gamma  = f->gamma_;
+    }
+    else if(auto* f = dynamic_cast<const InvLearningRate<float>*>(&functor))
+    {
+        p.policy = INV;
+        p.gamma  = f->gamma_;
+        p.power  = f->power_;
+    }
+    else if(auto* f = dynamic_cast<const PolyLearningRate<float>*>(&functor))
+    {
+        p.policy = POLY;
+        p.power  = f->power_;
+        p.period = f->max_iter_;
+    }
+    else if(auto* f = dynamic_cast<const LinearWarmupLearningRate<float>*>(&functor))
+    {
+        p.policy     = LINEAR_WARMUP;
+        p.multiplier = f->start_multiplier_;
+        p.period     = f->num_iter_;
+    }
+    else if(auto* f = dynamic_cast<const ConstantWarmupLearningRate<float>*>(&functor))
+    {
+        p.policy     = CONSTANT_WARMUP;
+        p.multiplier = f->multiplier_;
+        p.period     = f->num_iter_;
+    }
+    else if(auto* f = dynamic_cast<const HillLearningRate<float>*>(&functor))
+    {
+        p.policy         = HILL;
+        p.multiplier     = f->linear_warmup_lr_.start_multiplier_;
+        p.gamma          = f->inv_lr_.gamma_;
+        p.power          = f->inv_lr_.power_;
+        p.end_multiplier = f->end_multiplier_;
+        p.period         = f->num_iter_;
+    }
+    else
+    {
+        CAFFE_THROW("Learning rate policy not supported with the iteration on the device");
+    }
+    return p;
+}
+
+// Same as the functors of learning_rate_functors.h.
+__device__ float EvalLearningRate(const DeviceLearningRate& p, const long long iter)
+{
+    switch(p.policy)
+    {
+    case FIXED: return 1.f;
+    case ALTER:
+        if(iter % (p.period + p.inactive_period) < (p.active_first ? p.period : p.inactive_period))
+        {
+            return p.active_first ? 1.f : 0.f;
+        }
+        return p.active_first ? 0.f : 1.f;
+    case STEP: return powf(p.gamma, static_cast<float>(iter / p.period));
+    case EXP: return powf(p.gamma, static_cast<float>(iter));
+    case INV: return powf(1.f + p.gamma * iter, -p.power);
+    case POLY: return powf(1.f - float(iter) / float(p.period), p.power);
+    case LINEAR_WARMUP:
+        if(iter >= p.period)
+        {
+            return 1.f;
+        }
+        return p.multiplier + (1.f - p.multiplier) * float(iter) / float(p.period);
+    case CONSTANT_WARMUP: return iter >= p.period ? 1.f : p.multiplier;
+    case HILL:
+        if(iter < p.period)
+        {
+            return p.multiplier + (1.f - p.multiplier) * float(iter) / float(p.period);
+        }
+        return fmaxf(p.end_multiplier, powf(1.f + p.gamma * (iter - p.period), -p.power));
+    }
+    return 1.f;
+}
+
+__global__ void LearningRateKernel(const int64_t* iter,
+                                   const DeviceLearningRate policy,
+                                   const float base_lr,
+                                   float* lr)
+{
+    lr[0] = base_lr * EvalLearningRate(policy, iter[0]);
+}
+} // namespace
+
+template <>
+bool LearningRateOp<float, HIPContext>::RunOnDevice()
+{
+    auto* output = Output(0);
+    output->Resize(vector<TIndex>());
+    if(OperatorBase::InputIsType<TensorCPU>(0))
+    {
+        const int64_t iter = OperatorBase::Input<TensorCPU>(0).data<int64_t>()[0];
+        // The rate goes to the device as a kernel argument, not as a copy of
+        // host memory.
+        math::Set<float, HIPContext>(
+            1, base_lr_ * (*functor_)(iter), output->mutable_data<float>(), &context_);
+        return true;
+    }
+    // The iteration counter lives on the device, see IterOp<HIPContext>: the
+    // rate is evaluated there, without reading the counter back.
+    CAFFE_ENFORCE_EQ(Input(0).size(), 1);
+    hipLaunchKernelGGL((LearningRateKernel),
+                       dim3(1),
+                       dim3(1),
+                       0,
+                       context_.hip_stream(),
+                       Input(0).data<int64_t>(),
+                       ToDeviceLearningRate(*functor_),
+                       base_lr_,
+                       output->mutable_data<float>());
+    return true;
+}
+
 REGISTER_HIP_OPERATOR(LearningRate, LearningRateOp<float, HIPContext>);
 } // namespace caffe2
@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "loss_scale_ops.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(UnscaleGradients, UnscaleGradientsOp<CPUContext>);
+OPERATOR_SCHEMA(UnscaleGradients)
+    .NumInputs(1, INT_MAX)
+    .NumOutputs(1, INT_MAX)
+    .AllowInplace([](int in, int out) { return in == out + 1; })
+    .SetDoc(R"DOC(
+
+Undoes loss scaling on the gradients of a loss that was multiplied by
+loss_scale, for mixed-precision training where float16 gradients would
+otherwise underflow. The inputs are loss_scale followed by the gradients,
+which may be float or float16, and the outputs are the unscaled gradients, in
+place, followed by found_inf.
+
+found_inf is 1 if any unscaled gradient is not finite, and 0 otherwise. In
+that case all gradients are set to zero so that the step does not corrupt
+the parameters; feed found_inf to UpdateLossScale to back the scale off.
+
+On devices the gradients are processed in a few chunked kernel launches, and
+found_inf stays on the device.
+
+)DOC")
+    .Input(0, "loss_scale", "1-element float tensor the loss was scaled by");
+SHOULD_NOT_DO_GRADIENT(UnscaleGradients);
+
+REGISTER_CPU_OPERATOR(UpdateLossScale, UpdateLossScaleOp<CPUContext>);
+OPERATOR_SCHEMA(UpdateLossScale)
+    .NumInputs(3)
+    .NumOutputs(2)
+    .AllowInplace({{0, 0}, {1, 1}})
+    .SetDoc(R"DOC(
+
+Dynamic loss scaling. If found_inf is set, loss_scale is multiplied by
+backoff_factor, but not below min_scale, and good_steps is reset. Otherwise
+good_steps is incremented, and once it reaches growth_interval, loss_scale is
+multiplied by growth_factor and good_steps is reset.
+
+)DOC")
+    .Input(0, "loss_scale", "1-element float tensor")
+    .Input(1, "good_steps", "1-element int tensor, steps since the last change")
+    .Input(2, "found_inf", "found_inf output of UnscaleGradients")
+    .Output(0, "loss_scale", "Updated loss_scale")
+    .Output(1, "good_steps", "Updated good_steps")
+    .Arg("growth_factor", "Default 2")
+    .Arg("backoff_factor", "Default 0.5")
+    .Arg("growth_interval", "Default 2000")
+    .Arg("min_scale", "Default 1");
+SHOULD_NOT_DO_GRADIENT(UpdateLossScale);
+
+} // namespace caffe2
@@ -0,0 +1,186 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/conversions.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+// Pointers to one gradient unscaled by UnscaleGradients.
+template <typename T>
+struct UnscaleGradientsParam {
+  int size;
+  const T* grad;
+  T* grad_out;
+};
+
+// Divides every gradient by loss_scale and sets found_inf to 1 if any of the
+// results is not finite, in which case all gradients are zeroed.
+template <typename T, typename Context>
+void unscale_gradients(
+    const std::vector<UnscaleGradientsParam<T>>& params,
+    const float* loss_scale,
+    float* found_inf,
+    Context* /*context*/) {
+  const float inv_scale = 1.0f / loss_scale[0];
+  bool finite = true;
+  for (const auto& p : params) {
+    for (auto i = 0; i < p.size; ++i) {
+      const float g = convert::To<T, float>(p.grad[i]) * inv_scale;
+      finite = finite && std::isfinite(g);
+      p.grad_out[i] = convert::To<float, T>(g);
+    }
+  }
+  found_inf[0] = finite ? 0.0f : 1.0f;
+  if (!finite) {
+    for (const auto& p : params) {
+      std::fill(p.grad_out, p.grad_out + p.size, convert::To<float, T>(0));
+    }
+  }
+}
+
+template <typename Context>
+void update_loss_scale(
+    const float* found_inf,
+    float* loss_scale,
+    int* good_steps,
+    const float growth_factor,
+    const float backoff_factor,
+    const int growth_interval,
+    const float min_scale,
+    Context* /*context*/) {
+  if (found_inf[0] > 0) {
+    loss_scale[0] = std::max(loss_scale[0] * backoff_factor, min_scale);
+    good_steps[0] = 0;
+  } else if (++good_steps[0] >= growth_interval) {
+    loss_scale[0] *= growth_factor;
+    good_steps[0] = 0;
+  }
+}
+
+// Unscales the gradients of a loss that was multiplied by loss_scale. Inputs
+// are (loss_scale, grad_0, grad_1, ...) and outputs (grad_0, grad_1, ...,
+// found_inf), the gradients in place.
+template <class Context>
+class UnscaleGradientsOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  UnscaleGradientsOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws) {
+    CAFFE_ENFORCE_EQ(InputSize(), OutputSize());
+  }
+
+  bool RunOnDevice() override {
+    CAFFE_ENFORCE_EQ(Input(LOSS_SCALE).size(), 1);
+    if (InputSize() == 1) {
+      auto* found_inf = Output(0);
+      found_inf->Resize(1);
+      math::Set<float, Context>(
+          1, 0.0f, found_inf->template mutable_data<float>(), &context_);
+      return true;
+    }
+    return DispatchHelper<TensorTypes<float, float16>>::call(this, Input(1));
+  }
+
+  template <typename T>
+  bool DoRunWithType() {
+    const int n = InputSize() - 1;
+    std::vector<UnscaleGradientsParam<T>> params(n);
+    for (int i = 0; i < n; ++i) {
+      const auto& grad = Input(i + 1);
+      Output(i)->ResizeLike(grad);
+      params[i].size = grad.size();
+      params[i].grad = grad.template data<T>();
+      params[i].grad_out = Output(i)->template mutable_data<T>();
+    }
+    auto* found_inf = Output(n);
+    found_inf->Resize(1);
+    unscale_gradients<T, Context>(
+        params,
+        Input(LOSS_SCALE).template data<float>(),
+        found_inf->template mutable_data<float>(),
+        &context_);
+    return true;
+  }
+
+ protected:
+  INPUT_TAGS(LOSS_SCALE);
+};
+
+// Dynamic loss scaling: backs the scale off after an overflow and grows it
+// after growth_interval steps without one.
+template <class Context>
+class UpdateLossScaleOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  UpdateLossScaleOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        growth_factor_(
+            OperatorBase::GetSingleArgument<float>("growth_factor", 2.0f)),
+        backoff_factor_(
+            OperatorBase::GetSingleArgument<float>("backoff_factor", 0.5f)),
+        growth_interval_(
+            OperatorBase::GetSingleArgument<int>("growth_interval", 2000)),
+        min_scale_(OperatorBase::GetSingleArgument<float>("min_scale", 1.0f)) {
+    CAFFE_ENFORCE_GT(growth_interval_, 0);
+  }
+
+  bool RunOnDevice() override {
+    CAFFE_ENFORCE_EQ(Input(LOSS_SCALE).size(), 1);
+    CAFFE_ENFORCE_EQ(Input(GOOD_STEPS).size(), 1);
+    CAFFE_ENFORCE_EQ(Input(FOUND_INF).size(), 1);
+    Output(OUTPUT_LOSS_SCALE)->ResizeLike(Input(LOSS_SCALE));
+    Output(OUTPUT_GOOD_STEPS)->ResizeLike(Input(GOOD_STEPS));
+    auto* loss_scale =
+        Output(OUTPUT_LOSS_SCALE)->template mutable_data<float>();
+    auto* good_steps = Output(OUTPUT_GOOD_STEPS)->template mutable_data<int>();
+    if (loss_scale != Input(LOSS_SCALE).template data<float>()) {
+      context_.template Copy<float, Context, Context>(
+          1, Input(LOSS_SCALE).template data<float>(), loss_scale);
+    }
+    if (good_steps != Input(GOOD_STEPS).template data<int>()) {
+      context_.template Copy<int, Context, Context>(
+          1, Input(GOOD_STEPS).template data<int>(), good_steps);
+    }
+    update_loss_scale<Context>(
+        Input(FOUND_INF).template data<float>(),
+        loss_scale,
+        good_steps,
+        growth_factor_,
+        backoff_factor_,
+        growth_interval_,
+        min_scale_,
+        &context_);
+    return true;
+  }
+
+ protected:
+  float growth_factor_;
+  float backoff_factor_;
+  int growth_interval_;
+  float min_scale_;
+  INPUT_TAGS(LOSS_SCALE, GOOD_STEPS, FOUND_INF);
+  OUTPUT_TAGS(OUTPUT_LOSS_SCALE, OUTPUT_GOOD_STEPS);
+};
+
+} // namespace caffe2
@@ -0,0 +1,165 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "loss_scale_ops.h"
+#include "caffe2/core/common_hip.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/sgd/multi_tensor_apply_hip.h"
+#include "hip/hip_runtime.h"
+
+namespace caffe2 {
+
+namespace {
+
+template <typename T>
+__global__ void UnscaleGradientsKernel(const MultiTensorLaunch<UnscaleGradientsParam<T>> meta,
+                                       const float* loss_scale,
+                                       float* found_inf)
+{
+    const auto& p         = meta.params[meta.block_to_tensor[hipBlockIdx_x]];
+    const int start       = meta.block_to_chunk[hipBlockIdx_x] * kMultiTensorChunkSize;
+    const int end         = min(start + kMultiTensorChunkSize, p.size);
+    const float inv_scale = 1.0f / loss_scale[0];
+    for(int i = start + hipThreadIdx_x; i < end; i += hipBlockDim_x)
+    {
+        const float g = convert::To<T, float>(p.grad[i]) * inv_scale;
+        if(!isfinite(g))
+        {
+            // every writer stores the same value
+            found_inf[0] = 1.0f;
+        }
+        p.grad_out[i] = convert::To<float, T>(g);
+    }
+}
+
+// Launched after all chunks were unscaled, so that found_inf is final.
+template <typename T>
+__global__ void ZeroGradientsIfInfKernel(const MultiTensorLaunch<UnscaleGradientsParam<T>> meta,
+                                         const float* found_inf)
+{
+    if(found_inf[0] == 0.0f)
+    {
+        return;
+    }
+    const auto& p   = meta.params[meta.block_to_tensor[hipBlockIdx_x]];
+    const int start = meta.block_to_chunk[hipBlockIdx_x] * kMultiTensorChunkSize;
+    const int end   = min(start + kMultiTensorChunkSize, p.size);
+    for(int i = start + hipThreadIdx_x; i < end; i += hipBlockDim_x)
+    {
+        p.grad_out[i] = convert::To<float, T>(0.0f);
+    }
+}
+
+template <typename T>
+void UnscaleGradientsHIP(const std::vector<UnscaleGradientsParam<T>>& params,
+                         const float* loss_scale,
+                         float* found_inf,
+                         HIPContext* context)
+{
+    math::Set<float, HIPContext>(1, 0.0f, found_inf, context);
+    MultiTensorApply(
+        params, [&](const MultiTensorLaunch<UnscaleGradientsParam<T>>& meta, int blocks) {
+            hipLaunchKernelGGL((UnscaleGradientsKernel<T>),
+                               dim3(blocks),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context->hip_stream(),
+                               meta,
+                               loss_scale,
+                               found_inf);
+        });
+    MultiTensorApply(
+        params, [&](const MultiTensorLaunch<UnscaleGradientsParam<T>>& meta, int blocks) {
+            hipLaunchKernelGGL((ZeroGradientsIfInfKernel<T>),
+                               dim3(blocks),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context->hip_stream(),
+                               meta,
+                               found_inf);
+        });
+}
+
+__global__ void UpdateLossScaleKernel(const float* found_inf,
+                                      float* loss_scale,
+                                      int* good_steps,
+                                      const float growth_factor,
+                                      const float backoff_factor,
+                                      const int growth_interval,
+                                      const float min_scale)
+{
+    if(found_inf[0] > 0)
+    {
+        loss_scale[0] = fmaxf(loss_scale[0] * backoff_factor, min_scale);
+        good_steps[0] = 0;
+    }
+    else if(++good_steps[0] >= growth_interval)
+    {
+        loss_scale[0] *= growth_factor;
+        good_steps[0] = 0;
+    }
+}
+
+} // namespace
+
+template <>
+void unscale_gradients<float, HIPContext>(const std::vector<UnscaleGradientsParam<float>>& params,
+                                          const float* loss_scale,
+                                          float* found_inf,
+                                          HIPContext* context)
+{
+    UnscaleGradientsHIP<float>(params, loss_scale, found_inf, context);
+}
+
+template <>
+void unscale_gradients<float16, HIPContext>(
+    const std::vector<UnscaleGradientsParam<float16>>& params,
+    const float* loss_scale,
+    float* found_inf,
+    HIPContext* context)
+{
+    UnscaleGradientsHIP<float16>(params, loss_scale, found_inf, context);
+}
+
+template <>
+void update_loss_scale<HIPContext>(const float* found_inf,
+                                   float* loss_scale,
+                                   int* good_steps,
+                                   const float growth_factor,
+                                   const float backoff_factor,
+                                   const int growth_interval,
+                                   const float min_scale,
+                                   HIPContext* context)
+{
+    // A single thread keeps the scale on the device, without a sync.
+    hipLaunchKernelGGL((UpdateLossScaleKernel),
+                       dim3(1),
+                       dim3(1),
+                       0,
+                       context->hip_stream(),
+                       found_inf,
+                       loss_scale,
+                       good_steps,
+                       growth_factor,
+                       backoff_factor,
+                       growth_interval,
+                       min_scale);
+}
+
+REGISTER_HIP_OPERATOR(UnscaleGradients, UnscaleGradientsOp<HIPContext>);
+REGISTER_HIP_OPERATOR(UpdateLossScale, UpdateLossScaleOp<HIPContext>);
+
+} // namespace caffe2
@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "caffe2/core/common_hip.h"
+
+namespace caffe2 {
+
+// Every block of a launch updates one chunk of one tensor. The tensor list
+// and the block -> (tensor, chunk) map are passed by value as a kernel
+// argument, so a launch needs no host to device copy; the limits keep the
+// argument a few KB.
+constexpr int kMultiTensorMaxTensors = 24;
+constexpr int kMultiTensorMaxBlocks  = 160;
+constexpr int kMultiTensorChunkSize  = 16 * CAFFE_HIP_NUM_THREADS;
+
+template <typename P>
+struct MultiTensorLaunch
+{
+    P params[kMultiTensorMaxTensors];
+    int block_to_tensor[kMultiTensorMaxBlocks];
+    int block_to_chunk[kMultiTensorMaxBlocks];
+};
+
+// Splits params, which need a size member, into chunks and calls
+// launch(meta, num_blocks) every time a launch is full.
+template <typename P, typename Launch>
+void MultiTensorApply(const std::vector<P>& params, Launch launch)
+{
+    MultiTensorLaunch<P> meta;
+    int tensor = 0;
+    int blocks = 0;
+    for(const auto& p : params)
+    {
+        if(p.size == 0)
+        {
+            continue;
+        }
+        meta.params[tensor] = p;
+        const int chunks    = (p.size + kMultiTensorChunkSize - 1) / kMultiTensorChunkSize;
+        for(int chunk = 0; chunk < chunks; ++chunk)
+        {
+            meta.block_to_tensor[blocks] = tensor;
+            meta.block_to_chunk[blocks]  = chunk;
+            ++blocks;
+            const bool last_chunk = chunk == chunks - 1;
+            if(blocks == kMultiTensorMaxBlocks ||
+               (last_chunk && tensor + 1 == kMultiTensorMaxTensors))
+            {
+                launch(meta, blocks);
+                blocks = 0;
+                if(last_chunk)
+                {
+                    tensor = -1;
+                }
+                else
+                {
+                    // the rest of this tensor goes to the next launch
+                    meta.params[0] = p;
+                    tensor         = 0;
+                }
+            }
+        }
+        ++tensor;
+    }
+    if(blocks > 0)
+    {
+        launch(meta, blocks);
+    }
+}
+
+} // namespace caffe2
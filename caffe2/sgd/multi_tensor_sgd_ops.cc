@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "multi_tensor_sgd_ops.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(
+    MultiTensorMomentumSGDUpdate,
+    MultiTensorMomentumSGDUpdateOp<CPUContext>);
+OPERATOR_SCHEMA(MultiTensorMomentumSGDUpdate)
+    .NumInputs(4, INT_MAX)
+    .NumOutputs(3, INT_MAX)
+    .AllowInplace([](int in, int out) { return in == out + 1; })
+    .SetDoc(R"DOC(
+
+Applies MomentumSGDUpdate to a list of parameters at once. The inputs are
+the learning rate followed by (grad, moment, param) for every parameter, and
+the outputs are the updated (grad, moment, param) of every parameter, in
+place.
+
+If master_weights is set, every parameter comes with a fourth, float blob
+(grad, moment, param, master): the update is computed on the master weights
+and param, which can then be float16 like grad, receives a copy of them.
+Moments are always float.
+
+On devices the whole list is processed in a few chunked kernel launches
+instead of one per parameter.
+
+)DOC")
+    .Input(0, "lr", "Learning rate")
+    .Arg("momentum", "Momentum hyperparameter.")
+    .Arg("nesterov", "(boolean) Whether to use Nesterov Accelerated Gradient.")
+    .Arg("master_weights", "(boolean) Whether fp32 master weights are given.");
+SHOULD_NOT_DO_GRADIENT(MultiTensorMomentumSGDUpdate);
+
+REGISTER_CPU_OPERATOR(MultiTensorAdam, MultiTensorAdamOp<CPUContext>);
+OPERATOR_SCHEMA(MultiTensorAdam)
+    .NumInputs(6, INT_MAX)
+    .NumOutputs(3, INT_MAX)
+    .AllowInplace([](int in, int out) {
+      // Which of the two layouts is used depends on master_weights, the op
+      // checks the pairs against it.
+      if (in < 2) {
+        return false;
+      }
+      // (param, moment_1, moment_2, grad) -> (param, moment_1, moment_2)
+      if ((in - 2) % 4 < 3 && out == (in - 2) / 4 * 3 + (in - 2) % 4) {
+        return true;
+      }
+      // (param, moment_1, moment_2, grad, master) ->
+      // (param, moment_1, moment_2, master)
+      const int k = (in - 2) % 5;
+      return k != 3 && out == (in - 2) / 5 * 4 + (k == 4 ? 3 : k);
+    })
+    .SetDoc(R"DOC(
+
+Applies Adam to a list of parameters at once. The inputs are (lr, iter)
+followed by (param, moment_1, moment_2, grad) for every parameter, and the
+outputs are the updated (param, moment_1, moment_2) of every parameter, in
+place.
+
+If master_weights is set, every parameter also comes with a float master
+weight blob after its gradient and output after its moment_2: the update is
+computed on the master weights and param, which can then be float16 like
+grad, receives a copy of them. Moments are always float.
+
+On devices the whole list is processed in a few chunked kernel launches
+instead of one per parameter.
+
+)DOC")
+    .Input(0, "lr", "learning rate")
+    .Input(1, "iter", "iteration number")
+    .Arg("beta1", "Default 0.9")
+    .Arg("beta2", "Default 0.999")
+    .Arg("epsilon", "Default 1e-5")
+    .Arg("master_weights", "(boolean) Whether fp32 master weights are given.");
+SHOULD_NOT_DO_GRADIENT(MultiTensorAdam);
+
+} // namespace caffe2
@@ -0,0 +1,290 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/conversions.h"
+
+namespace caffe2 {
+
+// Pointers to the blobs of one parameter updated by
+// MultiTensorMomentumSGDUpdate. master is null unless master weights are used,
+// in which case the update is done on master and param is a copy of it.
+template <typename T>
+struct MultiTensorMomentumSGDParam {
+  int size;
+  const T* grad;
+  float* moment;
+  T* param;
+  float* master;
+  T* grad_out;
+};
+
+// Pointers to the blobs of one parameter updated by MultiTensorAdam.
+template <typename T>
+struct MultiTensorAdamParam {
+  int size;
+  const T* grad;
+  float* moment_1;
+  float* moment_2;
+  T* param;
+  float* master;
+};
+
+template <typename T, typename Context>
+void multi_tensor_momentum_sgd_update(
+    const std::vector<MultiTensorMomentumSGDParam<T>>& params,
+    const float* lr,
+    const float momentum,
+    const bool nesterov,
+    Context* /*context*/) {
+  const float LR = lr[0];
+  for (const auto& p : params) {
+    for (auto i = 0; i < p.size; ++i) {
+      const float g = convert::To<T, float>(p.grad[i]);
+      const float w =
+          p.master ? p.master[i] : convert::To<T, float>(p.param[i]);
+      float ng;
+      if (!nesterov) {
+        ng = LR * g + momentum * p.moment[i];
+        p.moment[i] = ng;
+      } else {
+        const float mi = p.moment[i];
+        const float mi_new = momentum * mi + LR * g;
+        p.moment[i] = mi_new;
+        ng = (1 + momentum) * mi_new - momentum * mi;
+      }
+      p.grad_out[i] = convert::To<float, T>(ng);
+      if (p.master) {
+        p.master[i] = w - ng;
+      }
+      p.param[i] = convert::To<float, T>(w - ng);
+    }
+  }
+}
+
+template <typename T, typename Context>
+void multi_tensor_adam_update(
+    const std::vector<MultiTensorAdamParam<T>>& params,
+    const float* lr,
+    const float beta1,
+    const float beta2,
+    const float eps_hat,
+    const float correction,
+    Context* /*context*/) {
+  for (const auto& p : params) {
+    for (auto i = 0; i < p.size; ++i) {
+      const float g = convert::To<T, float>(p.grad[i]);
+      const float w =
+          p.master ? p.master[i] : convert::To<T, float>(p.param[i]);
+      const float mi = p.moment_1[i] = p.moment_1[i] * beta1 + g * (1 - beta1);
+      const float vi = p.moment_2[i] =
+          p.moment_2[i] * beta2 + g * g * (1 - beta2);
+      const float nw = w + lr[0] * correction * mi / (std::sqrt(vi) + eps_hat);
+      if (p.master) {
+        p.master[i] = nw;
+      }
+      p.param[i] = convert::To<float, T>(nw);
+    }
+  }
+}
+
+// Momentum SGD update of many parameters at once, so that devices can apply
+// all of them with a handful of kernel launches instead of one per blob.
+// Inputs are (lr, grad_0, moment_0, param_0[, master_0], grad_1, ...) and
+// outputs (grad_0, moment_0, param_0[, master_0], grad_1, ...), all in place.
+template <class Context>
+class MultiTensorMomentumSGDUpdateOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  MultiTensorMomentumSGDUpdateOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        momentum_(OperatorBase::GetSingleArgument<float>("momentum", 0.0)),
+        nesterov_(OperatorBase::GetSingleArgument<int>("nesterov", 0)),
+        master_weights_(
+            OperatorBase::GetSingleArgument<int>("master_weights", 0)),
+        group_(3 + master_weights_) {
+    CAFFE_ENFORCE_EQ(
+        (InputSize() - 1) % group_, 0, "Unexpected number of inputs");
+    CAFFE_ENFORCE_EQ(InputSize() - 1, OutputSize());
+  }
+
+  bool RunOnDevice() override {
+    CAFFE_ENFORCE_EQ(Input(LR).size(), 1);
+    return DispatchHelper<TensorTypes<float, float16>>::call(this, Input(1));
+  }
+
+  template <typename T>
+  bool DoRunWithType() {
+    const int n = (InputSize() - 1) / group_;
+    std::vector<MultiTensorMomentumSGDParam<T>> params(n);
+    for (int i = 0; i < n; ++i) {
+      const int in = 1 + i * group_;
+      const int out = i * group_;
+      const auto& grad = Input(in + GRAD);
+      CAFFE_ENFORCE_EQ(grad.size(), Input(in + MOMENT).size());
+      CAFFE_ENFORCE_EQ(grad.size(), Input(in + PARAM).size());
+      Output(out + GRAD)->ResizeLike(grad);
+      Output(out + MOMENT)->ResizeLike(Input(in + MOMENT));
+      Output(out + PARAM)->ResizeLike(Input(in + PARAM));
+
+      auto& p = params[i];
+      p.size = grad.size();
+      p.grad = grad.template data<T>();
+      p.moment = Output(out + MOMENT)->template mutable_data<float>();
+      p.param = Output(out + PARAM)->template mutable_data<T>();
+      p.grad_out = Output(out + GRAD)->template mutable_data<T>();
+      p.master = nullptr;
+      if (master_weights_) {
+        CAFFE_ENFORCE_EQ(grad.size(), Input(in + MASTER).size());
+        Output(out + MASTER)->ResizeLike(Input(in + MASTER));
+        p.master = Output(out + MASTER)->template mutable_data<float>();
+      }
+    }
+    multi_tensor_momentum_sgd_update<T, Context>(
+        params,
+        Input(LR).template data<float>(),
+        momentum_,
+        nesterov_,
+        &context_);
+    return true;
+  }
+
+ protected:
+  float momentum_;
+  bool nesterov_;
+  bool master_weights_;
+  int group_;
+  // Offsets within the group of blobs of one parameter.
+  enum { GRAD = 0, MOMENT = 1, PARAM = 2, MASTER = 3 };
+  INPUT_TAGS(LR);
+};
+
+// Adam update of many parameters at once. Inputs are
+// (lr, iter, param_0, moment_1_0, moment_2_0, grad_0[, master_0], param_1,
+// ...) and outputs (param_0, moment_1_0, moment_2_0[, master_0], param_1,
+// ...), all in place.
+template <class Context>
+class MultiTensorAdamOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  MultiTensorAdamOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        beta1_(OperatorBase::GetSingleArgument<float>("beta1", 0.9f)),
+        beta2_(OperatorBase::GetSingleArgument<float>("beta2", 0.999f)),
+        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)),
+        master_weights_(
+            OperatorBase::GetSingleArgument<int>("master_weights", 0)),
+        in_group_(4 + master_weights_),
+        out_group_(3 + master_weights_) {
+    CAFFE_ENFORCE_EQ(
+        (InputSize() - 2) % in_group_, 0, "Unexpected number of inputs");
+    CAFFE_ENFORCE_EQ((InputSize() - 2) / in_group_ * out_group_, OutputSize());
+    // The schema cannot see master_weights and allows the in-place pairs of
+    // both layouts, so check them against the actual one.
+    for (int in = 2; in < InputSize(); ++in) {
+      const int k = (in - 2) % in_group_;
+      // The master weights come after the gradient in the inputs and after
+      // moment_2 in the outputs; the gradient is not an output.
+      const int expected = k == GRAD
+          ? -1
+          : (in - 2) / in_group_ * out_group_ + (k > GRAD ? 3 : k);
+      for (int out = 0; out < OutputSize(); ++out) {
+        CAFFE_ENFORCE(
+            operator_def.input(in) != operator_def.output(out) ||
+                out == expected,
+            "Input ",
+            in,
+            " and output ",
+            out,
+            " (",
+            operator_def.output(out),
+            ") cannot be in place",
+            master_weights_ ? " with master weights" : "");
+      }
+    }
+  }
+
+  bool RunOnDevice() override {
+    // Iter live on the CPU
+    CAFFE_ENFORCE(OperatorBase::InputIsType<TensorCPU>(ITER));
+    CAFFE_ENFORCE_EQ(Input(LR).size(), 1);
+    return DispatchHelper<TensorTypes<float, float16>>::call(this, Input(2));
+  }
+
+  template <typename T>
+  bool DoRunWithType() {
+    const int n = (InputSize() - 2) / in_group_;
+    std::vector<MultiTensorAdamParam<T>> params(n);
+    for (int i = 0; i < n; ++i) {
+      const int in = 2 + i * in_group_;
+      const int out = i * out_group_;
+      const auto& grad = Input(in + GRAD);
+      CAFFE_ENFORCE_EQ(grad.size(), Input(in + PARAM).size());
+      CAFFE_ENFORCE_EQ(grad.size(), Input(in + MOMENT_1).size());
+      CAFFE_ENFORCE_EQ(grad.size(), Input(in + MOMENT_2).size());
+      Output(out + PARAM)->ResizeLike(Input(in + PARAM));
+      Output(out + MOMENT_1)->ResizeLike(Input(in + MOMENT_1));
+      Output(out + MOMENT_2)->ResizeLike(Input(in + MOMENT_2));
+
+      auto& p = params[i];
+      p.size = grad.size();
+      p.grad = grad.template data<T>();
+      p.moment_1 = Output(out + MOMENT_1)->template mutable_data<float>();
+      p.moment_2 = Output(out + MOMENT_2)->template mutable_data<float>();
+      p.param = Output(out + PARAM)->template mutable_data<T>();
+      p.master = nullptr;
+      if (master_weights_) {
+        // in the inputs the master weights come after the gradient
+        CAFFE_ENFORCE_EQ(grad.size(), Input(in + 4).size());
+        Output(out + 3)->ResizeLike(Input(in + 4));
+        p.master = Output(out + 3)->template mutable_data<float>();
+      }
+    }
+
+    const auto iter =
+        OperatorBase::Input<TensorCPU>(ITER).template data<int64_t>()[0];
+    const auto t = iter + 1;
+    const float correction = std::sqrt(1.0f - std::pow(beta2_, t)) /
+        (1.0f - std::pow(beta1_, t));
+    multi_tensor_adam_update<T, Context>(
+        params,
+        Input(LR).template data<float>(),
+        beta1_,
+        beta2_,
+        epsilon_,
+        correction,
+        &context_);
+    return true;
+  }
+
+ protected:
+  float beta1_;
+  float beta2_;
+  float epsilon_;
+  bool master_weights_;
+  int in_group_;
+  int out_group_;
+  // Offsets within the group of blobs of one parameter.
+  enum { PARAM = 0, MOMENT_1 = 1, MOMENT_2 = 2, GRAD = 3 };
+  INPUT_TAGS(LR, ITER);
+};
+
+} // namespace caffe2
@@ -0,0 +1,194 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "multi_tensor_sgd_ops.h"
+#include "caffe2/core/common_hip.h"
+#include "caffe2/core/context_hip.h"
+#include "caffe2/sgd/multi_tensor_apply_hip.h"
+#include "hip/hip_runtime.h"
+
+namespace caffe2 {
+
+namespace {
+
+template <typename T>
+__global__ void MultiTensorMomentumSGDKernel(
+    const MultiTensorLaunch<MultiTensorMomentumSGDParam<T>> meta,
+    const float* lr,
+    const float momentum,
+    const bool nesterov)
+{
+    const auto& p   = meta.params[meta.block_to_tensor[hipBlockIdx_x]];
+    const int start = meta.block_to_chunk[hipBlockIdx_x] * kMultiTensorChunkSize;
+    const int end   = min(start + kMultiTensorChunkSize, p.size);
+    const float LR  = lr[0];
+    for(int i = start + hipThreadIdx_x; i < end; i += hipBlockDim_x)
+    {
+        const float g = convert::To<T, float>(p.grad[i]);
+        const float w = p.master ? p.master[i] : convert::To<T, float>(p.param[i]);
+        float ng;
+        if(!nesterov)
+        {
+            ng          = LR * g + momentum * p.moment[i];
+            p.moment[i] = ng;
+        }
+        else
+        {
+            const float mi     = p.moment[i];
+            const float mi_new = momentum * mi + LR * g;
+            p.moment[i]        = mi_new;
+            ng                 = (1 + momentum) * mi_new - momentum * mi;
+        }
+        p.grad_out[i] = convert::To<float, T>(ng);
+        if(p.master)
+        {
+            p.master[i] = w - ng;
+        }
+        p.param[i] = convert::To<float, T>(w - ng);
+    }
+}
+
+template <typename T>
+__global__ void MultiTensorAdamKernel(const MultiTensorLaunch<MultiTensorAdamParam<T>> meta,
+                                      const float* lr,
+                                      const float beta1,
+                                      const float beta2,
+                                      const float eps_hat,
+                                      const float correction)
+{
+    const auto& p   = meta.params[meta.block_to_tensor[hipBlockIdx_x]];
+    const int start = meta.block_to_chunk[hipBlockIdx_x] * kMultiTensorChunkSize;
+    const int end   = min(start + kMultiTensorChunkSize, p.size);
+    const float LR  = lr[0];
+    for(int i = start + hipThreadIdx_x; i < end; i += hipBlockDim_x)
+    {
+        const float g  = convert::To<T, float>(p.grad[i]);
+        const float w  = p.master ? p.master[i] : convert::To<T, float>(p.param[i]);
+        const float mi = p.moment_1[i] = p.moment_1[i] * beta1 + g * (1 - beta1);
+        const float vi = p.moment_2[i] = p.moment_2[i] * beta2 + g * g * (1 - beta2);
+        const float nw = w + LR * correction * mi / (sqrtf(vi) + eps_hat);
+        if(p.master)
+        {
+            p.master[i] = nw;
+        }
+        p.param[i] = convert::To<float, T>(nw);
+    }
+}
+
+} // namespace
+
+template <>
+void multi_tensor_momentum_sgd_update<float, HIPContext>(
+    const std::vector<MultiTensorMomentumSGDParam<float>>& params,
+    const float* lr,
+    const float momentum,
+    const bool nesterov,
+    HIPContext* context)
+{
+    MultiTensorApply(
+        params,
+        [&](const MultiTensorLaunch<MultiTensorMomentumSGDParam<float>>& meta, int blocks) {
+            hipLaunchKernelGGL((MultiTensorMomentumSGDKernel<float>),
+                               dim3(blocks),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context->hip_stream(),
+                               meta,
+                               lr,
+                               momentum,
+                               nesterov);
+        });
+}
+
+template <>
+void multi_tensor_momentum_sgd_update<float16, HIPContext>(
+    const std::vector<MultiTensorMomentumSGDParam<float16>>& params,
+    const float* lr,
+    const float momentum,
+    const bool nesterov,
+    HIPContext* context)
+{
+    MultiTensorApply(
+        params,
+        [&](const MultiTensorLaunch<MultiTensorMomentumSGDParam<float16>>& meta, int blocks) {
+            hipLaunchKernelGGL((MultiTensorMomentumSGDKernel<float16>),
+                               dim3(blocks),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context->hip_stream(),
+                               meta,
+                               lr,
+                               momentum,
+                               nesterov);
+        });
+}
+
+template <>
+void multi_tensor_adam_update<float, HIPContext>(
+    const std::vector<MultiTensorAdamParam<float>>& params,
+    const float* lr,
+    const float beta1,
+    const float beta2,
+    const float eps_hat,
+    const float correction,
+    HIPContext* context)
+{
+    MultiTensorApply(
+        params, [&](const MultiTensorLaunch<MultiTensorAdamParam<float>>& meta, int blocks) {
+            hipLaunchKernelGGL((MultiTensorAdamKernel<float>),
+                               dim3(blocks),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context->hip_stream(),
+                               meta,
+                               lr,
+                               beta1,
+                               beta2,
+                               eps_hat,
+                               correction);
+        });
+}
+
+template <>
+void multi_tensor_adam_update<float16, HIPContext>(
+    const std::vector<MultiTensorAdamParam<float16>>& params,
+    const float* lr,
+    const float beta1,
+    const float beta2,
+    const float eps_hat,
+    const float correction,
+    HIPContext* context)
+{
+    MultiTensorApply(
+        params, [&](const MultiTensorLaunch<MultiTensorAdamParam<float16>>& meta, int blocks) {
+            hipLaunchKernelGGL((MultiTensorAdamKernel<float16>),
+                               dim3(blocks),
+                               dim3(CAFFE_HIP_NUM_THREADS),
+                               0,
+                               context->hip_stream(),
+                               meta,
+                               lr,
+                               beta1,
+                               beta2,
+                               eps_hat,
+                               correction);
+        });
+}
+
+REGISTER_HIP_OPERATOR(MultiTensorMomentumSGDUpdate, MultiTensorMomentumSGDUpdateOp<HIPContext>);
+REGISTER_HIP_OPERATOR(MultiTensorAdam, MultiTensorAdamOp<HIPContext>);
+
+} // namespace caffe2
@@ -67,4 +67,37 @@ returns (grad_o, mean_squares_o, mom_o).
 )DOC");
 SHOULD_NOT_DO_GRADIENT(RmsProp);
 
+REGISTER_CPU_OPERATOR(SparseRmsProp, SparseRmsPropOp<float, CPUContext>);
+OPERATOR_SCHEMA(SparseRmsProp)
+    .NumInputs(6)
+    .NumOutputs(3)
+    .EnforceOneToOneInplace()
+    .SetDoc(R"DOC(
+
+Given inputs (param, mean_squares, mom, indices, grad, lr), runs the RmsProp
+update on the rows of (mean_squares, mom) given by indices, and adds the new
+momentum to the same rows of param:
+
+    mean_squares_o = mean_squares + (1 - decay) * (square(grad) - mean_squares)
+    mom_o = momentum * mom + lr * grad / sqrt(epsilon + mean_squares_o)
+    param_o = param + mom_o
+
+Duplicate indices are applied one after the other. Returns (param_o,
+mean_squares_o, mom_o).
+
+)DOC")
+    .Input(0, "param", "Parameters to be updated")
+    .Input(1, "mean_squares", "Mean squares history")
+    .Input(2, "mom", "Momentum history")
+    .Input(3, "indices", "Sparse indices")
+    .Input(4, "grad", "Gradient computed")
+    .Input(5, "lr", "learning rate")
+    .Output(0, "output_param", "Updated parameters")
+    .Output(1, "output_mean_squares", "Updated mean squares")
+    .Output(2, "output_mom", "Updated momentum")
+    .Arg("decay", "Default 0.9")
+    .Arg("momentum", "Default 0.0")
+    .Arg("epsilon", "Default 1e-5");
+SHOULD_NOT_DO_GRADIENT(SparseRmsProp);
+
 }
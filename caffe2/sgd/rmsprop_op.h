@@ -76,4 +76,68 @@ class RmsPropOp final : public Operator<Context> {
   INPUT_TAGS(GRAD, MEAN_SQUARES, MOMENTUM, LR);
   OUTPUT_TAGS(OUTPUT_GRAD, OUTPUT_MEAN_SQUARES, OUTPUT_MOMENTUM);
 };
+
+// Sparse counterpart of RmsProp: the rows of param, mean_squares and mom given
+// by indices are updated in place with the rows of grad, and param is moved by
+// the new momentum, which RmsProp returns as the gradient.
+template <typename T, class Context>
+class SparseRmsPropOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  SparseRmsPropOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        decay_(OperatorBase::GetSingleArgument<float>("decay", 0.9f)),
+        momentum_(OperatorBase::GetSingleArgument<float>("momentum", 0.0f)),
+        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)) {}
+
+  bool RunOnDevice() override {
+    CAFFE_ENFORCE_EQ(Input(PARAM).size(), Input(MEAN_SQUARES).size());
+    CAFFE_ENFORCE_EQ(Input(PARAM).size(), Input(MOMENTUM).size());
+    CAFFE_ENFORCE_EQ(Input(LR).size(), 1);
+    CAFFE_ENFORCE_EQ(
+        Input(PARAM).size_from_dim(1),
+        Input(GRAD).size_from_dim(Input(INDICES).ndim()));
+    return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(
+        this, Input(INDICES));
+  }
+
+  template <typename SIndex>
+  bool DoRunWithType() {
+    const auto n = Input(INDICES).size();
+    if (n == 0) {
+      return true;
+    }
+    const auto block_size = Input(GRAD).size() / n;
+    const auto* indices = Input(INDICES).template data<SIndex>();
+    const auto* grad = Input(GRAD).template data<T>();
+    const T lr = Input(LR).template data<T>()[0];
+    auto* param = Output(OUTPUT_PARAM)->template mutable_data<T>();
+    auto* ms = Output(OUTPUT_MEAN_SQUARES)->template mutable_data<T>();
+    auto* mom = Output(OUTPUT_MOMENTUM)->template mutable_data<T>();
+    for (TIndex i = 0; i < n; ++i) {
+      const TIndex offset = indices[i] * block_size;
+      CAFFE_ENFORCE_LE(
+          offset + block_size,
+          Input(PARAM).size(),
+          "Index out of bounds: ",
+          indices[i]);
+      for (TIndex j = 0; j < block_size; ++j) {
+        const T g = grad[i * block_size + j];
+        T& ms_j = ms[offset + j];
+        T& mom_j = mom[offset + j];
+        ms_j += (1.0f - decay_) * (g * g - ms_j);
+        mom_j = mom_j * momentum_ + lr * g / std::sqrt(epsilon_ + ms_j);
+        param[offset + j] += mom_j;
+      }
+    }
+    return true;
+  }
+
+ protected:
+  T decay_{0.9};
+  T momentum_{0.0};
+  T epsilon_{1e-8};
+  INPUT_TAGS(PARAM, MEAN_SQUARES, MOMENTUM, INDICES, GRAD, LR);
+  OUTPUT_TAGS(OUTPUT_PARAM, OUTPUT_MEAN_SQUARES, OUTPUT_MOMENTUM);
+};
 }
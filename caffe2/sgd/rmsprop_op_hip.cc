@@ -17,6 +17,7 @@
 #include "rmsprop_op.h"
 #include "caffe2/core/common_hip.h"
 #include "caffe2/core/context_hip.h"
+#include "caffe2/sgd/sparse_sort_hip.h"
 #include "hip/hip_runtime.h"
 
 namespace caffe2 {
@@ -76,5 +77,122 @@ void rmsprop_update<HIPContext>(int N,
                        lr);
 }
 
+/**
+ * SparseRmsProp over sorted indices: the block that sees the first occurrence
+ * of a row applies all of its occurrences in order, see SparseAdagradKernel.
+ */
+template <typename SIndex>
+__global__ void SparseRmsPropKernel(const int num_indices,
+                                    const int grad_slice_sz,
+                                    const float decay,
+                                    const float momentum,
+                                    const float epsilon,
+                                    float* param,
+                                    float* mean_squares,
+                                    float* mom,
+                                    const SIndex* sorted_indices,
+                                    const int* sorted_positions,
+                                    const float* grad,
+                                    const float* lr)
+{
+    const float LR = lr[0];
+    for(int i = hipBlockIdx_x; i < num_indices; i += hipGridDim_x)
+    {
+        const SIndex index = sorted_indices[i];
+        if(i > 0 && sorted_indices[i - 1] == index)
+        {
+            continue;
+        }
+        for(int j = hipThreadIdx_x; j < grad_slice_sz; j += hipBlockDim_x)
+        {
+            const size_t paramIdx = static_cast<size_t>(index) * grad_slice_sz + j;
+            float ms              = mean_squares[paramIdx];
+            float m               = mom[paramIdx];
+            float w               = param[paramIdx];
+            for(int k = i; k < num_indices && sorted_indices[k] == index; ++k)
+            {
+                const float g = grad[static_cast<size_t>(sorted_positions[k]) * grad_slice_sz + j];
+                ms += (1.0f - decay) * (g * g - ms);
+                m = m * momentum + LR * g / sqrtf(epsilon + ms);
+                w += m;
+            }
+            mean_squares[paramIdx] = ms;
+            mom[paramIdx]          = m;
+            param[paramIdx]        = w;
+        }
+    }
+}
+
+class HIPSparseRmsPropOp final : public Operator<HIPContext>
+{
+    public:
+    USE_OPERATOR_FUNCTIONS(HIPContext);
+    HIPSparseRmsPropOp(const OperatorDef& operator_def, Workspace* ws)
+        : Operator<HIPContext>(operator_def, ws),
+          decay_(OperatorBase::GetSingleArgument<float>("decay", 0.9f)),
+          momentum_(OperatorBase::GetSingleArgument<float>("momentum", 0.0f)),
+          epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f))
+    {
+    }
+
+    bool RunOnDevice() override
+    {
+        CAFFE_ENFORCE_EQ(Input(PARAM).size(), Input(MEAN_SQUARES).size());
+        CAFFE_ENFORCE_EQ(Input(PARAM).size(), Input(MOMENTUM).size());
+        CAFFE_ENFORCE_EQ(Input(LR).size(), 1);
+        CAFFE_ENFORCE_EQ(Input(PARAM).size_from_dim(1),
+                         Input(GRAD).size_from_dim(Input(INDICES).ndim()));
+        return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(this, Input(INDICES));
+    }
+
+    template <typename SIndex>
+    bool DoRunWithType()
+    {
+        const auto n = Input(INDICES).size();
+        if(n == 0 || Input(GRAD).size() == 0)
+        {
+            return true;
+        }
+        const auto grad_slice_sz = Input(GRAD).size_from_dim(Input(INDICES).ndim());
+        SortIndicesWithPositions<SIndex>(n,
+                                         Input(INDICES).data<SIndex>(),
+                                         &sorted_indices_,
+                                         &sorted_positions_,
+                                         &positions_,
+                                         &sort_buffer_,
+                                         &context_);
+        hipLaunchKernelGGL((SparseRmsPropKernel<SIndex>),
+                           dim3(std::min<int>(n, CAFFE_MAXIMUM_NUM_BLOCKS)),
+                           dim3(SparseRowThreads(grad_slice_sz)),
+                           0,
+                           context_.hip_stream(),
+                           static_cast<const int>(n),
+                           static_cast<const int>(grad_slice_sz),
+                           decay_,
+                           momentum_,
+                           epsilon_,
+                           Output(OUTPUT_PARAM)->mutable_data<float>(),
+                           Output(OUTPUT_MEAN_SQUARES)->mutable_data<float>(),
+                           Output(OUTPUT_MOMENTUM)->mutable_data<float>(),
+                           sorted_indices_.data<SIndex>(),
+                           sorted_positions_.data<int>(),
+                           Input(GRAD).data<float>(),
+                           Input(LR).data<float>());
+        return true;
+    }
+
+    protected:
+    float decay_;
+    float momentum_;
+    float epsilon_;
+    Tensor<HIPContext> sorted_indices_;
+    Tensor<HIPContext> sorted_positions_;
+    Tensor<HIPContext> positions_;
+    Tensor<HIPContext> sort_buffer_;
+    INPUT_TAGS(PARAM, MEAN_SQUARES, MOMENTUM, INDICES, GRAD, LR);
+    OUTPUT_TAGS(OUTPUT_PARAM, OUTPUT_MEAN_SQUARES, OUTPUT_MOMENTUM);
+};
+
 REGISTER_HIP_OPERATOR(RmsProp, RmsPropOp<float, HIPContext>);
+REGISTER_HIP_OPERATOR(SparseRmsProp, HIPSparseRmsPropOp);
 }
@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <hipcub/hipcub.hpp>
+#include "caffe2/core/common_hip.h"
+#include "caffe2/core/context_hip.h"
+#include "hip/hip_runtime.h"
+
+namespace caffe2 {
+
+template <typename T>
+__global__ void FillPositionsKernel(const int N, T* positions)
+{
+    HIP_1D_KERNEL_LOOP(i, N) { positions[i] = i; }
+}
+
+/**
+ * Sorts indices together with their positions in the gradient. The radix sort
+ * is stable, so all occurrences of a row end up next to each other and in
+ * their original order, which lets a single block apply them one after the
+ * other, exactly like the CPU ops do, without any atomics. Used by the sparse
+ * optimizers (SparseAdagrad, SparseAdam, SparseRmsProp, SparseFtrl).
+ */
+template <typename SIndex>
+void SortIndicesWithPositions(const int n,
+                              const SIndex* indices,
+                              Tensor<HIPContext>* sorted_indices,
+                              Tensor<HIPContext>* sorted_positions,
+                              Tensor<HIPContext>* positions,
+                              Tensor<HIPContext>* scratch,
+                              HIPContext* context)
+{
+    sorted_indices->Resize(n);
+    sorted_positions->Resize(n);
+    positions->Resize(n);
+    hipLaunchKernelGGL((FillPositionsKernel<int>),
+                       dim3(CAFFE_GET_BLOCKS(n)),
+                       dim3(CAFFE_HIP_NUM_THREADS),
+                       0,
+                       context->hip_stream(),
+                       n,
+                       positions->template mutable_data<int>());
+
+    size_t temp_storage_bytes = 0;
+    hipcub::DeviceRadixSort::SortPairs(nullptr,
+                                       temp_storage_bytes,
+                                       indices,
+                                       sorted_indices->template mutable_data<SIndex>(),
+                                       positions->template data<int>(),
+                                       sorted_positions->template mutable_data<int>(),
+                                       n,
+                                       0,
+                                       sizeof(SIndex) * 8,
+                                       context->hip_stream());
+    scratch->Resize(temp_storage_bytes + 1);
+    hipcub::DeviceRadixSort::SortPairs(
+        static_cast<void*>(scratch->template mutable_data<uint8_t>()),
+        temp_storage_bytes,
+        indices,
+        sorted_indices->template mutable_data<SIndex>(),
+        positions->template data<int>(),
+        sorted_positions->template mutable_data<int>(),
+        n,
+        0,
+        sizeof(SIndex) * 8,
+        context->hip_stream());
+}
+
+/**
+ * Number of threads of the one block per row kernels of the sparse optimizers:
+ * the threads stride over a row, a wavefront multiple covering it if it fits.
+ */
+inline int SparseRowThreads(const TIndex row_size)
+{
+    return std::min<TIndex>(CAFFE_HIP_NUM_THREADS, (row_size + 63) / 64 * 64);
+}
+
+} // namespace caffe2
@@ -0,0 +1,231 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/transforms/constant_folding_transform.h"
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/tensor.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+
+using transform::Graph;
+using transform::Node;
+
+namespace {
+
+template <typename T, typename ArgT>
+void AddValues(const TensorCPU& tensor, OperatorDef* op) {
+  const T* data = tensor.data<T>();
+  std::vector<ArgT> values(data, data + tensor.size());
+  AddArgument("values", values, op);
+}
+
+// Creates the fill operator writing the value of the given blob, or returns
+// false if the type of the blob has no exact GivenTensor*Fill.
+bool MakeFillOp(const string& name, const Blob& blob, OperatorDef* op) {
+  if (!blob.IsType<TensorCPU>()) {
+    return false;
+  }
+  const auto& tensor = blob.Get<TensorCPU>();
+  if (tensor.IsType<float>()) {
+    op->set_type("GivenTensorFill");
+    AddValues<float, float>(tensor, op);
+  } else if (tensor.IsType<int>()) {
+    op->set_type("GivenTensorIntFill");
+    AddValues<int, int>(tensor, op);
+  } else if (tensor.IsType<int64_t>()) {
+    op->set_type("GivenTensorInt64Fill");
+    AddValues<int64_t, int64_t>(tensor, op);
+  } else if (tensor.IsType<bool>()) {
+    op->set_type("GivenTensorBoolFill");
+    AddValues<bool, int>(tensor, op);
+  } else if (tensor.IsType<std::string>()) {
+    op->set_type("GivenTensorStringFill");
+    AddValues<std::string, std::string>(tensor, op);
+  } else {
+    // Doubles would be rounded to the float values argument.
+    return false;
+  }
+  std::vector<int64_t> shape(tensor.dims().begin(), tensor.dims().end());
+  AddArgument("shape", shape, op);
+  op->add_output(name);
+  return true;
+}
+
+} // namespace
+
+bool ConstantFoldingTransform::IsFoldable(
+    const OperatorDef& op,
+    const NetDef& net) const {
+  if (!foldable_ops_.count(op.type()) || op.output_size() == 0) {
+    return false;
+  }
+  const auto& device = op.has_device_option() ? op.device_option()
+                                              : net.device_option();
+  return device.device_type() == CPU;
+}
+
+NetDef ConstantFoldingTransform::ApplyTo(const NetDef& orig_net) {
+  std::set<string> constants;
+  if (has_init_net_) {
+    for (const auto& op : init_net_.op()) {
+      constants.insert(op.output().begin(), op.output().end());
+    }
+  }
+  std::map<string, int> writers;
+  for (const auto& op : orig_net.op()) {
+    for (const auto& blob : op.output()) {
+      writers[blob]++;
+    }
+  }
+
+  Graph g(orig_net);
+  folded_init_net_ = init_net_;
+  // A node is folded if it is foldable and it reads only constant external
+  // inputs and the outputs of folded nodes. Parents come before their
+  // children, so one forward pass decides every node.
+  std::vector<bool> folded(g.size(), false);
+  std::vector<int> removed;
+  bool computes = false;
+  for (int i = 0; i < g.size(); i++) {
+    const auto& node = g.node(i);
+    if (!IsFoldable(node.op, orig_net)) {
+      continue;
+    }
+    bool is_folded = true;
+    for (const auto& blob : node.op.output()) {
+      if (writers.at(blob) != 1) {
+        is_folded = false;
+      }
+    }
+    std::set<string> parent_blobs;
+    for (const auto& edge : node.parents) {
+      if (!folded[edge.first]) {
+        is_folded = false;
+      }
+      parent_blobs.insert(edge.second.begin(), edge.second.end());
+    }
+    for (const auto& blob : node.op.input()) {
+      if (!parent_blobs.count(blob) && !constants.count(blob)) {
+        is_folded = false;
+      }
+    }
+    folded[i] = is_folded;
+    if (is_folded) {
+      removed.push_back(i);
+      computes |= node.op.input_size() > 0;
+    }
+  }
+  if (removed.empty()) {
+    return orig_net;
+  }
+
+  // Evaluate the folded nodes in net order.
+  Workspace ws;
+  if (computes) {
+    try {
+      if (has_init_net_) {
+        CAFFE_ENFORCE(ws.RunNetOnce(init_net_), "Failed to run the init net");
+      }
+      for (int i : removed) {
+        CAFFE_ENFORCE(
+            ws.RunOperatorOnce(g.node(i).op),
+            "Failed to run ",
+            g.node(i).op.type());
+      }
+    } catch (const std::exception& e) {
+      LOG(WARNING) << "Not folding constants of net " << orig_net.name()
+                   << ": " << e.what();
+      return orig_net;
+    }
+  }
+
+  // Every folded op leaves the net. Its outputs that are read by an unfolded
+  // node, or are outputs of the net, become external inputs written by the
+  // init net: fills without inputs are moved there as they are, the other
+  // ops are replaced by a fill of each of these outputs.
+  const std::set<string> external_outputs(
+      orig_net.external_output().begin(), orig_net.external_output().end());
+  std::vector<OperatorDef> fills;
+  std::vector<string> inputs;
+  for (int i : removed) {
+    const auto& node = g.node(i);
+    std::vector<string> needed;
+    for (const auto& blob : node.op.output()) {
+      bool is_read = false;
+      for (const auto& edge : node.children) {
+        if (!folded[edge.first] &&
+            std::find(edge.second.begin(), edge.second.end(), blob) !=
+                edge.second.end()) {
+          is_read = true;
+        }
+      }
+      // Without declared external outputs, any blob not read again in the
+      // net may be fetched afterwards.
+      const bool is_output = external_outputs.empty()
+          ? g.external_output().count(blob) > 0
+          : external_outputs.count(blob) > 0;
+      if (is_read || is_output) {
+        needed.push_back(blob);
+      }
+    }
+    if (needed.empty()) {
+      continue;
+    }
+    inputs.insert(inputs.end(), needed.begin(), needed.end());
+    if (node.op.input_size() == 0) {
+      fills.push_back(node.op);
+      continue;
+    }
+    for (const auto& blob : needed) {
+      OperatorDef fill;
+      if (!MakeFillOp(blob, *ws.GetBlob(blob), &fill)) {
+        LOG(WARNING) << "Not folding constants of net " << orig_net.name()
+                     << ": blob " << blob << " has no GivenTensorFill type";
+        folded_init_net_ = init_net_;
+        return orig_net;
+      }
+      if (node.op.has_device_option()) {
+        fill.mutable_device_option()->CopyFrom(node.op.device_option());
+      }
+      fills.push_back(fill);
+    }
+  }
+
+  VLOG(1) << "Folding " << removed.size() << " operators of net "
+          << orig_net.name() << " into " << fills.size()
+          << " fills of the init net";
+  for (const auto& fill : fills) {
+    *folded_init_net_.add_op() = fill;
+  }
+  g.DeactivateSubgraph(removed);
+  NetDef net = g.GetNetDef();
+  const std::set<string> external_inputs(
+      net.external_input().begin(), net.external_input().end());
+  for (const auto& blob : inputs) {
+    if (!external_inputs.count(blob)) {
+      net.add_external_input(blob);
+    }
+  }
+  return net;
+}
+
+REGISTER_TRANSFORM(ConstantFolding, ConstantFoldingTransform);
+
+} // namespace caffe2
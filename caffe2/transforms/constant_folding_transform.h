@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/transform.h"
+#include "caffe2/proto/caffe2.pb.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+/**
+ * Constant Folding
+ *
+ * Evaluates, once and on the CPU, the operators whose inputs are all
+ * constant, and moves their results out of the net: they become external
+ * inputs of the returned net, written by GivenTensor*Fill operators appended
+ * to init_net(). A blob is constant if it is written by a fill operator
+ * without inputs, by the init net the transform was created with, or by
+ * another folded operator. This turns e.g. GivenTensorFill -> Transpose -> FC
+ * into an FC reading the transposed weights from the init net.
+ *
+ * Only the deterministic CPU operators in foldable_ops_ are evaluated, and
+ * only if every blob they write has no other writer in the net, so that the
+ * folded value is the only version of the blob. Fill operators without inputs
+ * are moved to init_net() as they are. Only the constants read by the rest of
+ * the net, or that are outputs of the net, are kept.
+ *
+ * The returned net needs init_net() to be run first, so the transform should
+ * be used through a ConstantFoldingTransform object rather than by name.
+ */
+class ConstantFoldingTransform : public Transform {
+ public:
+  ConstantFoldingTransform() {}
+  // The blobs written by init_net are treated as constants, and init_net is
+  // run to provide their values when folding.
+  explicit ConstantFoldingTransform(const NetDef& init_net)
+      : init_net_(init_net), has_init_net_(true) {}
+
+  NetDef ApplyTo(const NetDef& orig_net_def) override;
+
+  // The init net given at construction followed by the fills of the
+  // constants folded by the last ApplyTo().
+  const NetDef& init_net() const {
+    return folded_init_net_;
+  }
+
+ private:
+  bool IsFoldable(const OperatorDef& op, const NetDef& net) const;
+
+  NetDef init_net_;
+  bool has_init_net_ = false;
+  NetDef folded_init_net_;
+  std::set<string> foldable_ops_ = {
+      "Add",
+      "Cast",
+      "Concat",
+      "ConstantFill",
+      "Div",
+      "ExpandDims",
+      "Flatten",
+      "FlattenToVec",
+      "GivenTensorBoolFill",
+      "GivenTensorFill",
+      "GivenTensorInt64Fill",
+      "GivenTensorIntFill",
+      "GivenTensorStringFill",
+      "Mul",
+      "NCHW2NHWC",
+      "NHWC2NCHW",
+      "Reshape",
+      "Scale",
+      "Shape",
+      "Slice",
+      "Split",
+      "Squeeze",
+      "Sub",
+      "Sum",
+      "Tile",
+      "Transpose"};
+};
+
+} // namespace caffe2
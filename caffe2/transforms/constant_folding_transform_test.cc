@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/transforms/constant_folding_transform.h"
+
+namespace caffe2 {
+
+namespace {
+
+OperatorDef* AddWeights(NetDef* netdef, const string& name) {
+  auto* op = AddOp(netdef, "GivenTensorFill", {}, {name});
+  AddArgument("shape", std::vector<int>{2, 3}, op);
+  AddArgument("values", std::vector<float>{1, 2, 3, 4, 5, 6}, op);
+  return op;
+}
+
+/**
+ *  Before: (GivenTensorFill)-->(Transpose)-->(Scale)-->(Relu)
+ *
+ *  After : (Relu), reading the external input w_s written by a
+ *          (GivenTensorFill) of the init net.
+ */
+TEST(ConstantFoldingTest, TestSimple) {
+  NetDef netdef;
+  AddWeights(&netdef, "w");
+  AddOp(&netdef, "Transpose", {"w"}, {"w_t"});
+  auto* scale = AddOp(&netdef, "Scale", {"w_t"}, {"w_s"});
+  AddArgument("scale", 2.0f, scale);
+  AddOp(&netdef, "Relu", {"w_s"}, {"out"});
+  netdef.add_external_output("out");
+
+  ConstantFoldingTransform t;
+  NetDef folded = t.ApplyTo(netdef);
+  EXPECT_EQ(folded.op_size(), 1);
+  EXPECT_EQ(folded.op(0).type(), "Relu");
+  EXPECT_EQ(folded.external_input_size(), 1);
+  EXPECT_EQ(folded.external_input(0), "w_s");
+  const NetDef& init_net = t.init_net();
+  EXPECT_EQ(init_net.op_size(), 1);
+  EXPECT_EQ(init_net.op(0).type(), "GivenTensorFill");
+  EXPECT_EQ(init_net.op(0).output(0), "w_s");
+
+  Workspace ws;
+  EXPECT_TRUE(ws.RunNetOnce(init_net));
+  EXPECT_TRUE(ws.RunNetOnce(folded));
+  const auto& out = ws.GetBlob("out")->Get<TensorCPU>();
+  EXPECT_EQ(out.dims(), (std::vector<TIndex>{3, 2}));
+  const std::vector<float> expected{2, 8, 4, 10, 6, 12};
+  for (int i = 0; i < expected.size(); ++i) {
+    EXPECT_FLOAT_EQ(out.data<float>()[i], expected[i]);
+  }
+}
+
+/**
+ * Fills without inputs move to the init net as they are, and are dropped
+ * when nothing but folded ops reads them.
+ */
+TEST(ConstantFoldingTest, TestMoveFills) {
+  NetDef netdef;
+  AddWeights(&netdef, "w");
+  AddWeights(&netdef, "b");
+  AddOp(&netdef, "Transpose", {"w"}, {"w_t"});
+  AddOp(&netdef, "FC", {"in", "w_t", "b"}, {"out"});
+  netdef.add_external_output("out");
+
+  ConstantFoldingTransform t;
+  NetDef folded = t.ApplyTo(netdef);
+  EXPECT_EQ(folded.op_size(), 1);
+  EXPECT_EQ(folded.op(0).type(), "FC");
+  const NetDef& init_net = t.init_net();
+  EXPECT_EQ(init_net.op_size(), 2);
+  EXPECT_EQ(init_net.op(0).output(0), "b");
+  EXPECT_EQ(init_net.op(1).output(0), "w_t");
+}
+
+/**
+ * Ops reading a non-constant input, and ops on blobs with several writers,
+ * are left alone. Blobs of the init net count as constants.
+ */
+TEST(ConstantFoldingTest, TestInitNet) {
+  NetDef init_netdef;
+  AddWeights(&init_netdef, "w");
+
+  NetDef netdef;
+  AddOp(&netdef, "Transpose", {"w"}, {"w_t"});
+  AddOp(&netdef, "FC", {"in", "w_t", "b"}, {"out"});
+  AddOp(&netdef, "Shape", {"in"}, {"in_shape"});
+  netdef.add_external_output("out");
+  netdef.add_external_output("in_shape");
+
+  // Without the init net, w isn't known to be constant.
+  auto t = TransformRegistry()->Create("ConstantFolding");
+  CHECK(t);
+  EXPECT_EQ(t->ApplyTo(netdef).op(0).type(), "Transpose");
+
+  ConstantFoldingTransform with_init(init_netdef);
+  NetDef folded = with_init.ApplyTo(netdef);
+  EXPECT_EQ(folded.op_size(), 2);
+  EXPECT_EQ(folded.op(0).type(), "Shape");
+  EXPECT_EQ(folded.op(1).type(), "FC");
+  // The init net keeps its own ops, followed by the folded constants.
+  EXPECT_EQ(with_init.init_net().op_size(), 2);
+  EXPECT_EQ(with_init.init_net().op(0).output(0), "w");
+  EXPECT_EQ(with_init.init_net().op(1).output(0), "w_t");
+
+  AddOp(&netdef, "Relu", {"w_t"}, {"w_t"});
+  EXPECT_EQ(with_init.ApplyTo(netdef).op(0).type(), "Transpose");
+}
+
+} // namespace
+
+} // namespace caffe2
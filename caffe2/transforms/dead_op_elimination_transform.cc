@@ -0,0 +1,70 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/transforms/dead_op_elimination_transform.h"
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+
+using transform::Graph;
+
+NetDef DeadOpEliminationTransform::ApplyTo(const NetDef& orig_net) {
+  if (orig_net.external_output_size() == 0) {
+    return orig_net;
+  }
+  const std::set<string> external_inputs(
+      orig_net.external_input().begin(), orig_net.external_input().end());
+  const std::set<string> external_outputs(
+      orig_net.external_output().begin(), orig_net.external_output().end());
+
+  Graph g(orig_net);
+  // The children of a node always come after it in the net, so a single
+  // backward pass sees every child before its parents.
+  std::vector<bool> live(g.size(), false);
+  std::vector<int> dead;
+  for (int i = g.size() - 1; i >= 0; i--) {
+    const auto& node = g.node(i);
+    bool is_live = node.op.output_size() == 0;
+    for (const auto& blob : node.op.output()) {
+      if (external_outputs.count(blob) || external_inputs.count(blob)) {
+        is_live = true;
+      }
+    }
+    for (const auto& edge : node.children) {
+      if (live[edge.first]) {
+        is_live = true;
+      }
+    }
+    live[i] = is_live;
+    if (!is_live) {
+      dead.push_back(i);
+    }
+  }
+  if (dead.empty()) {
+    return orig_net;
+  }
+  VLOG(1) << "Removing " << dead.size() << " dead operators from net "
+          << orig_net.name();
+  g.DeactivateSubgraph(dead);
+  return g.GetNetDef();
+}
+
+REGISTER_TRANSFORM(DeadOpElimination, DeadOpEliminationTransform);
+
+} // namespace caffe2
@@ -0,0 +1,43 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/transform.h"
+#include "caffe2/proto/caffe2.pb.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+/**
+ * Dead Op Elimination
+ *
+ * Removes the operators none of whose outputs is needed to compute the
+ * external outputs of the net. An operator is kept if it writes an external
+ * output, if it writes one of the net's external inputs (it updates state
+ * that outlives the run), if it has no outputs at all (Print, Save, ...), or
+ * if one of its children in the graph is kept.
+ *
+ * A net without declared external outputs is returned unchanged, since
+ * nothing tells which of its results are consumed.
+ */
+class DeadOpEliminationTransform : public Transform {
+ public:
+  NetDef ApplyTo(const NetDef& orig_net_def) override;
+};
+
+} // namespace caffe2
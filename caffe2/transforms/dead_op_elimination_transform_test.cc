@@ -0,0 +1,79 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/transforms/dead_op_elimination_transform.h"
+
+namespace caffe2 {
+
+namespace {
+
+/**
+ *                 /-->(Relu)-->out
+ *  Before: (FC)-->
+ *                 \-->(Relu)-->(Sigmoid)
+ *
+ *  After : (FC)-->(Relu)-->out
+ */
+TEST(DeadOpEliminationTest, TestSimple) {
+  NetDef netdef;
+  AddOp(&netdef, "FC", {"in", "w", "b"}, {"mid"});
+  AddOp(&netdef, "Relu", {"mid"}, {"out"});
+  AddOp(&netdef, "Relu", {"mid"}, {"unused1"});
+  AddOp(&netdef, "Sigmoid", {"unused1"}, {"unused2"});
+  AddOp(&netdef, "Print", {"mid"}, {});
+  netdef.add_external_output("out");
+
+  auto t = TransformRegistry()->Create("DeadOpElimination");
+  CHECK(t);
+  NetDef transformed_netdef = t->ApplyTo(netdef);
+
+  EXPECT_EQ(transformed_netdef.op_size(), 3);
+  EXPECT_EQ(transformed_netdef.op(0).type(), "FC");
+  EXPECT_EQ(transformed_netdef.op(1).type(), "Relu");
+  EXPECT_EQ(transformed_netdef.op(1).output(0), "out");
+  // Ops without outputs are kept for their side effects.
+  EXPECT_EQ(transformed_netdef.op(2).type(), "Print");
+}
+
+/**
+ * Ops updating an external input are kept, as are all ops of a net that
+ * doesn't declare its external outputs.
+ */
+TEST(DeadOpEliminationTest, TestKeepsState) {
+  NetDef netdef;
+  AddOp(&netdef, "Relu", {"in"}, {"out"});
+  AddOp(&netdef, "Sigmoid", {"in"}, {"unused"});
+  AddOp(&netdef, "Scale", {"iter"}, {"iter"});
+
+  auto t = TransformRegistry()->Create("DeadOpElimination");
+  CHECK(t);
+  EXPECT_EQ(t->ApplyTo(netdef).op_size(), 3);
+
+  netdef.add_external_input("in");
+  netdef.add_external_input("iter");
+  netdef.add_external_output("out");
+  NetDef transformed_netdef = t->ApplyTo(netdef);
+  EXPECT_EQ(transformed_netdef.op_size(), 2);
+  EXPECT_EQ(transformed_netdef.op(0).type(), "Relu");
+  EXPECT_EQ(transformed_netdef.op(1).type(), "Scale");
+}
+
+} // namespace
+
+} // namespace caffe2
@@ -0,0 +1,165 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/transforms/fuse_bn_add_relu_transform.h"
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/net.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+
+using transform::Graph;
+
+namespace {
+
+void SetHIPDevice(NetDef* net) {
+  for (auto& op : *net->mutable_op()) {
+    op.mutable_device_option()->set_device_type(HIP);
+  }
+}
+
+NetDef BNAddReluPatternNet() {
+  NetDef net;
+  AddOp(
+      &net,
+      "SpatialBN",
+      {"X", "scale", "bias", "mean", "var"},
+      {"Y", "mean", "var", "saved_mean", "saved_inv_var"});
+  AddOp(&net, "Sum", {"Y", "Z"}, {"S"});
+  AddOp(&net, "Relu", {"S"}, {"R"});
+  SetHIPDevice(&net);
+  return net;
+}
+
+NetDef BNAddReluReplaceNet() {
+  NetDef net;
+  AddOp(
+      &net,
+      "SpatialBNAddRelu",
+      {"X", "scale", "bias", "mean", "var", "Z"},
+      {"R", "mean", "var", "saved_mean", "saved_inv_var"});
+  SetHIPDevice(&net);
+  return net;
+}
+
+int find_op(
+    const Graph& g,
+    const std::vector<int>& subgraph,
+    const string& type) {
+  for (const int idx : subgraph) {
+    if (g.node(idx).op.type() == type) {
+      return idx;
+    }
+  }
+  CAFFE_THROW("No ", type, " in the matched subgraph");
+}
+
+// The output of the node at idx is only read by the node at reader_idx.
+bool is_only_reader(const Graph& g, int idx, int reader_idx) {
+  const string& output = g.node(idx).op.output(0);
+  for (const auto& child : g.node(idx).children) {
+    if (child.first != reader_idx &&
+        std::find(child.second.begin(), child.second.end(), output) !=
+            child.second.end()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+FuseBNAddReluTransform::FuseBNAddReluTransform()
+    : PatternNetTransform(BNAddReluPatternNet(), BNAddReluReplaceNet()) {}
+
+bool FuseBNAddReluTransform::ValidatorRule(
+    const Graph& g,
+    const std::vector<int>& subgraph) {
+  if (!PatternNetTransform::ValidatorRule(g, subgraph)) {
+    return false;
+  }
+  const int bn_idx = find_op(g, subgraph, "SpatialBN");
+  const int sum_idx = find_op(g, subgraph, "Sum");
+  const int relu_idx = find_op(g, subgraph, "Relu");
+  const OperatorDef& bn = g.node(bn_idx).op;
+  const OperatorDef& sum = g.node(sum_idx).op;
+  const OperatorDef& relu = g.node(relu_idx).op;
+
+  if (ArgumentHelper::GetSingleArgument<OperatorDef, int>(
+          bn, OpSchema::Arg_IsTest, 0) ||
+      ArgumentHelper::GetSingleArgument<OperatorDef, string>(
+          bn, "order", "NCHW") != "NCHW" ||
+      !IsSameDevice(bn.device_option(), sum.device_option()) ||
+      !IsSameDevice(bn.device_option(), relu.device_option())) {
+    return false;
+  }
+
+  // Exactly one of the Sum inputs is the SpatialBN output, and the other one
+  // is the residual, which the fused op cannot overwrite.
+  if (sum.input(0) == sum.input(1)) {
+    return false;
+  }
+  const string& residual =
+      sum.input(0) == bn.output(0) ? sum.input(1) : sum.input(0);
+  if (relu.output(0) == residual) {
+    return false;
+  }
+
+  if (!is_only_reader(g, bn_idx, sum_idx) ||
+      !is_only_reader(g, sum_idx, relu_idx)) {
+    return false;
+  }
+  for (const auto& blob : {bn.output(0), sum.output(0)}) {
+    if (blob != relu.output(0) && g.external_output().count(blob)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool FuseBNAddReluTransform::ReplaceRule(
+    const std::vector<int>& subgraph,
+    Graph* g_ptr) {
+  CHECK(g_ptr);
+  auto& g = *g_ptr;
+
+  // The pattern matches blobs by position, so the SpatialBN output must be
+  // the first input of the Sum, like in the pattern net.
+  const int bn_idx = find_op(g, subgraph, "SpatialBN");
+  OperatorDef& sum = g.node(find_op(g, subgraph, "Sum")).op;
+  const OperatorDef bn = g.node(bn_idx).op;
+  if (sum.input(1) == bn.output(0)) {
+    const string residual = sum.input(0);
+    sum.set_input(0, sum.input(1));
+    sum.set_input(1, residual);
+  }
+
+  if (!PatternNetTransform::ReplaceRule(subgraph, g_ptr)) {
+    return false;
+  }
+
+  // The replacement op keeps the arguments and the device of the SpatialBN.
+  OperatorDef& fused = g.node(g.size() - 1).op;
+  fused.set_name(bn.name());
+  fused.mutable_arg()->CopyFrom(bn.arg());
+  fused.mutable_device_option()->CopyFrom(bn.device_option());
+  return true;
+}
+
+REGISTER_TRANSFORM(FuseBNAddRelu, FuseBNAddReluTransform);
+
+} // namespace caffe2
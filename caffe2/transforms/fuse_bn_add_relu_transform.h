@@ -0,0 +1,54 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/transform.h"
+#include "caffe2/proto/caffe2.pb.h"
+#include "caffe2/transforms/pattern_net_transform.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+/**
+ * SpatialBN + Sum + Relu Fusion
+ *
+ * Looks for the end of a residual block on HIP, a training-mode SpatialBN
+ * whose output is summed with a residual and passed through a Relu, and
+ * replaces it with a single SpatialBNAddRelu op. The fused op writes the
+ * activation once instead of three times, and its gradient reads and writes
+ * one activation-sized tensor less than the three separate gradients.
+ *
+ * The SpatialBN and the Sum outputs must only be read by the next op of
+ * the chain, and must not be external outputs unless the Relu overwrites
+ * them. Apply it to the forward net before adding the gradient operators,
+ * so that the fused gradient is used; a net whose gradients have already
+ * been added stays correct, but keeps the separate gradients.
+ */
+class FuseBNAddReluTransform : public PatternNetTransform {
+ public:
+  FuseBNAddReluTransform();
+
+ protected:
+  bool ValidatorRule(
+      const transform::Graph& g,
+      const std::vector<int>& subgraph) override;
+  bool ReplaceRule(const std::vector<int>& subgraph, transform::Graph* g_ptr)
+      override;
+};
+
+} // namespace caffe2
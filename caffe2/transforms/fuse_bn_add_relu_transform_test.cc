@@ -0,0 +1,101 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/transforms/fuse_bn_add_relu_transform.h"
+
+namespace caffe2 {
+
+namespace {
+
+/**
+ * (SpatialBN)-bn->(Sum)-sum->(Relu)-sum->(FC), with the shortcut summed in
+ * first, like in the ResNet builder.
+ */
+NetDef ResidualNet(int is_test) {
+  NetDef netdef;
+  auto* bn = AddOp(
+      &netdef,
+      "SpatialBN",
+      {"X", "scale", "bias", "mean", "var"},
+      is_test ? std::vector<string>{"bn"}
+              : std::vector<string>{
+                    "bn", "mean", "var", "saved_mean", "saved_inv_var"});
+  AddArgument(OpSchema::Arg_IsTest, is_test, bn);
+  AddArgument("epsilon", 1e-3f, bn);
+  AddOp(&netdef, "Sum", {"shortcut", "bn"}, {"sum"});
+  AddOp(&netdef, "Relu", {"sum"}, {"sum"});
+  AddOp(&netdef, "FC", {"sum", "w", "b"}, {"out"});
+  for (auto& op : *netdef.mutable_op()) {
+    op.mutable_device_option()->set_device_type(HIP);
+  }
+  return netdef;
+}
+
+TEST(FuseBNAddReluTest, TestFuse) {
+  NetDef netdef = ResidualNet(0);
+
+  auto t = TransformRegistry()->Create("FuseBNAddRelu");
+  CHECK(t);
+  NetDef transformed_netdef = t->ApplyTo(netdef);
+
+  EXPECT_EQ(transformed_netdef.op_size(), 2);
+  const auto& fused = transformed_netdef.op(0);
+  EXPECT_EQ(fused.type(), "SpatialBNAddRelu");
+  const std::vector<string> inputs{
+      "X", "scale", "bias", "mean", "var", "shortcut"};
+  const std::vector<string> outputs{
+      "sum", "mean", "var", "saved_mean", "saved_inv_var"};
+  EXPECT_EQ(
+      std::vector<string>(fused.input().begin(), fused.input().end()), inputs);
+  EXPECT_EQ(
+      std::vector<string>(fused.output().begin(), fused.output().end()),
+      outputs);
+  EXPECT_EQ(fused.device_option().device_type(), HIP);
+  const float epsilon = ArgumentHelper::GetSingleArgument<OperatorDef, float>(
+      fused, "epsilon", 0);
+  EXPECT_FLOAT_EQ(epsilon, 1e-3f);
+  EXPECT_EQ(transformed_netdef.op(1).type(), "FC");
+  EXPECT_EQ(transformed_netdef.op(1).input(0), "sum");
+}
+
+TEST(FuseBNAddReluTest, TestNoFuse) {
+  auto t = TransformRegistry()->Create("FuseBNAddRelu");
+  CHECK(t);
+
+  // Inference-mode SpatialBN.
+  EXPECT_EQ(t->ApplyTo(ResidualNet(1)).op_size(), 4);
+
+  // The SpatialBN output is read by another op.
+  NetDef netdef = ResidualNet(0);
+  AddOp(&netdef, "Relu", {"bn"}, {"bn_relu"})
+      ->mutable_device_option()
+      ->set_device_type(HIP);
+  EXPECT_EQ(t->ApplyTo(netdef).op_size(), 5);
+
+  // The ops do not run on HIP.
+  netdef = ResidualNet(0);
+  for (auto& op : *netdef.mutable_op()) {
+    op.clear_device_option();
+  }
+  EXPECT_EQ(t->ApplyTo(netdef).op_size(), 4);
+}
+
+} // namespace
+
+} // namespace caffe2
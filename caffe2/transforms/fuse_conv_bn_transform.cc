@@ -0,0 +1,199 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/transforms/fuse_conv_bn_transform.h"
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/net.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+
+using transform::Graph;
+using transform::Node;
+
+namespace {
+
+// The node at idx must be the only reader of the single output of the node
+// at parent_idx, and read it as its first input.
+bool is_only_reader(const Graph& g, int parent_idx, int idx) {
+  const Node& parent = g.node(parent_idx);
+  const OperatorDef& op = g.node(idx).op;
+  return parent.op.output_size() == 1 && parent.children.size() == 1 &&
+      parent.children.count(idx) && op.input_size() > 0 &&
+      op.input(0) == parent.op.output(0) &&
+      !g.external_output().count(parent.op.output(0));
+}
+
+string get_order(const OperatorDef& op) {
+  return ArgumentHelper::GetSingleArgument<OperatorDef, string>(
+      op, "order", "NCHW");
+}
+
+// Adds an edge for every blob of op's inputs that is written by one of the
+// given producers.
+void add_parent_edges(
+    const OperatorDef& op,
+    const std::map<string, int>& producers,
+    std::map<int, std::vector<string>>* parents) {
+  for (const auto& blob : op.input()) {
+    auto it = producers.find(blob);
+    if (it != producers.end()) {
+      (*parents)[it->second].push_back(blob);
+    }
+  }
+}
+
+} // namespace
+
+bool FuseConvBNTransform::PatternRule(
+    const Graph& g,
+    const std::vector<int>& subgraph,
+    int idx) {
+  const OperatorDef& op = g.node(idx).op;
+  if (subgraph.size() == 0) {
+    const auto device_type = op.device_option().device_type();
+    return op.type() == "Conv" && op.engine() != "NNPACK" &&
+        (op.input_size() == 2 || op.input_size() == 3) &&
+        op.output_size() == 1 && (device_type == CPU || device_type == HIP);
+  }
+  const OperatorDef& prev = g.node(subgraph.back()).op;
+  if (!is_only_reader(g, subgraph.back(), idx) ||
+      !IsSameDevice(prev.device_option(), op.device_option())) {
+    return false;
+  }
+  if (subgraph.size() == 1) {
+    return op.type() == "SpatialBN" && op.input_size() == 5 &&
+        op.output_size() == 1 &&
+        ArgumentHelper::GetSingleArgument<OperatorDef, int>(
+            op, OpSchema::Arg_IsTest, 0) &&
+        get_order(op) == get_order(prev);
+  }
+  if (subgraph.size() == 2) {
+    return op.type() == "Relu" && op.input_size() == 1 &&
+        op.output_size() == 1;
+  }
+  return false;
+}
+
+// A Conv followed by a SpatialBN is enough, the Relu is optional.
+bool FuseConvBNTransform::ValidatorRule(
+    const Graph& g,
+    const std::vector<int>& subgraph) {
+  return subgraph.size() >= 2;
+}
+
+bool FuseConvBNTransform::ReplaceRule(
+    const std::vector<int>& subgraph,
+    Graph* g_ptr) {
+  CHECK(g_ptr);
+  auto& g = *g_ptr;
+
+  const int conv_idx = subgraph[0];
+  const int bn_idx = subgraph[1];
+  const int last_idx = subgraph.back();
+  const OperatorDef conv = g.node(conv_idx).op;
+  const OperatorDef bn = g.node(bn_idx).op;
+  const string output = g.node(last_idx).op.output(0);
+
+  // Remember where the blobs read by the subgraph come from, and who reads
+  // its output, before its edges are removed.
+  std::map<string, int> producers;
+  for (const int x : subgraph) {
+    for (const auto& parent : g.node(x).parents) {
+      if (std::find(subgraph.begin(), subgraph.end(), parent.first) ==
+          subgraph.end()) {
+        for (const auto& blob : parent.second) {
+          producers[blob] = parent.first;
+        }
+      }
+    }
+  }
+  const auto children = g.node(last_idx).children;
+  g.DeactivateSubgraph(subgraph);
+
+  // Fold the SpatialBN into the Conv parameters.
+  const int fold_idx = g.size();
+  OperatorDef fold_op;
+  fold_op.set_type("FoldConvBN");
+  fold_op.set_name(bn.name());
+  fold_op.mutable_device_option()->CopyFrom(conv.device_option());
+  for (int i = 1; i < conv.input_size(); i++) {
+    fold_op.add_input(conv.input(i));
+  }
+  for (int i = 1; i < bn.input_size(); i++) {
+    fold_op.add_input(bn.input(i));
+  }
+  fold_op.add_output("transform/" + output + "_folded_filter");
+  fold_op.add_output("transform/" + output + "_folded_bias");
+  if (ArgumentHelper::HasArgument(bn, "epsilon")) {
+    fold_op.add_arg()->CopyFrom(GetArgument(bn, "epsilon"));
+  }
+  std::map<int, std::vector<string>> fold_parents;
+  add_parent_edges(fold_op, producers, &fold_parents);
+  for (const auto& parent : fold_parents) {
+    g.node(parent.first).children[fold_idx] = parent.second;
+  }
+  g.push_node(Node(
+      fold_op, true, fold_parents, std::map<int, std::vector<string>>()));
+
+  // The Conv reads the folded parameters and writes the final output.
+  const int new_conv_idx = g.size();
+  OperatorDef new_conv = conv;
+  new_conv.clear_input();
+  new_conv.add_input(conv.input(0));
+  new_conv.add_input(fold_op.output(0));
+  new_conv.add_input(fold_op.output(1));
+  new_conv.set_output(0, output);
+  new_conv.clear_arg();
+  for (const auto& arg : conv.arg()) {
+    if (arg.name() != "no_bias") {
+      new_conv.add_arg()->CopyFrom(arg);
+    }
+  }
+  std::map<int, std::vector<string>> conv_parents;
+  add_parent_edges(new_conv, producers, &conv_parents);
+  for (const auto& parent : conv_parents) {
+    g.node(parent.first).children[new_conv_idx] = parent.second;
+  }
+  conv_parents[fold_idx] = {fold_op.output(0), fold_op.output(1)};
+  g.node(fold_idx).children[new_conv_idx] = conv_parents[fold_idx];
+  g.push_node(Node(
+      new_conv, true, conv_parents, std::map<int, std::vector<string>>()));
+
+  // The Relu, if any, runs in place on the Conv output.
+  int new_last_idx = new_conv_idx;
+  if (subgraph.size() == 3) {
+    new_last_idx = g.size();
+    OperatorDef relu = g.node(last_idx).op;
+    relu.set_input(0, output);
+    std::map<int, std::vector<string>> relu_parents;
+    relu_parents[new_conv_idx] = {output};
+    g.node(new_conv_idx).children[new_last_idx] = {output};
+    g.push_node(Node(
+        relu, true, relu_parents, std::map<int, std::vector<string>>()));
+  }
+
+  for (const auto& child : children) {
+    g.node(new_last_idx).children[child.first] = child.second;
+    g.node(child.first).parents[new_last_idx] = child.second;
+  }
+  return true;
+}
+
+REGISTER_TRANSFORM(FuseConvBN, FuseConvBNTransform);
+
+} // namespace caffe2
@@ -0,0 +1,53 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/transform.h"
+#include "caffe2/proto/caffe2.pb.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+/**
+ * Conv + SpatialBN (+ Relu) Fusion
+ *
+ * Looks for a Conv whose only reader is an inference-mode SpatialBN,
+ * optionally followed by a Relu that is the only reader of the SpatialBN.
+ * The SpatialBN is folded into the filter and bias of the Conv by a
+ * FoldConvBN op, and the Relu is made to run in place on the Conv output,
+ * so the activation is written once and never re-read for the
+ * normalization.
+ *
+ * The Conv and the SpatialBN must run on the same CPU or HIP device and use
+ * the same storage order, and neither the Conv nor the SpatialBN output may
+ * be an external output, since it no longer exists after the fusion.
+ */
+class FuseConvBNTransform : public Transform {
+ protected:
+  bool PatternRule(
+      const transform::Graph& g,
+      const std::vector<int>& subgraph,
+      int idx) override;
+  bool ValidatorRule(
+      const transform::Graph& g,
+      const std::vector<int>& subgraph) override;
+  bool ReplaceRule(const std::vector<int>& subgraph, transform::Graph* g_ptr)
+      override;
+};
+
+} // namespace caffe2
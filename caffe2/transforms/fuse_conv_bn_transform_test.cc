@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/transforms/fuse_conv_bn_transform.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+using transform::Graph;
+
+void AddConvBN(NetDef* netdef, bool relu) {
+  OperatorDef* op;
+  op = AddOp(netdef, "Conv", {"X", "W", "b"}, {"conv"});
+  auto* arg = op->add_arg();
+  arg->set_name("kernel");
+  arg->set_i(3);
+  op = AddOp(netdef, "SpatialBN", {"conv", "s", "o", "m", "v"}, {"bn"});
+  arg = op->add_arg();
+  arg->set_name(OpSchema::Arg_IsTest);
+  arg->set_i(1);
+  if (relu) {
+    op = AddOp(netdef, "Relu", {"bn"}, {"Y"});
+  }
+}
+
+void FillRandom(Workspace* ws, const string& name, std::vector<TIndex> dims) {
+  CPUContext context;
+  auto* tensor = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  tensor->Resize(dims);
+  math::RandUniform<float, CPUContext>(
+      tensor->size(), 0.1f, 1.0f, tensor->mutable_data<float>(), &context);
+}
+
+TEST(FuseConvBNTest, TestPattern) {
+  NetDef netdef;
+  AddConvBN(&netdef, true);
+  AddOp(&netdef, "Conv", {"Y", "W2"}, {"conv2"});
+  // Not in test mode, so it won't be fused.
+  AddOp(&netdef, "SpatialBN", {"conv2", "s", "o", "m", "v"}, {"bn2"});
+
+  auto t = TransformRegistry()->Create("FuseConvBN");
+  EXPECT_EQ(t->PatternMatch(Graph(netdef)).size(), 1);
+  NetDef transformed_netdef = t->ApplyTo(netdef);
+
+  ASSERT_EQ(transformed_netdef.op_size(), 5);
+  EXPECT_EQ(transformed_netdef.op(0).type(), "FoldConvBN");
+  EXPECT_EQ(transformed_netdef.op(0).input_size(), 6);
+  const auto& conv = transformed_netdef.op(1);
+  EXPECT_EQ(conv.type(), "Conv");
+  EXPECT_EQ(conv.input(0), "X");
+  EXPECT_EQ(conv.input(1), transformed_netdef.op(0).output(0));
+  EXPECT_EQ(conv.input(2), transformed_netdef.op(0).output(1));
+  EXPECT_EQ(conv.output(0), "Y");
+  const auto& relu = transformed_netdef.op(2);
+  EXPECT_EQ(relu.type(), "Relu");
+  EXPECT_EQ(relu.input(0), "Y");
+  EXPECT_EQ(relu.output(0), "Y");
+  EXPECT_EQ(transformed_netdef.op(3).type(), "Conv");
+  EXPECT_EQ(transformed_netdef.op(4).type(), "SpatialBN");
+}
+
+TEST(FuseConvBNTest, TestSharedOutputNotFused) {
+  NetDef netdef;
+  AddConvBN(&netdef, false);
+  // The Conv output is read by another op, so it has to stay.
+  AddOp(&netdef, "Relu", {"conv"}, {"Z"});
+
+  auto t = TransformRegistry()->Create("FuseConvBN");
+  EXPECT_EQ(t->PatternMatch(Graph(netdef)).size(), 0);
+}
+
+TEST(FuseConvBNTest, TestNumerics) {
+  for (const bool relu : {false, true}) {
+    NetDef netdef;
+    netdef.set_name("conv_bn");
+    AddConvBN(&netdef, relu);
+    const string output = relu ? "Y" : "bn";
+    // Read the output so that it is not the final blob of the net and make
+    // sure the rest of the graph is rewired correctly.
+    AddOp(&netdef, "Copy", {output}, {"out"});
+
+    auto t = TransformRegistry()->Create("FuseConvBN");
+    NetDef transformed_netdef = t->ApplyTo(netdef);
+    EXPECT_EQ(transformed_netdef.op_size(), relu ? 4 : 3);
+
+    Workspace ws;
+    FillRandom(&ws, "X", {2, 4, 7, 7});
+    FillRandom(&ws, "W", {5, 4, 3, 3});
+    FillRandom(&ws, "b", {5});
+    FillRandom(&ws, "s", {5});
+    FillRandom(&ws, "o", {5});
+    FillRandom(&ws, "m", {5});
+    FillRandom(&ws, "v", {5});
+
+    ASSERT_TRUE(ws.RunNetOnce(netdef));
+    TensorCPU expected(ws.GetBlob("out")->Get<TensorCPU>());
+    ws.GetBlob("out")->Reset();
+    ASSERT_TRUE(ws.RunNetOnce(transformed_netdef));
+    const auto& actual = ws.GetBlob("out")->Get<TensorCPU>();
+
+    ASSERT_EQ(actual.dims(), expected.dims());
+    for (int i = 0; i < actual.size(); i++) {
+      EXPECT_NEAR(actual.data<float>()[i], expected.data<float>()[i], 1e-4);
+    }
+  }
+}
+
+} // namespace
+
+} // namespace caffe2
@@ -0,0 +1,183 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/transforms/fuse_elementwise_transform.h"
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/net.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+
+using transform::Graph;
+using transform::Node;
+
+namespace {
+
+// Returns the expression computing op from the expressions of its inputs,
+// or an empty string if op cannot be fused.
+string pointwise_expression(
+    const OperatorDef& op,
+    const std::vector<string>& in) {
+  const string& type = op.type();
+  if (in.size() == 1) {
+    const string& x = in[0];
+    if (type == "Relu") {
+      return "fmaxf(" + x + ", 0.f)";
+    } else if (type == "Sigmoid") {
+      return "1.f / (1.f + expf(-" + x + "))";
+    } else if (type == "Tanh") {
+      return "tanhf(" + x + ")";
+    } else if (type == "Exp") {
+      return "expf(" + x + ")";
+    } else if (type == "Log") {
+      return "logf(" + x + ")";
+    } else if (type == "Abs") {
+      return "fabsf(" + x + ")";
+    } else if (type == "Sqr") {
+      return x + " * " + x;
+    } else if (type == "Sqrt") {
+      return "sqrtf(" + x + ")";
+    } else if (type == "Negative") {
+      return "-" + x;
+    }
+  } else if (in.size() == 2) {
+    if (ArgumentHelper::GetSingleArgument<OperatorDef, int>(
+            op, "broadcast", 0)) {
+      return "";
+    }
+    if (type == "Add") {
+      return in[0] + " + " + in[1];
+    } else if (type == "Sub") {
+      return in[0] + " - " + in[1];
+    } else if (type == "Mul") {
+      return in[0] + " * " + in[1];
+    } else if (type == "Div") {
+      return in[0] + " / " + in[1];
+    }
+  }
+  if (type == "Sum" && in.size() > 0) {
+    string expr = in[0];
+    for (int i = 1; i < in.size(); i++) {
+      expr += " + " + in[i];
+    }
+    return expr;
+  }
+  return "";
+}
+
+bool is_fusable(const OperatorDef& op) {
+  return op.device_option().device_type() == HIP && op.engine().empty() &&
+      op.output_size() == 1 &&
+      !pointwise_expression(op, std::vector<string>(op.input_size(), "x"))
+           .empty();
+}
+
+} // namespace
+
+bool FuseElementwiseTransform::PatternRule(
+    const Graph& g,
+    const std::vector<int>& subgraph,
+    int idx) {
+  const OperatorDef& op = g.node(idx).op;
+  if (!is_fusable(op)) {
+    return false;
+  }
+  if (subgraph.size() == 0) {
+    return true;
+  }
+  // Grow the chain from its last op, which must hand its output to idx only.
+  const Node& last = g.node(subgraph.back());
+  return last.children.size() == 1 && last.children.count(idx) &&
+      !g.external_output().count(last.op.output(0)) &&
+      IsSameDevice(last.op.device_option(), op.device_option());
+}
+
+// Fusing a single op would only trade its kernel for a generated one.
+bool FuseElementwiseTransform::ValidatorRule(
+    const Graph& g,
+    const std::vector<int>& subgraph) {
+  return subgraph.size() >= 2;
+}
+
+bool FuseElementwiseTransform::ReplaceRule(
+    const std::vector<int>& subgraph,
+    Graph* g_ptr) {
+  CHECK(g_ptr);
+  auto& g = *g_ptr;
+
+  const int new_idx = g.size();
+  OperatorDef new_op;
+  new_op.set_type("ElementwiseRTC");
+  new_op.set_engine("HIPRTC");
+  new_op.set_name(g.node(subgraph.back()).op.name());
+  new_op.mutable_device_option()->CopyFrom(
+      g.node(subgraph[0]).op.device_option());
+  new_op.add_output(g.node(subgraph.back()).op.output(0));
+
+  // Every op becomes one statement of the kernel. Blobs written inside the
+  // chain are read from the temporaries, the others become inputs.
+  std::map<string, string> values;
+  std::map<int, std::vector<string>> new_parents;
+  std::stringstream src;
+  for (int i = 0; i < subgraph.size(); i++) {
+    const Node& node = g.node(subgraph[i]);
+    std::vector<string> args;
+    for (const auto& blob : node.op.input()) {
+      if (!values.count(blob)) {
+        values[blob] = "in" + caffe2::to_string(new_op.input_size()) + "[index]";
+        new_op.add_input(blob);
+      }
+      args.push_back(values.at(blob));
+    }
+    const string var = "t" + caffe2::to_string(i);
+    src << "const float " << var << " = "
+        << pointwise_expression(node.op, args) << ";\n";
+    values[node.op.output(0)] = var;
+
+    for (const auto& parent : node.parents) {
+      if (std::find(subgraph.begin(), subgraph.end(), parent.first) ==
+          subgraph.end()) {
+        auto& blobs = new_parents[parent.first];
+        for (const auto& blob : parent.second) {
+          if (std::find(blobs.begin(), blobs.end(), blob) == blobs.end()) {
+            blobs.push_back(blob);
+          }
+        }
+      }
+    }
+  }
+  src << "out0[index] = t" << subgraph.size() - 1 << ";";
+  auto* arg = new_op.add_arg();
+  arg->set_name("rtc_src");
+  arg->set_s(src.str());
+
+  const auto children = g.node(subgraph.back()).children;
+  g.DeactivateSubgraph(subgraph);
+
+  for (const auto& parent : new_parents) {
+    g.node(parent.first).children[new_idx] = parent.second;
+  }
+  for (const auto& child : children) {
+    g.node(child.first).parents[new_idx] = child.second;
+  }
+  g.push_node(Node(new_op, true, new_parents, children));
+  return true;
+}
+
+REGISTER_TRANSFORM(FuseElementwise, FuseElementwiseTransform);
+
+} // namespace caffe2
@@ -0,0 +1,53 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/transform.h"
+#include "caffe2/proto/caffe2.pb.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+/**
+ * Elementwise Fusion
+ *
+ * Looks for chains of pointwise HIP operators, such as
+ * Add -> Mul -> Sigmoid -> Mul, where every op but the last is the only
+ * reader of its output and that output is not an external output. Such a
+ * chain is replaced by a single ElementwiseRTC op with the HIPRTC engine,
+ * whose generated kernel reads the inputs of the chain once and writes only
+ * its final output, instead of launching one kernel and materializing one
+ * intermediate tensor per op.
+ *
+ * All blobs are assumed to be float tensors of the same size: ops relying
+ * on broadcasting are not fused.
+ */
+class FuseElementwiseTransform : public Transform {
+ protected:
+  bool PatternRule(
+      const transform::Graph& g,
+      const std::vector<int>& subgraph,
+      int idx) override;
+  bool ValidatorRule(
+      const transform::Graph& g,
+      const std::vector<int>& subgraph) override;
+  bool ReplaceRule(const std::vector<int>& subgraph, transform::Graph* g_ptr)
+      override;
+};
+
+} // namespace caffe2
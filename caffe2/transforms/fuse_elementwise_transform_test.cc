@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/transforms/fuse_elementwise_transform.h"
+
+namespace caffe2 {
+
+namespace {
+
+using transform::Graph;
+
+OperatorDef* AddHIPOp(
+    NetDef* netdef,
+    string op_type,
+    std::vector<string> inputs,
+    std::vector<string> outputs) {
+  auto* op = AddOp(netdef, op_type, inputs, outputs);
+  op->mutable_device_option()->set_device_type(HIP);
+  return op;
+}
+
+TEST(FuseElementwiseTest, TestChain) {
+  NetDef netdef;
+  AddHIPOp(&netdef, "FC", {"X", "W", "b"}, {"fc"});
+  AddHIPOp(&netdef, "Add", {"fc", "a"}, {"sum"});
+  AddHIPOp(&netdef, "Mul", {"sum", "m"}, {"prod"});
+  AddHIPOp(&netdef, "Sigmoid", {"prod"}, {"gate"});
+  AddHIPOp(&netdef, "Mul", {"gate", "fc2"}, {"out"});
+  AddHIPOp(&netdef, "FC", {"out", "W", "b"}, {"Y"});
+
+  auto t = TransformRegistry()->Create("FuseElementwise");
+  EXPECT_EQ(t->PatternMatch(Graph(netdef)).size(), 1);
+  NetDef transformed_netdef = t->ApplyTo(netdef);
+
+  ASSERT_EQ(transformed_netdef.op_size(), 3);
+  EXPECT_EQ(transformed_netdef.op(0).type(), "FC");
+  const auto& fused = transformed_netdef.op(1);
+  EXPECT_EQ(fused.type(), "ElementwiseRTC");
+  EXPECT_EQ(fused.engine(), "HIPRTC");
+  EXPECT_EQ(fused.device_option().device_type(), HIP);
+  ASSERT_EQ(fused.input_size(), 4);
+  EXPECT_EQ(fused.input(0), "fc");
+  EXPECT_EQ(fused.input(1), "a");
+  EXPECT_EQ(fused.input(2), "m");
+  EXPECT_EQ(fused.input(3), "fc2");
+  ASSERT_EQ(fused.output_size(), 1);
+  EXPECT_EQ(fused.output(0), "out");
+  const string src = ArgumentHelper::GetSingleArgument<OperatorDef, string>(
+      fused, "rtc_src", "");
+  EXPECT_EQ(
+      src,
+      "const float t0 = in0[index] + in1[index];\n"
+      "const float t1 = t0 * in2[index];\n"
+      "const float t2 = 1.f / (1.f + expf(-t1));\n"
+      "const float t3 = t2 * in3[index];\n"
+      "out0[index] = t3;");
+  EXPECT_EQ(transformed_netdef.op(2).type(), "FC");
+  EXPECT_EQ(transformed_netdef.op(2).input(0), "out");
+}
+
+TEST(FuseElementwiseTest, TestNotFused) {
+  NetDef netdef;
+  // Not on HIP.
+  AddOp(&netdef, "Add", {"a", "b"}, {"c"});
+  AddOp(&netdef, "Relu", {"c"}, {"c"});
+  // Broadcasting.
+  auto* op = AddHIPOp(&netdef, "Add", {"c", "b"}, {"d"});
+  auto* arg = op->add_arg();
+  arg->set_name("broadcast");
+  arg->set_i(1);
+  AddHIPOp(&netdef, "Relu", {"d"}, {"e"});
+  // The intermediate blobs have a second reader.
+  AddHIPOp(&netdef, "Sigmoid", {"e"}, {"f"});
+  AddHIPOp(&netdef, "Mul", {"e", "f"}, {"g"});
+  AddHIPOp(&netdef, "FC", {"f", "W", "b"}, {"h"});
+
+  auto t = TransformRegistry()->Create("FuseElementwise");
+  EXPECT_EQ(t->PatternMatch(Graph(netdef)).size(), 0);
+}
+
+} // namespace
+
+} // namespace caffe2
@@ -0,0 +1,131 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/transforms/inplace_transform.h"
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/memonger.h"
+#include "caffe2/core/operator_schema.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+
+namespace {
+
+bool HasNetArgument(const OperatorDef& op) {
+  for (const auto& arg : op.arg()) {
+    if (arg.has_n() || arg.nets_size() > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+NetDef InPlaceTransform::ApplyTo(const NetDef& orig_net) {
+  if (orig_net.external_output_size() == 0) {
+    return orig_net;
+  }
+  for (const auto& op : orig_net.op()) {
+    if (HasNetArgument(op)) {
+      return orig_net;
+    }
+  }
+  std::set<string> static_blobs(
+      orig_net.external_input().begin(), orig_net.external_input().end());
+  static_blobs.insert(
+      orig_net.external_output().begin(), orig_net.external_output().end());
+
+  // Index of the first and last op reading and writing every blob.
+  const int kNone = -1;
+  std::unordered_map<string, int> first_read, last_read, first_write,
+      last_write, writers;
+  for (int i = 0; i < orig_net.op_size(); i++) {
+    for (const auto& blob : orig_net.op(i).input()) {
+      first_read.emplace(blob, i);
+      last_read[blob] = i;
+    }
+    for (const auto& blob : orig_net.op(i).output()) {
+      first_write.emplace(blob, i);
+      last_write[blob] = i;
+      writers[blob]++;
+    }
+  }
+  auto lookup = [kNone](const std::unordered_map<string, int>& m,
+                        const string& blob) {
+    auto it = m.find(blob);
+    return it == m.end() ? kNone : it->second;
+  };
+
+  NetDef net = orig_net;
+  // Outputs renamed to the input they now alias. The renamed outputs have a
+  // single writer, so every later use of them is an input.
+  std::unordered_map<string, string> renaming;
+  for (int i = 0; i < net.op_size(); i++) {
+    auto& op = *net.mutable_op(i);
+    for (int k = 0; k < op.input_size(); k++) {
+      auto it = renaming.find(op.input(k));
+      if (it != renaming.end()) {
+        op.set_input(k, it->second);
+      }
+    }
+    const auto* schema = OpSchemaRegistry::Schema(op.type());
+    if (!schema) {
+      continue;
+    }
+    const std::vector<string> inputs(op.input().begin(), op.input().end());
+    const std::vector<string> outputs(op.output().begin(), op.output().end());
+    std::set<string> aliased;
+    for (int o = 0; o < outputs.size(); o++) {
+      const auto& y = outputs[o];
+      if (static_blobs.count(y) || writers.at(y) != 1 ||
+          (lookup(first_read, y) != kNone && lookup(first_read, y) <= i) ||
+          std::count(outputs.begin(), outputs.end(), y) != 1) {
+        continue;
+      }
+      for (int k = 0; k < inputs.size(); k++) {
+        const auto& x = inputs[k];
+        if (!schema->inplace_allowed(k, o) || static_blobs.count(x) ||
+            aliased.count(x) || lookup(last_read, x) != i ||
+            lookup(first_write, x) == kNone || lookup(first_write, x) >= i ||
+            lookup(last_write, x) > i ||
+            std::count(inputs.begin(), inputs.end(), x) != 1 ||
+            std::count(outputs.begin(), outputs.end(), x) != 0) {
+          continue;
+        }
+        op.set_output(o, x);
+        renaming[y] = x;
+        aliased.insert(x);
+        // x now lives as long as y did.
+        last_read[x] = std::max(i, lookup(last_read, y));
+        last_write[x] = i;
+        break;
+      }
+    }
+  }
+  if (renaming.empty()) {
+    return orig_net;
+  }
+  VLOG(1) << "Made " << renaming.size() << " outputs of net "
+          << orig_net.name() << " in-place";
+  return memonger::optimize_inference_net(net, static_blobs);
+}
+
+REGISTER_TRANSFORM(InPlace, InPlaceTransform);
+
+} // namespace caffe2
@@ -0,0 +1,50 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/transform.h"
+#include "caffe2/proto/caffe2.pb.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+/**
+ * In-place Rewriting
+ *
+ * Makes operators write their output into one of their inputs when the
+ * operator schema allows it (AllowInplace) and that input is not needed
+ * afterwards, e.g. FC -> Relu -> Dropout all end up writing the FC output.
+ * An output Y is renamed to the input X read at the same op if:
+ *  - X is an intermediate blob: written earlier in the net, never written
+ *    again afterwards and not an external input or output;
+ *  - this op is the last one reading X, and reads it only once;
+ *  - Y is written only by this op, is not read before it and is not an
+ *    external input or output.
+ * Then, for simple nets, memonger::optimize_inference_net shares the
+ * remaining intermediate blobs across non-overlapping lifetimes.
+ *
+ * Nets without declared external outputs, and nets with operators holding
+ * nets as arguments (e.g. RecurrentNetwork, which refer to blobs by name in
+ * them), are returned unchanged.
+ */
+class InPlaceTransform : public Transform {
+ public:
+  NetDef ApplyTo(const NetDef& orig_net_def) override;
+};
+
+} // namespace caffe2
@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/transforms/inplace_transform.h"
+
+namespace caffe2 {
+
+namespace {
+
+NetDef MakeNet() {
+  NetDef netdef;
+  for (const auto& blob : {"in", "w", "b", "w2", "b2"}) {
+    netdef.add_external_input(blob);
+  }
+  return netdef;
+}
+
+/**
+ *  Before: (FC)-h->(Relu)-r->(Dropout)-d->(FC)-->out
+ *
+ *  After : (FC)-h->(Relu)-h->(Dropout)-h->(FC)-->out
+ */
+TEST(InPlaceTest, TestChain) {
+  NetDef netdef = MakeNet();
+  AddOp(&netdef, "FC", {"in", "w", "b"}, {"h"});
+  AddOp(&netdef, "Relu", {"h"}, {"r"});
+  auto* op = AddOp(&netdef, "Dropout", {"r"}, {"d"});
+  AddArgument("is_test", 1, op);
+  AddOp(&netdef, "FC", {"d", "w2", "b2"}, {"out"});
+  netdef.add_external_output("out");
+
+  auto t = TransformRegistry()->Create("InPlace");
+  CHECK(t);
+  NetDef transformed_netdef = t->ApplyTo(netdef);
+
+  EXPECT_EQ(transformed_netdef.op_size(), 4);
+  // The intermediate blob may also be renamed by the memonger pass.
+  const auto& h = transformed_netdef.op(0).output(0);
+  EXPECT_EQ(transformed_netdef.op(1).input(0), h);
+  EXPECT_EQ(transformed_netdef.op(1).output(0), h);
+  EXPECT_EQ(transformed_netdef.op(2).input(0), h);
+  EXPECT_EQ(transformed_netdef.op(2).output(0), h);
+  EXPECT_EQ(transformed_netdef.op(3).input(0), h);
+  EXPECT_EQ(transformed_netdef.op(3).output(0), "out");
+}
+
+/**
+ * Inputs read again later, external outputs, and external inputs are not
+ * overwritten.
+ */
+TEST(InPlaceTest, TestNotEligible) {
+  NetDef netdef = MakeNet();
+  AddOp(&netdef, "FC", {"in", "w", "b"}, {"h"});
+  AddOp(&netdef, "Relu", {"h"}, {"r"});
+  AddOp(&netdef, "Add", {"r", "h"}, {"s"});
+  AddOp(&netdef, "Relu", {"s"}, {"out"});
+  AddOp(&netdef, "Relu", {"in"}, {"in_relu"});
+  netdef.add_external_output("out");
+  netdef.add_external_output("in_relu");
+
+  auto t = TransformRegistry()->Create("InPlace");
+  CHECK(t);
+  NetDef transformed_netdef = t->ApplyTo(netdef);
+
+  EXPECT_EQ(transformed_netdef.op_size(), 5);
+  EXPECT_NE(
+      transformed_netdef.op(1).output(0), transformed_netdef.op(1).input(0));
+  for (int i = 2; i < 5; i++) {
+    EXPECT_NE(
+        transformed_netdef.op(i).output(0),
+        transformed_netdef.op(i).input(0));
+  }
+  EXPECT_EQ(transformed_netdef.op(4).input(0), "in");
+}
+
+} // namespace
+
+} // namespace caffe2
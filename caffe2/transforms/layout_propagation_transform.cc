@@ -0,0 +1,389 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/transforms/layout_propagation_transform.h"
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+
+namespace {
+
+const std::set<string> kOrderAwareOps = {"AveragePool",
+                                         "AveragePool2D",
+                                         "Conv",
+                                         "Conv2D",
+                                         "MaxPool",
+                                         "MaxPool2D",
+                                         "SpatialBN"};
+
+// Ops whose output elements only depend on the input elements at the same
+// position, which run unchanged in either order.
+const std::set<string> kElementwiseOps =
+    {"Clip", "Elu", "LeakyRelu", "Relu", "Scale", "Sigmoid", "Sum", "Tanh"};
+
+StorageOrder GetOrder(const OperatorDef& op) {
+  return StringToStorageOrder(
+      ArgumentHelper::GetSingleArgument<OperatorDef, string>(
+          op, "order", "NCHW"));
+}
+
+StorageOrder OtherOrder(StorageOrder order) {
+  return order == StorageOrder::NCHW ? StorageOrder::NHWC
+                                     : StorageOrder::NCHW;
+}
+
+string OrderedName(const string& blob, StorageOrder order) {
+  return "transform/" + blob +
+      (order == StorageOrder::NHWC ? "_nhwc" : "_nchw");
+}
+
+bool IsConv(const OperatorDef& op) {
+  return op.type() == "Conv" || op.type() == "Conv2D";
+}
+
+bool IsSwitch(const OperatorDef& op) {
+  return (op.type() == "NCHW2NHWC" || op.type() == "NHWC2NCHW") &&
+      op.input_size() == 1 && op.output_size() == 1 &&
+      op.input(0) != op.output(0);
+}
+
+// The op switching input, stored in order from, to the other order.
+OperatorDef MakeSwitch(
+    StorageOrder from,
+    const string& input,
+    const string& output,
+    const OperatorDef& like) {
+  OperatorDef op;
+  op.set_type(from == StorageOrder::NCHW ? "NCHW2NHWC" : "NHWC2NCHW");
+  op.add_input(input);
+  op.add_output(output);
+  if (like.has_device_option()) {
+    op.mutable_device_option()->CopyFrom(like.device_option());
+  }
+  return op;
+}
+
+// Rewrites a net op by op, tracking for every blob of the original net
+// where its value can be read:
+//  - alias_: the blob is not written, it is a copy of another blob (a
+//    dropped switch of a blob that was available in the other order),
+//  - pending_: the blob is not written yet, the switch writing it is only
+//    emitted when something reads it in its own order,
+//  - other_: the blob whose value is this one in the other order.
+// Before a blob is overwritten, the aliases and pending switches that read
+// it and are still needed are emitted.
+class LayoutPropagator {
+ public:
+  LayoutPropagator(const NetDef& net, StorageOrder order)
+      : net_(net), order_(order) {
+    for (int i = 0; i < net.op_size(); i++) {
+      for (const auto& blob : net.op(i).input()) {
+        last_read_[blob] = i;
+      }
+    }
+    for (const auto& blob : net.external_output()) {
+      last_read_[blob] = net.op_size();
+    }
+  }
+
+  NetDef Run() {
+    result_ = net_;
+    result_.clear_op();
+    for (idx_ = 0; idx_ < net_.op_size(); idx_++) {
+      const auto& op = net_.op(idx_);
+      if (IsSwitch(op)) {
+        AddSwitch(op);
+      } else if (CanReorder(op)) {
+        AddReordered(op);
+      } else if (!AddElementwise(op)) {
+        AddUnchanged(op);
+      }
+    }
+    for (const auto& blob : net_.external_output()) {
+      Materialize(blob);
+    }
+    return result_;
+  }
+
+ private:
+  bool CanReorder(const OperatorDef& op) {
+    if (!kOrderAwareOps.count(op.type()) || op.input_size() == 0 ||
+        op.output_size() == 0 || (IsConv(op) && op.input_size() < 2)) {
+      return false;
+    }
+    const StorageOrder from = GetOrder(op);
+    if (from == order_ || from == StorageOrder::UNKNOWN) {
+      return false;
+    }
+    ArgumentHelper helper(op);
+    // The switches only take 4D blobs.
+    if (helper.HasArgument("kernels") &&
+        helper.GetRepeatedArgument<int>("kernels").size() != 2) {
+      return false;
+    }
+    if (op.type() == "SpatialBN" && !other_.count(op.input(0))) {
+      return false;
+    }
+    if (order_ == StorageOrder::NCHW) {
+      return true;
+    }
+    // Only the default CPU implementations run in NHWC, without groups for
+    // the Conv.
+    const auto& device =
+        op.has_device_option() ? op.device_option() : net_.device_option();
+    return device.device_type() == CPU && op.engine().empty() &&
+        !(IsConv(op) && helper.GetSingleArgument<int>("group", 1) != 1);
+  }
+
+  void AddSwitch(const OperatorDef& op) {
+    const string& input = op.input(0);
+    const string& output = op.output(0);
+    auto it = other_.find(input);
+    if (it != other_.end()) {
+      OperatorDef copy = op;
+      copy.set_type("Copy");
+      copy.set_input(0, it->second);
+      Redefine(output);
+      alias_[output] = copy;
+      other_[output] = input;
+      return;
+    }
+    OperatorDef pending = op;
+    pending.set_input(0, Resolve(input));
+    Redefine(output);
+    pending_[output] = pending;
+    other_[input] = output;
+    other_[output] = input;
+  }
+
+  void AddReordered(const OperatorDef& op) {
+    const StorageOrder from = GetOrder(op);
+    OperatorDef new_op = op;
+    new_op.set_input(0, Switched(op.input(0), from, op));
+    for (int i = 1; i < op.input_size(); i++) {
+      // The Conv filter is stored in the order of the Conv.
+      new_op.set_input(
+          i,
+          IsConv(op) && i == 1 ? Switched(op.input(i), from, op)
+                               : Resolve(op.input(i)));
+    }
+    const string& output = op.output(0);
+    const string reordered = OrderedName(output, order_);
+    new_op.set_output(0, reordered);
+    new_op.clear_arg();
+    for (const auto& arg : op.arg()) {
+      if (arg.name() != "order") {
+        new_op.add_arg()->CopyFrom(arg);
+      }
+    }
+    AddArgument<string>(
+        "order", order_ == StorageOrder::NHWC ? "NHWC" : "NCHW", &new_op);
+    for (const auto& blob : op.output()) {
+      Redefine(blob);
+    }
+    Redefine(reordered);
+    Emit(new_op);
+    pending_[output] = MakeSwitch(order_, reordered, output, op);
+    other_[output] = reordered;
+  }
+
+  // Runs an elementwise op in the other order, if none of its inputs is
+  // available in its own order.
+  bool AddElementwise(const OperatorDef& op) {
+    if (!kElementwiseOps.count(op.type()) || op.input_size() == 0 ||
+        op.output_size() != 1) {
+      return false;
+    }
+    string type;
+    for (const auto& blob : op.input()) {
+      auto it = pending_.find(blob);
+      if (it == pending_.end() || !other_.count(blob) ||
+          (!type.empty() && it->second.type() != type)) {
+        return false;
+      }
+      type = it->second.type();
+    }
+    const StorageOrder from = type == "NCHW2NHWC" ? StorageOrder::NCHW
+                                                  : StorageOrder::NHWC;
+    OperatorDef new_op = op;
+    for (int i = 0; i < op.input_size(); i++) {
+      new_op.set_input(i, Resolve(other_[op.input(i)]));
+    }
+    const string& output = op.output(0);
+    const string reordered = OrderedName(output, from);
+    new_op.set_output(0, reordered);
+    Redefine(output);
+    Redefine(reordered);
+    Emit(new_op);
+    pending_[output] = MakeSwitch(from, reordered, output, op);
+    other_[output] = reordered;
+    return true;
+  }
+
+  void AddUnchanged(const OperatorDef& op) {
+    OperatorDef new_op = op;
+    for (int i = 0; i < op.input_size(); i++) {
+      new_op.set_input(i, Resolve(op.input(i)));
+    }
+    for (const auto& blob : op.output()) {
+      Redefine(blob);
+    }
+    Emit(new_op);
+  }
+
+  // Returns the blob holding the value of blob, stored in order from, in the
+  // other order, switching it if it is not available yet.
+  string Switched(
+      const string& blob,
+      StorageOrder from,
+      const OperatorDef& op) {
+    auto it = other_.find(blob);
+    if (it != other_.end()) {
+      return Resolve(it->second);
+    }
+    const string source = Resolve(blob);
+    const string switched = OrderedName(blob, OtherOrder(from));
+    Redefine(switched);
+    Emit(MakeSwitch(from, source, switched, op));
+    other_[blob] = switched;
+    return switched;
+  }
+
+  // Returns the written blob holding the value of blob.
+  string Resolve(const string& blob) {
+    auto it = alias_.find(blob);
+    if (it != alias_.end()) {
+      return Resolve(it->second.input(0));
+    }
+    if (pending_.count(blob)) {
+      Materialize(blob);
+    }
+    return blob;
+  }
+
+  // Makes sure that blob is written.
+  void Materialize(const string& blob) {
+    auto pending = pending_.find(blob);
+    if (pending != pending_.end()) {
+      const OperatorDef op = pending->second;
+      pending_.erase(pending);
+      Emit(op);
+      return;
+    }
+    auto alias = alias_.find(blob);
+    if (alias != alias_.end()) {
+      OperatorDef op = alias->second;
+      alias_.erase(alias);
+      op.set_input(0, Resolve(op.input(0)));
+      Emit(op);
+    }
+  }
+
+  // Called before blob gets a new value: the blobs that are still to be
+  // made from its current value are made now, or forgotten if nothing reads
+  // them anymore.
+  void Redefine(const string& blob) {
+    std::vector<string> dependents;
+    for (const auto& entry : alias_) {
+      if (entry.second.input(0) == blob && entry.first != blob) {
+        dependents.push_back(entry.first);
+      }
+    }
+    for (const auto& entry : pending_) {
+      if (entry.second.input(0) == blob && entry.first != blob) {
+        dependents.push_back(entry.first);
+      }
+    }
+    for (const auto& dependent : dependents) {
+      if (NeededLater(dependent)) {
+        Materialize(dependent);
+      } else {
+        Redefine(dependent);
+      }
+    }
+    alias_.erase(blob);
+    pending_.erase(blob);
+    for (auto it = other_.begin(); it != other_.end();) {
+      if (it->first == blob || it->second == blob) {
+        it = other_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  bool NeededLater(const string& blob) const {
+    auto it = last_read_.find(blob);
+    if (it != last_read_.end() && it->second > idx_) {
+      return true;
+    }
+    for (const auto& entry : alias_) {
+      if (entry.second.input(0) == blob && entry.first != blob &&
+          NeededLater(entry.first)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void Emit(const OperatorDef& op) {
+    result_.add_op()->CopyFrom(op);
+  }
+
+  const NetDef& net_;
+  const StorageOrder order_;
+  NetDef result_;
+  int idx_ = 0;
+  std::map<string, int> last_read_;
+  std::map<string, OperatorDef> alias_;
+  std::map<string, OperatorDef> pending_;
+  std::map<string, string> other_;
+};
+
+int CountSwitches(const NetDef& net) {
+  int count = 0;
+  for (const auto& op : net.op()) {
+    count += op.type() == "NCHW2NHWC" || op.type() == "NHWC2NCHW";
+  }
+  return count;
+}
+
+} // namespace
+
+NetDef LayoutPropagationTransform::ApplyTo(const NetDef& orig_net) {
+  StorageOrder order = order_;
+  if (!has_order_) {
+    int nhwc = 0;
+    int nchw = 0;
+    for (const auto& op : orig_net.op()) {
+      if (kOrderAwareOps.count(op.type())) {
+        (GetOrder(op) == StorageOrder::NHWC ? nhwc : nchw)++;
+      }
+    }
+    order = nhwc > nchw ? StorageOrder::NHWC : StorageOrder::NCHW;
+  }
+  NetDef net = LayoutPropagator(orig_net, order).Run();
+  VLOG(1) << "Order switches in net " << orig_net.name() << ": "
+          << CountSwitches(orig_net) << " -> " << CountSwitches(net);
+  return net;
+}
+
+REGISTER_TRANSFORM(LayoutPropagation, LayoutPropagationTransform);
+
+} // namespace caffe2
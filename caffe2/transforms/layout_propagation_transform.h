@@ -0,0 +1,63 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/transform.h"
+#include "caffe2/core/types.h"
+#include "caffe2/proto/caffe2.pb.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+/**
+ * Layout Propagation
+ *
+ * Runs every order-aware operator (Conv, MaxPool, AveragePool, SpatialBN)
+ * that can in a single storage order, and removes the NCHW2NHWC and
+ * NHWC2NCHW switches that become unneeded, since every switch is a full pass
+ * over its blob.
+ *
+ * An operator changed to the target order reads the target-order version of
+ * its input, and of its filter for a Conv, writes a target-order version of
+ * its output, and leaves the original output to be switched back only if
+ * something still reads it in the original order. Elementwise operators
+ * (Relu, Sigmoid, Sum, ...) run in whichever order their inputs are
+ * available in, and a switch is dropped when its output already exists in
+ * the other order. The switches of constant filters are left to
+ * ConstantFolding.
+ *
+ * By default, the target order is the one most order-aware operators of the
+ * net already use. Ops are only changed to NHWC if they run on the CPU with
+ * the default engine, in 2D and, for a Conv, without groups; SpatialBN is
+ * only changed when its input is already available in the target order,
+ * since a switch needs a 4D blob.
+ */
+class LayoutPropagationTransform : public Transform {
+ public:
+  LayoutPropagationTransform() {}
+  explicit LayoutPropagationTransform(StorageOrder order)
+      : order_(order), has_order_(true) {}
+
+  NetDef ApplyTo(const NetDef& orig_net_def) override;
+
+ private:
+  StorageOrder order_ = StorageOrder::NCHW;
+  bool has_order_ = false;
+};
+
+} // namespace caffe2
@@ -0,0 +1,148 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/transforms/layout_propagation_transform.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+OperatorDef* AddOrderedOp(
+    NetDef* netdef,
+    const string& type,
+    const std::vector<string>& inputs,
+    const string& output,
+    const string& order) {
+  auto* op = AddOp(netdef, type, inputs, {output});
+  AddArgument<int>("kernel", type == "MaxPool" ? 2 : 3, op);
+  AddArgument<int>("pad", type == "MaxPool" ? 0 : 1, op);
+  AddArgument<string>("order", order, op);
+  return op;
+}
+
+string GetOrder(const OperatorDef& op) {
+  return ArgumentHelper::GetSingleArgument<OperatorDef, string>(
+      op, "order", "");
+}
+
+void FillRandom(Workspace* ws, const string& name, std::vector<TIndex> dims) {
+  CPUContext context;
+  auto* tensor = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  tensor->Resize(dims);
+  math::RandUniform<float, CPUContext>(
+      tensor->size(), -1.0f, 1.0f, tensor->mutable_data<float>(), &context);
+}
+
+void ExpectSameOutput(const NetDef& netdef, const NetDef& transformed) {
+  Workspace ws;
+  FillRandom(&ws, "X", {2, 4, 8, 8});
+  FillRandom(&ws, "W", {5, 4, 3, 3});
+  FillRandom(&ws, "W2", {3, 5, 3, 3});
+  FillRandom(&ws, "b", {5});
+
+  ASSERT_TRUE(ws.RunNetOnce(netdef));
+  TensorCPU expected(ws.GetBlob("Y")->Get<TensorCPU>());
+  ws.GetBlob("Y")->Reset();
+  ASSERT_TRUE(ws.RunNetOnce(transformed));
+  const auto& actual = ws.GetBlob("Y")->Get<TensorCPU>();
+
+  ASSERT_EQ(actual.dims(), expected.dims());
+  for (int i = 0; i < actual.size(); i++) {
+    EXPECT_NEAR(actual.data<float>()[i], expected.data<float>()[i], 1e-4);
+  }
+}
+
+TEST(LayoutPropagationTest, TestRemovesSwitches) {
+  NetDef netdef;
+  AddOrderedOp(&netdef, "Conv", {"X", "W", "b"}, "conv", "NCHW");
+  AddOp(&netdef, "NCHW2NHWC", {"conv"}, {"conv_nhwc"});
+  AddOrderedOp(&netdef, "MaxPool", {"conv_nhwc"}, "pool_nhwc", "NHWC");
+  AddOp(&netdef, "NHWC2NCHW", {"pool_nhwc"}, {"pool"});
+  AddOp(&netdef, "Relu", {"pool"}, {"relu"});
+  AddOrderedOp(&netdef, "Conv", {"relu", "W2"}, "Y", "NCHW");
+  netdef.add_external_output("Y");
+
+  auto t = TransformRegistry()->Create("LayoutPropagation");
+  NetDef transformed_netdef = t->ApplyTo(netdef);
+
+  ASSERT_EQ(transformed_netdef.op_size(), 4);
+  EXPECT_EQ(transformed_netdef.op(0).type(), "Conv");
+  const auto& pool = transformed_netdef.op(1);
+  EXPECT_EQ(pool.type(), "MaxPool");
+  EXPECT_EQ(pool.input(0), "conv");
+  EXPECT_EQ(GetOrder(pool), "NCHW");
+  const auto& relu = transformed_netdef.op(2);
+  EXPECT_EQ(relu.type(), "Relu");
+  EXPECT_EQ(relu.input(0), pool.output(0));
+  EXPECT_EQ(transformed_netdef.op(3).type(), "Conv");
+  EXPECT_EQ(transformed_netdef.op(3).output(0), "Y");
+
+  ExpectSameOutput(netdef, transformed_netdef);
+}
+
+TEST(LayoutPropagationTest, TestToNHWC) {
+  NetDef netdef;
+  AddOrderedOp(&netdef, "Conv", {"X", "W", "b"}, "conv", "NCHW");
+  AddOp(&netdef, "Relu", {"conv"}, {"relu"});
+  AddOrderedOp(&netdef, "Conv", {"relu", "W2"}, "Y", "NCHW");
+  netdef.add_external_output("Y");
+
+  LayoutPropagationTransform t(StorageOrder::NHWC);
+  NetDef transformed_netdef = t.ApplyTo(netdef);
+
+  // The input and the filters are switched once, the Relu runs on the NHWC
+  // output of the first Conv and only the net output is switched back.
+  ASSERT_EQ(transformed_netdef.op_size(), 7);
+  std::vector<string> types;
+  for (const auto& op : transformed_netdef.op()) {
+    types.push_back(op.type());
+  }
+  EXPECT_EQ(
+      types,
+      (std::vector<string>{"NCHW2NHWC",
+                           "NCHW2NHWC",
+                           "Conv",
+                           "Relu",
+                           "NCHW2NHWC",
+                           "Conv",
+                           "NHWC2NCHW"}));
+  EXPECT_EQ(
+      transformed_netdef.op(3).input(0), transformed_netdef.op(2).output(0));
+  EXPECT_EQ(transformed_netdef.op(6).output(0), "Y");
+
+  ExpectSameOutput(netdef, transformed_netdef);
+}
+
+TEST(LayoutPropagationTest, TestKeepsGroupConv) {
+  NetDef netdef;
+  auto* conv = AddOrderedOp(&netdef, "Conv", {"X", "W", "b"}, "Y", "NCHW");
+  AddArgument<int>("group", 2, conv);
+  netdef.add_external_output("Y");
+
+  // Grouped convolutions only run in NCHW, so nothing changes.
+  LayoutPropagationTransform t(StorageOrder::NHWC);
+  NetDef transformed_netdef = t.ApplyTo(netdef);
+  ASSERT_EQ(transformed_netdef.op_size(), 1);
+  EXPECT_EQ(GetOrder(transformed_netdef.op(0)), "NCHW");
+}
+
+} // namespace
+
+} // namespace caffe2
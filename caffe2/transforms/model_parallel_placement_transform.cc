@@ -0,0 +1,221 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/transforms/model_parallel_placement_transform.h"
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/net_cost_model.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+
+namespace {
+
+const int kCPU = -1;
+
+bool IsOnCPU(const OperatorDef& op) {
+  return op.has_device_option() && op.device_option().device_type() == CPU;
+}
+
+size_t BlobBytes(
+    const CaffeMap<string, TensorShape>& shapes,
+    const string& blob) {
+  const auto it = shapes.find(blob);
+  if (it == shapes.end() || it->second.unknown_shape()) {
+    return 0;
+  }
+  return nBytesFromShape(it->second);
+}
+
+string LocalName(const string& blob, int device) {
+  return device == kCPU ? blob + "_cpu" : blob + "_hip" + to_string(device);
+}
+
+DeviceOption OnHIP(DeviceOption option, int device) {
+  option.set_device_type(HIP);
+  option.set_hip_gpu_id(device);
+  return option;
+}
+
+} // namespace
+
+NetDef ModelParallelPlacementTransform::ApplyTo(const NetDef& orig_net_def) {
+  const int num_ops = orig_net_def.op_size();
+  CAFFE_ENFORCE_GT(num_devices_, 0);
+  CAFFE_ENFORCE(
+      memory_limits_.empty() || memory_limits_.size() == num_devices_,
+      "Expected a memory limit for each of the ",
+      num_devices_,
+      " devices, got ",
+      memory_limits_.size());
+  CAFFE_ENFORCE(
+      op_costs_.empty() || op_costs_.size() == num_ops,
+      "Expected a cost for each of the ",
+      num_ops,
+      " ops, got ",
+      op_costs_.size());
+
+  TensorShapes inferred_shapes;
+  if (!input_dims_.empty()) {
+    vector<std::unique_ptr<NetDef>> nets;
+    nets.emplace_back(new NetDef(orig_net_def));
+    inferred_shapes = InferBlobShapesAndTypesFromMap(input_dims_, nets);
+  }
+  CaffeMap<string, TensorShape> shapes;
+  for (const auto& shape : inferred_shapes.shapes()) {
+    shapes[shape.name()] = shape;
+  }
+  const NetCostModel cost_model(orig_net_def, inferred_shapes);
+
+  std::vector<float> costs(num_ops, 0);
+  float total_cost = 0;
+  for (int i = 0; i < num_ops; i++) {
+    const auto& op = orig_net_def.op(i);
+    if (!IsOnCPU(op)) {
+      costs[i] = op_costs_.empty()
+          ? std::max<float>(1, cost_model.op_cost(i).flops)
+          : op_costs_[i];
+      total_cost += costs[i];
+    }
+  }
+
+  // Stage d ends at d + 1 nths of the total cost. An op goes to the next
+  // stage when more than half of its cost is past the end of the current
+  // one, or when the blobs it adds to the current one don't fit.
+  std::vector<int> devices(num_ops, kCPU);
+  std::vector<std::set<string>> resident(num_devices_);
+  std::vector<size_t> resident_bytes(num_devices_, 0);
+  int device = 0;
+  bool stage_empty = true;
+  float cost_before = 0;
+  for (int i = 0; i < num_ops; i++) {
+    const auto& op = orig_net_def.op(i);
+    if (IsOnCPU(op)) {
+      continue;
+    }
+    if (!stage_empty && device + 1 < num_devices_ &&
+        cost_before + costs[i] / 2 > total_cost * (device + 1) / num_devices_) {
+      device++;
+      stage_empty = true;
+    }
+    std::set<string> blobs(op.input().begin(), op.input().end());
+    blobs.insert(op.output().begin(), op.output().end());
+    while (true) {
+      size_t bytes = 0;
+      for (const auto& blob : blobs) {
+        if (!resident[device].count(blob)) {
+          bytes += BlobBytes(shapes, blob);
+        }
+      }
+      if (memory_limits_.empty() ||
+          resident_bytes[device] + bytes <= memory_limits_[device]) {
+        resident_bytes[device] += bytes;
+        resident[device].insert(blobs.begin(), blobs.end());
+        break;
+      }
+      CAFFE_ENFORCE(
+          !stage_empty && device + 1 < num_devices_,
+          "Op ",
+          i,
+          " (",
+          op.type(),
+          ") does not fit in the memory of HIP device ",
+          device);
+      device++;
+      stage_empty = true;
+    }
+    devices[i] = device;
+    stage_empty = false;
+    cost_before += costs[i];
+  }
+
+  // A blob keeps its name on the device of its first writer (or reader, for
+  // an external input) and is renamed on the others.
+  NetDef net_def(orig_net_def);
+  net_def.clear_op();
+  input_devices_.clear();
+  std::map<string, int> home;
+  std::map<string, std::set<int>> holders;
+  auto local_name = [&home](const string& blob, int device) {
+    return device == home.at(blob) ? blob : LocalName(blob, device);
+  };
+  auto copy_to = [&](const string& blob, int device) {
+    const auto& current = holders.at(blob);
+    const int from =
+        current.count(home.at(blob)) ? home.at(blob) : *current.begin();
+    auto* copy = net_def.add_op();
+    copy->set_type(
+        from == kCPU ? "CopyCPUToGPU"
+                     : (device == kCPU ? "CopyGPUToCPU" : "Copy"));
+    copy->add_input(local_name(blob, from));
+    copy->add_output(local_name(blob, device));
+    *copy->mutable_device_option() =
+        OnHIP(net_def.device_option(), device == kCPU ? from : device);
+    holders[blob].insert(device);
+  };
+
+  for (int i = 0; i < num_ops; i++) {
+    OperatorDef op = orig_net_def.op(i);
+    const int device = devices[i];
+    for (auto& input : *op.mutable_input()) {
+      if (!home.count(input)) {
+        home[input] = device;
+        holders[input] = {device};
+        input_devices_[input] = device;
+      }
+      if (!holders[input].count(device)) {
+        copy_to(input, device);
+      }
+      input = local_name(input, device);
+    }
+    for (auto& output : *op.mutable_output()) {
+      if (!home.count(output)) {
+        home[output] = device;
+      }
+      holders[output] = {device};
+      output = local_name(output, device);
+    }
+    if (device != kCPU) {
+      *op.mutable_device_option() = OnHIP(
+          op.has_device_option() ? op.device_option()
+                                 : orig_net_def.device_option(),
+          device);
+    }
+    *net_def.add_op() = op;
+  }
+  for (const auto& output : net_def.external_output()) {
+    if (home.count(output) && !holders[output].count(home[output])) {
+      copy_to(output, home[output]);
+    }
+  }
+  return net_def;
+}
+
+int ModelParallelPlacementTransform::device(const string& blob) const {
+  const auto it = input_devices_.find(blob);
+  CAFFE_ENFORCE(
+      it != input_devices_.end(),
+      "Blob ",
+      blob,
+      " is not an input of the last transformed net.");
+  return it->second;
+}
+
+REGISTER_TRANSFORM(ModelParallelPlacement, ModelParallelPlacementTransform);
+
+} // namespace caffe2
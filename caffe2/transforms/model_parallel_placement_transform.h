@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/transform.h"
+#include "caffe2/proto/caffe2.pb.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+/**
+ * Model Parallel Placement
+ *
+ * Splits a net that is too large or too slow for one GPU into consecutive
+ * stages, one per HIP device, and inserts the copies of the blobs that cross
+ * devices, so that the device_options of the ops don't have to be written
+ * by hand.
+ *
+ * A stage is a contiguous range of ops of the net, and the stages are
+ * balanced by the cost of their ops: the given per-op costs (e.g. the
+ * average run times of a profiling observer) if any, else the flops of the
+ * NetCostModel of the net for the shapes of the given input blobs, or one
+ * for an op it doesn't know. A stage also ends early when the blobs it
+ * reads and writes would not fit in the memory limit of its device. Ops
+ * that are explicitly placed on the CPU stay there.
+ *
+ * A blob read on a device other than the one holding its latest value is
+ * copied to "<blob>_hip<id>" (or "<blob>_cpu") by a Copy, CopyCPUToGPU or
+ * CopyGPUToCPU op right before its first reader there, once per value. Each
+ * copy is an op of its own, so that async nets run it on a stream of its
+ * own rather than behind the compute of its device. External outputs
+ * are copied back to the device of their first writer at the end of the
+ * net. After ApplyTo, device() tells the device every external input has
+ * to be fed on.
+ */
+class ModelParallelPlacementTransform : public Transform {
+ public:
+  ModelParallelPlacementTransform() {}
+  // memory_limits are in bytes per device, an empty vector means no limit.
+  // op_costs, if not empty, holds one cost per op of the net.
+  explicit ModelParallelPlacementTransform(
+      int num_devices,
+      std::vector<size_t> memory_limits = {},
+      CaffeMap<string, std::vector<TIndex>> input_dims = {},
+      std::vector<float> op_costs = {})
+      : num_devices_(num_devices),
+        memory_limits_(std::move(memory_limits)),
+        input_dims_(std::move(input_dims)),
+        op_costs_(std::move(op_costs)) {}
+
+  NetDef ApplyTo(const NetDef& orig_net_def) override;
+
+  // The HIP device (or -1 for the CPU) that an external input of the last
+  // transformed net is first read on.
+  int device(const string& blob) const;
+
+ private:
+  int num_devices_ = 2;
+  std::vector<size_t> memory_limits_;
+  CaffeMap<string, std::vector<TIndex>> input_dims_;
+  std::vector<float> op_costs_;
+  std::map<string, int> input_devices_;
+};
+
+} // namespace caffe2
@@ -0,0 +1,119 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/transforms/model_parallel_placement_transform.h"
+
+namespace caffe2 {
+
+namespace {
+
+void ExpectOp(
+    const OperatorDef& op,
+    const string& type,
+    const string& input,
+    const string& output,
+    int device_type,
+    int hip_gpu_id) {
+  EXPECT_EQ(op.type(), type);
+  EXPECT_EQ(op.input(0), input);
+  EXPECT_EQ(op.output(0), output);
+  EXPECT_EQ(op.device_option().device_type(), device_type);
+  if (device_type == HIP) {
+    EXPECT_EQ(op.device_option().hip_gpu_id(), hip_gpu_id);
+  }
+}
+
+TEST(ModelParallelPlacementTest, TestSplitsByCost) {
+  NetDef netdef;
+  AddOp(&netdef, "Relu", {"X"}, {"a"});
+  AddOp(&netdef, "Relu", {"a"}, {"b"});
+  AddOp(&netdef, "Relu", {"b"}, {"c"});
+  AddOp(&netdef, "Relu", {"c"}, {"Y"});
+  netdef.add_external_output("Y");
+
+  ModelParallelPlacementTransform t(2, {}, {}, {1, 3, 1, 1});
+  NetDef placed = t.ApplyTo(netdef);
+  ASSERT_EQ(placed.op_size(), 5);
+  ExpectOp(placed.op(0), "Relu", "X", "a", HIP, 0);
+  ExpectOp(placed.op(1), "Relu", "a", "b", HIP, 0);
+  ExpectOp(placed.op(2), "Copy", "b", "b_hip1", HIP, 1);
+  ExpectOp(placed.op(3), "Relu", "b_hip1", "c", HIP, 1);
+  ExpectOp(placed.op(4), "Relu", "c", "Y", HIP, 1);
+  EXPECT_EQ(t.device("X"), 0);
+}
+
+TEST(ModelParallelPlacementTest, TestMemoryLimit) {
+  NetDef netdef;
+  AddOp(&netdef, "Relu", {"X"}, {"a"});
+  AddOp(&netdef, "Relu", {"a"}, {"b"});
+  AddOp(&netdef, "Relu", {"b"}, {"Y"});
+  netdef.add_external_output("Y");
+
+  // Every blob takes 128 bytes, device 0 only has room for two.
+  ModelParallelPlacementTransform t(2, {300, 1000}, {{"X", {4, 8}}});
+  NetDef placed = t.ApplyTo(netdef);
+  ASSERT_EQ(placed.op_size(), 4);
+  ExpectOp(placed.op(0), "Relu", "X", "a", HIP, 0);
+  ExpectOp(placed.op(1), "Copy", "a", "a_hip1", HIP, 1);
+  ExpectOp(placed.op(2), "Relu", "a_hip1", "b", HIP, 1);
+  ExpectOp(placed.op(3), "Relu", "b", "Y", HIP, 1);
+
+  ModelParallelPlacementTransform too_small(2, {300, 200}, {{"X", {4, 8}}});
+  EXPECT_THROW(too_small.ApplyTo(netdef), EnforceNotMet);
+}
+
+TEST(ModelParallelPlacementTest, TestCopiesBackExternalOutputs) {
+  NetDef netdef;
+  AddOp(&netdef, "Relu", {"X"}, {"Y"});
+  AddOp(&netdef, "Relu", {"Y"}, {"Y"});
+  netdef.add_external_output("Y");
+
+  ModelParallelPlacementTransform t(2, {}, {}, {1, 1});
+  NetDef placed = t.ApplyTo(netdef);
+  ASSERT_EQ(placed.op_size(), 4);
+  ExpectOp(placed.op(0), "Relu", "X", "Y", HIP, 0);
+  ExpectOp(placed.op(1), "Copy", "Y", "Y_hip1", HIP, 1);
+  ExpectOp(placed.op(2), "Relu", "Y_hip1", "Y_hip1", HIP, 1);
+  ExpectOp(placed.op(3), "Copy", "Y_hip1", "Y", HIP, 0);
+}
+
+TEST(ModelParallelPlacementTest, TestKeepsCPUOps) {
+  NetDef netdef;
+  AddOp(&netdef, "Relu", {"X"}, {"a"});
+  AddOp(&netdef, "Relu", {"a"}, {"b"})
+      ->mutable_device_option()
+      ->set_device_type(CPU);
+  AddOp(&netdef, "Relu", {"b"}, {"Y"});
+  netdef.add_external_output("Y");
+
+  // The registered transform splits the net over two devices.
+  auto t = TransformRegistry()->Create("ModelParallelPlacement");
+  CHECK(t);
+  NetDef placed = t->ApplyTo(netdef);
+  ASSERT_EQ(placed.op_size(), 5);
+  ExpectOp(placed.op(0), "Relu", "X", "a", HIP, 0);
+  ExpectOp(placed.op(1), "CopyGPUToCPU", "a", "a_cpu", HIP, 0);
+  ExpectOp(placed.op(2), "Relu", "a_cpu", "b", CPU, 0);
+  ExpectOp(placed.op(3), "CopyCPUToGPU", "b", "b_hip1", HIP, 1);
+  ExpectOp(placed.op(4), "Relu", "b_hip1", "Y", HIP, 1);
+}
+
+} // namespace
+
+} // namespace caffe2
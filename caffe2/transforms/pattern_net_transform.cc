@@ -113,6 +113,12 @@ bool PatternNetTransform::PatternRule(
   }
   int p_idx = ordered_ops_[subgraph.size()];
 
+  // Every neighbor of p_idx in p_ is matched to a distinct neighbor of g_idx.
+  if (g.node(g_idx).parents.size() < p_.node(p_idx).parents.size() ||
+      g.node(g_idx).children.size() < p_.node(p_idx).children.size()) {
+    return false;
+  }
+
   if (!compare_ops(p_.node(p_idx).op, g.node(g_idx).op, argument_match_)) {
     return false;
   }
@@ -75,6 +75,15 @@ class PatternNetTransform : public Transform {
       const transform::Graph& g,
       const std::vector<int>& subgraph,
       int idx) override;
+  /**
+   * The node at position pos must match p.node(ordered_ops[pos]).type().
+   */
+  string PatternOpType(size_t pos) override {
+    if (pos >= ordered_ops_.size()) {
+      return "*";
+    }
+    return p_.node(ordered_ops_[pos]).op.type();
+  }
   /**
    * ValidatorRule for PatternNetTransform does the following:
    *
@@ -167,6 +167,52 @@ TEST(PatternNetTransformTest, TestRepeatedTransform) {
   EXPECT_EQ(200, counter.load());
 }
 
+/**
+ * P = ---> (Op1) ---> (Op2) --->
+ *
+ * R = ---> (Op3) ---> (Op3) --->
+ *
+ * On a large net, where only the Op1 nodes can start a match.
+ */
+TEST(PatternNetTransformTest, TestLargeNetTransform) {
+  const int kNumUnits = 5000;
+  NetDef netdef;
+  string blob = "in";
+  for (int i = 0; i < kNumUnits; i++) {
+    const string mid = "mid" + caffe2::to_string(i);
+    const string out = "out" + caffe2::to_string(i);
+    AddOp(&netdef, "DummyCounterOp1", {blob}, {mid});
+    AddOp(&netdef, "DummyCounterOp2", {mid}, {out});
+    AddOp(&netdef, "DummyCounterOp3", {out}, {out});
+    blob = out;
+  }
+
+  NetDef pdef;
+  AddOp(&pdef, "DummyCounterOp1", {"in"}, {"mid"});
+  AddOp(&pdef, "DummyCounterOp2", {"mid"}, {"out"});
+
+  NetDef rdef;
+  AddOp(&rdef, "DummyCounterOp3", {"in"}, {"new_mid"});
+  AddOp(&rdef, "DummyCounterOp3", {"new_mid"}, {"out"});
+
+  PatternNetTransform t(pdef, rdef);
+  Graph g(netdef);
+  auto matches = t.PatternMatch(g);
+  EXPECT_EQ(matches.size(), static_cast<size_t>(kNumUnits));
+
+  t.ReplacePattern(matches, &g);
+  NetDef replaced_netdef = g.GetNetDef();
+  EXPECT_EQ(replaced_netdef.op_size(), 3 * kNumUnits);
+  for (int i = 0; i < replaced_netdef.op_size(); i++) {
+    EXPECT_EQ(replaced_netdef.op(i).type(), "DummyCounterOp3");
+  }
+  // The units are still chained in order.
+  EXPECT_EQ(replaced_netdef.op(0).input(0), "in");
+  EXPECT_EQ(
+      replaced_netdef.op(replaced_netdef.op_size() - 1).output(0),
+      "out" + caffe2::to_string(kNumUnits - 1));
+}
+
 /**
  * P = ---> (Op1) ---> (Op3) ---> (Op2) --->
  *            |------> (Op3) -------|
@@ -143,6 +143,8 @@ class CpuId {
 #define E(name, bit) X(name, f7c_, bit)
   E(prefetchwt1, 0)
   E(avx512vbmi, 1)
+  E(avx512vnni, 11)
+  E(avx512vpopcntdq, 14)
 #undef C
 
 #undef X
@@ -20,6 +20,14 @@
 #include <cstdlib>
 #include <stdint.h>
 
+// The quotient and remainder can also be computed in device code, e.g. to
+// decompose indices in kernels. The divisor is still set up on the host.
+#if defined(__CUDACC__) || defined(__HIPCC__)
+#define FIXED_DIVISOR_DECL inline __host__ __device__
+#else
+#define FIXED_DIVISOR_DECL inline
+#endif
+
 namespace caffe2 {
 
 // Utility class for quickly calculating quotients and remainders for
@@ -34,20 +42,26 @@ class FixedDivisor {
 template <>
 class FixedDivisor<int32_t> {
  public:
+  FixedDivisor() : FixedDivisor(1) {}
+
   FixedDivisor(int32_t d) : d_(d) {
     calcSignedMagic();
   }
 
-  uint64_t getMagic() const {
+  FIXED_DIVISOR_DECL int32_t d() const {
+    return d_;
+  }
+
+  FIXED_DIVISOR_DECL uint64_t getMagic() const {
     return magic_;
   }
 
-  int getShift() const {
+  FIXED_DIVISOR_DECL int getShift() const {
     return shift_;
   }
 
   /// Calculates `q = n / d`.
-  inline int32_t div(int32_t n) const {
+  FIXED_DIVISOR_DECL int32_t div(int32_t n) const {
     // In lieu of a mulhi instruction being available, perform the
     // work in uint64
     uint64_t mul64 = magic_ * (uint64_t) n;
@@ -55,12 +69,12 @@ class FixedDivisor<int32_t> {
   }
 
   /// Calculates `r = n % d`.
-  inline int32_t mod(int32_t n) const {
+  FIXED_DIVISOR_DECL int32_t mod(int32_t n) const {
     return n - d_ * div(n);
   }
 
   /// Calculates `q = n / d` and `r = n % d` together.
-  inline void divMod(int32_t n, int32_t& q, int32_t& r) const {
+  FIXED_DIVISOR_DECL void divMod(int32_t n, int32_t& q, int32_t& r) const {
     const int32_t quotient = div(n);
     q = quotient;
     r = n - d_ * quotient;
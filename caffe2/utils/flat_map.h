@@ -0,0 +1,219 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_UTILS_FLAT_MAP_H_
+#define CAFFE2_UTILS_FLAT_MAP_H_
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace caffe2 {
+
+// An open-addressing hash map from integer keys to values, for large lookup
+// tables such as ID remapping. The slots (key and value side by side) live in
+// one power of two sized array, filled at most half, and collisions are
+// resolved by linear probing, so a lookup usually touches one cache line.
+// The smallest key value marks empty slots; that key itself is kept aside.
+//
+// Lookups are const and don't modify the map, so a map that is no longer
+// written to can be read from any number of threads, e.g. by Predictors
+// sharing the workspace holding it. LookupBatch prefetches the slots of the
+// keys a few iterations ahead, to overlap the cache misses of big maps.
+template <typename K, typename V>
+class FlatMap {
+  static_assert(std::is_integral<K>::value, "FlatMap needs integer keys");
+
+ public:
+  using key_type = K;
+  using mapped_type = V;
+
+  FlatMap() {
+    Rehash(kMinCapacity);
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  void clear() {
+    size_ = 0;
+    has_empty_key_ = false;
+    slots_.clear();
+    Rehash(kMinCapacity);
+  }
+
+  // Makes room for n entries without rehashing.
+  void reserve(size_t n) {
+    size_t capacity = kMinCapacity;
+    while (capacity < 2 * n) {
+      capacity *= 2;
+    }
+    if (capacity > slots_.size()) {
+      Rehash(capacity);
+    }
+  }
+
+  // Inserts key -> value unless key is already in the map, like
+  // std::unordered_map::emplace. Returns whether it was inserted.
+  bool emplace(const K key, const V value) {
+    if (key == kEmptyKey) {
+      if (has_empty_key_) {
+        return false;
+      }
+      has_empty_key_ = true;
+      empty_key_value_ = value;
+      ++size_;
+      return true;
+    }
+    if (2 * (size_ + 1) > slots_.size()) {
+      Rehash(2 * slots_.size());
+    }
+    size_t index = SlotIndex(key);
+    while (slots_[index].key != kEmptyKey) {
+      if (slots_[index].key == key) {
+        return false;
+      }
+      index = (index + 1) & mask_;
+    }
+    slots_[index].key = key;
+    slots_[index].value = value;
+    ++size_;
+    return true;
+  }
+
+  // Returns the value of key, or nullptr if it isn't in the map.
+  const V* Lookup(const K key) const {
+    if (key == kEmptyKey) {
+      return has_empty_key_ ? &empty_key_value_ : nullptr;
+    }
+    size_t index = SlotIndex(key);
+    while (true) {
+      const Slot& slot = slots_[index];
+      if (slot.key == key) {
+        return &slot.value;
+      }
+      if (slot.key == kEmptyKey) {
+        return nullptr;
+      }
+      index = (index + 1) & mask_;
+    }
+  }
+
+  // values[i] = value of keys[i], or default_value for the keys that aren't
+  // in the map, found[i] (if found isn't nullptr) telling which. Returns the
+  // number of keys found.
+  size_t LookupBatch(
+      const K* keys,
+      const size_t n,
+      const V default_value,
+      V* values,
+      bool* found) const {
+    size_t num_found = 0;
+    for (size_t i = 0; i < n; ++i) {
+      if (i + kPrefetchDistance < n) {
+        Prefetch(&slots_[SlotIndex(keys[i + kPrefetchDistance])]);
+      }
+      const V* value = Lookup(keys[i]);
+      values[i] = value != nullptr ? *value : default_value;
+      if (found != nullptr) {
+        found[i] = value != nullptr;
+      }
+      num_found += value != nullptr;
+    }
+    return num_found;
+  }
+
+  // Calls f(key, value) for every entry, in no particular order.
+  template <typename F>
+  void ForEach(F f) const {
+    for (const auto& slot : slots_) {
+      if (slot.key != kEmptyKey) {
+        f(slot.key, slot.value);
+      }
+    }
+    if (has_empty_key_) {
+      f(kEmptyKey, empty_key_value_);
+    }
+  }
+
+ private:
+  struct Slot {
+    K key;
+    V value;
+  };
+
+  static constexpr K kEmptyKey = std::numeric_limits<K>::min();
+  static constexpr size_t kMinCapacity = 16;
+  static constexpr size_t kPrefetchDistance = 16;
+
+  // Fibonacci hashing, the top bits of the product index the slots, so that
+  // consecutive IDs are spread over the table.
+  size_t SlotIndex(const K key) const {
+    return static_cast<size_t>(
+        (static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL) >> shift_);
+  }
+
+  static void Prefetch(const Slot* slot) {
+#if defined(__GNUC__)
+    __builtin_prefetch(slot);
+#else
+    (void)slot;
+#endif
+  }
+
+  void Rehash(const size_t capacity) {
+    std::vector<Slot> previous(capacity, Slot{kEmptyKey, V()});
+    previous.swap(slots_);
+    mask_ = capacity - 1;
+    shift_ = 64;
+    for (size_t c = capacity; c > 1; c /= 2) {
+      --shift_;
+    }
+    for (const auto& slot : previous) {
+      if (slot.key != kEmptyKey) {
+        size_t index = SlotIndex(slot.key);
+        while (slots_[index].key != kEmptyKey) {
+          index = (index + 1) & mask_;
+        }
+        slots_[index] = slot;
+      }
+    }
+  }
+
+  std::vector<Slot> slots_;
+  size_t mask_ = 0;
+  int shift_ = 64;
+  size_t size_ = 0;
+  bool has_empty_key_ = false;
+  V empty_key_value_ = V();
+};
+
+template <typename K, typename V>
+constexpr K FlatMap<K, V>::kEmptyKey;
+template <typename K, typename V>
+constexpr size_t FlatMap<K, V>::kMinCapacity;
+template <typename K, typename V>
+constexpr size_t FlatMap<K, V>::kPrefetchDistance;
+
+} // namespace caffe2
+
+#endif // CAFFE2_UTILS_FLAT_MAP_H_
@@ -0,0 +1,106 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <unordered_map>
+
+#include <gtest/gtest.h>
+#include "caffe2/utils/flat_map.h"
+
+namespace caffe2 {
+
+TEST(FlatMapTest, EmplaceAndLookup) {
+  FlatMap<int64_t, int32_t> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.emplace(3, 30));
+  EXPECT_TRUE(map.emplace(-7, 70));
+  // Existing keys are kept, like std::unordered_map::emplace.
+  EXPECT_FALSE(map.emplace(3, 31));
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_EQ(*map.Lookup(3), 30);
+  EXPECT_EQ(*map.Lookup(-7), 70);
+  EXPECT_EQ(map.Lookup(4), nullptr);
+}
+
+TEST(FlatMapTest, SmallestKey) {
+  // The smallest key marks the empty slots, it is stored aside.
+  FlatMap<int32_t, int32_t> map;
+  const int32_t smallest = std::numeric_limits<int32_t>::min();
+  EXPECT_EQ(map.Lookup(smallest), nullptr);
+  EXPECT_TRUE(map.emplace(smallest, 1));
+  EXPECT_FALSE(map.emplace(smallest, 2));
+  EXPECT_EQ(*map.Lookup(smallest), 1);
+  EXPECT_EQ(map.size(), 1);
+  int entries = 0;
+  map.ForEach([&](int32_t key, int32_t value) {
+    EXPECT_EQ(key, smallest);
+    EXPECT_EQ(value, 1);
+    ++entries;
+  });
+  EXPECT_EQ(entries, 1);
+}
+
+TEST(FlatMapTest, MatchesUnorderedMap) {
+  std::unordered_map<int64_t, int64_t> reference;
+  FlatMap<int64_t, int64_t> map;
+  uint64_t state = 12345;
+  for (int i = 0; i < 100000; ++i) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    // Few distinct keys so that some are inserted more than once.
+    const int64_t key = static_cast<int64_t>(state >> 20) % 50000 - 25000;
+    EXPECT_EQ(map.emplace(key, i), reference.emplace(key, i).second);
+  }
+  EXPECT_EQ(map.size(), reference.size());
+
+  std::vector<int64_t> keys;
+  for (int64_t key = -30000; key < 30000; ++key) {
+    keys.push_back(key);
+  }
+  std::vector<int64_t> values(keys.size());
+  std::unique_ptr<bool[]> found(new bool[keys.size()]);
+  const size_t num_found =
+      map.LookupBatch(keys.data(), keys.size(), -1, values.data(), found.get());
+  EXPECT_EQ(num_found, reference.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    auto it = reference.find(keys[i]);
+    EXPECT_EQ(found[i], it != reference.end());
+    EXPECT_EQ(values[i], it != reference.end() ? it->second : -1);
+  }
+
+  size_t entries = 0;
+  map.ForEach([&](int64_t key, int64_t value) {
+    EXPECT_EQ(reference.at(key), value);
+    ++entries;
+  });
+  EXPECT_EQ(entries, reference.size());
+
+  map.clear();
+  EXPECT_EQ(map.size(), 0);
+  EXPECT_EQ(map.Lookup(keys[0]), nullptr);
+}
+
+TEST(FlatMapTest, Reserve) {
+  FlatMap<int32_t, int64_t> map;
+  map.reserve(1000);
+  for (int32_t i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(map.emplace(i * 16, i));
+  }
+  for (int32_t i = 0; i < 1000; ++i) {
+    EXPECT_EQ(*map.Lookup(i * 16), i);
+  }
+}
+
+} // namespace caffe2
@@ -149,6 +149,36 @@ CAFFE2_DECLARE_BINARY_OP(Div);
 
 #undef CAFFE2_DECLARE_BINARY_OP
 
+// Collapses the dims of a tensor A and of a tensor B broadcast to the shape of
+// A the numpy way into the fewest dims along which B is either broadcast or
+// not, and returns the stride of B along each of them (0 where it is
+// broadcast). b_dims is aligned with the trailing dims of a_dims and every one
+// of them must be 1 or equal to the dim of A it is aligned with.
+void ComputeBroadcastStrides(
+    const std::vector<int>& a_dims,
+    const std::vector<int>& b_dims,
+    std::vector<int>* dims,
+    std::vector<int>* b_strides);
+
+// Computes y = a op b with b broadcast to the shape of a as described in
+// ComputeBroadcastStrides, without materializing the broadcast b.
+#define CAFFE2_DECLARE_BROADCAST_BINARY_OP(name) \
+  template <typename T, class Context>           \
+  void Broadcast##name(                          \
+      const std::vector<int>& a_dims,            \
+      const std::vector<int>& b_dims,            \
+      const T* a,                                \
+      const T* b,                                \
+      T* y,                                      \
+      Context* context);
+
+CAFFE2_DECLARE_BROADCAST_BINARY_OP(Add);
+CAFFE2_DECLARE_BROADCAST_BINARY_OP(Sub);
+CAFFE2_DECLARE_BROADCAST_BINARY_OP(Mul);
+CAFFE2_DECLARE_BROADCAST_BINARY_OP(Div);
+
+#undef CAFFE2_DECLARE_BROADCAST_BINARY_OP
+
 template <typename T, class Context>
 void ReduceMin(
     const int N,
@@ -268,6 +298,29 @@ void GemmBatched(
     Tensor<Context>* scratch = nullptr,
     TensorProto::DataType math_type = TensorProto_DataType_FLOAT);
 
+// GemmStridedBatched computes batch_size gemms C_i = alpha * A_i * B_i +
+// beta * C_i, where X_i starts X_stride elements after X_{i-1}. A stride of 0
+// reuses the same matrix for every gemm. On devices this is a single library
+// call. For float16, math_type FLOAT accumulates in fp32 and FLOAT16 in fp16.
+template <typename T, class Context, class Engine = DefaultEngine>
+void GemmStridedBatched(
+    const CBLAS_TRANSPOSE TransA,
+    const CBLAS_TRANSPOSE TransB,
+    const int batch_size,
+    const int M,
+    const int N,
+    const int K,
+    const float alpha,
+    const T* A,
+    const int A_stride,
+    const T* B,
+    const int B_stride,
+    const float beta,
+    T* C,
+    const int C_stride,
+    Context* context,
+    TensorProto::DataType math_type = TensorProto_DataType_FLOAT);
+
 // Gemv always takes in a M*N matrix A, and depending on whether we set TransA
 // to Trans, the output is:
 // CblasNoTrans: x is an N dim vector and y is an M dim vector.
@@ -0,0 +1,162 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_UTILS_MATH_BROADCAST_HIP_H_
+#define CAFFE2_UTILS_MATH_BROADCAST_HIP_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "caffe2/core/common_hip.h"
+#include "caffe2/core/context_hip.h"
+#include "hip/hip_runtime.h"
+
+// Kernels computing y = op(a, b) where b is broadcast to the shape of a
+// through strides, as computed by math::ComputeBroadcastStrides, instead of
+// being tiled into a full size temporary.
+namespace caffe2 {
+
+constexpr int kBroadcastMaxDims = 8;
+
+// Passed by value as a kernel argument.
+struct BroadcastStrides
+{
+    int ndim;
+    int dims[kBroadcastMaxDims];
+    int b_strides[kBroadcastMaxDims];
+};
+
+// Four consecutive elements, loaded and stored as a single vector (a float4
+// for floats).
+template <typename T>
+struct alignas(4 * sizeof(T)) Pack4
+{
+    T v[4];
+};
+
+inline __device__ int BroadcastOffset(const BroadcastStrides& s, int i)
+{
+    int offset = 0;
+    for(int d = s.ndim - 1; d >= 0; --d)
+    {
+        offset += (i % s.dims[d]) * s.b_strides[d];
+        i /= s.dims[d];
+    }
+    return offset;
+}
+
+template <typename T, typename R, class Op>
+__global__ void
+BroadcastBinaryKernel(const int n, const BroadcastStrides s, const T* a, const T* b, R* y, Op op)
+{
+    HIP_1D_KERNEL_LOOP(i, n) { y[i] = op(a[i], b[BroadcastOffset(s, i)]); }
+}
+
+// Every thread computes four consecutive elements of the innermost dim, whose
+// size must be a multiple of 4. Along it b is either contiguous, so it is
+// loaded as a vector too, or broadcast.
+template <typename T, typename R, class Op>
+__global__ void BroadcastBinaryPack4Kernel(
+    const int n4, const BroadcastStrides s, const T* a, const T* b, R* y, Op op)
+{
+    const bool b_contiguous = s.b_strides[s.ndim - 1] != 0;
+    HIP_1D_KERNEL_LOOP(i, n4)
+    {
+        const Pack4<T> va = reinterpret_cast<const Pack4<T>*>(a)[i];
+        const int offset  = BroadcastOffset(s, 4 * i);
+        Pack4<T> vb;
+        if(b_contiguous)
+        {
+            vb = *reinterpret_cast<const Pack4<T>*>(b + offset);
+        }
+        else
+        {
+            vb.v[0] = vb.v[1] = vb.v[2] = vb.v[3] = b[offset];
+        }
+        Pack4<R> vy;
+#pragma unroll
+        for(int k = 0; k < 4; ++k)
+        {
+            vy.v[k] = op(va.v[k], vb.v[k]);
+        }
+        reinterpret_cast<Pack4<R>*>(y)[i] = vy;
+    }
+}
+
+template <typename T>
+inline bool IsPack4Aligned(const T* ptr)
+{
+    return reinterpret_cast<std::uintptr_t>(ptr) % sizeof(Pack4<T>) == 0;
+}
+
+template <typename T, typename R, class Op>
+void LaunchBroadcastBinary(const std::vector<int>& dims,
+                           const std::vector<int>& b_strides,
+                           const T* a,
+                           const T* b,
+                           R* y,
+                           Op op,
+                           HIPContext* context)
+{
+    CAFFE_ENFORCE_LE(dims.size(), kBroadcastMaxDims, "Too many broadcast dims.");
+    BroadcastStrides s;
+    s.ndim = dims.size();
+    int n  = 1;
+    for(int i = 0; i < s.ndim; ++i)
+    {
+        s.dims[i]      = dims[i];
+        s.b_strides[i] = b_strides[i];
+        n *= dims[i];
+    }
+    if(n == 0)
+    {
+        return;
+    }
+    const bool b_contiguous = b_strides.back() != 0;
+    if(dims.back() % 4 == 0 && IsPack4Aligned(a) && IsPack4Aligned(y) &&
+       (!b_contiguous || IsPack4Aligned(b)))
+    {
+        hipLaunchKernelGGL((BroadcastBinaryPack4Kernel<T, R, Op>),
+                           dim3(CAFFE_GET_BLOCKS(n / 4)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context->hip_stream(),
+                           n / 4,
+                           s,
+                           a,
+                           b,
+                           y,
+                           op);
+    }
+    else
+    {
+        hipLaunchKernelGGL((BroadcastBinaryKernel<T, R, Op>),
+                           dim3(CAFFE_GET_BLOCKS(n)),
+                           dim3(CAFFE_HIP_NUM_THREADS),
+                           0,
+                           context->hip_stream(),
+                           n,
+                           s,
+                           a,
+                           b,
+                           y,
+                           op);
+    }
+}
+
+} // namespace caffe2
+
+#endif // CAFFE2_UTILS_MATH_BROADCAST_HIP_H_
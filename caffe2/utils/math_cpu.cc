@@ -64,6 +64,8 @@ namespace math {
 ////////////////////////////////////////////////////////////////////////////////
 #ifdef CAFFE2_USE_EIGEN_FOR_BLAS
 
+namespace {
+
 // Caffe2 gemm provides a simpler interface to the gemm functions, with the
 // limitation that the data has to be contiguous in memory.
 //
@@ -79,8 +81,9 @@ namespace math {
 // the matrix multiply; depending on the flags set, op(A) is equal to A or A^T
 // (transpose) if the argument TransA or TransB is set to CblasNoTrans or
 // CblasTrans, respectively, for each of A and B.
-template <>
-void Gemm<float, CPUContext>(
+//
+// Single threaded, see Gemm below for the row split.
+void SgemmSerial(
     const CBLAS_TRANSPOSE TransA,
     const CBLAS_TRANSPOSE TransB,
     const int M,
@@ -90,9 +93,7 @@ void Gemm<float, CPUContext>(
     const float* A,
     const float* B,
     const float beta,
-    float* C,
-    CPUContext* context,
-    TensorProto::DataType math_type) {
+    float* C) {
   auto C_mat = EigenMatrixMap<float>(C, N, M);
   if (beta == 0) {
     C_mat.setZero();
@@ -137,6 +138,8 @@ void Gemm<float, CPUContext>(
   }
 }
 
+} // namespace
+
 template <>
 void GemmEx<float, CPUContext>(
     const CBLAS_TRANSPOSE TransA,
@@ -292,8 +295,10 @@ CAFFE2_SPECIALIZED_AXPBY(float)
 
 #else  // CAFFE2_USE_EIGEN_FOR_BLAS
 
-template <>
-void Gemm<float, CPUContext>(
+namespace {
+
+// Single threaded, see Gemm below for the row split.
+void SgemmSerial(
     const CBLAS_TRANSPOSE TransA,
     const CBLAS_TRANSPOSE TransB,
     const int M,
@@ -303,15 +308,15 @@ void Gemm<float, CPUContext>(
     const float* A,
     const float* B,
     const float beta,
-    float* C,
-    CPUContext* /*context*/,
-    TensorProto::DataType /*math_type*/) {
+    float* C) {
   int lda = (TransA == CblasNoTrans) ? K : M;
   int ldb = (TransB == CblasNoTrans) ? N : K;
   cblas_sgemm(CblasRowMajor, TransA, TransB, M, N, K, alpha, A, lda, B, ldb,
               beta, C, N);
 }
 
+} // namespace
+
 template <>
 void GemmEx<float, CPUContext>(
     const CBLAS_TRANSPOSE TransA,
@@ -421,6 +426,55 @@ CAFFE2_SPECIALIZED_AXPBY(float, s)
 
 #endif  // CAFFE2_USE_EIGEN_FOR_BLAS
 
+namespace {
+
+// Smallest number of multiply-adds worth running on another thread, and
+// smallest number of rows of A for the GEMM to stay efficient.
+constexpr size_t kGemmMinChunkWork = 1 << 20;
+constexpr size_t kGemmMinChunkRows = 8;
+
+} // namespace
+
+// Large products with a non transposed A are split by rows of C over the
+// intra-op thread pool, see CPUContext::ParallelFor.
+template <>
+void Gemm<float, CPUContext>(
+    const CBLAS_TRANSPOSE TransA,
+    const CBLAS_TRANSPOSE TransB,
+    const int M,
+    const int N,
+    const int K,
+    const float alpha,
+    const float* A,
+    const float* B,
+    const float beta,
+    float* C,
+    CPUContext* /*context*/,
+    TensorProto::DataType /*math_type*/) {
+  const size_t row_work = static_cast<size_t>(N) * K;
+  const size_t grain = row_work == 0
+      ? M
+      : std::max(
+            (kGemmMinChunkWork + row_work - 1) / row_work, kGemmMinChunkRows);
+  if (TransA != CblasNoTrans || static_cast<size_t>(M) < 2 * grain) {
+    SgemmSerial(TransA, TransB, M, N, K, alpha, A, B, beta, C);
+    return;
+  }
+  CPUContext::ParallelFor(M, grain, [&](size_t begin, size_t end) {
+    SgemmSerial(
+        TransA,
+        TransB,
+        end - begin,
+        N,
+        K,
+        alpha,
+        A + begin * K,
+        B,
+        beta,
+        C + begin * N);
+  });
+}
+
 template <>
 void GemmBatched<float, CPUContext>(
     const CBLAS_TRANSPOSE TransA,
@@ -444,21 +498,67 @@ void GemmBatched<float, CPUContext>(
   auto a_offset = A_size / A_batches;
   auto b_offset = B_size / B_batches;
   auto y_offset = M * N;
-  // loop over matrices in the batch
-  for (int i = 0; i < A_batches; ++i) {
-    math::Gemm<float, CPUContext>(
-        TransA,
-        TransB,
-        M,
-        N,
-        K,
-        1,
-        A + a_offset * i,
-        B + b_offset * i,
-        0,
-        C + y_offset * i,
-        context);
-  }
+  // loop over matrices in the batch, spread over the intra-op threads
+  const size_t work = static_cast<size_t>(M) * N * K;
+  CPUContext::ParallelFor(
+      A_batches,
+      work == 0 ? A_batches : (kGemmMinChunkWork + work - 1) / work,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          math::Gemm<float, CPUContext>(
+              TransA,
+              TransB,
+              M,
+              N,
+              K,
+              1,
+              A + a_offset * i,
+              B + b_offset * i,
+              0,
+              C + y_offset * i,
+              context);
+        }
+      });
+}
+
+template <>
+void GemmStridedBatched<float, CPUContext>(
+    const CBLAS_TRANSPOSE TransA,
+    const CBLAS_TRANSPOSE TransB,
+    const int batch_size,
+    const int M,
+    const int N,
+    const int K,
+    const float alpha,
+    const float* A,
+    const int A_stride,
+    const float* B,
+    const int B_stride,
+    const float beta,
+    float* C,
+    const int C_stride,
+    CPUContext* context,
+    TensorProto::DataType /* math_type */) {
+  const size_t work = static_cast<size_t>(M) * N * K;
+  CPUContext::ParallelFor(
+      batch_size,
+      work == 0 ? batch_size : (kGemmMinChunkWork + work - 1) / work,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          math::Gemm<float, CPUContext>(
+              TransA,
+              TransB,
+              M,
+              N,
+              K,
+              alpha,
+              A + A_stride * i,
+              B + B_stride * i,
+              beta,
+              C + C_stride * i,
+              context);
+        }
+      });
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1175,6 +1275,29 @@ void Im2col<float, CPUContext, StorageOrder::NHWC>(
     int w_pad = -pad_l;
     for (int w = 0; w < width_col; ++w) {
       for (int ih = h_pad; ih < h_pad + dkernel_h; ih += dilation_h) {
+        if (dilation_w == 1) {
+          // The taps of a kernel row are contiguous in NHWC, copy the part
+          // inside the image at once and pad the rest with zeros.
+          const int iw_begin = std::max(w_pad, 0);
+          const int iw_end = std::min(w_pad + kernel_w, width);
+          if (ih < 0 || ih >= height || iw_begin >= iw_end) {
+            memset(data_col, 0, sizeof(float) * kernel_w * channels);
+          } else {
+            const int left = iw_begin - w_pad;
+            const int inside = iw_end - iw_begin;
+            memset(data_col, 0, sizeof(float) * left * channels);
+            memcpy(
+                data_col + left * channels,
+                data_im + (ih * width + iw_begin) * channels,
+                sizeof(float) * inside * channels);
+            memset(
+                data_col + (left + inside) * channels,
+                0,
+                sizeof(float) * (kernel_w - left - inside) * channels);
+          }
+          data_col += kernel_w * channels;
+          continue;
+        }
         for (int iw = w_pad; iw < w_pad + dkernel_w; iw += dilation_w) {
           if (ih >= 0 && ih < height && iw >= 0 && iw < width) {
             memcpy(data_col, data_im + (ih * width + iw) * channels,
@@ -1631,5 +1754,88 @@ CAFFE2_SPECIALIZED_TRANSPOSE(int)
 CAFFE2_SPECIALIZED_TRANSPOSE(long)
 #undef CAFFE2_SPECIALIZED_TRANSPOSE
 
+void ComputeBroadcastStrides(
+    const std::vector<int>& a_dims,
+    const std::vector<int>& b_dims,
+    std::vector<int>* dims,
+    std::vector<int>* b_strides) {
+  CAFFE_ENFORCE_LE(
+      b_dims.size(),
+      a_dims.size(),
+      "The broadcast tensor cannot have more dims than the other one.");
+  const int offset = a_dims.size() - b_dims.size();
+  std::vector<bool> broadcast;
+  dims->clear();
+  for (int i = 0; i < a_dims.size(); ++i) {
+    const int b_dim = i < offset ? 1 : b_dims[i - offset];
+    CAFFE_ENFORCE(
+        b_dim == 1 || b_dim == a_dims[i], "Broadcast dimension mismatch.");
+    if (a_dims[i] == 1) {
+      continue;
+    }
+    const bool is_broadcast = b_dim == 1;
+    if (!dims->empty() && broadcast.back() == is_broadcast) {
+      dims->back() *= a_dims[i];
+    } else {
+      dims->push_back(a_dims[i]);
+      broadcast.push_back(is_broadcast);
+    }
+  }
+  if (dims->empty()) {
+    dims->push_back(1);
+    broadcast.push_back(false);
+  }
+  b_strides->resize(dims->size());
+  int stride = 1;
+  for (int i = dims->size() - 1; i >= 0; --i) {
+    (*b_strides)[i] = broadcast[i] ? 0 : stride;
+    if (!broadcast[i]) {
+      stride *= (*dims)[i];
+    }
+  }
+}
+
+#define CAFFE2_SPECIALIZED_BROADCAST_BINARY_OP(T, name, expr)        \
+  template <>                                                        \
+  void Broadcast##name<T, CPUContext>(                               \
+      const std::vector<int>& a_dims,                                \
+      const std::vector<int>& b_dims,                                \
+      const T* a,                                                    \
+      const T* b,                                                    \
+      T* y,                                                          \
+      CPUContext* /* context */) {                                   \
+    std::vector<int> dims;                                           \
+    std::vector<int> b_strides;                                      \
+    ComputeBroadcastStrides(a_dims, b_dims, &dims, &b_strides);      \
+    const int inner = dims.back();                                   \
+    const int inner_stride = b_strides.back();                       \
+    const int ndim = dims.size();                                    \
+    std::vector<int> index(ndim, 0);                                 \
+    int size = 1;                                                    \
+    for (const int dim : dims) {                                     \
+      size *= dim;                                                   \
+    }                                                                \
+    for (int row = 0; row < size; row += inner) {                    \
+      int b_offset = 0;                                              \
+      for (int i = 0; i < ndim - 1; ++i) {                           \
+        b_offset += index[i] * b_strides[i];                         \
+      }                                                              \
+      for (int j = 0; j < inner; ++j) {                              \
+        y[row + j] = a[row + j] expr b[b_offset + j * inner_stride]; \
+      }                                                              \
+      for (int i = ndim - 2; i >= 0; --i) {                          \
+        if (++index[i] < dims[i]) {                                  \
+          break;                                                     \
+        }                                                            \
+        index[i] = 0;                                                \
+      }                                                              \
+    }                                                                \
+  }
+CAFFE2_SPECIALIZED_BROADCAST_BINARY_OP(float, Add, +)
+CAFFE2_SPECIALIZED_BROADCAST_BINARY_OP(float, Sub, -)
+CAFFE2_SPECIALIZED_BROADCAST_BINARY_OP(float, Mul, *)
+CAFFE2_SPECIALIZED_BROADCAST_BINARY_OP(float, Div, /)
+#undef CAFFE2_SPECIALIZED_BROADCAST_BINARY_OP
+
 } // namespace math
 } // namespace caffe2
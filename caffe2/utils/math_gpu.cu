@@ -511,6 +511,143 @@ void GemmBatched<float16, CUDAContext>(
 #endif
 }
 
+template <>
+void GemmStridedBatched<float, CUDAContext>(
+    const CBLAS_TRANSPOSE TransA,
+    const CBLAS_TRANSPOSE TransB,
+    const int batch_size,
+    const int M,
+    const int N,
+    const int K,
+    const float alpha,
+    const float* A,
+    const int A_stride,
+    const float* B,
+    const int B_stride,
+    const float beta,
+    float* C,
+    const int C_stride,
+    CUDAContext* context,
+    TensorProto::DataType math_type) {
+#if __CUDACC_VER_MAJOR__ < 8
+  // loop over matrices in the batch
+  for (int i = 0; i < batch_size; ++i) {
+    math::Gemm<float, CUDAContext>(
+        TransA,
+        TransB,
+        M,
+        N,
+        K,
+        alpha,
+        A + A_stride * i,
+        B + B_stride * i,
+        beta,
+        C + C_stride * i,
+        context);
+  }
+#else
+  // Note that cublas follows fortran order, so the order is different from
+  // the cblas convention.
+  int lda = (TransA == CblasNoTrans) ? K : M;
+  int ldb = (TransB == CblasNoTrans) ? N : K;
+  cublasOperation_t cuTransA =
+      (TransA == CblasNoTrans) ? CUBLAS_OP_N : CUBLAS_OP_T;
+  cublasOperation_t cuTransB =
+      (TransB == CblasNoTrans) ? CUBLAS_OP_N : CUBLAS_OP_T;
+  CUBLAS_ENFORCE(cublasSgemmStridedBatched(
+      context->cublas_handle(),
+      cuTransB,
+      cuTransA,
+      N,
+      M,
+      K,
+      &alpha,
+      B,
+      ldb,
+      B_stride,
+      A,
+      lda,
+      A_stride,
+      &beta,
+      C,
+      N,
+      C_stride,
+      batch_size));
+#endif
+}
+
+template <>
+void GemmStridedBatched<float16, CUDAContext>(
+    const CBLAS_TRANSPOSE TransA,
+    const CBLAS_TRANSPOSE TransB,
+    const int batch_size,
+    const int M,
+    const int N,
+    const int K,
+    const float alpha,
+    const float16* A,
+    const int A_stride,
+    const float16* B,
+    const int B_stride,
+    const float beta,
+    float16* C,
+    const int C_stride,
+    CUDAContext* context,
+    TensorProto::DataType math_type) {
+#if __CUDACC_VER_MAJOR__ >= 8
+  if (math_type == TensorProto_DataType_FLOAT16) {
+    // Note that cublas follows fortran order, so the order is different from
+    // the cblas convention.
+    int lda = (TransA == CblasNoTrans) ? K : M;
+    int ldb = (TransB == CblasNoTrans) ? N : K;
+    cublasOperation_t cuTransA =
+        (TransA == CblasNoTrans) ? CUBLAS_OP_N : CUBLAS_OP_T;
+    cublasOperation_t cuTransB =
+        (TransB == CblasNoTrans) ? CUBLAS_OP_N : CUBLAS_OP_T;
+
+    // convert alpha, beta from float -> __half
+    auto alpha_fp16 = convert::floatToHalf(alpha);
+    auto beta_fp16 = convert::floatToHalf(beta);
+    CUBLAS_ENFORCE(cublasHgemmStridedBatched(
+        context->cublas_handle(),
+        cuTransB,
+        cuTransA,
+        N,
+        M,
+        K,
+        &alpha_fp16,
+        (const __half*)B,
+        ldb,
+        B_stride,
+        (const __half*)A,
+        lda,
+        A_stride,
+        &beta_fp16,
+        (__half*)C,
+        N,
+        C_stride,
+        batch_size));
+    return;
+  }
+#endif
+  // fp32 accumulation: loop over matrices in the batch
+  for (int i = 0; i < batch_size; ++i) {
+    math::Gemm<float16, CUDAContext>(
+        TransA,
+        TransB,
+        M,
+        N,
+        K,
+        alpha,
+        A + A_stride * i,
+        B + B_stride * i,
+        beta,
+        C + C_stride * i,
+        context,
+        math_type);
+  }
+}
+
 #if CUDA_VERSION >= 9000
 
 // No change, but required. Defer to default CUDA engine
@@ -679,6 +816,80 @@ void GemmBatched<float16, CUDAContext, TensorCoreEngine>(
       math_type);
 }
 
+template <>
+void GemmStridedBatched<float, CUDAContext, TensorCoreEngine>(
+    const CBLAS_TRANSPOSE TransA,
+    const CBLAS_TRANSPOSE TransB,
+    const int batch_size,
+    const int M,
+    const int N,
+    const int K,
+    const float alpha,
+    const float* A,
+    const int A_stride,
+    const float* B,
+    const int B_stride,
+    const float beta,
+    float* C,
+    const int C_stride,
+    CUDAContext* context,
+    TensorProto::DataType math_type) {
+  return GemmStridedBatched<float, CUDAContext, DefaultEngine>(
+      TransA,
+      TransB,
+      batch_size,
+      M,
+      N,
+      K,
+      alpha,
+      A,
+      A_stride,
+      B,
+      B_stride,
+      beta,
+      C,
+      C_stride,
+      context,
+      math_type);
+}
+
+template <>
+void GemmStridedBatched<float16, CUDAContext, TensorCoreEngine>(
+    const CBLAS_TRANSPOSE TransA,
+    const CBLAS_TRANSPOSE TransB,
+    const int batch_size,
+    const int M,
+    const int N,
+    const int K,
+    const float alpha,
+    const float16* A,
+    const int A_stride,
+    const float16* B,
+    const int B_stride,
+    const float beta,
+    float16* C,
+    const int C_stride,
+    CUDAContext* context,
+    TensorProto::DataType math_type) {
+  return GemmStridedBatched<float16, CUDAContext, DefaultEngine>(
+      TransA,
+      TransB,
+      batch_size,
+      M,
+      N,
+      K,
+      alpha,
+      A,
+      A_stride,
+      B,
+      B_stride,
+      beta,
+      C,
+      C_stride,
+      context,
+      math_type);
+}
+
 #endif // CUDA_VERSION >= 9000
 
 template <>
@@ -2,8 +2,10 @@
 #include "hip/hip_runtime.h"
 
 #include "caffe2/core/context_hip.h"
+#include "caffe2/core/kernel_autotune_hip.h"
 #include "caffe2/utils/conversions.h"
 #include "caffe2/utils/math.h"
+#include "caffe2/utils/math_broadcast_hip.h"
 
 #include <hipcub/hipcub.hpp>
 #include <cfloat>
@@ -22,14 +24,20 @@ namespace math {
     template <>                                                                      \
     void Funcname<T, HIPContext>(const int N, const T* x, T* y, HIPContext* context) \
     {                                                                                \
-        hipLaunchKernelGGL((_Kernel_##T##_##Funcname),                               \
-                           CAFFE_GET_BLOCKS(N),                                      \
-                           CAFFE_HIP_NUM_THREADS,                                    \
-                           0,                                                        \
-                           context->hip_stream(),                                    \
-                           N,                                                        \
-                           x,                                                        \
-                           y);                                                       \
+        HipTunedLaunch(#Funcname "_" #T,                                             \
+                       N,                                                            \
+                       context->hip_stream(),                                        \
+                       x != y,                                                       \
+                       [&](const HipLaunchConfig& config) {                          \
+                           hipLaunchKernelGGL((_Kernel_##T##_##Funcname),            \
+                                              config.blocks(N),                      \
+                                              config.threads,                        \
+                                              0,                                     \
+                                              context->hip_stream(),                 \
+                                              N,                                     \
+                                              x,                                     \
+                                              y);                                    \
+                       });                                                           \
     }
 
 DELEGATE_SIMPLE_HIP_UNARY_FUNCTION(float, Exp, expf);
@@ -82,15 +90,21 @@ DELEGATE_SINCOS_HIP_FUNCTION(double, sincos)
     template <>                                                                                  \
     void Funcname<T, HIPContext>(const int N, const T* a, const T* b, T* y, HIPContext* context) \
     {                                                                                            \
-        hipLaunchKernelGGL((_Kernel_##T##_##Funcname),                                           \
-                           CAFFE_GET_BLOCKS(N),                                                  \
-                           CAFFE_HIP_NUM_THREADS,                                                \
-                           0,                                                                    \
-                           context->hip_stream(),                                                \
-                           N,                                                                    \
-                           a,                                                                    \
-                           b,                                                                    \
-                           y);                                                                   \
+        HipTunedLaunch(#Funcname "_" #T,                                                         \
+                       N,                                                                        \
+                       context->hip_stream(),                                                    \
+                       y != a && y != b,                                                         \
+                       [&](const HipLaunchConfig& config) {                                      \
+                           hipLaunchKernelGGL((_Kernel_##T##_##Funcname),                        \
+                                              config.blocks(N),                                  \
+                                              config.threads,                                    \
+                                              0,                                                 \
+                                              context->hip_stream(),                             \
+                                              N,                                                 \
+                                              a,                                                 \
+                                              b,                                                 \
+                                              y);                                                \
+                       });                                                                       \
     }
 
 DELEGATE_SIMPLE_HIP_BINARY_INFIX_FUNCTION(float, Add, +);
@@ -106,6 +120,32 @@ DELEGATE_SIMPLE_HIP_BINARY_INFIX_FUNCTION(float16, Div, /);
 
 #undef DELEGATE_SIMPLE_HIP_BINARY_INFIX_FUNCTION
 
+#define DELEGATE_BROADCAST_HIP_BINARY_INFIX_FUNCTION(T, Funcname, expr)                         \
+    struct _Functor_##T##_##Funcname                                                            \
+    {                                                                                           \
+        inline __device__ T operator()(const T a, const T b) const { return a expr b; }         \
+    };                                                                                          \
+    template <>                                                                                 \
+    void Broadcast##Funcname<T, HIPContext>(const std::vector<int>& a_dims,                     \
+                                            const std::vector<int>& b_dims,                     \
+                                            const T* a,                                         \
+                                            const T* b,                                         \
+                                            T* y,                                               \
+                                            HIPContext* context)                                \
+    {                                                                                           \
+        std::vector<int> dims;                                                                  \
+        std::vector<int> b_strides;                                                             \
+        ComputeBroadcastStrides(a_dims, b_dims, &dims, &b_strides);                             \
+        LaunchBroadcastBinary(dims, b_strides, a, b, y, _Functor_##T##_##Funcname(), context);  \
+    }
+
+DELEGATE_BROADCAST_HIP_BINARY_INFIX_FUNCTION(float, Add, +);
+DELEGATE_BROADCAST_HIP_BINARY_INFIX_FUNCTION(float, Sub, -);
+DELEGATE_BROADCAST_HIP_BINARY_INFIX_FUNCTION(float, Mul, *);
+DELEGATE_BROADCAST_HIP_BINARY_INFIX_FUNCTION(float, Div, /);
+
+#undef DELEGATE_BROADCAST_HIP_BINARY_INFIX_FUNCTION
+
 #define DELEGATE_SIMPLE_HIP_BINARY_PREFIX_FUNCTION(T, Funcname, func)                            \
     __global__ void _Kernel_##T##_##Funcname(const int N, const T* a, const T* b, T* y)          \
     {                                                                                            \
@@ -195,6 +235,143 @@ void Gemm<float, HIPContext>(const CBLAS_TRANSPOSE TransA,
                                   N));
 }
 
+template <>
+void GemmStridedBatched<float, HIPContext>(const CBLAS_TRANSPOSE TransA,
+                                           const CBLAS_TRANSPOSE TransB,
+                                           const int batch_size,
+                                           const int M,
+                                           const int N,
+                                           const int K,
+                                           const float alpha,
+                                           const float* A,
+                                           const int A_stride,
+                                           const float* B,
+                                           const int B_stride,
+                                           const float beta,
+                                           float* C,
+                                           const int C_stride,
+                                           HIPContext* context,
+                                           TensorProto::DataType math_type)
+{
+    // Note that rocblas follows fortran order, so the order is different from
+    // the cblas convention.
+    int lda = (TransA == CblasNoTrans) ? K : M;
+    int ldb = (TransB == CblasNoTrans) ? N : K;
+    rocblas_operation rocTransA =
+        (TransA == CblasNoTrans) ? rocblas_operation_none : rocblas_operation_transpose;
+    rocblas_operation rocTransB =
+        (TransB == CblasNoTrans) ? rocblas_operation_none : rocblas_operation_transpose;
+    ROCBLAS_ENFORCE(rocblas_sgemm_strided_batched(context->get_rocblas_handle(),
+                                                  rocTransB,
+                                                  rocTransA,
+                                                  N,
+                                                  M,
+                                                  K,
+                                                  &alpha,
+                                                  B,
+                                                  ldb,
+                                                  B_stride,
+                                                  A,
+                                                  lda,
+                                                  A_stride,
+                                                  &beta,
+                                                  C,
+                                                  N,
+                                                  C_stride,
+                                                  batch_size));
+}
+
+template <>
+void GemmStridedBatched<float16, HIPContext>(const CBLAS_TRANSPOSE TransA,
+                                             const CBLAS_TRANSPOSE TransB,
+                                             const int batch_size,
+                                             const int M,
+                                             const int N,
+                                             const int K,
+                                             const float alpha,
+                                             const float16* A,
+                                             const int A_stride,
+                                             const float16* B,
+                                             const int B_stride,
+                                             const float beta,
+                                             float16* C,
+                                             const int C_stride,
+                                             HIPContext* context,
+                                             TensorProto::DataType math_type)
+{
+    // Note that rocblas follows fortran order, so the order is different from
+    // the cblas convention.
+    int lda = (TransA == CblasNoTrans) ? K : M;
+    int ldb = (TransB == CblasNoTrans) ? N : K;
+    rocblas_operation rocTransA =
+        (TransA == CblasNoTrans) ? rocblas_operation_none : rocblas_operation_transpose;
+    rocblas_operation rocTransB =
+        (TransB == CblasNoTrans) ? rocblas_operation_none : rocblas_operation_transpose;
+    if(math_type == TensorProto_DataType_FLOAT)
+    {
+        // fp16 storage, fp32 accumulation; alpha and beta are given in the
+        // compute type.
+        ROCBLAS_ENFORCE(rocblas_gemm_strided_batched_ex(context->get_rocblas_handle(),
+                                                        rocTransB,
+                                                        rocTransA,
+                                                        N,
+                                                        M,
+                                                        K,
+                                                        &alpha,
+                                                        B,
+                                                        rocblas_datatype_f16_r,
+                                                        ldb,
+                                                        B_stride,
+                                                        A,
+                                                        rocblas_datatype_f16_r,
+                                                        lda,
+                                                        A_stride,
+                                                        &beta,
+                                                        C,
+                                                        rocblas_datatype_f16_r,
+                                                        N,
+                                                        C_stride,
+                                                        C,
+                                                        rocblas_datatype_f16_r,
+                                                        N,
+                                                        C_stride,
+                                                        batch_size,
+                                                        rocblas_datatype_f32_r,
+                                                        rocblas_gemm_algo_standard,
+                                                        0,
+                                                        0));
+    }
+    else if(math_type == TensorProto_DataType_FLOAT16)
+    {
+        // convert alpha, beta from float -> half
+        const float16 alpha_fp16 = convert::cpu_float2half_rn(alpha);
+        const float16 beta_fp16  = convert::cpu_float2half_rn(beta);
+        ROCBLAS_ENFORCE(
+            rocblas_hgemm_strided_batched(context->get_rocblas_handle(),
+                                          rocTransB,
+                                          rocTransA,
+                                          N,
+                                          M,
+                                          K,
+                                          reinterpret_cast<const rocblas_half*>(&alpha_fp16),
+                                          reinterpret_cast<const rocblas_half*>(B),
+                                          ldb,
+                                          B_stride,
+                                          reinterpret_cast<const rocblas_half*>(A),
+                                          lda,
+                                          A_stride,
+                                          reinterpret_cast<const rocblas_half*>(&beta_fp16),
+                                          reinterpret_cast<rocblas_half*>(C),
+                                          N,
+                                          C_stride,
+                                          batch_size));
+    }
+    else
+    {
+        CAFFE_THROW("Unsupported math type");
+    }
+}
+
 template <>
 void Gemm<float16, HIPContext>(const CBLAS_TRANSPOSE TransA,
                                const CBLAS_TRANSPOSE TransB,
@@ -209,62 +386,23 @@ void Gemm<float16, HIPContext>(const CBLAS_TRANSPOSE TransA,
                                HIPContext* context,
                                TensorProto::DataType math_type)
 {
-    CAFFE_THROW("Unsupported math type");
-#if 0 // Ashish TBD: rocblas for half not supported
-  // Note that cublas follows fortran order, so the order is different from
-  // the cblas convention.
-  int lda = (TransA == CblasNoTrans) ? K : M;
-  int ldb = (TransB == CblasNoTrans) ? N : K;
-  cublasOperation_t cuTransA =
-      (TransA == CblasNoTrans) ? CUBLAS_OP_N : CUBLAS_OP_T;
-  cublasOperation_t cuTransB =
-      (TransB == CblasNoTrans) ? CUBLAS_OP_N : CUBLAS_OP_T;
-  if (math_type == TensorProto_DataType_FLOAT) {
-    CUBLAS_CHECK(cublasSgemmEx(
-        context->cublas_handle(),
-        cuTransB,
-        cuTransA,
-        N,
-        M,
-        K,
-        &alpha,
-        B,
-        CUDA_R_16F,
-        ldb,
-        A,
-        CUDA_R_16F,
-        lda,
-        &beta,
-        C,
-        CUDA_R_16F,
-        N));
-
-  } else if (math_type == TensorProto_DataType_FLOAT16) {
-    // convert alpha, beta from float -> __half
-    auto alpha_fp16 = convert::floatToHalf(alpha);
-    auto beta_fp16 = convert::floatToHalf(beta);
-
-    // call cublasHgemm
-    CUBLAS_CHECK(cublasHgemm(
-        context->cublas_handle(),
-        cuTransB,
-        cuTransA,
-        N,
-        M,
-        K,
-        &alpha_fp16,
-        (const __half*)B,
-        ldb,
-        (const __half*)A,
-        lda,
-        &beta_fp16,
-        (__half*)C,
-        N));
-  } else {
-    // fail
-    CAFFE_THROW("Unsupported math type");
-  }
-#endif
+    // A single gemm is a batch of one.
+    GemmStridedBatched<float16, HIPContext>(TransA,
+                                            TransB,
+                                            1,
+                                            M,
+                                            N,
+                                            K,
+                                            alpha,
+                                            A,
+                                            0,
+                                            B,
+                                            0,
+                                            beta,
+                                            C,
+                                            0,
+                                            context,
+                                            math_type);
 }
 
 template <>
@@ -286,33 +424,22 @@ void GemmBatched<float, HIPContext>(const CBLAS_TRANSPOSE TransA,
                                     Tensor<HIPContext>* scratch,
                                     TensorProto::DataType math_type)
 {
-    // Note that cublas follows fortran order, so the order is different from
-    // the cblas convention.
-    int lda = (TransA == CblasNoTrans) ? K : M;
-    int ldb = (TransB == CblasNoTrans) ? N : K;
-
-    rocblas_operation rocTransA =
-        (TransA == CblasNoTrans) ? rocblas_operation_none : rocblas_operation_transpose;
-    rocblas_operation rocTransB =
-        (TransB == CblasNoTrans) ? rocblas_operation_none : rocblas_operation_transpose;
-    ROCBLAS_ENFORCE(rocblas_sgemm_strided_batched(context->get_rocblas_handle(),
-                                                  rocTransB,
-                                                  rocTransA,
-                                                  N,
-                                                  M,
-                                                  K,
-                                                  &alpha,
-                                                  B,
-                                                  ldb,
-                                                  B_size / B_batches, // B stride
-                                                  A,
-                                                  lda,
-                                                  A_size / A_batches, // A stride
-                                                  &beta,
-                                                  C,
-                                                  N,
-                                                  M * N, // C stride
-                                                  A_batches));
+    GemmStridedBatched<float, HIPContext>(TransA,
+                                          TransB,
+                                          A_batches,
+                                          M,
+                                          N,
+                                          K,
+                                          alpha,
+                                          A,
+                                          A_size / A_batches,
+                                          B,
+                                          B_size / B_batches,
+                                          beta,
+                                          C,
+                                          M * N,
+                                          context,
+                                          math_type);
 }
 
 namespace {
@@ -350,8 +477,9 @@ void GemmBatched<float16, HIPContext>(const CBLAS_TRANSPOSE TransA,
 
     // 3 options:
     // 1) scratch != null = cast to fp32, SgemmStridedBatched, cast result to fp16
-    // 2) math_type == FLOAT, scratch == nullptr = looped SgemmEx
-    // 3) math_type == FLOAT16, scratch == nullptr = batched Hgemm
+    // 2) math_type == FLOAT, scratch == nullptr = strided batched gemm_ex with
+    //    fp32 accumulation
+    // 3) math_type == FLOAT16, scratch == nullptr = strided batched Hgemm
 
     if(scratch != nullptr)
     {
@@ -413,7 +541,22 @@ void GemmBatched<float16, HIPContext>(const CBLAS_TRANSPOSE TransA,
     }
     else
     {
-        CAFFE_THROW("Unsupported math type");
+        GemmStridedBatched<float16, HIPContext>(TransA,
+                                                TransB,
+                                                A_batches,
+                                                M,
+                                                N,
+                                                K,
+                                                alpha,
+                                                A,
+                                                A_size / A_batches,
+                                                B,
+                                                B_size / B_batches,
+                                                beta,
+                                                C,
+                                                M * N,
+                                                context,
+                                                math_type);
     }
 }
 
@@ -526,60 +669,11 @@ void Gemv<float16, HIPContext>(const CBLAS_TRANSPOSE TransA,
                                HIPContext* context,
                                TensorProto::DataType math_type)
 {
-    CAFFE_THROW("Unsupported math type");
-#if 0 // Ashish TBD: fp16 for rocblas
-  cublasOperation_t cuTransA =
-      (TransA == CblasNoTrans) ? CUBLAS_OP_T : CUBLAS_OP_N;
-
-  // sort out what we need to call cublasSgemmEx / cublasHgemm
-  int m = (cuTransA == CUBLAS_OP_N) ? N : M;
-  int k = (cuTransA == CUBLAS_OP_N) ? M : N;
-  int LDA = (cuTransA == CUBLAS_OP_N) ? m : k;
-  int LDC = m;
-
-  if (math_type == TensorProto_DataType_FLOAT) {
-    CUBLAS_CHECK(cublasSgemmEx(
-        context->cublas_handle(),
-        cuTransA,
-        CUBLAS_OP_N,
-        m,
-        1,
-        k,
-        &alpha,
-        A,
-        CUDA_R_16F,
-        LDA,
-        x,
-        CUDA_R_16F,
-        k,
-        &beta,
-        y,
-        CUDA_R_16F,
-        LDC));
-  } else if (math_type == TensorProto_DataType_FLOAT16) {
-    auto alpha_fp16 = convert::floatToHalf(alpha);
-    auto beta_fp16 = convert::floatToHalf(beta);
-
-    CUBLAS_CHECK(cublasHgemm(
-        context->cublas_handle(),
-        cuTransA,
-        CUBLAS_OP_N,
-        m,
-        1,
-        k,
-        &alpha_fp16,
-        (const __half*)A,
-        LDA,
-        (const __half*)x,
-        k,
-        &beta_fp16,
-        (__half*)y,
-        LDC));
-  } else {
-    // fail
-    CAFFE_THROW("Unsupported math type");
-  }
-#endif
+    // y is a single column gemm: A * x for CblasNoTrans, A' * x for CblasTrans.
+    const int m = (TransA == CblasNoTrans) ? M : N;
+    const int k = (TransA == CblasNoTrans) ? N : M;
+    Gemm<float16, HIPContext>(
+        TransA, CblasNoTrans, m, 1, k, alpha, A, x, beta, y, context, math_type);
 }
 
 namespace {
@@ -116,6 +116,27 @@ TEST(MathTest, GemmNoTransTrans) {
   }
 }
 
+TEST(MathTest, GemmStridedBatched) {
+  DeviceOption option;
+  CPUContext cpu_context(option);
+  // Three batches of X (2x3) times the same W (3x4), W has a stride of 0.
+  TensorCPU X(std::vector<int>{3, 2, 3});
+  TensorCPU W(std::vector<int>{3, 4});
+  TensorCPU Y(std::vector<int>{3, 2, 4});
+  for (int i = 0; i < X.size(); ++i) {
+    X.mutable_data<float>()[i] = i / 6;
+  }
+  math::Set<float, CPUContext>(W.size(), 1, W.mutable_data<float>(), &cpu_context);
+  math::Set<float, CPUContext>(Y.size(), 1, Y.mutable_data<float>(), &cpu_context);
+  math::GemmStridedBatched<float, CPUContext>(
+      CblasNoTrans, CblasNoTrans, 3, 2, 4, 3, 2.0f, X.data<float>(), 6,
+      W.data<float>(), 0, 0.5f, Y.mutable_data<float>(), 8, &cpu_context);
+  for (int i = 0; i < Y.size(); ++i) {
+    // batch b sums three b's, times 2, plus half of the initial 1.
+    CHECK_EQ(Y.data<float>()[i], 2 * 3 * (i / 8) + 0.5f) << i;
+  }
+}
+
 TEST(MathTest, GemvNoTrans) {
   DeviceOption option;
   CPUContext cpu_context(option);
@@ -295,4 +316,55 @@ TEST(MathTest, TranposeTest) {
   }
 }
 
+TEST(MathTest, ComputeBroadcastStrides) {
+  std::vector<int> dims;
+  std::vector<int> b_strides;
+  math::ComputeBroadcastStrides({2, 3, 4}, {3, 4}, &dims, &b_strides);
+  EXPECT_EQ(dims, (std::vector<int>{2, 12}));
+  EXPECT_EQ(b_strides, (std::vector<int>{0, 1}));
+
+  math::ComputeBroadcastStrides({2, 3, 4, 5}, {3, 1, 5}, &dims, &b_strides);
+  EXPECT_EQ(dims, (std::vector<int>{2, 3, 4, 5}));
+  EXPECT_EQ(b_strides, (std::vector<int>{0, 5, 0, 1}));
+
+  // Dims of size 1 in A disappear.
+  math::ComputeBroadcastStrides({2, 1, 4, 5}, {2, 1, 1, 5}, &dims, &b_strides);
+  EXPECT_EQ(dims, (std::vector<int>{2, 4, 5}));
+  EXPECT_EQ(b_strides, (std::vector<int>{5, 0, 1}));
+}
+
+TEST(MathTest, BroadcastAdd) {
+  DeviceOption option;
+  CPUContext cpu_context(option);
+  // Broadcast B 3x1x5 to A 2x3x4x5.
+  TensorCPU A(std::vector<int>{2, 3, 4, 5});
+  TensorCPU B(std::vector<int>{3, 1, 5});
+  TensorCPU Y(std::vector<int>{2, 3, 4, 5});
+  for (int i = 0; i < A.size(); ++i) {
+    A.mutable_data<float>()[i] = static_cast<float>(i);
+  }
+  for (int i = 0; i < B.size(); ++i) {
+    B.mutable_data<float>()[i] = static_cast<float>(1000 * i);
+  }
+  math::BroadcastAdd<float, CPUContext>(
+      {2, 3, 4, 5},
+      {3, 1, 5},
+      A.data<float>(),
+      B.data<float>(),
+      Y.mutable_data<float>(),
+      &cpu_context);
+  for (int n = 0; n < 2; ++n) {
+    for (int c = 0; c < 3; ++c) {
+      for (int h = 0; h < 4; ++h) {
+        for (int w = 0; w < 5; ++w) {
+          const int i = ((n * 3 + c) * 4 + h) * 5 + w;
+          EXPECT_FLOAT_EQ(
+              A.data<float>()[i] + B.data<float>()[c * 5 + w],
+              Y.data<float>()[i]);
+        }
+      }
+    }
+  }
+}
+
 } // namespace caffe2
@@ -234,6 +234,48 @@ bool ArgumentHelper::HasArgument(const string& name) const {
   return arg_map_.count(name);
 }
 
+const Argument* ArgumentHelper::FindArgument(
+    const OperatorDef& def,
+    const string& name) {
+  const Argument* found = nullptr;
+  for (const auto& arg : def.arg()) {
+    if (arg.name() != name) {
+      continue;
+    }
+    if (found) {
+      if (arg.SerializeAsString() != found->SerializeAsString()) {
+        CAFFE_THROW(
+            "Found argument of the same name ",
+            arg.name(),
+            "but with different contents.",
+            ProtoDebugString(def));
+      } else {
+        LOG(WARNING) << "Duplicated argument name [" << arg.name()
+                     << "] found in operator def: " << ProtoDebugString(def);
+      }
+    }
+    found = &arg;
+  }
+  return found;
+}
+
+const Argument* ArgumentHelper::FindArgument(
+    const NetDef& def,
+    const string& name) {
+  const Argument* found = nullptr;
+  for (const auto& arg : def.arg()) {
+    if (arg.name() != name) {
+      continue;
+    }
+    CAFFE_ENFORCE(
+        found == nullptr,
+        "Duplicated argument name [", arg.name(), "] found in net def: ",
+        ProtoDebugString(def));
+    found = &arg;
+  }
+  return found;
+}
+
 namespace {
 // Helper function to verify that conversion between types won't loose any
 // significant bit.
@@ -256,18 +298,18 @@ std::ostream& operator<<(std::ostream& output, const NetDef& n) {
     T, fieldname, enforce_lossless_conversion)                                \
   template <>                                                                 \
   T ArgumentHelper::GetSingleArgument<T>(                                     \
-      const string& name, const T& default_value) const {                     \
-    if (arg_map_.count(name) == 0) {                                          \
+      const Argument* arg, const string& name, const T& default_value) {      \
+    if (arg == nullptr) {                                                     \
       VLOG(1) << "Using default parameter value " << default_value            \
               << " for parameter " << name;                                   \
       return default_value;                                                   \
     }                                                                         \
     CAFFE_ENFORCE(                                                            \
-        arg_map_.at(name).has_##fieldname(),                                  \
+        arg->has_##fieldname(),                                               \
         "Argument ",                                                          \
         name,                                                                 \
         " does not have the right field: expected field " #fieldname);        \
-    auto value = arg_map_.at(name).fieldname();                               \
+    auto value = arg->fieldname();                                            \
     if (enforce_lossless_conversion) {                                        \
       auto supportsConversion =                                               \
           SupportsLosslessConversion<decltype(value), T>(value);              \
@@ -282,11 +324,8 @@ std::ostream& operator<<(std::ostream& output, const NetDef& n) {
     return static_cast<T>(value);                                             \
   }                                                                           \
   template <>                                                                 \
-  bool ArgumentHelper::HasSingleArgumentOfType<T>(const string& name) const { \
-    if (arg_map_.count(name) == 0) {                                          \
-      return false;                                                           \
-    }                                                                         \
-    return arg_map_.at(name).has_##fieldname();                               \
+  bool ArgumentHelper::HasSingleArgumentOfType<T>(const Argument* arg) {      \
+    return arg != nullptr && arg->has_##fieldname();                          \
   }
 
 INSTANTIATE_GET_SINGLE_ARGUMENT(float, f, false)
@@ -307,12 +346,15 @@ INSTANTIATE_GET_SINGLE_ARGUMENT(NetDef, n, false)
     T, fieldname, enforce_lossless_conversion)                         \
   template <>                                                          \
   vector<T> ArgumentHelper::GetRepeatedArgument<T>(                    \
-      const string& name, const std::vector<T>& default_value) const { \
-    if (arg_map_.count(name) == 0) {                                   \
+      const Argument* arg,                                             \
+      const string& name,                                              \
+      const std::vector<T>& default_value) {                           \
+    if (arg == nullptr) {                                              \
       return default_value;                                            \
     }                                                                  \
     vector<T> values;                                                  \
-    for (const auto& v : arg_map_.at(name).fieldname()) {              \
+    values.reserve(arg->fieldname##_size());                           \
+    for (const auto& v : arg->fieldname()) {                           \
       if (enforce_lossless_conversion) {                               \
         auto supportsConversion =                                      \
             SupportsLosslessConversion<decltype(v), T>(v);             \
@@ -197,9 +197,12 @@ bool HasInput(const OperatorDef& op, const std::string& input);
  */
 class ArgumentHelper {
  public:
+  // The static accessors below look the argument up directly in the def's
+  // repeated arg field, without building (and copying every argument into)
+  // an arg map; operators call them for every argument they read.
   template <typename Def>
   static bool HasArgument(const Def& def, const string& name) {
-    return ArgumentHelper(def).HasArgument(name);
+    return FindArgument(def, name) != nullptr;
   }
 
   template <typename Def, typename T>
@@ -207,12 +210,12 @@ class ArgumentHelper {
       const Def& def,
       const string& name,
       const T& default_value) {
-    return ArgumentHelper(def).GetSingleArgument<T>(name, default_value);
+    return GetSingleArgument<T>(FindArgument(def, name), name, default_value);
   }
 
   template <typename Def, typename T>
   static bool HasSingleArgumentOfType(const Def& def, const string& name) {
-    return ArgumentHelper(def).HasSingleArgumentOfType<T>(name);
+    return HasSingleArgumentOfType<T>(FindArgument(def, name));
   }
 
   template <typename Def, typename T>
@@ -220,19 +223,21 @@ class ArgumentHelper {
       const Def& def,
       const string& name,
       const std::vector<T>& default_value = std::vector<T>()) {
-    return ArgumentHelper(def).GetRepeatedArgument<T>(name, default_value);
+    return GetRepeatedArgument<T>(
+        FindArgument(def, name), name, default_value);
   }
 
   template <typename Def, typename MessageType>
   static MessageType GetMessageArgument(const Def& def, const string& name) {
-    return ArgumentHelper(def).GetMessageArgument<MessageType>(name);
+    return GetMessageArgument<MessageType>(FindArgument(def, name), name);
   }
 
   template <typename Def, typename MessageType>
   static vector<MessageType> GetRepeatedMessageArgument(
       const Def& def,
       const string& name) {
-    return ArgumentHelper(def).GetRepeatedMessageArgument<MessageType>(name);
+    return GetRepeatedMessageArgument<MessageType>(
+        FindArgument(def, name), name);
   }
 
   explicit ArgumentHelper(const OperatorDef& def);
@@ -240,21 +245,67 @@ class ArgumentHelper {
   bool HasArgument(const string& name) const;
 
   template <typename T>
-  T GetSingleArgument(const string& name, const T& default_value) const;
+  T GetSingleArgument(const string& name, const T& default_value) const {
+    return GetSingleArgument<T>(Find(name), name, default_value);
+  }
   template <typename T>
-  bool HasSingleArgumentOfType(const string& name) const;
+  bool HasSingleArgumentOfType(const string& name) const {
+    return HasSingleArgumentOfType<T>(Find(name));
+  }
   template <typename T>
   vector<T> GetRepeatedArgument(
       const string& name,
-      const std::vector<T>& default_value = std::vector<T>()) const;
+      const std::vector<T>& default_value = std::vector<T>()) const {
+    return GetRepeatedArgument<T>(Find(name), name, default_value);
+  }
 
   template <typename MessageType>
   MessageType GetMessageArgument(const string& name) const {
-    CAFFE_ENFORCE(arg_map_.count(name), "Cannot find parameter named ", name);
+    return GetMessageArgument<MessageType>(Find(name), name);
+  }
+
+  template <typename MessageType>
+  vector<MessageType> GetRepeatedMessageArgument(const string& name) const {
+    return GetRepeatedMessageArgument<MessageType>(Find(name), name);
+  }
+
+ private:
+  // Returns the argument of the given name, or nullptr. Like the constructors
+  // below, throws if the def holds it twice with different contents.
+  static const Argument* FindArgument(
+      const OperatorDef& def,
+      const string& name);
+  static const Argument* FindArgument(const NetDef& def, const string& name);
+
+  const Argument* Find(const string& name) const {
+    auto it = arg_map_.find(name);
+    return it == arg_map_.end() ? nullptr : &it->second;
+  }
+
+  // Typed accessors shared by the static and the arg map based lookups; arg
+  // is the argument found for name, or nullptr.
+  template <typename T>
+  static T GetSingleArgument(
+      const Argument* arg,
+      const string& name,
+      const T& default_value);
+  template <typename T>
+  static bool HasSingleArgumentOfType(const Argument* arg);
+  template <typename T>
+  static vector<T> GetRepeatedArgument(
+      const Argument* arg,
+      const string& name,
+      const std::vector<T>& default_value);
+
+  template <typename MessageType>
+  static MessageType GetMessageArgument(
+      const Argument* arg,
+      const string& name) {
+    CAFFE_ENFORCE(arg, "Cannot find parameter named ", name);
     MessageType message;
-    if (arg_map_.at(name).has_s()) {
+    if (arg->has_s()) {
       CAFFE_ENFORCE(
-          message.ParseFromString(arg_map_.at(name).s()),
+          message.ParseFromString(arg->s()),
           "Faild to parse content from the string");
     } else {
       VLOG(1) << "Return empty message for parameter " << name;
@@ -263,18 +314,19 @@ class ArgumentHelper {
   }
 
   template <typename MessageType>
-  vector<MessageType> GetRepeatedMessageArgument(const string& name) const {
-    CAFFE_ENFORCE(arg_map_.count(name), "Cannot find parameter named ", name);
-    vector<MessageType> messages(arg_map_.at(name).strings_size());
+  static vector<MessageType> GetRepeatedMessageArgument(
+      const Argument* arg,
+      const string& name) {
+    CAFFE_ENFORCE(arg, "Cannot find parameter named ", name);
+    vector<MessageType> messages(arg->strings_size());
     for (int i = 0; i < messages.size(); ++i) {
       CAFFE_ENFORCE(
-          messages[i].ParseFromString(arg_map_.at(name).strings(i)),
+          messages[i].ParseFromString(arg->strings(i)),
           "Faild to parse content from the string");
     }
     return messages;
   }
 
- private:
   CaffeMap<string, Argument> arg_map_;
 };
 
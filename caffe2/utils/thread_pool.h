@@ -17,12 +17,18 @@
 #ifndef CAFFE2_UTILS_THREAD_POOL_H_
 #define CAFFE2_UTILS_THREAD_POOL_H_
 
+#include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <thread>
 #include <utility>
+#include <vector>
+
+#include "caffe2/core/numa.h"
 
 namespace caffe2 {
 
@@ -30,32 +36,83 @@ class TaskThreadPool {
  private:
     struct task_element_t {
         bool run_with_id;
-        const std::function< void() > no_id;
-        const std::function< void(std::size_t) > with_id;
+        std::function< void() > no_id;
+        std::function< void(std::size_t) > with_id;
+        int priority;
+        std::size_t seq;
+
+        task_element_t() :
+            run_with_id(false), no_id(nullptr), with_id(nullptr),
+            priority(0), seq(0) { }
+        explicit task_element_t(const std::function< void() >& f,
+                                int p = 0, std::size_t s = 0) :
+            run_with_id(false), no_id(f), with_id(nullptr),
+            priority(p), seq(s) { }
+        explicit task_element_t(const std::function< void(std::size_t) >& f,
+                                int p = 0, std::size_t s = 0) :
+            run_with_id(true), no_id(nullptr), with_id(f),
+            priority(p), seq(s) { }
 
-        explicit task_element_t(const std::function< void() >& f) :
-            run_with_id(false), no_id(f), with_id(nullptr) { }
-        explicit task_element_t(const std::function< void(std::size_t) >& f) :
-            run_with_id(true), no_id(nullptr), with_id(f) { }
+        // Higher priority first, FIFO among tasks of the same priority.
+        bool operator<(const task_element_t& other) const {
+            if (priority != other.priority) {
+                return priority < other.priority;
+            }
+            return seq > other.seq;
+        }
+    };
+    // Work-stealing mode: a deque per worker. A worker pushes the tasks it
+    // schedules to the back of its own deque and takes its next task from
+    // there too, so the children of a task run on the thread that produced
+    // their inputs while they are hot in its cache. Idle workers steal the
+    // oldest task from the front of the other deques. Each deque has its own
+    // lock, which is only contended when a thief and the owner meet.
+    struct worker_queue_t {
+        std::mutex mutex;
+        std::deque<task_element_t> tasks;
     };
-    std::queue<task_element_t> tasks_;
+
+    std::priority_queue<task_element_t> tasks_;
     std::vector<std::thread> threads_;
     std::mutex mutex_;
     std::condition_variable condition_;
     std::condition_variable completed_;
-    bool running_;
+    std::atomic<bool> running_;
     bool complete_;
     std::size_t available_;
     std::size_t total_;
+    std::size_t next_seq_;
+    const bool work_stealing_;
+    const int numa_node_id_;
+    std::vector<std::unique_ptr<worker_queue_t>> queues_;
+    // Tasks in the deques, and tasks pushed but not finished yet.
+    std::atomic<std::size_t> queued_;
+    std::atomic<std::size_t> outstanding_;
+    std::atomic<std::size_t> sleeping_;
+    std::atomic<std::size_t> next_queue_;
 
  public:
-    /// @brief Constructor.
-    explicit TaskThreadPool(std::size_t pool_size)
+    /// @brief Constructor. With work_stealing the tasks go to the deques
+    /// of the workers instead of one shared queue, and priorities are
+    /// ignored. With numa_node_id >= 0 the workers are bound to that node.
+    explicit TaskThreadPool(
+        std::size_t pool_size,
+        bool work_stealing = false,
+        int numa_node_id = -1)
         :  threads_(pool_size), running_(true), complete_(true),
-           available_(pool_size), total_(pool_size) {
+           available_(pool_size), total_(pool_size), next_seq_(0),
+           work_stealing_(work_stealing), numa_node_id_(numa_node_id),
+           queued_(0), outstanding_(0), sleeping_(0), next_queue_(0) {
+        if (work_stealing_) {
+            for ( std::size_t i = 0; i < pool_size; ++i ) {
+                queues_.emplace_back(new worker_queue_t());
+            }
+        }
         for ( std::size_t i = 0; i < pool_size; ++i ) {
-            threads_[i] = std::thread(
-                std::bind(&TaskThreadPool::main_loop, this, i));
+            threads_[i] = std::thread(std::bind(
+                work_stealing_ ? &TaskThreadPool::stealing_loop
+                               : &TaskThreadPool::main_loop,
+                this, i));
         }
     }
 
@@ -80,11 +137,17 @@ class TaskThreadPool {
     /// @brief Add task to the thread pool if a thread is currently available.
     template <typename Task>
     void runTask(Task task) {
+        if (work_stealing_) {
+            push_stealing(task_element_t(
+                static_cast<std::function< void() >>(task)));
+            return;
+        }
         std::unique_lock<std::mutex> lock(mutex_);
 
         // Set task and signal condition variable so that a worker thread will
         // wake up and use the task.
-        tasks_.push(task_element_t(static_cast<std::function< void() >>(task)));
+        tasks_.push(task_element_t(
+            static_cast<std::function< void() >>(task), 0, next_seq_++));
         complete_ = false;
         condition_.notify_one();
     }
@@ -93,14 +156,32 @@ class TaskThreadPool {
       runTask(func);
     }
 
+    /// @brief Add task that is started before all the queued tasks of a
+    /// lower priority.
+    void runWithPriority(const std::function<void()>& func, int priority) {
+      if (work_stealing_) {
+        push_stealing(task_element_t(func, priority));
+        return;
+      }
+      std::unique_lock<std::mutex> lock(mutex_);
+      tasks_.push(task_element_t(func, priority, next_seq_++));
+      complete_ = false;
+      condition_.notify_one();
+    }
+
     template <typename Task>
     void runTaskWithID(Task task) {
+      if (work_stealing_) {
+        push_stealing(task_element_t(
+            static_cast<std::function< void(std::size_t) >>(task)));
+        return;
+      }
       std::unique_lock<std::mutex> lock(mutex_);
 
       // Set task and signal condition variable so that a worker thread will
       // wake up and use the task.
       tasks_.push(task_element_t(static_cast<std::function< void(std::size_t) >>(
-                                   task)));
+                                   task), 0, next_seq_++));
       complete_ = false;
       condition_.notify_one();
     }
@@ -108,13 +189,104 @@ class TaskThreadPool {
     /// @brief Wait for queue to be empty
     void waitWorkComplete() {
         std::unique_lock<std::mutex> lock(mutex_);
+        if (work_stealing_) {
+            completed_.wait(lock, [this] { return outstanding_ == 0; });
+            return;
+        }
         while (!complete_)
           completed_.wait(lock);
     }
 
  private:
+    // The pool and index of the worker running on this thread, if any.
+    static std::pair<const TaskThreadPool*, std::size_t>& current_worker() {
+        static thread_local std::pair<const TaskThreadPool*, std::size_t>
+            worker(nullptr, 0);
+        return worker;
+    }
+
+    static void run_task(const task_element_t& task, std::size_t index) {
+        try {
+            if (task.run_with_id) {
+                task.with_id(index);
+            } else {
+                task.no_id();
+            }
+        }
+        // Suppress all exceptions.
+        catch ( const std::exception& ) {}
+    }
+
+    void push_stealing(task_element_t&& task) {
+        const auto& worker = current_worker();
+        // Tasks scheduled from outside the pool are spread round robin.
+        const std::size_t index = worker.first == this
+            ? worker.second : next_queue_++ % total_;
+        ++outstanding_;
+        ++queued_;
+        {
+            std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+            queues_[index]->tasks.push_back(std::move(task));
+        }
+        // A worker going to sleep increments sleeping_ before checking
+        // queued_, so at least one of the two sees the other.
+        if (sleeping_ > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            condition_.notify_one();
+        }
+    }
+
+    bool pop_stealing(std::size_t index, task_element_t* task) {
+        {
+            auto& own = *queues_[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                *task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                --queued_;
+                return true;
+            }
+        }
+        for (std::size_t i = 1; i < total_; ++i) {
+            auto& victim = *queues_[(index + i) % total_];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                *task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                --queued_;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// @brief Entry point for pool threads in work-stealing mode.
+    void stealing_loop(std::size_t index) {
+        NUMABind(numa_node_id_);
+        current_worker() = std::make_pair(this, index);
+        task_element_t task;
+        while (running_) {
+            if (pop_stealing(index, &task)) {
+                run_task(task, index);
+                // Release what the task holds before waiting for the next.
+                task = task_element_t();
+                if (--outstanding_ == 0) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    completed_.notify_all();
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            ++sleeping_;
+            condition_.wait(
+                lock, [this] { return queued_ > 0 || !running_; });
+            --sleeping_;
+        }
+    }
+
     /// @brief Entry point for pool threads.
     void main_loop(std::size_t index) {
+        NUMABind(numa_node_id_);
         while (running_) {
             // Wait on condition variable while the task is empty and
             // the pool is still running.
@@ -131,7 +303,7 @@ class TaskThreadPool {
             // useful in the event that the function contains
             // shared_ptr arguments bound via bind.
             {
-                auto tasks = tasks_.front();
+                auto tasks = tasks_.top();
                 tasks_.pop();
                 // Decrement count, indicating thread is no longer available.
                 --available_;
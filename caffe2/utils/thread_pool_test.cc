@@ -0,0 +1,79 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "caffe2/utils/thread_pool.h"
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+class TaskThreadPoolTest : public ::testing::TestWithParam<bool> {};
+
+TEST_P(TaskThreadPoolTest, RunsAllTasks) {
+  TaskThreadPool pool(4, GetParam());
+  std::atomic<int> count(0);
+  for (int i = 0; i < 1000; ++i) {
+    pool.run([&count]() { ++count; });
+  }
+  pool.waitWorkComplete();
+  EXPECT_EQ(count, 1000);
+}
+
+TEST_P(TaskThreadPoolTest, RunsTasksScheduledByTasks) {
+  TaskThreadPool pool(4, GetParam());
+  std::atomic<int> count(0);
+  // A binary tree of tasks, each scheduling its children from the pool.
+  std::function<void(int)> spawn = [&](int depth) {
+    ++count;
+    if (depth > 0) {
+      pool.run([&spawn, depth]() { spawn(depth - 1); });
+      pool.run([&spawn, depth]() { spawn(depth - 1); });
+    }
+  };
+  pool.run([&spawn]() { spawn(10); });
+  pool.waitWorkComplete();
+  EXPECT_EQ(count, (1 << 11) - 1);
+}
+
+TEST(WorkStealingThreadPoolTest, RunsChildOnParentThread) {
+  TaskThreadPool pool(4, true);
+  std::atomic<int> same_thread(0);
+  const int kTasks = 100;
+  for (int i = 0; i < kTasks; ++i) {
+    pool.run([&pool, &same_thread]() {
+      const auto parent = std::this_thread::get_id();
+      // Pushed to the back of this worker's deque, which it takes from
+      // next.
+      pool.run([parent, &same_thread]() {
+        same_thread += std::this_thread::get_id() == parent;
+      });
+    });
+  }
+  pool.waitWorkComplete();
+  // Idle workers may steal some children, but most run where they were
+  // scheduled.
+  EXPECT_GT(same_thread, kTasks / 2);
+}
+
+INSTANTIATE_TEST_CASE_P(
+    SharedQueueAndWorkStealing,
+    TaskThreadPoolTest,
+    ::testing::Bool());
+
+} // namespace caffe2
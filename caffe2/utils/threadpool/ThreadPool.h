@@ -23,9 +23,10 @@
 #error "mobile build state not defined"
 #endif
 
-// ThreadPool only used in mobile builds at the moment
-#if CAFFE2_THREADPOOL_MOBILE
+// Mobile builds run NNPACK and the mobile operators on it, server builds the
+// intra-op parallelism of CPUContext::ParallelFor.
 
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <vector>
@@ -68,6 +69,4 @@ private:
 
 } // namespace caffe2
 
-#endif // CAFFE2_THREADPOOL_MOBILE
-
 #endif // CAFFE2_UTILS_THREADPOOL_H_
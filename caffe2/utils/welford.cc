@@ -0,0 +1,44 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/utils/welford.h"
+
+#include <algorithm>
+
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+// Small enough for a chunk to stay in L1 between its two passes.
+constexpr size_t kMomentsChunk = 1024;
+} // namespace
+
+WelfordMoments<float> ComputeMoments(const float* x, size_t n) {
+  WelfordMoments<float> moments = {0.0f, 0.0f, 0.0f};
+  for (size_t begin = 0; begin < n; begin += kMomentsChunk) {
+    const auto size = std::min(kMomentsChunk, n - begin);
+    ConstEigenVectorArrayMap<float> chunk(x + begin, size);
+    WelfordMoments<float> chunk_moments;
+    chunk_moments.count = size;
+    chunk_moments.mean = chunk.mean();
+    chunk_moments.m2 = (chunk - chunk_moments.mean).square().sum();
+    moments.Combine(chunk_moments);
+  }
+  return moments;
+}
+
+} // namespace caffe2
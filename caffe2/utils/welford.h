@@ -0,0 +1,79 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_UTILS_WELFORD_H_
+#define CAFFE2_UTILS_WELFORD_H_
+
+#include <cstddef>
+
+// The moments are also updated and merged in device code, e.g. by the
+// normalization kernels.
+#if defined(__CUDACC__) || defined(__HIPCC__)
+#define WELFORD_DECL inline __host__ __device__
+#else
+#define WELFORD_DECL inline
+#endif
+
+namespace caffe2 {
+
+/**
+ * Count, mean and sum of squared deviations from the mean (m2) of a stream of
+ * values, updated in a single pass with Welford's algorithm. Moments of parts
+ * of the stream, e.g. of different threads, are merged with Combine (Chan et
+ * al.). It's an aggregate so that it can be kept in shared memory, start from
+ * {0, 0, 0}.
+ */
+template <typename T>
+struct WelfordMoments {
+  T count;
+  T mean;
+  T m2;
+
+  WELFORD_DECL void Update(const T x) {
+    count += T(1);
+    const T delta = x - mean;
+    mean += delta / count;
+    m2 += delta * (x - mean);
+  }
+
+  WELFORD_DECL void Combine(const WelfordMoments<T>& other) {
+    if (other.count == T(0)) {
+      return;
+    }
+    const T new_count = count + other.count;
+    const T delta = other.mean - mean;
+    const T other_weight = other.count / new_count;
+    mean += delta * other_weight;
+    m2 += other.m2 + delta * delta * count * other_weight;
+    count = new_count;
+  }
+
+  // Biased (population) variance, as used by normalization.
+  WELFORD_DECL T Variance() const {
+    return count > T(0) ? m2 / count : T(0);
+  }
+};
+
+/**
+ * Moments of x[0], ..., x[n - 1]. The values are read from memory once: they
+ * are taken in cache sized chunks whose moments are computed with vectorized
+ * loops and merged with Combine.
+ */
+WelfordMoments<float> ComputeMoments(const float* x, size_t n);
+
+} // namespace caffe2
+
+#endif // CAFFE2_UTILS_WELFORD_H_
@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/utils/welford.h"
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace caffe2 {
+
+namespace {
+
+void checkMoments(const std::vector<float>& x) {
+  double mean = 0;
+  for (auto v : x) {
+    mean += v;
+  }
+  mean /= x.size();
+  double var = 0;
+  for (auto v : x) {
+    var += (v - mean) * (v - mean);
+  }
+  var /= x.size();
+
+  auto moments = ComputeMoments(x.data(), x.size());
+  EXPECT_EQ(moments.count, x.size());
+  EXPECT_NEAR(moments.mean, mean, 1e-4 * (1 + std::abs(mean)));
+  EXPECT_NEAR(moments.Variance(), var, 1e-3 * (1 + var));
+
+  WelfordMoments<float> streamed = {0, 0, 0};
+  for (auto v : x) {
+    streamed.Update(v);
+  }
+  EXPECT_NEAR(streamed.mean, mean, 1e-4 * (1 + std::abs(mean)));
+  EXPECT_NEAR(streamed.Variance(), var, 1e-3 * (1 + var));
+}
+
+} // namespace
+
+TEST(WelfordTest, Moments) {
+  std::mt19937 gen(1);
+  std::normal_distribution<float> dist(0, 1);
+  for (size_t n : {1, 7, 1023, 1024, 1025, 5000}) {
+    std::vector<float> x(n);
+    for (auto& v : x) {
+      v = dist(gen);
+    }
+    checkMoments(x);
+  }
+}
+
+TEST(WelfordTest, LargeOffset) {
+  // E[x^2] - E[x]^2 loses all the digits of the variance here.
+  std::mt19937 gen(2);
+  std::uniform_real_distribution<float> dist(-1, 1);
+  std::vector<float> x(3000);
+  for (auto& v : x) {
+    v = 1e4f + dist(gen);
+  }
+  checkMoments(x);
+}
+
+TEST(WelfordTest, Combine) {
+  WelfordMoments<float> a = {0, 0, 0};
+  WelfordMoments<float> b = {0, 0, 0};
+  WelfordMoments<float> all = {0, 0, 0};
+  for (int i = 0; i < 10; ++i) {
+    (i < 3 ? a : b).Update(i);
+    all.Update(i);
+  }
+  WelfordMoments<float> empty = {0, 0, 0};
+  a.Combine(empty);
+  a.Combine(b);
+  EXPECT_FLOAT_EQ(a.count, all.count);
+  EXPECT_FLOAT_EQ(a.mean, all.mean);
+  EXPECT_NEAR(a.m2, all.m2, 1e-4);
+}
+
+} // namespace caffe2
@@ -99,6 +99,11 @@ class ZmqSocket {
     CAFFE_ENFORCE_EQ(rc, 0);
   }
 
+  void SetOption(int option, int value) {
+    int rc = zmq_setsockopt(ptr_, option, &value, sizeof(value));
+    CAFFE_ENFORCE_EQ(rc, 0);
+  }
+
   int Send(const string& msg, int flags) {
     int nbytes = zmq_send(ptr_, msg.c_str(), msg.size(), flags);
     if (nbytes) {
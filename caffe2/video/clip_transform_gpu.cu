@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/video/clip_transform_gpu.h"
+
+namespace caffe2 {
+
+namespace {
+
+// One block per (clip, channel, frame) plane of the output.
+__global__ void clip_transform_kernel(
+    const int C,
+    const int L,
+    const int H,
+    const int W,
+    const int crop,
+    const float mean,
+    const float inv_std,
+    const int* crop_params,
+    const uint8_t* in,
+    float* out) {
+  const int plane = blockIdx.x;
+  const int n = plane / (C * L);
+  const int h_off = crop_params[3 * n];
+  const int w_off = crop_params[3 * n + 1];
+  const bool mirror = crop_params[3 * n + 2];
+
+  const uint8_t* input_ptr = in + static_cast<int64_t>(plane) * H * W;
+  float* output_ptr = out + static_cast<int64_t>(plane) * crop * crop;
+
+  for (int h = threadIdx.y; h < crop; h += blockDim.y) {
+    const uint8_t* row = input_ptr + (h_off + h) * W + w_off;
+    for (int w = threadIdx.x; w < crop; w += blockDim.x) {
+      const int out_w = mirror ? crop - 1 - w : w;
+      output_ptr[h * crop + out_w] = (row[w] - mean) * inv_std;
+    }
+  }
+}
+
+} // namespace
+
+template <class Context>
+bool ClipTransformOnGPU(
+    const Tensor<Context>& X,
+    const Tensor<Context>& crop_params,
+    const int crop,
+    const float mean,
+    const float std,
+    Tensor<Context>* Y,
+    Context* context) {
+  const int N = X.dim32(0), C = X.dim32(1), L = X.dim32(2), H = X.dim32(3),
+            W = X.dim32(4);
+  CAFFE_ENFORCE_EQ(crop_params.size(), 3 * N);
+  Y->Resize(std::vector<int>{N, C, L, crop, crop});
+  if (N == 0) {
+    return true;
+  }
+
+  clip_transform_kernel<<<N * C * L, dim3(32, 8), 0, context->cuda_stream()>>>(
+      C,
+      L,
+      H,
+      W,
+      crop,
+      mean,
+      1.f / std,
+      crop_params.template data<int>(),
+      X.template data<uint8_t>(),
+      Y->template mutable_data<float>());
+  return true;
+}
+
+template bool ClipTransformOnGPU<CUDAContext>(
+    const Tensor<CUDAContext>& X,
+    const Tensor<CUDAContext>& crop_params,
+    const int crop,
+    const float mean,
+    const float std,
+    Tensor<CUDAContext>* Y,
+    CUDAContext* context);
+
+} // namespace caffe2
@@ -0,0 +1,40 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAFFE2_VIDEO_CLIP_TRANSFORM_GPU_H_
+#define CAFFE2_VIDEO_CLIP_TRANSFORM_GPU_H_
+
+#include "caffe2/core/context.h"
+
+namespace caffe2 {
+
+// Crops, mirrors and normalizes a batch of clips on the device, like
+// ClipTransform. X holds N x C x L x H x W uint8 clips, crop_params holds the
+// vertical offset, horizontal offset and mirror flag of every clip, as drawn
+// by GetClipCropParams. Y is resized to N x C x L x crop x crop.
+template <class Context>
+bool ClipTransformOnGPU(
+    const Tensor<Context>& X,
+    const Tensor<Context>& crop_params,
+    const int crop,
+    const float mean,
+    const float std,
+    Tensor<Context>* Y,
+    Context* context);
+
+} // namespace caffe2
+
+#endif // CAFFE2_VIDEO_CLIP_TRANSFORM_GPU_H_
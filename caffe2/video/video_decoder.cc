@@ -18,6 +18,8 @@
 #include "caffe2/core/logging.h"
 
 #include <stdio.h>
+#include <algorithm>
+#include <fstream>
 #include <mutex>
 #include <random>
 
@@ -25,12 +27,78 @@ extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
 #include <libavutil/log.h>
+#include <libavutil/pixdesc.h>
 #include <libswresample/swresample.h>
 #include <libswscale/swscale.h>
 }
 
+// The hwcontext API and avcodec_get_hw_config() are available from FFmpeg 4.0
+#if LIBAVCODEC_VERSION_MAJOR >= 58
+#define CAFFE2_VIDEO_HW_DECODE 1
+extern "C" {
+#include <libavutil/hwcontext.h>
+}
+#endif
+
 namespace caffe2 {
 
+#ifdef CAFFE2_VIDEO_HW_DECODE
+namespace {
+
+// Picks the hardware pixel format stored in the opaque field of the codec
+// context if the decoder offers it, and the first software format otherwise,
+// so that the stream is still decoded when the device does not support it.
+AVPixelFormat getHWFormat(AVCodecContext* ctx, const AVPixelFormat* formats) {
+  const AVPixelFormat hwFormat =
+      static_cast<AVPixelFormat>(reinterpret_cast<intptr_t>(ctx->opaque));
+  for (const AVPixelFormat* p = formats; *p != AV_PIX_FMT_NONE; p++) {
+    if (*p == hwFormat) {
+      return *p;
+    }
+  }
+  LOG(WARNING) << "Hardware decoding is not supported for this stream, "
+                  "decoding in software";
+  for (const AVPixelFormat* p = formats; *p != AV_PIX_FMT_NONE; p++) {
+    if (!(av_pix_fmt_desc_get(*p)->flags & AV_PIX_FMT_FLAG_HWACCEL)) {
+      return *p;
+    }
+  }
+  return AV_PIX_FMT_NONE;
+}
+
+struct HWDeviceDeleter {
+  void operator()(AVBufferRef* p) const {
+    av_buffer_unref(&p);
+  }
+};
+
+// Opening a device takes longer than decoding a short clip, so every decode
+// thread keeps the last device it opened. Returns a new reference to it.
+int getHWDevice(
+    AVHWDeviceType type,
+    const std::string& device,
+    AVBufferRef** deviceContext) {
+  static thread_local std::unique_ptr<AVBufferRef, HWDeviceDeleter> cached;
+  static thread_local AVHWDeviceType cachedType = AV_HWDEVICE_TYPE_NONE;
+  static thread_local std::string cachedDevice;
+  if (!cached || cachedType != type || cachedDevice != device) {
+    AVBufferRef* ref = nullptr;
+    int ret = av_hwdevice_ctx_create(
+        &ref, type, device.empty() ? nullptr : device.c_str(), nullptr, 0);
+    if (ret < 0) {
+      return ret;
+    }
+    cached.reset(ref);
+    cachedType = type;
+    cachedDevice = device;
+  }
+  *deviceContext = av_buffer_ref(cached.get());
+  return *deviceContext ? 0 : AVERROR(ENOMEM);
+}
+
+} // namespace
+#endif // CAFFE2_VIDEO_HW_DECODE
+
 VideoDecoder::VideoDecoder() {
   static bool gInitialized = false;
   static std::mutex gMutex;
@@ -43,6 +111,53 @@ VideoDecoder::VideoDecoder() {
   }
 }
 
+AVFormatContext* VideoDecoder::openInput(
+    const string& videoName,
+    VideoIOContext& ioctx) {
+  AVFormatContext* inputContext = avformat_alloc_context();
+  inputContext->pb = ioctx.get_avio();
+  inputContext->flags |= AVFMT_FLAG_CUSTOM_IO;
+  int ret = 0;
+
+  // Determining the input format:
+  int probeSz = 32 * 1024 + AVPROBE_PADDING_SIZE;
+  DecodedFrame::AvDataPtr probe((uint8_t*)av_malloc(probeSz));
+
+  memset(probe.get(), 0, probeSz);
+  int len = ioctx.read(probe.get(), probeSz - AVPROBE_PADDING_SIZE);
+  if (len < probeSz - AVPROBE_PADDING_SIZE) {
+    LOG(ERROR) << "Insufficient data to determine video format";
+    avformat_free_context(inputContext);
+    return nullptr;
+  }
+
+  // seek back to start of stream
+  ioctx.seek(0, SEEK_SET);
+
+  unique_ptr<AVProbeData> probeData(new AVProbeData());
+  probeData->buf = probe.get();
+  probeData->buf_size = len;
+  probeData->filename = "";
+  // Determine the input-format:
+  inputContext->iformat = av_probe_input_format(probeData.get(), 1);
+
+  // On failure, avformat_open_input() frees the context
+  ret = avformat_open_input(&inputContext, "", nullptr, nullptr);
+  if (ret < 0) {
+    LOG(ERROR) << "Unable to open stream " << ffmpegErrorStr(ret);
+    return nullptr;
+  }
+
+  ret = avformat_find_stream_info(inputContext, nullptr);
+  if (ret < 0) {
+    LOG(ERROR) << "Unable to find stream info in " << videoName << " "
+               << ffmpegErrorStr(ret);
+    avformat_close_input(&inputContext);
+    return nullptr;
+  }
+  return inputContext;
+}
+
 void VideoDecoder::decodeLoop(
     const string& videoName,
     VideoIOContext& ioctx,
@@ -52,10 +167,12 @@ void VideoDecoder::decodeLoop(
     bool decodeFromStart) {
   AVPixelFormat pixFormat = params.pixelFormat_;
 
-  AVFormatContext* inputContext = avformat_alloc_context();
+  AVFormatContext* inputContext = nullptr;
   AVStream* videoStream_ = nullptr;
   AVCodecContext* videoCodecContext_ = nullptr;
   AVFrame* videoStreamFrame_ = nullptr;
+  // frame the hardware decoded frames are downloaded to
+  AVFrame* hwTransferFrame_ = nullptr;
   AVPacket packet;
   av_init_packet(&packet); // init packet
   SwsContext* scaleContext_ = nullptr;
@@ -63,43 +180,11 @@ void VideoDecoder::decodeLoop(
    * Else decode all the frames */
   bool mustDecodeAll = (maxFrames <= 0);
   try {
-    inputContext->pb = ioctx.get_avio();
-    inputContext->flags |= AVFMT_FLAG_CUSTOM_IO;
-    int ret = 0;
-
-    // Determining the input format:
-    int probeSz = 32 * 1024 + AVPROBE_PADDING_SIZE;
-    DecodedFrame::AvDataPtr probe((uint8_t*)av_malloc(probeSz));
-
-    memset(probe.get(), 0, probeSz);
-    int len = ioctx.read(probe.get(), probeSz - AVPROBE_PADDING_SIZE);
-    if (len < probeSz - AVPROBE_PADDING_SIZE) {
-      LOG(ERROR) << "Insufficient data to determine video format";
-      return;
-    }
-
-    // seek back to start of stream
-    ioctx.seek(0, SEEK_SET);
-
-    unique_ptr<AVProbeData> probeData(new AVProbeData());
-    probeData->buf = probe.get();
-    probeData->buf_size = len;
-    probeData->filename = "";
-    // Determine the input-format:
-    inputContext->iformat = av_probe_input_format(probeData.get(), 1);
-
-    ret = avformat_open_input(&inputContext, "", nullptr, nullptr);
-    if (ret < 0) {
-      LOG(ERROR) << "Unable to open stream " << ffmpegErrorStr(ret);
-      return;
-    }
-
-    ret = avformat_find_stream_info(inputContext, nullptr);
-    if (ret < 0) {
-      LOG(ERROR) << "Unable to find stream info in " << videoName << " "
-                 << ffmpegErrorStr(ret);
+    inputContext = openInput(videoName, ioctx);
+    if (inputContext == nullptr) {
       return;
     }
+    int ret = 0;
 
     // Decode the first video stream
     int videoStreamIndex_ = params.streamIndex_;
@@ -122,11 +207,14 @@ void VideoDecoder::decodeLoop(
 
     // Initialize codec
     videoCodecContext_ = videoStream_->codec;
+    AVCodec* codec = avcodec_find_decoder(videoCodecContext_->codec_id);
+
+    AVPixelFormat hwFormat = AV_PIX_FMT_NONE;
+    if (!params.hwAccel_.empty() && codec != nullptr) {
+      hwFormat = initHWDecoder(videoCodecContext_, codec, params);
+    }
 
-    ret = avcodec_open2(
-        videoCodecContext_,
-        avcodec_find_decoder(videoCodecContext_->codec_id),
-        nullptr);
+    ret = avcodec_open2(videoCodecContext_, codec, nullptr);
     if (ret < 0) {
       LOG(ERROR) << "Cannot open video codec : "
                  << videoCodecContext_->codec->name;
@@ -162,21 +250,14 @@ void VideoDecoder::decodeLoop(
                                              : params.outputHeight_;
     }
 
-    // Make sure that we have a valid format
-    CAFFE_ENFORCE_NE(videoCodecContext_->pix_fmt, AV_PIX_FMT_NONE);
-
-    // Create a scale context
-    scaleContext_ = sws_getContext(
-        videoCodecContext_->width,
-        videoCodecContext_->height,
-        videoCodecContext_->pix_fmt,
-        outWidth,
-        outHeight,
-        pixFormat,
-        SWS_FAST_BILINEAR,
-        nullptr,
-        nullptr,
-        nullptr);
+    // Make sure that we have a valid format. With a hardware decoder the
+    // format of the downloaded frames is only known once they are decoded,
+    // so the scale context is created for the first frame.
+    if (hwFormat == AV_PIX_FMT_NONE) {
+      CAFFE_ENFORCE_NE(videoCodecContext_->pix_fmt, AV_PIX_FMT_NONE);
+    } else {
+      hwTransferFrame_ = av_frame_alloc();
+    }
 
     // Getting video meta data
     VideoMeta videoMeta;
@@ -266,6 +347,31 @@ void VideoDecoder::decodeLoop(
       }
     }
 
+    // Seek to the last keyframe at or before the first frame to output.
+    // Frames are counted from the index of that keyframe.
+    int64_t seekTimestamp = AV_NOPTS_VALUE;
+    const KeyframeIndex* keyframeIndex = params.keyframeIndex_;
+    if (keyframeIndex != nullptr && decodeFromStart &&
+        params.startFrame_ > 0) {
+      int k = keyframeIndex->find(params.startFrame_);
+      if (k >= 0 && keyframeIndex->frames_[k] > 0) {
+        ret = av_seek_frame(
+            inputContext,
+            videoStreamIndex_,
+            keyframeIndex->timestamps_[k],
+            AVSEEK_FLAG_BACKWARD);
+        if (ret < 0) {
+          LOG(ERROR) << "Unable to seek to keyframe "
+                     << keyframeIndex->frames_[k] << " of " << videoName;
+          av_seek_frame(
+              inputContext, videoStreamIndex_, 0, AVSEEK_FLAG_BACKWARD);
+        } else {
+          seekTimestamp = keyframeIndex->timestamps_[k];
+          frameIndex = keyframeIndex->frames_[k] - 1;
+        }
+      }
+    }
+
     int gotPicture = 0;
     int eof = 0;
     int selectiveDecodedFrames = 0;
@@ -314,12 +420,26 @@ void VideoDecoder::decodeLoop(
             continue;
           }
 
-          frameIndex++;
-
           double frame_ts =
               av_frame_get_best_effort_timestamp(videoStreamFrame_);
           timestamp = frame_ts * av_q2d(videoStream_->time_base);
 
+          // After a seek, an open GOP can output frames that precede the
+          // keyframe; they are not counted.
+          if (seekTimestamp != AV_NOPTS_VALUE && frame_ts < seekTimestamp) {
+            av_frame_unref(videoStreamFrame_);
+            av_free_packet(&packet);
+            continue;
+          }
+
+          frameIndex++;
+
+          if (frameIndex < params.startFrame_) {
+            av_frame_unref(videoStreamFrame_);
+            av_free_packet(&packet);
+            continue;
+          }
+
           if ((frame_ts >= random_ts && !mustDecodeAll) || mustDecodeAll) {
             /* process current frame if:
              * 1) We are not doing selective decoding and mustDecodeAll
@@ -407,12 +527,44 @@ void VideoDecoder::decodeLoop(
                   outWidth,
                   outHeight);
 
+              AVFrame* srcFrame = videoStreamFrame_;
+#ifdef CAFFE2_VIDEO_HW_DECODE
+              if (videoStreamFrame_->format == hwFormat) {
+                av_frame_unref(hwTransferFrame_);
+                ret = av_hwframe_transfer_data(
+                    hwTransferFrame_, videoStreamFrame_, 0);
+                if (ret < 0) {
+                  LOG(ERROR) << "Error downloading decoded frame : "
+                             << ffmpegErrorStr(ret);
+                  av_frame_free(&rgbFrame);
+                  av_frame_unref(videoStreamFrame_);
+                  av_free_packet(&packet);
+                  continue;
+                }
+                srcFrame = hwTransferFrame_;
+              }
+#endif // CAFFE2_VIDEO_HW_DECODE
+
+              // Reused as long as the source format and size do not change
+              scaleContext_ = sws_getCachedContext(
+                  scaleContext_,
+                  srcFrame->width,
+                  srcFrame->height,
+                  static_cast<AVPixelFormat>(srcFrame->format),
+                  outWidth,
+                  outHeight,
+                  pixFormat,
+                  SWS_FAST_BILINEAR,
+                  nullptr,
+                  nullptr,
+                  nullptr);
+
               sws_scale(
                   scaleContext_,
-                  videoStreamFrame_->data,
-                  videoStreamFrame_->linesize,
+                  srcFrame->data,
+                  srcFrame->linesize,
                   0,
-                  videoCodecContext_->height,
+                  srcFrame->height,
                   rgbFrame->data,
                   rgbFrame->linesize);
 
@@ -447,6 +599,7 @@ void VideoDecoder::decodeLoop(
     sws_freeContext(scaleContext_);
     av_packet_unref(&packet);
     av_frame_free(&videoStreamFrame_);
+    av_frame_free(&hwTransferFrame_);
     avcodec_close(videoCodecContext_);
     avformat_close_input(&inputContext);
     avformat_free_context(inputContext);
@@ -456,6 +609,7 @@ void VideoDecoder::decodeLoop(
     sws_freeContext(scaleContext_);
     av_packet_unref(&packet);
     av_frame_free(&videoStreamFrame_);
+    av_frame_free(&hwTransferFrame_);
     avcodec_close(videoCodecContext_);
     avformat_close_input(&inputContext);
     avformat_free_context(inputContext);
@@ -489,6 +643,157 @@ void VideoDecoder::decodeFile(
   decodeLoop(file, ioctx, params, sampledFrames, maxFrames, decodeFromStart);
 }
 
+bool VideoDecoder::indexLoop(
+    const string& videoName,
+    VideoIOContext& ioctx,
+    KeyframeIndex* index) {
+  AVFormatContext* inputContext = openInput(videoName, ioctx);
+  if (inputContext == nullptr) {
+    return false;
+  }
+
+  int videoStreamIndex = -1;
+  for (int i = 0; i < inputContext->nb_streams; i++) {
+    if (inputContext->streams[i]->codec->codec_type == AVMEDIA_TYPE_VIDEO) {
+      videoStreamIndex = i;
+      break;
+    }
+  }
+  if (videoStreamIndex == -1) {
+    LOG(ERROR) << "Unable to find video stream in " << videoName;
+    avformat_close_input(&inputContext);
+    return false;
+  }
+
+  // Packets are read in decoding order, the presentation index of a keyframe
+  // is the rank of its timestamp among the ones of all the frames.
+  std::vector<int64_t> timestamps;
+  std::vector<int64_t> keyframeTimestamps;
+  AVPacket packet;
+  av_init_packet(&packet);
+  while (av_read_frame(inputContext, &packet) >= 0) {
+    if (packet.stream_index == videoStreamIndex &&
+        packet.pts != AV_NOPTS_VALUE) {
+      timestamps.push_back(packet.pts);
+      if (packet.flags & AV_PKT_FLAG_KEY) {
+        keyframeTimestamps.push_back(packet.pts);
+      }
+    }
+    av_packet_unref(&packet);
+  }
+  avformat_close_input(&inputContext);
+
+  std::sort(timestamps.begin(), timestamps.end());
+  std::sort(keyframeTimestamps.begin(), keyframeTimestamps.end());
+  index->numFrames_ = timestamps.size();
+  index->frames_.clear();
+  index->timestamps_ = keyframeTimestamps;
+  for (int64_t ts : keyframeTimestamps) {
+    index->frames_.push_back(
+        std::lower_bound(timestamps.begin(), timestamps.end(), ts) -
+        timestamps.begin());
+  }
+  return true;
+}
+
+bool VideoDecoder::indexMemory(
+    const char* buffer,
+    const int size,
+    KeyframeIndex* index) {
+  VideoIOContext ioctx(buffer, size);
+  return indexLoop(string("Memory Buffer"), ioctx, index);
+}
+
+bool VideoDecoder::indexFile(const string& filename, KeyframeIndex* index) {
+  VideoIOContext ioctx(filename);
+  return indexLoop(filename, ioctx, index);
+}
+
+int KeyframeIndex::find(int frame) const {
+  auto it = std::upper_bound(frames_.begin(), frames_.end(), frame);
+  return static_cast<int>(it - frames_.begin()) - 1;
+}
+
+bool KeyframeIndex::save(const string& filename) const {
+  std::ofstream out(filename);
+  if (!out) {
+    return false;
+  }
+  out << numFrames_ << " " << frames_.size() << "\n";
+  for (int i = 0; i < frames_.size(); i++) {
+    out << frames_[i] << " " << timestamps_[i] << "\n";
+  }
+  return static_cast<bool>(out);
+}
+
+bool KeyframeIndex::load(const string& filename) {
+  std::ifstream in(filename);
+  int numKeyframes = 0;
+  if (!(in >> numFrames_ >> numKeyframes) || numKeyframes < 0) {
+    return false;
+  }
+  frames_.resize(numKeyframes);
+  timestamps_.resize(numKeyframes);
+  for (int i = 0; i < numKeyframes; i++) {
+    if (!(in >> frames_[i] >> timestamps_[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+AVPixelFormat VideoDecoder::initHWDecoder(
+    AVCodecContext* codecContext,
+    AVCodec* codec,
+    const Params& params) {
+#ifdef CAFFE2_VIDEO_HW_DECODE
+  const AVHWDeviceType type =
+      av_hwdevice_find_type_by_name(params.hwAccel_.c_str());
+  if (type == AV_HWDEVICE_TYPE_NONE) {
+    LOG(ERROR) << "Unknown hardware decoder " << params.hwAccel_
+               << ", decoding in software";
+    return AV_PIX_FMT_NONE;
+  }
+
+  AVPixelFormat hwFormat = AV_PIX_FMT_NONE;
+  for (int i = 0;; i++) {
+    const AVCodecHWConfig* config = avcodec_get_hw_config(codec, i);
+    if (config == nullptr) {
+      break;
+    }
+    if ((config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX) &&
+        config->device_type == type) {
+      hwFormat = config->pix_fmt;
+      break;
+    }
+  }
+  if (hwFormat == AV_PIX_FMT_NONE) {
+    LOG(WARNING) << "Codec " << codec->name << " cannot be decoded with "
+                 << params.hwAccel_ << ", decoding in software";
+    return AV_PIX_FMT_NONE;
+  }
+
+  AVBufferRef* deviceContext = nullptr;
+  int ret = getHWDevice(type, params.hwDevice_, &deviceContext);
+  if (ret < 0) {
+    LOG(WARNING) << "Unable to open " << params.hwAccel_ << " device "
+                 << params.hwDevice_ << " : " << ffmpegErrorStr(ret)
+                 << ", decoding in software";
+    return AV_PIX_FMT_NONE;
+  }
+  // The codec context owns the reference from now on, avcodec_close()
+  // releases it.
+  codecContext->hw_device_ctx = deviceContext;
+  codecContext->opaque = reinterpret_cast<void*>(intptr_t(hwFormat));
+  codecContext->get_format = getHWFormat;
+  return hwFormat;
+#else
+  LOG(WARNING) << "Hardware decoding requires FFmpeg 4.0 or newer, "
+                  "decoding in software";
+  return AV_PIX_FMT_NONE;
+#endif // CAFFE2_VIDEO_HW_DECODE
+}
+
 string VideoDecoder::ffmpegErrorStr(int result) {
   std::array<char, 128> buf;
   av_strerror(result, buf.data(), buf.size());
@@ -60,6 +60,32 @@ struct SampleInterval {
   }
 };
 
+// Presentation indices and timestamps of the keyframes of a video stream,
+// built by demuxing the stream once, so that decoding a clip can seek to the
+// last keyframe before it instead of decoding every frame from the start.
+class KeyframeIndex {
+ public:
+  // Number of frames in the stream
+  int numFrames_ = 0;
+
+  // Presentation index of every keyframe, ascending
+  std::vector<int> frames_;
+
+  // Timestamp of every keyframe, in the time base of the stream
+  std::vector<int64_t> timestamps_;
+
+  /**
+   * Position of the last keyframe at or before frame, -1 if there is none
+   */
+  int find(int frame) const;
+
+  /**
+   * Write the index to / read it from a file
+   */
+  bool save(const std::string& filename) const;
+  bool load(const std::string& filename);
+};
+
 class Params {
  public:
   // return all key-frames regardless of specified fps
@@ -91,6 +117,23 @@ class Params {
   // fps must be either the 3 special fps defined in SpecialFps, or > 0
   std::vector<SampleInterval> intervals_ = {{0, SpecialFps::SAMPLE_ALL_FRAMES}};
 
+  // FFmpeg hardware device type used to decode, e.g. "vaapi", empty to decode
+  // in software. Decoding falls back to software when the device cannot be
+  // opened or does not support the codec of the video.
+  std::string hwAccel_;
+
+  // Device to open for hwAccel_, e.g. "/dev/dri/renderD128", empty for the
+  // default device of that type
+  std::string hwDevice_;
+
+  // Presentation index of the first frame to output, the frames decoded
+  // before it are dropped without being converted. 0 to output from the
+  // start of the video.
+  int startFrame_ = 0;
+
+  // If set, decoding seeks to the last keyframe at or before startFrame_
+  const KeyframeIndex* keyframeIndex_ = nullptr;
+
   Params() {}
 
   /**
@@ -161,6 +204,26 @@ class Params {
     maxOutputDimension_ = size;
     return *this;
   }
+
+  /**
+   * Decode with the given FFmpeg hardware device type, default to software
+   * decoding. Decoded frames are downloaded to host memory before they are
+   * scaled to the output pixel format.
+   */
+  Params& hwAccel(const std::string& type, const std::string& device = "") {
+    hwAccel_ = type;
+    hwDevice_ = device;
+    return *this;
+  }
+
+  /**
+   * Start outputting at this frame, seeking with index if it is given
+   */
+  Params& startFrame(int frame, const KeyframeIndex* index = nullptr) {
+    startFrame_ = frame;
+    keyframeIndex_ = index;
+    return *this;
+  }
 };
 
 // data structure for storing decoded video frames
@@ -384,9 +447,32 @@ class VideoDecoder {
                                      intermediate frame ? */
       );
 
+  // Builds the keyframe index of the first video stream, without decoding it
+  bool indexFile(const std::string& filename, KeyframeIndex* index);
+
+  bool indexMemory(const char* buffer, const int size, KeyframeIndex* index);
+
  private:
   std::string ffmpegErrorStr(int result);
 
+  // Probes the format of ioctx and opens it, returns nullptr on failure
+  AVFormatContext* openInput(
+      const std::string& videoName,
+      VideoIOContext& ioctx);
+
+  bool indexLoop(
+      const std::string& videoName,
+      VideoIOContext& ioctx,
+      KeyframeIndex* index);
+
+  // Attaches a hardware device of type params.hwAccel_ to codecContext, and
+  // returns the pixel format of the frames it decodes, or AV_PIX_FMT_NONE if
+  // the video has to be decoded in software.
+  AVPixelFormat initHWDecoder(
+      AVCodecContext* codecContext,
+      AVCodec* codec,
+      const Params& params);
+
   void decodeLoop(
       const std::string& videoName,
       VideoIOContext& ioctx,
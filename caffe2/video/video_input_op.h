@@ -17,8 +17,10 @@
 #ifndef CAFFE2_VIDEO_VIDEO_INPUT_OP_H_
 #define CAFFE2_VIDEO_VIDEO_INPUT_OP_H_
 
+#include <cstring>
 #include <iostream>
 #include <random>
+#include <sstream>
 #include <string>
 
 #include <opencv2/opencv.hpp>
@@ -28,6 +30,8 @@
 #include "caffe2/operators/prefetch_op.h"
 #include "caffe2/utils/math.h"
 #include "caffe2/utils/thread_pool.h"
+#include "caffe2/video/clip_transform_gpu.h"
+#include "caffe2/video/video_decoder.h"
 #include "caffe2/video/video_io.h"
 
 namespace caffe2 {
@@ -49,14 +53,18 @@ class VideoInputOp final : public PrefetchOperator<Context> {
 
  private:
   bool GetClipAndLabelFromDBValue(
+      const std::string& key,
       const std::string& value,
       float*& buffer,
       int* label_data,
       std::mt19937* randgen);
 
   void DecodeAndTransform(
+      const std::string key,
       const std::string value,
       float* clip_data,
+      uint8_t* raw_clip_data,
+      int* crop_params,
       int* label_data,
       const int crop_size,
       const bool mirror,
@@ -69,8 +77,16 @@ class VideoInputOp final : public PrefetchOperator<Context> {
   CPUContext cpu_context_;
   TensorCPU prefetched_clip_;
   TensorCPU prefetched_label_;
-  Tensor<Context> prefetched_clip_on_device_;
-  Tensor<Context> prefetched_label_on_device_;
+  // One of each per prefetch slot.
+  vector<Tensor<Context>> prefetched_clip_on_device_;
+  vector<Tensor<Context>> prefetched_label_on_device_;
+  // With use_gpu_transform, the uncropped uint8 clips and the crop offsets
+  // and mirror flag of every clip, that ClipTransformOnGPU turns into the
+  // output on the device.
+  TensorCPU prefetched_raw_clip_;
+  TensorCPU prefetched_crop_params_;
+  vector<Tensor<Context>> prefetched_raw_clip_on_device_;
+  vector<Tensor<Context>> prefetched_crop_params_on_device_;
   int batch_size_;
   float mean_;
   float std_;
@@ -87,6 +103,17 @@ class VideoInputOp final : public PrefetchOperator<Context> {
   bool use_local_file_;
   bool is_test_;
   std::string im_extension_;
+  // FFmpeg hardware device type and device to decode with, see
+  // Params::hwAccel_
+  std::string hw_decode_;
+  std::string hw_decode_device_;
+  bool gpu_transform_;
+  // Seek to the clips with a keyframe index of every video, see
+  // GetKeyframeIndex
+  bool use_keyframe_index_;
+  // Number of decoded clips kept in the process-wide clip cache, 0 to
+  // disable it. Only clips with a fixed start frame are cached.
+  int clip_cache_size_;
 
   // thread pool for parse + decode
   int num_decode_threads_;
@@ -124,6 +151,20 @@ VideoInputOp<Context>::VideoInputOp(
           0)),
       im_extension_(
           OperatorBase::template GetSingleArgument<string>("im_extension", "")),
+      hw_decode_(
+          OperatorBase::template GetSingleArgument<string>("hw_decode", "")),
+      hw_decode_device_(OperatorBase::template GetSingleArgument<string>(
+          "hw_decode_device",
+          "")),
+      gpu_transform_(OperatorBase::template GetSingleArgument<int>(
+          "use_gpu_transform",
+          0)),
+      use_keyframe_index_(OperatorBase::template GetSingleArgument<int>(
+          "use_keyframe_index",
+          0)),
+      clip_cache_size_(OperatorBase::template GetSingleArgument<int>(
+          "clip_cache_size",
+          0)),
       num_decode_threads_(
           OperatorBase::template GetSingleArgument<int>("decode_threads", 4)),
 
@@ -148,12 +189,31 @@ VideoInputOp<Context>::VideoInputOp(
         "Number of labels must be set for using multiple label output.");
   }
 
+  CAFFE_ENFORCE(
+      !gpu_transform_ || !std::is_same<Context, CPUContext>::value,
+      "use_gpu_transform requires a GPU device option");
+  CAFFE_ENFORCE(
+      hw_decode_.empty() || !use_image_,
+      "hw_decode cannot be used with image sequence input");
+
   // Always need a dbreader, even when using local video files
   CAFFE_ENFORCE_GT(
       operator_def.input_size(), 0, "Need to have a DBReader blob input");
 
   LOG(INFO) << "Creating a clip input op with the following setting: ";
   LOG(INFO) << "    Using " << num_decode_threads_ << " CPU threads;";
+  if (!hw_decode_.empty()) {
+    LOG(INFO) << "    Decoding with the " << hw_decode_ << " hardware decoder;";
+  }
+  if (gpu_transform_) {
+    LOG(INFO) << "    Cropping and normalizing on the GPU;";
+  }
+  if (use_keyframe_index_) {
+    LOG(INFO) << "    Seeking to the clips with keyframe indices;";
+  }
+  if (clip_cache_size_ > 0) {
+    LOG(INFO) << "    Caching up to " << clip_cache_size_ << " decoded clips;";
+  }
   if (temporal_jitter_) {
     LOG(INFO) << "  Using temporal jittering;";
   }
@@ -177,7 +237,14 @@ VideoInputOp<Context>::VideoInputOp(
   data_shape[2] = length_;
   data_shape[3] = crop_;
   data_shape[4] = crop_;
-  prefetched_clip_.Resize(data_shape);
+  if (gpu_transform_) {
+    data_shape[3] = scale_h_;
+    data_shape[4] = scale_w_;
+    prefetched_raw_clip_.Resize(data_shape);
+    prefetched_crop_params_.Resize(batch_size_, 3);
+  } else {
+    prefetched_clip_.Resize(data_shape);
+  }
 
   // If multiple label is used, outout label is a binary vector of length
   // number of labels-dim in indicating which labels present
@@ -188,10 +255,17 @@ VideoInputOp<Context>::VideoInputOp(
   } else {
     prefetched_label_.Resize(vector<TIndex>(1, batch_size_));
   }
+  prefetched_clip_on_device_.resize(this->prefetch_slots());
+  prefetched_label_on_device_.resize(this->prefetch_slots());
+  if (gpu_transform_) {
+    prefetched_raw_clip_on_device_.resize(this->prefetch_slots());
+    prefetched_crop_params_on_device_.resize(this->prefetch_slots());
+  }
 }
 
 template <class Context>
 bool VideoInputOp<Context>::GetClipAndLabelFromDBValue(
+    const string& key,
     const string& value,
     float*& buffer,
     int* label_data,
@@ -219,6 +293,20 @@ bool VideoInputOp<Context>::GetClipAndLabelFromDBValue(
     }
   }
 
+  // Clips drawn with temporal jittering are unlikely to be read again
+  std::string cache_key;
+  const int clip_size = 3 * length_ * scale_h_ * scale_w_;
+  if (clip_cache_size_ > 0 && start_frm >= 0) {
+    std::ostringstream ss;
+    ss << key << ":" << start_frm << ":" << length_ << ":" << sampling_rate_
+       << ":" << scale_h_ << "x" << scale_w_;
+    cache_key = ss.str();
+    buffer = GetCachedClip(cache_key, clip_size);
+    if (buffer) {
+      return true;
+    }
+  }
+
   if (use_local_file_) {
     CAFFE_ENFORCE_EQ(
         video_proto.data_type(),
@@ -239,7 +327,10 @@ bool VideoInputOp<Context>::GetClipAndLabelFromDBValue(
           scale_w_,
           sampling_rate_,
           buffer,
-          randgen);
+          randgen,
+          hw_decode_,
+          hw_decode_device_,
+          use_keyframe_index_ ? key : "");
     } else {
       // encoded string contains an absolute path to a local file or folder
       std::string filename = encoded_video_str;
@@ -259,7 +350,13 @@ bool VideoInputOp<Context>::GetClipAndLabelFromDBValue(
             buffer));
       } else {
         if (temporal_jitter_) {
-          int num_of_frames = GetNumberOfFrames(filename);
+          std::shared_ptr<const KeyframeIndex> index;
+          if (use_keyframe_index_) {
+            index = GetKeyframeIndex(filename, nullptr, 0);
+          }
+          int num_of_frames = index && index->numFrames_ > 0
+              ? index->numFrames_
+              : GetNumberOfFrames(filename);
           start_frm = std::uniform_int_distribution<>(
               0, num_of_frames - length_ * sampling_rate_ + 1)(*randgen);
           CHECK(DecodeClipFromVideoFile(
@@ -269,7 +366,10 @@ bool VideoInputOp<Context>::GetClipAndLabelFromDBValue(
               scale_h_,
               scale_w_,
               sampling_rate_,
-              buffer));
+              buffer,
+              hw_decode_,
+              hw_decode_device_,
+              use_keyframe_index_));
         } else {
           CHECK(DecodeClipFromVideoFile(
               filename,
@@ -278,7 +378,10 @@ bool VideoInputOp<Context>::GetClipAndLabelFromDBValue(
               scale_h_,
               scale_w_,
               sampling_rate_,
-              buffer));
+              buffer,
+              hw_decode_,
+              hw_decode_device_,
+              use_keyframe_index_));
         }
       }
     }
@@ -292,17 +395,27 @@ bool VideoInputOp<Context>::GetClipAndLabelFromDBValue(
         scale_w_,
         sampling_rate_,
         buffer,
-        randgen);
+        randgen,
+        hw_decode_,
+        hw_decode_device_,
+        use_keyframe_index_ ? key : "");
   } else {
     LOG(FATAL) << "Unknown video data type.";
   }
+
+  if (buffer && !cache_key.empty()) {
+    CacheClip(cache_key, buffer, clip_size, clip_cache_size_);
+  }
   return true;
 }
 
 template <class Context>
 void VideoInputOp<Context>::DecodeAndTransform(
+    const std::string key,
     const std::string value,
     float* clip_data,
+    uint8_t* raw_clip_data,
+    int* crop_params,
     int* label_data,
     const int crop_size,
     const bool mirror,
@@ -313,9 +426,34 @@ void VideoInputOp<Context>::DecodeAndTransform(
   float* buffer = nullptr;
 
   // Decode the video from memory or read from a local file
-  CHECK(GetClipAndLabelFromDBValue(value, buffer, label_data, randgen));
-
-  if (buffer) {
+  CHECK(GetClipAndLabelFromDBValue(key, value, buffer, label_data, randgen));
+
+  if (buffer && gpu_transform_) {
+    // Only draw the crop here, ClipTransformOnGPU applies it. The decoded
+    // pixels are whole numbers, so they are sent to the device as uint8.
+    int h_off = 0;
+    int w_off = 0;
+    bool mirror_me = false;
+    GetClipCropParams(
+        scale_h_,
+        scale_w_,
+        crop_size,
+        mirror,
+        randgen,
+        mirror_this_clip,
+        is_test_,
+        &h_off,
+        &w_off,
+        &mirror_me);
+    crop_params[0] = h_off;
+    crop_params[1] = w_off;
+    crop_params[2] = mirror_me;
+    const int size = 3 * length_ * scale_h_ * scale_w_;
+    for (int i = 0; i < size; ++i) {
+      raw_clip_data[i] = static_cast<uint8_t>(buffer[i]);
+    }
+    delete[] buffer;
+  } else if (buffer) {
     ClipTransform(
         buffer,
         3,
@@ -332,6 +470,17 @@ void VideoInputOp<Context>::DecodeAndTransform(
         is_test_);
 
     delete[] buffer;
+  } else {
+    // The video could not be decoded: zero the clip rather than leaving the
+    // one of the previous batch in its slot.
+    LOG(WARNING) << "Failed to decode the clip of " << key
+                 << ", using a blank clip instead";
+    if (gpu_transform_) {
+      memset(crop_params, 0, 3 * sizeof(int));
+      memset(raw_clip_data, 0, 3 * length_ * scale_h_ * scale_w_);
+    } else {
+      memset(clip_data, 0, 3 * length_ * crop_size * crop_size * sizeof(float));
+    }
   }
 }
 
@@ -344,7 +493,12 @@ bool VideoInputOp<Context>::Prefetch() {
   const int channels = 3;
 
   // Call mutable_data() once to allocate the underlying memory.
-  prefetched_clip_.mutable_data<float>();
+  if (gpu_transform_) {
+    prefetched_raw_clip_.mutable_data<uint8_t>();
+    prefetched_crop_params_.mutable_data<int>();
+  } else {
+    prefetched_clip_.mutable_data<float>();
+  }
   prefetched_label_.mutable_data<int>();
 
   // Prefetching handled with a thread pool of "decode_threads" threads.
@@ -363,8 +517,17 @@ bool VideoInputOp<Context>::Prefetch() {
         (multiple_label_ ? num_of_labels_ : 1) * item_id;
 
     // get the clip data pointer for the item_id -th example
-    float* clip_data = prefetched_clip_.mutable_data<float>() +
-        crop_ * crop_ * length_ * channels * item_id;
+    float* clip_data = nullptr;
+    uint8_t* raw_clip_data = nullptr;
+    int* crop_params = nullptr;
+    if (gpu_transform_) {
+      raw_clip_data = prefetched_raw_clip_.mutable_data<uint8_t>() +
+          scale_h_ * scale_w_ * length_ * channels * item_id;
+      crop_params = prefetched_crop_params_.mutable_data<int>() + 3 * item_id;
+    } else {
+      clip_data = prefetched_clip_.mutable_data<float>() +
+          crop_ * crop_ * length_ * channels * item_id;
+    }
 
     std::string key, value;
     // read data
@@ -373,8 +536,11 @@ bool VideoInputOp<Context>::Prefetch() {
     thread_pool_->runTask(std::bind(
         &VideoInputOp<Context>::DecodeAndTransform,
         this,
+        std::string(key),
         std::string(value),
         clip_data,
+        raw_clip_data,
+        crop_params,
         label_data,
         crop_,
         mirror_,
@@ -386,10 +552,22 @@ bool VideoInputOp<Context>::Prefetch() {
   thread_pool_->waitWorkComplete();
 
   // If the context is not CPUContext, we will need to do a copy in the
-  // prefetch function as well.
+  // prefetch function as well. It runs asynchronously, into the current slot.
   if (!std::is_same<Context, CPUContext>::value) {
-    prefetched_clip_on_device_.CopyFrom(prefetched_clip_, &context_);
-    prefetched_label_on_device_.CopyFrom(prefetched_label_, &context_);
+    const int slot = this->prefetch_slot();
+    if (gpu_transform_) {
+      this->CopyToDeviceAsync(
+          &prefetched_raw_clip_, &prefetched_raw_clip_on_device_[slot], 0);
+      this->CopyToDeviceAsync(
+          &prefetched_crop_params_,
+          &prefetched_crop_params_on_device_[slot],
+          2);
+    } else {
+      this->CopyToDeviceAsync(
+          &prefetched_clip_, &prefetched_clip_on_device_[slot], 0);
+    }
+    this->CopyToDeviceAsync(
+        &prefetched_label_, &prefetched_label_on_device_[slot], 1);
   }
   return true;
 }
@@ -402,8 +580,20 @@ bool VideoInputOp<Context>::CopyPrefetched() {
     clip_output->CopyFrom(prefetched_clip_, &context_);
     label_output->CopyFrom(prefetched_label_, &context_);
   } else {
-    clip_output->CopyFrom(prefetched_clip_on_device_, &context_);
-    label_output->CopyFrom(prefetched_label_on_device_, &context_);
+    const int slot = this->consume_slot();
+    if (gpu_transform_) {
+      ClipTransformOnGPU<Context>(
+          prefetched_raw_clip_on_device_[slot],
+          prefetched_crop_params_on_device_[slot],
+          crop_,
+          mean_,
+          std_,
+          clip_output,
+          &context_);
+    } else {
+      clip_output->CopyFrom(prefetched_clip_on_device_[slot], &context_);
+    }
+    label_output->CopyFrom(prefetched_label_on_device_[slot], &context_);
   }
   return true;
 }
@@ -15,8 +15,12 @@
  */
 
 #include "caffe2/video/video_io.h"
+#include <algorithm>
+#include <list>
+#include <mutex>
 #include <random>
 #include <string>
+#include <unordered_map>
 #include "caffe2/core/logging.h"
 #include "caffe2/video/video_decoder.h"
 
@@ -46,6 +50,27 @@ void ImageDataToBuffer(
   }
 }
 
+void GetClipCropParams(
+    const int height,
+    const int width,
+    const int crop,
+    const bool mirror,
+    std::mt19937* randgen,
+    std::bernoulli_distribution* mirror_this_clip,
+    const bool use_center_crop,
+    int* h_off,
+    int* w_off,
+    bool* mirror_me) {
+  if (use_center_crop) {
+    *h_off = (height - crop) / 2;
+    *w_off = (width - crop) / 2;
+  } else {
+    *h_off = std::uniform_int_distribution<>(0, height - crop)(*randgen);
+    *w_off = std::uniform_int_distribution<>(0, width - crop)(*randgen);
+  }
+  *mirror_me = mirror && (*mirror_this_clip)(*randgen);
+}
+
 void ClipTransform(
     const float* clip_data,
     const int channels,
@@ -62,18 +87,21 @@ void ClipTransform(
     const bool use_center_crop) {
   int h_off = 0;
   int w_off = 0;
-
-  if (use_center_crop) {
-    h_off = (height - crop_size) / 2;
-    w_off = (width - crop_size) / 2;
-  } else {
-    h_off = std::uniform_int_distribution<>(0, height - crop_size)(*randgen);
-    w_off = std::uniform_int_distribution<>(0, width - crop_size)(*randgen);
-  }
+  bool mirror_me = false;
+  GetClipCropParams(
+      height,
+      width,
+      crop_size,
+      mirror,
+      randgen,
+      mirror_this_clip,
+      use_center_crop,
+      &h_off,
+      &w_off,
+      &mirror_me);
 
   float inv_std = 1.f / std;
   int top_index, data_index;
-  bool mirror_me = mirror && (*mirror_this_clip)(*randgen);
 
   for (int c = 0; c < channels; ++c) {
     for (int l = 0; l < length; ++l) {
@@ -396,7 +424,10 @@ bool DecodeClipFromVideoFile(
     const int height,
     const int width,
     const int sampling_rate,
-    float*& buffer) {
+    float*& buffer,
+    const std::string& hw_accel,
+    const std::string& hw_device,
+    const bool use_keyframe_index) {
   Params params;
   std::vector<std::unique_ptr<DecodedFrame>> sampledFrames;
   VideoDecoder decoder;
@@ -404,9 +435,23 @@ bool DecodeClipFromVideoFile(
   params.outputHeight_ = height ? height : -1;
   params.outputWidth_ = width ? width : -1;
   params.maximumOutputFrames_ = MAX_DECODING_FRAMES;
+  params.hwAccel(hw_accel, hw_device);
 
-  // decode all frames with defaul sampling rate
-  decoder.decodeFile(filename, params, sampledFrames);
+  std::shared_ptr<const KeyframeIndex> index;
+  if (use_keyframe_index) {
+    index = GetKeyframeIndex(filename, nullptr, 0);
+  }
+  if (index) {
+    // only decode from the keyframe before the clip to its end
+    params.startFrame(start_frm, index.get());
+    decoder.decodeFile(
+        filename, params, sampledFrames, length * sampling_rate);
+  }
+  if (sampledFrames.size() < length * sampling_rate) {
+    // decode all frames with defaul sampling rate
+    params.startFrame(0);
+    decoder.decodeFile(filename, params, sampledFrames);
+  }
 
   buffer = nullptr;
   int offset = 0;
@@ -414,9 +459,12 @@ bool DecodeClipFromVideoFile(
   int image_size = 0;
   int data_size = 0;
 
-  int end_frm = start_frm + length * sampling_rate;
-  for (int i = start_frm; i < end_frm; i += sampling_rate) {
-    if (i == start_frm) {
+  // position of the first frame of the clip in sampledFrames
+  int use_start_frm =
+      sampledFrames.empty() ? start_frm : start_frm - sampledFrames[0]->index_;
+  int end_frm = use_start_frm + length * sampling_rate;
+  for (int i = use_start_frm; i < end_frm; i += sampling_rate) {
+    if (i == use_start_frm) {
       image_size = sampledFrames[i]->height_ * sampledFrames[i]->width_;
       channel_size = image_size * length;
       data_size = channel_size * 3;
@@ -454,7 +502,10 @@ bool DecodeClipFromMemoryBuffer(
     const int width,
     const int sampling_rate,
     float*& buffer,
-    std::mt19937* randgen) {
+    std::mt19937* randgen,
+    const std::string& hw_accel,
+    const std::string& hw_device,
+    const std::string& index_key) {
   Params params;
   std::vector<std::unique_ptr<DecodedFrame>> sampledFrames;
   VideoDecoder decoder;
@@ -462,8 +513,25 @@ bool DecodeClipFromMemoryBuffer(
   params.outputHeight_ = height ? height : -1;
   params.outputWidth_ = width ? width : -1;
   params.maximumOutputFrames_ = MAX_DECODING_FRAMES;
+  params.hwAccel(hw_accel, hw_device);
+
+  std::shared_ptr<const KeyframeIndex> index;
+  if (!index_key.empty()) {
+    index = GetKeyframeIndex(index_key, video_buffer, size);
+  }
 
   bool isTemporalJitter = (start_frm < 0);
+  int use_start_frm = start_frm;
+  if (isTemporalJitter && index && index->numFrames_ > 0) {
+    /* the index knows the number of frames, so the clip can be drawn
+     * before decoding, and decoded by seeking to it. */
+    use_start_frm = std::uniform_int_distribution<>(
+        0, std::max(0, index->numFrames_ - length * sampling_rate))(*randgen);
+    isTemporalJitter = false;
+  }
+  if (!isTemporalJitter) {
+    params.startFrame(use_start_frm, index.get());
+  }
   decoder.decodeMemory(
       video_buffer,
       size,
@@ -474,6 +542,7 @@ bool DecodeClipFromMemoryBuffer(
 
   if (sampledFrames.size() < length * sampling_rate) {
     /* selective decoding failed. Decode all frames. */
+    params.startFrame(0);
     decoder.decodeMemory(video_buffer, size, params, sampledFrames);
   }
 
@@ -483,14 +552,16 @@ bool DecodeClipFromMemoryBuffer(
   int image_size = 0;
   int data_size = 0;
 
-  int use_start_frm = start_frm;
-  if (start_frm < 0) { // perform temporal jittering
+  if (isTemporalJitter) { // perform temporal jittering
     if ((int)(sampledFrames.size() - length * sampling_rate) > 0) {
       use_start_frm = std::uniform_int_distribution<>(
           0, (int)(sampledFrames.size() - length * sampling_rate))(*randgen);
     } else {
       use_start_frm = 0;
     }
+  } else if (!sampledFrames.empty()) {
+    // position of the first frame of the clip in sampledFrames
+    use_start_frm -= sampledFrames[0]->index_;
   }
 
   if (sampledFrames.size() < length * sampling_rate) {
@@ -542,4 +613,95 @@ bool DecodeClipFromMemoryBuffer(
   return true;
 }
 
+std::shared_ptr<const KeyframeIndex> GetKeyframeIndex(
+    const std::string& key,
+    const char* video_buffer,
+    const int size) {
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::shared_ptr<const KeyframeIndex>>
+      indices;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = indices.find(key);
+    if (it != indices.end()) {
+      return it->second;
+    }
+  }
+
+  // Build the index outside of the lock, two threads indexing the same video
+  // at once only duplicate the work.
+  std::shared_ptr<KeyframeIndex> index = std::make_shared<KeyframeIndex>();
+  if (video_buffer == nullptr) {
+    const std::string index_file = key + ".kfidx";
+    if (!index->load(index_file)) {
+      VideoDecoder decoder;
+      if (!decoder.indexFile(key, index.get())) {
+        return nullptr;
+      }
+      if (!index->save(index_file)) {
+        VLOG(1) << "Unable to write the keyframe index " << index_file;
+      }
+    }
+  } else {
+    VideoDecoder decoder;
+    if (!decoder.indexMemory(video_buffer, size, index.get())) {
+      return nullptr;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  return indices.emplace(key, index).first->second;
+}
+
+namespace {
+
+struct ClipCache {
+  std::mutex mutex;
+  // most recently used clip first
+  std::list<std::pair<std::string, std::vector<float>>> clips;
+  std::unordered_map<
+      std::string,
+      std::list<std::pair<std::string, std::vector<float>>>::iterator>
+      positions;
+};
+
+ClipCache& GetClipCache() {
+  static ClipCache cache;
+  return cache;
+}
+
+} // namespace
+
+float* GetCachedClip(const std::string& key, const int size) {
+  ClipCache& cache = GetClipCache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  auto it = cache.positions.find(key);
+  if (it == cache.positions.end() ||
+      static_cast<int>(it->second->second.size()) != size) {
+    return nullptr;
+  }
+  cache.clips.splice(cache.clips.begin(), cache.clips, it->second);
+  float* buffer = new float[size];
+  memcpy(buffer, it->second->second.data(), size * sizeof(float));
+  return buffer;
+}
+
+void CacheClip(
+    const std::string& key,
+    const float* buffer,
+    const int size,
+    const int capacity) {
+  ClipCache& cache = GetClipCache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  if (cache.positions.count(key)) {
+    return;
+  }
+  cache.clips.emplace_front(key, std::vector<float>(buffer, buffer + size));
+  cache.positions[key] = cache.clips.begin();
+  while (cache.clips.size() > static_cast<size_t>(capacity)) {
+    cache.positions.erase(cache.clips.back().first);
+    cache.clips.pop_back();
+  }
+}
+
 } // caffe2 namespace
@@ -18,6 +18,7 @@
 #define CAFFE2_VIDEO_VIDEO_IO_H_
 
 #include <opencv2/opencv.hpp>
+#include <memory>
 #include <random>
 #include "caffe/proto/caffe.pb.h"
 
@@ -25,6 +26,8 @@
 
 namespace caffe2 {
 
+class KeyframeIndex;
+
 void ImageChannelToBuffer(const cv::Mat* img, float* buffer, int c);
 
 void ImageDataToBuffer(
@@ -40,6 +43,20 @@ double GetVideoFPS(std::string filename);
 
 void GetVideoMeta(std::string filename, int& number_of_frames, double& fps);
 
+// Draws the crop offsets of a clip, and whether it is mirrored, the way
+// ClipTransform does, for transforms that run on the device.
+void GetClipCropParams(
+    const int height,
+    const int width,
+    const int crop,
+    const bool mirror,
+    std::mt19937* randgen,
+    std::bernoulli_distribution* mirror_this_clip,
+    const bool use_center_crop,
+    int* h_off,
+    int* w_off,
+    bool* mirror_me);
+
 void ClipTransform(
     const float* clip_data,
     const int channels,
@@ -99,7 +116,10 @@ bool DecodeClipFromVideoFile(
     const int height,
     const int width,
     const int sampling_rate,
-    float*& buffer);
+    float*& buffer,
+    const std::string& hw_accel = "",
+    const std::string& hw_device = "",
+    const bool use_keyframe_index = false);
 
 bool DecodeClipFromMemoryBuffer(
     const char* video_buffer,
@@ -110,7 +130,33 @@ bool DecodeClipFromMemoryBuffer(
     const int width,
     const int sampling_rate,
     float*& buffer,
-    std::mt19937* randgen);
+    std::mt19937* randgen,
+    const std::string& hw_accel = "",
+    const std::string& hw_device = "",
+    const std::string& index_key = "");
+
+// Returns the keyframe index of a video, built once per process. If
+// video_buffer is null, key is the name of a local file, and the index is
+// also stored next to it in key + ".kfidx" so that it is only built once.
+// Otherwise key identifies the video held in video_buffer, e.g. its DB key.
+// Returns nullptr if the video cannot be indexed.
+std::shared_ptr<const KeyframeIndex> GetKeyframeIndex(
+    const std::string& key,
+    const char* video_buffer,
+    const int size);
+
+// Process-wide LRU cache of decoded clips, before they are cropped, so that
+// the crops of the same clip taken for multi-crop testing decode it once.
+// GetCachedClip returns a copy of the size floats cached under key, allocated
+// with new[], or nullptr. CacheClip evicts the least recently used clips to
+// hold at most capacity clips.
+float* GetCachedClip(const std::string& key, const int size);
+
+void CacheClip(
+    const std::string& key,
+    const float* buffer,
+    const int size,
+    const int capacity);
 }
 
 #endif // CAFFE2_VIDEO_VIDEO_IO_H_
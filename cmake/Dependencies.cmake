@@ -161,6 +161,8 @@ if(USE_LEVELDB)
     list(APPEND Caffe2_DEPENDENCY_LIBS ${LevelDB_LIBRARIES})
     caffe2_include_directories(${Snappy_INCLUDE_DIR})
     list(APPEND Caffe2_DEPENDENCY_LIBS ${Snappy_LIBRARIES})
+    # Also used to compress the record batches of ZmqDB.
+    set(CAFFE2_USE_SNAPPY 1)
   else()
     message(WARNING "Not compiling with LevelDB. Suppress this warning with -DUSE_LEVELDB=OFF")
     set(USE_LEVELDB OFF)
@@ -191,6 +193,24 @@ if(USE_ZMQ)
   endif()
 endif()
 
+# ---[ NUMA
+if(USE_NUMA)
+  if(NOT ${CMAKE_SYSTEM_NAME} STREQUAL "Linux")
+    message(WARNING "NUMA is currently only supported under Linux.")
+    set(USE_NUMA OFF)
+  else()
+    find_package(Numa)
+    if(NUMA_FOUND)
+      caffe2_include_directories(${Numa_INCLUDE_DIR})
+      list(APPEND Caffe2_DEPENDENCY_LIBS ${Numa_LIBRARIES})
+      set(CAFFE2_USE_NUMA 1)
+    else()
+      message(WARNING "Not compiling with NUMA. Suppress this warning with -DUSE_NUMA=OFF")
+      set(USE_NUMA OFF)
+    endif()
+  endif()
+endif()
+
 # ---[ Redis
 if(USE_REDIS)
   find_package(Hiredis)
@@ -389,6 +409,23 @@ if(USE_NCCL)
   endif()
 endif()
 
+# ---[ RCCL
+if(USE_RCCL)
+  if(NOT USE_HIP)
+    message(WARNING "If not using HIP, one should not use RCCL either.")
+    set(USE_RCCL OFF)
+  else()
+    find_package(RCCL)
+    if(RCCL_FOUND)
+      caffe2_include_directories(${RCCL_INCLUDE_DIRS})
+      list(APPEND Caffe2_HIP_DEPENDENCY_LIBS ${RCCL_LIBRARIES})
+    else()
+      message(WARNING "Not compiling with RCCL. Suppress this warning with -DUSE_RCCL=OFF")
+      set(USE_RCCL OFF)
+    endif()
+  endif()
+endif()
+
 # ---[ CUB
 if(USE_CUDA)
   find_package(CUB)
@@ -417,6 +454,7 @@ if(USE_GLOO)
     set(USE_GLOO OFF)
   else()
     set(Gloo_USE_CUDA ${USE_CUDA})
+    set(Gloo_USE_ROCM ${USE_HIP})
     find_package(Gloo)
     if(Gloo_FOUND)
       caffe2_include_directories(${Gloo_INCLUDE_DIRS})
@@ -430,6 +468,8 @@ if(USE_GLOO)
       set(__BUILD_BENCHMARK ${BUILD_BENCHMARK})
       set(BUILD_TEST OFF)
       set(BUILD_BENCHMARK OFF)
+      # Builds the gloo_hip library alongside gloo.
+      set(USE_ROCM ${USE_HIP})
       add_subdirectory(${PROJECT_SOURCE_DIR}/third_party/gloo)
       # Here is a little bit hacky. We have to put PROJECT_BINARY_DIR in front
       # of PROJECT_SOURCE_DIR with/without conda system. The reason is that
@@ -451,6 +491,9 @@ if(USE_GLOO)
     if(USE_CUDA)
       list(APPEND Caffe2_CUDA_DEPENDENCY_LIBS gloo_cuda)
     endif()
+    if(USE_HIP)
+      list(APPEND Caffe2_HIP_DEPENDENCY_LIBS gloo_hip)
+    endif()
   endif()
 endif()
 
@@ -464,6 +507,14 @@ if(USE_PROF)
   endif()
 endif()
 
+# ---[ shared memory, shm_open is in librt before glibc 2.34
+if(USE_SHM_MUTEX)
+  find_library(RT_LIBRARY rt)
+  if(RT_LIBRARY)
+    list(APPEND Caffe2_DEPENDENCY_LIBS ${RT_LIBRARY})
+  endif()
+endif()
+
 if (USE_MOBILE_OPENGL)
   if (ANDROID)
     list(APPEND Caffe2_DEPENDENCY_LIBS EGL GLESv2)
@@ -13,4 +13,23 @@ include(${HIP_PATH}/cmake/FindHIP.cmake)
 if(EXISTS ${HIP_ROOT_DIR})
 	set(HAVE_HIP TRUE)
 	list(APPEND Caffe2_HIP_DEPENDENCY_LIBS hip_hcc)
+	# Older HIP releases ship hiprtc inside hip_hcc, newer ones as libhiprtc.
+	find_library(HIP_HIPRTC_LIB hiprtc
+	    PATHS ${HIP_PATH}
+	    PATH_SUFFIXES lib lib64)
+	if(HIP_HIPRTC_LIB)
+		message(STATUS "Found libhiprtc: ${HIP_HIPRTC_LIB}")
+		list(APPEND Caffe2_HIP_DEPENDENCY_LIBS ${HIP_HIPRTC_LIB})
+	endif()
+	# Stream capture into hipGraph is only available on newer HIP releases.
+	find_file(HIP_RUNTIME_API_H hip_runtime_api.h
+	    PATHS ${HIP_PATH}/include/hip
+	    NO_DEFAULT_PATH)
+	if(HIP_RUNTIME_API_H)
+		file(STRINGS ${HIP_RUNTIME_API_H} HIP_GRAPH_API REGEX "hipGraphInstantiate")
+		if(HIP_GRAPH_API)
+			message(STATUS "HIP runtime supports hipGraph")
+			set(CAFFE2_USE_HIP_GRAPH 1)
+		endif()
+	endif()
 endif()
\ No newline at end of file
@@ -99,6 +99,41 @@ if (CAFFE2_COMPILER_SUPPORTS_AVX2_EXTENSIONS)
 endif()
 cmake_pop_check_state()
 
+# ---[ Check if the compiler has AVX512 support. The AVX512 perfkernels are
+# only built on top of the AVX2 ones, so this is skipped for msvc as well.
+cmake_push_check_state(RESET)
+set(CMAKE_REQUIRED_FLAGS "-mavx512f")
+CHECK_CXX_SOURCE_COMPILES(
+    "#include <immintrin.h>
+     int main() {
+       __m512 a = _mm512_set1_ps(1.f);
+       a = _mm512_fmadd_ps(a, a, a);
+       a = _mm512_add_ps(a, _mm512_cvtph_ps(_mm256_setzero_si256()));
+       return 0;
+     }" CAFFE2_COMPILER_SUPPORTS_AVX512_EXTENSIONS)
+if (CAFFE2_COMPILER_SUPPORTS_AVX512_EXTENSIONS AND CAFFE2_PERF_WITH_AVX2)
+  message(STATUS "Current compiler supports avx512f extention. Will build avx512 perfkernels.")
+  set(CAFFE2_PERF_WITH_AVX512 1)
+endif()
+cmake_pop_check_state()
+
+# ---[ Check if the compiler has AVX512 VNNI support, used by the int8 GEMM
+# perfkernels.
+cmake_push_check_state(RESET)
+set(CMAKE_REQUIRED_FLAGS "-mavx512f -mavx512bw -mavx512vnni")
+CHECK_CXX_SOURCE_COMPILES(
+    "#include <immintrin.h>
+     int main() {
+       __m512i a = _mm512_set1_epi8(1);
+       a = _mm512_dpbusd_epi32(a, a, a);
+       return _mm512_reduce_add_epi32(a);
+     }" CAFFE2_COMPILER_SUPPORTS_AVX512_VNNI_EXTENSIONS)
+if (CAFFE2_COMPILER_SUPPORTS_AVX512_VNNI_EXTENSIONS AND CAFFE2_PERF_WITH_AVX512)
+  message(STATUS "Current compiler supports avx512 vnni extention. Will build avx512 vnni perfkernels.")
+  set(CAFFE2_PERF_WITH_AVX512_VNNI 1)
+endif()
+cmake_pop_check_state()
+
 # ---[ If we are using msvc, set no warning flags
 # Note(jiayq): if you are going to add a warning flag, check if this is
 # totally necessary, and only add when you see fit. If it is needed due to
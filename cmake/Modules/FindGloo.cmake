@@ -18,10 +18,18 @@ find_library(Gloo_CUDA_LIBRARY
 	DOC "The Gloo library (with CUDA)"
 )
 
+find_library(Gloo_HIP_LIBRARY
+	NAMES gloo_hip
+	DOC "The Gloo library (with HIP)"
+)
+
 set(Gloo_INCLUDE_DIRS ${Gloo_INCLUDE_DIR})
 
-# use the CUDA library depending on the Gloo_USE_CUDA variable
-if (DEFINED Gloo_USE_CUDA)
+# use the CUDA library depending on the Gloo_USE_CUDA variable, or the HIP
+# library if Gloo_USE_ROCM is set
+if (DEFINED Gloo_USE_ROCM AND ${Gloo_USE_ROCM})
+	set(Gloo_LIBRARY ${Gloo_HIP_LIBRARY})
+elseif (DEFINED Gloo_USE_CUDA)
 	if (${Gloo_USE_CUDA})
 		set(Gloo_LIBRARY ${Gloo_CUDA_LIBRARY})
 	else()
@@ -0,0 +1,40 @@
+# Find the rccl libraries
+#
+# The following variables are optionally searched for defaults
+#  RCCL_ROOT_DIR: Base directory where all RCCL components are found
+#  RCCL_INCLUDE_DIR: Directory where RCCL header is found
+#  RCCL_LIB_DIR: Directory where RCCL library is found
+#
+# The following are set after configuration is done:
+#  RCCL_FOUND
+#  RCCL_INCLUDE_DIRS
+#  RCCL_LIBRARIES
+#
+# ROCm installs RCCL under /opt/rocm/rccl, which is searched by default.
+
+set(RCCL_ROOT_DIR "/opt/rocm/rccl" CACHE PATH "Folder contains AMD RCCL")
+
+find_path(RCCL_INCLUDE_DIRS
+  NAMES rccl.h
+  HINTS
+  ${RCCL_INCLUDE_DIR}
+  ${RCCL_ROOT_DIR}
+  ${RCCL_ROOT_DIR}/include
+  /opt/rocm/include)
+
+find_library(RCCL_LIBRARIES
+  NAMES rccl
+  HINTS
+  ${RCCL_LIB_DIR}
+  ${RCCL_ROOT_DIR}
+  ${RCCL_ROOT_DIR}/lib
+  ${RCCL_ROOT_DIR}/lib64
+  /opt/rocm/lib)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(RCCL DEFAULT_MSG RCCL_INCLUDE_DIRS RCCL_LIBRARIES)
+
+if(RCCL_FOUND)
+  message(STATUS "Found RCCL (include: ${RCCL_INCLUDE_DIRS}, library: ${RCCL_LIBRARIES})")
+  mark_as_advanced(RCCL_ROOT_DIR RCCL_INCLUDE_DIRS RCCL_LIBRARIES)
+endif()
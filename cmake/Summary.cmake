@@ -51,11 +51,13 @@ function (caffe2_print_configuration_summary)
   message(STATUS "  USE_MOBILE_OPENGL     : ${USE_MOBILE_OPENGL}")
   message(STATUS "  USE_MPI               : ${USE_MPI}")
   message(STATUS "  USE_NCCL              : ${USE_NCCL}")
+  message(STATUS "  USE_RCCL              : ${USE_RCCL}")
   message(STATUS "  USE_NERVANA_GPU       : ${USE_NERVANA_GPU}")
   if(${USE_NERVANA_GPU})
     message(STATUS "    NERVANA_GPU version : ${NERVANA_GPU_VERSION}")
   endif()
   message(STATUS "  USE_NNPACK            : ${USE_NNPACK}")
+  message(STATUS "  USE_NUMA              : ${USE_NUMA}")
   message(STATUS "  USE_OBSERVERS         : ${USE_OBSERVERS}")
   message(STATUS "  USE_OPENCV            : ${USE_OPENCV}")
   if(${USE_OPENCV})
@@ -65,6 +67,7 @@ function (caffe2_print_configuration_summary)
   message(STATUS "  USE_PROF              : ${USE_PROF}")
   message(STATUS "  USE_REDIS             : ${USE_REDIS}")
   message(STATUS "  USE_ROCKSDB           : ${USE_ROCKSDB}")
+  message(STATUS "  USE_SHM_MUTEX         : ${USE_SHM_MUTEX}")
   message(STATUS "  USE_THREADS           : ${USE_THREADS}")
   message(STATUS "  USE_ZMQ               : ${USE_ZMQ}")
 endfunction()
@@ -235,7 +235,7 @@ endfunction()
 # target name is given by the first argument and the rest are the source files
 # to build the target.
 function(caffe2_binary_target target_name_or_src)
-  if (${ARGN})
+  if (ARGN)
     set(__target ${target_name_or_src})
     prepend(__srcs "${CMAKE_CURRENT_SOURCE_DIR}/" "${ARGN}")
   else()